@@ -0,0 +1,555 @@
+/**
+ * @file benchmarks.cpp
+ * @author Ryan Curtin
+ *
+ * Time optimizers on the functions in ensmallen_bits/problems/ and print the
+ * results as CSV to stdout.  Build with 'make ensmallen_benchmarks' and run
+ * with --help for the options.  Each optimizer runs until its own termination
+ * criterion (usually its tolerance) is met; for each run, the total time, the
+ * time spent in the objective function, the number of calls to the objective
+ * function, the final objective and the peak memory of the process are
+ * printed.  With --trace, the convergence trace of every run of an optimizer
+ * that supports callbacks is written to the given file as CSV, to draw
+ * time-to-accuracy curves (objective against time or evaluations).  With
+ * --counters, the hardware counters of each run (cycles, instructions and
+ * last level cache misses) are read with perf_event on Linux, and printed with
+ * their values per step and the memory bandwidth they imply.
+ *
+ * The regression datasets are drawn from planted models with the generators
+ * of synthetic_data.hpp, so any number of points can be used; with
+ * --data-dir, their predictors are held in files of that directory mapped
+ * with MappedMatrix, so that they can be larger than the memory.  (The
+ * optimizers that shuffle the points still copy them.)
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+// The benchmarks report the number of function calls.
+#ifndef ENS_PROFILE
+  #define ENS_PROFILE
+#endif
+
+#include <ensmallen.hpp>
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Hardware counters of the process, read with perf_event on Linux: the cycles,
+ * the instructions and the last level cache misses.  Each counter is opened
+ * separately (so that the kernel can multiplex them if there are not enough
+ * hardware counters, in which case the values are scaled) and is inherited by
+ * the threads created afterwards, so the counters must be opened before any
+ * OpenMP region or thread pool starts its threads.  Only user space is
+ * counted, which most systems allow without privileges.
+ */
+class HardwareCounters
+{
+ public:
+  //! The number of counters.
+  static const size_t Count = 3;
+
+  HardwareCounters()
+  {
+    for (size_t i = 0; i < Count; ++i)
+      fds[i] = -1;
+  }
+
+  ~HardwareCounters()
+  {
+  #if defined(__linux__)
+    for (size_t i = 0; i < Count; ++i)
+      if (fds[i] != -1)
+        close(fds[i]);
+  #endif
+  }
+
+  //! Open the counters; return false if perf_event is not available.
+  bool Open()
+  {
+  #if defined(__linux__)
+    const unsigned long long configs[Count] = { PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+    for (size_t i = 0; i < Count; ++i)
+    {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+          PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fds[i] == -1)
+        return false;
+    }
+    return true;
+  #else
+    return false;
+  #endif
+  }
+
+  //! Reset and start the counters.
+  void Start()
+  {
+  #if defined(__linux__)
+    for (size_t i = 0; i < Count; ++i)
+    {
+      ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  #endif
+  }
+
+  //! Stop the counters and store their values.
+  void Stop(double values[Count])
+  {
+    for (size_t i = 0; i < Count; ++i)
+    {
+      values[i] = std::numeric_limits<double>::quiet_NaN();
+    #if defined(__linux__)
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+      // The value, the time the counter was enabled and the time it ran.
+      unsigned long long data[3];
+      if (read(fds[i], data, sizeof(data)) == (ssize_t) sizeof(data) &&
+          data[2] > 0)
+        values[i] = (double) data[0] * ((double) data[1] / data[2]);
+    #endif
+    }
+  }
+
+ private:
+  int fds[Count];
+};
+
+/**
+ * Options of the benchmark run.
+ */
+struct BenchmarkOptions
+{
+  BenchmarkOptions() :
+      points(10000),
+      dimensions(10),
+      classes(5),
+      vertices(30),
+      repetitions(1),
+      seed(42),
+      readCounters(false)
+  { }
+
+  //! Number of points of the synthetic regression datasets.
+  size_t points;
+  //! Number of dimensions of the synthetic regression datasets.
+  size_t dimensions;
+  //! Number of classes of the softmax regression dataset.
+  size_t classes;
+  //! Number of vertices of the Lovasz-Theta graph.
+  size_t vertices;
+  //! Number of times each benchmark is run.
+  size_t repetitions;
+  //! Random seed.
+  size_t seed;
+  //! Only run the benchmarks whose name contains this string.
+  std::string filter;
+  //! Directory of the files to map the datasets to (none if empty).
+  std::string dataDir;
+  //! File to write the convergence traces to (none if empty).
+  std::string traceFile;
+  //! Stream of the convergence traces.
+  std::ofstream trace;
+  //! Whether to read the hardware counters.
+  bool readCounters;
+  //! The hardware counters.
+  HardwareCounters counters;
+};
+
+/**
+ * Return the peak resident memory of the process in kilobytes, or 0 if it is
+ * not available on this platform.  Note that it never decreases, so it is the
+ * peak over every benchmark run so far.
+ */
+inline size_t PeakMemory()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  #if defined(__APPLE__)
+    // ru_maxrss is in bytes on macOS.
+    return usage.ru_maxrss / 1024;
+  #else
+    return usage.ru_maxrss;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Run one benchmark and print one line of results for each repetition.  The
+ * run function optimizes from a fresh starting point and returns the final
+ * objective; it is given a TraceRecorder to pass to optimizers that support
+ * callbacks, whose records are written to the trace file.
+ */
+template<typename OptimizerType, typename RunType>
+void BenchmarkRun(BenchmarkOptions& options,
+                  const std::string& problem,
+                  const size_t size,
+                  const std::string& optimizerName,
+                  OptimizerType& optimizer,
+                  RunType run)
+{
+  const std::string name = problem + "/" + optimizerName;
+  if (name.find(options.filter) == std::string::npos)
+    return;
+
+  for (size_t r = 0; r < options.repetitions; ++r)
+  {
+    arma::arma_rng::set_seed(options.seed + r);
+    TraceRecorder trace(1000000);
+    if (options.readCounters)
+      options.counters.Start();
+    const double objective = run(trace);
+    double values[HardwareCounters::Count];
+    if (options.readCounters)
+      options.counters.Stop(values);
+
+    const ProfileReport& report = optimizer.Profile();
+    std::cout << problem << "," << size << "," << optimizerName << "," << r
+        << "," << report.TotalTime() << "," << report.FunctionTime() << ","
+        << report.Evaluations() << "," << report.Gradients() << ","
+        << report.EvaluationsWithGradient() << "," << objective << ","
+        << PeakMemory();
+
+    if (options.readCounters)
+    {
+      // Every last level cache miss moves one cache line of 64 bytes; the
+      // steps are only known for optimizers that take callbacks.
+      const double bytes = 64.0 * values[2];
+      const double steps = (trace.Steps() > 0) ? (double) trace.Steps() :
+          std::numeric_limits<double>::quiet_NaN();
+      std::cout << "," << trace.Steps() << "," << values[0] << ","
+          << values[1] << "," << values[2] << "," << (values[0] / steps)
+          << "," << (values[1] / steps) << "," << (values[2] / steps) << ","
+          << (bytes / steps) << "," << (bytes / report.TotalTime() / 1e9);
+    }
+    std::cout << std::endl;
+
+    if (options.trace.is_open())
+    {
+      std::ostringstream prefix;
+      prefix << problem << "," << size << "," << optimizerName << "," << r
+          << ",";
+      trace.WriteCSV(options.trace, prefix.str(), false);
+    }
+  }
+}
+
+/**
+ * Benchmark the optimizer on the given function, starting from the initial
+ * point of the function.
+ */
+template<typename OptimizerType, typename FunctionType>
+void Benchmark(BenchmarkOptions& options,
+               const std::string& problem,
+               const size_t size,
+               const std::string& optimizerName,
+               OptimizerType& optimizer,
+               FunctionType& function)
+{
+  BenchmarkRun(options, problem, size, optimizerName, optimizer,
+      [&](TraceRecorder& trace)
+  {
+    arma::mat coordinates = function.GetInitialPoint();
+    return optimizer.Optimize(function, coordinates, trace);
+  });
+}
+
+/**
+ * Get the file to map the predictors of the given dataset to, or an empty name
+ * to keep them in memory.
+ */
+inline std::string DataFile(const BenchmarkOptions& options,
+                            const std::string& name)
+{
+  return options.dataDir.empty() ? "" : (options.dataDir + "/" + name +
+      ".bin");
+}
+
+/**
+ * Set up the Lovasz-Theta SDP of a random graph, with the initial point given
+ * by Monteiro and Burer 2004.
+ */
+inline void LovaszTheta(const size_t vertices,
+                        arma::mat& edges,
+                        arma::mat& coordinates)
+{
+  // Every edge of the graph exists with probability 0.2.
+  std::vector<std::pair<size_t, size_t>> edgeList;
+  for (size_t i = 0; i < vertices; ++i)
+    for (size_t j = i + 1; j < vertices; ++j)
+      if (arma::randu() < 0.2)
+        edgeList.push_back(std::make_pair(i, j));
+
+  edges.set_size(2, edgeList.size());
+  for (size_t i = 0; i < edgeList.size(); ++i)
+  {
+    edges(0, i) = edgeList[i].first;
+    edges(1, i) = edgeList[i].second;
+  }
+
+  const size_t m = edges.n_cols + 1;
+  double r = 0.5 + std::sqrt(0.25 + 2 * m);
+  if (std::ceil(r) > vertices)
+    r = vertices;
+
+  coordinates.set_size(vertices, std::ceil(r));
+  for (size_t i = 0; i < vertices; ++i)
+  {
+    for (size_t j = 0; j < std::ceil(r); ++j)
+    {
+      coordinates(i, j) = std::sqrt(1.0 / (vertices * m));
+      if (i == j)
+        coordinates(i, j) += std::sqrt(1.0 / r);
+    }
+  }
+}
+
+inline void GeneralizedRosenbrockBenchmarks(BenchmarkOptions& options)
+{
+  const size_t sizes[] = { 10, 50, 100 };
+  for (size_t s = 0; s < 3; ++s)
+  {
+    GeneralizedRosenbrockFunction f(sizes[s]);
+
+    L_BFGS lbfgs;
+    Benchmark(options, "GeneralizedRosenbrock", sizes[s], "L_BFGS", lbfgs, f);
+
+    Adam adam(0.001, 1, 0.9, 0.999, 1e-8, 100000 * sizes[s], 1e-9, true);
+    Benchmark(options, "GeneralizedRosenbrock", sizes[s], "Adam", adam, f);
+  }
+}
+
+inline void LogisticRegressionBenchmarks(BenchmarkOptions& options)
+{
+  MappedMatrix data(options.dimensions, options.points,
+      DataFile(options, "logistic_regression"));
+  RandomPredictors(data.Matrix(), options.seed);
+  arma::Row<size_t> labels;
+  arma::rowvec parameters;
+  LogisticRegressionData(data.Matrix(), labels, parameters, 2.0,
+      options.seed);
+  LogisticRegression<> f(data.Matrix(), labels, 0.5);
+
+  L_BFGS lbfgs;
+  Benchmark(options, "LogisticRegression", options.points, "L_BFGS", lbfgs, f);
+
+  StandardSGD sgd(0.0003, 32, 100 * options.points, 1e-5, true);
+  Benchmark(options, "LogisticRegression", options.points, "SGD", sgd, f);
+
+  Adam adam(0.01, 32, 0.9, 0.999, 1e-8, 100 * options.points, 1e-5, true);
+  Benchmark(options, "LogisticRegression", options.points, "Adam", adam, f);
+
+  SVRG svrg(0.005, 32, 100, 0, 1e-5, true);
+  Benchmark(options, "LogisticRegression", options.points, "SVRG", svrg, f);
+
+  // Hogwild! with a dense gradient, with and without NUMA locality.
+  for (size_t numa = 0; numa < 2; ++numa)
+  {
+    ParallelSGD<ConstantStep> psgd(1000, 0, 1e-5, true,
+        ConstantStep(0.0003), 32, true, true, OpenMPExecutor(), numa == 1);
+    BenchmarkRun(options, "LogisticRegression", options.points,
+        (numa == 1) ? "ParallelSGD/NUMA" : "ParallelSGD", psgd,
+        [&](TraceRecorder& /* trace */)
+    {
+      arma::mat coordinates = f.GetInitialPoint();
+      return psgd.Optimize<LogisticRegression<>, arma::mat, arma::mat>(f,
+          coordinates);
+    });
+  }
+}
+
+inline void SoftmaxRegressionBenchmarks(BenchmarkOptions& options)
+{
+  MappedMatrix data(options.dimensions, options.points,
+      DataFile(options, "softmax_regression"));
+  RandomPredictors(data.Matrix(), options.seed);
+  arma::Row<size_t> labels;
+  arma::mat parameters;
+  SoftmaxRegressionData(data.Matrix(), options.classes, labels, parameters,
+      2.0, options.seed);
+  SoftmaxRegressionFunction f(data.Matrix(), labels, options.classes);
+
+  L_BFGS lbfgs;
+  Benchmark(options, "SoftmaxRegression", options.points, "L_BFGS", lbfgs, f);
+
+  // SCD does not take callbacks.
+  SCD<> scd(0.02, 60000, 1e-5);
+  BenchmarkRun(options, "SoftmaxRegression", options.points, "SCD", scd,
+      [&](TraceRecorder& /* trace */)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    return scd.Optimize(f, coordinates);
+  });
+}
+
+inline void SparseTestFunctionBenchmarks(BenchmarkOptions& options)
+{
+  SparseTestFunction f;
+
+  StandardSGD sgd(0.4, 1, 100000, 1e-12, true);
+  Benchmark(options, "SparseTestFunction", f.NumFunctions(), "SGD", sgd, f);
+
+  ConstantStep decayPolicy(0.4);
+  ParallelSGD<ConstantStep> psgd(10000, 1, 1e-12, true, decayPolicy);
+  BenchmarkRun(options, "SparseTestFunction", f.NumFunctions(), "ParallelSGD",
+      psgd, [&](TraceRecorder& /* trace */)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    return psgd.Optimize(f, coordinates);
+  });
+}
+
+inline void LovaszThetaBenchmarks(BenchmarkOptions& options)
+{
+  arma::mat edges, initialPoint;
+  arma::arma_rng::set_seed(options.seed);
+  LovaszTheta(options.vertices, edges, initialPoint);
+
+  LRSDP<SDP<arma::mat>> lrsdp(edges.n_cols + 1, 0, initialPoint);
+  lrsdp.SDP().C().ones(options.vertices, options.vertices);
+  lrsdp.SDP().C() *= -1;
+  lrsdp.SDP().SparseB().zeros(edges.n_cols + 1);
+  lrsdp.SDP().SparseB()[0] = 1;
+  lrsdp.SDP().SparseA()[0].eye(options.vertices, options.vertices);
+  for (size_t i = 0; i < edges.n_cols; ++i)
+  {
+    lrsdp.SDP().SparseA()[i + 1].zeros(options.vertices, options.vertices);
+    lrsdp.SDP().SparseA()[i + 1](edges(0, i), edges(1, i)) = 1.;
+    lrsdp.SDP().SparseA()[i + 1](edges(1, i), edges(0, i)) = 1.;
+  }
+
+  BenchmarkRun(options, "LovaszTheta", options.vertices, "LRSDP", lrsdp,
+      [&](TraceRecorder& trace)
+  {
+    lrsdp.AugLag().Lambda().ones(edges.n_cols + 1);
+    lrsdp.AugLag().Lambda() *= -1;
+    lrsdp.AugLag().Lambda()[0] = -double(options.vertices);
+    lrsdp.AugLag().Sigma() = 10;
+    arma::mat x = initialPoint;
+    return lrsdp.Optimize(x, trace);
+  });
+}
+
+int main(int argc, char** argv)
+{
+  BenchmarkOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--counters")
+    {
+      options.readCounters = true;
+      continue;
+    }
+
+    if (arg == "--help" || i + 1 == argc)
+    {
+      std::cout << "Usage: " << argv[0] << " [--points N] [--dimensions D] "
+          << "[--classes C] [--vertices V] [--repetitions R] [--seed S] "
+          << "[--filter STRING] [--trace FILE] [--data-dir DIR] [--counters]"
+          << std::endl;
+      return (arg == "--help") ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+    if (arg == "--filter")
+      options.filter = value;
+    else if (arg == "--points")
+      options.points = std::stoul(value);
+    else if (arg == "--dimensions")
+      options.dimensions = std::stoul(value);
+    else if (arg == "--classes")
+      options.classes = std::stoul(value);
+    else if (arg == "--vertices")
+      options.vertices = std::stoul(value);
+    else if (arg == "--repetitions")
+      options.repetitions = std::stoul(value);
+    else if (arg == "--seed")
+      options.seed = std::stoul(value);
+    else if (arg == "--trace")
+      options.traceFile = value;
+    else if (arg == "--data-dir")
+      options.dataDir = value;
+    else
+    {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  // The counters are opened before any thread is started, so that they are
+  // inherited by all the threads.
+  if (options.readCounters && !options.counters.Open())
+  {
+    std::cerr << "Cannot open the hardware counters (perf_event is only "
+        << "available on Linux, and may be restricted by "
+        << "/proc/sys/kernel/perf_event_paranoid)." << std::endl;
+    return 1;
+  }
+
+  std::cout << "problem,size,optimizer,repetition,total_time,function_time,"
+      << "evaluations,gradients,evaluations_with_gradient,objective,"
+      << "peak_memory_kb";
+  if (options.readCounters)
+  {
+    std::cout << ",steps,cycles,instructions,llc_misses,cycles_per_step,"
+        << "instructions_per_step,llc_misses_per_step,bytes_per_step,"
+        << "bandwidth_gb_s";
+  }
+  std::cout << std::endl;
+
+  if (!options.traceFile.empty())
+  {
+    options.trace.open(options.traceFile);
+    if (!options.trace.is_open())
+    {
+      std::cerr << "Cannot open " << options.traceFile << "." << std::endl;
+      return 1;
+    }
+
+    options.trace << "problem,size,optimizer,repetition,time,iteration,"
+        << "evaluations,objective,gradient_norm,step_size,epoch" << std::endl;
+  }
+
+  GeneralizedRosenbrockBenchmarks(options);
+  LogisticRegressionBenchmarks(options);
+  SoftmaxRegressionBenchmarks(options);
+  SparseTestFunctionBenchmarks(options);
+  LovaszThetaBenchmarks(options);
+
+  return 0;
+}
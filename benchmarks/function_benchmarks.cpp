@@ -0,0 +1,186 @@
+/**
+ * @file function_benchmarks.cpp
+ * @author Marcus Edel
+ *
+ * Check the gradients of the functions in ensmallen_bits/problems/ against
+ * finite differences and time their methods at several batch sizes, and print
+ * the results as CSV to stdout.  Build with 'make ensmallen_function_benchmarks'
+ * and run with --help for the options.  This is also a template for checking a
+ * user function before a long optimization: replace the problems below with
+ * the function.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Options of the benchmark run.
+ */
+struct FunctionBenchmarkOptions
+{
+  FunctionBenchmarkOptions() :
+      points(10000),
+      dimensions(100),
+      classes(5),
+      minTime(0.2),
+      seed(42)
+  { }
+
+  //! Number of points of the synthetic regression datasets.
+  size_t points;
+  //! Number of dimensions of the synthetic regression datasets.
+  size_t dimensions;
+  //! Number of classes of the softmax regression dataset.
+  size_t classes;
+  //! Minimum time (in seconds) spent on each method.
+  double minTime;
+  //! Random seed.
+  size_t seed;
+  //! Only run the benchmarks whose name contains this string.
+  std::string filter;
+};
+
+/**
+ * Print one CSV line for each timing, with the relative error of the gradient.
+ */
+inline void PrintResults(const std::string& problem,
+                         const double gradientError,
+                         const double flopsPerSample,
+                         const std::vector<FunctionTiming>& timings)
+{
+  for (size_t i = 0; i < timings.size(); ++i)
+  {
+    std::cout << problem << "," << timings[i].Method() << ","
+        << timings[i].BatchSize() << "," << timings[i].Calls() << ","
+        << timings[i].Seconds() << "," << timings[i].SamplesPerSecond() << ","
+        << timings[i].GFlops(flopsPerSample) << "," << gradientError
+        << std::endl;
+  }
+}
+
+/**
+ * Check and time the given separable function, with the gradient checked on
+ * its first batch of the largest size.
+ */
+template<typename FunctionType>
+void BenchmarkDecomposable(const FunctionBenchmarkOptions& options,
+                           const std::string& problem,
+                           const double flopsPerSample,
+                           FunctionType& function)
+{
+  if (problem.find(options.filter) == std::string::npos)
+    return;
+
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  std::vector<size_t> batchSizes;
+  for (size_t b = 1; b <= f.NumFunctions() && b <= 4096; b *= 8)
+    batchSizes.push_back(b);
+
+  // Check the gradient away from the initial point, where it may be zero.
+  arma::arma_rng::set_seed(options.seed);
+  arma::mat coordinates = f.GetInitialPoint();
+  coordinates += 0.1 * arma::randn<arma::mat>(arma::size(coordinates));
+
+  const double error = CheckDecomposableGradient(f, coordinates, 0,
+      batchSizes.back(), 1e-6, true);
+  PrintResults(problem, error, flopsPerSample, TimeDecomposableFunction(f,
+      coordinates, batchSizes, options.minTime));
+}
+
+/**
+ * Check and time the given differentiable function.
+ */
+template<typename FunctionType>
+void Benchmark(const FunctionBenchmarkOptions& options,
+               const std::string& problem,
+               const double flopsPerSample,
+               FunctionType& function)
+{
+  if (problem.find(options.filter) == std::string::npos)
+    return;
+
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  arma::arma_rng::set_seed(options.seed);
+  arma::mat coordinates = f.GetInitialPoint();
+  coordinates += 0.1 * arma::randn<arma::mat>(arma::size(coordinates));
+
+  const double error = CheckGradient(f, coordinates, 1e-6, true);
+  PrintResults(problem, error, flopsPerSample, TimeFunction(f, coordinates,
+      options.minTime));
+}
+
+int main(int argc, char** argv)
+{
+  FunctionBenchmarkOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--help" || i + 1 == argc)
+    {
+      std::cout << "Usage: " << argv[0] << " [--points N] [--dimensions D] "
+          << "[--classes C] [--min-time T] [--seed S] [--filter STRING]"
+          << std::endl;
+      return (arg == "--help") ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+    if (arg == "--filter")
+      options.filter = value;
+    else if (arg == "--points")
+      options.points = std::stoul(value);
+    else if (arg == "--dimensions")
+      options.dimensions = std::stoul(value);
+    else if (arg == "--classes")
+      options.classes = std::stoul(value);
+    else if (arg == "--min-time")
+      options.minTime = std::stod(value);
+    else if (arg == "--seed")
+      options.seed = std::stoul(value);
+    else
+    {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "problem,method,batch_size,calls,seconds,samples_per_second,"
+      << "gflops,gradient_error" << std::endl;
+
+  arma::arma_rng::set_seed(options.seed);
+  arma::mat data = arma::randn<arma::mat>(options.dimensions, options.points);
+  arma::Row<size_t> labels(options.points), binaryLabels(options.points);
+  for (size_t i = 0; i < options.points; ++i)
+  {
+    labels[i] = i % options.classes;
+    binaryLabels[i] = i % 2;
+  }
+
+  // A gradient of a linear model is a dot product and an axpy per point.
+  LogisticRegression<> lr(data, binaryLabels, 0.5);
+  BenchmarkDecomposable(options, "LogisticRegression",
+      4.0 * options.dimensions, lr);
+
+  // The softmax regression function is only timed on the whole dataset.
+  SoftmaxRegressionFunction softmax(data, labels, options.classes);
+  Benchmark(options, "SoftmaxRegression",
+      4.0 * options.dimensions * options.classes * options.points, softmax);
+
+  // Four operations per term of the sum.
+  GeneralizedRosenbrockFunction rosenbrock(options.dimensions);
+  BenchmarkDecomposable(options, "GeneralizedRosenbrock", 8.0, rosenbrock);
+
+  RosenbrockFunction rosenbrock2d;
+  Benchmark(options, "Rosenbrock", 10.0, rosenbrock2d);
+
+  return 0;
+}
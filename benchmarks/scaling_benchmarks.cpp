@@ -0,0 +1,231 @@
+/**
+ * @file scaling_benchmarks.cpp
+ * @author Marcus Edel
+ *
+ * Thread scaling of ParallelSGD on a sparse matrix factorization, printed as
+ * CSV to stdout.  Build with 'make ensmallen_scaling_benchmarks' and run with
+ * --help for the options.
+ *
+ * A rank-r matrix of users x items is generated with a given number of observed
+ * entries per user, whose items are drawn with a popularity skew (a skew of 1
+ * draws them uniformly; larger skews make a few items much more popular, so
+ * that their columns are updated by many threads at once, as with real
+ * ratings).  For each update mode of ParallelSGD (atomic updates, HOGWILD!
+ * updates without atomics, and atomic updates with NUMA locality) and for 1, 2,
+ * 4, ... threads, a few passes over the observations are timed; the number of
+ * updates (observations processed) per second, the speedup over one thread of
+ * the same mode, the parallel efficiency (speedup / threads), and the RMSE of
+ * the factorization on the observations are printed.  The best time of the
+ * repetitions is kept.
+ *
+ * On a NUMA machine, bind the OpenMP threads to their cores (e.g.
+ * OMP_PROC_BIND=true OMP_PLACES=cores) so that the timings are stable.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+
+#include <chrono>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Options of the benchmark run.
+ */
+struct ScalingBenchmarkOptions
+{
+  ScalingBenchmarkOptions() :
+      users(100000),
+      items(20000),
+      perUser(50),
+      rank(16),
+      skew(2.0),
+      passes(3),
+      repetitions(3),
+      maxThreads(0),
+      stepSize(0.01),
+      lambda(0.01),
+      seed(42)
+  { }
+
+  //! Number of users (rows of the matrix).
+  size_t users;
+  //! Number of items (columns of the matrix).
+  size_t items;
+  //! Number of observed entries per user.
+  size_t perUser;
+  //! Rank of the matrix and of the factorization.
+  size_t rank;
+  //! Popularity skew of the items.
+  double skew;
+  //! Number of passes over the observations per run.
+  size_t passes;
+  //! Number of runs for each mode and number of threads.
+  size_t repetitions;
+  //! Largest number of threads (0 means all available).
+  size_t maxThreads;
+  //! Step size of ParallelSGD.
+  double stepSize;
+  //! Regularization parameter of the factorization.
+  double lambda;
+  //! Seed of the random number generator.
+  size_t seed;
+  //! Only modes whose name contains this string are run.
+  std::string filter;
+};
+
+/**
+ * Generate the observations of a random rank-r matrix with noise (see
+ * MatrixFactorizationData()).
+ */
+MatrixFactorizationFunction GenerateProblem(
+    const ScalingBenchmarkOptions& options)
+{
+  arma::umat locations;
+  arma::vec values;
+  arma::mat parameters;
+  MatrixFactorizationData(options.users, options.items, options.perUser,
+      options.rank, locations, values, parameters, options.skew, 0.1,
+      options.seed);
+
+  return MatrixFactorizationFunction(locations, values, options.users,
+      options.items, options.rank, options.lambda);
+}
+
+/**
+ * Time ParallelSGD on the problem with the given update mode for every number
+ * of threads.
+ */
+void BenchmarkMode(const ScalingBenchmarkOptions& options,
+                   const std::string& name,
+                   MatrixFactorizationFunction& f,
+                   const std::vector<size_t>& threadCounts,
+                   const bool atomicUpdate,
+                   const bool numaLocality)
+{
+  if (name.find(options.filter) == std::string::npos)
+    return;
+
+  MatrixFactorizationFunction error(f);
+  error.Lambda() = 0.0;
+
+  const double updates = (double) options.passes * f.NumFunctions();
+  double baseline = 0.0;
+  for (size_t t = 0; t < threadCounts.size(); ++t)
+  {
+    // With no share size, every iteration is one pass over the observations;
+    // the objective is accumulated during the passes so that no serial
+    // evaluation of the whole objective is timed, and the tolerance is never
+    // reached.
+    ParallelSGD<ConstantStep, OpenMPExecutor> optimizer(options.passes + 1, 0,
+        -1.0, true, ConstantStep(options.stepSize), 1, atomicUpdate, true,
+        OpenMPExecutor(threadCounts[t]), numaLocality);
+
+    double seconds = std::numeric_limits<double>::infinity();
+    double rmse = 0.0;
+    for (size_t r = 0; r < options.repetitions; ++r)
+    {
+      arma::arma_rng::set_seed(options.seed + r);
+      arma::mat coordinates = f.GetInitialPoint();
+
+      const auto start = std::chrono::steady_clock::now();
+      optimizer.Optimize(f, coordinates);
+      seconds = std::min(seconds, std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count());
+
+      rmse = std::sqrt(error.Evaluate(coordinates) / f.NumFunctions());
+    }
+
+    if (t == 0)
+      baseline = seconds;
+    const double speedup = baseline / seconds;
+    std::cout << name << "," << threadCounts[t] << "," << f.NumFunctions()
+        << "," << options.passes << "," << seconds << "," << updates / seconds
+        << "," << speedup << "," << speedup / threadCounts[t] << "," << rmse
+        << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ScalingBenchmarkOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--help" || i + 1 == argc)
+    {
+      std::cout << "Usage: " << argv[0] << " [--users N] [--items N] "
+          << "[--per-user N] [--rank R] [--skew S] [--passes N] "
+          << "[--repetitions N] [--max-threads N] [--step-size A] "
+          << "[--lambda L] [--seed S] [--filter STRING]" << std::endl;
+      return (arg == "--help") ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+    if (arg == "--filter")
+      options.filter = value;
+    else if (arg == "--users")
+      options.users = std::stoul(value);
+    else if (arg == "--items")
+      options.items = std::stoul(value);
+    else if (arg == "--per-user")
+      options.perUser = std::stoul(value);
+    else if (arg == "--rank")
+      options.rank = std::stoul(value);
+    else if (arg == "--skew")
+      options.skew = std::stod(value);
+    else if (arg == "--passes")
+      options.passes = std::stoul(value);
+    else if (arg == "--repetitions")
+      options.repetitions = std::stoul(value);
+    else if (arg == "--max-threads")
+      options.maxThreads = std::stoul(value);
+    else if (arg == "--step-size")
+      options.stepSize = std::stod(value);
+    else if (arg == "--lambda")
+      options.lambda = std::stod(value);
+    else if (arg == "--seed")
+      options.seed = std::stoul(value);
+    else
+    {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  if (options.users == 0 || options.items == 0 || options.perUser == 0 ||
+      options.rank == 0 || options.passes == 0 || options.repetitions == 0)
+  {
+    std::cerr << "The sizes, passes and repetitions must be positive."
+        << std::endl;
+    return 1;
+  }
+
+  #ifndef ENS_USE_OPENMP
+    std::cerr << "Warning: OpenMP is not used, so every run is serial."
+        << std::endl;
+  #endif
+
+  // The thread counts are the powers of 2 up to the largest, and the largest.
+  const size_t maxThreads = (options.maxThreads == 0) ?
+      OpenMPExecutor().Threads() : options.maxThreads;
+  std::vector<size_t> threadCounts;
+  for (size_t t = 1; t < maxThreads; t *= 2)
+    threadCounts.push_back(t);
+  threadCounts.push_back(maxThreads);
+
+  MatrixFactorizationFunction f = GenerateProblem(options);
+
+  std::cout << "mode,threads,observations,passes,seconds,updates_per_second,"
+      << "speedup,efficiency,rmse" << std::endl;
+
+  BenchmarkMode(options, "Atomic", f, threadCounts, true, false);
+  BenchmarkMode(options, "Hogwild", f, threadCounts, false, false);
+  BenchmarkMode(options, "AtomicNUMA", f, threadCounts, true, true);
+
+  return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * @file sdp_benchmarks.cpp
+ * @author Ryan Curtin
+ *
+ * Time PrimalDualSolver and LRSDP on random SDPs of growing size and print the
+ * results as CSV to stdout.  Build with 'make ensmallen_sdp_benchmarks' and run
+ * with --help for the options.
+ *
+ * For every size n, three SDPs are generated with the generators of
+ * sdp_generators.hpp: the MaxCut relaxation of an Erdos-Renyi graph with n
+ * vertices (n constraints), its Lovasz-Theta SDP (one constraint per edge, and
+ * a dense objective), and the nuclear norm completion of a low-rank
+ * n / 2 x n / 2 matrix from a few of its entries.  With --dense, the
+ * constraints are stored as dense matrices instead of sparse ones.  For each
+ * run, the number of iterations (of the interior point method for
+ * PrimalDualSolver, and of the augmented Lagrangian method for LRSDP), the
+ * time, the time per iteration, the final objective and the peak memory of the
+ * run are printed.
+ *
+ * On Linux the peak memory of the process is reset before each run, so the
+ * peak memory is that of the run (including the memory held by the SDP);
+ * elsewhere it is the peak of the process so far, which only grows, so the
+ * sizes are run from the smallest to the largest.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+
+#include <chrono>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>
+#endif
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Options of the benchmark run.
+ */
+struct SDPBenchmarkOptions
+{
+  SDPBenchmarkOptions() :
+      sizes({ 25, 50, 100, 200 }),
+      edgeProbability(0.1),
+      rank(2),
+      oversampling(4.0),
+      denseConstraints(false),
+      maxIterations(1000),
+      repetitions(1),
+      seed(42)
+  { }
+
+  //! Sizes n of the SDPs.
+  std::vector<size_t> sizes;
+  //! Probability of every edge of the random graphs.
+  double edgeProbability;
+  //! Rank of the matrices to complete.
+  size_t rank;
+  //! Number of observed entries per degree of freedom of the matrices to
+  //! complete.
+  double oversampling;
+  //! Whether to store the constraints as dense matrices.
+  bool denseConstraints;
+  //! Maximum number of iterations of the solvers.
+  size_t maxIterations;
+  //! Number of times each benchmark is run.
+  size_t repetitions;
+  //! Random seed.
+  size_t seed;
+  //! Only run the benchmarks whose name contains this string.
+  std::string filter;
+};
+
+/**
+ * Reset the peak resident memory of the process to its current resident
+ * memory, where that is possible (Linux 4.0 and later).
+ */
+inline void ResetPeakMemory()
+{
+#if defined(__linux__)
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if (clearRefs.is_open())
+    clearRefs << "5";
+#endif
+}
+
+/**
+ * Return the peak resident memory of the process in kilobytes (since the last
+ * ResetPeakMemory() on Linux), or 0 if it is not available on this platform.
+ */
+inline size_t PeakMemory()
+{
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::stoul(line.substr(6));
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  #if defined(__APPLE__)
+    // ru_maxrss is in bytes on macOS.
+    return usage.ru_maxrss / 1024;
+  #else
+    return usage.ru_maxrss;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Get the starting point of LRSDP for an SDP with n rows and m constraints,
+ * whose rank is the bound r(r + 1) / 2 <= m of Barvinok and Pataki, with rows
+ * of the given norm (so that the MaxCut constraints hold).
+ */
+inline arma::mat LRSDPInitialPoint(const size_t n,
+                                   const size_t m,
+                                   const double rowNorm)
+{
+  const size_t r = std::min((size_t) std::ceil(0.5 + std::sqrt(0.25 + 2 * m)),
+      n);
+  arma::mat coordinates = arma::randn<arma::mat>(n, r);
+  coordinates = rowNorm * arma::normalise(coordinates, 2, 1);
+  return coordinates;
+}
+
+/**
+ * Run one solver on the SDP and print one line of results for each
+ * repetition.  The run function solves the SDP from a fresh starting point,
+ * passing the given TraceRecorder to the solver to count the iterations, and
+ * returns the final objective.
+ */
+template<typename SDPType, typename RunType>
+void BenchmarkRun(const SDPBenchmarkOptions& options,
+                  const std::string& problem,
+                  const SDPType& sdp,
+                  const std::string& solver,
+                  RunType run)
+{
+  const std::string name = problem + "/" + solver;
+  if (name.find(options.filter) == std::string::npos)
+    return;
+
+  for (size_t r = 0; r < options.repetitions; ++r)
+  {
+    arma::arma_rng::set_seed(options.seed + r);
+    TraceRecorder trace(1, 0);
+
+    ResetPeakMemory();
+    const auto start = std::chrono::steady_clock::now();
+    const double objective = run(trace);
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << problem << "," << sdp.N() << "," << sdp.NumConstraints()
+        << "," << (options.denseConstraints ? "dense" : "sparse") << ","
+        << solver << "," << r << "," << trace.Steps() << "," << seconds << ","
+        << seconds / std::max(trace.Steps(), (size_t) 1) << "," << objective
+        << "," << PeakMemory() << std::endl;
+  }
+}
+
+/**
+ * Run both solvers on the SDP.
+ */
+template<typename SDPType>
+void BenchmarkSDP(const SDPBenchmarkOptions& options,
+                  const std::string& problem,
+                  const SDPType& sdp,
+                  const double rowNorm)
+{
+  BenchmarkRun(options, problem, sdp, "PrimalDualSolver",
+      [&](TraceRecorder& trace)
+  {
+    PrimalDualSolver<SDPType> solver(sdp);
+    solver.MaxIterations() = options.maxIterations;
+    arma::mat x;
+    return solver.Optimize(x, trace);
+  });
+
+  BenchmarkRun(options, problem, sdp, "LRSDP", [&](TraceRecorder& trace)
+  {
+    arma::mat coordinates = LRSDPInitialPoint(sdp.N(), sdp.NumConstraints(),
+        rowNorm);
+    LRSDP<SDPType> lrsdp(sdp.NumSparseConstraints(), sdp.NumDenseConstraints(),
+        coordinates, options.maxIterations);
+    lrsdp.SDP() = sdp;
+    return lrsdp.Optimize(coordinates, trace);
+  });
+}
+
+int main(int argc, char** argv)
+{
+  SDPBenchmarkOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--dense")
+    {
+      options.denseConstraints = true;
+      continue;
+    }
+
+    if (arg == "--help" || i + 1 == argc)
+    {
+      std::cout << "Usage: " << argv[0] << " [--sizes N1,N2,...] "
+          << "[--edge-probability P] [--rank R] [--oversampling O] [--dense] "
+          << "[--max-iterations N] [--repetitions R] [--seed S] "
+          << "[--filter STRING]" << std::endl;
+      return (arg == "--help") ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+    if (arg == "--filter")
+      options.filter = value;
+    else if (arg == "--sizes")
+    {
+      options.sizes.clear();
+      std::istringstream sizes(value);
+      std::string size;
+      while (std::getline(sizes, size, ','))
+        options.sizes.push_back(std::stoul(size));
+    }
+    else if (arg == "--edge-probability")
+      options.edgeProbability = std::stod(value);
+    else if (arg == "--rank")
+      options.rank = std::stoul(value);
+    else if (arg == "--oversampling")
+      options.oversampling = std::stod(value);
+    else if (arg == "--max-iterations")
+      options.maxIterations = std::stoul(value);
+    else if (arg == "--repetitions")
+      options.repetitions = std::stoul(value);
+    else if (arg == "--seed")
+      options.seed = std::stoul(value);
+    else
+    {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "problem,n,constraints,constraint_storage,solver,repetition,"
+      << "iterations,seconds,seconds_per_iteration,objective,peak_memory_kb"
+      << std::endl;
+
+  std::sort(options.sizes.begin(), options.sizes.end());
+  for (size_t s = 0; s < options.sizes.size(); ++s)
+  {
+    const size_t n = options.sizes[s];
+    arma::arma_rng::set_seed(options.seed);
+    const arma::umat edges = RandomGraph(n, options.edgeProbability);
+
+    BenchmarkSDP(options, "MaxCut", GenerateMaxCutSDP(edges, n,
+        options.denseConstraints), 1.0);
+    BenchmarkSDP(options, "LovaszTheta", GenerateLovaszThetaSDP(edges, n,
+        options.denseConstraints), 1.0 / std::sqrt((double) n));
+
+    // The matrix has rank (rows + cols - rank) degrees of freedom; at the
+    // optimum, the trace of X is twice its nuclear norm.
+    const size_t rows = n / 2;
+    const size_t cols = n - rows;
+    const size_t observations = std::min(rows * cols, (size_t) std::ceil(
+        options.oversampling * options.rank * (rows + cols - options.rank)));
+    arma::mat m;
+    BenchmarkSDP(options, "MatrixCompletion", GenerateMatrixCompletionSDP(rows,
+        cols, options.rank, observations, m, options.denseConstraints),
+        std::sqrt(2.0 * arma::norm(m, "nuc") / n));
+  }
+
+  return 0;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file update_benchmarks.cpp
+ * @author Marcus Edel
+ *
+ * Time one step of the SGD update policies on a large iterate and print the
+ * results as CSV to stdout.  Build with 'make ensmallen_update_benchmarks' and
+ * run with --help for the options.
+ *
+ * The steps are bound by memory bandwidth, so for each policy the number of
+ * parameter-sized arrays that its step has to read or write at least once
+ * (e.g. 5 for MomentumUpdate: read g, read and write x and v) is given, and
+ * the bandwidth it reaches is compared with that of an axpy kernel that reads
+ * and writes the same number of arrays per element.  A relative bandwidth
+ * close to 1 means that the step makes no more passes over memory than it has
+ * to.
+ *
+ * The axpy kernel is timed twice: on arrays written first by the main thread,
+ * as a plain Armadillo allocation is, and on arrays placed with
+ * FirstTouchPlace(), as the state of the update policies is.  On a NUMA machine
+ * with OpenMP threads bound to their cores (e.g. OMP_PROC_BIND=true), the
+ * second one shows the bandwidth gained by keeping each chunk on the node of
+ * the thread that updates it.
+ *
+ * With --huge-pages transparent (or explicit), the state of the policies and
+ * the arrays placed with FirstTouchPlace() are backed by huge pages (see
+ * SetHugePages()), while the first axpy arrays keep the normal pages.  The
+ * dTLB load misses per step are read with perf_event on Linux (the counter
+ * needs /proc/sys/kernel/perf_event_paranoid at most 2); comparing the two axpy
+ * lines, or two runs with and without huge pages, shows the misses removed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+
+#include <cstring>
+#include <limits>
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+using namespace ens;
+
+/**
+ * Counter of the dTLB load misses of the process, read with perf_event on
+ * Linux.  It must be opened before the OpenMP threads are started, so that
+ * they inherit it.
+ */
+class DTLBMissCounter
+{
+ public:
+  DTLBMissCounter() : fd(-1) { }
+
+  ~DTLBMissCounter()
+  {
+  #if defined(__linux__)
+    if (fd != -1)
+      close(fd);
+  #endif
+  }
+
+  //! Open the counter; return false if perf_event is not available.
+  bool Open()
+  {
+  #if defined(__linux__)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    return fd != -1;
+  #else
+    return false;
+  #endif
+  }
+
+  //! Reset and start the counter.
+  void Start()
+  {
+  #if defined(__linux__)
+    if (fd == -1)
+      return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  #endif
+  }
+
+  //! Stop the counter and return its value (NaN if it is not open).
+  double Stop()
+  {
+    double value = std::numeric_limits<double>::quiet_NaN();
+  #if defined(__linux__)
+    if (fd == -1)
+      return value;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    unsigned long long count;
+    if (read(fd, &count, sizeof(count)) == (ssize_t) sizeof(count))
+      value = (double) count;
+  #endif
+    return value;
+  }
+
+ private:
+  int fd;
+};
+
+/**
+ * Options of the benchmark run.
+ */
+struct UpdateBenchmarkOptions
+{
+  UpdateBenchmarkOptions() :
+      elements(1 << 24),
+      minTime(0.5),
+      seed(42)
+  { }
+
+  //! Number of elements of the iterate.
+  size_t elements;
+  //! Minimum time (in seconds) spent on each policy.
+  double minTime;
+  //! Random seed.
+  size_t seed;
+  //! Only run the benchmarks whose name contains this string.
+  std::string filter;
+  //! The counter of dTLB misses.
+  DTLBMissCounter tlbMisses;
+};
+
+/**
+ * Print one CSV line for the given timing of a kernel that streams the given
+ * number of parameter-sized arrays per call.
+ */
+inline double PrintResult(const UpdateBenchmarkOptions& options,
+                          const std::string& name,
+                          const size_t streams,
+                          const FunctionTiming& timing,
+                          const double tlbMisses,
+                          const double axpyBandwidth)
+{
+  const double seconds = timing.Seconds() / timing.Calls();
+  const double bandwidth = streams * options.elements * sizeof(double) /
+      seconds / 1e9;
+  std::cout << name << "," << options.elements << "," << streams << ","
+      << timing.Calls() << "," << seconds << ","
+      << seconds * 1e9 / options.elements << "," << bandwidth << ","
+      << ((axpyBandwidth > 0.0) ? bandwidth / axpyBandwidth : 1.0) << ","
+      << tlbMisses / timing.Calls() << std::endl;
+  return bandwidth;
+}
+
+/**
+ * Time the step of the given update policy on a random iterate and gradient.
+ */
+template<typename UpdatePolicyType>
+void BenchmarkUpdate(UpdateBenchmarkOptions& options,
+                     const std::string& name,
+                     const size_t streams,
+                     UpdatePolicyType updatePolicy,
+                     const double axpyBandwidth)
+{
+  if (name.find(options.filter) == std::string::npos)
+    return;
+
+  arma::arma_rng::set_seed(options.seed);
+  arma::mat iterate = arma::randu<arma::mat>(options.elements, 1);
+  arma::mat gradient = 1e-3 * arma::randn<arma::mat>(options.elements, 1);
+  FirstTouchPlace(iterate);
+  FirstTouchPlace(gradient);
+  typename UpdatePolicyType::template Policy<arma::mat, arma::mat> policy(
+      updatePolicy, iterate.n_rows, iterate.n_cols);
+
+  // Warm up, so that the state of the policy is allocated and paged in.
+  policy.Update(iterate, 1e-6, gradient);
+
+  options.tlbMisses.Start();
+  const FunctionTiming timing = detail::TimeCalls(name, 0, options.minTime,
+      [&](const size_t) { policy.Update(iterate, 1e-6, gradient); });
+  const double tlbMisses = options.tlbMisses.Stop();
+  PrintResult(options, name, streams, timing, tlbMisses, axpyBandwidth);
+}
+
+int main(int argc, char** argv)
+{
+  UpdateBenchmarkOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--help" || i + 1 == argc)
+    {
+      std::cout << "Usage: " << argv[0] << " [--elements N] [--min-time T] "
+          << "[--seed S] [--filter STRING] "
+          << "[--huge-pages none|transparent|explicit]" << std::endl;
+      return (arg == "--help") ? 0 : 1;
+    }
+
+    const std::string value = argv[++i];
+    if (arg == "--filter")
+      options.filter = value;
+    else if (arg == "--elements")
+      options.elements = std::stoul(value);
+    else if (arg == "--min-time")
+      options.minTime = std::stod(value);
+    else if (arg == "--seed")
+      options.seed = std::stoul(value);
+    else if (arg == "--huge-pages" && value == "none")
+      SetHugePages(NoHugePages);
+    else if (arg == "--huge-pages" && value == "transparent")
+      SetHugePages(TransparentHugePages);
+    else if (arg == "--huge-pages" && value == "explicit")
+      SetHugePages(ExplicitHugePages);
+    else
+    {
+      std::cerr << "Unknown option " << arg << "." << std::endl;
+      return 1;
+    }
+  }
+
+  // Open the counter before the OpenMP threads are started.
+  if (!options.tlbMisses.Open())
+  {
+    std::cerr << "Cannot open the dTLB miss counter (perf_event is only "
+        << "available on Linux, and may be restricted by "
+        << "/proc/sys/kernel/perf_event_paranoid)." << std::endl;
+  }
+
+  std::cout << "policy,elements,streams,calls,seconds_per_step,"
+      << "ns_per_element,gb_per_second,relative_bandwidth,"
+      << "dtlb_misses_per_step" << std::endl;
+
+  // The reference: x = x + a g, which reads g and reads and writes x.
+  arma::mat x = arma::randu<arma::mat>(options.elements, 1);
+  const arma::mat g = arma::randu<arma::mat>(options.elements, 1);
+  double* xMem = x.memptr();
+  const double* gMem = g.memptr();
+  options.tlbMisses.Start();
+  const FunctionTiming axpy = detail::TimeCalls("Axpy", 0, options.minTime,
+      [&](const size_t)
+      {
+        Elementwise(options.elements, [&](const size_t begin, const size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+            xMem[i] += 1e-6 * gMem[i];
+        });
+      });
+  PrintResult(options, "Axpy", 3, axpy, options.tlbMisses.Stop(), 0.0);
+
+  // The same kernel on arrays placed on the nodes of the threads; this is the
+  // reference of the update policies, whose state is placed the same way.
+  arma::mat placedX = x;
+  arma::mat placedG = g;
+  FirstTouchPlace(placedX);
+  FirstTouchPlace(placedG);
+  double* placedXMem = placedX.memptr();
+  const double* placedGMem = placedG.memptr();
+  options.tlbMisses.Start();
+  const FunctionTiming placedAxpy = detail::TimeCalls("AxpyFirstTouch", 0,
+      options.minTime, [&](const size_t)
+      {
+        Elementwise(options.elements, [&](const size_t begin, const size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+            placedXMem[i] += 1e-6 * placedGMem[i];
+        });
+      });
+  const double axpyBandwidth = PrintResult(options, "AxpyFirstTouch", 3,
+      placedAxpy, options.tlbMisses.Stop(), 0.0);
+
+  BenchmarkUpdate(options, "VanillaUpdate", 3, VanillaUpdate(),
+      axpyBandwidth);
+  BenchmarkUpdate(options, "MomentumUpdate", 5, MomentumUpdate(0.9),
+      axpyBandwidth);
+  BenchmarkUpdate(options, "NesterovMomentumUpdate", 5,
+      NesterovMomentumUpdate(0.9), axpyBandwidth);
+  BenchmarkUpdate(options, "AdamUpdate", 7, AdamUpdate(), axpyBandwidth);
+  BenchmarkUpdate(options, "LARSUpdate", 7, LARSUpdate(), axpyBandwidth);
+  BenchmarkUpdate(options, "LAMBUpdate", 10, LAMBUpdate(), axpyBandwidth);
+
+  return 0;
+}
@@ -21,6 +21,15 @@
   #define ARMA_USE_CXX11
 #endif
 
+// With ENS_ALIGNED_ALLOCATOR, Armadillo allocates all its memory aligned to a
+// cache line, and large buffers on huge pages if they are enabled (see
+// SetHugePages()).  Armadillo must not have been included before.
+#ifdef ENS_ALIGNED_ALLOCATOR
+  #include "ensmallen_bits/utility/huge_pages.hpp"
+  #define ARMA_ALIEN_MEM_ALLOC_FUNCTION ens::AlignedAllocate
+  #define ARMA_ALIEN_MEM_FREE_FUNCTION ens::AlignedFree
+#endif
+
 #include <armadillo>
 
 #if !defined(ARMA_USE_CXX11)
@@ -56,50 +65,111 @@
 #endif
 
 #include "ensmallen_bits/config.hpp"
+
+#ifdef ENS_USE_COOT
+  #include <bandicoot>
+#endif
+
 #include "ensmallen_bits/ens_version.hpp"
 #include "ensmallen_bits/log.hpp" // TODO: should move to another place
-
-#include "ensmallen_bits/problems/problems.hpp" // TODO: should move to another place
+#include "ensmallen_bits/utility/any.hpp"
+#include "ensmallen_bits/utility/trace.hpp"
+#include "ensmallen_bits/utility/profile.hpp"
+#include "ensmallen_bits/utility/optimizer_state.hpp"
+#include "ensmallen_bits/utility/random.hpp"
+#include "ensmallen_bits/utility/deterministic.hpp"
+#include "ensmallen_bits/utility/huge_pages.hpp"
+#include "ensmallen_bits/utility/elementwise.hpp"
+#include "ensmallen_bits/utility/importance_sampler.hpp"
+#include "ensmallen_bits/utility/cancellation_token.hpp"
+#include "ensmallen_bits/utility/memory_estimate.hpp"
+#include "ensmallen_bits/utility/hashed_parameters.hpp"
+#include "ensmallen_bits/callbacks/callbacks.hpp"
+#include "ensmallen_bits/executors/executors.hpp"
 
 #include "ensmallen_bits/ada_delta/ada_delta.hpp"
+#include "ensmallen_bits/ada_factor/ada_factor.hpp"
 #include "ensmallen_bits/ada_grad/ada_grad.hpp"
 #include "ensmallen_bits/adam/adam.hpp"
+#include "ensmallen_bits/admm/consensus_admm.hpp"
 #include "ensmallen_bits/aug_lagrangian/aug_lagrangian.hpp"
+#include "ensmallen_bits/batched/batched_gradient_descent.hpp"
+#include "ensmallen_bits/batched/batched_lbfgs.hpp"
 #include "ensmallen_bits/bigbatch_sgd/bigbatch_sgd.hpp"
+#include "ensmallen_bits/block_separable/block_separable.hpp"
 #include "ensmallen_bits/cmaes/cmaes.hpp"
+#include "ensmallen_bits/cmaes/ipop_cmaes.hpp"
 #include "ensmallen_bits/cne/cne.hpp"
+#include "ensmallen_bits/data_parallel_sgd/data_parallel_sgd.hpp"
 #include "ensmallen_bits/eve/eve.hpp"
 #include "ensmallen_bits/ftml/ftml.hpp"
+#include "ensmallen_bits/ftrl/ftrl.hpp"
 
 #include "ensmallen_bits/function.hpp" // TODO: should move to function/
 
 #include "ensmallen_bits/fw/frank_wolfe.hpp"
+#include "ensmallen_bits/fw/stochastic_frank_wolfe.hpp"
 #include "ensmallen_bits/gradient_descent/gradient_descent.hpp"
 #include "ensmallen_bits/grid_search/grid_search.hpp"
+#include "ensmallen_bits/hyperband/hyperband.hpp"
 #include "ensmallen_bits/iqn/iqn.hpp"
+#include "ensmallen_bits/iqn/liqn.hpp"
 #include "ensmallen_bits/katyusha/katyusha.hpp"
+#include "ensmallen_bits/katyusha/loopless_katyusha.hpp"
 #include "ensmallen_bits/lbfgs/lbfgs.hpp"
+#include "ensmallen_bits/lbfgs/lbfgs_b.hpp"
+#include "ensmallen_bits/lbfgs/online_lbfgs.hpp"
+#include "ensmallen_bits/lbfgs/owlqn.hpp"
+#include "ensmallen_bits/local_sgd/local_sgd.hpp"
+#include "ensmallen_bits/multi_start/multi_start.hpp"
+#include "ensmallen_bits/newton_cg/newton_cg.hpp"
+#include "ensmallen_bits/nonlinear_cg/nonlinear_cg.hpp"
 #include "ensmallen_bits/padam/padam.hpp"
+#include "ensmallen_bits/parallel_sgd/async_parallel_sgd.hpp"
 #include "ensmallen_bits/parallel_sgd/parallel_sgd.hpp"
+#include "ensmallen_bits/proximal_gradient/proximal_gradient.hpp"
 #include "ensmallen_bits/rmsprop/rmsprop.hpp"
 
 #include "ensmallen_bits/sa/sa.hpp"
+#include "ensmallen_bits/saga/saga.hpp"
 #include "ensmallen_bits/sarah/sarah.hpp"
 #include "ensmallen_bits/scd/scd.hpp"
+#include "ensmallen_bits/scd/accelerated_scd.hpp"
 #include "ensmallen_bits/sdp/sdp.hpp"
 #include "ensmallen_bits/sdp/lrsdp.hpp"
 #include "ensmallen_bits/sdp/primal_dual.hpp"
+#include "ensmallen_bits/sdp/chordal_decomposition.hpp"
 
 #include "ensmallen_bits/sgd/sgd.hpp"
 // TODO: this should probably be included in sgd.hpp
 #include "ensmallen_bits/sgd/update_policies/gradient_clipping.hpp"
+#include "ensmallen_bits/sgd/update_policies/lamb_update.hpp"
+#include "ensmallen_bits/sgd/update_policies/lars_update.hpp"
+#include "ensmallen_bits/sgd/update_policies/lazy_weight_decay.hpp"
+#include "ensmallen_bits/sgd/update_policies/lookahead.hpp"
+#include "ensmallen_bits/sgd/update_policies/mixed_precision.hpp"
+#include "ensmallen_bits/sgd/update_policies/parameter_groups.hpp"
+#include "ensmallen_bits/sgd/update_policies/weight_averaging.hpp"
 #include "ensmallen_bits/sgdr/sgdr.hpp"
 #include "ensmallen_bits/sgdr/snapshot_ensembles.hpp"
 #include "ensmallen_bits/sgdr/snapshot_sgdr.hpp"
 #include "ensmallen_bits/smorms3/smorms3.hpp"
 #include "ensmallen_bits/spalera_sgd/spalera_sgd.hpp"
+#include "ensmallen_bits/sqn/sqn.hpp"
+#include "ensmallen_bits/streaming/streaming_function.hpp"
 #include "ensmallen_bits/svrg/svrg.hpp"
+#include "ensmallen_bits/svrg/loopless_svrg.hpp"
+#include "ensmallen_bits/svrg/async_svrg.hpp"
 #include "ensmallen_bits/swats/swats.hpp"
 #include "ensmallen_bits/wn_grad/wn_grad.hpp"
 
+// The test problems are only included on request; see config.hpp.
+#ifdef ENS_INCLUDE_PROBLEMS
+  #include "ensmallen_bits/problems/problems.hpp"
+#endif
+
+#ifdef ENS_USE_EXTERN_TEMPLATES
+  #include "ensmallen_bits/extern_templates.hpp"
+#endif
+
 #endif
@@ -0,0 +1,211 @@
+/**
+ * @file ada_factor.hpp
+ * @author Marcus Edel
+ *
+ * Definition of the AdaFactor optimizer, an adaptive learning rate method with
+ * factored second moment estimates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADA_FACTOR_ADA_FACTOR_HPP
+#define ENSMALLEN_ADA_FACTOR_ADA_FACTOR_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include "ada_factor_update.hpp"
+
+namespace ens {
+
+/**
+ * AdaFactor is an adaptive learning rate method whose second moment estimate of
+ * a matrix iterate is factored into row and column statistics, so that its
+ * state takes O(rows + cols) memory instead of the two parameter-sized matrices
+ * of Adam; see AdaFactorUpdate for the details of the update.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Shazeer2018,
+ *   title     = {Adafactor: Adaptive Learning Rates with Sublinear Memory
+ *                Cost},
+ *   author    = {Shazeer, Noam and Stern, Mitchell},
+ *   booktitle = {Proceedings of the 35th International Conference on Machine
+ *                Learning},
+ *   pages     = {4596--4604},
+ *   year      = {2018}
+ * }
+ * @endcode
+ *
+ * AdaFactor can optimize differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class AdaFactor
+{
+ public:
+  /**
+   * Construct the AdaFactor optimizer with the given function and parameters.
+   * The defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.  The
+   * maximum number of iterations refers to the maximum number of points that
+   * are processed (i.e., one iteration equals one point; one iteration does not
+   * equal one pass over the dataset).
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Number of points to process in a single step.
+   * @param epsilon Value added to the squared gradients for numerical
+   *        stability.
+   * @param clippingThreshold Maximum root mean square of the update (0 means
+   *        no clipping).
+   * @param decayRate Exponent c of the decay rate 1 - t^(-c) of the second
+   *        moment estimates.
+   * @param beta1 Exponential decay rate of the first moment (0 means no first
+   *        moment is kept).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *        limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *        function is visited in linear order.
+   */
+  AdaFactor(const double stepSize = 0.01,
+            const size_t batchSize = 32,
+            const double epsilon = 1e-30,
+            const double clippingThreshold = 1.0,
+            const double decayRate = 0.8,
+            const double beta1 = 0.0,
+            const size_t maxIterations = 100000,
+            const double tolerance = 1e-5,
+            const bool shuffle = true) :
+      optimizer(stepSize,
+                batchSize,
+                maxIterations,
+                tolerance,
+                shuffle,
+                AdaFactorUpdate(epsilon, clippingThreshold, decayRate, beta1))
+  { /* Nothing to do here. */ }
+
+  /**
+   * Optimize the given function using AdaFactor. The given starting point will
+   * be modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType>(function, iterate, callbacks...);
+  }
+
+  //! Get the step size.
+  double StepSize() const { return optimizer.StepSize(); }
+  //! Modify the step size.
+  double& StepSize() { return optimizer.StepSize(); }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return optimizer.BatchSize(); }
+  //! Modify the batch size.
+  size_t& BatchSize() { return optimizer.BatchSize(); }
+
+  //! Get the value added to the squared gradients.
+  double Epsilon() const { return optimizer.UpdatePolicy().Epsilon(); }
+  //! Modify the value added to the squared gradients.
+  double& Epsilon() { return optimizer.UpdatePolicy().Epsilon(); }
+
+  //! Get the maximum root mean square of the update.
+  double ClippingThreshold() const
+  { return optimizer.UpdatePolicy().ClippingThreshold(); }
+  //! Modify the maximum root mean square of the update.
+  double& ClippingThreshold()
+  { return optimizer.UpdatePolicy().ClippingThreshold(); }
+
+  //! Get the exponent of the decay rate of the second moment estimates.
+  double DecayRate() const { return optimizer.UpdatePolicy().DecayRate(); }
+  //! Modify the exponent of the decay rate of the second moment estimates.
+  double& DecayRate() { return optimizer.UpdatePolicy().DecayRate(); }
+
+  //! Get the decay rate of the first moment.
+  double Beta1() const { return optimizer.UpdatePolicy().Beta1(); }
+  //! Modify the decay rate of the first moment.
+  double& Beta1() { return optimizer.UpdatePolicy().Beta1(); }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return optimizer.MaxIterations(); }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return optimizer.MaxIterations(); }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return optimizer.Tolerance(); }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return optimizer.Tolerance(); }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return optimizer.Shuffle(); }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return optimizer.Shuffle(); }
+
+  //! Get whether or not the gradient of each batch is computed in parallel.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not the gradient of each batch is computed in parallel.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get the number of functions in each gradient evaluation (0 means the whole
+  //! batch).
+  size_t MicroBatchSize() const { return optimizer.MicroBatchSize(); }
+  //! Modify the number of functions in each gradient evaluation (0 means the
+  //! whole batch).
+  size_t& MicroBatchSize() { return optimizer.MicroBatchSize(); }
+
+  //! Get the number of consecutive functions shuffled as a block (0 means the
+  //! functions are shuffled individually).
+  size_t ShuffleBlockSize() const { return optimizer.ShuffleBlockSize(); }
+  //! Modify the number of consecutive functions shuffled as a block (0 means
+  //! the functions are shuffled individually).
+  size_t& ShuffleBlockSize() { return optimizer.ShuffleBlockSize(); }
+
+  /**
+   * Store the state of the optimizer in the given state; see
+   * SGD::SaveState().
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
+ private:
+  //! The Stochastic Gradient Descent object with AdaFactor policy.
+  SGD<AdaFactorUpdate> optimizer;
+};
+
+} // namespace ens
+
+#endif
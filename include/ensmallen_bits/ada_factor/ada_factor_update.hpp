@@ -0,0 +1,378 @@
+/**
+ * @file ada_factor_update.hpp
+ * @author Marcus Edel
+ *
+ * AdaFactor update policy, with factored second moment estimates for matrix
+ * iterates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADA_FACTOR_ADA_FACTOR_UPDATE_HPP
+#define ENSMALLEN_ADA_FACTOR_ADA_FACTOR_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * AdaFactor is an adaptive learning rate method like RMSProp and Adam, which
+ * saves memory by not storing the full second moment estimate of a matrix
+ * iterate.  Instead, only the moving averages of the row sums R and the column
+ * sums C of the squared gradient are kept, and the second moment is estimated
+ * by the rank-1 factorization
+ *
+ * \f[
+ * \hat{V}_{ij} = \frac{R_i C_j}{\sum_k R_k},
+ * \f]
+ *
+ * so that the state of an m x n iterate takes O(m + n) memory instead of
+ * O(m n).  Vector iterates (one row or one column) keep the full second moment
+ * estimate.  The update \f$ U = G / \sqrt{\hat{V}} \f$ is scaled down so that
+ * its root mean square is at most the clipping threshold, and the decay rate
+ * of the averages at iteration t is \f$ \hat{\beta}_{2t} = 1 - t^{-c} \f$,
+ * which needs no bias correction.  A first moment (momentum) of the update is
+ * only kept (in a parameter-sized matrix) if beta1 is positive.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Shazeer2018,
+ *   title     = {Adafactor: Adaptive Learning Rates with Sublinear Memory
+ *                Cost},
+ *   author    = {Shazeer, Noam and Stern, Mitchell},
+ *   booktitle = {Proceedings of the 35th International Conference on Machine
+ *                Learning},
+ *   pages     = {4596--4604},
+ *   year      = {2018}
+ * }
+ * @endcode
+ */
+class AdaFactorUpdate
+{
+ public:
+  /**
+   * Construct the AdaFactor update policy with the given parameters.
+   *
+   * @param epsilon Value added to the squared gradients for numerical
+   *     stability.
+   * @param clippingThreshold Maximum root mean square of the update (0 means
+   *     no clipping).
+   * @param decayRate Exponent c of the decay rate 1 - t^(-c) of the second
+   *     moment estimates.
+   * @param beta1 Exponential decay rate of the first moment (0 means no first
+   *     moment is kept).
+   */
+  AdaFactorUpdate(const double epsilon = 1e-30,
+                  const double clippingThreshold = 1.0,
+                  const double decayRate = 0.8,
+                  const double beta1 = 0.0) :
+      epsilon(epsilon),
+      clippingThreshold(clippingThreshold),
+      decayRate(decayRate),
+      beta1(beta1)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the value added to the squared gradients.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value added to the squared gradients.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the maximum root mean square of the update.
+  double ClippingThreshold() const { return clippingThreshold; }
+  //! Modify the maximum root mean square of the update.
+  double& ClippingThreshold() { return clippingThreshold; }
+
+  //! Get the exponent of the decay rate of the second moment estimates.
+  double DecayRate() const { return decayRate; }
+  //! Modify the exponent of the decay rate of the second moment estimates.
+  double& DecayRate() { return decayRate; }
+
+  //! Get the decay rate of the first moment.
+  double Beta1() const { return beta1; }
+  //! Modify the decay rate of the first moment.
+  double& Beta1() { return beta1; }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(AdaFactorUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        factored(rows > 1 && cols > 1),
+        iteration(0)
+    {
+      if (factored)
+      {
+        rowStatistics.zeros(rows, 1);
+        columnStatistics.zeros(cols, 1);
+        rowScale.set_size(rows);
+        columnScale.set_size(cols);
+      }
+      else
+      {
+        v.zeros(rows, cols);
+      }
+
+      if (parent.beta1 > 0.0)
+        m.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for AdaFactor.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      // Increment the iteration counter variable.
+      ++iteration;
+      const double beta2 = 1.0 - std::pow(iteration, -parent.decayRate);
+      const double epsilon = parent.epsilon;
+
+      const size_t rows = iterate.n_rows;
+      const size_t cols = iterate.n_cols;
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // The sum of the squares of the unclipped update.
+      double sumSquares[1];
+      if (factored)
+      {
+        // Accumulate the row and column sums of the squared gradient in one
+        // pass; the factors of the update are used as buffers.
+        double* r = rowScale.memptr();
+        double* c = columnScale.memptr();
+        rowScale.zeros();
+        for (size_t j = 0; j < cols; ++j)
+        {
+          const GradElemType* gj = g + j * rows;
+          double columnSum = 0.0;
+          for (size_t i = 0; i < rows; ++i)
+          {
+            const double s = double(gj[i]) * gj[i] + epsilon;
+            r[i] += s;
+            columnSum += s;
+          }
+          c[j] = columnSum;
+        }
+
+        rowStatistics = beta2 * rowStatistics + (1.0 - beta2) * rowScale;
+        columnStatistics = beta2 * columnStatistics + (1.0 - beta2) *
+            columnScale;
+
+        // The update is U_ij = G_ij rowScale_i columnScale_j.
+        rowScale = 1.0 / arma::sqrt(rowStatistics);
+        columnScale = std::sqrt(arma::accu(rowStatistics)) /
+            arma::sqrt(columnStatistics);
+
+        sumSquares[0] = 0.0;
+        if (parent.clippingThreshold > 0.0)
+        {
+          r = rowScale.memptr();
+          c = columnScale.memptr();
+          for (size_t j = 0; j < cols; ++j)
+          {
+            const GradElemType* gj = g + j * rows;
+            double columnSum = 0.0;
+            for (size_t i = 0; i < rows; ++i)
+            {
+              const double u = gj[i] * r[i];
+              columnSum += u * u;
+            }
+            sumSquares[0] += columnSum * c[j] * c[j];
+          }
+        }
+      }
+      else
+      {
+        const ElemType beta2Elem = beta2;
+        const ElemType oneMinusBeta2 = 1.0 - beta2;
+        const ElemType epsilonElem = epsilon;
+        ElemType* vMem = v.memptr();
+
+        ElementwiseSums(iterate.n_elem, [&](const size_t begin,
+            const size_t end, double* partial)
+        {
+          for (size_t i = begin; i < end; ++i)
+          {
+            vMem[i] = beta2Elem * vMem[i] + oneMinusBeta2 * (g[i] * g[i] +
+                epsilonElem);
+            const double u = g[i] / std::sqrt(vMem[i]);
+            partial[0] += u * u;
+          }
+        }, sumSquares);
+      }
+
+      // Scale the update down if its root mean square is above the threshold.
+      double scale = stepSize;
+      if (parent.clippingThreshold > 0.0)
+      {
+        const double rms = std::sqrt(sumSquares[0] / iterate.n_elem);
+        scale /= std::max(1.0, rms / parent.clippingThreshold);
+      }
+
+      // Apply the update, through the first moment if there is one.
+      ElemType* x = iterate.memptr();
+      const bool momentum = (parent.beta1 > 0.0);
+      const ElemType beta1 = parent.beta1;
+      const ElemType oneMinusBeta1 = 1.0 - parent.beta1;
+      ElemType* mMem = m.memptr();
+      if (factored)
+      {
+        const double* r = rowScale.memptr();
+        const double* c = columnScale.memptr();
+        for (size_t j = 0; j < cols; ++j)
+        {
+          const GradElemType* gj = g + j * rows;
+          ElemType* xj = x + j * rows;
+          const ElemType cj = scale * c[j];
+          if (momentum)
+          {
+            ElemType* mj = mMem + j * rows;
+            for (size_t i = 0; i < rows; ++i)
+            {
+              mj[i] = beta1 * mj[i] + oneMinusBeta1 * (cj * ElemType(r[i]) *
+                  gj[i]);
+              xj[i] -= mj[i];
+            }
+          }
+          else
+          {
+            for (size_t i = 0; i < rows; ++i)
+              xj[i] -= cj * ElemType(r[i]) * gj[i];
+          }
+        }
+      }
+      else
+      {
+        const ElemType scaleElem = scale;
+        const ElemType* vMem = v.memptr();
+        Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+          {
+            const ElemType u = scaleElem * g[i] / std::sqrt(vMem[i]);
+            if (momentum)
+            {
+              mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * u;
+              x[i] -= mMem[i];
+            }
+            else
+            {
+              x[i] -= u;
+            }
+          }
+        });
+      }
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("rowStatistics", rowStatistics);
+      state.Set("columnStatistics", columnStatistics);
+      state.Set("v", v);
+      state.Set("m", m);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("rowStatistics", rowStatistics);
+      state.Get("columnStatistics", columnStatistics);
+      state.Get("v", v);
+      state.Get("m", m);
+      state.Get("iteration", iteration);
+    }
+
+    //! Get the moving average of the row sums of the squared gradient.
+    const arma::mat& RowStatistics() const { return rowStatistics; }
+
+    //! Get the moving average of the column sums of the squared gradient.
+    const arma::mat& ColumnStatistics() const { return columnStatistics; }
+
+    //! Get the number of elements of the state of the policy.
+    size_t StateSize() const
+    {
+      return rowStatistics.n_elem + columnStatistics.n_elem + v.n_elem +
+          m.n_elem;
+    }
+
+   private:
+    //! Instantiated parent object.
+    AdaFactorUpdate& parent;
+
+    //! Whether the second moment estimate is factored.
+    bool factored;
+
+    //! The moving average of the row sums of the squared gradient.
+    arma::mat rowStatistics;
+
+    //! The moving average of the column sums of the squared gradient.
+    arma::mat columnStatistics;
+
+    //! The row and column factors of the update.
+    arma::vec rowScale;
+    arma::vec columnScale;
+
+    //! The second moment estimate of vector iterates.
+    arma::Mat<typename MatType::elem_type> v;
+
+    //! The first moment of the update, if beta1 is positive.
+    arma::Mat<typename MatType::elem_type> m;
+
+    //! The number of iterations.
+    double iteration;
+  };
+
+ private:
+  //! The value added to the squared gradients.
+  double epsilon;
+
+  //! The maximum root mean square of the update.
+  double clippingThreshold;
+
+  //! The exponent of the decay rate of the second moment estimates.
+  double decayRate;
+
+  //! The decay rate of the first moment.
+  double beta1;
+};
+
+} // namespace ens
+
+#endif
@@ -49,49 +49,131 @@ class AdaGradUpdate
     // Nothing to do.
   }
 
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process. In AdaGrad update policy, squared
-   * gradient matrix is initialized to the zeros matrix with the same size as
-   * gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Initialize an empty matrix for sum of squares of parameter gradient.
-    squaredGradient = arma::zeros<arma::mat>(rows, cols);
-  }
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.  In AdaGrad update policy, squared
+     * gradient matrix is initialized to the zeros matrix with the same size as
+     * gradient matrix (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(AdaGradUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        squaredGradient(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
 
-  /**
-   * Update step for SGD. The AdaGrad update adapts the learning rate by
-   * performing larger updates for more sparse parameters and smaller updates
-   * for less sparse parameters .
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
+    /**
+     * Update step for SGD. The AdaGrad update adapts the learning rate by
+     * performing larger updates for more sparse parameters and smaller updates
+     * for less sparse parameters .  If the gradient is sparse, only the
+     * coordinates with a non-zero gradient are touched.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, stepSize, gradient);
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      squaredGradient.zeros(rows, cols);
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("squaredGradient", squaredGradient);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("squaredGradient", squaredGradient);
+    }
+
+   private:
+    //! Take a step with a dense gradient.
+    template<typename DenseGradType>
+    void Step(MatType& iterate,
               const double stepSize,
-              const arma::mat& gradient)
-  {
-    squaredGradient += (gradient % gradient);
-    iterate -= (stepSize * gradient) / (arma::sqrt(squaredGradient) + epsilon);
-  }
+              const DenseGradType& gradient)
+    {
+      squaredGradient += (gradient % gradient);
+      iterate -= (stepSize * gradient) / (arma::sqrt(squaredGradient) +
+          parent.epsilon);
+    }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    //! Take a step with a sparse gradient; the squared gradient sums and the
+    //! iterate are only updated where the gradient is non-zero.
+    template<typename eT>
+    void Step(MatType& iterate,
+              const double stepSize,
+              const arma::SpMat<eT>& gradient)
+    {
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+        const eT g = (*it);
+
+        squaredGradient.at(row, col) += g * g;
+        iterate.at(row, col) -= stepSize * g /
+            (std::sqrt(squaredGradient.at(row, col)) + parent.epsilon);
+      }
+    }
+
+    // Instantiated parent object.
+    AdaGradUpdate& parent;
+
+    // The squared gradient matrix.
+    MatType squaredGradient;
+  };
 
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
-
-  // The squared gradient matrix.
-  arma::mat squaredGradient;
 };
 
 } // namespace ens
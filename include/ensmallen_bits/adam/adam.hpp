@@ -102,14 +102,24 @@ class AdamType
    * objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
   {
-    return optimizer.Optimize(function, iterate);
+    return optimizer.template Optimize<DecomposableFunctionType, MatType,
+        GradType>(function, iterate, callbacks...);
   }
 
   //! Get the step size.
@@ -152,6 +162,55 @@ class AdamType
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return optimizer.Shuffle(); }
 
+  //! Get whether or not the gradient of each batch is computed in parallel.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not the gradient of each batch is computed in parallel.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get the number of functions in each gradient evaluation (0 means the whole
+  //! batch).
+  size_t MicroBatchSize() const { return optimizer.MicroBatchSize(); }
+  //! Modify the number of functions in each gradient evaluation (0 means the
+  //! whole batch).
+  size_t& MicroBatchSize() { return optimizer.MicroBatchSize(); }
+
+  //! Get the number of consecutive functions shuffled as a block (0 means the
+  //! functions are shuffled individually).
+  size_t ShuffleBlockSize() const { return optimizer.ShuffleBlockSize(); }
+  //! Modify the number of consecutive functions shuffled as a block (0 means
+  //! the functions are shuffled individually).
+  size_t& ShuffleBlockSize() { return optimizer.ShuffleBlockSize(); }
+
+  //! Get whether the gradient of the next batch is computed while the update
+  //! of the current batch is applied.
+  bool Pipelined() const { return optimizer.Pipelined(); }
+  //! Modify whether the gradient of the next batch is computed while the
+  //! update of the current batch is applied.
+  bool& Pipelined() { return optimizer.Pipelined(); }
+
+  /**
+   * Store the state of the optimizer in the given state; see
+   * SGD::SaveState().
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
  private:
   //! The Stochastic Gradient Descent object with Adam policy.
   SGD<UpdateRule> optimizer;
@@ -52,58 +52,11 @@ class AdamUpdate
              const double beta2 = 0.999) :
     epsilon(epsilon),
     beta1(beta1),
-    beta2(beta2),
-    iteration(0)
+    beta2(beta2)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for Adam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    /**
-     * It should be noted that the term, m / (arma::sqrt(v) + eps), in the
-     * following expression is an approximation of the following actual term;
-     * m / (arma::sqrt(v) + (arma::sqrt(biasCorrection2) * eps).
-     */
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-        m / (arma::sqrt(v) + epsilon);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -119,6 +72,213 @@ class AdamUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent AdamUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(AdamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality; GPU matrices are allocated on the device.
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+    }
+
+    /**
+     * Update step for Adam.  If the gradient is sparse, only the coordinates
+     * with a non-zero gradient are touched; see SparseUpdate().
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      Step(iterate, stepSize * std::sqrt(biasCorrection2) / biasCorrection1,
+          gradient);
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      iteration = 0;
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("m", m);
+      state.Set("v", v);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("m", m);
+      state.Get("v", v);
+      state.Get("iteration", iteration);
+    }
+
+   private:
+    /**
+     * Take a step with a dense gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param correctedStepSize Step size including the bias corrections.
+     * @param gradient The gradient matrix.
+     */
+    template<typename DenseGradType>
+    void Step(MatType& iterate,
+              const double correctedStepSize,
+              const DenseGradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename DenseGradType::elem_type GradElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = correctedStepSize;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mMem = m.memptr();
+      ElemType* vMem = v.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // Update the moments and the iterate in a single pass.
+      //
+      // It should be noted that the term, m / (sqrt(v) + eps), in the
+      // following expression is an approximation of the following actual term;
+      // m / (sqrt(v) + (sqrt(biasCorrection2) * eps).
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * g[i];
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+          x[i] -= step * mMem[i] / (std::sqrt(vMem[i]) + epsilon);
+        }
+      });
+    }
+
+    /**
+     * Take a "lazy" step with a sparse gradient: the moment estimates and the
+     * iterate are only updated for the coordinates that have a non-zero
+     * gradient, so the cost of a step is linear in the number of non-zeros
+     * instead of the number of parameters.  The moment estimates of inactive
+     * coordinates are not decayed, as in the LazyAdam variant of Adam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param correctedStepSize Step size including the bias corrections.
+     * @param gradient The sparse gradient matrix.
+     */
+    template<typename eT>
+    void Step(MatType& iterate,
+              const double correctedStepSize,
+              const arma::SpMat<eT>& gradient)
+    {
+      typename arma::SpMat<eT>::const_iterator it = gradient.begin();
+      for ( ; it != gradient.end(); ++it)
+      {
+        const size_t row = it.row();
+        const size_t col = it.col();
+        const eT g = (*it);
+
+        m.at(row, col) = parent.beta1 * m.at(row, col) +
+            (1 - parent.beta1) * g;
+        v.at(row, col) = parent.beta2 * v.at(row, col) +
+            (1 - parent.beta2) * g * g;
+
+        iterate.at(row, col) -= correctedStepSize * m.at(row, col) /
+            (std::sqrt(v.at(row, col)) + parent.epsilon);
+      }
+    }
+
+    #ifdef ENS_USE_COOT
+    /**
+     * Take a step with a dense gradient on the GPU.  The moments are updated
+     * with whole-matrix expressions, which Bandicoot runs as kernels on the
+     * device, so that no element is copied to the host.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param correctedStepSize Step size including the bias corrections.
+     * @param gradient The gradient matrix.
+     */
+    template<typename eT>
+    void Step(MatType& iterate,
+              const double correctedStepSize,
+              const coot::Mat<eT>& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      m *= ElemType(parent.beta1);
+      m += ElemType(1 - parent.beta1) * gradient;
+      v *= ElemType(parent.beta2);
+      v += ElemType(1 - parent.beta2) * (gradient % gradient);
+      iterate -= ElemType(correctedStepSize) * m /
+          (coot::sqrt(v) + ElemType(parent.epsilon));
+    }
+    #endif
+
+    // Instantiated parent object.
+    AdamUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -128,15 +288,6 @@ class AdamUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -47,57 +47,11 @@ class AMSGradUpdate
                 const double beta2 = 0.999) :
     epsilon(epsilon),
     beta1(beta1),
-    beta2(beta2),
-    iteration(0)
+    beta2(beta2)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-    vImproved = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for AMSGrad.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    // Element wise maximum of past and present squared gradients.
-    vImproved = arma::max(vImproved, v);
-
-    iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-                m / (arma::sqrt(vImproved) + epsilon);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -113,6 +67,144 @@ class AMSGradUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent AMSGradUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(AMSGradUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(vImproved, rows, cols);
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(vImproved, rows, cols);
+      iteration = 0;
+    }
+
+    /**
+     * Update step for AMSGrad.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType step = stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1;
+
+      ElemType* x = iterate.memptr();
+      ElemType* mMem = m.memptr();
+      ElemType* vMem = v.memptr();
+      ElemType* vImprovedMem = vImproved.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // Update the moments, the element wise maximum of past and present
+      // squared gradients, and the iterate in a single pass.
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * g[i];
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+          vImprovedMem[i] = std::max(vImprovedMem[i], vMem[i]);
+          x[i] -= step * mMem[i] / (std::sqrt(vImprovedMem[i]) + epsilon);
+        }
+      });
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("m", m);
+      state.Set("v", v);
+      state.Set("vImproved", vImproved);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("m", m);
+      state.Get("v", v);
+      state.Get("vImproved", vImproved);
+      state.Get("iteration", iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    AMSGradUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The optimal sqaured gradient value.
+    MatType vImproved;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -122,18 +214,6 @@ class AMSGradUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
-  // The optimal sqaured gradient value.
-  arma::mat vImproved;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -51,68 +51,11 @@ class NadamUpdate
       beta1(beta1),
       beta2(beta2),
       scheduleDecay(scheduleDecay),
-      iteration(0),
       cumBeta1(1)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize() method is called by the optimizer before the start of the
-   * iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for Nadam.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    m *= beta1;
-    m += (1 - beta1) * gradient;
-
-    v *= beta2;
-    v += (1 - beta2) * gradient % gradient;
-
-    double beta1T = beta1 * (1 - (0.5 *
-        std::pow(0.96, iteration * scheduleDecay)));
-
-    double beta1T1 = beta1 * (1 - (0.5 *
-        std::pow(0.96, (iteration + 1) * scheduleDecay)));
-
-    cumBeta1 *= beta1T;
-
-    const double biasCorrection1 = 1.0 - cumBeta1;
-
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    const double biasCorrection3 = 1.0 - (cumBeta1 * beta1T1);
-
-    /* Note :- arma::sqrt(v) + epsilon * sqrt(biasCorrection2) is approximated
-     * as arma::sqrt(v) + epsilon
-     */
-    iterate -= (stepSize * (((1 - beta1T) / biasCorrection1) * gradient
-        + (beta1T1 / biasCorrection3) * m) * sqrt(biasCorrection2))
-        / (arma::sqrt(v) + epsilon);
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -138,6 +81,155 @@ class NadamUpdate
   //! Modify the decay parameter for decay coefficients
   double& ScheduleDecay() { return scheduleDecay; }
 
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent NadamUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(NadamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+
+      // The cumulative product of decay coefficients starts over with every
+      // new optimization.
+      parent.cumBeta1 = 1;
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      parent.cumBeta1 = 1;
+      iteration = 0;
+    }
+
+    /**
+     * Update step for Nadam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      double beta1T = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, iteration * parent.scheduleDecay)));
+
+      double beta1T1 = parent.beta1 * (1 - (0.5 *
+          std::pow(0.96, (iteration + 1) * parent.scheduleDecay)));
+
+      parent.cumBeta1 *= beta1T;
+
+      const double biasCorrection1 = 1.0 - parent.cumBeta1;
+
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      const double biasCorrection3 = 1.0 - (parent.cumBeta1 * beta1T1);
+
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType gradientWeight = (1 - beta1T) / biasCorrection1;
+      const ElemType momentWeight = beta1T1 / biasCorrection3;
+      const ElemType step = stepSize * std::sqrt(biasCorrection2);
+
+      ElemType* x = iterate.memptr();
+      ElemType* mMem = m.memptr();
+      ElemType* vMem = v.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // Update the moments and the iterate in a single pass.
+      //
+      // Note :- sqrt(v) + epsilon * sqrt(biasCorrection2) is approximated as
+      // sqrt(v) + epsilon
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * g[i];
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+          x[i] -= step * (gradientWeight * g[i] + momentWeight * mMem[i]) /
+              (std::sqrt(vMem[i]) + epsilon);
+        }
+      });
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("m", m);
+      state.Set("v", v);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("m", m);
+      state.Get("v", v);
+      state.Get("iteration", iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    NadamUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType m;
+
+    // The exponential moving average of squared gradient values.
+    MatType v;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -148,18 +240,9 @@ class NadamUpdate
   // The second moment coefficient.
   double beta2;
 
-  // The exponential moving average of gradient values.
-  arma::mat m;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat v;
-
   // The decay parameter for decay coefficients
   double scheduleDecay;
 
-  // The number of iterations.
-  double iteration;
-
   // The cumulative product of decay coefficients
   double cumBeta1;
 };
@@ -0,0 +1,107 @@
+/**
+ * @file admm_local_function.hpp
+ * @author Marcus Edel
+ *
+ * The local subproblem of consensus ADMM: a local function plus the quadratic
+ * penalty of its distance to the consensus.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADMM_ADMM_LOCAL_FUNCTION_HPP
+#define ENSMALLEN_ADMM_ADMM_LOCAL_FUNCTION_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * The function
+ *
+ *   f_j(x) + (rho / 2) ||x - target||^2,
+ *
+ * whose minimum is the local step of consensus ADMM, with target = z - u_j (the
+ * consensus minus the scaled dual variable of the block).  The local function
+ * only needs what the optimizer of the block needs; the missing methods are
+ * provided by the Function<> wrapper.
+ *
+ * @tparam FunctionType Type of the local function.
+ */
+template<typename FunctionType>
+class ADMMLocalFunction
+{
+ public:
+  /**
+   * Create the local subproblem; the function and the target are referenced,
+   * not copied.
+   *
+   * @param function Local function.
+   * @param target Center of the quadratic penalty.
+   * @param rho Strength of the quadratic penalty.
+   */
+  ADMMLocalFunction(FunctionType& function,
+                    const arma::mat& target,
+                    const double rho) :
+      function(static_cast<Function<FunctionType>&>(function)),
+      target(target),
+      rho(rho)
+  { /* Nothing to do. */ }
+
+  //! Evaluate the subproblem at the given coordinates.
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return function.Evaluate(coordinates) + 0.5 * rho *
+        SquaredDistance(coordinates);
+  }
+
+  //! Evaluate the gradient of the subproblem at the given coordinates.
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    function.Gradient(coordinates, gradient);
+    AddPenaltyGradient(coordinates, gradient);
+  }
+
+  //! Evaluate the subproblem and its gradient at the given coordinates.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient)
+  {
+    const double objective = function.EvaluateWithGradient(coordinates,
+        gradient);
+    AddPenaltyGradient(coordinates, gradient);
+    return objective + 0.5 * rho * SquaredDistance(coordinates);
+  }
+
+ private:
+  //! Return ||coordinates - target||^2.
+  double SquaredDistance(const arma::mat& coordinates) const
+  {
+    double result = 0.0;
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      const double d = coordinates[i] - target[i];
+      result += d * d;
+    }
+    return result;
+  }
+
+  //! Add rho (coordinates - target) to the gradient, in place.
+  void AddPenaltyGradient(const arma::mat& coordinates,
+                          arma::mat& gradient) const
+  {
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+      gradient[i] += rho * (coordinates[i] - target[i]);
+  }
+
+  //! The local function.
+  Function<FunctionType>& function;
+  //! The center of the quadratic penalty.
+  const arma::mat& target;
+  //! The strength of the quadratic penalty.
+  double rho;
+};
+
+} // namespace ens
+
+#endif
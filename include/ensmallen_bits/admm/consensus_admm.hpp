@@ -0,0 +1,235 @@
+/**
+ * @file consensus_admm.hpp
+ * @author Marcus Edel
+ *
+ * Consensus ADMM: minimize a sum of local functions, each solved by its own
+ * optimizer, plus a regularizer of the consensus.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADMM_CONSENSUS_ADMM_HPP
+#define ENSMALLEN_ADMM_CONSENSUS_ADMM_HPP
+
+#include <ensmallen_bits/communicators/communicators.hpp>
+#include <ensmallen_bits/lbfgs/lbfgs.hpp>
+#include <ensmallen_bits/proximal_gradient/proximal_gradient.hpp>
+#include "admm_local_function.hpp"
+
+namespace ens {
+
+/**
+ * Consensus ADMM minimizes
+ *
+ * \f[
+ * \sum_{j = 1}^{N} f_j(x) + g(x),
+ * \f]
+ *
+ * where the local functions f_j are typically the losses of the parts of a
+ * partitioned dataset, and g is a regularizer with a proximal operator (see
+ * ProximalGradient).  Each block has its own copy x_j of the coordinates, and
+ * every iteration is
+ *
+ *   x_j = argmin f_j(x) + (rho / 2) ||x - z + u_j||^2   (local, any optimizer)
+ *   z   = prox_{g / (N rho)}(mean_j (x_j + u_j))          (one sum over blocks)
+ *   u_j = u_j + x_j - z.
+ *
+ * The local problems are solved with copies of the given optimizer (e.g.
+ * L_BFGS), each warm started from its last solution; the blocks of a worker are
+ * solved in parallel if OpenMP is enabled.  The blocks may also be spread over
+ * the workers of a communicator (e.g. MPI processes): then the only
+ * communication of an iteration is the sum of the x_j + u_j and of three
+ * scalars for the termination criteria.
+ *
+ * The optimization stops when the primal residual ||x_j - z|| and the dual
+ * residual rho sqrt(N) ||z - z_old|| are below the tolerances of Boyd et al.
+ * (section 3.3.1), built from the absolute and the relative tolerance.  With
+ * adaptRho, rho is multiplied or divided by 2 when one residual is more than
+ * 10 times the other (section 3.4.1).  For more information, see the following.
+ *
+ * @code
+ * @article{Boyd2011,
+ *   author  = {Boyd, Stephen and Parikh, Neal and Chu, Eric and Peleato, Borja
+ *              and Eckstein, Jonathan},
+ *   title   = {Distributed Optimization and Statistical Learning via the
+ *              Alternating Direction Method of Multipliers},
+ *   journal = {Foundations and Trends in Machine Learning},
+ *   volume  = {3},
+ *   number  = {1},
+ *   pages   = {1--122},
+ *   year    = {2011}
+ * }
+ * @endcode
+ *
+ * @code
+ * // The rows of the dataset are split into blocks, with one least squares
+ * // function per block.
+ * std::vector<LeastSquaresFunction> blocks;
+ * ...
+ * ConsensusADMM<L_BFGS, L1Penalty> admm(L_BFGS(), 1.0);
+ * admm.Proximal().Lambda() = 0.1;
+ * arma::mat coordinates(d, 1, arma::fill::zeros);
+ * admm.Optimize(blocks, coordinates);
+ * @endcode
+ *
+ * @tparam OptimizerType Optimizer of the local problems.
+ * @tparam ProximalType Regularizer of the consensus (see NoPenalty, L1Penalty,
+ *     GroupLassoPenalty, BoxConstraint...).
+ * @tparam CommunicatorType Communicator of the workers (see NoCommunicator;
+ *     MPICommunicator is available if ENS_USE_MPI is defined).
+ */
+template<typename OptimizerType = L_BFGS,
+         typename ProximalType = NoPenalty,
+         typename CommunicatorType = NoCommunicator>
+class ConsensusADMM
+{
+ public:
+  /**
+   * Construct the consensus ADMM optimizer with the given parameters.
+   *
+   * @param optimizer Optimizer of the local problems, copied for each block.
+   * @param rho Strength of the quadratic penalty (initial value if adaptRho).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param absoluteTolerance Absolute tolerance of the residuals.
+   * @param relativeTolerance Relative tolerance of the residuals.
+   * @param adaptRho Whether rho is adapted to balance the residuals.
+   * @param proximal Regularizer of the consensus.
+   * @param communicator Communicator of the workers.
+   * @param parallel Whether to solve the local problems of this worker with
+   *     several OpenMP threads.
+   */
+  ConsensusADMM(const OptimizerType& optimizer = OptimizerType(),
+                const double rho = 1.0,
+                const size_t maxIterations = 1000,
+                const double absoluteTolerance = 1e-6,
+                const double relativeTolerance = 1e-4,
+                const bool adaptRho = true,
+                const ProximalType& proximal = ProximalType(),
+                const CommunicatorType& communicator = CommunicatorType(),
+                const bool parallel = true);
+
+  /**
+   * Minimize the sum of the given local functions (over all workers) plus the
+   * regularizer.  The given starting point is replaced by that of the first
+   * worker, and then by the consensus z at the end of the optimization (the
+   * same on all workers).  The objective at the consensus, summed over the
+   * workers, is returned.
+   *
+   * The callbacks are given to the optimization of every local problem.  If
+   * the blocks are solved in parallel, they may be called from several threads
+   * at once.
+   *
+   * @tparam FunctionType Type of the local functions.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param functions Local functions of the blocks of this worker.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(std::vector<FunctionType>& functions,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the optimizer that is copied for each block.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer that is copied for each block.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the strength of the quadratic penalty.
+  double Rho() const { return rho; }
+  //! Modify the strength of the quadratic penalty.
+  double& Rho() { return rho; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the absolute tolerance of the residuals.
+  double AbsoluteTolerance() const { return absoluteTolerance; }
+  //! Modify the absolute tolerance of the residuals.
+  double& AbsoluteTolerance() { return absoluteTolerance; }
+
+  //! Get the relative tolerance of the residuals.
+  double RelativeTolerance() const { return relativeTolerance; }
+  //! Modify the relative tolerance of the residuals.
+  double& RelativeTolerance() { return relativeTolerance; }
+
+  //! Get whether rho is adapted.
+  bool AdaptRho() const { return adaptRho; }
+  //! Modify whether rho is adapted.
+  bool& AdaptRho() { return adaptRho; }
+
+  //! Get the regularizer of the consensus.
+  const ProximalType& Proximal() const { return proximal; }
+  //! Modify the regularizer of the consensus.
+  ProximalType& Proximal() { return proximal; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get whether the local problems are solved in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the local problems are solved in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the number of iterations of the last call to Optimize().
+  size_t Iterations() const { return iterations; }
+
+  //! Get the final value of rho of the last call to Optimize().
+  double FinalRho() const { return finalRho; }
+
+  //! Get the primal residual of the last iteration.
+  double PrimalResidual() const { return primalResidual; }
+
+  //! Get the dual residual of the last iteration.
+  double DualResidual() const { return dualResidual; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The optimizer that is copied for each block.
+  OptimizerType optimizer;
+  //! The strength of the quadratic penalty.
+  double rho;
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! The absolute tolerance of the residuals.
+  double absoluteTolerance;
+  //! The relative tolerance of the residuals.
+  double relativeTolerance;
+  //! Whether rho is adapted.
+  bool adaptRho;
+  //! The regularizer of the consensus.
+  ProximalType proximal;
+  //! The communicator of the workers.
+  CommunicatorType communicator;
+  //! Whether the local problems are solved in parallel.
+  bool parallel;
+
+  //! The number of iterations of the last call to Optimize().
+  size_t iterations;
+  //! The final value of rho of the last call to Optimize().
+  double finalRho;
+  //! The primal residual of the last iteration.
+  double primalResidual;
+  //! The dual residual of the last iteration.
+  double dualResidual;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "consensus_admm_impl.hpp"
+
+#endif
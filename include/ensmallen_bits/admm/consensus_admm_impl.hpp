@@ -0,0 +1,216 @@
+/**
+ * @file consensus_admm_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of consensus ADMM.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADMM_CONSENSUS_ADMM_IMPL_HPP
+#define ENSMALLEN_ADMM_CONSENSUS_ADMM_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "consensus_admm.hpp"
+
+#include <atomic>
+
+namespace ens {
+
+template<typename OptimizerType,
+         typename ProximalType,
+         typename CommunicatorType>
+ConsensusADMM<OptimizerType, ProximalType, CommunicatorType>::ConsensusADMM(
+    const OptimizerType& optimizer,
+    const double rho,
+    const size_t maxIterations,
+    const double absoluteTolerance,
+    const double relativeTolerance,
+    const bool adaptRho,
+    const ProximalType& proximal,
+    const CommunicatorType& communicator,
+    const bool parallel) :
+    optimizer(optimizer),
+    rho(rho),
+    maxIterations(maxIterations),
+    absoluteTolerance(absoluteTolerance),
+    relativeTolerance(relativeTolerance),
+    adaptRho(adaptRho),
+    proximal(proximal),
+    communicator(communicator),
+    parallel(parallel),
+    iterations(0),
+    finalRho(rho),
+    primalResidual(0.0),
+    dualResidual(0.0)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType,
+         typename ProximalType,
+         typename CommunicatorType>
+template<typename FunctionType, typename... CallbackTypes>
+double ConsensusADMM<OptimizerType, ProximalType, CommunicatorType>::Optimize(
+    std::vector<FunctionType>& functions,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // All the workers start from the coordinates of the first worker.
+  const size_t n = iterate.n_elem;
+  communicator.Broadcast(iterate.memptr(), n, 0);
+
+  const size_t numLocal = functions.size();
+  double numBlocks = numLocal;
+  communicator.AllReduce(&numBlocks, 1);
+  if (numBlocks == 0)
+  {
+    throw std::invalid_argument("ConsensusADMM::Optimize(): no local "
+        "functions were given.");
+  }
+
+  // The local coordinates start at the consensus, and the scaled dual
+  // variables at zero.  The local optimizers are kept between iterations, so
+  // that they can reuse their buffers.
+  std::vector<arma::mat> x(numLocal, iterate);
+  std::vector<arma::mat> u(numLocal, arma::mat(iterate.n_rows,
+      iterate.n_cols, arma::fill::zeros));
+  std::vector<arma::mat> targets(numLocal, iterate);
+  std::vector<OptimizerType> optimizers(numLocal, optimizer);
+
+  arma::mat& z = iterate;
+  arma::mat zOld(z.n_rows, z.n_cols);
+  arma::mat average(z.n_rows, z.n_cols);
+
+  #ifdef ENS_USE_OPENMP
+    const size_t numThreads = parallel ? std::min(
+        (size_t) omp_get_max_threads(), numLocal) : 1;
+  #else
+    const size_t numThreads = 1;
+  #endif
+
+  double currentRho = rho;
+  const double sqrtN = std::sqrt(numBlocks);
+  const double absoluteScale = std::sqrt(n * numBlocks) * absoluteTolerance;
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  iterations = 0;
+  while (iterations < actualMaxIterations)
+  {
+    ++iterations;
+
+    // The local steps.
+    for (size_t j = 0; j < numLocal; ++j)
+      targets[j] = z - u[j];
+
+    auto localStep = [&](const size_t j)
+    {
+      ADMMLocalFunction<FunctionType> local(functions[j], targets[j],
+          currentRho);
+      optimizers[j].Optimize(local, x[j], callbacks...);
+    };
+
+    if (numThreads <= 1)
+    {
+      for (size_t j = 0; j < numLocal; ++j)
+        localStep(j);
+    }
+    else
+    {
+      // Every thread takes the next block that has not been started.
+      std::atomic<size_t> nextBlock(0);
+
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        for (size_t j = nextBlock++; j < numLocal; j = nextBlock++)
+          localStep(j);
+      }
+    }
+
+    // The consensus step: the proximal operator of g / (N rho) at the average
+    // of the x_j + u_j over all the blocks.
+    zOld = z;
+    average.zeros();
+    for (size_t j = 0; j < numLocal; ++j)
+      average += x[j] + u[j];
+    communicator.AllReduce(average.memptr(), n);
+    z = average / numBlocks;
+    proximal.ProximalStep(z, 1.0 / (numBlocks * currentRho));
+
+    // The dual step, and the norms of the termination criteria, which are
+    // summed over the workers at once.
+    double norms[3] = { 0.0, 0.0, 0.0 };
+    for (size_t j = 0; j < numLocal; ++j)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        const double r = x[j][i] - z[i];
+        u[j][i] += r;
+        norms[0] += r * r;
+        norms[1] += x[j][i] * x[j][i];
+        norms[2] += u[j][i] * u[j][i];
+      }
+    }
+    communicator.AllReduce(norms, 3);
+
+    primalResidual = std::sqrt(norms[0]);
+    dualResidual = currentRho * sqrtN * arma::norm(z - zOld, 2);
+
+    const double primalTolerance = absoluteScale + relativeTolerance *
+        std::max(std::sqrt(norms[1]), sqrtN * arma::norm(z, 2));
+    const double dualTolerance = absoluteScale + relativeTolerance *
+        currentRho * std::sqrt(norms[2]);
+
+    ENS_INFO << "ConsensusADMM: iteration " << iterations << ", primal "
+        << "residual " << primalResidual << ", dual residual " << dualResidual
+        << ", rho " << currentRho << "." << std::endl;
+
+    if (primalResidual <= primalTolerance && dualResidual <= dualTolerance)
+    {
+      ENS_INFO << "ConsensusADMM: minimized within tolerance; terminating "
+          << "optimization." << std::endl;
+      break;
+    }
+
+    // Balance the residuals; the scaled dual variables are u = y / rho.
+    if (adaptRho)
+    {
+      double factor = 1.0;
+      if (primalResidual > 10.0 * dualResidual)
+        factor = 2.0;
+      else if (dualResidual > 10.0 * primalResidual)
+        factor = 0.5;
+
+      if (factor != 1.0)
+      {
+        currentRho *= factor;
+        for (size_t j = 0; j < numLocal; ++j)
+          u[j] /= factor;
+      }
+    }
+  }
+
+  if (iterations == actualMaxIterations)
+  {
+    ENS_INFO << "ConsensusADMM: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  finalRho = currentRho;
+
+  // The objective at the consensus, over all the workers.
+  double objective = 0.0;
+  for (size_t j = 0; j < numLocal; ++j)
+  {
+    objective += static_cast<Function<FunctionType>&>(functions[j]).Evaluate(
+        z);
+  }
+  communicator.AllReduce(&objective, 1);
+  return objective + proximal.Evaluate(z);
+}
+
+} // namespace ens
+
+#endif
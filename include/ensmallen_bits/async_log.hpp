@@ -0,0 +1,216 @@
+/**
+ * @file async_log.hpp
+ * @author Marcus Edel
+ *
+ * Asynchronous sink for log streams; the Info and Warn streams use it if
+ * ENS_ASYNC_LOG is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ASYNC_LOG_HPP
+#define ENSMALLEN_ASYNC_LOG_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+namespace ens {
+
+/**
+ * The thread that writes the lines of the asynchronous log streams to their
+ * targets, in the order they were finished.  Formatting is still done by the
+ * thread that logs, but it never waits for the terminal or the file behind the
+ * target stream.  There is one sink for the whole program; the lines that are
+ * still queued when it is destroyed, at exit, are written first.
+ */
+class AsyncLogSink
+{
+ public:
+  //! Start the writing thread.
+  AsyncLogSink() : written(0), queued(0), stop(false)
+  {
+    writer = std::thread(&AsyncLogSink::Write, this);
+  }
+
+  //! Write the queued lines, and stop the writing thread.
+  ~AsyncLogSink()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_one();
+    writer.join();
+  }
+
+  //! Queue the given line, to be written to the given stream.
+  void Push(std::ostream& target, std::string& line)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      lines.push_back(Line());
+      lines.back().target = &target;
+      lines.back().text.swap(line);
+      ++queued;
+    }
+    wake.notify_one();
+  }
+
+  //! Wait until all the lines queued so far are written.
+  void Flush()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    const size_t last = queued;
+    done.wait(lock, [&]() { return written >= last; });
+  }
+
+  //! Get the sink of the program.
+  static AsyncLogSink& Global()
+  {
+    static AsyncLogSink sink;
+    return sink;
+  }
+
+ private:
+  //! A line to write, and its target.
+  struct Line
+  {
+    std::ostream* target;
+    std::string text;
+  };
+
+  //! The loop of the writing thread.
+  void Write()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      wake.wait(lock, [&]() { return stop || !lines.empty(); });
+      if (lines.empty())
+        return;
+
+      Line line;
+      line.target = lines.front().target;
+      line.text.swap(lines.front().text);
+      lines.pop_front();
+
+      lock.unlock();
+      line.target->write(line.text.data(), line.text.size());
+      line.target->flush();
+      lock.lock();
+
+      ++written;
+      done.notify_all();
+    }
+  }
+
+  //! The lines to write.
+  std::deque<Line> lines;
+
+  //! The number of lines written so far.
+  size_t written;
+
+  //! The number of lines queued so far.
+  size_t queued;
+
+  //! Whether the writing thread must stop once the queue is empty.
+  bool stop;
+
+  //! Protects the members above.
+  std::mutex mutex;
+
+  //! Signals a new line, or the stop.
+  std::condition_variable wake;
+
+  //! Signals a written line.
+  std::condition_variable done;
+
+  //! The writing thread.
+  std::thread writer;
+};
+
+/**
+ * A stream buffer that collects the text of a line and hands it to the sink
+ * when the line ends or the stream is flushed (e.g. by std::endl).  As with
+ * std::cout, the lines of threads that log at the same time may be mixed.
+ */
+class AsyncLogBuffer : public std::streambuf
+{
+ public:
+  /**
+   * Create the buffer of the given target stream.
+   *
+   * @param target Stream that the lines are written to.
+   */
+  AsyncLogBuffer(std::ostream& target) : target(target) { }
+
+  //! Hand the unfinished line, if any, to the sink.
+  ~AsyncLogBuffer() { sync(); }
+
+ protected:
+  //! Append a character.
+  int_type overflow(int_type c)
+  {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    line.push_back(traits_type::to_char_type(c));
+    if (c == '\n')
+      AsyncLogSink::Global().Push(target, line);
+    return c;
+  }
+
+  //! Append a sequence of characters.
+  std::streamsize xsputn(const char* s, std::streamsize n)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    line.append(s, n);
+    if (n > 0 && s[n - 1] == '\n')
+      AsyncLogSink::Global().Push(target, line);
+    return n;
+  }
+
+  //! Hand the current line to the sink.
+  int sync()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!line.empty())
+      AsyncLogSink::Global().Push(target, line);
+    return 0;
+  }
+
+ private:
+  //! The stream the lines are written to.
+  std::ostream& target;
+
+  //! The current line.
+  std::string line;
+
+  //! Serializes the threads that log.
+  std::mutex mutex;
+};
+
+/**
+ * Get the asynchronous stream that writes to the given target.  There is one
+ * stream per Index: ensmallen uses 0 for the Info stream and 1 for the Warn
+ * stream, and the target is only used by the first call for each Index.
+ */
+template<int Index>
+inline std::ostream& AsyncLogStream(std::ostream& target)
+{
+  // The sink has to outlive the buffer, which flushes it.
+  AsyncLogSink::Global();
+  static AsyncLogBuffer buffer(target);
+  static std::ostream stream(&buffer);
+  return stream;
+}
+
+} // namespace ens
+
+#endif
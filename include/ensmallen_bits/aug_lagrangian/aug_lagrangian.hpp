@@ -29,33 +29,77 @@ namespace ens {
  * AugLagrangian can optimize constrained functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * Each subproblem is solved with the inner optimizer, L-BFGS by default; any
+ * optimizer for differentiable functions can be used instead.  The subproblems
+ * of the first iterations do not need to be solved to full precision, so the
+ * tolerance of the inner optimizer (MinGradientNorm() for L-BFGS, Tolerance()
+ * for the others) can be loosened at first and tightened at each iteration:
+ * with an initial inner tolerance t_0, iteration k uses
+ * max(t_0 * decay^k, t), where t is the tolerance of the inner optimizer.
+ *
+ * @tparam InnerOptimizerType Optimizer used to solve each subproblem.
  */
-class AugLagrangian
+template<typename InnerOptimizerType = L_BFGS>
+class AugLagrangianType
 {
  public:
   /**
-   * Initialize the Augmented Lagrangian with the default L-BFGS optimizer.  We
-   * limit the number of L-BFGS iterations to 1000, rather than the unlimited
-   * default L-BFGS.
+   * Initialize the Augmented Lagrangian with the default inner optimizer.  For
+   * L-BFGS, we limit the number of iterations to 1000, rather than the
+   * unlimited default L-BFGS.
+   *
+   * @param warmStart If true, keep the Lagrange multipliers, the penalty
+   *     parameter and the penalty threshold at the end of every call to
+   *     Optimize(), and continue with them in the next call.
+   */
+  AugLagrangianType(const bool warmStart = false);
+
+  /**
+   * Initialize the Augmented Lagrangian with the given inner optimizer.
+   *
+   * @param innerOptimizer Optimizer used to solve each subproblem.
+   * @param warmStart If true, keep the Lagrange multipliers, the penalty
+   *     parameter and the penalty threshold at the end of every call to
+   *     Optimize(), and continue with them in the next call.
+   * @param innerTolerance Tolerance of the inner optimizer at the first
+   *     iteration; 0 uses the tolerance of the inner optimizer throughout.
+   * @param innerToleranceDecay Factor the inner tolerance is multiplied by at
+   *     each iteration, until it reaches the tolerance of the inner optimizer.
    */
-  AugLagrangian();
+  AugLagrangianType(const InnerOptimizerType& innerOptimizer,
+                    const bool warmStart = false,
+                    const double innerTolerance = 0.0,
+                    const double innerToleranceDecay = 0.1);
 
   /**
    * Optimize the function.  The value '1' is used for the initial value of each
    * Lagrange multiplier.  To set the Lagrange multipliers yourself, use the
    * other overload of Optimize().
    *
+   * Any number of callbacks may be given after maxIterations; an epoch is one
+   * iteration of the Augmented Lagrangian algorithm (one inner
+   * optimization), after which the objective is reported to Evaluate() and a
+   * step is reported to StepTaken().
+   *
+   * The Lagrange multipliers and the penalty parameter found by the last call
+   * are used instead of the default values, if there are any: they are kept
+   * when the optimization converges and, with WarmStart(), however it ends.
+   *
    * @tparam LagrangianFunctionType Function which can be optimized by this
    *     class.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function The function to optimize.
    * @param coordinates Output matrix to store the optimized coordinates in.
    * @param maxIterations Maximum number of iterations of the Augmented
    *     Lagrangian algorithm.  0 indicates no maximum.
+   * @param callbacks Callback functions.
    */
-  template<typename LagrangianFunctionType>
+  template<typename LagrangianFunctionType, typename... CallbackTypes>
   bool Optimize(LagrangianFunctionType& function,
                 arma::mat& coordinates,
-                const size_t maxIterations = 1000);
+                const size_t maxIterations = 1000,
+                CallbackTypes&&... callbacks);
 
   /**
    * Optimize the function, giving initial estimates for the Lagrange
@@ -71,18 +115,37 @@ class AugLagrangian
    * @param initSigma Initial penalty parameter.
    * @param maxIterations Maximum number of iterations of the Augmented
    *     Lagrangian algorithm.  0 indicates no maximum.
+   * @param callbacks Callback functions.
    */
-  template<typename LagrangianFunctionType>
+  template<typename LagrangianFunctionType, typename... CallbackTypes>
   bool Optimize(LagrangianFunctionType& function,
                 arma::mat& coordinates,
                 const arma::vec& initLambda,
                 const double initSigma,
-                const size_t maxIterations = 1000);
-
-  //! Get the L-BFGS object used for the actual optimization.
-  const L_BFGS& LBFGS() const { return lbfgs; }
-  //! Modify the L-BFGS object used for the actual optimization.
-  L_BFGS& LBFGS() { return lbfgs; }
+                const size_t maxIterations = 1000,
+                CallbackTypes&&... callbacks);
+
+  //! Get the optimizer used for the subproblems.
+  const InnerOptimizerType& InnerOptimizer() const { return innerOptimizer; }
+  //! Modify the optimizer used for the subproblems.
+  InnerOptimizerType& InnerOptimizer() { return innerOptimizer; }
+
+  //! Get the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  const InnerOptimizerType& LBFGS() const { return innerOptimizer; }
+  //! Modify the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  InnerOptimizerType& LBFGS() { return innerOptimizer; }
+
+  //! Get the inner tolerance at the first iteration (0 if not adapted).
+  double InnerTolerance() const { return innerTolerance; }
+  //! Modify the inner tolerance at the first iteration (0 if not adapted).
+  double& InnerTolerance() { return innerTolerance; }
+
+  //! Get the factor the inner tolerance is multiplied by at each iteration.
+  double InnerToleranceDecay() const { return innerToleranceDecay; }
+  //! Modify the factor the inner tolerance is multiplied by at each iteration.
+  double& InnerToleranceDecay() { return innerToleranceDecay; }
 
   //! Get the Lagrange multipliers.
   const arma::vec& Lambda() const { return lambda; }
@@ -94,28 +157,90 @@ class AugLagrangian
   //! Modify the penalty parameter.
   double& Sigma() { return sigma; }
 
- private:
-  //! If the user did not pass an L_BFGS object, we'll use our own internal one.
-  L_BFGS lbfgsInternal;
+  //! Get whether the state is kept between calls to Optimize().
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether the state is kept between calls to Optimize().
+  bool& WarmStart() { return warmStart; }
+
+  //! Get whether the last call to Optimize() was terminated by a callback.
+  bool Terminated() const { return terminated; }
 
-  //! The L-BFGS optimizer that we will use.
-  L_BFGS& lbfgs;
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The optimizer used for the subproblems.
+  InnerOptimizerType innerOptimizer;
 
   //! Lagrange multipliers.
   arma::vec lambda;
   //! Penalty parameter.
   double sigma;
 
+  //! Whether to keep the state between calls to Optimize().
+  bool warmStart;
+  //! The penalty threshold at the end of the last call, if warm starting.
+  double lastPenaltyThreshold;
+
+  //! The inner tolerance at the first iteration.
+  double innerTolerance;
+  //! The factor the inner tolerance is multiplied by at each iteration.
+  double innerToleranceDecay;
+
+  //! Whether the last call to Optimize() was terminated by a callback.
+  bool terminated;
+
+  //! Limit the number of iterations of the default L-BFGS optimizer.
+  static void SetDefaults(L_BFGS& optimizer)
+  { optimizer.MaxIterations() = 1000; }
+  //! Other inner optimizers keep their defaults.
+  template<typename OptimizerType>
+  static void SetDefaults(OptimizerType& /* optimizer */) { }
+
+  //! Return the tolerance of an optimizer on the gradient norm (L-BFGS).
+  template<typename OptimizerType>
+  static auto ToleranceOf(OptimizerType& optimizer, int)
+      -> decltype(&optimizer.MinGradientNorm())
+  {
+    return &optimizer.MinGradientNorm();
+  }
+
+  //! Return the tolerance of an optimizer with a Tolerance() method.
+  template<typename OptimizerType>
+  static auto ToleranceOf(OptimizerType& optimizer, long)
+      -> decltype(&optimizer.Tolerance())
+  {
+    return &optimizer.Tolerance();
+  }
+
+  //! Other optimizers have no tolerance to adapt.
+  template<typename OptimizerType>
+  static double* ToleranceOf(OptimizerType& /* optimizer */, ...)
+  {
+    return NULL;
+  }
+
   /**
    * Internal optimization function: given an initialized AugLagrangianFunction,
    * perform the optimization itself.
    */
-  template<typename LagrangianFunctionType>
+  template<typename LagrangianFunctionType, typename... CallbackTypes>
   bool Optimize(AugLagrangianFunction<LagrangianFunctionType>& augfunc,
                 arma::mat& coordinates,
-                const size_t maxIterations);
+                const size_t maxIterations,
+                CallbackTypes&&... callbacks);
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
+// Convenience typedefs.
+
+/**
+ * The Augmented Lagrangian method with L-BFGS for the subproblems.
+ */
+using AugLagrangian = AugLagrangianType<L_BFGS>;
+
 } // namespace ens
 
 #include "aug_lagrangian_impl.hpp"
@@ -73,6 +73,18 @@ class AugLagrangianFunction
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the objective function and the gradient of the Augmented
+   * Lagrangian function at the same time, evaluating the constraints only
+   * once.
+   *
+   * @param coordinates Coordinates to evaluate the function and gradient at.
+   * @param gradient Matrix to store gradient into.
+   * @return Objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
   /**
    * Get the initial point of the optimization (supplied by the
    * LagrangianFunction).
@@ -97,6 +109,11 @@ class AugLagrangianFunction
   LagrangianFunction& Function() { return function; }
 
  private:
+  //! Evaluate the gradient given the values of the constraints.
+  void ConstrainedGradient(const arma::mat& coordinates,
+                           const arma::vec& constraints,
+                           arma::mat& gradient) const;
+
   //! Instantiation of the function to be optimized.
   LagrangianFunction& function;
 
@@ -17,6 +17,8 @@
 // In case it hasn't been included.
 #include "aug_lagrangian_function.hpp"
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 // Initialize the AugLagrangianFunction.
@@ -53,18 +55,14 @@ double AugLagrangianFunction<LagrangianFunction>::Evaluate(
   //    f(x) + {-lambda_i * c_i(x) + (sigma / 2) c_i(x)^2} for all constraints
 
   // First get the function's objective value.
-  double objective = function.Evaluate(coordinates);
-
-  // Now loop for each constraint.
-  for (size_t i = 0; i < function.NumConstraints(); ++i)
-  {
-    double constraint = function.EvaluateConstraint(i, coordinates);
+  const double objective = function.Evaluate(coordinates);
 
-    objective += (-lambda[i] * constraint) +
-        sigma * std::pow(constraint, 2) / 2;
-  }
+  // Now add the terms of all the constraints.
+  arma::vec constraints;
+  EvaluateAllConstraints(function, coordinates, constraints);
 
-  return objective;
+  return objective + arma::dot((sigma / 2.) * constraints - lambda,
+      constraints);
 }
 
 // Evaluate the gradient of the AugLagrangianFunction at the given coordinates.
@@ -75,20 +73,43 @@ void AugLagrangianFunction<LagrangianFunction>::Gradient(
 {
   // The augmented Lagrangian's gradient is evaluted as
   // f'(x) + {(-lambda_i + sigma * c_i(x)) * c'_i(x)} for all constraints
+  arma::vec constraints;
+  EvaluateAllConstraints(function, coordinates, constraints);
+  ConstrainedGradient(coordinates, constraints, gradient);
+}
+
+// Evaluate the gradient given the values of the constraints.
+template<typename LagrangianFunction>
+void AugLagrangianFunction<LagrangianFunction>::ConstrainedGradient(
+    const arma::mat& coordinates,
+    const arma::vec& constraints,
+    arma::mat& gradient) const
+{
   gradient.zeros();
   function.Gradient(coordinates, gradient);
 
-  arma::mat constraintGradient; // Temporary for constraint gradients.
-  for (size_t i = 0; i < function.NumConstraints(); i++)
-  {
-    function.GradientConstraint(i, coordinates, constraintGradient);
-
-    // Now calculate scaling factor and add to existing gradient.
-    arma::mat tmpGradient;
-    tmpGradient = (-lambda[i] + sigma *
-        function.EvaluateConstraint(i, coordinates)) * constraintGradient;
-    gradient += tmpGradient;
-  }
+  // The gradients of the constraints are summed with the scaling factors as
+  // weights, in a single call if the function supports it.
+  arma::mat constraintGradient;
+  WeightedConstraintGradient(function, coordinates,
+      arma::vec(sigma * constraints - lambda), constraintGradient);
+  gradient += constraintGradient;
+}
+
+// Evaluate the AugLagrangianFunction and its gradient at the given
+// coordinates.
+template<typename LagrangianFunction>
+double AugLagrangianFunction<LagrangianFunction>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  // The constraints are only evaluated once for both.
+  arma::vec constraints;
+  EvaluateAllConstraints(function, coordinates, constraints);
+  ConstrainedGradient(coordinates, constraints, gradient);
+
+  return function.Evaluate(coordinates) +
+      arma::dot((sigma / 2.) * constraints - lambda, constraints);
 }
 
 // Get the initial point.
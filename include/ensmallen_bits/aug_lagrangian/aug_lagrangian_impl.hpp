@@ -15,37 +15,62 @@
 
 #include <ensmallen_bits/lbfgs/lbfgs.hpp>
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 #include "aug_lagrangian_function.hpp"
 
 namespace ens {
 
-inline AugLagrangian::AugLagrangian() :
-    lbfgsInternal(),
-    lbfgs(lbfgsInternal)
+template<typename InnerOptimizerType>
+AugLagrangianType<InnerOptimizerType>::AugLagrangianType(const bool warmStart) :
+    innerOptimizer(),
+    warmStart(warmStart),
+    lastPenaltyThreshold(DBL_MAX),
+    innerTolerance(0.0),
+    innerToleranceDecay(0.1),
+    terminated(false)
 {
-  lbfgs.MaxIterations() = 1000;
+  SetDefaults(innerOptimizer);
 }
 
-template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(LagrangianFunctionType& function,
+template<typename InnerOptimizerType>
+AugLagrangianType<InnerOptimizerType>::AugLagrangianType(
+    const InnerOptimizerType& innerOptimizer,
+    const bool warmStart,
+    const double innerTolerance,
+    const double innerToleranceDecay) :
+    innerOptimizer(innerOptimizer),
+    warmStart(warmStart),
+    lastPenaltyThreshold(DBL_MAX),
+    innerTolerance(innerTolerance),
+    innerToleranceDecay(innerToleranceDecay),
+    terminated(false)
+{ /* Nothing to do. */ }
+
+template<typename InnerOptimizerType>
+template<typename LagrangianFunctionType, typename... CallbackTypes>
+bool AugLagrangianType<InnerOptimizerType>::Optimize(LagrangianFunctionType& function,
                              arma::mat& coordinates,
                              const arma::vec& initLambda,
                              const double initSigma,
-                             const size_t maxIterations)
+                             const size_t maxIterations,
+                             CallbackTypes&&... callbacks)
 {
   lambda = initLambda;
   sigma = initSigma;
+  lastPenaltyThreshold = DBL_MAX;
 
   AugLagrangianFunction<LagrangianFunctionType> augfunc(function,
       lambda, sigma);
 
-  return Optimize(augfunc, coordinates, maxIterations);
+  return Optimize(augfunc, coordinates, maxIterations, callbacks...);
 }
 
-template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(LagrangianFunctionType& function,
+template<typename InnerOptimizerType>
+template<typename LagrangianFunctionType, typename... CallbackTypes>
+bool AugLagrangianType<InnerOptimizerType>::Optimize(LagrangianFunctionType& function,
                              arma::mat& coordinates,
-                             const size_t maxIterations)
+                             const size_t maxIterations,
+                             CallbackTypes&&... callbacks)
 {
   // If the user did not specify the right size for sigma and lambda, we will
   // use defaults.
@@ -53,90 +78,124 @@ bool AugLagrangian::Optimize(LagrangianFunctionType& function,
   {
     AugLagrangianFunction<LagrangianFunctionType> augfunc(function, lambda,
         sigma);
-    return Optimize(augfunc, coordinates, maxIterations);
+    return Optimize(augfunc, coordinates, maxIterations, callbacks...);
   }
   else
   {
     AugLagrangianFunction<LagrangianFunctionType> augfunc(function);
-    return Optimize(augfunc, coordinates, maxIterations);
+    return Optimize(augfunc, coordinates, maxIterations, callbacks...);
   }
 }
 
-template<typename LagrangianFunctionType>
-bool AugLagrangian::Optimize(
+template<typename InnerOptimizerType>
+template<typename LagrangianFunctionType, typename... CallbackTypes>
+bool AugLagrangianType<InnerOptimizerType>::Optimize(
     AugLagrangianFunction<LagrangianFunctionType>& augfunc,
     arma::mat& coordinates,
-    const size_t maxIterations)
+    const size_t maxIterations,
+    CallbackTypes&&... callbacks)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   traits::CheckConstrainedFunctionTypeAPI<LagrangianFunctionType>();
 
   LagrangianFunctionType& function = augfunc.Function();
 
-  // Ensure that we update lambda immediately.
-  double penaltyThreshold = DBL_MAX;
+  // Ensure that we update lambda immediately, unless we continue from the
+  // last call.
+  double penaltyThreshold = warmStart ? lastPenaltyThreshold : DBL_MAX;
+
+  // The inner tolerance starts loose and is tightened at each iteration, down
+  // to the tolerance the inner optimizer was configured with.
+  double* toleranceParameter = ToleranceOf(innerOptimizer, 0);
+  const double finalTolerance = toleranceParameter ? *toleranceParameter : 0.0;
+  const bool adaptTolerance = (toleranceParameter != NULL) &&
+      (innerTolerance > finalTolerance);
+  double currentTolerance = innerTolerance;
 
   // Track the last objective to compare for convergence.
   double lastObjective = function.Evaluate(coordinates);
 
-  // Then, calculate the current penalty.
-  double penalty = 0;
-  for (size_t i = 0; i < function.NumConstraints(); i++)
-    penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
+  // Then, calculate the current penalty.  The constraints are evaluated once
+  // per outer iteration (in a single call if the function supports it), and
+  // shared by the penalty and the multiplier update.
+  arma::vec constraints;
+  EvaluateAllConstraints(function, coordinates, constraints);
+  double penalty = arma::dot(constraints, constraints);
 
-  Info << "Penalty is " << penalty << " (threshold " << penaltyThreshold
+  ENS_INFO << "Penalty is " << penalty << " (threshold " << penaltyThreshold
       << ")." << std::endl;
 
+  terminated = false;
+  bool terminate = Callback::BeginOptimization(*this, function, coordinates,
+      callbacks...);
+
   // The odd comparison allows user to pass maxIterations = 0 (i.e. no limit on
   // number of iterations).
   size_t it;
-  for (it = 0; it != (maxIterations - 1); it++)
+  for (it = 0; it != (maxIterations - 1) && !terminate; it++)
   {
-    Info << "AugLagrangian on iteration " << it
+    ENS_INFO << "AugLagrangian on iteration " << it
         << ", starting with objective "  << lastObjective << "." << std::endl;
 
-    if (!lbfgs.Optimize(augfunc, coordinates))
-      Info << "L-BFGS reported an error during optimization."
+    terminate |= Callback::BeginEpoch(*this, function, coordinates, it,
+        lastObjective, callbacks...);
+    if (terminate)
+      break;
+
+    if (adaptTolerance)
+    {
+      *toleranceParameter = std::max(currentTolerance, finalTolerance);
+      currentTolerance *= innerToleranceDecay;
+    }
+
+    if (!std::isfinite(innerOptimizer.Optimize(augfunc, coordinates)))
+      ENS_INFO << "The inner optimizer reported an error during optimization."
           << std::endl;
 
+    const double objective = function.Evaluate(coordinates);
+    terminate |= Callback::Evaluate(*this, function, coordinates, objective,
+        callbacks...);
+    terminate |= Callback::StepTaken(*this, function, coordinates,
+        callbacks...);
+
     // Check if we are done with the entire optimization (the threshold we are
     // comparing with is arbitrary).
-    if (std::abs(lastObjective - function.Evaluate(coordinates)) < 1e-10 &&
+    if (std::abs(lastObjective - objective) < 1e-10 &&
         augfunc.Sigma() > 500000)
     {
       lambda = std::move(augfunc.Lambda());
       sigma = augfunc.Sigma();
+      lastPenaltyThreshold = penaltyThreshold;
+      if (adaptTolerance)
+        *toleranceParameter = finalTolerance;
+      Callback::EndOptimization(*this, function, coordinates, callbacks...);
       return true;
     }
 
-    lastObjective = function.Evaluate(coordinates);
+    lastObjective = objective;
 
     // Assuming that the optimization has converged to a new set of coordinates,
     // we now update either lambda or sigma.  We update sigma if the penalty
     // term is too high, and we update lambda otherwise.
 
     // First, calculate the current penalty.
-    double penalty = 0;
-    for (size_t i = 0; i < function.NumConstraints(); i++)
-    {
-      penalty += std::pow(function.EvaluateConstraint(i, coordinates), 2);
-    }
+    EvaluateAllConstraints(function, coordinates, constraints);
+    penalty = arma::dot(constraints, constraints);
 
-    Info << "Penalty is " << penalty << " (threshold "
+    ENS_INFO << "Penalty is " << penalty << " (threshold "
         << penaltyThreshold << ")." << std::endl;
 
     if (penalty < penaltyThreshold) // We update lambda.
     {
-      // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates),
-      // but we have to write a loop to do this for each constraint.
-      for (size_t i = 0; i < function.NumConstraints(); i++)
-        augfunc.Lambda()[i] -= augfunc.Sigma() *
-            function.EvaluateConstraint(i, coordinates);
+      // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates).
+      augfunc.Lambda() -= augfunc.Sigma() * constraints;
 
       // We also update the penalty threshold to be a factor of the current
       // penalty.  TODO: this factor should be a parameter (from CLI).  The
       // value of 0.25 is taken from Burer and Monteiro (2002).
       penaltyThreshold = 0.25 * penalty;
-      Info << "Lagrange multiplier estimates updated." << std::endl;
+      ENS_INFO << "Lagrange multiplier estimates updated." << std::endl;
     }
     else
     {
@@ -144,10 +203,26 @@ bool AugLagrangian::Optimize(
       // parameter (from CLI).  The value of 10 is taken from Burer and Monteiro
       // (2002).
       augfunc.Sigma() *= 10;
-      Info << "Updated sigma to " << augfunc.Sigma() << "." << std::endl;
+      ENS_INFO << "Updated sigma to " << augfunc.Sigma() << "." << std::endl;
     }
+
+    terminate |= Callback::EndEpoch(*this, function, coordinates, it,
+        lastObjective, callbacks...);
   }
 
+  // Keep the state for the next call even though we did not converge.
+  if (warmStart)
+  {
+    lambda = augfunc.Lambda();
+    sigma = augfunc.Sigma();
+    lastPenaltyThreshold = penaltyThreshold;
+  }
+
+  if (adaptTolerance)
+    *toleranceParameter = finalTolerance;
+
+  terminated = terminate;
+  Callback::EndOptimization(*this, function, coordinates, callbacks...);
   return false;
 }
 
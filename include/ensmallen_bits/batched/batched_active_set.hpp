@@ -0,0 +1,149 @@
+/**
+ * @file batched_active_set.hpp
+ * @author Marcus Edel
+ *
+ * The set of the problems of a batched optimizer that have not converged yet.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_ACTIVE_SET_HPP
+#define ENSMALLEN_BATCHED_BATCHED_ACTIVE_SET_HPP
+
+namespace ens {
+namespace detail {
+
+/**
+ * BatchedActiveSet holds the indices of the problems of a batched optimization
+ * that are still being optimized.  The state of the active problems is kept in
+ * matrices with one row per active problem, so when a problem converges its
+ * final point is written back and its row is removed from the state; the
+ * following iterations only work (and call the function) on the problems that
+ * are left.
+ */
+class BatchedActiveSet
+{
+ public:
+  /**
+   * Start with all the given problems active.
+   *
+   * @param numProblems The number of problems.
+   * @param objectives Vector to store the final objectives in.
+   * @param iterations Vector to store the number of iterations of each problem
+   *     in.
+   */
+  BatchedActiveSet(const size_t numProblems,
+                   arma::vec& objectives,
+                   arma::uvec& iterations) :
+      problems(numProblems),
+      objectives(objectives),
+      iterations(iterations)
+  {
+    for (size_t i = 0; i < numProblems; ++i)
+      problems[i] = i;
+
+    objectives.zeros(numProblems);
+    iterations.zeros(numProblems);
+  }
+
+  //! Get the indices of the active problems.
+  const arma::uvec& Problems() const { return problems; }
+
+  //! Return whether no problem is active anymore.
+  bool Empty() const { return problems.n_elem == 0; }
+
+  /**
+   * Write the final point and objective of every active problem that is
+   * marked as done back, and remove it from the set.  The positions of the
+   * problems that are left are returned, to be kept in the state of the
+   * optimizer with KeepRows().
+   *
+   * @param done Whether each active problem is done.
+   * @param coordinates The points of the active problems, one per row.
+   * @param objective The objectives of the active problems.
+   * @param iteration The current iteration.
+   * @param iterate Matrix to write the final points in.
+   * @return The positions of the problems that are still active.
+   */
+  arma::uvec Retire(const std::vector<bool>& done,
+                    const arma::mat& coordinates,
+                    const arma::vec& objective,
+                    const size_t iteration,
+                    arma::mat& iterate)
+  {
+    size_t numKept = 0;
+    for (size_t i = 0; i < problems.n_elem; ++i)
+      numKept += done[i] ? 0 : 1;
+
+    arma::uvec keep(numKept);
+    numKept = 0;
+    for (size_t i = 0; i < problems.n_elem; ++i)
+    {
+      if (!done[i])
+      {
+        keep[numKept++] = i;
+        continue;
+      }
+
+      iterate.row(problems[i]) = coordinates.row(i);
+      objectives[problems[i]] = objective[i];
+      iterations[problems[i]] = iteration;
+    }
+
+    if (numKept < problems.n_elem)
+      KeepRows(problems, keep);
+
+    return keep;
+  }
+
+  //! Retire all the active problems.
+  void RetireAll(const arma::mat& coordinates,
+                 const arma::vec& objective,
+                 const size_t iteration,
+                 arma::mat& iterate)
+  {
+    Retire(std::vector<bool>(problems.n_elem, true), coordinates, objective,
+        iteration, iterate);
+  }
+
+  //! Keep the given rows of a matrix, in order.
+  static void KeepRows(arma::mat& m, const arma::uvec& keep)
+  {
+    arma::mat kept = m.rows(keep);
+    m = std::move(kept);
+  }
+
+  //! Keep the given elements of a vector, in order.
+  template<typename eT>
+  static void KeepRows(arma::Col<eT>& v, const arma::uvec& keep)
+  {
+    arma::Col<eT> kept = v.elem(keep);
+    v = std::move(kept);
+  }
+
+  //! Keep the given rows of every slice of a cube, in order.
+  static void KeepRows(arma::cube& c, const arma::uvec& keep)
+  {
+    arma::cube kept(keep.n_elem, c.n_cols, c.n_slices);
+    for (size_t i = 0; i < c.n_slices; ++i)
+      kept.slice(i) = c.slice(i).rows(keep);
+    c = std::move(kept);
+  }
+
+ private:
+  //! The indices of the active problems.
+  arma::uvec problems;
+
+  //! The final objectives.
+  arma::vec& objectives;
+
+  //! The number of iterations of each problem.
+  arma::uvec& iterations;
+};
+
+} // namespace detail
+} // namespace ens
+
+#endif
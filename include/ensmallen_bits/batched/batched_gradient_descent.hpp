@@ -0,0 +1,123 @@
+/**
+ * @file batched_gradient_descent.hpp
+ * @author Marcus Edel
+ *
+ * Gradient descent on many small independent problems at once.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_HPP
+#define ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_HPP
+
+#include "batched_active_set.hpp"
+
+namespace ens {
+
+/**
+ * BatchedGradientDescent runs gradient descent on many independent problems of
+ * the same form and the same (small) number of parameters, such as a fit for
+ * every pixel of an image, in lockstep.  The problems are stored as the rows
+ * of a single matrix: column j holds parameter j of every problem, so the
+ * updates and the per-problem reductions are loops over contiguous memory
+ * across the problems, which the compiler vectorizes, instead of many tiny
+ * optimizations of one or two parameters each, which are dominated by their
+ * overhead.
+ *
+ * Every problem has its own termination: a problem whose objective changes by
+ * less than the tolerance is written back and removed from the batch, and the
+ * following iterations only evaluate the problems that are left.  The function
+ * must evaluate all the given problems at once; see the documentation on
+ * batched functions included with this distribution or on the ensmallen
+ * website.
+ *
+ * @code
+ * // One row per problem.
+ * arma::mat coordinates(1000000, 2, arma::fill::zeros);
+ * BatchedGradientDescent optimizer(0.01, 100000, 1e-9);
+ * optimizer.Optimize(f, coordinates);
+ * const arma::vec& objectives = optimizer.Objectives();
+ * @endcode
+ */
+class BatchedGradientDescent
+{
+ public:
+  /**
+   * Construct the batched gradient descent optimizer with the given
+   * parameters, which are those of GradientDescent.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate a problem.
+   */
+  BatchedGradientDescent(const double stepSize = 0.01,
+                         const size_t maxIterations = 100000,
+                         const double tolerance = 1e-5);
+
+  /**
+   * Optimize every problem of the given batched function, starting at the
+   * corresponding row of iterate, which will be modified to store the
+   * finishing points.  The sum of the final objectives is returned; the
+   * objective of each problem is available with Objectives().
+   *
+   * @tparam BatchedFunctionType Type of the function to optimize.
+   * @param function Batched function to optimize.
+   * @param iterate Starting points, one row per problem (will be modified).
+   * @return Sum of the objectives of the final points.
+   */
+  template<typename BatchedFunctionType>
+  double Optimize(BatchedFunctionType& function, arma::mat& iterate);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the final objective of each problem of the last call to Optimize().
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the number of iterations of each problem of the last call to
+  //! Optimize().
+  const arma::uvec& Iterations() const { return iterations; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The final objectives of the last call to Optimize().
+  arma::vec objectives;
+
+  //! The number of iterations of each problem of the last call to Optimize().
+  arma::uvec iterations;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "batched_gradient_descent_impl.hpp"
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file batched_gradient_descent_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of gradient descent on many small independent problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_IMPL_HPP
+#define ENSMALLEN_BATCHED_BATCHED_GRADIENT_DESCENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "batched_gradient_descent.hpp"
+
+namespace ens {
+
+inline BatchedGradientDescent::BatchedGradientDescent(
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance) :
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename BatchedFunctionType>
+double BatchedGradientDescent::Optimize(BatchedFunctionType& function,
+                                        arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  detail::BatchedActiveSet active(iterate.n_rows, objectives, iterations);
+
+  // The state of the active problems, one row per problem.
+  arma::mat coordinates = iterate;
+  arma::mat gradient;
+  arma::vec objective;
+  arma::vec lastObjective(iterate.n_rows);
+  lastObjective.fill(std::numeric_limits<double>::max());
+
+  std::vector<bool> done;
+  size_t i = 1;
+  for (; i != maxIterations && !active.Empty(); ++i)
+  {
+    function.EvaluateWithGradient(coordinates, active.Problems(), objective,
+        gradient);
+
+    // A problem is done when its objective is within the tolerance of the
+    // last one, or when it is not finite anymore.
+    done.assign(objective.n_elem, false);
+    bool anyDone = false;
+    for (size_t k = 0; k < objective.n_elem; ++k)
+    {
+      if (!std::isfinite(objective[k]) ||
+          std::abs(lastObjective[k] - objective[k]) < tolerance)
+      {
+        done[k] = true;
+        anyDone = true;
+      }
+    }
+
+    if (anyDone)
+    {
+      const arma::uvec keep = active.Retire(done, coordinates, objective, i,
+          iterate);
+      detail::BatchedActiveSet::KeepRows(coordinates, keep);
+      detail::BatchedActiveSet::KeepRows(gradient, keep);
+      detail::BatchedActiveSet::KeepRows(objective, keep);
+    }
+
+    ENS_INFO << "Batched Gradient Descent: iteration " << i << ", "
+        << active.Problems().n_elem << " problems left." << std::endl;
+
+    lastObjective = objective;
+    coordinates -= stepSize * gradient;
+  }
+
+  // The problems that did not converge in time end where the last step left
+  // them.
+  if (!active.Empty())
+  {
+    ENS_INFO << "Batched Gradient Descent: maximum iterations ("
+        << maxIterations << ") reached with " << active.Problems().n_elem
+        << " problems left; terminating optimization." << std::endl;
+
+    function.EvaluateWithGradient(coordinates, active.Problems(), objective,
+        gradient);
+    active.RetireAll(coordinates, objective, i, iterate);
+  }
+
+  return arma::accu(objectives);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file batched_lbfgs.hpp
+ * @author Marcus Edel
+ *
+ * L-BFGS on many small independent problems at once.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_LBFGS_HPP
+#define ENSMALLEN_BATCHED_BATCHED_LBFGS_HPP
+
+#include "batched_active_set.hpp"
+
+namespace ens {
+
+/**
+ * BatchedL_BFGS runs L-BFGS on many independent problems of the same form and
+ * the same (small) number of parameters in lockstep, as BatchedGradientDescent
+ * does for gradient descent.  The problems are the rows of a single matrix, and
+ * so are the pairs of differences of the iterates and the gradients of every
+ * problem, so the two-loop recursion of all the problems is a sequence of
+ * element-wise operations and row sums over contiguous columns.
+ *
+ * The step of every problem is found with its own backtracking line search for
+ * the Armijo condition; each trial of the line search evaluates the problems
+ * whose step was not accepted yet.  A problem terminates when its gradient norm
+ * or its relative decrease of the objective is small enough, or when its line
+ * search fails; it is then written back and removed from the batch.
+ *
+ * @code
+ * // One row per problem.
+ * arma::mat coordinates(1000000, 2, arma::fill::zeros);
+ * BatchedL_BFGS optimizer;
+ * optimizer.Optimize(f, coordinates);
+ * const arma::vec& objectives = optimizer.Objectives();
+ * @endcode
+ */
+class BatchedL_BFGS
+{
+ public:
+  /**
+   * Construct the batched L-BFGS optimizer with the given parameters, which
+   * are those of L_BFGS.
+   *
+   * @param numBasis Number of memory points to be stored for each problem.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum gradient norm required to continue the
+   *     optimization of a problem.
+   * @param factr Minimum relative function value decrease to continue the
+   *     optimization of a problem.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   */
+  BatchedL_BFGS(const size_t numBasis = 10,
+                const size_t maxIterations = 10000,
+                const double armijoConstant = 1e-4,
+                const double minGradientNorm = 1e-6,
+                const double factr = 1e-15,
+                const size_t maxLineSearchTrials = 50,
+                const double minStep = 1e-20);
+
+  /**
+   * Optimize every problem of the given batched function, starting at the
+   * corresponding row of iterate, which will be modified to store the
+   * finishing points.  The sum of the final objectives is returned; the
+   * objective of each problem is available with Objectives().
+   *
+   * @tparam BatchedFunctionType Type of the function to optimize.
+   * @param function Batched function to optimize.
+   * @param iterate Starting points, one row per problem (will be modified).
+   * @return Sum of the objectives of the final points.
+   */
+  template<typename BatchedFunctionType>
+  double Optimize(BatchedFunctionType& function, arma::mat& iterate);
+
+  //! Get the memory size.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the memory size.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the minimum gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Return the minimum line search step size.
+  double MinStep() const { return minStep; }
+  //! Modify the minimum line search step size.
+  double& MinStep() { return minStep; }
+
+  //! Get the final objective of each problem of the last call to Optimize().
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the number of iterations of each problem of the last call to
+  //! Optimize().
+  const arma::uvec& Iterations() const { return iterations; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! Size of memory for this L-BFGS optimizer.
+  size_t numBasis;
+
+  //! Maximum number of iterations.
+  size_t maxIterations;
+
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+
+  //! Minimum gradient norm required to continue the optimization.
+  double minGradientNorm;
+
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+
+  //! Maximum number of trials for the line search.
+  size_t maxLineSearchTrials;
+
+  //! Minimum step of the line search.
+  double minStep;
+
+  //! The final objectives of the last call to Optimize().
+  arma::vec objectives;
+
+  //! The number of iterations of each problem of the last call to Optimize().
+  arma::uvec iterations;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "batched_lbfgs_impl.hpp"
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * @file batched_lbfgs_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of L-BFGS on many small independent problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BATCHED_BATCHED_LBFGS_IMPL_HPP
+#define ENSMALLEN_BATCHED_BATCHED_LBFGS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "batched_lbfgs.hpp"
+
+namespace ens {
+
+inline BatchedL_BFGS::BatchedL_BFGS(const size_t numBasis,
+                                    const size_t maxIterations,
+                                    const double armijoConstant,
+                                    const double minGradientNorm,
+                                    const double factr,
+                                    const size_t maxLineSearchTrials,
+                                    const double minStep) :
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    minStep(minStep)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename BatchedFunctionType>
+double BatchedL_BFGS::Optimize(BatchedFunctionType& function,
+                               arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  if (numBasis == 0)
+  {
+    throw std::invalid_argument("BatchedL_BFGS::Optimize(): the number of "
+        "memory points must be positive.");
+  }
+
+  detail::BatchedActiveSet active(iterate.n_rows, objectives, iterations);
+  typedef detail::BatchedActiveSet ActiveSet;
+  if (active.Empty())
+    return 0.0;
+
+  // The state of the active problems, one row per problem.
+  arma::mat coordinates = iterate;
+  arma::mat gradient;
+  arma::vec objective;
+  function.EvaluateWithGradient(coordinates, active.Problems(), objective,
+      gradient);
+
+  // The problems that start at a stationary point, or where the objective is
+  // not finite, are done before the first step.
+  arma::vec gradientNorm = arma::sqrt(arma::sum(arma::square(gradient), 1));
+  std::vector<bool> done(objective.n_elem);
+  for (size_t k = 0; k < objective.n_elem; ++k)
+  {
+    done[k] = !std::isfinite(objective[k]) ||
+        gradientNorm[k] < minGradientNorm;
+  }
+
+  arma::uvec keep = active.Retire(done, coordinates, objective, 0, iterate);
+  ActiveSet::KeepRows(coordinates, keep);
+  ActiveSet::KeepRows(gradient, keep);
+  ActiveSet::KeepRows(objective, keep);
+  ActiveSet::KeepRows(gradientNorm, keep);
+
+  // The differences of the iterates and the gradients, with the slice of each
+  // pair; rho is the inverse of the curvature of each pair, or 0 for the pairs
+  // that are skipped because they are not positive.  The initial inverse
+  // Hessian of each problem is gamma times the identity.
+  const size_t n = iterate.n_cols;
+  arma::cube s(coordinates.n_rows, n, numBasis);
+  arma::cube y(coordinates.n_rows, n, numBasis);
+  arma::mat rho(coordinates.n_rows, numBasis, arma::fill::zeros);
+  arma::vec gamma = 1.0 / gradientNorm;
+  size_t pairs = 0;
+
+  arma::mat direction, alpha, trial, trialGradient, newCoordinates,
+      newGradient;
+  arma::vec directional, step, trialObjective, newObjective;
+  std::vector<bool> failed;
+
+  size_t i = 1;
+  for (; (maxIterations == 0 || i <= maxIterations) && !active.Empty(); ++i)
+  {
+    const size_t numActive = coordinates.n_rows;
+
+    // The two-loop recursion, for all the problems at once.
+    direction = gradient;
+    alpha.set_size(numActive, numBasis);
+    const size_t m = std::min(pairs, numBasis);
+    for (size_t j = 0; j < m; ++j)
+    {
+      const size_t pos = (pairs - 1 - j) % numBasis;
+      alpha.col(pos) = rho.col(pos) % arma::sum(s.slice(pos) % direction, 1);
+      direction -= y.slice(pos).each_col() % alpha.col(pos);
+    }
+
+    direction.each_col() %= gamma;
+
+    for (size_t j = m; j > 0; --j)
+    {
+      const size_t pos = (pairs - j) % numBasis;
+      const arma::vec beta = rho.col(pos) % arma::sum(y.slice(pos) %
+          direction, 1);
+      direction += s.slice(pos).each_col() % (alpha.col(pos) - beta);
+    }
+
+    direction *= -1.0;
+
+    // A direction that does not descend (because of rounding) is replaced by
+    // the scaled negative gradient.
+    directional = arma::sum(gradient % direction, 1);
+    for (size_t k = 0; k < numActive; ++k)
+    {
+      if (!(directional[k] < 0.0))
+      {
+        direction.row(k) = -gradient.row(k) / gradientNorm[k];
+        directional[k] = -gradientNorm[k];
+      }
+    }
+
+    // The backtracking line searches of all the problems; every trial
+    // evaluates the problems whose step is not accepted yet.
+    newCoordinates = coordinates;
+    newObjective = objective;
+    newGradient = gradient;
+    failed.assign(numActive, false);
+    step.ones(numActive);
+    arma::uvec pending(numActive);
+    for (size_t k = 0; k < numActive; ++k)
+      pending[k] = k;
+
+    for (size_t t = 0; t < maxLineSearchTrials && pending.n_elem > 0; ++t)
+    {
+      trial = direction.rows(pending);
+      trial.each_col() %= step.elem(pending);
+      trial += coordinates.rows(pending);
+
+      const arma::uvec problems = active.Problems().elem(pending);
+      function.EvaluateWithGradient(trial, problems, trialObjective,
+          trialGradient);
+
+      size_t numPending = 0;
+      for (size_t k = 0; k < pending.n_elem; ++k)
+      {
+        const size_t p = pending[k];
+        if (std::isfinite(trialObjective[k]) && trialObjective[k] <=
+            objective[p] + armijoConstant * step[p] * directional[p])
+        {
+          newCoordinates.row(p) = trial.row(k);
+          newObjective[p] = trialObjective[k];
+          newGradient.row(p) = trialGradient.row(k);
+          continue;
+        }
+
+        step[p] *= 0.5;
+        if (step[p] < minStep)
+          failed[p] = true;
+        else
+          pending[numPending++] = p;
+      }
+
+      pending.resize(numPending);
+    }
+
+    for (size_t k = 0; k < pending.n_elem; ++k)
+      failed[pending[k]] = true;
+
+    // Store the new pairs; a pair with a curvature that is not positive is
+    // skipped (with rho = 0) and keeps the last scaling.
+    const size_t pos = pairs % numBasis;
+    s.slice(pos) = newCoordinates - coordinates;
+    y.slice(pos) = newGradient - gradient;
+    const arma::vec sy = arma::sum(s.slice(pos) % y.slice(pos), 1);
+    const arma::vec yy = arma::sum(arma::square(y.slice(pos)), 1);
+    for (size_t k = 0; k < numActive; ++k)
+    {
+      rho(k, pos) = (sy[k] > 0.0) ? 1.0 / sy[k] : 0.0;
+      if (sy[k] > 0.0)
+        gamma[k] = sy[k] / yy[k];
+    }
+    ++pairs;
+
+    gradientNorm = arma::sqrt(arma::sum(arma::square(newGradient), 1));
+    done.assign(numActive, false);
+    for (size_t k = 0; k < numActive; ++k)
+    {
+      const double denom = std::max(std::max(std::abs(objective[k]),
+          std::abs(newObjective[k])), 1.0);
+      done[k] = failed[k] || gradientNorm[k] < minGradientNorm ||
+          (objective[k] - newObjective[k]) / denom <= factr;
+    }
+
+    coordinates.swap(newCoordinates);
+    objective.swap(newObjective);
+    gradient.swap(newGradient);
+
+    keep = active.Retire(done, coordinates, objective, i, iterate);
+    if (keep.n_elem < numActive)
+    {
+      ActiveSet::KeepRows(coordinates, keep);
+      ActiveSet::KeepRows(gradient, keep);
+      ActiveSet::KeepRows(objective, keep);
+      ActiveSet::KeepRows(gradientNorm, keep);
+      ActiveSet::KeepRows(s, keep);
+      ActiveSet::KeepRows(y, keep);
+      ActiveSet::KeepRows(rho, keep);
+      ActiveSet::KeepRows(gamma, keep);
+    }
+
+    ENS_INFO << "Batched L-BFGS: iteration " << i << ", "
+        << active.Problems().n_elem << " problems left." << std::endl;
+  }
+
+  if (!active.Empty())
+  {
+    ENS_INFO << "Batched L-BFGS: maximum iterations (" << maxIterations
+        << ") reached with " << active.Problems().n_elem << " problems left; "
+        << "terminating optimization." << std::endl;
+    active.RetireAll(coordinates, objective, i - 1, iterate);
+  }
+
+  return arma::accu(objectives);
+}
+
+} // namespace ens
+
+#endif
@@ -55,34 +55,42 @@ class AdaptiveStepsize
   { /* Nothing to do here. */ }
 
   /**
-   * This function is called in each iteration.
+   * This function is called in each iteration, with the objective of the
+   * backtracking batch at the iterate, which the optimizer computes along with
+   * the gradient.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
    * @param function Function to be optimized (minimized).
    * @param stepSize Step size to be used for the given iteration.
    * @param iterate Parameters that minimize the function.
    * @param gradient The gradient matrix.
+   * @param objective The objective of the backtracking batch at the iterate.
    * @param gradientNorm The gradient norm to be used for the given iteration.
    * @param offset The batch offset to be used for the given iteration.
    * @param batchSize Batch size to be used for the given iteration.
    * @param backtrackingBatchSize Backtracking batch size to be used for the
    *        given iteration.
    * @param reset Reset the step size decay parameter.
+   * @return The objective of the backtracking batch at
+   *     iterate - stepSize * gradient, where the optimizer moves to.
    */
   template<typename DecomposableFunctionType>
-  void Update(DecomposableFunctionType& function,
-              double& stepSize,
-              arma::mat& iterate,
-              const arma::mat& gradient,
-              const double gradientNorm,
-              const double sampleVariance,
-              const size_t offset,
-              const size_t batchSize,
-              const size_t backtrackingBatchSize,
-              const bool /* reset */)
+  double Update(DecomposableFunctionType& function,
+                double& stepSize,
+                arma::mat& iterate,
+                const arma::mat& gradient,
+                const double objective,
+                const double gradientNorm,
+                const double sampleVariance,
+                const size_t offset,
+                const size_t batchSize,
+                const size_t backtrackingBatchSize,
+                const bool /* reset */)
   {
-    Backtracking(function, stepSize, iterate, gradient, gradientNorm, offset,
-        backtrackingBatchSize);
+    // The last trial point of the search is the new iterate, so its objective
+    // is the starting objective of the second search.
+    const double objectiveUpdate = Backtracking(function, stepSize, iterate,
+        gradient, objective, gradientNorm, offset, backtrackingBatchSize);
 
     // Update the iterate.
     iterate -= stepSize * gradient;
@@ -107,8 +115,8 @@ class AdaptiveStepsize
     stepSize *= (1 - ((double) batchSize / function.NumFunctions()));
     stepSize += stepSizeDecay * ((double) batchSize / function.NumFunctions());
 
-    Backtracking(function, stepSize, iterate, gradient, gradientNorm, offset,
-        backtrackingBatchSize);
+    return Backtracking(function, stepSize, iterate, gradient,
+        objectiveUpdate, gradientNorm, offset, backtrackingBatchSize);
   }
 
   //! Get the backtracking step size.
@@ -132,35 +140,38 @@ class AdaptiveStepsize
    * @param stepSize Step size to be used for the given iteration.
    * @param iterate Parameters that minimize the function.
    * @param gradient The gradient matrix.
+   * @param objective The objective of the backtracking batch at the iterate.
    * @param gradientNorm The gradient norm to be used for the given iteration.
    * @param offset The batch offset to be used for the given iteration.
    * @param backtrackingBatchSize The backtracking batch size.
+   * @return The objective at iterate - stepSize * gradient.
    */
   template<typename DecomposableFunctionType>
-  void Backtracking(DecomposableFunctionType& function,
-                    double& stepSize,
-                    const arma::mat& iterate,
-                    const arma::mat& gradient,
-                    const double gradientNorm,
-                    const size_t offset,
-                    const size_t backtrackingBatchSize)
+  double Backtracking(DecomposableFunctionType& function,
+                      double& stepSize,
+                      const arma::mat& iterate,
+                      const arma::mat& gradient,
+                      const double objective,
+                      const double gradientNorm,
+                      const size_t offset,
+                      const size_t backtrackingBatchSize)
   {
-    double overallObjective = function.Evaluate(iterate, offset,
-        backtrackingBatchSize);
-
-    arma::mat iterateUpdate = iterate - (stepSize * gradient);
-    double overallObjectiveUpdate = function.Evaluate(iterateUpdate, offset,
+    // Every trial point is computed into the same buffer.
+    iterateUpdate = iterate - (stepSize * gradient);
+    double objectiveUpdate = function.Evaluate(iterateUpdate, offset,
         backtrackingBatchSize);
 
-    while (overallObjectiveUpdate >
-        (overallObjective + searchParameter * stepSize * gradientNorm))
+    while (objectiveUpdate >
+        (objective + searchParameter * stepSize * gradientNorm))
     {
       stepSize *= backtrackStepSize;
 
       iterateUpdate = iterate - (stepSize * gradient);
-      overallObjectiveUpdate = function.Evaluate(iterateUpdate, offset,
+      objectiveUpdate = function.Evaluate(iterateUpdate, offset,
           backtrackingBatchSize);
     }
+
+    return objectiveUpdate;
   }
 
   //! The backtracking step size for each iteration.
@@ -168,6 +179,9 @@ class AdaptiveStepsize
 
   //! The search parameter for each iteration.
   double searchParameter;
+
+  //! The trial point of the backtracking search.
+  arma::mat iterateUpdate;
 };
 
 } // namespace ens
@@ -52,56 +52,65 @@ class BacktrackingLineSearch
   { /* Nothing to do here. */ }
 
   /**
-   * This function is called in each iteration.
+   * This function is called in each iteration, with the objective of the
+   * backtracking batch at the iterate, which the optimizer computes along with
+   * the gradient.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
    * @param function Function to be optimized (minimized).
    * @param stepSize Step size to be used for the given iteration.
    * @param iterate Parameters that minimize the function.
    * @param gradient The gradient matrix.
+   * @param objective The objective of the backtracking batch at the iterate.
    * @param gradientNorm The gradient norm to be used for the given iteration.
    * @param offset The batch offset to be used for the given iteration.
    * @param batchSize Batch size to be used for the given iteration.
    * @param backtrackingBatchSize Backtracking batch size to be used for the
    *        given iteration.
    * @param reset Reset the step size decay parameter.
+   * @return The objective of the backtracking batch at
+   *     iterate - stepSize * gradient, where the optimizer moves to.
    */
   template<typename DecomposableFunctionType>
-  void Update(DecomposableFunctionType& function,
-              double& stepSize,
-              arma::mat& iterate,
-              const arma::mat& gradient,
-              const double gradientNorm,
-              const double /* sampleVariance */,
-              const size_t offset,
-              const size_t /* batchSize */,
-              const size_t backtrackingBatchSize,
-              const bool reset)
+  double Update(DecomposableFunctionType& function,
+                double& stepSize,
+                arma::mat& iterate,
+                const arma::mat& gradient,
+                const double objective,
+                const double gradientNorm,
+                const double /* sampleVariance */,
+                const size_t offset,
+                const size_t /* batchSize */,
+                const size_t backtrackingBatchSize,
+                const bool reset)
   {
     if (reset)
       stepSize *= 2;
 
-    double overallObjective = function.Evaluate(iterate, offset,
-        backtrackingBatchSize);
-
-    arma::mat iterateUpdate = iterate - (stepSize * gradient);
-    double overallObjectiveUpdate = function.Evaluate(iterateUpdate,
+    // Every trial point is computed into the same buffer.
+    iterateUpdate = iterate - (stepSize * gradient);
+    double objectiveUpdate = function.Evaluate(iterateUpdate,
         offset, backtrackingBatchSize);
 
-    while (overallObjectiveUpdate >
-        (overallObjective + searchParameter * stepSize * gradientNorm))
+    while (objectiveUpdate >
+        (objective + searchParameter * stepSize * gradientNorm))
     {
       stepSize /= 2;
 
       iterateUpdate = iterate - (stepSize * gradient);
-      overallObjectiveUpdate = function.Evaluate(iterateUpdate,
+      objectiveUpdate = function.Evaluate(iterateUpdate,
         offset, backtrackingBatchSize);
     }
+
+    return objectiveUpdate;
   }
 
  private:
   //! The search parameter for each iteration.
   double searchParameter;
+
+  //! The trial point of the line search.
+  arma::mat iterateUpdate;
 };
 
 } // namespace ens
@@ -103,6 +103,12 @@ class BigBatchSGD
    * will be modified to store the finishing point of the algorithm, and the
    * final objective value is returned.
    *
+   * The sample variance of the batch gradient is needed to adapt the batch
+   * size.  If the function has a GradientVariance() method (see
+   * traits::HasBatchGradientVariance), the gradient and the variance of each
+   * batch are computed with a single call to it; otherwise the gradient of
+   * each point of the batch is computed separately.
+   *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
@@ -147,6 +153,9 @@ class BigBatchSGD
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The size of the current batch.
   size_t batchSize;
@@ -169,6 +178,9 @@ class BigBatchSGD
 
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 using BBS_Armijo = BigBatchSGD<BacktrackingLineSearch>;
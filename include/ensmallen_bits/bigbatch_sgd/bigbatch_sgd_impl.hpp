@@ -42,14 +42,24 @@ template<typename DecomposableFunctionType>
 double BigBatchSGD<UpdatePolicyType>::Optimize(
     DecomposableFunctionType& function, arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   typedef Function<DecomposableFunctionType> FullFunctionType;
-  FullFunctionType& f(static_cast<FullFunctionType&>(function));
 
   // Make sure we have all the methods that we need.
   traits::CheckDecomposableFunctionTypeAPI<FullFunctionType>();
 
+  // If the function can be evaluated on any set of indices, we hold the order
+  // of visitation ourselves and the function never has to be shuffled.
+  typedef VisitationOrder<DecomposableFunctionType> VisitationOrderType;
+  typedef Function<typename VisitationOrderType::VisitedType>
+      VisitedFunctionType;
+  VisitationOrderType order(function);
+  VisitedFunctionType& visited(
+      static_cast<VisitedFunctionType&>(order.Get()));
+
   // Find the number of functions to use.
-  const size_t numFunctions = f.NumFunctions();
+  const size_t numFunctions = visited.NumFunctions();
 
   // To keep track of where we are and how things are going.
   size_t currentFunction = 0;
@@ -69,12 +79,12 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
     if ((currentFunction % numFunctions) == 0 && i > 0)
     {
       // Output current objective function.
-      Info << "Big-batch SGD: iteration " << i << ", objective "
+      ENS_INFO << "Big-batch SGD: iteration " << i << ", objective "
           << overallObjective << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
-        Warn << "Big-batch SGD: converged to " << overallObjective
+        ENS_WARN << "Big-batch SGD: converged to " << overallObjective
             << "; terminating with failure.  Try a smaller step size?"
             << std::endl;
         return overallObjective;
@@ -82,7 +92,7 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
 
       if (std::abs(lastObjective - overallObjective) < tolerance)
       {
-        Info << "Big-batch SGD: minimized within tolerance " << tolerance
+        ENS_INFO << "Big-batch SGD: minimized within tolerance " << tolerance
             << "; terminating optimization." << std::endl;
         return overallObjective;
       }
@@ -93,7 +103,7 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
       currentFunction = 0;
 
       if (shuffle) // Determine order of visitation.
-        f.Shuffle();
+        visited.Shuffle();
     }
 
     // Find the effective batch size; we have to take the minimum of three
@@ -109,21 +119,41 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
     size_t k = 1;
     double vB = 0;
 
-    // Compute the stochastic gradient estimation.
-    f.Gradient(iterate, currentFunction, gradient, 1);
+    // The objective of the batch at the iterate, which the step size policy
+    // needs, and the number of functions it covers so far.
+    double objective = 0;
+    size_t covered = 0;
 
-    delta1 = gradient;
-    for (size_t j = 1; j < effectiveBatchSize; ++j, ++k)
+    // Compute the stochastic gradient estimation and the sample variance with
+    // a single batched call, if the function allows it.
+    const bool batchedVariance = TryGradientVariance(order.Get(), iterate,
+        currentFunction, gradient, effectiveBatchSize, vB);
+    if (batchedVariance)
+    {
+      k = effectiveBatchSize;
+    }
+    else
     {
-      f.Gradient(iterate, currentFunction + j, functionGradient, 1);
-      delta0 = delta1 + (functionGradient - delta1) / k;
+      // Compute the stochastic gradient estimation, and the objective along
+      // with it.
+      objective += visited.EvaluateWithGradient(iterate, currentFunction,
+          gradient, 1);
 
-      // Compute sample variance.
-      vB += arma::norm(functionGradient - delta1, 2.0) *
-          arma::norm(functionGradient - delta0, 2.0);
+      delta1 = gradient;
+      for (size_t j = 1; j < effectiveBatchSize; ++j, ++k)
+      {
+        objective += visited.EvaluateWithGradient(iterate, currentFunction + j,
+            functionGradient, 1);
+        delta0 = delta1 + (functionGradient - delta1) / k;
+
+        // Compute sample variance.
+        vB += arma::norm(functionGradient - delta1, 2.0) *
+            arma::norm(functionGradient - delta0, 2.0);
 
-      delta1 = delta0;
-      gradient += functionGradient;
+        delta1 = delta0;
+        gradient += functionGradient;
+      }
+      covered = effectiveBatchSize;
     }
     double gB = std::pow(arma::norm(gradient / effectiveBatchSize, 2), 2.0);
 
@@ -147,17 +177,33 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
         // Update the stochastic gradient estimation.
         const size_t batchStart = (currentFunction + batchSize + batchOffset
             - 1) < numFunctions ? currentFunction + batchSize - 1 : 0;
-        for (size_t j = 0; j < batchOffset; ++j, ++k)
+        if (batchedVariance)
         {
-          f.Gradient(iterate, batchStart + j, functionGradient, 1);
-          delta0 = delta1 + (functionGradient - delta1) / (k + 1);
+          // Combine the spread of the new samples with the current one.
+          double offsetVariance = 0;
+          TryGradientVariance(order.Get(), iterate, batchStart,
+              functionGradient, batchOffset, offsetVariance);
+          vB += offsetVariance + std::pow(arma::norm(gradient / (double) k -
+              functionGradient / (double) batchOffset, 2), 2.0) * k *
+              batchOffset / (double) (k + batchOffset);
 
-          // Compute sample variance.
-          vB += arma::norm(functionGradient - delta1, 2.0) *
-              arma::norm(functionGradient - delta0, 2.0);
-
-          delta1 = delta0;
           gradient += functionGradient;
+          k += batchOffset;
+        }
+        else
+        {
+          for (size_t j = 0; j < batchOffset; ++j, ++k)
+          {
+            visited.Gradient(iterate, batchStart + j, functionGradient, 1);
+            delta0 = delta1 + (functionGradient - delta1) / (k + 1);
+
+            // Compute sample variance.
+            vB += arma::norm(functionGradient - delta1, 2.0) *
+                arma::norm(functionGradient - delta0, 2.0);
+
+            delta1 = delta0;
+            gradient += functionGradient;
+          }
         }
         gB = std::pow(arma::norm(gradient / (batchSize + batchOffset), 2), 2.0);
 
@@ -170,20 +216,28 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
       }
     }
 
-    updatePolicy.Update(f, stepSize, iterate, gradient, gB, vB,
-        currentFunction, batchSize, effectiveBatchSize, reset);
+    // Evaluate the rest of the batch: all of it if the gradient was batched,
+    // or else the functions it grew by.
+    if (covered < effectiveBatchSize)
+    {
+      objective += visited.Evaluate(iterate, currentFunction + covered,
+          effectiveBatchSize - covered);
+    }
+
+    // The policy returns the objective of the batch at the new iterate, which
+    // its line search has already evaluated.
+    overallObjective += updatePolicy.Update(visited, stepSize, iterate,
+        gradient, objective, gB, vB, currentFunction, batchSize,
+        effectiveBatchSize, reset);
 
     // Update the iterate.
     iterate -= stepSize * gradient;
 
-    overallObjective += f.Evaluate(iterate, currentFunction,
-        effectiveBatchSize);
-
     i += effectiveBatchSize;
     currentFunction += effectiveBatchSize;
   }
 
-  Info << "Big-batch SGD: maximum iterations (" << maxIterations << ") "
+  ENS_INFO << "Big-batch SGD: maximum iterations (" << maxIterations << ") "
       << "reached; terminating optimization." << std::endl;
 
   // Calculate final objective.
@@ -191,7 +245,7 @@ double BigBatchSGD<UpdatePolicyType>::Optimize(
   for (size_t i = 0; i < numFunctions; i += batchSize)
   {
     const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    overallObjective += visited.Evaluate(iterate, i, effectiveBatchSize);
   }
   return overallObjective;
 }
@@ -0,0 +1,154 @@
+/**
+ * @file block_separable.hpp
+ * @author Marcus Edel
+ *
+ * Optimize a function whose parameters split into independent blocks with a
+ * separate optimization for each block.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BLOCK_SEPARABLE_BLOCK_SEPARABLE_HPP
+#define ENSMALLEN_BLOCK_SEPARABLE_BLOCK_SEPARABLE_HPP
+
+#include <atomic>
+#include <vector>
+
+namespace ens {
+
+/**
+ * BlockSeparable optimizes a function that is a sum of functions of disjoint
+ * blocks of parameters,
+ *
+ * \f[
+ * f(A_1, \ldots, A_k) = \sum_{j = 1}^{k} f_j(A_j),
+ * \f]
+ *
+ * such as per-user models or one-vs-rest classifiers, by running a copy of the
+ * given optimizer on each block.  Unlike one optimization over the
+ * concatenated parameters, the line searches and the termination criteria of
+ * each block are independent: a block that converges quickly stops, and does
+ * not have to follow the iterations of the slower ones.  The blocks are
+ * optimized in parallel if OpenMP is enabled; a thread takes the next block as
+ * soon as it is done with one, so blocks of different costs are balanced.
+ *
+ * The blocks are given as a vector of functions, one for each block, and a
+ * vector of starting points, or a single matrix whose rows are the blocks (as in
+ * the parameters of SoftmaxRegressionFunction, which has a row for each
+ * class).  Each function must be a valid function for the optimizer.
+ *
+ * @code
+ * // The functions keep references to the responses.
+ * std::vector<arma::Row<size_t>> responses(numClasses);
+ * std::vector<LogisticRegression<>> classifiers;
+ * for (size_t c = 0; c < numClasses; ++c)
+ * {
+ *   responses[c] = arma::conv_to<arma::Row<size_t>>::from(labels == c);
+ *   classifiers.push_back(LogisticRegression<>(data, responses[c], 0.1));
+ * }
+ *
+ * arma::mat coordinates(numClasses, data.n_rows + 1, arma::fill::zeros);
+ * BlockSeparable<L_BFGS> optimizer;
+ * optimizer.Optimize(classifiers, coordinates);
+ * @endcode
+ *
+ * @tparam OptimizerType Type of the optimizer of each block.
+ */
+template<typename OptimizerType>
+class BlockSeparable
+{
+ public:
+  /**
+   * Construct the BlockSeparable optimizer with the given optimizer, which is
+   * copied for each block.
+   *
+   * @param optimizer Optimizer to use on each block.
+   * @param parallel Whether to optimize the blocks with several OpenMP
+   *     threads.
+   */
+  BlockSeparable(const OptimizerType& optimizer = OptimizerType(),
+                 const bool parallel = true);
+
+  /**
+   * Optimize each of the given functions, starting from the corresponding
+   * iterate, which will be modified to store the finishing point of its
+   * optimization.  The sum of the final objectives is returned; the objective
+   * of each block is available with Objectives() and the optimizer of each
+   * block with Optimizers().
+   *
+   * The callbacks are given to the optimization of every block.  If the blocks
+   * are optimized in parallel, they may be called from several threads at
+   * once.
+   *
+   * @tparam FunctionType Type of the functions of the blocks.
+   * @tparam MatType Type of the iterates.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param functions Functions of the blocks.
+   * @param iterates Starting points of the blocks (will be modified).
+   * @param callbacks Callback functions.
+   * @return Sum of the objectives of the final points.
+   */
+  template<typename FunctionType, typename MatType, typename... CallbackTypes>
+  double Optimize(std::vector<FunctionType>& functions,
+                  std::vector<MatType>& iterates,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Optimize each of the given functions, where the parameters of block j are
+   * row j of iterate; see above.
+   *
+   * @tparam FunctionType Type of the functions of the blocks.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param functions Functions of the blocks.
+   * @param iterate Starting point, one row per block (will be modified).
+   * @param callbacks Callback functions.
+   * @return Sum of the objectives of the final points.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(std::vector<FunctionType>& functions,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the optimizer that is copied for each block.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer that is copied for each block.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get whether the blocks are optimized in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the blocks are optimized in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the optimizers of the blocks of the last call to Optimize().
+  const std::vector<OptimizerType>& Optimizers() const { return optimizers; }
+
+  //! Get the final objectives of the blocks of the last call to Optimize().
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The optimizer that is copied for each block.
+  OptimizerType optimizer;
+
+  //! Whether the blocks are optimized in parallel.
+  bool parallel;
+
+  //! The optimizers of the blocks of the last call to Optimize().
+  std::vector<OptimizerType> optimizers;
+
+  //! The final objectives of the blocks of the last call to Optimize().
+  arma::vec objectives;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "block_separable_impl.hpp"
+
+#endif
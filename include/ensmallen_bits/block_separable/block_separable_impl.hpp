@@ -0,0 +1,110 @@
+/**
+ * @file block_separable_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the BlockSeparable optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_BLOCK_SEPARABLE_BLOCK_SEPARABLE_IMPL_HPP
+#define ENSMALLEN_BLOCK_SEPARABLE_BLOCK_SEPARABLE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "block_separable.hpp"
+
+namespace ens {
+
+template<typename OptimizerType>
+BlockSeparable<OptimizerType>::BlockSeparable(const OptimizerType& optimizer,
+                                              const bool parallel) :
+    optimizer(optimizer),
+    parallel(parallel)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType, typename... CallbackTypes>
+double BlockSeparable<OptimizerType>::Optimize(
+    std::vector<FunctionType>& functions,
+    std::vector<MatType>& iterates,
+    CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  if (functions.size() != iterates.size())
+  {
+    throw std::invalid_argument("BlockSeparable::Optimize(): the number of "
+        "functions must match the number of iterates.");
+  }
+
+  const size_t numBlocks = functions.size();
+  optimizers.assign(numBlocks, optimizer);
+  objectives.zeros(numBlocks);
+
+  #ifdef ENS_USE_OPENMP
+    const size_t numThreads = parallel ? std::min(
+        (size_t) omp_get_max_threads(), numBlocks) : 1;
+  #else
+    const size_t numThreads = 1;
+  #endif
+
+  if (numThreads <= 1)
+  {
+    for (size_t j = 0; j < numBlocks; ++j)
+    {
+      objectives[j] = optimizers[j].Optimize(functions[j], iterates[j],
+          callbacks...);
+    }
+  }
+  else
+  {
+    // Every thread takes the next block that has not been started, so that a
+    // thread done with a cheap block moves on.
+    std::atomic<size_t> nextBlock(0);
+
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      for (size_t j = nextBlock++; j < numBlocks; j = nextBlock++)
+      {
+        objectives[j] = optimizers[j].Optimize(functions[j], iterates[j],
+            callbacks...);
+      }
+    }
+  }
+
+  ENS_INFO << "BlockSeparable: optimized " << numBlocks << " blocks; objective "
+      << arma::accu(objectives) << "." << std::endl;
+
+  return arma::accu(objectives);
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename... CallbackTypes>
+double BlockSeparable<OptimizerType>::Optimize(
+    std::vector<FunctionType>& functions,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  if (functions.size() != iterate.n_rows)
+  {
+    throw std::invalid_argument("BlockSeparable::Optimize(): the number of "
+        "functions must match the number of rows of the iterate.");
+  }
+
+  std::vector<arma::mat> iterates(iterate.n_rows);
+  for (size_t j = 0; j < iterate.n_rows; ++j)
+    iterates[j] = iterate.row(j);
+
+  const double objective = Optimize(functions, iterates, callbacks...);
+
+  for (size_t j = 0; j < iterate.n_rows; ++j)
+    iterate.row(j) = iterates[j];
+
+  return objective;
+}
+
+} // namespace ens
+
+#endif
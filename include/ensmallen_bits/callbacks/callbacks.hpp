@@ -0,0 +1,233 @@
+/**
+ * @file callbacks.hpp
+ * @author Ryan Curtin
+ *
+ * Dispatch of optimizer events to user-supplied callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_CALLBACKS_HPP
+#define ENSMALLEN_CALLBACKS_CALLBACKS_HPP
+
+#include <initializer_list>
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * The Callback class forwards the events of an optimizer to any number of
+ * callbacks.  Optimizers that support callbacks accept them as trailing
+ * arguments to Optimize(), e.g.
+ *
+ * @code
+ * optimizer.Optimize(function, coordinates, PrintLoss(), EarlyStopAtMinLoss());
+ * @endcode
+ *
+ * A callback is any class that implements some of the methods below; methods
+ * that are not implemented are simply not called, so that an Optimize() call
+ * without callbacks has no overhead.  Each method may return void or bool; if
+ * any callback returns true, the optimizer terminates (EndOptimization() is
+ * still called).  The methods may be templates, and each optimizer documents
+ * which events it reports.
+ *
+ * @code
+ * template<typename OptimizerType, typename FunctionType, typename MatType>
+ * void BeginOptimization(OptimizerType& optimizer, FunctionType& function,
+ *                        MatType& coordinates);
+ * void EndOptimization(OptimizerType& optimizer, FunctionType& function,
+ *                      MatType& coordinates);
+ * bool Evaluate(OptimizerType& optimizer, FunctionType& function,
+ *               const MatType& coordinates, const double objective);
+ * bool Gradient(OptimizerType& optimizer, FunctionType& function,
+ *               const MatType& coordinates, const GradType& gradient);
+ * bool BeginEpoch(OptimizerType& optimizer, FunctionType& function,
+ *                 const MatType& coordinates, const size_t epoch,
+ *                 const double objective);
+ * bool EndEpoch(OptimizerType& optimizer, FunctionType& function,
+ *               const MatType& coordinates, const size_t epoch,
+ *               const double objective);
+ * bool StepTaken(OptimizerType& optimizer, FunctionType& function,
+ *                const MatType& coordinates);
+ * @endcode
+ */
+class Callback
+{
+ public:
+  /**
+   * Called once at the start of the optimization.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginOptimization(OptimizerType& optimizer,
+                                FunctionType& function,
+                                MatType& coordinates,
+                                CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::BeginOptimizationInvoker<
+            CallbackTypes, OptimizerType, FunctionType, MatType>::Invoke(
+            callbacks, optimizer, function, coordinates) || terminate)... };
+    return terminate;
+  }
+
+  /**
+   * Called once at the end of the optimization, however it terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void EndOptimization(OptimizerType& optimizer,
+                              FunctionType& function,
+                              MatType& coordinates,
+                              CallbackTypes&... callbacks)
+  {
+    (void) std::initializer_list<bool>{ false,
+        ens::callbacks::traits::EndOptimizationInvoker<CallbackTypes,
+            OptimizerType, FunctionType, MatType>::Invoke(callbacks,
+            optimizer, function, coordinates)... };
+  }
+
+  /**
+   * Called after the objective has been evaluated.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool Evaluate(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const double objective,
+                       CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::EvaluateInvoker<CallbackTypes,
+            OptimizerType, FunctionType, const MatType, const double>::Invoke(
+            callbacks, optimizer, function, coordinates, objective) ||
+            terminate)... };
+    return terminate;
+  }
+
+  /**
+   * Called after the gradient has been computed.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool Gradient(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const GradType& gradient,
+                       CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::GradientInvoker<CallbackTypes,
+            OptimizerType, FunctionType, const MatType, const GradType>::Invoke(
+            callbacks, optimizer, function, coordinates, gradient) ||
+            terminate)... };
+    return terminate;
+  }
+
+  /**
+   * Called at the start of an epoch (one pass over the data, or one iteration
+   * for optimizers that do not work on separable functions).
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginEpoch(OptimizerType& optimizer,
+                         FunctionType& function,
+                         const MatType& coordinates,
+                         const size_t epoch,
+                         const double objective,
+                         CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::BeginEpochInvoker<CallbackTypes,
+            OptimizerType, FunctionType, const MatType, const size_t,
+            const double>::Invoke(callbacks, optimizer, function, coordinates,
+            epoch, objective) || terminate)... };
+    return terminate;
+  }
+
+  /**
+   * Called at the end of an epoch.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndEpoch(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const size_t epoch,
+                       const double objective,
+                       CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::EndEpochInvoker<CallbackTypes,
+            OptimizerType, FunctionType, const MatType, const size_t,
+            const double>::Invoke(callbacks, optimizer, function, coordinates,
+            epoch, objective) || terminate)... };
+    return terminate;
+  }
+
+  /**
+   * Called after each step (update of the coordinates) of the optimizer.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool StepTaken(OptimizerType& optimizer,
+                        FunctionType& function,
+                        const MatType& coordinates,
+                        CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    (void) std::initializer_list<bool>{ terminate,
+        (terminate = ens::callbacks::traits::StepTakenInvoker<CallbackTypes,
+            OptimizerType, FunctionType, const MatType>::Invoke(callbacks,
+            optimizer, function, coordinates) || terminate)... };
+    return terminate;
+  }
+};
+
+} // namespace ens
+
+#include "checkpoint.hpp"
+#include "early_stop_at_min_loss.hpp"
+#include "early_stop_at_min_validation_loss.hpp"
+#include "print_loss.hpp"
+#include "time_budget.hpp"
+#include "trace_recorder.hpp"
+#include "metrics_exporter.hpp"
+
+#endif
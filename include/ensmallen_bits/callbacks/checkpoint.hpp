@@ -0,0 +1,227 @@
+/**
+ * @file checkpoint.hpp
+ * @author Marcus Edel
+ *
+ * Callback that periodically writes the state of the optimization to a file,
+ * so that it can be resumed after an interruption.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_CHECKPOINT_HPP
+#define ENSMALLEN_CALLBACKS_CHECKPOINT_HPP
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+
+namespace ens {
+
+/**
+ * Write a checkpoint of the optimization every given number of epochs: the
+ * coordinates, the index of the epoch, and the state of the optimizer if it
+ * has a SaveState() method (e.g. the moment estimates of Adam for SGD-based
+ * optimizers).  The state is copied at the end of the epoch, and written to the
+ * file on a background thread while the optimization goes on; the file is
+ * first written under a temporary name and then renamed, so an interruption
+ * never leaves a partial checkpoint behind.
+ *
+ * To resume, call Resume() with the optimizer and the coordinates before
+ * calling Optimize() again:
+ *
+ * @code
+ * Adam optimizer;
+ * arma::mat coordinates = f.GetInitialPoint();
+ * Checkpoint::Resume("adam.ckpt", optimizer, coordinates);
+ * optimizer.Optimize(f, coordinates, Checkpoint("adam.ckpt"));
+ * @endcode
+ */
+class Checkpoint
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param filename Name of the file to write the checkpoints to.
+   * @param period Number of epochs between two checkpoints.
+   */
+  Checkpoint(const std::string& filename, const size_t period = 1) :
+      filename(filename),
+      period(period),
+      writeFailed(false)
+  { /* Nothing to do. */ }
+
+  //! Wait for the last checkpoint to be written.
+  ~Checkpoint() { Wait(); }
+
+  /**
+   * Write a checkpoint at the end of every period'th epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t epoch,
+                const double objective)
+  {
+    if (period == 0 || epoch % period != 0)
+      return;
+
+    // Only one checkpoint is written at a time, so the buffer is free once the
+    // last one is done.
+    Wait();
+
+    buffer.Clear();
+    SaveOptimizerState(optimizer, coordinates, buffer, 0);
+    buffer.Set("coordinates", coordinates);
+    buffer.Set("epoch", epoch);
+    buffer.Set("objective", objective);
+
+    writer = std::thread(&Checkpoint::Write, this);
+  }
+
+  /**
+   * Wait for the last checkpoint to be written at the end of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    Wait();
+  }
+
+  /**
+   * Restore the coordinates and the state of the optimizer from the given
+   * checkpoint: the optimizer resumes from the stored state in its next call
+   * to Optimize().  If there is no readable checkpoint (e.g. on the first
+   * run), nothing is changed.
+   *
+   * @param filename Name of the checkpoint file.
+   * @param optimizer Optimizer to restore the state of.
+   * @param coordinates Matrix to restore the coordinates into.
+   * @return true if a checkpoint was restored.
+   */
+  template<typename OptimizerType, typename MatType>
+  static bool Resume(const std::string& filename,
+                     OptimizerType& optimizer,
+                     MatType& coordinates)
+  {
+    OptimizerState state;
+    if (!state.Load(filename))
+      return false;
+
+    state.Get("coordinates", coordinates);
+    LoadOptimizerState(optimizer, state, 0);
+    return true;
+  }
+
+  //! Get the name of the checkpoint file.
+  const std::string& Filename() const { return filename; }
+  //! Modify the name of the checkpoint file.
+  std::string& Filename() { return filename; }
+
+  //! Get the number of epochs between two checkpoints.
+  size_t Period() const { return period; }
+  //! Modify the number of epochs between two checkpoints.
+  size_t& Period() { return period; }
+
+ private:
+  //! Store the state of an optimizer that has a SaveState() method.
+  template<typename OptimizerType, typename MatType>
+  static auto SaveOptimizerState(const OptimizerType& optimizer,
+                                 const MatType& /* coordinates */,
+                                 OptimizerState& state,
+                                 int)
+      -> decltype(optimizer.template SaveState<MatType>(state))
+  {
+    optimizer.template SaveState<MatType>(state);
+  }
+
+  //! Other optimizers only get their coordinates stored.
+  template<typename OptimizerType, typename MatType>
+  static void SaveOptimizerState(const OptimizerType& /* optimizer */,
+                                 const MatType& /* coordinates */,
+                                 OptimizerState& /* state */,
+                                 long)
+  { }
+
+  //! Restore the state of an optimizer that has a LoadState() method.
+  template<typename OptimizerType>
+  static auto LoadOptimizerState(OptimizerType& optimizer,
+                                 const OptimizerState& state,
+                                 int)
+      -> decltype(optimizer.LoadState(state))
+  {
+    optimizer.LoadState(state);
+  }
+
+  //! Other optimizers only get their coordinates restored.
+  template<typename OptimizerType>
+  static void LoadOptimizerState(OptimizerType& /* optimizer */,
+                                 const OptimizerState& /* state */,
+                                 long)
+  { }
+
+  //! Write the buffer to the file; this runs on the writer thread.
+  void Write()
+  {
+    const std::string temporary = filename + ".tmp";
+    writeFailed = !buffer.Save(temporary);
+    if (writeFailed)
+      return;
+
+    #ifdef _WIN32
+      // rename() does not replace existing files on Windows.
+      std::remove(filename.c_str());
+    #endif
+    writeFailed = (std::rename(temporary.c_str(), filename.c_str()) != 0);
+  }
+
+  //! Wait for the writer thread, if it is running.
+  void Wait()
+  {
+    if (!writer.joinable())
+      return;
+
+    writer.join();
+    if (writeFailed)
+    {
+      ENS_WARN << "Checkpoint: could not write '" << filename << "'."
+          << std::endl;
+    }
+  }
+
+  //! The name of the checkpoint file.
+  std::string filename;
+
+  //! The number of epochs between two checkpoints.
+  size_t period;
+
+  //! The copy of the state that is being written.
+  OptimizerState buffer;
+
+  //! The thread writing the last checkpoint.
+  std::thread writer;
+
+  //! Whether writing the last checkpoint failed.
+  bool writeFailed;
+};
+
+} // namespace ens
+
+#endif
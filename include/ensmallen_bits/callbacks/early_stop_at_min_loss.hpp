@@ -0,0 +1,105 @@
+/**
+ * @file early_stop_at_min_loss.hpp
+ * @author Ryan Curtin
+ *
+ * Callback that stops the optimization when the objective stops improving.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_LOSS_HPP
+#define ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_LOSS_HPP
+
+namespace ens {
+
+/**
+ * Terminate the optimization when the objective at the end of an epoch has
+ * not improved on the best objective seen so far for a given number of epochs.
+ */
+class EarlyStopAtMinLoss
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param patience The number of epochs to wait for an improvement of the
+   *     objective before terminating.
+   */
+  EarlyStopAtMinLoss(const size_t patience = 10) :
+      patience(patience),
+      bestObjective(std::numeric_limits<double>::max()),
+      steps(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Reset the state at the start of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    bestObjective = std::numeric_limits<double>::max();
+    steps = 0;
+  }
+
+  /**
+   * Check the objective at the end of an epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    if (objective < bestObjective)
+    {
+      steps = 0;
+      bestObjective = objective;
+      return false;
+    }
+
+    if (++steps < patience)
+      return false;
+
+    ENS_INFO << "EarlyStopAtMinLoss: no improvement of the objective for "
+        << patience << " epochs; terminating optimization." << std::endl;
+    return true;
+  }
+
+  //! Get the number of epochs to wait for an improvement.
+  size_t Patience() const { return patience; }
+  //! Modify the number of epochs to wait for an improvement.
+  size_t& Patience() { return patience; }
+
+  //! Get the best objective seen in the last optimization.
+  double BestObjective() const { return bestObjective; }
+
+ private:
+  //! The number of epochs to wait for an improvement.
+  size_t patience;
+
+  //! The best objective seen so far.
+  double bestObjective;
+
+  //! The number of epochs since the best objective was seen.
+  size_t steps;
+};
+
+} // namespace ens
+
+#endif
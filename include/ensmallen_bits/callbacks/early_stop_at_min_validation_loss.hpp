@@ -0,0 +1,308 @@
+/**
+ * @file early_stop_at_min_validation_loss.hpp
+ * @author Marcus Edel
+ *
+ * Callback that stops the optimization when the objective on a held-out
+ * validation function stops improving, and restores the best coordinates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_VALIDATION_LOSS_HPP
+#define ENSMALLEN_CALLBACKS_EARLY_STOP_AT_MIN_VALIDATION_LOSS_HPP
+
+#include <thread>
+
+namespace ens {
+
+/**
+ * Evaluate a held-out validation function at the end of every given number of
+ * epochs, and terminate the optimization when the validation objective has
+ * not improved on the best one seen so far for a given number of evaluations.
+ * At the end of the optimization the coordinates are replaced by the best
+ * ones seen, unless restoreBest is false.  The objective returned by
+ * Optimize() is still that of the last coordinates of the optimizer.
+ *
+ * The validation function only needs a method
+ *
+ * @code
+ * double Evaluate(const arma::mat& coordinates);
+ * @endcode
+ *
+ * By default it is evaluated on a copy of the coordinates on a background
+ * thread while the optimization goes on, so it must not share any mutable
+ * state with the function being optimized; the result of an evaluation is then
+ * taken into account at the next evaluation, so the optimization terminates
+ * one period later than it would with a synchronous evaluation.  The epochs
+ * are those of the optimizer: passes over the data for SGD-based optimizers
+ * and SVRG, and iterations for L-BFGS.
+ *
+ * @code
+ * LogisticRegressionFunction<> f(trainData, trainResponses);
+ * LogisticRegressionFunction<> validation(validData, validResponses);
+ * EarlyStopAtMinValidationLoss<LogisticRegressionFunction<>> cb(validation);
+ *
+ * arma::mat coordinates = f.GetInitialPoint();
+ * StandardSGD optimizer;
+ * optimizer.Optimize(f, coordinates, cb);
+ * @endcode
+ *
+ * @tparam ValidationFunctionType Type of the validation function.
+ */
+template<typename ValidationFunctionType>
+class EarlyStopAtMinValidationLoss
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param validation The validation function; it must outlive the callback.
+   * @param period Number of epochs between two evaluations of the validation
+   *     function.
+   * @param patience The number of evaluations to wait for an improvement of
+   *     the validation objective before terminating.
+   * @param restoreBest If true, the coordinates are replaced by the best ones
+   *     at the end of the optimization.
+   * @param async If true, the validation function is evaluated on a
+   *     background thread.
+   */
+  EarlyStopAtMinValidationLoss(ValidationFunctionType& validation,
+                               const size_t period = 1,
+                               const size_t patience = 10,
+                               const bool restoreBest = true,
+                               const bool async = true) :
+      validation(validation),
+      period(period),
+      patience(patience),
+      restoreBest(restoreBest),
+      async(async),
+      bestObjective(std::numeric_limits<double>::max()),
+      bestEpoch(0),
+      steps(0),
+      evaluations(0),
+      pending(false),
+      pendingEpoch(0),
+      pendingObjective(0)
+  { /* Nothing to do. */ }
+
+  //! Wait for the last evaluation to finish.
+  ~EarlyStopAtMinValidationLoss() { Wait(); }
+
+  /**
+   * Reset the state at the start of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    Wait();
+    pending = false;
+    bestObjective = std::numeric_limits<double>::max();
+    bestEpoch = 0;
+    steps = 0;
+    evaluations = 0;
+    best.reset();
+  }
+
+  /**
+   * Take in the result of the last evaluation, and start the evaluation of the
+   * current coordinates at the end of every period'th epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t epoch,
+                const double /* objective */)
+  {
+    if (period == 0 || epoch % period != 0)
+      return false;
+
+    if (Collect())
+      return true;
+
+    // The buffer is free once the last evaluation has been taken in.
+    Copy(candidate, coordinates);
+    pendingEpoch = epoch;
+    pending = true;
+
+    if (!async)
+    {
+      Evaluate();
+      return Collect();
+    }
+
+    evaluator = std::thread(&EarlyStopAtMinValidationLoss::Evaluate, this);
+    return false;
+  }
+
+  /**
+   * Take in the result of the last evaluation, and restore the best
+   * coordinates at the end of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& coordinates)
+  {
+    Collect();
+    if (restoreBest && best.n_elem > 0)
+      coordinates = arma::conv_to<MatType>::from(best);
+  }
+
+  //! Get the number of epochs between two evaluations.
+  size_t Period() const { return period; }
+  //! Modify the number of epochs between two evaluations.
+  size_t& Period() { return period; }
+
+  //! Get the number of evaluations to wait for an improvement.
+  size_t Patience() const { return patience; }
+  //! Modify the number of evaluations to wait for an improvement.
+  size_t& Patience() { return patience; }
+
+  //! Get whether the best coordinates are restored.
+  bool RestoreBest() const { return restoreBest; }
+  //! Modify whether the best coordinates are restored.
+  bool& RestoreBest() { return restoreBest; }
+
+  //! Get whether the validation function is evaluated in the background.
+  bool Async() const { return async; }
+  //! Modify whether the validation function is evaluated in the background.
+  bool& Async() { return async; }
+
+  //! Get the best validation objective seen in the last optimization.
+  double BestObjective() const { return bestObjective; }
+
+  //! Get the epoch of the best validation objective.
+  size_t BestEpoch() const { return bestEpoch; }
+
+  //! Get the coordinates with the best validation objective.
+  const arma::mat& Best() const { return best; }
+
+  //! Get the number of evaluations of the validation function in the last
+  //! optimization.
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  //! Copy the coordinates into the given buffer, reusing its memory.
+  static void Copy(arma::mat& buffer, const arma::mat& coordinates)
+  {
+    buffer = coordinates;
+  }
+
+  //! Convert coordinates of another type into the given buffer.
+  template<typename MatType>
+  static void Copy(arma::mat& buffer, const MatType& coordinates)
+  {
+    buffer = arma::conv_to<arma::mat>::from(coordinates);
+  }
+
+  //! Evaluate the validation function on the candidate; this runs on the
+  //! evaluator thread if async is true.
+  void Evaluate() { pendingObjective = validation.Evaluate(candidate); }
+
+  //! Wait for the evaluator thread, if it is running.
+  void Wait()
+  {
+    if (evaluator.joinable())
+      evaluator.join();
+  }
+
+  /**
+   * Wait for the last evaluation and take in its result.
+   *
+   * @return true if the optimization should be terminated.
+   */
+  bool Collect()
+  {
+    Wait();
+    if (!pending)
+      return false;
+
+    pending = false;
+    ++evaluations;
+    if (pendingObjective < bestObjective)
+    {
+      bestObjective = pendingObjective;
+      bestEpoch = pendingEpoch;
+      best.swap(candidate);
+      steps = 0;
+      return false;
+    }
+
+    if (++steps < patience)
+      return false;
+
+    ENS_INFO << "EarlyStopAtMinValidationLoss: no improvement of the "
+        << "validation objective for " << patience << " evaluations; "
+        << "terminating optimization." << std::endl;
+    return true;
+  }
+
+  //! The validation function.
+  ValidationFunctionType& validation;
+
+  //! The number of epochs between two evaluations.
+  size_t period;
+
+  //! The number of evaluations to wait for an improvement.
+  size_t patience;
+
+  //! Whether to restore the best coordinates.
+  bool restoreBest;
+
+  //! Whether to evaluate the validation function in the background.
+  bool async;
+
+  //! The best validation objective seen so far.
+  double bestObjective;
+
+  //! The epoch of the best validation objective.
+  size_t bestEpoch;
+
+  //! The number of evaluations since the best objective was seen.
+  size_t steps;
+
+  //! The number of evaluations taken in so far.
+  size_t evaluations;
+
+  //! The coordinates with the best validation objective.
+  arma::mat best;
+
+  //! The copy of the coordinates that is being evaluated.
+  arma::mat candidate;
+
+  //! Whether an evaluation has been started and not taken in yet.
+  bool pending;
+
+  //! The epoch of the coordinates that are being evaluated.
+  size_t pendingEpoch;
+
+  //! The result of the last evaluation.
+  double pendingObjective;
+
+  //! The thread evaluating the validation function.
+  std::thread evaluator;
+};
+
+} // namespace ens
+
+#endif
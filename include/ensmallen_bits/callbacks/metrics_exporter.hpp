@@ -0,0 +1,580 @@
+/**
+ * @file metrics_exporter.hpp
+ * @author Ryan Curtin
+ *
+ * Callback that keeps live metrics of an optimization (throughput, objective,
+ * step size, evaluation counts, time spent), which another thread can read at
+ * any time and write to a metrics sink, such as the Prometheus text format.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_METRICS_EXPORTER_HPP
+#define ENSMALLEN_CALLBACKS_METRICS_EXPORTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <string>
+
+namespace ens {
+
+/**
+ * The metrics of a MetricsExporter at one point in time.  Counters only grow
+ * while the exporter lives; gauges hold the last value reported.  Values that
+ * are not known are NaN.
+ */
+struct MetricsSnapshot
+{
+  //! Time since the exporter started, in seconds.
+  double time;
+  //! Number of optimizations started.
+  size_t optimizations;
+  //! Whether an optimization is running.
+  bool running;
+  //! Number of steps taken.
+  size_t steps;
+  //! Number of samples processed by the steps.
+  size_t samples;
+  //! Number of epochs finished.
+  size_t epochs;
+  //! Number of objective evaluations reported.
+  size_t evaluations;
+  //! Number of gradients reported.
+  size_t gradients;
+  //! The last objective reported by the optimizer.
+  double objective;
+  //! Step size of the optimizer (NaN if it has none).
+  double stepSize;
+  //! Norm of the last gradient kept (NaN if none).
+  double gradientNorm;
+  //! Samples processed per second, over the last rate interval.
+  double samplesPerSecond;
+  //! Time spent in optimizations, including the running one, in seconds.
+  double optimizationTime;
+  //! Time spent in the objective function by the whole process, in seconds
+  //! (only known if ENS_PROFILE is defined).
+  double functionTime;
+  //! Duration of the last epoch, in seconds.
+  double lastEpochTime;
+  //! Time since the last step, in seconds (NaN if no step was taken).
+  double timeSinceLastStep;
+};
+
+/**
+ * Keep live metrics of the optimizations it is passed to, so that a long
+ * optimization can be monitored while it runs: counters of the steps, the
+ * samples processed, the epochs, the objective evaluations and the gradients,
+ * and gauges of the last objective, the step size (for optimizers with a
+ * StepSize() method), the gradient norm, the throughput in samples per second,
+ * the time spent in the optimization and in the objective function, the
+ * duration of the last epoch, and the time since the last step (which detects
+ * stalls).
+ *
+ * The metrics are atomics, updated with relaxed operations by whichever thread
+ * reports an event, so that several optimizer threads can report at once and
+ * another thread can read them at any time with Snapshot() or Export(),
+ * without locks.  A step costs a few atomic additions and one read of the
+ * steady clock; the norm of the gradient is only computed every normPeriod
+ * steps.  The samples of a step are the BatchSize() of optimizers that have
+ * one; otherwise, the NumFunctions() of separable functions (a full pass), and
+ * otherwise one.
+ *
+ * The exporter accumulates over all the optimizations it is passed to (so an
+ * optimizer that runs others, such as LRSDP, or a training job that calls
+ * Optimize() repeatedly, gives a single series), and the time of optimizations
+ * that run at once is counted once.  It must be passed as an lvalue, and must
+ * outlive the threads that read it.
+ *
+ * Export() gives a snapshot to a metrics sink, which is any class with a
+ * method
+ *
+ * @code
+ * void Write(const MetricsSnapshot& snapshot);
+ * @endcode
+ *
+ * such as PrometheusTextSink, which writes the Prometheus text exposition
+ * format, e.g. to answer the requests of a Prometheus server:
+ *
+ * @code
+ * MetricsExporter metrics;
+ * std::thread server([&]()
+ * {
+ *   while (...) // For every scrape request...
+ *   {
+ *     std::ostringstream body;
+ *     PrometheusTextSink sink(body, "ensmallen", "job=\"training\"");
+ *     metrics.Export(sink);
+ *     // ... send body.str() as the response.
+ *   }
+ * });
+ *
+ * Adam optimizer;
+ * optimizer.Optimize(f, coordinates, metrics);
+ * @endcode
+ */
+class MetricsExporter
+{
+ public:
+  /**
+   * Set up the exporter.
+   *
+   * @param normPeriod Number of steps between two computations of the gradient
+   *     norm (0 means that the norm is never computed).
+   * @param rateInterval Minimum time, in seconds, over which the throughput is
+   *     measured.
+   */
+  MetricsExporter(const size_t normPeriod = 100,
+                  const double rateInterval = 1.0) :
+      normPeriod(normPeriod),
+      rateInterval(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(rateInterval)).count()),
+      start(Clock::now()),
+      optimizations(0),
+      depth(0),
+      steps(0),
+      samples(0),
+      epochs(0),
+      evaluations(0),
+      gradients(0),
+      optimizationTicks(0),
+      optimizationStart(0),
+      epochStart(0),
+      lastStep(-1),
+      rateStart(0),
+      rateSamples(0)
+  {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    objective = nan;
+    stepSize = nan;
+    gradientNorm = nan;
+    samplesPerSecond = nan;
+    lastEpochTime = nan;
+  }
+
+  /**
+   * Start timing the optimization, unless another one is running.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    optimizations.fetch_add(1, std::memory_order_relaxed);
+    const long long now = Now();
+    epochStart.store(now, std::memory_order_relaxed);
+    if (depth.fetch_add(1, std::memory_order_acq_rel) == 0)
+      optimizationStart.store(now, std::memory_order_release);
+  }
+
+  /**
+   * Stop timing the optimization, if it is the last one running.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    if (depth.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      optimizationTicks.fetch_add(Now() - optimizationStart.load(
+          std::memory_order_acquire), std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Count the evaluation and keep the objective.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param objective Objective value of the coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objective)
+  {
+    evaluations.fetch_add(1, std::memory_order_relaxed);
+    this->objective.store(objective, std::memory_order_relaxed);
+  }
+
+  /**
+   * Count the gradient, and keep its norm if it is one of every normPeriod.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param gradient Gradient at the coordinates.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& gradient)
+  {
+    gradients.fetch_add(1, std::memory_order_relaxed);
+    if (normPeriod != 0 &&
+        (steps.load(std::memory_order_relaxed) + 1) % normPeriod == 0)
+    {
+      gradientNorm.store(arma::norm(gradient, "fro"),
+          std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Count the epoch, and keep its objective and duration.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    epochs.fetch_add(1, std::memory_order_relaxed);
+    this->objective.store(objective, std::memory_order_relaxed);
+
+    const long long now = Now();
+    lastEpochTime.store(Seconds(now - epochStart.exchange(now,
+        std::memory_order_relaxed)), std::memory_order_relaxed);
+  }
+
+  /**
+   * Count the step and its samples, keep the step size, and update the
+   * throughput once per rate interval.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& optimizer,
+                 FunctionType& function,
+                 const MatType& /* coordinates */)
+  {
+    steps.fetch_add(1, std::memory_order_relaxed);
+    const size_t stepSamples = StepSamples(optimizer, function, 0);
+    const size_t total = samples.fetch_add(stepSamples,
+        std::memory_order_relaxed) + stepSamples;
+    stepSize.store(StepSize(optimizer, 0), std::memory_order_relaxed);
+
+    const long long now = Now();
+    lastStep.store(now, std::memory_order_relaxed);
+
+    // Only the thread that moves the start of the window updates the rate.
+    long long windowStart = rateStart.load(std::memory_order_relaxed);
+    if (now - windowStart >= rateInterval &&
+        rateStart.compare_exchange_strong(windowStart, now,
+        std::memory_order_relaxed))
+    {
+      const size_t windowSamples = rateSamples.exchange(total,
+          std::memory_order_relaxed);
+      if (now > windowStart)
+      {
+        samplesPerSecond.store((double) (total - windowSamples) /
+            Seconds(now - windowStart), std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Get the current metrics.  This may be called from any thread, while the
+   * optimization runs.
+   */
+  MetricsSnapshot Snapshot() const
+  {
+    const long long now = Now();
+
+    MetricsSnapshot s;
+    s.time = Seconds(now);
+    s.optimizations = optimizations.load(std::memory_order_relaxed);
+    s.running = (depth.load(std::memory_order_acquire) > 0);
+    s.steps = steps.load(std::memory_order_relaxed);
+    s.samples = samples.load(std::memory_order_relaxed);
+    s.epochs = epochs.load(std::memory_order_relaxed);
+    s.evaluations = evaluations.load(std::memory_order_relaxed);
+    s.gradients = gradients.load(std::memory_order_relaxed);
+    s.objective = objective.load(std::memory_order_relaxed);
+    s.stepSize = stepSize.load(std::memory_order_relaxed);
+    s.gradientNorm = gradientNorm.load(std::memory_order_relaxed);
+    s.samplesPerSecond = samplesPerSecond.load(std::memory_order_relaxed);
+    s.lastEpochTime = lastEpochTime.load(std::memory_order_relaxed);
+
+    long long ticks = optimizationTicks.load(std::memory_order_relaxed);
+    if (s.running)
+      ticks += now - optimizationStart.load(std::memory_order_acquire);
+    s.optimizationTime = Seconds(std::max(ticks, 0LL));
+
+    #ifdef ENS_PROFILE
+      s.functionTime = profile::GlobalCounters().functionNanoseconds / 1e9;
+    #else
+      s.functionTime = std::numeric_limits<double>::quiet_NaN();
+    #endif
+
+    const long long step = lastStep.load(std::memory_order_relaxed);
+    s.timeSinceLastStep = (step < 0) ?
+        std::numeric_limits<double>::quiet_NaN() :
+        Seconds(std::max(now - step, 0LL));
+
+    return s;
+  }
+
+  /**
+   * Give the current metrics to the given sink, which must have a method
+   * void Write(const MetricsSnapshot&).  This may be called from any thread,
+   * while the optimization runs.
+   *
+   * @param sink Sink to write the metrics to.
+   */
+  template<typename SinkType>
+  void Export(SinkType& sink) const
+  {
+    sink.Write(Snapshot());
+  }
+
+  //! Get the number of steps between two computations of the gradient norm.
+  size_t NormPeriod() const { return normPeriod; }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! Get the ticks of the steady clock since the exporter started.
+  long long Now() const { return (Clock::now() - start).count(); }
+
+  //! Convert ticks of the steady clock to seconds.
+  static double Seconds(const long long ticks)
+  {
+    return std::chrono::duration<double>(Clock::duration(ticks)).count();
+  }
+
+  //! Get the batch size of an optimizer with a BatchSize() method.
+  template<typename OptimizerType, typename FunctionType>
+  static auto StepSamples(OptimizerType& optimizer,
+                          FunctionType& /* function */,
+                          int)
+      -> decltype((size_t) optimizer.BatchSize())
+  {
+    return (size_t) optimizer.BatchSize();
+  }
+
+  //! Otherwise, the steps over a separable function take all of it.
+  template<typename OptimizerType, typename FunctionType>
+  static auto StepSamples(OptimizerType& /* optimizer */,
+                          FunctionType& function,
+                          long)
+      -> decltype((size_t) function.NumFunctions())
+  {
+    return (size_t) function.NumFunctions();
+  }
+
+  //! Otherwise, a step processes one sample.
+  template<typename OptimizerType, typename FunctionType>
+  static size_t StepSamples(OptimizerType& /* optimizer */,
+                            FunctionType& /* function */,
+                            ...)
+  {
+    return 1;
+  }
+
+  //! Get the step size of an optimizer with a StepSize() method.
+  template<typename OptimizerType>
+  static auto StepSize(OptimizerType& optimizer, int)
+      -> decltype((double) optimizer.StepSize())
+  {
+    return (double) optimizer.StepSize();
+  }
+
+  //! Optimizers without a StepSize() method have no step size.
+  template<typename OptimizerType>
+  static double StepSize(OptimizerType& /* optimizer */, long)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  //! The number of steps between two computations of the gradient norm.
+  size_t normPeriod;
+
+  //! The minimum interval of the throughput, in ticks.
+  long long rateInterval;
+
+  //! The time the exporter started.
+  Clock::time_point start;
+
+  //! The number of optimizations started.
+  std::atomic<size_t> optimizations;
+
+  //! The number of optimizations running.
+  std::atomic<int> depth;
+
+  //! The number of steps taken.
+  std::atomic<size_t> steps;
+
+  //! The number of samples processed.
+  std::atomic<size_t> samples;
+
+  //! The number of epochs finished.
+  std::atomic<size_t> epochs;
+
+  //! The number of objective evaluations reported.
+  std::atomic<size_t> evaluations;
+
+  //! The number of gradients reported.
+  std::atomic<size_t> gradients;
+
+  //! The last objective reported.
+  std::atomic<double> objective;
+
+  //! The last step size of the optimizer.
+  std::atomic<double> stepSize;
+
+  //! The last gradient norm kept.
+  std::atomic<double> gradientNorm;
+
+  //! The throughput over the last rate interval.
+  std::atomic<double> samplesPerSecond;
+
+  //! The duration of the last epoch.
+  std::atomic<double> lastEpochTime;
+
+  //! The ticks of the optimizations that finished.
+  std::atomic<long long> optimizationTicks;
+
+  //! The start of the running optimizations.
+  std::atomic<long long> optimizationStart;
+
+  //! The start of the current epoch.
+  std::atomic<long long> epochStart;
+
+  //! The time of the last step (-1 if none).
+  std::atomic<long long> lastStep;
+
+  //! The start of the current throughput window.
+  std::atomic<long long> rateStart;
+
+  //! The number of samples processed at the start of the window.
+  std::atomic<size_t> rateSamples;
+};
+
+/**
+ * A metrics sink that writes a MetricsSnapshot in the Prometheus text
+ * exposition format (version 0.0.4), with a HELP and a TYPE line per metric.
+ * Counters have the _total suffix; the metrics that are not known are written
+ * as NaN.
+ */
+class PrometheusTextSink
+{
+ public:
+  /**
+   * Set up the sink.
+   *
+   * @param output Stream to write to.
+   * @param prefix Prefix of the metric names.
+   * @param labels Labels of every sample, without the braces (e.g.
+   *     job="training",run="3"), or an empty string.
+   */
+  PrometheusTextSink(std::ostream& output,
+                     const std::string& prefix = "ensmallen",
+                     const std::string& labels = "") :
+      output(output),
+      prefix(prefix),
+      labels(labels.empty() ? "" : "{" + labels + "}")
+  { /* Nothing to do. */ }
+
+  /**
+   * Write the given metrics.
+   *
+   * @param s Metrics to write.
+   */
+  void Write(const MetricsSnapshot& s)
+  {
+    const std::streamsize precision = output.precision(17);
+    Metric("optimizations_total", "counter",
+        "Number of optimizations started.", (double) s.optimizations);
+    Metric("running", "gauge",
+        "Whether an optimization is running.", s.running ? 1.0 : 0.0);
+    Metric("steps_total", "counter",
+        "Number of steps taken.", (double) s.steps);
+    Metric("samples_total", "counter",
+        "Number of samples processed by the steps.", (double) s.samples);
+    Metric("epochs_total", "counter",
+        "Number of epochs finished.", (double) s.epochs);
+    Metric("evaluations_total", "counter",
+        "Number of objective evaluations.", (double) s.evaluations);
+    Metric("gradients_total", "counter",
+        "Number of gradients computed.", (double) s.gradients);
+    Metric("objective", "gauge",
+        "Last objective reported by the optimizer.", s.objective);
+    Metric("step_size", "gauge",
+        "Step size of the optimizer.", s.stepSize);
+    Metric("gradient_norm", "gauge",
+        "Norm of the last gradient kept.", s.gradientNorm);
+    Metric("samples_per_second", "gauge",
+        "Samples processed per second.", s.samplesPerSecond);
+    Metric("optimization_seconds_total", "counter",
+        "Time spent in optimizations.", s.optimizationTime);
+    Metric("function_seconds_total", "counter",
+        "Time spent in the objective function.", s.functionTime);
+    Metric("last_epoch_seconds", "gauge",
+        "Duration of the last epoch.", s.lastEpochTime);
+    Metric("seconds_since_last_step", "gauge",
+        "Time since the last step.", s.timeSinceLastStep);
+    output.precision(precision);
+    output.flush();
+  }
+
+ private:
+  //! Write one metric with its HELP and TYPE lines.
+  void Metric(const char* name,
+              const char* type,
+              const char* help,
+              const double value)
+  {
+    output << "# HELP " << prefix << "_" << name << " " << help << "\n"
+        << "# TYPE " << prefix << "_" << name << " " << type << "\n"
+        << prefix << "_" << name << labels << " ";
+    if (std::isnan(value))
+      output << "NaN";
+    else if (std::isinf(value))
+      output << ((value > 0) ? "+Inf" : "-Inf");
+    else
+      output << value;
+    output << "\n";
+  }
+
+  //! The stream to write to.
+  std::ostream& output;
+
+  //! The prefix of the metric names.
+  std::string prefix;
+
+  //! The labels of every sample, with the braces.
+  std::string labels;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file print_loss.hpp
+ * @author Ryan Curtin
+ *
+ * Callback that prints the objective at the end of every epoch.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_PRINT_LOSS_HPP
+#define ENSMALLEN_CALLBACKS_PRINT_LOSS_HPP
+
+namespace ens {
+
+/**
+ * Print the objective at the end of every epoch to the given stream.  Unlike
+ * the Info stream, this works even if ENS_PRINT_INFO is not defined.
+ */
+class PrintLoss
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param output Stream to print the objective to.
+   */
+  PrintLoss(std::ostream& output = std::cout) : output(output)
+  { /* Nothing to do. */ }
+
+  /**
+   * Print the objective at the end of an epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t epoch,
+                const double objective)
+  {
+    output << "epoch " << epoch << ": objective " << objective << std::endl;
+  }
+
+ private:
+  //! The stream to print to.
+  std::ostream& output;
+};
+
+} // namespace ens
+
+#endif
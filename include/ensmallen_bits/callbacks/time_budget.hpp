@@ -0,0 +1,261 @@
+/**
+ * @file time_budget.hpp
+ * @author Ryan Curtin
+ *
+ * Callback that stops the optimization when a wall-clock time budget is spent
+ * or a cancellation token is set.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TIME_BUDGET_HPP
+#define ENSMALLEN_CALLBACKS_TIME_BUDGET_HPP
+
+#include <chrono>
+#include <ensmallen_bits/utility/cancellation_token.hpp>
+
+namespace ens {
+
+/**
+ * Terminate the optimization once the given number of seconds has passed
+ * since the callback was constructed (or since Restart() was called), or once
+ * the given CancellationToken has been cancelled.  Since the clock does not
+ * start again with every optimization, an optimizer that runs others (such as
+ * LRSDP, IPOPCMAES or MultiStart) stays within the same budget, and a
+ * TimeBudget constructed when a request arrives bounds the time spent on it.
+ * The check is made at every event the optimizer reports (every batch for SGD
+ * and the optimizers based on it, every iteration and every trial of the line
+ * search for L_BFGS, every generation for CMAES, every move for SA, and so
+ * on), and costs one read of the steady clock.
+ *
+ * Optimizers return their current coordinates when they are stopped.  With
+ * restoreBest, the coordinates with the lowest objective reported at the end
+ * of an epoch are restored instead, if the budget stopped the optimization;
+ * the objective returned by Optimize() is still that of the last coordinates.
+ */
+class TimeBudget
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param seconds The wall-clock time budget, in seconds, starting now (0
+   *     means no limit).
+   * @param token Token that stops the optimization when it is cancelled.
+   * @param restoreBest If true, restore the coordinates with the best
+   *     objective at the end of an epoch when the budget is exhausted.
+   */
+  TimeBudget(const double seconds,
+             const CancellationToken& token = CancellationToken(),
+             const bool restoreBest = false) :
+      seconds(seconds),
+      token(token),
+      restoreBest(restoreBest),
+      bestObjective(std::numeric_limits<double>::max())
+  {
+    Restart();
+  }
+
+  //! Start the time budget again from now, and forget that it was spent.
+  void Restart()
+  {
+    start = Clock::now();
+    deadline = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    expired = false;
+  }
+
+  /**
+   * Check the budget at the start of the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    bestObjective = std::numeric_limits<double>::max();
+    best.reset();
+    return Expired();
+  }
+
+  /**
+   * Check the budget after an evaluation of the objective.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param objective Objective value of the coordinates.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double /* objective */)
+  {
+    return Expired();
+  }
+
+  /**
+   * Check the budget at the start of an epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the last epoch.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double /* objective */)
+  {
+    return Expired();
+  }
+
+  /**
+   * Keep the best coordinates, if restoreBest is set, and check the budget at
+   * the end of an epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    if (restoreBest && objective < bestObjective)
+    {
+      bestObjective = objective;
+      best = arma::conv_to<arma::mat>::from(coordinates);
+    }
+
+    return Expired();
+  }
+
+  /**
+   * Check the budget after a step.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @return true if the optimization should be terminated.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    return Expired();
+  }
+
+  /**
+   * Restore the best coordinates, if the budget stopped the optimization and
+   * restoreBest is set.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& coordinates)
+  {
+    if (restoreBest && expired && best.n_elem > 0)
+      coordinates = arma::conv_to<MatType>::from(best);
+  }
+
+  //! Get the time budget, in seconds (0 means no limit).
+  double Seconds() const { return seconds; }
+
+  //! Get the cancellation token.
+  const CancellationToken& Token() const { return token; }
+  //! Modify the cancellation token.
+  CancellationToken& Token() { return token; }
+
+  //! Get whether the best coordinates are restored.
+  bool RestoreBest() const { return restoreBest; }
+  //! Modify whether the best coordinates are restored.
+  bool& RestoreBest() { return restoreBest; }
+
+  //! Get whether the budget is spent or the token was cancelled.
+  bool Stopped() const { return expired; }
+
+  //! Get the time since the budget started, in seconds.
+  double Elapsed() const
+  {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! Return whether the budget is spent or the token is cancelled.  Once
+  //! that happened, it stays that way until Restart() is called.
+  bool Expired()
+  {
+    if (expired)
+      return true;
+
+    if (token.Cancelled())
+    {
+      ENS_INFO << "TimeBudget: cancelled; terminating optimization."
+          << std::endl;
+      expired = true;
+    }
+    else if (seconds > 0.0 && Clock::now() >= deadline)
+    {
+      ENS_INFO << "TimeBudget: time budget of " << seconds << "s spent; "
+          << "terminating optimization." << std::endl;
+      expired = true;
+    }
+
+    return expired;
+  }
+
+  //! The time budget, in seconds.
+  double seconds;
+
+  //! The cancellation token.
+  CancellationToken token;
+
+  //! Whether to restore the best coordinates.
+  bool restoreBest;
+
+  //! Whether the optimization was stopped.
+  bool expired;
+
+  //! The start of the budget.
+  Clock::time_point start;
+
+  //! The end of the budget.
+  Clock::time_point deadline;
+
+  //! The best objective at the end of an epoch.
+  double bestObjective;
+
+  //! The coordinates with the best objective.
+  arma::mat best;
+};
+
+} // namespace ens
+
+#endif
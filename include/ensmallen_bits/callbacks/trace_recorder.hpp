@@ -0,0 +1,331 @@
+/**
+ * @file trace_recorder.hpp
+ * @author Ryan Curtin
+ *
+ * Callback that records a timestamped trace of the convergence of an
+ * optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TRACE_RECORDER_HPP
+#define ENSMALLEN_CALLBACKS_TRACE_RECORDER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * One record of a TraceRecorder.
+ */
+struct TraceRecord
+{
+  //! Time since the recorder started, in seconds.
+  double time;
+  //! Number of steps taken so far.
+  size_t iteration;
+  //! Number of objective evaluations reported so far.
+  size_t evaluations;
+  //! The last objective reported by the optimizer.
+  double objective;
+  //! Norm of the last gradient reported by the optimizer (NaN if none).
+  double gradientNorm;
+  //! Step size of the optimizer (NaN if it has none).
+  double stepSize;
+  //! Whether the record was taken at the end of an epoch.
+  bool epoch;
+};
+
+/**
+ * Record a trace of the optimization: every period steps, and at the end of
+ * every epoch, the time since the recorder started, the number of steps and of
+ * objective evaluations so far, the last objective and gradient norm reported
+ * by the optimizer, and the step size of the optimizer (for optimizers with a
+ * StepSize() method) are stored.  The trace gives the objective against the
+ * wall-clock time or the number of evaluations, to compare optimizers on a
+ * problem.
+ *
+ * The records are kept in a ring buffer allocated by the constructor, so that
+ * recording never allocates and costs a read of the steady clock; once the
+ * buffer is full, the oldest records are overwritten.  The gradient norm is
+ * only computed for the gradients of the recorded steps.  For the optimizers
+ * of separable functions, the objective of a step is that of the last batch,
+ * and the objective of the end of an epoch is that of the epoch.
+ *
+ * As with TimeBudget, the clock starts when the recorder is constructed (or
+ * when Clear() is called), so that an optimizer that runs others gives one
+ * trace.  After the optimization, the trace can be written with WriteCSV() or
+ * WriteJSON().
+ */
+class TraceRecorder
+{
+ public:
+  /**
+   * Set up the recorder.
+   *
+   * @param capacity Maximum number of records kept.
+   * @param period Number of steps between two records (0 means that only the
+   *     ends of the epochs are recorded).
+   */
+  TraceRecorder(const size_t capacity = 100000, const size_t period = 1) :
+      records(std::max(capacity, (size_t) 1)),
+      period(period)
+  {
+    Clear();
+  }
+
+  //! Forget all the records and start the clock again from now.
+  void Clear()
+  {
+    start = Clock::now();
+    head = 0;
+    size = 0;
+    dropped = 0;
+    steps = 0;
+    evaluations = 0;
+    lastObjective = std::numeric_limits<double>::quiet_NaN();
+    lastGradientNorm = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /**
+   * Keep the objective.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param objective Objective value of the coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objective)
+  {
+    ++evaluations;
+    lastObjective = objective;
+  }
+
+  /**
+   * Keep the norm of the gradient, if the next step is recorded.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param gradient Gradient at the coordinates.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& gradient)
+  {
+    if (period != 0 && (steps + 1) % period == 0)
+      lastGradientNorm = arma::norm(gradient, "fro");
+  }
+
+  /**
+   * Record the end of an epoch.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current epoch.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    lastObjective = objective;
+    Record(StepSize(optimizer, 0), true);
+  }
+
+  /**
+   * Record the step, if it is one of every period steps.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Current coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& optimizer,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    ++steps;
+    if (period != 0 && steps % period == 0)
+      Record(StepSize(optimizer, 0), false);
+  }
+
+  //! Get the number of records kept.
+  size_t Size() const { return size; }
+
+  //! Get the maximum number of records kept.
+  size_t Capacity() const { return records.size(); }
+
+  //! Get the number of records that were overwritten.
+  size_t Dropped() const { return dropped; }
+
+  //! Get the number of steps taken since the recorder started.
+  size_t Steps() const { return steps; }
+
+  //! Get the number of steps between two records.
+  size_t Period() const { return period; }
+  //! Modify the number of steps between two records.
+  size_t& Period() { return period; }
+
+  //! Get the i-th record kept, from the oldest.
+  const TraceRecord& operator[](const size_t i) const
+  {
+    return records[(head + records.size() - size + i) % records.size()];
+  }
+
+  /**
+   * Write the records as CSV, with a header line.  Values that are not known
+   * are written as nan.
+   *
+   * @param output Stream to write to.
+   * @param prefix Text written at the start of every record line (e.g. the
+   *     name of the run and a comma).
+   * @param header Whether to write the header line.
+   */
+  void WriteCSV(std::ostream& output,
+                const std::string& prefix = "",
+                const bool header = true) const
+  {
+    if (header)
+    {
+      output << "time,iteration,evaluations,objective,gradient_norm,"
+          << "step_size,epoch" << std::endl;
+    }
+
+    const std::streamsize precision = output.precision(17);
+    for (size_t i = 0; i < size; ++i)
+    {
+      const TraceRecord& r = (*this)[i];
+      output << prefix << r.time << "," << r.iteration << "," << r.evaluations
+          << "," << r.objective << "," << r.gradientNorm << "," << r.stepSize
+          << "," << (r.epoch ? 1 : 0) << "\n";
+    }
+    output.precision(precision);
+    output.flush();
+  }
+
+  /**
+   * Write the records as a JSON array of objects.  Values that are not known
+   * are written as null.
+   *
+   * @param output Stream to write to.
+   */
+  void WriteJSON(std::ostream& output) const
+  {
+    const std::streamsize precision = output.precision(17);
+    output << "[";
+    for (size_t i = 0; i < size; ++i)
+    {
+      const TraceRecord& r = (*this)[i];
+      output << ((i == 0) ? "\n" : ",\n") << "  {\"time\": " << r.time
+          << ", \"iteration\": " << r.iteration << ", \"evaluations\": "
+          << r.evaluations << ", \"objective\": ";
+      WriteJSONNumber(output, r.objective);
+      output << ", \"gradient_norm\": ";
+      WriteJSONNumber(output, r.gradientNorm);
+      output << ", \"step_size\": ";
+      WriteJSONNumber(output, r.stepSize);
+      output << ", \"epoch\": " << (r.epoch ? "true" : "false") << "}";
+    }
+    output << ((size == 0) ? "]" : "\n]") << std::endl;
+    output.precision(precision);
+  }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! Store a record of the current state in the ring buffer.
+  void Record(const double stepSize, const bool epoch)
+  {
+    TraceRecord& r = records[head];
+    r.time = std::chrono::duration<double>(Clock::now() - start).count();
+    r.iteration = steps;
+    r.evaluations = evaluations;
+    r.objective = lastObjective;
+    r.gradientNorm = lastGradientNorm;
+    r.stepSize = stepSize;
+    r.epoch = epoch;
+
+    head = (head + 1) % records.size();
+    if (size < records.size())
+      ++size;
+    else
+      ++dropped;
+  }
+
+  //! Get the step size of an optimizer with a StepSize() method.
+  template<typename OptimizerType>
+  static auto StepSize(OptimizerType& optimizer, int)
+      -> decltype((double) optimizer.StepSize())
+  {
+    return (double) optimizer.StepSize();
+  }
+
+  //! Optimizers without a StepSize() method have no step size.
+  template<typename OptimizerType>
+  static double StepSize(OptimizerType& /* optimizer */, long)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  //! Write a number, or null if it is not finite.
+  static void WriteJSONNumber(std::ostream& output, const double value)
+  {
+    if (std::isfinite(value))
+      output << value;
+    else
+      output << "null";
+  }
+
+  //! The ring buffer of records.
+  std::vector<TraceRecord> records;
+
+  //! The number of steps between two records.
+  size_t period;
+
+  //! The index of the next record to write.
+  size_t head;
+
+  //! The number of records kept.
+  size_t size;
+
+  //! The number of records overwritten.
+  size_t dropped;
+
+  //! The number of steps taken.
+  size_t steps;
+
+  //! The number of objective evaluations reported.
+  size_t evaluations;
+
+  //! The last objective reported.
+  double lastObjective;
+
+  //! The norm of the last gradient kept.
+  double lastGradientNorm;
+
+  //! The start of the trace.
+  Clock::time_point start;
+};
+
+} // namespace ens
+
+#endif
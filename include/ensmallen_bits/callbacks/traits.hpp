@@ -0,0 +1,96 @@
+/**
+ * @file traits.hpp
+ * @author Ryan Curtin
+ *
+ * Detection of the callback methods that a callback type implements, and
+ * invocation of those methods.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TRAITS_HPP
+#define ENSMALLEN_CALLBACKS_TRAITS_HPP
+
+#include <type_traits>
+
+namespace ens {
+namespace callbacks {
+namespace traits {
+
+//! Returned by the detection below if a callback does not have a method.
+struct MethodNotFound { };
+
+} // namespace traits
+} // namespace callbacks
+} // namespace ens
+
+/**
+ * Generate a struct NAME<CallbackType, Args...> that detects whether
+ * CallbackType has a method METHOD callable with arguments of the types Args,
+ * and that provides a static Invoke() method calling it.  Invoke() returns the
+ * result of the callback if it returns bool, false if it returns void, and
+ * false without doing anything if the callback does not have the method at
+ * all.  The default template parameter R lets the unused overloads fail
+ * substitution instead of failing to compile.
+ *
+ * @param METHOD The name of the callback method.
+ * @param NAME The name of the struct to generate.
+ */
+#undef  ENS_CALLBACK_INVOKER
+#define ENS_CALLBACK_INVOKER(METHOD, NAME)                                     \
+template<typename CallbackType, typename... Args>                              \
+struct NAME                                                                    \
+{                                                                              \
+  template<typename C>                                                         \
+  static auto Check(int) -> decltype(                                          \
+      std::declval<C&>().METHOD(std::declval<Args&>()...));                    \
+  template<typename>                                                           \
+  static MethodNotFound Check(...);                                            \
+                                                                               \
+  typedef decltype(Check<CallbackType>(0)) ResultType;                         \
+                                                                               \
+  static const bool value = !std::is_same<ResultType, MethodNotFound>::value;  \
+                                                                               \
+  template<typename R = ResultType>                                            \
+  static typename std::enable_if<std::is_same<R, bool>::value, bool>::type     \
+  Invoke(CallbackType& callback, Args&... args)                                \
+  {                                                                            \
+    return callback.METHOD(args...);                                           \
+  }                                                                            \
+                                                                               \
+  template<typename R = ResultType>                                            \
+  static typename std::enable_if<std::is_void<R>::value, bool>::type           \
+  Invoke(CallbackType& callback, Args&... args)                                \
+  {                                                                            \
+    callback.METHOD(args...);                                                  \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  template<typename R = ResultType>                                            \
+  static typename std::enable_if<std::is_same<R, MethodNotFound>::value,       \
+      bool>::type                                                              \
+  Invoke(CallbackType& /* callback */, Args&... /* args */)                    \
+  {                                                                            \
+    return false;                                                              \
+  }                                                                            \
+};
+
+namespace ens {
+namespace callbacks {
+namespace traits {
+
+ENS_CALLBACK_INVOKER(BeginOptimization, BeginOptimizationInvoker)
+ENS_CALLBACK_INVOKER(EndOptimization, EndOptimizationInvoker)
+ENS_CALLBACK_INVOKER(Evaluate, EvaluateInvoker)
+ENS_CALLBACK_INVOKER(Gradient, GradientInvoker)
+ENS_CALLBACK_INVOKER(BeginEpoch, BeginEpochInvoker)
+ENS_CALLBACK_INVOKER(EndEpoch, EndEpochInvoker)
+ENS_CALLBACK_INVOKER(StepTaken, StepTakenInvoker)
+
+} // namespace traits
+} // namespace callbacks
+} // namespace ens
+
+#endif
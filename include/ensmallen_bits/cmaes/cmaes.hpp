@@ -17,6 +17,9 @@
 
 #include "full_selection.hpp"
 #include "random_selection.hpp"
+#include "importance_selection.hpp"
+#include "full_covariance.hpp"
+#include "diagonal_covariance.hpp"
 
 namespace ens {
 
@@ -46,8 +49,11 @@ namespace ens {
  * ensmallen website.
  *
  * @tparam SelectionPolicy The selection strategy used for the evaluation step.
+ * @tparam CovariancePolicyType The representation of the covariance matrix of
+ *     the search distribution (FullCovariance or DiagonalCovariance).
  */
-template<typename SelectionPolicyType = FullSelection>
+template<typename SelectionPolicyType = FullSelection,
+         typename CovariancePolicyType = FullCovariance>
 class CMAES
 {
  public:
@@ -68,6 +74,12 @@ class CMAES
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param selectionPolicy Instantiated selection policy used to calculate the
    *     objective.
+   * @param parallelEvaluation If true, evaluate the candidates of each
+   *     generation with several OpenMP threads.
+   * @param covariancePolicy Instantiated covariance policy used to adapt the
+   *     search distribution.
+   * @param warmStart If true, continue with the search distribution of the
+   *     last call to Optimize() instead of starting over.
    */
   CMAES(const size_t lambda = 0,
         const double lowerBound = -10,
@@ -75,20 +87,144 @@ class CMAES
         const size_t batchSize = 32,
         const size_t maxIterations = 1000,
         const double tolerance = 1e-5,
-        const SelectionPolicyType& selectionPolicy = SelectionPolicyType());
+        const SelectionPolicyType& selectionPolicy = SelectionPolicyType(),
+        const bool parallelEvaluation = false,
+        const CovariancePolicyType& covariancePolicy = CovariancePolicyType(),
+        const bool warmStart = false);
 
   /**
    * Optimize the given function using CMA-ES. The given starting point will be
    * modified to store the finishing point of the algorithm, and the final
    * objective value is returned.
    *
+   * Any number of callbacks may be given after the iterate; an epoch of CMA-ES
+   * is one generation, every evaluated candidate is reported to Evaluate(),
+   * and a step is an update of the mean.
+   *
+   * With ParallelEvaluation(), the candidates of a generation are evaluated
+   * with several OpenMP threads, so the function (and the selection policy)
+   * must be safe to evaluate concurrently.  Each candidate is evaluated with
+   * its own random number stream, seeded from the main stream, so the result
+   * does not depend on the number of threads.  Callbacks are notified of the
+   * evaluations once the whole generation has been evaluated.
+   *
+   * If the function has an EvaluateBatch() method (see
+   * traits::HasBatchEvaluation) and the FullSelection policy is used, the whole
+   * generation is evaluated with a single call to it instead.
+   *
+   * The covariance matrix is only decomposed again after about
+   * 1 / (10 n (c1 + cmu)) generations, where n is the number of coordinates and
+   * c1 and cmu are the learning rates of the covariance matrix, so that the
+   * cost of the decomposition is amortized for large problems.
+   *
+   * With WarmStart(), the search distribution of the last call (its mean, step
+   * size, evolution paths and covariance matrix) is kept, and the next call
+   * continues with it instead of drawing a new mean between LowerBound() and
+   * UpperBound() and starting from the identity covariance matrix, as long as
+   * the iterate has the same size.
+   *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Start a new search distribution for coordinates of the given size, for the
+   * ask/tell interface.  As in Optimize(), the mean is drawn between
+   * LowerBound() and UpperBound(); it can be changed with Mean() before the
+   * first call to Ask().
+   *
+   * The ask/tell interface lets the caller evaluate the candidates however it
+   * likes (for instance on remote machines), and hand the objectives back
+   * later:
+   *
+   * @code
+   * CMAES<> cmaes(0, -1, 1);
+   * cmaes.Initialize(10, 1);
+   * for (size_t i = 0; i < 100; ++i)
+   * {
+   *   const arma::cube& candidates = cmaes.Ask();
+   *   arma::vec objectives(candidates.n_slices);
+   *   for (size_t j = 0; j < candidates.n_slices; ++j)
+   *     objectives[j] = f.Evaluate(candidates.slice(j));
+   *   cmaes.Tell(objectives);
+   * }
+   * // cmaes.Mean() is the estimate of the minimum.
+   * @endcode
+   *
+   * Optimize() is implemented with these methods.  If it is called after
+   * Initialize() and before any generation, it starts from the distribution
+   * of Initialize() (and the changes made to it with Mean() and Sigma()).
+   *
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   * @param newGenerator The random number stream of the search (by default a
+   *     new one).
+   */
+  void Initialize(const size_t rows,
+                  const size_t cols,
+                  const RandomGenerator& newGenerator = NewRandomGenerator());
+
+  /**
+   * Sample the candidates of the next generation from the search distribution.
+   * The objectives of all the candidates must be given to Tell() before the
+   * next call to Ask().
+   *
+   * @return The candidates, one per slice; the cube is valid until the next
+   *     call to Ask().
+   */
+  const arma::cube& Ask();
+
+  /**
+   * Update the search distribution with the objectives of the candidates of
+   * the last call to Ask().
+   *
+   * @param objectives The objective of each candidate, in the order of the
+   *     slices.
+   */
+  void Tell(const arma::vec& objectives);
+
+  //! Get the mean of the search distribution.
+  const arma::mat& Mean() const { return mean; }
+  //! Modify the mean of the search distribution.
+  arma::mat& Mean() { return mean; }
+
+  //! Get the step size of the search distribution.
+  double Sigma() const { return sigma; }
+  //! Modify the step size of the search distribution.
+  double& Sigma() { return sigma; }
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for an iterate
+   * of the given size (see ens::MemoryEstimate()): the steps, the candidates
+   * and the normal samples of the population (three n x lambda matrices), and
+   * the covariance matrix, which takes O(n^2) memory with FullCovariance and
+   * O(n) with DiagonalCovariance.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param numFunctions Ignored; the population does not depend on it.
+   */
+  size_t MemoryEstimate(const size_t rows,
+                        const size_t cols,
+                        const size_t numFunctions = 1) const;
+
+  //! Get the population size used when PopulationSize() is 0, for the given
+  //! number of coordinates.
+  static size_t DefaultPopulationSize(const size_t n)
+  {
+    return (4 + std::round(3 * std::log(n))) * 10;
+  }
+
+  //! Get the number of generations of the search distribution so far.
+  size_t Generation() const { return generation; }
 
   //! Get the step size.
   size_t PopulationSize() const { return lambda; }
@@ -125,6 +261,26 @@ class CMAES
   //! Modify the selection policy.
   SelectionPolicyType& SelectionPolicy() { return selectionPolicy; }
 
+  //! Get whether the candidates are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the candidates are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the covariance policy.
+  const CovariancePolicyType& CovariancePolicy() const
+  { return covariancePolicy; }
+  //! Modify the covariance policy.
+  CovariancePolicyType& CovariancePolicy() { return covariancePolicy; }
+
+  //! Get whether the search distribution is kept between calls to Optimize().
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether the search distribution is kept between calls to
+  //! Optimize().
+  bool& WarmStart() { return warmStart; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! Population size.
   size_t lambda;
@@ -146,6 +302,86 @@ class CMAES
 
   //! The selection policy used to calculate the objective.
   SelectionPolicyType selectionPolicy;
+
+  //! Whether to evaluate the candidates in parallel.
+  bool parallelEvaluation;
+
+  //! The covariance policy used to adapt the search distribution.
+  CovariancePolicyType covariancePolicy;
+
+  //! Whether to keep the search distribution between calls to Optimize().
+  bool warmStart;
+
+  //! The number of parents.
+  size_t mu;
+
+  //! The weights of the parents.
+  arma::vec weights;
+
+  //! The number of effective solutions.
+  double muEffective;
+
+  //! The step size control parameters.
+  double cs, ds, enn;
+
+  //! The covariance update parameters.
+  double cc, h, c1, cmu;
+
+  //! The number of generations between two decompositions of the covariance
+  //! matrix.
+  size_t decompositionGap;
+
+  //! The number of generations since the last decomposition.
+  size_t sinceDecomposition;
+
+  //! The mean of the search distribution.
+  arma::mat mean;
+
+  //! The step size of the search distribution.
+  double sigma;
+
+  //! The evolution path of the step size.
+  arma::mat ps;
+
+  //! The evolution path of the covariance matrix.
+  arma::mat pc;
+
+  //! The steps of the candidates of the current generation.
+  arma::cube pStep;
+
+  //! The candidates of the current generation.
+  arma::cube pPosition;
+
+  //! The order of the candidates by objective.
+  arma::uvec idx;
+
+  //! The objectives of the candidates of the current generation.
+  arma::vec pObjective;
+
+  //! Buffers for the update of the search distribution.
+  arma::mat step, psStep;
+
+  //! The standard normal samples of the population, one column per candidate.
+  arma::mat normal;
+
+  //! The weights of all the candidates for the step of the mean.
+  arma::vec populationWeights;
+
+  //! The number of generations of the search distribution so far.
+  size_t generation;
+
+  //! Whether the candidates of the last call to Ask() are waiting for Tell().
+  bool asked;
+
+  //! Whether Initialize() was called and the distribution has not been used
+  //! yet.
+  bool fresh;
+
+  //! The random number stream of the search.
+  RandomGenerator generator;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 /**
@@ -154,6 +390,12 @@ class CMAES
 template<typename SelectionPolicyType = RandomSelection>
 using ApproxCMAES = CMAES<SelectionPolicyType>;
 
+/**
+ * Convenient typedef for CMAES with a diagonal covariance matrix (sep-CMA-ES).
+ */
+template<typename SelectionPolicyType = FullSelection>
+using SepCMAES = CMAES<SelectionPolicyType, DiagonalCovariance>;
+
 } // namespace ens
 
 // Include implementation.
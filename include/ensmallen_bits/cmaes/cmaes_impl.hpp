@@ -19,32 +19,75 @@
 #include "cmaes.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 
 namespace ens {
 
-template<typename SelectionPolicyType>
-CMAES<SelectionPolicyType>::CMAES(const size_t lambda,
-                                  const double lowerBound,
-                                  const double upperBound,
-                                  const size_t batchSize,
-                                  const size_t maxIterations,
-                                  const double tolerance,
-                                  const SelectionPolicyType& selectionPolicy) :
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+CMAES<SelectionPolicyType, CovariancePolicyType>::CMAES(
+    const size_t lambda,
+    const double lowerBound,
+    const double upperBound,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const SelectionPolicyType& selectionPolicy,
+    const bool parallelEvaluation,
+    const CovariancePolicyType& covariancePolicy,
+    const bool warmStart) :
     lambda(lambda),
     lowerBound(lowerBound),
     upperBound(upperBound),
     batchSize(batchSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    selectionPolicy(selectionPolicy)
+    selectionPolicy(selectionPolicy),
+    parallelEvaluation(parallelEvaluation),
+    covariancePolicy(covariancePolicy),
+    warmStart(warmStart),
+    mu(0),
+    muEffective(0),
+    cs(0),
+    ds(0),
+    enn(0),
+    cc(0),
+    h(0),
+    c1(0),
+    cmu(0),
+    decompositionGap(1),
+    sinceDecomposition(0),
+    sigma(0),
+    generation(0),
+    asked(false),
+    fresh(false)
 { /* Nothing to do. */ }
 
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+size_t CMAES<SelectionPolicyType, CovariancePolicyType>::MemoryEstimate(
+    const size_t rows,
+    const size_t cols,
+    const size_t /* numFunctions */) const
+{
+  const size_t n = rows * cols;
+  const size_t populationSize = (lambda == 0) ? DefaultPopulationSize(n) :
+      lambda;
+
+  // The population, the mean, the evolution paths and the step buffers, and
+  // the vectors of the objectives, the order and the weights.
+  return (3 * n * populationSize + 5 * n + 4 * populationSize) *
+      sizeof(double) + covariancePolicy.MemoryEstimate(n, populationSize);
+}
+
 //! Optimize the function (minimize).
-template<typename SelectionPolicyType>
-template<typename DecomposableFunctionType>
-double CMAES<SelectionPolicyType>::Optimize(
-    DecomposableFunctionType& function, arma::mat& iterate)
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double CMAES<SelectionPolicyType, CovariancePolicyType>::Optimize(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   // Make sure that we have the methods that we need.  Long name...
   traits::CheckNonDifferentiableDecomposableFunctionTypeAPI<
       DecomposableFunctionType>();
@@ -52,233 +95,330 @@ double CMAES<SelectionPolicyType>::Optimize(
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
-  // Population size.
-  if (lambda == 0)
-    lambda = (4 + std::round(3 * std::log(iterate.n_elem))) * 10;
-
-  // Parent weights.
-  const size_t mu = std::round(lambda / 2);
-  arma::vec w = std::log(mu + 0.5) - arma::log(
-    arma::linspace<arma::vec>(0, mu - 1, mu) + 1.0);
-  w /= arma::sum(w);
-
-  // Number of effective solutions.
-  const double muEffective = 1 / arma::accu(arma::pow(w, 2));
-
-  // Step size control parameters.
-  arma::vec sigma(3);
-  sigma(0) = 0.3 * (upperBound - lowerBound);
-  const double cs = (muEffective + 2) / (iterate.n_elem + muEffective + 5);
-  const double ds = 1 + cs + 2 * std::max(std::sqrt((muEffective - 1) /
-      (iterate.n_elem + 1)) - 1, 0.0);
-  const double enn = std::sqrt(iterate.n_elem) * (1.0 - 1.0 /
-      (4.0 * iterate.n_elem) + 1.0 / (21 * std::pow(iterate.n_elem, 2)));
-
-  // Covariance update parameters.
-  // Cumulation for distribution.
-  const double cc = (4 + muEffective / iterate.n_elem) /
-      (4 + iterate.n_elem + 2 * muEffective / iterate.n_elem);
-  const double h = (1.4 + 2.0 / (iterate.n_elem + 1.0)) * enn;
-
-  const double c1 = 2 / (std::pow(iterate.n_elem + 1.3, 2) + muEffective);
-  const double alphaMu = 2;
-  const double cmu = std::min(1 - c1, alphaMu * (muEffective - 2 + 1 /
-      muEffective) / (std::pow(iterate.n_elem + 2, 2) +
-      alphaMu * muEffective / 2));
-
-  arma::cube mPosition(iterate.n_rows, iterate.n_cols, 3);
-  mPosition.slice(0) = lowerBound + arma::randu(
-      iterate.n_rows, iterate.n_cols) * (upperBound - lowerBound);
+  // Start from the distribution of the last call to Initialize() if it has
+  // not been used yet, or continue with the search distribution of the last
+  // call if warm starting, as long as it fits the iterate; otherwise start a
+  // new one.  Either way, all the random numbers of this optimization come
+  // from its own stream.
+  const bool fits = mean.n_rows == iterate.n_rows &&
+      mean.n_cols == iterate.n_cols &&
+      (lambda == 0 || pPosition.n_slices == lambda);
+  const bool warm = warmStart && generation > 0 && fits;
+  if (fresh && generation == 0 && fits)
+  {
+    // Nothing to do.
+  }
+  else if (warm)
+  {
+    generator = NewRandomGenerator();
+    sinceDecomposition = decompositionGap;
+    asked = false;
+  }
+  else
+  {
+    Initialize(iterate.n_rows, iterate.n_cols);
+  }
+  fresh = false;
+  RandomScope randomScope(generator);
 
-  arma::mat step = arma::zeros(iterate.n_rows, iterate.n_cols);
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
 
   // Calculate the first objective function.
   double currentObjective = 0;
   for (size_t f = 0; f < numFunctions; f += batchSize)
   {
     const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-    currentObjective += function.Evaluate(mPosition.slice(0), f,
-        effectiveBatchSize);
+    currentObjective += function.Evaluate(mean, f, effectiveBatchSize);
   }
 
   double overallObjective = currentObjective;
   double lastObjective = DBL_MAX;
 
-  // Population parameters.
-  arma::cube pStep(iterate.n_rows, iterate.n_cols, lambda);
-  arma::cube pPosition(iterate.n_rows, iterate.n_cols, lambda);
-  arma::vec pObjective(lambda);
-  arma::cube ps = arma::zeros(iterate.n_rows, iterate.n_cols, 2);
-  arma::cube pc = ps;
-  arma::cube C(iterate.n_elem, iterate.n_elem, 2);
-  C.slice(0).eye();
+  terminate |= Callback::Evaluate(*this, function, mean, currentObjective,
+      callbacks...);
 
-  // Covariance matrix parameters.
-  arma::vec eigval;
-  arma::mat eigvec;
-  arma::vec eigvalZero = arma::zeros(iterate.n_elem);
+  // The objectives of the candidates of a generation.
+  pObjective.set_size(lambda);
 
-  // The current visitation order (sorted by population objectives).
-  arma::uvec idx = arma::linspace<arma::uvec>(0, lambda - 1, lambda);
+  // The whole population can be evaluated at once if the function supports it
+  // and the objective is computed over all the separable functions.
+  const bool batchEvaluation =
+      traits::HasBatchEvaluation<DecomposableFunctionType>::value &&
+      std::is_same<SelectionPolicyType, FullSelection>::value;
 
   // Now iterate!
-  for (size_t i = 1; i < maxIterations; ++i)
+  for (size_t i = 1; i < maxIterations && !terminate; ++i)
   {
-    // To keep track of where we are.
-    const size_t idx0 = (i - 1) % 2;
-    const size_t idx1 = i % 2;
+    terminate |= Callback::BeginEpoch(*this, function, iterate, i,
+        overallObjective, callbacks...);
+    if (terminate)
+      break;
 
-    const arma::mat covLower = arma::chol(C.slice(idx0), "lower");
+    const arma::cube& candidates = Ask();
 
-    for (size_t j = 0; j < lambda; ++j)
+    if (batchEvaluation)
     {
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        pStep.slice(idx(j)) = covLower *
-            arma::randn(iterate.n_rows, iterate.n_cols);
-      }
-      else
-      {
-        pStep.slice(idx(j)) = arma::randn(iterate.n_rows, iterate.n_cols) *
-            covLower;
-      }
-
-      pPosition.slice(idx(j)) = mPosition.slice(idx0) + sigma(idx0) *
-          pStep.slice(idx(j));
-
-      // Calculate the objective function.
-      pObjective(idx(j)) = selectionPolicy.Select(function, batchSize,
-          pPosition.slice(idx(j)));
+      TryEvaluateBatch(function, candidates, pObjective);
     }
-
-    // Sort population.
-    idx = sort_index(pObjective);
-
-    step = w(0) * pStep.slice(idx(0));
-    for (size_t j = 1; j < mu; ++j)
-      step += w(j) * pStep.slice(idx(j));
-
-    mPosition.slice(idx1) = mPosition.slice(idx0) + sigma(idx0) * step;
-
-    // Calculate the objective function.
-    currentObjective = selectionPolicy.Select(function, batchSize,
-          mPosition.slice(idx1));
-
-    // Update best parameters.
-    if (currentObjective < overallObjective)
-    {
-      overallObjective = currentObjective;
-      iterate = mPosition.slice(idx1);
-    }
-
-    // Update Step Size.
-    if (iterate.n_rows > iterate.n_cols)
-    {
-      ps.slice(idx1) = (1 - cs) * ps.slice(idx0) + std::sqrt(
-          cs * (2 - cs) * muEffective) * covLower.t() * step;
-    }
-    else
+    else if (parallelEvaluation)
     {
-      ps.slice(idx1) = (1 - cs) * ps.slice(idx0) + std::sqrt(
-          cs * (2 - cs) * muEffective) * step * covLower.t();
-    }
-
-    const double psNorm = arma::norm(ps.slice(idx1));
-    sigma(idx1) = sigma(idx0) * std::pow(
-        std::exp(cs / ds * psNorm / enn - 1), 0.3);
+      // The candidates are sampled with the stream of the optimization, and
+      // every candidate is evaluated with its own stream of a new seed, so the
+      // result does not depend on the number of threads.
+      const uint64_t seed = generator.Next64();
 
-    // Update covariance matrix.
-    if ((psNorm / sqrt(1 - std::pow(1 - cs, 2 * i))) < h)
-    {
-      pc.slice(idx1) = (1 - cc) * pc.slice(idx0) + std::sqrt(cc * (2 - cc) *
-        muEffective) * step;
-
-
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-          (pc.slice(idx1) * pc.slice(idx1).t());
-      }
-      else
+      ENS_PRAGMA_OMP_PARALLEL
       {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-          (pc.slice(idx1).t() * pc.slice(idx1));
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        for (size_t j = threadId; j < lambda; j += numThreads)
+        {
+          RandomGenerator candidateGenerator(seed, j);
+          RandomScope candidateScope(candidateGenerator);
+          pObjective(j) = selectionPolicy.Select(function, batchSize,
+              candidates.slice(j));
+        }
       }
     }
     else
     {
-      pc.slice(idx1) = (1 - cc) * pc.slice(idx0);
-
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 * (pc.slice(idx1) *
-            pc.slice(idx1).t() + (cc * (2 - cc)) * C.slice(idx0));
-      }
-      else
+      for (size_t j = 0; j < lambda; ++j)
       {
-        C.slice(idx1) = (1 - c1 - cmu) * C.slice(idx0) + c1 *
-            (pc.slice(idx1).t() * pc.slice(idx1) + (cc * (2 - cc)) *
-            C.slice(idx0));
+        // Calculate the objective function.
+        pObjective(j) = selectionPolicy.Select(function, batchSize,
+            candidates.slice(j));
       }
     }
 
-    if (iterate.n_rows > iterate.n_cols)
+    for (size_t j = 0; j < lambda; ++j)
     {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C.slice(idx1) = C.slice(idx1) + cmu * w(j) *
-            pStep.slice(idx(j)) * pStep.slice(idx(j)).t();
-      }
-    }
-    else
-    {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C.slice(idx1) = C.slice(idx1) + cmu * w(j) *
-            pStep.slice(idx(j)).t() * pStep.slice(idx(j));
-      }
+      terminate |= Callback::Evaluate(*this, function, candidates.slice(j),
+          pObjective(j), callbacks...);
     }
 
-    arma::eig_sym(eigval, eigvec, C.slice(idx1));
-    const arma::uvec negativeEigval = find(eigval < 0, 1);
-    if (!negativeEigval.is_empty())
+    Tell(pObjective);
+
+    // Calculate the objective function.
+    currentObjective = selectionPolicy.Select(function, batchSize, mean);
+
+    terminate |= Callback::Evaluate(*this, function, mean, currentObjective,
+        callbacks...);
+
+    // Update best parameters.
+    if (currentObjective < overallObjective)
     {
-      if (negativeEigval(0) == 0)
-      {
-        C.slice(idx1).zeros();
-      }
-      else
-      {
-        C.slice(idx1) = eigvec.cols(0, negativeEigval(0) - 1) *
-            arma::diagmat(eigval.subvec(0, negativeEigval(0) - 1)) *
-            eigvec.cols(0, negativeEigval(0) - 1).t();
-      }
+      overallObjective = currentObjective;
+      iterate = mean;
     }
 
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
     // Output current objective function.
-    Info << "CMA-ES: iteration " << i << ", objective " << overallObjective
+    ENS_INFO << "CMA-ES: iteration " << i << ", objective " << overallObjective
         << "." << std::endl;
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
-      Warn << "CMA-ES: converged to " << overallObjective << "; "
+      ENS_WARN << "CMA-ES: converged to " << overallObjective << "; "
           << "terminating with failure.  Try a smaller step size?" << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
     if (std::abs(lastObjective - overallObjective) < tolerance)
     {
-      Info << "CMA-ES: minimized within tolerance " << tolerance << "; "
+      ENS_INFO << "CMA-ES: minimized within tolerance " << tolerance << "; "
           << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
     lastObjective = overallObjective;
+
+    terminate |= Callback::EndEpoch(*this, function, iterate, i,
+        overallObjective, callbacks...);
   }
 
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return overallObjective;
 }
 
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::Initialize(
+    const size_t rows,
+    const size_t cols,
+    const RandomGenerator& newGenerator)
+{
+  const size_t n = rows * cols;
+
+  // Population size.
+  if (lambda == 0)
+    lambda = DefaultPopulationSize(n);
+
+  // Parent weights.
+  mu = std::round(lambda / 2);
+  weights.set_size(mu);
+  for (size_t j = 0; j < mu; ++j)
+    weights(j) = std::log(mu + 0.5) - std::log(j + 1.0);
+  weights /= arma::accu(weights);
+
+  // Number of effective solutions.
+  muEffective = 1 / arma::dot(weights, weights);
+
+  // Step size control parameters.
+  cs = (muEffective + 2) / (n + muEffective + 5);
+  ds = 1 + cs + 2 * std::max(std::sqrt((muEffective - 1) / (n + 1)) - 1,
+      0.0);
+  enn = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 /
+      (21 * std::pow(n, 2)));
+
+  // Covariance update parameters.
+  // Cumulation for distribution.
+  cc = (4 + muEffective / n) / (4 + n + 2 * muEffective / n);
+  h = (1.4 + 2.0 / (n + 1.0)) * enn;
+
+  const double covScale = covariancePolicy.LearningRateScale(n);
+  c1 = std::min(1.0, covScale * 2 / (std::pow(n + 1.3, 2) + muEffective));
+  const double alphaMu = 2;
+  cmu = std::min(1 - c1, covScale * alphaMu * (muEffective - 2 +
+      1 / muEffective) / (std::pow(n + 2, 2) + alphaMu * muEffective / 2));
+
+  // The covariance matrix changes slowly, so it is only decomposed again after
+  // about 1 / (10 n (c1 + cmu)) generations.
+  decompositionGap = std::max(1.0, std::floor(1.0 / (10.0 * n * (c1 + cmu))));
+  sinceDecomposition = decompositionGap;
+
+  // All the random numbers of the search come from its own stream.
+  generator = newGenerator;
+
+  mean.set_size(rows, cols);
+  generator.Randu(mean);
+  mean = lowerBound + mean * (upperBound - lowerBound);
+  sigma = 0.3 * (upperBound - lowerBound);
+
+  ps.zeros(rows, cols);
+  pc.zeros(rows, cols);
+  covariancePolicy.Initialize(mean);
+
+  pStep.set_size(rows, cols, lambda);
+  pPosition.set_size(rows, cols, lambda);
+  step.set_size(rows, cols);
+  normal.set_size(n, lambda);
+
+  generation = 0;
+  asked = false;
+  fresh = true;
+}
+
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+const arma::cube& CMAES<SelectionPolicyType, CovariancePolicyType>::Ask()
+{
+  if (mean.n_elem == 0)
+  {
+    throw std::logic_error("CMAES::Ask(): the search distribution has not "
+        "been initialized");
+  }
+
+  if (sinceDecomposition >= decompositionGap)
+  {
+    covariancePolicy.Decompose();
+    sinceDecomposition = 0;
+  }
+
+  // The slices of a cube are contiguous, so the population is sampled as n x
+  // lambda matrices that share the memory of the cubes.  The random numbers
+  // are drawn in the same order as candidate by candidate.
+  const size_t n = mean.n_elem;
+  arma::mat steps(pStep.memptr(), n, lambda, false, true);
+  arma::mat positions(pPosition.memptr(), n, lambda, false, true);
+  const arma::vec meanVec(mean.memptr(), n, false, true);
+
+  generator.Randn(normal);
+  covariancePolicy.Transform(normal, steps);
+  positions = sigma * steps;
+  positions.each_col() += meanVec;
+
+  asked = true;
+  return pPosition;
+}
+
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::Tell(
+    const arma::vec& objectives)
+{
+  if (!asked)
+  {
+    throw std::logic_error("CMAES::Tell(): Ask() has not been called since "
+        "the last call to Tell()");
+  }
+
+  if (objectives.n_elem != lambda)
+  {
+    throw std::invalid_argument("CMAES::Tell(): the number of objectives "
+        "does not match the population size");
+  }
+
+  asked = false;
+  ++generation;
+  ++sinceDecomposition;
+
+  // Sort population.  The order is sorted in place, so that it keeps its
+  // memory, and ties are broken by the index of the candidate.
+  // arma::sort_index() is still used to report NaN objectives.
+  if (objectives.has_nan())
+  {
+    idx = arma::sort_index(objectives);
+  }
+  else
+  {
+    idx.set_size(lambda);
+    for (size_t j = 0; j < lambda; ++j)
+      idx(j) = j;
+    std::sort(idx.begin(), idx.end(),
+        [&objectives](const arma::uword a, const arma::uword b)
+        {
+          return objectives(a) < objectives(b) ||
+              (objectives(a) == objectives(b) && a < b);
+        });
+  }
+
+  // The weighted mean of the best steps is a single product with the weights
+  // of the whole population (zero for the candidates that are not selected).
+  const size_t n = mean.n_elem;
+  populationWeights.zeros(lambda);
+  for (size_t j = 0; j < mu; ++j)
+    populationWeights(idx(j)) = weights(j);
+
+  const arma::mat steps(pStep.memptr(), n, lambda, false, true);
+  arma::vec stepVec(step.memptr(), n, false, true);
+  stepVec = steps * populationWeights;
+
+  mean += sigma * step;
+
+  // Update Step Size.
+  covariancePolicy.TransposeTransform(step, psStep);
+  ps = (1 - cs) * ps + std::sqrt(cs * (2 - cs) * muEffective) * psStep;
+
+  const double psNorm = arma::norm(ps);
+  sigma *= std::pow(std::exp(cs / ds * psNorm / enn - 1), 0.3);
+
+  // Update covariance matrix.
+  const bool stalled = (psNorm / sqrt(1 - std::pow(1 - cs,
+      2 * generation))) >= h;
+  if (!stalled)
+    pc = (1 - cc) * pc + std::sqrt(cc * (2 - cc) * muEffective) * step;
+  else
+    pc *= (1 - cc);
+
+  covariancePolicy.Update(pc, stalled, c1, cmu, cc, pStep, idx, weights);
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,150 @@
+/**
+ * @file diagonal_covariance.hpp
+ * @author Marcus Edel
+ *
+ * Adapt only the diagonal of the covariance matrix of the search distribution
+ * of CMA-ES (sep-CMA-ES).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt only the diagonal of the covariance matrix of the search distribution,
+ * so that each generation costs O(n) time and memory (besides the evaluation of
+ * the candidates), where n is the number of coordinates.  Since a diagonal
+ * matrix has fewer degrees of freedom, the learning rates of the covariance
+ * matrix are increased by a factor of (n + 2) / 3.  This works well for
+ * high-dimensional problems whose coordinates are not strongly correlated.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{Ros2008,
+ *   author    = {Ros, Raymond and Hansen, Nikolaus},
+ *   title     = {A Simple Modification in CMA-ES Achieving Linear Time and
+ *                Space Complexity},
+ *   booktitle = {Parallel Problem Solving from Nature -- PPSN X},
+ *   pages     = {296--305},
+ *   year      = {2008}
+ * }
+ * @endcode
+ */
+class DiagonalCovariance
+{
+ public:
+  /**
+   * Get the factor by which the learning rates of the covariance matrix are
+   * scaled.
+   *
+   * @param n Number of coordinates.
+   */
+  double LearningRateScale(const size_t n) const { return (n + 2.0) / 3.0; }
+
+  /**
+   * Reset the diagonal of the covariance matrix to ones.
+   *
+   * @param iterate Starting point of the optimization.
+   */
+  void Initialize(const arma::mat& iterate)
+  {
+    c.ones(iterate.n_rows, iterate.n_cols);
+  }
+
+  /**
+   * Compute the square root of the diagonal of the covariance matrix that is
+   * used by Transform() and TransposeTransform().
+   */
+  void Decompose()
+  {
+    cSqrt = arma::sqrt(c);
+  }
+
+  /**
+   * Transform standard normal samples into samples of the search distribution.
+   * Each column holds one sample, with the coordinates in the order of the
+   * elements of the iterate.
+   *
+   * @param z Standard normal samples.
+   * @param steps Samples of the search distribution.
+   */
+  void Transform(const arma::mat& z, arma::mat& steps) const
+  {
+    steps = z.each_col() % arma::vectorise(cSqrt);
+  }
+
+  /**
+   * Transform a step with the transpose of the factor of the covariance
+   * matrix, for the update of the step size.
+   *
+   * @param step Step of the mean.
+   * @param result Transformed step.
+   */
+  void TransposeTransform(const arma::mat& step, arma::mat& result) const
+  {
+    result = cSqrt % step;
+  }
+
+  /**
+   * Update the diagonal of the covariance matrix with the evolution path
+   * (rank-one update) and the best steps of the generation (rank-mu update).
+   *
+   * @param pc Evolution path.
+   * @param stalled Whether the update of the evolution path was stalled.
+   * @param c1 Learning rate of the rank-one update.
+   * @param cmu Learning rate of the rank-mu update.
+   * @param cc Learning rate of the evolution path.
+   * @param pStep Steps of the population.
+   * @param idx Indices of the population, sorted by objective.
+   * @param w Weights of the best steps.
+   */
+  void Update(const arma::mat& pc,
+              const bool stalled,
+              const double c1,
+              const double cmu,
+              const double cc,
+              const arma::cube& pStep,
+              const arma::uvec& idx,
+              const arma::vec& w)
+  {
+    if (!stalled)
+      c = (1 - c1 - cmu) * c + c1 * arma::square(pc);
+    else
+      c = (1 - c1 - cmu) * c + c1 * (arma::square(pc) + (cc * (2 - cc)) * c);
+
+    for (size_t j = 0; j < w.n_elem; ++j)
+      c += cmu * w(j) * arma::square(pStep.slice(idx(j)));
+  }
+
+  //! Get the diagonal of the covariance matrix, in the shape of the iterate.
+  const arma::mat& Covariance() const { return c; }
+
+  /**
+   * Estimate the number of bytes taken by the diagonal, its square root, and
+   * the temporary of the transformation of the population.
+   *
+   * @param n Number of coordinates.
+   * @param lambda Population size.
+   */
+  size_t MemoryEstimate(const size_t n, const size_t lambda) const
+  {
+    return (2 * n + n * lambda) * sizeof(double);
+  }
+
+ private:
+  //! The diagonal of the covariance matrix.
+  arma::mat c;
+
+  //! The square root of the diagonal of the covariance matrix.
+  arma::mat cSqrt;
+};
+
+} // namespace ens
+
+#endif
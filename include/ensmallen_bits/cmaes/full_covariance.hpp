@@ -0,0 +1,179 @@
+/**
+ * @file full_covariance.hpp
+ * @author Marcus Edel
+ *
+ * Adapt the full covariance matrix of the search distribution of CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt the full covariance matrix of the search distribution.  The matrix
+ * takes O(n^2) memory, where n is the number of coordinates; each update costs
+ * O(n^2) time per selected candidate, and each decomposition O(n^3) time.  The
+ * population is sampled with one matrix product, and the rank-one and rank-mu
+ * updates are a single symmetric rank-k product, so that both run as BLAS-3
+ * operations.
+ */
+class FullCovariance
+{
+ public:
+  /**
+   * Get the factor by which the learning rates of the covariance matrix are
+   * scaled.
+   *
+   * @param n Number of coordinates.
+   */
+  double LearningRateScale(const size_t /* n */) const { return 1.0; }
+
+  /**
+   * Reset the covariance matrix to the identity.
+   *
+   * @param iterate Starting point of the optimization.
+   */
+  void Initialize(const arma::mat& iterate)
+  {
+    C.eye(iterate.n_elem, iterate.n_elem);
+  }
+
+  /**
+   * Compute the factor B * D^(1/2) of the covariance matrix from its
+   * eigendecomposition C = B * D * B^T, which is used by Transform() and
+   * TransposeTransform().  Negative eigenvalues caused by numerical errors are
+   * clipped to zero.
+   */
+  void Decompose()
+  {
+    ENS_TRACE_ZONE("Decompose");
+    arma::eig_sym(eigval, eigvec, C);
+
+    // The columns are scaled in place, so that the factor keeps its memory.
+    factor = eigvec;
+    for (size_t k = 0; k < eigval.n_elem; ++k)
+    {
+      eigval(k) = std::max(eigval(k), 0.0);
+      factor.col(k) *= std::sqrt(eigval(k));
+    }
+  }
+
+  /**
+   * Transform standard normal samples into samples of the search distribution.
+   * Each column holds one sample, with the coordinates in the order of the
+   * elements of the iterate.
+   *
+   * @param z Standard normal samples.
+   * @param steps Samples of the search distribution.
+   */
+  void Transform(const arma::mat& z, arma::mat& steps) const
+  {
+    steps = factor * z;
+  }
+
+  /**
+   * Transform a step with the transpose of the factor of the covariance
+   * matrix, for the update of the step size.
+   *
+   * @param step Step of the mean.
+   * @param result Transformed step.
+   */
+  void TransposeTransform(const arma::mat& step, arma::mat& result) const
+  {
+    if (step.n_rows > step.n_cols)
+      result = factor.t() * step;
+    else
+      result = step * factor;
+  }
+
+  /**
+   * Update the covariance matrix with the evolution path (rank-one update) and
+   * the best steps of the generation (rank-mu update).
+   *
+   * @param pc Evolution path.
+   * @param stalled Whether the update of the evolution path was stalled.
+   * @param c1 Learning rate of the rank-one update.
+   * @param cmu Learning rate of the rank-mu update.
+   * @param cc Learning rate of the evolution path.
+   * @param pStep Steps of the population.
+   * @param idx Indices of the population, sorted by objective.
+   * @param w Weights of the best steps.
+   */
+  void Update(const arma::mat& pc,
+              const bool stalled,
+              const double c1,
+              const double cmu,
+              const double cc,
+              const arma::cube& pStep,
+              const arma::uvec& idx,
+              const arma::vec& w)
+  {
+    if (!stalled)
+      C *= (1 - c1 - cmu);
+    else
+      C *= (1 - c1 - cmu + c1 * cc * (2 - cc));
+
+    // The evolution path and the best steps, scaled by the square roots of
+    // their learning rates, are the columns of Y, so that both updates are
+    // the single product Y * Y^T (which Armadillo computes with syrk).
+    const size_t n = C.n_rows;
+    scaledSteps.set_size(n, w.n_elem + 1);
+    ScaleColumn(std::sqrt(c1), pc.memptr(), scaledSteps.colptr(0));
+    for (size_t j = 0; j < w.n_elem; ++j)
+    {
+      ScaleColumn(std::sqrt(cmu * w(j)), pStep.slice_memptr(idx(j)),
+          scaledSteps.colptr(j + 1));
+    }
+
+    C += scaledSteps * scaledSteps.t();
+  }
+
+  //! Get the covariance matrix.
+  const arma::mat& Covariance() const { return C; }
+
+  /**
+   * Estimate the number of bytes taken by the covariance matrix, its factor,
+   * its eigendecomposition (and the workspace of the decomposition), and the
+   * scaled steps of the update.
+   *
+   * @param n Number of coordinates.
+   * @param lambda Population size.
+   */
+  size_t MemoryEstimate(const size_t n, const size_t lambda) const
+  {
+    return (4 * n * n + n * (lambda / 2 + 2)) * sizeof(double);
+  }
+
+ private:
+  //! Store alpha * v in the given column, where v has as many elements as C
+  //! has rows.
+  void ScaleColumn(const double alpha, const double* v, double* column) const
+  {
+    for (size_t i = 0; i < C.n_rows; ++i)
+      column[i] = alpha * v[i];
+  }
+
+  //! The covariance matrix.
+  arma::mat C;
+
+  //! The factor of the covariance matrix computed by Decompose().
+  arma::mat factor;
+
+  //! The eigenvalues of the covariance matrix.
+  arma::vec eigval;
+
+  //! The eigenvectors of the covariance matrix.
+  arma::mat eigvec;
+
+  //! The scaled evolution path and best steps of the last update.
+  arma::mat scaledSteps;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file importance_selection.hpp
+ * @author Marcus Edel
+ *
+ * Select dataset points by importance sampling for use in the Evaluation step.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_IMPORTANCE_SELECTION_HPP
+#define ENSMALLEN_CMAES_IMPORTANCE_SELECTION_HPP
+
+#include <ensmallen_bits/utility/importance_sampler.hpp>
+
+namespace ens {
+
+/*
+ * Select dataset points by importance sampling for use in the Evaluation step.
+ * As with RandomSelection, a fraction of the points is evaluated, but each
+ * point i is drawn with probability p_i from an ImportanceSampler and weighted
+ * by 1 / (n p_i), so that the estimate has the expectation of RandomSelection
+ * with a lower variance.  The probabilities are proportional to the given
+ * weights, or, if none are given (or adaptive is set), to the absolute value
+ * of the last objective of each point.  The adaptive weights change with each
+ * evaluation, so they must not be used with the parallelEvaluation option of
+ * CMAES.
+ */
+class ImportanceSelection
+{
+ public:
+  /**
+   * Constructor for the importance selection strategy, with weights adapted to
+   * the recent objectives.
+   *
+   * @param fraction The dataset fraction used for the selection (Default 0.3).
+   * @param uniformity Fraction of the probability spread uniformly.
+   */
+  ImportanceSelection(const double fraction = 0.3,
+                      const double uniformity = 0.1) :
+      fraction(fraction),
+      sampler(0, uniformity),
+      adaptive(true)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Constructor for the importance selection strategy, with the given weights.
+   *
+   * @param fraction The dataset fraction used for the selection.
+   * @param weights Weight of each point.
+   * @param uniformity Fraction of the probability spread uniformly.
+   * @param adaptive If true, the weights are replaced by the recent
+   *     objectives.
+   */
+  ImportanceSelection(const double fraction,
+                      const arma::vec& weights,
+                      const double uniformity = 0.1,
+                      const bool adaptive = false) :
+      fraction(fraction),
+      sampler(0, uniformity),
+      adaptive(adaptive)
+  {
+    sampler.Reset(weights);
+  }
+
+  //! Get the dataset fraction.
+  double Fraction() const { return fraction; }
+  //! Modify the dataset fraction.
+  double& Fraction() { return fraction; }
+
+  //! Get whether the weights are replaced by the recent objectives.
+  bool Adaptive() const { return adaptive; }
+  //! Modify whether the weights are replaced by the recent objectives.
+  bool& Adaptive() { return adaptive; }
+
+  //! Get the sampler of the points.
+  const ImportanceSampler& Sampler() const { return sampler; }
+  //! Modify the sampler of the points.
+  ImportanceSampler& Sampler() { return sampler; }
+
+  /**
+   * Select dataset points by importance sampling to estimate the objective
+   * function.  If the number of points differs from the number of weights,
+   * the weights are reset to be equal.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be evaluated.
+   * @param function Function to optimize.
+   * @param batchSize Batch size to use for each step (unused; the points are
+   *     evaluated one at a time).
+   * @param iterate starting point.
+   */
+  template<typename DecomposableFunctionType>
+  double Select(DecomposableFunctionType& function,
+                const size_t /* batchSize */,
+                const arma::mat& iterate)
+  {
+    // Find the number of functions to use.
+    const size_t numFunctions = function.NumFunctions();
+    if (sampler.Size() != numFunctions)
+      sampler.Reset(numFunctions);
+
+    const size_t points = std::max((size_t) std::floor(numFunctions *
+        fraction), (size_t) 1);
+
+    double objective = 0;
+    for (size_t k = 0; k < points; ++k)
+    {
+      const size_t i = sampler.Sample();
+      const double weight = 1.0 / (numFunctions * sampler.Probability(i));
+      const double pointObjective = function.Evaluate(iterate, i, 1);
+      objective += weight * pointObjective;
+
+      if (adaptive)
+        sampler.Update(i, std::abs(pointObjective));
+    }
+
+    return objective;
+  }
+
+ private:
+  //! Dataset fraction parameter.
+  double fraction;
+
+  //! The sampler of the points.
+  ImportanceSampler sampler;
+
+  //! Whether the weights are replaced by the recent objectives.
+  bool adaptive;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file ipop_cmaes.hpp
+ * @author Marcus Edel
+ *
+ * Definition of the IPOP and BIPOP restart strategies for CMA-ES, as proposed
+ * by A. Auger and N. Hansen in "A Restart CMA Evolution Strategy With
+ * Increasing Population Size" and by N. Hansen in "Benchmarking a BI-Population
+ * CMA-ES on the BBOB-2009 Function Testbed".
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_IPOP_CMAES_HPP
+#define ENSMALLEN_CMAES_IPOP_CMAES_HPP
+
+#include "cmaes.hpp"
+
+namespace ens {
+
+/**
+ * IPOP-CMA-ES runs CMA-ES several times from new random means, multiplying the
+ * population size by a given factor at every restart, and keeps the best
+ * result; larger populations search more globally, which helps on multi-modal
+ * functions.  BIPOP-CMA-ES interleaves these restarts with restarts of small
+ * random populations and step sizes, each with a smaller budget of evaluations,
+ * so that the total budget of the small restarts follows that of the large
+ * ones.
+ *
+ * The schedule of the restarts (their population sizes, step sizes and budgets)
+ * is planned up front from the budgets of evaluations they are given, and each
+ * restart has its own random number stream, so the restarts are independent
+ * and can be run at the same time on several OpenMP threads.  The result does
+ * not depend on the number of threads.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Auger2005,
+ *   author    = {Auger, Anne and Hansen, Nikolaus},
+ *   title     = {A Restart {CMA} Evolution Strategy With Increasing Population
+ *                Size},
+ *   booktitle = {Proceedings of the IEEE Congress on Evolutionary
+ *                Computation},
+ *   pages     = {1769--1776},
+ *   year      = {2005}
+ * }
+ *
+ * @inproceedings{Hansen2009,
+ *   author    = {Hansen, Nikolaus},
+ *   title     = {Benchmarking a {BI}-Population {CMA-ES} on the {BBOB}-2009
+ *                Function Testbed},
+ *   booktitle = {Proceedings of the 11th Annual Conference Companion on
+ *                Genetic and Evolutionary Computation Conference},
+ *   pages     = {2389--2396},
+ *   year      = {2009}
+ * }
+ * @endcode
+ *
+ * IPOPCMAES can optimize separable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ *
+ * @tparam SelectionPolicyType The selection strategy used for the evaluation
+ *     step.
+ * @tparam CovariancePolicyType The representation of the covariance matrix of
+ *     the search distribution.
+ */
+template<typename SelectionPolicyType = FullSelection,
+         typename CovariancePolicyType = FullCovariance>
+class IPOPCMAES
+{
+ public:
+  //! The type of the optimizer of each restart.
+  typedef CMAES<SelectionPolicyType, CovariancePolicyType> CMAESType;
+
+  /**
+   * Construct the IPOP-CMA-ES optimizer.  The given CMA-ES optimizer holds the
+   * parameters of the first restart; its population size (or the default one,
+   * if it is 0) is multiplied by populationFactor at every restart of a large
+   * population.
+   *
+   * @param cmaes The CMA-ES optimizer to restart.
+   * @param populationFactor The factor the population size is multiplied by
+   *     at every restart.
+   * @param maxRestarts Maximum number of restarts after the first run.
+   * @param useBIPOP If true, interleave restarts with small populations
+   *     (BIPOP-CMA-ES).
+   * @param parallelRestarts If true, run the restarts with several OpenMP
+   *     threads.
+   */
+  IPOPCMAES(const CMAESType& cmaes = CMAESType(),
+            const double populationFactor = 2.0,
+            const size_t maxRestarts = 9,
+            const bool useBIPOP = false,
+            const bool parallelRestarts = false);
+
+  /**
+   * Optimize the given function with restarts of CMA-ES.  The given starting
+   * point will be modified to store the best point found by any restart, and
+   * its objective value is returned.
+   *
+   * With ParallelRestarts(), several restarts run at the same time, so the
+   * function (and the selection policy) must be safe to evaluate concurrently.
+   *
+   * @tparam SeparableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType>
+  double Optimize(SeparableFunctionType& function, arma::mat& iterate);
+
+  //! Get the CMA-ES optimizer that is restarted.
+  const CMAESType& Optimizer() const { return cmaes; }
+  //! Modify the CMA-ES optimizer that is restarted.
+  CMAESType& Optimizer() { return cmaes; }
+
+  //! Get the factor the population size is multiplied by at every restart.
+  double PopulationFactor() const { return populationFactor; }
+  //! Modify the factor the population size is multiplied by at every restart.
+  double& PopulationFactor() { return populationFactor; }
+
+  //! Get the maximum number of restarts.
+  size_t MaxRestarts() const { return maxRestarts; }
+  //! Modify the maximum number of restarts.
+  size_t& MaxRestarts() { return maxRestarts; }
+
+  //! Get whether restarts with small populations are interleaved.
+  bool UseBIPOP() const { return useBIPOP; }
+  //! Modify whether restarts with small populations are interleaved.
+  bool& UseBIPOP() { return useBIPOP; }
+
+  //! Get whether the restarts are run in parallel.
+  bool ParallelRestarts() const { return parallelRestarts; }
+  //! Modify whether the restarts are run in parallel.
+  bool& ParallelRestarts() { return parallelRestarts; }
+
+  //! Get the population size of each restart of the last call to Optimize().
+  const std::vector<size_t>& PopulationSizes() const { return lambdas; }
+
+  //! Get the index of the restart that found the final point in the last call
+  //! to Optimize().
+  size_t BestRestart() const { return bestRestart; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Plan the population size, the number of iterations and the scale of the
+   * step size of every restart.
+   *
+   * @param n The number of coordinates.
+   * @param generator The stream to draw the small populations from.
+   */
+  void Plan(const size_t n, RandomGenerator& generator);
+
+  //! The CMA-ES optimizer that is restarted.
+  CMAESType cmaes;
+
+  //! The factor the population size is multiplied by.
+  double populationFactor;
+
+  //! The maximum number of restarts.
+  size_t maxRestarts;
+
+  //! Whether to interleave restarts with small populations.
+  bool useBIPOP;
+
+  //! Whether to run the restarts in parallel.
+  bool parallelRestarts;
+
+  //! The population size of each restart.
+  std::vector<size_t> lambdas;
+
+  //! The maximum number of iterations of each restart.
+  std::vector<size_t> iterations;
+
+  //! The factor the initial step size of each restart is multiplied by.
+  std::vector<double> sigmaScales;
+
+  //! The restart that found the final point.
+  size_t bestRestart;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "ipop_cmaes_impl.hpp"
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file ipop_cmaes_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the IPOP and BIPOP restart strategies for CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_IPOP_CMAES_IMPL_HPP
+#define ENSMALLEN_CMAES_IPOP_CMAES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "ipop_cmaes.hpp"
+
+#include <atomic>
+
+namespace ens {
+
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+IPOPCMAES<SelectionPolicyType, CovariancePolicyType>::IPOPCMAES(
+    const CMAESType& cmaes,
+    const double populationFactor,
+    const size_t maxRestarts,
+    const bool useBIPOP,
+    const bool parallelRestarts) :
+    cmaes(cmaes),
+    populationFactor(populationFactor),
+    maxRestarts(maxRestarts),
+    useBIPOP(useBIPOP),
+    parallelRestarts(parallelRestarts),
+    bestRestart(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType>
+double IPOPCMAES<SelectionPolicyType, CovariancePolicyType>::Optimize(
+    SeparableFunctionType& function,
+    arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // The schedule and the streams of the restarts come from the stream of this
+  // optimization.
+  RandomGenerator generator = NewRandomGenerator();
+  Plan(iterate.n_elem, generator);
+  const uint64_t seed = generator.Next64();
+
+  const size_t numRestarts = lambdas.size();
+  std::vector<double> objectives(numRestarts);
+  std::vector<arma::mat> results(numRestarts, iterate);
+
+  // Every restart is independent, so the restarts may run in any order.  The
+  // large restarts are at the end of the schedule, and the threads take the
+  // next restart when they are done with one.
+  std::atomic<size_t> next(0);
+  const auto run = [&]()
+  {
+    for (size_t r = next++; r < numRestarts; r = next++)
+    {
+      CMAESType restart(cmaes);
+      restart.PopulationSize() = lambdas[r];
+      restart.MaxIterations() = iterations[r];
+      restart.WarmStart() = false;
+      restart.Initialize(iterate.n_rows, iterate.n_cols,
+          RandomGenerator(seed, r));
+      restart.Sigma() *= sigmaScales[r];
+
+      objectives[r] = restart.Optimize(function, results[r]);
+    }
+  };
+
+  if (parallelRestarts)
+  {
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      run();
+    }
+  }
+  else
+  {
+    run();
+  }
+
+  bestRestart = 0;
+  for (size_t r = 0; r < numRestarts; ++r)
+  {
+    ENS_INFO << "IPOP-CMA-ES: restart " << r << " with population size "
+        << lambdas[r] << ", objective " << objectives[r] << "." << std::endl;
+    if (objectives[r] < objectives[bestRestart])
+      bestRestart = r;
+  }
+
+  iterate = results[bestRestart];
+  return objectives[bestRestart];
+}
+
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+void IPOPCMAES<SelectionPolicyType, CovariancePolicyType>::Plan(
+    const size_t n,
+    RandomGenerator& generator)
+{
+  const size_t lambda0 = (cmaes.PopulationSize() == 0) ?
+      CMAESType::DefaultPopulationSize(n) : cmaes.PopulationSize();
+  const size_t maxIterations = cmaes.MaxIterations();
+
+  lambdas.assign(1, lambda0);
+  iterations.assign(1, maxIterations);
+  sigmaScales.assign(1, 1.0);
+
+  // The budgets (in evaluations) of the restarts of each regime so far.
+  double largeBudget = (double) lambda0 * maxIterations;
+  double smallBudget = 0.0;
+  double lastLargeBudget = largeBudget;
+  double largeLambda = lambda0;
+
+  for (size_t r = 1; r <= maxRestarts; ++r)
+  {
+    if (useBIPOP && smallBudget < largeBudget)
+    {
+      // A small population and step size, with a budget of at most half that
+      // of the last large restart.
+      const double u = generator.Uniform();
+      const size_t lambda = std::max(4.0, std::floor(lambda0 *
+          std::pow(0.5 * largeLambda / lambda0, u * u)));
+      const size_t maxIt = std::max(2.0, std::floor(0.5 * lastLargeBudget /
+          lambda));
+
+      lambdas.push_back(lambda);
+      iterations.push_back(maxIt);
+      sigmaScales.push_back(std::pow(10.0, -2.0 * u));
+      smallBudget += (double) lambda * maxIt;
+    }
+    else
+    {
+      largeLambda *= populationFactor;
+      const size_t lambda = std::round(largeLambda);
+
+      lambdas.push_back(lambda);
+      iterations.push_back(maxIterations);
+      sigmaScales.push_back(1.0);
+      lastLargeBudget = (double) lambda * maxIterations;
+      largeBudget += lastLargeBudget;
+    }
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -54,8 +54,7 @@ class RandomSelection
     double objective = 0;
     for (size_t f = 0; f < std::floor(numFunctions * fraction); f += batchSize)
     {
-      const size_t selection = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numFunctions - 1)));
+      const size_t selection = Random().Integer(numFunctions);
       const size_t effectiveBatchSize = std::min(batchSize,
           numFunctions - selection);
 
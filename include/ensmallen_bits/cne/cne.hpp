@@ -90,6 +90,8 @@ class CNE
    * @param objectiveChange Minimum change in best fitness values between two
    *     consecutive generations should be greater than threshold. If set to
    *     negative value, objectiveChange is not considered.
+   * @param parallelEvaluation If true, evaluate the fitness of the candidates
+   *     of each generation with several OpenMP threads.
    */
   CNE(const size_t populationSize = 500,
       const size_t maxGenerations = 5000,
@@ -97,13 +99,22 @@ class CNE
       const double mutationSize = 0.02,
       const double selectPercent = 0.2,
       const double tolerance = 1e-5,
-      const double objectiveChange = 1e-5);
+      const double objectiveChange = 1e-5,
+      const bool parallelEvaluation = false);
 
   /**
    * Optimize the given function using CNE. The given
    * starting point will be modified to store the finishing point of the
    * algorithm, and the final objective value is returned.
    *
+   * With ParallelEvaluation(), the candidates of a generation are evaluated
+   * with several OpenMP threads, so the Evaluate() method of the function must
+   * be safe to call concurrently.  If the function has an EvaluateBatch()
+   * method (see traits::HasBatchEvaluation), the whole population is evaluated
+   * with a single call to it instead.  Only the candidates that changed since
+   * their last evaluation (the children and the mutated elites) are evaluated
+   * again.
+   *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
@@ -112,6 +123,57 @@ class CNE
   template<typename DecomposableFunctionType>
   double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
 
+  /**
+   * Start a new population of candidates of the given size, drawn between 0
+   * and 1, for the ask/tell interface.  Optimize() is implemented with this,
+   * Ask() and Tell(); the ask/tell interface lets the caller evaluate the
+   * candidates however it likes (for instance on remote machines):
+   *
+   * @code
+   * CNE cne(200, 1000);
+   * cne.Initialize(10, 1);
+   * for (size_t i = 0; i < 1000; ++i)
+   * {
+   *   const arma::cube& candidates = cne.Ask();
+   *   arma::vec fitness(candidates.n_slices);
+   *   for (size_t j = 0; j < candidates.n_slices; ++j)
+   *     fitness[j] = f.Evaluate(candidates.slice(j));
+   *   cne.Tell(fitness);
+   * }
+   * // cne.Best() is the best candidate.
+   * @endcode
+   *
+   * @param rows Number of rows of the candidates.
+   * @param cols Number of columns of the candidates.
+   */
+  void Initialize(const size_t rows, const size_t cols);
+
+  /**
+   * Get the candidates to evaluate in this generation: those that changed
+   * since their last evaluation (all of them in the first generation).  The
+   * fitness of each of them must be given to Tell() before the next call to
+   * Ask().
+   *
+   * @return The candidates, one per slice; the cube is valid until the next
+   *     call to Ask().
+   */
+  const arma::cube& Ask();
+
+  /**
+   * Take the fitness of the candidates of the last call to Ask(), and create
+   * the next generation.
+   *
+   * @param fitness The fitness of each candidate, in the order of the slices.
+   */
+  void Tell(const arma::vec& fitness);
+
+  //! Get the best candidate of the last generation given to Tell().
+  const arma::mat& Best() const { return population.slice(index(0)); }
+
+  //! Get the fitness of the best candidate of the last generation given to
+  //! Tell().
+  double BestFitness() const { return fitnessValues[index(0)]; }
+
   //! Get the population size.
   size_t PopulationSize() const { return populationSize; }
   //! Modify the population size.
@@ -147,10 +209,34 @@ class CNE
   //! Modify the termination criteria of change in fitness value.
   double& ObjectiveChange() { return objectiveChange; }
 
+  //! Get whether the candidates are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the candidates are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the number of candidates evaluated by the last call to Optimize().
+  //! Candidates that did not change since the last generation are not
+  //! evaluated again.
+  size_t Evaluations() const { return evaluations; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! Reproduce candidates to create the next generation.
   void Reproduce();
 
+  /**
+   * Store the indices of the candidates that changed since their last
+   * evaluation in toEvaluate, and count them as evaluated.
+   *
+   * @return The number of changed candidates.
+   */
+  size_t FindModified();
+
+  //! Copy the first numModified candidates of toEvaluate into candidates.
+  void GatherModified(const size_t numModified);
+
   //! Modify weights with some noise for the evolution of next generation.
   void Mutate();
 
@@ -180,6 +266,18 @@ class CNE
   //! Index of sorted fitness values.
   arma::uvec index;
 
+  //! Whether each candidate was changed since it was last evaluated.
+  std::vector<bool> modified;
+
+  //! The indices of the candidates to evaluate in this generation.
+  arma::uvec toEvaluate;
+
+  //! The changed candidates, for functions with an EvaluateBatch() method.
+  arma::cube candidates;
+
+  //! The fitness values of the changed candidates.
+  arma::vec candidateFitness;
+
   //! The number of candidates in the population.
   size_t populationSize;
 
@@ -201,11 +299,26 @@ class CNE
   //! Minimum change in best fitness values between two generations.
   double objectiveChange;
 
+  //! Whether to evaluate the candidates in parallel.
+  bool parallelEvaluation;
+
   //! Number of candidates to become parent for the next generation.
   size_t numElite;
 
   //! Store the number of elements in a cube slice or a matrix column.
   size_t elements;
+
+  //! The number of candidates evaluated by the last call to Optimize().
+  size_t evaluations;
+
+  //! Whether the candidates of the last call to Ask() are waiting for Tell().
+  bool asked;
+
+  //! The random number stream of the search.
+  RandomGenerator generator;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
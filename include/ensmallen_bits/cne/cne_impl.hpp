@@ -18,6 +18,8 @@
 
 #include "cne.hpp"
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 inline CNE::CNE(const size_t populationSize,
@@ -26,7 +28,8 @@ inline CNE::CNE(const size_t populationSize,
                 const double mutationSize,
                 const double selectPercent,
                 const double tolerance,
-                const double objectiveChange) :
+                const double objectiveChange,
+                const bool parallelEvaluation) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     mutationProb(mutationProb),
@@ -34,52 +37,23 @@ inline CNE::CNE(const size_t populationSize,
     selectPercent(selectPercent),
     tolerance(tolerance),
     objectiveChange(objectiveChange),
+    parallelEvaluation(parallelEvaluation),
     numElite(0),
-    elements(0)
+    elements(0),
+    evaluations(0),
+    asked(false)
 { /* Nothing to do here. */ }
 
 //! Optimize the function.
 template<typename DecomposableFunctionType>
 double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 {
-  // Make sure for evolution to work at least four candidates are present.
-  if (populationSize < 4)
-  {
-    throw std::logic_error("CNE::Optimize(): population size should be at least"
-        " 4!");
-  }
-
-  // Find the number of elite canditates from population.
-  numElite = floor(selectPercent * populationSize);
-
-  // Making sure we have even number of candidates to remove and create.
-  if ((populationSize - numElite) % 2 != 0)
-    numElite--;
-
-  // Terminate if two parents can not be created.
-  if (numElite < 2)
-  {
-    throw std::logic_error("CNE::Optimize(): unable to select two parents. "
-        "Increase selection percentage.");
-  }
-
-  // Terminate if at least two childs are not possible.
-  if ((populationSize - numElite) < 2)
-  {
-    throw std::logic_error("CNE::Optimize(): no space to accomodate even 2 "
-        "children. Increase population size.");
-  }
-
-  // Set the population size and fill random values [0,1].
-  population = arma::randu(iterate.n_rows, iterate.n_cols, populationSize);
-
-  // Store the number of elements in a cube slice or a matrix column.
-  elements = population.n_rows * population.n_cols;
+  ENS_PROFILE_OPTIMIZER(profile);
 
-  // initializing helper variables.
-  fitnessValues.set_size(populationSize);
+  Initialize(iterate.n_rows, iterate.n_cols);
+  RandomScope randomScope(generator);
 
-  Info << "CNE initialized successfully. Optimization started."
+  ENS_INFO << "CNE initialized successfully. Optimization started."
       << std::endl;
 
   // Find the fitness before optimization using given iterate parameters.
@@ -88,17 +62,55 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
   // Iterate until maximum number of generations is obtained.
   for (size_t gen = 1; gen <= maxGenerations; gen++)
   {
-    // Calculating fitness values of all candidates.
-    for (size_t i = 0; i < populationSize; i++)
+    // Only the candidates that were changed by the last reproduction have to
+    // be evaluated.
+    const size_t numModified = FindModified();
+
+    // Calculating fitness values of the changed candidates, at once if the
+    // function supports it.  Otherwise each candidate is evaluated in place,
+    // so the threads do not share any matrix.
+    if (numModified == populationSize &&
+        TryEvaluateBatch(function, population, fitnessValues))
     {
-       // Select a candidate and insert the parameters in the function.
-       iterate = population.slice(i);
-
-       // Find fitness of candidate.
-       fitnessValues[i] = function.Evaluate(iterate);
+      // Nothing else to do.
+    }
+    else if (numModified < populationSize &&
+        traits::HasBatchEvaluation<DecomposableFunctionType>::value)
+    {
+      // Only the changed candidates are given to EvaluateBatch().
+      GatherModified(numModified);
+      TryEvaluateBatch(function, candidates, candidateFitness);
+      for (size_t i = 0; i < numModified; i++)
+        fitnessValues[toEvaluate[i]] = candidateFitness[i];
+    }
+    else if (parallelEvaluation)
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        for (size_t i = threadId; i < numModified; i += numThreads)
+        {
+          fitnessValues[toEvaluate[i]] = function.Evaluate(
+              population.slice(toEvaluate[i]));
+        }
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < numModified; i++)
+      {
+        fitnessValues[toEvaluate[i]] = function.Evaluate(
+            population.slice(toEvaluate[i]));
+      }
     }
 
-    Info << "Generation number: " << gen << " best fitness = "
+    ENS_INFO << "Generation number: " << gen << " best fitness = "
         << fitnessValues.min() << std::endl;
 
     // Create next generation of species.
@@ -107,7 +119,7 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
     // Check for termination criteria.
     if (tolerance >= fitnessValues.min())
     {
-      Info << "CNE::Optimize(): terminating. Given fitness criteria "
+      ENS_INFO << "CNE::Optimize(): terminating. Given fitness criteria "
           << tolerance << " > " << fitnessValues.min() << "." << std::endl;
       break;
     }
@@ -115,7 +127,7 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
     // Check for termination criteria.
     if (lastBestFitness - fitnessValues.min() < objectiveChange)
     {
-      Info << "CNE::Optimize(): terminating. Fitness history change "
+      ENS_INFO << "CNE::Optimize(): terminating. Fitness history change "
           << (lastBestFitness - fitnessValues.min())
           << " < " << objectiveChange << "." << std::endl;
       break;
@@ -131,12 +143,124 @@ double CNE::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
   return function.Evaluate(iterate);
 }
 
+inline void CNE::Initialize(const size_t rows, const size_t cols)
+{
+  // Make sure for evolution to work at least four candidates are present.
+  if (populationSize < 4)
+  {
+    throw std::logic_error("CNE::Initialize(): population size should be at "
+        "least 4!");
+  }
+
+  // Find the number of elite canditates from population.
+  numElite = floor(selectPercent * populationSize);
+
+  // Making sure we have even number of candidates to remove and create.
+  if ((populationSize - numElite) % 2 != 0)
+    numElite--;
+
+  // Terminate if two parents can not be created.
+  if (numElite < 2)
+  {
+    throw std::logic_error("CNE::Initialize(): unable to select two parents. "
+        "Increase selection percentage.");
+  }
+
+  // Terminate if at least two childs are not possible.
+  if ((populationSize - numElite) < 2)
+  {
+    throw std::logic_error("CNE::Initialize(): no space to accomodate even 2 "
+        "children. Increase population size.");
+  }
+
+  // All the random numbers of the search come from its own stream.
+  generator = NewRandomGenerator();
+
+  // Set the population size and fill random values [0,1].
+  population.set_size(rows, cols, populationSize);
+  generator.Randu(population);
+
+  // Store the number of elements in a cube slice or a matrix column.
+  elements = population.n_rows * population.n_cols;
+
+  // initializing helper variables.  Every candidate has to be evaluated in
+  // the first generation.
+  fitnessValues.set_size(populationSize);
+  modified.assign(populationSize, true);
+  toEvaluate.set_size(populationSize);
+  index.reset();
+  evaluations = 0;
+  asked = false;
+}
+
+inline const arma::cube& CNE::Ask()
+{
+  if (population.n_elem == 0)
+  {
+    throw std::logic_error("CNE::Ask(): the population has not been "
+        "initialized");
+  }
+
+  GatherModified(FindModified());
+  asked = true;
+  return candidates;
+}
+
+inline void CNE::Tell(const arma::vec& fitness)
+{
+  if (!asked)
+  {
+    throw std::logic_error("CNE::Tell(): Ask() has not been called since the "
+        "last call to Tell()");
+  }
+
+  if (fitness.n_elem != candidates.n_slices)
+  {
+    throw std::invalid_argument("CNE::Tell(): the number of fitness values "
+        "does not match the number of candidates");
+  }
+
+  asked = false;
+  for (size_t i = 0; i < fitness.n_elem; i++)
+    fitnessValues[toEvaluate[i]] = fitness[i];
+
+  RandomScope randomScope(generator);
+  Reproduce();
+}
+
+//! Find the candidates that were changed since their last evaluation.
+inline size_t CNE::FindModified()
+{
+  // The others (at least the best one, which is never mutated) keep their
+  // fitness value.
+  size_t numModified = 0;
+  for (size_t i = 0; i < populationSize; i++)
+  {
+    if (modified[i])
+      toEvaluate[numModified++] = i;
+  }
+  evaluations += numModified;
+
+  return numModified;
+}
+
+//! Copy the changed candidates into the candidates cube.
+inline void CNE::GatherModified(const size_t numModified)
+{
+  candidates.set_size(population.n_rows, population.n_cols, numModified);
+  for (size_t i = 0; i < numModified; i++)
+    candidates.slice(i) = population.slice(toEvaluate[i]);
+}
+
 //! Reproduce candidates to create the next generation.
 inline void CNE::Reproduce()
 {
   // Sort fitness values. Smaller fitness value means better performance.
   index = arma::sort_index(fitnessValues);
 
+  // The candidates that are not replaced or mutated keep their fitness.
+  std::fill(modified.begin(), modified.end(), false);
+
   // First parent.
   size_t mom;
 
@@ -146,11 +270,8 @@ inline void CNE::Reproduce()
   for (size_t i = numElite; i < populationSize - 1; i++)
   {
     // Select 2 different parents from elite group randomly [0, numElite).
-    mom = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
-
-    dad = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
+    mom = Random().Integer(numElite);
+    dad = Random().Integer(numElite);
 
     // Making sure both parents are not the same.
     if (mom == dad)
@@ -181,40 +302,63 @@ inline void CNE::Crossover(const size_t mom,
                            const size_t child1,
                            const size_t child2)
 {
-  // Replace the candidates with parents at their place.
-  population.slice(child1) = population.slice(mom);
-  population.slice(child2) = population.slice(dad);
-
-  // Preallocate random selection vector (values between 0 and 1).
-  arma::vec selection = arma::randu(elements);
-
-  // Randomly alter mom and dad genome weights to get two different children.
-  for (size_t i = 0; i < elements; i++)
+  // Randomly select the weights that the first child inherits from mom and
+  // the second child from dad; the other weights are swapped.  Each bit of a
+  // random word is the coin of one weight, and both children are written in
+  // a single pass.
+  const double* momMem = population.slice_memptr(mom);
+  const double* dadMem = population.slice_memptr(dad);
+  double* child1Mem = population.slice_memptr(child1);
+  double* child2Mem = population.slice_memptr(child2);
+
+  RandomGenerator& generator = Random();
+  uint64_t coins = 0;
+  for (size_t i = 0; i < elements; ++i)
   {
-    // Using it to alter the weights of the children.
-    if (selection(i) > 0.5)
-    {
-      population.slice(child1)(i) = population.slice(mom)(i);
-      population.slice(child2)(i) = population.slice(dad)(i);
-    }
-    else
-    {
-      population.slice(child1)(i) = population.slice(dad)(i);
-      population.slice(child2)(i) = population.slice(mom)(i);
-    }
+    if (i % 64 == 0)
+      coins = generator.Next64();
+
+    const bool fromMom = (coins & 1);
+    coins >>= 1;
+    child1Mem[i] = fromMom ? momMem[i] : dadMem[i];
+    child2Mem[i] = fromMom ? dadMem[i] : momMem[i];
   }
+
+  modified[child1] = true;
+  modified[child2] = true;
 }
 
 //! Modify weights with some noise for the evolution of next generation.
 inline void CNE::Mutate()
 {
-  // Mutate the whole matrix with the given rate and probability.
+  // Mutate the whole population with the given rate and probability.
   // The best candidate is not altered.
-  for (size_t i = 1; i < populationSize; i++)
+  if (mutationProb <= 0.0)
+    return;
+
+  // Instead of drawing a coin for every weight, the number of weights to skip
+  // until the next mutation is drawn from the geometric distribution, so that
+  // only the mutations themselves cost random numbers.
+  const double logSkip = std::log1p(-std::min(mutationProb, 1.0));
+  RandomGenerator& generator = Random();
+  for (size_t i = 0; i < populationSize; ++i)
   {
-    population.slice(index(i)) += (arma::randu(
-        population.n_rows, population.n_cols) < mutationProb) %
-        (mutationSize * arma::randn(population.n_rows, population.n_cols));
+    if (i == index(0))
+      continue;
+
+    double* mem = population.slice_memptr(i);
+    for (size_t j = 0; ; ++j)
+    {
+      // With mutationProb = 1, logSkip is -inf and no weight is skipped.
+      const double skip = std::floor(std::log1p(-generator.Uniform()) /
+          logSkip);
+      if (!(skip < (double) (elements - j)))
+        break;
+
+      j += (size_t) skip;
+      mem[j] += mutationSize * generator.Normal();
+      modified[i] = true;
+    }
   }
 }
 
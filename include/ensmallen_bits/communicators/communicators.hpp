@@ -0,0 +1,21 @@
+/**
+ * @file communicators.hpp
+ * @author Marcus Edel
+ *
+ * Communicators of the distributed optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_COMMUNICATORS_COMMUNICATORS_HPP
+#define ENSMALLEN_COMMUNICATORS_COMMUNICATORS_HPP
+
+#include "no_communicator.hpp"
+
+#ifdef ENS_USE_MPI
+  #include "mpi_communicator.hpp"
+#endif
+
+#endif
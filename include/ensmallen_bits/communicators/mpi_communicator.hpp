@@ -0,0 +1,153 @@
+/**
+ * @file mpi_communicator.hpp
+ * @author Marcus Edel
+ *
+ * Communicator of the workers of an MPI communicator.  Only available if
+ * ENS_USE_MPI is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_COMMUNICATORS_MPI_COMMUNICATOR_HPP
+#define ENSMALLEN_COMMUNICATORS_MPI_COMMUNICATOR_HPP
+
+#include <mpi.h>
+
+namespace ens {
+
+namespace detail {
+
+//! The MPI datatype of the given element type.
+template<typename ElemType>
+struct MPIType;
+
+template<>
+struct MPIType<float>
+{ static MPI_Datatype Get() { return MPI_FLOAT; } };
+
+template<>
+struct MPIType<double>
+{ static MPI_Datatype Get() { return MPI_DOUBLE; } };
+
+template<>
+struct MPIType<long double>
+{ static MPI_Datatype Get() { return MPI_LONG_DOUBLE; } };
+
+template<>
+struct MPIType<unsigned char>
+{ static MPI_Datatype Get() { return MPI_UNSIGNED_CHAR; } };
+
+template<>
+struct MPIType<unsigned long>
+{ static MPI_Datatype Get() { return MPI_UNSIGNED_LONG; } };
+
+template<>
+struct MPIType<unsigned long long>
+{ static MPI_Datatype Get() { return MPI_UNSIGNED_LONG_LONG; } };
+
+} // namespace detail
+
+/**
+ * The communicator of the processes of an MPI communicator (by default
+ * MPI_COMM_WORLD), one worker per process.  MPI must be initialized before the
+ * communicator is used, and finalized by the caller.  StartAllReduce() uses the
+ * non-blocking MPI_Iallreduce() of MPI 3, so that several sums can be in flight
+ * at the same time.  Whether a sum progresses while the worker computes
+ * depends on the MPI implementation (for instance, MPICH does so with
+ * MPICH_ASYNC_PROGRESS=1).
+ *
+ * The communicator is only available if ENS_USE_MPI is defined before
+ * ensmallen.hpp is included (for the tests, configure with -DUSE_MPI=ON).
+ *
+ * @code
+ * MPI_Init(&argc, &argv);
+ * DataParallelSGD<AdamUpdate, NoDecay, MPICommunicator> optimizer(0.001, 32);
+ * optimizer.Optimize(localFunction, coordinates);
+ * MPI_Finalize();
+ * @endcode
+ */
+class MPICommunicator
+{
+ public:
+  //! The type of a pending operation.
+  typedef MPI_Request RequestType;
+
+  /**
+   * Create the communicator of the processes of the given MPI communicator.
+   *
+   * @param comm The MPI communicator.
+   */
+  MPICommunicator(MPI_Comm comm = MPI_COMM_WORLD) : comm(comm)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of workers.
+  size_t Size() const
+  {
+    int size;
+    MPI_Comm_size(comm, &size);
+    return size;
+  }
+
+  //! Get the index of this worker.
+  size_t Rank() const
+  {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    return rank;
+  }
+
+  //! Sum the given data over the workers.
+  template<typename ElemType>
+  void AllReduce(ElemType* data, const size_t n)
+  {
+    MPI_Allreduce(MPI_IN_PLACE, data, n, detail::MPIType<ElemType>::Get(),
+        MPI_SUM, comm);
+  }
+
+  //! Start to sum the given data over the workers.
+  template<typename ElemType>
+  RequestType StartAllReduce(ElemType* data, const size_t n)
+  {
+    RequestType request;
+    MPI_Iallreduce(MPI_IN_PLACE, data, n, detail::MPIType<ElemType>::Get(),
+        MPI_SUM, comm, &request);
+    return request;
+  }
+
+  //! Wait for the given operation to finish.
+  void Wait(RequestType& request)
+  {
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+  }
+
+  //! Copy the data of the given worker to all the workers.
+  template<typename ElemType>
+  void Broadcast(ElemType* data, const size_t n, const size_t root)
+  {
+    MPI_Bcast(data, n, detail::MPIType<ElemType>::Get(), root, comm);
+  }
+
+  //! Concatenate the given data of all the workers.
+  template<typename ElemType>
+  void AllGather(const ElemType* data, const size_t n, ElemType* result)
+  {
+    MPI_Allgather(const_cast<ElemType*>(data), n,
+        detail::MPIType<ElemType>::Get(), result, n,
+        detail::MPIType<ElemType>::Get(), comm);
+  }
+
+  //! Get the MPI communicator.
+  MPI_Comm Comm() const { return comm; }
+
+ private:
+  //! The MPI communicator.
+  MPI_Comm comm;
+};
+
+} // namespace ens
+
+#endif
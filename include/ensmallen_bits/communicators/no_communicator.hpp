@@ -0,0 +1,94 @@
+/**
+ * @file no_communicator.hpp
+ * @author Marcus Edel
+ *
+ * Communicator of a single worker, which does not communicate at all.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_COMMUNICATORS_NO_COMMUNICATOR_HPP
+#define ENSMALLEN_COMMUNICATORS_NO_COMMUNICATOR_HPP
+
+#include <algorithm>
+
+namespace ens {
+
+/**
+ * The communicator of a single worker: every collective operation is a no-op.
+ * This is the default communicator of the distributed optimizers, which then
+ * behave like their single-node counterparts.
+ *
+ * A communicator class must implement the following methods, which are called
+ * by all the workers in the same order:
+ *
+ * @code
+ * // The number of workers, and the index of this worker in [0, Size()).
+ * size_t Size();
+ * size_t Rank();
+ *
+ * // Replace data[0, n) with its sum over the workers.
+ * template<typename ElemType>
+ * void AllReduce(ElemType* data, const size_t n);
+ *
+ * // Start the same sum without waiting for it; the data must not be used
+ * // until Wait() was called on the returned request.
+ * template<typename ElemType>
+ * RequestType StartAllReduce(ElemType* data, const size_t n);
+ * void Wait(RequestType& request);
+ *
+ * // Replace data[0, n) with that of the given worker.
+ * template<typename ElemType>
+ * void Broadcast(ElemType* data, const size_t n, const size_t root);
+ *
+ * // Concatenate data[0, n) of all the workers, in the order of their ranks,
+ * // into result[0, Size() * n).
+ * template<typename ElemType>
+ * void AllGather(const ElemType* data, const size_t n, ElemType* result);
+ * @endcode
+ */
+class NoCommunicator
+{
+ public:
+  //! The type of a pending operation.
+  typedef int RequestType;
+
+  //! Get the number of workers.
+  size_t Size() const { return 1; }
+
+  //! Get the index of this worker.
+  size_t Rank() const { return 0; }
+
+  //! Sum the given data over the workers (nothing to do).
+  template<typename ElemType>
+  void AllReduce(ElemType* /* data */, const size_t /* n */) { }
+
+  //! Start to sum the given data over the workers (nothing to do).
+  template<typename ElemType>
+  RequestType StartAllReduce(ElemType* /* data */, const size_t /* n */)
+  {
+    return 0;
+  }
+
+  //! Wait for the given operation to finish (nothing to do).
+  void Wait(RequestType& /* request */) { }
+
+  //! Copy the data of the given worker to all the workers (nothing to do).
+  template<typename ElemType>
+  void Broadcast(ElemType* /* data */,
+                 const size_t /* n */,
+                 const size_t /* root */) { }
+
+  //! Concatenate the given data of all the workers (a copy).
+  template<typename ElemType>
+  void AllGather(const ElemType* data, const size_t n, ElemType* result)
+  {
+    std::copy(data, data + n, result);
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -18,6 +18,79 @@
   // #define ENS_PRINT_WARN
 #endif
 
+#if !defined(ENS_ASYNC_LOG)
+  // Write the lines of the Info and Warn streams from a background thread, so
+  // that the optimizers never wait for the output.
+  // #define ENS_ASYNC_LOG
+#endif
+
+#if !defined(ENS_PROFILE)
+  // #define ENS_PROFILE
+#endif
+
+#if !defined(ENS_TRACE)
+  // Record the phases of the optimizers as zones of a timeline, which
+  // ens::WriteTrace() writes in the Chrome trace event format.
+  // #define ENS_TRACE
+#endif
+
+#if !defined(ENS_STRICT_FUNCTIONS)
+  // #define ENS_STRICT_FUNCTIONS
+#endif
+
+#if !defined(ENS_USE_MPI)
+  // Provide MPICommunicator for the distributed optimizers; requires <mpi.h>.
+  // #define ENS_USE_MPI
+#endif
+
+#if !defined(ENS_USE_COOT)
+  // Support Bandicoot GPU matrices (coot::Mat) in SGD and the Adam, momentum
+  // and Nesterov momentum update policies; requires <bandicoot>.
+  // #define ENS_USE_COOT
+#endif
+
+#if !defined(ENS_INCLUDE_PROBLEMS)
+  // Include the test problems of ens::test (RosenbrockFunction,
+  // LogisticRegressionFunction and so on) in ensmallen.hpp.
+  // #define ENS_INCLUDE_PROBLEMS
+#endif
+
+#if !defined(ENS_USE_EXTERN_TEMPLATES)
+  // Do not compile the optimizers instantiated by the ensmallen_instantiations
+  // library, which must then be linked.
+  // #define ENS_USE_EXTERN_TEMPLATES
+#endif
+
+#if !defined(ENS_ELEMENTWISE_PARALLEL_THRESHOLD)
+  // Number of parameters from which the steps of the update policies are split
+  // between OpenMP threads.
+  #define ENS_ELEMENTWISE_PARALLEL_THRESHOLD 1048576
+#endif
+
+#if !defined(ENS_LRSDP_PARALLEL_THRESHOLD)
+  // Number of constraints from which LRSDPFunction evaluates the constraints
+  // and the gradient of the augmented Lagrangian with OpenMP threads.
+  #define ENS_LRSDP_PARALLEL_THRESHOLD 512
+#endif
+
+#if !defined(ENS_DETERMINISTIC)
+  // Enable the deterministic mode by default (see ens::SetDeterministic()), so
+  // that the results do not depend on the number of threads.
+  // #define ENS_DETERMINISTIC
+#endif
+
+#if !defined(ENS_DETERMINISTIC_CHUNKS)
+  // Number of chunks of the parallel reductions in the deterministic mode.
+  #define ENS_DETERMINISTIC_CHUNKS 16
+#endif
+
+#if !defined(ENS_HUGE_PAGES)
+  // Back the large optimizer state with transparent huge pages by default (see
+  // ens::SetHugePages()).  With ENS_ALIGNED_ALLOCATOR, this must be defined
+  // before ensmallen.hpp is included.
+  // #define ENS_HUGE_PAGES
+#endif
+
 #if defined(ARMA_USE_OPENMP)
   #undef  ENS_USE_OPENMP
   #define ENS_USE_OPENMP
@@ -35,6 +108,14 @@
   #undef ENS_PRINT_WARN
 #endif
 
+#if defined(ENS_DONT_PROFILE)
+  #undef ENS_PROFILE
+#endif
+
+#if defined(ENS_DONT_TRACE)
+  #undef ENS_TRACE
+#endif
+
 #if defined(ENS_DONT_USE_OPENMP)
   #undef ENS_USE_OPENMP
 #endif
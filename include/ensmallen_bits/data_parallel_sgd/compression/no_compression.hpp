@@ -0,0 +1,111 @@
+/**
+ * @file no_compression.hpp
+ * @author Marcus Edel
+ *
+ * Gradient "compression" of data-parallel SGD that sends the dense gradient.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_NO_COMPRESSION_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_NO_COMPRESSION_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * The default compression policy of DataParallelSGD: the dense gradient is
+ * summed over the workers in buckets of bucketSize elements, which are all
+ * started before the first one is waited for, so that the communication of
+ * the buckets is pipelined; each bucket is averaged as soon as it has arrived.
+ *
+ * A compression policy must contain an internal 'Policy' template class with
+ * two template arguments, GradType and CommunicatorType, which is instantiated
+ * at the start of the optimization and holds the state of the compression
+ * (e.g. the residuals of the error feedback):
+ *
+ * @code
+ * Policy(CompressionPolicyType& parent,
+ *        CommunicatorType& communicator,
+ *        const size_t rows,
+ *        const size_t cols);
+ *
+ * // Replace the local gradient with the average of the gradients of all the
+ * // workers; all the workers must end with the same gradient.
+ * void Reduce(GradType& gradient, const size_t bucketSize);
+ * @endcode
+ */
+class NoCompression
+{
+ public:
+  /**
+   * The state of the reduction, instantiated at the start of the
+   * optimization.
+   */
+  template<typename GradType, typename CommunicatorType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param communicator The communicator of the workers.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(NoCompression& /* parent */,
+           CommunicatorType& communicator,
+           const size_t /* rows */,
+           const size_t /* cols */) :
+        communicator(communicator)
+    { /* Nothing to do. */ }
+
+    /**
+     * Average the dense gradient over the workers.
+     *
+     * @param gradient The local gradient, replaced by the average.
+     * @param bucketSize Number of elements of the gradient summed at once.
+     */
+    void Reduce(GradType& gradient, const size_t bucketSize)
+    {
+      typedef typename GradType::elem_type ElemType;
+      ElemType* g = gradient.memptr();
+      const size_t n = gradient.n_elem;
+
+      requests.clear();
+      for (size_t begin = 0; begin < n; begin += bucketSize)
+      {
+        requests.push_back(communicator.StartAllReduce(g + begin,
+            std::min(bucketSize, n - begin)));
+      }
+
+      const ElemType scale = ElemType(1) / ElemType(communicator.Size());
+      size_t k = 0;
+      for (size_t begin = 0; begin < n; begin += bucketSize, ++k)
+      {
+        communicator.Wait(requests[k]);
+        const size_t end = std::min(begin + bucketSize, n);
+        if (scale != ElemType(1))
+        {
+          for (size_t i = begin; i < end; ++i)
+            g[i] *= scale;
+        }
+      }
+    }
+
+   private:
+    //! The communicator of the workers.
+    CommunicatorType& communicator;
+
+    //! The pending sums of the current reduction.
+    std::vector<typename CommunicatorType::RequestType> requests;
+  };
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file quantized_compression.hpp
+ * @author Marcus Edel
+ *
+ * 8-bit and 1-bit quantization of the gradients of data-parallel SGD, with
+ * error feedback.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_QUANTIZED_COMPRESSION_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_QUANTIZED_COMPRESSION_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * Quantization of the gradients: each worker sends one byte (bits = 8) or one
+ * bit (bits = 1) per element of its gradient, plus a single scale, and the
+ * quantized gradients of all the workers are gathered and averaged.
+ *
+ *  - With 8 bits, the elements are rounded to 255 levels evenly spaced on
+ *    [-s, s], where s is the largest magnitude of the gradient.
+ *  - With 1 bit, only the sign of each element is sent, and the elements are
+ *    decoded to +s or -s, where s is the mean magnitude of the gradient.
+ *
+ * With error feedback, the quantization error of each step is kept in a
+ * residual and added to the next gradient; 1-bit quantization needs it to
+ * converge.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Seide2014,
+ *   title     = {1-Bit Stochastic Gradient Descent and its Application to
+ *                Data-Parallel Distributed Training of Speech {DNNs}},
+ *   author    = {Seide, Frank and Fu, Hao and Droppo, Jasha and Li, Gang and
+ *                Yu, Dong},
+ *   booktitle = {Interspeech},
+ *   year      = {2014}
+ * }
+ *
+ * @inproceedings{Karimireddy2019,
+ *   title     = {Error Feedback Fixes {SignSGD} and other Gradient
+ *                Compression Schemes},
+ *   author    = {Karimireddy, Sai Praneeth and Rebjock, Quentin and Stich,
+ *                Sebastian U. and Jaggi, Martin},
+ *   booktitle = {International Conference on Machine Learning},
+ *   pages     = {3252--3261},
+ *   year      = {2019}
+ * }
+ * @endcode
+ */
+class QuantizedCompression
+{
+ public:
+  /**
+   * Construct the quantization with the given number of bits.
+   *
+   * @param bits Number of bits per element (8 or 1).
+   * @param errorFeedback Whether the quantization errors are kept for the next
+   *     step.
+   */
+  QuantizedCompression(const size_t bits = 8,
+                       const bool errorFeedback = true) :
+      bits(bits),
+      errorFeedback(errorFeedback)
+  {
+    if (bits != 8 && bits != 1)
+    {
+      std::ostringstream oss;
+      oss << "QuantizedCompression::QuantizedCompression(): bits must be 8 or "
+          << "1, given " << bits;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  /**
+   * The state of the compression, instantiated at the start of the
+   * optimization.
+   */
+  template<typename GradType, typename CommunicatorType>
+  class Policy
+  {
+   public:
+    //! The element type of the gradient.
+    typedef typename GradType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param communicator The communicator of the workers.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(QuantizedCompression& parent,
+           CommunicatorType& communicator,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        communicator(communicator)
+    {
+      residual.zeros(rows, cols);
+    }
+
+    /**
+     * Send the quantized local gradient (plus the residual), and replace the
+     * gradient with the average of those of all the workers.
+     *
+     * @param gradient The local gradient, replaced by the average.
+     * @param bucketSize Unused.
+     */
+    void Reduce(GradType& gradient, const size_t /* bucketSize */)
+    {
+      const size_t n = gradient.n_elem;
+      const size_t bytes = (parent.bits == 8) ? n : (n + 7) / 8;
+
+      if (parent.errorFeedback)
+        residual += gradient;
+      else
+        residual = gradient;
+      ElemType* r = residual.memptr();
+
+      // Quantize the local gradient, and keep the error.
+      codes.assign(bytes, 0);
+      ElemType scale = 0;
+      if (parent.bits == 8)
+      {
+        for (size_t i = 0; i < n; ++i)
+          scale = std::max(scale, ElemType(std::abs(r[i])));
+        const ElemType step = scale / ElemType(127);
+        for (size_t i = 0; i < n; ++i)
+        {
+          const ElemType q = (step > 0) ? std::round(r[i] / step) : 0;
+          codes[i] = (unsigned char) (q + 127);
+          r[i] -= q * step;
+        }
+      }
+      else
+      {
+        for (size_t i = 0; i < n; ++i)
+          scale += std::abs(r[i]);
+        scale /= ElemType(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+          if (r[i] >= 0)
+          {
+            codes[i / 8] |= (unsigned char) (1 << (i % 8));
+            r[i] -= scale;
+          }
+          else
+          {
+            r[i] += scale;
+          }
+        }
+      }
+
+      const size_t workers = communicator.Size();
+      allCodes.resize(workers * bytes);
+      allScales.resize(workers);
+      communicator.AllGather(codes.data(), bytes, allCodes.data());
+      communicator.AllGather(&scale, 1, allScales.data());
+
+      // Every worker decodes and sums the gradients in the same order.
+      gradient.zeros();
+      ElemType* g = gradient.memptr();
+      for (size_t w = 0; w < workers; ++w)
+      {
+        const unsigned char* c = allCodes.data() + w * bytes;
+        if (parent.bits == 8)
+        {
+          const ElemType step = allScales[w] / ElemType(127);
+          for (size_t i = 0; i < n; ++i)
+            g[i] += (ElemType(c[i]) - ElemType(127)) * step;
+        }
+        else
+        {
+          for (size_t i = 0; i < n; ++i)
+            g[i] += ((c[i / 8] >> (i % 8)) & 1) ? allScales[w] : -allScales[w];
+        }
+      }
+      if (workers > 1)
+        gradient /= ElemType(workers);
+    }
+
+    //! Get the quantization errors that were not sent yet.
+    const GradType& Residual() const { return residual; }
+
+   private:
+    //! Instantiated parent object.
+    QuantizedCompression& parent;
+
+    //! The communicator of the workers.
+    CommunicatorType& communicator;
+
+    //! The quantization errors that were not sent yet.
+    GradType residual;
+
+    //! The quantized local gradient.
+    std::vector<unsigned char> codes;
+
+    //! The quantized gradients and scales of all the workers.
+    std::vector<unsigned char> allCodes;
+    std::vector<ElemType> allScales;
+  };
+
+  //! Get the number of bits per element.
+  size_t Bits() const { return bits; }
+  //! Modify the number of bits per element.
+  size_t& Bits() { return bits; }
+
+  //! Get whether the quantization errors are kept.
+  bool ErrorFeedback() const { return errorFeedback; }
+  //! Modify whether the quantization errors are kept.
+  bool& ErrorFeedback() { return errorFeedback; }
+
+ private:
+  //! The number of bits per element.
+  size_t bits;
+
+  //! Whether the quantization errors are kept.
+  bool errorFeedback;
+};
+
+} // namespace ens
+
+#endif
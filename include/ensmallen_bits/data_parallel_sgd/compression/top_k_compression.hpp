@@ -0,0 +1,198 @@
+/**
+ * @file top_k_compression.hpp
+ * @author Marcus Edel
+ *
+ * Top-k sparsification of the gradients of data-parallel SGD, with error
+ * feedback.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_TOP_K_COMPRESSION_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_COMPRESSION_TOP_K_COMPRESSION_HPP
+
+#include <algorithm>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Top-k sparsification: each worker only sends the ratio * n elements of its
+ * gradient with the largest magnitude, as (index, value) pairs, which are
+ * gathered from all the workers and summed into the dense average.  With error
+ * feedback, the elements that were not sent are kept in a residual and added
+ * to the next gradient, so that no part of the gradient is lost; this is what
+ * keeps the convergence of SGD at high compression ratios.
+ *
+ * Each worker receives Size() * k pairs per step, instead of the dense
+ * gradient, so that the compression pays off while ratio * Size() is small.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Stich2018,
+ *   title     = {Sparsified {SGD} with Memory},
+ *   author    = {Stich, Sebastian U. and Cordonnier, Jean-Baptiste and
+ *                Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {4447--4458},
+ *   year      = {2018}
+ * }
+ * @endcode
+ */
+class TopKCompression
+{
+ public:
+  /**
+   * Construct the top-k compression with the given ratio.
+   *
+   * @param ratio Fraction of the elements of the gradient sent at each step,
+   *     in (0, 1].
+   * @param errorFeedback Whether the elements that were not sent are kept for
+   *     the next step.
+   */
+  TopKCompression(const double ratio = 0.01,
+                  const bool errorFeedback = true) :
+      ratio(ratio),
+      errorFeedback(errorFeedback)
+  {
+    if (ratio <= 0.0 || ratio > 1.0)
+    {
+      std::ostringstream oss;
+      oss << "TopKCompression::TopKCompression(): ratio must be in (0, 1], "
+          << "given " << ratio;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  /**
+   * The state of the compression, instantiated at the start of the
+   * optimization.
+   */
+  template<typename GradType, typename CommunicatorType>
+  class Policy
+  {
+   public:
+    //! The element type of the gradient.
+    typedef typename GradType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param communicator The communicator of the workers.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(TopKCompression& parent,
+           CommunicatorType& communicator,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        communicator(communicator)
+    {
+      residual.zeros(rows, cols);
+    }
+
+    /**
+     * Send the largest elements of the local gradient (plus the residual), and
+     * replace the gradient with the average of those of all the workers.
+     *
+     * @param gradient The local gradient, replaced by the average.
+     * @param bucketSize Unused.
+     */
+    void Reduce(GradType& gradient, const size_t /* bucketSize */)
+    {
+      const size_t n = gradient.n_elem;
+      const size_t k = std::min(n, std::max(size_t(1),
+          size_t(std::ceil(parent.ratio * n))));
+
+      if (parent.errorFeedback)
+        residual += gradient;
+      else
+        residual = gradient;
+      ElemType* r = residual.memptr();
+
+      // Select the k elements of largest magnitude.
+      order.resize(n);
+      for (size_t i = 0; i < n; ++i)
+        order[i] = i;
+      if (k < n)
+      {
+        std::nth_element(order.begin(), order.begin() + (k - 1), order.end(),
+            [&](const size_t a, const size_t b)
+            { return std::abs(r[a]) > std::abs(r[b]); });
+      }
+
+      indices.resize(k);
+      values.resize(k);
+      for (size_t i = 0; i < k; ++i)
+      {
+        indices[i] = order[i];
+        values[i] = r[order[i]];
+        r[order[i]] = 0;
+      }
+
+      const size_t workers = communicator.Size();
+      allIndices.resize(workers * k);
+      allValues.resize(workers * k);
+      communicator.AllGather(indices.data(), k, allIndices.data());
+      communicator.AllGather(values.data(), k, allValues.data());
+
+      // Every worker sums the pairs in the same order.
+      gradient.zeros();
+      ElemType* g = gradient.memptr();
+      for (size_t i = 0; i < workers * k; ++i)
+        g[allIndices[i]] += allValues[i];
+      if (workers > 1)
+        gradient /= ElemType(workers);
+    }
+
+    //! Get the elements of the gradients that were not sent yet.
+    const GradType& Residual() const { return residual; }
+
+   private:
+    //! Instantiated parent object.
+    TopKCompression& parent;
+
+    //! The communicator of the workers.
+    CommunicatorType& communicator;
+
+    //! The elements of the gradients that were not sent yet.
+    GradType residual;
+
+    //! The indices of the elements, ordered by magnitude.
+    std::vector<size_t> order;
+
+    //! The sent indices and values.
+    std::vector<unsigned long long> indices;
+    std::vector<ElemType> values;
+
+    //! The indices and values sent by all the workers.
+    std::vector<unsigned long long> allIndices;
+    std::vector<ElemType> allValues;
+  };
+
+  //! Get the fraction of the elements sent at each step.
+  double Ratio() const { return ratio; }
+  //! Modify the fraction of the elements sent at each step.
+  double& Ratio() { return ratio; }
+
+  //! Get whether the elements that were not sent are kept.
+  bool ErrorFeedback() const { return errorFeedback; }
+  //! Modify whether the elements that were not sent are kept.
+  bool& ErrorFeedback() { return errorFeedback; }
+
+ private:
+  //! The fraction of the elements sent at each step.
+  double ratio;
+
+  //! Whether the elements that were not sent are kept.
+  bool errorFeedback;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file data_parallel_function.hpp
+ * @author Marcus Edel
+ *
+ * Wrapper of the local part of a separable function of a data-parallel
+ * optimization: the objectives and gradients are combined over the workers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_FUNCTION_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_FUNCTION_HPP
+
+#include "compression/no_compression.hpp"
+#include "compression/quantized_compression.hpp"
+#include "compression/top_k_compression.hpp"
+
+namespace ens {
+
+/**
+ * Each worker of a data-parallel optimization holds its own part of the data,
+ * as a separable function with the same number of separable functions on all
+ * the workers.  This wrapper evaluates the given batch of the local function,
+ * and combines the results over the workers: the objective is summed, so it is
+ * the objective of the batch on all the data, and the gradient is averaged,
+ * so the step size has the same meaning as for a single worker.  Every worker
+ * then takes the same step.
+ *
+ * The gradient is averaged by the compression policy: NoCompression sums the
+ * dense gradient in pipelined buckets of bucketSize elements, while
+ * TopKCompression and QuantizedCompression send a compressed gradient.  The
+ * objective is summed while the gradient is reduced.
+ *
+ * @tparam FunctionType Type of the local function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient (must be dense).
+ * @tparam CommunicatorType Type of the communicator.
+ * @tparam CompressionPolicyType Compression of the gradients.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename CommunicatorType,
+         typename CompressionPolicyType = NoCompression>
+class DataParallelFunction
+{
+ public:
+  //! The element type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given local function.  Neither the function nor the communicator
+   * are copied, so they must outlive this object.
+   *
+   * @param function The local function.
+   * @param communicator The communicator of the workers.
+   * @param bucketSize Number of elements of the gradient summed at once.
+   * @param compressionPolicy Compression of the gradients.
+   * @param rows Number of rows of the gradient.
+   * @param cols Number of columns of the gradient.
+   */
+  DataParallelFunction(FunctionType& function,
+                       CommunicatorType& communicator,
+                       const size_t bucketSize,
+                       CompressionPolicyType& compressionPolicy,
+                       const size_t rows,
+                       const size_t cols) :
+      function(function),
+      communicator(communicator),
+      bucketSize(std::max(bucketSize, size_t(1))),
+      instCompressionPolicy(compressionPolicy, communicator, rows, cols)
+  { /* Nothing to do. */ }
+
+  //! Return the number of local separable functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the local separable functions.
+  void Shuffle() { function.Shuffle(); }
+
+  /**
+   * Evaluate the given batch of the local function, and sum the objective over
+   * the workers.
+   */
+  ElemType Evaluate(const MatType& coordinates,
+                    const size_t begin,
+                    const size_t batchSize)
+  {
+    ElemType objective = function.Evaluate(coordinates, begin, batchSize);
+    communicator.AllReduce(&objective, 1);
+    return objective;
+  }
+
+  /**
+   * Compute the gradient of the given batch of the local function, and average
+   * it over the workers.
+   */
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    function.Gradient(coordinates, begin, gradient, batchSize);
+    Reduce(gradient, NULL);
+  }
+
+  /**
+   * Evaluate the given batch of the local function and its gradient; the
+   * objective is summed and the gradient averaged over the workers, in the
+   * same round of communication.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                const size_t begin,
+                                GradType& gradient,
+                                const size_t batchSize)
+  {
+    ElemType objective = function.EvaluateWithGradient(coordinates, begin,
+        gradient, batchSize);
+    Reduce(gradient, &objective);
+    return objective;
+  }
+
+ private:
+  //! Average the gradient over the workers, and sum the objective if it is
+  //! given.
+  void Reduce(GradType& gradient, ElemType* objective)
+  {
+    typename CommunicatorType::RequestType request;
+    if (objective != NULL)
+      request = communicator.StartAllReduce(objective, 1);
+
+    instCompressionPolicy.Reduce(gradient, bucketSize);
+
+    if (objective != NULL)
+      communicator.Wait(request);
+  }
+
+  //! The local function.
+  FunctionType& function;
+
+  //! The communicator of the workers.
+  CommunicatorType& communicator;
+
+  //! Number of elements of the gradient summed at once.
+  size_t bucketSize;
+
+  //! The instantiated compression of the gradients.
+  typename CompressionPolicyType::template Policy<GradType, CommunicatorType>
+      instCompressionPolicy;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * @file data_parallel_sgd.hpp
+ * @author Marcus Edel
+ *
+ * Data-parallel SGD on several workers, which average their gradients with a
+ * communicator before each step.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_SGD_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_SGD_HPP
+
+#include <ensmallen_bits/communicators/communicators.hpp>
+#include <ensmallen_bits/sgd/sgd.hpp>
+
+#include "data_parallel_function.hpp"
+
+namespace ens {
+
+/**
+ * Synchronous data-parallel SGD: each worker (e.g. each MPI process) holds its
+ * own part of the data as a separable function, computes the gradient of a
+ * batch of its part, and the gradients are averaged over the workers (an
+ * allreduce) before the update policy takes the step.  All the workers start
+ * from the coordinates of the first worker and take the same steps, so they
+ * hold the same coordinates all along; a step uses a batch of
+ * batchSize * Size() points.
+ *
+ * The optimization runs in a single call to SGD::Optimize() with any update
+ * and decay policy, so the state of the policies is kept from step to step and
+ * the callbacks see the whole optimization.  The gradient is reduced in
+ * buckets of bucketSize elements whose communication is pipelined (see
+ * DataParallelFunction); a compression policy (TopKCompression or
+ * QuantizedCompression) sends a compressed gradient instead.  The objectives are summed over the workers, so the
+ * tolerance and the returned objective refer to all the data.
+ *
+ * All the workers must have the same number of separable functions, and make
+ * the same calls to Optimize(); the callbacks of all the workers must make the
+ * same decisions to terminate.  The gradients must be dense, and the batches
+ * are not split between OpenMP threads.
+ *
+ * @code
+ * // On each MPI process, with its own part of the data.
+ * LogisticRegression<> localFunction(localData, localResponses);
+ * DataParallelSGD<AdamUpdate, NoDecay, MPICommunicator> optimizer(0.001, 32);
+ * arma::mat coordinates = localFunction.GetInitialPoint();
+ * optimizer.Optimize(localFunction, coordinates);
+ * @endcode
+ *
+ * @tparam UpdatePolicyType Update policy used to take the steps.
+ * @tparam DecayPolicyType Decay policy used to adjust the step size.
+ * @tparam CommunicatorType Communicator of the workers (see NoCommunicator;
+ *     MPICommunicator is available if ENS_USE_MPI is defined).
+ * @tparam CompressionPolicyType Compression of the gradients (see
+ *     NoCompression).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay,
+         typename CommunicatorType = NoCommunicator,
+         typename CompressionPolicyType = NoCompression>
+class DataParallelSGD
+{
+ public:
+  /**
+   * Construct the DataParallelSGD optimizer with the given parameters.  The
+   * maximum number of iterations refers to the maximum number of points that
+   * are processed by each worker.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size of each worker for each step.
+   * @param maxIterations Maximum number of iterations of each worker (0 means
+   *     no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the local function order is shuffled; otherwise,
+   *     each function is visited in linear order.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param communicator Communicator of the workers.
+   * @param bucketSize Number of elements of the gradient averaged at once.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   * @param compressionPolicy Compression of the gradients; its state (e.g.
+   *     the residuals of the error feedback) is reset by every Optimize call.
+   */
+  DataParallelSGD(const double stepSize = 0.01,
+                  const size_t batchSize = 32,
+                  const size_t maxIterations = 100000,
+                  const double tolerance = 1e-5,
+                  const bool shuffle = true,
+                  const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                  const DecayPolicyType& decayPolicy = DecayPolicyType(),
+                  const CommunicatorType& communicator = CommunicatorType(),
+                  const size_t bucketSize = 1048576,
+                  const bool resetPolicy = true,
+                  const CompressionPolicyType& compressionPolicy =
+                      CompressionPolicyType()) :
+      optimizer(stepSize, batchSize, maxIterations, tolerance, shuffle,
+          updatePolicy, decayPolicy, resetPolicy),
+      communicator(communicator),
+      bucketSize(bucketSize),
+      compressionPolicy(compressionPolicy)
+  { /* Nothing to do. */ }
+
+  /**
+   * Optimize the given local function with data-parallel SGD.  The given
+   * starting point is replaced by that of the first worker, then modified to
+   * store the finishing point of the algorithm (the same on all workers), and
+   * the final objective value on all the data is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the local function.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Local function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return optimizer.StepSize(); }
+  //! Modify the step size.
+  double& StepSize() { return optimizer.StepSize(); }
+
+  //! Get the batch size of each worker.
+  size_t BatchSize() const { return optimizer.BatchSize(); }
+  //! Modify the batch size of each worker.
+  size_t& BatchSize() { return optimizer.BatchSize(); }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return optimizer.MaxIterations(); }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return optimizer.MaxIterations(); }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return optimizer.Tolerance(); }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return optimizer.Tolerance(); }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return optimizer.Shuffle(); }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return optimizer.Shuffle(); }
+
+  //! Get whether or not the update policy parameters are reset before
+  //! Optimize call.
+  bool ResetPolicy() const { return optimizer.ResetPolicy(); }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return optimizer.ResetPolicy(); }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const
+  { return optimizer.UpdatePolicy(); }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return optimizer.UpdatePolicy(); }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const
+  { return optimizer.DecayPolicy(); }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return optimizer.DecayPolicy(); }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get the number of elements of the gradient averaged at once.
+  size_t BucketSize() const { return bucketSize; }
+  //! Modify the number of elements of the gradient averaged at once.
+  size_t& BucketSize() { return bucketSize; }
+
+  //! Get the compression of the gradients.
+  const CompressionPolicyType& CompressionPolicy() const
+  { return compressionPolicy; }
+  //! Modify the compression of the gradients.
+  CompressionPolicyType& CompressionPolicy() { return compressionPolicy; }
+
+  /**
+   * Store the state of the optimizer in the given state; see
+   * SGD::SaveState().  The state is the same on all workers.
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
+ private:
+  //! The SGD optimizer that takes the steps.
+  SGD<UpdatePolicyType, DecayPolicyType> optimizer;
+
+  //! The communicator of the workers.
+  CommunicatorType communicator;
+
+  //! Number of elements of the gradient averaged at once.
+  size_t bucketSize;
+
+  //! The compression of the gradients.
+  CompressionPolicyType compressionPolicy;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "data_parallel_sgd_impl.hpp"
+
+#endif
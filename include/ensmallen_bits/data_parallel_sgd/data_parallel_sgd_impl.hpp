@@ -0,0 +1,76 @@
+/**
+ * @file data_parallel_sgd_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of data-parallel SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_SGD_IMPL_HPP
+#define ENSMALLEN_DATA_PARALLEL_SGD_DATA_PARALLEL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "data_parallel_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType,
+         typename CompressionPolicyType>
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type DataParallelSGD<UpdatePolicyType,
+    DecayPolicyType, CommunicatorType, CompressionPolicyType>::Optimize(
+    DecomposableFunctionType& function,
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
+{
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<DecomposableFunctionType, MatType, GradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, MatType,
+      GradType>();
+
+  // All the workers must visit the same number of batches, or they would wait
+  // for each other forever.  Every worker compares its number of functions with
+  // that of the first one, so that they all fail together.
+  unsigned long long numFunctions = f.NumFunctions();
+  communicator.Broadcast(&numFunctions, 1, 0);
+  unsigned long long mismatches = (numFunctions == f.NumFunctions()) ? 0 : 1;
+  communicator.AllReduce(&mismatches, 1);
+  if (mismatches > 0)
+  {
+    std::ostringstream oss;
+    oss << "DataParallelSGD::Optimize(): " << mismatches << " of the "
+        << communicator.Size() << " workers do not have the " << numFunctions
+        << " separable functions of the first worker";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // All the workers start from the coordinates of the first one.
+  communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+  typedef DataParallelFunction<FullFunctionType, MatType, GradType,
+      CommunicatorType, CompressionPolicyType> ParallelFunctionType;
+  ParallelFunctionType parallelFunction(f, communicator, bucketSize,
+      compressionPolicy, iterate.n_rows, iterate.n_cols);
+
+  return optimizer.template Optimize<ParallelFunctionType, MatType, GradType>(
+      parallelFunction, iterate, callbacks...);
+}
+
+} // namespace ens
+
+#endif
@@ -72,6 +72,11 @@ class Eve
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *        function is visited in linear order.
+   * @param exactObjective If true, the objective of the final point is
+   *        computed with an extra pass over all functions once maxIterations
+   *        is reached; otherwise, the objective accumulated during the last
+   *        epoch is returned (scaled to all functions if the epoch is not
+   *        complete).
    */
   Eve(const double stepSize = 0.001,
       const size_t batchSize = 32,
@@ -82,7 +87,8 @@ class Eve
       const double clip = 10,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
-      const bool shuffle = true);
+      const bool shuffle = true,
+      const bool exactObjective = true);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
@@ -147,6 +153,14 @@ class Eve
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get whether or not the final objective is computed with an extra pass.
+  bool ExactObjective() const { return exactObjective; }
+  //! Modify whether or not the final objective is computed with an extra pass.
+  bool& ExactObjective() { return exactObjective; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -178,6 +192,13 @@ class Eve
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! Controls whether or not the final objective is computed with an extra
+  //! pass over all functions.
+  bool exactObjective;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
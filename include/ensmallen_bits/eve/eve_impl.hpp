@@ -29,7 +29,8 @@ inline Eve::Eve(const double stepSize,
                 const double clip,
                 const size_t maxIterations,
                 const double tolerance,
-                const bool shuffle) :
+                const bool shuffle,
+                const bool exactObjective) :
     stepSize(stepSize),
     batchSize(batchSize),
     beta1(beta1),
@@ -39,7 +40,8 @@ inline Eve::Eve(const double stepSize,
     clip(clip),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    exactObjective(exactObjective)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -48,6 +50,8 @@ double Eve::Optimize(
     DecomposableFunctionType& function,
     arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   typedef Function<DecomposableFunctionType> FullFunctionType;
   FullFunctionType& f(static_cast<FullFunctionType&>(function));
 
@@ -82,19 +86,19 @@ double Eve::Optimize(
     if ((currentFunction % numFunctions) == 0 && i > 0)
     {
       // Output current objective function.
-      Info << "Eve: iteration " << i << ", objective " << overallObjective
+      ENS_INFO << "Eve: iteration " << i << ", objective " << overallObjective
           << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
-        Warn << "Eve: converged to " << overallObjective << "; terminating"
+        ENS_WARN << "Eve: converged to " << overallObjective << "; terminating"
             << " with failure.  Try a smaller step size?" << std::endl;
         return overallObjective;
       }
 
       if (std::abs(lastOverallObjective - overallObjective) < tolerance)
       {
-        Info << "Eve: minimized within tolerance " << tolerance << "; "
+        ENS_INFO << "Eve: minimized within tolerance " << tolerance << "; "
             << "terminating optimization." << std::endl;
         return overallObjective;
       }
@@ -151,9 +155,14 @@ double Eve::Optimize(
     currentFunction += effectiveBatchSize;
   }
 
-  Info << "Eve: maximum iterations (" << maxIterations << ") reached; "
+  ENS_INFO << "Eve: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
 
+  // The objective of the last epoch is a cheaper estimate of the final
+  // objective, if the user allows it.
+  if (!exactObjective && currentFunction > 0)
+    return overallObjective * numFunctions / currentFunction;
+
   // Calculate final objective.
   overallObjective = 0;
   for (size_t i = 0; i < numFunctions; i += batchSize)
@@ -0,0 +1,19 @@
+/**
+ * @file executors.hpp
+ * @author Marcus Edel
+ *
+ * Executors that run the tasks of the parallel optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXECUTORS_EXECUTORS_HPP
+#define ENSMALLEN_EXECUTORS_EXECUTORS_HPP
+
+#include "serial_executor.hpp"
+#include "openmp_executor.hpp"
+#include "thread_pool_executor.hpp"
+
+#endif
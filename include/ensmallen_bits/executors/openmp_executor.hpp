@@ -0,0 +1,93 @@
+/**
+ * @file openmp_executor.hpp
+ * @author Marcus Edel
+ *
+ * Executor that runs the tasks on a team of OpenMP threads.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXECUTORS_OPENMP_EXECUTOR_HPP
+#define ENSMALLEN_EXECUTORS_OPENMP_EXECUTOR_HPP
+
+#include <algorithm>
+
+namespace ens {
+
+/**
+ * The default executor of the parallel optimizers: the tasks are split between
+ * the threads of an OpenMP parallel region, by default with as many threads as
+ * omp_get_max_threads() (i.e. OMP_NUM_THREADS).  If OpenMP is not enabled, or
+ * if Run() is called from inside a parallel region, the tasks are run on the
+ * calling thread, so that nested parallelism never oversubscribes the cores.
+ * See SerialExecutor for the interface of an executor.
+ */
+class OpenMPExecutor
+{
+ public:
+  /**
+   * Create the executor with the given number of threads.
+   *
+   * @param threads Maximum number of threads (0 means omp_get_max_threads()).
+   */
+  OpenMPExecutor(const size_t threads = 0) : threads(threads)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of tasks that can run at the same time.
+  size_t Threads() const
+  {
+    #ifdef ENS_USE_OPENMP
+      if (omp_in_parallel())
+        return 1;
+
+      return (threads == 0) ? (size_t) omp_get_max_threads() : threads;
+    #else
+      return 1;
+    #endif
+  }
+
+  //! Run the given tasks on the threads of an OpenMP parallel region.
+  template<typename TaskType>
+  void Run(const size_t tasks, TaskType task)
+  {
+    #ifdef ENS_USE_OPENMP
+      const size_t numThreads = std::min(Threads(), tasks);
+      if (numThreads > 1)
+      {
+        #pragma omp parallel num_threads(numThreads)
+        {
+          // The team may be smaller than requested, so each thread takes
+          // every numThreads'th task.
+          const size_t threadId = omp_get_thread_num();
+          const size_t teamSize = omp_get_num_threads();
+          for (size_t t = threadId; t < tasks; t += teamSize)
+          {
+            ENS_TRACE_ZONE("Task");
+            task(t);
+          }
+        }
+        return;
+      }
+    #endif
+
+    for (size_t t = 0; t < tasks; ++t)
+      task(t);
+  }
+
+  //! Get the maximum number of threads (0 means omp_get_max_threads()).
+  size_t MaxThreads() const { return threads; }
+  //! Modify the maximum number of threads (0 means omp_get_max_threads()).
+  size_t& MaxThreads() { return threads; }
+
+ private:
+  //! The maximum number of threads.
+  size_t threads;
+};
+
+} // namespace ens
+
+#endif
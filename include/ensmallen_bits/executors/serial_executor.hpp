@@ -0,0 +1,55 @@
+/**
+ * @file serial_executor.hpp
+ * @author Marcus Edel
+ *
+ * Executor that runs all the tasks on the calling thread.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXECUTORS_SERIAL_EXECUTOR_HPP
+#define ENSMALLEN_EXECUTORS_SERIAL_EXECUTOR_HPP
+
+namespace ens {
+
+/**
+ * The executor of an optimizer that must not start any thread, e.g. because it
+ * is already called from every thread of a multithreaded application: the
+ * tasks are run one after the other on the calling thread.
+ *
+ * An executor class must implement the following methods:
+ *
+ * @code
+ * // The number of tasks that can run at the same time; the parallel
+ * // optimizers split their work into this many tasks.
+ * size_t Threads();
+ *
+ * // Call task(t) once for every t in [0, tasks), possibly concurrently and in
+ * // any order, and return once all of them are done.
+ * template<typename TaskType>
+ * void Run(const size_t tasks, TaskType task);
+ * @endcode
+ *
+ * Any thread pool can be used through a small class with these two methods;
+ * see OpenMPExecutor (the default) and ThreadPoolExecutor.
+ */
+class SerialExecutor
+{
+ public:
+  //! Get the number of tasks that can run at the same time.
+  size_t Threads() const { return 1; }
+
+  //! Run the given tasks one after the other.
+  template<typename TaskType>
+  void Run(const size_t tasks, TaskType task)
+  {
+    for (size_t t = 0; t < tasks; ++t)
+      task(t);
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file thread_pool_executor.hpp
+ * @author Marcus Edel
+ *
+ * Executor that runs the tasks on a persistent pool of std::thread workers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXECUTORS_THREAD_POOL_EXECUTOR_HPP
+#define ENSMALLEN_EXECUTORS_THREAD_POOL_EXECUTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ens {
+
+/**
+ * An executor with its own pool of threads, which does not need OpenMP.  The
+ * workers are started once, when the executor is created, and wait for work
+ * between two calls to Run(); the calling thread works too.  The tasks of a
+ * call are taken from a shared counter by whichever thread is free, so that
+ * slow tasks are balanced between the threads.
+ *
+ * Copies of the executor share the same pool, so that several optimizers can
+ * be given the same threads; the pool is stopped when the last copy is
+ * destroyed.  Calls to Run() from several threads are serialized, and a call
+ * from inside a task runs its tasks on the calling thread.  If a task throws,
+ * the first exception is rethrown by Run() once all the tasks are done.  See
+ * SerialExecutor for the interface of an executor.
+ *
+ * @code
+ * ThreadPoolExecutor pool(8);
+ * ParallelSGD<ConstantStep, ThreadPoolExecutor> optimizer(0, 0, 1e-5, true,
+ *     ConstantStep(0.01), 1, true, false, pool);
+ * @endcode
+ */
+class ThreadPoolExecutor
+{
+ public:
+  /**
+   * Create the executor and start its threads.
+   *
+   * @param threads Number of threads, including the calling one (0 means
+   *     std::thread::hardware_concurrency()).
+   */
+  ThreadPoolExecutor(const size_t threads = 0) :
+      pool(std::make_shared<Pool>(threads == 0 ?
+          std::max((size_t) std::thread::hardware_concurrency(), (size_t) 1) :
+          threads))
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of tasks that can run at the same time.
+  size_t Threads() const { return Pool::InTask() ? 1 : pool->Threads(); }
+
+  //! Run the given tasks on the threads of the pool.
+  template<typename TaskType>
+  void Run(const size_t tasks, TaskType task)
+  {
+    if (tasks <= 1 || pool->Threads() <= 1 || Pool::InTask())
+    {
+      for (size_t t = 0; t < tasks; ++t)
+        task(t);
+      return;
+    }
+
+    pool->Run(tasks, std::function<void(size_t)>(task));
+  }
+
+ private:
+  /**
+   * The threads of the pool, and the tasks of the current call to Run().
+   */
+  class Pool
+  {
+   public:
+    Pool(const size_t threads) :
+        threads(threads),
+        job(NULL),
+        tasks(0),
+        next(0),
+        pending(0),
+        generation(0),
+        stop(false)
+    {
+      for (size_t i = 1; i < threads; ++i)
+        workers.push_back(std::thread(&Pool::Work, this));
+    }
+
+    ~Pool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      wake.notify_all();
+
+      for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    }
+
+    size_t Threads() const { return threads; }
+
+    void Run(const size_t numTasks, const std::function<void(size_t)>& task)
+    {
+      std::lock_guard<std::mutex> runLock(runMutex);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        tasks = numTasks;
+        next = 0;
+        pending = workers.size();
+        error = std::exception_ptr();
+        ++generation;
+      }
+      wake.notify_all();
+
+      Execute();
+
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [&]() { return pending == 0; });
+      job = NULL;
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+    //! Whether the calling thread is running a task of a pool.
+    static bool& InTask()
+    {
+      static thread_local bool inTask = false;
+      return inTask;
+    }
+
+   private:
+    //! The loop of a worker: wait for a call to Run(), and take its tasks.
+    void Work()
+    {
+      size_t seen = 0;
+      while (true)
+      {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          wake.wait(lock, [&]() { return stop || generation != seen; });
+          if (stop)
+            return;
+          seen = generation;
+        }
+
+        Execute();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0)
+          done.notify_one();
+      }
+    }
+
+    //! Take tasks from the shared counter until there are none left.
+    void Execute()
+    {
+      InTask() = true;
+      for (size_t t = next++; t < tasks; t = next++)
+      {
+        try
+        {
+          ENS_TRACE_ZONE("Task");
+          (*job)(t);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+      InTask() = false;
+    }
+
+    //! The number of threads, including the calling one.
+    size_t threads;
+
+    //! The worker threads.
+    std::vector<std::thread> workers;
+
+    //! The task of the current call to Run().
+    const std::function<void(size_t)>* job;
+
+    //! The number of tasks of the current call to Run().
+    size_t tasks;
+
+    //! The next task to take.
+    std::atomic<size_t> next;
+
+    //! The number of workers that have not finished the current call yet.
+    size_t pending;
+
+    //! The number of calls to Run() so far.
+    size_t generation;
+
+    //! Whether the workers must stop.
+    bool stop;
+
+    //! The first exception thrown by a task of the current call.
+    std::exception_ptr error;
+
+    //! Protects the members above, except next.
+    std::mutex mutex;
+
+    //! Serializes the calls to Run().
+    std::mutex runMutex;
+
+    //! Signals a new call to Run(), or the stop.
+    std::condition_variable wake;
+
+    //! Signals the end of the current call.
+    std::condition_variable done;
+  };
+
+  //! The shared pool.
+  std::shared_ptr<Pool> pool;
+};
+
+} // namespace ens
+
+#endif
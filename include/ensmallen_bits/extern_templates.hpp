@@ -0,0 +1,46 @@
+/**
+ * @file extern_templates.hpp
+ * @author Marcus Edel
+ *
+ * Declarations of the explicit instantiations of the ensmallen_instantiations
+ * library, so that the programs that link it do not compile them again.  Only
+ * included if ENS_USE_EXTERN_TEMPLATES is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EXTERN_TEMPLATES_HPP
+#define ENSMALLEN_EXTERN_TEMPLATES_HPP
+
+namespace ens {
+
+// The optimizers of differentiable functions, on AnyDifferentiableFunction.
+extern template double L_BFGS::Optimize<AnyDifferentiableFunction>(
+    AnyDifferentiableFunction& function,
+    arma::mat& iterate);
+
+extern template double GradientDescent::Optimize<AnyDifferentiableFunction>(
+    AnyDifferentiableFunction& function,
+    arma::mat& iterate);
+
+// The most used SGD variants, on AnySeparableFunction, without callbacks.
+extern template double
+SGD<VanillaUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+extern template double
+SGD<MomentumUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+extern template double
+SGD<AdamUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+} // namespace ens
+
+#endif
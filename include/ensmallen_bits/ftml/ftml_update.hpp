@@ -51,55 +51,9 @@ class FTMLUpdate
              const double beta2 = 0.999) :
       epsilon(epsilon),
       beta1(beta1),
-      beta2(beta2),
-      iteration(0)
+      beta2(beta2)
   { /* Do nothing. */ }
 
-  /**
-   * The Initialize method is called by SGD::Optimize method with UpdatePolicy
-   * FTMLUpdate before the start of the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    v = arma::zeros<arma::mat>(rows, cols);
-    z = arma::zeros<arma::mat>(rows, cols);
-    d = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for FTML.
-   *
-   * @param iterate Parameter that minimizes the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    // And update the iterate.
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
-
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
-
-    arma::mat sigma = -beta1 * d;
-    d = biasCorrection1 / stepSize *
-      (arma::sqrt(v / biasCorrection2) + epsilon);
-    sigma += d;
-
-    z *= beta1;
-    z += (1 - beta1) * gradient - sigma % iterate;
-    iterate = -z / d;
-  }
-
   //! Get the value used to initialise the squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the squared gradient parameter.
@@ -115,6 +69,148 @@ class FTMLUpdate
   //! Modify the second moment coefficient.
   double& Beta2() { return beta2; }
 
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(FTMLUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(z, rows, cols);
+      FirstTouchZeros(d, rows, cols);
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(z, rows, cols);
+      FirstTouchZeros(d, rows, cols);
+      iteration = 0;
+    }
+
+    /**
+     * Update step for FTML.
+     *
+     * @param iterate Parameter that minimizes the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType scale = biasCorrection1 / stepSize;
+      const ElemType correction2 = biasCorrection2;
+
+      ElemType* x = iterate.memptr();
+      ElemType* vMem = v.memptr();
+      ElemType* dMem = d.memptr();
+      ElemType* zMem = z.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // Update v, d and z and compute the new iterate in a single pass.
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+
+          const ElemType dNew = scale * (std::sqrt(vMem[i] / correction2) +
+              epsilon);
+          const ElemType sigma = dNew - beta1 * dMem[i];
+          dMem[i] = dNew;
+
+          zMem[i] = beta1 * zMem[i] + (oneMinusBeta1 * g[i] - sigma * x[i]);
+          x[i] = -zMem[i] / dNew;
+        }
+      });
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("v", v);
+      state.Set("z", z);
+      state.Set("d", d);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("v", v);
+      state.Get("z", z);
+      state.Get("d", d);
+      state.Get("iteration", iteration);
+    }
+
+   private:
+    // Instantiated parent object.
+    FTMLUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    MatType v;
+
+    // The exponential moving average of squared gradient values.
+    MatType z;
+
+    // Parmeter update term.
+    MatType d;
+
+    // The number of iterations.
+    double iteration;
+  };
+
  private:
   // The epsilon value used to initialise the squared gradient parameter.
   double epsilon;
@@ -124,18 +220,6 @@ class FTMLUpdate
 
   // The second moment coefficient.
   double beta2;
-
-  // The exponential moving average of gradient values.
-  arma::mat v;
-
-  // The exponential moving average of squared gradient values.
-  arma::mat z;
-
-  // Parmeter update term.
-  arma::mat d;
-
-  // The number of iterations.
-  double iteration;
 };
 
 } // namespace ens
@@ -0,0 +1,239 @@
+/**
+ * @file ftrl.hpp
+ * @author Marcus Edel
+ *
+ * FTRL-Proximal optimizer with per-coordinate learning rates, for sparse
+ * separable functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FTRL_FTRL_HPP
+#define ENSMALLEN_FTRL_FTRL_HPP
+
+#include <ensmallen_bits/executors/executors.hpp>
+
+namespace ens {
+
+/**
+ * FTRL-Proximal ("Follow The (Proximally) Regularized Leader") with
+ * per-coordinate learning rates, as used for sparse click-through rate models.
+ * For every coordinate i, the optimizer keeps the sum z_i of the gradients
+ * (corrected by the proximal terms) and the sum n_i of the squared gradients;
+ * the weight is then given in closed form by
+ *
+ *   w_i = 0                                                  if |z_i| <= l1,
+ *   w_i = -(z_i - sign(z_i) l1) / ((beta + sqrt(n_i)) / alpha + l2) otherwise.
+ *
+ * The weight of a coordinate only depends on its own z_i and n_i, which only
+ * change when the coordinate has a non-zero gradient.  So each step only
+ * touches the non-zero coordinates of the sparse gradient of the batch, and the
+ * iterate always holds the exact weights: the cost of a step is proportional
+ * to the number of non-zero elements of the gradient, not to the dimension.
+ * The L1 penalty keeps the weights of rarely useful coordinates at exactly zero.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{mcmahan2013ad,
+ *   title     = {Ad Click Prediction: a View from the Trenches},
+ *   author    = {McMahan, H. Brendan and Holt, Gary and Sculley, D. and
+ *                Young, Michael and Ebner, Dietmar and Grady, Julian and
+ *                Nie, Lan and Phillips, Todd and Davydov, Eugene and
+ *                Golovin, Daniel and others},
+ *   booktitle = {Proceedings of the 19th ACM SIGKDD International Conference
+ *                on Knowledge Discovery and Data Mining},
+ *   pages     = {1222--1230},
+ *   year      = {2013}
+ * }
+ * @endcode
+ *
+ * With a parallel executor, each thread processes its own part of the batches
+ * of a pass and updates z, n and the iterate without any synchronization, as in
+ * HOGWILD!; this works well when the gradients of the batches rarely share
+ * coordinates.
+ *
+ * FTRLProximal can optimize sparse differentiable separable functions.  For
+ * more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam ExecutorType Executor that runs the threads (see SerialExecutor,
+ *     OpenMPExecutor, and ThreadPoolExecutor).
+ */
+template<typename ExecutorType = SerialExecutor>
+class FTRLProximalType
+{
+ public:
+  /**
+   * Construct the FTRL-Proximal optimizer with the given parameters.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.
+   *
+   * @param alpha Scale of the per-coordinate learning rates.
+   * @param beta Smoothing term of the per-coordinate learning rates.
+   * @param l1 L1 regularization strength; larger values give sparser weights.
+   * @param l2 L2 regularization strength.
+   * @param batchSize Number of datapoints in each gradient evaluation.
+   * @param maxIterations Maximum number of passes over the data (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param shuffle If true, the batches are visited in a new random order in
+   *     every pass; otherwise, they are visited in linear order.
+   * @param executor The executor that runs the threads; each thread of a pass
+   *     is one task of the executor.
+   */
+  FTRLProximalType(const double alpha = 0.1,
+                   const double beta = 1.0,
+                   const double l1 = 0.0,
+                   const double l2 = 0.0,
+                   const size_t batchSize = 1,
+                   const size_t maxIterations = 100,
+                   const double tolerance = 1e-5,
+                   const bool shuffle = true,
+                   const ExecutorType& executor = ExecutorType());
+
+  /**
+   * Optimize the given function using FTRL-Proximal.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * value of the loss function (without the L1 and L2 terms) at the final
+   * point is returned.  By default the gradient is sparse; a dense GradType can
+   * be specified explicitly for functions that only provide a dense
+   * Gradient(), but then each step costs O(d).
+   *
+   * @tparam SparseFunctionType Type of function to be optimized.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param function Function to be optimized (minimized).
+   * @param iterate Starting point (will be modified).
+   * @return Objective value at the final point.
+   */
+  template<typename SparseFunctionType,
+           typename MatType,
+           typename GradType = arma::SpMat<typename MatType::elem_type>>
+  typename MatType::elem_type Optimize(SparseFunctionType& function,
+                                       MatType& iterate);
+
+  //! Get the scale of the learning rates.
+  double Alpha() const { return alpha; }
+  //! Modify the scale of the learning rates.
+  double& Alpha() { return alpha; }
+
+  //! Get the smoothing term of the learning rates.
+  double Beta() const { return beta; }
+  //! Modify the smoothing term of the learning rates.
+  double& Beta() { return beta; }
+
+  //! Get the L1 regularization strength.
+  double L1() const { return l1; }
+  //! Modify the L1 regularization strength.
+  double& L1() { return l1; }
+
+  //! Get the L2 regularization strength.
+  double L2() const { return l2; }
+  //! Modify the L2 regularization strength.
+  double& L2() { return l2; }
+
+  //! Get the number of datapoints in each gradient evaluation.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of datapoints in each gradient evaluation.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of passes (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of passes (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Update z, n and the weight of every non-zero coordinate of the sparse
+   * gradient.
+   */
+  template<typename MatType, typename eT>
+  void UpdateCoordinates(MatType& iterate,
+                         MatType& z,
+                         MatType& n,
+                         const arma::SpMat<eT>& gradient) const;
+
+  /**
+   * Update z, n and the weight of every non-zero coordinate of the dense
+   * gradient.
+   */
+  template<typename MatType, typename DenseGradType>
+  void UpdateCoordinates(MatType& iterate,
+                         MatType& z,
+                         MatType& n,
+                         const DenseGradType& gradient) const;
+
+  /**
+   * Update the state and the weight of one coordinate with the given gradient.
+   */
+  template<typename MatType>
+  void UpdateCoordinate(MatType& iterate,
+                        MatType& z,
+                        MatType& n,
+                        const size_t k,
+                        const double g) const;
+
+  //! Get the weight given by the sums z and n of a coordinate.
+  double Weight(const double z, const double n) const;
+
+  //! The scale of the learning rates.
+  double alpha;
+
+  //! The smoothing term of the learning rates.
+  double beta;
+
+  //! The L1 regularization strength.
+  double l1;
+
+  //! The L2 regularization strength.
+  double l2;
+
+  //! The number of datapoints in each gradient evaluation.
+  size_t batchSize;
+
+  //! The maximum number of passes over the data.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are shuffled.
+  bool shuffle;
+
+  //! The executor that runs the threads.
+  ExecutorType executor;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+//! FTRL-Proximal on the calling thread.
+typedef FTRLProximalType<SerialExecutor> FTRLProximal;
+
+} // namespace ens
+
+// Include implementation.
+#include "ftrl_impl.hpp"
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * @file ftrl_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the FTRL-Proximal optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FTRL_FTRL_IMPL_HPP
+#define ENSMALLEN_FTRL_FTRL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "ftrl.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename ExecutorType>
+FTRLProximalType<ExecutorType>::FTRLProximalType(
+    const double alpha,
+    const double beta,
+    const double l1,
+    const double l2,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const ExecutorType& executor) :
+    alpha(alpha),
+    beta(beta),
+    l1(l1),
+    l2(l2),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    executor(executor)
+{ /* Nothing to do. */ }
+
+template<typename ExecutorType>
+template<typename SparseFunctionType, typename MatType, typename GradType>
+typename MatType::elem_type FTRLProximalType<ExecutorType>::Optimize(
+    SparseFunctionType& function,
+    MatType& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  typedef typename MatType::elem_type ElemType;
+
+  // Check that we have all the functions that we need.
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType, MatType, GradType>();
+
+  typedef Function<SparseFunctionType, MatType, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  if (alpha <= 0.0)
+  {
+    std::ostringstream oss;
+    oss << "FTRLProximal::Optimize(): alpha must be positive, but is "
+        << alpha << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Start from the given iterate: with n = 0, the weight given by z is the
+  // starting weight.  If neither beta nor l2 is positive, no finite z gives a
+  // non-zero weight, and the optimization starts from zero.
+  MatType n(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  MatType z(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  const double startDenominator = beta / alpha + l2;
+  for (size_t k = 0; k < iterate.n_elem; ++k)
+  {
+    const double w = iterate[k];
+    if (w != 0.0 && startDenominator > 0.0)
+      z[k] = ElemType(-w * startDenominator - ((w > 0.0) ? l1 : -l1));
+    iterate[k] = ElemType(Weight(z[k], 0.0));
+  }
+
+  // The functions are visited in batches of batchSize consecutive functions;
+  // the last batch may be smaller.
+  const size_t numFunctions = f.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  // The order in which the batches will be visited.
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numBatches - 1), numBatches);
+
+  // The batches are shuffled with a random stream of this optimization.
+  RandomGenerator generator = NewRandomGenerator();
+
+  // Each thread processes a contiguous part of the batches of a pass.
+  const size_t numShares = std::min(std::max(executor.Threads(), (size_t) 1),
+      numBatches);
+
+  ElemType overallObjective = f.Evaluate(iterate);
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+  for (size_t i = 1; i != maxIterations + 1 || maxIterations == 0; ++i)
+  {
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      ENS_WARN << "FTRLProximal: converged to " << overallObjective
+          << "; terminating with failure.  Try a smaller alpha?" << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      ENS_INFO << "FTRLProximal: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    if (shuffle)
+      generator.Shuffle(visitationOrder);
+
+    executor.Run(numShares, [&](const size_t share)
+    {
+      // The gradient buffer is reused for every batch of the share.
+      GradType gradient;
+
+      const size_t shareEnd = (share + 1) * numBatches / numShares;
+      for (size_t j = share * numBatches / numShares; j < shareEnd; ++j)
+      {
+        const size_t begin = visitationOrder[j] * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
+
+        f.Gradient(iterate, begin, gradient, effectiveBatchSize);
+        UpdateCoordinates(iterate, z, n, gradient);
+      }
+    });
+
+    lastObjective = overallObjective;
+    overallObjective = f.Evaluate(iterate);
+
+    // Output current objective function.
+    ENS_INFO << "FTRLProximal: pass " << i << ", objective "
+        << overallObjective << "." << std::endl;
+  }
+
+  ENS_INFO << "FTRLProximal: maximum iterations (" << maxIterations
+      << ") reached; terminating optimization." << std::endl;
+  return overallObjective;
+}
+
+template<typename ExecutorType>
+template<typename MatType, typename eT>
+void FTRLProximalType<ExecutorType>::UpdateCoordinates(
+    MatType& iterate,
+    MatType& z,
+    MatType& n,
+    const arma::SpMat<eT>& gradient) const
+{
+  // Only the non-zero elements are visited.
+  typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+  for (; cur != gradient.end(); ++cur)
+  {
+    UpdateCoordinate(iterate, z, n, cur.row() + cur.col() * iterate.n_rows,
+        *cur);
+  }
+}
+
+template<typename ExecutorType>
+template<typename MatType, typename DenseGradType>
+void FTRLProximalType<ExecutorType>::UpdateCoordinates(
+    MatType& iterate,
+    MatType& z,
+    MatType& n,
+    const DenseGradType& gradient) const
+{
+  for (size_t k = 0; k < gradient.n_elem; ++k)
+  {
+    if (gradient[k] != 0)
+      UpdateCoordinate(iterate, z, n, k, gradient[k]);
+  }
+}
+
+template<typename ExecutorType>
+template<typename MatType>
+inline void FTRLProximalType<ExecutorType>::UpdateCoordinate(
+    MatType& iterate,
+    MatType& z,
+    MatType& n,
+    const size_t k,
+    const double g) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // sigma is the increase of the inverse learning rate, which centers the new
+  // proximal term at the current weight.
+  const double nOld = n[k];
+  const double nNew = nOld + g * g;
+  const double sigma = (std::sqrt(nNew) - std::sqrt(nOld)) / alpha;
+  const double zNew = z[k] + g - sigma * iterate[k];
+
+  z[k] = ElemType(zNew);
+  n[k] = ElemType(nNew);
+  iterate[k] = ElemType(Weight(zNew, nNew));
+}
+
+template<typename ExecutorType>
+inline double FTRLProximalType<ExecutorType>::Weight(const double z,
+                                                     const double n) const
+{
+  if (std::abs(z) <= l1)
+    return 0.0;
+
+  const double denominator = (beta + std::sqrt(n)) / alpha + l2;
+  if (denominator <= 0.0)
+    return 0.0;
+
+  return -(z - ((z > 0.0) ? l1 : -l1)) / denominator;
+}
+
+} // namespace ens
+
+#endif
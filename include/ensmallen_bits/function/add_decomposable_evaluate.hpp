@@ -3,7 +3,9 @@
  * @author Ryan Curtin
  *
  * Adds a decomposable Evaluate() function if a decomposable
- * EvaluateWithGradient() function exists.
+ * EvaluateWithGradient() function exists.  The objective-only form of
+ * EvaluateWithGradient() is used when the function has one (see
+ * ObjectiveOnly).
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
  * the terms of the 3-clause BSD license.  You should have received a copy of
@@ -13,7 +15,7 @@
 #ifndef ENSMALLEN_FUNCTION_ADD_DECOMPOSABLE_EVALUATE_HPP
 #define ENSMALLEN_FUNCTION_ADD_DECOMPOSABLE_EVALUATE_HPP
 
-#include "traits.hpp"
+#include "objective_only.hpp"
 
 namespace ens {
 
@@ -23,12 +25,16 @@ namespace ens {
  * otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasDecomposableEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::DecomposableEvaluateWithGradientForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateWithGradientForm>::value,
          bool HasDecomposableEvaluate =
              traits::HasEvaluate<FunctionType,
-                 traits::DecomposableEvaluateForm>::value>
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateForm>::value>
 class AddDecomposableEvaluate
 {
  public:
@@ -39,19 +45,23 @@ class AddDecomposableEvaluate
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasDecomposableEvaluateWithGradient>
-class AddDecomposableEvaluate<FunctionType, HasDecomposableEvaluateWithGradient,
-    true>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasDecomposableEvaluateWithGradient>
+class AddDecomposableEvaluate<FunctionType, MatType, GradType,
+    HasDecomposableEvaluateWithGradient, true>
 {
  public:
   // Reflect the existing Evaluate().
-  double Evaluate(const arma::mat& coordinates,
-                  const size_t begin,
-                  const size_t batchSize)
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
     return static_cast<FunctionType*>(
-        static_cast<Function<FunctionType>*>(this))->Evaluate(coordinates,
-        begin, batchSize);
+        static_cast<Function<FunctionType, MatType, GradType>*>(
+        this))->Evaluate(coordinates, begin, batchSize);
   }
 };
 
@@ -59,8 +69,8 @@ class AddDecomposableEvaluate<FunctionType, HasDecomposableEvaluateWithGradient,
  * If we have a decomposable EvaluateWithGradient() but not a decomposable
  * Evaluate(), add a decomposable Evaluate() method.
  */
-template<typename FunctionType>
-class AddDecomposableEvaluate<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddDecomposableEvaluate<FunctionType, MatType, GradType, true, false>
 {
  public:
   /**
@@ -71,13 +81,14 @@ class AddDecomposableEvaluate<FunctionType, true, false>
    * @param begin Index of first function to evaluate.
    * @param batchSize Number of functions to evaluate.
    */
-  double Evaluate(const arma::mat& coordinates,
-                  const size_t begin,
-                  const size_t batchSize)
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize)
   {
-    arma::mat gradient; // This will be ignored.
-    return static_cast<Function<FunctionType>*>(this)->EvaluateWithGradient(
-        coordinates, begin, gradient, batchSize);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasDecomposableObjectiveOnly<FunctionType, MatType,
+            GradType>::value>::Evaluate(*static_cast<Function<FunctionType,
+        MatType, GradType>*>(this), coordinates, begin, batchSize);
   }
 };
 
@@ -87,12 +98,16 @@ class AddDecomposableEvaluate<FunctionType, true, false>
  * exists, or nothing otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasDecomposableEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::DecomposableEvaluateWithGradientConstForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateWithGradientConstForm>::value,
          bool HasDecomposableEvaluate =
              traits::HasEvaluate<FunctionType,
-                 traits::DecomposableEvaluateConstForm>::value>
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateConstForm>::value>
 class AddDecomposableEvaluateConst
 {
  public:
@@ -104,19 +119,23 @@ class AddDecomposableEvaluateConst
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasDecomposableEvaluateWithGradient>
-class AddDecomposableEvaluateConst<FunctionType,
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasDecomposableEvaluateWithGradient>
+class AddDecomposableEvaluateConst<FunctionType, MatType, GradType,
     HasDecomposableEvaluateWithGradient, true>
 {
  public:
   // Reflect the existing Evaluate().
-  double Evaluate(const arma::mat& coordinates,
-                  const size_t begin,
-                  const size_t batchSize) const
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize) const
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
     return static_cast<const FunctionType*>(
-        static_cast<const Function<FunctionType>*>(this))->Evaluate(coordinates,
-        begin, batchSize);
+        static_cast<const Function<FunctionType, MatType, GradType>*>(
+        this))->Evaluate(coordinates, begin, batchSize);
   }
 };
 
@@ -124,8 +143,9 @@ class AddDecomposableEvaluateConst<FunctionType,
  * If we have a decomposable const EvaluateWithGradient() but not a decomposable
  * const Evaluate(), add a decomposable const Evaluate() method.
  */
-template<typename FunctionType>
-class AddDecomposableEvaluateConst<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddDecomposableEvaluateConst<FunctionType, MatType, GradType, true,
+    false>
 {
  public:
   /**
@@ -136,14 +156,15 @@ class AddDecomposableEvaluateConst<FunctionType, true, false>
    * @param begin Index of first function to evaluate.
    * @param batchSize Number of functions to evaluate.
    */
-  double Evaluate(const arma::mat& coordinates,
-                  const size_t begin,
-                  const size_t batchSize) const
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize) const
   {
-    arma::mat gradient; // This will be ignored.
-    return
-        static_cast<const Function<FunctionType>*>(this)->EvaluateWithGradient(
-        coordinates, begin, gradient, batchSize);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasDecomposableObjectiveOnly<FunctionType, MatType,
+            GradType>::constValue>::Evaluate(*static_cast<const Function<
+        FunctionType, MatType, GradType>*>(this), coordinates, begin,
+        batchSize);
   }
 };
 
@@ -153,12 +174,16 @@ class AddDecomposableEvaluateConst<FunctionType, true, false>
  * exists, or nothing otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasDecomposableEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::DecomposableEvaluateWithGradientStaticForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateWithGradientStaticForm>::value,
          bool HasDecomposableEvaluate =
              traits::HasEvaluate<FunctionType,
-                 traits::DecomposableEvaluateStaticForm>::value>
+                 traits::TypedForms<MatType, GradType>::template
+                     DecomposableEvaluateStaticForm>::value>
 class AddDecomposableEvaluateStatic
 {
  public:
@@ -169,16 +194,20 @@ class AddDecomposableEvaluateStatic
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasDecomposableEvaluateWithGradient>
-class AddDecomposableEvaluateStatic<FunctionType,
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasDecomposableEvaluateWithGradient>
+class AddDecomposableEvaluateStatic<FunctionType, MatType, GradType,
     HasDecomposableEvaluateWithGradient, true>
 {
  public:
   // Reflect the existing Evaluate().
-  static double Evaluate(const arma::mat& coordinates,
-                         const size_t begin,
-                         const size_t batchSize)
+  static typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                              const size_t begin,
+                                              const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
     return FunctionType::Evaluate(coordinates, begin, batchSize);
   }
 };
@@ -187,8 +216,9 @@ class AddDecomposableEvaluateStatic<FunctionType,
  * If we have a decomposable EvaluateWithGradient() but not a decomposable
  * Evaluate(), add a decomposable Evaluate() method.
  */
-template<typename FunctionType>
-class AddDecomposableEvaluateStatic<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddDecomposableEvaluateStatic<FunctionType, MatType, GradType, true,
+    false>
 {
  public:
   /**
@@ -199,12 +229,14 @@ class AddDecomposableEvaluateStatic<FunctionType, true, false>
    * @param begin Index of first function to evaluate.
    * @param batchSize Number of functions to evaluate.
    */
-  static double Evaluate(const arma::mat& coordinates,
-                         const size_t begin,
-                         const size_t batchSize)
+  static typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                              const size_t begin,
+                                              const size_t batchSize)
   {
-    arma::mat gradient; // This will be ignored.
-    return FunctionType::EvaluateWithGradient(coordinates, begin, gradient,
+    ENS_PROFILE_FUNCTION(EvaluateWithGradient);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasDecomposableObjectiveOnly<FunctionType, MatType,
+            GradType>::staticValue>::EvaluateStatic(coordinates, begin,
         batchSize);
   }
 };
@@ -47,6 +47,7 @@ class AddDecomposableEvaluate<FunctionType, HasDecomposableEvaluateWithGradient,
   // Reflect the existing Evaluate().
   double Evaluate(const arma::mat& coordinates, const size_t index)
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
     return static_cast<FunctionType*>(
         static_cast<Function<FunctionType>*>(this))->Evaluate(coordinates,
         index);
@@ -154,6 +155,7 @@ class AddDecomposableEvaluateStatic<FunctionType, true, false>
                          const size_t begin,
                          const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(EvaluateWithGradient);
     arma::mat gradient; // This will be ignored.
     return FunctionType::EvaluateWithGradient(coordinates, begin, gradient,
         batchSize);
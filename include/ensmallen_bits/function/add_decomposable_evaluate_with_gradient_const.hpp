@@ -123,6 +123,8 @@ class AddDecomposableEvaluateWithGradient<FunctionType, true, true, false> :
                               arma::mat& gradient,
                               const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    ENS_PROFILE_FUNCTION(Gradient);
     const double objective = FunctionType::Evaluate(coordinates, begin,
         batchSize);
     FunctionType::Gradient(coordinates, begin, gradient, batchSize);
@@ -148,6 +150,7 @@ class AddDecomposableEvaluateWithGradient<FunctionType, false, true, true> :
                   const size_t begin,
                   const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(EvaluateWithGradient);
     arma::mat gradient; // This will be ignored.
     return FunctionType::EvaluateWithGradient(coordinates, begin, gradient,
         batchSize);
@@ -174,6 +177,7 @@ class AddDecomposableEvaluateWithGradient<FunctionType, true, false, true> :
                 arma::mat& gradient,
                 const size_t batchSize)
   {
+    ENS_PROFILE_FUNCTION(EvaluateWithGradient);
     // The returned objective value will be ignored.
     (void) FunctionType::EvaluateWithGradient(coordinates, begin, gradient,
         batchSize);
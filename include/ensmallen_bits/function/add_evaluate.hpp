@@ -4,6 +4,8 @@
  *
  * This file defines a mixin for the Function class that will ensure that the
  * function Evaluate() is avaliable if EvaluateWithGradient() is available.
+ * The objective-only form of EvaluateWithGradient() is used when the function
+ * has one (see ObjectiveOnly).
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
  * the terms of the 3-clause BSD license.  You should have received a copy of
@@ -13,7 +15,7 @@
 #ifndef ENSMALLEN_FUNCTION_ADD_EVALUATE_HPP
 #define ENSMALLEN_FUNCTION_ADD_EVALUATE_HPP
 
-#include "traits.hpp"
+#include "objective_only.hpp"
 
 namespace ens {
 
@@ -22,11 +24,16 @@ namespace ens {
  * FunctionType has EvaluateWithGradient(), or nothing otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::EvaluateWithGradientForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateWithGradientForm>::value,
          bool HasEvaluate =
-             traits::HasEvaluate<FunctionType, traits::EvaluateForm>::value>
+             traits::HasEvaluate<FunctionType,
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateForm>::value>
 class AddEvaluate
 {
  public:
@@ -37,14 +44,20 @@ class AddEvaluate
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasEvaluateWithGradient>
-class AddEvaluate<FunctionType, HasEvaluateWithGradient, true>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasEvaluateWithGradient>
+class AddEvaluate<FunctionType, MatType, GradType, HasEvaluateWithGradient,
+    true>
 {
  public:
   // Reflect the existing Evaluate().
-  double Evaluate(const arma::mat& coordinates)
+  typename MatType::elem_type Evaluate(const MatType& coordinates)
   {
-    return static_cast<FunctionType*>(static_cast<Function<FunctionType>*>(
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return static_cast<FunctionType*>(
+        static_cast<Function<FunctionType, MatType, GradType>*>(
         this))->Evaluate(coordinates);
   }
 };
@@ -53,8 +66,8 @@ class AddEvaluate<FunctionType, HasEvaluateWithGradient, true>
  * If we have EvaluateWithGradient() but no existing Evaluate(), add an
  * Evaluate() method.
  */
-template<typename FunctionType>
-class AddEvaluate<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddEvaluate<FunctionType, MatType, GradType, true, false>
 {
  public:
   /**
@@ -62,11 +75,12 @@ class AddEvaluate<FunctionType, true, false>
    *
    * @param coordinates Coordinates to evaluate the function at.
    */
-  double Evaluate(const arma::mat& coordinates)
+  typename MatType::elem_type Evaluate(const MatType& coordinates)
   {
-    arma::mat gradient; // This will be ignored.
-    return static_cast<Function<FunctionType>*>(this)->EvaluateWithGradient(
-        coordinates, gradient);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasObjectiveOnly<FunctionType, MatType, GradType>::value>::
+        Evaluate(*static_cast<Function<FunctionType, MatType, GradType>*>(
+        this), coordinates);
   }
 };
 
@@ -76,12 +90,16 @@ class AddEvaluate<FunctionType, true, false>
  * otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::EvaluateWithGradientConstForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateWithGradientConstForm>::value,
          bool HasEvaluate =
              traits::HasEvaluate<FunctionType,
-                 traits::EvaluateConstForm>::value>
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateConstForm>::value>
 class AddEvaluateConst
 {
  public:
@@ -92,16 +110,21 @@ class AddEvaluateConst
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasEvaluateWithGradient>
-class AddEvaluateConst<FunctionType, HasEvaluateWithGradient, true>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasEvaluateWithGradient>
+class AddEvaluateConst<FunctionType, MatType, GradType,
+    HasEvaluateWithGradient, true>
 {
  public:
   // Reflect the existing Evaluate().
-  double Evaluate(const arma::mat& coordinates) const
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
   {
-    return static_cast<const FunctionType*>(static_cast<const
-Function<FunctionType>*>(this))->Evaluate(
-        coordinates);
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return static_cast<const FunctionType*>(
+        static_cast<const Function<FunctionType, MatType, GradType>*>(
+        this))->Evaluate(coordinates);
   }
 };
 
@@ -109,8 +132,8 @@ Function<FunctionType>*>(this))->Evaluate(
  * If we have EvaluateWithGradient() but no existing Evaluate(), add an
  * Evaluate() without a using directive to make the base Evaluate() accessible.
  */
-template<typename FunctionType>
-class AddEvaluateConst<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddEvaluateConst<FunctionType, MatType, GradType, true, false>
 {
  public:
   /**
@@ -118,12 +141,12 @@ class AddEvaluateConst<FunctionType, true, false>
    *
    * @param coordinates Coordinates to evaluate the function at.
    */
-  double Evaluate(const arma::mat& coordinates) const
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
   {
-    arma::mat gradient; // This will be ignored.
-    return static_cast<
-        const Function<FunctionType>*>(this)->EvaluateWithGradient(coordinates,
-        gradient);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasObjectiveOnly<FunctionType, MatType, GradType>::constValue>::
+        Evaluate(*static_cast<const Function<FunctionType, MatType,
+        GradType>*>(this), coordinates);
   }
 };
 
@@ -133,12 +156,16 @@ class AddEvaluateConst<FunctionType, true, false>
  * otherwise.
  */
 template<typename FunctionType,
+         typename MatType,
+         typename GradType,
          bool HasEvaluateWithGradient =
              traits::HasEvaluateWithGradient<FunctionType,
-                 traits::EvaluateWithGradientStaticForm>::value,
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateWithGradientStaticForm>::value,
          bool HasEvaluate =
              traits::HasEvaluate<FunctionType,
-                 traits::EvaluateStaticForm>::value>
+                 traits::TypedForms<MatType, GradType>::template
+                     EvaluateStaticForm>::value>
 class AddEvaluateStatic
 {
  public:
@@ -149,13 +176,18 @@ class AddEvaluateStatic
 /**
  * Reflect the existing Evaluate().
  */
-template<typename FunctionType, bool HasEvaluateWithGradient>
-class AddEvaluateStatic<FunctionType, HasEvaluateWithGradient, true>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasEvaluateWithGradient>
+class AddEvaluateStatic<FunctionType, MatType, GradType,
+    HasEvaluateWithGradient, true>
 {
  public:
   // Reflect the existing Evaluate().
-  static double Evaluate(const arma::mat& coordinates)
+  static typename MatType::elem_type Evaluate(const MatType& coordinates)
   {
+    ENS_PROFILE_FUNCTION(Evaluate);
     return FunctionType::Evaluate(coordinates);
   }
 };
@@ -164,8 +196,8 @@ class AddEvaluateStatic<FunctionType, HasEvaluateWithGradient, true>
  * If we have EvaluateWithGradient() but no existing Evaluate(), add an
  * Evaluate() without a using directive to make the base Evaluate() accessible.
  */
-template<typename FunctionType>
-class AddEvaluateStatic<FunctionType, true, false>
+template<typename FunctionType, typename MatType, typename GradType>
+class AddEvaluateStatic<FunctionType, MatType, GradType, true, false>
 {
  public:
   /**
@@ -173,10 +205,12 @@ class AddEvaluateStatic<FunctionType, true, false>
    *
    * @param coordinates Coordinates to evaluate the function at.
    */
-  static double Evaluate(const arma::mat& coordinates)
+  static typename MatType::elem_type Evaluate(const MatType& coordinates)
   {
-    arma::mat gradient; // This will be ignored.
-    return FunctionType::EvaluateWithGradient(coordinates, gradient);
+    ENS_PROFILE_FUNCTION(EvaluateWithGradient);
+    return ObjectiveOnlyEvaluation<FunctionType, MatType, GradType,
+        traits::HasObjectiveOnly<FunctionType, MatType, GradType>::
+        staticValue>::EvaluateStatic(coordinates);
   }
 };
 
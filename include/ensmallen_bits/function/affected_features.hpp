@@ -0,0 +1,81 @@
+/**
+ * @file affected_features.hpp
+ * @author Marcus Edel
+ *
+ * Find the features whose partial gradient changes when a single feature is
+ * updated with the AffectedFeatures() method of a function, if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_AFFECTED_FEATURES_HPP
+#define ENSMALLEN_FUNCTION_AFFECTED_FEATURES_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * FeatureDependencies calls the AffectedFeatures() method of functions that
+ * have one (see traits::HasFeatureDependencies), and reports that every
+ * feature may be affected for the others.
+ *
+ * @tparam FunctionType Type of the partially differentiable function.
+ */
+template<typename FunctionType,
+         bool HasDependencies =
+             traits::HasFeatureDependencies<FunctionType>::value>
+class FeatureDependencies
+{
+ public:
+  //! The function has no AffectedFeatures() method.
+  static bool Affected(FunctionType& /* function */,
+                       const size_t /* feature */,
+                       arma::uvec& /* affected */)
+  {
+    return false;
+  }
+};
+
+/**
+ * Specialization for functions with an AffectedFeatures() method.
+ */
+template<typename FunctionType>
+class FeatureDependencies<FunctionType, true>
+{
+ public:
+  //! Get the affected features with AffectedFeatures().
+  static bool Affected(FunctionType& function,
+                       const size_t feature,
+                       arma::uvec& affected)
+  {
+    function.AffectedFeatures(feature, affected);
+    return true;
+  }
+};
+
+/**
+ * Store in affected the indices of the features whose partial gradient may
+ * change when the given feature is updated, with the AffectedFeatures() method
+ * of the function, if it has one.  If false is returned, the caller must assume
+ * that every partial gradient may have changed.
+ *
+ * @param function Partially differentiable function.
+ * @param feature Index of the updated feature.
+ * @param affected Vector to store the indices of the affected features in.
+ * @return true if the affected features were found.
+ */
+template<typename FunctionType>
+inline bool TryAffectedFeatures(FunctionType& function,
+                                const size_t feature,
+                                arma::uvec& affected)
+{
+  return FeatureDependencies<FunctionType>::Affected(function, feature,
+      affected);
+}
+
+} // namespace ens
+
+#endif
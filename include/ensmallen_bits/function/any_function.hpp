@@ -0,0 +1,258 @@
+/**
+ * @file any_function.hpp
+ * @author Marcus Edel
+ *
+ * Non-owning type-erased wrappers for differentiable and separable functions
+ * on arma::mat, so that an optimizer compiled once can be used for any
+ * function.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_ANY_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_ANY_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * AnyDifferentiableFunction refers to any differentiable function on arma::mat
+ * coordinates, through function pointers.  Every function then has the same
+ * type, so that the optimizer code is compiled only once for all of them; the
+ * explicit instantiations of the ensmallen_instantiations library are made on
+ * this type (see ENS_USE_EXTERN_TEMPLATES).  The methods that the function
+ * lacks are provided as with Function<>.
+ *
+ * @code
+ * RosenbrockFunction f;
+ * AnyDifferentiableFunction any(f);
+ *
+ * L_BFGS optimizer;
+ * optimizer.Optimize(any, coordinates);
+ * @endcode
+ *
+ * The wrapper does not copy the function, which must outlive it.  The cost of
+ * the indirection is that of one function call per evaluation.
+ */
+class AnyDifferentiableFunction
+{
+ public:
+  /**
+   * Refer to the given function.
+   *
+   * @param function Differentiable function to wrap.
+   */
+  template<typename FunctionType>
+  AnyDifferentiableFunction(FunctionType& function) :
+      function(&function),
+      evaluate(&EvaluateThunk<FunctionType>),
+      gradient(&GradientThunk<FunctionType>),
+      evaluateWithGradient(&EvaluateWithGradientThunk<FunctionType>)
+  {
+    traits::CheckFunctionTypeAPI<Function<FunctionType, arma::mat, arma::mat>,
+        arma::mat, arma::mat>();
+  }
+
+  //! Evaluate the function at the given coordinates.
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return evaluate(function, coordinates);
+  }
+
+  //! Compute the gradient of the function at the given coordinates.
+  void Gradient(const arma::mat& coordinates, arma::mat& g)
+  {
+    gradient(function, coordinates, g);
+  }
+
+  //! Evaluate the function and its gradient at the given coordinates.
+  double EvaluateWithGradient(const arma::mat& coordinates, arma::mat& g)
+  {
+    return evaluateWithGradient(function, coordinates, g);
+  }
+
+ private:
+  template<typename FunctionType>
+  static double EvaluateThunk(void* function, const arma::mat& coordinates)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    return static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->Evaluate(coordinates);
+  }
+
+  template<typename FunctionType>
+  static void GradientThunk(void* function,
+                            const arma::mat& coordinates,
+                            arma::mat& g)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->Gradient(coordinates, g);
+  }
+
+  template<typename FunctionType>
+  static double EvaluateWithGradientThunk(void* function,
+                                          const arma::mat& coordinates,
+                                          arma::mat& g)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    return static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->EvaluateWithGradient(coordinates, g);
+  }
+
+  //! The wrapped function.
+  void* function;
+
+  //! Evaluate() of the wrapped function.
+  double (*evaluate)(void*, const arma::mat&);
+
+  //! Gradient() of the wrapped function.
+  void (*gradient)(void*, const arma::mat&, arma::mat&);
+
+  //! EvaluateWithGradient() of the wrapped function.
+  double (*evaluateWithGradient)(void*, const arma::mat&, arma::mat&);
+};
+
+/**
+ * AnySeparableFunction refers to any differentiable separable function on
+ * arma::mat coordinates, through function pointers, so that the SGD-like
+ * optimizers are compiled only once for all of them (see
+ * AnyDifferentiableFunction).  The methods that the function lacks are
+ * provided as with Function<>.
+ *
+ * @code
+ * LogisticRegressionFunction<> lrf(data, responses, 0.5);
+ * AnySeparableFunction any(lrf);
+ *
+ * SGD<AdamUpdate> optimizer(0.01, 32);
+ * optimizer.Optimize(any, coordinates);
+ * @endcode
+ *
+ * The wrapper does not copy the function, which must outlive it.
+ */
+class AnySeparableFunction
+{
+ public:
+  /**
+   * Refer to the given function.
+   *
+   * @param function Differentiable separable function to wrap.
+   */
+  template<typename FunctionType>
+  AnySeparableFunction(FunctionType& function) :
+      function(&function),
+      numFunctions(&NumFunctionsThunk<FunctionType>),
+      shuffle(&ShuffleThunk<FunctionType>),
+      evaluate(&EvaluateThunk<FunctionType>),
+      gradient(&GradientThunk<FunctionType>),
+      evaluateWithGradient(&EvaluateWithGradientThunk<FunctionType>)
+  {
+    traits::CheckDecomposableFunctionTypeAPI<Function<FunctionType, arma::mat,
+        arma::mat>, arma::mat, arma::mat>();
+  }
+
+  //! Get the number of separable functions.
+  size_t NumFunctions() const { return numFunctions(function); }
+
+  //! Shuffle the order of the separable functions.
+  void Shuffle() { shuffle(function); }
+
+  //! Evaluate a batch of the separable functions.
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    return evaluate(function, coordinates, begin, batchSize);
+  }
+
+  //! Compute the gradient of a batch of the separable functions.
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& g,
+                const size_t batchSize)
+  {
+    gradient(function, coordinates, begin, g, batchSize);
+  }
+
+  //! Evaluate a batch of the separable functions and its gradient.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& g,
+                              const size_t batchSize)
+  {
+    return evaluateWithGradient(function, coordinates, begin, g, batchSize);
+  }
+
+ private:
+  template<typename FunctionType>
+  static size_t NumFunctionsThunk(const void* function)
+  {
+    return static_cast<const FunctionType*>(function)->NumFunctions();
+  }
+
+  template<typename FunctionType>
+  static void ShuffleThunk(void* function)
+  {
+    static_cast<FunctionType*>(function)->Shuffle();
+  }
+
+  template<typename FunctionType>
+  static double EvaluateThunk(void* function,
+                              const arma::mat& coordinates,
+                              const size_t begin,
+                              const size_t batchSize)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    return static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->Evaluate(coordinates, begin, batchSize);
+  }
+
+  template<typename FunctionType>
+  static void GradientThunk(void* function,
+                            const arma::mat& coordinates,
+                            const size_t begin,
+                            arma::mat& g,
+                            const size_t batchSize)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->Gradient(coordinates, begin, g, batchSize);
+  }
+
+  template<typename FunctionType>
+  static double EvaluateWithGradientThunk(void* function,
+                                          const arma::mat& coordinates,
+                                          const size_t begin,
+                                          arma::mat& g,
+                                          const size_t batchSize)
+  {
+    typedef Function<FunctionType, arma::mat, arma::mat> FullFunctionType;
+    return static_cast<FullFunctionType*>(static_cast<FunctionType*>(
+        function))->EvaluateWithGradient(coordinates, begin, g, batchSize);
+  }
+
+  //! The wrapped function.
+  void* function;
+
+  //! NumFunctions() of the wrapped function.
+  size_t (*numFunctions)(const void*);
+
+  //! Shuffle() of the wrapped function.
+  void (*shuffle)(void*);
+
+  //! Evaluate() of a batch of the wrapped function.
+  double (*evaluate)(void*, const arma::mat&, const size_t, const size_t);
+
+  //! Gradient() of a batch of the wrapped function.
+  void (*gradient)(void*, const arma::mat&, const size_t, arma::mat&,
+                   const size_t);
+
+  //! EvaluateWithGradient() of a batch of the wrapped function.
+  double (*evaluateWithGradient)(void*, const arma::mat&, const size_t,
+                                 arma::mat&, const size_t);
+};
+
+} // namespace ens
+
+#endif
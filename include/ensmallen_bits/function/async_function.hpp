@@ -0,0 +1,247 @@
+/**
+ * @file async_function.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper for a function whose evaluations are asynchronous, which keeps a
+ * bounded number of evaluations in flight for population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_ASYNC_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_ASYNC_FUNCTION_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+
+namespace ens {
+
+/**
+ * AsyncFunction wraps a function with a method
+ *
+ * @code
+ * std::future<double> EvaluateAsync(const arma::mat& coordinates);
+ * @endcode
+ *
+ * which starts an evaluation and returns immediately (any type with a get()
+ * method returning the objective may be returned instead of std::future).  The
+ * library does not need to know how the evaluations are run: the future may be
+ * that of std::async(), or of a std::promise fulfilled when a remote machine
+ * answers.
+ *
+ * The wrapper provides an EvaluateBatch() method, which starts the evaluations
+ * of all the candidates of a generation (or of a row of the grid) and collects
+ * them, with at most the given number of evaluations in flight at once.  CNE,
+ * CMAES (with FullSelection) and GridSearch use it instead of evaluating the
+ * candidates one by one.  Its Evaluate() method waits for a single
+ * evaluation; it may be called by several threads at once, so simulated
+ * annealing with several chains keeps one evaluation in flight per chain, and
+ * the limit holds across all the threads.  The wrapper is also a separable
+ * function with one separable function, so it can be given to CMAES.
+ *
+ * @code
+ * MyRemoteFunction f; // Has EvaluateAsync().
+ * AsyncFunction<MyRemoteFunction> async(f, 64);
+ *
+ * CNE optimizer;
+ * optimizer.Optimize(async, coordinates);
+ * @endcode
+ *
+ * @tparam FunctionType Type of the function to wrap.
+ */
+template<typename FunctionType>
+class AsyncFunction
+{
+ public:
+  //! The type returned by EvaluateAsync().
+  typedef decltype(std::declval<FunctionType&>().EvaluateAsync(
+      std::declval<const arma::mat&>())) FutureType;
+
+  /**
+   * Wrap the given function; it must outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   * @param maxInFlight Maximum number of evaluations in flight at once (0
+   *     means no limit).
+   */
+  AsyncFunction(FunctionType& function, const size_t maxInFlight = 0) :
+      function(function),
+      maxInFlight(maxInFlight),
+      inFlight(0),
+      peakInFlight(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Evaluate the function at the given coordinates, and wait for the result.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   */
+  double Evaluate(const arma::mat& coordinates)
+  {
+    FutureType future = Start(coordinates);
+    return Collect(future);
+  }
+
+  //! Evaluate the function at the given coordinates (the wrapper has a single
+  //! separable function).
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t /* begin */,
+                  const size_t /* batchSize */)
+  {
+    return Evaluate(coordinates);
+  }
+
+  //! Return the number of separable functions, 1.
+  size_t NumFunctions() const { return 1; }
+
+  //! Do nothing; there is a single separable function.
+  void Shuffle() { }
+
+  /**
+   * Evaluate every slice of candidates, with at most MaxInFlight()
+   * evaluations in flight at once.  The evaluations are collected in the order
+   * they were started.
+   *
+   * @param candidates Candidates to evaluate, one per slice.
+   * @param objectives Vector to store the objective of each candidate in.
+   */
+  void EvaluateBatch(const arma::cube& candidates, arma::vec& objectives)
+  {
+    objectives.set_size(candidates.n_slices);
+
+    // The function is given the slices of the cube, which stay valid until
+    // all the evaluations are collected.
+    std::deque<FutureType> pending;
+    size_t next = 0;
+    try
+    {
+      for (size_t i = 0; i < candidates.n_slices; ++i)
+      {
+        // Collect our own oldest evaluation first if we hold all the slots, so
+        // that we do not wait for ourselves.
+        if (maxInFlight > 0 && pending.size() >= maxInFlight)
+        {
+          FutureType future = std::move(pending.front());
+          pending.pop_front();
+          objectives[next++] = Collect(future);
+        }
+
+        pending.push_back(Start(candidates.slice(i)));
+      }
+
+      while (!pending.empty())
+      {
+        FutureType future = std::move(pending.front());
+        pending.pop_front();
+        objectives[next++] = Collect(future);
+      }
+    }
+    catch (...)
+    {
+      // Wait for the other evaluations, which may still use the candidates,
+      // and free their slots.
+      for (size_t i = 0; i < pending.size(); ++i)
+      {
+        try { Collect(pending[i]); }
+        catch (...) { }
+      }
+      throw;
+    }
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get the maximum number of evaluations in flight (0 indicates no limit).
+  size_t MaxInFlight() const { return maxInFlight; }
+  //! Modify the maximum number of evaluations in flight (0 indicates no
+  //! limit).  It must not be changed while evaluations are in flight.
+  size_t& MaxInFlight() { return maxInFlight; }
+
+  //! Get the largest number of evaluations that were in flight at once.
+  size_t PeakInFlight() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakInFlight;
+  }
+
+ private:
+  //! Wait for a free slot, and start an evaluation in it.
+  FutureType Start(const arma::mat& coordinates)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (maxInFlight > 0 && inFlight >= maxInFlight)
+        slotFreed.wait(lock);
+
+      ++inFlight;
+      peakInFlight = std::max(peakInFlight, inFlight);
+    }
+
+    try
+    {
+      return function.EvaluateAsync(coordinates);
+    }
+    catch (...)
+    {
+      Release();
+      throw;
+    }
+  }
+
+  //! Wait for the given evaluation, and free its slot.
+  double Collect(FutureType& future)
+  {
+    double objective;
+    try
+    {
+      objective = future.get();
+    }
+    catch (...)
+    {
+      Release();
+      throw;
+    }
+
+    Release();
+    return objective;
+  }
+
+  //! Free a slot.
+  void Release()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --inFlight;
+    }
+    slotFreed.notify_one();
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The maximum number of evaluations in flight.
+  size_t maxInFlight;
+
+  //! The number of evaluations in flight.
+  size_t inFlight;
+
+  //! The largest number of evaluations in flight at once.
+  size_t peakInFlight;
+
+  //! The lock for the counters.
+  mutable std::mutex mutex;
+
+  //! Signalled when an evaluation is collected.
+  std::condition_variable slotFreed;
+};
+
+} // namespace ens
+
+#endif
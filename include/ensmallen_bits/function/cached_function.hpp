@@ -0,0 +1,226 @@
+/**
+ * @file cached_function.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper for a differentiable function that remembers the objective and the
+ * gradient at the last coordinates, so that evaluating the function again at
+ * the same point costs no extra pass.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+
+#include <algorithm>
+
+namespace ens {
+
+/**
+ * CachedFunction wraps a differentiable function and memoises the objective
+ * and the gradient at the last coordinates it was called with.  Optimizers
+ * often ask for Evaluate() and Gradient() (or EvaluateWithGradient()) at the
+ * same point, for instance at the end of a line search; with the cache, the
+ * repeated requests are served without calling the function again.
+ *
+ * The cache is opt-in: pass a CachedFunction to the optimizer instead of the
+ * function itself.
+ *
+ * @code
+ * RosenbrockFunction f;
+ * CachedFunction<RosenbrockFunction> cached(f);
+ *
+ * L_BFGS optimizer;
+ * optimizer.Optimize(cached, coordinates);
+ * @endcode
+ *
+ * The coordinates are compared element by element, which costs much less than
+ * an evaluation.  The wrapped function must not change between calls (for
+ * instance, through its own parameters) without a call to Reset().
+ *
+ * @tparam FunctionType Type of the differentiable function to wrap.
+ * @tparam MatType Type of the coordinates matrix (default arma::mat).
+ * @tparam GradType Type of the gradient matrix (default MatType).
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class CachedFunction
+{
+ public:
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function; it must outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   */
+  CachedFunction(FunctionType& function) :
+      function(function),
+      objective(0),
+      hasObjective(false),
+      hasGradient(false),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective at the given coordinates, from the cache if they are
+   * the last coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    if (hasObjective && Cached(coordinates))
+    {
+      ++hits;
+      return objective;
+    }
+
+    ++misses;
+    Store(coordinates);
+    objective = Wrapped().Evaluate(coordinates);
+    hasObjective = true;
+    return objective;
+  }
+
+  /**
+   * Store the gradient at the given coordinates in gradient, from the cache if
+   * they are the last coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    if (hasGradient && Cached(coordinates))
+    {
+      ++hits;
+      gradient = cachedGradient;
+      return;
+    }
+
+    ++misses;
+    Store(coordinates);
+    Wrapped().Gradient(coordinates, cachedGradient);
+    hasGradient = true;
+    gradient = cachedGradient;
+  }
+
+  /**
+   * Return the objective and store the gradient at the given coordinates;
+   * only the missing quantities are computed.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates, GradType& gradient)
+  {
+    const bool cached = Cached(coordinates);
+    if (cached && hasObjective && hasGradient)
+    {
+      ++hits;
+    }
+    else if (cached && hasObjective)
+    {
+      ++misses;
+      Wrapped().Gradient(coordinates, cachedGradient);
+      hasGradient = true;
+    }
+    else if (cached && hasGradient)
+    {
+      ++misses;
+      objective = Wrapped().Evaluate(coordinates);
+      hasObjective = true;
+    }
+    else
+    {
+      ++misses;
+      Store(coordinates);
+      objective = Wrapped().EvaluateWithGradient(coordinates, cachedGradient);
+      hasObjective = true;
+      hasGradient = true;
+    }
+
+    gradient = cachedGradient;
+    return objective;
+  }
+
+  //! Forget the cached values, for instance after the function changed.
+  void Reset()
+  {
+    hasObjective = false;
+    hasGradient = false;
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function; call Reset() if this changes it.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get the number of requests served from the cache.
+  size_t Hits() const { return hits; }
+
+  //! Get the number of requests that called the wrapped function.
+  size_t Misses() const { return misses; }
+
+ private:
+  //! Get the wrapped function with the methods added by Function<>.
+  Function<FunctionType, MatType, GradType>& Wrapped()
+  {
+    return static_cast<Function<FunctionType, MatType, GradType>&>(function);
+  }
+
+  //! Return whether the given coordinates are the cached coordinates.
+  bool Cached(const MatType& coordinates) const
+  {
+    return (hasObjective || hasGradient) &&
+        coordinates.n_rows == cachedCoordinates.n_rows &&
+        coordinates.n_cols == cachedCoordinates.n_cols &&
+        std::equal(coordinates.begin(), coordinates.end(),
+            cachedCoordinates.begin());
+  }
+
+  //! Make the given coordinates the cached coordinates, if they are new.
+  void Store(const MatType& coordinates)
+  {
+    if (!Cached(coordinates))
+    {
+      cachedCoordinates = coordinates;
+      hasObjective = false;
+      hasGradient = false;
+    }
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The last coordinates.
+  MatType cachedCoordinates;
+
+  //! The objective at the last coordinates, if hasObjective is true.
+  ElemType objective;
+
+  //! The gradient at the last coordinates, if hasGradient is true.
+  GradType cachedGradient;
+
+  //! Whether the objective at the last coordinates is cached.
+  bool hasObjective;
+
+  //! Whether the gradient at the last coordinates is cached.
+  bool hasGradient;
+
+  //! The number of requests served from the cache.
+  size_t hits;
+
+  //! The number of requests that called the wrapped function.
+  size_t misses;
+};
+
+} // namespace ens
+
+#endif
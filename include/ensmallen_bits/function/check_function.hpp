@@ -0,0 +1,546 @@
+/**
+ * @file check_function.hpp
+ * @author Marcus Edel
+ *
+ * Check the gradient of a user function against finite differences, and time
+ * its methods, so that a slow or wrong Gradient() is found before a long
+ * optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_CHECK_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_CHECK_FUNCTION_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ens {
+
+/**
+ * The timing of one method of a function, as measured by TimeFunction(),
+ * TimeDecomposableFunction() or TimeThroughput().  For differentiable
+ * functions, one call counts as one sample; for separable functions, a call
+ * counts as many samples as the size of its batch.  If the calls were made by
+ * several threads, the time is the wall clock time, so that SamplesPerSecond()
+ * is the throughput of all the threads together.
+ */
+class FunctionTiming
+{
+ public:
+  //! Create the timing of the given method.
+  FunctionTiming(const std::string& method,
+                 const size_t batchSize,
+                 const size_t calls,
+                 const double seconds,
+                 const size_t threads = 1) :
+      method(method),
+      batchSize(batchSize),
+      calls(calls),
+      seconds(seconds),
+      threads(threads)
+  { /* Nothing to do. */ }
+
+  //! Get the name of the method.
+  const std::string& Method() const { return method; }
+
+  //! Get the batch size of the calls (0 for non-separable methods).
+  size_t BatchSize() const { return batchSize; }
+
+  //! Get the number of calls.
+  size_t Calls() const { return calls; }
+
+  //! Get the total time (in seconds) of the calls.
+  double Seconds() const { return seconds; }
+
+  //! Get the number of threads that made the calls.
+  size_t Threads() const { return threads; }
+
+  //! Get the number of samples processed per second.
+  double SamplesPerSecond() const
+  {
+    return (seconds > 0.0) ? calls * std::max(batchSize, (size_t) 1) /
+        seconds : 0.0;
+  }
+
+  /**
+   * Get an estimate of the throughput in GFLOP/s, given the number of floating
+   * point operations per sample (for instance, about 4 times the number of
+   * dimensions for the gradient of a linear model).
+   */
+  double GFlops(const double flopsPerSample) const
+  {
+    return SamplesPerSecond() * flopsPerSample / 1e9;
+  }
+
+ private:
+  //! The name of the method.
+  std::string method;
+  //! The batch size of the calls.
+  size_t batchSize;
+  //! The number of calls.
+  size_t calls;
+  //! The total time of the calls.
+  double seconds;
+  //! The number of threads that made the calls.
+  size_t threads;
+};
+
+/**
+ * Compute the gradient of the function at the given coordinates with central
+ * differences of Evaluate(), store it in numericalGradient, and return the
+ * relative error \f$ \| g - \hat{g} \| / (\| g \| + \| \hat{g} \|) \f$ of the
+ * gradient g of Gradient() with respect to it.  A correct gradient typically
+ * gives an error around 1e-7 or smaller; a wrong one, an error of order 1.
+ *
+ * The function should be wrapped in Function<> if it does not have both
+ * methods.  Each coordinate costs two calls to Evaluate(); if parallel is true
+ * and OpenMP is enabled, the coordinates are split between the threads, and
+ * Evaluate() must then be safe to call concurrently.
+ *
+ * @param function Function to check.
+ * @param coordinates Coordinates to check the gradient at.
+ * @param numericalGradient Matrix to store the finite differences in.
+ * @param epsilon Step of the finite differences.
+ * @param parallel Whether to evaluate the coordinates with several threads.
+ * @return Relative error of the gradient.
+ */
+template<typename FunctionType>
+double CheckGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     arma::mat& numericalGradient,
+                     const double epsilon = 1e-6,
+                     const bool parallel = false)
+{
+  arma::mat gradient;
+  function.Gradient(coordinates, gradient);
+
+  numericalGradient.set_size(coordinates.n_rows, coordinates.n_cols);
+
+  #ifdef ENS_USE_OPENMP
+    const size_t numChunks = parallel ? std::min((size_t) omp_get_max_threads(),
+        (size_t) coordinates.n_elem) : 1;
+  #else
+    const size_t numChunks = 1;
+    (void) parallel;
+  #endif
+
+  if (numChunks <= 1)
+  {
+    arma::mat perturbed(coordinates);
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      perturbed[i] = coordinates[i] + epsilon;
+      const double upper = function.Evaluate(perturbed);
+      perturbed[i] = coordinates[i] - epsilon;
+      const double lower = function.Evaluate(perturbed);
+      perturbed[i] = coordinates[i];
+
+      numericalGradient[i] = (upper - lower) / (2 * epsilon);
+    }
+  }
+  else
+  {
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      size_t threadId = 0;
+      size_t numThreads = 1;
+      #ifdef ENS_USE_OPENMP
+        threadId = omp_get_thread_num();
+        numThreads = omp_get_num_threads();
+      #endif
+
+      // Every thread perturbs its own copy of the coordinates.
+      arma::mat perturbed(coordinates);
+      for (size_t i = threadId; i < coordinates.n_elem; i += numThreads)
+      {
+        perturbed[i] = coordinates[i] + epsilon;
+        const double upper = function.Evaluate(perturbed);
+        perturbed[i] = coordinates[i] - epsilon;
+        const double lower = function.Evaluate(perturbed);
+        perturbed[i] = coordinates[i];
+
+        numericalGradient[i] = (upper - lower) / (2 * epsilon);
+      }
+    }
+  }
+
+  const double scale = arma::norm(gradient, 2) +
+      arma::norm(numericalGradient, 2);
+  return (scale > 0.0) ? arma::norm(gradient - numericalGradient, 2) / scale :
+      0.0;
+}
+
+/**
+ * Return the relative error of the gradient of the function at the given
+ * coordinates with respect to central differences; see the overload above.
+ */
+template<typename FunctionType>
+double CheckGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const double epsilon = 1e-6,
+                     const bool parallel = false)
+{
+  arma::mat numericalGradient;
+  return CheckGradient(function, coordinates, numericalGradient, epsilon,
+      parallel);
+}
+
+/**
+ * Return the relative error of the gradient of the given batch of separable
+ * functions at the given coordinates with respect to central differences of
+ * the objective of the batch.  The function should be wrapped in Function<> if
+ * it does not have both separable methods; see CheckGradient() for the other
+ * parameters.
+ *
+ * @param function Separable function to check.
+ * @param coordinates Coordinates to check the gradient at.
+ * @param begin First function of the batch.
+ * @param batchSize Number of functions of the batch.
+ * @param epsilon Step of the finite differences.
+ * @param parallel Whether to evaluate the coordinates with several threads.
+ * @return Relative error of the gradient.
+ */
+template<typename FunctionType>
+double CheckDecomposableGradient(FunctionType& function,
+                                 const arma::mat& coordinates,
+                                 const size_t begin,
+                                 const size_t batchSize,
+                                 const double epsilon = 1e-6,
+                                 const bool parallel = false)
+{
+  // Restrict the function to the batch, so that the check above applies.
+  struct BatchFunction
+  {
+    double Evaluate(const arma::mat& x)
+    { return function.Evaluate(x, begin, batchSize); }
+    void Gradient(const arma::mat& x, arma::mat& g)
+    { function.Gradient(x, begin, g, batchSize); }
+
+    FunctionType& function;
+    size_t begin;
+    size_t batchSize;
+  } batch = { function, begin, batchSize };
+
+  return CheckGradient(batch, coordinates, epsilon, parallel);
+}
+
+namespace detail {
+
+//! Call the given method repeatedly until minTime seconds have passed.
+template<typename CallType>
+inline FunctionTiming TimeCalls(const std::string& method,
+                                const size_t batchSize,
+                                const double minTime,
+                                CallType call)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  size_t calls = 0;
+  double seconds = 0.0;
+  const Clock::time_point start = Clock::now();
+  do
+  {
+    call(calls);
+    ++calls;
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (seconds < minTime);
+
+  return FunctionTiming(method, batchSize, calls, seconds);
+}
+
+/**
+ * Call the separable EvaluateWithGradient() of the function with the given
+ * batch size from the given number of threads, each with its own gradient,
+ * until minTime seconds have passed; the threads take the batches in turn.
+ */
+template<typename FunctionType>
+inline FunctionTiming TimeParallelCalls(FunctionType& function,
+                                        const arma::mat& coordinates,
+                                        const size_t batchSize,
+                                        const size_t threads,
+                                        const double minTime)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  const size_t numBatches = function.NumFunctions() / batchSize;
+  std::vector<size_t> calls(threads, 0);
+  std::vector<double> objectives(threads, 0.0);
+  const Clock::time_point start = Clock::now();
+  OpenMPExecutor(threads).Run(threads, [&](const size_t t)
+  {
+    arma::mat gradient(coordinates.n_rows, coordinates.n_cols);
+    size_t k = t;
+    do
+    {
+      objectives[t] += function.EvaluateWithGradient(coordinates,
+          (k % numBatches) * batchSize, gradient, batchSize);
+      ++calls[t];
+      k += threads;
+    } while (std::chrono::duration<double>(Clock::now() - start).count() <
+        minTime);
+  });
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  size_t totalCalls = 0;
+  for (size_t t = 0; t < threads; ++t)
+    totalCalls += calls[t];
+
+  return FunctionTiming("EvaluateWithGradient", batchSize, totalCalls, seconds,
+      threads);
+}
+
+} // namespace detail
+
+/**
+ * Time Evaluate(), Gradient() and EvaluateWithGradient() of the function at the
+ * given coordinates; each method is called until minTime seconds have passed.
+ * The function should be wrapped in Function<> if it does not have all three
+ * methods.  If EvaluateWithGradient() is not much faster than Evaluate() and
+ * Gradient() together, the function is probably not on the fast path.
+ *
+ * @param function Function to time.
+ * @param coordinates Coordinates to call the methods at.
+ * @param minTime Minimum time (in seconds) to spend on each method.
+ * @return The timings of the three methods.
+ */
+template<typename FunctionType>
+std::vector<FunctionTiming> TimeFunction(FunctionType& function,
+                                         const arma::mat& coordinates,
+                                         const double minTime = 0.1)
+{
+  arma::mat gradient(coordinates.n_rows, coordinates.n_cols);
+  double objective = 0.0;
+
+  std::vector<FunctionTiming> timings;
+  timings.push_back(detail::TimeCalls("Evaluate", 0, minTime,
+      [&](const size_t) { objective += function.Evaluate(coordinates); }));
+  timings.push_back(detail::TimeCalls("Gradient", 0, minTime,
+      [&](const size_t) { function.Gradient(coordinates, gradient); }));
+  timings.push_back(detail::TimeCalls("EvaluateWithGradient", 0, minTime,
+      [&](const size_t)
+      {
+        objective += function.EvaluateWithGradient(coordinates, gradient);
+      }));
+
+  return timings;
+}
+
+/**
+ * Time the separable Evaluate(), Gradient() and EvaluateWithGradient() of the
+ * function at the given coordinates, for each of the given batch sizes; the
+ * batches cycle through the separable functions.  See TimeFunction().
+ *
+ * @param function Separable function to time.
+ * @param coordinates Coordinates to call the methods at.
+ * @param batchSizes Batch sizes to time; sizes larger than the number of
+ *     functions are skipped.
+ * @param minTime Minimum time (in seconds) to spend on each method and size.
+ * @return The timings of the three methods for every batch size.
+ */
+template<typename FunctionType>
+std::vector<FunctionTiming> TimeDecomposableFunction(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    const std::vector<size_t>& batchSizes,
+    const double minTime = 0.1)
+{
+  const size_t numFunctions = function.NumFunctions();
+  arma::mat gradient(coordinates.n_rows, coordinates.n_cols);
+  double objective = 0.0;
+
+  std::vector<FunctionTiming> timings;
+  for (size_t b = 0; b < batchSizes.size(); ++b)
+  {
+    const size_t batchSize = batchSizes[b];
+    if (batchSize == 0 || batchSize > numFunctions)
+      continue;
+
+    // The first function of the k'th batch.
+    const size_t numBatches = numFunctions / batchSize;
+    auto begin = [&](const size_t k) { return (k % numBatches) * batchSize; };
+
+    timings.push_back(detail::TimeCalls("Evaluate", batchSize, minTime,
+        [&](const size_t k)
+        {
+          objective += function.Evaluate(coordinates, begin(k), batchSize);
+        }));
+    timings.push_back(detail::TimeCalls("Gradient", batchSize, minTime,
+        [&](const size_t k)
+        {
+          function.Gradient(coordinates, begin(k), gradient, batchSize);
+        }));
+    timings.push_back(detail::TimeCalls("EvaluateWithGradient", batchSize,
+        minTime, [&](const size_t k)
+        {
+          objective += function.EvaluateWithGradient(coordinates, begin(k),
+              gradient, batchSize);
+        }));
+  }
+
+  return timings;
+}
+
+/**
+ * Time the separable EvaluateWithGradient() of the function at the given
+ * coordinates for every pair of the given batch sizes and thread counts; with
+ * t threads, t batches are evaluated at the same time, each by its own
+ * thread, as a data-parallel optimizer would.  The throughput
+ * (SamplesPerSecond()) is that of all the threads together, so it shows both
+ * how well the function vectorizes over a batch and how well it scales over
+ * the cores (or whether the memory bandwidth runs out first).  The function
+ * must be safe to call concurrently when more than one thread is used, and
+ * thread counts above the number of OpenMP threads are reduced to it (to 1 if
+ * OpenMP is not enabled).
+ *
+ * @param function Separable function to time.
+ * @param coordinates Coordinates to call EvaluateWithGradient() at.
+ * @param batchSizes Batch sizes to time; sizes larger than the number of
+ *     functions are skipped.
+ * @param threadCounts Numbers of threads to time.
+ * @param minTime Minimum time (in seconds) to spend on each configuration.
+ * @return The timings of every configuration.
+ */
+template<typename FunctionType>
+std::vector<FunctionTiming> TimeThroughput(
+    FunctionType& function,
+    const arma::mat& coordinates,
+    const std::vector<size_t>& batchSizes,
+    const std::vector<size_t>& threadCounts,
+    const double minTime = 0.1)
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  std::vector<FunctionTiming> timings;
+  for (size_t b = 0; b < batchSizes.size(); ++b)
+  {
+    const size_t batchSize = batchSizes[b];
+    if (batchSize == 0 || batchSize > numFunctions)
+      continue;
+
+    for (size_t i = 0; i < threadCounts.size(); ++i)
+    {
+      if (threadCounts[i] == 0)
+        continue;
+
+      const size_t threads = std::min(threadCounts[i],
+          OpenMPExecutor(threadCounts[i]).Threads());
+      timings.push_back(detail::TimeParallelCalls(function, coordinates,
+          batchSize, threads, minTime));
+    }
+  }
+
+  return timings;
+}
+
+/**
+ * Find the batch size and the number of threads with the largest throughput
+ * (samples per second) of the separable EvaluateWithGradient() of the
+ * function, so that an optimizer can be configured for the machine it runs on
+ * rather than by hand.  The powers of two up to maxBatchSize (and
+ * maxBatchSize itself) are tried as batch sizes, and the powers of two up to
+ * maxThreads (and maxThreads itself) as thread counts; see TimeThroughput().
+ * Every timing and the chosen configuration are printed with ENS_INFO.
+ *
+ * A larger batch usually has a larger throughput but fewer steps per epoch,
+ * so maxBatchSize should be the largest batch the optimizer still converges
+ * well with.
+ *
+ * @code
+ * FunctionTiming best = TuneThroughput(f, coordinates, 256);
+ * SGD<> sgd(0.01, best.BatchSize());
+ * @endcode
+ *
+ * @param function Separable function to tune for.
+ * @param coordinates Coordinates to call EvaluateWithGradient() at.
+ * @param maxBatchSize Largest batch size to try.
+ * @param maxThreads Largest number of threads to try (0 means the number of
+ *     OpenMP threads).
+ * @param minTime Minimum time (in seconds) to spend on each configuration.
+ * @return The timing of the configuration with the largest throughput.
+ */
+template<typename FunctionType>
+FunctionTiming TuneThroughput(FunctionType& function,
+                              const arma::mat& coordinates,
+                              const size_t maxBatchSize,
+                              const size_t maxThreads = 0,
+                              const double minTime = 0.05)
+{
+  const size_t largestBatch = std::min(maxBatchSize, function.NumFunctions());
+  if (largestBatch == 0)
+  {
+    throw std::invalid_argument("TuneThroughput(): the maximum batch size and "
+        "the number of functions must be positive!");
+  }
+
+  std::vector<size_t> batchSizes;
+  for (size_t batchSize = 1; batchSize < largestBatch; batchSize *= 2)
+    batchSizes.push_back(batchSize);
+  batchSizes.push_back(largestBatch);
+
+  const size_t largestThreads = OpenMPExecutor(maxThreads).Threads();
+  std::vector<size_t> threadCounts;
+  for (size_t threads = 1; threads < largestThreads; threads *= 2)
+    threadCounts.push_back(threads);
+  threadCounts.push_back(largestThreads);
+
+  const std::vector<FunctionTiming> timings = TimeThroughput(function,
+      coordinates, batchSizes, threadCounts, minTime);
+
+  size_t best = 0;
+  for (size_t i = 0; i < timings.size(); ++i)
+  {
+    ENS_INFO << "TuneThroughput(): batch size " << timings[i].BatchSize()
+        << ", " << timings[i].Threads() << " thread(s): "
+        << timings[i].SamplesPerSecond() << " samples/s." << std::endl;
+    if (timings[i].SamplesPerSecond() > timings[best].SamplesPerSecond())
+      best = i;
+  }
+
+  ENS_INFO << "TuneThroughput(): best is batch size "
+      << timings[best].BatchSize() << " with " << timings[best].Threads()
+      << " thread(s), " << timings[best].SamplesPerSecond() << " samples/s."
+      << std::endl;
+
+  return timings[best];
+}
+
+/**
+ * Print the given timings as a table, with an estimate of the throughput in
+ * GFLOP/s if the number of floating point operations per sample is given.
+ *
+ * @param timings Timings to print.
+ * @param output Stream to print to.
+ * @param flopsPerSample Floating point operations per sample (0 to omit the
+ *     estimate).
+ */
+inline void PrintTimings(const std::vector<FunctionTiming>& timings,
+                         std::ostream& output,
+                         const double flopsPerSample = 0.0)
+{
+  for (size_t i = 0; i < timings.size(); ++i)
+  {
+    output << timings[i].Method();
+    if (timings[i].BatchSize() > 0)
+      output << " (batch size " << timings[i].BatchSize() << ")";
+    if (timings[i].Threads() > 1)
+      output << " (" << timings[i].Threads() << " threads)";
+    output << ": " << timings[i].Calls() << " calls in "
+        << timings[i].Seconds() << "s, " << timings[i].SamplesPerSecond()
+        << " samples/s";
+    if (flopsPerSample > 0.0)
+      output << ", ~" << timings[i].GFlops(flopsPerSample) << " GFLOP/s";
+    output << std::endl;
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file evaluate_batch.hpp
+ * @author Ryan Curtin
+ *
+ * Evaluate a population of candidates at once with the EvaluateBatch() method
+ * of a function, if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_BATCH_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_BATCH_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * BatchEvaluation calls the EvaluateBatch() method of functions that have one
+ * (see traits::HasBatchEvaluation), and does nothing for the others.
+ *
+ * @tparam FunctionType Type of the function to evaluate.
+ */
+template<typename FunctionType,
+         bool HasBatch = traits::HasBatchEvaluation<FunctionType>::value>
+class BatchEvaluation
+{
+ public:
+  //! The function has no EvaluateBatch() method.
+  static bool Evaluate(FunctionType& /* function */,
+                       const arma::cube& /* candidates */,
+                       arma::vec& /* objectives */)
+  {
+    return false;
+  }
+};
+
+/**
+ * Specialization for functions with an EvaluateBatch() method.
+ */
+template<typename FunctionType>
+class BatchEvaluation<FunctionType, true>
+{
+ public:
+  //! Evaluate all the candidates with EvaluateBatch().
+  static bool Evaluate(FunctionType& function,
+                       const arma::cube& candidates,
+                       arma::vec& objectives)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    objectives.set_size(candidates.n_slices);
+    function.EvaluateBatch(candidates, objectives);
+    return true;
+  }
+};
+
+/**
+ * Evaluate every slice of candidates with the EvaluateBatch() method of the
+ * function, if it has one.  The caller is expected to evaluate the candidates
+ * one by one if false is returned.
+ *
+ * @param function Function to evaluate.
+ * @param candidates Candidates to evaluate, one per slice.
+ * @param objectives Vector to store the objective of each candidate in.
+ * @return true if the candidates were evaluated, false otherwise.
+ */
+template<typename FunctionType>
+inline bool TryEvaluateBatch(FunctionType& function,
+                             const arma::cube& candidates,
+                             arma::vec& objectives)
+{
+  return BatchEvaluation<FunctionType>::Evaluate(function, candidates,
+      objectives);
+}
+
+} // namespace ens
+
+#endif
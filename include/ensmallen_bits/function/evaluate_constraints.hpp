@@ -0,0 +1,152 @@
+/**
+ * @file evaluate_constraints.hpp
+ * @author Marcus Edel
+ *
+ * Evaluate all the constraints of a constrained function, and the weighted sum
+ * of their gradients, with the EvaluateConstraints() and GradientConstraints()
+ * methods of the function, if it has them.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_CONSTRAINTS_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_CONSTRAINTS_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * BatchConstraintEvaluation calls the EvaluateConstraints() method of
+ * functions that have one (see traits::HasBatchConstraintEvaluation), and
+ * calls EvaluateConstraint() once per constraint for the others.
+ *
+ * @tparam FunctionType Type of the constrained function.
+ */
+template<typename FunctionType,
+         bool HasBatch = traits::HasBatchConstraintEvaluation<
+             FunctionType>::value>
+class BatchConstraintEvaluation
+{
+ public:
+  //! Evaluate the constraints one by one.
+  static void Evaluate(FunctionType& function,
+                       const arma::mat& coordinates,
+                       arma::vec& constraints)
+  {
+    constraints.set_size(function.NumConstraints());
+    for (size_t i = 0; i < constraints.n_elem; ++i)
+      constraints[i] = function.EvaluateConstraint(i, coordinates);
+  }
+};
+
+/**
+ * Specialization for functions with an EvaluateConstraints() method.
+ */
+template<typename FunctionType>
+class BatchConstraintEvaluation<FunctionType, true>
+{
+ public:
+  //! Evaluate all the constraints with EvaluateConstraints().
+  static void Evaluate(FunctionType& function,
+                       const arma::mat& coordinates,
+                       arma::vec& constraints)
+  {
+    function.EvaluateConstraints(coordinates, constraints);
+  }
+};
+
+/**
+ * BatchConstraintGradient calls the GradientConstraints() method of functions
+ * that have one (see traits::HasBatchConstraintGradient), and sums the
+ * gradients given by GradientConstraint() for the others.
+ *
+ * @tparam FunctionType Type of the constrained function.
+ */
+template<typename FunctionType,
+         bool HasBatch = traits::HasBatchConstraintGradient<
+             FunctionType>::value>
+class BatchConstraintGradient
+{
+ public:
+  //! Sum the weighted gradients of the constraints one by one.
+  static void Gradient(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const arma::vec& weights,
+                       arma::mat& gradient)
+  {
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+    arma::mat constraintGradient; // Temporary for constraint gradients.
+    for (size_t i = 0; i < weights.n_elem; ++i)
+    {
+      // A zero weight contributes nothing, so skip its gradient.
+      if (weights[i] == 0.0)
+        continue;
+
+      function.GradientConstraint(i, coordinates, constraintGradient);
+      gradient += weights[i] * constraintGradient;
+    }
+  }
+};
+
+/**
+ * Specialization for functions with a GradientConstraints() method.
+ */
+template<typename FunctionType>
+class BatchConstraintGradient<FunctionType, true>
+{
+ public:
+  //! Compute the weighted sum with GradientConstraints().
+  static void Gradient(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const arma::vec& weights,
+                       arma::mat& gradient)
+  {
+    function.GradientConstraints(coordinates, weights, gradient);
+  }
+};
+
+/**
+ * Evaluate all the constraints of the given function at the given
+ * coordinates, with a single call to EvaluateConstraints() if the function has
+ * it.
+ *
+ * @param function Constrained function.
+ * @param coordinates Coordinates to evaluate the constraints at.
+ * @param constraints Vector to store the value of each constraint in.
+ */
+template<typename FunctionType>
+inline void EvaluateAllConstraints(FunctionType& function,
+                                   const arma::mat& coordinates,
+                                   arma::vec& constraints)
+{
+  BatchConstraintEvaluation<FunctionType>::Evaluate(function, coordinates,
+      constraints);
+}
+
+/**
+ * Compute sum_i weights[i] * c_i'(coordinates), the product of the transposed
+ * Jacobian of the constraints with the given weights, with a single call to
+ * GradientConstraints() if the function has it.
+ *
+ * @param function Constrained function.
+ * @param coordinates Coordinates to compute the gradients at.
+ * @param weights Weight of each constraint.
+ * @param gradient Matrix to store the weighted sum of the gradients in.
+ */
+template<typename FunctionType>
+inline void WeightedConstraintGradient(FunctionType& function,
+                                       const arma::mat& coordinates,
+                                       const arma::vec& weights,
+                                       arma::mat& gradient)
+{
+  BatchConstraintGradient<FunctionType>::Gradient(function, coordinates,
+      weights, gradient);
+}
+
+} // namespace ens
+
+#endif
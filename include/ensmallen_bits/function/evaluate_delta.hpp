@@ -0,0 +1,92 @@
+/**
+ * @file evaluate_delta.hpp
+ * @author Marcus Edel
+ *
+ * Evaluate the objective after changing a single coordinate with the
+ * EvaluateDelta() method of a function, if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATE_DELTA_HPP
+#define ENSMALLEN_FUNCTION_EVALUATE_DELTA_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * DeltaEvaluation evaluates the objective after a change of a single
+ * coordinate with the EvaluateDelta() method of functions that have one (see
+ * traits::HasDeltaEvaluation), and with Evaluate() for the others.
+ *
+ * @tparam FunctionType Type of the function to evaluate.
+ */
+template<typename FunctionType,
+         bool HasDelta = traits::HasDeltaEvaluation<FunctionType>::value>
+class DeltaEvaluation
+{
+ public:
+  //! Evaluate the whole objective with the coordinate changed.
+  static double Evaluate(FunctionType& function,
+                         arma::mat& coordinates,
+                         const size_t index,
+                         const double value,
+                         const double /* objective */)
+  {
+    const double oldValue = coordinates(index);
+    coordinates(index) = value;
+    const double newObjective = function.Evaluate(coordinates);
+    coordinates(index) = oldValue;
+    return newObjective;
+  }
+};
+
+/**
+ * Specialization for functions with an EvaluateDelta() method.
+ */
+template<typename FunctionType>
+class DeltaEvaluation<FunctionType, true>
+{
+ public:
+  //! Add the change of the objective given by EvaluateDelta().
+  static double Evaluate(FunctionType& function,
+                         arma::mat& coordinates,
+                         const size_t index,
+                         const double value,
+                         const double objective)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return objective + function.EvaluateDelta(coordinates, index, value);
+  }
+};
+
+/**
+ * Return the objective at the given coordinates with element index set to
+ * value, given the objective at the coordinates.  The coordinates are left
+ * unchanged.  If the function has an EvaluateDelta() method, only the change of
+ * the objective is computed; otherwise the whole objective is evaluated.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Current coordinates (restored before returning).
+ * @param index Index of the element to change.
+ * @param value New value of the element.
+ * @param objective Objective at the current coordinates.
+ * @return Objective with the element changed.
+ */
+template<typename FunctionType>
+inline double EvaluateMove(FunctionType& function,
+                           arma::mat& coordinates,
+                           const size_t index,
+                           const double value,
+                           const double objective)
+{
+  return DeltaEvaluation<FunctionType>::Evaluate(function, coordinates, index,
+      value, objective);
+}
+
+} // namespace ens
+
+#endif
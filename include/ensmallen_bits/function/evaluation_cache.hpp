@@ -0,0 +1,251 @@
+/**
+ * @file evaluation_cache.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper for an arbitrary function that memoises the objective at the most
+ * recently used coordinates, for black-box optimizers that propose the same
+ * candidates several times.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_EVALUATION_CACHE_HPP
+#define ENSMALLEN_FUNCTION_EVALUATION_CACHE_HPP
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ens {
+
+/**
+ * EvaluationCache wraps a function with an Evaluate() method and keeps the
+ * objective at up to a given number of coordinates, dropping the least
+ * recently used ones first.  Black-box optimizers often propose candidates
+ * they have evaluated before: the final point of CNE is the best candidate of
+ * the last generation, a grid search revisits its grid when it is run again,
+ * and restarts of CMA-ES or simulated annealing from the same point evaluate
+ * it again.  With an expensive objective, every request served by the cache
+ * saves a whole evaluation.
+ *
+ * @code
+ * MySimulatorFunction f;
+ * EvaluationCache<MySimulatorFunction> cached(f, 10000);
+ *
+ * GridSearch optimizer;
+ * optimizer.Optimize(cached, coordinates, categoricalDimensions,
+ *     numCategories);
+ * // cached.Hits() evaluations were saved.
+ * @endcode
+ *
+ * By default the coordinates must be exactly equal to be served from the
+ * cache.  If a quantum is given, the coordinates are rounded to multiples of
+ * it first, so that all the points in a cell of that size share the objective
+ * of the first one evaluated.
+ *
+ * The cache can be used by several threads at once (for instance by CNE with
+ * ParallelEvaluation()); the wrapped function is called outside the lock, so
+ * its evaluations still run in parallel, and two threads asking for the same
+ * new coordinates at the same time may both evaluate them.  The wrapped
+ * function must not change between calls without a call to Clear().
+ *
+ * @tparam FunctionType Type of the function to wrap.
+ * @tparam MatType Type of the coordinates matrix (default arma::mat).
+ */
+template<typename FunctionType, typename MatType = arma::mat>
+class EvaluationCache
+{
+ public:
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function; it must outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   * @param capacity Maximum number of objectives kept (0 means no limit).
+   * @param quantum If positive, the coordinates are rounded to multiples of
+   *     quantum to find them in the cache; otherwise they must be equal.
+   */
+  EvaluationCache(FunctionType& function,
+                  const size_t capacity = 1024,
+                  const double quantum = 0.0) :
+      function(function),
+      capacity(capacity),
+      quantum(quantum),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective at the given coordinates, from the cache if they
+   * were evaluated before.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    Key key;
+    MakeKey(coordinates, key);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      typename Map::iterator it = map.find(key);
+      if (it != map.end())
+      {
+        ++hits;
+        // Move the entry to the front of the recency list.
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+      }
+
+      ++misses;
+    }
+
+    const ElemType objective = Wrapped().Evaluate(coordinates);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (map.find(key) == map.end())
+    {
+      entries.push_front(Entry(std::move(key), objective));
+      map[entries.front().first] = entries.begin();
+
+      if (capacity > 0 && entries.size() > capacity)
+      {
+        map.erase(entries.back().first);
+        entries.pop_back();
+      }
+    }
+
+    return objective;
+  }
+
+  //! Forget all the cached objectives, for instance after the function
+  //! changed.
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    map.clear();
+    entries.clear();
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function; call Clear() if this changes it.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get the maximum number of objectives kept (0 indicates no limit).
+  size_t Capacity() const { return capacity; }
+
+  //! Get the quantum the coordinates are rounded to (0 indicates none).
+  double Quantum() const { return quantum; }
+
+  //! Get the number of objectives in the cache.
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  //! Get the number of requests served from the cache.
+  size_t Hits() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  //! Get the number of requests that called the wrapped function.
+  size_t Misses() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+ private:
+  //! Get the wrapped function with the methods added by Function<>.
+  Function<FunctionType, MatType, MatType>& Wrapped()
+  {
+    return static_cast<Function<FunctionType, MatType, MatType>&>(function);
+  }
+
+  //! The key of some coordinates: their shape, and the bits of each element
+  //! or the index of its cell.
+  typedef std::vector<uint64_t> Key;
+
+  //! Hash a key by mixing its words (with the finalizer of SplitMix64).
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      uint64_t hash = 0;
+      for (size_t i = 0; i < key.size(); ++i)
+      {
+        uint64_t z = hash + key[i] + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        hash = z ^ (z >> 31);
+      }
+
+      return (size_t) hash;
+    }
+  };
+
+  //! A cached objective; the most recently used entries are at the front.
+  typedef std::pair<Key, ElemType> Entry;
+  typedef std::list<Entry> EntryList;
+  typedef std::unordered_map<Key, typename EntryList::iterator, KeyHash> Map;
+
+  //! Build the key of the given coordinates.
+  void MakeKey(const MatType& coordinates, Key& key) const
+  {
+    key.resize(coordinates.n_elem + 2);
+    key[0] = coordinates.n_rows;
+    key[1] = coordinates.n_cols;
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+    {
+      const double value = (double) coordinates[i];
+      if (quantum > 0.0)
+      {
+        key[i + 2] = (uint64_t) (int64_t) std::floor(value / quantum + 0.5);
+      }
+      else
+      {
+        // Positive and negative zero are the same coordinate.
+        const double exact = (value == 0.0) ? 0.0 : value;
+        std::memcpy(&key[i + 2], &exact, sizeof(double));
+      }
+    }
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The maximum number of objectives kept.
+  size_t capacity;
+
+  //! The size of the cells the coordinates are rounded to.
+  double quantum;
+
+  //! The cached objectives, most recently used first.
+  EntryList entries;
+
+  //! The position of each cached objective in entries.
+  Map map;
+
+  //! The number of requests served from the cache.
+  size_t hits;
+
+  //! The number of requests that called the wrapped function.
+  size_t misses;
+
+  //! The lock for the cache and the counters.
+  mutable std::mutex mutex;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,335 @@
+/**
+ * @file finite_difference_function.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper that gives a function with only Evaluate() a gradient, with finite
+ * differences or simultaneous perturbations, so that gradient-based optimizers
+ * can be used on it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_FINITE_DIFFERENCE_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_FINITE_DIFFERENCE_FUNCTION_HPP
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * FiniteDifferenceFunction wraps a function that only has an Evaluate()
+ * method and adds Gradient() and EvaluateWithGradient(), so that smooth
+ * black-box functions can be optimized with L_BFGS, GradientDescent and the
+ * other optimizers for differentiable functions instead of only with the
+ * derivative-free ones.
+ *
+ * @code
+ * MySimulatorFunction f;
+ * FiniteDifferenceFunction<MySimulatorFunction> differentiable(f,
+ *     FiniteDifferenceFunction<MySimulatorFunction>::CentralDifferences,
+ *     0.0, true);
+ *
+ * L_BFGS optimizer;
+ * optimizer.Optimize(differentiable, coordinates);
+ * @endcode
+ *
+ * Three schemes are available:
+ *
+ *  - CentralDifferences: (f(x + h e_i) - f(x - h e_i)) / 2h for every
+ *    coordinate i, with 2n evaluations per gradient and an error of order h^2.
+ *  - ForwardDifferences: (f(x + h e_i) - f(x)) / h, with n + 1 evaluations per
+ *    gradient (n with EvaluateWithGradient(), which needs f(x) anyway) and an
+ *    error of order h.
+ *  - SPSA: the simultaneous perturbation estimate
+ *    (f(x + h d) - f(x - h d)) / 2h * d, with a random direction d of +-1
+ *    elements, averaged over a given number of directions.  It costs two
+ *    evaluations per direction whatever the dimension, but is only an unbiased
+ *    estimate of the gradient, so it suits the stochastic optimizers (e.g.
+ *    GradientDescent with a small step size) in very high dimensions.
+ *
+ * The step of coordinate i is h = epsilon * max(1, |x_i|) (for SPSA,
+ * epsilon * max(1, max_i |x_i|)).  By default epsilon is the cube root of the
+ * machine epsilon for the central schemes and its square root for forward
+ * differences, which balance the truncation and rounding errors.
+ *
+ * If parallel is true and OpenMP is enabled, the evaluations of a gradient are
+ * split between the threads, each with its own copy of the coordinates; the
+ * wrapped Evaluate() must then be safe to call concurrently.  The differences
+ * are combined in a fixed order, so the gradient does not depend on the
+ * number of threads.
+ *
+ * @tparam FunctionType Type of the function to wrap.
+ * @tparam MatType Type of the coordinates matrix (default arma::mat).
+ * @tparam GradType Type of the gradient matrix (default MatType).
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class FiniteDifferenceFunction
+{
+ public:
+  //! The type of the objective.
+  typedef typename MatType::elem_type ElemType;
+
+  //! The schemes to estimate the gradient with.
+  enum Scheme
+  {
+    CentralDifferences,
+    ForwardDifferences,
+    SPSA
+  };
+
+  /**
+   * Wrap the given function; it must outlive the wrapper.
+   *
+   * @param function Function to wrap.
+   * @param scheme Scheme to estimate the gradient with.
+   * @param epsilon Relative step of the differences (0 means the default of
+   *     the scheme).
+   * @param parallel Whether to evaluate the differences with several threads.
+   * @param directions Number of random directions averaged by SPSA.
+   */
+  FiniteDifferenceFunction(FunctionType& function,
+                           const Scheme scheme = CentralDifferences,
+                           const double epsilon = 0.0,
+                           const bool parallel = false,
+                           const size_t directions = 1) :
+      function(function),
+      scheme(scheme),
+      epsilon(epsilon),
+      parallel(parallel),
+      directions(directions),
+      evaluations(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Return the objective of the wrapped function at the given coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    ++evaluations;
+    return function.Evaluate(coordinates);
+  }
+
+  /**
+   * Store the estimate of the gradient at the given coordinates in gradient.
+   *
+   * @param coordinates Coordinates to estimate the gradient at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    if (scheme == ForwardDifferences)
+      EvaluateWithGradient(coordinates, gradient);
+    else
+      Differences(coordinates, gradient, 0);
+  }
+
+  /**
+   * Return the objective and store the estimate of the gradient at the given
+   * coordinates.
+   *
+   * @param coordinates Coordinates to evaluate the function at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates, GradType& gradient)
+  {
+    const ElemType objective = Evaluate(coordinates);
+    Differences(coordinates, gradient, objective);
+    return objective;
+  }
+
+  //! Get the wrapped function.
+  const FunctionType& WrappedFunction() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& WrappedFunction() { return function; }
+
+  //! Get the scheme to estimate the gradient with.
+  Scheme GradientScheme() const { return scheme; }
+  //! Modify the scheme to estimate the gradient with.
+  Scheme& GradientScheme() { return scheme; }
+
+  //! Get the relative step of the differences (0 means the default).
+  double Epsilon() const { return epsilon; }
+  //! Modify the relative step of the differences (0 means the default).
+  double& Epsilon() { return epsilon; }
+
+  //! Get whether the differences are evaluated with several threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the differences are evaluated with several threads.
+  bool& Parallel() { return parallel; }
+
+  //! Get the number of random directions averaged by SPSA.
+  size_t Directions() const { return directions; }
+  //! Modify the number of random directions averaged by SPSA.
+  size_t& Directions() { return directions; }
+
+  //! Get the number of calls to the wrapped Evaluate() so far.
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  //! Get the relative step of the current scheme.
+  double Step() const
+  {
+    if (epsilon > 0.0)
+      return epsilon;
+
+    const double machineEpsilon = std::numeric_limits<ElemType>::epsilon();
+    return (scheme == ForwardDifferences) ? std::sqrt(machineEpsilon) :
+        std::cbrt(machineEpsilon);
+  }
+
+  /**
+   * Estimate the gradient at the given coordinates with the current scheme;
+   * objective is the objective at the coordinates, which only forward
+   * differences use.
+   */
+  void Differences(const MatType& coordinates,
+                   GradType& gradient,
+                   const ElemType objective)
+  {
+    const size_t n = coordinates.n_elem;
+    const double step = Step();
+    gradient.set_size(coordinates.n_rows, coordinates.n_cols);
+
+    if (scheme == SPSA)
+    {
+      if (directions == 0)
+      {
+        throw std::invalid_argument("FiniteDifferenceFunction::Gradient(): "
+            "the number of SPSA directions must be positive!");
+      }
+
+      // Draw all the directions first, so that they do not depend on the
+      // threads.
+      MatType signs = 2 * arma::randi<MatType>(n, directions,
+          arma::distr_param(0, 1)) - 1;
+      const ElemType h = step * std::max(1.0,
+          (double) arma::abs(coordinates).max());
+
+      std::vector<ElemType> values(2 * directions);
+      EvaluateAll(coordinates, values, [&](const size_t t, MatType& perturbed)
+      {
+        const ElemType sign = (t % 2 == 0) ? h : -h;
+        for (size_t i = 0; i < n; ++i)
+          perturbed[i] += sign * signs(i, t / 2);
+      },
+      [&](const size_t /* t */, MatType& perturbed)
+      {
+        perturbed = coordinates;
+      });
+
+      gradient.zeros();
+      for (size_t d = 0; d < directions; ++d)
+      {
+        gradient += ((values[2 * d] - values[2 * d + 1]) / (2 * h)) *
+            arma::reshape(signs.col(d), coordinates.n_rows, coordinates.n_cols);
+      }
+      gradient /= (ElemType) directions;
+      return;
+    }
+
+    const bool central = (scheme == CentralDifferences);
+    std::vector<ElemType> values(central ? 2 * n : n);
+    EvaluateAll(coordinates, values, [&](const size_t t, MatType& perturbed)
+    {
+      const size_t i = central ? t / 2 : t;
+      const ElemType h = step * std::max(1.0, (double) std::abs(coordinates[i]));
+      perturbed[i] += (t % 2 == 0 || !central) ? h : -h;
+    },
+    [&](const size_t t, MatType& perturbed)
+    {
+      const size_t i = central ? t / 2 : t;
+      perturbed[i] = coordinates[i];
+    });
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      const ElemType h = step * std::max(1.0, (double) std::abs(coordinates[i]));
+      gradient[i] = central ? (values[2 * i] - values[2 * i + 1]) / (2 * h) :
+          (values[i] - objective) / h;
+    }
+  }
+
+  /**
+   * Evaluate the function at every perturbation of the given coordinates and
+   * store the objectives in values; perturb(t, perturbed) applies perturbation
+   * t to a copy of the coordinates, and restore(t, perturbed) undoes it (only
+   * copying back the elements it changed).
+   */
+  template<typename PerturbType, typename RestoreType>
+  void EvaluateAll(const MatType& coordinates,
+                   std::vector<ElemType>& values,
+                   PerturbType perturb,
+                   RestoreType restore)
+  {
+    #ifdef ENS_USE_OPENMP
+      const size_t numThreads = parallel ?
+          std::min((size_t) omp_get_max_threads(), values.size()) : 1;
+    #else
+      const size_t numThreads = 1;
+    #endif
+
+    if (numThreads <= 1)
+    {
+      MatType perturbed(coordinates);
+      for (size_t t = 0; t < values.size(); ++t)
+      {
+        perturb(t, perturbed);
+        values[t] = function.Evaluate(perturbed);
+        restore(t, perturbed);
+      }
+    }
+    else
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t teamSize = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          teamSize = omp_get_num_threads();
+        #endif
+
+        // Every thread perturbs its own copy of the coordinates.
+        MatType perturbed(coordinates);
+        for (size_t t = threadId; t < values.size(); t += teamSize)
+        {
+          perturb(t, perturbed);
+          values[t] = function.Evaluate(perturbed);
+          restore(t, perturbed);
+        }
+      }
+    }
+
+    evaluations += values.size();
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The scheme to estimate the gradient with.
+  Scheme scheme;
+
+  //! The relative step of the differences (0 means the default).
+  double epsilon;
+
+  //! Whether the differences are evaluated with several threads.
+  bool parallel;
+
+  //! The number of random directions averaged by SPSA.
+  size_t directions;
+
+  //! The number of calls to the wrapped Evaluate().
+  size_t evaluations;
+};
+
+} // namespace ens
+
+#endif
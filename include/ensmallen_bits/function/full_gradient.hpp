@@ -0,0 +1,237 @@
+/**
+ * @file full_gradient.hpp
+ * @author Marcus Edel
+ *
+ * Compute the objective and the full gradient of a decomposable function in a
+ * single pass over its separable functions, as done at the start of every
+ * outer iteration of the variance reduced optimizers (SVRG, SARAH, Katyusha),
+ * and the gradients of a batch at two points, as done in their inner steps.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_FULL_GRADIENT_HPP
+#define ENSMALLEN_FUNCTION_FULL_GRADIENT_HPP
+
+namespace ens {
+
+/**
+ * Compute the sum of the objectives and the mean of the gradients of all the
+ * separable functions of the given function at the given coordinates, with one
+ * call to EvaluateWithGradient() per batch.  The given function should be
+ * wrapped in Function<> so that EvaluateWithGradient() is available.
+ *
+ * If parallel is true and OpenMP is enabled, the batches are split into one
+ * contiguous chunk per available thread; each chunk is summed in order into
+ * its own buffer, and the chunks are then added pairwise in a fixed tree.  The
+ * result therefore only depends on the maximum number of threads and not on
+ * the scheduling, so it is reproducible for a given number of threads.  In the
+ * deterministic mode (see SetDeterministic()), the number of chunks does not
+ * depend on the threads either (even without OpenMP), and every chunk draws
+ * its random numbers from its own stream.  The function must be safe to
+ * evaluate concurrently if parallel is true.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Coordinates to evaluate the function at.
+ * @param batchSize Number of separable functions to evaluate per call.
+ * @param fullGradient Matrix to store the mean gradient in; its memory is
+ *     reused if it already has the right size.
+ * @param gradient Matrix to store the gradient of each batch in.
+ * @param parallel Whether to evaluate the batches with several threads.
+ * @return Sum of the objectives of the separable functions.
+ */
+template<typename FunctionType>
+double FullEvaluateWithGradient(FunctionType& function,
+                                const arma::mat& coordinates,
+                                const size_t batchSize,
+                                arma::mat& fullGradient,
+                                arma::mat& gradient,
+                                const bool parallel = false)
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  // Find the number of batches.
+  size_t numBatches = numFunctions / batchSize;
+  if (numFunctions % batchSize != 0)
+    ++numBatches; // Capture last few.
+
+  #ifdef ENS_USE_OPENMP
+    const size_t maxThreads = omp_get_max_threads();
+  #else
+    const size_t maxThreads = 1;
+  #endif
+  const size_t numChunks = parallel ? ParallelChunks(maxThreads, numBatches) :
+      1;
+
+  if (numChunks <= 1)
+  {
+    fullGradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    double objective = 0;
+    for (size_t f = 0; f < numFunctions; f += batchSize)
+    {
+      // Find the effective batch size (the last batch may be smaller).
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
+
+      objective += function.EvaluateWithGradient(coordinates, f, gradient,
+          effectiveBatchSize);
+      fullGradient += gradient;
+    }
+    fullGradient /= (double) numFunctions;
+
+    return objective;
+  }
+
+  // Every chunk gets its own gradient buffer; the first chunk uses
+  // fullGradient.
+  std::vector<arma::mat> gradients(numChunks - 1);
+  std::vector<double> objectives(numChunks, 0.0);
+  const uint64_t seed = ChunkRandomSeed();
+
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    arma::mat batchGradient;
+
+    // The team may be smaller than requested, so each thread takes every
+    // numThreads'th chunk.
+    for (size_t c = threadId; c < numChunks; c += numThreads)
+    {
+      ChunkRandomScope chunkScope(seed, c);
+      arma::mat& chunkGradient = (c == 0) ? fullGradient : gradients[c - 1];
+      chunkGradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+      const size_t chunkEnd = std::min(numFunctions,
+          ((c + 1) * numBatches / numChunks) * batchSize);
+      for (size_t f = (c * numBatches / numChunks) * batchSize; f < chunkEnd;
+          f += batchSize)
+      {
+        const size_t effectiveBatchSize = std::min(batchSize, chunkEnd - f);
+        objectives[c] += function.EvaluateWithGradient(coordinates, f,
+            batchGradient, effectiveBatchSize);
+        chunkGradient += batchGradient;
+      }
+    }
+  }
+
+  // Add the chunks pairwise: first chunk c + 1 into chunk c for every even c,
+  // then chunk c + 2 into chunk c for every multiple c of 4, and so on.
+  PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+  {
+    arma::mat& targetGradient = (target == 0) ? fullGradient :
+        gradients[target - 1];
+    targetGradient += gradients[source - 1];
+    objectives[target] += objectives[source];
+  });
+  fullGradient /= (double) numFunctions;
+
+  return objectives[0];
+}
+
+/**
+ * Compute the gradients of the same batch of separable functions at two
+ * points, as the variance reduced methods need in every step.  If parallel is
+ * true and OpenMP is enabled, the batch is split into contiguous chunks and
+ * the gradients of every chunk at both points are computed by the available
+ * threads (so that even a batch of one function uses two threads); the chunks
+ * are then added pairwise in a fixed tree, as in FullEvaluateWithGradient(), so
+ * the result is reproducible for a given number of threads (and for any number
+ * of threads in the deterministic mode).  The function must be safe to
+ * evaluate concurrently if parallel is true.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates First point.
+ * @param coordinates0 Second point.
+ * @param begin First function of the batch.
+ * @param batchSize Number of functions in the batch.
+ * @param gradient Matrix to store the gradient at the first point in.
+ * @param gradient0 Matrix to store the gradient at the second point in.
+ * @param buffers Storage for the gradients of the chunks, which can be kept
+ *     between calls to avoid allocations.
+ * @param parallel Whether to evaluate the chunks with several threads.
+ */
+template<typename FunctionType>
+void BatchGradientPair(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const arma::mat& coordinates0,
+                       const size_t begin,
+                       const size_t batchSize,
+                       arma::mat& gradient,
+                       arma::mat& gradient0,
+                       std::vector<arma::mat>& buffers,
+                       const bool parallel = false)
+{
+  #ifdef ENS_USE_OPENMP
+    const size_t maxThreads = omp_get_max_threads();
+  #else
+    const size_t maxThreads = 1;
+  #endif
+  // In the deterministic mode, there are ENS_DETERMINISTIC_CHUNKS chunks of
+  // the batch, so twice as many tasks.
+  const size_t numTasks = !parallel ? 1 : (Deterministic() ?
+      2 * ParallelChunks(maxThreads, batchSize) :
+      std::min(maxThreads, 2 * batchSize));
+
+  if (numTasks <= 1)
+  {
+    function.Gradient(coordinates, begin, gradient, batchSize);
+    function.Gradient(coordinates0, begin, gradient0, batchSize);
+    return;
+  }
+
+  // Task t computes the gradient of chunk t / 2 at the first point if t is
+  // even, and at the second point otherwise.  The first chunk uses gradient
+  // and gradient0.
+  const size_t numChunks = std::max(numTasks / 2, (size_t) 1);
+  if (buffers.size() < 2 * (numChunks - 1))
+    buffers.resize(2 * (numChunks - 1));
+  const uint64_t seed = ChunkRandomSeed();
+
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    // The team may be smaller than requested, so each thread takes every
+    // numThreads'th task.
+    for (size_t t = threadId; t < 2 * numChunks; t += numThreads)
+    {
+      const size_t c = t / 2;
+      const bool second = (t % 2 == 1);
+      ChunkRandomScope chunkScope(seed, c);
+      arma::mat& target = (c == 0) ? (second ? gradient0 : gradient) :
+          buffers[2 * (c - 1) + (second ? 1 : 0)];
+
+      const size_t chunkBegin = begin + c * batchSize / numChunks;
+      const size_t chunkEnd = begin + (c + 1) * batchSize / numChunks;
+      function.Gradient(second ? coordinates0 : coordinates, chunkBegin,
+          target, chunkEnd - chunkBegin);
+    }
+  }
+
+  // Add the chunks pairwise, as in FullEvaluateWithGradient().
+  PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+  {
+    arma::mat& targetGradient = (target == 0) ? gradient :
+        buffers[2 * (target - 1)];
+    arma::mat& targetGradient0 = (target == 0) ? gradient0 :
+        buffers[2 * (target - 1) + 1];
+    targetGradient += buffers[2 * (source - 1)];
+    targetGradient0 += buffers[2 * (source - 1) + 1];
+  });
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file gradient_update.hpp
+ * @author Marcus Edel
+ *
+ * Update the gradient of a differentiable function after a step towards a
+ * single coordinate, with the UpdateGradient() method of the function if it has
+ * one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_GRADIENT_UPDATE_HPP
+#define ENSMALLEN_FUNCTION_GRADIENT_UPDATE_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * GradientUpdate calls the UpdateGradient() method of functions that have one
+ * (see traits::HasGradientUpdate), and reports that the gradient has to be
+ * computed again for the others.
+ *
+ * @tparam FunctionType Type of the differentiable function.
+ */
+template<typename FunctionType,
+         bool HasUpdate = traits::HasGradientUpdate<FunctionType>::value>
+class GradientUpdate
+{
+ public:
+  //! The function has no UpdateGradient() method.
+  static bool Update(FunctionType& /* function */,
+                     const arma::mat& /* coordinates */,
+                     const double /* gamma */,
+                     const size_t /* index */,
+                     const double /* value */,
+                     arma::mat& /* gradient */)
+  {
+    return false;
+  }
+};
+
+/**
+ * Specialization for functions with an UpdateGradient() method.
+ */
+template<typename FunctionType>
+class GradientUpdate<FunctionType, true>
+{
+ public:
+  //! Update the gradient with UpdateGradient().
+  static bool Update(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const double gamma,
+                     const size_t index,
+                     const double value,
+                     arma::mat& gradient)
+  {
+    ENS_PROFILE_FUNCTION(Gradient);
+    function.UpdateGradient(coordinates, gamma, index, value, gradient);
+    return true;
+  }
+};
+
+/**
+ * Replace the gradient at the previous coordinates with the gradient at
+ * coordinates, after the step
+ * \f$ x \leftarrow (1 - \gamma) x + \gamma \cdot value \cdot e_{index} \f$,
+ * with the UpdateGradient() method of the function, if it has one.  If false
+ * is returned, gradient is unchanged and must be computed again.
+ *
+ * @param function Differentiable function.
+ * @param coordinates Coordinates after the step.
+ * @param gamma Step size.
+ * @param index Linear index of the non-zero element of the atom.
+ * @param value Value of the non-zero element of the atom.
+ * @param gradient Gradient at the previous coordinates, updated in place.
+ * @return true if the gradient was updated.
+ */
+template<typename FunctionType>
+inline bool TryUpdateGradient(FunctionType& function,
+                              const arma::mat& coordinates,
+                              const double gamma,
+                              const size_t index,
+                              const double value,
+                              arma::mat& gradient)
+{
+  return GradientUpdate<FunctionType>::Update(function, coordinates, gamma,
+      index, value, gradient);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file gradient_variance.hpp
+ * @author Marcus Edel
+ *
+ * Compute the gradient of a batch of separable functions and the spread of
+ * their individual gradients with the GradientVariance() method of a function,
+ * if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_GRADIENT_VARIANCE_HPP
+#define ENSMALLEN_FUNCTION_GRADIENT_VARIANCE_HPP
+
+#include "traits.hpp"
+#include "visitation_order.hpp"
+
+namespace ens {
+
+/**
+ * BatchGradientVariance calls the GradientVariance() method of functions that
+ * have one (see traits::HasBatchGradientVariance), and does nothing for the
+ * others.
+ *
+ * @tparam FunctionType Type of the function to differentiate.
+ */
+template<typename FunctionType,
+         bool HasVariance = traits::HasBatchGradientVariance<
+             FunctionType>::value>
+class BatchGradientVariance
+{
+ public:
+  //! The function has no GradientVariance() method.
+  static bool Gradient(FunctionType& /* function */,
+                       const arma::mat& /* coordinates */,
+                       const size_t /* begin */,
+                       arma::mat& /* gradient */,
+                       const size_t /* batchSize */,
+                       double& /* variance */)
+  {
+    return false;
+  }
+};
+
+/**
+ * Specialization for functions with a GradientVariance() method.
+ */
+template<typename FunctionType>
+class BatchGradientVariance<FunctionType, true>
+{
+ public:
+  //! Compute the gradient and the variance with GradientVariance().
+  static bool Gradient(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const size_t begin,
+                       arma::mat& gradient,
+                       const size_t batchSize,
+                       double& variance)
+  {
+    ENS_PROFILE_FUNCTION(Gradient);
+    variance = function.GradientVariance(coordinates, begin, gradient,
+        batchSize);
+    return true;
+  }
+};
+
+/**
+ * IndexedGradientVariance calls the indexed GradientVariance() method of the
+ * function visited by an IndexedFunction, if it has one (see
+ * traits::HasIndexedBatchGradientVariance).
+ *
+ * @tparam FunctionType Type of the visited function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasVariance = traits::HasIndexedBatchGradientVariance<
+             FunctionType>::value>
+class IndexedGradientVariance
+{
+ public:
+  //! The visited function has no indexed GradientVariance() method.
+  static bool Gradient(
+      IndexedFunction<FunctionType, MatType, GradType>& /* visited */,
+      const arma::mat& /* coordinates */,
+      const size_t /* begin */,
+      arma::mat& /* gradient */,
+      const size_t /* batchSize */,
+      double& /* variance */)
+  {
+    return false;
+  }
+};
+
+/**
+ * Specialization for visited functions with an indexed GradientVariance()
+ * method.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+class IndexedGradientVariance<FunctionType, MatType, GradType, true>
+{
+ public:
+  //! Compute the gradient and the variance of the batch in the visited order.
+  static bool Gradient(
+      IndexedFunction<FunctionType, MatType, GradType>& visited,
+      const arma::mat& coordinates,
+      const size_t begin,
+      arma::mat& gradient,
+      const size_t batchSize,
+      double& variance)
+  {
+    ENS_PROFILE_FUNCTION(Gradient);
+    variance = visited.VisitedFunction().GradientVariance(coordinates,
+        visited.Order().subvec(begin, begin + batchSize - 1), gradient);
+    return true;
+  }
+};
+
+/**
+ * Specialization for functions visited through an IndexedFunction.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+class BatchGradientVariance<IndexedFunction<FunctionType, MatType, GradType>,
+                            false>
+{
+ public:
+  //! Compute the gradient and the variance of the batch, if possible.
+  static bool Gradient(
+      IndexedFunction<FunctionType, MatType, GradType>& visited,
+      const arma::mat& coordinates,
+      const size_t begin,
+      arma::mat& gradient,
+      const size_t batchSize,
+      double& variance)
+  {
+    return IndexedGradientVariance<FunctionType, MatType, GradType>::Gradient(
+        visited, coordinates, begin, gradient, batchSize, variance);
+  }
+};
+
+/**
+ * Compute the sum of the gradients of the given batch of separable functions
+ * and the sum of the squared distances between each of their gradients and the
+ * mean gradient, with the GradientVariance() method of the function, if it has
+ * one.  The caller is expected to compute the gradients one by one if false is
+ * returned.
+ *
+ * @param function Function to differentiate (not wrapped in Function<>).
+ * @param coordinates Coordinates to compute the gradient at.
+ * @param begin Index of the first separable function of the batch.
+ * @param gradient Matrix to store the sum of the gradients in.
+ * @param batchSize Number of separable functions in the batch.
+ * @param variance Sum of the squared distances to the mean gradient.
+ * @return true if the gradient and the variance were computed.
+ */
+template<typename FunctionType>
+inline bool TryGradientVariance(FunctionType& function,
+                                const arma::mat& coordinates,
+                                const size_t begin,
+                                arma::mat& gradient,
+                                const size_t batchSize,
+                                double& variance)
+{
+  return BatchGradientVariance<FunctionType>::Gradient(function, coordinates,
+      begin, gradient, batchSize, variance);
+}
+
+} // namespace ens
+
+#endif
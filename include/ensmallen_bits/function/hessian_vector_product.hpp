@@ -0,0 +1,113 @@
+/**
+ * @file hessian_vector_product.hpp
+ * @author Marcus Edel
+ *
+ * Multiply the Hessian of a differentiable function with a vector, with the
+ * HessianVectorProduct() method of the function if it has one, and with a
+ * finite difference of gradients otherwise.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+#define ENSMALLEN_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * HessianProduct calls the HessianVectorProduct() method of functions that have
+ * one (see traits::HasHessianVectorProduct).  For the others, the product is
+ * approximated by the forward difference
+ * \f$ (\nabla f(x + \epsilon v) - \nabla f(x)) / \epsilon \f$, which costs one
+ * more call to Gradient().
+ *
+ * @tparam FunctionType Type of the differentiable function.
+ */
+template<typename FunctionType,
+         bool HasProduct = traits::HasHessianVectorProduct<FunctionType>::value>
+class HessianProduct
+{
+ public:
+  //! The product is approximated.
+  static const bool Exact = false;
+
+  //! Approximate the product with a forward difference of the gradients.
+  static void Product(FunctionType& function,
+                      const arma::mat& coordinates,
+                      const arma::mat& gradient,
+                      const arma::mat& v,
+                      arma::mat& product)
+  {
+    const double vNorm = arma::norm(v, 2);
+    if (vNorm == 0.0)
+    {
+      product.zeros(arma::size(v));
+      return;
+    }
+
+    // Scale the difference with the size of the coordinates, so that it is
+    // about the square root of the machine precision relative to them.
+    const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon()) *
+        (1.0 + arma::norm(coordinates, 2)) / vNorm;
+    typedef Function<FunctionType> FullFunctionType;
+    static_cast<FullFunctionType&>(function).Gradient(coordinates +
+        epsilon * v, product);
+    product -= gradient;
+    product /= epsilon;
+  }
+};
+
+/**
+ * Specialization for functions with a HessianVectorProduct() method.
+ */
+template<typename FunctionType>
+class HessianProduct<FunctionType, true>
+{
+ public:
+  //! The product is exact.
+  static const bool Exact = true;
+
+  //! Compute the product with HessianVectorProduct().
+  static void Product(FunctionType& function,
+                      const arma::mat& coordinates,
+                      const arma::mat& /* gradient */,
+                      const arma::mat& v,
+                      arma::mat& product)
+  {
+    ENS_PROFILE_FUNCTION(Gradient);
+    function.HessianVectorProduct(coordinates, v, product);
+  }
+};
+
+/**
+ * Store the product of the Hessian of the function at the given coordinates
+ * with v in product.  If the function has a HessianVectorProduct() method, it
+ * is used; otherwise the product is approximated by a finite difference of
+ * the gradients, for which the gradient at the coordinates must be given.  The
+ * function should not be wrapped in Function<>, so that its methods are
+ * detected.
+ *
+ * @param function Differentiable function.
+ * @param coordinates Coordinates to compute the Hessian at.
+ * @param gradient Gradient of the function at the coordinates.
+ * @param v Vector (in the shape of the coordinates) to multiply with.
+ * @param product Matrix to store the product in.
+ */
+template<typename FunctionType>
+inline void HessianVectorProduct(FunctionType& function,
+                                 const arma::mat& coordinates,
+                                 const arma::mat& gradient,
+                                 const arma::mat& v,
+                                 arma::mat& product)
+{
+  HessianProduct<FunctionType>::Product(function, coordinates, gradient, v,
+      product);
+}
+
+} // namespace ens
+
+#endif
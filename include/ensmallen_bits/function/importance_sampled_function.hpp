@@ -0,0 +1,185 @@
+/**
+ * @file importance_sampled_function.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper for a differentiable separable function whose batches are drawn by
+ * importance sampling, for the SGD-like optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_IMPORTANCE_SAMPLED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_IMPORTANCE_SAMPLED_FUNCTION_HPP
+
+#include <ensmallen_bits/utility/importance_sampler.hpp>
+
+namespace ens {
+
+/**
+ * ImportanceSampledFunction wraps a differentiable separable function so that
+ * each batch asked for by an optimizer is made of separable functions drawn
+ * with probabilities p_i from an ImportanceSampler, instead of consecutive
+ * ones.  Each drawn function is weighted by 1 / (n p_i), so that the objective
+ * and the gradient of a batch are unbiased estimates of those of a batch of
+ * the same size drawn uniformly; drawing the functions with large gradients
+ * more often reduces the variance of the estimate.
+ *
+ * The probabilities are proportional to the given weights, such as per-sample
+ * Lipschitz constants of the gradients (e.g. ||x_i||^2 for a least squares
+ * problem); if no weights are given, or if adaptive is set, the weight of a
+ * function is replaced by the absolute value of its objective each time it is
+ * drawn, so that the functions with a large recent loss are drawn more often.
+ *
+ * @code
+ * LogisticRegressionFunction<> lrf(data, responses, 0.5);
+ * ImportanceSampledFunction<LogisticRegressionFunction<>> sampled(lrf);
+ *
+ * StandardSGD sgd(0.01, 32);
+ * sgd.Optimize(sampled, coordinates);
+ * @endcode
+ *
+ * As the batch is drawn again at every call, Shuffle() does nothing, and the
+ * begin argument of EvaluateWithGradient() and Gradient() is ignored.
+ * Evaluate() of a batch is not sampled: it computes the exact objective of the
+ * given consecutive functions, so that the final objective reported by an
+ * optimizer is exact.  The drawn functions are evaluated one at a time, and the
+ * wrapper must not be used with the parallelBatch option of SGD.  The wrapped
+ * function must outlive the wrapper.
+ *
+ * @tparam FunctionType Type of the differentiable separable function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class ImportanceSampledFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function, with weights adapted to the recent losses.
+   *
+   * @param function Function to wrap.
+   * @param uniformity Fraction of the probability spread uniformly.
+   */
+  ImportanceSampledFunction(FunctionType& function,
+                            const double uniformity = 0.1) :
+      function(function),
+      sampler(function.NumFunctions(), uniformity),
+      adaptive(true)
+  { /* Nothing to do. */ }
+
+  /**
+   * Wrap the given function, with the given weights.
+   *
+   * @param function Function to wrap.
+   * @param weights Weight of each separable function.
+   * @param uniformity Fraction of the probability spread uniformly.
+   * @param adaptive If true, the weights are replaced by the recent losses.
+   */
+  ImportanceSampledFunction(FunctionType& function,
+                            const arma::vec& weights,
+                            const double uniformity = 0.1,
+                            const bool adaptive = false) :
+      function(function),
+      sampler(0, uniformity),
+      adaptive(adaptive)
+  {
+    if (weights.n_elem != function.NumFunctions())
+    {
+      std::ostringstream oss;
+      oss << "ImportanceSampledFunction: expected " << function.NumFunctions()
+          << " weights, but got " << weights.n_elem;
+      throw std::invalid_argument(oss.str());
+    }
+
+    sampler.Reset(weights);
+  }
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return sampler.Size(); }
+
+  //! The batches are drawn at random, so there is nothing to shuffle.
+  void Shuffle() { }
+
+  //! Evaluate the given consecutive separable functions (not sampled).
+  ElemType Evaluate(const MatType& coordinates,
+                    const size_t begin,
+                    const size_t batchSize)
+  {
+    return Full().Evaluate(coordinates, begin, batchSize);
+  }
+
+  //! Compute the sampled gradient of a batch of the given size.
+  void Gradient(const MatType& coordinates,
+                const size_t /* begin */,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    EvaluateWithGradient(coordinates, 0, gradient, batchSize);
+  }
+
+  //! Compute the sampled objective and gradient of a batch of the given size.
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                const size_t /* begin */,
+                                GradType& gradient,
+                                const size_t batchSize)
+  {
+    const double n = double(sampler.Size());
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+
+    ElemType objective = 0;
+    for (size_t k = 0; k < batchSize; ++k)
+    {
+      const size_t i = sampler.Sample();
+      const double weight = 1.0 / (n * sampler.Probability(i));
+
+      const ElemType sampleObjective = Full().EvaluateWithGradient(coordinates,
+          i, sampleGradient, 1);
+      objective += ElemType(weight) * sampleObjective;
+      gradient += ElemType(weight) * sampleGradient;
+
+      if (adaptive)
+        sampler.Update(i, std::abs(double(sampleObjective)));
+    }
+
+    return objective;
+  }
+
+  //! Get the sampler of the separable functions.
+  const ImportanceSampler& Sampler() const { return sampler; }
+  //! Modify the sampler of the separable functions.
+  ImportanceSampler& Sampler() { return sampler; }
+
+  //! Get whether the weights are replaced by the recent losses.
+  bool Adaptive() const { return adaptive; }
+  //! Modify whether the weights are replaced by the recent losses.
+  bool& Adaptive() { return adaptive; }
+
+ private:
+  //! Get the wrapped function, with the methods it lacks.
+  Function<FunctionType, MatType, GradType>& Full()
+  {
+    return static_cast<Function<FunctionType, MatType, GradType>&>(function);
+  }
+
+  //! The wrapped function.
+  FunctionType& function;
+
+  //! The sampler of the separable functions.
+  ImportanceSampler sampler;
+
+  //! Whether the weights are replaced by the recent losses.
+  bool adaptive;
+
+  //! The gradient of one drawn function, kept between calls.
+  GradType sampleGradient;
+};
+
+} // namespace ens
+
+#endif
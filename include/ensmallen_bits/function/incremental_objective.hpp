@@ -0,0 +1,87 @@
+/**
+ * @file incremental_objective.hpp
+ * @author Marcus Edel
+ *
+ * Keep track of the objective of a partially differentiable function as single
+ * features are updated, with its InitializeObjective() and UpdateObjective()
+ * methods if it has them.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_INCREMENTAL_OBJECTIVE_HPP
+#define ENSMALLEN_FUNCTION_INCREMENTAL_OBJECTIVE_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * IncrementalObjective forwards to the InitializeObjective() and
+ * UpdateObjective() methods of functions that have them (see
+ * traits::HasIncrementalObjective).  For the other functions, Tracked is false
+ * and the optimizer has to call Evaluate() to get the objective.
+ *
+ * @tparam FunctionType Type of the partially differentiable function.
+ */
+template<typename FunctionType,
+         bool HasIncremental =
+             traits::HasIncrementalObjective<FunctionType>::value>
+class IncrementalObjective
+{
+ public:
+  //! The objective is not tracked.
+  static const bool Tracked = false;
+
+  //! The function has no InitializeObjective() method.
+  static double Initialize(FunctionType& /* function */,
+                           const arma::mat& /* coordinates */)
+  {
+    return 0.0;
+  }
+
+  //! The function has no UpdateObjective() method.
+  static double Update(FunctionType& /* function */,
+                       const arma::mat& /* coordinates */,
+                       const size_t /* j */,
+                       const arma::vec& /* delta */)
+  {
+    return 0.0;
+  }
+};
+
+/**
+ * Specialization for functions with InitializeObjective() and UpdateObjective()
+ * methods.
+ */
+template<typename FunctionType>
+class IncrementalObjective<FunctionType, true>
+{
+ public:
+  //! The objective is tracked by the function.
+  static const bool Tracked = true;
+
+  //! Set up the state of the function and return the objective.
+  static double Initialize(FunctionType& function,
+                           const arma::mat& coordinates)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return function.InitializeObjective(coordinates);
+  }
+
+  //! Return the objective after column j of the coordinates changed by delta.
+  static double Update(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const size_t j,
+                       const arma::vec& delta)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return function.UpdateObjective(coordinates, j, delta);
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,270 @@
+/**
+ * @file multi_model_function.hpp
+ * @author Marcus Edel
+ *
+ * A wrapper that presents several models of the same data, which differ only
+ * in their hyper-parameters, as one separable function, so that they are
+ * trained in a single pass over the data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_MULTI_MODEL_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_MULTI_MODEL_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * MultiModelFunction wraps K separable functions of the same data, such as
+ * logistic regression models with different regularization parameters, and
+ * presents them as the sum of their objectives, with the parameters of model k
+ * in column k of the coordinates.  An SGD-based optimizer then trains all the
+ * models in one pass over the data.  Since each model is a contiguous range of
+ * the coordinates, ParameterGroups can give each model its own step size and
+ * its own instance of the update policy.
+ *
+ * If the function type has a static EvaluateWithGradient() method over
+ * several models (see traits::HasMultiModelGradient), as
+ * LogisticRegressionFunction does, the gradients of the models on a batch are
+ * computed with it in one call: the work on the batch becomes a few matrix
+ * products instead of one pass for each model.  Otherwise each model is
+ * evaluated on its own column, which is given to it as a column vector, or as
+ * a row vector if rowParameters is true (as for LogisticRegressionFunction).
+ *
+ * @code
+ * std::vector<LogisticRegressionFunction<>> models;
+ * const arma::vec lambdas("0.0 0.01 0.1 1.0");
+ * for (size_t k = 0; k < lambdas.n_elem; ++k)
+ * {
+ *   models.push_back(LogisticRegressionFunction<>(data, responses,
+ *       lambdas[k]));
+ * }
+ *
+ * MultiModelFunction<LogisticRegressionFunction<>> f(models, true);
+ * const size_t n = data.n_rows + 1;
+ * arma::mat coordinates(n, lambdas.n_elem, arma::fill::zeros);
+ *
+ * // Model k has a step size of 0.01 * stepScales[k].
+ * const arma::vec stepScales("1.0 1.0 0.5 0.1");
+ * ParameterGroups<VanillaUpdate> groups;
+ * for (size_t k = 0; k < stepScales.n_elem; ++k)
+ *   groups.Add(k * n, n, VanillaUpdate(), stepScales[k]);
+ * SGD<ParameterGroups<VanillaUpdate>> optimizer(0.01, 32, 100000, -1.0, false,
+ *     groups);
+ * optimizer.Optimize(f, coordinates);
+ *
+ * arma::vec objectives;
+ * f.Objectives(coordinates, objectives); // The objective of each model.
+ * @endcode
+ *
+ * @tparam FunctionType Type of the model functions.
+ */
+template<typename FunctionType>
+class MultiModelFunction
+{
+ public:
+  /**
+   * Wrap the given models; they must outlive the wrapper, and have the same
+   * number of separable functions.
+   *
+   * @param models The model functions.
+   * @param rowParameters If true, the models take their parameters as a row
+   *     vector instead of a column vector.
+   */
+  MultiModelFunction(std::vector<FunctionType>& models,
+                     const bool rowParameters = false) :
+      models(models),
+      rowParameters(rowParameters)
+  {
+    if (models.empty())
+    {
+      throw std::invalid_argument("MultiModelFunction::MultiModelFunction(): "
+          "there must be at least one model.");
+    }
+
+    for (size_t k = 1; k < models.size(); ++k)
+    {
+      if (models[k].NumFunctions() != models[0].NumFunctions())
+      {
+        throw std::invalid_argument("MultiModelFunction::MultiModelFunction():"
+            " all the models must have the same number of functions.");
+      }
+    }
+  }
+
+  //! Return the number of separable functions, that of each model.
+  size_t NumFunctions() const { return models[0].NumFunctions(); }
+
+  //! Return the number of models.
+  size_t NumModels() const { return models.size(); }
+
+  //! Shuffle the separable functions.  With the batched gradient only the
+  //! points of the first model are used, so only they are shuffled.
+  void Shuffle()
+  {
+    const size_t numShuffled = traits::HasMultiModelGradient<
+        FunctionType>::value ? 1 : models.size();
+    for (size_t k = 0; k < numShuffled; ++k)
+      models[k].Shuffle();
+  }
+
+  /**
+   * Evaluate the sum of the objectives of the models on the given batch.
+   *
+   * @param coordinates Parameters of the models, one column per model.
+   * @param begin The first separable function of the batch.
+   * @param batchSize Number of separable functions in the batch.
+   */
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    CheckColumns(coordinates, "Evaluate");
+
+    double objective = 0.0;
+    for (size_t k = 0; k < models.size(); ++k)
+    {
+      Parameters(coordinates, k);
+      objective += Model(k).Evaluate(parameters, begin, batchSize);
+    }
+
+    return objective;
+  }
+
+  /**
+   * Evaluate the sum of the objectives of the models on the given batch, and
+   * the gradient of each model in the corresponding column of gradient.
+   *
+   * @param coordinates Parameters of the models, one column per model.
+   * @param begin The first separable function of the batch.
+   * @param gradient Matrix to store the gradients in.
+   * @param batchSize Number of separable functions in the batch.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    CheckColumns(coordinates, "EvaluateWithGradient");
+    return EvaluateWithGradient(coordinates, begin, gradient, batchSize,
+        std::integral_constant<bool,
+            traits::HasMultiModelGradient<FunctionType>::value>());
+  }
+
+  //! Evaluate the gradient of each model on the given batch.
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize)
+  {
+    EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+  }
+
+  /**
+   * Store the objective of each model over all its separable functions, for
+   * instance to pick the best model after the optimization.
+   *
+   * @param coordinates Parameters of the models, one column per model.
+   * @param objectives Vector to store the objective of each model in.
+   */
+  void Objectives(const arma::mat& coordinates, arma::vec& objectives)
+  {
+    CheckColumns(coordinates, "Objectives");
+
+    objectives.set_size(models.size());
+    for (size_t k = 0; k < models.size(); ++k)
+    {
+      Parameters(coordinates, k);
+      objectives[k] = Model(k).Evaluate(parameters, 0, NumFunctions());
+    }
+  }
+
+  //! Get the model functions.
+  const std::vector<FunctionType>& Models() const { return models; }
+  //! Modify the model functions.
+  std::vector<FunctionType>& Models() { return models; }
+
+  //! Get whether the models take their parameters as a row vector.
+  bool RowParameters() const { return rowParameters; }
+
+ private:
+  //! Get the given model with the methods added by Function<>.
+  Function<FunctionType, arma::mat, arma::mat>& Model(const size_t k)
+  {
+    return static_cast<Function<FunctionType, arma::mat, arma::mat>&>(
+        models[k]);
+  }
+
+  //! Make sure that the coordinates have one column per model.
+  void CheckColumns(const arma::mat& coordinates, const char* method) const
+  {
+    if (coordinates.n_cols != models.size())
+    {
+      std::ostringstream oss;
+      oss << "MultiModelFunction::" << method << "(): the coordinates have "
+          << coordinates.n_cols << " columns, but there are " << models.size()
+          << " models!";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  //! Copy the parameters of the given model into the buffer, in the shape the
+  //! model takes.
+  void Parameters(const arma::mat& coordinates, const size_t k)
+  {
+    if (rowParameters)
+      parameters = coordinates.col(k).t();
+    else
+      parameters = coordinates.col(k);
+  }
+
+  //! Evaluate all the models at once with the batched gradient.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize,
+                              std::true_type /* batched */)
+  {
+    return FunctionType::EvaluateWithGradient(models, coordinates, begin,
+        gradient, batchSize);
+  }
+
+  //! Evaluate the models one by one.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize,
+                              std::false_type /* batched */)
+  {
+    gradient.set_size(arma::size(coordinates));
+
+    double objective = 0.0;
+    for (size_t k = 0; k < models.size(); ++k)
+    {
+      Parameters(coordinates, k);
+      objective += Model(k).EvaluateWithGradient(parameters, begin,
+          modelGradient, batchSize);
+      gradient.col(k) = arma::vectorise(modelGradient);
+    }
+
+    return objective;
+  }
+
+  //! The model functions.
+  std::vector<FunctionType>& models;
+
+  //! Whether the models take their parameters as a row vector.
+  bool rowParameters;
+
+  //! The buffer of the parameters of one model.
+  arma::mat parameters;
+
+  //! The buffer of the gradient of one model.
+  arma::mat modelGradient;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * @file objective_only.hpp
+ * @author Marcus Edel
+ *
+ * Evaluate the objective of a function that only implements
+ * EvaluateWithGradient(), with its objective-only form if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_OBJECTIVE_ONLY_HPP
+#define ENSMALLEN_FUNCTION_OBJECTIVE_ONLY_HPP
+
+#include <type_traits>
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * A gradient for the synthesized Evaluate() methods to pass to
+ * EvaluateWithGradient() and ignore.  Each thread keeps one buffer per
+ * gradient type, so that repeated evaluations (line search trials, convergence
+ * checks) reuse its memory instead of allocating a gradient every time.  If
+ * the buffer is already in use, because EvaluateWithGradient() itself
+ * evaluates another function (as the wrappers do), a fresh gradient is used
+ * instead.
+ *
+ * @tparam GradType Type of the gradient.
+ */
+template<typename GradType>
+class IgnoredGradient
+{
+ public:
+  //! Take the buffer of this thread, if it is free.
+  IgnoredGradient() : owner(!InUse())
+  {
+    if (owner)
+      InUse() = true;
+  }
+
+  //! Release the buffer.
+  ~IgnoredGradient()
+  {
+    if (owner)
+      InUse() = false;
+  }
+
+  //! Get the gradient to pass to EvaluateWithGradient().
+  GradType& Get() { return owner ? Buffer() : local; }
+
+ private:
+  IgnoredGradient(const IgnoredGradient&);
+  IgnoredGradient& operator=(const IgnoredGradient&);
+
+  //! Get whether the buffer of this thread is in use.
+  static bool& InUse()
+  {
+    static thread_local bool inUse = false;
+    return inUse;
+  }
+
+  //! Get the buffer of this thread.
+  static GradType& Buffer()
+  {
+    static thread_local GradType buffer;
+    return buffer;
+  }
+
+  //! Whether this object holds the buffer of the thread.
+  bool owner;
+  //! The gradient used when the buffer is already in use.
+  GradType local;
+};
+
+/**
+ * ObjectiveOnlyEvaluation evaluates the objective of a function that only
+ * implements EvaluateWithGradient(): with its objective-only form (see
+ * ObjectiveOnly) if it has one, and otherwise with EvaluateWithGradient() and
+ * an ignored gradient.
+ *
+ * @tparam FunctionType Type of the function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ * @tparam HasObjectiveOnly Whether the objective-only form can be called.
+ */
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         bool HasObjectiveOnly>
+class ObjectiveOnlyEvaluation
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Evaluate the objective with EvaluateWithGradient() (function may be
+  //! const).
+  template<typename WrapperType>
+  static ElemType Evaluate(WrapperType& function, const MatType& coordinates)
+  {
+    IgnoredGradient<GradType> gradient;
+    return function.EvaluateWithGradient(coordinates, gradient.Get());
+  }
+
+  //! Evaluate the objective of a batch with EvaluateWithGradient() (function
+  //! may be const).
+  template<typename WrapperType>
+  static ElemType Evaluate(WrapperType& function,
+                           const MatType& coordinates,
+                           const size_t begin,
+                           const size_t batchSize)
+  {
+    IgnoredGradient<GradType> gradient;
+    return function.EvaluateWithGradient(coordinates, begin, gradient.Get(),
+        batchSize);
+  }
+
+  //! Evaluate the objective with a static EvaluateWithGradient().
+  static ElemType EvaluateStatic(const MatType& coordinates)
+  {
+    IgnoredGradient<GradType> gradient;
+    return FunctionType::EvaluateWithGradient(coordinates, gradient.Get());
+  }
+
+  //! Evaluate the objective of a batch with a static EvaluateWithGradient().
+  static ElemType EvaluateStatic(const MatType& coordinates,
+                                 const size_t begin,
+                                 const size_t batchSize)
+  {
+    IgnoredGradient<GradType> gradient;
+    return FunctionType::EvaluateWithGradient(coordinates, begin,
+        gradient.Get(), batchSize);
+  }
+};
+
+/**
+ * Specialization for functions with an objective-only EvaluateWithGradient().
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+class ObjectiveOnlyEvaluation<FunctionType, MatType, GradType, true>
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Evaluate the objective with the objective-only form.
+  template<typename WrapperType>
+  static ElemType Evaluate(WrapperType& function, const MatType& coordinates)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return Unwrap(function).EvaluateWithGradient(coordinates,
+        ObjectiveOnly());
+  }
+
+  //! Evaluate the objective of a batch with the objective-only form.
+  template<typename WrapperType>
+  static ElemType Evaluate(WrapperType& function,
+                           const MatType& coordinates,
+                           const size_t begin,
+                           const size_t batchSize)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return Unwrap(function).EvaluateWithGradient(coordinates, begin,
+        batchSize, ObjectiveOnly());
+  }
+
+  //! Evaluate the objective with the static objective-only form.
+  static ElemType EvaluateStatic(const MatType& coordinates)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return FunctionType::EvaluateWithGradient(coordinates, ObjectiveOnly());
+  }
+
+  //! Evaluate the objective of a batch with the static objective-only form.
+  static ElemType EvaluateStatic(const MatType& coordinates,
+                                 const size_t begin,
+                                 const size_t batchSize)
+  {
+    ENS_PROFILE_FUNCTION(Evaluate);
+    return FunctionType::EvaluateWithGradient(coordinates, begin, batchSize,
+        ObjectiveOnly());
+  }
+
+ private:
+  //! Get the user's function from Function<>, since the EvaluateWithGradient()
+  //! methods of Function<> hide the objective-only form.
+  template<typename WrapperType>
+  static typename std::conditional<std::is_const<WrapperType>::value,
+      const FunctionType&, FunctionType&>::type Unwrap(WrapperType& function)
+  {
+    return function;
+  }
+};
+
+} // namespace ens
+
+#endif
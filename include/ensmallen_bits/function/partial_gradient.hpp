@@ -0,0 +1,88 @@
+/**
+ * @file partial_gradient.hpp
+ * @author Marcus Edel
+ *
+ * Compute the partial gradient column of a single feature, with the dense
+ * PartialGradient() overload of a function if it has one.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_PARTIAL_GRADIENT_HPP
+#define ENSMALLEN_FUNCTION_PARTIAL_GRADIENT_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * DensePartialGradient computes the partial gradient column of a feature with
+ * the dense PartialGradient() overload of functions that have one (see
+ * traits::HasDensePartialGradient), and extracts it from the sparse partial
+ * gradient for the others.
+ *
+ * @tparam FunctionType Type of the partially differentiable function.
+ */
+template<typename FunctionType,
+         bool HasDense = traits::HasDensePartialGradient<FunctionType>::value>
+class DensePartialGradient
+{
+ public:
+  //! Compute the sparse partial gradient and copy its non-zero column.
+  static void Gradient(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const size_t j,
+                       arma::vec& gradient,
+                       arma::sp_mat& buffer)
+  {
+    function.PartialGradient(coordinates, j, buffer);
+    gradient = arma::mat(buffer.col(j));
+  }
+};
+
+/**
+ * Specialization for functions with a dense PartialGradient() overload.
+ */
+template<typename FunctionType>
+class DensePartialGradient<FunctionType, true>
+{
+ public:
+  //! Compute the partial gradient column directly.
+  static void Gradient(FunctionType& function,
+                       const arma::mat& coordinates,
+                       const size_t j,
+                       arma::vec& gradient,
+                       arma::sp_mat& /* buffer */)
+  {
+    function.PartialGradient(coordinates, j, gradient);
+  }
+};
+
+/**
+ * Store column j of the partial gradient f'_j(x) (its only non-zero column) in
+ * gradient.  If the function has a dense PartialGradient() overload, it is
+ * used; otherwise the sparse partial gradient is computed into buffer, which
+ * may be reused across calls.
+ *
+ * @param function Partially differentiable function.
+ * @param coordinates Coordinates to compute the partial gradient at.
+ * @param j Index of the feature.
+ * @param gradient Vector to store the partial gradient column in.
+ * @param buffer Sparse matrix used if there is no dense overload.
+ */
+template<typename FunctionType>
+inline void PartialGradientColumn(FunctionType& function,
+                                  const arma::mat& coordinates,
+                                  const size_t j,
+                                  arma::vec& gradient,
+                                  arma::sp_mat& buffer)
+{
+  DensePartialGradient<FunctionType>::Gradient(function, coordinates, j,
+      gradient, buffer);
+}
+
+} // namespace ens
+
+#endif
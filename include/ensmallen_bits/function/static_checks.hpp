@@ -25,13 +25,18 @@ namespace traits {
  *
  * This is required by the FunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckEvaluate
 {
   const static bool value =
-      HasEvaluate<FunctionType, EvaluateForm>::value ||
-      HasEvaluate<FunctionType, EvaluateConstForm>::value ||
-      HasEvaluate<FunctionType, EvaluateStaticForm>::value;
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          EvaluateForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          EvaluateConstForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          EvaluateStaticForm>::value;
 };
 
 /**
@@ -39,13 +44,18 @@ struct CheckEvaluate
  *
  * This is required by the FunctionType API.
  */
-template <typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckGradient
 {
   const static bool value =
-      HasGradient<FunctionType, GradientForm>::value ||
-      HasGradient<FunctionType, GradientConstForm>::value ||
-      HasGradient<FunctionType, GradientStaticForm>::value;
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          GradientForm>::value ||
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          GradientConstForm>::value ||
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          GradientStaticForm>::value;
 };
 
 /**
@@ -81,13 +91,18 @@ struct CheckShuffle
  *
  * This is required by the DecomposableFunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckDecomposableEvaluate
 {
   const static bool value =
-      HasEvaluate<FunctionType, DecomposableEvaluateForm>::value ||
-      HasEvaluate<FunctionType, DecomposableEvaluateConstForm>::value ||
-      HasEvaluate<FunctionType, DecomposableEvaluateStaticForm>::value;
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableEvaluateForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableEvaluateConstForm>::value ||
+      HasEvaluate<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableEvaluateStaticForm>::value;
 };
 
 /**
@@ -95,13 +110,18 @@ struct CheckDecomposableEvaluate
  *
  * This is required by the DecomposableFunctionType API.
  */
-template <typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckDecomposableGradient
 {
   const static bool value =
-      HasGradient<FunctionType, DecomposableGradientForm>::value ||
-      HasGradient<FunctionType, DecomposableGradientConstForm>::value ||
-      HasGradient<FunctionType, DecomposableGradientStaticForm>::value;
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableGradientForm>::value ||
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableGradientConstForm>::value ||
+      HasGradient<FunctionType, TypedForms<MatType, GradType>::template
+          DecomposableGradientStaticForm>::value;
 };
 
 /**
@@ -186,7 +206,8 @@ struct CheckPartialGradient
   const static bool value =
       HasPartialGradient<FunctionType, PartialGradientForm>::value ||
       HasPartialGradient<FunctionType, PartialGradientConstForm>::value ||
-      HasPartialGradient<FunctionType, PartialGradientStaticForm>::value;
+      HasPartialGradient<FunctionType, PartialGradientStaticForm>::value ||
+      HasDensePartialGradient<FunctionType>::value;
 };
 
 /**
@@ -194,14 +215,20 @@ struct CheckPartialGradient
  *
  * This is required by the FunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckEvaluateWithGradient
 {
   const static bool value =
-      HasEvaluateWithGradient<FunctionType, EvaluateWithGradientForm>::value ||
       HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
+          EvaluateWithGradientForm>::value ||
+      HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
           EvaluateWithGradientConstForm>::value ||
       HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
           EvaluateWithGradientStaticForm>::value;
 };
 
@@ -211,65 +238,177 @@ struct CheckEvaluateWithGradient
  *
  * This is required by the FunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 struct CheckDecomposableEvaluateWithGradient
 {
   const static bool value =
       HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
           DecomposableEvaluateWithGradientForm>::value ||
       HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
           DecomposableEvaluateWithGradientConstForm>::value ||
       HasEvaluateWithGradient<FunctionType,
+          TypedForms<MatType, GradType>::template
           DecomposableEvaluateWithGradientStaticForm>::value;
 };
 
+//! Get the user's function type from a type that may be wrapped in Function<>.
+template<typename FunctionType>
+struct UnwrapFunction
+{
+  typedef FunctionType type;
+};
+
+//! Specialization for functions wrapped in Function<>.
+template<typename FunctionType, typename MatType, typename GradType>
+struct UnwrapFunction<Function<FunctionType, MatType, GradType>>
+{
+  typedef FunctionType type;
+};
+
+/**
+ * A compile-time description of the methods of a function.  For each method,
+ * Native is true if the function implements it, and the flag without prefix is
+ * true if it is available at all once the function is wrapped in Function<>;
+ * Synthesized flags the methods that Function<> has to build from the others.
+ * In particular, a synthesized EvaluateWithGradient() calls Evaluate() and
+ * Gradient() one after the other, which costs two passes over the data.
+ *
+ * The given type may itself be wrapped in Function<>.
+ *
+ * @code
+ * typedef traits::FunctionCapabilities<MyFunction> Capabilities;
+ * static_assert(!Capabilities::SynthesizedEvaluateWithGradient,
+ *     "MyFunction should implement EvaluateWithGradient().");
+ * @endcode
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+struct FunctionCapabilities
+{
+  //! The user's function type.
+  typedef typename UnwrapFunction<FunctionType>::type UserFunctionType;
+  //! The wrapped function type, with the synthesized methods.
+  typedef Function<UserFunctionType, MatType, GradType> FullFunctionType;
+
+  const static bool NativeEvaluate =
+      CheckEvaluate<UserFunctionType, MatType, GradType>::value;
+  const static bool NativeGradient =
+      CheckGradient<UserFunctionType, MatType, GradType>::value;
+  const static bool NativeEvaluateWithGradient =
+      CheckEvaluateWithGradient<UserFunctionType, MatType, GradType>::value;
+  const static bool NativeDecomposableEvaluate =
+      CheckDecomposableEvaluate<UserFunctionType, MatType, GradType>::value;
+  const static bool NativeDecomposableGradient =
+      CheckDecomposableGradient<UserFunctionType, MatType, GradType>::value;
+  const static bool NativeDecomposableEvaluateWithGradient =
+      CheckDecomposableEvaluateWithGradient<UserFunctionType, MatType,
+          GradType>::value;
+
+  const static bool Evaluate =
+      CheckEvaluate<FullFunctionType, MatType, GradType>::value;
+  const static bool Gradient =
+      CheckGradient<FullFunctionType, MatType, GradType>::value;
+  const static bool EvaluateWithGradient =
+      CheckEvaluateWithGradient<FullFunctionType, MatType, GradType>::value;
+  const static bool DecomposableEvaluate =
+      CheckDecomposableEvaluate<FullFunctionType, MatType, GradType>::value;
+  const static bool DecomposableGradient =
+      CheckDecomposableGradient<FullFunctionType, MatType, GradType>::value;
+  const static bool DecomposableEvaluateWithGradient =
+      CheckDecomposableEvaluateWithGradient<FullFunctionType, MatType,
+          GradType>::value;
+
+  const static bool SynthesizedEvaluate = Evaluate && !NativeEvaluate;
+  const static bool SynthesizedGradient = Gradient && !NativeGradient;
+  const static bool SynthesizedEvaluateWithGradient =
+      EvaluateWithGradient && !NativeEvaluateWithGradient;
+  const static bool SynthesizedDecomposableEvaluate =
+      DecomposableEvaluate && !NativeDecomposableEvaluate;
+  const static bool SynthesizedDecomposableGradient =
+      DecomposableGradient && !NativeDecomposableGradient;
+  const static bool SynthesizedDecomposableEvaluateWithGradient =
+      DecomposableEvaluateWithGradient &&
+      !NativeDecomposableEvaluateWithGradient;
+};
+
 /**
  * Perform checks for the regular FunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 inline void CheckFunctionTypeAPI()
 {
-  static_assert(CheckEvaluate<FunctionType>::value,
+  static_assert(CheckEvaluate<FunctionType, MatType, GradType>::value,
       "The FunctionType does not have a correct definition of Evaluate(). "
       "Please check that the FunctionType fully satisfies the requirements of "
       "the FunctionType API; see the optimizer tutorial for details.");
 
-  static_assert(CheckGradient<FunctionType>::value,
+  static_assert(CheckGradient<FunctionType, MatType, GradType>::value,
       "The FunctionType does not have a correct definition of Gradient(). "
       "Please check that the FunctionType fully satisfies the requirements of "
       "the FunctionType API; see the optimizer tutorial for details.");
 
-  static_assert(CheckEvaluateWithGradient<FunctionType>::value,
+  static_assert(CheckEvaluateWithGradient<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of "
       "EvaluateWithGradient().  Please check that the FunctionType fully "
       "satisfies the requirements of the FunctionType API; see the optimizer "
       "tutorial for more details.");
+
+  #ifdef ENS_STRICT_FUNCTIONS
+  static_assert(!FunctionCapabilities<FunctionType, MatType,
+      GradType>::SynthesizedEvaluateWithGradient,
+      "ENS_STRICT_FUNCTIONS is defined, but the FunctionType does not "
+      "implement EvaluateWithGradient(), so each call would cost a call to "
+      "Evaluate() and a call to Gradient().  Please implement "
+      "EvaluateWithGradient(), or undefine ENS_STRICT_FUNCTIONS.");
+  #endif
 }
 
 /**
  * Perform checks for the DecomposableFunctionType API.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
 inline void CheckDecomposableFunctionTypeAPI()
 {
-  static_assert(CheckDecomposableEvaluate<FunctionType>::value,
+  static_assert(CheckDecomposableEvaluate<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of a decomposable "
       "Evaluate() method.  Please check that the FunctionType fully satisfies"
       " the requirements of the DecomposableFunctionType API; see the optimizer"
       " tutorial for more details.");
 
-  static_assert(CheckDecomposableGradient<FunctionType>::value,
+  static_assert(CheckDecomposableGradient<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of a decomposable "
       "Gradient() method.  Please check that the FunctionType fully satisfies"
       " the requirements of the DecomposableFunctionType API; see the optimizer"
       " tutorial for more details.");
 
-  static_assert(CheckDecomposableEvaluateWithGradient<FunctionType>::value,
+  static_assert(CheckDecomposableEvaluateWithGradient<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of a decomposable "
       "EvaluateWithGradient() method.  Please check that the FunctionType "
       "fully satisfies the requirements of the DecomposableFunctionType API; "
       "see the optimizer tutorial for more details.");
 
+  #ifdef ENS_STRICT_FUNCTIONS
+  static_assert(!FunctionCapabilities<FunctionType, MatType,
+      GradType>::SynthesizedDecomposableEvaluateWithGradient,
+      "ENS_STRICT_FUNCTIONS is defined, but the FunctionType does not "
+      "implement a decomposable EvaluateWithGradient(), so each batch would "
+      "cost a call to Evaluate() and a call to Gradient().  Please implement "
+      "EvaluateWithGradient(), or undefine ENS_STRICT_FUNCTIONS.");
+  #endif
+
   static_assert(CheckNumFunctions<FunctionType>::value,
       "The FunctionType does not have a correct definition of NumFunctions(). "
       "Please check that the FunctionType fully satisfies the requirements of "
@@ -284,9 +423,12 @@ inline void CheckDecomposableFunctionTypeAPI()
 }
 
 /**
- * Perform checks for the SparseFunctionType API.
+ * Perform checks for the SparseFunctionType API.  By default the gradient is
+ * expected to be sparse, but a dense GradType may also be given.
  */
-template<typename FunctionType>
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = arma::SpMat<typename MatType::elem_type>>
 inline void CheckSparseFunctionTypeAPI()
 {
   static_assert(CheckNumFunctions<FunctionType>::value,
@@ -295,13 +437,15 @@ inline void CheckSparseFunctionTypeAPI()
       "the SparseFunctionType API; see the optimizer tutorial for more "
       "details.");
 
-  static_assert(CheckDecomposableEvaluate<FunctionType>::value,
+  static_assert(CheckDecomposableEvaluate<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of Evaluate(). "
       "Please check that the FunctionType fully satisfies the requirements of "
       "the SparseFunctionType API; see the optimizer tutorial for more "
       "details.");
 
-  static_assert(CheckSparseGradient<FunctionType>::value,
+  static_assert(CheckDecomposableGradient<FunctionType, MatType,
+      GradType>::value,
       "The FunctionType does not have a correct definition of a sparse "
       "Gradient() method. Please check that the FunctionType fully satisfies "
       "the requirements of the SparseFunctionType API; see the optimizer "
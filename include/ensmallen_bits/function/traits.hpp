@@ -16,6 +16,25 @@
 #include "sfinae_utility.hpp"
 
 namespace ens {
+
+/**
+ * Tag for the objective-only form of EvaluateWithGradient(): a function that
+ * only implements EvaluateWithGradient() may also implement
+ *
+ * @code
+ * double EvaluateWithGradient(const arma::mat& coordinates, ObjectiveOnly);
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const size_t begin,
+ *                             const size_t batchSize,
+ *                             ObjectiveOnly);
+ * @endcode
+ *
+ * which return the objective without doing any of the work of the gradient.
+ * The Evaluate() methods that Function<> builds from EvaluateWithGradient()
+ * then call them (see traits::HasObjectiveOnly).
+ */
+struct ObjectiveOnly { };
+
 namespace traits {
 
 //! Detect an Evaluate() method.
@@ -38,6 +57,34 @@ ENS_HAS_EXACT_METHOD_FORM(GradientConstraint, HasGradientConstraint)
 ENS_HAS_EXACT_METHOD_FORM(NumFeatures, HasNumFeatures)
 //! Detect a PartialGradient() method.
 ENS_HAS_EXACT_METHOD_FORM(PartialGradient, HasPartialGradient)
+//! Detect an EvaluateBatch() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateBatch, HasEvaluateBatch)
+//! Detect an EvaluateWithCoefficients() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateWithCoefficients, HasEvaluateWithCoefficients)
+//! Detect a LinearGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(LinearGradient, HasLinearGradient)
+//! Detect a RegularizationGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(RegularizationGradient, HasRegularizationGradient)
+//! Detect a GradientVariance() method.
+ENS_HAS_EXACT_METHOD_FORM(GradientVariance, HasGradientVariance)
+//! Detect an EvaluateDelta() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateDelta, HasEvaluateDelta)
+//! Detect an EvaluateConstraints() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateConstraints, HasEvaluateConstraints)
+//! Detect a GradientConstraints() method.
+ENS_HAS_EXACT_METHOD_FORM(GradientConstraints, HasGradientConstraints)
+//! Detect an AffectedFeatures() method.
+ENS_HAS_EXACT_METHOD_FORM(AffectedFeatures, HasAffectedFeatures)
+//! Detect an InitializeObjective() method.
+ENS_HAS_EXACT_METHOD_FORM(InitializeObjective, HasInitializeObjective)
+//! Detect an UpdateObjective() method.
+ENS_HAS_EXACT_METHOD_FORM(UpdateObjective, HasUpdateObjective)
+//! Detect an UpdateGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(UpdateGradient, HasUpdateGradient)
+//! Detect a HessianVectorProduct() method.
+ENS_HAS_EXACT_METHOD_FORM(HessianVectorProduct, HasHessianVectorProductMethod)
+//! Detect a Residual() method.
+ENS_HAS_EXACT_METHOD_FORM(Residual, HasResidualMethod)
 
 //! This is the form of a non-const Evaluate() method.
 template<typename FunctionType>
@@ -232,6 +279,791 @@ template<typename FunctionType>
 using PartialGradientStaticForm = void(*)(
     const arma::mat&, const size_t, arma::sp_mat&);
 
+//! This is the form of a non-const PartialGradient() method that writes only
+//! the partial gradient column into a dense vector.
+template<typename FunctionType>
+using PartialGradientDenseForm = void(FunctionType::*)(
+    const arma::mat&, const size_t, arma::vec&);
+
+//! This is the form of a const PartialGradient() method that writes only the
+//! partial gradient column into a dense vector.
+template<typename FunctionType>
+using PartialGradientDenseConstForm = void(FunctionType::*)(
+    const arma::mat&, const size_t, arma::vec&) const;
+
+//! This is the form of a non-const EvaluateBatch() method.
+template<typename FunctionType>
+using EvaluateBatchForm = void(FunctionType::*)(const arma::cube&, arma::vec&);
+
+//! This is the form of a const EvaluateBatch() method.
+template<typename FunctionType>
+using EvaluateBatchConstForm =
+    void(FunctionType::*)(const arma::cube&, arma::vec&) const;
+
+//! This is the form of a static EvaluateBatch() method.
+template<typename FunctionType>
+using EvaluateBatchStaticForm = void(*)(const arma::cube&, arma::vec&);
+
+//! This is the form of a static EvaluateWithGradient() method over several
+//! models.
+template<typename FunctionType>
+using MultiModelEvaluateWithGradientForm = double(*)(
+    const std::vector<FunctionType>&, const arma::mat&, const size_t,
+    arma::mat&, const size_t);
+
+//! This is the form of a non-const EvaluateWithCoefficients() method.
+template<typename FunctionType>
+using EvaluateWithCoefficientsForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, arma::rowvec&, const size_t);
+
+//! This is the form of a const EvaluateWithCoefficients() method.
+template<typename FunctionType>
+using EvaluateWithCoefficientsConstForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, arma::rowvec&, const size_t) const;
+
+//! This is the form of a non-const LinearGradient() method.
+template<typename FunctionType>
+using LinearGradientForm = void(FunctionType::*)(
+    const size_t, const arma::rowvec&, arma::mat&, const size_t);
+
+//! This is the form of a const LinearGradient() method.
+template<typename FunctionType>
+using LinearGradientConstForm = void(FunctionType::*)(
+    const size_t, const arma::rowvec&, arma::mat&, const size_t) const;
+
+//! This is the form of a non-const RegularizationGradient() method.
+template<typename FunctionType>
+using RegularizationGradientForm = void(FunctionType::*)(
+    const arma::mat&, arma::mat&);
+
+//! This is the form of a const RegularizationGradient() method.
+template<typename FunctionType>
+using RegularizationGradientConstForm = void(FunctionType::*)(
+    const arma::mat&, arma::mat&) const;
+
+//! This is the form of a non-const GradientVariance() method.
+template<typename FunctionType>
+using GradientVarianceForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, arma::mat&, const size_t);
+
+//! This is the form of a const GradientVariance() method.
+template<typename FunctionType>
+using GradientVarianceConstForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, arma::mat&, const size_t) const;
+
+//! This is the form of a non-const indexed GradientVariance() method.
+template<typename FunctionType>
+using IndexedGradientVarianceForm = double(FunctionType::*)(
+    const arma::mat&, const arma::uvec&, arma::mat&);
+
+//! This is the form of a const indexed GradientVariance() method.
+template<typename FunctionType>
+using IndexedGradientVarianceConstForm = double(FunctionType::*)(
+    const arma::mat&, const arma::uvec&, arma::mat&) const;
+
+//! This is the form of a non-const EvaluateDelta() method.
+template<typename FunctionType>
+using EvaluateDeltaForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, const double);
+
+//! This is the form of a const EvaluateDelta() method.
+template<typename FunctionType>
+using EvaluateDeltaConstForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, const double) const;
+
+//! This is the form of a non-const EvaluateConstraints() method.
+template<typename FunctionType>
+using EvaluateConstraintsForm = void(FunctionType::*)(
+    const arma::mat&, arma::vec&);
+
+//! This is the form of a const EvaluateConstraints() method.
+template<typename FunctionType>
+using EvaluateConstraintsConstForm = void(FunctionType::*)(
+    const arma::mat&, arma::vec&) const;
+
+//! This is the form of a non-const GradientConstraints() method.
+template<typename FunctionType>
+using GradientConstraintsForm = void(FunctionType::*)(
+    const arma::mat&, const arma::vec&, arma::mat&);
+
+//! This is the form of a const GradientConstraints() method.
+template<typename FunctionType>
+using GradientConstraintsConstForm = void(FunctionType::*)(
+    const arma::mat&, const arma::vec&, arma::mat&) const;
+
+//! This is the form of a non-const AffectedFeatures() method.
+template<typename FunctionType>
+using AffectedFeaturesForm = void(FunctionType::*)(const size_t, arma::uvec&);
+
+//! This is the form of a const AffectedFeatures() method.
+template<typename FunctionType>
+using AffectedFeaturesConstForm =
+    void(FunctionType::*)(const size_t, arma::uvec&) const;
+
+//! This is the form of a non-const InitializeObjective() method.
+template<typename FunctionType>
+using InitializeObjectiveForm = double(FunctionType::*)(const arma::mat&);
+
+//! This is the form of a const InitializeObjective() method.
+template<typename FunctionType>
+using InitializeObjectiveConstForm =
+    double(FunctionType::*)(const arma::mat&) const;
+
+//! This is the form of a non-const UpdateObjective() method.
+template<typename FunctionType>
+using UpdateObjectiveForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, const arma::vec&);
+
+//! This is the form of a const UpdateObjective() method.
+template<typename FunctionType>
+using UpdateObjectiveConstForm = double(FunctionType::*)(
+    const arma::mat&, const size_t, const arma::vec&) const;
+
+//! This is the form of a non-const UpdateGradient() method.
+template<typename FunctionType>
+using UpdateGradientForm = void(FunctionType::*)(
+    const arma::mat&, const double, const size_t, const double, arma::mat&);
+
+//! This is the form of a const UpdateGradient() method.
+template<typename FunctionType>
+using UpdateGradientConstForm = void(FunctionType::*)(
+    const arma::mat&, const double, const size_t, const double, arma::mat&)
+    const;
+
+//! This is the form of a non-const HessianVectorProduct() method.
+template<typename FunctionType>
+using HessianVectorProductForm = void(FunctionType::*)(
+    const arma::mat&, const arma::mat&, arma::mat&);
+
+//! This is the form of a const HessianVectorProduct() method.
+template<typename FunctionType>
+using HessianVectorProductConstForm = void(FunctionType::*)(
+    const arma::mat&, const arma::mat&, arma::mat&) const;
+
+//! This is the form of a non-const Residual() method.
+template<typename FunctionType>
+using ResidualForm = void(FunctionType::*)(const arma::mat&, arma::vec&);
+
+//! This is the form of a const Residual() method.
+template<typename FunctionType>
+using ResidualConstForm =
+    void(FunctionType::*)(const arma::mat&, arma::vec&) const;
+
+/**
+ * The forms above are all hard-wired to arma::mat.  TypedForms provides the
+ * same set of objective and gradient method forms for an arbitrary matrix type
+ * (e.g. arma::fmat) and gradient type, so that the Function<> wrapper and the
+ * static API checks can be used with any element type.  The objective returned
+ * by each form is of type MatType::elem_type.
+ *
+ * @tparam MatType Type of the coordinates matrix.
+ * @tparam GradType Type of the gradient matrix.
+ */
+template<typename MatType, typename GradType = MatType>
+struct TypedForms
+{
+  //! The element type of the coordinates (and thus of the objective).
+  typedef typename MatType::elem_type ElemType;
+
+  //! This is the form of a non-const Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateForm = ElemType(FunctionType::*)(const MatType&);
+
+  //! This is the form of a const Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateConstForm = ElemType(FunctionType::*)(const MatType&) const;
+
+  //! This is the form of a static Evaluate() method.
+  template<typename FunctionType>
+  using EvaluateStaticForm = ElemType(*)(const MatType&);
+
+  //! This is the form of a non-const Gradient() method.
+  template<typename FunctionType>
+  using GradientForm = void(FunctionType::*)(const MatType&, GradType&);
+
+  //! This is the form of a const Gradient() method.
+  template<typename FunctionType>
+  using GradientConstForm =
+      void(FunctionType::*)(const MatType&, GradType&) const;
+
+  //! This is the form of a static Gradient() method.
+  template<typename FunctionType>
+  using GradientStaticForm = void(*)(const MatType&, GradType&);
+
+  //! This is the form of a non-const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientForm =
+      ElemType(FunctionType::*)(const MatType&, GradType&);
+
+  //! This is the form of a const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientConstForm =
+      ElemType(FunctionType::*)(const MatType&, GradType&) const;
+
+  //! This is the form of a static EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using EvaluateWithGradientStaticForm =
+      ElemType(*)(const MatType&, GradType&);
+
+  //! This is the form of a decomposable Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t);
+
+  //! This is the form of a decomposable const Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t) const;
+
+  //! This is the form of a decomposable static Evaluate() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateStaticForm = ElemType(*)(
+      const MatType&, const size_t, const size_t);
+
+  //! This is the form of a decomposable non-const Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientForm = void(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a decomposable const Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientConstForm = void(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t) const;
+
+  //! This is the form of a decomposable static Gradient() method.
+  template<typename FunctionType>
+  using DecomposableGradientStaticForm = void(*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a decomposable non-const EvaluateWithGradient()
+  //! method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of a decomposable const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, GradType&, const size_t) const;
+
+  //! This is the form of a decomposable static EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableEvaluateWithGradientStaticForm = ElemType(*)(
+      const MatType&, const size_t, GradType&, const size_t);
+
+  //! This is the form of an indexed non-const Evaluate() method.
+  template<typename FunctionType>
+  using IndexedEvaluateForm = ElemType(FunctionType::*)(const MatType&,
+      const arma::uvec&);
+
+  //! This is the form of an indexed const Evaluate() method.
+  template<typename FunctionType>
+  using IndexedEvaluateConstForm = ElemType(FunctionType::*)(const MatType&,
+      const arma::uvec&) const;
+
+  //! This is the form of an indexed non-const Gradient() method.
+  template<typename FunctionType>
+  using IndexedGradientForm = void(FunctionType::*)(const MatType&,
+      const arma::uvec&, GradType&);
+
+  //! This is the form of an indexed const Gradient() method.
+  template<typename FunctionType>
+  using IndexedGradientConstForm = void(FunctionType::*)(const MatType&,
+      const arma::uvec&, GradType&) const;
+
+  //! This is the form of an indexed non-const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using IndexedEvaluateWithGradientForm = ElemType(FunctionType::*)(
+      const MatType&, const arma::uvec&, GradType&);
+
+  //! This is the form of an indexed const EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using IndexedEvaluateWithGradientConstForm = ElemType(FunctionType::*)(
+      const MatType&, const arma::uvec&, GradType&) const;
+
+  //! This is the form of a non-const objective-only EvaluateWithGradient()
+  //! method.
+  template<typename FunctionType>
+  using ObjectiveOnlyForm =
+      ElemType(FunctionType::*)(const MatType&, ObjectiveOnly);
+
+  //! This is the form of a const objective-only EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using ObjectiveOnlyConstForm =
+      ElemType(FunctionType::*)(const MatType&, ObjectiveOnly) const;
+
+  //! This is the form of a static objective-only EvaluateWithGradient()
+  //! method.
+  template<typename FunctionType>
+  using ObjectiveOnlyStaticForm = ElemType(*)(const MatType&, ObjectiveOnly);
+
+  //! This is the form of a decomposable non-const objective-only
+  //! EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableObjectiveOnlyForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t, ObjectiveOnly);
+
+  //! This is the form of a decomposable const objective-only
+  //! EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableObjectiveOnlyConstForm = ElemType(FunctionType::*)(
+      const MatType&, const size_t, const size_t, ObjectiveOnly) const;
+
+  //! This is the form of a decomposable static objective-only
+  //! EvaluateWithGradient() method.
+  template<typename FunctionType>
+  using DecomposableObjectiveOnlyStaticForm = ElemType(*)(
+      const MatType&, const size_t, const size_t, ObjectiveOnly);
+};
+
+/**
+ * Detect whether the given FunctionType can be evaluated on an arbitrary set of
+ * indices of its separable functions, that is, whether it has (const or
+ * non-const) indexed Evaluate(), Gradient() and EvaluateWithGradient()
+ * methods:
+ *
+ * @code
+ * double Evaluate(const arma::mat& coordinates, const arma::uvec& indices);
+ * void Gradient(const arma::mat& coordinates, const arma::uvec& indices,
+ *               arma::mat& gradient);
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const arma::uvec& indices,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * Optimizers visit such functions in a shuffled order, so that they never need
+ * to be shuffled themselves.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+struct HasIndexedFunctions
+{
+  typedef TypedForms<MatType, GradType> Forms;
+
+  static const bool value =
+      (HasEvaluate<FunctionType, Forms::template IndexedEvaluateForm>::value ||
+       HasEvaluate<FunctionType,
+           Forms::template IndexedEvaluateConstForm>::value) &&
+      (HasGradient<FunctionType, Forms::template IndexedGradientForm>::value ||
+       HasGradient<FunctionType,
+           Forms::template IndexedGradientConstForm>::value) &&
+      (HasEvaluateWithGradient<FunctionType,
+           Forms::template IndexedEvaluateWithGradientForm>::value ||
+       HasEvaluateWithGradient<FunctionType,
+           Forms::template IndexedEvaluateWithGradientConstForm>::value);
+};
+
+/**
+ * Detect whether the given FunctionType has an objective-only form of
+ * EvaluateWithGradient() (see ObjectiveOnly):
+ *
+ * @code
+ * double EvaluateWithGradient(const arma::mat& coordinates, ObjectiveOnly);
+ * @endcode
+ *
+ * value tells whether it can be called on a non-const function, constValue on
+ * a const function and staticValue without a function.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+struct HasObjectiveOnly
+{
+  typedef TypedForms<MatType, GradType> Forms;
+
+  static const bool staticValue = HasEvaluateWithGradient<FunctionType,
+      Forms::template ObjectiveOnlyStaticForm>::value;
+  static const bool constValue = staticValue ||
+      HasEvaluateWithGradient<FunctionType,
+          Forms::template ObjectiveOnlyConstForm>::value;
+  static const bool value = constValue ||
+      HasEvaluateWithGradient<FunctionType,
+          Forms::template ObjectiveOnlyForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType has a decomposable objective-only form
+ * of EvaluateWithGradient() (see ObjectiveOnly):
+ *
+ * @code
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const size_t begin,
+ *                             const size_t batchSize,
+ *                             ObjectiveOnly);
+ * @endcode
+ *
+ * The members are as in HasObjectiveOnly.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+struct HasDecomposableObjectiveOnly
+{
+  typedef TypedForms<MatType, GradType> Forms;
+
+  static const bool staticValue = HasEvaluateWithGradient<FunctionType,
+      Forms::template DecomposableObjectiveOnlyStaticForm>::value;
+  static const bool constValue = staticValue ||
+      HasEvaluateWithGradient<FunctionType,
+          Forms::template DecomposableObjectiveOnlyConstForm>::value;
+  static const bool value = constValue ||
+      HasEvaluateWithGradient<FunctionType,
+          Forms::template DecomposableObjectiveOnlyForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType can evaluate a whole population of
+ * candidates at once, that is, whether it has a (non-const, const or static)
+ * EvaluateBatch() method:
+ *
+ * @code
+ * void EvaluateBatch(const arma::cube& candidates, arma::vec& objectives);
+ * @endcode
+ *
+ * Each slice of candidates is one set of coordinates, and objectives(i) is set
+ * to the objective of slice i.  Population-based optimizers use this method
+ * instead of evaluating the candidates one by one when it is available.
+ */
+template<typename FunctionType>
+struct HasBatchEvaluation
+{
+  static const bool value =
+      HasEvaluateBatch<FunctionType, EvaluateBatchForm>::value ||
+      HasEvaluateBatch<FunctionType, EvaluateBatchConstForm>::value ||
+      HasEvaluateBatch<FunctionType, EvaluateBatchStaticForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType can evaluate several models of the
+ * same data at once, that is, whether it has a static method
+ *
+ * @code
+ * static double EvaluateWithGradient(
+ *     const std::vector<FunctionType>& models,
+ *     const arma::mat& parameters,
+ *     const size_t begin,
+ *     arma::mat& gradient,
+ *     const size_t batchSize);
+ * @endcode
+ *
+ * where column k of parameters (and of gradient) belongs to models[k], and the
+ * sum of the objectives of the models on the given batch is returned.
+ * MultiModelFunction uses it instead of evaluating the models one by one.
+ */
+template<typename FunctionType>
+struct HasMultiModelGradient
+{
+  static const bool value = HasEvaluateWithGradient<FunctionType,
+      MultiModelEvaluateWithGradientForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType is a linear model, that is, whether
+ * the gradient of each of its separable functions is a scalar coefficient times
+ * a fixed feature vector, plus a term that is the same for all the separable
+ * functions (e.g. a regularization).  Such a function provides (const or
+ * non-const) methods of the following forms:
+ *
+ * @code
+ * // Return the objective of the given batch, and store the coefficient of
+ * // each separable function of the batch in coefficients.
+ * double EvaluateWithCoefficients(const arma::mat& coordinates,
+ *                                 const size_t begin,
+ *                                 arma::rowvec& coefficients,
+ *                                 const size_t batchSize);
+ *
+ * // Store the sum of the feature vectors of the given batch, weighted by the
+ * // given coefficients, in gradient.
+ * void LinearGradient(const size_t begin,
+ *                     const arma::rowvec& coefficients,
+ *                     arma::mat& gradient,
+ *                     const size_t batchSize);
+ *
+ * // Store the gradient of the term shared by every separable function in
+ * // gradient.
+ * void RegularizationGradient(const arma::mat& coordinates,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * The gradient of a batch is then LinearGradient() of its coefficients plus
+ * batchSize times RegularizationGradient().  Optimizers such as SAGA use this
+ * to store one scalar per separable function instead of a whole gradient.
+ */
+template<typename FunctionType>
+struct HasLinearModelGradient
+{
+  static const bool value =
+      (HasEvaluateWithCoefficients<FunctionType,
+           EvaluateWithCoefficientsForm>::value ||
+       HasEvaluateWithCoefficients<FunctionType,
+           EvaluateWithCoefficientsConstForm>::value) &&
+      (HasLinearGradient<FunctionType, LinearGradientForm>::value ||
+       HasLinearGradient<FunctionType, LinearGradientConstForm>::value) &&
+      (HasRegularizationGradient<FunctionType,
+           RegularizationGradientForm>::value ||
+       HasRegularizationGradient<FunctionType,
+           RegularizationGradientConstForm>::value);
+};
+
+/**
+ * Detect whether the given FunctionType can compute the gradient of a batch of
+ * separable functions along with the spread of their individual gradients in a
+ * single call, that is, whether it has a (const or non-const) method
+ *
+ * @code
+ * double GradientVariance(const arma::mat& coordinates,
+ *                         const size_t begin,
+ *                         arma::mat& gradient,
+ *                         const size_t batchSize);
+ * @endcode
+ *
+ * which stores the sum of the gradients of the batch in gradient (like
+ * Gradient()) and returns the sum of the squared distances between each
+ * individual gradient and their mean.  BigBatchSGD uses this to estimate the
+ * variance of its batch gradient without computing one gradient at a time.
+ */
+template<typename FunctionType>
+struct HasBatchGradientVariance
+{
+  static const bool value =
+      HasGradientVariance<FunctionType, GradientVarianceForm>::value ||
+      HasGradientVariance<FunctionType, GradientVarianceConstForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType has the indexed form of
+ * GradientVariance(), which computes the same quantities for the separable
+ * functions with the given indices:
+ *
+ * @code
+ * double GradientVariance(const arma::mat& coordinates,
+ *                         const arma::uvec& indices,
+ *                         arma::mat& gradient);
+ * @endcode
+ */
+template<typename FunctionType>
+struct HasIndexedBatchGradientVariance
+{
+  static const bool value =
+      HasGradientVariance<FunctionType, IndexedGradientVarianceForm>::value ||
+      HasGradientVariance<FunctionType,
+          IndexedGradientVarianceConstForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType can compute the change of its
+ * objective when a single coordinate is changed, that is, whether it has a
+ * (const or non-const) method
+ *
+ * @code
+ * double EvaluateDelta(const arma::mat& coordinates,
+ *                      const size_t index,
+ *                      const double value);
+ * @endcode
+ *
+ * which returns f(x') - f(x), where x is coordinates and x' is x with element
+ * index set to value.  Optimizers that move one coordinate at a time (e.g. SA)
+ * use this method instead of evaluating the whole objective at every move.
+ */
+template<typename FunctionType>
+struct HasDeltaEvaluation
+{
+  static const bool value =
+      HasEvaluateDelta<FunctionType, EvaluateDeltaForm>::value ||
+      HasEvaluateDelta<FunctionType, EvaluateDeltaConstForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType can evaluate all of its constraints at
+ * once, that is, whether it has a (const or non-const) method
+ *
+ * @code
+ * void EvaluateConstraints(const arma::mat& coordinates,
+ *                          arma::vec& constraints);
+ * @endcode
+ *
+ * which stores c_i(coordinates) in constraints[i] for every constraint.
+ */
+template<typename FunctionType>
+struct HasBatchConstraintEvaluation
+{
+  static const bool value =
+      HasEvaluateConstraints<FunctionType, EvaluateConstraintsForm>::value ||
+      HasEvaluateConstraints<FunctionType,
+          EvaluateConstraintsConstForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType can compute a weighted sum of the
+ * gradients of its constraints (the product of the transposed Jacobian of the
+ * constraints with a vector), that is, whether it has a (const or non-const)
+ * method
+ *
+ * @code
+ * void GradientConstraints(const arma::mat& coordinates,
+ *                          const arma::vec& weights,
+ *                          arma::mat& gradient);
+ * @endcode
+ *
+ * which stores sum_i weights[i] * c_i'(coordinates) in gradient.
+ */
+template<typename FunctionType>
+struct HasBatchConstraintGradient
+{
+  static const bool value =
+      HasGradientConstraints<FunctionType, GradientConstraintsForm>::value ||
+      HasGradientConstraints<FunctionType,
+          GradientConstraintsConstForm>::value;
+};
+
+/**
+ * Detect whether the given partially differentiable FunctionType can compute
+ * only the partial gradient column of a feature, that is, whether it has a
+ * (const or non-const) method
+ *
+ * @code
+ * void PartialGradient(const arma::mat& coordinates,
+ *                      const size_t j,
+ *                      arma::vec& gradient);
+ * @endcode
+ *
+ * which stores column j of the partial gradient f'_j(x) (the only non-zero
+ * column) in gradient.  This avoids building a sparse matrix the size of the
+ * coordinates at every step of coordinate descent.
+ */
+template<typename FunctionType>
+struct HasDensePartialGradient
+{
+  static const bool value =
+      HasPartialGradient<FunctionType, PartialGradientDenseForm>::value ||
+      HasPartialGradient<FunctionType, PartialGradientDenseConstForm>::value;
+};
+
+/**
+ * Detect whether the given partially differentiable FunctionType can tell
+ * which partial gradients change when a single feature is updated, that is,
+ * whether it has a (const or non-const) method
+ *
+ * @code
+ * void AffectedFeatures(const size_t feature, arma::uvec& affected);
+ * @endcode
+ *
+ * which stores in affected the indices of the features j whose partial
+ * gradient f'_j(x) depends on feature (including feature itself).  Greedy
+ * coordinate descent policies use this to refresh only those partial gradients
+ * after each step.
+ */
+template<typename FunctionType>
+struct HasFeatureDependencies
+{
+  static const bool value =
+      HasAffectedFeatures<FunctionType, AffectedFeaturesForm>::value ||
+      HasAffectedFeatures<FunctionType, AffectedFeaturesConstForm>::value;
+};
+
+/**
+ * Detect whether the given partially differentiable FunctionType can keep
+ * track of its objective as single features are updated, that is, whether it
+ * has the (const or non-const) methods
+ *
+ * @code
+ * double InitializeObjective(const arma::mat& coordinates);
+ * double UpdateObjective(const arma::mat& coordinates,
+ *                        const size_t j,
+ *                        const arma::vec& delta);
+ * @endcode
+ *
+ * InitializeObjective() sets up the state of the function (e.g. the residuals
+ * of a least-squares problem) at the given coordinates and returns the
+ * objective there.  UpdateObjective() is called after column j of coordinates
+ * was changed by delta; it updates that state and returns the objective at the
+ * new coordinates, ideally without a full pass over the data.
+ */
+template<typename FunctionType>
+struct HasIncrementalObjective
+{
+  static const bool value =
+      (HasInitializeObjective<FunctionType, InitializeObjectiveForm>::value ||
+       HasInitializeObjective<FunctionType,
+           InitializeObjectiveConstForm>::value) &&
+      (HasUpdateObjective<FunctionType, UpdateObjectiveForm>::value ||
+       HasUpdateObjective<FunctionType, UpdateObjectiveConstForm>::value);
+};
+
+/**
+ * Detect whether the given differentiable FunctionType can update its gradient
+ * after a step towards a single coordinate, that is, whether it has a (const or
+ * non-const) method
+ *
+ * @code
+ * void UpdateGradient(const arma::mat& coordinates,
+ *                     const double gamma,
+ *                     const size_t index,
+ *                     const double value,
+ *                     arma::mat& gradient);
+ * @endcode
+ *
+ * which is called after the step
+ * \f$ x \leftarrow (1 - \gamma) x + \gamma \cdot value \cdot e_{index} \f$;
+ * coordinates holds the new point and gradient the gradient at the old point,
+ * to be replaced with the gradient at the new point.  FrankWolfe uses this with
+ * sparse atoms instead of computing the whole gradient again.
+ */
+template<typename FunctionType>
+struct HasGradientUpdate
+{
+  static const bool value =
+      HasUpdateGradient<FunctionType, UpdateGradientForm>::value ||
+      HasUpdateGradient<FunctionType, UpdateGradientConstForm>::value;
+};
+
+/**
+ * Detect whether the given differentiable FunctionType can multiply its Hessian
+ * with a vector, that is, whether it has a (const or non-const) method
+ *
+ * @code
+ * void HessianVectorProduct(const arma::mat& coordinates,
+ *                           const arma::mat& v,
+ *                           arma::mat& product);
+ * @endcode
+ *
+ * which stores \f$ \nabla^2 f(coordinates) v \f$ in product; v and product
+ * have the shape of the coordinates.  NewtonCG uses this instead of finite
+ * differences of the gradient.
+ */
+template<typename FunctionType>
+struct HasHessianVectorProduct
+{
+  static const bool value =
+      HasHessianVectorProductMethod<FunctionType,
+          HessianVectorProductForm>::value ||
+      HasHessianVectorProductMethod<FunctionType,
+          HessianVectorProductConstForm>::value;
+};
+
+/**
+ * Detect whether the given FunctionType is a least squares objective
+ * \f$ f(x) = \frac{1}{2} \|r(x)\|_2^2 \f$ with an affine residual
+ * \f$ r(x) = A x - b \f$ that it can compute, that is, whether it has a (const
+ * or non-const) method
+ *
+ * @code
+ * void Residual(const arma::mat& coordinates, arma::vec& residual);
+ * @endcode
+ *
+ * which stores \f$ r(coordinates) \f$ in residual.  The line search of the
+ * Frank-Wolfe update rules then takes the exact step along a line from the
+ * residuals at its two ends, instead of searching with the gradient.
+ */
+template<typename FunctionType>
+struct HasResidual
+{
+  static const bool value =
+      HasResidualMethod<FunctionType, ResidualForm>::value ||
+      HasResidualMethod<FunctionType, ResidualConstForm>::value;
+};
+
 //! This is a utility struct that will match any non-const form.
 template<typename FunctionType, typename... Ts>
 using OtherForm = double(FunctionType::*)(Ts...);
@@ -0,0 +1,211 @@
+/**
+ * @file visitation_order.hpp
+ * @author Ryan Curtin
+ *
+ * Visit the separable functions of a decomposable function in a shuffled order
+ * held by the optimizer, so that the function itself does not need to be
+ * shuffled (which usually means copying its data).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_VISITATION_ORDER_HPP
+#define ENSMALLEN_FUNCTION_VISITATION_ORDER_HPP
+
+#include "traits.hpp"
+
+namespace ens {
+
+/**
+ * IndexedFunction presents a function with indexed Evaluate(), Gradient() and
+ * EvaluateWithGradient() methods (see traits::HasIndexedFunctions) as a
+ * decomposable function.  The separable functions are visited in the order of
+ * a permutation, and Shuffle() only shuffles the permutation.
+ *
+ * A full permutation scatters every batch over the whole dataset.  With a
+ * positive block size, Shuffle() instead shuffles the order of the contiguous
+ * blocks of blockSize functions, and then shuffles the functions inside each
+ * block, which acts as the buffered window of a streaming shuffle.  Each batch
+ * then reads its points from one or two blocks, which keeps the accesses to
+ * the data (and to memory-mapped files) mostly sequential.
+ *
+ * @tparam FunctionType Type of the function to visit.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class IndexedFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Visit the given function, starting in the original order of its separable
+   * functions.  The function is not copied, so it must outlive this object.
+   *
+   * @param function Function to visit.
+   * @param blockSize Number of contiguous functions shuffled as a block (0
+   *     means the functions are shuffled individually).
+   */
+  IndexedFunction(FunctionType& function, const size_t blockSize = 0) :
+      function(function),
+      order(arma::linspace<arma::uvec>(0, function.NumFunctions() - 1,
+          function.NumFunctions())),
+      blockSize(blockSize)
+  { /* Nothing to do. */ }
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return order.n_elem; }
+
+  //! Shuffle the order of function visitation.
+  void Shuffle()
+  {
+    if (blockSize == 0 || blockSize >= order.n_elem)
+    {
+      Random().Shuffle(order);
+      return;
+    }
+
+    const size_t n = order.n_elem;
+    const size_t numBlocks = (n + blockSize - 1) / blockSize;
+    arma::uvec blocks = arma::linspace<arma::uvec>(0, numBlocks - 1,
+        numBlocks);
+    Random().Shuffle(blocks);
+
+    // Each block is written in its new position, and then shuffled in place.
+    size_t position = 0;
+    for (size_t b = 0; b < numBlocks; ++b)
+    {
+      const size_t first = blocks[b] * blockSize;
+      const size_t count = std::min(blockSize, n - first);
+      for (size_t k = 0; k < count; ++k)
+        order[position + k] = first + k;
+
+      arma::uvec window(order.memptr() + position, count, false, true);
+      Random().Shuffle(window);
+      position += count;
+    }
+  }
+
+  //! Evaluate the given batch of separable functions.
+  ElemType Evaluate(const MatType& coordinates,
+                    const size_t begin,
+                    const size_t batchSize)
+  {
+    return function.Evaluate(coordinates, Indices(begin, batchSize));
+  }
+
+  //! Evaluate the gradient of the given batch of separable functions.
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    function.Gradient(coordinates, Indices(begin, batchSize), gradient);
+  }
+
+  //! Evaluate the given batch of separable functions and their gradient.
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                const size_t begin,
+                                GradType& gradient,
+                                const size_t batchSize)
+  {
+    return function.EvaluateWithGradient(coordinates,
+        Indices(begin, batchSize), gradient);
+  }
+
+  //! Get the current order of visitation.
+  const arma::uvec& Order() const { return order; }
+
+  //! Get the number of functions shuffled as a block (0 means none).
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of functions shuffled as a block (0 means none).
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get the visited function.
+  FunctionType& VisitedFunction() { return function; }
+
+ private:
+  //! Get the indices of the given batch in the current order.  The indices
+  //! are a view of the order, so no memory is allocated.
+  const arma::uvec Indices(const size_t begin, const size_t batchSize) const
+  {
+    // We promise to be well-behaved... the elements won't be modified.
+    return arma::uvec(const_cast<arma::uword*>(order.memptr()) + begin,
+        batchSize, false, true);
+  }
+
+  //! The visited function.
+  FunctionType& function;
+  //! The order of visitation of the separable functions.
+  arma::uvec order;
+  //! The number of functions shuffled as a block.
+  size_t blockSize;
+};
+
+/**
+ * VisitationOrder chooses how an optimizer visits the separable functions of a
+ * decomposable function.  If the function has indexed Evaluate(), Gradient()
+ * and EvaluateWithGradient() methods, Get() returns an IndexedFunction that
+ * holds the order of visitation; otherwise Get() returns the function itself,
+ * and shuffling is done by the Shuffle() method of the function.  The block
+ * size of block shuffling (see IndexedFunction) only applies to the first
+ * case; a function that shuffles itself chooses how (e.g. StreamingFunction
+ * always shuffles blocks).
+ *
+ * @code
+ * VisitationOrder<FunctionType, MatType, GradType> order(function);
+ * typedef Function<typename VisitationOrder<FunctionType, MatType,
+ *     GradType>::VisitedType, MatType, GradType> VisitedFunctionType;
+ * VisitedFunctionType& visited(
+ *     static_cast<VisitedFunctionType&>(order.Get()));
+ * @endcode
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType,
+         bool Indexed = traits::HasIndexedFunctions<FunctionType, MatType,
+             GradType>::value>
+class VisitationOrder
+{
+ public:
+  typedef IndexedFunction<FunctionType, MatType, GradType> VisitedType;
+
+  VisitationOrder(FunctionType& function, const size_t blockSize = 0) :
+      visited(function, blockSize) { }
+
+  //! Get the function to visit.
+  VisitedType& Get() { return visited; }
+
+ private:
+  //! The visited function, which holds the order of visitation.
+  VisitedType visited;
+};
+
+/**
+ * The function has no indexed methods, so it is visited directly.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+class VisitationOrder<FunctionType, MatType, GradType, false>
+{
+ public:
+  typedef FunctionType VisitedType;
+
+  VisitationOrder(FunctionType& function, const size_t /* blockSize */ = 0) :
+      visited(function) { }
+
+  //! Get the function to visit.
+  VisitedType& Get() { return visited; }
+
+ private:
+  //! The visited function.
+  VisitedType& visited;
+};
+
+} // namespace ens
+
+#endif
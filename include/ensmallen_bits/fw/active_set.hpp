@@ -0,0 +1,166 @@
+/**
+ * @file active_set.hpp
+ * @author Marcus Edel
+ *
+ * The active set of the Frank-Wolfe variants that move weight between atoms:
+ * the current solution as a convex combination of atoms.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_ACTIVE_SET_HPP
+#define ENSMALLEN_FW_ACTIVE_SET_HPP
+
+namespace ens {
+
+/**
+ * Class to hold the active set of the away-step and pairwise variants of
+ * FrankWolfe: the solution is kept as the convex combination
+ * \f$ x = \sum_i \alpha_i v_i \f$ of the atoms \f$ v_i \f$ returned by the
+ * linear constrained solver, with weights \f$ \alpha_i > 0 \f$ that sum to one.
+ *
+ * Unlike Atoms, which is meant for the square loss FuncSq and keeps the product
+ * of each atom with its matrix, the active set works with any function.  Each
+ * atom is stored as a column, in the shape of the coordinates.
+ */
+class ActiveSet
+{
+ public:
+  ActiveSet() : nRows(0), nCols(0) { /* Nothing to do. */ }
+
+  /**
+   * Start from the single atom x, with weight one.
+   *
+   * @param x starting point, which must lie in the constrained domain.
+   */
+  void Reset(const arma::mat& x)
+  {
+    nRows = x.n_rows;
+    nCols = x.n_cols;
+    atoms = arma::vectorise(x);
+    weights.ones(1);
+  }
+
+  /**
+   * Return whether the active set represents the given point, that is, whether
+   * the point is the last solution recovered from it.
+   *
+   * @param x point to check.
+   */
+  bool Represents(const arma::mat& x) const
+  {
+    if (atoms.n_cols == 0 || x.n_rows != nRows || x.n_cols != nCols)
+      return false;
+
+    const arma::vec recovered = atoms * weights;
+    return arma::norm(recovered - arma::vectorise(x), 2) <=
+        1e-10 * std::max(1.0, arma::norm(recovered, 2));
+  }
+
+  /**
+   * Find the index of the given atom, or Size() if it is not in the active set.
+   *
+   * @param v atom to look for.
+   */
+  size_t Find(const arma::mat& v) const
+  {
+    const arma::vec column = arma::vectorise(v);
+    for (size_t i = 0; i < atoms.n_cols; ++i)
+    {
+      if (arma::all(atoms.col(i) == column))
+        return i;
+    }
+
+    return atoms.n_cols;
+  }
+
+  /**
+   * Add the given weight to the given atom, inserting it if it is not in the
+   * active set yet.
+   *
+   * @param v atom.
+   * @param weight weight to add.
+   * @return index of the atom.
+   */
+  size_t Add(const arma::mat& v, const double weight)
+  {
+    const size_t index = Find(v);
+    if (index == atoms.n_cols)
+    {
+      atoms.insert_cols(atoms.n_cols, arma::vectorise(v));
+      weights.resize(weights.n_elem + 1);
+      weights(index) = 0.0;
+    }
+
+    weights(index) += weight;
+    return index;
+  }
+
+  /**
+   * Remove the atom with the given index, with its weight.
+   *
+   * @param index index of the atom to remove.
+   */
+  void Remove(const size_t index)
+  {
+    atoms.shed_col(index);
+    weights.shed_row(index);
+  }
+
+  /**
+   * Find the away atom: the atom of the active set with the largest inner
+   * product with the gradient.
+   *
+   * @param gradient gradient at the current solution.
+   * @return index of the away atom.
+   */
+  size_t Away(const arma::mat& gradient) const
+  {
+    const arma::rowvec products = arma::vectorise(gradient).t() * atoms;
+    arma::uword index = 0;
+    products.max(index);
+    return index;
+  }
+
+  //! Recover the solution from the atoms and their weights.
+  void RecoverVector(arma::mat& x) const
+  {
+    x = arma::reshape(atoms * weights, nRows, nCols);
+  }
+
+  //! Get atom i, in the shape of the coordinates.
+  arma::mat Atom(const size_t i) const
+  {
+    return arma::reshape(atoms.col(i), nRows, nCols);
+  }
+
+  //! Get the number of atoms.
+  size_t Size() const { return atoms.n_cols; }
+
+  //! Get the atoms, one (vectorised) atom per column.
+  const arma::mat& CurrentAtoms() const { return atoms; }
+
+  //! Get the weights of the atoms.
+  const arma::vec& Weights() const { return weights; }
+  //! Modify the weights of the atoms.
+  arma::vec& Weights() { return weights; }
+
+ private:
+  //! The atoms, one vectorised atom per column.
+  arma::mat atoms;
+
+  //! The weight of each atom.
+  arma::vec weights;
+
+  //! The number of rows of the coordinates.
+  size_t nRows;
+
+  //! The number of columns of the coordinates.
+  size_t nCols;
+};
+
+} // namespace ens
+
+#endif
@@ -19,6 +19,12 @@ namespace ens {
 /**
  * Class to hold the information and operations of current atoms in the
  * soluton space.
+ *
+ * For the square loss \f$ 0.5 * ||Ax - b||_2^2 \f$ (see FuncSqType), the
+ * product of A with each atom is computed once when the atom is added, and
+ * kept along with the atoms; the residual and the gradient with respect to the
+ * coefficients are then computed from these products, without any product with
+ * A itself.
  */
 class Atoms
 {
@@ -29,17 +35,35 @@ class Atoms
    * Add atom into the solution space.
    *
    * @param v new atom to be added.
+   * @param function function to be optimized.
+   * @param c coefficient of the new atom.
+   */
+  template<typename MatType>
+  void AddAtom(const arma::vec& v,
+               const FuncSqType<MatType>& function,
+               const double c = 0)
+  {
+    AddAtom(v, arma::vec(function.MatrixA() * v), c);
+  }
+
+  /**
+   * Add atom into the solution space, given its product with the matrix A of
+   * the function.
+   *
+   * @param v new atom to be added.
+   * @param product product of A with the new atom.
    * @param c coefficient of the new atom.
    */
-  void AddAtom(const arma::vec& v, FuncSq& function, const double c = 0)
+  void AddAtom(const arma::vec& v, const arma::vec& product, const double c = 0)
   {
     if (currentAtoms.is_empty())
     {
-      CurrentAtoms() = v;
-      CurrentCoeffs().set_size(1);
-      CurrentCoeffs().fill(c);
+      currentAtoms = v;
+      currentCoeffs.set_size(1);
+      currentCoeffs.fill(c);
+      atomProducts = product;
       atomSqTerm.set_size(1);
-      atomSqTerm(0) = std::pow(norm(function.MatrixA() * v, 2), 2);
+      atomSqTerm(0) = arma::dot(product, product);
     }
     else
     {
@@ -47,13 +71,38 @@ class Atoms
       arma::vec cVec(1);
       cVec(0) = c;
       currentCoeffs.insert_rows(0, cVec);
-      double tmp = std::pow(norm(function.MatrixA() * v, 2), 2);
+      atomProducts.insert_cols(0, product);
       arma::vec tmpVec(1);
-      tmpVec(0) = tmp;
+      tmpVec(0) = arma::dot(product, product);
       atomSqTerm.insert_rows(0, tmpVec);
     }
   }
 
+  /**
+   * Remove the atom with the given index, with its coefficient.
+   *
+   * @param index index of the atom to be removed.
+   */
+  void RemoveAtom(const size_t index)
+  {
+    currentAtoms.shed_col(index);
+    currentCoeffs.shed_row(index);
+    atomProducts.shed_col(index);
+    atomSqTerm.shed_row(index);
+  }
+
+  /**
+   * Recompute the products of A with every atom; this is only needed if the
+   * atoms were modified through CurrentAtoms().
+   *
+   * @param function function to be optimized.
+   */
+  template<typename MatType>
+  void UpdateAtomProducts(const FuncSqType<MatType>& function)
+  {
+    atomProducts = function.MatrixA() * currentAtoms;
+    atomSqTerm = arma::sum(arma::square(atomProducts), 0).t();
+  }
 
   //! Recover the solution coordinate from the coefficients of current atoms.
   void RecoverVector(arma::mat& x)
@@ -61,6 +110,19 @@ class Atoms
     x = currentAtoms * currentCoeffs;
   }
 
+  /**
+   * Compute the residual \f$ Ax - b \f$ of the solution given by the current
+   * atoms and coefficients, from the stored products.
+   *
+   * @param function function to be optimized.
+   * @param residual output residual vector.
+   */
+  template<typename MatType>
+  void Residual(const FuncSqType<MatType>& function, arma::vec& residual) const
+  {
+    residual = atomProducts * currentCoeffs - function.Vectorb();
+  }
+
   /**
    * Prune the support, delete previous atoms if they don't contribute much.
    * See Algorithm 2 of paper:
@@ -80,43 +142,37 @@ class Atoms
    * @param F thresholding number.
    * @param function function to be optimized.
    */
-  void PruneSupport(const double F, FuncSq& function)
+  template<typename MatType>
+  void PruneSupport(const double F, const FuncSqType<MatType>& function)
   {
     arma::vec sqTerm = 0.5 * atomSqTerm % square(currentCoeffs);
+    arma::vec residual;
 
     while (currentAtoms.n_cols > 1)
     {
-      // Solve for current gradient.
-      arma::mat x;
-      RecoverVector(x);
-      arma::mat gradient(size(x));
-      function.Gradient(x, gradient);
+      // Solve for current gradient; the gradient of the function is
+      // A^T * residual, so its product with each atom is the product of the
+      // atom with A times the residual.
+      Residual(function, residual);
 
       // Find possible atom to be deleted.
-      arma::vec gap = sqTerm -
-          currentCoeffs % trans(gradient.t() * currentAtoms);
+      arma::vec gap = sqTerm - currentCoeffs % (atomProducts.t() * residual);
       arma::uword ind;
       gap.min(ind);
 
       // Try deleting the atom.
-      arma::mat newAtoms(currentAtoms.n_rows, currentAtoms.n_cols - 1);
-      if (ind > 0)
-        newAtoms.cols(0, ind - 1) = currentAtoms.cols(0, ind - 1);
-      if (ind < (currentAtoms.n_cols - 1))
-      {
-        newAtoms.cols(ind, newAtoms.n_cols - 1) =
-            currentAtoms.cols(ind + 1, currentAtoms.n_cols - 1);
-      }
+      arma::mat newProducts = atomProducts;
+      newProducts.shed_col(ind);
 
       // Reoptimize the coefficients, we brute-forcely reoptimize in the span,
       // which would be used in UpdateSpan class. Alternatively, if you want to
       // add an atom norm constraint, you could use projected gradient method,
       // see the implementaton of ProjectedGradientEnhancement().
-      arma::vec newCoeffs =
-          solve(function.MatrixA() * newAtoms, function.Vectorb());
+      arma::vec newCoeffs = solve(newProducts, function.Vectorb());
 
       // Evaluate the function again.
-      double Fnew = function.Evaluate(newAtoms * newCoeffs);
+      residual = newProducts * newCoeffs - function.Vectorb();
+      double Fnew = 0.5 * arma::dot(residual, residual);
 
       if (Fnew > F)
         // Should not delete the atom.
@@ -124,9 +180,8 @@ class Atoms
       else
       {
         // Delete the atom from current atoms.
-        currentAtoms = newAtoms;
+        RemoveAtom(ind);
         currentCoeffs = newCoeffs;
-        atomSqTerm.shed_row(ind);
         sqTerm.shed_row(ind);
       } // else
     } // while
@@ -160,29 +215,28 @@ class Atoms
    * @param maxIteration maximum iteration number.
    * @param tolerance tolerance for projected gradient method.
    */
-  void ProjectedGradientEnhancement(FuncSq& function,
+  template<typename MatType>
+  void ProjectedGradientEnhancement(const FuncSqType<MatType>& function,
                                     double tau,
                                     double stepSize,
                                     size_t maxIteration = 100,
                                     double tolerance = 1e-3)
   {
-    arma::mat x;
-    RecoverVector(x);
-    double value = function.Evaluate(x);
+    arma::vec residual;
+    Residual(function, residual);
+    double value = 0.5 * arma::dot(residual, residual);
 
     for (size_t iter = 1; iter<maxIteration; iter++)
     {
-      // Update currentCoeffs with gradient descent method.
-      arma::mat g;
-      function.Gradient(x, g);
-      g = currentAtoms.t() * g;
-      currentCoeffs = currentCoeffs - stepSize * g;
+      // Update currentCoeffs with gradient descent method; the gradient with
+      // respect to the coefficients is (A * atoms)^T * residual.
+      currentCoeffs -= stepSize * (atomProducts.t() * residual);
 
       // Projection of currentCoeffs to satisfy the atom norm constraint.
       Proximal::ProjectToL1Ball(currentCoeffs, tau);
 
-      RecoverVector(x);
-      double valueNew = function.Evaluate(x);
+      Residual(function, residual);
+      double valueNew = 0.5 * arma::dot(residual, residual);
 
       if ((value - valueNew) < tolerance)
         break;
@@ -199,9 +253,12 @@ class Atoms
 
   //! Get the current atoms.
   const arma::mat& CurrentAtoms() const { return currentAtoms; }
-  //! Modify the current atoms.
+  //! Modify the current atoms (call UpdateAtomProducts() afterwards).
   arma::mat& CurrentAtoms() { return currentAtoms; }
 
+  //! Get the products of the matrix A of the function with the current atoms.
+  const arma::mat& CurrentAtomProducts() const { return atomProducts; }
+
  private:
   //! Coefficients of current atoms.
   arma::vec currentCoeffs;
@@ -209,6 +266,10 @@ class Atoms
   //! Current atoms in the solution space.
   arma::mat currentAtoms;
 
+  //! Products of the matrix A with current atoms, one column per atom.  They
+  //! are computed when an atom is added.
+  arma::mat atomProducts;
+
   //! Atom square term: ||A * atom||^2, used in PruneSupport(). It is computed
   //! when an atom is added.
   arma::vec atomSqTerm;
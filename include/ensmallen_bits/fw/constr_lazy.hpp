@@ -0,0 +1,192 @@
+/**
+ * @file constr_lazy.hpp
+ * @author Marcus Edel
+ *
+ * Lazy linear constrained solver for FrankWolfe, which reuses the solutions of
+ * another solver when they give enough progress.  Used as
+ * LinearConstrSolverType in FrankWolfe.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_CONSTR_LAZY_HPP
+#define ENSMALLEN_FW_CONSTR_LAZY_HPP
+
+namespace ens {
+
+/**
+ * Lazy linear constrained solver for FrankWolfe.  Solving the linear
+ * constrained problem can be the main cost of an iteration (e.g. for
+ * structured group balls or nuclear norm balls).  This solver keeps the last
+ * solutions (atoms) of the wrapped solver, and at each iteration first looks
+ * for the cached atom \f$ v \f$ with the smallest \f$ <v, \nabla f(x)> \f$.
+ * If it gives enough progress, that is,
+ * \f[
+ * <x - v, \nabla f(x)> \geq \Phi / K,
+ * \f]
+ * where \f$ \Phi \f$ is the duality gap found by the last call to the wrapped
+ * solver, the atom is used and the wrapped solver is not called.  Otherwise
+ * the wrapped solver gives the atom, which is added to the cache, and
+ * \f$ \Phi \f$ is updated.  Only the duality gap of atoms given by the wrapped
+ * solver is used to terminate FrankWolfe.  For more information, see the
+ * following paper:
+ *
+ * @code
+ * @inproceedings{Braun2017,
+ *   title     = {Lazifying Conditional Gradient Algorithms},
+ *   author    = {Braun, G{\'a}bor and Pokutta, Sebastian and Zink, Daniel},
+ *   booktitle = {Proceedings of the 34th International Conference on Machine
+ *                Learning},
+ *   pages     = {566--575},
+ *   year      = {2017}
+ * }
+ * @endcode
+ *
+ * Here \f$ \Phi \f$ is set to the last exact gap instead of being halved as in
+ * the paper, since FrankWolfe takes a step at every iteration.
+ *
+ * @tparam LinearConstrSolverType Solver for the linear constrained problem.
+ */
+template<typename LinearConstrSolverType>
+class LazyConstrSolver
+{
+ public:
+  /**
+   * Construct the lazy solver around the given solver.
+   *
+   * @param solver Solver for the linear constrained problem.
+   * @param accuracy Accuracy parameter K >= 1; larger values accept cached
+   *     atoms with less progress.
+   * @param maxAtoms Maximum number of cached atoms; the oldest atom is dropped
+   *     when the cache is full (0 means no limit).
+   */
+  LazyConstrSolver(const LinearConstrSolverType& solver,
+                   const double accuracy = 2.0,
+                   const size_t maxAtoms = 100) :
+      solver(solver),
+      accuracy(accuracy),
+      maxAtoms(maxAtoms),
+      phi(0.0),
+      oracleCalls(0),
+      cachedCalls(0)
+  { /* Do nothing. */ }
+
+  /**
+   * Solve the linear constrained problem with the wrapped solver, without
+   * looking at the cache.
+   *
+   * @param v Input local gradient.
+   * @param s Output optimal solution in the constrained domain.
+   */
+  void Optimize(const arma::mat& v, arma::mat& s)
+  {
+    solver.Optimize(v, s);
+    ++oracleCalls;
+  }
+
+  /**
+   * Find an atom giving enough progress from the given iterate, calling the
+   * wrapped solver only if no cached atom does.
+   *
+   * @param v Input local gradient.
+   * @param iterate Current solution of FrankWolfe.
+   * @param s Output atom in the constrained domain.
+   * @return true if s was given by the wrapped solver, so that its duality gap
+   *     is exact.
+   */
+  bool Optimize(const arma::mat& v, const arma::mat& iterate, arma::mat& s)
+  {
+    const double current = arma::dot(v, iterate);
+    if (atoms.n_cols > 0 && phi > 0.0)
+    {
+      const arma::rowvec products = arma::vectorise(v).t() * atoms;
+      arma::uword best = 0;
+      products.min(best);
+      if (current - products[best] >= phi / accuracy)
+      {
+        s = arma::reshape(atoms.col(best), iterate.n_rows, iterate.n_cols);
+        ++cachedCalls;
+        return false;
+      }
+    }
+
+    Optimize(v, s);
+    phi = current - arma::dot(v, s);
+
+    // Add the atom to the cache if it is new.
+    const arma::vec atom = arma::vectorise(s);
+    if (atoms.n_rows != atom.n_elem)
+      atoms.set_size(atom.n_elem, 0);
+
+    for (size_t i = 0; i < atoms.n_cols; ++i)
+    {
+      if (arma::all(atoms.col(i) == atom))
+        return true;
+    }
+
+    if (maxAtoms > 0 && atoms.n_cols >= maxAtoms)
+      atoms.shed_col(0);
+    atoms.insert_cols(atoms.n_cols, atom);
+    return true;
+  }
+
+  //! Clear the cached atoms and the gap estimate, e.g. before optimizing
+  //! another function.
+  void Reset()
+  {
+    atoms.reset();
+    phi = 0.0;
+  }
+
+  //! Get the wrapped solver.
+  const LinearConstrSolverType& Solver() const { return solver; }
+  //! Modify the wrapped solver.
+  LinearConstrSolverType& Solver() { return solver; }
+
+  //! Get the accuracy parameter K.
+  double Accuracy() const { return accuracy; }
+  //! Modify the accuracy parameter K.
+  double& Accuracy() { return accuracy; }
+
+  //! Get the maximum number of cached atoms.
+  size_t MaxAtoms() const { return maxAtoms; }
+  //! Modify the maximum number of cached atoms.
+  size_t& MaxAtoms() { return maxAtoms; }
+
+  //! Get the cached atoms, one (vectorised) atom per column.
+  const arma::mat& CachedAtoms() const { return atoms; }
+
+  //! Get the number of calls to the wrapped solver.
+  size_t OracleCalls() const { return oracleCalls; }
+
+  //! Get the number of calls answered from the cache.
+  size_t CachedCalls() const { return cachedCalls; }
+
+ private:
+  //! The wrapped solver.
+  LinearConstrSolverType solver;
+
+  //! The accuracy parameter K.
+  double accuracy;
+
+  //! The maximum number of cached atoms (0 means no limit).
+  size_t maxAtoms;
+
+  //! The cached atoms, one vectorised atom per column.
+  arma::mat atoms;
+
+  //! The duality gap of the last atom given by the wrapped solver.
+  double phi;
+
+  //! The number of calls to the wrapped solver.
+  size_t oracleCalls;
+
+  //! The number of calls answered from the cache.
+  size_t cachedCalls;
+};
+
+} // namespace ens
+
+#endif
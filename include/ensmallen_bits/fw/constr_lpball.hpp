@@ -123,12 +123,50 @@ class ConstrLpBallSolver
     }
     else
     {
-      Warn << "Wrong norm p!" << std::endl;
+      ENS_WARN << "Wrong norm p!" << std::endl;
     }
 
     return;
   }
 
+  /**
+   * Optimizer of Linear Constrained Problem for FrankWolfe, returning the
+   * solution as a sparse atom.  This is only possible for the l1 ball, where
+   * the solution has a single non-zero element \f$ s_k \f$; for other norms
+   * false is returned and the dense Optimize() has to be used.
+   *
+   * @param v Input local gradient.
+   * @param index Output linear index k of the non-zero element of s.
+   * @param value Output value of s_k.
+   * @return true if the solution is a sparse atom.
+   */
+  bool Optimize(const arma::mat& v,
+                arma::uword& index,
+                double& value)
+  {
+    if (p != 1.0)
+      return false;
+
+    // Find k without forming any temporary of the size of v.
+    double largest = -1.0;
+    for (arma::uword j = 0; j < v.n_elem; ++j)
+    {
+      const double magnitude = regFlag ? std::abs(v[j] / lambda[j]) :
+          std::abs(v[j]);
+      if (magnitude > largest)
+      {
+        largest = magnitude;
+        index = j;
+      }
+    }
+
+    value = -((0.0 < v[index]) - (v[index] < 0.0));
+    if (regFlag)
+      value /= lambda[index];
+
+    return true;
+  }
+
   //! Get the p-norm.
   double P() const { return p; }
   //! Modify the p-norm.
@@ -58,6 +58,20 @@ namespace ens {
  *    ProjectToGroup(const arma::mat& v, const size_t groupId, arma::vec& y);
  *    void OptimalFromGroup(const arma::mat& v, const size_t groupId, arma::mat& s);
  *
+ *  If GroupType also has the method
+ *
+ *    double GroupDualNorm(const arma::mat& v, const size_t groupId) const;
+ *
+ *  it is used to compute the dual norm of each group directly from v, instead
+ *  of projecting v to the group first.
+ *
+ *  The search for the group with the largest dual norm can be split between
+ *  OpenMP threads; each thread scans a contiguous range of the groups with its
+ *  own projection buffer, which is kept between calls, and the best group of
+ *  each range is then compared in order, so that the same group is found as
+ *  with one thread.  The methods of GroupType must then be safe to call from
+ *  several threads at once.
+ *
  * @tparam GroupType Class that implements functions to map original vectors to
  *                   each group, and to solve linear optimization problem in the
  *                   unit ball defined by the norm of each group.
@@ -71,9 +85,13 @@ class ConstrStructGroupSolver
    *
    * @param groupExtractor Class used to project to a group, recovery from a
    *                       group, and compute norm in each group.
+   * @param parallel Whether to search for the optimal group with several
+   *                 OpenMP threads.
    */
-  ConstrStructGroupSolver(GroupType& groupExtractor) :
-    groupExtractor(groupExtractor)
+  ConstrStructGroupSolver(GroupType& groupExtractor,
+                          const bool parallel = false) :
+    groupExtractor(groupExtractor),
+    parallel(parallel)
   { /* Nothing to do */ }
 
   /**
@@ -84,31 +102,132 @@ class ConstrStructGroupSolver
    */
   void Optimize(const arma::mat& v, arma::mat& s)
   {
-    size_t nGroups = groupExtractor.NumGroups();
+    const size_t nGroups = groupExtractor.NumGroups();
+
+    #ifdef ENS_USE_OPENMP
+      const size_t maxThreads = parallel ?
+          std::max((size_t) omp_get_max_threads(), (size_t) 1) : 1;
+    #else
+      const size_t maxThreads = 1;
+    #endif
+
+    // The buffers are only allocated when the number of threads grows.
+    if (buffers.size() < maxThreads)
+    {
+      buffers.resize(maxThreads);
+      bestNorms.resize(maxThreads);
+      bestGroups.resize(maxThreads);
+    }
+
+    // Find the optimal group.  A range that finds no positive dual norm keeps
+    // group 0, which is never taken.
+    std::fill(bestGroups.begin(), bestGroups.end(), 0);
+    if (maxThreads == 1 || nGroups < 2)
+    {
+      ScanGroups(v, 1, nGroups + 1, buffers[0], bestNorms[0], bestGroups[0]);
+    }
+    else
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        ScanGroups(v, 1 + threadId * nGroups / numThreads,
+            1 + (threadId + 1) * nGroups / numThreads, buffers[threadId],
+            bestNorms[threadId], bestGroups[threadId]);
+      }
+    }
+
+    // Compare the ranges in order, so that ties go to the first group.
     double dualNorm = 0;
     size_t optimalGroup = 1;
+    for (size_t t = 0; t < maxThreads; ++t)
+    {
+      if (bestGroups[t] != 0 && bestNorms[t] > dualNorm)
+      {
+        optimalGroup = bestGroups[t];
+        dualNorm = bestNorms[t];
+      }
+    }
 
-    // Find the optimal group.
-    for (size_t i = 1; i <= nGroups; ++i)
+    groupExtractor.OptimalFromGroup(v, optimalGroup, s);
+  }
+
+  //! Get whether the optimal group is searched with several threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the optimal group is searched with several threads.
+  bool& Parallel() { return parallel; }
+
+ private:
+  /**
+   * Find the group with the largest positive dual norm among the groups
+   * [begin, end); bestGroup is 0 if there is none.
+   */
+  void ScanGroups(const arma::mat& v,
+                  const size_t begin,
+                  const size_t end,
+                  arma::vec& y,
+                  double& bestNorm,
+                  size_t& bestGroup)
+  {
+    bestNorm = 0;
+    bestGroup = 0;
+    for (size_t i = begin; i < end; ++i)
     {
-      arma::vec y;
-      groupExtractor.ProjectToGroup(v, i, y);
-      double newNorm = groupExtractor.DualNorm(y, i);
+      const double newNorm = CallDualNorm(groupExtractor, v, i, y, 0);
 
       // Find the group with largest dual norm.
-      if (newNorm > dualNorm)
+      if (newNorm > bestNorm)
       {
-        optimalGroup = i;
-        dualNorm = newNorm;
+        bestGroup = i;
+        bestNorm = newNorm;
       }
     }
+  }
 
-    groupExtractor.OptimalFromGroup(v, optimalGroup, s);
+  //! Compute the dual norm of a group directly from v.
+  template<typename ExtractorType>
+  static auto CallDualNorm(ExtractorType& extractor,
+                           const arma::mat& v,
+                           const size_t groupId,
+                           arma::vec& /* y */,
+                           int)
+      -> decltype(extractor.GroupDualNorm(v, groupId))
+  {
+    return extractor.GroupDualNorm(v, groupId);
+  }
+
+  //! Compute the dual norm of the projection of v to a group.
+  template<typename ExtractorType>
+  static double CallDualNorm(ExtractorType& extractor,
+                             const arma::mat& v,
+                             const size_t groupId,
+                             arma::vec& y,
+                             long)
+  {
+    extractor.ProjectToGroup(v, groupId, y);
+    return extractor.DualNorm(y, groupId);
   }
 
- private:
   //! Information and methods for groups.
   GroupType& groupExtractor;
+
+  //! Whether to search for the optimal group with several threads.
+  bool parallel;
+
+  //! The projection buffer of each thread.
+  std::vector<arma::vec> buffers;
+
+  //! The largest dual norm found by each thread.
+  std::vector<double> bestNorms;
+
+  //! The group with the largest dual norm found by each thread.
+  std::vector<size_t> bestGroups;
 };
 
 /**
@@ -190,7 +309,7 @@ class GroupLpBall
    * @param yk compute the q-norm of yk.
    * @param groupId group ID number.
    */
-  double DualNorm(const arma::vec& yk, const int groupId)
+  double DualNorm(const arma::vec& yk, const int /* groupId */)
   {
     if (p == std::numeric_limits<double>::infinity())
     {
@@ -210,12 +329,78 @@ class GroupLpBall
     }
     else
     {
-      Log::Fatal << "Wrong norm p!" << std::endl;
+      WrongNorm();
+      return 0.0;
+    }
+  }
+
+  /**
+   * Compute the q-norm of the projection of v to a group, 1/p+1/q=1, directly
+   * from the indices of the group, without forming the projection.
+   *
+   * @param v input vector.
+   * @param groupId group ID number, start from 1.
+   */
+  double GroupDualNorm(const arma::mat& v, const size_t groupId) const
+  {
+    const arma::uvec& indList = groupIndicesList[groupId - 1];
+    const size_t dim = indList.n_elem;
+
+    if (p == std::numeric_limits<double>::infinity())
+    {
+      // inf-norm, return 1-norm
+      double norm = 0.0;
+      for (size_t i = 0; i < dim; ++i)
+        norm += std::abs(v(indList(i)));
+      return norm;
+    }
+    else if (p == 2.0)
+    {
+      double norm = 0.0;
+      for (size_t i = 0; i < dim; ++i)
+        norm += v(indList(i)) * v(indList(i));
+      return std::sqrt(norm);
+    }
+    else if (p > 1.0)
+    {
+      // p norm, return q-norm; the elements are scaled by the largest one, so
+      // that their powers neither overflow nor underflow.
+      const double q = 1.0 / (1.0 - 1.0/p);
+      double scale = 0.0;
+      for (size_t i = 0; i < dim; ++i)
+        scale = std::max(scale, std::abs(v(indList(i))));
+      if (scale == 0.0)
+        return 0.0;
+
+      double norm = 0.0;
+      for (size_t i = 0; i < dim; ++i)
+        norm += std::pow(std::abs(v(indList(i))) / scale, q);
+      return scale * std::pow(norm, 1.0 / q);
+    }
+    else if (p == 1.0)
+    {
+      // 1-norm, return inf-norm
+      double norm = 0.0;
+      for (size_t i = 0; i < dim; ++i)
+        norm = std::max(norm, std::abs(v(indList(i))));
+      return norm;
+    }
+    else
+    {
+      WrongNorm();
       return 0.0;
     }
   }
 
  private:
+  //! Signal a norm p smaller than 1.
+  void WrongNorm() const
+  {
+    std::ostringstream oss;
+    oss << "GroupLpBall: the norm p must be at least 1, but is " << p << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
   //! lp norm, 1<=p<=inf;
   //! use std::numeric_limits<double>::infinity() for inf norm.
   double p;
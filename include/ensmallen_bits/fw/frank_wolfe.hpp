@@ -16,7 +16,11 @@
 #include "update_linesearch.hpp"
 #include "update_classic.hpp"
 #include "update_span.hpp"
+#include "update_away_step.hpp"
+#include "update_pairwise.hpp"
 #include "constr_lpball.hpp"
+#include "constr_structure_group.hpp"
+#include "constr_lazy.hpp"
 
 namespace ens {
 
@@ -71,11 +75,56 @@ namespace ens {
  *
  * UpdateRuleType:
  *
- *   void Update(const arma::mat& old_coords,
+ *   void Update(FunctionType& function,
+ *               const arma::mat& old_coords,
  *               const arma::mat& s,
  *               arma::mat& new_coords,
  *               const size_t num_iter);
  *
+ * An update rule that needs the gradient at old_coords (like UpdateAwayStep and
+ * UpdatePairwise) may instead implement
+ *
+ *   void Update(FunctionType& function,
+ *               const arma::mat& old_coords,
+ *               const arma::mat& s,
+ *               const arma::mat& gradient,
+ *               arma::mat& new_coords,
+ *               const size_t num_iter);
+ *
+ * which is then called with the gradient already computed by the optimizer.
+ *
+ * When the solution of the linear constrained problem has a single non-zero
+ * element (e.g. ConstrLpBallSolver with p = 1), the solver may also implement
+ *
+ *   bool Optimize(const arma::mat& gradient,
+ *                 arma::uword& index,
+ *                 double& value);
+ *
+ * returning true if it stored the solution as s(index) = value, and the update
+ * rule may implement
+ *
+ *   double SparseUpdate(FunctionType& function,
+ *                       arma::mat& coords,
+ *                       const arma::uword index,
+ *                       const double value,
+ *                       const size_t num_iter);
+ *
+ * which updates coords in place and returns the step gamma (like
+ * UpdateClassic).  The duality gap and the update then never form s, and if
+ * the function has an UpdateGradient() method (see
+ * traits::HasGradientUpdate), the gradient is updated after such a step
+ * instead of being computed again.
+ *
+ * A solver may also implement
+ *
+ *   bool Optimize(const arma::mat& gradient,
+ *                 const arma::mat& iterate,
+ *                 arma::mat& s);
+ *
+ * which may return any atom giving enough progress from the iterate (like
+ * LazyConstrSolver); it returns true only if s solves the linear constrained
+ * problem, and the duality gap is then checked for termination.
+ *
  * @tparam LinearConstrSolverType Solver for the linear constrained problem.
  * @tparam UpdateRuleType Rule to update the solution in each iteration.
  *
@@ -143,6 +192,9 @@ class FrankWolfe
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The solver for constrained linear problem in first step.
   LinearConstrSolverType linearConstrSolver;
@@ -155,6 +207,113 @@ class FrankWolfe
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+
+  //! Call the update rule with the gradient, if it takes it.
+  template<typename RuleType, typename FunctionType>
+  static auto CallUpdate(RuleType& rule,
+                         FunctionType& function,
+                         const arma::mat& iterate,
+                         const arma::mat& s,
+                         const arma::mat& gradient,
+                         arma::mat& iterateNew,
+                         const size_t numIter,
+                         int)
+      -> decltype(rule.Update(function, iterate, s, gradient, iterateNew,
+                              numIter))
+  {
+    return rule.Update(function, iterate, s, gradient, iterateNew, numIter);
+  }
+
+  //! Call the update rule without the gradient.
+  template<typename RuleType, typename FunctionType>
+  static void CallUpdate(RuleType& rule,
+                         FunctionType& function,
+                         const arma::mat& iterate,
+                         const arma::mat& s,
+                         const arma::mat& /* gradient */,
+                         arma::mat& iterateNew,
+                         const size_t numIter,
+                         long)
+  {
+    rule.Update(function, iterate, s, iterateNew, numIter);
+  }
+
+  //! Get an atom from a solver that may not solve the problem exactly.
+  template<typename SolverType>
+  static auto CallLazyOptimize(SolverType& solver,
+                               const arma::mat& gradient,
+                               const arma::mat& iterate,
+                               arma::mat& s,
+                               int)
+      -> decltype(solver.Optimize(gradient, iterate, s))
+  {
+    return solver.Optimize(gradient, iterate, s);
+  }
+
+  //! Solve the linear constrained problem exactly.
+  template<typename SolverType>
+  static bool CallLazyOptimize(SolverType& solver,
+                               const arma::mat& gradient,
+                               const arma::mat& /* iterate */,
+                               arma::mat& s,
+                               long)
+  {
+    solver.Optimize(gradient, s);
+    return true;
+  }
+
+  //! Get the solution of the linear constrained problem as a sparse atom.
+  template<typename SolverType>
+  static auto CallSparseOptimize(SolverType& solver,
+                                 const arma::mat& gradient,
+                                 arma::uword& index,
+                                 double& value,
+                                 int)
+      -> decltype(solver.Optimize(gradient, index, value))
+  {
+    return solver.Optimize(gradient, index, value);
+  }
+
+  //! The solver gives dense solutions only.
+  template<typename SolverType>
+  static bool CallSparseOptimize(SolverType& /* solver */,
+                                 const arma::mat& /* gradient */,
+                                 arma::uword& /* index */,
+                                 double& /* value */,
+                                 long)
+  {
+    return false;
+  }
+
+  //! Update the solution in place with a sparse atom and return the step.
+  template<typename RuleType, typename FunctionType>
+  static auto CallSparseUpdate(RuleType& rule,
+                               FunctionType& function,
+                               arma::mat& iterate,
+                               const arma::uword index,
+                               const double value,
+                               const size_t numIter,
+                               int)
+      -> decltype(rule.SparseUpdate(function, iterate, index, value, numIter))
+  {
+    return rule.SparseUpdate(function, iterate, index, value, numIter);
+  }
+
+  //! The update rule needs a dense atom; a negative step is returned.
+  template<typename RuleType, typename FunctionType>
+  static double CallSparseUpdate(RuleType& /* rule */,
+                                 FunctionType& /* function */,
+                                 arma::mat& /* iterate */,
+                                 const arma::uword /* index */,
+                                 const double /* value */,
+                                 const size_t /* numIter */,
+                                 long)
+  {
+    return -1.0;
+  }
 };
 
 /**
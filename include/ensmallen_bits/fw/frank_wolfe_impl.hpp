@@ -43,6 +43,8 @@ template<typename FunctionType>
 double FrankWolfe<LinearConstrSolverType, UpdateRuleType>::
 Optimize(FunctionType& function, arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   typedef Function<FunctionType> FullFunctionType;
   FullFunctionType& f = static_cast<FullFunctionType&>(function);
 
@@ -57,34 +59,80 @@ Optimize(FunctionType& function, arma::mat& iterate)
   arma::mat iterateNew(iterate.n_rows, iterate.n_cols);
   double gap = 0;
 
+  // The sparse atom given by the linear constrained solver, if it can give
+  // one.
+  arma::uword atomIndex = 0;
+  double atomValue = 0.0;
+
+  // Whether the gradient was updated after the last (sparse) step, so that
+  // currentObjective was not evaluated at the iterate.
+  bool gradientUpdated = false;
+
   for (size_t i = 1; i != maxIterations; ++i)
   {
-    currentObjective = f.EvaluateWithGradient(iterate, gradient);
-
-    // Output current objective function.
-    Info << "FrankWolfe::Optimize(): iteration " << i << ", objective "
-        << currentObjective << "." << std::endl;
+    if (!gradientUpdated)
+    {
+      currentObjective = f.EvaluateWithGradient(iterate, gradient);
 
-    // Solve linear constrained problem, solution saved in s.
-    linearConstrSolver.Optimize(gradient, s);
+      // Output current objective function.
+      ENS_INFO << "FrankWolfe::Optimize(): iteration " << i << ", objective "
+          << currentObjective << "." << std::endl;
+    }
 
-    // Check duality gap for return condition.
-    gap = std::fabs(dot(iterate - s, gradient));
-    if (gap < tolerance)
+    if (CallSparseOptimize(linearConstrSolver, gradient, atomIndex, atomValue,
+        0))
     {
-      Info << "FrankWolfe::Optimize(): minimized within tolerance "
-          << tolerance << "; " << "terminating optimization." << std::endl;
-      return currentObjective;
+      // Check duality gap for return condition, without forming s.
+      gap = std::fabs(dot(iterate, gradient) -
+          atomValue * gradient[atomIndex]);
+      if (gap < tolerance)
+      {
+        ENS_INFO << "FrankWolfe::Optimize(): minimized within tolerance "
+            << tolerance << "; " << "terminating optimization." << std::endl;
+        return gradientUpdated ? f.Evaluate(iterate) : currentObjective;
+      }
+
+      // Update solution in place, if the update rule can take a sparse atom.
+      const double gamma = CallSparseUpdate(updateRule, f, iterate, atomIndex,
+          atomValue, i, 0);
+      if (gamma >= 0.0)
+      {
+        gradientUpdated = TryUpdateGradient(function, iterate, gamma,
+            atomIndex, atomValue, gradient);
+        continue;
+      }
+
+      s.zeros(iterate.n_rows, iterate.n_cols);
+      s[atomIndex] = atomValue;
+    }
+    else
+    {
+      // Solve linear constrained problem, solution saved in s; a lazy solver
+      // may return an atom that does not solve it exactly.
+      const bool exact = CallLazyOptimize(linearConstrSolver, gradient,
+          iterate, s, 0);
+
+      // Check duality gap for return condition.
+      gap = std::fabs(dot(iterate - s, gradient));
+      if (exact && gap < tolerance)
+      {
+        ENS_INFO << "FrankWolfe::Optimize(): minimized within tolerance "
+            << tolerance << "; " << "terminating optimization." << std::endl;
+        return gradientUpdated ? f.Evaluate(iterate) : currentObjective;
+      }
     }
-
 
     // Update solution, save in iterateNew.
-    updateRule.Update(f, iterate, s, iterateNew, i);
+    CallUpdate(updateRule, f, iterate, s, gradient, iterateNew, i, 0);
 
-    iterate = std::move(iterateNew);
+    SwapInPlace(iterate, iterateNew);
+    gradientUpdated = false;
   }
 
-  Info << "FrankWolfe::Optimize(): maximum iterations (" << maxIterations
+  if (gradientUpdated)
+    currentObjective = f.Evaluate(iterate);
+
+  ENS_INFO << "FrankWolfe::Optimize(): maximum iterations (" << maxIterations
       << ") reached; " << "terminating optimization." << std::endl;
   return currentObjective;
 } // Optimize()
@@ -17,9 +17,13 @@ namespace ens {
 /**
  * Square loss function \f$ f(x) = 0.5 * ||Ax - b||_2^2 \f$.
  *
- * Contains matrix \f$ A \f$ and vector \f$ b \f$.
+ * Contains matrix \f$ A \f$ and vector \f$ b \f$.  The matrix may be dense
+ * (arma::mat) or sparse (arma::sp_mat).
+ *
+ * @tparam MatType Type of the matrix A.
  */
-class FuncSq
+template<typename MatType = arma::mat>
+class FuncSqType
 {
  public:
   /**
@@ -28,7 +32,7 @@ class FuncSq
    * @param A matrix A.
    * @param b vector b.
    */
-  FuncSq(const arma::mat& A, const arma::vec& b) : A(A), b(b)
+  FuncSqType(const MatType& A, const arma::vec& b) : A(A), b(b)
   {/* Nothing to do. */}
 
   /**
@@ -57,24 +61,40 @@ class FuncSq
     gradient = A.t() * r;
   }
 
+  /**
+   * Residual of square loss function, \f$ r(x) = Ax - b \f$.  Since the
+   * residual is affine in x, the line search can find its exact step from the
+   * residuals at the two ends of the line.
+   *
+   * @param coords input vector x.
+   * @param residual output residual vector.
+   */
+  void Residual(const arma::mat& coords, arma::vec& residual)
+  {
+    residual = A * coords - b;
+  }
+
   //! Get the matrix A.
-  arma::mat MatrixA() const {return A;}
+  const MatType& MatrixA() const { return A; }
   //! Modify the matrix A.
-  arma::mat& MatrixA() {return A;}
+  MatType& MatrixA() { return A; }
 
   //! Get the vector b.
-  arma::vec Vectorb() const { return b; }
+  const arma::vec& Vectorb() const { return b; }
   //! Modify the vector b.
   arma::vec& Vectorb() { return b; }
 
  private:
   //! Matrix A in square loss function.
-  arma::mat A;
+  MatType A;
 
   //! Vector b in square loss function.
   arma::vec b;
 };
 
+//! Square loss function with a dense matrix A.
+using FuncSq = FuncSqType<arma::mat>;
+
 } // namespace ens
 
 #endif
@@ -23,6 +23,11 @@ namespace ens {
  * line will be nondecreasing, so the minimum always exists.
  * If the function is strongly convex, the derivative of the function along the
  * search line will be strictly increasing, so the minimum is unique.
+ *
+ * If the function is a least squares objective that can compute its residual
+ * (see traits::HasResidual, e.g. FuncSq), the objective is quadratic along the
+ * line and the exact step is computed in closed form from the residuals at the
+ * two end points instead; no gradient is computed then.
  */
 class LineSearch
 {
@@ -47,6 +52,46 @@ class LineSearch
   template<typename FunctionType>
   double Optimize(FunctionType& function, const arma::mat& x1, arma::mat& x2);
 
+  /**
+   * Find the exact minimum of a least squares objective
+   * \f$ f(x) = \frac{1}{2} \|Ax - b\|_2^2 \f$ between two points, given the
+   * residual \f$ Ax_1 - b \f$ at the first one (see traits::HasResidual).
+   * Since the residual is affine, the residual at the solution is updated from
+   * the residuals at the two end points, so only the residual at x2 is
+   * computed: a caller that keeps the residual across calls needs a single
+   * product with A per line search.
+   *
+   * @param function least squares function to be minimized.
+   * @param x1 Input one end point.
+   * @param x2 Input the other end point, also used as output, to store the
+   *           coordinate of the optimal solution.
+   * @param residual Input the residual at x1, also used as output, to store the
+   *           residual at the optimal solution.
+   * @return Minimum solution function value.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function,
+                  const arma::mat& x1,
+                  arma::mat& x2,
+                  arma::vec& residual);
+
+  /**
+   * Line search to minimize function along the given direction, with a step
+   * between 0 and gammaMax, that is, between x and x + gammaMax * direction.
+   *
+   * @param function function to be minimized.
+   * @param x Input starting point.
+   * @param direction Input search direction.
+   * @param gammaMax Largest allowed step.
+   * @return The step minimizing the function; this is exactly gammaMax if the
+   *         minimum is at the far end point.
+   */
+  template<typename FunctionType>
+  double Step(FunctionType& function,
+              const arma::mat& x,
+              const arma::mat& direction,
+              const double gammaMax);
+
   //! Get the maximum number of iterations (0 indicates no limit).
   size_t MaxIterations() const { return maxIterations; }
   //! Modify the maximum number of iterations (0 indicates no limit).
@@ -64,6 +109,18 @@ class LineSearch
   //! Tolerance for convergence.
   double tolerance;
 
+  //! Find the minimum with the secant method.
+  template<typename FunctionType>
+  typename std::enable_if<!traits::HasResidual<FunctionType>::value,
+      double>::type
+  Search(FunctionType& function, const arma::mat& x1, arma::mat& x2);
+
+  //! Find the exact minimum of a least squares objective.
+  template<typename FunctionType>
+  typename std::enable_if<traits::HasResidual<FunctionType>::value,
+      double>::type
+  Search(FunctionType& function, const arma::mat& x1, arma::mat& x2);
+
   /**
    * Derivative of the function along the search line.
    *
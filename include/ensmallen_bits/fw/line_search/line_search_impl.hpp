@@ -23,6 +23,60 @@ template<typename FunctionType>
 double LineSearch::Optimize(FunctionType& function,
                             const arma::mat& x1,
                             arma::mat& x2)
+{
+  return Search(function, x1, x2);
+}
+
+template<typename FunctionType>
+double LineSearch::Optimize(FunctionType& function,
+                            const arma::mat& x1,
+                            arma::mat& x2,
+                            arma::vec& residual)
+{
+  static_assert(traits::HasResidual<FunctionType>::value,
+      "The FunctionType does not have a correct definition of Residual(). "
+      "Please check that the FunctionType fully satisfies the requirements of "
+      "a least squares objective.");
+
+  // Along the line x1 + gamma * (x2 - x1) the residual is
+  // r1 + gamma * (r2 - r1), so the objective is the quadratic
+  // 0.5 * ||r1||^2 + gamma * slope + 0.5 * gamma^2 * curvature.
+  arma::vec residualEnd;
+  function.Residual(x2, residualEnd);
+  const arma::vec change = residualEnd - residual;
+  const double slope = arma::dot(residual, change);
+  const double curvature = arma::dot(change, change);
+
+  if (slope >= 0.0) // Optimal solution at left endpoint.
+  {
+    x2 = x1;
+  }
+  else if (slope + curvature <= 0.0) // Optimal solution at right endpoint.
+  {
+    residual.swap(residualEnd);
+  }
+  else
+  {
+    const double gamma = -slope / curvature;
+    x2 = (1 - gamma) * x1 + gamma * x2;
+    residual += gamma * change;
+  }
+
+  return 0.5 * arma::dot(residual, residual);
+}
+
+template<typename FunctionType>
+typename std::enable_if<traits::HasResidual<FunctionType>::value, double>::type
+LineSearch::Search(FunctionType& function, const arma::mat& x1, arma::mat& x2)
+{
+  arma::vec residual;
+  function.Residual(x1, residual);
+  return Optimize(function, x1, x2, residual);
+}
+
+template<typename FunctionType>
+typename std::enable_if<!traits::HasResidual<FunctionType>::value, double>::type
+LineSearch::Search(FunctionType& function, const arma::mat& x1, arma::mat& x2)
 {
   typedef Function<FunctionType> FullFunctionType;
   FullFunctionType& f = static_cast<FullFunctionType&>(function);
@@ -59,7 +113,7 @@ double LineSearch::Optimize(FunctionType& function,
     // secant should always >=0 for convex function.
     if (secant < 0.0)
     {
-      Warn << "LineSearchSecant: Function is not convex!" << std::endl;
+      ENS_WARN << "LineSearchSecant: Function is not convex!" << std::endl;
       x2 = x1;
       return function.Evaluate(x1);
     }
@@ -77,21 +131,43 @@ double LineSearch::Optimize(FunctionType& function,
 
     if (std::fabs(derivative) < tolerance)
     {
-      Info << "LineSearchSecant: minimized within tolerance "
+      ENS_INFO << "LineSearchSecant: minimized within tolerance "
           << tolerance << "; " << "terminating optimization." << std::endl;
       x2 = (1 - gamma) * x1 + gamma * x2;
       return f.Evaluate(x2);
     }
   }
 
-  Info << "LineSearchSecant: maximum iterations (" << maxIterations
+  ENS_INFO << "LineSearchSecant: maximum iterations (" << maxIterations
       << ") reached; " << "terminating optimization." << std::endl;
 
   x2 = (1 - gamma) * x1 + gamma * x2;
   return f.Evaluate(x2);
-}  // Optimize
+}  // Search
 
 
+template<typename FunctionType>
+double LineSearch::Step(FunctionType& function,
+                        const arma::mat& x,
+                        const arma::mat& direction,
+                        const double gammaMax)
+{
+  const double directionNorm = arma::dot(direction, direction);
+  if (directionNorm == 0.0 || gammaMax <= 0.0)
+    return 0.0;
+
+  arma::mat end = x + gammaMax * direction;
+  Optimize(function, x, end);
+
+  // Recover the step from the point found by the line search; the far end
+  // point itself is returned unchanged when it is the minimum.
+  const double gamma = arma::dot(end - x, direction) / directionNorm;
+  if (gamma >= gammaMax * (1.0 - 1e-10))
+    return gammaMax;
+
+  return std::max(gamma, 0.0);
+}
+
 //! Derivative of the function along the search line.
 template<typename FunctionType>
 double LineSearch::Derivative(FunctionType& function,
@@ -14,6 +14,10 @@
 #ifndef ENSMALLEN_PROXIMAL_PROXIMAL_HPP
 #define ENSMALLEN_PROXIMAL_PROXIMAL_HPP
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 namespace ens {
 
 /**
@@ -37,6 +41,17 @@ class Proximal
    */
   static void ProjectToL1Ball(arma::vec& v, double tau);
 
+  /**
+   * Project each column of the matrix onto the l1 ball with norm tau, as with
+   * ProjectToL1Ball().  The columns are projected in parallel when OpenMP is
+   * enabled.
+   *
+   * @param v Input matrix whose columns are to be approximated, the output
+   *          optimal columns are also saved in v.
+   * @param tau Norm of l1 ball.
+   */
+  static void ProjectColumnsToL1Ball(arma::mat& v, double tau);
+
   /**
    * Project the vector onto the l0 ball with norm tau. That is, we try to
    * approximate v with sparse vector w:
@@ -49,6 +64,40 @@ class Proximal
    * @param tau Norm of l0 ball.
    */
   static void ProjectToL0Ball(arma::vec& v, int tau);
+
+  /**
+   * Project the vector onto the l0 ball with norm tau as ProjectToL0Ball(),
+   * and also store the sorted indices of the (at most tau) entries that are
+   * kept in support, so that the result can be used as the sparse vector given
+   * by support and v.elem(support).
+   *
+   * @param v Input vector to be approxmated, the output optimal vector is
+   *          also saved in v.
+   * @param tau Norm of l0 ball.
+   * @param support Output indices of the kept entries of v.
+   */
+  static void ProjectToL0Ball(arma::vec& v, int tau, arma::uvec& support);
+
+ private:
+  /**
+   * Find the threshold theta such that soft thresholding the n values of v by
+   * theta projects them onto the l1 ball with norm tau; theta is 0 if they are
+   * already in the ball.
+   *
+   * @param v Values to be projected.
+   * @param n Number of values.
+   * @param tau Norm of l1 ball.
+   * @param active Buffer, reused across calls.
+   * @param waiting Buffer, reused across calls.
+   */
+  static double L1BallThreshold(const double* v,
+                                const size_t n,
+                                const double tau,
+                                std::vector<double>& active,
+                                std::vector<double>& waiting);
+
+  //! Soft threshold the n values of v by theta.
+  static void SoftThreshold(double* v, const size_t n, const double theta);
 };  // class Proximal
 
 } // namespace ens
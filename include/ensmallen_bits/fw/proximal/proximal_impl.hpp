@@ -16,7 +16,9 @@ namespace ens {
 
 /**
  * Projection of the vector v onto l1 ball with norm tau.
- * See the paper:
+ * This is just a soft thresholding: the threshold is that of the projection of
+ * |v| onto the simplex, found in expected linear time (instead of sorting
+ * |v|), see the papers:
  * @code
  * @inproceedings{DucShaSin2008Efficient,
  *    author       = {Duchi, John and Shalev-Shwartz, Shai and Singer,
@@ -28,53 +30,216 @@ namespace ens {
  *    title        = {Efficient projections onto the l 1-ball for learning in
  *                    high dimensions},
  *    year         = {2008}}
- * @endcode
  *
- * This is just a soft thresholding.
+ * @article{Condat2016,
+ *    author  = {Condat, Laurent},
+ *    title   = {Fast projection onto the simplex and the l1 ball},
+ *    journal = {Mathematical Programming},
+ *    volume  = {158},
+ *    number  = {1},
+ *    pages   = {575--585},
+ *    year    = {2016}}
+ * @endcode
  */
 inline void Proximal::ProjectToL1Ball(arma::vec& v, double tau)
 {
-  arma::vec simplexSol = arma::abs(v);
+  std::vector<double> active, waiting;
+  const double theta = L1BallThreshold(v.memptr(), v.n_elem, tau, active,
+      waiting);
+  if (theta > 0.0)
+    SoftThreshold(v.memptr(), v.n_elem, theta);
+}
+
+/**
+ * Projection of each column of v onto l1 ball with norm tau; each thread
+ * keeps its own buffers.
+ */
+inline void Proximal::ProjectColumnsToL1Ball(arma::mat& v, double tau)
+{
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    std::vector<double> active, waiting;
+    for (size_t i = threadId; i < v.n_cols; i += numThreads)
+    {
+      const double theta = L1BallThreshold(v.colptr(i), v.n_rows, tau, active,
+          waiting);
+      if (theta > 0.0)
+        SoftThreshold(v.colptr(i), v.n_rows, theta);
+    }
+  }
+}
+
+/**
+ * Condat's algorithm on |v|: the candidate threshold is the one of the
+ * projection of the active values; values below it can not be in the support
+ * of the projection, and are dropped until the threshold is stable.
+ */
+inline double Proximal::L1BallThreshold(const double* v,
+                                        const size_t n,
+                                        const double tau,
+                                        std::vector<double>& active,
+                                        std::vector<double>& waiting)
+{
+  double norm = 0.0;
+  for (size_t j = 0; j < n; ++j)
+    norm += std::abs(v[j]);
 
   // Already with L1 norm <= tau.
-  if (arma::accu(simplexSol) <= tau)
-    return;
+  if (norm <= tau)
+    return 0.0;
+
+  active.clear();
+  waiting.clear();
+
+  // First pass: keep the values above the running threshold rho.
+  active.push_back(std::abs(v[0]));
+  double rho = active[0] - tau;
+  for (size_t j = 1; j < n; ++j)
+  {
+    const double y = std::abs(v[j]);
+    if (y <= rho)
+      continue;
 
-  simplexSol = arma::sort(simplexSol, "descend");
-  arma::vec simplexSum = arma::cumsum(simplexSol);
+    rho += (y - rho) / (active.size() + 1);
+    if (rho > y - tau)
+    {
+      active.push_back(y);
+    }
+    else
+    {
+      // y alone gives a larger threshold; restart from it.
+      waiting.insert(waiting.end(), active.begin(), active.end());
+      active.assign(1, y);
+      rho = y - tau;
+    }
+  }
 
-  double nu = 0;
-  size_t rho;
-  for (size_t j = 1; j <= simplexSol.n_rows; j++)
+  // Values set aside may still be above the final threshold.
+  for (size_t j = 0; j < waiting.size(); ++j)
   {
-    rho = simplexSol.n_rows - j;
-    nu = simplexSol(rho) - (simplexSum(rho) - tau)/(rho + 1);
-    if (nu > 0)
-      break;
+    if (waiting[j] > rho)
+    {
+      active.push_back(waiting[j]);
+      rho += (waiting[j] - rho) / active.size();
+    }
   }
-  double theta = (simplexSum(rho) - tau)/rho;
 
-  // Threshold on absolute value of v with theta.
-  for (arma::uword j = 0; j< simplexSol.n_rows; j++)
+  // Drop the values below the threshold until it does not change.
+  size_t size = active.size();
+  size_t previousSize = 0;
+  while (size != previousSize)
   {
-    if (v(j) >= 0.0)
-      v(j) = std::max(v(j) - theta, 0.0);
+    previousSize = size;
+    size_t kept = 0;
+    for (size_t j = 0; j < previousSize; ++j)
+    {
+      if (active[j] > rho)
+      {
+        active[kept++] = active[j];
+      }
+      else
+      {
+        --size;
+        rho += (rho - active[j]) / size;
+      }
+    }
+  }
+
+  return rho;
+}
+
+//! Soft threshold the n values of v by theta.
+inline void Proximal::SoftThreshold(double* v,
+                                    const size_t n,
+                                    const double theta)
+{
+  for (size_t j = 0; j < n; ++j)
+  {
+    if (v[j] >= 0.0)
+      v[j] = std::max(v[j] - theta, 0.0);
     else
-      v(j) = std::min(v(j) + theta, 0.0);
+      v[j] = std::min(v[j] + theta, 0.0);
   }
 }
 
 /**
  * Approximate the vector v with a tau-sparse vector.
- * This is a hard-thresholding.
+ * This is a hard-thresholding: the tau-th largest magnitude is found with a
+ * partial selection (std::nth_element) in linear time, instead of sorting v.
  */
 inline void Proximal::ProjectToL0Ball(arma::vec& v, int tau)
 {
-  arma::uvec indices = arma::sort_index(arma::abs(v));
-  arma::uword numberToKill = v.n_elem - tau;
+  arma::uvec support;
+  ProjectToL0Ball(v, tau, support);
+}
+
+/**
+ * Approximate the vector v with a tau-sparse vector, and keep the indices of
+ * its support.  Among entries of equal magnitude the first ones are kept.
+ */
+inline void Proximal::ProjectToL0Ball(arma::vec& v,
+                                      int tau,
+                                      arma::uvec& support)
+{
+  if (tau <= 0)
+  {
+    v.zeros();
+    support.reset();
+    return;
+  }
+
+  // Already tau-sparse.
+  if ((arma::uword) tau >= v.n_elem)
+  {
+    support = arma::find(v);
+    return;
+  }
+
+  std::vector<double> magnitudes(v.n_elem);
+  for (arma::uword j = 0; j < v.n_elem; ++j)
+    magnitudes[j] = std::abs(v[j]);
+
+  std::nth_element(magnitudes.begin(), magnitudes.begin() + (tau - 1),
+      magnitudes.end(), std::greater<double>());
+  const double threshold = magnitudes[tau - 1];
+
+  // The entries above the threshold are kept, and as many entries at the
+  // threshold as needed to keep tau entries.
+  arma::uword ties = tau;
+  for (arma::uword j = 0; j < v.n_elem; ++j)
+  {
+    if (std::abs(v[j]) > threshold)
+      --ties;
+  }
+
+  support.set_size(tau);
+  arma::uword kept = 0;
+  for (arma::uword j = 0; j < v.n_elem; ++j)
+  {
+    const double magnitude = std::abs(v[j]);
+    if (magnitude > threshold || (magnitude == threshold && ties > 0))
+    {
+      if (magnitude == threshold)
+        --ties;
+
+      // Exact zeros are not part of the support.
+      if (magnitude > 0.0)
+        support[kept++] = j;
+    }
+    else
+    {
+      v[j] = 0.0;
+    }
+  }
 
-  for (arma::uword i = 0; i < numberToKill; i++)
-    v(indices(i)) = 0.0;
+  support.resize(kept);
 }
 
 } // namespace ens
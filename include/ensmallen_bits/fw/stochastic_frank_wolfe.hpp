@@ -0,0 +1,215 @@
+/**
+ * @file stochastic_frank_wolfe.hpp
+ * @author Marcus Edel
+ *
+ * Stochastic Frank-Wolfe algorithm for differentiable separable functions,
+ * with growing batches or the SPIDER gradient estimator.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+
+#include "frank_wolfe.hpp"
+
+namespace ens {
+
+/**
+ * Stochastic Frank-Wolfe minimizes a differentiable separable function
+ *
+ * \f[
+ * f(x) = \sum_{i = 0}^{n - 1} f_i(x)
+ * \f]
+ *
+ * over a compact convex set \f$ D \f$ like FrankWolfe, but estimates the
+ * gradient of each iteration from a batch of the separable functions instead
+ * of all of them, with one of two estimators:
+ *
+ *  - If epochLength is 0, the gradient of iteration \f$ k \f$ (from 1) is the
+ *    mean gradient of a batch of \f$ \lceil b k^\alpha \rceil \f$ functions,
+ *    where \f$ b \f$ is batchSize and \f$ \alpha \f$ is batchGrowth (Hazan and
+ *    Luo use \f$ \alpha = 2 \f$ for convex functions); once the batch covers
+ *    all the functions, the full gradient is used.
+ *
+ *  - Otherwise, the SPIDER estimator is used: every epochLength iterations, the
+ *    full gradient \f$ v \f$ is computed, and in between it is corrected with
+ *    the change of the gradient of a batch between the last two iterates,
+ *    \f$ v \leftarrow v + \frac{1}{|B|} \sum_{i \in B} (\nabla f_i(x_k) -
+ *    \nabla f_i(x_{k - 1})) \f$, where the batches grow as above.
+ *
+ * The atoms are given by the linear constrained solver (e.g.
+ * ConstrLpBallSolver or ConstrStructGroupSolver) and the steps by the update
+ * rule, as in FrankWolfe.  Since the objective is never evaluated as a whole,
+ * the update rule must not evaluate the function (e.g. UpdateClassic).  The
+ * batches are taken in order, and the functions are shuffled whenever the next
+ * batch would go past the last function (if shuffle is set).
+ *
+ * The duality gap is only known when the full gradient was computed, so the
+ * tolerance is only checked then.  The objective of the final point is
+ * computed with one pass over the functions.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Hazan2016,
+ *   title     = {Variance-Reduced and Projection-Free Stochastic
+ *                Optimization},
+ *   author    = {Hazan, Elad and Luo, Haipeng},
+ *   booktitle = {Proceedings of the 33rd International Conference on Machine
+ *                Learning (ICML 2016)},
+ *   pages     = {1263--1271},
+ *   year      = {2016}
+ * }
+ *
+ * @inproceedings{Yurtsever2019,
+ *   title     = {Conditional Gradient Methods via Stochastic Path-Integrated
+ *                Differential Estimator},
+ *   author    = {Yurtsever, Alp and Sra, Suvrit and Cevher, Volkan},
+ *   booktitle = {Proceedings of the 36th International Conference on Machine
+ *                Learning (ICML 2019)},
+ *   pages     = {7282--7291},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * StochasticFrankWolfe can optimize differentiable separable functions.  For
+ * more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam LinearConstrSolverType Solver for the linear constrained problem.
+ * @tparam UpdateRuleType Rule to update the solution in each iteration.
+ */
+template<typename LinearConstrSolverType,
+         typename UpdateRuleType = UpdateClassic>
+class StochasticFrankWolfe
+{
+ public:
+  /**
+   * Construct the stochastic Frank-Wolfe optimizer with the given parameters.
+   *
+   * @param linearConstrSolver Solver for linear constrained problem.
+   * @param updateRule Rule for updating solution in each iteration.
+   * @param batchSize Number of functions in the batch of the first iteration.
+   * @param batchGrowth Exponent of the growth of the batches (0 keeps them
+   *     constant).
+   * @param epochLength Number of iterations between two full gradients of the
+   *     SPIDER estimator (0 means the gradient of every iteration is the
+   *     gradient of its batch).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum duality gap to terminate the algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   */
+  StochasticFrankWolfe(const LinearConstrSolverType linearConstrSolver,
+                       const UpdateRuleType updateRule = UpdateRuleType(),
+                       const size_t batchSize = 32,
+                       const double batchGrowth = 1.0,
+                       const size_t epochLength = 0,
+                       const size_t maxIterations = 1000,
+                       const double tolerance = 1e-10,
+                       const bool shuffle = true);
+
+  /**
+   * Optimize the given function using stochastic Frank-Wolfe.  The given
+   * starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to be optimized.
+   * @param function Function to be optimized.
+   * @param iterate Input with starting point, and will be modified to save
+   *     the output optimal solution coordinates.
+   * @return Objective value at the final solution.
+   */
+  template<typename SeparableFunctionType>
+  double Optimize(SeparableFunctionType& function, arma::mat& iterate);
+
+  //! Get the linear constrained solver.
+  const LinearConstrSolverType& LinearConstrSolver()
+      const { return linearConstrSolver; }
+  //! Modify the linear constrained solver.
+  LinearConstrSolverType& LinearConstrSolver() { return linearConstrSolver; }
+
+  //! Get the update rule.
+  const UpdateRuleType& UpdateRule() const { return updateRule; }
+  //! Modify the update rule.
+  UpdateRuleType& UpdateRule() { return updateRule; }
+
+  //! Get the batch size of the first iteration.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size of the first iteration.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the exponent of the growth of the batches.
+  double BatchGrowth() const { return batchGrowth; }
+  //! Modify the exponent of the growth of the batches.
+  double& BatchGrowth() { return batchGrowth; }
+
+  //! Get the number of iterations between two full gradients (0 means the
+  //! SPIDER estimator is not used).
+  size_t EpochLength() const { return epochLength; }
+  //! Modify the number of iterations between two full gradients (0 means the
+  //! SPIDER estimator is not used).
+  size_t& EpochLength() { return epochLength; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! Get the batch size of the given iteration (from 1), at most
+  //! numFunctions.
+  size_t IterationBatchSize(const size_t iteration,
+                            const size_t numFunctions) const;
+
+  //! The solver for constrained linear problem in first step.
+  LinearConstrSolverType linearConstrSolver;
+
+  //! The rule to update, used in the second step.
+  UpdateRuleType updateRule;
+
+  //! The batch size of the first iteration.
+  size_t batchSize;
+
+  //! The exponent of the growth of the batches.
+  double batchGrowth;
+
+  //! The number of iterations between two full gradients.
+  size_t epochLength;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "stochastic_frank_wolfe_impl.hpp"
+
+#endif
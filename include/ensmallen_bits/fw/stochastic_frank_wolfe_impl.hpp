@@ -0,0 +1,174 @@
+/**
+ * @file stochastic_frank_wolfe_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the stochastic Frank-Wolfe algorithm.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "stochastic_frank_wolfe.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename LinearConstrSolverType, typename UpdateRuleType>
+StochasticFrankWolfe<LinearConstrSolverType, UpdateRuleType>::
+StochasticFrankWolfe(const LinearConstrSolverType linearConstrSolver,
+                     const UpdateRuleType updateRule,
+                     const size_t batchSize,
+                     const double batchGrowth,
+                     const size_t epochLength,
+                     const size_t maxIterations,
+                     const double tolerance,
+                     const bool shuffle) :
+    linearConstrSolver(linearConstrSolver),
+    updateRule(updateRule),
+    batchSize(batchSize),
+    batchGrowth(batchGrowth),
+    epochLength(epochLength),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+template<typename LinearConstrSolverType, typename UpdateRuleType>
+size_t StochasticFrankWolfe<LinearConstrSolverType, UpdateRuleType>::
+IterationBatchSize(const size_t iteration, const size_t numFunctions) const
+{
+  const double size = std::ceil(batchSize * std::pow((double) iteration,
+      batchGrowth));
+  if (size >= (double) numFunctions)
+    return numFunctions;
+
+  return std::max((size_t) size, (size_t) 1);
+}
+
+//! Optimize the function (minimize).
+template<typename LinearConstrSolverType, typename UpdateRuleType>
+template<typename SeparableFunctionType>
+double StochasticFrankWolfe<LinearConstrSolverType, UpdateRuleType>::
+Optimize(SeparableFunctionType& function, arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  typedef Function<SeparableFunctionType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Make sure we have all necessary functions.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType>();
+
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("StochasticFrankWolfe::Optimize(): the batch "
+        "size must be positive!");
+  }
+
+  const size_t numFunctions = f.NumFunctions();
+
+  // The estimate of the mean gradient, and the gradients of the batches.
+  arma::mat v(iterate.n_rows, iterate.n_cols);
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat gradient0(iterate.n_rows, iterate.n_cols);
+  arma::mat lastIterate(iterate.n_rows, iterate.n_cols);
+  arma::mat s(iterate.n_rows, iterate.n_cols);
+  arma::mat iterateNew(iterate.n_rows, iterate.n_cols);
+  std::vector<arma::mat> chunkGradients;
+
+  size_t currentFunction = 0;
+  if (shuffle)
+    f.Shuffle();
+
+  bool converged = false;
+  for (size_t i = 1; i != maxIterations; ++i)
+  {
+    const size_t effectiveBatchSize = IterationBatchSize(i, numFunctions);
+
+    // The SPIDER estimator takes the full gradient at the start of each epoch,
+    // and otherwise corrects the last estimate.
+    const bool full = (effectiveBatchSize == numFunctions) ||
+        (epochLength > 0 && (i - 1) % epochLength == 0);
+    if (full)
+    {
+      const double objective = FullEvaluateWithGradient(f, iterate,
+          std::min(batchSize, numFunctions), v, gradient);
+
+      ENS_INFO << "StochasticFrankWolfe::Optimize(): iteration " << i
+          << ", objective " << objective << "." << std::endl;
+    }
+    else
+    {
+      // Take the next batch, and start a new pass over the functions if it
+      // would go past the last one.
+      if (currentFunction + effectiveBatchSize > numFunctions)
+      {
+        currentFunction = 0;
+        if (shuffle)
+          f.Shuffle();
+      }
+
+      if (epochLength > 0)
+      {
+        BatchGradientPair(f, iterate, lastIterate, currentFunction,
+            effectiveBatchSize, gradient, gradient0, chunkGradients);
+        v += (gradient - gradient0) / (double) effectiveBatchSize;
+      }
+      else
+      {
+        f.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+        v = gradient / (double) effectiveBatchSize;
+      }
+
+      currentFunction += effectiveBatchSize;
+    }
+
+    // Solve linear constrained problem, solution saved in s.
+    linearConstrSolver.Optimize(v, s);
+
+    // Check the duality gap of the whole objective, if the gradient is exact.
+    const double gap = numFunctions * std::fabs(arma::dot(iterate - s, v));
+    if (full && gap < tolerance)
+    {
+      ENS_INFO << "StochasticFrankWolfe::Optimize(): minimized within "
+          << "tolerance " << tolerance << "; terminating optimization."
+          << std::endl;
+      converged = true;
+      break;
+    }
+
+    if (epochLength > 0)
+      lastIterate = iterate;
+
+    // Update solution, save in iterateNew.
+    updateRule.Update(f, iterate, s, iterateNew, i);
+    SwapInPlace(iterate, iterateNew);
+  }
+
+  if (!converged)
+  {
+    ENS_INFO << "StochasticFrankWolfe::Optimize(): maximum iterations ("
+        << maxIterations << ") reached; terminating optimization."
+        << std::endl;
+  }
+
+  // Calculate final objective.
+  double objective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    objective += f.Evaluate(iterate, i, effectiveBatchSize);
+  }
+
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file update_away_step.hpp
+ * @author Marcus Edel
+ *
+ * Away-step update method for FrankWolfe algorithm. Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+#define ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+
+#include "active_set.hpp"
+#include "line_search/line_search.hpp"
+
+namespace ens {
+
+/**
+ * Use the away-step rule in the update step for FrankWolfe algorithm.  The
+ * solution is kept as a convex combination of the atoms \f$ v \f$ found so far
+ * (the active set, see ActiveSet).  Besides the classic step towards the atom
+ * \f$ s \f$ given by the linear constrained solver, the rule may move away from
+ * the active atom \f$ v \f$ with the largest inner product with the gradient:
+ * \f[
+ * d = s - x_k \quad \textrm{or} \quad d = x_k - v, \quad
+ * x_{k+1} = x_k + \gamma d,
+ * \f]
+ * whichever direction has the larger inner product with \f$ -\nabla f(x_k) \f$,
+ * with \f$ \gamma \f$ found by line search.  Away steps remove the weight of
+ * bad atoms, so that the iterates do not zig-zag towards a face of the domain;
+ * the algorithm then converges linearly for strongly convex functions over
+ * polytopes.  For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{Lacoste2015,
+ *   title     = {On the Global Linear Convergence of {F}rank-{W}olfe
+ *                Optimization Variants},
+ *   author    = {Lacoste-Julien, Simon and Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {496--504},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * The starting point must be an atom of the domain (for instance a vertex of
+ * the polytope); if the current solution was not produced by this rule, the
+ * active set is restarted from it.
+ */
+class UpdateAwayStep
+{
+ public:
+  /**
+   * Construct the away-step update rule.
+   *
+   * @param maxIterations Max number of iterations in line search.
+   * @param tolerance Tolerance for termination of line search.
+   */
+  UpdateAwayStep(const size_t maxIterations = 100000,
+                 const double tolerance = 1e-5) :
+      maxIterations(maxIterations), tolerance(tolerance)
+  { /* Do nothing. */ }
+
+  /**
+   * Away-step update rule for FrankWolfe.
+   *
+   * @param function function to be optimized.
+   * @param oldCoords previous solution coords.
+   * @param s current linear_constr_solution result.
+   * @param gradient gradient of the function at oldCoords.
+   * @param newCoords output new solution coords.
+   * @param numIter current iteration number, not used here.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              const arma::mat& gradient,
+              arma::mat& newCoords,
+              const size_t /* numIter */)
+  {
+    if (!activeSet.Represents(oldCoords))
+      activeSet.Reset(oldCoords);
+
+    const size_t away = activeSet.Away(gradient);
+    const arma::mat v = activeSet.Atom(away);
+    const double awayWeight = activeSet.Weights()(away);
+
+    // Pick the direction with the largest decrease of the linearized function;
+    // a lone atom leaves no room for an away step.
+    const double forwardGap = arma::dot(gradient, oldCoords - s);
+    const double awayGap = arma::dot(gradient, v - oldCoords);
+
+    LineSearch solver(maxIterations, tolerance);
+    if (forwardGap >= awayGap || awayWeight >= 1.0)
+    {
+      const double gamma = solver.Step(function, oldCoords, s - oldCoords, 1.0);
+      if (gamma == 1.0)
+      {
+        activeSet.Reset(s);
+      }
+      else if (gamma > 0.0)
+      {
+        activeSet.Weights() *= (1.0 - gamma);
+        activeSet.Add(s, gamma);
+      }
+    }
+    else
+    {
+      const double gammaMax = awayWeight / (1.0 - awayWeight);
+      const double gamma = solver.Step(function, oldCoords, oldCoords - v,
+          gammaMax);
+      if (gamma == gammaMax)
+      {
+        // Drop step: the away atom leaves the active set.
+        activeSet.Weights() *= (1.0 + gamma);
+        activeSet.Remove(away);
+      }
+      else if (gamma > 0.0)
+      {
+        activeSet.Weights() *= (1.0 + gamma);
+        activeSet.Weights()(away) -= gamma;
+      }
+    }
+
+    activeSet.RecoverVector(newCoords);
+  }
+
+  /**
+   * Away-step update rule for FrankWolfe, for callers that do not pass the
+   * gradient; it is computed at oldCoords.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              arma::mat& newCoords,
+              const size_t numIter)
+  {
+    arma::mat gradient(oldCoords.n_rows, oldCoords.n_cols);
+    function.Gradient(oldCoords, gradient);
+    Update(function, oldCoords, s, gradient, newCoords, numIter);
+  }
+
+  //! Get the active set.
+  const ActiveSet& CurrentActiveSet() const { return activeSet; }
+  //! Modify the active set.
+  ActiveSet& CurrentActiveSet() { return activeSet; }
+
+  //! Get the maximum number of iterations of the line search.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations of the line search.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance of the line search.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance of the line search.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! The atoms of the current solution and their weights.
+  ActiveSet activeSet;
+
+  //! Max number of iterations of the line search.
+  size_t maxIterations;
+
+  //! Tolerance of the line search.
+  double tolerance;
+};
+
+} // namespace ens
+
+#endif
@@ -52,6 +52,31 @@ class UpdateClassic
     double gamma = 2.0 / (numIter + 2.0);
     newCoords = (1.0 - gamma) * oldCoords + gamma * s;
   }
+
+  /**
+   * Classic update rule for FrankWolfe with a sparse atom s, whose only
+   * non-zero element is s(index) = value.  The coordinates are updated in
+   * place.
+   *
+   * @param function function to be optimized, not used in this update rule.
+   * @param coords solution coords, updated in place.
+   * @param index linear index of the non-zero element of s.
+   * @param value value of the non-zero element of s.
+   * @param numIter current iteration number
+   * @return The step gamma that was taken.
+   */
+  template<typename FunctionType>
+  double SparseUpdate(FunctionType& /* function */,
+                      arma::mat& coords,
+                      const arma::uword index,
+                      const double value,
+                      const size_t numIter)
+  {
+    double gamma = 2.0 / (numIter + 2.0);
+    coords *= (1.0 - gamma);
+    coords[index] += gamma * value;
+    return gamma;
+  }
 };
 
 } // namespace ens
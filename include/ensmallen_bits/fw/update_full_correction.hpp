@@ -29,7 +29,8 @@ namespace ens {
  * smaller than or equal to tau. This constraint optimization problem is solved
  * by projected gradient method. See Atoms.ProjectedEnhancement().
  *
- * Currently only works for function in FuncSq class.
+ * Currently only works for function in FuncSqType class, with a dense or
+ * sparse matrix A.
  *
  */
 class UpdateFullCorrection
@@ -55,21 +56,26 @@ class UpdateFullCorrection
    * @param newCoords new output solution coords.
    * @param numIter current iteration number.
    */
-  void Update(FuncSq& function,
+  template<typename MatType>
+  void Update(FuncSqType<MatType>& function,
               const arma::mat& oldCoords,
               const arma::mat& s,
               arma::mat& newCoords,
               const size_t /* numIter */)
   {
-    // Line search, with explicit solution here.
-    arma::mat v = tau * s - oldCoords;
-    arma::mat b = function.Vectorb();
-    arma::mat A = function.MatrixA();
-    double gamma = arma::dot(b - A * oldCoords, A * v);
-    gamma = gamma / std::pow(arma::norm(A * v, "fro"), 2);
+    const MatType& A = function.MatrixA();
+    const arma::vec& b = function.Vectorb();
+
+    // Line search, with explicit solution here.  The product of A with the new
+    // atom is kept for the atoms.
+    const arma::vec productS = A * s;
+    const arma::vec productOld = A * oldCoords;
+    const arma::vec productV = tau * productS - productOld;
+    double gamma = arma::dot(b - productOld, productV);
+    gamma = gamma / arma::dot(productV, productV);
     gamma = std::min(gamma, 1.0);
     atoms.CurrentCoeffs() = (1.0 - gamma) * atoms.CurrentCoeffs();
-    atoms.AddAtom(s, function, gamma * tau);
+    atoms.AddAtom(s, productS, gamma * tau);
 
     // Projected gradient method for enhancement.
     atoms.ProjectedGradientEnhancement(function, tau, stepSize);
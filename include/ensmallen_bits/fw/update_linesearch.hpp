@@ -25,6 +25,10 @@ namespace ens {
  * x_{k+1} = (1-\gamma) x_k + \gamma s
  * \f]
  *
+ * For a least squares objective that can compute its residual (see
+ * traits::HasResidual, e.g. FuncSq), the exact step is computed in closed form,
+ * and the residual at the new iterate is kept for the next iteration, so that
+ * each step costs a single product with the matrix of the objective.
  */
 class UpdateLineSearch
 {
@@ -62,20 +66,21 @@ class UpdateLineSearch
    * @param s current linear_constr_solution result, the other end point of
    *        line search.
    * @param newCoords output new solution coords.
-   * @param numIter current iteration number, not used here.
+   * @param numIter current iteration number; the cached residual of a least
+   *        squares objective is not reused in the first iteration.
    */
   template<typename FunctionType>
   void Update(FunctionType& function,
               const arma::mat& oldCoords,
               const arma::mat& s,
               arma::mat& newCoords,
-              const size_t /* numIter */)
+              const size_t numIter)
 
   {
     LineSearch solver(maxIterations, tolerance);
 
     newCoords = s;
-    solver.Optimize(function, oldCoords, newCoords);
+    Search(solver, function, oldCoords, newCoords, numIter);
   }
 
   //! Get the tolerance for termination.
@@ -94,6 +99,45 @@ class UpdateLineSearch
 
   //! Max number of iterations.
   size_t maxIterations;
+
+  //! The point of the last step, where the residual was cached.
+  arma::mat residualCoords;
+
+  //! The residual of a least squares objective at residualCoords.
+  arma::vec residual;
+
+  //! Search the line with the secant method.
+  template<typename FunctionType>
+  typename std::enable_if<!traits::HasResidual<FunctionType>::value>::type
+  Search(LineSearch& solver,
+         FunctionType& function,
+         const arma::mat& oldCoords,
+         arma::mat& newCoords,
+         const size_t /* numIter */)
+  {
+    solver.Optimize(function, oldCoords, newCoords);
+  }
+
+  //! Take the exact step of a least squares objective, reusing the residual
+  //! at the end of the last step if it is the start of this one.
+  template<typename FunctionType>
+  typename std::enable_if<traits::HasResidual<FunctionType>::value>::type
+  Search(LineSearch& solver,
+         FunctionType& function,
+         const arma::mat& oldCoords,
+         arma::mat& newCoords,
+         const size_t numIter)
+  {
+    if (numIter <= 1 || residualCoords.n_rows != oldCoords.n_rows ||
+        residualCoords.n_cols != oldCoords.n_cols ||
+        arma::any(arma::vectorise(residualCoords != oldCoords)))
+    {
+      function.Residual(oldCoords, residual);
+    }
+
+    solver.Optimize(function, oldCoords, newCoords, residual);
+    residualCoords = newCoords;
+  }
 };  // class UpdateLineSearch
 
 } // namespace ens
@@ -0,0 +1,146 @@
+/**
+ * @file update_pairwise.hpp
+ * @author Marcus Edel
+ *
+ * Pairwise update method for FrankWolfe algorithm. Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_PAIRWISE_HPP
+#define ENSMALLEN_FW_UPDATE_PAIRWISE_HPP
+
+#include "active_set.hpp"
+#include "line_search/line_search.hpp"
+
+namespace ens {
+
+/**
+ * Use the pairwise rule in the update step for FrankWolfe algorithm.  Like
+ * UpdateAwayStep, the solution is kept as a convex combination of atoms (see
+ * ActiveSet), but each step moves weight directly from the away atom \f$ v \f$
+ * (the active atom with the largest inner product with the gradient) to the
+ * atom \f$ s \f$ given by the linear constrained solver:
+ * \f[
+ * x_{k+1} = x_k + \gamma (s - v), \quad \gamma \in [0, \alpha_v],
+ * \f]
+ * where \f$ \alpha_v \f$ is the weight of \f$ v \f$ and \f$ \gamma \f$ is found
+ * by line search.  For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{Lacoste2015,
+ *   title     = {On the Global Linear Convergence of {F}rank-{W}olfe
+ *                Optimization Variants},
+ *   author    = {Lacoste-Julien, Simon and Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {496--504},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * The starting point must be an atom of the domain (for instance a vertex of
+ * the polytope); if the current solution was not produced by this rule, the
+ * active set is restarted from it.
+ */
+class UpdatePairwise
+{
+ public:
+  /**
+   * Construct the pairwise update rule.
+   *
+   * @param maxIterations Max number of iterations in line search.
+   * @param tolerance Tolerance for termination of line search.
+   */
+  UpdatePairwise(const size_t maxIterations = 100000,
+                 const double tolerance = 1e-5) :
+      maxIterations(maxIterations), tolerance(tolerance)
+  { /* Do nothing. */ }
+
+  /**
+   * Pairwise update rule for FrankWolfe.
+   *
+   * @param function function to be optimized.
+   * @param oldCoords previous solution coords.
+   * @param s current linear_constr_solution result.
+   * @param gradient gradient of the function at oldCoords.
+   * @param newCoords output new solution coords.
+   * @param numIter current iteration number, not used here.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              const arma::mat& gradient,
+              arma::mat& newCoords,
+              const size_t /* numIter */)
+  {
+    if (!activeSet.Represents(oldCoords))
+      activeSet.Reset(oldCoords);
+
+    const size_t away = activeSet.Away(gradient);
+    const double gammaMax = activeSet.Weights()(away);
+
+    LineSearch solver(maxIterations, tolerance);
+    const double gamma = solver.Step(function, oldCoords,
+        s - activeSet.Atom(away), gammaMax);
+
+    if (gamma > 0.0)
+    {
+      // New atoms are appended, so the index of the away atom stays valid.
+      activeSet.Add(s, gamma);
+      if (gamma == gammaMax)
+        activeSet.Remove(away);
+      else
+        activeSet.Weights()(away) -= gamma;
+    }
+
+    activeSet.RecoverVector(newCoords);
+  }
+
+  /**
+   * Pairwise update rule for FrankWolfe, for callers that do not pass the
+   * gradient; it is computed at oldCoords.
+   */
+  template<typename FunctionType>
+  void Update(FunctionType& function,
+              const arma::mat& oldCoords,
+              const arma::mat& s,
+              arma::mat& newCoords,
+              const size_t numIter)
+  {
+    arma::mat gradient(oldCoords.n_rows, oldCoords.n_cols);
+    function.Gradient(oldCoords, gradient);
+    Update(function, oldCoords, s, gradient, newCoords, numIter);
+  }
+
+  //! Get the active set.
+  const ActiveSet& CurrentActiveSet() const { return activeSet; }
+  //! Modify the active set.
+  ActiveSet& CurrentActiveSet() { return activeSet; }
+
+  //! Get the maximum number of iterations of the line search.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations of the line search.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance of the line search.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance of the line search.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! The atoms of the current solution and their weights.
+  ActiveSet activeSet;
+
+  //! Max number of iterations of the line search.
+  size_t maxIterations;
+
+  //! Tolerance of the line search.
+  double tolerance;
+};
+
+} // namespace ens
+
+#endif
@@ -22,7 +22,8 @@ namespace ens {
  * Recalculate the optimal solution in the span of all previous solution space,
  * used as update step for FrankWolfe algorithm.
  *
- * Currently only works for function in FuncSq class.
+ * Currently only works for function in FuncSqType class, with a dense or
+ * sparse matrix A.
  */
 class UpdateSpan
 {
@@ -45,7 +46,8 @@ class UpdateSpan
    * @param newCoords output new solution coords.
    * @param numIter current iteration number.
    */
-  void Update(FuncSq& function,
+  template<typename MatType>
+  void Update(FuncSqType<MatType>& function,
               const arma::mat& oldCoords,
               const arma::mat& s,
               arma::mat& newCoords,
@@ -55,8 +57,8 @@ class UpdateSpan
     atoms.AddAtom(s, function);
 
     // Reoptimize the solution in the current space.
-    arma::vec b = function.Vectorb();
-    atoms.CurrentCoeffs() = solve(function.MatrixA() * atoms.CurrentAtoms(), b);
+    atoms.CurrentCoeffs() = solve(atoms.CurrentAtomProducts(),
+        function.Vectorb());
 
     // x has coords of only the current atoms, recover the solution
     // to the original size.
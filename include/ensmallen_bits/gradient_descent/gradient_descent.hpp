@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_HPP
 #define ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_HPP
 
+#include <ensmallen_bits/svrg/barzilai_borwein_decay.hpp>
+
 namespace ens {
 
 /**
@@ -36,6 +38,35 @@ namespace ens {
  * The parameter \f$\epsilon\f$ is specified by the tolerance parameter to the
  * constructor.
  *
+ * Three options reduce the number of evaluations on ill-conditioned problems,
+ * where every evaluation is a pass over the data:
+ *
+ *  - accelerate: Nesterov's accelerated gradient (as in FISTA), where the
+ *    gradient is taken at an extrapolation of the last two iterates; the
+ *    momentum is restarted whenever the step points uphill (gradient restart,
+ *    O'Donoghue and Candes, 2015).
+ *  - barzilaiBorwein: the step size of each iteration is the Barzilai-Borwein
+ *    step s's / s'y of the last two points (see BarzilaiBorweinDecay), instead
+ *    of the constant stepSize; stepSize is the first step.
+ *  - backtracking: the step is reduced until it satisfies the Armijo condition
+ *    f(x - a g) <= f(x) - c a ||g||^2 (with c at least 1/2 if accelerate is
+ *    true, as in FISTA).  Without barzilaiBorwein, the reduced step is kept
+ *    for the next iterations.
+ *
+ * For more information on acceleration with restarts, see the following.
+ *
+ * @code
+ * @article{ODonoghue2015,
+ *   title   = {Adaptive Restart for Accelerated Gradient Schemes},
+ *   author  = {O'Donoghue, Brendan and Cand\`{e}s, Emmanuel},
+ *   journal = {Foundations of Computational Mathematics},
+ *   volume  = {15},
+ *   number  = {3},
+ *   pages   = {715--732},
+ *   year    = {2015}
+ * }
+ * @endcode
+ *
  * GradientDescent can optimize differentiable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -54,15 +85,29 @@ class GradientDescent
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param accelerate If true, use Nesterov's accelerated gradient with
+   *     gradient restarts.
+   * @param barzilaiBorwein If true, use the Barzilai-Borwein step size.
+   * @param backtracking If true, reduce the step until it satisfies the Armijo
+   *     condition.
+   * @param armijoConstant Constant c of the Armijo condition.
+   * @param backtrackingFactor Factor the step is reduced by on each failure of
+   *     the Armijo condition.
    */
   GradientDescent(const double stepSize = 0.01,
                   const size_t maxIterations = 100000,
-                  const double tolerance = 1e-5);
+                  const double tolerance = 1e-5,
+                  const bool accelerate = false,
+                  const bool barzilaiBorwein = false,
+                  const bool backtracking = false,
+                  const double armijoConstant = 1e-4,
+                  const double backtrackingFactor = 0.5);
 
   /**
    * Optimize the given function using gradient descent.  The given starting
    * point will be modified to store the finishing point of the algorithm, and
-   * the final objective value is returned.
+   * the final objective value is returned.  To run the optimization a few
+   * iterations at a time, use a GradientDescentStepper.
    *
    * @tparam FunctionType Type of the function to optimize.
    * @param function Function to optimize.
@@ -72,6 +117,30 @@ class GradientDescent
   template<typename FunctionType>
   double Optimize(FunctionType& function, arma::mat& iterate);
 
+  /**
+   * Optimize the given function, starting at the given fixed-size point; see
+   * above.  The gradient and the other buffers of the optimization are
+   * fixed-size matrices of the same size, so they are stored in the objects
+   * themselves instead of on the heap, and their sizes are known at compile
+   * time.  This is for small problems (e.g. with 2 or 6 coordinates) that are
+   * solved many times, where the allocations would dominate.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam Rows Number of rows of the iterate.
+   * @tparam Cols Number of columns of the iterate.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, arma::uword Rows, arma::uword Cols>
+  double Optimize(FunctionType& function,
+                  arma::mat::fixed<Rows, Cols>& iterate);
+
+  //! Optimize the given function, starting at the given fixed-size column
+  //! vector; see above.
+  template<typename FunctionType, arma::uword Rows>
+  double Optimize(FunctionType& function, arma::vec::fixed<Rows>& iterate);
+
   /**
    * Assert all dimensions are numeric and optimize the given function using
    * gradient descent. The given starting point will be modified to store the
@@ -111,7 +180,48 @@ class GradientDescent
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether Nesterov's accelerated gradient is used.
+  bool Accelerate() const { return accelerate; }
+  //! Modify whether Nesterov's accelerated gradient is used.
+  bool& Accelerate() { return accelerate; }
+
+  //! Get whether the Barzilai-Borwein step size is used.
+  bool BarzilaiBorwein() const { return barzilaiBorwein; }
+  //! Modify whether the Barzilai-Borwein step size is used.
+  bool& BarzilaiBorwein() { return barzilaiBorwein; }
+
+  //! Get whether the step is reduced until the Armijo condition holds.
+  bool Backtracking() const { return backtracking; }
+  //! Modify whether the step is reduced until the Armijo condition holds.
+  bool& Backtracking() { return backtracking; }
+
+  //! Get the constant of the Armijo condition.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the constant of the Armijo condition.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the factor the step is reduced by when backtracking.
+  double BacktrackingFactor() const { return backtrackingFactor; }
+  //! Modify the factor the step is reduced by when backtracking.
+  double& BacktrackingFactor() { return backtrackingFactor; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  /**
+   * Optimize the given function, with buffers of the given matrix type, which
+   * has the size of the iterate.
+   *
+   * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix).
+   * @tparam FunctionType Type of the function to optimize.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename MatType, typename FunctionType>
+  double OptimizeImpl(FunctionType& function, arma::mat& iterate);
+
   //! The step size for each example.
   double stepSize;
 
@@ -120,10 +230,29 @@ class GradientDescent
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! Whether Nesterov's accelerated gradient is used.
+  bool accelerate;
+
+  //! Whether the Barzilai-Borwein step size is used.
+  bool barzilaiBorwein;
+
+  //! Whether the step is reduced until the Armijo condition holds.
+  bool backtracking;
+
+  //! The constant of the Armijo condition.
+  double armijoConstant;
+
+  //! The factor the step is reduced by when backtracking.
+  double backtrackingFactor;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
 
+#include "gradient_descent_stepper.hpp"
 #include "gradient_descent_impl.hpp"
 
 #endif
@@ -23,10 +23,20 @@ namespace ens {
 inline GradientDescent::GradientDescent(
     const double stepSize,
     const size_t maxIterations,
-    const double tolerance) :
+    const double tolerance,
+    const bool accelerate,
+    const bool barzilaiBorwein,
+    const bool backtracking,
+    const double armijoConstant,
+    const double backtrackingFactor) :
     stepSize(stepSize),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    accelerate(accelerate),
+    barzilaiBorwein(barzilaiBorwein),
+    backtracking(backtracking),
+    armijoConstant(armijoConstant),
+    backtrackingFactor(backtrackingFactor)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -34,52 +44,36 @@ template<typename FunctionType>
 double GradientDescent::Optimize(
     FunctionType& function, arma::mat& iterate)
 {
-  // Use the Function<> wrapper type to provide additional functionality.
-  typedef Function<FunctionType> FullFunctionType;
-  FullFunctionType& f(static_cast<FullFunctionType&>(function));
-
-  // Make sure we have the methods that we need.
-  traits::CheckFunctionTypeAPI<FullFunctionType>();
-
-  // To keep track of where we are and how things are going.
-  double overallObjective = std::numeric_limits<double>::max();
-  double lastObjective = std::numeric_limits<double>::max();
-
-  // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
-  for (size_t i = 1; i != maxIterations; ++i)
-  {
-    overallObjective = f.EvaluateWithGradient(iterate, gradient);
-
-    // Output current objective function.
-    Info << "Gradient Descent: iteration " << i << ", objective "
-        << overallObjective << "." << std::endl;
-
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
-    {
-      Warn << "Gradient Descent: converged to " << overallObjective
-          << "; terminating" << " with failure.  Try a smaller step size?"
-          << std::endl;
-      return overallObjective;
-    }
+  return OptimizeImpl<arma::mat>(function, iterate);
+}
 
-    if (std::abs(lastObjective - overallObjective) < tolerance)
-    {
-      Info << "Gradient Descent: minimized within tolerance "
-          << tolerance << "; " << "terminating optimization." << std::endl;
-      return overallObjective;
-    }
+//! Optimize the function (minimize), with fixed-size buffers.
+template<typename FunctionType, arma::uword Rows, arma::uword Cols>
+double GradientDescent::Optimize(
+    FunctionType& function, arma::mat::fixed<Rows, Cols>& iterate)
+{
+  return OptimizeImpl<arma::mat::fixed<Rows, Cols>>(function, iterate);
+}
 
-    // Reset the counter variables.
-    lastObjective = overallObjective;
+//! Optimize the function (minimize), with fixed-size buffers.
+template<typename FunctionType, arma::uword Rows>
+double GradientDescent::Optimize(
+    FunctionType& function, arma::vec::fixed<Rows>& iterate)
+{
+  return OptimizeImpl<arma::vec::fixed<Rows>>(function, iterate);
+}
 
-    // And update the iterate.
-    iterate -= stepSize * gradient;
-  }
+template<typename MatType, typename FunctionType>
+double GradientDescent::OptimizeImpl(
+    FunctionType& function, arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
 
-  Info << "Gradient Descent: maximum iterations (" << maxIterations
-      << ") reached; " << "terminating optimization." << std::endl;
-  return overallObjective;
+  // The optimization is a single call to Step() that runs until termination.
+  GradientDescentStepper<FunctionType, MatType> stepper(*this, function,
+      iterate);
+  stepper.Step(std::numeric_limits<size_t>::max());
+  return stepper.Result();
 }
 
 template<typename FunctionType>
@@ -0,0 +1,154 @@
+/**
+ * @file gradient_descent_stepper.hpp
+ * @author Marcus Edel
+ *
+ * A gradient descent optimization that is run a few iterations at a time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_STEPPER_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_STEPPER_HPP
+
+#include "gradient_descent.hpp"
+
+namespace ens {
+
+/**
+ * A gradient descent optimization of the given function from the given
+ * iterate, which is advanced by calls to Step() instead of running to
+ * completion, so that a scheduler can interleave many optimizations on a few
+ * threads, and give more iterations to the promising ones.  Each call to
+ * Step(n) takes at most n iterations, and the optimization stops on the same
+ * conditions and with the same iterates as GradientDescent::Optimize(), which
+ * is itself a single call to Step().
+ *
+ * The stepper works on its own copy of the optimizer, so one configured
+ * optimizer can start many steppers.  It refers to the function and the
+ * iterate, which must outlive it; the iterate holds the current point between
+ * the calls to Step().
+ *
+ * @code
+ * GradientDescent optimizer(0.01, 0, 1e-10);
+ * GradientDescentStepper<RosenbrockFunction> stepper(optimizer, f,
+ *     coordinates);
+ * while (stepper.Step(10))
+ * {
+ *   // Do something else between every 10 iterations.
+ * }
+ * const double objective = stepper.Result();
+ * @endcode
+ *
+ * @tparam FunctionType Type of the function to optimize.
+ * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix of the
+ *     size of the iterate).
+ */
+template<typename FunctionType, typename MatType = arma::mat>
+class GradientDescentStepper
+{
+ public:
+  /**
+   * Start the optimization of the given function from the given iterate; no
+   * evaluation is done until the first call to Step().
+   *
+   * @param optimizer Optimizer with the parameters of the optimization.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified by Step()).
+   */
+  GradientDescentStepper(const GradientDescent& optimizer,
+                         FunctionType& function,
+                         arma::mat& iterate);
+
+  /**
+   * Take at most the given number of iterations, and return whether the
+   * optimization can go on (i.e. !Done()).
+   *
+   * @param steps Maximum number of iterations to take.
+   */
+  bool Step(const size_t steps = 1);
+
+  //! Get whether the optimization has terminated.
+  bool Done() const { return done; }
+
+  //! Get the number of iterations taken so far.
+  size_t Steps() const { return iteration - 1; }
+
+  //! Get the objective at the last evaluated point (DBL_MAX before the first
+  //! step).
+  double Objective() const { return overallObjective; }
+
+  //! Get the objective returned by Optimize(); before Done(), it is the
+  //! objective at the last evaluated point.
+  double Result() const { return overallObjective; }
+
+  //! Get the current point.
+  const arma::mat& Iterate() const { return iterate; }
+
+  //! Get the optimizer.
+  const GradientDescent& Optimizer() const { return optimizer; }
+
+ private:
+  //! Take one iteration, or terminate.
+  void TakeStep();
+
+  //! The optimizer with the parameters of the optimization.
+  GradientDescent optimizer;
+  //! The function to optimize.
+  Function<FunctionType>& function;
+  //! The current point.
+  arma::mat& iterate;
+
+  //! The number of the next iteration (from 1).
+  size_t iteration;
+  //! Whether the optimization has terminated.
+  bool done;
+  //! The objective at the last evaluated point.
+  double overallObjective;
+  //! The objective at the point before.
+  double lastObjective;
+
+  //! The extrapolated point, with acceleration.
+  MatType extrapolated;
+  //! The momentum of the extrapolation.
+  double momentum;
+
+  //! The candidate of the line search.
+  MatType candidate;
+  //! The gradient at the candidate, if it was evaluated with it.
+  MatType candidateGradient;
+  //! The objective at the candidate.
+  double candidateObjective;
+  //! Whether the gradient of the next point was computed by the line search.
+  bool evaluated;
+
+  //! The step of the next iteration.
+  double step;
+  //! The Barzilai-Borwein steps.
+  BarzilaiBorweinDecay bbDecay;
+  //! The last point, for the Barzilai-Borwein steps.
+  MatType lastPoint;
+  //! The gradient at the current point.
+  MatType gradient;
+};
+
+/**
+ * Start a step-wise gradient descent optimization of the given function from
+ * the given iterate; see GradientDescentStepper.
+ */
+template<typename FunctionType>
+GradientDescentStepper<FunctionType> MakeStepper(
+    const GradientDescent& optimizer,
+    FunctionType& function,
+    arma::mat& iterate)
+{
+  return GradientDescentStepper<FunctionType>(optimizer, function, iterate);
+}
+
+} // namespace ens
+
+// Include implementation.
+#include "gradient_descent_stepper_impl.hpp"
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file gradient_descent_stepper_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the step-wise gradient descent optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_STEPPER_IMPL_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_STEPPER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "gradient_descent_stepper.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename FunctionType, typename MatType>
+GradientDescentStepper<FunctionType, MatType>::GradientDescentStepper(
+    const GradientDescent& optimizer,
+    FunctionType& function,
+    arma::mat& iterate) :
+    optimizer(optimizer),
+    function(static_cast<Function<FunctionType>&>(function)),
+    iterate(iterate),
+    iteration(1),
+    done(false),
+    overallObjective(std::numeric_limits<double>::max()),
+    lastObjective(std::numeric_limits<double>::max()),
+    momentum(1.0),
+    candidateObjective(0.0),
+    evaluated(false),
+    step(optimizer.StepSize()),
+    // The Barzilai-Borwein steps are taken without the eps of SVRG, which
+    // would dominate the curvature once the steps are small.
+    bbDecay(DBL_MAX, 0.0)
+{
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<Function<FunctionType>>();
+
+  // With acceleration, the gradient is taken at the extrapolated point, and
+  // iterate holds the last point reached by a step.
+  if (optimizer.Accelerate())
+    extrapolated = iterate;
+
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
+}
+
+template<typename FunctionType, typename MatType>
+bool GradientDescentStepper<FunctionType, MatType>::Step(const size_t steps)
+{
+  for (size_t k = 0; k < steps && !done; ++k)
+    TakeStep();
+
+  return !done;
+}
+
+template<typename FunctionType, typename MatType>
+void GradientDescentStepper<FunctionType, MatType>::TakeStep()
+{
+  if (iteration == optimizer.MaxIterations())
+  {
+    ENS_INFO << "Gradient Descent: maximum iterations ("
+        << optimizer.MaxIterations() << ") reached; "
+        << "terminating optimization." << std::endl;
+    done = true;
+    return;
+  }
+
+  const bool accelerate = optimizer.Accelerate();
+  const bool backtracking = optimizer.Backtracking();
+  arma::mat& point = accelerate ? extrapolated : iterate;
+
+  // The accepted candidate of a line search becomes the next point, so its
+  // gradient is computed with its objective, unless the next point is an
+  // extrapolation.
+  const bool fusedSearch = backtracking && !accelerate;
+
+  if (!evaluated)
+    overallObjective = function.EvaluateWithGradient(point, gradient);
+  evaluated = false;
+
+  // Output current objective function.
+  ENS_INFO << "Gradient Descent: iteration " << iteration << ", objective "
+      << overallObjective << "." << std::endl;
+
+  if (std::isnan(overallObjective) || std::isinf(overallObjective))
+  {
+    ENS_WARN << "Gradient Descent: converged to " << overallObjective
+        << "; terminating" << " with failure.  Try a smaller step size?"
+        << std::endl;
+    if (accelerate)
+      iterate = extrapolated;
+    done = true;
+    return;
+  }
+
+  if (std::abs(lastObjective - overallObjective) < optimizer.Tolerance())
+  {
+    ENS_INFO << "Gradient Descent: minimized within tolerance "
+        << optimizer.Tolerance() << "; " << "terminating optimization."
+        << std::endl;
+    if (accelerate)
+      iterate = extrapolated;
+    done = true;
+    return;
+  }
+
+  // Reset the counter variables.
+  lastObjective = overallObjective;
+  ++iteration;
+
+  // The Barzilai-Borwein step of the last two points; the first call only
+  // stores the gradient.  A step that is not positive (the function is not
+  // convex between the points) is replaced by the initial step size.
+  if (optimizer.BarzilaiBorwein())
+  {
+    bbDecay.Update(point, lastPoint, gradient, gradient, 1, step);
+    if (!(step > 0.0) || std::isinf(step))
+      step = optimizer.StepSize();
+    lastPoint = point;
+  }
+
+  if (!accelerate && !backtracking)
+  {
+    // And update the iterate.
+    iterate -= step * gradient;
+    return;
+  }
+
+  candidate = point - step * gradient;
+  if (backtracking)
+  {
+    // Reduce the step until the Armijo condition holds, at most 50 times.
+    // The accelerated steps need the stricter condition of FISTA, with a
+    // constant of at least 1/2.
+    const double sufficientDecrease = (accelerate ?
+        std::max(optimizer.ArmijoConstant(), 0.5) :
+        optimizer.ArmijoConstant()) * arma::dot(gradient, gradient);
+    for (size_t k = 0; k < 50; ++k)
+    {
+      candidateObjective = fusedSearch ?
+          function.EvaluateWithGradient(candidate, candidateGradient) :
+          function.Evaluate(candidate);
+      if (candidateObjective <= overallObjective - step * sufficientDecrease)
+      {
+        evaluated = fusedSearch;
+        break;
+      }
+
+      step *= optimizer.BacktrackingFactor();
+      candidate = point - step * gradient;
+    }
+  }
+
+  if (accelerate)
+  {
+    // Restart the momentum if it takes the iterate uphill; otherwise,
+    // extrapolate along the last step.
+    if (arma::dot(gradient, candidate - iterate) > 0.0)
+    {
+      momentum = 1.0;
+      extrapolated = candidate;
+    }
+    else
+    {
+      const double nextMomentum = (1.0 + std::sqrt(1.0 + 4.0 * momentum *
+          momentum)) / 2.0;
+      extrapolated = candidate + ((momentum - 1.0) / nextMomentum) *
+          (candidate - iterate);
+      momentum = nextMomentum;
+    }
+  }
+
+  SwapInPlace(iterate, candidate);
+  if (evaluated)
+  {
+    overallObjective = candidateObjective;
+    gradient.swap(candidateGradient);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_GRID_SEARCH_GRID_SEARCH_HPP
 #define ENSMALLEN_GRID_SEARCH_GRID_SEARCH_HPP
 
+#include <atomic>
+
 namespace ens {
 
 /**
@@ -21,10 +23,32 @@ namespace ens {
  * GridSearch can optimize categorical functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * The points of the grid are visited in lexicographic order (the last
+ * dimension varies fastest).  They can be evaluated by several OpenMP threads,
+ * and the search can be stopped after a given number of evaluations or as soon
+ * as a point reaches a target objective value.
  */
 class GridSearch
 {
  public:
+  /**
+   * Construct the GridSearch optimizer.  By default every point of the grid is
+   * evaluated, one at a time.
+   *
+   * @param parallelEvaluation If true, the points of the grid are evaluated by
+   *     several OpenMP threads; Evaluate() must then be safe to call
+   *     concurrently.  This has no effect if the function has an
+   *     EvaluateBatch() method.
+   * @param maxEvaluations Maximum number of points to evaluate; only the first
+   *     maxEvaluations points of the grid are evaluated (0 means no limit).
+   * @param targetObjective Stop as soon as a point with an objective value less
+   *     than or equal to targetObjective is found.
+   */
+  GridSearch(const bool parallelEvaluation = false,
+             const size_t maxEvaluations = 0,
+             const double targetObjective = -DBL_MAX);
+
   /**
    * Optimize (minimize) the given function by iterating through the all
    * possible combinations of values for the parameters specified in
@@ -44,23 +68,61 @@ class GridSearch
       const std::vector<bool>& categoricalDimensions,
       const arma::Row<size_t>& numCategories);
 
+  //! Get whether the points are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether the points are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the maximum number of evaluations (0 means no limit).
+  size_t MaxEvaluations() const { return maxEvaluations; }
+  //! Modify the maximum number of evaluations (0 means no limit).
+  size_t& MaxEvaluations() { return maxEvaluations; }
+
+  //! Get the target objective value.
+  double TargetObjective() const { return targetObjective; }
+  //! Modify the target objective value.
+  double& TargetObjective() { return targetObjective; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   /**
-   * Iterate through the last (parameterValueCollections.size() - i) dimensions
-   * of the grid and change the arguments bestObjective and bestParameters if
-   * there is something better. The values for the first i dimensions
-   * (parameters) are specified in the first i rows of the currentParameters
-   * argument.
+   * Store the coordinates of the point with the given index in the grid into
+   * the given vector.
+   */
+  static void Point(size_t index,
+                    const arma::Row<size_t>& numCategories,
+                    arma::vec& point);
+
+  /**
+   * Evaluate the points chunk, chunk + numChunks, chunk + 2 * numChunks, ...
+   * of the first numPoints points of the grid, and store the best objective
+   * and the index of its point in bestObjective and bestIndex.  Points with an
+   * index not less than stopIndex are skipped; if a point reaches the target,
+   * stopIndex is lowered to its index.
    */
   template<typename FunctionType>
-  void Optimize(
-      FunctionType& function,
-      double& bestObjective,
-      arma::mat& bestParameters,
-      arma::vec& currentParameters,
-      const std::vector<bool>& categoricalDimensions,
-      const arma::Row<size_t>& numCategories,
-      size_t i);
+  void EvaluateChunk(FunctionType& function,
+                     const arma::Row<size_t>& numCategories,
+                     const size_t numPoints,
+                     const size_t chunk,
+                     const size_t numChunks,
+                     std::atomic<size_t>& stopIndex,
+                     double& bestObjective,
+                     size_t& bestIndex) const;
+
+  //! Whether the points are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! The maximum number of evaluations (0 means no limit).
+  size_t maxEvaluations;
+
+  //! The target objective value.
+  double targetObjective;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
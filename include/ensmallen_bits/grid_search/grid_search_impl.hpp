@@ -17,6 +17,14 @@
 
 namespace ens {
 
+inline GridSearch::GridSearch(const bool parallelEvaluation,
+                              const size_t maxEvaluations,
+                              const double targetObjective) :
+    parallelEvaluation(parallelEvaluation),
+    maxEvaluations(maxEvaluations),
+    targetObjective(targetObjective)
+{ /* Nothing to do. */ }
+
 template<typename FunctionType>
 double GridSearch::Optimize(
     FunctionType& function,
@@ -24,6 +32,11 @@ double GridSearch::Optimize(
     const std::vector<bool>& categoricalDimensions,
     const arma::Row<size_t>& numCategories)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Make sure we have the methods that we need.
+  traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
+
   for (size_t i = 0; i < categoricalDimensions.size(); ++i)
   {
     if (!categoricalDimensions[i])
@@ -35,51 +48,194 @@ double GridSearch::Optimize(
     }
   }
 
-  double bestObjective = std::numeric_limits<double>::max();
-  bestParameters = arma::mat(categoricalDimensions.size(), 1);
-  arma::vec currentParameters = arma::vec(categoricalDimensions.size());
+  // Find the number of points of the grid.
+  const size_t numDimensions = categoricalDimensions.size();
+  size_t numPoints = 1;
+  for (size_t i = 0; i < numDimensions; ++i)
+  {
+    if (numCategories(i) != 0 &&
+        numPoints > std::numeric_limits<size_t>::max() / numCategories(i))
+    {
+      throw std::invalid_argument("GridSearch::Optimize(): the grid has too "
+          "many points");
+    }
+    numPoints *= numCategories(i);
+  }
+
+  if (maxEvaluations != 0 && maxEvaluations < numPoints)
+  {
+    ENS_INFO << "GridSearch::Optimize(): evaluating the first "
+        << maxEvaluations << " of " << numPoints << " points." << std::endl;
+    numPoints = maxEvaluations;
+  }
 
   /* Initialize best parameters for the case (very unlikely though) when no set
    * of parameters gives an objective value better than
    * std::numeric_limits<double>::max() */
-  for (size_t i = 0; i < categoricalDimensions.size(); ++i)
-    bestParameters(i, 0) = 0;
+  double bestObjective = std::numeric_limits<double>::max();
+  bestParameters.zeros(numDimensions, 1);
+  if (numPoints == 0)
+    return bestObjective;
 
-  Optimize(function, bestObjective, bestParameters, currentParameters,
-      categoricalDimensions, numCategories, 0);
+  // The index of the first point that reaches the target, if any.
+  std::atomic<size_t> stopIndex(numPoints);
+  size_t bestIndex = numPoints;
 
-  return bestObjective;
-}
+  if (numDimensions > 0 && traits::HasBatchEvaluation<FunctionType>::value)
+  {
+    // Evaluate all the values of the last dimension at once.
+    const size_t last = numDimensions - 1;
+    arma::cube candidates;
+    arma::vec point, objectives;
+    for (size_t begin = 0; begin < stopIndex; begin += numCategories(last))
+    {
+      const size_t count = std::min((size_t) numCategories(last),
+          numPoints - begin);
+      candidates.set_size(numDimensions, 1, count);
+      Point(begin, numCategories, point);
+      for (size_t j = 0; j < count; ++j)
+      {
+        candidates.slice(j) = point;
+        candidates.slice(j)(last) = j;
+      }
 
-template<typename FunctionType>
-void GridSearch::Optimize(
-    FunctionType& function,
-    double& bestObjective,
-    arma::mat& bestParameters,
-    arma::vec& currentParameters,
-    const std::vector<bool>& categoricalDimensions,
-    const arma::Row<size_t>& numCategories,
-    size_t i)
-{
-  // Make sure we have the methods that we need.
-  traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
+      TryEvaluateBatch(function, candidates, objectives);
+      for (size_t j = 0; j < count; ++j)
+      {
+        if (objectives(j) < bestObjective)
+        {
+          bestObjective = objectives(j);
+          bestIndex = begin + j;
+        }
 
-  if (i < categoricalDimensions.size())
+        if (objectives(j) <= targetObjective)
+        {
+          stopIndex = begin + j;
+          break;
+        }
+      }
+    }
+  }
+  else
   {
-    for (size_t j = 0; j < numCategories(i); ++j)
+    #ifdef ENS_USE_OPENMP
+      const size_t numChunks = parallelEvaluation ? std::min(
+          (size_t) omp_get_max_threads(), numPoints) : 1;
+    #else
+      const size_t numChunks = 1;
+    #endif
+
+    // Every chunk keeps its own best point, so the threads only share the
+    // index to stop at.
+    std::vector<double> objectives(numChunks,
+        std::numeric_limits<double>::max());
+    std::vector<size_t> indices(numChunks, numPoints);
+
+    if (numChunks == 1)
+    {
+      EvaluateChunk(function, numCategories, numPoints, 0, 1, stopIndex,
+          objectives[0], indices[0]);
+    }
+    else
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        // The team may be smaller than requested, so each thread takes every
+        // numThreads'th chunk.
+        for (size_t c = threadId; c < numChunks; c += numThreads)
+        {
+          EvaluateChunk(function, numCategories, numPoints, c, numChunks,
+              stopIndex, objectives[c], indices[c]);
+        }
+      }
+    }
+
+    // Take the point that reached the target first; the points after it may
+    // or may not have been evaluated.  Otherwise take the first point with
+    // the smallest objective, as a sequential search would.
+    for (size_t c = 0; c < numChunks; ++c)
     {
-      currentParameters(i) = j;
-      Optimize(function, bestObjective, bestParameters, currentParameters,
-          categoricalDimensions, numCategories, i + 1);
+      if (indices[c] == numPoints)
+        continue;
+
+      if ((stopIndex < numPoints && indices[c] == stopIndex) ||
+          (stopIndex == numPoints && (objectives[c] < bestObjective ||
+          (objectives[c] == bestObjective && indices[c] < bestIndex))))
+      {
+        bestObjective = objectives[c];
+        bestIndex = indices[c];
+      }
     }
   }
-  else
+
+  if (stopIndex < numPoints)
+  {
+    ENS_INFO << "GridSearch::Optimize(): objective " << bestObjective
+        << " reached the target " << targetObjective << " after "
+        << (stopIndex + 1) << " points; terminating optimization."
+        << std::endl;
+  }
+
+  if (bestIndex < numPoints)
+  {
+    arma::vec point;
+    Point(bestIndex, numCategories, point);
+    bestParameters = point;
+  }
+
+  return bestObjective;
+}
+
+inline void GridSearch::Point(size_t index,
+                              const arma::Row<size_t>& numCategories,
+                              arma::vec& point)
+{
+  point.set_size(numCategories.n_elem);
+  for (size_t i = numCategories.n_elem; i > 0; --i)
   {
-    double objective = function.Evaluate(currentParameters);
+    point(i - 1) = index % numCategories(i - 1);
+    index /= numCategories(i - 1);
+  }
+}
+
+template<typename FunctionType>
+void GridSearch::EvaluateChunk(FunctionType& function,
+                               const arma::Row<size_t>& numCategories,
+                               const size_t numPoints,
+                               const size_t chunk,
+                               const size_t numChunks,
+                               std::atomic<size_t>& stopIndex,
+                               double& bestObjective,
+                               size_t& bestIndex) const
+{
+  arma::vec point;
+  for (size_t p = chunk; p < numPoints; p += numChunks)
+  {
+    if (p >= stopIndex.load(std::memory_order_relaxed))
+      break;
+
+    Point(p, numCategories, point);
+    const double objective = function.Evaluate(point);
     if (objective < bestObjective)
     {
       bestObjective = objective;
-      bestParameters = currentParameters;
+      bestIndex = p;
+    }
+
+    if (objective <= targetObjective)
+    {
+      // Lower the index to stop at, unless another chunk has already found an
+      // earlier point.
+      size_t current = stopIndex.load();
+      while (p < current && !stopIndex.compare_exchange_weak(current, p)) { }
+      break;
     }
   }
 }
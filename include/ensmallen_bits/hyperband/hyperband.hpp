@@ -0,0 +1,190 @@
+/**
+ * @file hyperband.hpp
+ * @author Marcus Edel
+ *
+ * Hyperband, which runs successive halving over random points of a grid with
+ * several trade-offs between the number of points and their budget.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_HYPERBAND_HYPERBAND_HPP
+#define ENSMALLEN_HYPERBAND_HYPERBAND_HPP
+
+#include <ensmallen_bits/executors/executors.hpp>
+
+namespace ens {
+
+/**
+ * Hyperband finds the minimum of a function of categorical parameters (the
+ * same grid as GridSearch) that can be evaluated at several fidelities: a
+ * cheap, noisy evaluation with a small budget (e.g. a model trained for a few
+ * epochs, or on a fraction of the data), up to the full evaluation with the
+ * largest budget, MaxResource().  Most of the points are only evaluated with a
+ * small budget, so the search takes a small fraction of the compute of a grid
+ * search.
+ *
+ * Successive halving evaluates n random points of the grid with a budget r,
+ * keeps the best 1 / eta of them, evaluates those with a budget eta * r, and so
+ * on, until the last points are evaluated with MaxResource().  How many points
+ * to start with is a trade-off: many points with a small budget find good
+ * points when the cheap evaluations rank the points well, few points with a
+ * large budget when they do not.  Hyperband runs successive halving once for
+ * each trade-off (bracket), from the most aggressive one, which starts with
+ * the smallest budget MaxResource() / eta^s, to plain random search at full
+ * budget, with about the same total budget for each.  With NumBrackets() = 1,
+ * only the most aggressive bracket is run, which is successive halving.
+ *
+ * The function must have the method
+ *
+ *   double Evaluate(const arma::mat& parameters, const double fidelity);
+ *
+ * where fidelity is the budget of the evaluation, between
+ * MaxResource() / eta^s and MaxResource() (for instance, the number of epochs
+ * to train for).  The objectives at different fidelities are only compared
+ * with each other within a rung, and the returned point is the one with the
+ * lowest objective at full fidelity.
+ *
+ * The points of each rung are evaluated as tasks of the executor, so with a
+ * parallel executor (OpenMPExecutor or ThreadPoolExecutor) Evaluate() must be
+ * safe to call concurrently.  The points are drawn from the random number
+ * stream of NewRandomGenerator(), and ties are broken by the order in which
+ * the points were drawn, so the result does not depend on the executor.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{li2018hyperband,
+ *   title   = {Hyperband: A Novel Bandit-Based Approach to Hyperparameter
+ *              Optimization},
+ *   author  = {Li, Lisha and Jamieson, Kevin and DeSalvo, Giulia and
+ *              Rostamizadeh, Afshin and Talwalkar, Ameet},
+ *   journal = {Journal of Machine Learning Research},
+ *   volume  = {18},
+ *   number  = {185},
+ *   pages   = {1--52},
+ *   year    = {2018}
+ * }
+ * @endcode
+ *
+ * @tparam ExecutorType Executor that evaluates the points of a rung (see
+ *     SerialExecutor, OpenMPExecutor, and ThreadPoolExecutor).
+ */
+template<typename ExecutorType = SerialExecutor>
+class HyperbandType
+{
+ public:
+  /**
+   * Construct the Hyperband optimizer.
+   *
+   * @param maxResource Budget of a full evaluation; the smallest budget is
+   *     maxResource / eta^s, where s is the largest integer with eta^s at most
+   *     maxResource.
+   * @param eta Factor by which the number of points is divided, and their
+   *     budget multiplied, from one rung to the next (larger than 1).
+   * @param numBrackets Number of brackets to run, from the most aggressive
+   *     one (0 means all of them; 1 is successive halving).
+   * @param executor The executor that evaluates the points of a rung.
+   */
+  HyperbandType(const double maxResource = 81,
+                const double eta = 3,
+                const size_t numBrackets = 0,
+                const ExecutorType& executor = ExecutorType());
+
+  /**
+   * Optimize (minimize) the given function over the points of the grid given
+   * by the number of categories of each dimension.
+   *
+   * @param function Function to optimize.
+   * @param bestParameters Variable for storing results.
+   * @param categoricalDimensions Set of dimension types.  If a value is true,
+   *     then that dimension is a categorical dimension.
+   * @param numCategories Number of categories in each categorical dimension.
+   * @return Objective value of the final point, at full fidelity.
+   */
+  template<typename FunctionType>
+  double Optimize(FunctionType& function,
+                  arma::mat& bestParameters,
+                  const std::vector<bool>& categoricalDimensions,
+                  const arma::Row<size_t>& numCategories);
+
+  //! Get the budget of a full evaluation.
+  double MaxResource() const { return maxResource; }
+  //! Modify the budget of a full evaluation.
+  double& MaxResource() { return maxResource; }
+
+  //! Get the factor between the budgets of successive rungs.
+  double Eta() const { return eta; }
+  //! Modify the factor between the budgets of successive rungs.
+  double& Eta() { return eta; }
+
+  //! Get the number of brackets to run (0 means all of them).
+  size_t NumBrackets() const { return numBrackets; }
+  //! Modify the number of brackets to run (0 means all of them).
+  size_t& NumBrackets() { return numBrackets; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
+  //! Get the number of evaluations of the last call to Optimize().
+  size_t Evaluations() const { return evaluations; }
+
+  //! Get the total budget of the evaluations of the last call to Optimize(),
+  //! in units of MaxResource().
+  double TotalBudget() const { return totalBudget; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Store the coordinates of the point with the given index in the grid into
+   * the given vector.
+   */
+  static void Point(size_t index,
+                    const arma::Row<size_t>& numCategories,
+                    arma::vec& point);
+
+  /**
+   * Draw the indices of count distinct points among the numPoints points of
+   * the grid, in the order they are drawn.
+   */
+  static std::vector<size_t> Sample(const size_t count,
+                                    const size_t numPoints,
+                                    RandomGenerator& generator);
+
+  //! The budget of a full evaluation.
+  double maxResource;
+
+  //! The factor between the budgets of successive rungs.
+  double eta;
+
+  //! The number of brackets to run (0 means all of them).
+  size_t numBrackets;
+
+  //! The executor that evaluates the points of a rung.
+  ExecutorType executor;
+
+  //! The number of evaluations of the last call to Optimize().
+  size_t evaluations;
+
+  //! The total budget of the last call to Optimize().
+  double totalBudget;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+//! Hyperband that evaluates the points of a rung one after the other.
+typedef HyperbandType<SerialExecutor> Hyperband;
+
+} // namespace ens
+
+// Include implementation.
+#include "hyperband_impl.hpp"
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file hyperband_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of Hyperband.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_HYPERBAND_HYPERBAND_IMPL_HPP
+#define ENSMALLEN_HYPERBAND_HYPERBAND_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "hyperband.hpp"
+
+#include <limits>
+#include <unordered_set>
+
+namespace ens {
+
+template<typename ExecutorType>
+HyperbandType<ExecutorType>::HyperbandType(const double maxResource,
+                                           const double eta,
+                                           const size_t numBrackets,
+                                           const ExecutorType& executor) :
+    maxResource(maxResource),
+    eta(eta),
+    numBrackets(numBrackets),
+    executor(executor),
+    evaluations(0),
+    totalBudget(0.0)
+{ /* Nothing to do. */ }
+
+template<typename ExecutorType>
+template<typename FunctionType>
+double HyperbandType<ExecutorType>::Optimize(
+    FunctionType& function,
+    arma::mat& bestParameters,
+    const std::vector<bool>& categoricalDimensions,
+    const arma::Row<size_t>& numCategories)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  for (size_t i = 0; i < categoricalDimensions.size(); ++i)
+  {
+    if (!categoricalDimensions[i])
+    {
+      std::ostringstream oss;
+      oss << "Hyperband::Optimize(): the dimension " << i
+          << " is not categorical" << std::endl;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  if (!(eta > 1.0) || !(maxResource >= 1.0))
+  {
+    std::ostringstream oss;
+    oss << "Hyperband::Optimize(): eta (" << eta << ") must be larger than 1 "
+        << "and the maximum resource (" << maxResource << ") at least 1!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Find the number of points of the grid.
+  const size_t numDimensions = categoricalDimensions.size();
+  size_t numPoints = 1;
+  for (size_t i = 0; i < numDimensions; ++i)
+  {
+    if (numCategories(i) != 0 &&
+        numPoints > std::numeric_limits<size_t>::max() / numCategories(i))
+    {
+      throw std::invalid_argument("Hyperband::Optimize(): the grid has too "
+          "many points");
+    }
+    numPoints *= numCategories(i);
+  }
+
+  evaluations = 0;
+  totalBudget = 0.0;
+  double bestObjective = std::numeric_limits<double>::max();
+  bestParameters.zeros(numDimensions, 1);
+  if (numPoints == 0)
+    return bestObjective;
+
+  // The most aggressive bracket has sMax + 1 rungs; the tolerance keeps
+  // eta^sMax = maxResource exact powers from being lost to rounding.
+  size_t sMax = 0;
+  while (std::pow(eta, (double) (sMax + 1)) <= maxResource * (1.0 + 1e-10))
+    ++sMax;
+  const size_t brackets = (numBrackets == 0) ? sMax + 1 :
+      std::min(numBrackets, sMax + 1);
+
+  RandomGenerator generator = NewRandomGenerator();
+  size_t bestIndex = numPoints;
+  std::vector<double> objectives;
+  std::vector<size_t> order;
+  for (size_t s = sMax; s + brackets > sMax; --s)
+  {
+    // Every bracket gets about (sMax + 1) * maxResource of budget.
+    const double start = std::ceil((sMax + 1) * std::pow(eta, (double) s) /
+        (s + 1) - 1e-10);
+    std::vector<size_t> points = Sample((size_t) std::min(start,
+        (double) numPoints), numPoints, generator);
+
+    for (size_t i = 0; i <= s; ++i)
+    {
+      const double fidelity = maxResource / std::pow(eta, (double) (s - i));
+
+      objectives.resize(points.size());
+      executor.Run(points.size(), [&](const size_t j)
+      {
+        arma::vec point;
+        Point(points[j], numCategories, point);
+        objectives[j] = function.Evaluate(point, fidelity);
+      });
+      evaluations += points.size();
+      totalBudget += points.size() * fidelity / maxResource;
+
+      // Rank the points; ties keep the order in which the points were drawn.
+      order.resize(points.size());
+      for (size_t j = 0; j < order.size(); ++j)
+        order[j] = j;
+      std::stable_sort(order.begin(), order.end(),
+          [&](const size_t a, const size_t b)
+          { return objectives[a] < objectives[b]; });
+
+      if (i == s)
+      {
+        if (objectives[order[0]] < bestObjective)
+        {
+          bestObjective = objectives[order[0]];
+          bestIndex = points[order[0]];
+        }
+        break;
+      }
+
+      // Keep the best 1 / eta of the points for the next rung.
+      const size_t kept = std::max((size_t) (points.size() / eta), size_t(1));
+      std::vector<size_t> survivors(kept);
+      for (size_t j = 0; j < kept; ++j)
+        survivors[j] = points[order[j]];
+      points.swap(survivors);
+    }
+
+    ENS_INFO << "Hyperband: bracket " << (sMax - s + 1) << " of " << brackets
+        << " done; best objective " << bestObjective << "." << std::endl;
+
+    if (s == 0)
+      break;
+  }
+
+  if (bestIndex < numPoints)
+  {
+    arma::vec point;
+    Point(bestIndex, numCategories, point);
+    bestParameters = point;
+  }
+
+  return bestObjective;
+}
+
+template<typename ExecutorType>
+void HyperbandType<ExecutorType>::Point(size_t index,
+                                        const arma::Row<size_t>& numCategories,
+                                        arma::vec& point)
+{
+  point.set_size(numCategories.n_elem);
+  for (size_t i = numCategories.n_elem; i > 0; --i)
+  {
+    point(i - 1) = index % numCategories(i - 1);
+    index /= numCategories(i - 1);
+  }
+}
+
+template<typename ExecutorType>
+std::vector<size_t> HyperbandType<ExecutorType>::Sample(
+    const size_t count,
+    const size_t numPoints,
+    RandomGenerator& generator)
+{
+  // Floyd's algorithm draws distinct indices in O(count) time, however large
+  // the grid is.
+  std::vector<size_t> indices;
+  std::unordered_set<size_t> drawn;
+  indices.reserve(count);
+  for (size_t j = numPoints - count; j < numPoints; ++j)
+  {
+    const size_t t = generator.Integer(j + 1);
+    const size_t index = (drawn.count(t) == 0) ? t : j;
+    drawn.insert(index);
+    indices.push_back(index);
+  }
+
+  return indices;
+}
+
+} // namespace ens
+
+#endif
@@ -82,6 +82,22 @@ class IQN
   template<typename DecomposableFunctionType>
   double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
 
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for an iterate
+   * of the given size (see ens::MemoryEstimate()).  With n elements in the
+   * iterate and b = ceil(numFunctions / BatchSize()) batches, the Hessian
+   * approximation of every batch takes b * n^2 doubles, and the aggregate
+   * approximation, its inverse and the temporaries of their updates a few
+   * more n^2; LIQN needs O(b * n) memory instead.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param numFunctions Number of separable functions of the objective.
+   */
+  size_t MemoryEstimate(const size_t rows,
+                        const size_t cols,
+                        const size_t numFunctions) const;
+
   //! Get the step size.
   double StepSize() const { return stepSize; }
   //! Modify the step size.
@@ -102,7 +118,24 @@ class IQN
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  /**
+   * Update the given inverse of a symmetric matrix A to the inverse of
+   * A + alpha * v * v^T with the Sherman-Morrison formula, in O(n^2) time.
+   * Returns false (and leaves the inverse unchanged) if the updated matrix is
+   * (numerically) singular.
+   *
+   * @param inverse Inverse of A; overwritten with the updated inverse.
+   * @param v Column vector of the rank-one update.
+   * @param alpha Weight of the rank-one update.
+   */
+  bool ShermanMorrisonUpdate(arma::mat& inverse,
+                             const arma::mat& v,
+                             const double alpha);
+
   //! The step size for each example.
   double stepSize;
 
@@ -114,6 +147,9 @@ class IQN
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
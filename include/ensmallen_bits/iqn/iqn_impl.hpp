@@ -31,10 +31,27 @@ inline IQN::IQN(const double stepSize,
     tolerance(tolerance)
 { /* Nothing to do. */ }
 
+inline size_t IQN::MemoryEstimate(const size_t rows,
+                                  const size_t cols,
+                                  const size_t numFunctions) const
+{
+  const size_t n = rows * cols;
+  const size_t numBatches = (numFunctions + std::max(batchSize, size_t(1)) -
+      1) / std::max(batchSize, size_t(1));
+
+  // Q holds an n x n slice per batch; B, its inverse and the rank-two updates
+  // (or the inverse computed from scratch) take four more.  y and t hold a
+  // vector per batch, and there are about eight more vectors.
+  return ((numBatches + 4) * n * n + (2 * numBatches + 8) * n) *
+      sizeof(double);
+}
+
 //! Optimize the function (minimize).
 template<typename DecomposableFunctionType>
 double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
 
   // Find the number of functions.
@@ -49,8 +66,10 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
   arma::cube y(iterate.n_rows, iterate.n_cols, numBatches);
   arma::cube t(iterate.n_elem, 1, numBatches);
   arma::cube Q(iterate.n_elem, iterate.n_elem, numBatches);
-  arma::mat initialIterate = arma::randn(iterate.n_rows, iterate.n_cols);
+  arma::mat initialIterate(iterate.n_rows, iterate.n_cols);
+  Random().Randn(initialIterate);
   arma::mat B = arma::eye(iterate.n_elem, iterate.n_elem);
+  arma::mat BInverse = arma::eye(iterate.n_elem, iterate.n_elem);
 
   arma::mat g = arma::zeros(iterate.n_rows, iterate.n_cols);
   for (size_t i = 0, f = 0; i < numFunctions; f++)
@@ -97,27 +116,41 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
 
         const arma::mat s = iterateVec - t.slice(it);
         const arma::mat yy = arma::vectorise(gradient - y.slice(it));
-
-        const arma::mat stochasticHessian = Q.slice(it) + yy * yy.t() /
-            arma::as_scalar(yy.t() * s) - Q.slice(it) * s * s.t() *
-            Q.slice(it) / arma::as_scalar(s.t() * Q.slice(it) * s);
-
-        // Update aggregate Hessian approximation.
-        B += (1.0 / numBatches) * (stochasticHessian - Q.slice(it));
-
-        // Update aggregate Hessian-variable product.
-        u += (1.0 / numBatches) * (stochasticHessian * iterateVec -
-            Q.slice(it) * t.slice(it));
+        const arma::mat Qs = Q.slice(it) * s;
+
+        // The BFGS update of the Hessian approximation of the batch is the
+        // rank-two correction alpha * yy * yy^T + beta * Qs * Qs^T (Q is
+        // symmetric), so it is never formed explicitly.
+        const double alpha = 1.0 / arma::as_scalar(yy.t() * s);
+        const double beta = -1.0 / arma::as_scalar(s.t() * Qs);
+
+        // Update aggregate Hessian-variable product.  Since s = x - t, the
+        // old term Q * (x - t) is just Qs.
+        u += (1.0 / numBatches) * (Qs + alpha * arma::dot(yy, iterateVec) *
+            yy + beta * arma::dot(Qs, iterateVec) * Qs);
+
+        // Update aggregate Hessian approximation and its inverse.
+        {
+          ENS_TRACE_ZONE("InverseUpdate");
+          B += (alpha / numBatches) * yy * yy.t() +
+              (beta / numBatches) * Qs * Qs.t();
+          if (!ShermanMorrisonUpdate(BInverse, yy, alpha / numBatches) ||
+              !ShermanMorrisonUpdate(BInverse, Qs, beta / numBatches))
+          {
+            // The update is numerically unstable, so do it the slow way.
+            BInverse = B.i();
+          }
+        }
 
         // Update aggregate gradient.
         g += (1.0 / numBatches) * (gradient - y.slice(it));
 
         // Update the function information tables.
-        Q.slice(it) = stochasticHessian;
+        Q.slice(it) += alpha * yy * yy.t() + beta * Qs * Qs.t();
         y.slice(it) = gradient;
         t.slice(it) = iterateVec;
 
-        iterateVec = stepSize * B.i() * (u - gVec) + (1 - stepSize) *
+        iterateVec = stepSize * BInverse * (u - gVec) + (1 - stepSize) *
             iterateVec;
       }
 
@@ -133,30 +166,45 @@ double IQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
     overallObjective /= numFunctions;
 
     // Output current objective function.
-    Info << "IQN: iteration " << i << ", objective " << overallObjective
+    ENS_INFO << "IQN: iteration " << i << ", objective " << overallObjective
         << "." << std::endl;
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
-      Warn << "IQN: converged to " << overallObjective << "; terminating"
+      ENS_WARN << "IQN: converged to " << overallObjective << "; terminating"
           << " with failure.  Try a smaller step size?" << std::endl;
       return overallObjective;
     }
 
     if (overallObjective < tolerance)
     {
-      Info << "IQN: minimized within tolerance " << tolerance << "; "
+      ENS_INFO << "IQN: minimized within tolerance " << tolerance << "; "
           << "terminating optimization." << std::endl;
       return overallObjective;
     }
   }
 
-  Info << "IQN: maximum iterations (" << maxIterations << ") reached; "
+  ENS_INFO << "IQN: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
 
   return overallObjective;
 }
 
+inline bool IQN::ShermanMorrisonUpdate(arma::mat& inverse,
+                                       const arma::mat& v,
+                                       const double alpha)
+{
+  // (A + alpha * v * v^T)^-1 = A^-1 - alpha * A^-1 v v^T A^-1 /
+  //     (1 + alpha * v^T A^-1 v), where A^-1 is symmetric.
+  const arma::mat inverseV = inverse * v;
+  const double denominator = 1.0 + alpha * arma::dot(v, inverseV);
+  if (!std::isfinite(denominator) || std::abs(denominator) < 1e-10)
+    return false;
+
+  inverse -= (alpha / denominator) * inverseV * inverseV.t();
+  return true;
+}
+
 } // namespace ens
 
 #endif
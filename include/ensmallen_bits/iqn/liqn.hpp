@@ -0,0 +1,161 @@
+/**
+ * @file liqn.hpp
+ * @author Marcus Edel
+ *
+ * Definition of a limited-memory variant of the incremental Quasi-Newton
+ * method (IQN), which does not store a dense Hessian approximation.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_IQN_LIQN_HPP
+#define ENSMALLEN_IQN_LIQN_HPP
+
+namespace ens {
+
+/**
+ * LIQN is a limited-memory variant of IQN.  IQN keeps one dense n x n Hessian
+ * approximation for every batch, which is infeasible for more than a few
+ * thousand parameters.  LIQN keeps, like IQN, the last iterate and gradient of
+ * every batch, but represents the aggregated Hessian approximation by the
+ * numBasis most recent curvature pairs (s, y) of the batch updates, like
+ * L-BFGS, and applies its inverse with the two-loop recursion.  Since the
+ * Hessian approximations of the batches are replaced by the aggregated one,
+ * each step moves towards
+ *
+ * \f[
+ * \bar{t} - B^{-1} \bar{g},
+ * \f]
+ *
+ * where \f$ \bar{t} \f$ is the average of the last iterates of the batches and
+ * \f$ \bar{g} \f$ the average of their last gradients.  Each step then costs
+ * O(numBasis * n) time, and the memory use is O((numBatches + numBasis) * n).
+ *
+ * LIQN has the same API as IQN, plus the number of curvature pairs, so it can
+ * be used in its place.  It can optimize differentiable separable functions.
+ * For more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class LIQN
+{
+ public:
+  /**
+   * Construct the LIQN optimizer with the given parameters.  The defaults here
+   * are not necessarily good for the given problem, so it is suggested that
+   * the values used be tailored to the task at hand.  As for IQN, one
+   * iteration is one pass over the dataset.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Size of each batch.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param numBasis Number of curvature pairs to keep.
+   */
+  LIQN(const double stepSize = 0.01,
+       const size_t batchSize = 10,
+       const size_t maxIterations = 100000,
+       const double tolerance = 1e-5,
+       const size_t numBasis = 10);
+
+  /**
+   * Optimize the given function using LIQN. The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType>
+  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for an iterate
+   * of the given size (see ens::MemoryEstimate()): with n elements in the
+   * iterate and b = ceil(numFunctions / BatchSize()) batches, the last iterate
+   * and gradient of every batch (2 * b * n doubles), the 2 * NumBasis()
+   * curvature pairs, and a few more vectors.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param numFunctions Number of separable functions of the objective.
+   */
+  size_t MemoryEstimate(const size_t rows,
+                        const size_t cols,
+                        const size_t numFunctions) const;
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of curvature pairs to keep.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the number of curvature pairs to keep.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Compute the product of the inverse Hessian approximation given by the
+   * stored curvature pairs with the given vector, using the two-loop
+   * recursion.
+   *
+   * @param vector Vector to multiply.
+   * @param numPairs Number of curvature pairs stored so far.
+   * @param s Differences of the iterates.
+   * @param y Differences of the gradients.
+   * @param product Matrix to store the product into.
+   */
+  void InverseHessianProduct(const arma::mat& vector,
+                             const size_t numPairs,
+                             const arma::cube& s,
+                             const arma::cube& y,
+                             arma::mat& product) const;
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The size of each batch.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The number of curvature pairs to keep.
+  size_t numBasis;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "liqn_impl.hpp"
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * @file liqn_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the limited-memory variant of the incremental Quasi-Newton
+ * method (IQN).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_IQN_LIQN_IMPL_HPP
+#define ENSMALLEN_IQN_LIQN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "liqn.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline LIQN::LIQN(const double stepSize,
+                  const size_t batchSize,
+                  const size_t maxIterations,
+                  const double tolerance,
+                  const size_t numBasis) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    numBasis(numBasis)
+{ /* Nothing to do. */ }
+
+inline size_t LIQN::MemoryEstimate(const size_t rows,
+                                   const size_t cols,
+                                   const size_t numFunctions) const
+{
+  const size_t n = rows * cols;
+  const size_t numBatches = (numFunctions + std::max(batchSize, size_t(1)) -
+      1) / std::max(batchSize, size_t(1));
+
+  return (2 * numBatches + 2 * numBasis + 8) * n * sizeof(double);
+}
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType>
+double LIQN::Optimize(DecomposableFunctionType& function, arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
+
+  // Find the number of functions.
+  const size_t numFunctions = function.NumFunctions();
+  size_t numBatches = numFunctions / batchSize;
+  if (numFunctions % batchSize != 0)
+    ++numBatches; // Capture last few.
+
+  // To keep track of where we are and how things are going.
+  double overallObjective = 0;
+
+  // The last iterate and gradient of every batch, as for IQN.
+  arma::cube y(iterate.n_rows, iterate.n_cols, numBatches);
+  arma::cube t(iterate.n_rows, iterate.n_cols, numBatches);
+  arma::mat initialIterate(iterate.n_rows, iterate.n_cols);
+  Random().Randn(initialIterate);
+
+  // The curvature pairs, overwritten in a circular fashion.
+  arma::cube s(iterate.n_rows, iterate.n_cols, numBasis);
+  arma::cube yy(iterate.n_rows, iterate.n_cols, numBasis);
+  size_t numPairs = 0;
+
+  arma::mat g = arma::zeros(iterate.n_rows, iterate.n_cols);
+  for (size_t i = 0, f = 0; i < numFunctions; f++)
+  {
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+
+    t.slice(f) = initialIterate;
+    function.Gradient(initialIterate, i, y.slice(f), effectiveBatchSize);
+
+    g += y.slice(f);
+    y.slice(f) /= (double) effectiveBatchSize;
+
+    i += effectiveBatchSize;
+  }
+  g /= numFunctions;
+
+  // The average of the last iterates of the batches.
+  arma::mat tAverage = initialIterate;
+
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat direction;
+
+  for (size_t i = 1; i != maxIterations; ++i)
+  {
+    for (size_t j = 0, f = 0; f < numFunctions; j++)
+    {
+      // Cyclicly iterating through the number of functions.
+      const size_t it = ((j + 1) % numBatches);
+
+      // Find the effective batch size (the last batch may be smaller).
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions -
+          it * batchSize);
+
+      if (arma::norm(iterate - t.slice(it)) > 0)
+      {
+        function.Gradient(iterate, it * batchSize, gradient,
+            effectiveBatchSize);
+        gradient /= effectiveBatchSize;
+
+        // Keep the curvature pair only if it has positive curvature, so that
+        // the Hessian approximation stays positive definite.
+        const arma::mat sNew = iterate - t.slice(it);
+        const arma::mat yNew = gradient - y.slice(it);
+        if (numBasis > 0 && arma::dot(sNew, yNew) > 1e-10 *
+            arma::norm(sNew) * arma::norm(yNew))
+        {
+          s.slice(numPairs % numBasis) = sNew;
+          yy.slice(numPairs % numBasis) = yNew;
+          ++numPairs;
+        }
+
+        // Update aggregate gradient and iterate.
+        g += (1.0 / numBatches) * yNew;
+        tAverage += (1.0 / numBatches) * sNew;
+
+        // Update the function information tables.
+        y.slice(it) = gradient;
+        t.slice(it) = iterate;
+
+        InverseHessianProduct(g, numPairs, s, yy, direction);
+        iterate = stepSize * (tAverage - direction) + (1 - stepSize) *
+            iterate;
+      }
+
+      f += effectiveBatchSize;
+    }
+
+    overallObjective = 0;
+    for (size_t f = 0; f < numFunctions; f += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
+      overallObjective += function.Evaluate(iterate, f, effectiveBatchSize);
+    }
+    overallObjective /= numFunctions;
+
+    // Output current objective function.
+    ENS_INFO << "LIQN: iteration " << i << ", objective " << overallObjective
+        << "." << std::endl;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      ENS_WARN << "LIQN: converged to " << overallObjective << "; terminating"
+          << " with failure.  Try a smaller step size?" << std::endl;
+      return overallObjective;
+    }
+
+    if (overallObjective < tolerance)
+    {
+      ENS_INFO << "LIQN: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+      return overallObjective;
+    }
+  }
+
+  ENS_INFO << "LIQN: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  return overallObjective;
+}
+
+inline void LIQN::InverseHessianProduct(const arma::mat& vector,
+                                        const size_t numPairs,
+                                        const arma::cube& s,
+                                        const arma::cube& y,
+                                        arma::mat& product) const
+{
+  // Start from this point.
+  product = vector;
+  if (numPairs == 0)
+    return;
+
+  // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
+  // matrices with limited storage" (Nocedal, 1980).  The pairs are visited
+  // from the newest to the oldest, then back.
+  const size_t count = std::min(numPairs, numBasis);
+  arma::vec rho(count);
+  arma::vec alpha(count);
+  for (size_t k = 0; k < count; ++k)
+  {
+    const size_t pos = (numPairs - 1 - k) % numBasis;
+    rho[k] = 1.0 / arma::dot(y.slice(pos), s.slice(pos));
+    alpha[k] = rho[k] * arma::dot(s.slice(pos), product);
+    product -= alpha[k] * y.slice(pos);
+  }
+
+  // Scale by the usual initial approximation of the inverse Hessian, given by
+  // the newest pair.
+  const size_t newest = (numPairs - 1) % numBasis;
+  product *= arma::dot(s.slice(newest), y.slice(newest)) /
+      arma::dot(y.slice(newest), y.slice(newest));
+
+  for (size_t k = count; k > 0; --k)
+  {
+    const size_t pos = (numPairs - k) % numBasis;
+    const double beta = rho[k - 1] * arma::dot(y.slice(pos), product);
+    product += (alpha[k - 1] - beta) * s.slice(pos);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -34,9 +34,24 @@ namespace ens {
  * }
  * @endcode
  *
- * Katyusha can optimize differentiable separable functions.  For more details,
- * see the documentation on function types included with this distribution or on
- * the ensmallen website.
+ * With a sparse gradient type (e.g. arma::sp_mat), Katyusha (without the
+ * proximal update) runs its inner iterations in O(nnz) instead of O(d): the
+ * sequences y, z and the weighted sum of the iterates move on every coordinate
+ * in every step, but on a coordinate that the gradients of a batch do not touch
+ * they only follow the full gradient, an affine recurrence whose result after
+ * any number of steps has a closed form.  Each coordinate therefore holds the
+ * step it was last brought up to date at, and the skipped steps are applied
+ * just in time, when a batch touches the coordinate (the gradient at the
+ * snapshot, whose non-zero coordinates are brought up to date before the
+ * gradient at the current point is computed, tells which), and for all
+ * coordinates at the end of the outer iteration.  The result is the same as
+ * with the dense steps, as long as the gradient of a batch at the current point
+ * has no non-zero coordinate where the one at the snapshot is zero.
+ *
+ * Katyusha can optimize differentiable separable functions, and sparse
+ * differentiable separable functions.  For more details, see the documentation
+ * on function types included with this distribution or on the ensmallen
+ * website.
  *
  * @tparam proximal Whether the proximal update should be used or not.
  */
@@ -63,6 +78,8 @@ class KatyushaType
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *    function is visited in linear order.
+   * @param parallelFullGradient If true, compute the full gradient of each
+   *    outer iteration with several OpenMP threads.
    */
   KatyushaType(const double convexity = 1.0,
                const double lipschitz = 10.0,
@@ -70,19 +87,23 @@ class KatyushaType
                const size_t maxIterations = 1000,
                const size_t innerIterations = 0,
                const double tolerance = 1e-5,
-               const bool shuffle = true);
+               const bool shuffle = true,
+               const bool parallelFullGradient = false);
 
   /**
    * Optimize the given function using Katyusha. The given starting point will
    * be modified to store the finishing point of the algorithm, and the final
-   * objective value is returned.
+   * objective value is returned.  With a sparse GradType, the inner iterations
+   * are lazy (see above); this needs the standard update.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam GradType Type of matrix to use to represent function gradients
+   *     (arma::mat or arma::sp_mat).
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
+  template<typename DecomposableFunctionType, typename GradType = arma::mat>
   double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
 
   //! Get the convexity parameter.
@@ -120,7 +141,46 @@ class KatyushaType
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return shuffle; }
 
+  //! Get whether the full gradient is computed in parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether the full gradient is computed in parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  //! Optimize the function with dense steps, using the given gradient buffer.
+  template<typename DecomposableFunctionType>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  arma::mat& gradient);
+
+  //! Optimize the function with lazy sparse steps, using the given gradient
+  //! buffer.
+  template<typename SparseFunctionType, typename eT>
+  double Optimize(SparseFunctionType& function,
+                  arma::mat& iterate,
+                  arma::SpMat<eT>& gradient);
+
+  /**
+   * Compute the constants of the steps for the given number of functions, and
+   * set innerIterations to the number of functions if it is 0.
+   *
+   * @param numFunctions Number of separable functions.
+   * @param numBatches Number of batches of an outer iteration.
+   * @param tau1 Weight of z in the iterate.
+   * @param alpha Step size of z.
+   * @param r Growth of the weights of the iterates in the snapshot.
+   * @param normalizer Normalizer of the weighted sum of the iterates.
+   */
+  void StepConstants(const size_t numFunctions,
+                     size_t& numBatches,
+                     double& tau1,
+                     double& alpha,
+                     double& r,
+                     double& normalizer);
+
   //! The convexity regularization term.
   double convexity;
 
@@ -142,6 +202,12 @@ class KatyushaType
   //! Controls whether or not the individual functions are shuffled when
   //! iterating.
   bool shuffle;
+
+  //! Whether to compute the full gradient in parallel.
+  bool parallelFullGradient;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 // Convenience typedefs.
@@ -27,60 +27,91 @@ KatyushaType<Proximal>::KatyushaType(
     const size_t maxIterations,
     const size_t innerIterations,
     const double tolerance,
-    const bool shuffle) :
+    const bool shuffle,
+    const bool parallelFullGradient) :
     convexity(convexity),
     lipschitz(lipschitz),
     batchSize(batchSize),
     maxIterations(maxIterations),
     innerIterations(innerIterations),
     tolerance(tolerance),
-    shuffle(shuffle)
+    shuffle(shuffle),
+    parallelFullGradient(parallelFullGradient)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
 template<bool Proximal>
-template<typename DecomposableFunctionType>
+template<typename DecomposableFunctionType, typename GradType>
 double KatyushaType<Proximal>::Optimize(
     DecomposableFunctionType& function,
     arma::mat& iterate)
 {
-  traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
+  ENS_PROFILE_OPTIMIZER(profile);
 
-  // Find the number of functions to use.
-  const size_t numFunctions = function.NumFunctions();
+  GradType gradient;
+  return Optimize(function, iterate, gradient);
+}
 
+template<bool Proximal>
+void KatyushaType<Proximal>::StepConstants(const size_t numFunctions,
+                                           size_t& numBatches,
+                                           double& tau1,
+                                           double& alpha,
+                                           double& r,
+                                           double& normalizer)
+{
   // Set epoch length to n / b if the user asked for.
   if (innerIterations == 0)
     innerIterations = numFunctions;
 
   // Find the number of batches.
-  size_t numBatches = innerIterations / batchSize;
+  numBatches = innerIterations / batchSize;
   if (numFunctions % batchSize != 0)
     ++numBatches; // Capture last few.
 
-  const double tau1 = std::min(0.5,
-      std::sqrt(batchSize * convexity / (3.0 * lipschitz)));
-  const double tau2 = 0.5;
-  const double alpha = 1.0 / (3.0 * tau1 * lipschitz);
-  const double r = 1.0 + std::min(alpha * convexity, 1.0 /
-      (4.0 / innerIterations));
+  tau1 = std::min(0.5, std::sqrt(batchSize * convexity / (3.0 * lipschitz)));
+  alpha = 1.0 / (3.0 * tau1 * lipschitz);
+  r = 1.0 + std::min(alpha * convexity, 1.0 / (4.0 / innerIterations));
 
   // sum_{j=0}^{m-1} 1 + std::min(alpha * convexity, 1 / (4 * m)^j).
-  double normalizer = 1;
+  normalizer = 1;
   for (size_t i = 0; i < numBatches; i++)
   {
     normalizer = r * (normalizer + 1.0);
   }
   normalizer = 1.0 / normalizer;
+}
+
+//! Optimize the function with dense steps.
+template<bool Proximal>
+template<typename DecomposableFunctionType>
+double KatyushaType<Proximal>::Optimize(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    arma::mat& gradient)
+{
+  traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
+
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& fullFunction(static_cast<FullFunctionType&>(function));
+
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  size_t numBatches;
+  double tau1, alpha, r, normalizer;
+  StepConstants(numFunctions, numBatches, tau1, alpha, r, normalizer);
+  const double tau2 = 0.5;
 
   // To keep track of where we are and how things are going.
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  gradient.set_size(iterate.n_rows, iterate.n_cols);
   arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
   arma::mat gradient0(iterate.n_rows, iterate.n_cols);
+  arma::mat zStep(iterate.n_rows, iterate.n_cols);
 
   arma::mat iterate0 = iterate;
   arma::mat y = iterate;
@@ -91,17 +122,14 @@ double KatyushaType<Proximal>::Optimize(
       std::numeric_limits<size_t>::max() : maxIterations;
   for (size_t i = 0; i < actualMaxIterations; ++i)
   {
-    // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
-    {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate0, f, effectiveBatchSize);
-    }
+    // Calculate the objective function and the full gradient at the snapshot
+    // in one pass.
+    overallObjective = FullEvaluateWithGradient(fullFunction, iterate0,
+        batchSize, fullGradient, gradient, parallelFullGradient);
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
-      Warn << "Katyusha: converged to " << overallObjective
+      ENS_WARN << "Katyusha: converged to " << overallObjective
           << "; terminating  with failure.  Try a smaller step size?"
           << std::endl;
       return overallObjective;
@@ -109,29 +137,13 @@ double KatyushaType<Proximal>::Optimize(
 
     if (std::abs(lastObjective - overallObjective) < tolerance)
     {
-      Info << "Katyusha: minimized within tolerance " << tolerance
+      ENS_INFO << "Katyusha: minimized within tolerance " << tolerance
           << "; terminating optimization." << std::endl;
       return overallObjective;
     }
 
     lastObjective = overallObjective;
 
-    // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
-    {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
-
-      function.Gradient(iterate0, f, gradient, effectiveBatchSize);
-      fullGradient += gradient;
-
-      f += effectiveBatchSize;
-    }
-    fullGradient /= (double) numFunctions;
-
     // To keep track of where we are and how things are going.
     double cw = 1;
     w.zeros();
@@ -150,7 +162,8 @@ double KatyushaType<Proximal>::Optimize(
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
       iterate = tau1 * z + tau2 * iterate0 + (1 - tau1 - tau2) * y;
 
       // Calculate variance reduced gradient.
@@ -160,8 +173,9 @@ double KatyushaType<Proximal>::Optimize(
           effectiveBatchSize);
 
       // By the minimality definition of z_{k + 1}, we have that:
-      // z_{k+1} − z_k + \alpha * \sigma_{k+1} + \alpha g = 0.
-      arma::mat zNew = z - alpha * (fullGradient + (gradient - gradient0) /
+      // z_{k+1} − z_k + \alpha * \sigma_{k+1} + \alpha g = 0.  Only the step
+      // z_{k+1} - z_k is computed, into storage allocated once.
+      zStep = -alpha * (fullGradient + (gradient - gradient0) /
           (double) batchSize);
 
       // Proximal update, choose between Option I and Option II. Shift relative
@@ -179,10 +193,10 @@ double KatyushaType<Proximal>::Optimize(
       }
       else
       {
-        y = iterate + tau1 * (zNew - z);
+        y = iterate + tau1 * zStep;
       }
 
-      z = std::move(zNew);
+      z += zStep;
 
       // sum_{j=0}^{m-1} 1 + std::min(alpha * convexity, 1 / (4 * m)^j * ys).
       w += cw * iterate;
@@ -194,7 +208,7 @@ double KatyushaType<Proximal>::Optimize(
     iterate0 = normalizer * w;
   }
 
-  Info << "Katyusha: maximum iterations (" << maxIterations << ") reached"
+  ENS_INFO << "Katyusha: maximum iterations (" << maxIterations << ") reached"
       << "; terminating optimization." << std::endl;
 
   // Calculate final objective.
@@ -207,6 +221,238 @@ double KatyushaType<Proximal>::Optimize(
   return overallObjective;
 }
 
+
+//! Optimize the function with lazy sparse steps.
+template<bool Proximal>
+template<typename SparseFunctionType, typename eT>
+double KatyushaType<Proximal>::Optimize(
+    SparseFunctionType& function,
+    arma::mat& iterate,
+    arma::SpMat<eT>& gradient)
+{
+  static_assert(!Proximal, "KatyushaProximal does not support sparse "
+      "gradients; use Katyusha or a dense gradient type.");
+
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType, arma::mat,
+      arma::SpMat<eT>>();
+
+  typedef Function<SparseFunctionType, arma::mat, arma::SpMat<eT>>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  const size_t numFunctions = f.NumFunctions();
+
+  size_t numBatches;
+  double tau1, alpha, r, normalizer;
+  StepConstants(numFunctions, numBatches, tau1, alpha, r, normalizer);
+  const double tau2 = 0.5;
+  const double c = 1.0 - tau1 - tau2;
+
+  // Count the steps of an outer iteration.
+  size_t numSteps = 0;
+  for (size_t fn = 0, currentFunction = 0; fn < innerIterations; ++numSteps)
+  {
+    if ((currentFunction % numFunctions) == 0)
+      currentFunction = 0;
+
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+    currentFunction += effectiveBatchSize;
+    fn += effectiveBatchSize;
+  }
+
+  // On a coordinate that no batch touches, a step only follows the full
+  // gradient mu:
+  //
+  //   x_k = tau1 z_k + tau2 x0 + c y_k,
+  //   y_{k + 1} = x_k - tau1 alpha mu,  z_{k + 1} = z_k - alpha mu,
+  //   w_{k + 1} = w_k + r^k x_k.
+  //
+  // After m such steps from step a,
+  //
+  //   y_{a + m} = c^m y_a + (tau1 z_a + tau2 x0 - tau1 alpha mu) S0(m)
+  //       - tau1 alpha mu S1(m),
+  //
+  // with S0(m) = sum_{i < m} c^{m - 1 - i} and S1(m) = sum_{i < m} i
+  // c^{m - 1 - i}, and w gains r^a times a combination of the sums R0(m),
+  // R1(m), Rc(m), RS0(m) and RS1(m) of r^i, i r^i, (r c)^i, r^i S0(i) and
+  // r^i S1(i) over i < m.  These only depend on m, so they are tabulated.
+  std::vector<double> cPow(numSteps + 1), s0(numSteps + 1), s1(numSteps + 1),
+      rPow(numSteps + 1), r0(numSteps + 1), r1(numSteps + 1),
+      rc(numSteps + 1), rs0(numSteps + 1), rs1(numSteps + 1);
+  cPow[0] = rPow[0] = 1.0;
+  s0[0] = s1[0] = r0[0] = r1[0] = rc[0] = rs0[0] = rs1[0] = 0.0;
+  for (size_t m = 0; m < numSteps; ++m)
+  {
+    cPow[m + 1] = c * cPow[m];
+    s0[m + 1] = c * s0[m] + 1.0;
+    s1[m + 1] = c * s1[m] + m;
+    rPow[m + 1] = r * rPow[m];
+    r0[m + 1] = r0[m] + rPow[m];
+    r1[m + 1] = r1[m] + m * rPow[m];
+    rc[m + 1] = rc[m] + rPow[m] * cPow[m];
+    rs0[m + 1] = rs0[m] + rPow[m] * s0[m];
+    rs1[m + 1] = rs1[m] + rPow[m] * s1[m];
+  }
+
+  arma::SpMat<eT> gradient0;
+  arma::SpMat<eT> difference;
+  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
+
+  arma::mat iterate0 = iterate;
+  arma::mat y = iterate;
+  arma::mat z = iterate;
+  arma::mat w(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+
+  // The step each coordinate of y, z and w was last brought up to date at.
+  std::vector<size_t> lastStep(iterate.n_elem, 0);
+
+  // Apply the skipped steps of coordinate j up to step t.
+  auto catchUp = [&](const size_t j, const size_t t)
+  {
+    const size_t a = lastStep[j];
+    if (a == t)
+      return;
+
+    const size_t m = t - a;
+    const double mu = fullGradient[j];
+    const double zA = z[j];
+    const double yA = y[j];
+    const double drift = tau1 * zA + tau2 * iterate0[j] - tau1 * alpha * mu;
+
+    w[j] += rPow[a] * ((tau1 * zA + tau2 * iterate0[j]) * r0[m] -
+        tau1 * alpha * mu * r1[m] + c * yA * rc[m] + c * drift * rs0[m] -
+        c * tau1 * alpha * mu * rs1[m]);
+    y[j] = cPow[m] * yA + drift * s0[m] - tau1 * alpha * mu * s1[m];
+    z[j] = zA - m * alpha * mu;
+    lastStep[j] = t;
+  };
+
+  // Bring the coordinates of the given gradient up to step t, and compute the
+  // iterate there.
+  auto catchUpGradient = [&](const arma::SpMat<eT>& g, const size_t t)
+  {
+    typename arma::SpMat<eT>::const_iterator cur = g.begin();
+    for (; cur != g.end(); ++cur)
+    {
+      const size_t j = cur.row() + cur.col() * iterate.n_rows;
+      catchUp(j, t);
+      iterate[j] = tau1 * z[j] + tau2 * iterate0[j] + c * y[j];
+    }
+  };
+
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations; ++i)
+  {
+    // Calculate the objective function and the full gradient at the snapshot
+    // in one pass.
+    overallObjective = 0;
+    fullGradient.zeros();
+    for (size_t begin = 0; begin < numFunctions; begin += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+      overallObjective += f.EvaluateWithGradient(iterate0, begin, gradient,
+          effectiveBatchSize);
+      fullGradient += gradient;
+    }
+    fullGradient /= (double) numFunctions;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      ENS_WARN << "Katyusha: converged to " << overallObjective
+          << "; terminating  with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      ENS_INFO << "Katyusha: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    lastObjective = overallObjective;
+    w.zeros();
+
+    size_t k = 0;
+    for (size_t fn = 0, currentFunction = 0; fn < innerIterations; ++k)
+    {
+      // Is this iteration the start of a sequence?
+      if ((currentFunction % numFunctions) == 0)
+      {
+        currentFunction = 0;
+
+        // Determine order of visitation.
+        if (shuffle)
+          f.Shuffle();
+      }
+
+      // Find the effective batch size (the last batch may be smaller).
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
+
+      // The snapshot is up to date, so its gradient tells which coordinates
+      // the batch reads; they are brought up to date before the gradient at
+      // the current point is computed.
+      f.Gradient(iterate0, currentFunction, gradient0, effectiveBatchSize);
+      catchUpGradient(gradient0, k);
+      f.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+      catchUpGradient(gradient, k);
+
+      // Take the step on the coordinates of the variance reduction term; the
+      // others only follow the full gradient, and are updated lazily.
+      difference = gradient - gradient0;
+      typename arma::SpMat<eT>::const_iterator cur = difference.begin();
+      for (; cur != difference.end(); ++cur)
+      {
+        const size_t j = cur.row() + cur.col() * iterate.n_rows;
+        const double zStep = -alpha * (fullGradient[j] +
+            (*cur) / (double) batchSize);
+        w[j] += rPow[k] * iterate[j];
+        y[j] = iterate[j] + tau1 * zStep;
+        z[j] += zStep;
+        lastStep[j] = k + 1;
+      }
+
+      currentFunction += effectiveBatchSize;
+      fn += effectiveBatchSize;
+    }
+
+    // Bring every coordinate to the end of the outer iteration; the iterate is
+    // the one of the last step, as with the dense steps.
+    for (size_t j = 0; j < iterate.n_elem; ++j)
+    {
+      if (lastStep[j] < numSteps)
+      {
+        catchUp(j, numSteps - 1);
+        iterate[j] = tau1 * z[j] + tau2 * iterate0[j] + c * y[j];
+        catchUp(j, numSteps);
+      }
+      lastStep[j] = 0;
+    }
+
+    iterate0 = normalizer * w;
+  }
+
+  ENS_INFO << "Katyusha: maximum iterations (" << maxIterations << ") reached"
+      << "; terminating optimization." << std::endl;
+
+  // Calculate final objective.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+  }
+  return overallObjective;
+}
+
 } // namespace ens
 
 #endif
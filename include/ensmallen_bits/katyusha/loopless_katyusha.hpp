@@ -0,0 +1,188 @@
+/**
+ * @file loopless_katyusha.hpp
+ * @author Marcus Edel
+ *
+ * Loopless Katyusha (L-Katyusha), an accelerated variance reduced method
+ * without the outer loop.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_KATYUSHA_LOOPLESS_KATYUSHA_HPP
+#define ENSMALLEN_KATYUSHA_LOOPLESS_KATYUSHA_HPP
+
+namespace ens {
+
+/**
+ * Loopless Katyusha is the counterpart of Katyusha without the outer loop: as
+ * with LooplessSVRG, the snapshot is moved with probability p after every step
+ * (to the previous point of the y sequence), and the full gradient is computed
+ * at the new snapshot.  The Katyusha momentum parameters are derived from the
+ * convexity and the Lipschitz constant:
+ *
+ * \f[
+ * \sigma = \mu / L, \quad \theta_2 = 1 / 2, \quad
+ * \theta_1 = \min \left( \sqrt{2 \sigma / (3 p)}, 1 / 2 \right), \quad
+ * \eta = \frac{\theta_2}{(1 + \theta_2) \theta_1}.
+ * \f]
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Kovalev2020,
+ *   author    = {Kovalev, Dmitry and Horv{\'a}th, Samuel and
+ *                Richt{\'a}rik, Peter},
+ *   title     = {Don't Jump Through Hoops and Remove Those Loops: {SVRG} and
+ *                {Katyusha} are Better Without the Outer Loop},
+ *   booktitle = {Proceedings of the 31st International Conference on
+ *                Algorithmic Learning Theory},
+ *   pages     = {451--467},
+ *   year      = {2020}
+ * }
+ * @endcode
+ *
+ * LooplessKatyusha can optimize differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class LooplessKatyusha
+{
+ public:
+  /**
+   * Construct the loopless Katyusha optimizer with the given parameters.  The
+   * maximum number of iterations is the maximum number of steps, one batch
+   * each.
+   *
+   * @param convexity The strong convexity parameter of the mean function.
+   * @param lipschitz The Lipschitz constant of the gradient of the mean
+   *     function.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of steps allowed (0 means no limit).
+   * @param snapshotProbability Probability of moving the snapshot after each
+   *     step (0 means batchSize / n).
+   * @param tolerance Maximum absolute difference of the objective at two
+   *     successive snapshots to terminate the algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   * @param parallelFullGradient If true, compute the full gradient at each
+   *     snapshot with several OpenMP threads.
+   */
+  LooplessKatyusha(const double convexity = 1.0,
+                   const double lipschitz = 10.0,
+                   const size_t batchSize = 32,
+                   const size_t maxIterations = 100000,
+                   const double snapshotProbability = 0.0,
+                   const double tolerance = 1e-5,
+                   const bool shuffle = true,
+                   const bool parallelFullGradient = false);
+
+  /**
+   * Optimize the given function using loopless Katyusha.  The given starting
+   * point will be modified to store the finishing point of the algorithm (the
+   * last point of the y sequence, which the convergence guarantees are about),
+   * and the final objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch is the
+   * sequence of steps between two snapshots, and the objective and the
+   * gradient given to the callbacks are those of the snapshot.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the convexity parameter.
+  double Convexity() const { return convexity; }
+  //! Modify the convexity parameter.
+  double& Convexity() { return convexity; }
+
+  //! Get the lipschitz parameter.
+  double Lipschitz() const { return lipschitz; }
+  //! Modify the lipschitz parameter.
+  double& Lipschitz() { return lipschitz; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of steps (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of steps (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the snapshot probability (0 indicates batchSize / n).
+  double SnapshotProbability() const { return snapshotProbability; }
+  //! Modify the snapshot probability (0 indicates batchSize / n).
+  double& SnapshotProbability() { return snapshotProbability; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether the full gradient is computed in parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether the full gradient is computed in parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get the number of full gradients computed by the last call to
+  //! Optimize().
+  size_t Snapshots() const { return snapshots; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The strong convexity parameter.
+  double convexity;
+
+  //! The lipschitz constant.
+  double lipschitz;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed steps.
+  size_t maxIterations;
+
+  //! The probability of moving the snapshot after a step.
+  double snapshotProbability;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! Whether to compute the full gradient in parallel.
+  bool parallelFullGradient;
+
+  //! The number of full gradients computed by the last call to Optimize().
+  size_t snapshots;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "loopless_katyusha_impl.hpp"
+
+#endif
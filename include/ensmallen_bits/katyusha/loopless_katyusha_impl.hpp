@@ -0,0 +1,211 @@
+/**
+ * @file loopless_katyusha_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of loopless Katyusha (L-Katyusha).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_KATYUSHA_LOOPLESS_KATYUSHA_IMPL_HPP
+#define ENSMALLEN_KATYUSHA_LOOPLESS_KATYUSHA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "loopless_katyusha.hpp"
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+inline LooplessKatyusha::LooplessKatyusha(
+    const double convexity,
+    const double lipschitz,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double snapshotProbability,
+    const double tolerance,
+    const bool shuffle,
+    const bool parallelFullGradient) :
+    convexity(convexity),
+    lipschitz(lipschitz),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    snapshotProbability(snapshotProbability),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    parallelFullGradient(parallelFullGradient),
+    snapshots(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double LooplessKatyusha::Optimize(DecomposableFunctionType& function,
+                                  arma::mat& iterate,
+                                  CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // If the function can be evaluated on any set of indices, we hold the order
+  // of visitation ourselves and the function never has to be shuffled.
+  typedef VisitationOrder<DecomposableFunctionType> VisitationOrderType;
+  VisitationOrderType order(function);
+  typedef Function<typename VisitationOrderType::VisitedType>
+      VisitedFunctionType;
+  VisitedFunctionType& visited(
+      static_cast<VisitedFunctionType&>(order.Get()));
+
+  // Find the number of functions to use.
+  const size_t numFunctions = visited.NumFunctions();
+
+  // By default the snapshot moves once per pass over the data on average.
+  const double probability = (snapshotProbability == 0.0) ?
+      std::min(1.0, (double) batchSize / (double) numFunctions) :
+      snapshotProbability;
+
+  // The momentum parameters of L-Katyusha.
+  const double sigma = convexity / lipschitz;
+  const double tau2 = 0.5;
+  const double tau1 = std::min(0.5, std::sqrt(2.0 * sigma /
+      (3.0 * probability)));
+  const double eta = tau2 / ((1.0 + tau2) * tau1);
+
+  // To keep track of where we are and how things are going.
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+  snapshots = 0;
+
+  // The three sequences and the snapshot.  The new points of y and z are
+  // computed into their own buffers and swapped in, so that no step copies or
+  // allocates a matrix.
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat gradient0(iterate.n_rows, iterate.n_cols);
+  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat w = iterate;
+  arma::mat y = iterate;
+  arma::mat z = iterate;
+  arma::mat yNew(iterate.n_rows, iterate.n_cols);
+  arma::mat zNew(iterate.n_rows, iterate.n_cols);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  bool moveSnapshot = true;
+  size_t epoch = 0;
+  for (size_t i = 0, currentFunction = 0; i < actualMaxIterations &&
+      !terminate; ++i)
+  {
+    if (moveSnapshot)
+    {
+      if (i > 0)
+      {
+        terminate |= Callback::EndEpoch(*this, function, iterate, epoch++,
+            overallObjective, callbacks...);
+        if (terminate)
+          break;
+      }
+
+      // Calculate the objective function and the full gradient at the
+      // snapshot in one pass.
+      overallObjective = FullEvaluateWithGradient(visited, w, batchSize,
+          fullGradient, gradient, parallelFullGradient);
+      ++snapshots;
+
+      terminate |= Callback::Evaluate(*this, function, iterate,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "LooplessKatyusha: converged to " << overallObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        iterate = w;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "LooplessKatyusha: minimized within tolerance "
+            << tolerance << "; terminating optimization." << std::endl;
+        iterate = w;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      lastObjective = overallObjective;
+
+      terminate |= Callback::BeginEpoch(*this, function, iterate, epoch,
+          overallObjective, callbacks...);
+      terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+          callbacks...);
+      if (terminate)
+        break;
+    }
+
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0)
+    {
+      currentFunction = 0;
+
+      // Determine order of visitation.
+      if (shuffle)
+        visited.Shuffle();
+    }
+
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+
+    // The point the gradient is taken at.
+    iterate = tau1 * z + tau2 * w + (1 - tau1 - tau2) * y;
+
+    // Calculate variance reduced gradient.
+    visited.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+    visited.Gradient(w, currentFunction, gradient0, effectiveBatchSize);
+
+    // Regularized mirror step for z, and momentum step for y.
+    zNew = (eta * sigma * iterate + z - (eta / lipschitz) * (fullGradient +
+        (gradient - gradient0) / (double) effectiveBatchSize)) /
+        (1.0 + eta * sigma);
+    yNew = iterate + tau1 * (zNew - z);
+
+    // The snapshot moves to the previous point of y.
+    moveSnapshot = (Random().Uniform() < probability);
+    if (moveSnapshot)
+      w.swap(y);
+    y.swap(yNew);
+    z.swap(zNew);
+
+    terminate |= Callback::StepTaken(*this, function, iterate,
+        callbacks...);
+
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (!terminate)
+  {
+    ENS_INFO << "LooplessKatyusha: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  iterate = y;
+
+  // Calculate final objective.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += visited.Evaluate(iterate, i, effectiveBatchSize);
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
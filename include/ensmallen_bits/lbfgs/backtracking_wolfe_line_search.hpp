@@ -0,0 +1,172 @@
+/**
+ * @file backtracking_wolfe_line_search.hpp
+ * @author Dongryeol Lee
+ * @author Ryan Curtin
+ *
+ * Back-tracking line search for L_BFGS.  Used as LineSearchType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_BACKTRACKING_WOLFE_LINE_SEARCH_HPP
+#define ENSMALLEN_LBFGS_BACKTRACKING_WOLFE_LINE_SEARCH_HPP
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+/**
+ * Back-tracking line search, which starts every search with a step of 1, and
+ * halves or expands the step until it satisfies the strong Wolfe conditions.
+ * The parameters of the search (Armijo constant, Wolfe parameter, minimum and
+ * maximum step, and number of trials) are those of the optimizer.
+ */
+class BacktrackingWolfeLineSearch
+{
+ public:
+  /**
+   * Construct the back-tracking line search.
+   */
+  BacktrackingWolfeLineSearch() { /* Do nothing. */ }
+
+  /**
+   * Perform a back-tracking line search along the search direction to
+   * calculate a step size satisfying the Wolfe conditions.  The parameter
+   * iterate will be modified if the method is successful.
+   *
+   * @param optimizer The optimizer, which holds the parameters of the search.
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param newIterateTmp Matrix to hold the trial points.
+   * @param searchDirection A vector specifying the search direction.
+   * @param iterationNum The iteration number of the optimizer (not used).
+   * @param terminate Set to true if a callback requests termination.
+   * @param callbacks Callback functions.
+   *
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename... CallbackTypes>
+  bool Search(OptimizerType& optimizer,
+              FunctionType& function,
+              double& functionValue,
+              arma::mat& iterate,
+              arma::mat& gradient,
+              arma::mat& newIterateTmp,
+              const arma::mat& searchDirection,
+              const size_t /* iterationNum */,
+              bool& terminate,
+              CallbackTypes&... callbacks)
+  {
+    ENS_TRACE_ZONE("LineSearch");
+
+    // Default first step size of 1.0.
+    double stepSize = 1.0;
+
+    // The initial linear term approximation in the direction of the
+    // search direction.
+    double initialSearchDirectionDotGradient =
+        arma::dot(gradient, searchDirection);
+
+    // If it is not a descent direction, just report failure.
+    if (initialSearchDirectionDotGradient > 0.0)
+    {
+      ENS_WARN << "L-BFGS line search direction is not a descent direction "
+          << "(terminating)!" << std::endl;
+      return false;
+    }
+
+    // Save the initial function value.
+    double initialFunctionValue = functionValue;
+
+    // Unit linear approximation to the decrease in function value.
+    double linearApproxFunctionValueDecrease = optimizer.ArmijoConstant() *
+        initialSearchDirectionDotGradient;
+
+    // The number of iteration in the search.
+    size_t numIterations = 0;
+
+    // Armijo step size scaling factor for increase and decrease.
+    const double inc = 2.1;
+    const double dec = 0.5;
+    double width = 0;
+    double bestStepSize = 1.0;
+    double bestObjective = std::numeric_limits<double>::max();
+
+    while (true)
+    {
+      // Perform a step and evaluate the gradient and the function values at
+      // that point.
+      newIterateTmp = iterate;
+      newIterateTmp += stepSize * searchDirection;
+      functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+      if (functionValue < bestObjective)
+      {
+        bestStepSize = stepSize;
+        bestObjective = functionValue;
+      }
+      numIterations++;
+
+      terminate |= Callback::Evaluate(optimizer, function, newIterateTmp,
+          functionValue, callbacks...);
+      terminate |= Callback::Gradient(optimizer, function, newIterateTmp,
+          gradient, callbacks...);
+      if (terminate)
+        break;
+
+      if (functionValue > initialFunctionValue + stepSize *
+          linearApproxFunctionValueDecrease)
+      {
+        width = dec;
+      }
+      else
+      {
+        // Check Wolfe's condition.
+        double searchDirectionDotGradient = arma::dot(gradient,
+            searchDirection);
+
+        if (searchDirectionDotGradient < optimizer.Wolfe() *
+            initialSearchDirectionDotGradient)
+        {
+          width = inc;
+        }
+        else
+        {
+          if (searchDirectionDotGradient > -optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            width = dec;
+          }
+          else
+          {
+            break;
+          }
+        }
+      }
+
+      // Terminate when the step size gets too small or too big or it
+      // exceeds the max number of iterations.
+      const bool cond1 = (stepSize < optimizer.MinStep());
+      const bool cond2 = (stepSize > optimizer.MaxStep());
+      const bool cond3 = (numIterations >= optimizer.MaxLineSearchTrials());
+      if (cond1 || cond2 || cond3)
+        break;
+
+      // Scale the step size.
+      stepSize *= width;
+    }
+
+    // Move to the new iterate.
+    iterate += bestStepSize * searchDirection;
+    return true;
+  }
+};
+
+} // namespace ens
+
+#endif
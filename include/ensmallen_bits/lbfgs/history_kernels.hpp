@@ -0,0 +1,179 @@
+/**
+ * @file history_kernels.hpp
+ * @author Ryan Curtin
+ *
+ * Inner product and axpy kernels used by L_BFGS on its history, which may be
+ * stored in single precision, and the two-loop recursion built on them.
+ * Products are always accumulated in double precision; the overloads for
+ * double use BLAS.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_HISTORY_KERNELS_HPP
+#define ENSMALLEN_LBFGS_HISTORY_KERNELS_HPP
+
+namespace ens {
+namespace math {
+
+//! Inner product of n elements, accumulated in double precision.
+template<typename ElemType1, typename ElemType2>
+inline double Dot(const size_t n, const ElemType1* a, const ElemType2* b)
+{
+  double result = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    result += double(a[i]) * double(b[i]);
+
+  return result;
+}
+
+//! Inner product of n elements, using BLAS.
+inline double Dot(const size_t n, const double* a, const double* b)
+{
+  // We promise to be well-behaved... the elements won't be modified.
+  return arma::dot(arma::vec(const_cast<double*>(a), n, false, true),
+                   arma::vec(const_cast<double*>(b), n, false, true));
+}
+
+//! Add alpha * x to y, for n elements.
+template<typename ElemType>
+inline void Axpy(const size_t n,
+                 const double alpha,
+                 const ElemType* x,
+                 double* y)
+{
+  for (size_t i = 0; i < n; ++i)
+    y[i] += alpha * double(x[i]);
+}
+
+//! Add alpha * x to y, for n elements, using BLAS.
+inline void Axpy(const size_t n, const double alpha, const double* x, double* y)
+{
+  arma::vec yVec(y, n, false, true);
+  yVec += alpha * arma::vec(const_cast<double*>(x), n, false, true);
+}
+
+//! Compute m^T v, accumulated in double precision.
+template<typename ElemType1, typename ElemType2>
+inline arma::vec TransposeProduct(const arma::Mat<ElemType1>& m,
+                                  const ElemType2* v)
+{
+  arma::vec result(m.n_cols);
+  for (size_t k = 0; k < m.n_cols; ++k)
+    result[k] = Dot(m.n_rows, m.colptr(k), v);
+
+  return result;
+}
+
+//! Compute m^T v, using BLAS.
+inline arma::vec TransposeProduct(const arma::mat& m, const double* v)
+{
+  return m.t() * arma::vec(const_cast<double*>(v), m.n_rows, false, true);
+}
+
+//! Add m * a to y.
+template<typename ElemType>
+inline void AddProduct(const arma::Mat<ElemType>& m,
+                       const arma::vec& a,
+                       arma::vec& y)
+{
+  for (size_t k = 0; k < m.n_cols; ++k)
+    Axpy(m.n_rows, a[k], m.colptr(k), y.memptr());
+}
+
+//! Add m * a to y, using BLAS.
+inline void AddProduct(const arma::mat& m, const arma::vec& a, arma::vec& y)
+{
+  y += m * a;
+}
+
+/**
+ * Compute the quasi-Newton search direction -H g with the two-loop recursion,
+ * where H is the limited-memory BFGS approximation of the inverse Hessian
+ * built from the last pairs of differences of the iterates and the gradients.
+ * Pair k is stored in slice k % numBasis of s and y.  The initial inverse
+ * Hessian approximation H0 is applied by initialHessian(v), which multiplies v
+ * by H0 in place.
+ *
+ * @param gradient The gradient at the current point.
+ * @param pairs The number of pairs stored so far.
+ * @param numBasis The number of slices of s and y.
+ * @param initialHessian Function that multiplies a matrix by H0.
+ * @param s Differences between the iterates.
+ * @param y Differences between the gradients.
+ * @param searchDirection Matrix to store the search direction in.
+ */
+template<typename CubeType, typename InitialHessianType>
+inline void TwoLoopRecursion(const arma::mat& gradient,
+                             const size_t pairs,
+                             const size_t numBasis,
+                             const InitialHessianType& initialHessian,
+                             const CubeType& s,
+                             const CubeType& y,
+                             arma::mat& searchDirection)
+{
+  // Start from this point.
+  searchDirection = gradient;
+
+  // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
+  // matrices with limited storage" (Nocedal, 1980).
+
+  // Temporary variables.
+  const size_t n = gradient.n_elem;
+  arma::vec rho(numBasis);
+  arma::vec alpha(numBasis);
+
+  size_t limit = (numBasis > pairs) ? 0 : (pairs - numBasis);
+  for (size_t i = pairs; i != limit; i--)
+  {
+    int translatedPosition = (i + (numBasis - 1)) % numBasis;
+    const typename CubeType::elem_type* sMem =
+        s.slice_memptr(translatedPosition);
+    const typename CubeType::elem_type* yMem =
+        y.slice_memptr(translatedPosition);
+    rho[pairs - i] = 1.0 / Dot(n, yMem, sMem);
+    alpha[pairs - i] = rho[pairs - i] *
+        Dot(n, sMem, searchDirection.memptr());
+    Axpy(n, -alpha[pairs - i], yMem, searchDirection.memptr());
+  }
+
+  initialHessian(searchDirection);
+
+  for (size_t i = limit; i < pairs; i++)
+  {
+    int translatedPosition = i % numBasis;
+    double beta = rho[pairs - i - 1] * Dot(n,
+        y.slice_memptr(translatedPosition), searchDirection.memptr());
+    Axpy(n, alpha[pairs - i - 1] - beta,
+        s.slice_memptr(translatedPosition), searchDirection.memptr());
+  }
+
+  // Negate the search direction so that it is a descent direction.
+  searchDirection *= -1;
+}
+
+/**
+ * Compute the quasi-Newton search direction -H g with the two-loop recursion,
+ * with the initial inverse Hessian approximation H0 = scalingFactor * I; see
+ * above.
+ */
+template<typename CubeType>
+inline void TwoLoopRecursion(const arma::mat& gradient,
+                             const size_t pairs,
+                             const size_t numBasis,
+                             const double scalingFactor,
+                             const CubeType& s,
+                             const CubeType& y,
+                             arma::mat& searchDirection)
+{
+  TwoLoopRecursion(gradient, pairs, numBasis,
+      [scalingFactor](arma::mat& v) { v *= scalingFactor; }, s, y,
+      searchDirection);
+}
+
+} // namespace math
+} // namespace ens
+
+#endif
@@ -14,20 +14,65 @@
 #define ENSMALLEN_LBFGS_LBFGS_HPP
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/any.hpp>
+#include "history_kernels.hpp"
+#include "lbfgs_history.hpp"
+#include "backtracking_wolfe_line_search.hpp"
+#include "more_thuente_line_search.hpp"
+#include "speculative_line_search.hpp"
+#include "preconditioners.hpp"
 
 namespace ens {
 
+// Forward declaration; see lbfgs_stepper.hpp.
+template<typename OptimizerType, typename FunctionType, typename MatType>
+class L_BFGSStepper;
+
 /**
- * The L-BFGS optimizer, which uses a back-tracking line search algorithm to
- * minimize a function.  The parameters for the algorithm (number of memory
- * points, maximum step size, and so forth) are all configurable via either the
+ * The L-BFGS optimizer, which uses a line search algorithm to minimize a
+ * function.  The parameters for the algorithm (number of memory points,
+ * maximum step size, and so forth) are all configurable via either the
  * constructor or standalone modifier functions.
  *
+ * The line search is given by LineSearchType; BacktrackingWolfeLineSearch (the
+ * default), MoreThuenteLineSearch and SpeculativeLineSearch are available.  A
+ * line search policy must provide the following method:
+ *
+ *   template<typename OptimizerType,
+ *            typename FunctionType,
+ *            typename... CallbackTypes>
+ *   bool Search(OptimizerType& optimizer,
+ *               FunctionType& function,
+ *               double& functionValue,
+ *               arma::mat& iterate,
+ *               arma::mat& gradient,
+ *               arma::mat& newIterateTmp,
+ *               const arma::mat& searchDirection,
+ *               const size_t iterationNum,
+ *               bool& terminate,
+ *               CallbackTypes&... callbacks);
+ *
+ * which moves iterate along the search direction and leaves the objective and
+ * the gradient at the new iterate in functionValue and gradient.  The
+ * parameters of the search (ArmijoConstant(), Wolfe(), MinStep(), MaxStep()
+ * and MaxLineSearchTrials()) are taken from the optimizer.
+ *
+ * The initial inverse Hessian approximation of the two-loop recursion is given
+ * by PreconditionerType; IdentityPreconditioner (the default, the usual scaled
+ * identity) and DiagonalPreconditioner are available (see preconditioners.hpp
+ * for the interface).  The compact representation is only used with
+ * IdentityPreconditioner.
+ *
  * L_BFGS can optimize differentiable functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * @tparam LineSearchType Line search policy.
+ * @tparam PreconditionerType Initial inverse Hessian approximation policy.
  */
-class L_BFGS
+template<typename LineSearchType = BacktrackingWolfeLineSearch,
+         typename PreconditionerType = IdentityPreconditioner>
+class L_BFGSType
 {
  public:
   /**
@@ -48,16 +93,32 @@ class L_BFGS
    *     (before giving up).
    * @param minStep The minimum step of the line search.
    * @param maxStep The maximum step of the line search.
+   * @param compact If true, compute the search direction with the compact
+   *     representation of the inverse Hessian approximation instead of the
+   *     two-loop recursion.
+   * @param floatHistory If true, store the differences of the iterates and
+   *     the gradients in single precision, which halves the memory used by
+   *     the history.
+   * @param warmStart If true, keep the history of the last call to Optimize()
+   *     and continue with it in the next call, instead of starting over with
+   *     the scaled negative gradient.
+   * @param lineSearch The line search policy.
+   * @param preconditioner The initial inverse Hessian approximation policy.
    */
-  L_BFGS(const size_t numBasis = 10, /* same default as scipy */
-         const size_t maxIterations = 10000, /* many but not infinite */
-         const double armijoConstant = 1e-4,
-         const double wolfe = 0.9,
-         const double minGradientNorm = 1e-6,
-         const double factr = 1e-15,
-         const size_t maxLineSearchTrials = 50,
-         const double minStep = 1e-20,
-         const double maxStep = 1e20);
+  L_BFGSType(const size_t numBasis = 10, /* same default as scipy */
+             const size_t maxIterations = 10000, /* many but not infinite */
+             const double armijoConstant = 1e-4,
+             const double wolfe = 0.9,
+             const double minGradientNorm = 1e-6,
+             const double factr = 1e-15,
+             const size_t maxLineSearchTrials = 50,
+             const double minStep = 1e-20,
+             const double maxStep = 1e20,
+             const bool compact = false,
+             const bool floatHistory = false,
+             const bool warmStart = false,
+             const LineSearchType& lineSearch = LineSearchType(),
+             const PreconditionerType& preconditioner = PreconditionerType());
 
   /**
    * Return the point where the lowest function value has been found.
@@ -75,13 +136,77 @@ class L_BFGS
    * given starting point will be modified to store the finishing point of the
    * algorithm, and the final objective value is returned.
    *
+   * Any number of callbacks may be given after the iterate; an epoch of L-BFGS
+   * is one iteration, and every evaluation in the line search is reported.
+   * To run the optimization a few iterations at a time, use an L_BFGSStepper
+   * (see MakeStepper()).
+   *
+   * If WarmStart() is set, the pairs of differences of the iterates and the
+   * gradients stored in the last call are used from the first iteration on,
+   * as long as the iterate has the same size and NumBasis(), Compact() and
+   * FloatHistory() did not change; this lets repeated optimizations of a
+   * slowly changing function (e.g. a model refit on a sliding window)
+   * converge in fewer iterations.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Optimize the given function, starting at the given fixed-size point; see
+   * above.  The gradient, the search direction and the other buffers of the
+   * optimization (including those of the line search) are fixed-size matrices
+   * of the same size, so they are stored in the objects themselves instead of
+   * on the heap, and their sizes are known at compile time.  This is for small
+   * problems (e.g. with 2 or 6 coordinates) that are solved many times, where
+   * the allocations would dominate.
+   *
    * @tparam FunctionType Type of the function to be optimized.
+   * @tparam Rows Number of rows of the iterate.
+   * @tparam Cols Number of columns of the iterate.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize; must have Evaluate() and Gradient().
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType,
+           arma::uword Rows,
+           arma::uword Cols,
+           typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat::fixed<Rows, Cols>& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Optimize the given function, starting at the given fixed-size column
+  //! vector; see above.
+  template<typename FunctionType, arma::uword Rows, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::vec::fixed<Rows>& iterate,
+                  CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for an iterate
+   * of the given size (see ens::MemoryEstimate()): the 2 * NumBasis() stored
+   * differences of the iterates and the gradients (in single precision with
+   * FloatHistory()), and the gradients, the search direction and the other
+   * buffers of the size of the iterate.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param numFunctions Ignored; the function is not separable.
+   */
+  size_t MemoryEstimate(const size_t rows,
+                        const size_t cols,
+                        const size_t numFunctions = 1) const;
 
   //! Get the memory size.
   size_t NumBasis() const { return numBasis; }
@@ -128,7 +253,45 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
+  //! Get whether the compact representation is used for the search direction.
+  bool Compact() const { return compact; }
+  //! Modify whether the compact representation is used for the search
+  //! direction.
+  bool& Compact() { return compact; }
+
+  //! Get whether the history is stored in single precision.
+  bool FloatHistory() const { return floatHistory; }
+  //! Modify whether the history is stored in single precision.
+  bool& FloatHistory() { return floatHistory; }
+
+  //! Get whether the history is kept between calls to Optimize().
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether the history is kept between calls to Optimize().
+  bool& WarmStart() { return warmStart; }
+
+  //! Get the line search policy.
+  const LineSearchType& LineSearch() const { return lineSearch; }
+  //! Modify the line search policy.
+  LineSearchType& LineSearch() { return lineSearch; }
+
+  //! Get the preconditioner policy.
+  const PreconditionerType& Preconditioner() const { return preconditioner; }
+  //! Modify the preconditioner policy.
+  PreconditionerType& Preconditioner() { return preconditioner; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  //! OnlineL_BFGS takes its search directions and stores its pairs with the
+  //! methods of L_BFGS.
+  friend class OnlineL_BFGS;
+
+  //! L_BFGSStepper runs the iterations of Optimize() with its copy of the
+  //! optimizer.
+  template<typename, typename, typename>
+  friend class L_BFGSStepper;
+
   //! Size of memory for this L-BFGS optimizer.
   size_t numBasis;
   //! Maximum number of iterations.
@@ -147,6 +310,84 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! Whether to use the compact representation for the search direction.
+  bool compact;
+  //! Whether to store the history in single precision.
+  bool floatHistory;
+  //! Whether to keep the history between calls to Optimize().
+  bool warmStart;
+  //! The line search policy.
+  LineSearchType lineSearch;
+  //! The initial inverse Hessian approximation policy.
+  PreconditionerType preconditioner;
+
+  //! The basis sets of an optimization; see LBFGSHistory.
+  template<typename CubeType>
+  using History = LBFGSHistory<CubeType>;
+
+  //! The history of the last call to Optimize().  It is continued by the next
+  //! call if warm starting, and otherwise only its memory is reused.
+  Any history;
+
+  /**
+   * The buffers of an optimization, which are kept between calls to
+   * Optimize() so that repeated optimizations of iterates of the same size do
+   * not allocate memory.
+   *
+   * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix).
+   */
+  template<typename MatType>
+  struct Workspace
+  {
+    //! The trial points of the line search.
+    MatType newIterateTmp;
+    //! The iterate before the last step.
+    MatType oldIterate;
+    //! The gradient at the current iterate.
+    MatType gradient;
+    //! The gradient at the old iterate.
+    MatType oldGradient;
+    //! The search direction.
+    MatType searchDirection;
+  };
+
+  //! The buffers of the last call to Optimize(); their type depends on the
+  //! type of the iterate used in that call.
+  Any workspace;
+
+  /**
+   * Use L-BFGS to optimize the given function, with buffers of the given
+   * matrix type, which has the size of the iterate.
+   *
+   * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix).
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename MatType, typename FunctionType, typename... CallbackTypes>
+  double OptimizeWithBuffers(FunctionType& function,
+                             arma::mat& iterate,
+                             CallbackTypes&... callbacks);
+
+  /**
+   * Use L-BFGS to optimize the given function, storing the differences of the
+   * iterates and the gradients in the given cube type.
+   *
+   * @tparam CubeType Type of the history (arma::cube or arma::fcube).
+   * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix).
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename CubeType,
+           typename MatType,
+           typename FunctionType,
+           typename... CallbackTypes>
+  double OptimizeWithHistory(FunctionType& function,
+                             arma::mat& iterate,
+                             CallbackTypes&... callbacks);
 
   /**
    * Calculate the scaling factor, gamma, which is used to scale the Hessian
@@ -158,32 +399,11 @@ class L_BFGS
    * @param s Differences between the iterate and old iterate matrix.
    * @param y Differences between the gradient and the old gradient matrix.
    */
+  template<typename CubeType>
   double ChooseScalingFactor(const size_t iterationNum,
                              const arma::mat& gradient,
-                             const arma::cube& s,
-                             const arma::cube& y);
-
-  /**
-   * Perform a back-tracking line search along the search direction to
-   * calculate a step size satisfying the Wolfe conditions.  The parameter
-   * iterate will be modified if the method is successful.
-   *
-   * @param function Function to optimize.
-   * @param functionValue Value of the function at the initial point.
-   * @param iterate The initial point to begin the line search from.
-   * @param gradient The gradient at the initial point.
-   * @param searchDirection A vector specifying the search direction.
-   * @param stepSize Variable the calculated step size will be stored in.
-   *
-   * @return false if no step size is suitable, true otherwise.
-   */
-  template<typename FunctionType>
-  bool LineSearch(FunctionType& function,
-                  double& functionValue,
-                  arma::mat& iterate,
-                  arma::mat& gradient,
-                  arma::mat& newIterateTmp,
-                  const arma::mat& searchDirection);
+                             const CubeType& s,
+                             const CubeType& y);
 
   /**
    * Find the L-BFGS search direction.
@@ -195,13 +415,58 @@ class L_BFGS
    * @param y Differences between the gradient and the old gradient matrix.
    * @param searchDirection Vector to store search direction in.
    */
+  template<typename CubeType>
   void SearchDirection(const arma::mat& gradient,
                        const size_t iterationNum,
                        const double scalingFactor,
-                       const arma::cube& s,
-                       const arma::cube& y,
+                       const CubeType& s,
+                       const CubeType& y,
                        arma::mat& searchDirection);
 
+  /**
+   * Find the L-BFGS search direction with the compact representation of the
+   * inverse Hessian approximation (Byrd, Nocedal and Schnabel, 1994).  The
+   * histories are used as n x numBasis matrices, so the direction takes four
+   * matrix-vector products instead of 4 * numBasis passes over the iterate.
+   *
+   * @param gradient The gradient at the current point.
+   * @param iterationNum The iteration number.
+   * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
+   * @param s Differences between the iterate and old iterate matrix.
+   * @param y Differences between the gradient and the old gradient matrix.
+   * @param sy Inner products of the columns of s and y (see
+   *     UpdateInnerProducts()).
+   * @param yy Inner products of the columns of y.
+   * @param searchDirection Vector to store search direction in.
+   */
+  template<typename CubeType>
+  void CompactSearchDirection(const arma::mat& gradient,
+                              const size_t iterationNum,
+                              const double scalingFactor,
+                              const CubeType& s,
+                              const CubeType& y,
+                              const arma::mat& sy,
+                              const arma::mat& yy,
+                              arma::mat& searchDirection);
+
+  /**
+   * Update the inner products used by CompactSearchDirection() after the
+   * basis set at the given iteration has been overwritten.
+   *
+   * @param iterationNum Iteration number.
+   * @param s Differences between the iterate and old iterate matrix.
+   * @param y Differences between the gradient and the old gradient matrix.
+   * @param sy Inner products of the columns of s and y; sy(i, j) holds the
+   *     inner product of slice i of s and slice j of y.
+   * @param yy Inner products of the columns of y.
+   */
+  template<typename CubeType>
+  void UpdateInnerProducts(const size_t iterationNum,
+                           const CubeType& s,
+                           const CubeType& y,
+                           arma::mat& sy,
+                           arma::mat& yy);
+
   /**
    * Update the y and s matrices, which store the differences
    * between the iterate and old iterate and the differences between the
@@ -215,18 +480,26 @@ class L_BFGS
    * @param s Differences between the iterate and old iterate matrix.
    * @param y Differences between the gradient and the old gradient matrix.
    */
+  template<typename CubeType>
   void UpdateBasisSet(const size_t iterationNum,
                       const arma::mat& iterate,
                       const arma::mat& oldIterate,
                       const arma::mat& gradient,
                       const arma::mat& oldGradient,
-                      arma::cube& s,
-                      arma::cube& y);
+                      CubeType& s,
+                      CubeType& y);
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
+//! L-BFGS with the back-tracking line search.
+typedef L_BFGSType<BacktrackingWolfeLineSearch> L_BFGS;
+
 } // namespace ens
 
 #include "lbfgs_impl.hpp"
+#include "lbfgs_stepper.hpp"
 
 #endif // ENSMALLEN_LBFGS_LBFGS_HPP
 
@@ -0,0 +1,257 @@
+/**
+ * @file lbfgs_b.hpp
+ * @author Ryan Curtin
+ *
+ * The L-BFGS-B optimizer, for differentiable functions with box constraints.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_HPP
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/any.hpp>
+#include "history_kernels.hpp"
+#include "lbfgs_history.hpp"
+
+namespace ens {
+
+/**
+ * L-BFGS-B minimizes a differentiable function subject to the box constraints
+ * lowerBound <= x <= upperBound.  Each iteration finds the generalized Cauchy
+ * point, which is the first local minimizer of the quadratic model along the
+ * projected steepest descent path; the coordinates at a bound at that point
+ * are fixed, and the quadratic model is minimized over the other (free)
+ * coordinates.  The step to the result is then taken with a backtracking line
+ * search.  The L-BFGS approximation of the Hessian is used in its compact
+ * representation, B = theta I - W M W^T, so that both steps cost O(n m) for m
+ * stored pairs.  The pairs are stored as for L_BFGS (see LBFGSHistory).
+ *
+ * Because the iterates never leave the box, this converges much faster than
+ * clamping the iterates of L_BFGS, which invalidates its curvature pairs.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @article{byrd1995limited,
+ *   title   = {A Limited Memory Algorithm for Bound Constrained Optimization},
+ *   author  = {Byrd, Richard H. and Lu, Peihuang and Nocedal, Jorge and
+ *              Zhu, Ciyou},
+ *   journal = {SIAM Journal on Scientific Computing},
+ *   volume  = {16},
+ *   number  = {5},
+ *   pages   = {1190--1208},
+ *   year    = {1995}
+ * }
+ * @endcode
+ *
+ * L_BFGS_B can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class L_BFGS_B
+{
+ public:
+  /**
+   * Initialize the L-BFGS-B object with the same bounds for every coordinate.
+   * The other parameters have the same meaning as for L_BFGS.
+   *
+   * @param lowerBound Lower bound of the coordinates.
+   * @param upperBound Upper bound of the coordinates.
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum maximum-norm of the projected gradient
+   *     required to continue the optimization.
+   * @param factr Minimum relative function value decrease to continue
+   *     the optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   */
+  L_BFGS_B(const double lowerBound = -DBL_MAX,
+           const double upperBound = DBL_MAX,
+           const size_t numBasis = 10,
+           const size_t maxIterations = 10000,
+           const double armijoConstant = 1e-4,
+           const double minGradientNorm = 1e-6,
+           const double factr = 1e-15,
+           const size_t maxLineSearchTrials = 50,
+           const double minStep = 1e-20);
+
+  /**
+   * Initialize the L-BFGS-B object with a bound for each coordinate; the
+   * bounds must have the size of the iterate.  See the constructor above for
+   * the other parameters.
+   */
+  L_BFGS_B(const arma::mat& lowerBound,
+           const arma::mat& upperBound,
+           const size_t numBasis = 10,
+           const size_t maxIterations = 10000,
+           const double armijoConstant = 1e-4,
+           const double minGradientNorm = 1e-6,
+           const double factr = 1e-15,
+           const size_t maxLineSearchTrials = 50,
+           const double minStep = 1e-20);
+
+  /**
+   * Use L-BFGS-B to optimize the given function within the bounds, starting at
+   * the given iterate point (which is first projected onto the bounds) and
+   * finding the minimum.  The given starting point will be modified to store
+   * the finishing point of the algorithm, and the final objective value is
+   * returned.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the lower bound (a 1x1 matrix if it is the same for every
+  //! coordinate).
+  const arma::mat& LowerBound() const { return lowerBound; }
+  //! Modify the lower bound.
+  arma::mat& LowerBound() { return lowerBound; }
+
+  //! Get the upper bound (a 1x1 matrix if it is the same for every
+  //! coordinate).
+  const arma::mat& UpperBound() const { return upperBound; }
+  //! Modify the upper bound.
+  arma::mat& UpperBound() { return upperBound; }
+
+  //! Get the memory size.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the memory size.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the minimum projected gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum projected gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Return the minimum line search step size.
+  double MinStep() const { return minStep; }
+  //! Modify the minimum line search step size.
+  double& MinStep() { return minStep; }
+
+ private:
+  //! The lower bound of the coordinates.
+  arma::mat lowerBound;
+  //! The upper bound of the coordinates.
+  arma::mat upperBound;
+  //! Size of memory for this optimizer.
+  size_t numBasis;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+  //! Minimum projected gradient norm required to continue the optimization.
+  double minGradientNorm;
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+  //! Maximum number of trials for the line search.
+  size_t maxLineSearchTrials;
+  //! Minimum step of the line search.
+  double minStep;
+
+  //! The history of the last call to Optimize(); only its memory is reused.
+  Any history;
+
+  //! Inner products s_i^T y_j of the stored pairs, indexed by slice.
+  arma::mat sy;
+  //! Inner products s_i^T s_j of the stored pairs, indexed by slice.
+  arma::mat ss;
+
+  //! W = [Y, theta S] of the compact representation, oldest pair first.
+  arma::mat w;
+  //! The middle matrix M of the compact representation.
+  arma::mat m;
+
+  //! Return the lower bound of coordinate i.
+  double Lower(const size_t i) const
+  { return (lowerBound.n_elem == 1) ? lowerBound[0] : lowerBound[i]; }
+
+  //! Return the upper bound of coordinate i.
+  double Upper(const size_t i) const
+  { return (upperBound.n_elem == 1) ? upperBound[0] : upperBound[i]; }
+
+  /**
+   * Build W and M for the pairs stored in the history.
+   *
+   * @param history The history.
+   * @param theta Scaling of the initial Hessian approximation.
+   * @return false if M could not be computed.
+   */
+  bool CompactRepresentation(const LBFGSHistory<arma::cube>& history,
+                             const double theta);
+
+  /**
+   * Compute the generalized Cauchy point, and the vector c = W^T (xCauchy - x)
+   * needed by the subspace minimization.
+   *
+   * @param iterate The current point.
+   * @param gradient The gradient at the current point.
+   * @param theta Scaling of the initial Hessian approximation.
+   * @param cauchy Matrix to store the generalized Cauchy point in.
+   * @param c Vector to store W^T (cauchy - iterate) in.
+   */
+  void CauchyPoint(const arma::mat& iterate,
+                   const arma::mat& gradient,
+                   const double theta,
+                   arma::mat& cauchy,
+                   arma::vec& c) const;
+
+  /**
+   * Minimize the quadratic model over the coordinates that are not at a bound
+   * at the generalized Cauchy point, starting from it, and truncate the step
+   * to stay within the bounds.
+   *
+   * @param iterate The current point.
+   * @param gradient The gradient at the current point.
+   * @param theta Scaling of the initial Hessian approximation.
+   * @param c W^T (cauchy - iterate).
+   * @param cauchy The generalized Cauchy point; the result is stored in it.
+   */
+  void SubspaceMinimization(const arma::mat& iterate,
+                            const arma::mat& gradient,
+                            const double theta,
+                            const arma::vec& c,
+                            arma::mat& cauchy) const;
+};
+
+} // namespace ens
+
+#include "lbfgs_b_impl.hpp"
+
+#endif // ENSMALLEN_LBFGS_LBFGS_B_HPP
@@ -0,0 +1,516 @@
+/**
+ * @file lbfgs_b_impl.hpp
+ * @author Ryan Curtin
+ *
+ * The implementation of the L-BFGS-B optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lbfgs_b.hpp"
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+inline L_BFGS_B::L_BFGS_B(const double lowerBound,
+                          const double upperBound,
+                          const size_t numBasis,
+                          const size_t maxIterations,
+                          const double armijoConstant,
+                          const double minGradientNorm,
+                          const double factr,
+                          const size_t maxLineSearchTrials,
+                          const double minStep) :
+    lowerBound(1, 1),
+    upperBound(1, 1),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    minStep(minStep)
+{
+  this->lowerBound[0] = lowerBound;
+  this->upperBound[0] = upperBound;
+}
+
+inline L_BFGS_B::L_BFGS_B(const arma::mat& lowerBound,
+                          const arma::mat& upperBound,
+                          const size_t numBasis,
+                          const size_t maxIterations,
+                          const double armijoConstant,
+                          const double minGradientNorm,
+                          const double factr,
+                          const size_t maxLineSearchTrials,
+                          const double minStep) :
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    minStep(minStep)
+{
+  // Nothing to do.
+}
+
+inline bool L_BFGS_B::CompactRepresentation(
+    const LBFGSHistory<arma::cube>& history,
+    const double theta)
+{
+  const size_t n = history.s.n_rows * history.s.n_cols;
+  const size_t count = std::min(history.pairs, numBasis);
+  w.set_size(n, 2 * count);
+  if (count == 0)
+  {
+    m.reset();
+    return true;
+  }
+
+  // The positions of the stored pairs, from the oldest to the newest.
+  arma::uvec order(count);
+  for (size_t k = 0; k < count; ++k)
+    order[k] = (history.pairs - count + k) % numBasis;
+
+  for (size_t k = 0; k < count; ++k)
+  {
+    std::copy(history.y.slice_memptr(order[k]),
+        history.y.slice_memptr(order[k]) + n, w.colptr(k));
+    const double* sMem = history.s.slice_memptr(order[k]);
+    double* wMem = w.colptr(count + k);
+    for (size_t i = 0; i < n; ++i)
+      wMem[i] = theta * sMem[i];
+  }
+
+  // See equation (3.4) of Byrd et al. (1995):
+  //
+  //   M = [ -D   L^T         ]^-1
+  //       [  L   theta S^T S ]
+  //
+  // where D is the diagonal of S^T Y and L its strictly lower triangle.
+  const arma::mat syOrdered = sy.submat(order, order);
+  arma::mat mInv(2 * count, 2 * count, arma::fill::zeros);
+  for (size_t j = 0; j < count; ++j)
+  {
+    mInv(j, j) = -syOrdered(j, j);
+    for (size_t i = j + 1; i < count; ++i)
+    {
+      mInv(count + i, j) = syOrdered(i, j);
+      mInv(j, count + i) = syOrdered(i, j);
+    }
+  }
+  mInv.submat(count, count, 2 * count - 1, 2 * count - 1) =
+      theta * ss.submat(order, order);
+
+  return arma::inv(m, mInv);
+}
+
+inline void L_BFGS_B::CauchyPoint(const arma::mat& iterate,
+                                  const arma::mat& gradient,
+                                  const double theta,
+                                  arma::mat& cauchy,
+                                  arma::vec& c) const
+{
+  const size_t n = iterate.n_elem;
+  cauchy = iterate;
+  c.zeros(w.n_cols);
+
+  // The breakpoints t of the projected steepest descent path x(t) = P(x - t g),
+  // and the direction d of its first segment.
+  arma::vec t(n);
+  arma::vec d(n);
+  std::vector<size_t> breakpoints;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (gradient[i] < 0.0)
+      t[i] = (iterate[i] - Upper(i)) / gradient[i];
+    else if (gradient[i] > 0.0)
+      t[i] = (iterate[i] - Lower(i)) / gradient[i];
+    else
+      t[i] = DBL_MAX;
+
+    if (t[i] > 0.0 && gradient[i] != 0.0)
+    {
+      d[i] = -gradient[i];
+      breakpoints.push_back(i);
+    }
+    else
+    {
+      d[i] = 0.0;
+    }
+  }
+
+  if (breakpoints.empty())
+    return;
+
+  std::sort(breakpoints.begin(), breakpoints.end(),
+      [&t](const size_t a, const size_t b) { return t[a] < t[b]; });
+
+  // Follow the path, segment by segment, until the quadratic model along the
+  // segment has its minimum inside it.  This is algorithm CP of Byrd et al.
+  // (1995), with f1 and f2 the first and second derivatives of the model.
+  arma::vec p = w.t() * d;
+  double f1 = -arma::dot(d, d);
+  double f2 = -theta * f1 - arma::dot(p, m * p);
+  const double f2Original = f2;
+  double dtMin = -f1 / f2;
+  double tOld = 0.0;
+
+  size_t k = 0;
+  for (; k < breakpoints.size(); ++k)
+  {
+    const size_t b = breakpoints[k];
+    const double dt = t[b] - tOld;
+    if (dtMin < dt)
+      break;
+
+    // Coordinate b reaches its bound.
+    cauchy[b] = (d[b] > 0.0) ? Upper(b) : Lower(b);
+    const double z = cauchy[b] - iterate[b];
+    const double g = gradient[b];
+    c += dt * p;
+
+    const arma::vec wb = w.row(b).t();
+    const arma::vec mwb = m * wb;
+    f1 += dt * f2 + g * g + theta * g * z - g * arma::dot(mwb, c);
+    f2 -= theta * g * g + 2.0 * g * arma::dot(mwb, p) +
+        g * g * arma::dot(wb, mwb);
+    f2 = std::max(f2, std::numeric_limits<double>::epsilon() * f2Original);
+    p += g * wb;
+    d[b] = 0.0;
+
+    dtMin = -f1 / f2;
+    tOld = t[b];
+  }
+
+  // The minimum is inside the current segment.
+  dtMin = std::max(dtMin, 0.0);
+  tOld += dtMin;
+  for (; k < breakpoints.size(); ++k)
+  {
+    const size_t i = breakpoints[k];
+    cauchy[i] = iterate[i] + tOld * d[i];
+  }
+  c += dtMin * p;
+}
+
+inline void L_BFGS_B::SubspaceMinimization(const arma::mat& iterate,
+                                           const arma::mat& gradient,
+                                           const double theta,
+                                           const arma::vec& c,
+                                           arma::mat& cauchy) const
+{
+  // The free coordinates are those that are not at a bound.
+  std::vector<arma::uword> freeCoordinates;
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    if (cauchy[i] > Lower(i) && cauchy[i] < Upper(i))
+      freeCoordinates.push_back(i);
+  }
+
+  if (freeCoordinates.empty())
+    return;
+
+  const arma::uvec freeIndices(freeCoordinates);
+  const arma::vec mc = m * c;
+
+  // The reduced gradient of the model at the Cauchy point.
+  arma::vec r(freeIndices.n_elem);
+  for (size_t k = 0; k < freeIndices.n_elem; ++k)
+  {
+    const size_t i = freeIndices[k];
+    r[k] = gradient[i] + theta * (cauchy[i] - iterate[i]);
+    if (w.n_cols > 0)
+      r[k] -= arma::dot(w.row(i), mc);
+  }
+
+  // The Newton step on the free coordinates, with the reduced inverse Hessian
+  // computed with the Sherman-Morrison-Woodbury formula (equation (5.11) of
+  // Byrd et al. (1995)); only a 2m x 2m system has to be solved.
+  arma::vec du = -r / theta;
+  if (w.n_cols > 0)
+  {
+    const arma::mat wz = w.rows(freeIndices);
+    arma::vec v = m * (wz.t() * r);
+    const arma::mat middle = arma::eye(w.n_cols, w.n_cols) -
+        (m * (wz.t() * wz)) / theta;
+    arma::vec nv;
+    if (arma::solve(nv, middle, v))
+      du -= (wz * nv) / (theta * theta);
+  }
+
+  // Truncate the step so that it stays within the bounds.
+  double alpha = 1.0;
+  for (size_t k = 0; k < freeIndices.n_elem; ++k)
+  {
+    const size_t i = freeIndices[k];
+    if (du[k] > 0.0)
+      alpha = std::min(alpha, (Upper(i) - cauchy[i]) / du[k]);
+    else if (du[k] < 0.0)
+      alpha = std::min(alpha, (Lower(i) - cauchy[i]) / du[k]);
+  }
+
+  for (size_t k = 0; k < freeIndices.n_elem; ++k)
+    cauchy[freeIndices[k]] += alpha * du[k];
+}
+
+template<typename FunctionType, typename... CallbackTypes>
+double L_BFGS_B::Optimize(FunctionType& function,
+                          arma::mat& iterate,
+                          CallbackTypes&&... callbacks)
+{
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
+  const size_t n = iterate.n_elem;
+  if ((lowerBound.n_elem != 1 && lowerBound.n_elem != n) ||
+      (upperBound.n_elem != 1 && upperBound.n_elem != n))
+  {
+    std::ostringstream oss;
+    oss << "L_BFGS_B::Optimize(): the bounds must have 1 or " << n
+        << " elements, but have " << lowerBound.n_elem << " and "
+        << upperBound.n_elem << " elements!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Start inside the bounds.
+  for (size_t i = 0; i < n; ++i)
+    iterate[i] = std::min(std::max(iterate[i], Lower(i)), Upper(i));
+
+  // The memory of the history of the last call is reused if it fits.
+  typedef LBFGSHistory<arma::cube> HistoryType;
+  if (!history.Has<HistoryType>() ||
+      !history.As<HistoryType>().Fits(rows, cols, numBasis, false))
+  {
+    history.Set(new HistoryType(rows, cols, numBasis, false));
+  }
+  else
+  {
+    history.As<HistoryType>().Reset();
+  }
+
+  HistoryType& h = history.As<HistoryType>();
+  sy.zeros(numBasis, numBasis);
+  ss.zeros(numBasis, numBasis);
+
+  // Whether to optimize until convergence.
+  bool optimizeUntilConvergence = (maxIterations == 0);
+
+  arma::mat gradient(rows, cols);
+  arma::mat oldIterate(rows, cols);
+  arma::mat oldGradient(rows, cols);
+  arma::mat searchDirection(rows, cols);
+  arma::vec c;
+
+  // Scaling of the initial Hessian approximation, theta I.
+  double theta = 1.0;
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+
+  // The initial function value and gradient.
+  double functionValue = f.EvaluateWithGradient(iterate, gradient);
+  double prevFunctionValue = functionValue;
+
+  terminate |= Callback::Evaluate(*this, f, iterate, functionValue,
+      callbacks...);
+  terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
+
+  // The main optimization loop.
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+       (itNum != maxIterations)) && !terminate; ++itNum)
+  {
+    prevFunctionValue = functionValue;
+
+    terminate |= Callback::BeginEpoch(*this, f, iterate, itNum,
+        functionValue, callbacks...);
+    if (terminate)
+      break;
+
+    // Break when the projected gradient, P(x - g) - x, becomes too small.  It
+    // is zero at a minimum, even one on the boundary.
+    double projectedGradientNorm = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double projected = std::min(std::max(iterate[i] - gradient[i],
+          Lower(i)), Upper(i));
+      projectedGradientNorm = std::max(projectedGradientNorm,
+          std::abs(projected - iterate[i]));
+    }
+
+    if (projectedGradientNorm < minGradientNorm)
+    {
+      ENS_INFO << "L-BFGS-B projected gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // Break if the objective is not a number.
+    if (std::isnan(functionValue))
+    {
+      ENS_WARN << "L-BFGS-B terminated with objective " << functionValue
+          << "; are the objective and gradient functions implemented "
+          << "correctly?" << std::endl;
+      break;
+    }
+
+    if (!CompactRepresentation(h, theta))
+    {
+      ENS_WARN << "L-BFGS-B Hessian approximation is singular; resetting the "
+          << "history." << std::endl;
+      h.Reset();
+      theta = 1.0;
+      CompactRepresentation(h, theta);
+    }
+
+    // The search direction points from the iterate to the minimizer of the
+    // quadratic model over the free coordinates at the generalized Cauchy
+    // point; searchDirection holds that point until the end.
+    CauchyPoint(iterate, gradient, theta, searchDirection, c);
+    SubspaceMinimization(iterate, gradient, theta, c, searchDirection);
+    searchDirection -= iterate;
+
+    const double initialSlope = arma::dot(gradient, searchDirection);
+    if (initialSlope >= 0.0)
+    {
+      if (h.pairs == 0)
+      {
+        ENS_INFO << "L-BFGS-B found no descent direction (terminating "
+            << "successfully)." << std::endl;
+        break;
+      }
+
+      // Try again with the steepest descent path.
+      ENS_WARN << "L-BFGS-B search direction is not a descent direction; "
+          << "resetting the history." << std::endl;
+      h.Reset();
+      theta = 1.0;
+      continue;
+    }
+
+    // Save the old iterate and the gradient before stepping.
+    oldIterate = iterate;
+    oldGradient = gradient;
+
+    // Backtrack from the end of the search direction, which is within the
+    // bounds, so every trial point is too.  Without a history the direction
+    // is the scaled projected gradient, so the first step is normalized.
+    double step = (h.pairs == 0) ?
+        std::min(1.0, 1.0 / arma::norm(searchDirection, 2)) : 1.0;
+    bool accepted = false;
+    for (size_t trial = 0; trial < maxLineSearchTrials && !terminate; ++trial)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        iterate[i] = std::min(std::max(oldIterate[i] +
+            step * searchDirection[i], Lower(i)), Upper(i));
+      }
+
+      const double value = f.EvaluateWithGradient(iterate, gradient);
+      terminate |= Callback::Evaluate(*this, f, iterate, value, callbacks...);
+
+      if (value <= functionValue + armijoConstant * step * initialSlope)
+      {
+        functionValue = value;
+        accepted = true;
+        break;
+      }
+
+      step *= 0.5;
+      if (step < minStep)
+        break;
+    }
+
+    if (!accepted)
+    {
+      iterate = oldIterate;
+      functionValue = prevFunctionValue;
+      ENS_WARN << "Line search failed.  Stopping optimization." << std::endl;
+      break; // The line search failed; nothing else to try.
+    }
+
+    // It is possible that the difference between the two coordinates is zero.
+    // In this case we terminate successfully.
+    if (std::equal(iterate.begin(), iterate.end(), oldIterate.begin()))
+    {
+      ENS_INFO << "L-BFGS-B step size of 0 (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    // If we can't make progress on the gradient, then we'll also accept
+    // a stable function value.
+    const double denom = std::max(
+        std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0);
+    if ((prevFunctionValue - functionValue) / denom <= factr)
+    {
+      ENS_INFO << "L-BFGS-B function value stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    // Store the new pair, unless its curvature is too small to keep the
+    // Hessian approximation positive definite (the line search only checks the
+    // Armijo condition).
+    double sTy = 0.0, yTy = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double yi = gradient[i] - oldGradient[i];
+      sTy += (iterate[i] - oldIterate[i]) * yi;
+      yTy += yi * yi;
+    }
+
+    if (sTy > std::numeric_limits<double>::epsilon() * yTy)
+    {
+      const size_t pos = h.pairs % numBasis;
+      double* sMem = h.s.slice_memptr(pos);
+      double* yMem = h.y.slice_memptr(pos);
+      for (size_t i = 0; i < n; ++i)
+      {
+        sMem[i] = iterate[i] - oldIterate[i];
+        yMem[i] = gradient[i] - oldGradient[i];
+      }
+
+      // Only the new row and column of the inner products change.
+      const size_t count = std::min(h.pairs + 1, numBasis);
+      for (size_t j = 0; j < count; ++j)
+      {
+        sy(pos, j) = math::Dot(n, sMem, h.y.slice_memptr(j));
+        sy(j, pos) = math::Dot(n, h.s.slice_memptr(j), yMem);
+        ss(pos, j) = math::Dot(n, sMem, h.s.slice_memptr(j));
+        ss(j, pos) = ss(pos, j);
+      }
+
+      ++h.pairs;
+      theta = yTy / sTy;
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, itNum, functionValue,
+        callbacks...);
+  } // End of the optimization loop.
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
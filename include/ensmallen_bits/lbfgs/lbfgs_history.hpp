@@ -0,0 +1,78 @@
+/**
+ * @file lbfgs_history.hpp
+ * @author Ryan Curtin
+ *
+ * The storage of the differences of the iterates and the gradients used by the
+ * limited-memory quasi-Newton optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_HISTORY_HPP
+#define ENSMALLEN_LBFGS_LBFGS_HISTORY_HPP
+
+namespace ens {
+
+/**
+ * The basis sets of an L-BFGS optimization, along with the number of pairs
+ * that have been stored in them.  Pair i is stored in slice i % numBasis.  This
+ * is shared by L_BFGS and L_BFGS_B.
+ *
+ * @tparam CubeType Type of the history (arma::cube or arma::fcube).
+ */
+template<typename CubeType>
+struct LBFGSHistory
+{
+  //! Allocate the basis sets for the given sizes (with FirstTouchZeros(), so
+  //! that large histories are spread over the NUMA nodes and can be backed by
+  //! huge pages).
+  LBFGSHistory(const size_t rows,
+               const size_t cols,
+               const size_t numBasis,
+               const bool compact) :
+      pairs(0)
+  {
+    FirstTouchZeros(s, rows, cols, numBasis);
+    FirstTouchZeros(y, rows, cols, numBasis);
+    if (compact)
+    {
+      sy.zeros(numBasis, numBasis);
+      yy.zeros(numBasis, numBasis);
+    }
+  }
+
+  //! Return whether the basis sets were allocated for the given sizes.
+  bool Fits(const size_t rows,
+            const size_t cols,
+            const size_t numBasis,
+            const bool compact) const
+  {
+    return s.n_rows == rows && s.n_cols == cols && s.n_slices == numBasis &&
+        (sy.n_rows == (compact ? numBasis : 0));
+  }
+
+  //! Forget the stored pairs, keeping the memory of the basis sets.
+  void Reset()
+  {
+    sy.zeros();
+    yy.zeros();
+    pairs = 0;
+  }
+
+  //! Differences between the iterates and the old iterates.
+  CubeType s;
+  //! Differences between the gradients and the old gradients.
+  CubeType y;
+  //! Inner products of s and y, if the compact representation is used.
+  arma::mat sy;
+  //! Inner products of y, if the compact representation is used.
+  arma::mat yy;
+  //! The number of pairs stored so far.
+  size_t pairs;
+};
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_LBFGS_HISTORY_HPP
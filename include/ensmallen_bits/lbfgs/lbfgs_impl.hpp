@@ -17,11 +17,12 @@
 #include "lbfgs.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 
 namespace ens {
 
 /**
- * Initialize the L_BFGS object.
+ * Initialize the L_BFGSType object.
  *
  * @param numBasis Number of memory points to be stored (default 5).
  * @param maxIterations Maximum number of iterations for the optimization
@@ -37,16 +38,31 @@ namespace ens {
  *     (before giving up).
  * @param minStep The minimum step of the line search.
  * @param maxStep The maximum step of the line search.
+ * @param compact If true, compute the search direction with the compact
+ *     representation of the inverse Hessian approximation instead of the
+ *     two-loop recursion.
+ * @param floatHistory If true, store the differences of the iterates and the
+ *     gradients in single precision.
+ * @param warmStart If true, keep the history between calls to Optimize().
+ * @param lineSearch The line search policy.
+ * @param preconditioner The initial inverse Hessian approximation policy.
  */
-inline L_BFGS::L_BFGS(const size_t numBasis,
-                      const size_t maxIterations,
-                      const double armijoConstant,
-                      const double wolfe,
-                      const double minGradientNorm,
-                      const double factr,
-                      const size_t maxLineSearchTrials,
-                      const double minStep,
-                      const double maxStep) :
+template<typename LineSearchType, typename PreconditionerType>
+L_BFGSType<LineSearchType, PreconditionerType>::L_BFGSType(
+    const size_t numBasis,
+    const size_t maxIterations,
+    const double armijoConstant,
+    const double wolfe,
+    const double minGradientNorm,
+    const double factr,
+    const size_t maxLineSearchTrials,
+    const double minStep,
+    const double maxStep,
+    const bool compact,
+    const bool floatHistory,
+    const bool warmStart,
+    const LineSearchType& lineSearch,
+    const PreconditionerType& preconditioner) :
     numBasis(numBasis),
     maxIterations(maxIterations),
     armijoConstant(armijoConstant),
@@ -55,11 +71,32 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
     factr(factr),
     maxLineSearchTrials(maxLineSearchTrials),
     minStep(minStep),
-    maxStep(maxStep)
+    maxStep(maxStep),
+    compact(compact),
+    floatHistory(floatHistory),
+    warmStart(warmStart),
+    lineSearch(lineSearch),
+    preconditioner(preconditioner)
 {
   // Nothing to do.
 }
 
+template<typename LineSearchType, typename PreconditionerType>
+size_t L_BFGSType<LineSearchType, PreconditionerType>::MemoryEstimate(
+    const size_t rows,
+    const size_t cols,
+    const size_t /* numFunctions */) const
+{
+  const size_t n = rows * cols;
+  const size_t historyElemSize = floatHistory ? sizeof(float) : sizeof(double);
+
+  // The five buffers of the workspace, the point with the lowest objective and
+  // the gradient at the trial point of the line search; the compact
+  // representation also stores the inner products of the basis sets.
+  return 2 * numBasis * n * historyElemSize + 7 * n * sizeof(double) +
+      (compact ? 2 * numBasis * numBasis * sizeof(double) : 0);
+}
+
 /**
  * Calculate the scaling factor, gamma, which is used to scale the Hessian
  * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal
@@ -70,19 +107,23 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
  * @param s Differences between the iterate and old iterate matrix.
  * @param y Differences between the gradient and the old gradient matrix.
  */
-inline double L_BFGS::ChooseScalingFactor(const size_t iterationNum,
-                                          const arma::mat& gradient,
-                                          const arma::cube& s,
-                                          const arma::cube& y)
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType>
+double L_BFGSType<LineSearchType, PreconditionerType>::ChooseScalingFactor(
+    const size_t iterationNum,
+    const arma::mat& gradient,
+    const CubeType& s,
+    const CubeType& y)
 {
   double scalingFactor = 1.0;
   if (iterationNum > 0)
   {
     int previousPos = (iterationNum - 1) % numBasis;
     // Get s and y matrices once instead of multiple times.
-    const arma::mat& sMat = s.slice(previousPos);
-    const arma::mat& yMat = y.slice(previousPos);
-    scalingFactor = dot(sMat, yMat) / dot(yMat, yMat);
+    const size_t n = s.n_rows * s.n_cols;
+    const typename CubeType::elem_type* sMem = s.slice_memptr(previousPos);
+    const typename CubeType::elem_type* yMem = y.slice_memptr(previousPos);
+    scalingFactor = math::Dot(n, sMem, yMem) / math::Dot(n, yMem, yMem);
   }
   else
   {
@@ -102,47 +143,141 @@ inline double L_BFGS::ChooseScalingFactor(const size_t iterationNum,
  * @param y Differences between the gradient and the old gradient matrix.
  * @param searchDirection Vector to store search direction in.
  */
-inline void L_BFGS::SearchDirection(const arma::mat& gradient,
-                                    const size_t iterationNum,
-                                    const double scalingFactor,
-                                    const arma::cube& s,
-                                    const arma::cube& y,
-                                    arma::mat& searchDirection)
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType>
+void L_BFGSType<LineSearchType, PreconditionerType>::SearchDirection(
+    const arma::mat& gradient,
+    const size_t iterationNum,
+    const double scalingFactor,
+    const CubeType& s,
+    const CubeType& y,
+    arma::mat& searchDirection)
 {
-  // Start from this point.
-  searchDirection = gradient;
-
-  // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
-  // matrices with limited storage" (Nocedal, 1980).
+  ENS_TRACE_ZONE("SearchDirection");
 
-  // Temporary variables.
-  arma::vec rho(numBasis);
-  arma::vec alpha(numBasis);
-
-  size_t limit = (numBasis > iterationNum) ? 0 : (iterationNum - numBasis);
-  for (size_t i = iterationNum; i != limit; i--)
-  {
-    int translatedPosition = (i + (numBasis - 1)) % numBasis;
-    rho[iterationNum - i] = 1.0 / arma::dot(y.slice(translatedPosition),
-                                            s.slice(translatedPosition));
-    alpha[iterationNum - i] = rho[iterationNum - i] *
-        arma::dot(s.slice(translatedPosition), searchDirection);
-    searchDirection -= alpha[iterationNum - i] * y.slice(translatedPosition);
-  }
-
-  searchDirection *= scalingFactor;
+  // The preconditioner gives the initial inverse Hessian approximation.
+  const PreconditionerType& p = preconditioner;
+  math::TwoLoopRecursion(gradient, iterationNum, numBasis,
+      [&p, scalingFactor](arma::mat& v) { p.Apply(scalingFactor, v); }, s, y,
+      searchDirection);
+}
 
-  for (size_t i = limit; i < iterationNum; i++)
-  {
-    int translatedPosition = i % numBasis;
-    double beta = rho[iterationNum - i - 1] *
-        arma::dot(y.slice(translatedPosition), searchDirection);
-    searchDirection += (alpha[iterationNum - i - 1] - beta) *
-        s.slice(translatedPosition);
-  }
+/**
+ * Find the L_BFGS search direction with the compact representation of the
+ * inverse Hessian approximation.
+ *
+ * @param gradient The gradient at the current point.
+ * @param iterationNum The iteration number.
+ * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
+ * @param s Differences between the iterate and old iterate matrix.
+ * @param y Differences between the gradient and the old gradient matrix.
+ * @param sy Inner products of the columns of s and y.
+ * @param yy Inner products of the columns of y.
+ * @param searchDirection Vector to store search direction in.
+ */
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType>
+void L_BFGSType<LineSearchType, PreconditionerType>::CompactSearchDirection(
+    const arma::mat& gradient,
+    const size_t iterationNum,
+    const double scalingFactor,
+    const CubeType& s,
+    const CubeType& y,
+    const arma::mat& sy,
+    const arma::mat& yy,
+    arma::mat& searchDirection)
+{
+  ENS_TRACE_ZONE("SearchDirection");
+
+  // Without any basis set the direction is the scaled negative gradient.
+  searchDirection = -scalingFactor * gradient;
+
+  const size_t count = std::min(iterationNum, numBasis);
+  if (count == 0)
+    return;
+
+  // The positions of the stored pairs, from the oldest to the newest.  Until
+  // the history is full these are the first count slices.
+  arma::uvec order(count);
+  for (size_t k = 0; k < count; ++k)
+    order[k] = (iterationNum - count + k) % numBasis;
+
+  // View the histories, the gradient and the search direction as vectors and
+  // matrices without copying them.  We promise to be well-behaved... the
+  // elements won't be modified.
+  typedef typename CubeType::elem_type ElemType;
+  const size_t n = gradient.n_elem;
+  const arma::Mat<ElemType> sMat(const_cast<ElemType*>(s.memptr()), n, count,
+      false, true);
+  const arma::Mat<ElemType> yMat(const_cast<ElemType*>(y.memptr()), n, count,
+      false, true);
+  arma::vec direction(searchDirection.memptr(), n, false, true);
+
+  // See equation (2.6) of "Representations of quasi-Newton matrices and their
+  // use in limited memory methods" (Byrd, Nocedal and Schnabel, 1994):
+  //
+  //   H g = gamma g + S a - gamma Y r,
+  //
+  // where r = R^{-1} S^T g and a = R^{-T} (D r + gamma Y^T Y r - gamma Y^T g),
+  // R is the upper triangle of S^T Y (in chronological order) and D its
+  // diagonal.
+  const arma::vec sg = math::TransposeProduct(sMat, gradient.memptr());
+  const arma::vec yg = math::TransposeProduct(yMat, gradient.memptr());
+
+  const arma::mat r = arma::trimatu(sy.submat(order, order));
+  const arma::vec rCoef = arma::solve(arma::trimatu(r), sg.elem(order));
+  const arma::vec aCoef = arma::solve(arma::trimatl(r.t()),
+      r.diag() % rCoef + scalingFactor * (yy.submat(order, order) * rCoef -
+      yg.elem(order)));
+
+  // Back to the order of the slices.
+  arma::vec a(count), b(count);
+  a.elem(order) = -aCoef;
+  b.elem(order) = scalingFactor * rCoef;
+
+  // The search direction is -H g, so that it is a descent direction.
+  math::AddProduct(sMat, a, direction);
+  math::AddProduct(yMat, b, direction);
+}
 
-  // Negate the search direction so that it is a descent direction.
-  searchDirection *= -1;
+/**
+ * Update the inner products used by CompactSearchDirection() after the basis
+ * set at the given iteration has been overwritten.
+ *
+ * @param iterationNum Iteration number.
+ * @param s Differences between the iterate and old iterate matrix.
+ * @param y Differences between the gradient and the old gradient matrix.
+ * @param sy Inner products of the columns of s and y.
+ * @param yy Inner products of the columns of y.
+ */
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType>
+void L_BFGSType<LineSearchType, PreconditionerType>::UpdateInnerProducts(
+    const size_t iterationNum,
+    const CubeType& s,
+    const CubeType& y,
+    arma::mat& sy,
+    arma::mat& yy)
+{
+  // Only the new row and column change.
+  const size_t pos = iterationNum % numBasis;
+  const size_t count = std::min(iterationNum + 1, numBasis);
+
+  typedef typename CubeType::elem_type ElemType;
+  const size_t n = s.n_rows * s.n_cols;
+  const arma::Mat<ElemType> sMat(const_cast<ElemType*>(s.memptr()), n, count,
+      false, true);
+  const arma::Mat<ElemType> yMat(const_cast<ElemType*>(y.memptr()), n, count,
+      false, true);
+
+  sy(pos, arma::span(0, count - 1)) =
+      math::TransposeProduct(yMat, sMat.colptr(pos)).t();
+  sy(arma::span(0, count - 1), pos) =
+      math::TransposeProduct(sMat, yMat.colptr(pos));
+
+  yy(arma::span(0, count - 1), pos) =
+      math::TransposeProduct(yMat, yMat.colptr(pos));
+  yy(pos, arma::span(0, count - 1)) = yy(arma::span(0, count - 1), pos).t();
 }
 
 /**
@@ -158,146 +293,139 @@ inline void L_BFGS::SearchDirection(const arma::mat& gradient,
  * @param s Differences between the iterate and old iterate matrix.
  * @param y Differences between the gradient and the old gradient matrix.
  */
-inline void L_BFGS::UpdateBasisSet(const size_t iterationNum,
-                                   const arma::mat& iterate,
-                                   const arma::mat& oldIterate,
-                                   const arma::mat& gradient,
-                                   const arma::mat& oldGradient,
-                                   arma::cube& s,
-                                   arma::cube& y)
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType>
+void L_BFGSType<LineSearchType, PreconditionerType>::UpdateBasisSet(
+    const size_t iterationNum,
+    const arma::mat& iterate,
+    const arma::mat& oldIterate,
+    const arma::mat& gradient,
+    const arma::mat& oldGradient,
+    CubeType& s,
+    CubeType& y)
 {
+  typedef typename CubeType::elem_type ElemType;
+
   // Overwrite a certain position instead of pushing everything in the vector
-  // back one position.
-  int overwritePos = iterationNum % numBasis;
-  s.slice(overwritePos) = iterate - oldIterate;
-  y.slice(overwritePos) = gradient - oldGradient;
+  // back one position.  The differences are written straight into the slices,
+  // without temporaries.
+  const size_t overwritePos = iterationNum % numBasis;
+  ElemType* sMem = s.slice_memptr(overwritePos);
+  ElemType* yMem = y.slice_memptr(overwritePos);
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    sMem[i] = ElemType(iterate[i] - oldIterate[i]);
+    yMem[i] = ElemType(gradient[i] - oldGradient[i]);
+  }
 }
 
 /**
- * Perform a back-tracking line search along the search direction to calculate a
- * step size satisfying the Wolfe conditions.
+ * Use L_BFGS to optimize the given function, starting at the given iterate
+ * point and performing no more than the specified number of maximum iterations.
+ * The given starting point will be modified to store the finishing point of the
+ * algorithm.
+ *
+ * @param numIterations Maximum number of iterations to perform
+ * @param iterate Starting point (will be modified)
+ * @param callbacks Callback functions.
+ */
+template<typename LineSearchType, typename PreconditionerType>
+template<typename FunctionType, typename... CallbackTypes>
+double L_BFGSType<LineSearchType, PreconditionerType>::Optimize(
+    FunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  return OptimizeWithBuffers<arma::mat>(function, iterate, callbacks...);
+}
+
+/**
+ * Use L_BFGS to optimize the given function, starting at the given fixed-size
+ * point, with fixed-size buffers.
  *
  * @param function Function to optimize.
- * @param functionValue Value of the function at the initial point.
- * @param iterate The initial point to begin the line search from.
- * @param gradient The gradient at the initial point.
- * @param searchDirection A vector specifying the search direction.
- * @param stepSize Variable the calculated step size will be stored in.
+ * @param iterate Starting point (will be modified).
+ * @param callbacks Callback functions.
+ */
+template<typename LineSearchType, typename PreconditionerType>
+template<typename FunctionType,
+         arma::uword Rows,
+         arma::uword Cols,
+         typename... CallbackTypes>
+double L_BFGSType<LineSearchType, PreconditionerType>::Optimize(
+    FunctionType& function,
+    arma::mat::fixed<Rows, Cols>& iterate,
+    CallbackTypes&&... callbacks)
+{
+  return OptimizeWithBuffers<arma::mat::fixed<Rows, Cols>>(function, iterate,
+      callbacks...);
+}
+
+/**
+ * Use L_BFGS to optimize the given function, starting at the given fixed-size
+ * column vector, with fixed-size buffers.
  *
- * @return false if no step size is suitable, true otherwise.
+ * @param function Function to optimize.
+ * @param iterate Starting point (will be modified).
+ * @param callbacks Callback functions.
  */
-template<typename FunctionType>
-bool L_BFGS::LineSearch(FunctionType& function,
-                        double& functionValue,
-                        arma::mat& iterate,
-                        arma::mat& gradient,
-                        arma::mat& newIterateTmp,
-                        const arma::mat& searchDirection)
+template<typename LineSearchType, typename PreconditionerType>
+template<typename FunctionType, arma::uword Rows, typename... CallbackTypes>
+double L_BFGSType<LineSearchType, PreconditionerType>::Optimize(
+    FunctionType& function,
+    arma::vec::fixed<Rows>& iterate,
+    CallbackTypes&&... callbacks)
 {
-  // Default first step size of 1.0.
-  double stepSize = 1.0;
+  return OptimizeWithBuffers<arma::vec::fixed<Rows>>(function, iterate,
+      callbacks...);
+}
 
-  // The initial linear term approximation in the direction of the
-  // search direction.
-  double initialSearchDirectionDotGradient =
-      arma::dot(gradient, searchDirection);
+/**
+ * Use L_BFGS to optimize the given function, with buffers of the given matrix
+ * type.
+ *
+ * @param function Function to optimize.
+ * @param iterate Starting point (will be modified).
+ * @param callbacks Callback functions.
+ */
+template<typename LineSearchType, typename PreconditionerType>
+template<typename MatType, typename FunctionType, typename... CallbackTypes>
+double L_BFGSType<LineSearchType, PreconditionerType>::OptimizeWithBuffers(
+    FunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
 
-  // If it is not a descent direction, just report failure.
-  if (initialSearchDirectionDotGradient > 0.0)
+  if (floatHistory)
   {
-    Warn << "L-BFGS line search direction is not a descent direction "
-        << "(terminating)!" << std::endl;
-    return false;
+    return OptimizeWithHistory<arma::fcube, MatType>(function, iterate,
+        callbacks...);
   }
-
-  // Save the initial function value.
-  double initialFunctionValue = functionValue;
-
-  // Unit linear approximation to the decrease in function value.
-  double linearApproxFunctionValueDecrease = armijoConstant *
-      initialSearchDirectionDotGradient;
-
-  // The number of iteration in the search.
-  size_t numIterations = 0;
-
-  // Armijo step size scaling factor for increase and decrease.
-  const double inc = 2.1;
-  const double dec = 0.5;
-  double width = 0;
-  double bestStepSize = 1.0;
-  double bestObjective = std::numeric_limits<double>::max();
-
-  while (true)
+  else
   {
-    // Perform a step and evaluate the gradient and the function values at that
-    // point.
-    newIterateTmp = iterate;
-    newIterateTmp += stepSize * searchDirection;
-    functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
-    if (functionValue < bestObjective)
-    {
-      bestStepSize = stepSize;
-      bestObjective = functionValue;
-    }
-    numIterations++;
-
-    if (functionValue > initialFunctionValue + stepSize *
-        linearApproxFunctionValueDecrease)
-    {
-      width = dec;
-    }
-    else
-    {
-      // Check Wolfe's condition.
-      double searchDirectionDotGradient = arma::dot(gradient, searchDirection);
-
-      if (searchDirectionDotGradient < wolfe *
-          initialSearchDirectionDotGradient)
-      {
-        width = inc;
-      }
-      else
-      {
-        if (searchDirectionDotGradient > -wolfe *
-            initialSearchDirectionDotGradient)
-        {
-          width = dec;
-        }
-        else
-        {
-          break;
-        }
-      }
-    }
-
-    // Terminate when the step size gets too small or too big or it
-    // exceeds the max number of iterations.
-    const bool cond1 = (stepSize < minStep);
-    const bool cond2 = (stepSize > maxStep);
-    const bool cond3 = (numIterations >= maxLineSearchTrials);
-    if (cond1 || cond2 || cond3)
-      break;
-
-    // Scale the step size.
-    stepSize *= width;
+    return OptimizeWithHistory<arma::cube, MatType>(function, iterate,
+        callbacks...);
   }
-
-  // Move to the new iterate.
-  iterate += bestStepSize * searchDirection;
-  return true;
 }
 
 /**
- * Use L_BFGS to optimize the given function, starting at the given iterate
- * point and performing no more than the specified number of maximum iterations.
- * The given starting point will be modified to store the finishing point of the
- * algorithm.
+ * Use L_BFGS to optimize the given function, storing the differences of the
+ * iterates and the gradients in the given cube type.
  *
- * @param numIterations Maximum number of iterations to perform
- * @param iterate Starting point (will be modified)
+ * @param function Function to optimize.
+ * @param iterate Starting point (will be modified).
+ * @param callbacks Callback functions.
  */
-template<typename FunctionType>
-double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
+template<typename LineSearchType, typename PreconditionerType>
+template<typename CubeType,
+         typename MatType,
+         typename FunctionType,
+         typename... CallbackTypes>
+double L_BFGSType<LineSearchType, PreconditionerType>::OptimizeWithHistory(
+    FunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&... callbacks)
 {
   // Use the Function<> wrapper to ensure the function has all of the functions
   // that we need.
@@ -312,41 +440,95 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
   const size_t rows = iterate.n_rows;
   const size_t cols = iterate.n_cols;
 
-  arma::mat newIterateTmp(rows, cols);
-  arma::cube s(rows, cols, numBasis);
-  arma::cube y(rows, cols, numBasis);
+  // The buffers are kept from the last call if its iterate had the same type;
+  // setting the size of a matrix that already has it does not allocate.
+  typedef Workspace<MatType> WorkspaceType;
+  if (!workspace.Has<WorkspaceType>())
+    workspace.Set(new WorkspaceType());
+  WorkspaceType& w = workspace.As<WorkspaceType>();
+
+  MatType& newIterateTmp = w.newIterateTmp;
+  newIterateTmp.set_size(rows, cols);
+
+  // The basis sets, and the inner products of the basis sets if the compact
+  // representation is used.  When warm starting, we continue with the ones of
+  // the last call, if they fit; otherwise their memory is reused if they fit,
+  // and the stored pairs are forgotten.
+  typedef History<CubeType> HistoryType;
+  if (!history.Has<HistoryType>() ||
+      !history.As<HistoryType>().Fits(rows, cols, numBasis, compact))
+  {
+    history.Set(new HistoryType(rows, cols, numBasis, compact));
+  }
+  else if (!warmStart)
+  {
+    history.As<HistoryType>().Reset();
+  }
+
+  HistoryType& h = history.As<HistoryType>();
+  CubeType& s = h.s;
+  CubeType& y = h.y;
+  arma::mat& sy = h.sy;
+  arma::mat& yy = h.yy;
+
+  // The number of pairs stored before this call.
+  const size_t offset = h.pairs;
+
+  // The preconditioner starts over with the history.
+  if (offset == 0)
+    preconditioner.Reset(iterate);
+
+  // The compact representation assumes that the initial inverse Hessian
+  // approximation is a scaled identity.
+  const bool useCompact = compact &&
+      std::is_same<PreconditionerType, IdentityPreconditioner>::value;
 
   // The old iterate to be saved.
-  arma::mat oldIterate;
-  oldIterate.zeros(iterate.n_rows, iterate.n_cols);
+  MatType& oldIterate = w.oldIterate;
+  oldIterate.zeros(rows, cols);
 
   // Whether to optimize until convergence.
   bool optimizeUntilConvergence = (maxIterations == 0);
 
   // The gradient: the current and the old.
-  arma::mat gradient(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
-  arma::mat oldGradient(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  MatType& gradient = w.gradient;
+  MatType& oldGradient = w.oldGradient;
+  gradient.zeros(rows, cols);
+  oldGradient.zeros(rows, cols);
 
   // The search direction.
-  arma::mat searchDirection(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  MatType& searchDirection = w.searchDirection;
+  searchDirection.zeros(rows, cols);
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
 
   // The initial function value and gradient.
   double functionValue = f.EvaluateWithGradient(iterate, gradient);
   double prevFunctionValue = functionValue;
 
+  terminate |= Callback::Evaluate(*this, f, iterate, functionValue,
+      callbacks...);
+  terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
+
   // The main optimization loop.
-  for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
-       ++itNum)
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+       (itNum != maxIterations)) && !terminate; ++itNum)
   {
     prevFunctionValue = functionValue;
 
+    terminate |= Callback::BeginEpoch(*this, f, iterate, itNum,
+        functionValue, callbacks...);
+    if (terminate)
+      break;
+
     // Break when the norm of the gradient becomes too small.
     //
     // But don't do this on the first iteration to ensure we always take at
     // least one descent step.
     if (itNum > 0 && (arma::norm(gradient, 2) < minGradientNorm))
     {
-      Warn << "L-BFGS gradient norm too small (terminating successfully)."
+      ENS_WARN << "L-BFGS gradient norm too small (terminating successfully)."
           << std::endl;
       break;
     }
@@ -354,35 +536,47 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
     // Break if the objective is not a number.
     if (std::isnan(functionValue))
     {
-      Warn << "L-BFGS terminated with objective " << functionValue << "; "
+      ENS_WARN << "L-BFGS terminated with objective " << functionValue << "; "
           << "are the objective and gradient functions implemented correctly?"
           << std::endl;
       break;
     }
 
+    // The history is indexed by the number of pairs stored so far.
+    const size_t historyNum = offset + itNum;
+
     // Choose the scaling factor.
-    double scalingFactor = ChooseScalingFactor(itNum, gradient, s, y);
+    double scalingFactor = ChooseScalingFactor(historyNum, gradient, s, y);
 
     // Build an approximation to the Hessian and choose the search
     // direction for the current iteration.
-    SearchDirection(gradient, itNum, scalingFactor, s, y, searchDirection);
+    if (useCompact)
+    {
+      CompactSearchDirection(gradient, historyNum, scalingFactor, s, y, sy, yy,
+          searchDirection);
+    }
+    else
+    {
+      SearchDirection(gradient, historyNum, scalingFactor, s, y,
+          searchDirection);
+    }
 
     // Save the old iterate and the gradient before stepping.
     oldIterate = iterate;
     oldGradient = gradient;
 
-    if (!LineSearch(f, functionValue, iterate, gradient, newIterateTmp,
-        searchDirection))
+    if (!lineSearch.Search(*this, f, functionValue, iterate, gradient,
+        newIterateTmp, searchDirection, itNum, terminate, callbacks...))
     {
-      Warn << "Line search failed.  Stopping optimization." << std::endl;
+      ENS_WARN << "Line search failed.  Stopping optimization." << std::endl;
       break; // The line search failed; nothing else to try.
     }
 
     // It is possible that the difference between the two coordinates is zero.
     // In this case we terminate successfully.
-    if (accu(iterate != oldIterate) == 0)
+    if (std::equal(iterate.begin(), iterate.end(), oldIterate.begin()))
     {
-      Info << "L-BFGS step size of 0 (terminating successfully)."
+      ENS_INFO << "L-BFGS step size of 0 (terminating successfully)."
           << std::endl;
       break;
     }
@@ -393,15 +587,25 @@ double L_BFGS::Optimize(FunctionType& function, arma::mat& iterate)
         std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0);
     if ((prevFunctionValue - functionValue) / denom <= factr)
     {
-      Info << "L-BFGS function value stable (terminating successfully)."
+      ENS_INFO << "L-BFGS function value stable (terminating successfully)."
           << std::endl;
       break;
     }
 
     // Overwrite an old basis set.
-    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient, s, y);
+    UpdateBasisSet(historyNum, iterate, oldIterate, gradient, oldGradient, s,
+        y);
+    if (useCompact)
+      UpdateInnerProducts(historyNum, s, y, sy, yy);
+    preconditioner.Update(iterate, oldIterate, gradient, oldGradient);
+    h.pairs = historyNum + 1;
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, itNum, functionValue,
+        callbacks...);
   } // End of the optimization loop.
 
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return functionValue;
 }
 
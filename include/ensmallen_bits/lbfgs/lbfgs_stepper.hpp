@@ -0,0 +1,156 @@
+/**
+ * @file lbfgs_stepper.hpp
+ * @author Marcus Edel
+ *
+ * An L-BFGS optimization that is run a few iterations at a time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_STEPPER_HPP
+#define ENSMALLEN_LBFGS_LBFGS_STEPPER_HPP
+
+#include "lbfgs.hpp"
+
+namespace ens {
+
+/**
+ * An L-BFGS optimization of the given function from the given iterate, which
+ * is advanced by calls to Step() instead of running to completion, so that a
+ * scheduler can interleave many optimizations on a few threads, and give more
+ * iterations to the promising ones.  Each call to Step(n) takes at most n
+ * iterations (line searches), and the optimization keeps its history between
+ * the calls, so it goes through the same iterates and stops on the same
+ * conditions as L_BFGS::Optimize().  Callbacks are not supported.
+ *
+ * The stepper works on its own copy of the optimizer and holds its own
+ * history, so one configured optimizer can start many steppers (a history kept
+ * by the optimizer for WarmStart() is not used).  It refers to the function
+ * and the iterate, which must outlive it; the iterate holds the current point
+ * between the calls to Step().
+ *
+ * @code
+ * L_BFGS optimizer;
+ * L_BFGSStepper<L_BFGS, RosenbrockFunction> stepper(optimizer, f,
+ *     coordinates);
+ * while (stepper.Step(5) && stepper.Objective() > target)
+ * {
+ *   // Do something else between every 5 iterations.
+ * }
+ * @endcode
+ *
+ * @tparam OptimizerType Type of the optimizer (an L_BFGSType<>).
+ * @tparam FunctionType Type of the function to optimize.
+ * @tparam MatType Type of the buffers (arma::mat or a fixed-size matrix of the
+ *     size of the iterate).
+ */
+template<typename OptimizerType,
+         typename FunctionType,
+         typename MatType = arma::mat>
+class L_BFGSStepper
+{
+ public:
+  /**
+   * Start the optimization of the given function from the given iterate; no
+   * evaluation is done until the first call to Step().
+   *
+   * @param optimizer Optimizer with the parameters of the optimization.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified by Step()).
+   */
+  L_BFGSStepper(const OptimizerType& optimizer,
+                FunctionType& function,
+                arma::mat& iterate);
+
+  /**
+   * Take at most the given number of iterations, and return whether the
+   * optimization can go on (i.e. !Done()).  The first call also evaluates the
+   * function at the starting point.
+   *
+   * @param steps Maximum number of iterations to take.
+   */
+  bool Step(const size_t steps = 1);
+
+  //! Get whether the optimization has terminated.
+  bool Done() const { return done; }
+
+  //! Get the number of iterations taken so far.
+  size_t Steps() const { return iteration; }
+
+  //! Get the objective at the current point (0 before the first step).
+  double Objective() const { return functionValue; }
+
+  //! Get the objective returned by Optimize(); before Done(), it is the
+  //! objective at the current point.
+  double Result() const { return functionValue; }
+
+  //! Get the current point.
+  const arma::mat& Iterate() const { return iterate; }
+
+  //! Get the optimizer.
+  const OptimizerType& Optimizer() const { return optimizer; }
+
+ private:
+  //! Take one iteration with the given history, or terminate.
+  template<typename CubeType>
+  void TakeStep(LBFGSHistory<CubeType>& h);
+
+  //! The optimizer with the parameters of the optimization.
+  OptimizerType optimizer;
+  //! The function to optimize.
+  Function<FunctionType>& function;
+  //! The current point.
+  arma::mat& iterate;
+
+  //! The history, if it is stored in double precision.
+  LBFGSHistory<arma::cube> history;
+  //! The history, if it is stored in single precision.
+  LBFGSHistory<arma::fcube> floatHistory;
+  //! Whether the compact representation is used.
+  bool useCompact;
+
+  //! The trial points of the line search.
+  MatType newIterateTmp;
+  //! The iterate before the last step.
+  MatType oldIterate;
+  //! The gradient at the current iterate.
+  MatType gradient;
+  //! The gradient at the old iterate.
+  MatType oldGradient;
+  //! The search direction.
+  MatType searchDirection;
+
+  //! Whether the function was evaluated at the starting point.
+  bool started;
+  //! Whether the optimization has terminated.
+  bool done;
+  //! The number of iterations taken.
+  size_t iteration;
+  //! The objective at the current point.
+  double functionValue;
+};
+
+/**
+ * Start a step-wise L-BFGS optimization of the given function from the given
+ * iterate; see L_BFGSStepper.
+ */
+template<typename LineSearchType,
+         typename PreconditionerType,
+         typename FunctionType>
+L_BFGSStepper<L_BFGSType<LineSearchType, PreconditionerType>, FunctionType>
+MakeStepper(const L_BFGSType<LineSearchType, PreconditionerType>& optimizer,
+            FunctionType& function,
+            arma::mat& iterate)
+{
+  return L_BFGSStepper<L_BFGSType<LineSearchType, PreconditionerType>,
+      FunctionType>(optimizer, function, iterate);
+}
+
+} // namespace ens
+
+// Include implementation.
+#include "lbfgs_stepper_impl.hpp"
+
+#endif
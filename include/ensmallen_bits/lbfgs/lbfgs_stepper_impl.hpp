@@ -0,0 +1,188 @@
+/**
+ * @file lbfgs_stepper_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the step-wise L-BFGS optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_STEPPER_IMPL_HPP
+#define ENSMALLEN_LBFGS_LBFGS_STEPPER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lbfgs_stepper.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename OptimizerType, typename FunctionType, typename MatType>
+L_BFGSStepper<OptimizerType, FunctionType, MatType>::L_BFGSStepper(
+    const OptimizerType& optimizer,
+    FunctionType& function,
+    arma::mat& iterate) :
+    optimizer(optimizer),
+    function(static_cast<Function<FunctionType>&>(function)),
+    iterate(iterate),
+    history(0, 0, 0, false),
+    floatHistory(0, 0, 0, false),
+    // The compact representation assumes that the initial inverse Hessian
+    // approximation is a scaled identity.
+    useCompact(optimizer.compact && std::is_same<typename std::decay<decltype(
+        optimizer.Preconditioner())>::type, IdentityPreconditioner>::value),
+    started(false),
+    done(false),
+    iteration(0),
+    functionValue(0.0)
+{
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<Function<FunctionType>>();
+
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
+  if (optimizer.floatHistory)
+  {
+    floatHistory = LBFGSHistory<arma::fcube>(rows, cols, optimizer.numBasis,
+        optimizer.compact);
+  }
+  else
+  {
+    history = LBFGSHistory<arma::cube>(rows, cols, optimizer.numBasis,
+        optimizer.compact);
+  }
+
+  // The preconditioner starts over with the history.
+  this->optimizer.preconditioner.Reset(iterate);
+
+  newIterateTmp.set_size(rows, cols);
+  oldIterate.zeros(rows, cols);
+  gradient.zeros(rows, cols);
+  oldGradient.zeros(rows, cols);
+  searchDirection.zeros(rows, cols);
+}
+
+template<typename OptimizerType, typename FunctionType, typename MatType>
+bool L_BFGSStepper<OptimizerType, FunctionType, MatType>::Step(
+    const size_t steps)
+{
+  for (size_t k = 0; k < steps && !done; ++k)
+  {
+    if (optimizer.floatHistory)
+      TakeStep(floatHistory);
+    else
+      TakeStep(history);
+  }
+
+  return !done;
+}
+
+template<typename OptimizerType, typename FunctionType, typename MatType>
+template<typename CubeType>
+void L_BFGSStepper<OptimizerType, FunctionType, MatType>::TakeStep(
+    LBFGSHistory<CubeType>& h)
+{
+  // The initial function value and gradient.
+  if (!started)
+  {
+    functionValue = function.EvaluateWithGradient(iterate, gradient);
+    started = true;
+  }
+
+  if (optimizer.maxIterations != 0 && iteration == optimizer.maxIterations)
+  {
+    done = true;
+    return;
+  }
+
+  const double prevFunctionValue = functionValue;
+
+  // Break when the norm of the gradient becomes too small.
+  //
+  // But don't do this on the first iteration to ensure we always take at
+  // least one descent step.
+  if (iteration > 0 && (arma::norm(gradient, 2) < optimizer.minGradientNorm))
+  {
+    ENS_WARN << "L-BFGS gradient norm too small (terminating successfully)."
+        << std::endl;
+    done = true;
+    return;
+  }
+
+  // Break if the objective is not a number.
+  if (std::isnan(functionValue))
+  {
+    ENS_WARN << "L-BFGS terminated with objective " << functionValue << "; "
+        << "are the objective and gradient functions implemented correctly?"
+        << std::endl;
+    done = true;
+    return;
+  }
+
+  // Choose the scaling factor.
+  const double scalingFactor = optimizer.ChooseScalingFactor(iteration,
+      gradient, h.s, h.y);
+
+  // Build an approximation to the Hessian and choose the search direction for
+  // the current iteration.
+  if (useCompact)
+  {
+    optimizer.CompactSearchDirection(gradient, iteration, scalingFactor, h.s,
+        h.y, h.sy, h.yy, searchDirection);
+  }
+  else
+  {
+    optimizer.SearchDirection(gradient, iteration, scalingFactor, h.s, h.y,
+        searchDirection);
+  }
+
+  // Save the old iterate and the gradient before stepping.
+  oldIterate = iterate;
+  oldGradient = gradient;
+
+  bool terminate = false;
+  if (!optimizer.lineSearch.Search(optimizer, function, functionValue,
+      iterate, gradient, newIterateTmp, searchDirection, iteration, terminate))
+  {
+    ENS_WARN << "Line search failed.  Stopping optimization." << std::endl;
+    done = true;
+    return;
+  }
+
+  // It is possible that the difference between the two coordinates is zero.
+  // In this case we terminate successfully.
+  if (std::equal(iterate.begin(), iterate.end(), oldIterate.begin()))
+  {
+    ENS_INFO << "L-BFGS step size of 0 (terminating successfully)."
+        << std::endl;
+    done = true;
+    return;
+  }
+
+  // If we can't make progress on the gradient, then we'll also accept a
+  // stable function value.
+  const double denom = std::max(
+      std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0);
+  if ((prevFunctionValue - functionValue) / denom <= optimizer.factr)
+  {
+    ENS_INFO << "L-BFGS function value stable (terminating successfully)."
+        << std::endl;
+    done = true;
+    return;
+  }
+
+  // Overwrite an old basis set.
+  optimizer.UpdateBasisSet(iteration, iterate, oldIterate, gradient,
+      oldGradient, h.s, h.y);
+  if (useCompact)
+    optimizer.UpdateInnerProducts(iteration, h.s, h.y, h.sy, h.yy);
+  optimizer.preconditioner.Update(iterate, oldIterate, gradient, oldGradient);
+  h.pairs = iteration + 1;
+  ++iteration;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file more_thuente_line_search.hpp
+ * @author Ryan Curtin
+ *
+ * More-Thuente line search for L_BFGS.  Used as LineSearchType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_MORE_THUENTE_LINE_SEARCH_HPP
+#define ENSMALLEN_LBFGS_MORE_THUENTE_LINE_SEARCH_HPP
+
+namespace ens {
+
+/**
+ * The line search of More and Thuente, which finds a step satisfying the
+ * strong Wolfe conditions by safeguarded cubic and quadratic interpolation of
+ * the function values and directional derivatives at the trial steps.  The
+ * first trial step is chosen from the decrease of the objective in the
+ * previous iteration, so usually only one or two evaluations are needed per
+ * iteration.  The parameters of the search (Armijo constant, Wolfe parameter,
+ * minimum and maximum step, and number of trials) are those of the optimizer.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @article{More1994,
+ *   author  = {Mor{\'e}, Jorge J. and Thuente, David J.},
+ *   title   = {Line Search Algorithms with Guaranteed Sufficient Decrease},
+ *   journal = {ACM Transactions on Mathematical Software},
+ *   volume  = {20},
+ *   number  = {3},
+ *   pages   = {286--307},
+ *   year    = {1994}
+ * }
+ * @endcode
+ */
+class MoreThuenteLineSearch
+{
+ public:
+  /**
+   * Construct the More-Thuente line search.
+   *
+   * @param intervalTolerance Relative width of the interval of uncertainty
+   *     below which the search stops.
+   */
+  MoreThuenteLineSearch(const double intervalTolerance = 1e-16) :
+      intervalTolerance(intervalTolerance),
+      previousDecrease(0.0)
+  { /* Do nothing. */ }
+
+  /**
+   * Search for a step satisfying the strong Wolfe conditions along the search
+   * direction.  The parameter iterate will be modified if the method is
+   * successful, and functionValue and gradient will then hold the objective
+   * and the gradient at the new iterate.
+   *
+   * @param optimizer The optimizer, which holds the parameters of the search.
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param newIterateTmp Matrix to hold the trial points.
+   * @param searchDirection A vector specifying the search direction.
+   * @param iterationNum The iteration number of the optimizer.
+   * @param terminate Set to true if a callback requests termination.
+   * @param callbacks Callback functions.
+   *
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename... CallbackTypes>
+  bool Search(OptimizerType& optimizer,
+              FunctionType& function,
+              double& functionValue,
+              arma::mat& iterate,
+              arma::mat& gradient,
+              arma::mat& newIterateTmp,
+              const arma::mat& searchDirection,
+              const size_t iterationNum,
+              bool& terminate,
+              CallbackTypes&... callbacks);
+
+  //! Get the relative tolerance of the interval of uncertainty.
+  double IntervalTolerance() const { return intervalTolerance; }
+  //! Modify the relative tolerance of the interval of uncertainty.
+  double& IntervalTolerance() { return intervalTolerance; }
+
+ private:
+  /**
+   * Compute a safeguarded trial step and update the interval of uncertainty
+   * [stx, sty] (the dcstep routine of More and Thuente).  stx is the step with
+   * the lowest function value so far, and stp the current trial step, which is
+   * overwritten with the next one.
+   *
+   * @param stx Best step so far.
+   * @param fx Function value at stx.
+   * @param dx Directional derivative at stx.
+   * @param sty Other endpoint of the interval of uncertainty.
+   * @param fy Function value at sty.
+   * @param dy Directional derivative at sty.
+   * @param stp Current step; next trial step on exit.
+   * @param fp Function value at stp.
+   * @param dp Directional derivative at stp.
+   * @param bracketed Whether a minimizer has been bracketed.
+   * @param stpMin Lower bound for the step.
+   * @param stpMax Upper bound for the step.
+   */
+  static void Step(double& stx, double& fx, double& dx,
+                   double& sty, double& fy, double& dy,
+                   double& stp, const double fp, const double dp,
+                   bool& bracketed,
+                   const double stpMin,
+                   const double stpMax);
+
+  //! The relative tolerance of the interval of uncertainty.
+  double intervalTolerance;
+
+  //! The decrease of the objective in the previous iteration.
+  double previousDecrease;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "more_thuente_line_search_impl.hpp"
+
+#endif
@@ -0,0 +1,366 @@
+/**
+ * @file more_thuente_line_search_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the More-Thuente line search for L_BFGS.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_MORE_THUENTE_LINE_SEARCH_IMPL_HPP
+#define ENSMALLEN_LBFGS_MORE_THUENTE_LINE_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "more_thuente_line_search.hpp"
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+template<typename OptimizerType,
+         typename FunctionType,
+         typename... CallbackTypes>
+bool MoreThuenteLineSearch::Search(OptimizerType& optimizer,
+                                   FunctionType& function,
+                                   double& functionValue,
+                                   arma::mat& iterate,
+                                   arma::mat& gradient,
+                                   arma::mat& newIterateTmp,
+                                   const arma::mat& searchDirection,
+                                   const size_t iterationNum,
+                                   bool& terminate,
+                                   CallbackTypes&... callbacks)
+{
+  ENS_TRACE_ZONE("LineSearch");
+
+  // The directional derivative at the initial point.
+  const double initialDerivative = arma::dot(gradient, searchDirection);
+
+  // If it is not a descent direction, just report failure.
+  if (initialDerivative > 0.0)
+  {
+    ENS_WARN << "L-BFGS line search direction is not a descent direction "
+        << "(terminating)!" << std::endl;
+    return false;
+  }
+
+  const double initialValue = functionValue;
+  const double minStep = optimizer.MinStep();
+  const double maxStep = optimizer.MaxStep();
+
+  // Choose the first trial step so that the decrease predicted by the
+  // directional derivative matches the decrease of the previous iteration
+  // (see equation (3.60) in Nocedal and Wright, "Numerical Optimization"), but
+  // never more than the quasi-Newton step.
+  double stp = 1.0;
+  if (iterationNum > 0 && previousDecrease > 0.0)
+    stp = std::min(1.0, 2.02 * previousDecrease / -initialDerivative);
+  stp = std::min(std::max(stp, minStep), maxStep);
+
+  // The slope of the sufficient decrease (Armijo) condition.
+  const double decreaseSlope = optimizer.ArmijoConstant() * initialDerivative;
+  const double curvatureBound = -optimizer.Wolfe() * initialDerivative;
+
+  // The interval of uncertainty [stx, sty], holding the best step so far,
+  // and the bounds of the next trial step.
+  bool bracketed = false;
+  bool firstStage = true;
+  double width = maxStep - minStep;
+  double previousWidth = 2.0 * width;
+  double stx = 0.0, fx = initialValue, dx = initialDerivative;
+  double sty = 0.0, fy = initialValue, dy = initialDerivative;
+  double stMin = 0.0;
+  double stMax = stp + 4.0 * stp;
+
+  bool converged = false;
+  size_t numTrials = 0;
+  while (true)
+  {
+    // Perform a step and evaluate the gradient and the function values at that
+    // point.
+    newIterateTmp = iterate;
+    newIterateTmp += stp * searchDirection;
+    functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+    ++numTrials;
+
+    terminate |= Callback::Evaluate(optimizer, function, newIterateTmp,
+        functionValue, callbacks...);
+    terminate |= Callback::Gradient(optimizer, function, newIterateTmp,
+        gradient, callbacks...);
+    if (terminate)
+      break;
+
+    const double derivative = arma::dot(gradient, searchDirection);
+    const double sufficientValue = initialValue + stp * decreaseSlope;
+
+    // Once a step with sufficient decrease and non-negative curvature is
+    // found, the original function is used for the interpolation.
+    if (firstStage && functionValue <= sufficientValue &&
+        derivative >= std::min(optimizer.ArmijoConstant(), optimizer.Wolfe()) *
+        initialDerivative)
+    {
+      firstStage = false;
+    }
+
+    // Check the strong Wolfe conditions.
+    if (functionValue <= sufficientValue &&
+        std::abs(derivative) <= curvatureBound)
+    {
+      converged = true;
+      break;
+    }
+
+    // Terminate on rounding errors, when the interval of uncertainty is too
+    // small, at the bounds of the step, or when the number of trials is
+    // exceeded.
+    const bool cond1 = bracketed && (stp <= stMin || stp >= stMax ||
+        stMax - stMin <= intervalTolerance * stMax);
+    const bool cond2 = (stp == maxStep && functionValue <= sufficientValue &&
+        derivative <= decreaseSlope);
+    const bool cond3 = (stp == minStep && (functionValue > sufficientValue ||
+        derivative >= decreaseSlope));
+    const bool cond4 = (numTrials >= optimizer.MaxLineSearchTrials());
+    if (cond1 || cond2 || cond3 || cond4)
+      break;
+
+    if (firstStage && functionValue <= fx && functionValue > sufficientValue)
+    {
+      // Interpolate the modified function f(stp) - stp * decreaseSlope, whose
+      // minimizers satisfy the sufficient decrease condition.
+      double fxm = fx - stx * decreaseSlope;
+      double dxm = dx - decreaseSlope;
+      double fym = fy - sty * decreaseSlope;
+      double dym = dy - decreaseSlope;
+      Step(stx, fxm, dxm, sty, fym, dym, stp, functionValue - stp *
+          decreaseSlope, derivative - decreaseSlope, bracketed, stMin, stMax);
+      fx = fxm + stx * decreaseSlope;
+      dx = dxm + decreaseSlope;
+      fy = fym + sty * decreaseSlope;
+      dy = dym + decreaseSlope;
+    }
+    else
+    {
+      Step(stx, fx, dx, sty, fy, dy, stp, functionValue, derivative, bracketed,
+          stMin, stMax);
+    }
+
+    // Bisect if the interval of uncertainty does not shrink fast enough.
+    if (bracketed)
+    {
+      if (std::abs(sty - stx) >= 0.66 * previousWidth)
+        stp = stx + 0.5 * (sty - stx);
+      previousWidth = width;
+      width = std::abs(sty - stx);
+
+      stMin = std::min(stx, sty);
+      stMax = std::max(stx, sty);
+    }
+    else
+    {
+      stMin = stp + 1.1 * (stp - stx);
+      stMax = stp + 4.0 * (stp - stx);
+    }
+
+    stp = std::min(std::max(stp, minStep), maxStep);
+
+    // If no further progress can be made, fall back to the best step.
+    if (bracketed && (stp <= stMin || stp >= stMax ||
+        stMax - stMin <= intervalTolerance * stMax))
+    {
+      stp = stx;
+    }
+  }
+
+  if (!converged && functionValue > fx)
+  {
+    // The last trial step is not the best one.
+    if (stx == 0.0)
+    {
+      // No step decreased the objective.
+      functionValue = initialValue;
+      return terminate;
+    }
+
+    newIterateTmp = iterate;
+    newIterateTmp += stx * searchDirection;
+    if (terminate)
+    {
+      // The gradient won't be needed anymore.
+      functionValue = fx;
+    }
+    else
+    {
+      functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+      terminate |= Callback::Evaluate(optimizer, function, newIterateTmp,
+          functionValue, callbacks...);
+      terminate |= Callback::Gradient(optimizer, function, newIterateTmp,
+          gradient, callbacks...);
+    }
+  }
+
+  // Move to the new iterate.
+  iterate = newIterateTmp;
+  previousDecrease = initialValue - functionValue;
+  return true;
+}
+
+inline void MoreThuenteLineSearch::Step(double& stx, double& fx, double& dx,
+                                        double& sty, double& fy, double& dy,
+                                        double& stp,
+                                        const double fp,
+                                        const double dp,
+                                        bool& bracketed,
+                                        const double stpMin,
+                                        const double stpMax)
+{
+  const double sgnd = dp * (dx / std::abs(dx));
+
+  double stpf;
+  if (fp > fx)
+  {
+    // Case 1: a higher function value.  The minimum is bracketed; take the
+    // cubic step if it is closer to stx than the quadratic step, otherwise
+    // the average of both.
+    const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+    const double s = std::max(std::max(std::abs(theta), std::abs(dx)),
+        std::abs(dp));
+    double gamma = s * std::sqrt((theta / s) * (theta / s) - (dx / s) *
+        (dp / s));
+    if (stp < stx)
+      gamma = -gamma;
+    const double p = (gamma - dx) + theta;
+    const double q = ((gamma - dx) + gamma) + dp;
+    const double stpc = stx + (p / q) * (stp - stx);
+    const double stpq = stx + ((dx / ((fx - fp) / (stp - stx) + dx)) / 2.0) *
+        (stp - stx);
+    if (std::abs(stpc - stx) < std::abs(stpq - stx))
+      stpf = stpc;
+    else
+      stpf = stpc + (stpq - stpc) / 2.0;
+    bracketed = true;
+  }
+  else if (sgnd < 0.0)
+  {
+    // Case 2: a lower function value and derivatives of opposite sign.  The
+    // minimum is bracketed; take the step farther from stp.
+    const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+    const double s = std::max(std::max(std::abs(theta), std::abs(dx)),
+        std::abs(dp));
+    double gamma = s * std::sqrt((theta / s) * (theta / s) - (dx / s) *
+        (dp / s));
+    if (stp > stx)
+      gamma = -gamma;
+    const double p = (gamma - dp) + theta;
+    const double q = ((gamma - dp) + gamma) + dx;
+    const double stpc = stp + (p / q) * (stx - stp);
+    const double stpq = stp + (dp / (dp - dx)) * (stx - stp);
+    if (std::abs(stpc - stp) > std::abs(stpq - stp))
+      stpf = stpc;
+    else
+      stpf = stpq;
+    bracketed = true;
+  }
+  else if (std::abs(dp) < std::abs(dx))
+  {
+    // Case 3: a lower function value, derivatives of the same sign, and the
+    // magnitude of the derivative decreases.  The cubic step is only used if
+    // it is in the right direction.
+    const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+    const double s = std::max(std::max(std::abs(theta), std::abs(dx)),
+        std::abs(dp));
+    double gamma = s * std::sqrt(std::max(0.0, (theta / s) * (theta / s) -
+        (dx / s) * (dp / s)));
+    if (stp > stx)
+      gamma = -gamma;
+    const double p = (gamma - dp) + theta;
+    const double q = (gamma + (dx - dp)) + gamma;
+    const double r = p / q;
+    double stpc;
+    if (r < 0.0 && gamma != 0.0)
+      stpc = stp + r * (stx - stp);
+    else if (stp > stx)
+      stpc = stpMax;
+    else
+      stpc = stpMin;
+    const double stpq = stp + (dp / (dp - dx)) * (stx - stp);
+
+    if (bracketed)
+    {
+      // Take the step closer to stp, but not too close to sty.
+      if (std::abs(stpc - stp) < std::abs(stpq - stp))
+        stpf = stpc;
+      else
+        stpf = stpq;
+
+      if (stp > stx)
+        stpf = std::min(stp + 0.66 * (sty - stp), stpf);
+      else
+        stpf = std::max(stp + 0.66 * (sty - stp), stpf);
+    }
+    else
+    {
+      // Take the step farther from stp, within the bounds.
+      if (std::abs(stpc - stp) > std::abs(stpq - stp))
+        stpf = stpc;
+      else
+        stpf = stpq;
+
+      stpf = std::max(stpMin, std::min(stpMax, stpf));
+    }
+  }
+  else
+  {
+    // Case 4: a lower function value, derivatives of the same sign, and the
+    // magnitude of the derivative does not decrease.  Extrapolate to the
+    // bound, or take the cubic step towards sty if the minimum is bracketed.
+    if (bracketed)
+    {
+      const double theta = 3.0 * (fp - fy) / (sty - stp) + dy + dp;
+      const double s = std::max(std::max(std::abs(theta), std::abs(dy)),
+          std::abs(dp));
+      double gamma = s * std::sqrt((theta / s) * (theta / s) - (dy / s) *
+          (dp / s));
+      if (stp > sty)
+        gamma = -gamma;
+      const double p = (gamma - dp) + theta;
+      const double q = ((gamma - dp) + gamma) + dy;
+      stpf = stp + (p / q) * (sty - stp);
+    }
+    else if (stp > stx)
+    {
+      stpf = stpMax;
+    }
+    else
+    {
+      stpf = stpMin;
+    }
+  }
+
+  // Update the interval of uncertainty.
+  if (fp > fx)
+  {
+    sty = stp;
+    fy = fp;
+    dy = dp;
+  }
+  else
+  {
+    if (sgnd < 0.0)
+    {
+      sty = stx;
+      fy = fx;
+      dy = dx;
+    }
+    stx = stp;
+    fx = fp;
+    dx = dp;
+  }
+
+  stp = stpf;
+}
+
+} // namespace ens
+
+#endif
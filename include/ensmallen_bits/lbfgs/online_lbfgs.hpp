@@ -0,0 +1,175 @@
+/**
+ * @file online_lbfgs.hpp
+ * @author Ryan Curtin
+ *
+ * Online L-BFGS (oLBFGS) for decomposable functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_ONLINE_LBFGS_HPP
+#define ENSMALLEN_LBFGS_ONLINE_LBFGS_HPP
+
+#include <ensmallen_bits/function.hpp>
+#include "lbfgs.hpp"
+
+namespace ens {
+
+/**
+ * Online L-BFGS for functions which can be expressed as a sum of other
+ * functions,
+ *
+ * \f[
+ * f(A) = \sum_{i = 0}^{n} f_i(A).
+ * \f]
+ *
+ * Each step is \f$ A \leftarrow A - \alpha H g \f$, where g is the gradient of
+ * a batch and H the L-BFGS approximation of the inverse Hessian; the search
+ * direction and the storage of the pairs are those of L_BFGS.  After each step
+ * the gradient of the same batch is computed again at the new iterate, so that
+ * the curvature pair (s, y) measures the curvature of one function instead of
+ * the difference between two batches:
+ *
+ *   s = A_new - A,   y = g_batch(A_new) - g_batch(A) + lambda s,
+ *
+ * where lambda is a small damping that keeps the pairs of convex functions
+ * positive.  Pairs with non-positive curvature are skipped.  Each step costs
+ * two batch gradients and the two-loop recursion.  For more information, see
+ * the following.
+ *
+ * @code
+ * @inproceedings{schraudolph2007stochastic,
+ *   title     = {A Stochastic Quasi-Newton Method for Online Convex
+ *                Optimization},
+ *   author    = {Schraudolph, Nicol N. and Yu, Jin and G{\"u}nter, Simon},
+ *   booktitle = {Proceedings of the Eleventh International Conference on
+ *                Artificial Intelligence and Statistics},
+ *   pages     = {436--443},
+ *   year      = {2007}
+ * }
+ * @endcode
+ *
+ * Until the first curvature pair is available, the steps are plain SGD steps.
+ *
+ * OnlineL_BFGS can optimize differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class OnlineL_BFGS
+{
+ public:
+  /**
+   * Construct the online L-BFGS optimizer with the given parameters.  The
+   * maximum number of iterations refers to the maximum number of points that
+   * are processed (i.e., one iteration equals one point; one iteration does
+   * not equal one pass over the dataset).
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Size of each batch.
+   * @param numBasis Number of curvature pairs to keep.
+   * @param lambda Damping added to the differences of the gradients.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled after each pass;
+   *     otherwise, the functions are visited in linear order.
+   */
+  OnlineL_BFGS(const double stepSize = 0.1,
+               const size_t batchSize = 32,
+               const size_t numBasis = 10,
+               const double lambda = 1e-4,
+               const size_t maxIterations = 100000,
+               const double tolerance = 1e-5,
+               const bool shuffle = true);
+
+  /**
+   * Optimize the given function using online L-BFGS.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch is one
+   * pass over the functions.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of curvature pairs to keep.
+  size_t NumBasis() const { return lbfgs.NumBasis(); }
+  //! Modify the number of curvature pairs to keep.
+  size_t& NumBasis() { return lbfgs.NumBasis(); }
+
+  //! Get the damping of the differences of the gradients.
+  double Lambda() const { return lambda; }
+  //! Modify the damping of the differences of the gradients.
+  double& Lambda() { return lambda; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the number of curvature pairs formed in the last optimization.
+  size_t Pairs() const { return pairs; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+  //! The batch size for processing.
+  size_t batchSize;
+  //! The damping of the differences of the gradients.
+  double lambda;
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+  //! The tolerance for termination.
+  double tolerance;
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+  //! The number of curvature pairs formed in the last optimization.
+  size_t pairs;
+  //! Gives the search direction and stores the pairs; only its memory size is
+  //! used.
+  L_BFGS lbfgs;
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "online_lbfgs_impl.hpp"
+
+#endif // ENSMALLEN_LBFGS_ONLINE_LBFGS_HPP
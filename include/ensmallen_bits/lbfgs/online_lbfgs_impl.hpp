@@ -0,0 +1,206 @@
+/**
+ * @file online_lbfgs_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the online L-BFGS optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_ONLINE_LBFGS_IMPL_HPP
+#define ENSMALLEN_LBFGS_ONLINE_LBFGS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_lbfgs.hpp"
+
+namespace ens {
+
+inline OnlineL_BFGS::OnlineL_BFGS(const double stepSize,
+                                  const size_t batchSize,
+                                  const size_t numBasis,
+                                  const double lambda,
+                                  const size_t maxIterations,
+                                  const double tolerance,
+                                  const bool shuffle) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    lambda(lambda),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    pairs(0),
+    lbfgs(numBasis)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double OnlineL_BFGS::Optimize(DecomposableFunctionType& function,
+                              arma::mat& iterate,
+                              CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType>();
+
+  // Find the number of functions to use.
+  const size_t numFunctions = f.NumFunctions();
+  const size_t numBasis = lbfgs.NumBasis();
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  double overallObjective = 0;
+  double lastObjective = std::numeric_limits<double>::max();
+
+  // The curvature pairs; pair k is stored in slice k % numBasis.
+  pairs = 0;
+  arma::cube s(iterate.n_rows, iterate.n_cols, numBasis);
+  arma::cube y(iterate.n_rows, iterate.n_cols, numBasis);
+
+  // Now iterate!
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat newGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat oldIterate(iterate.n_rows, iterate.n_cols);
+  arma::mat direction;
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  size_t epoch = 1;
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+  terminate |= Callback::BeginEpoch(*this, f, iterate, epoch, lastObjective,
+      callbacks...);
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0 && i > 0)
+    {
+      // Output current objective function.
+      ENS_INFO << "OnlineL_BFGS: iteration " << i << ", objective "
+          << overallObjective << "." << std::endl;
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "OnlineL_BFGS: converged to " << overallObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "OnlineL_BFGS: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch,
+          overallObjective, callbacks...);
+      if (terminate)
+        break;
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+
+      if (shuffle) // Determine order of visitation.
+        f.Shuffle();
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, ++epoch,
+          lastObjective, callbacks...);
+      if (terminate)
+        break;
+    }
+
+    // Find the effective batch size; we have to take the minimum of three
+    // things:
+    // - the batch size can't be larger than the user-specified batch size;
+    // - the batch size can't be larger than the number of iterations left
+    //       before actualMaxIterations is hit;
+    // - the batch size can't be larger than the number of functions left.
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    const double objective = f.EvaluateWithGradient(iterate, currentFunction,
+        gradient, effectiveBatchSize);
+    overallObjective += objective;
+
+    terminate |= Callback::Evaluate(*this, f, iterate, objective,
+        callbacks...);
+    terminate |= Callback::Gradient(*this, f, iterate, gradient,
+        callbacks...);
+
+    // The steps are taken on the average of the functions of the batch, so
+    // that the step size does not depend on the batch size.
+    gradient /= (double) effectiveBatchSize;
+    oldIterate = iterate;
+    if (pairs == 0)
+    {
+      iterate -= stepSize * gradient;
+    }
+    else
+    {
+      const double scalingFactor = lbfgs.ChooseScalingFactor(pairs, gradient,
+          s, y);
+      lbfgs.SearchDirection(gradient, pairs, scalingFactor, s, y, direction);
+      iterate += stepSize * direction;
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // The curvature pair is formed on the same batch.  The damping is added to
+    // the new gradient, so that UpdateBasisSet() stores y + lambda s.
+    f.Gradient(iterate, currentFunction, newGradient, effectiveBatchSize);
+    newGradient /= (double) effectiveBatchSize;
+    double sy = 0.0;
+    for (size_t j = 0; j < iterate.n_elem; ++j)
+    {
+      const double sj = iterate[j] - oldIterate[j];
+      newGradient[j] += lambda * sj;
+      sy += sj * (newGradient[j] - gradient[j]);
+    }
+
+    // Only keep pairs of positive curvature, so that the approximation of the
+    // inverse Hessian stays positive definite.
+    if (sy > 0.0)
+    {
+      lbfgs.UpdateBasisSet(pairs, iterate, oldIterate, newGradient, gradient,
+          s, y);
+      ++pairs;
+    }
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+  }
+
+  if (!terminate)
+  {
+    ENS_INFO << "OnlineL_BFGS: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  // Calculate final objective.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_ONLINE_LBFGS_IMPL_HPP
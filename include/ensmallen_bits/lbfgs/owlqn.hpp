@@ -0,0 +1,210 @@
+/**
+ * @file owlqn.hpp
+ * @author Ryan Curtin
+ *
+ * The orthant-wise limited-memory quasi-Newton (OWL-QN) optimizer, for
+ * objectives with an L1 penalty.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_OWLQN_HPP
+#define ENSMALLEN_LBFGS_OWLQN_HPP
+
+#include <ensmallen_bits/function.hpp>
+#include "history_kernels.hpp"
+
+namespace ens {
+
+/**
+ * OWL-QN minimizes f(x) + lambda * ||x||_1, where f(x) is differentiable and
+ * given by the function to optimize, and lambda is the L1 penalty.  It is
+ * L-BFGS with three changes: the search direction is computed from the
+ * pseudo-gradient of the penalized objective (its steepest descent direction),
+ * the direction is projected onto the orthant of the pseudo-gradient, and the
+ * backtracking line search projects every trial point onto the orthant of the
+ * iterate, setting the coordinates that would change sign to zero.  Because of
+ * the projection, coordinates become exactly zero and the iterate is sparse.
+ * The history is built from the gradients of f(x) only, as for L_BFGS.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{andrew2007scalable,
+ *   title     = {Scalable Training of L1-Regularized Log-Linear Models},
+ *   author    = {Andrew, Galen and Gao, Jianfeng},
+ *   booktitle = {Proceedings of the 24th International Conference on
+ *                Machine Learning},
+ *   pages     = {33--40},
+ *   year      = {2007}
+ * }
+ * @endcode
+ *
+ * OWLQN can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class OWLQN
+{
+ public:
+  /**
+   * Initialize the OWL-QN object.  The parameters have the same meaning as for
+   * L_BFGS, and the same defaults.
+   *
+   * @param lambda The L1 penalty.
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum norm of the pseudo-gradient required to
+   *     continue the optimization.
+   * @param factr Minimum relative function value decrease to continue
+   *     the optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   */
+  OWLQN(const double lambda = 1.0,
+        const size_t numBasis = 10,
+        const size_t maxIterations = 10000,
+        const double armijoConstant = 1e-4,
+        const double minGradientNorm = 1e-6,
+        const double factr = 1e-15,
+        const size_t maxLineSearchTrials = 50,
+        const double minStep = 1e-20);
+
+  /**
+   * Use OWL-QN to optimize the given function plus the L1 penalty, starting at
+   * the given iterate point and finding the minimum.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value, including the penalty, is returned.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the L1 penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the L1 penalty.
+  double& Lambda() { return lambda; }
+
+  //! Get the memory size.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the memory size.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the minimum pseudo-gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum pseudo-gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Return the minimum line search step size.
+  double MinStep() const { return minStep; }
+  //! Modify the minimum line search step size.
+  double& MinStep() { return minStep; }
+
+ private:
+  //! The L1 penalty.
+  double lambda;
+  //! Size of memory for this optimizer.
+  size_t numBasis;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+  //! Minimum pseudo-gradient norm required to continue the optimization.
+  double minGradientNorm;
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+  //! Maximum number of trials for the line search.
+  size_t maxLineSearchTrials;
+  //! Minimum step of the line search.
+  double minStep;
+
+  //! Differences between the iterates and the old iterates.
+  arma::cube s;
+  //! Differences between the gradients and the old gradients.
+  arma::cube y;
+
+  /**
+   * Compute the pseudo-gradient of the penalized objective: the gradient of
+   * the penalty is lambda * sign(x) for the nonzero coordinates, and for the
+   * zero coordinates the one-sided derivative that decreases the objective is
+   * taken, or zero if there is none.
+   *
+   * @param iterate The current point.
+   * @param gradient The gradient of the function at the current point.
+   * @param pseudoGradient Matrix to store the pseudo-gradient in.
+   */
+  void PseudoGradient(const arma::mat& iterate,
+                      const arma::mat& gradient,
+                      arma::mat& pseudoGradient) const;
+
+  /**
+   * Backtrack along the search direction, projecting each trial point onto
+   * the orthant of the iterate (given by the signs of the iterate, or of the
+   * negative pseudo-gradient for the zero coordinates), until the penalized
+   * objective decreases sufficiently.  On success the iterate, the objective
+   * and the gradient of the function are those of the accepted point.
+   *
+   * @param function Function to optimize.
+   * @param functionValue Penalized objective at the iterate; will be modified.
+   * @param iterate The current point; will be modified.
+   * @param gradient Gradient of the function at the iterate; will be modified.
+   * @param pseudoGradient Pseudo-gradient at the iterate.
+   * @param newIterateTmp Buffer for the trial points.
+   * @param searchDirection The search direction.
+   * @param iterationNum The iteration number.
+   * @param terminate Set to true if a callback requests termination.
+   * @param callbacks Callback functions.
+   * @return false if no sufficient decrease was found.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  bool LineSearch(FunctionType& function,
+                  double& functionValue,
+                  arma::mat& iterate,
+                  arma::mat& gradient,
+                  const arma::mat& pseudoGradient,
+                  arma::mat& newIterateTmp,
+                  const arma::mat& searchDirection,
+                  const size_t iterationNum,
+                  bool& terminate,
+                  CallbackTypes&... callbacks);
+};
+
+} // namespace ens
+
+#include "owlqn_impl.hpp"
+
+#endif // ENSMALLEN_LBFGS_OWLQN_HPP
@@ -0,0 +1,292 @@
+/**
+ * @file owlqn_impl.hpp
+ * @author Ryan Curtin
+ *
+ * The implementation of the OWL-QN optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_OWLQN_IMPL_HPP
+#define ENSMALLEN_LBFGS_OWLQN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "owlqn.hpp"
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+inline OWLQN::OWLQN(const double lambda,
+                    const size_t numBasis,
+                    const size_t maxIterations,
+                    const double armijoConstant,
+                    const double minGradientNorm,
+                    const double factr,
+                    const size_t maxLineSearchTrials,
+                    const double minStep) :
+    lambda(lambda),
+    numBasis(numBasis),
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    minStep(minStep)
+{
+  // Nothing to do.
+}
+
+inline void OWLQN::PseudoGradient(const arma::mat& iterate,
+                                  const arma::mat& gradient,
+                                  arma::mat& pseudoGradient) const
+{
+  pseudoGradient.set_size(iterate.n_rows, iterate.n_cols);
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    if (iterate[i] > 0.0)
+      pseudoGradient[i] = gradient[i] + lambda;
+    else if (iterate[i] < 0.0)
+      pseudoGradient[i] = gradient[i] - lambda;
+    else if (gradient[i] + lambda < 0.0)
+      pseudoGradient[i] = gradient[i] + lambda; // Moving right decreases.
+    else if (gradient[i] - lambda > 0.0)
+      pseudoGradient[i] = gradient[i] - lambda; // Moving left decreases.
+    else
+      pseudoGradient[i] = 0.0;
+  }
+}
+
+template<typename FunctionType, typename... CallbackTypes>
+bool OWLQN::LineSearch(FunctionType& function,
+                       double& functionValue,
+                       arma::mat& iterate,
+                       arma::mat& gradient,
+                       const arma::mat& pseudoGradient,
+                       arma::mat& newIterateTmp,
+                       const arma::mat& searchDirection,
+                       const size_t iterationNum,
+                       bool& terminate,
+                       CallbackTypes&... callbacks)
+{
+  // The direction was projected onto the orthant of the negative
+  // pseudo-gradient, so it can only fail to be a descent direction if it is
+  // zero.
+  if (arma::dot(pseudoGradient, searchDirection) >= 0.0)
+  {
+    ENS_WARN << "OWL-QN line search direction is not a descent direction "
+        << "(terminating)!" << std::endl;
+    return false;
+  }
+
+  double step = 1.0;
+  for (size_t trial = 0; trial < maxLineSearchTrials; ++trial)
+  {
+    // Take the step, and set the coordinates that leave the orthant of the
+    // iterate to zero.  A zero coordinate may only move in the direction of
+    // the negative pseudo-gradient.  The decrease predicted by the
+    // pseudo-gradient is accumulated at the same time.
+    double predicted = 0.0;
+    for (size_t i = 0; i < iterate.n_elem; ++i)
+    {
+      const double orthant = (iterate[i] != 0.0) ? iterate[i] :
+          -pseudoGradient[i];
+      const double value = iterate[i] + step * searchDirection[i];
+      newIterateTmp[i] = (value * orthant > 0.0) ? value : 0.0;
+      predicted += pseudoGradient[i] * (newIterateTmp[i] - iterate[i]);
+    }
+
+    const double value = function.EvaluateWithGradient(newIterateTmp,
+        gradient) + lambda * arma::accu(arma::abs(newIterateTmp));
+
+    terminate |= Callback::Evaluate(*this, function, newIterateTmp, value,
+        callbacks...);
+
+    // Check the Armijo condition on the penalized objective.
+    if (value <= functionValue + armijoConstant * predicted)
+    {
+      iterate = newIterateTmp;
+      functionValue = value;
+      return true;
+    }
+
+    step *= 0.5;
+    if (step < minStep || terminate)
+      break;
+  }
+
+  ENS_WARN << "OWL-QN line search failed at iteration " << iterationNum
+      << "." << std::endl;
+  return false;
+}
+
+template<typename FunctionType, typename... CallbackTypes>
+double OWLQN::Optimize(FunctionType& function,
+                       arma::mat& iterate,
+                       CallbackTypes&&... callbacks)
+{
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  // The basis sets are kept between calls, so that repeated optimizations of
+  // the same size do not allocate them again.
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
+  if (s.n_rows != rows || s.n_cols != cols || s.n_slices != numBasis)
+  {
+    s.set_size(rows, cols, numBasis);
+    y.set_size(rows, cols, numBasis);
+  }
+  size_t pairs = 0;
+
+  // Whether to optimize until convergence.
+  bool optimizeUntilConvergence = (maxIterations == 0);
+
+  arma::mat gradient(rows, cols);
+  arma::mat pseudoGradient(rows, cols);
+  arma::mat oldIterate(rows, cols);
+  arma::mat oldGradient(rows, cols);
+  arma::mat newIterateTmp(rows, cols);
+  arma::mat searchDirection(rows, cols);
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+
+  // The initial objective, including the penalty, and the pseudo-gradient.
+  double functionValue = f.EvaluateWithGradient(iterate, gradient) +
+      lambda * arma::accu(arma::abs(iterate));
+  double prevFunctionValue = functionValue;
+  PseudoGradient(iterate, gradient, pseudoGradient);
+
+  terminate |= Callback::Evaluate(*this, f, iterate, functionValue,
+      callbacks...);
+  terminate |= Callback::Gradient(*this, f, iterate, pseudoGradient,
+      callbacks...);
+
+  // The main optimization loop.
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+       (itNum != maxIterations)) && !terminate; ++itNum)
+  {
+    prevFunctionValue = functionValue;
+
+    terminate |= Callback::BeginEpoch(*this, f, iterate, itNum,
+        functionValue, callbacks...);
+    if (terminate)
+      break;
+
+    // The pseudo-gradient is zero at the minimum, even at the points where the
+    // penalty is not differentiable, so we can check it on every iteration.
+    if (arma::norm(pseudoGradient, 2) < minGradientNorm)
+    {
+      ENS_WARN << "OWL-QN pseudo-gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // Break if the objective is not a number.
+    if (std::isnan(functionValue))
+    {
+      ENS_WARN << "OWL-QN terminated with objective " << functionValue << "; "
+          << "are the objective and gradient functions implemented correctly?"
+          << std::endl;
+      break;
+    }
+
+    // Choose the scaling factor as L_BFGS does, and compute the search
+    // direction from the pseudo-gradient.
+    double scalingFactor;
+    if (pairs > 0)
+    {
+      const size_t previousPos = (pairs - 1) % numBasis;
+      const size_t n = iterate.n_elem;
+      scalingFactor = math::Dot(n, s.slice_memptr(previousPos),
+          y.slice_memptr(previousPos)) / math::Dot(n,
+          y.slice_memptr(previousPos), y.slice_memptr(previousPos));
+    }
+    else
+    {
+      scalingFactor = 1.0 / arma::norm(pseudoGradient, 2);
+    }
+
+    math::TwoLoopRecursion(pseudoGradient, pairs, numBasis, scalingFactor, s,
+        y, searchDirection);
+
+    // Project the direction onto the orthant of the negative pseudo-gradient.
+    for (size_t i = 0; i < searchDirection.n_elem; ++i)
+    {
+      if (searchDirection[i] * pseudoGradient[i] >= 0.0)
+        searchDirection[i] = 0.0;
+    }
+
+    // Save the old iterate and the gradient before stepping.
+    oldIterate = iterate;
+    oldGradient = gradient;
+
+    if (!LineSearch(f, functionValue, iterate, gradient, pseudoGradient,
+        newIterateTmp, searchDirection, itNum, terminate, callbacks...))
+    {
+      ENS_WARN << "Line search failed.  Stopping optimization." << std::endl;
+      break; // The line search failed; nothing else to try.
+    }
+
+    // It is possible that the difference between the two coordinates is zero.
+    // In this case we terminate successfully.
+    if (std::equal(iterate.begin(), iterate.end(), oldIterate.begin()))
+    {
+      ENS_INFO << "OWL-QN step size of 0 (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    // If we can't make progress on the pseudo-gradient, then we'll also accept
+    // a stable function value.
+    const double denom = std::max(
+        std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0);
+    if ((prevFunctionValue - functionValue) / denom <= factr)
+    {
+      ENS_INFO << "OWL-QN function value stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    PseudoGradient(iterate, gradient, pseudoGradient);
+
+    // Store the new pair, unless the curvature along the step is not positive
+    // (which may happen because of the projection); it would make the inverse
+    // Hessian approximation indefinite.
+    double sy = 0.0;
+    for (size_t i = 0; i < iterate.n_elem; ++i)
+      sy += (iterate[i] - oldIterate[i]) * (gradient[i] - oldGradient[i]);
+
+    if (sy > 0.0)
+    {
+      const size_t overwritePos = pairs % numBasis;
+      double* sMem = s.slice_memptr(overwritePos);
+      double* yMem = y.slice_memptr(overwritePos);
+      for (size_t i = 0; i < iterate.n_elem; ++i)
+      {
+        sMem[i] = iterate[i] - oldIterate[i];
+        yMem[i] = gradient[i] - oldGradient[i];
+      }
+      ++pairs;
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, itNum, functionValue,
+        callbacks...);
+  } // End of the optimization loop.
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_OWLQN_IMPL_HPP
@@ -0,0 +1,192 @@
+/**
+ * @file preconditioners.hpp
+ * @author Ryan Curtin
+ *
+ * Initial inverse Hessian approximations for L_BFGS.  Used as
+ * PreconditionerType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_PRECONDITIONERS_HPP
+#define ENSMALLEN_LBFGS_PRECONDITIONERS_HPP
+
+namespace ens {
+
+/**
+ * The default initial inverse Hessian approximation of L_BFGS, H0 = gamma I,
+ * where gamma is the scaling factor s^T y / y^T y of the newest pair (see
+ * L_BFGSType::ChooseScalingFactor()).
+ *
+ * A preconditioner policy must provide the following methods:
+ *
+ *   // Start a new optimization from the given iterate.
+ *   void Reset(const arma::mat& iterate);
+ *
+ *   // Take the newest pair of differences into account.
+ *   void Update(const arma::mat& iterate,
+ *               const arma::mat& oldIterate,
+ *               const arma::mat& gradient,
+ *               const arma::mat& oldGradient);
+ *
+ *   // Multiply v by H0; scalingFactor is the scalar gamma of L_BFGS.
+ *   void Apply(const double scalingFactor, arma::mat& v) const;
+ */
+class IdentityPreconditioner
+{
+ public:
+  //! Nothing to reset.
+  void Reset(const arma::mat& /* iterate */) { }
+
+  //! Nothing to update.
+  void Update(const arma::mat& /* iterate */,
+              const arma::mat& /* oldIterate */,
+              const arma::mat& /* gradient */,
+              const arma::mat& /* oldGradient */) { }
+
+  //! Multiply v by gamma I.
+  void Apply(const double scalingFactor, arma::mat& v) const
+  {
+    v *= scalingFactor;
+  }
+};
+
+/**
+ * A diagonal initial inverse Hessian approximation, for badly scaled problems
+ * where the scalar gamma I fits some coordinates and not the others.  The
+ * diagonal is either given, as an approximation of the diagonal of the inverse
+ * Hessian (e.g. the inverse of the squared scale of each feature), or
+ * estimated from the pairs of differences.
+ *
+ * A given diagonal D is used as is until the first pair is stored, and then
+ * scaled by s^T y / y^T D y for the newest pair, which is the scaling of L_BFGS
+ * in the metric of D.  An estimated diagonal starts as gamma I, and then has
+ * the coordinate-wise ratios s_i y_i / y_i^2 of the newest pair, clamped to
+ * [gamma / maxRatio, gamma * maxRatio] (and gamma where the ratio is not
+ * positive).
+ */
+class DiagonalPreconditioner
+{
+ public:
+  /**
+   * Create the diagonal preconditioner.
+   *
+   * @param diagonal Approximation of the diagonal of the inverse Hessian, with
+   *     the size of the iterate; if empty, the diagonal is estimated.
+   * @param maxRatio Largest ratio between an estimated diagonal element and
+   *     the scalar scaling factor.
+   */
+  DiagonalPreconditioner(const arma::mat& diagonal = arma::mat(),
+                         const double maxRatio = 100.0) :
+      diagonal(diagonal),
+      maxRatio(maxRatio),
+      scale(1.0),
+      hasPair(false)
+  {
+    // Nothing to do.
+  }
+
+  //! Start a new optimization from the given iterate.
+  void Reset(const arma::mat& iterate)
+  {
+    if (!diagonal.is_empty() && diagonal.n_elem != iterate.n_elem)
+    {
+      std::ostringstream oss;
+      oss << "DiagonalPreconditioner::Reset(): the diagonal has "
+          << diagonal.n_elem << " elements, but the iterate has "
+          << iterate.n_elem << "!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    scale = 1.0;
+    hasPair = false;
+  }
+
+  //! Take the newest pair of differences into account.
+  void Update(const arma::mat& iterate,
+              const arma::mat& oldIterate,
+              const arma::mat& gradient,
+              const arma::mat& oldGradient)
+  {
+    const size_t n = iterate.n_elem;
+    double sy = 0.0, yy = 0.0, ydy = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double si = iterate[i] - oldIterate[i];
+      const double yi = gradient[i] - oldGradient[i];
+      sy += si * yi;
+      yy += yi * yi;
+      if (!diagonal.is_empty())
+        ydy += yi * yi * diagonal[i];
+    }
+
+    // A pair with non-positive curvature says nothing about the scaling.
+    if (sy <= 0.0 || yy == 0.0)
+      return;
+
+    hasPair = true;
+    if (!diagonal.is_empty())
+    {
+      scale = sy / ydy;
+      return;
+    }
+
+    const double gamma = sy / yy;
+    estimate.set_size(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double si = iterate[i] - oldIterate[i];
+      const double yi = gradient[i] - oldGradient[i];
+      const double ratio = (si * yi > 0.0) ? (si * yi) / (yi * yi) : gamma;
+      estimate[i] = std::min(std::max(ratio, gamma / maxRatio),
+          gamma * maxRatio);
+    }
+  }
+
+  //! Multiply v by the diagonal.
+  void Apply(const double scalingFactor, arma::mat& v) const
+  {
+    if (!diagonal.is_empty())
+    {
+      for (size_t i = 0; i < v.n_elem; ++i)
+        v[i] *= scale * diagonal[i];
+    }
+    else if (hasPair)
+    {
+      for (size_t i = 0; i < v.n_elem; ++i)
+        v[i] *= estimate[i];
+    }
+    else
+    {
+      v *= scalingFactor;
+    }
+  }
+
+  //! Get the given diagonal (empty if it is estimated).
+  const arma::mat& Diagonal() const { return diagonal; }
+  //! Modify the given diagonal (empty if it is estimated).
+  arma::mat& Diagonal() { return diagonal; }
+
+  //! Get the largest ratio between an estimated element and gamma.
+  double MaxRatio() const { return maxRatio; }
+  //! Modify the largest ratio between an estimated element and gamma.
+  double& MaxRatio() { return maxRatio; }
+
+ private:
+  //! The given diagonal.
+  arma::mat diagonal;
+  //! The largest ratio between an estimated element and gamma.
+  double maxRatio;
+  //! The scaling of the given diagonal.
+  double scale;
+  //! Whether a pair has been taken into account.
+  bool hasPair;
+  //! The estimated diagonal.
+  arma::vec estimate;
+};
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_PRECONDITIONERS_HPP
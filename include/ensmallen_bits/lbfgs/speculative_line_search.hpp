@@ -0,0 +1,261 @@
+/**
+ * @file speculative_line_search.hpp
+ * @author Ryan Curtin
+ *
+ * Back-tracking line search for L_BFGS that evaluates several step sizes at
+ * once.  Used as LineSearchType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_SPECULATIVE_LINE_SEARCH_HPP
+#define ENSMALLEN_LBFGS_SPECULATIVE_LINE_SEARCH_HPP
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+#include <ensmallen_bits/executors/executors.hpp>
+
+namespace ens {
+
+/**
+ * Speculative back-tracking line search.  BacktrackingWolfeLineSearch evaluates
+ * the step sizes 1, 1/2, 1/4, ... (or 2.1, 2.1^2, ... when the steps are too
+ * short) one after the other, until one satisfies the strong Wolfe conditions.
+ * This line search evaluates the next k step sizes of the same sequence at
+ * once, with the tasks of the executor, and takes the first of them that
+ * satisfies the conditions.  When the evaluation of the function does not use
+ * all the cores by itself (moderate-size problems), a search then takes
+ * roughly the time of one evaluation.
+ *
+ * The steps are the same as those of BacktrackingWolfeLineSearch, and so are
+ * the iterates; only the speculative evaluations after the accepted step are
+ * wasted.  The function must be safe to evaluate from several threads at once
+ * (e.g. EvaluateWithGradient() must not modify members).
+ *
+ * @tparam ExecutorType Executor that runs the evaluations (see SerialExecutor,
+ *     OpenMPExecutor and ThreadPoolExecutor).
+ */
+template<typename ExecutorType = OpenMPExecutor>
+class SpeculativeLineSearchType
+{
+ public:
+  /**
+   * Construct the speculative line search.
+   *
+   * @param steps Number of step sizes evaluated at once (0 means the number of
+   *     threads of the executor).
+   * @param executor Executor that runs the evaluations.
+   */
+  SpeculativeLineSearchType(const size_t steps = 0,
+                            const ExecutorType& executor = ExecutorType()) :
+      steps(steps),
+      executor(executor)
+  { /* Do nothing. */ }
+
+  /**
+   * Perform a speculative back-tracking line search along the search direction
+   * to calculate a step size satisfying the Wolfe conditions.  The parameter
+   * iterate will be modified if the method is successful.
+   *
+   * @param optimizer The optimizer, which holds the parameters of the search.
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param newIterateTmp Matrix to hold the trial points (not used; every
+   *     concurrent trial has its own).
+   * @param searchDirection A vector specifying the search direction.
+   * @param iterationNum The iteration number of the optimizer (not used).
+   * @param terminate Set to true if a callback requests termination.
+   * @param callbacks Callback functions.
+   *
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename... CallbackTypes>
+  bool Search(OptimizerType& optimizer,
+              FunctionType& function,
+              double& functionValue,
+              arma::mat& iterate,
+              arma::mat& gradient,
+              arma::mat& /* newIterateTmp */,
+              const arma::mat& searchDirection,
+              const size_t /* iterationNum */,
+              bool& terminate,
+              CallbackTypes&... callbacks)
+  {
+    ENS_TRACE_ZONE("LineSearch");
+
+    // The initial linear term approximation in the direction of the
+    // search direction.
+    const double initialSearchDirectionDotGradient =
+        arma::dot(gradient, searchDirection);
+
+    // If it is not a descent direction, just report failure.
+    if (initialSearchDirectionDotGradient > 0.0)
+    {
+      ENS_WARN << "L-BFGS line search direction is not a descent direction "
+          << "(terminating)!" << std::endl;
+      return false;
+    }
+
+    const double initialFunctionValue = functionValue;
+    const double linearApproxFunctionValueDecrease =
+        optimizer.ArmijoConstant() * initialSearchDirectionDotGradient;
+
+    // The buffers of the concurrent trials are kept between searches.
+    const size_t k = (steps == 0) ? std::max(executor.Threads(), (size_t) 1) :
+        steps;
+    if (points.size() != k)
+    {
+      points.resize(k);
+      gradients.resize(k);
+      values.set_size(k);
+      stepSizes.set_size(k);
+    }
+
+    // Armijo step size scaling factor for increase and decrease.
+    const double inc = 2.1;
+    const double dec = 0.5;
+    double width = dec;
+    double stepSize = 1.0;
+
+    // The best trial, which is taken if no step satisfies the conditions.
+    size_t best = k;
+    double bestObjective = std::numeric_limits<double>::max();
+    double bestStepSize = 0.0;
+
+    size_t numIterations = 0;
+    bool done = false;
+    while (!done && !terminate)
+    {
+      // The next k steps of the sequence, all with the same scaling.
+      for (size_t i = 0; i < k; ++i)
+      {
+        stepSizes[i] = stepSize;
+        stepSize *= width;
+      }
+
+      executor.Run(k, [&](const size_t i)
+      {
+        points[i] = iterate + stepSizes[i] * searchDirection;
+        values[i] = function.EvaluateWithGradient(points[i], gradients[i]);
+      });
+
+      // Now go through the trials in order, as the sequential search would.
+      for (size_t i = 0; i < k; ++i)
+      {
+        numIterations++;
+        if (values[i] < bestObjective)
+        {
+          // The best trial of an earlier round is overwritten by the next
+          // round, so keep it.
+          bestObjective = values[i];
+          bestStepSize = stepSizes[i];
+          best = i;
+          functionValue = values[i];
+          gradient = gradients[i];
+        }
+
+        terminate |= Callback::Evaluate(optimizer, function, points[i],
+            values[i], callbacks...);
+        terminate |= Callback::Gradient(optimizer, function, points[i],
+            gradients[i], callbacks...);
+        if (terminate)
+          break;
+
+        double newWidth;
+        if (values[i] > initialFunctionValue + stepSizes[i] *
+            linearApproxFunctionValueDecrease)
+        {
+          newWidth = dec;
+        }
+        else
+        {
+          // Check Wolfe's condition.
+          const double searchDirectionDotGradient = arma::dot(gradients[i],
+              searchDirection);
+
+          if (searchDirectionDotGradient < optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            newWidth = inc;
+          }
+          else if (searchDirectionDotGradient > -optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            newWidth = dec;
+          }
+          else
+          {
+            // The strong Wolfe conditions are satisfied; as for
+            // BacktrackingWolfeLineSearch, we move to the best trial.
+            done = true;
+            break;
+          }
+        }
+
+        // Terminate when the step size gets too small or too big or it
+        // exceeds the max number of iterations.
+        if (stepSizes[i] < optimizer.MinStep() ||
+            stepSizes[i] > optimizer.MaxStep() ||
+            numIterations >= optimizer.MaxLineSearchTrials())
+        {
+          done = true;
+          break;
+        }
+
+        // If the sequence changes direction, the speculative steps after this
+        // one are not those the sequential search would take; start the next
+        // round from here.
+        if (newWidth != width)
+        {
+          width = newWidth;
+          stepSize = stepSizes[i] * width;
+          break;
+        }
+      }
+    }
+
+    if (best == k)
+      return false;
+
+    // Move to the new iterate.
+    iterate += bestStepSize * searchDirection;
+    return true;
+  }
+
+  //! Get the number of step sizes evaluated at once.
+  size_t Steps() const { return steps; }
+  //! Modify the number of step sizes evaluated at once.
+  size_t& Steps() { return steps; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
+ private:
+  //! The number of step sizes evaluated at once.
+  size_t steps;
+  //! The executor that runs the evaluations.
+  ExecutorType executor;
+
+  //! The trial points.
+  std::vector<arma::mat> points;
+  //! The gradients at the trial points.
+  std::vector<arma::mat> gradients;
+  //! The objectives at the trial points.
+  arma::vec values;
+  //! The step sizes of the trial points.
+  arma::vec stepSizes;
+};
+
+//! The speculative line search, with the trials evaluated by OpenMP threads.
+typedef SpeculativeLineSearchType<OpenMPExecutor> SpeculativeLineSearch;
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_SPECULATIVE_LINE_SEARCH_HPP
@@ -0,0 +1,269 @@
+/**
+ * @file local_averaging.hpp
+ * @author Marcus Edel
+ *
+ * Local averaging update wrapper: the coordinates (and optionally the state of
+ * the update policy) are averaged over the workers every few steps.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LOCAL_SGD_LOCAL_AVERAGING_HPP
+#define ENSMALLEN_LOCAL_SGD_LOCAL_AVERAGING_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <ensmallen_bits/communicators/communicators.hpp>
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate) so that
+ * each worker takes its own steps on its own data, and every period steps the
+ * coordinates are averaged over the workers.  If averageState is true, the
+ * state of the wrapped policy (e.g. the moments of Adam) is averaged as well.
+ * The coordinates and the state are packed into one buffer, so each average
+ * is a single allreduce.  This communicates period times less than
+ * synchronous data-parallel SGD.  See LocalSGD for the optimizer built on this
+ * policy.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Stich2019,
+ *   title     = {Local {SGD} Converges Fast and Communicates Little},
+ *   author    = {Stich, Sebastian U.},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ * @tparam CommunicatorType Communicator of the workers.
+ */
+template<typename UpdatePolicyType,
+         typename CommunicatorType = NoCommunicator>
+class LocalAveraging
+{
+ public:
+  /**
+   * Construct the LocalAveraging wrapper around the given update policy.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     local steps.
+   * @param period Number of local steps between two averages.
+   * @param averageState Whether the state of the update policy is averaged
+   *     too.
+   * @param communicator Communicator of the workers.
+   */
+  LocalAveraging(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                 const size_t period = 8,
+                 const bool averageState = false,
+                 const CommunicatorType& communicator = CommunicatorType()) :
+      updatePolicy(updatePolicy),
+      period(period),
+      averageState(averageState),
+      communicator(communicator)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(LocalAveraging<UpdatePolicyType, CommunicatorType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        steps(0),
+        averages(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step: the wrapped policy takes a local step, and every period
+     * steps the coordinates are averaged over the workers.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+
+      if (++steps >= parent.period)
+        Average(iterate);
+    }
+
+    /**
+     * Average the coordinates (and the state of the wrapped policy, if
+     * requested) over the workers now.  All the workers must call this at the
+     * same time.
+     *
+     * @param iterate Parameters that minimize the function.
+     */
+    void Average(MatType& iterate)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      steps = 0;
+      ++averages;
+      const size_t workers = parent.communicator.Size();
+      if (workers == 1)
+        return;
+
+      OptimizerState state;
+      std::vector<std::string> names;
+      std::vector<arma::mat> entries;
+      size_t n = iterate.n_elem;
+      if (parent.averageState)
+      {
+        SavePolicyState(instUpdatePolicy, state);
+        names = state.Names();
+        entries.resize(names.size());
+        for (size_t k = 0; k < names.size(); ++k)
+        {
+          state.Get(names[k], entries[k]);
+          n += entries[k].n_elem;
+        }
+      }
+
+      // Pack everything into one buffer, so that a single sum is needed.
+      buffer.set_size(n);
+      ElemType* x = iterate.memptr();
+      for (size_t i = 0; i < iterate.n_elem; ++i)
+        buffer[i] = x[i];
+      size_t offset = iterate.n_elem;
+      for (size_t k = 0; k < entries.size(); ++k)
+      {
+        std::copy(entries[k].begin(), entries[k].end(), buffer.begin() +
+            offset);
+        offset += entries[k].n_elem;
+      }
+
+      parent.communicator.AllReduce(buffer.memptr(), n);
+      buffer /= workers;
+
+      for (size_t i = 0; i < iterate.n_elem; ++i)
+        x[i] = ElemType(buffer[i]);
+      offset = iterate.n_elem;
+      for (size_t k = 0; k < entries.size(); ++k)
+      {
+        std::copy(buffer.begin() + offset, buffer.begin() + offset +
+            entries[k].n_elem, entries[k].begin());
+        state.Set(names[k], entries[k]);
+        offset += entries[k].n_elem;
+      }
+
+      if (parent.averageState)
+        LoadPolicyState(instUpdatePolicy, state);
+    }
+
+    /**
+     * Store the state of the actual update policy in the given state, so that
+     * the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+      state.Set("localSteps", steps);
+    }
+
+    /**
+     * Restore the state of the actual update policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+      state.Get("localSteps", steps);
+    }
+
+    //! Get the number of local steps since the last average.
+    size_t Steps() const { return steps; }
+
+    //! Get the number of averages so far.
+    size_t Averages() const { return averages; }
+
+   private:
+    //! Instantiated parent object.
+    LocalAveraging<UpdatePolicyType, CommunicatorType>& parent;
+
+    //! The update policy used for the local steps.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The number of local steps since the last average.
+    size_t steps;
+
+    //! The number of averages so far.
+    size_t averages;
+
+    //! The buffer of the sums.
+    arma::vec buffer;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the number of local steps between two averages.
+  size_t Period() const { return period; }
+  //! Modify the number of local steps between two averages.
+  size_t& Period() { return period; }
+
+  //! Get whether the state of the update policy is averaged too.
+  bool AverageState() const { return averageState; }
+  //! Modify whether the state of the update policy is averaged too.
+  bool& AverageState() { return averageState; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+ private:
+  //! An instance of the UpdatePolicy used for the local steps.
+  UpdatePolicyType updatePolicy;
+
+  //! The number of local steps between two averages.
+  size_t period;
+
+  //! Whether the state of the update policy is averaged too.
+  bool averageState;
+
+  //! The communicator of the workers.
+  CommunicatorType communicator;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file local_sgd.hpp
+ * @author Marcus Edel
+ *
+ * Local SGD: each worker takes its own steps on its own data, and the
+ * coordinates are averaged over the workers periodically.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LOCAL_SGD_LOCAL_SGD_HPP
+#define ENSMALLEN_LOCAL_SGD_LOCAL_SGD_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+
+#include "local_averaging.hpp"
+
+namespace ens {
+
+/**
+ * Local SGD (periodic model averaging) runs SGD with the given update policy
+ * on each worker (e.g. each MPI process), on the worker's own part of the data,
+ * and averages the coordinates over the workers every period steps; with
+ * averageState, the state of the update policy (e.g. the moments of Adam) is
+ * averaged too.  This communicates period times less than synchronous
+ * data-parallel SGD (see DataParallelSGD), which makes it scale on slow
+ * networks.  The steps are taken by SGD<LocalAveraging<UpdatePolicyType>>, so
+ * any update and decay policy can be used.
+ *
+ * All the workers start from the coordinates of the first worker, and end with
+ * the same averaged coordinates.  The tolerance is checked on the objective of
+ * the epoch summed over the workers, so that all the workers stop together;
+ * they must have the same number of separable functions, and the callbacks of
+ * all the workers must make the same decisions to terminate.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Stich2019,
+ *   title     = {Local {SGD} Converges Fast and Communicates Little},
+ *   author    = {Stich, Sebastian U.},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * @tparam UpdatePolicyType Update policy used to take the local steps.
+ * @tparam DecayPolicyType Decay policy used to adjust the step size.
+ * @tparam CommunicatorType Communicator of the workers (see NoCommunicator;
+ *     MPICommunicator is available if ENS_USE_MPI is defined).
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay,
+         typename CommunicatorType = NoCommunicator>
+class LocalSGD
+{
+ public:
+  //! The update policy of the SGD optimizer that takes the steps.
+  typedef LocalAveraging<UpdatePolicyType, CommunicatorType>
+      LocalUpdatePolicyType;
+
+  /**
+   * Construct the LocalSGD optimizer with the given parameters.  The maximum
+   * number of iterations refers to the maximum number of points that are
+   * processed by each worker.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size of each worker for each step.
+   * @param period Number of local steps between two averages.
+   * @param maxIterations Maximum number of iterations of each worker (0 means
+   *     no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the local function order is shuffled; otherwise,
+   *     each function is visited in linear order.
+   * @param updatePolicy Instantiated update policy used to take the local
+   *     steps.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param communicator Communicator of the workers.
+   * @param averageState Whether the state of the update policy is averaged
+   *     with the coordinates.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   */
+  LocalSGD(const double stepSize = 0.01,
+           const size_t batchSize = 32,
+           const size_t period = 8,
+           const size_t maxIterations = 100000,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+           const DecayPolicyType& decayPolicy = DecayPolicyType(),
+           const CommunicatorType& communicator = CommunicatorType(),
+           const bool averageState = false,
+           const bool resetPolicy = true) :
+      optimizer(stepSize, batchSize, maxIterations, -1.0, shuffle,
+          LocalUpdatePolicyType(updatePolicy, period, averageState,
+          communicator), decayPolicy, resetPolicy),
+      tolerance(tolerance)
+  { /* Nothing to do. */ }
+
+  /**
+   * Optimize the given local function with local SGD.  The given starting point
+   * is replaced by that of the first worker, then modified to store the
+   * finishing point of the algorithm (the same on all workers), and the final
+   * objective value on all the data is returned.
+   *
+   * @tparam DecomposableFunctionType Type of the local function.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Local function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return optimizer.StepSize(); }
+  //! Modify the step size.
+  double& StepSize() { return optimizer.StepSize(); }
+
+  //! Get the batch size of each worker.
+  size_t BatchSize() const { return optimizer.BatchSize(); }
+  //! Modify the batch size of each worker.
+  size_t& BatchSize() { return optimizer.BatchSize(); }
+
+  //! Get the number of local steps between two averages.
+  size_t Period() const { return optimizer.UpdatePolicy().Period(); }
+  //! Modify the number of local steps between two averages.
+  size_t& Period() { return optimizer.UpdatePolicy().Period(); }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return optimizer.MaxIterations(); }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return optimizer.MaxIterations(); }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return optimizer.Shuffle(); }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return optimizer.Shuffle(); }
+
+  //! Get whether or not the update policy parameters are reset before
+  //! Optimize call.
+  bool ResetPolicy() const { return optimizer.ResetPolicy(); }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return optimizer.ResetPolicy(); }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const
+  { return optimizer.UpdatePolicy().UpdatePolicy(); }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy()
+  { return optimizer.UpdatePolicy().UpdatePolicy(); }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const
+  { return optimizer.DecayPolicy(); }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return optimizer.DecayPolicy(); }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const
+  { return optimizer.UpdatePolicy().Communicator(); }
+  //! Modify the communicator.
+  CommunicatorType& Communicator()
+  { return optimizer.UpdatePolicy().Communicator(); }
+
+  //! Get whether the state of the update policy is averaged too.
+  bool AverageState() const { return optimizer.UpdatePolicy().AverageState(); }
+  //! Modify whether the state of the update policy is averaged too.
+  bool& AverageState() { return optimizer.UpdatePolicy().AverageState(); }
+
+  /**
+   * Get the update policy instantiated by the last call to Optimize(); see
+   * SGD::InstUpdatePolicy().
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  const typename LocalUpdatePolicyType::template Policy<MatType, GradType>&
+  InstUpdatePolicy() const
+  {
+    return optimizer.template InstUpdatePolicy<MatType, GradType>();
+  }
+
+  /**
+   * Store the state of the optimizer in the given state; see
+   * SGD::SaveState().
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
+ private:
+  //! The SGD optimizer that takes the steps; its own tolerance is disabled.
+  SGD<LocalUpdatePolicyType, DecayPolicyType> optimizer;
+
+  //! The tolerance for termination.
+  double tolerance;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "local_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * @file local_sgd_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of local SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LOCAL_SGD_LOCAL_SGD_IMPL_HPP
+#define ENSMALLEN_LOCAL_SGD_LOCAL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "local_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+namespace detail {
+
+/**
+ * Terminate the local steps of all the workers together, when the objective of
+ * the epoch summed over the workers changes by less than the tolerance.
+ */
+template<typename CommunicatorType>
+class LocalSGDTermination
+{
+ public:
+  LocalSGDTermination(CommunicatorType& communicator, const double tolerance) :
+      communicator(communicator),
+      tolerance(tolerance),
+      lastObjective(std::numeric_limits<double>::max())
+  { /* Nothing to do. */ }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    double overallObjective = objective;
+    communicator.AllReduce(&overallObjective, 1);
+
+    const bool converged =
+        std::abs(lastObjective - overallObjective) < tolerance;
+    if (converged)
+    {
+      ENS_INFO << "LocalSGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+    }
+
+    lastObjective = overallObjective;
+    return converged;
+  }
+
+ private:
+  //! The communicator of the workers.
+  CommunicatorType& communicator;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The objective of the last epoch, summed over the workers.
+  double lastObjective;
+};
+
+} // namespace detail
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename CommunicatorType>
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type LocalSGD<UpdatePolicyType, DecayPolicyType,
+    CommunicatorType>::Optimize(
+    DecomposableFunctionType& function,
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<DecomposableFunctionType, MatType, GradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, MatType,
+      GradType>();
+
+  CommunicatorType& communicator = Communicator();
+
+  // All the workers must take the same number of steps, or they would wait
+  // for each other forever.  Every worker compares its number of functions with
+  // that of the first one, so that they all fail together.
+  unsigned long long numFunctions = f.NumFunctions();
+  communicator.Broadcast(&numFunctions, 1, 0);
+  unsigned long long mismatches = (numFunctions == f.NumFunctions()) ? 0 : 1;
+  communicator.AllReduce(&mismatches, 1);
+  if (mismatches > 0)
+  {
+    std::ostringstream oss;
+    oss << "LocalSGD::Optimize(): " << mismatches << " of the "
+        << communicator.Size() << " workers do not have the " << numFunctions
+        << " separable functions of the first worker";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // All the workers start from the coordinates of the first one.
+  communicator.Broadcast(iterate.memptr(), iterate.n_elem, 0);
+
+  detail::LocalSGDTermination<CommunicatorType> termination(communicator,
+      tolerance);
+  ElemType objective = optimizer.template Optimize<DecomposableFunctionType,
+      MatType, GradType>(function, iterate, termination, callbacks...);
+
+  // The last local steps have not been averaged yet; then the objective of the
+  // averaged coordinates has to be computed again.
+  if (optimizer.template InstUpdatePolicy<MatType, GradType>().Steps() > 0 &&
+      communicator.Size() > 1)
+  {
+    communicator.AllReduce(iterate.memptr(), iterate.n_elem);
+    iterate /= ElemType(communicator.Size());
+
+    const size_t batchSize = BatchSize();
+    objective = 0;
+    for (size_t i = 0; i < f.NumFunctions(); i += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize,
+          f.NumFunctions() - i);
+      objective += f.Evaluate(iterate, i, effectiveBatchSize);
+    }
+  }
+
+  communicator.AllReduce(&objective, 1);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -2,7 +2,8 @@
  * @file log.hpp
  * @author Marcus Edel
  *
- * Definition of the Info and Warn log functions.
+ * Definition of the Info and Warn log functions, and of the ENS_INFO and
+ * ENS_WARN statements that use them.
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
  * the terms of the 3-clause BSD license.  You should have received a copy of
@@ -12,6 +13,8 @@
 #ifndef ENSMALLEN_LOG_HPP
 #define ENSMALLEN_LOG_HPP
 
+#include "async_log.hpp"
+
 namespace ens {
 /**
  * This class does nothing and should be optimized out entirely by the compiler.
@@ -70,18 +73,55 @@ class NullOutStream
   NullOutStream& operator<<(const T&) { return *this; }
 };
 
-#ifdef ENS_PRINT_INFO
+// If ENS_ASYNC_LOG is defined, the lines are written by a thread of their own.
+#if defined(ENS_PRINT_INFO) && defined(ENS_ASYNC_LOG)
+  static std::ostream& Info = AsyncLogStream<0>(arma::get_cout_stream());
+#elif defined(ENS_PRINT_INFO)
   static std::ostream& Info = arma::get_cout_stream();
 #else
   static NullOutStream Info;
 #endif
 
-#ifdef ENS_PRINT_WARN
+#if defined(ENS_PRINT_WARN) && defined(ENS_ASYNC_LOG)
+  static std::ostream& Warn = AsyncLogStream<1>(arma::get_cerr_stream());
+#elif defined(ENS_PRINT_WARN)
   static std::ostream& Warn = arma::get_cerr_stream();
 #else
   static NullOutStream Warn;
 #endif
 
+//! Wait until every line logged so far to Info and Warn is written.
+inline void FlushLog()
+{
+  #ifdef ENS_ASYNC_LOG
+  AsyncLogSink::Global().Flush();
+  #endif
+}
+
 } // namespace ens
 
+/**
+ * ENS_INFO and ENS_WARN are used like the Info and Warn streams:
+ *
+ * @code
+ * ENS_INFO << "SGD: iteration " << i << ", objective " << objective << "."
+ *     << std::endl;
+ * @endcode
+ *
+ * If the stream is disabled, the whole statement is dropped at compile time,
+ * and its arguments are not even evaluated; this is what the optimizers use,
+ * so that the expensive values they log cost nothing when nobody reads them.
+ */
+#ifdef ENS_PRINT_INFO
+  #define ENS_INFO ens::Info
+#else
+  #define ENS_INFO while (false) ens::Info
+#endif
+
+#ifdef ENS_PRINT_WARN
+  #define ENS_WARN ens::Warn
+#else
+  #define ENS_WARN while (false) ens::Warn
+#endif
+
 #endif
@@ -0,0 +1,292 @@
+/**
+ * @file multi_start.hpp
+ * @author Marcus Edel
+ *
+ * Optimize a function from several random starting points with copies of a
+ * given optimizer, and keep the best result.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTI_START_MULTI_START_HPP
+#define ENSMALLEN_MULTI_START_MULTI_START_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace ens {
+
+/**
+ * MultiStart runs a copy of the given optimizer (for instance L_BFGS,
+ * GradientDescent or Adam) from each of several starting points and keeps the
+ * point with the lowest final objective, which helps on functions with many
+ * local minima.  The first start is the given iterate, and the others are
+ * drawn uniformly in [lowerBound, upperBound] from their own random number
+ * streams.  The starts run in parallel if OpenMP is enabled, one optimizer per
+ * thread; a thread takes the next start as soon as it is done with one.
+ *
+ * Starts that lag behind can be terminated early: if laggardEpochs is
+ * positive, a start whose objective at the end of an epoch (after its first
+ * laggardEpochs epochs) is more than laggardTolerance above the incumbent, the
+ * lowest objective any start has reached so far, terminates.  This needs an
+ * optimizer that takes callbacks; the starts of other optimizers (such as
+ * GradientDescent) always run to the end.  When the starts run in parallel,
+ * the incumbent depends on the timing of the threads, so which starts are
+ * terminated may differ from one run to the next.
+ *
+ * @code
+ * RastriginFunction f(10);
+ * arma::mat coordinates = f.GetInitialPoint();
+ *
+ * // 32 starts of L-BFGS in [-5, 5]; the starts more than 1 above the best
+ * // objective after 5 iterations are terminated.
+ * MultiStart<L_BFGS> optimizer(L_BFGS(), 32, -5, 5, 5, 1.0);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ *
+ * All the starts use the same function, so if they run in parallel, the
+ * function must be safe to use from several threads at once (SGD-based
+ * optimizers shuffle the function unless they are told not to).
+ *
+ * @tparam OptimizerType Type of the optimizer of each start.
+ */
+template<typename OptimizerType>
+class MultiStart
+{
+ public:
+  /**
+   * Construct the MultiStart optimizer with the given optimizer, which is
+   * copied for each start.
+   *
+   * @param optimizer Optimizer to use on each start.
+   * @param numStarts Number of starting points, including the given iterate.
+   * @param lowerBound Lower bound of the random starting points.
+   * @param upperBound Upper bound of the random starting points.
+   * @param laggardEpochs Number of epochs of a start before it may be
+   *     terminated for lagging behind (0 means never).
+   * @param laggardTolerance How far above the incumbent a start may be without
+   *     being terminated.
+   * @param parallel Whether to run the starts with several OpenMP threads.
+   */
+  MultiStart(const OptimizerType& optimizer = OptimizerType(),
+             const size_t numStarts = 10,
+             const double lowerBound = -1.0,
+             const double upperBound = 1.0,
+             const size_t laggardEpochs = 0,
+             const double laggardTolerance = 0.0,
+             const bool parallel = true);
+
+  /**
+   * Optimize the given function from every start.  The given iterate is the
+   * first starting point, and will be modified to store the best final point
+   * of all the starts; its objective is returned.  The final objective of each
+   * start is available with Objectives().
+   *
+   * The callbacks are given to the optimization of every start.  If the
+   * starts run in parallel, they may be called from several threads at once.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of the iterate.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename MatType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  MatType& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the optimizer that is copied for each start.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer that is copied for each start.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the number of starts.
+  size_t NumStarts() const { return numStarts; }
+  //! Modify the number of starts.
+  size_t& NumStarts() { return numStarts; }
+
+  //! Get the lower bound of the random starting points.
+  double LowerBound() const { return lowerBound; }
+  //! Modify the lower bound of the random starting points.
+  double& LowerBound() { return lowerBound; }
+
+  //! Get the upper bound of the random starting points.
+  double UpperBound() const { return upperBound; }
+  //! Modify the upper bound of the random starting points.
+  double& UpperBound() { return upperBound; }
+
+  //! Get the number of epochs before a start may be terminated (0 means
+  //! never).
+  size_t LaggardEpochs() const { return laggardEpochs; }
+  //! Modify the number of epochs before a start may be terminated (0 means
+  //! never).
+  size_t& LaggardEpochs() { return laggardEpochs; }
+
+  //! Get how far above the incumbent a start may be.
+  double LaggardTolerance() const { return laggardTolerance; }
+  //! Modify how far above the incumbent a start may be.
+  double& LaggardTolerance() { return laggardTolerance; }
+
+  //! Get whether the starts run in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the starts run in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the final objectives of the starts of the last call to Optimize().
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the index of the start that found the final point in the last call
+  //! to Optimize().
+  size_t BestStart() const { return bestStart; }
+
+  //! Get the number of starts terminated early in the last call to
+  //! Optimize().
+  size_t Terminated() const { return terminated; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The lowest objective reached by any start so far, shared by the starts.
+  struct Incumbent
+  {
+    //! The objective.
+    double objective;
+    //! The lock for the objective.
+    std::mutex mutex;
+  };
+
+  /**
+   * The callback that lowers the incumbent when its start leads, and
+   * terminates the start when it lags behind.
+   */
+  class Laggard
+  {
+   public:
+    //! Watch one start; the incumbent must outlive the callback.
+    Laggard(Incumbent& incumbent, const size_t epochs, const double tolerance) :
+        incumbent(incumbent),
+        epochs(epochs),
+        tolerance(tolerance),
+        terminated(false)
+    { /* Nothing to do. */ }
+
+    //! Compare the objective of the start with the incumbent.
+    template<typename O, typename FunctionType, typename MatType>
+    bool EndEpoch(O& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t epoch,
+                  const double objective)
+    {
+      terminated = Lagging(epoch, objective);
+      return terminated;
+    }
+
+    //! Lower the incumbent to the given objective if it is lower, and return
+    //! whether a start with that objective at that epoch lags behind.
+    bool Lagging(const size_t epoch, const double objective)
+    {
+      std::lock_guard<std::mutex> lock(incumbent.mutex);
+      incumbent.objective = std::min(incumbent.objective, objective);
+      return epochs > 0 && epoch >= epochs &&
+          objective > incumbent.objective + tolerance;
+    }
+
+    //! Get whether the start was terminated.
+    bool Terminated() const { return terminated; }
+
+   private:
+    //! The incumbent shared by the starts.
+    Incumbent& incumbent;
+
+    //! The number of epochs before the start may be terminated.
+    size_t epochs;
+
+    //! How far above the incumbent the start may be.
+    double tolerance;
+
+    //! Whether the start was terminated.
+    bool terminated;
+  };
+
+  /**
+   * Detect whether OptimizerType can optimize FunctionType with a callback.
+   */
+  template<typename FunctionType, typename MatType>
+  struct TakesCallbacks
+  {
+    template<typename O>
+    static auto Check(int) -> decltype(
+        std::declval<O&>().Optimize(std::declval<FunctionType&>(),
+            std::declval<MatType&>(), std::declval<Laggard&>()),
+        std::true_type());
+    template<typename>
+    static std::false_type Check(...);
+
+    static const bool value = decltype(Check<OptimizerType>(0))::value;
+  };
+
+  //! Run one start with the laggard callback.
+  template<typename FunctionType, typename MatType, typename... CallbackTypes>
+  static double Run(OptimizerType& startOptimizer,
+                    FunctionType& function,
+                    MatType& iterate,
+                    Laggard& laggard,
+                    std::true_type /* takesCallbacks */,
+                    CallbackTypes&&... callbacks);
+
+  //! Run one start of an optimizer that does not take callbacks.
+  template<typename FunctionType, typename MatType, typename... CallbackTypes>
+  static double Run(OptimizerType& startOptimizer,
+                    FunctionType& function,
+                    MatType& iterate,
+                    Laggard& laggard,
+                    std::false_type /* takesCallbacks */,
+                    CallbackTypes&&... callbacks);
+
+  //! The optimizer that is copied for each start.
+  OptimizerType optimizer;
+
+  //! The number of starts.
+  size_t numStarts;
+
+  //! The lower bound of the random starting points.
+  double lowerBound;
+
+  //! The upper bound of the random starting points.
+  double upperBound;
+
+  //! The number of epochs before a start may be terminated.
+  size_t laggardEpochs;
+
+  //! How far above the incumbent a start may be.
+  double laggardTolerance;
+
+  //! Whether the starts run in parallel.
+  bool parallel;
+
+  //! The final objectives of the starts of the last call to Optimize().
+  arma::vec objectives;
+
+  //! The start that found the final point.
+  size_t bestStart;
+
+  //! The number of starts terminated early.
+  size_t terminated;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "multi_start_impl.hpp"
+
+#endif
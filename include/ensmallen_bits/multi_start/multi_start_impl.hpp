@@ -0,0 +1,156 @@
+/**
+ * @file multi_start_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the MultiStart optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTI_START_MULTI_START_IMPL_HPP
+#define ENSMALLEN_MULTI_START_MULTI_START_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "multi_start.hpp"
+
+namespace ens {
+
+template<typename OptimizerType>
+MultiStart<OptimizerType>::MultiStart(const OptimizerType& optimizer,
+                                      const size_t numStarts,
+                                      const double lowerBound,
+                                      const double upperBound,
+                                      const size_t laggardEpochs,
+                                      const double laggardTolerance,
+                                      const bool parallel) :
+    optimizer(optimizer),
+    numStarts(numStarts),
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    laggardEpochs(laggardEpochs),
+    laggardTolerance(laggardTolerance),
+    parallel(parallel),
+    bestStart(0),
+    terminated(0)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType, typename... CallbackTypes>
+double MultiStart<OptimizerType>::Optimize(FunctionType& function,
+                                           MatType& iterate,
+                                           CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  if (numStarts == 0)
+  {
+    throw std::invalid_argument("MultiStart::Optimize(): the number of starts "
+        "must be positive.");
+  }
+
+  if (laggardEpochs > 0 && !TakesCallbacks<FunctionType, MatType>::value)
+  {
+    ENS_WARN << "MultiStart: the optimizer does not take callbacks, so the "
+        << "starts will not be terminated early." << std::endl;
+  }
+
+  // The random starting points come from the stream of this optimization.
+  const uint64_t seed = NewRandomGenerator().Next64();
+
+  objectives.zeros(numStarts);
+  std::vector<MatType> iterates(numStarts, iterate);
+  std::vector<char> lagged(numStarts, 0);
+
+  Incumbent incumbent;
+  incumbent.objective = std::numeric_limits<double>::max();
+
+  // Every thread takes the next start that has not been run, so that a thread
+  // done with a start that converged quickly moves on.
+  std::atomic<size_t> nextStart(0);
+  const auto run = [&]()
+  {
+    for (size_t k = nextStart++; k < numStarts; k = nextStart++)
+    {
+      // Each start has its own stream, for its starting point and for the
+      // random numbers of its optimizer.
+      RandomGenerator generator(seed, k);
+      RandomScope randomScope(generator);
+      if (k > 0)
+      {
+        generator.Randu(iterates[k]);
+        iterates[k] = lowerBound + (upperBound - lowerBound) * iterates[k];
+      }
+
+      OptimizerType startOptimizer(optimizer);
+      Laggard laggard(incumbent, laggardEpochs, laggardTolerance);
+      objectives[k] = Run(startOptimizer, function, iterates[k], laggard,
+          std::integral_constant<bool, TakesCallbacks<FunctionType,
+              MatType>::value>(), callbacks...);
+      lagged[k] = laggard.Terminated();
+
+      // The final objective of the start may lower the incumbent.
+      laggard.Lagging(0, objectives[k]);
+    }
+  };
+
+  #ifdef ENS_USE_OPENMP
+    const size_t numThreads = parallel ? std::min(
+        (size_t) omp_get_max_threads(), numStarts) : 1;
+  #else
+    const size_t numThreads = 1;
+  #endif
+
+  if (numThreads <= 1)
+  {
+    run();
+  }
+  else
+  {
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      run();
+    }
+  }
+
+  arma::uword best = 0;
+  objectives.min(best);
+  bestStart = best;
+  terminated = std::count(lagged.begin(), lagged.end(), 1);
+  iterate = iterates[bestStart];
+
+  ENS_INFO << "MultiStart: ran " << numStarts << " starts (" << terminated
+      << " terminated early); best objective " << objectives[bestStart]
+      << " from start " << bestStart << "." << std::endl;
+
+  return objectives[bestStart];
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType, typename... CallbackTypes>
+double MultiStart<OptimizerType>::Run(OptimizerType& startOptimizer,
+                                      FunctionType& function,
+                                      MatType& iterate,
+                                      Laggard& laggard,
+                                      std::true_type /* takesCallbacks */,
+                                      CallbackTypes&&... callbacks)
+{
+  return startOptimizer.Optimize(function, iterate, laggard, callbacks...);
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType, typename... CallbackTypes>
+double MultiStart<OptimizerType>::Run(OptimizerType& startOptimizer,
+                                      FunctionType& function,
+                                      MatType& iterate,
+                                      Laggard& /* laggard */,
+                                      std::false_type /* takesCallbacks */,
+                                      CallbackTypes&&... callbacks)
+{
+  return startOptimizer.Optimize(function, iterate, callbacks...);
+}
+
+} // namespace ens
+
+#endif
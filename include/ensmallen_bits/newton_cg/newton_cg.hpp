@@ -0,0 +1,173 @@
+/**
+ * @file newton_cg.hpp
+ * @author Marcus Edel
+ *
+ * Truncated Newton (Newton-CG) optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * NewtonCG is a truncated Newton method: at each iteration, the Newton system
+ * \f$ \nabla^2 f(x) p = -\nabla f(x) \f$ is solved inexactly with the conjugate
+ * gradient method, which only needs products of the Hessian with vectors,
+ * and the step along p is chosen by a back-tracking line search.  The conjugate
+ * gradient iterations stop once the residual is below
+ * \f$ \eta \| \nabla f(x) \| \f$, with the forcing term
+ * \f$ \eta = \min(1/2, \sqrt{\| \nabla f(x) \|}) \f$, or when a direction of
+ * negative curvature is found.  For more information, see the following.
+ *
+ * @code
+ * @book{Nocedal2006,
+ *   title     = {Numerical Optimization},
+ *   author    = {Nocedal, Jorge and Wright, Stephen J.},
+ *   edition   = {2},
+ *   publisher = {Springer},
+ *   year      = {2006},
+ *   chapter   = {7.1}
+ * }
+ * @endcode
+ *
+ * If the function has a HessianVectorProduct() method (see the documentation on
+ * function types), the products are exact; otherwise they are approximated by
+ * finite differences of the gradient.  On ill-conditioned problems with cheap
+ * Hessian-vector products, such as generalized linear models, this converges in
+ * far fewer passes over the data than L_BFGS.
+ *
+ * NewtonCG can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class NewtonCG
+{
+ public:
+  /**
+   * Construct the Newton-CG optimizer with the given parameters.
+   *
+   * @param maxIterations Maximum number of (outer) iterations allowed (0 means
+   *     no limit).
+   * @param maxCGIterations Maximum number of conjugate gradient iterations per
+   *     outer iteration (0 means the number of coordinates).
+   * @param minGradientNorm Minimum gradient norm required to continue the
+   *     optimization.
+   * @param factr Minimum relative function value decrease to continue the
+   *     optimization.
+   * @param armijoConstant Sufficient decrease constant of the line search.
+   * @param maxLineSearchTrials Maximum number of step halvings of the line
+   *     search.
+   */
+  NewtonCG(const size_t maxIterations = 1000,
+           const size_t maxCGIterations = 0,
+           const double minGradientNorm = 1e-6,
+           const double factr = 1e-15,
+           const double armijoConstant = 1e-4,
+           const size_t maxLineSearchTrials = 50);
+
+  /**
+   * Optimize the given function using Newton-CG.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch of
+   * NewtonCG is one outer iteration.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the maximum number of CG iterations (0 means the dimension).
+  size_t MaxCGIterations() const { return maxCGIterations; }
+  //! Modify the maximum number of CG iterations (0 means the dimension).
+  size_t& MaxCGIterations() { return maxCGIterations; }
+
+  //! Get the minimum gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Get the number of Hessian-vector products of the last call to Optimize().
+  size_t HessianProducts() const { return hessianProducts; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Solve the Newton system inexactly with conjugate gradient, starting at
+   * zero, and store the search direction in direction.
+   *
+   * @return Number of Hessian-vector products.
+   */
+  template<typename FunctionType>
+  size_t SolveNewtonSystem(FunctionType& function,
+                           const arma::mat& iterate,
+                           const arma::mat& gradient,
+                           arma::mat& direction);
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The maximum number of CG iterations.
+  size_t maxCGIterations;
+
+  //! The minimum gradient norm.
+  double minGradientNorm;
+
+  //! The minimum relative decrease of the objective.
+  double factr;
+
+  //! The sufficient decrease constant of the line search.
+  double armijoConstant;
+
+  //! The maximum number of line search trials.
+  size_t maxLineSearchTrials;
+
+  //! The number of Hessian-vector products of the last call to Optimize().
+  size_t hessianProducts;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "newton_cg_impl.hpp"
+
+#endif
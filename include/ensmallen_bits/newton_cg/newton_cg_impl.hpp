@@ -0,0 +1,205 @@
+/**
+ * @file newton_cg_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the truncated Newton (Newton-CG) optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "newton_cg.hpp"
+
+namespace ens {
+
+inline NewtonCG::NewtonCG(const size_t maxIterations,
+                          const size_t maxCGIterations,
+                          const double minGradientNorm,
+                          const double factr,
+                          const double armijoConstant,
+                          const size_t maxLineSearchTrials) :
+    maxIterations(maxIterations),
+    maxCGIterations(maxCGIterations),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    armijoConstant(armijoConstant),
+    maxLineSearchTrials(maxLineSearchTrials),
+    hessianProducts(0)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType>
+size_t NewtonCG::SolveNewtonSystem(FunctionType& function,
+                                   const arma::mat& iterate,
+                                   const arma::mat& gradient,
+                                   arma::mat& direction)
+{
+  const double gradientNorm = arma::norm(gradient, 2);
+  const double tolerance = std::min(0.5, std::sqrt(gradientNorm)) *
+      gradientNorm;
+  const size_t maxSteps = (maxCGIterations == 0) ? iterate.n_elem :
+      maxCGIterations;
+
+  // The residual of the Newton system at direction is r = H direction + g.
+  direction.zeros(arma::size(iterate));
+  arma::mat residual(gradient);
+  arma::mat conjugate = -gradient;
+  arma::mat product;
+  double residualNorm = gradientNorm * gradientNorm;
+
+  size_t products = 0;
+  for (size_t k = 0; k < maxSteps; ++k)
+  {
+    HessianVectorProduct(function, iterate, gradient, conjugate, product);
+    ++products;
+
+    // On a direction of non-positive curvature, stop with the last direction,
+    // or with the steepest descent direction on the first iteration.
+    const double curvature = arma::dot(conjugate, product);
+    if (curvature <= 0.0)
+    {
+      if (k == 0)
+        direction = -gradient;
+      break;
+    }
+
+    const double alpha = residualNorm / curvature;
+    direction += alpha * conjugate;
+    residual += alpha * product;
+
+    const double newResidualNorm = arma::dot(residual, residual);
+    if (std::sqrt(newResidualNorm) <= tolerance)
+      break;
+
+    conjugate *= newResidualNorm / residualNorm;
+    conjugate -= residual;
+    residualNorm = newResidualNorm;
+  }
+
+  return products;
+}
+
+template<typename FunctionType, typename... CallbackTypes>
+double NewtonCG::Optimize(FunctionType& function,
+                          arma::mat& iterate,
+                          CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  hessianProducts = 0;
+
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat newGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat direction, newIterate;
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+
+  double objective = f.EvaluateWithGradient(iterate, gradient);
+  terminate |= Callback::Evaluate(*this, f, iterate, objective, callbacks...);
+  terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
+
+  for (size_t i = 0; (maxIterations == 0 || i != maxIterations) && !terminate;
+       ++i)
+  {
+    terminate |= Callback::BeginEpoch(*this, f, iterate, i, objective,
+        callbacks...);
+    if (terminate)
+      break;
+
+    if (std::isnan(objective) || std::isinf(objective))
+    {
+      ENS_WARN << "NewtonCG: converged to " << objective << "; terminating "
+          << "with failure.  Are the objective and gradient implemented "
+          << "correctly?"
+          << std::endl;
+      break;
+    }
+
+    if (arma::norm(gradient, 2) < minGradientNorm)
+    {
+      ENS_INFO << "NewtonCG: gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // The Hessian-vector products are taken on the user's function, so that
+    // its HessianVectorProduct() method is detected.
+    hessianProducts += SolveNewtonSystem(function, iterate, gradient,
+        direction);
+
+    // The direction of conjugate gradient is a descent direction unless the
+    // approximate products were too inaccurate.
+    double slope = arma::dot(gradient, direction);
+    if (slope >= 0.0)
+    {
+      direction = -gradient;
+      slope = -arma::dot(gradient, gradient);
+    }
+
+    // Back-tracking line search from the Newton step.
+    double step = 1.0;
+    double newObjective = objective;
+    bool accepted = false;
+    for (size_t t = 0; t < maxLineSearchTrials; ++t, step *= 0.5)
+    {
+      newIterate = iterate + step * direction;
+      newObjective = f.EvaluateWithGradient(newIterate, newGradient);
+      terminate |= Callback::Evaluate(*this, f, newIterate, newObjective,
+          callbacks...);
+
+      if (newObjective <= objective + armijoConstant * step * slope)
+      {
+        accepted = true;
+        break;
+      }
+    }
+
+    if (!accepted)
+    {
+      ENS_WARN << "NewtonCG: line search failed.  Stopping optimization."
+          << std::endl;
+      break;
+    }
+
+    const double previousObjective = objective;
+    SwapInPlace(iterate, newIterate);
+    gradient.swap(newGradient);
+    objective = newObjective;
+
+    ENS_INFO << "NewtonCG: iteration " << i << ", objective " << objective
+        << "." << std::endl;
+
+    terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, i, objective,
+        callbacks...);
+
+    const double denom = std::max(std::max(std::abs(previousObjective),
+        std::abs(objective)), 1.0);
+    if ((previousObjective - objective) / denom <= factr)
+    {
+      ENS_INFO << "NewtonCG: function value stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
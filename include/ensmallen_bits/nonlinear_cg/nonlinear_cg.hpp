@@ -0,0 +1,221 @@
+/**
+ * @file nonlinear_cg.hpp
+ * @author Marcus Edel
+ *
+ * Nonlinear conjugate gradient optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_HPP
+#define ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_HPP
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/lbfgs/more_thuente_line_search.hpp>
+#include "update_rules.hpp"
+
+namespace ens {
+
+/**
+ * The nonlinear conjugate gradient method, which minimizes a function along
+ * the directions
+ *
+ *   d_0 = -g_0,   d_k = -g_k + beta_k d_{k - 1},
+ *
+ * with a line search satisfying the strong Wolfe conditions.  beta_k is given
+ * by UpdateRuleType; HagerZhang (the default) and PolakRibierePlus are
+ * available (see update_rules.hpp for the interface).  Besides the iterate, an
+ * optimization only stores four matrices of its size (the gradient, the last
+ * gradient, the direction and the trial point of the line search), so it is
+ * suited to problems that are too large for the history of L_BFGS, at the cost
+ * of more iterations.
+ *
+ * The line search is given by LineSearchType, with the interface of the line
+ * searches of L_BFGS (see lbfgs.hpp); MoreThuenteLineSearch (the default) finds
+ * a step satisfying the strong Wolfe conditions.  The Wolfe parameter is
+ * smaller than for L_BFGS (0.1 instead of 0.9), since conjugate gradient
+ * directions need more accurate steps.  If a direction is not a descent
+ * direction, the method restarts with the steepest descent direction; it can
+ * also restart every given number of iterations.  For more information, see
+ * the following.
+ *
+ * @code
+ * @book{Nocedal2006,
+ *   title     = {Numerical Optimization},
+ *   author    = {Nocedal, Jorge and Wright, Stephen J.},
+ *   edition   = {2},
+ *   publisher = {Springer},
+ *   year      = {2006},
+ *   chapter   = {5.2}
+ * }
+ * @endcode
+ *
+ * NonlinearCG can optimize differentiable functions.  For more details, see
+ * the documentation on function types included with this distribution or on
+ * the ensmallen website.
+ *
+ * @tparam UpdateRuleType Choice of beta.
+ * @tparam LineSearchType Line search policy.
+ */
+template<typename UpdateRuleType = HagerZhang,
+         typename LineSearchType = MoreThuenteLineSearch>
+class NonlinearCGType
+{
+ public:
+  /**
+   * Construct the nonlinear conjugate gradient optimizer with the given
+   * parameters.
+   *
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param wolfe Parameter for detecting the Wolfe condition.
+   * @param minGradientNorm Minimum gradient norm required to continue the
+   *     optimization.
+   * @param factr Minimum relative function value decrease to continue the
+   *     optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   * @param maxStep The maximum step of the line search.
+   * @param restartInterval Number of iterations after which the method
+   *     restarts with the steepest descent direction (0 means never).
+   * @param updateRule The choice of beta.
+   * @param lineSearch The line search policy.
+   */
+  NonlinearCGType(const size_t maxIterations = 10000,
+                  const double armijoConstant = 1e-4,
+                  const double wolfe = 0.1,
+                  const double minGradientNorm = 1e-6,
+                  const double factr = 1e-15,
+                  const size_t maxLineSearchTrials = 50,
+                  const double minStep = 1e-20,
+                  const double maxStep = 1e20,
+                  const size_t restartInterval = 0,
+                  const UpdateRuleType& updateRule = UpdateRuleType(),
+                  const LineSearchType& lineSearch = LineSearchType());
+
+  /**
+   * Optimize the given function using nonlinear conjugate gradient.  The given
+   * starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch is one
+   * iteration, and every evaluation in the line search is reported.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the Armijo condition constant.
+  double ArmijoConstant() const { return armijoConstant; }
+  //! Modify the Armijo condition constant.
+  double& ArmijoConstant() { return armijoConstant; }
+
+  //! Get the Wolfe parameter.
+  double Wolfe() const { return wolfe; }
+  //! Modify the Wolfe parameter.
+  double& Wolfe() { return wolfe; }
+
+  //! Get the minimum gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the factr value.
+  double Factr() const { return factr; }
+  //! Modify the factr value.
+  double& Factr() { return factr; }
+
+  //! Get the maximum number of line search trials.
+  size_t MaxLineSearchTrials() const { return maxLineSearchTrials; }
+  //! Modify the maximum number of line search trials.
+  size_t& MaxLineSearchTrials() { return maxLineSearchTrials; }
+
+  //! Return the minimum line search step size.
+  double MinStep() const { return minStep; }
+  //! Modify the minimum line search step size.
+  double& MinStep() { return minStep; }
+
+  //! Return the maximum line search step size.
+  double MaxStep() const { return maxStep; }
+  //! Modify the maximum line search step size.
+  double& MaxStep() { return maxStep; }
+
+  //! Get the number of iterations between restarts (0 means never).
+  size_t RestartInterval() const { return restartInterval; }
+  //! Modify the number of iterations between restarts (0 means never).
+  size_t& RestartInterval() { return restartInterval; }
+
+  //! Get the update rule.
+  const UpdateRuleType& UpdateRule() const { return updateRule; }
+  //! Modify the update rule.
+  UpdateRuleType& UpdateRule() { return updateRule; }
+
+  //! Get the line search policy.
+  const LineSearchType& LineSearch() const { return lineSearch; }
+  //! Modify the line search policy.
+  LineSearchType& LineSearch() { return lineSearch; }
+
+  //! Get the number of restarts with the steepest descent direction in the
+  //! last call to Optimize() (not counting the periodic restarts).
+  size_t Restarts() const { return restarts; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Parameter for determining the Armijo condition.
+  double armijoConstant;
+  //! Parameter for detecting the Wolfe condition.
+  double wolfe;
+  //! Minimum gradient norm required to continue the optimization.
+  double minGradientNorm;
+  //! Minimum relative function value decrease to continue the optimization.
+  double factr;
+  //! Maximum number of trials for the line search.
+  size_t maxLineSearchTrials;
+  //! Minimum step of the line search.
+  double minStep;
+  //! Maximum step of the line search.
+  double maxStep;
+  //! Number of iterations between restarts.
+  size_t restartInterval;
+  //! The choice of beta.
+  UpdateRuleType updateRule;
+  //! The line search policy.
+  LineSearchType lineSearch;
+  //! The number of restarts of the last call to Optimize().
+  size_t restarts;
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+//! The nonlinear conjugate gradient method with the Hager-Zhang choice of beta
+//! and the More-Thuente line search.
+typedef NonlinearCGType<> NonlinearCG;
+
+} // namespace ens
+
+// Include implementation.
+#include "nonlinear_cg_impl.hpp"
+
+#endif // ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_HPP
@@ -0,0 +1,168 @@
+/**
+ * @file nonlinear_cg_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the nonlinear conjugate gradient optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_IMPL_HPP
+#define ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "nonlinear_cg.hpp"
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+template<typename UpdateRuleType, typename LineSearchType>
+NonlinearCGType<UpdateRuleType, LineSearchType>::NonlinearCGType(
+    const size_t maxIterations,
+    const double armijoConstant,
+    const double wolfe,
+    const double minGradientNorm,
+    const double factr,
+    const size_t maxLineSearchTrials,
+    const double minStep,
+    const double maxStep,
+    const size_t restartInterval,
+    const UpdateRuleType& updateRule,
+    const LineSearchType& lineSearch) :
+    maxIterations(maxIterations),
+    armijoConstant(armijoConstant),
+    wolfe(wolfe),
+    minGradientNorm(minGradientNorm),
+    factr(factr),
+    maxLineSearchTrials(maxLineSearchTrials),
+    minStep(minStep),
+    maxStep(maxStep),
+    restartInterval(restartInterval),
+    updateRule(updateRule),
+    lineSearch(lineSearch),
+    restarts(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdateRuleType, typename LineSearchType>
+template<typename FunctionType, typename... CallbackTypes>
+double NonlinearCGType<UpdateRuleType, LineSearchType>::Optimize(
+    FunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  // The only buffers of the optimization.
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat oldGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat direction(iterate.n_rows, iterate.n_cols);
+  arma::mat newIterateTmp(iterate.n_rows, iterate.n_cols);
+
+  restarts = 0;
+  const bool optimizeUntilConvergence = (maxIterations == 0);
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+
+  // The initial function value and gradient.
+  double functionValue = f.EvaluateWithGradient(iterate, gradient);
+
+  terminate |= Callback::Evaluate(*this, f, iterate, functionValue,
+      callbacks...);
+  terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
+
+  // The first direction is the steepest descent direction.
+  for (size_t i = 0; i < direction.n_elem; ++i)
+    direction[i] = -gradient[i];
+
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+       (itNum != maxIterations)) && !terminate; ++itNum)
+  {
+    const double prevFunctionValue = functionValue;
+
+    terminate |= Callback::BeginEpoch(*this, f, iterate, itNum,
+        functionValue, callbacks...);
+    if (terminate)
+      break;
+
+    // Break when the norm of the gradient becomes too small, but always take
+    // at least one step.
+    if (itNum > 0 && arma::norm(gradient, 2) < minGradientNorm)
+    {
+      ENS_INFO << "NonlinearCG: gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    if (std::isnan(functionValue))
+    {
+      ENS_WARN << "NonlinearCG: terminated with objective " << functionValue
+          << "; are the objective and gradient functions implemented "
+          << "correctly?" << std::endl;
+      break;
+    }
+
+    // Start over with the steepest descent direction if the direction does
+    // not descend.
+    if (arma::dot(gradient, direction) >= 0.0)
+    {
+      for (size_t i = 0; i < direction.n_elem; ++i)
+        direction[i] = -gradient[i];
+      ++restarts;
+    }
+
+    oldGradient = gradient;
+    if (!lineSearch.Search(*this, f, functionValue, iterate, gradient,
+        newIterateTmp, direction, itNum, terminate, callbacks...))
+    {
+      ENS_WARN << "NonlinearCG: line search failed.  Stopping optimization."
+          << std::endl;
+      break;
+    }
+
+    ENS_INFO << "NonlinearCG: iteration " << itNum << ", objective "
+        << functionValue << "." << std::endl;
+
+    // If we can't make progress on the gradient, then we'll also accept a
+    // stable function value.
+    const double denom = std::max(std::max(std::abs(prevFunctionValue),
+        std::abs(functionValue)), 1.0);
+    if ((prevFunctionValue - functionValue) / denom <= factr)
+    {
+      ENS_INFO << "NonlinearCG: function value stable (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // The next direction, in place: d = -g + beta d.
+    const bool restart = (restartInterval > 0 &&
+        (itNum + 1) % restartInterval == 0);
+    const double beta = restart ? 0.0 :
+        updateRule.Beta(gradient, oldGradient, direction);
+    for (size_t i = 0; i < direction.n_elem; ++i)
+      direction[i] = beta * direction[i] - gradient[i];
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, itNum, functionValue,
+        callbacks...);
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
+
+} // namespace ens
+
+#endif // ENSMALLEN_NONLINEAR_CG_NONLINEAR_CG_IMPL_HPP
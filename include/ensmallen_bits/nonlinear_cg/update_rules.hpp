@@ -0,0 +1,124 @@
+/**
+ * @file update_rules.hpp
+ * @author Marcus Edel
+ *
+ * Choices of the parameter beta of the nonlinear conjugate gradient method.
+ * Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NONLINEAR_CG_UPDATE_RULES_HPP
+#define ENSMALLEN_NONLINEAR_CG_UPDATE_RULES_HPP
+
+namespace ens {
+
+/**
+ * The Polak-Ribiere+ choice of beta,
+ *
+ *   beta = max(0, g^T (g - g_old) / g_old^T g_old),
+ *
+ * which restarts with the steepest descent direction whenever beta would be
+ * negative.
+ *
+ * An update rule must provide the following method:
+ *
+ *   // Return beta, given the new gradient, the gradient at the last iterate
+ *   // and the last search direction.
+ *   double Beta(const arma::mat& gradient,
+ *               const arma::mat& oldGradient,
+ *               const arma::mat& direction) const;
+ */
+class PolakRibierePlus
+{
+ public:
+  //! Return beta, computed in one pass over the gradients.
+  double Beta(const arma::mat& gradient,
+              const arma::mat& oldGradient,
+              const arma::mat& /* direction */) const
+  {
+    double gy = 0.0, oldNorm = 0.0;
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+    {
+      gy += gradient[i] * (gradient[i] - oldGradient[i]);
+      oldNorm += oldGradient[i] * oldGradient[i];
+    }
+
+    return (oldNorm > 0.0) ? std::max(gy / oldNorm, 0.0) : 0.0;
+  }
+};
+
+/**
+ * The choice of beta of Hager and Zhang (CG_DESCENT), which gives descent
+ * directions independently of the line search:
+ *
+ *   beta = (y - 2 d ||y||^2 / d^T y)^T g / d^T y,   y = g - g_old,
+ *
+ * bounded below by -1 / (||d|| min(eta, ||g_old||)).  For more information,
+ * see the following paper:
+ *
+ * @code
+ * @article{Hager2005,
+ *   author  = {Hager, William W. and Zhang, Hongchao},
+ *   title   = {A New Conjugate Gradient Method with Guaranteed Descent and an
+ *              Efficient Line Search},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {16},
+ *   number  = {1},
+ *   pages   = {170--192},
+ *   year    = {2005}
+ * }
+ * @endcode
+ */
+class HagerZhang
+{
+ public:
+  /**
+   * Create the Hager-Zhang update rule.
+   *
+   * @param eta Parameter of the lower bound of beta.
+   */
+  HagerZhang(const double eta = 0.01) : eta(eta) { }
+
+  //! Return beta, computed in one pass over the gradients and the direction.
+  double Beta(const arma::mat& gradient,
+              const arma::mat& oldGradient,
+              const arma::mat& direction) const
+  {
+    double dy = 0.0, yy = 0.0, yg = 0.0, dg = 0.0, dd = 0.0, oldNorm = 0.0;
+    for (size_t i = 0; i < gradient.n_elem; ++i)
+    {
+      const double yi = gradient[i] - oldGradient[i];
+      dy += direction[i] * yi;
+      yy += yi * yi;
+      yg += yi * gradient[i];
+      dg += direction[i] * gradient[i];
+      dd += direction[i] * direction[i];
+      oldNorm += oldGradient[i] * oldGradient[i];
+    }
+
+    // Without curvature along the direction, start over.
+    if (dy == 0.0 || dd == 0.0)
+      return 0.0;
+
+    const double beta = (yg - 2.0 * yy * dg / dy) / dy;
+    const double lowerBound = -1.0 / (std::sqrt(dd) *
+        std::min(eta, std::sqrt(oldNorm)));
+    return std::max(beta, lowerBound);
+  }
+
+  //! Get the parameter of the lower bound of beta.
+  double Eta() const { return eta; }
+  //! Modify the parameter of the lower bound of beta.
+  double& Eta() { return eta; }
+
+ private:
+  //! The parameter of the lower bound of beta.
+  double eta;
+};
+
+} // namespace ens
+
+#endif // ENSMALLEN_NONLINEAR_CG_UPDATE_RULES_HPP
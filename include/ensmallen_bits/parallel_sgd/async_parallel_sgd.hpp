@@ -0,0 +1,216 @@
+/**
+ * @file async_parallel_sgd.hpp
+ * @author Marcus Edel
+ *
+ * Asynchronous parallel SGD on several processes, which share their parameters
+ * through a parameter server.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_ASYNC_PARALLEL_SGD_HPP
+#define ENSMALLEN_PARALLEL_SGD_ASYNC_PARALLEL_SGD_HPP
+
+#include <vector>
+
+#include "decay_policies/constant_step.hpp"
+#include "decay_policies/exponential_backoff.hpp"
+#include "parameter_servers/parameter_servers.hpp"
+
+namespace ens {
+
+/**
+ * Asynchronous parallel SGD extends the lock-free HOGWILD! scheme of
+ * ParallelSGD from the threads of one machine to the workers of a parameter
+ * server (e.g. MPI processes).  Each worker optimizes its own part of the data,
+ * as a sparse separable function, without global barriers: it computes the
+ * sparse gradient of a batch on its local copy of the parameters, pushes the
+ * update of the non-zero coordinates to the server, and pulls back the new
+ * values of those coordinates, which include the updates of the other
+ * workers.  The whole parameters can also be pulled every pullInterval steps.
+ *
+ * The staleness is bounded: a worker waits whenever it is more than
+ * maxStaleness steps ahead of the slowest worker (the stale synchronous
+ * parallel model), so that the updates it computes are never based on
+ * parameters that miss too many steps of the others.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Ho2013,
+ *   title     = {More Effective Distributed {ML} via a Stale Synchronous
+ *                Parallel Parameter Server},
+ *   author    = {Ho, Qirong and Cipar, James and Cui, Henggang and Lee,
+ *                Seunghak and Kim, Jin Kyu and Gibbons, Phillip B. and Gibson,
+ *                Garth A. and Ganger, Greg and Xing, Eric P.},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {1223--1231},
+ *   year      = {2013}
+ * }
+ * @endcode
+ *
+ * The tolerance is checked by each worker on the objective of its own data,
+ * accumulated over one pass, and each worker stops on its own; the parameters
+ * of all the workers are gathered at the end.  AsyncParallelSGD can optimize
+ * sparse differentiable separable functions; a dense GradType can be given for
+ * functions that only provide a dense Gradient().
+ *
+ * @tparam DecayPolicyType Step size update policy used to update the step size
+ *     after each step.
+ * @tparam ParameterServerType Parameter server of the workers (see
+ *     LocalParameterServer; MPIParameterServer is available if ENS_USE_MPI is
+ *     defined).
+ */
+template<typename DecayPolicyType = ConstantStep,
+         typename ParameterServerType = LocalParameterServer>
+class AsyncParallelSGD
+{
+ public:
+  /**
+   * Construct the asynchronous parallel SGD optimizer with the given
+   * parameters.  One iteration means one batch processed by a worker.
+   *
+   * @param maxIterations Maximum number of iterations of each worker (0 means
+   *     no limit).
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param shuffle If true, the local function order is shuffled; otherwise,
+   *     each function is visited in linear order.
+   * @param decayPolicy The step size update policy to use.
+   * @param batchSize Number of datapoints in each gradient evaluation.
+   * @param maxStaleness Maximum number of steps a worker may be ahead of the
+   *     slowest one.
+   * @param pullInterval Number of steps between two pulls of all the
+   *     parameters (0 means only the updated coordinates are pulled).
+   * @param parameterServer Parameter server of the workers.
+   */
+  AsyncParallelSGD(const size_t maxIterations = 100000,
+                   const double tolerance = 1e-5,
+                   const bool shuffle = true,
+                   const DecayPolicyType& decayPolicy = DecayPolicyType(),
+                   const size_t batchSize = 1,
+                   const size_t maxStaleness = 4,
+                   const size_t pullInterval = 0,
+                   const ParameterServerType& parameterServer =
+                       ParameterServerType());
+
+  /**
+   * Optimize the given local function with asynchronous parallel SGD.  The
+   * given starting point is replaced by that of the first worker, then
+   * modified to store the final parameters (the same on all workers), and the
+   * objective of the local function at the final point is returned.
+   *
+   * @tparam SparseFunctionType Type of the local function.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param function Local function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the local function at the final point.
+   */
+  template<typename SparseFunctionType,
+           typename MatType,
+           typename GradType = arma::SpMat<typename MatType::elem_type>>
+  typename MatType::elem_type Optimize(SparseFunctionType& function,
+                                       MatType& iterate);
+
+  //! Get the maximum number of iterations (0 indicates no limits).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limits).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the number of datapoints in each gradient evaluation.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of datapoints in each gradient evaluation.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of steps a worker may be ahead of the slowest.
+  size_t MaxStaleness() const { return maxStaleness; }
+  //! Modify the maximum number of steps a worker may be ahead of the slowest.
+  size_t& MaxStaleness() { return maxStaleness; }
+
+  //! Get the number of steps between two pulls of all the parameters.
+  size_t PullInterval() const { return pullInterval; }
+  //! Modify the number of steps between two pulls of all the parameters.
+  size_t& PullInterval() { return pullInterval; }
+
+  //! Get the parameter server.
+  const ParameterServerType& ParameterServer() const { return parameterServer; }
+  //! Modify the parameter server.
+  ParameterServerType& ParameterServer() { return parameterServer; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Push the update of the non-zero coordinates of the sparse gradient, and
+   * pull back their new values.  The given buffers are reused between steps.
+   */
+  template<typename MatType, typename eT>
+  void PushPull(MatType& iterate,
+                const double stepSize,
+                const arma::SpMat<eT>& gradient,
+                std::vector<size_t>& indices,
+                std::vector<typename MatType::elem_type>& updates);
+
+  /**
+   * Push the update of the dense gradient, and pull back all the parameters.
+   */
+  template<typename MatType, typename DenseGradType>
+  void PushPull(MatType& iterate,
+                const double stepSize,
+                const DenseGradType& gradient,
+                std::vector<size_t>& indices,
+                std::vector<typename MatType::elem_type>& updates);
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The step size decay policy.
+  DecayPolicyType decayPolicy;
+
+  //! The number of datapoints in each gradient evaluation.
+  size_t batchSize;
+
+  //! The maximum number of steps a worker may be ahead of the slowest one.
+  size_t maxStaleness;
+
+  //! The number of steps between two pulls of all the parameters.
+  size_t pullInterval;
+
+  //! The parameter server of the workers.
+  ParameterServerType parameterServer;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "async_parallel_sgd_impl.hpp"
+
+#endif
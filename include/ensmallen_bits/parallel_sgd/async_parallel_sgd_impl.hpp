@@ -0,0 +1,186 @@
+/**
+ * @file async_parallel_sgd_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of asynchronous parallel SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_ASYNC_PARALLEL_SGD_IMPL_HPP
+#define ENSMALLEN_PARALLEL_SGD_ASYNC_PARALLEL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "async_parallel_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename DecayPolicyType, typename ParameterServerType>
+AsyncParallelSGD<DecayPolicyType, ParameterServerType>::AsyncParallelSGD(
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const DecayPolicyType& decayPolicy,
+    const size_t batchSize,
+    const size_t maxStaleness,
+    const size_t pullInterval,
+    const ParameterServerType& parameterServer) :
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    decayPolicy(decayPolicy),
+    batchSize(batchSize),
+    maxStaleness(maxStaleness),
+    pullInterval(pullInterval),
+    parameterServer(parameterServer)
+{ /* Nothing to do. */ }
+
+template<typename DecayPolicyType, typename ParameterServerType>
+template<typename SparseFunctionType, typename MatType, typename GradType>
+typename MatType::elem_type AsyncParallelSGD<DecayPolicyType,
+    ParameterServerType>::Optimize(SparseFunctionType& function,
+                                   MatType& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  typedef typename MatType::elem_type ElemType;
+
+  // Check that we have all the functions that we need.
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType, MatType, GradType>();
+
+  // Use the Function<> wrapper so that EvaluateWithGradient() is available.
+  typedef Function<SparseFunctionType, MatType, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // All the workers start from the parameters of the first one.
+  parameterServer.Initialize(iterate.memptr(), iterate.n_elem);
+
+  // The local functions are visited in batches of batchSize consecutive
+  // functions; the last batch may be smaller.
+  const size_t numFunctions = f.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numBatches - 1), numBatches);
+
+  // The batches are shuffled with a random stream of this optimization.
+  RandomGenerator generator = NewRandomGenerator();
+
+  ElemType passObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+  size_t offset = 0;
+
+  GradType gradient;
+  std::vector<size_t> indices;
+  std::vector<ElemType> updates;
+  for (size_t i = 1; maxIterations == 0 || i <= maxIterations; ++i)
+  {
+    // Check for convergence at the end of every pass over the local data.  The
+    // worker must not return before it leaves the server, or the others would
+    // wait for it forever.
+    if (offset == 0 && i > 1)
+    {
+      ENS_INFO << "AsyncParallelSGD: iteration " << i << ", local objective "
+          << passObjective << "." << std::endl;
+
+      if (std::isnan(passObjective) || std::isinf(passObjective))
+      {
+        ENS_WARN << "AsyncParallelSGD: converged to " << passObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        break;
+      }
+
+      if (std::abs(lastObjective - passObjective) < tolerance)
+      {
+        ENS_INFO << "AsyncParallelSGD: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        break;
+      }
+
+      lastObjective = passObjective;
+      passObjective = 0;
+    }
+
+    // Shuffle for uniform sampling of functions, once at the start of every
+    // pass over the data.
+    if (shuffle && offset == 0)
+      generator.Shuffle(visitationOrder);
+
+    const size_t begin = visitationOrder[offset] * batchSize;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - begin);
+    passObjective += f.EvaluateWithGradient(iterate, begin, gradient,
+        effectiveBatchSize);
+
+    PushPull(iterate, decayPolicy.StepSize(i), gradient, indices, updates);
+    if (pullInterval > 0 && (i % pullInterval) == 0)
+      parameterServer.Pull(iterate.memptr(), iterate.n_elem);
+
+    // Wait for the slowest worker, if it is too far behind.
+    parameterServer.Synchronize(i, maxStaleness);
+
+    if (++offset == numBatches)
+      offset = 0;
+  }
+
+  // Gather the final parameters once every worker is done.
+  parameterServer.Leave();
+  parameterServer.Finish(iterate.memptr(), iterate.n_elem);
+
+  const ElemType objective = f.Evaluate(iterate);
+  ENS_INFO << "AsyncParallelSGD: terminated with local objective " << objective
+      << "." << std::endl;
+  return objective;
+}
+
+template<typename DecayPolicyType, typename ParameterServerType>
+template<typename MatType, typename eT>
+void AsyncParallelSGD<DecayPolicyType, ParameterServerType>::PushPull(
+    MatType& iterate,
+    const double stepSize,
+    const arma::SpMat<eT>& gradient,
+    std::vector<size_t>& indices,
+    std::vector<typename MatType::elem_type>& updates)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Iterate over the non-zero elements.
+  indices.clear();
+  updates.clear();
+  typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+  for (; cur != gradient.end(); ++cur)
+  {
+    indices.push_back(cur.row() + cur.col() * iterate.n_rows);
+    updates.push_back(-ElemType(stepSize * (*cur)));
+  }
+
+  parameterServer.Push(indices.data(), updates.data(), indices.size());
+  parameterServer.Pull(iterate.memptr(), indices.data(), indices.size());
+}
+
+template<typename DecayPolicyType, typename ParameterServerType>
+template<typename MatType, typename DenseGradType>
+void AsyncParallelSGD<DecayPolicyType, ParameterServerType>::PushPull(
+    MatType& iterate,
+    const double stepSize,
+    const DenseGradType& gradient,
+    std::vector<size_t>& /* indices */,
+    std::vector<typename MatType::elem_type>& updates)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  updates.resize(gradient.n_elem);
+  for (size_t k = 0; k < gradient.n_elem; ++k)
+    updates[k] = -ElemType(stepSize * gradient[k]);
+
+  parameterServer.Push(updates.data(), updates.size());
+  parameterServer.Pull(iterate.memptr(), iterate.n_elem);
+}
+
+} // namespace ens
+
+#endif
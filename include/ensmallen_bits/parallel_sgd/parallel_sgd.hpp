@@ -14,6 +14,10 @@
 
 #include "decay_policies/constant_step.hpp"
 #include "decay_policies/exponential_backoff.hpp"
+#include "update_policies/sparse_vanilla_update.hpp"
+#include "update_policies/sparse_adagrad_update.hpp"
+#include "update_policies/sparse_adam_update.hpp"
+#include <ensmallen_bits/executors/executors.hpp>
 
 namespace ens {
 
@@ -35,17 +39,33 @@ namespace ens {
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
  *
+ * The step of each coordinate is given by UpdatePolicyType, one coordinate at
+ * a time: SparseVanillaUpdate takes plain gradient steps, and
+ * SparseAdaGradUpdate and SparseAdamUpdate adapt the step of each coordinate,
+ * which converges much faster on sparse data whose features have very
+ * different frequencies.  The state of a coordinate is only touched when its
+ * gradient is non-zero, and is updated lock-free like the iterate.
+ *
  * @tparam DecayPolicyType Step size update policy used by parallel SGD
  *     to update the stepsize after each iteration.
+ * @tparam ExecutorType Executor that runs the threads (see SerialExecutor,
+ *     OpenMPExecutor, and ThreadPoolExecutor).
+ * @tparam UpdatePolicyType Per-coordinate update policy (see
+ *     SparseVanillaUpdate for the interface).
  */
-template <typename DecayPolicyType = ConstantStep>
+template <typename DecayPolicyType = ConstantStep,
+          typename ExecutorType = OpenMPExecutor,
+          typename UpdatePolicyType = SparseVanillaUpdate>
 class ParallelSGD
 {
  public:
   /**
    * Construct the parallel SGD optimizer to optimize the given function with
-   * the given parameters. One iteration means one batch of datapoints processed
-   * by each thread.
+   * the given parameters. One iteration means one share of datapoints
+   * processed by each thread.  Successive iterations continue where the last
+   * one stopped, so every datapoint is visited once per pass over the data
+   * even if threadShareSize times the number of threads is smaller than the
+   * number of functions.
    *
    * The defaults here are not necessarily good for the given problem, so it is
    * suggested that the values used be tailored to the task at hand.
@@ -53,31 +73,64 @@ class ParallelSGD
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param threadShareSize Number of datapoints to be processed in one
-   *     iteration by each thread.
+   *     iteration by each thread (0 means the whole dataset is split evenly
+   *     between the threads in every iteration).
    * @param tolerance Maximum absolute tolerance to terminate the algorithm.
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
    * @param decayPolicy The step size update policy to use.
+   * @param batchSize Number of datapoints in each gradient evaluation of a
+   *     thread.
+   * @param atomicUpdate If true, each coordinate of the iterate is updated
+   *     atomically; otherwise threads write to the iterate without any
+   *     synchronization, as in the original HOGWILD! scheme.
+   * @param accumulateObjective If true, the objective used to check for
+   *     convergence is accumulated from the batches visited during each pass
+   *     over the data, instead of evaluating the full objective at every
+   *     iteration.
+   * @param executor The executor that runs the threads; each thread of an
+   *     iteration is one task of the executor.
+   * @param numaLocality If true, each thread always visits the same
+   *     contiguous part of the batches (shuffled within that part), and the
+   *     iterate is spread over the NUMA nodes of the threads; see
+   *     FirstTouchPlace().
+   * @param weightDecay Strength of an L2 penalty applied as weight decay; the
+   *     decay of each coordinate is only applied when it has a non-zero
+   *     gradient (0 means no penalty).
+   * @param updatePolicy The per-coordinate update policy to use.
   */
   ParallelSGD(const size_t maxIterations,
               const size_t threadShareSize,
               const double tolerance = 1e-5,
               const bool shuffle = true,
-              const DecayPolicyType& decayPolicy = DecayPolicyType());
+              const DecayPolicyType& decayPolicy = DecayPolicyType(),
+              const size_t batchSize = 1,
+              const bool atomicUpdate = true,
+              const bool accumulateObjective = false,
+              const ExecutorType& executor = ExecutorType(),
+              const bool numaLocality = false,
+              const double weightDecay = 0.0,
+              const UpdatePolicyType& updatePolicy = UpdatePolicyType());
 
   /**
    * Optimize the given function using the parallel SGD algorithm. The given
    * starting point will be modified to store the finishing point of the
    * algorithm, and the value of the loss function at the final point is
-   * returned.
+   * returned.  By default the gradient is sparse; a dense GradType can be
+   * specified explicitly for functions that only provide a dense Gradient().
    *
    * @tparam SparseFunctionType Type of function to be optimized.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam GradType Type of matrix to use to represent function gradients.
    * @param function Function to be optimized(minimized).
    * @param iterate Starting point(will be modified).
    * @return Objective value at the final point.
    */
-  template <typename SparseFunctionType>
-  double Optimize(SparseFunctionType& function, arma::mat& iterate);
+  template<typename SparseFunctionType,
+           typename MatType,
+           typename GradType = arma::SpMat<typename MatType::elem_type>>
+  typename MatType::elem_type Optimize(SparseFunctionType& function,
+                                       MatType& iterate);
 
   //! Get the maximum number of iterations (0 indicates no limits).
   size_t MaxIterations() const { return maxIterations; }
@@ -106,7 +159,103 @@ class ParallelSGD
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get the number of datapoints in each gradient evaluation.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of datapoints in each gradient evaluation.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get whether or not the iterate is updated atomically.
+  bool AtomicUpdate() const { return atomicUpdate; }
+  //! Modify whether or not the iterate is updated atomically.
+  bool& AtomicUpdate() { return atomicUpdate; }
+
+  //! Get whether or not the objective is accumulated during each pass.
+  bool AccumulateObjective() const { return accumulateObjective; }
+  //! Modify whether or not the objective is accumulated during each pass.
+  bool& AccumulateObjective() { return accumulateObjective; }
+
+  //! Get whether or not each thread keeps to its own part of the data.
+  bool NUMALocality() const { return numaLocality; }
+  //! Modify whether or not each thread keeps to its own part of the data.
+  bool& NUMALocality() { return numaLocality; }
+
+  //! Get the strength of the L2 penalty applied as weight decay.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the strength of the L2 penalty applied as weight decay.
+  double& WeightDecay() { return weightDecay; }
+
+  //! Get the per-coordinate update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the per-coordinate update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  /**
+   * Shuffle the batches of each share among the positions of that share in the
+   * visitation order, so that each share keeps the same batches.
+   */
+  void ShuffleShares(const std::vector<std::vector<size_t>>& sharePositions,
+                     arma::Col<size_t>& visitationOrder,
+                     RandomGenerator& generator) const;
+
+  /**
+   * Subtract the steps of the update policy for the sparse gradient of the
+   * given batch (from 1) from the iterate, touching only the non-zero
+   * coordinates.
+   */
+  template<typename MatType, typename eT>
+  void UpdateIterate(MatType& iterate,
+                     const double stepSize,
+                     const arma::SpMat<eT>& gradient,
+                     const size_t step);
+
+  /**
+   * Subtract the steps of the update policy for the dense gradient of the
+   * given batch (from 1) from the iterate.
+   */
+  template<typename MatType, typename DenseGradType>
+  void UpdateIterate(MatType& iterate,
+                     const double stepSize,
+                     const DenseGradType& gradient,
+                     const size_t step);
+
+  /**
+   * Apply the weight decay skipped by the non-zero coordinates of the sparse
+   * gradient since their last update, and set their clocks to the given one.
+   */
+  template<typename MatType, typename eT>
+  void DecayIterate(MatType& iterate,
+                    arma::mat& lastClock,
+                    const double clock,
+                    const arma::SpMat<eT>& gradient) const;
+
+  /**
+   * Apply the weight decay skipped by every coordinate; a dense gradient
+   * touches all of them.
+   */
+  template<typename MatType, typename DenseGradType>
+  void DecayIterate(MatType& iterate,
+                    arma::mat& lastClock,
+                    const double clock,
+                    const DenseGradType& gradient) const;
+
+  /**
+   * Apply the weight decay skipped by every coordinate, so that the whole
+   * iterate is up to date.
+   */
+  template<typename MatType>
+  void SynchronizeIterate(MatType& iterate,
+                          arma::mat& lastClock,
+                          const double clock) const;
+
   //! The maximum number of allowed iterations.
   size_t maxIterations;
 
@@ -122,6 +271,30 @@ class ParallelSGD
 
   //! The step size decay policy.
   DecayPolicyType decayPolicy;
+
+  //! The number of datapoints in each gradient evaluation.
+  size_t batchSize;
+
+  //! Controls whether or not the iterate is updated atomically.
+  bool atomicUpdate;
+
+  //! Controls whether or not the objective is accumulated during each pass.
+  bool accumulateObjective;
+
+  //! The executor that runs the threads.
+  ExecutorType executor;
+
+  //! Controls whether or not each thread keeps to its own part of the data.
+  bool numaLocality;
+
+  //! The strength of the L2 penalty applied as weight decay.
+  double weightDecay;
+
+  //! The per-coordinate update policy.
+  UpdatePolicyType updatePolicy;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
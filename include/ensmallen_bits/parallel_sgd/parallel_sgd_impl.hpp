@@ -19,116 +19,441 @@
 
 namespace ens {
 
-template <typename DecayPolicyType>
-ParallelSGD<DecayPolicyType>::ParallelSGD(
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::ParallelSGD(
     const size_t maxIterations,
     const size_t threadShareSize,
     const double tolerance,
     const bool shuffle,
-    const DecayPolicyType& decayPolicy) :
+    const DecayPolicyType& decayPolicy,
+    const size_t batchSize,
+    const bool atomicUpdate,
+    const bool accumulateObjective,
+    const ExecutorType& executor,
+    const bool numaLocality,
+    const double weightDecay,
+    const UpdatePolicyType& updatePolicy) :
     maxIterations(maxIterations),
     threadShareSize(threadShareSize),
     tolerance(tolerance),
     shuffle(shuffle),
-    decayPolicy(decayPolicy)
+    decayPolicy(decayPolicy),
+    batchSize(batchSize),
+    atomicUpdate(atomicUpdate),
+    accumulateObjective(accumulateObjective),
+    executor(executor),
+    numaLocality(numaLocality),
+    weightDecay(weightDecay),
+    updatePolicy(updatePolicy)
 { /* Nothing to do. */ }
 
-template <typename DecayPolicyType>
-template <typename SparseFunctionType>
-double ParallelSGD<DecayPolicyType>::Optimize(
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename SparseFunctionType, typename MatType, typename GradType>
+typename MatType::elem_type
+ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::Optimize(
     SparseFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  typedef typename MatType::elem_type ElemType;
+
   // Check that we have all the functions that we need.
-  traits::CheckSparseFunctionTypeAPI<SparseFunctionType>();
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType, MatType, GradType>();
+
+  // Use the Function<> wrapper so that EvaluateWithGradient() is available.
+  typedef Function<SparseFunctionType, MatType, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Weight decay and the adaptive update policies keep dense state for every
+  // coordinate, which a hashed iterate is meant to avoid.
+  if (IsHashedParameters<MatType>::value && (weightDecay > 0.0 ||
+      !std::is_same<UpdatePolicyType, SparseVanillaUpdate>::value))
+  {
+    throw std::invalid_argument("ParallelSGD::Optimize(): a HashedParameters "
+        "iterate can only be used with SparseVanillaUpdate and without weight "
+        "decay!");
+  }
+
+  ElemType overallObjective = std::numeric_limits<ElemType>::max();
+  ElemType lastObjective;
 
-  double overallObjective = DBL_MAX;
-  double lastObjective;
+  // When accumulating the objective, this holds the sum of the objectives of
+  // the batches visited so far in the current pass over the data.
+  ElemType passObjective = 0;
+  bool passComplete = false;
 
-  // The order in which the functions will be visited.
+  // The functions are visited in batches of batchSize consecutive functions;
+  // the last batch may be smaller.
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  // The order in which the batches will be visited.
   arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
-      (function.NumFunctions() - 1), function.NumFunctions());
+      (numBatches - 1), numBatches);
+
+  // The batches are shuffled with a random stream of this optimization.
+  RandomGenerator generator = NewRandomGenerator();
+
+  const size_t maxThreads = std::max(executor.Threads(), (size_t) 1);
+
+  // Number of batches processed by each thread in one iteration.  If no share
+  // size is given, the whole dataset is split evenly between the threads.
+  size_t threadBatches = (threadShareSize == 0) ?
+      (numBatches + maxThreads - 1) / maxThreads :
+      (threadShareSize + batchSize - 1) / batchSize;
+  threadBatches = std::max(threadBatches, (size_t) 1);
+  const size_t iterationBatches = std::min(numBatches,
+      threadBatches * maxThreads);
+
+  // Position in visitationOrder of the next batch to process.
+  size_t offset = 0;
+
+  // The share of an iteration that processes the batch at position p of
+  // visitationOrder is (p / threadBatches) % maxThreads, in every iteration.
+  // For NUMA locality, the positions of each share are given a contiguous part
+  // of the batches, which is only shuffled within the share; then the thread of
+  // a share always reads the same part of the data.
+  std::vector<std::vector<size_t>> sharePositions;
+  if (numaLocality)
+  {
+    sharePositions.resize(std::min(maxThreads, numBatches));
+    for (size_t p = 0; p < numBatches; ++p)
+      sharePositions[(p / threadBatches) % maxThreads].push_back(p);
+
+    size_t batch = 0;
+    for (size_t s = 0; s < sharePositions.size(); ++s)
+      for (size_t k = 0; k < sharePositions[s].size(); ++k)
+        visitationOrder[sharePositions[s][k]] = batch++;
+
+    // The iterate is updated by all the threads, so its pages are spread over
+    // their nodes.
+    FirstTouchPlace(iterate);
+
+    #if defined(ENS_USE_OPENMP) && (_OPENMP >= 201307)
+      if (omp_get_proc_bind() == omp_proc_bind_false)
+      {
+        ENS_WARN << "ParallelSGD: the threads are not bound to their cores, so "
+            << "they may leave the NUMA node of their data; set OMP_PROC_BIND."
+            << std::endl;
+      }
+    #endif
+  }
+
+  // With weight decay, each coordinate holds the clock of its last update; the
+  // clock advances by log(1 - stepSize * weightDecay) for every batch, so that
+  // the decay skipped by a coordinate is exp(clock - lastClock).  The clocks
+  // are kept in double precision since they only grow in magnitude.
+  arma::mat lastClock;
+  double clock = 0.0;
+  if (weightDecay > 0.0)
+    lastClock.zeros(iterate.n_rows, iterate.n_cols);
+
+  // The state of the update policy starts over, and the batches are counted
+  // from 1 over the whole optimization.
+  updatePolicy.Initialize(iterate.n_elem);
+  size_t steps = 0;
 
   // Iterate till the objective is within tolerance or the maximum number of
   // allowed iterations is reached. If maxIterations is 0, this will iterate
   // till convergence.
   for (size_t i = 1; i != maxIterations; ++i)
   {
-    // Calculate the overall objective.
-    lastObjective = overallObjective;
+    // Check for convergence, either at every iteration using the full
+    // objective, or after every complete pass using the accumulated objective.
+    if (!accumulateObjective || passComplete)
+    {
+      // Calculate the overall objective.
+      lastObjective = overallObjective;
 
-    overallObjective = function.Evaluate(iterate);
+      if (weightDecay > 0.0)
+        SynchronizeIterate(iterate, lastClock, clock);
 
-    // Output current objective function.
-    Info << "Parallel SGD: iteration " << i << ", objective "
-      << overallObjective << "." << std::endl;
+      overallObjective = accumulateObjective ? passObjective :
+          f.Evaluate(iterate);
+      passObjective = 0;
+      passComplete = false;
 
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
-    {
-      Warn << "Parallel SGD: converged to " << overallObjective
-        << "; terminating with failure. Try a smaller step size?"
-        << std::endl;
-      return overallObjective;
-    }
+      // Output current objective function.
+      ENS_INFO << "Parallel SGD: iteration " << i << ", objective "
+        << overallObjective << "." << std::endl;
 
-    if (std::abs(lastObjective - overallObjective) < tolerance)
-    {
-      Info << "SGD: minimized within tolerance " << tolerance << "; "
-        << "terminating optimization." << std::endl;
-      return overallObjective;
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "Parallel SGD: converged to " << overallObjective
+          << "; terminating with failure. Try a smaller step size?"
+          << std::endl;
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "SGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+
+        // The accumulated objective was computed at changing iterates.
+        if (accumulateObjective)
+          overallObjective = f.Evaluate(iterate);
+
+        return overallObjective;
+      }
     }
 
     // Get the stepsize for this iteration
     double stepSize = decayPolicy.StepSize(i);
 
-    // Shuffle for uniform sampling of functions by each thread.
-    if (shuffle)
+    double logDecay = 0.0;
+    if (weightDecay > 0.0)
+    {
+      if (stepSize * weightDecay >= 1.0)
+      {
+        std::ostringstream oss;
+        oss << "ParallelSGD::Optimize(): the step size times the weight decay "
+            << "is " << stepSize * weightDecay << ", but must be less than 1!";
+        throw std::invalid_argument(oss.str());
+      }
+
+      logDecay = std::log(1.0 - stepSize * weightDecay);
+    }
+
+    // Shuffle for uniform sampling of functions by each thread, once at the
+    // start of every pass over the data.
+    if (shuffle && offset == 0)
     {
       // Determine order of visitation.
-      visitationOrder = arma::shuffle(visitationOrder);
+      if (numaLocality)
+        ShuffleShares(sharePositions, visitationOrder, generator);
+      else
+        generator.Shuffle(visitationOrder);
     }
 
-    ENS_PRAGMA_OMP_PARALLEL
+    // Don't go past the end of the current pass.
+    const size_t currentBatches = std::min(iterationBatches,
+        numBatches - offset);
+    const size_t numShares = (currentBatches + threadBatches - 1) /
+        threadBatches;
+
+    // The objective of each share, summed in order after the sweep so that
+    // the result does not depend on thread scheduling.
+    std::vector<ElemType> shareObjectives(accumulateObjective ? numShares : 0);
+
+    // Each share of threadBatches batches is one task of the executor.
+    executor.Run(numShares, [&](const size_t share)
     {
-      // Each processor gets a subset of the instances.
-      // Each subset is of size threadShareSize
-      size_t threadId = 0;
-      #ifdef ENS_USE_OPENMP
-        threadId = omp_get_thread_num();
-      #endif
-
-      for (size_t j = threadId * threadShareSize;
-          j < (threadId + 1) * threadShareSize && j < visitationOrder.n_elem;
-          ++j)
+      // Each instance affects only some components of the decision variable,
+      // so the gradient is usually sparse.  The buffer is reused for every
+      // batch of the share.
+      GradType gradient;
+
+      const size_t shareEnd = std::min((share + 1) * threadBatches,
+          currentBatches);
+      ElemType shareObjective = 0;
+      for (size_t j = share * threadBatches; j < shareEnd; ++j)
       {
-        // Each instance affects only some components of the decision variable.
-        // So the gradient is sparse.
-        arma::sp_mat gradient;
+        const size_t begin = visitationOrder[offset + j] * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
 
-        // Evaluate the sparse gradient.
-        function.Gradient(iterate, visitationOrder[j], gradient, 1);
+        // Evaluate the gradient and update the decision variable.
+        if (accumulateObjective)
+        {
+          shareObjective += f.EvaluateWithGradient(iterate, begin, gradient,
+              effectiveBatchSize);
+        }
+        else
+        {
+          f.Gradient(iterate, begin, gradient, effectiveBatchSize);
+        }
 
-        // Update the decision variable with non-zero components of the
-        // gradient.
-        for (size_t i = 0; i < gradient.n_cols; ++i)
+        // The batch at position j of the iteration is its (j + 1)-th step.
+        if (weightDecay > 0.0)
         {
-          // Iterate over the non-zero elements.
-          for (arma::sp_mat::iterator cur = gradient.begin_col(i);
-              cur != gradient.end_col(i); ++cur)
-          {
-            ENS_PRAGMA_OMP_ATOMIC
-            iterate(cur.row(), i) -= stepSize * (*cur);
-          }
+          DecayIterate(iterate, lastClock, clock + (j + 1) * logDecay,
+              gradient);
         }
+        UpdateIterate(iterate, stepSize, gradient, steps + j + 1);
       }
+
+      if (accumulateObjective)
+        shareObjectives[share] = shareObjective;
+    });
+
+    for (size_t share = 0; share < shareObjectives.size(); ++share)
+      passObjective += shareObjectives[share];
+
+    clock += currentBatches * logDecay;
+    steps += currentBatches;
+
+    offset += currentBatches;
+    if (offset == numBatches)
+    {
+      offset = 0;
+      passComplete = true;
     }
   }
 
-  Info << "\n Parallel SGD terminated with objective : "
+  if (weightDecay > 0.0)
+    SynchronizeIterate(iterate, lastClock, clock);
+
+  // The accumulated objective was computed at changing iterates.
+  if (accumulateObjective)
+    overallObjective = f.Evaluate(iterate);
+
+  ENS_INFO << "\n Parallel SGD terminated with objective : "
     << overallObjective << std::endl;
   return overallObjective;
 }
 
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::ShuffleShares(
+    const std::vector<std::vector<size_t>>& sharePositions,
+    arma::Col<size_t>& visitationOrder,
+    RandomGenerator& generator) const
+{
+  arma::Col<size_t> batches;
+  for (size_t s = 0; s < sharePositions.size(); ++s)
+  {
+    const std::vector<size_t>& positions = sharePositions[s];
+    batches.set_size(positions.size());
+    for (size_t k = 0; k < positions.size(); ++k)
+      batches[k] = visitationOrder[positions[k]];
+
+    generator.Shuffle(batches);
+    for (size_t k = 0; k < positions.size(); ++k)
+      visitationOrder[positions[k]] = batches[k];
+  }
+}
+
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename MatType, typename eT>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::UpdateIterate(
+    MatType& iterate,
+    const double stepSize,
+    const arma::SpMat<eT>& gradient,
+    const size_t step)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Iterate over the non-zero elements; the update policy only touches their
+  // state.
+  typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+  if (atomicUpdate)
+  {
+    for (; cur != gradient.end(); ++cur)
+    {
+      const size_t k = cur.row() + cur.col() * iterate.n_rows;
+      const ElemType update = ElemType(updatePolicy.Step(k, stepSize, *cur,
+          step));
+      ENS_PRAGMA_OMP_ATOMIC
+      iterate[k] -= update;
+    }
+  }
+  else
+  {
+    for (; cur != gradient.end(); ++cur)
+    {
+      const size_t k = cur.row() + cur.col() * iterate.n_rows;
+      iterate[k] -= ElemType(updatePolicy.Step(k, stepSize, *cur, step));
+    }
+  }
+}
+
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename MatType, typename DenseGradType>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::UpdateIterate(
+    MatType& iterate,
+    const double stepSize,
+    const DenseGradType& gradient,
+    const size_t step)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (atomicUpdate)
+  {
+    for (size_t k = 0; k < gradient.n_elem; ++k)
+    {
+      const ElemType update = ElemType(updatePolicy.Step(k, stepSize,
+          gradient[k], step));
+      ENS_PRAGMA_OMP_ATOMIC
+      iterate[k] -= update;
+    }
+  }
+  else if (std::is_same<UpdatePolicyType, SparseVanillaUpdate>::value)
+  {
+    iterate -= ElemType(stepSize) * gradient;
+  }
+  else
+  {
+    // Every coordinate of a dense gradient goes through the policy, even with
+    // a zero gradient.
+    for (size_t k = 0; k < gradient.n_elem; ++k)
+      iterate[k] -= ElemType(updatePolicy.Step(k, stepSize, gradient[k], step));
+  }
+}
+
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename MatType, typename eT>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::DecayIterate(
+    MatType& iterate,
+    arma::mat& lastClock,
+    const double clock,
+    const arma::SpMat<eT>& gradient) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The clocks are updated without synchronization, as the iterate is.
+  typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+  for (; cur != gradient.end(); ++cur)
+  {
+    const size_t k = cur.row() + cur.col() * iterate.n_rows;
+    iterate[k] *= ElemType(std::exp(clock - lastClock[k]));
+    lastClock[k] = clock;
+  }
+}
+
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename MatType, typename DenseGradType>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::DecayIterate(
+    MatType& iterate,
+    arma::mat& lastClock,
+    const double clock,
+    const DenseGradType& /* gradient */) const
+{
+  SynchronizeIterate(iterate, lastClock, clock);
+}
+
+template <typename DecayPolicyType,
+          typename ExecutorType,
+          typename UpdatePolicyType>
+template <typename MatType>
+void ParallelSGD<DecayPolicyType, ExecutorType, UpdatePolicyType>::SynchronizeIterate(
+    MatType& iterate,
+    arma::mat& lastClock,
+    const double clock) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  for (size_t k = 0; k < iterate.n_elem; ++k)
+  {
+    iterate[k] *= ElemType(std::exp(clock - lastClock[k]));
+    lastClock[k] = clock;
+  }
+}
+
 } // namespace ens
 
 #endif
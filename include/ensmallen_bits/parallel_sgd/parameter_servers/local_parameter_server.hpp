@@ -0,0 +1,133 @@
+/**
+ * @file local_parameter_server.hpp
+ * @author Marcus Edel
+ *
+ * Parameter server of a single worker, whose coordinates are the parameters.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_LOCAL_PARAMETER_SERVER_HPP
+#define ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_LOCAL_PARAMETER_SERVER_HPP
+
+namespace ens {
+
+/**
+ * The parameter server of a single worker: the coordinates of the worker are
+ * the parameters, so that a push updates them in place and a pull has nothing
+ * to do.  This is the default parameter server of AsyncParallelSGD, which then
+ * behaves like sequential SGD with sparse updates.
+ *
+ * A parameter server holds the parameters of the workers of AsyncParallelSGD,
+ * possibly split in shards over several machines, and must implement the
+ * following methods.  Only Initialize() and Finish() are collective; the
+ * others are called by each worker at its own pace.
+ *
+ * @code
+ * // The number of workers, and the index of this worker in [0, Workers()).
+ * size_t Workers();
+ * size_t Rank();
+ *
+ * // Replace the given coordinates with those of the first worker, and make
+ * // them the parameters of the server.
+ * template<typename ElemType>
+ * void Initialize(ElemType* coordinates, const size_t n);
+ *
+ * // Copy all the parameters, or those of the given indices, to the
+ * // coordinates of this worker.
+ * template<typename ElemType>
+ * void Pull(ElemType* coordinates, const size_t n);
+ * template<typename ElemType>
+ * void Pull(ElemType* coordinates, const size_t* indices, const size_t k);
+ *
+ * // Add the given updates to all the parameters, or to those of the given
+ * // indices; each element is added atomically.
+ * template<typename ElemType>
+ * void Push(const ElemType* updates, const size_t n);
+ * template<typename ElemType>
+ * void Push(const size_t* indices, const ElemType* updates, const size_t k);
+ *
+ * // Publish the clock (the number of steps) of this worker, and wait until no
+ * // other worker is more than maxStaleness steps behind.
+ * void Synchronize(const size_t clock, const size_t maxStaleness);
+ *
+ * // Stop to take part in the staleness control.
+ * void Leave();
+ *
+ * // Wait for all the workers, and copy the final parameters to the given
+ * // coordinates.
+ * template<typename ElemType>
+ * void Finish(ElemType* coordinates, const size_t n);
+ * @endcode
+ */
+class LocalParameterServer
+{
+ public:
+  //! Create the server.
+  LocalParameterServer() : parameters(NULL) { }
+
+  //! Get the number of workers.
+  size_t Workers() const { return 1; }
+
+  //! Get the index of this worker.
+  size_t Rank() const { return 0; }
+
+  //! Make the given coordinates the parameters.
+  template<typename ElemType>
+  void Initialize(ElemType* coordinates, const size_t /* n */)
+  {
+    parameters = coordinates;
+  }
+
+  //! Copy the parameters to the coordinates (nothing to do).
+  template<typename ElemType>
+  void Pull(ElemType* /* coordinates */, const size_t /* n */) { }
+
+  //! Copy the given parameters to the coordinates (nothing to do).
+  template<typename ElemType>
+  void Pull(ElemType* /* coordinates */,
+            const size_t* /* indices */,
+            const size_t /* k */) { }
+
+  //! Add the given updates to the parameters.
+  template<typename ElemType>
+  void Push(const ElemType* updates, const size_t n)
+  {
+    ElemType* x = static_cast<ElemType*>(parameters);
+    for (size_t i = 0; i < n; ++i)
+      x[i] += updates[i];
+  }
+
+  //! Add the given updates to the parameters of the given indices.
+  template<typename ElemType>
+  void Push(const size_t* indices, const ElemType* updates, const size_t k)
+  {
+    ElemType* x = static_cast<ElemType*>(parameters);
+    for (size_t j = 0; j < k; ++j)
+      x[indices[j]] += updates[j];
+  }
+
+  //! Publish the clock of this worker (nothing to do).
+  void Synchronize(const size_t /* clock */, const size_t /* maxStaleness */)
+  { }
+
+  //! Stop to take part in the staleness control (nothing to do).
+  void Leave() { }
+
+  //! Forget the parameters; the coordinates already hold them.
+  template<typename ElemType>
+  void Finish(ElemType* /* coordinates */, const size_t /* n */)
+  {
+    parameters = NULL;
+  }
+
+ private:
+  //! The coordinates of the worker, which are the parameters.
+  void* parameters;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file mpi_parameter_server.hpp
+ * @author Marcus Edel
+ *
+ * Parameter server sharded over the processes of an MPI communicator, with
+ * one-sided communication.  Only available if ENS_USE_MPI is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_MPI_PARAMETER_SERVER_HPP
+#define ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_MPI_PARAMETER_SERVER_HPP
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <ensmallen_bits/communicators/mpi_communicator.hpp>
+
+namespace ens {
+
+/**
+ * The parameter server of the processes of an MPI communicator (by default
+ * MPI_COMM_WORLD): every process is a worker, and also holds one shard of the
+ * parameters, exposed in an MPI-3 window.  The workers pull and push with
+ * one-sided communication in a passive-target epoch, so that no worker ever
+ * waits for another one, except for the staleness control: pushes are atomic
+ * MPI_Accumulate() sums, and pulls are atomic MPI_Get_accumulate() reads.  The
+ * clocks of the workers live in a second window.
+ *
+ * Whether one-sided operations progress while the target computes depends on
+ * the MPI implementation (for instance, MPICH does so with
+ * MPICH_ASYNC_PROGRESS=1).  MPI must be initialized before the server is used,
+ * and finalized by the caller.
+ *
+ * @code
+ * MPI_Init(&argc, &argv);
+ * AsyncParallelSGD<ConstantStep, MPIParameterServer> optimizer(100000, 1e-5);
+ * optimizer.Optimize(localFunction, coordinates);
+ * MPI_Finalize();
+ * @endcode
+ */
+class MPIParameterServer
+{
+ public:
+  /**
+   * Create the parameter server of the processes of the given MPI
+   * communicator.
+   *
+   * @param comm The MPI communicator.
+   */
+  MPIParameterServer(MPI_Comm comm = MPI_COMM_WORLD) :
+      comm(comm),
+      window(MPI_WIN_NULL),
+      clockWindow(MPI_WIN_NULL),
+      shardSize(0)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of workers.
+  size_t Workers() const
+  {
+    int size;
+    MPI_Comm_size(comm, &size);
+    return size;
+  }
+
+  //! Get the index of this worker.
+  size_t Rank() const
+  {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    return rank;
+  }
+
+  /**
+   * Replace the given coordinates with those of the first worker, and copy
+   * the shard of this worker to its window.
+   */
+  template<typename ElemType>
+  void Initialize(ElemType* coordinates, const size_t n)
+  {
+    const size_t workers = Workers();
+    shardSize = std::max(size_t(1), (n + workers - 1) / workers);
+    MPI_Bcast(coordinates, n, detail::MPIType<ElemType>::Get(), 0, comm);
+
+    const size_t begin = std::min(n, Rank() * shardSize);
+    const size_t count = std::min(n, begin + shardSize) - begin;
+    ElemType* shard;
+    MPI_Win_allocate(count * sizeof(ElemType), sizeof(ElemType), MPI_INFO_NULL,
+        comm, &shard, &window);
+    std::copy(coordinates + begin, coordinates + begin + count, shard);
+
+    unsigned long long* clock;
+    MPI_Win_allocate(sizeof(unsigned long long), sizeof(unsigned long long),
+        MPI_INFO_NULL, comm, &clock, &clockWindow);
+    *clock = 0;
+
+    MPI_Barrier(comm);
+    MPI_Win_lock_all(0, window);
+    MPI_Win_lock_all(0, clockWindow);
+  }
+
+  //! Copy all the parameters to the coordinates.
+  template<typename ElemType>
+  void Pull(ElemType* coordinates, const size_t n)
+  {
+    const MPI_Datatype type = detail::MPIType<ElemType>::Get();
+    for (size_t begin = 0, q = 0; begin < n; begin += shardSize, ++q)
+    {
+      const size_t count = std::min(shardSize, n - begin);
+      MPI_Get_accumulate(NULL, 0, type, coordinates + begin, count, type, q, 0,
+          count, type, MPI_NO_OP, window);
+    }
+    MPI_Win_flush_all(window);
+  }
+
+  //! Copy the parameters of the given indices to the coordinates.
+  template<typename ElemType>
+  void Pull(ElemType* coordinates, const size_t* indices, const size_t k)
+  {
+    const MPI_Datatype type = detail::MPIType<ElemType>::Get();
+    for (size_t j = 0; j < k; ++j)
+    {
+      MPI_Get_accumulate(NULL, 0, type, coordinates + indices[j], 1, type,
+          indices[j] / shardSize, indices[j] % shardSize, 1, type, MPI_NO_OP,
+          window);
+    }
+    MPI_Win_flush_all(window);
+  }
+
+  //! Add the given updates to all the parameters.
+  template<typename ElemType>
+  void Push(const ElemType* updates, const size_t n)
+  {
+    const MPI_Datatype type = detail::MPIType<ElemType>::Get();
+    for (size_t begin = 0, q = 0; begin < n; begin += shardSize, ++q)
+    {
+      const size_t count = std::min(shardSize, n - begin);
+      MPI_Accumulate(updates + begin, count, type, q, 0, count, type, MPI_SUM,
+          window);
+    }
+    MPI_Win_flush_all(window);
+  }
+
+  //! Add the given updates to the parameters of the given indices.
+  template<typename ElemType>
+  void Push(const size_t* indices, const ElemType* updates, const size_t k)
+  {
+    const MPI_Datatype type = detail::MPIType<ElemType>::Get();
+    for (size_t j = 0; j < k; ++j)
+    {
+      MPI_Accumulate(updates + j, 1, type, indices[j] / shardSize,
+          indices[j] % shardSize, 1, type, MPI_SUM, window);
+    }
+    MPI_Win_flush_all(window);
+  }
+
+  /**
+   * Publish the clock of this worker, and wait until no other worker is more
+   * than maxStaleness steps behind (the stale synchronous parallel model).
+   */
+  void Synchronize(const size_t clock, const size_t maxStaleness)
+  {
+    Publish(clock);
+    if (clock <= maxStaleness)
+      return;
+
+    const size_t workers = Workers();
+    std::vector<unsigned long long> clocks(workers);
+    while (true)
+    {
+      for (size_t q = 0; q < workers; ++q)
+      {
+        MPI_Get_accumulate(NULL, 0, MPI_UNSIGNED_LONG_LONG, &clocks[q], 1,
+            MPI_UNSIGNED_LONG_LONG, q, 0, 1, MPI_UNSIGNED_LONG_LONG,
+            MPI_NO_OP, clockWindow);
+      }
+      MPI_Win_flush_all(clockWindow);
+
+      if (*std::min_element(clocks.begin(), clocks.end()) >=
+          clock - maxStaleness)
+        return;
+    }
+  }
+
+  //! Stop to take part in the staleness control, so that no worker waits for
+  //! this one any more.
+  void Leave() { Publish(std::numeric_limits<unsigned long long>::max()); }
+
+  //! Wait for all the workers, copy the final parameters to the coordinates,
+  //! and free the windows.
+  template<typename ElemType>
+  void Finish(ElemType* coordinates, const size_t n)
+  {
+    MPI_Barrier(comm);
+    Pull(coordinates, n);
+    MPI_Win_unlock_all(window);
+    MPI_Win_unlock_all(clockWindow);
+    MPI_Barrier(comm);
+    MPI_Win_free(&window);
+    MPI_Win_free(&clockWindow);
+  }
+
+  //! Get the MPI communicator.
+  MPI_Comm Comm() const { return comm; }
+
+ private:
+  //! Write the clock of this worker to its window.
+  void Publish(const unsigned long long clock)
+  {
+    MPI_Accumulate(&clock, 1, MPI_UNSIGNED_LONG_LONG, Rank(), 0, 1,
+        MPI_UNSIGNED_LONG_LONG, MPI_REPLACE, clockWindow);
+    MPI_Win_flush(Rank(), clockWindow);
+  }
+
+  //! The MPI communicator.
+  MPI_Comm comm;
+
+  //! The window of the shard of the parameters of this worker.
+  MPI_Win window;
+
+  //! The window of the clock of this worker.
+  MPI_Win clockWindow;
+
+  //! The number of parameters of each shard.
+  size_t shardSize;
+};
+
+} // namespace ens
+
+#endif
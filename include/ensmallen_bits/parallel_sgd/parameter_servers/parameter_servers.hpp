@@ -0,0 +1,21 @@
+/**
+ * @file parameter_servers.hpp
+ * @author Marcus Edel
+ *
+ * Parameter servers of asynchronous parallel SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_PARAMETER_SERVERS_HPP
+#define ENSMALLEN_PARALLEL_SGD_PARAMETER_SERVERS_PARAMETER_SERVERS_HPP
+
+#include "local_parameter_server.hpp"
+
+#ifdef ENS_USE_MPI
+  #include "mpi_parameter_server.hpp"
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file sparse_adagrad_update.hpp
+ * @author Marcus Edel
+ *
+ * Per-coordinate AdaGrad update policy for parallel Stochastic Gradient
+ * Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_SPARSE_ADAGRAD_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_SPARSE_ADAGRAD_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * AdaGrad update policy for ParallelSGD (see SparseVanillaUpdate for the
+ * interface).  Each coordinate keeps the sum of the squares of its gradients,
+ * and takes the step stepSize * g / (sqrt(sum) + epsilon), so that the rare
+ * features of sparse data keep larger steps than the frequent ones.  Since a
+ * coordinate with a zero gradient adds nothing to its sum, only the
+ * coordinates with a non-zero gradient are touched, and the result is the
+ * same as that of AdaGradUpdate in SGD.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{duchi2011adaptive,
+ *   author  = {Duchi, John and Hazan, Elad and Singer, Yoram},
+ *   title   = {Adaptive subgradient methods for online learning and
+ *              stochastic optimization},
+ *   journal = {Journal of Machine Learning Research},
+ *   volume  = {12},
+ *   pages   = {2121--2159},
+ *   year    = {2011}
+ * }
+ * @endcode
+ */
+class SparseAdaGradUpdate
+{
+ public:
+  /**
+   * Construct the AdaGrad update policy.
+   *
+   * @param epsilon Value added to the denominator for numerical stability.
+   */
+  SparseAdaGradUpdate(const double epsilon = 1e-8) : epsilon(epsilon)
+  { /* Nothing to do. */ }
+
+  //! Reset the sums of the squared gradients.
+  void Initialize(const size_t numElements)
+  {
+    squaredGradients.zeros(numElements);
+  }
+
+  //! Add the squared gradient of the coordinate to its sum, and get its step.
+  double Step(const size_t k,
+              const double stepSize,
+              const double g,
+              const size_t /* t */)
+  {
+    const double sum = squaredGradients[k] + g * g;
+    squaredGradients[k] = sum;
+    return stepSize * g / (std::sqrt(sum) + epsilon);
+  }
+
+  //! Get the value used for numerical stability.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used for numerical stability.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the sums of the squared gradients of the last optimization.
+  const arma::vec& SquaredGradients() const { return squaredGradients; }
+
+ private:
+  //! The value used for numerical stability.
+  double epsilon;
+  //! The sum of the squared gradients of each coordinate.
+  arma::vec squaredGradients;
+};
+
+} // namespace ens
+
+#endif
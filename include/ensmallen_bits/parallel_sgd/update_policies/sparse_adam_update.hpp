@@ -0,0 +1,112 @@
+/**
+ * @file sparse_adam_update.hpp
+ * @author Marcus Edel
+ *
+ * Per-coordinate (lazy) Adam update policy for parallel Stochastic Gradient
+ * Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_SPARSE_ADAM_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_SPARSE_ADAM_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * Lazy Adam update policy for ParallelSGD (see SparseVanillaUpdate for the
+ * interface).  Each coordinate keeps the moving averages of its gradient and
+ * of its squared gradient, but, unlike AdamUpdate in SGD, they only decay
+ * when the coordinate has a non-zero gradient, so that a batch only touches
+ * the state of its own coordinates.  The bias corrections use the number of
+ * batches of the optimization, as in the LazyAdam optimizer of TensorFlow.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Kingma2014,
+ *   author  = {Diederik P. Kingma and Jimmy Ba},
+ *   title   = {Adam: {A} Method for Stochastic Optimization},
+ *   journal = {CoRR},
+ *   year    = {2014},
+ *   url     = {http://arxiv.org/abs/1412.6980}
+ * }
+ * @endcode
+ */
+class SparseAdamUpdate
+{
+ public:
+  /**
+   * Construct the lazy Adam update policy.
+   *
+   * @param beta1 Exponential decay rate for the first moment estimates.
+   * @param beta2 Exponential decay rate for the second moment estimates.
+   * @param epsilon Value added to the denominator for numerical stability.
+   */
+  SparseAdamUpdate(const double beta1 = 0.9,
+                   const double beta2 = 0.999,
+                   const double epsilon = 1e-8) :
+      beta1(beta1),
+      beta2(beta2),
+      epsilon(epsilon)
+  { /* Nothing to do. */ }
+
+  //! Reset the moving averages.
+  void Initialize(const size_t numElements)
+  {
+    m.zeros(numElements);
+    v.zeros(numElements);
+  }
+
+  //! Update the moving averages of the coordinate, and get its step.
+  double Step(const size_t k,
+              const double stepSize,
+              const double g,
+              const size_t t)
+  {
+    const double mk = beta1 * m[k] + (1.0 - beta1) * g;
+    const double vk = beta2 * v[k] + (1.0 - beta2) * g * g;
+    m[k] = mk;
+    v[k] = vk;
+
+    const double biasCorrection1 = 1.0 - std::pow(beta1, (double) t);
+    const double biasCorrection2 = 1.0 - std::pow(beta2, (double) t);
+    return stepSize * std::sqrt(biasCorrection2) / biasCorrection1 * mk /
+        (std::sqrt(vk) + epsilon);
+  }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the value used for numerical stability.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used for numerical stability.
+  double& Epsilon() { return epsilon; }
+
+ private:
+  //! The smoothing parameter.
+  double beta1;
+  //! The second moment coefficient.
+  double beta2;
+  //! The value used for numerical stability.
+  double epsilon;
+
+  //! The exponential moving average of the gradient of each coordinate.
+  arma::vec m;
+  //! The exponential moving average of the squared gradient of each
+  //! coordinate.
+  arma::vec v;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file sparse_vanilla_update.hpp
+ * @author Marcus Edel
+ *
+ * Plain per-coordinate update policy for parallel Stochastic Gradient Descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_SPARSE_VANILLA_UPDATE_HPP
+#define ENSMALLEN_PARALLEL_SGD_SPARSE_VANILLA_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * The default update policy of ParallelSGD: each coordinate with a non-zero
+ * gradient g takes the step stepSize * g, without any state.
+ *
+ * An update policy of ParallelSGD works one coordinate at a time, so that it
+ * can be applied lock-free while the threads update the iterate, and only
+ * touches the state of the coordinates with a non-zero gradient.  It has the
+ * two methods
+ *
+ * @code
+ * // Allocate the state of an iterate with the given number of elements.
+ * void Initialize(const size_t numElements);
+ *
+ * // Get the step of coordinate k (the linear index in the iterate), whose
+ * // gradient is g, in the t-th batch of the optimization (t starts at 1).
+ * double Step(const size_t k, const double stepSize, const double g,
+ *             const size_t t);
+ * @endcode
+ *
+ * Step() is called concurrently by the threads, for any coordinates; like the
+ * iterate in HOGWILD!, the state of a coordinate is updated without
+ * synchronization.
+ */
+class SparseVanillaUpdate
+{
+ public:
+  //! There is no state to allocate.
+  void Initialize(const size_t /* numElements */) { }
+
+  //! Get the plain gradient step of a coordinate.
+  double Step(const size_t /* k */,
+              const double stepSize,
+              const double g,
+              const size_t /* t */) const
+  {
+    return stepSize * g;
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file data_access.hpp
+ * @author Marcus Edel
+ *
+ * Helpers for the problems that keep a matrix of data points, so that they can
+ * hold either dense (arma::Mat) or sparse (arma::SpMat) data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_DATA_ACCESS_HPP
+#define ENSMALLEN_PROBLEMS_DATA_ACCESS_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * Return an alias of the given dense matrix, which uses its memory without
+ * copying it.  We promise to be well-behaved... the elements won't be
+ * modified.
+ */
+template<typename eT>
+inline arma::Mat<eT> AliasData(const arma::Mat<eT>& data)
+{
+  return arma::Mat<eT>(const_cast<arma::Mat<eT>&>(data).memptr(),
+      data.n_rows, data.n_cols, false, false);
+}
+
+/**
+ * Return a copy of the given sparse matrix.  Armadillo sparse matrices can not
+ * use external memory, so the data is copied once; this takes memory
+ * proportional to the number of non-zero elements.
+ */
+template<typename eT>
+inline arma::SpMat<eT> AliasData(const arma::SpMat<eT>& data)
+{
+  return data;
+}
+
+/**
+ * Gather the columns of the given dense matrix with the given indices.
+ */
+template<typename eT>
+inline arma::Mat<eT> GatherColumns(const arma::Mat<eT>& data,
+                                   const arma::uvec& indices)
+{
+  return data.cols(indices);
+}
+
+/**
+ * Gather the columns of the given sparse matrix with the given indices, by
+ * multiplication with a sparse selection matrix; this only touches the
+ * non-zero elements of the gathered columns.
+ */
+template<typename eT>
+inline arma::SpMat<eT> GatherColumns(const arma::SpMat<eT>& data,
+                                     const arma::uvec& indices)
+{
+  arma::umat locations(2, indices.n_elem);
+  locations.row(0) = indices.t();
+  locations.row(1) = arma::linspace<arma::urowvec>(0, indices.n_elem - 1,
+      indices.n_elem);
+  const arma::SpMat<eT> selection(locations,
+      arma::ones<arma::Col<eT>>(indices.n_elem), data.n_cols, indices.n_elem);
+
+  return data * selection;
+}
+
+/**
+ * Make sure an alias made by AliasData() is not written to when it is replaced
+ * by new data.
+ */
+template<typename eT>
+inline void ReleaseData(arma::Mat<eT>& data)
+{
+  if (data.mem_state >= 1)
+    data.reset();
+}
+
+//! Sparse matrices always own their data.
+template<typename eT>
+inline void ReleaseData(arma::SpMat<eT>& /* data */) { }
+
+} // namespace test
+} // namespace ens
+
+#endif
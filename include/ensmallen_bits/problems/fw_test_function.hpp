@@ -53,6 +53,29 @@ class TestFuncFW
     gradient[1] = coords[1] - 0.2;
     gradient[2] = coords[2] - 0.3;
   }
+
+  /**
+   * Update the gradient after the Frank-Wolfe step
+   * \f$ x \leftarrow (1 - \gamma) x + \gamma \cdot value \cdot e_{index} \f$.
+   *
+   * @param coords input vector x, after the step.
+   * @param gamma step size.
+   * @param index index of the non-zero element of the atom.
+   * @param value value of the non-zero element of the atom.
+   * @param gradient gradient before the step, updated in place.
+   */
+  void UpdateGradient(const arma::mat& /* coords */,
+                      const double gamma,
+                      const size_t index,
+                      const double value,
+                      arma::mat& gradient)
+  {
+    gradient *= (1.0 - gamma);
+    gradient[0] -= gamma * 0.1;
+    gradient[1] -= gamma * 0.2;
+    gradient[2] -= gamma * 0.3;
+    gradient[index] += gamma * value;
+  }
 };
 
 } // namespace ens
@@ -14,6 +14,8 @@
 #ifndef ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 
+#include "data_access.hpp"
+
 namespace ens {
 namespace test {
 
@@ -21,6 +23,12 @@ namespace test {
  * The log-likelihood function for the logistic regression objective function.
  * This is used by various ensmallen optimizers to train a logistic regression
  * model.
+ *
+ * The predictors may be dense (arma::mat) or sparse (arma::sp_mat); sparse
+ * predictors are never converted to dense matrices, so that the memory used is
+ * proportional to their number of non-zero elements.
+ *
+ * @tparam MatType Type of the predictors matrix.
  */
 template<typename MatType = arma::mat>
 class LogisticRegressionFunction
@@ -132,9 +140,73 @@ class LogisticRegressionFunction
                        const size_t j,
                        arma::sp_mat& gradient) const;
 
+  /**
+   * Evaluate the partial gradient with respect to only one feature, and store
+   * only its (single-element) non-zero column in the given vector.  SCD uses
+   * this overload to avoid building a sparse matrix at every step.
+   *
+   * If the parameters are those last given to InitializeObjective() and
+   * UpdateObjective(), the residual of each point stored by those methods is
+   * used, so that this costs one pass over row j of the predictors instead of
+   * a pass over the whole predictor matrix.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param j Index of the feature with respect to which the gradient is to
+   *    be computed.
+   * @param gradient Vector to output the gradient column into.
+   */
+  void PartialGradient(const arma::mat& parameters,
+                       const size_t j,
+                       arma::vec& gradient) const;
+
+  /**
+   * Multiply the Hessian of the objective at the given parameters with v, in
+   * two passes over the predictors.  The Hessian is X W X^T plus the
+   * regularization, with X the predictors (with a row of ones for the
+   * intercept) and W the diagonal of the variances sig(w'x) (1 - sig(w'x)).
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param v Vector to multiply with, in the shape of the parameters.
+   * @param product Vector to store the product in.
+   */
+  void HessianVectorProduct(const arma::mat& parameters,
+                            const arma::mat& v,
+                            arma::mat& product) const;
+
+  /**
+   * Compute and store the linear prediction of every point for the given
+   * parameters, and return the objective there.  Together with
+   * UpdateObjective(), this lets SCD keep track of the objective without
+   * evaluating it in full, and lets PartialGradient() reuse the predictions.
+   * This must be called again after Shuffle().
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @return Objective at the given parameters.
+   */
+  double InitializeObjective(const arma::mat& parameters);
+
+  /**
+   * Update the stored linear predictions after feature j of the parameters was
+   * changed by delta, and return the objective at the new parameters.  This
+   * costs one pass over the points, instead of one pass over the whole
+   * predictor matrix for Evaluate().
+   *
+   * @param parameters Vector of logistic regression parameters (already
+   *    changed).
+   * @param j Index of the changed feature.
+   * @param delta Change of the feature (one element).
+   * @return Objective at the new parameters.
+   */
+  double UpdateObjective(const arma::mat& parameters,
+                         const size_t j,
+                         const arma::vec& delta);
+
   /**
    * Evaluate the objective function and gradient of the logistic regression
-   * log-likelihood function simultaneously with the given parameters.
+   * log-likelihood function simultaneously with the given parameters.  The
+   * loss and the residual of each point are computed in a single, numerically
+   * stable pass, so the objective stays finite even for points classified
+   * wrongly with very high confidence.
    */
   template<typename GradType>
   double EvaluateWithGradient(const arma::mat& parameters,
@@ -146,6 +218,138 @@ class LogisticRegressionFunction
                               GradType& gradient,
                               const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the objective functions and the gradients of several models on
+   * the given batch of points at once: column k of the parameters holds the
+   * parameters of a model with the regularization parameter of models[k].  The
+   * predictions of all the models are computed with one matrix product, and
+   * the gradients with another, instead of one pass over the points for each
+   * model.  All the models must have the same points; those of models[0] are
+   * used.  MultiModelFunction uses this method.
+   *
+   * @param models The models; only their regularization parameters are used.
+   * @param parameters Matrix of parameters, one column per model.
+   * @param begin The first point of the batch.
+   * @param gradient Matrix to store the gradients in, one column per model.
+   * @param batchSize Number of points in the batch.
+   * @return The sum of the objectives of the models.
+   */
+  template<typename GradType>
+  static double EvaluateWithGradient(
+      const std::vector<LogisticRegressionFunction>& models,
+      const arma::mat& parameters,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize);
+
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters on the points with the given indices.  Optimizers such as SGD
+   * use this to visit the points in a shuffled order without calling
+   * Shuffle(), so that the data is never copied.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param indices Indices of the points to use for objective function
+   *     evaluation.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const arma::uvec& indices) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters on the points with the given indices.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param indices Indices of the points to use for objective function
+   *     gradient evaluation.
+   * @param gradient Vector to output gradient into.
+   */
+  template<typename GradType>
+  void Gradient(const arma::mat& parameters,
+                const arma::uvec& indices,
+                GradType& gradient) const;
+
+  /**
+   * Evaluate the objective function and gradient of the logistic regression
+   * log-likelihood function simultaneously on the points with the given
+   * indices.
+   */
+  template<typename GradType>
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const arma::uvec& indices,
+                              GradType& gradient) const;
+
+  /**
+   * Evaluate the logistic regression log-likelihood function for the given
+   * batch, and store the derivative of the loss of each point of the batch
+   * with respect to its linear prediction in coefficients.  The gradient of
+   * the batch is then LinearGradient() of the coefficients plus batchSize
+   * times RegularizationGradient(); optimizers such as SAGA use this to store
+   * one scalar per point instead of a whole gradient.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param coefficients Vector to store the coefficient of each point in.
+   * @param batchSize Number of points in the batch.
+   */
+  double EvaluateWithCoefficients(const arma::mat& parameters,
+                                  const size_t begin,
+                                  arma::rowvec& coefficients,
+                                  const size_t batchSize) const;
+
+  /**
+   * Compute the sum of the features (including the intercept) of the points
+   * of the given batch, weighted by the given coefficients.
+   *
+   * @param begin Index of the first point of the batch.
+   * @param coefficients Coefficient of each point of the batch.
+   * @param gradient Vector to output the weighted sum into.
+   * @param batchSize Number of points in the batch.
+   */
+  void LinearGradient(const size_t begin,
+                      const arma::rowvec& coefficients,
+                      arma::mat& gradient,
+                      const size_t batchSize) const;
+
+  /**
+   * Compute the gradient of the L2-regularization term of a single point.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output the gradient into.
+   */
+  void RegularizationGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * for the given batch, and return the sum of the squared distances between
+   * the gradient of each point and the mean gradient of the batch.  Since the
+   * gradient of each point is a scalar times its features, this only takes
+   * one pass over the batch.  This is used by BigBatchSGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param gradient Vector to output the gradient of the batch into.
+   * @param batchSize Number of points in the batch.
+   */
+  double GradientVariance(const arma::mat& parameters,
+                          const size_t begin,
+                          arma::mat& gradient,
+                          const size_t batchSize) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * for the points with the given indices, and return the sum of the squared
+   * distances between the gradient of each point and their mean gradient.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param indices Indices of the points to use.
+   * @param gradient Vector to output the gradient into.
+   */
+  double GradientVariance(const arma::mat& parameters,
+                          const arma::uvec& indices,
+                          arma::mat& gradient) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -203,6 +407,50 @@ class LogisticRegressionFunction
   arma::Row<size_t> responses;
   //! The regularization parameter for L2-regularization.
   double lambda;
+  //! The responses, converted once to double for the loss computations.
+  arma::rowvec doubleResponses;
+
+  //! The linear prediction of each point, kept by UpdateObjective().
+  arma::rowvec margins;
+  //! The residual sig(w'x) - y of each point, kept by UpdateObjective().
+  arma::rowvec residuals;
+  //! The parameters the margins were computed for.
+  arma::mat marginParameters;
+  //! The regularization term of the objective, kept by UpdateObjective().
+  double regularizationObjective;
+
+  /**
+   * Compute the residuals and the objective given the linear prediction of
+   * every point.
+   */
+  double MarginObjective();
+
+  /**
+   * Compute the (numerically stable) loss of the points with the given linear
+   * predictions and responses, and store the residual sig(z) - y of each point
+   * in residuals, in a single pass.  residuals may be margins.memptr().
+   *
+   * @param margins Linear prediction of each point.
+   * @param responses Response of each point.
+   * @param residuals Array to store the residual of each point in.
+   * @return Sum of the losses of the points.
+   */
+  static double LogisticLoss(const arma::rowvec& margins,
+                             const double* responses,
+                             double* residuals);
+
+  //! Return whether the stored margins are those of the given parameters.
+  bool MarginsCached(const arma::mat& parameters) const;
+
+  /**
+   * Compute the gradient of the given batch of points and the spread of the
+   * gradients of the points (see GradientVariance()).
+   */
+  template<typename BatchType>
+  double ComputeGradientVariance(const arma::mat& parameters,
+                                 const BatchType& batch,
+                                 const arma::rowvec& batchResponses,
+                                 arma::mat& gradient) const;
 };
 
 // Convenience typedefs.
@@ -24,12 +24,13 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     const arma::Row<size_t>& responses,
     const double lambda) :
     // We promise to be well-behaved... the elements won't be modified.
-    predictors(MatType(const_cast<MatType&>(predictors).memptr(), predictors.n_rows,
-        predictors.n_cols, false, false)),
+    predictors(AliasData(predictors)),
     responses(arma::Row<size_t>(
         const_cast<arma::Row<size_t>&>(responses).memptr(),
         responses.n_elem, false, false)),
-    lambda(lambda)
+    lambda(lambda),
+    doubleResponses(arma::conv_to<arma::rowvec>::from(responses)),
+    regularizationObjective(0.0)
 {
   initialPoint = arma::rowvec(predictors.n_rows + 1, arma::fill::zeros);
 
@@ -52,12 +53,13 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     const arma::vec& initialPoint,
     const double lambda) :
     initialPoint(initialPoint),
-    predictors(MatType(const_cast<MatType&>(predictors).memptr(), predictors.n_rows,
-        predictors.n_cols, false, false)),
+    predictors(AliasData(predictors)),
     responses(arma::Row<size_t>(
         const_cast<arma::Row<size_t>&>(responses).memptr(),
         responses.n_elem, false, false)),
-    lambda(lambda)
+    lambda(lambda),
+    doubleResponses(arma::conv_to<arma::rowvec>::from(responses)),
+    regularizationObjective(0.0)
 {
   // To check if initialPoint is compatible with predictors.
   if (initialPoint.n_rows != (predictors.n_rows + 1) ||
@@ -77,12 +79,12 @@ void LogisticRegressionFunction<MatType>::Shuffle()
   arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
       predictors.n_cols - 1, predictors.n_cols));
 
-  newPredictors = predictors.cols(ordering);
+  newPredictors = GatherColumns(predictors, ordering);
   newResponses = responses.cols(ordering);
+  doubleResponses = doubleResponses.cols(ordering);
 
   // If we are an alias, make sure we don't write to the original data.
-  if (predictors.mem_state >= 1)
-    predictors.reset();
+  ReleaseData(predictors);
 
   if (responses.mem_state >= 1)
     responses.reset();
@@ -90,6 +92,11 @@ void LogisticRegressionFunction<MatType>::Shuffle()
   // Take ownership of the new data.
   predictors = std::move(newPredictors);
   responses = std::move(newResponses);
+
+  // The stored margins are in the old order.
+  margins.reset();
+  residuals.reset();
+  marginParameters.reset();
 }
 
 /**
@@ -211,6 +218,26 @@ void LogisticRegressionFunction<MatType>::Gradient(
       predictors.cols(begin, begin + batchSize - 1).t() + regularization;
 }
 
+//! Multiply the Hessian of the logistic regression objective with a vector.
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::HessianVectorProduct(
+    const arma::mat& parameters,
+    const arma::mat& v,
+    arma::mat& product) const
+{
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+
+  // The directional derivative of each prediction, scaled by its variance.
+  const arma::rowvec weights = sigmoids % (1.0 - sigmoids) % (v(0, 0) +
+      v.tail_cols(v.n_elem - 1) * predictors);
+
+  product.set_size(arma::size(parameters));
+  product[0] = arma::accu(weights);
+  product.tail_cols(parameters.n_elem - 1) = weights * predictors.t() +
+      lambda * v.tail_cols(v.n_elem - 1);
+}
+
 /**
  * Evaluate the partial gradient of the logistic regression objective
  * function with respect to the individual features in the parameter.
@@ -221,22 +248,139 @@ void LogisticRegressionFunction<MatType>::PartialGradient(
     const size_t j,
     arma::sp_mat& gradient) const
 {
+  arma::vec column;
+  PartialGradient(parameters, j, column);
+
+  gradient.zeros(arma::size(parameters));
+  gradient[j] = column[0];
+}
+
+/**
+ * Evaluate the non-zero column of the partial gradient of the logistic
+ * regression objective function with respect to one feature.
+ */
+template <typename MatType>
+void LogisticRegressionFunction<MatType>::PartialGradient(
+    const arma::mat& parameters,
+    const size_t j,
+    arma::vec& gradient) const
+{
+  gradient.set_size(1);
+
+  if (MarginsCached(parameters))
+  {
+    // Only row j of the predictors is needed with the stored residuals.
+    if (j == 0)
+    {
+      gradient[0] = arma::accu(residuals);
+    }
+    else
+    {
+      gradient[0] = arma::dot(predictors.row(j - 1), residuals) + lambda *
+          parameters(0, j);
+    }
+
+    return;
+  }
+
   const arma::rowvec diffs = responses - (1 / (1 + arma::exp(-parameters(0, 0)
       - parameters.tail_cols(parameters.n_elem - 1) * predictors)));
 
-  gradient.set_size(arma::size(parameters));
-
   if (j == 0)
   {
-    gradient[j] = -arma::accu(diffs);
+    gradient[0] = -arma::accu(diffs);
   }
   else
   {
-    gradient[j] = arma::dot(-predictors.row(j - 1), diffs) + lambda *
+    gradient[0] = -arma::dot(predictors.row(j - 1), diffs) + lambda *
       parameters(0, j);
   }
 }
 
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::InitializeObjective(
+    const arma::mat& parameters)
+{
+  margins = parameters(0, 0) + parameters.tail_cols(parameters.n_elem - 1) *
+      predictors;
+  marginParameters = parameters;
+  regularizationObjective = 0.5 * lambda *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+      parameters.tail_cols(parameters.n_elem - 1));
+
+  return MarginObjective();
+}
+
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::UpdateObjective(
+    const arma::mat& parameters,
+    const size_t j,
+    const arma::vec& delta)
+{
+  if (j == 0)
+  {
+    margins += delta[0];
+  }
+  else
+  {
+    margins += delta[0] * predictors.row(j - 1);
+
+    // Only the regularization of feature j changed.
+    const double oldValue = parameters(0, j) - delta[0];
+    regularizationObjective += 0.5 * lambda * (parameters(0, j) *
+        parameters(0, j) - oldValue * oldValue);
+  }
+
+  if (marginParameters.n_elem == parameters.n_elem)
+    marginParameters[j] = parameters[j];
+
+  return MarginObjective();
+}
+
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::MarginObjective()
+{
+  // This is the same as Evaluate(), with the stored linear predictions.
+  residuals.set_size(margins.n_elem);
+  return regularizationObjective + LogisticLoss(margins,
+      doubleResponses.memptr(), residuals.memptr());
+}
+
+template <typename MatType>
+double LogisticRegressionFunction<MatType>::LogisticLoss(
+    const arma::rowvec& margins,
+    const double* responses,
+    double* residuals)
+{
+  // With e = exp(-|z|), the loss of a point with prediction z and response y
+  // is log(1 + exp(z)) - y z = max(z, 0) + log1p(e) - y z, and sig(z) is
+  // 1 / (1 + e) or e / (1 + e); neither form overflows.  residuals may alias
+  // margins, since each prediction is read before its residual is written.
+  double loss = 0.0;
+  const arma::uword n = margins.n_elem;
+  const double* z = margins.memptr();
+  for (arma::uword i = 0; i < n; ++i)
+  {
+    const double zi = z[i];
+    const double e = std::exp(-std::abs(zi));
+    loss += std::max(zi, 0.0) + std::log1p(e) - responses[i] * zi;
+    residuals[i] = ((zi >= 0.0) ? 1.0 : e) / (1.0 + e) - responses[i];
+  }
+
+  return loss;
+}
+
+template <typename MatType>
+bool LogisticRegressionFunction<MatType>::MarginsCached(
+    const arma::mat& parameters) const
+{
+  // Comparing the parameters is much cheaper than recomputing the margins.
+  return residuals.n_elem == predictors.n_cols &&
+      marginParameters.n_elem == parameters.n_elem &&
+      std::equal(parameters.begin(), parameters.end(),
+      marginParameters.begin());
+}
+
 template<typename MatType>
 template<typename GradType>
 double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
@@ -251,22 +395,19 @@ double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
                 parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate the sigmoid function values.
-  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) * predictors)));
+  // Compute the loss and the residual of every point in a single pass over
+  // the linear predictions.
+  arma::rowvec residuals = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * predictors;
+  const double result = LogisticLoss(residuals, doubleResponses.memptr(),
+      residuals.memptr());
 
   gradient.set_size(arma::size(parameters));
-  gradient[0] = -arma::accu(responses - sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - responses) *
-      predictors.t() + regularization;
-
-  // Now compute the objective function using the sigmoids.
-  double result = arma::accu(arma::log(1.0 -
-      arma::conv_to<arma::rowvec>::from(responses) + sigmoids %
-      (2 * arma::conv_to<arma::rowvec>::from(responses) - 1.0)));
+  gradient[0] = arma::accu(residuals);
+  gradient.tail_cols(parameters.n_elem - 1) = residuals * predictors.t() +
+      regularization;
 
-  // Invert the result, because it's a minimization.
-  return objectiveRegularization - result;
+  return objectiveRegularization + result;
 }
 
 template<typename MatType>
@@ -287,26 +428,263 @@ double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
                 parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate the sigmoid function values.
-  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+  // Compute the loss and the residual of every point in a single pass over
+  // the linear predictions.
+  arma::rowvec residuals = parameters(0, 0) +
       parameters.tail_cols(parameters.n_elem - 1) *
-      predictors.cols(begin, begin + batchSize - 1))));
+      predictors.cols(begin, begin + batchSize - 1);
+  const double result = LogisticLoss(residuals,
+      doubleResponses.memptr() + begin, residuals.memptr());
 
   gradient.set_size(parameters.n_rows, parameters.n_cols);
-  gradient[0] = -arma::accu(responses.subvec(begin, begin + batchSize - 1) -
-      sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids -
-      responses.subvec(begin, begin + batchSize - 1)) *
+  gradient[0] = arma::accu(residuals);
+  gradient.tail_cols(parameters.n_elem - 1) = residuals *
       predictors.cols(begin, begin + batchSize - 1).t() + regularization;
 
-  // Now compute the objective function using the sigmoids.
-  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(responses.subvec(begin,
-      begin + batchSize - 1));
-  const double result = arma::accu(arma::log(1.0 - respD + sigmoids %
+  return objectiveRegularization + result;
+}
+
+template<typename MatType>
+template<typename GradType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
+    const std::vector<LogisticRegressionFunction>& models,
+    const arma::mat& parameters,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  const LogisticRegressionFunction& data = models[0];
+  const size_t numFeatures = parameters.n_rows - 1;
+  const auto points = data.predictors.cols(begin, begin + batchSize - 1);
+
+  // One column of predictions per model, so that the loss of each model is a
+  // pass over contiguous memory; the residuals overwrite the predictions.
+  arma::mat residuals = points.t() * parameters.tail_rows(numFeatures);
+  residuals.each_row() += parameters.row(0);
+
+  const double scale = batchSize / (double) data.predictors.n_cols;
+  double objective = 0.0;
+  for (size_t k = 0; k < models.size(); ++k)
+  {
+    const arma::rowvec margins(residuals.colptr(k), batchSize, false, true);
+    objective += LogisticLoss(margins, data.doubleResponses.memptr() + begin,
+        residuals.colptr(k));
+
+    const arma::vec weights = parameters.col(k).tail(numFeatures);
+    objective += models[k].lambda * scale / 2.0 * arma::dot(weights, weights);
+  }
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient.row(0) = arma::sum(residuals, 0);
+  gradient.tail_rows(numFeatures) = points * residuals;
+  for (size_t k = 0; k < models.size(); ++k)
+  {
+    gradient.col(k).tail(numFeatures) += models[k].lambda * scale *
+        parameters.col(k).tail(numFeatures);
+  }
+
+  return objective;
+}
+
+/**
+ * Evaluate the logistic regression objective function given the estimated
+ * parameters for the points with the given indices.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const arma::uvec& indices) const
+{
+  // Calculate the regularization term.
+  const double regularization = lambda *
+      (indices.n_elem / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+                parameters.tail_cols(parameters.n_elem - 1));
+
+  // Calculate the sigmoid function values.
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) *
+      GatherColumns(predictors, indices))));
+
+  // Compute the objective for the given points.
+  arma::rowvec respD = arma::conv_to<arma::rowvec>::from(
+      responses.cols(indices));
+  const double result = arma::accu(arma::log(1.0 - respD + sigmoid %
       (2 * respD - 1.0)));
 
   // Invert the result, because it's a minimization.
-  return objectiveRegularization - result;
+  return regularization - result;
+}
+
+//! Evaluate the gradient of the logistic regression objective function for the
+//! points with the given indices.
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const arma::uvec& indices,
+    GradType& gradient) const
+{
+  // Regularization term.
+  arma::mat regularization;
+  regularization = lambda * parameters.tail_cols(parameters.n_elem - 1)
+      / predictors.n_cols * indices.n_elem;
+
+  // The points are gathered once, since they are used twice.
+  const MatType batch = GatherColumns(predictors, indices);
+  const arma::Row<size_t> batchResponses = responses.cols(indices);
+
+  const arma::rowvec exponents = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * batch;
+  // Calculating the sigmoid function values.
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-exponents));
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = -arma::accu(batchResponses - sigmoids);
+  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - batchResponses) *
+      batch.t() + regularization;
+}
+
+template<typename MatType>
+template<typename GradType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const arma::uvec& indices,
+    GradType& gradient) const
+{
+  // Regularization term.
+  arma::mat regularization =
+      lambda * parameters.tail_cols(parameters.n_elem - 1) / predictors.n_cols *
+      indices.n_elem;
+
+  const double objectiveRegularization = lambda *
+      (indices.n_elem / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+                parameters.tail_cols(parameters.n_elem - 1));
+
+  // The points are gathered once, since they are used twice.
+  const MatType batch = GatherColumns(predictors, indices);
+  const arma::rowvec batchResponses = doubleResponses.cols(indices);
+
+  // Compute the loss and the residual of every point in a single pass over
+  // the linear predictions.
+  arma::rowvec residuals = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * batch;
+  const double result = LogisticLoss(residuals, batchResponses.memptr(),
+      residuals.memptr());
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = arma::accu(residuals);
+  gradient.tail_cols(parameters.n_elem - 1) = residuals * batch.t() +
+      regularization;
+
+  return objectiveRegularization + result;
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateWithCoefficients(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::rowvec& coefficients,
+    const size_t batchSize) const
+{
+  const double objectiveRegularization = lambda *
+      (batchSize / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+                parameters.tail_cols(parameters.n_elem - 1));
+
+  // The derivative of the loss of each point with respect to its prediction
+  // is its residual.
+  coefficients = parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) *
+      predictors.cols(begin, begin + batchSize - 1);
+  const double result = LogisticLoss(coefficients,
+      doubleResponses.memptr() + begin, coefficients.memptr());
+
+  return objectiveRegularization + result;
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::LinearGradient(
+    const size_t begin,
+    const arma::rowvec& coefficients,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  gradient.set_size(1, predictors.n_rows + 1);
+  gradient[0] = arma::accu(coefficients);
+  gradient.tail_cols(predictors.n_rows) = coefficients *
+      predictors.cols(begin, begin + batchSize - 1).t();
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::RegularizationGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  gradient.set_size(arma::size(parameters));
+  gradient[0] = 0;
+  gradient.tail_cols(parameters.n_elem - 1) = lambda *
+      parameters.tail_cols(parameters.n_elem - 1) / predictors.n_cols;
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::GradientVariance(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  return ComputeGradientVariance(parameters,
+      predictors.cols(begin, begin + batchSize - 1),
+      doubleResponses.subvec(begin, begin + batchSize - 1), gradient);
+}
+
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::GradientVariance(
+    const arma::mat& parameters,
+    const arma::uvec& indices,
+    arma::mat& gradient) const
+{
+  // The points are gathered once, since they are used twice.
+  const MatType batch = GatherColumns(predictors, indices);
+  return ComputeGradientVariance(parameters, batch,
+      doubleResponses.cols(indices), gradient);
+}
+
+template<typename MatType>
+template<typename BatchType>
+double LogisticRegressionFunction<MatType>::ComputeGradientVariance(
+    const arma::mat& parameters,
+    const BatchType& batch,
+    const arma::rowvec& batchResponses,
+    arma::mat& gradient) const
+{
+  // The gradient of point i is c_i [1; x_i] plus the regularization term,
+  // which is the same for all the points.  The regularization term therefore
+  // does not contribute to the spread, which is
+  //   sum_i c_i^2 (1 + ||x_i||^2) - ||sum_i c_i [1; x_i]||^2 / n.
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-(parameters(0, 0) +
+      parameters.tail_cols(parameters.n_elem - 1) * batch)));
+  const arma::rowvec coefficients = sigmoids - batchResponses;
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  gradient[0] = arma::accu(coefficients);
+  gradient.tail_cols(parameters.n_elem - 1) = coefficients * batch.t();
+
+  const arma::rowvec featureNorms(arma::sum(arma::square(batch), 0));
+  const double squaredNorms = arma::dot(arma::square(coefficients),
+      1.0 + featureNorms);
+  const double variance = squaredNorms -
+      arma::dot(gradient, gradient) / batchResponses.n_elem;
+
+  // Add the regularization term.
+  gradient.tail_cols(parameters.n_elem - 1) += lambda *
+      parameters.tail_cols(parameters.n_elem - 1) / predictors.n_cols *
+      batchResponses.n_elem;
+
+  // Guard against a negative result due to cancellation.
+  return std::max(variance, 0.0);
 }
 
 template<typename MatType>
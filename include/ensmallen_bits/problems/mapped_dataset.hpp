@@ -0,0 +1,304 @@
+/**
+ * @file mapped_dataset.hpp
+ * @author Marcus Edel
+ *
+ * A labeled dataset read from a binary file mapped with mmap(), whose
+ * predictors and responses are used in place by the regression test problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MAPPED_DATASET_HPP
+#define ENSMALLEN_PROBLEMS_MAPPED_DATASET_HPP
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace ens {
+namespace test {
+
+/**
+ * A dataset of points with responses (or labels), stored in a binary file that
+ * is mapped with mmap() instead of being read, so that opening even a very
+ * large dataset takes no time and no memory: the operating system reads the
+ * pages of the file when they are first used, and can drop them again under
+ * memory pressure.  Predictors() and Responses() are Armadillo objects that
+ * use the mapped memory; LogisticRegressionFunction and
+ * SoftmaxRegressionFunction alias them instead of copying them (see
+ * AliasData()), so the MappedDataset must outlive the function.
+ *
+ * The file holds a header of four 64-bit words, in the native byte order:
+ *
+ *  - the magic number "ENSDATA1" (as 8 characters);
+ *  - the number of rows (dimensions) of the predictors;
+ *  - the number of columns (points) of the predictors;
+ *  - 1 if the file holds responses, 0 otherwise;
+ *
+ * then the predictors as doubles in column-major order, then the responses as
+ * 64-bit unsigned integers, one per point.  Save() writes such a file.
+ *
+ * The access pattern is given to the operating system with madvise(): with
+ * SequentialAccess, pages are read ahead aggressively and dropped after use,
+ * which suits full passes over the data, or optimizers that visit contiguous
+ * blocks of points (such as IndexedFunction with a block size); with
+ * RandomAccess, read-ahead is disabled, which suits points visited in a fully
+ * shuffled order, since any read-ahead would be wasted.  Note that the
+ * Shuffle() of the regression functions copies their data; to keep the data
+ * mapped, shuffle the visitation order with IndexedFunction instead.
+ *
+ * The file is mapped privately, so it is never modified.  On platforms
+ * without mmap() the file is read into memory, and the hint is ignored.
+ *
+ * @code
+ * MappedDataset dataset("train.bin", MappedDataset::RandomAccess);
+ * LogisticRegressionFunction<> f(dataset.Predictors(), dataset.Responses());
+ * @endcode
+ */
+class MappedDataset
+{
+ public:
+  //! The access patterns of the points of the dataset.
+  enum AccessPattern
+  {
+    SequentialAccess,
+    RandomAccess
+  };
+
+  /**
+   * Map the dataset held by the given file.
+   *
+   * @param filename File that holds the dataset.
+   * @param access Expected access pattern of the points.
+   */
+  MappedDataset(const std::string& filename,
+                const AccessPattern access = SequentialAccess) :
+      header(ReadHeader(filename)),
+      bytes(sizeof(Header) + (header.rows * header.cols + (header.hasResponses ?
+          header.cols : 0)) * sizeof(double)),
+      mapped(false),
+      data(Load(filename, bytes, buffer, mapped)),
+      // The views are constructed on the memory of the file; assigning them
+      // would copy the memory.
+      predictors((double*) (data + sizeof(Header)), header.rows, header.cols,
+          false, true),
+      responses((size_t*) (data + sizeof(Header) + header.rows * header.cols *
+          sizeof(double)), header.hasResponses ? header.cols : 0, false, true)
+  {
+    Advise(access);
+  }
+
+  //! Unmap the dataset.
+  ~MappedDataset()
+  {
+  #if defined(__unix__) || defined(__APPLE__)
+    // The views do not free the memory they do not own.
+    if (mapped)
+      munmap(data, bytes);
+  #endif
+  }
+
+  // The mapping can not be shared.
+  MappedDataset(const MappedDataset&) = delete;
+  MappedDataset& operator=(const MappedDataset&) = delete;
+
+  /**
+   * Write the given dataset to a file in the format of MappedDataset.
+   *
+   * @param filename File to write.
+   * @param predictors Predictors, one point per column.
+   * @param responses Responses of the points (may be empty if there are
+   *     none).
+   */
+  static void Save(const std::string& filename,
+                   const arma::mat& predictors,
+                   const arma::Row<size_t>& responses = arma::Row<size_t>())
+  {
+    if (!responses.is_empty() && responses.n_elem != predictors.n_cols)
+    {
+      std::ostringstream oss;
+      oss << "MappedDataset::Save(): " << responses.n_elem << " responses "
+          << "given for " << predictors.n_cols << " points!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    Header header;
+    std::memcpy(header.magic, "ENSDATA1", 8);
+    header.rows = predictors.n_rows;
+    header.cols = predictors.n_cols;
+    header.hasResponses = responses.is_empty() ? 0 : 1;
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    stream.write((const char*) &header, sizeof(Header));
+    stream.write((const char*) predictors.memptr(),
+        predictors.n_elem * sizeof(double));
+    for (size_t i = 0; i < responses.n_elem; ++i)
+    {
+      const uint64_t response = responses[i];
+      stream.write((const char*) &response, sizeof(uint64_t));
+    }
+
+    if (!stream)
+    {
+      std::ostringstream oss;
+      oss << "MappedDataset::Save(): cannot write " << filename << "!";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  /**
+   * Give the operating system a new access pattern of the points, for
+   * instance before switching from full passes over the data to shuffled
+   * visitation.
+   */
+  void Advise(const AccessPattern access)
+  {
+  #if defined(__unix__) || defined(__APPLE__)
+    if (!mapped)
+      return;
+
+    // Failures are ignored; the hint only affects the performance.
+    (void) madvise(data, bytes, (access == SequentialAccess) ?
+        MADV_SEQUENTIAL : MADV_RANDOM);
+  #else
+    (void) access;
+  #endif
+  }
+
+  //! Get the predictors, one point per column.
+  const arma::mat& Predictors() const { return predictors; }
+  //! Get the responses (empty if the file has none).
+  const arma::Row<size_t>& Responses() const { return responses; }
+
+  //! Get whether the file is mapped (rather than read into memory).
+  bool Mapped() const { return mapped; }
+
+ private:
+  //! The header of the file.
+  struct Header
+  {
+    char magic[8];
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t hasResponses;
+  };
+
+  /**
+   * Read and check the header of the given file, including that the file has
+   * the size given by the header.
+   */
+  static Header ReadHeader(const std::string& filename)
+  {
+    std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+    if (!stream.is_open())
+      Fail("cannot open " + filename);
+    const uint64_t fileBytes = (uint64_t) stream.tellg();
+
+    Header header;
+    stream.seekg(0);
+    if (!stream.read((char*) &header, sizeof(Header)) ||
+        std::memcmp(header.magic, "ENSDATA1", 8) != 0 ||
+        header.hasResponses > 1)
+    {
+      Fail(filename + " is not a dataset");
+    }
+
+    // The responses are used in place as size_t.
+    if (header.hasResponses && sizeof(size_t) != sizeof(uint64_t))
+      Fail("responses can only be mapped with a 64-bit size_t");
+
+    // The sizes are checked in a way that can not overflow.
+    const uint64_t words = (fileBytes - sizeof(Header)) / sizeof(double);
+    const uint64_t responseWords = header.hasResponses ? header.cols : 0;
+    if ((fileBytes - sizeof(Header)) % sizeof(double) != 0 ||
+        responseWords > words || (header.cols > 0 &&
+        header.rows != (words - responseWords) / header.cols) ||
+        (header.cols == 0 && words != 0) ||
+        (header.cols > 0 && (words - responseWords) % header.cols != 0))
+    {
+      std::ostringstream oss;
+      oss << filename << " has " << fileBytes << " bytes, which do not match a "
+          << header.rows << " x " << header.cols << " dataset";
+      Fail(oss.str());
+    }
+
+    return header;
+  }
+
+  /**
+   * Map the given number of bytes of the given file, or read them into the
+   * given buffer if mmap() is not available; return the memory of the file.
+   */
+  static char* Load(const std::string& filename,
+                    const size_t bytes,
+                    std::vector<double>& buffer,
+                    bool& mapped)
+  {
+  #if defined(__unix__) || defined(__APPLE__)
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+      Fail("cannot open " + filename);
+
+    // The mapping is private and writable, as Armadillo views are not const;
+    // the pages are only copied if they are written.
+    void* address = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+        0);
+    // The mapping holds its own reference to the file.
+    close(fd);
+    if (address == MAP_FAILED)
+      Fail("cannot map " + filename);
+
+    mapped = true;
+    return static_cast<char*>(address);
+  #else
+    buffer.resize((bytes + sizeof(double) - 1) / sizeof(double));
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream.read((char*) buffer.data(), bytes))
+      Fail("cannot read " + filename);
+
+    mapped = false;
+    return (char*) buffer.data();
+  #endif
+  }
+
+  //! Throw an error about the dataset.
+  static void Fail(const std::string& reason)
+  {
+    std::ostringstream oss;
+    oss << "MappedDataset::MappedDataset(): " << reason << "!";
+    throw std::runtime_error(oss.str());
+  }
+
+  //! The header of the file.
+  Header header;
+
+  //! The size of the file.
+  size_t bytes;
+
+  //! The contents of the file, if it is read into memory.
+  std::vector<double> buffer;
+
+  //! Whether the file is mapped (rather than read into buffer).
+  bool mapped;
+
+  //! The memory of the file.
+  char* data;
+
+  //! The predictors, in the memory of the file.
+  arma::mat predictors;
+
+  //! The responses, in the memory of the file.
+  arma::Row<size_t> responses;
+};
+
+} // namespace test
+} // namespace ens
+
+#endif
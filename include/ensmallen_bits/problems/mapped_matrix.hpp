@@ -0,0 +1,161 @@
+/**
+ * @file mapped_matrix.hpp
+ * @author Marcus Edel
+ *
+ * A dense matrix whose memory is mapped with mmap(), either from a file or
+ * anonymously, to hold datasets that are larger than the memory.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MAPPED_MATRIX_HPP
+#define ENSMALLEN_PROBLEMS_MAPPED_MATRIX_HPP
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace ens {
+namespace test {
+
+/**
+ * A dense matrix of doubles held in memory mapped with mmap().  If a file name
+ * is given, the file is created (or resized) to hold the matrix and mapped,
+ * so that the operating system pages the matrix to and from the file, and the
+ * matrix can be much larger than the physical memory; the file is kept when
+ * the MappedMatrix is destroyed, and an existing file of the right size can be
+ * mapped again without being written.  Otherwise the memory is mapped
+ * anonymously, without reserving swap space, so that it is only taken when the
+ * pages are written.
+ *
+ * Matrix() is an Armadillo matrix that uses the mapped memory; it can be given
+ * to the test problems, which alias dense data instead of copying it (see
+ * AliasData()).  Its size can not be changed.  On platforms without mmap(),
+ * the matrix is allocated normally and files are not supported.
+ *
+ * @code
+ * MappedMatrix storage(100, 10000000, "predictors.bin");
+ * RandomPredictors(storage.Matrix());
+ * arma::Row<size_t> responses;
+ * arma::rowvec parameters;
+ * LogisticRegressionData(storage.Matrix(), responses, parameters);
+ * LogisticRegressionFunction<> f(storage.Matrix(), responses);
+ * @endcode
+ */
+class MappedMatrix
+{
+ public:
+  /**
+   * Map a matrix of the given size.
+   *
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   * @param filename File that holds the matrix, in column-major order (if
+   *     empty, the memory is mapped anonymously).
+   */
+  MappedMatrix(const size_t rows,
+               const size_t cols,
+               const std::string& filename = "") :
+      bytes(rows * cols * sizeof(double)),
+      memory(Map(bytes, filename)),
+      // The matrix is constructed on the mapped memory; assigning it would
+      // copy the memory.
+      matrix((memory != NULL) ? arma::mat(memory, rows, cols, false, true) :
+          arma::mat(rows, cols))
+  {
+    // Nothing to do.
+  }
+
+  //! Unmap the matrix; a file keeps its contents.
+  ~MappedMatrix()
+  {
+  #if defined(__unix__) || defined(__APPLE__)
+    // The matrix does not free the memory it does not own.
+    if (memory != NULL)
+      munmap(memory, bytes);
+  #endif
+  }
+
+  // The mapping can not be shared.
+  MappedMatrix(const MappedMatrix&) = delete;
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+  //! Get the matrix.
+  const arma::mat& Matrix() const { return matrix; }
+  //! Modify the elements of the matrix.
+  arma::mat& Matrix() { return matrix; }
+
+  //! Get whether the memory of the matrix is mapped.
+  bool Mapped() const { return memory != NULL; }
+
+ private:
+  /**
+   * Map the given number of bytes from the given file, or anonymously if the
+   * file name is empty; return NULL if nothing is mapped.
+   */
+  static double* Map(const size_t bytes, const std::string& filename)
+  {
+  #if defined(__unix__) || defined(__APPLE__)
+    if (bytes == 0)
+      return NULL;
+
+    int fd = -1;
+    if (!filename.empty())
+    {
+      fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+      if (fd == -1 || ftruncate(fd, bytes) != 0)
+      {
+        if (fd != -1)
+          close(fd);
+        Fail("cannot create the file " + filename);
+      }
+    }
+
+    #if defined(MAP_NORESERVE)
+      const int noReserve = MAP_NORESERVE;
+    #else
+      const int noReserve = 0;
+    #endif
+
+    void* address = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+        (fd == -1) ? (MAP_PRIVATE | MAP_ANON | noReserve) : MAP_SHARED, fd, 0);
+    // The mapping holds its own reference to the file.
+    if (fd != -1)
+      close(fd);
+    if (address == MAP_FAILED)
+      Fail("cannot map " + std::to_string(bytes) + " bytes");
+
+    return static_cast<double*>(address);
+  #else
+    if (!filename.empty())
+      Fail("files can not be mapped on this platform");
+    return NULL;
+  #endif
+  }
+
+  //! Throw an error about the mapping.
+  static void Fail(const std::string& reason)
+  {
+    std::ostringstream oss;
+    oss << "MappedMatrix::MappedMatrix(): " << reason << "!";
+    throw std::runtime_error(oss.str());
+  }
+
+  //! The size of the mapped memory.
+  size_t bytes;
+
+  //! The mapped memory (NULL if the matrix is allocated normally).
+  double* memory;
+
+  //! The matrix that uses the mapped memory.
+  arma::mat matrix;
+};
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file matrix_factorization_function.hpp
+ * @author Marcus Edel
+ *
+ * Low-rank factorization of a sparse matrix of observed entries (e.g. the
+ * ratings of a recommender system), a sparse separable problem for
+ * ParallelSGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * The squared error of a rank-r factorization X ~ W^T H of a matrix X with
+ * n_u rows and n_v columns, of which only some entries are observed:
+ *
+ *   f(W, H) = sum_{(u, v, x) observed} (w_u^T h_v - x)^2 +
+ *       lambda (||w_u||^2 + ||h_v||^2),
+ *
+ * where the regularization is applied with every observation, as is usual
+ * for SGD.  The coordinates are an r x (n_u + n_v) matrix, whose first n_u
+ * columns are the w_u and the others the h_v.  Each observation is one
+ * separable function, whose gradient only has the 2 r elements of the columns
+ * of its row and its column; with few observations per row and column, the
+ * updates of concurrent threads seldom touch the same coordinates, which is
+ * the setting of HOGWILD!.
+ *
+ * The gradient is given as an arma::sp_mat, or as an arma::mat for the
+ * optimizers that need a dense gradient.  The sparse gradient of a single
+ * observation is built directly in compressed sparse column form, and
+ * EvaluateWithGradient() computes the error of each observation once, for the
+ * optimizers that accumulate the objective as they go (such as ParallelSGD
+ * with accumulateObjective).  MatrixFactorizationData() generates the
+ * observations of a planted low-rank matrix.
+ */
+class MatrixFactorizationFunction
+{
+ public:
+  /**
+   * Set up the function from the observed entries of a sparse matrix; every
+   * non-zero element is one observation.
+   *
+   * @param observations Sparse matrix of the observed entries.
+   * @param rank Rank of the factorization.
+   * @param lambda Regularization parameter.
+   */
+  MatrixFactorizationFunction(const arma::sp_mat& observations,
+                              const size_t rank,
+                              const double lambda = 0.0);
+
+  /**
+   * Set up the function from the given observations.
+   *
+   * @param locations 2 x m matrix of the rows and columns of the observations.
+   * @param values The m observed values.
+   * @param numRows Number of rows of the matrix.
+   * @param numCols Number of columns of the matrix.
+   * @param rank Rank of the factorization.
+   * @param lambda Regularization parameter.
+   */
+  MatrixFactorizationFunction(const arma::umat& locations,
+                              const arma::vec& values,
+                              const size_t numRows,
+                              const size_t numCols,
+                              const size_t rank,
+                              const double lambda = 0.0);
+
+  //! Get the number of functions (observations).
+  size_t NumFunctions() const { return values.n_elem; }
+
+  //! Get the rank of the factorization.
+  size_t Rank() const { return rank; }
+  //! Get the number of rows of the matrix.
+  size_t NumRows() const { return numRows; }
+  //! Get the number of columns of the matrix.
+  size_t NumCols() const { return numCols; }
+
+  //! Get the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+
+  //! Shuffle the order of the observations.
+  void Shuffle();
+
+  /**
+   * Get a random starting point, with elements uniform in [0, scale); the
+   * factorization cannot start from zero, where the gradient vanishes.
+   */
+  arma::mat GetInitialPoint(const double scale = 0.1) const
+  {
+    return scale * arma::randu<arma::mat>(rank, numRows + numCols);
+  }
+
+  //! Evaluate the squared error of the given observations.
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize = 1) const;
+
+  //! Evaluate the squared error of all the observations.
+  double Evaluate(const arma::mat& coordinates) const;
+
+  //! Evaluate the sparse gradient of the given observations.
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::sp_mat& gradient,
+                const size_t batchSize = 1) const;
+
+  //! Evaluate the dense gradient of the given observations.
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize = 1) const;
+
+  //! Evaluate the squared error and the sparse gradient of the given
+  //! observations, computing the error of each observation once.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::sp_mat& gradient,
+                              const size_t batchSize = 1) const;
+
+  //! Evaluate the squared error and the dense gradient of the given
+  //! observations, computing the error of each observation once.
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize = 1) const;
+
+ private:
+  //! Get the error of the factorization on the i-th observation.
+  double Error(const arma::mat& coordinates, const size_t i) const
+  {
+    return arma::dot(coordinates.col(locations(0, i)),
+        coordinates.col(numRows + locations(1, i))) - values[i];
+  }
+
+  //! Get the objective of the i-th observation, given its error.
+  double Objective(const arma::mat& coordinates,
+                   const size_t i,
+                   const double error) const
+  {
+    double objective = error * error;
+    if (lambda > 0.0)
+    {
+      const size_t u = locations(0, i);
+      const size_t v = numRows + locations(1, i);
+      objective += lambda * (arma::dot(coordinates.col(u),
+          coordinates.col(u)) + arma::dot(coordinates.col(v),
+          coordinates.col(v)));
+    }
+
+    return objective;
+  }
+
+  //! The rows and columns of the observations.
+  arma::umat locations;
+
+  //! The observed values.
+  arma::vec values;
+
+  //! The number of rows of the matrix.
+  size_t numRows;
+
+  //! The number of columns of the matrix.
+  size_t numCols;
+
+  //! The rank of the factorization.
+  size_t rank;
+
+  //! The regularization parameter.
+  double lambda;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "matrix_factorization_function_impl.hpp"
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file matrix_factorization_function_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the low-rank factorization of a sparse matrix.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "matrix_factorization_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline MatrixFactorizationFunction::MatrixFactorizationFunction(
+    const arma::sp_mat& observations,
+    const size_t rank,
+    const double lambda) :
+    locations(2, observations.n_nonzero),
+    values(observations.n_nonzero),
+    numRows(observations.n_rows),
+    numCols(observations.n_cols),
+    rank(rank),
+    lambda(lambda)
+{
+  arma::sp_mat::const_iterator it = observations.begin();
+  for (size_t i = 0; it != observations.end(); ++it, ++i)
+  {
+    locations(0, i) = it.row();
+    locations(1, i) = it.col();
+    values[i] = *it;
+  }
+}
+
+inline MatrixFactorizationFunction::MatrixFactorizationFunction(
+    const arma::umat& locations,
+    const arma::vec& values,
+    const size_t numRows,
+    const size_t numCols,
+    const size_t rank,
+    const double lambda) :
+    locations(locations),
+    values(values),
+    numRows(numRows),
+    numCols(numCols),
+    rank(rank),
+    lambda(lambda)
+{
+  if (locations.n_rows != 2 || locations.n_cols != values.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "MatrixFactorizationFunction::MatrixFactorizationFunction(): "
+        << "expected a 2 x " << values.n_elem << " matrix of locations, but "
+        << "got a " << locations.n_rows << " x " << locations.n_cols
+        << " matrix!";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+inline void MatrixFactorizationFunction::Shuffle()
+{
+  const arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
+      values.n_elem - 1, values.n_elem));
+  locations = locations.cols(ordering);
+  values = values.elem(ordering);
+}
+
+inline double MatrixFactorizationFunction::Evaluate(
+    const arma::mat& coordinates,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  double objective = 0.0;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+    objective += Objective(coordinates, i, Error(coordinates, i));
+
+  return objective;
+}
+
+inline double MatrixFactorizationFunction::Evaluate(
+    const arma::mat& coordinates) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+inline void MatrixFactorizationFunction::Gradient(
+    const arma::mat& coordinates,
+    const size_t begin,
+    arma::sp_mat& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+}
+
+inline void MatrixFactorizationFunction::Gradient(
+    const arma::mat& coordinates,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+}
+
+inline double MatrixFactorizationFunction::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    const size_t begin,
+    arma::sp_mat& gradient,
+    const size_t batchSize) const
+{
+  double objective = 0.0;
+  if (batchSize == 1)
+  {
+    // The gradient of one observation only has the columns u < v, so it is
+    // built directly in compressed sparse column form, without sorting its
+    // elements.
+    const size_t u = locations(0, begin);
+    const size_t v = numRows + locations(1, begin);
+    const double error = Error(coordinates, begin);
+    objective = Objective(coordinates, begin, error);
+
+    arma::uvec rowIndices(2 * rank);
+    arma::vec gradientValues(2 * rank);
+    for (size_t d = 0; d < rank; ++d)
+    {
+      rowIndices[d] = d;
+      rowIndices[rank + d] = d;
+      gradientValues[d] = 2.0 * (error * coordinates(d, v) +
+          lambda * coordinates(d, u));
+      gradientValues[rank + d] = 2.0 * (error * coordinates(d, u) +
+          lambda * coordinates(d, v));
+    }
+
+    arma::uvec columnPointers(coordinates.n_cols + 1);
+    columnPointers.subvec(0, u).zeros();
+    columnPointers.subvec(u + 1, v).fill(rank);
+    columnPointers.subvec(v + 1, coordinates.n_cols).fill(2 * rank);
+
+    gradient = arma::sp_mat(rowIndices, columnPointers, gradientValues,
+        coordinates.n_rows, coordinates.n_cols);
+    return objective;
+  }
+
+  // The gradient is built from its 2 r elements per observation at once; the
+  // elements of the observations of a batch that share a row or a column are
+  // added.
+  arma::umat elements(2, 2 * rank * batchSize);
+  arma::vec gradientValues(2 * rank * batchSize);
+  size_t k = 0;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t u = locations(0, i);
+    const size_t v = numRows + locations(1, i);
+    const double error = Error(coordinates, i);
+    objective += Objective(coordinates, i, error);
+    for (size_t d = 0; d < rank; ++d, k += 2)
+    {
+      elements(0, k) = d;
+      elements(1, k) = u;
+      gradientValues[k] = 2.0 * (error * coordinates(d, v) +
+          lambda * coordinates(d, u));
+      elements(0, k + 1) = d;
+      elements(1, k + 1) = v;
+      gradientValues[k + 1] = 2.0 * (error * coordinates(d, u) +
+          lambda * coordinates(d, v));
+    }
+  }
+
+  gradient = arma::sp_mat(true, elements, gradientValues, coordinates.n_rows,
+      coordinates.n_cols);
+  return objective;
+}
+
+inline double MatrixFactorizationFunction::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  // Only the columns of the observations are written; zeros() keeps the
+  // memory of a gradient of the right size.
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  double objective = 0.0;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t u = locations(0, i);
+    const size_t v = numRows + locations(1, i);
+    const double error = Error(coordinates, i);
+    objective += Objective(coordinates, i, error);
+    gradient.col(u) += 2.0 * (error * coordinates.col(v) +
+        lambda * coordinates.col(u));
+    gradient.col(v) += 2.0 * (error * coordinates.col(u) +
+        lambda * coordinates.col(v));
+  }
+
+  return objective;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -18,17 +18,23 @@
 #include "generalized_rosenbrock_function.hpp"
 #include "gradient_descent_test_function.hpp"
 #include "logistic_regression_function.hpp"
+#include "mapped_dataset.hpp"
+#include "mapped_matrix.hpp"
+#include "matrix_factorization_function.hpp"
 #include "matyas_function.hpp"
 #include "mc_cormick_function.hpp"
+#include "quantized_logistic_regression_function.hpp"
 #include "rastrigin_function.hpp"
 #include "rosenbrock_function.hpp"
 #include "rosenbrock_wood_function.hpp"
 #include "schwefel_function.hpp"
+#include "sdp_generators.hpp"
 #include "sgd_test_function.hpp"
 #include "softmax_regression_function.hpp"
 #include "sparse_test_function.hpp"
 #include "sphere_function.hpp"
 #include "styblinski_tang_function.hpp"
+#include "synthetic_data.hpp"
 #include "wood_function.hpp"
 
 #endif
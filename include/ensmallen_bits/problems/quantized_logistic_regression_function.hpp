@@ -0,0 +1,141 @@
+/**
+ * @file quantized_logistic_regression_function.hpp
+ * @author Marcus Edel
+ *
+ * The logistic regression function on predictors stored in a QuantizedMatrix.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_QUANTIZED_LOGISTIC_REGRESSION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_QUANTIZED_LOGISTIC_REGRESSION_FUNCTION_HPP
+
+#include "quantized_matrix.hpp"
+
+namespace ens {
+namespace test {
+
+/**
+ * The objective of LogisticRegressionFunction, with the same parameters
+ * (the intercept, then one weight per feature) and the same regularization,
+ * on predictors quantized to 8-bit integers or half precision floats with a
+ * scale per feature (see QuantizedMatrix).  The objective and the gradient are
+ * those of the dequantized predictors; each batch is read once, by the fused
+ * kernel QuantizedMatrix::MarginGradient(), which computes the margins, the
+ * losses and the gradient in one pass.  With int8_t codes, the predictors take
+ * an eighth of the memory (and of the memory bandwidth) of a dense arma::mat.
+ *
+ * @code
+ * QuantizedLogisticRegressionFunction<int8_t> f(predictors, responses, 0.1);
+ * arma::mat coordinates = f.GetInitialPoint();
+ * SGD<> sgd;
+ * sgd.Optimize(f, coordinates);
+ * @endcode
+ *
+ * @tparam ElemType Type of the codes of the predictors (int8_t or Float16).
+ */
+template<typename ElemType = int8_t>
+class QuantizedLogisticRegressionFunction
+{
+ public:
+  /**
+   * Quantize the given predictors.
+   *
+   * @param predictors Predictors, one point per column.
+   * @param responses The 0 / 1 response of each point.
+   * @param lambda L2-regularization parameter.
+   */
+  QuantizedLogisticRegressionFunction(const arma::mat& predictors,
+                                      const arma::Row<size_t>& responses,
+                                      const double lambda = 0);
+
+  /**
+   * Use the given quantized predictors.
+   *
+   * @param predictors Quantized predictors, one point per column.
+   * @param responses The 0 / 1 response of each point.
+   * @param lambda L2-regularization parameter.
+   */
+  QuantizedLogisticRegressionFunction(
+      const QuantizedMatrix<ElemType>& predictors,
+      const arma::Row<size_t>& responses,
+      const double lambda = 0);
+
+  //! Return the regularization parameter (lambda).
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter (lambda).
+  double& Lambda() { return lambda; }
+
+  //! Return the quantized predictors.
+  const QuantizedMatrix<ElemType>& Predictors() const { return predictors; }
+  //! Return the responses, as doubles.
+  const arma::rowvec& Responses() const { return responses; }
+
+  //! Shuffle the order of the points.
+  void Shuffle();
+
+  //! Evaluate the objective on all the points.
+  double Evaluate(const arma::mat& parameters) const;
+
+  //! Evaluate the objective on the given batch of points.
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize = 1) const;
+
+  //! Evaluate the gradient on all the points.
+  void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
+
+  //! Evaluate the gradient on the given batch of points.
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize = 1) const;
+
+  //! Evaluate the objective and the gradient on all the points, in one pass.
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  //! Evaluate the objective and the gradient on the given batch of points, in
+  //! one pass.
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize = 1) const;
+
+  //! Return the initial point for the optimization (all zeros).
+  arma::mat GetInitialPoint() const
+  {
+    return arma::zeros<arma::mat>(1, predictors.NumRows() + 1);
+  }
+
+  //! Return the number of separable functions (the number of points).
+  size_t NumFunctions() const { return predictors.NumCols(); }
+
+  //! Return the number of features (add 1 for the intercept term).
+  size_t NumFeatures() const { return predictors.NumRows() + 1; }
+
+ private:
+  //! Evaluate the objective (and the gradient, if not NULL) of the given
+  //! points, with a fraction of the regularization for batchSize points.
+  double BatchObjective(const arma::mat& parameters,
+                        const size_t begin,
+                        const size_t batchSize,
+                        arma::mat* gradient) const;
+
+  //! The quantized predictors.
+  QuantizedMatrix<ElemType> predictors;
+  //! The responses, as doubles.
+  arma::rowvec responses;
+  //! The regularization parameter for L2-regularization.
+  double lambda;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "quantized_logistic_regression_function_impl.hpp"
+
+#endif
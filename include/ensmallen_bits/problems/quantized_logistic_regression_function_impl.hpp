@@ -0,0 +1,170 @@
+/**
+ * @file quantized_logistic_regression_function_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the logistic regression function on quantized predictors.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_QUANTIZED_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_QUANTIZED_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "quantized_logistic_regression_function.hpp"
+
+namespace ens {
+namespace test {
+
+template<typename ElemType>
+QuantizedLogisticRegressionFunction<ElemType>::
+QuantizedLogisticRegressionFunction(const arma::mat& predictors,
+                                    const arma::Row<size_t>& responses,
+                                    const double lambda) :
+    QuantizedLogisticRegressionFunction(QuantizedMatrix<ElemType>(predictors),
+        responses, lambda)
+{
+  // Nothing to do.
+}
+
+template<typename ElemType>
+QuantizedLogisticRegressionFunction<ElemType>::
+QuantizedLogisticRegressionFunction(
+    const QuantizedMatrix<ElemType>& predictors,
+    const arma::Row<size_t>& responses,
+    const double lambda) :
+    predictors(predictors),
+    responses(arma::conv_to<arma::rowvec>::from(responses)),
+    lambda(lambda)
+{
+  if (responses.n_elem != predictors.NumCols())
+  {
+    std::ostringstream oss;
+    oss << "QuantizedLogisticRegressionFunction::"
+        << "QuantizedLogisticRegressionFunction(): predictors matrix has "
+        << predictors.NumCols() << " points, but responses vector has "
+        << responses.n_elem << " elements!";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename ElemType>
+void QuantizedLogisticRegressionFunction<ElemType>::Shuffle()
+{
+  // Only the codes are moved, which is cheaper than shuffling dense data.
+  const arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
+      NumFunctions() - 1, NumFunctions()));
+  predictors = predictors.Cols(ordering);
+  responses = responses.cols(ordering);
+}
+
+template<typename ElemType>
+double QuantizedLogisticRegressionFunction<ElemType>::Evaluate(
+    const arma::mat& parameters) const
+{
+  return BatchObjective(parameters, 0, NumFunctions(), NULL);
+}
+
+template<typename ElemType>
+double QuantizedLogisticRegressionFunction<ElemType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  return BatchObjective(parameters, begin, batchSize, NULL);
+}
+
+template<typename ElemType>
+void QuantizedLogisticRegressionFunction<ElemType>::Gradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  BatchObjective(parameters, 0, NumFunctions(), &gradient);
+}
+
+template<typename ElemType>
+void QuantizedLogisticRegressionFunction<ElemType>::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  BatchObjective(parameters, begin, batchSize, &gradient);
+}
+
+template<typename ElemType>
+double QuantizedLogisticRegressionFunction<ElemType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  return BatchObjective(parameters, 0, NumFunctions(), &gradient);
+}
+
+template<typename ElemType>
+double QuantizedLogisticRegressionFunction<ElemType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  return BatchObjective(parameters, begin, batchSize, &gradient);
+}
+
+template<typename ElemType>
+double QuantizedLogisticRegressionFunction<ElemType>::BatchObjective(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat* gradient) const
+{
+  // The regularization of LogisticRegressionFunction, split evenly over the
+  // points.
+  const size_t numFeatures = predictors.NumRows();
+  const double scale = batchSize / (double) NumFunctions();
+  const double* weights = parameters.memptr() + 1;
+  double objective = 0.0;
+  for (size_t j = 0; j < numFeatures; ++j)
+    objective += weights[j] * weights[j];
+  objective *= 0.5 * lambda * scale;
+
+  // With e = exp(-|z|), the loss of a point with margin z and response y is
+  // max(z, 0) + log1p(e) - y z, and its derivative is sig(z) - y; neither
+  // overflows (as in LogisticRegressionFunction).
+  const double intercept = parameters[0];
+  const double* y = responses.memptr() + begin;
+  double residualSum = 0.0;
+  auto loss = [&](const size_t i, const double margin)
+  {
+    const double z = intercept + margin;
+    const double e = std::exp(-std::abs(z));
+    objective += std::max(z, 0.0) + std::log1p(e) - y[i] * z;
+    const double residual = ((z >= 0.0) ? 1.0 : e) / (1.0 + e) - y[i];
+    residualSum += residual;
+    return residual;
+  };
+
+  if (gradient == NULL)
+  {
+    arma::rowvec margins(batchSize);
+    predictors.Margins(weights, begin, batchSize, margins.memptr());
+    for (size_t i = 0; i < batchSize; ++i)
+      loss(i, margins[i]);
+    return objective;
+  }
+
+  gradient->set_size(1, numFeatures + 1);
+  predictors.MarginGradient(weights, begin, batchSize, loss,
+      gradient->memptr() + 1);
+  (*gradient)[0] = residualSum;
+  for (size_t j = 0; j < numFeatures; ++j)
+    (*gradient)[j + 1] += lambda * scale * weights[j];
+
+  return objective;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -0,0 +1,351 @@
+/**
+ * @file quantized_matrix.hpp
+ * @author Marcus Edel
+ *
+ * A dense matrix of points stored with 8-bit integers or 16-bit floats and a
+ * scale per feature, for test problems whose cost is reading their data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_QUANTIZED_MATRIX_HPP
+#define ENSMALLEN_PROBLEMS_QUANTIZED_MATRIX_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * A half precision (IEEE 754 binary16) float, stored as its bits; it is only
+ * used as the element type of QuantizedMatrix.  Conversions round to the
+ * nearest value, ties to even.
+ */
+struct Float16
+{
+  //! The bits of the float.
+  uint16_t bits;
+
+  //! Convert the given float to half precision.
+  static Float16 FromFloat(const float value)
+  {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(float));
+    const uint16_t sign = (uint16_t) ((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+
+    Float16 result;
+    if (x >= 0x7f800000)
+    {
+      // Infinity or NaN.
+      result.bits = sign | 0x7c00 | ((x > 0x7f800000) ? 0x200 : 0);
+    }
+    else if (x >= 0x477ff000)
+    {
+      // Rounds past the largest half, 65504.
+      result.bits = sign | 0x7c00;
+    }
+    else if (x < 0x38800000)
+    {
+      // Below the smallest normal half, 2^-14: the mantissa is shifted to the
+      // subnormal scale 2^-24 and rounded.
+      const uint32_t exponent = x >> 23;
+      if (exponent < 102)
+      {
+        result.bits = sign;
+        return result;
+      }
+
+      const uint32_t mantissa = (x & 0x7fffff) | 0x800000;
+      const uint32_t shift = 126 - exponent;
+      uint32_t h = mantissa >> shift;
+      const uint32_t remainder = mantissa & ((1u << shift) - 1);
+      const uint32_t half = 1u << (shift - 1);
+      if (remainder > half || (remainder == half && (h & 1)))
+        ++h;
+      result.bits = sign | (uint16_t) h;
+    }
+    else
+    {
+      // Rebias the exponent from 127 to 15; a carry of the rounding into the
+      // exponent is correct.
+      uint32_t h = (x - 0x38000000) >> 13;
+      const uint32_t remainder = x & 0x1fff;
+      if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1)))
+        ++h;
+      result.bits = sign | (uint16_t) h;
+    }
+
+    return result;
+  }
+
+  //! Convert the half to single precision (exactly).
+  float ToFloat() const
+  {
+    const uint32_t sign = uint32_t(bits & 0x8000) << 16;
+    const uint32_t exponent = (bits >> 10) & 0x1f;
+    const uint32_t mantissa = bits & 0x3ff;
+
+    uint32_t x;
+    if (exponent == 0)
+    {
+      // Zero or subnormal.
+      const float value = std::ldexp((float) mantissa, -24);
+      return (sign != 0) ? -value : value;
+    }
+    else if (exponent == 31)
+    {
+      x = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+      x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &x, sizeof(float));
+    return value;
+  }
+};
+
+//! Get the value of an 8-bit code.
+inline double Dequantize(const int8_t code) { return (double) code; }
+//! Get the value of a half precision code.
+inline double Dequantize(const Float16 code) { return code.ToFloat(); }
+
+//! Get the 8-bit code nearest to the given value in [-127, 127].
+inline void Quantize(const double value, int8_t& code)
+{
+  code = (int8_t) std::max(-127.0, std::min(127.0, std::round(value)));
+}
+
+//! Get the half precision code nearest to the given value.
+inline void Quantize(const double value, Float16& code)
+{
+  code = Float16::FromFloat((float) value);
+}
+
+//! Get the largest magnitude of the codes the features are scaled to.
+inline double QuantizedRange(const int8_t* /* codes */) { return 127.0; }
+inline double QuantizedRange(const Float16* /* codes */) { return 1.0; }
+
+/**
+ * A dense matrix of points (one per column) stored as 8-bit integers
+ * (ElemType = int8_t) or half precision floats (ElemType = Float16), with a
+ * scale per feature (row): element (j, i) is scale[j] times the code of the
+ * element.  The scale of each feature maps its largest magnitude to the
+ * largest code (127 for int8_t, 1 for Float16), so the int8_t codes have a
+ * relative error of at most 1 / 254 of the range of the feature, and the
+ * Float16 codes a relative error of at most 2^-11 of each element.  The
+ * matrix takes a quarter (int8_t) or a half (Float16) of the memory of
+ * float data, and an eighth or a quarter of that of double data.
+ *
+ * Problems that read the whole dataset at every pass are bound by the memory
+ * bandwidth, so the kernels below read each code once and convert it in
+ * registers: Margins() computes w^T x for every point of a range, and
+ * MarginGradient() computes the margin of each point, asks for the derivative
+ * of its loss, and adds its contribution to the gradient while the point is
+ * still in cache, in a single pass.  The scales are folded into the weights
+ * and into the gradient once per call, so the inner loops only see the codes.
+ *
+ * @tparam ElemType Type of the codes (int8_t or Float16).
+ */
+template<typename ElemType = int8_t>
+class QuantizedMatrix
+{
+ public:
+  //! Create an empty matrix.
+  QuantizedMatrix() : numRows(0), numCols(0) { }
+
+  /**
+   * Quantize the given matrix, one point per column.
+   *
+   * @param data Matrix to quantize.
+   */
+  QuantizedMatrix(const arma::mat& data) :
+      numRows(data.n_rows),
+      numCols(data.n_cols),
+      scales(data.n_rows, arma::fill::zeros),
+      codes(data.n_elem)
+  {
+    // The largest magnitudes are found column by column, so that the data is
+    // read in order without a temporary of its size.
+    for (size_t i = 0; i < numCols; ++i)
+    {
+      const double* point = data.colptr(i);
+      for (size_t j = 0; j < numRows; ++j)
+        scales[j] = std::max(scales[j], std::abs(point[j]));
+    }
+
+    const double range = QuantizedRange(codes.data());
+    arma::vec inverseScales(numRows);
+    for (size_t j = 0; j < numRows; ++j)
+    {
+      inverseScales[j] = (scales[j] > 0.0) ? range / scales[j] : 0.0;
+      scales[j] /= range;
+    }
+
+    for (size_t i = 0; i < numCols; ++i)
+    {
+      const double* point = data.colptr(i);
+      ElemType* pointCodes = codes.data() + i * numRows;
+      for (size_t j = 0; j < numRows; ++j)
+        Quantize(point[j] * inverseScales[j], pointCodes[j]);
+    }
+  }
+
+  //! Get the number of rows (features).
+  size_t NumRows() const { return numRows; }
+  //! Get the number of columns (points).
+  size_t NumCols() const { return numCols; }
+
+  //! Get the scale of each feature.
+  const arma::vec& Scales() const { return scales; }
+
+  //! Get the codes of the i-th point.
+  const ElemType* Point(const size_t i) const
+  {
+    return codes.data() + i * numRows;
+  }
+
+  //! Get the number of bytes taken by the codes.
+  size_t Bytes() const { return codes.size() * sizeof(ElemType); }
+
+  /**
+   * Get the given points as a dense matrix.
+   *
+   * @param begin First point.
+   * @param count Number of points.
+   */
+  arma::mat Dequantize(const size_t begin, const size_t count) const
+  {
+    arma::mat data(numRows, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const ElemType* point = Point(begin + i);
+      for (size_t j = 0; j < numRows; ++j)
+        data(j, i) = scales[j] * test::Dequantize(point[j]);
+    }
+
+    return data;
+  }
+
+  //! Get all the points as a dense matrix.
+  arma::mat Dequantize() const { return Dequantize(0, numCols); }
+
+  /**
+   * Get the matrix of the given points, in the given order, without
+   * quantizing them again.
+   *
+   * @param indices Indices of the points.
+   */
+  QuantizedMatrix Cols(const arma::uvec& indices) const
+  {
+    QuantizedMatrix result;
+    result.numRows = numRows;
+    result.numCols = indices.n_elem;
+    result.scales = scales;
+    result.codes.resize(numRows * indices.n_elem);
+    for (size_t i = 0; i < indices.n_elem; ++i)
+    {
+      std::copy(Point(indices[i]), Point(indices[i]) + numRows,
+          result.codes.data() + i * numRows);
+    }
+
+    return result;
+  }
+
+  /**
+   * Compute the margin w^T x of each of the given points.
+   *
+   * @param weights Weight of each feature.
+   * @param begin First point.
+   * @param count Number of points.
+   * @param margins The margins are stored here.
+   */
+  void Margins(const double* weights,
+               const size_t begin,
+               const size_t count,
+               double* margins) const
+  {
+    const arma::vec scaledWeights = ScaledWeights(weights);
+    const double* w = scaledWeights.memptr();
+    for (size_t i = 0; i < count; ++i)
+    {
+      const ElemType* point = Point(begin + i);
+      double margin = 0.0;
+      for (size_t j = 0; j < numRows; ++j)
+        margin += w[j] * test::Dequantize(point[j]);
+      margins[i] = margin;
+    }
+  }
+
+  /**
+   * Compute the margin w^T x of each of the given points, and store the sum of
+   * the points weighted by the derivative of their loss in gradient, in one
+   * pass over the points.  The derivative is computed by
+   * derivative(i, margin), where i is the index of the point in the range.
+   *
+   * @param weights Weight of each feature.
+   * @param begin First point.
+   * @param count Number of points.
+   * @param derivative Function that gives the derivative of the loss of a
+   *     point with respect to its margin.
+   * @param gradient The numRows elements of the weighted sum are stored here.
+   */
+  template<typename DerivativeType>
+  void MarginGradient(const double* weights,
+                      const size_t begin,
+                      const size_t count,
+                      DerivativeType derivative,
+                      double* gradient) const
+  {
+    const arma::vec scaledWeights = ScaledWeights(weights);
+    const double* w = scaledWeights.memptr();
+    std::fill(gradient, gradient + numRows, 0.0);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const ElemType* point = Point(begin + i);
+      double margin = 0.0;
+      for (size_t j = 0; j < numRows; ++j)
+        margin += w[j] * test::Dequantize(point[j]);
+
+      const double c = derivative(i, margin);
+      if (c != 0.0)
+      {
+        for (size_t j = 0; j < numRows; ++j)
+          gradient[j] += c * test::Dequantize(point[j]);
+      }
+    }
+
+    for (size_t j = 0; j < numRows; ++j)
+      gradient[j] *= scales[j];
+  }
+
+ private:
+  //! Fold the scales into the given weights.
+  arma::vec ScaledWeights(const double* weights) const
+  {
+    arma::vec scaledWeights(numRows);
+    for (size_t j = 0; j < numRows; ++j)
+      scaledWeights[j] = weights[j] * scales[j];
+    return scaledWeights;
+  }
+
+  //! The number of rows (features).
+  size_t numRows;
+
+  //! The number of columns (points).
+  size_t numCols;
+
+  //! The scale of each feature.
+  arma::vec scales;
+
+  //! The codes of the elements, in column-major order.
+  std::vector<ElemType> codes;
+};
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file sdp_generators.hpp
+ * @author Ryan Curtin
+ *
+ * Generators of random SDPs of any size (MaxCut and Lovasz-Theta relaxations of
+ * random graphs, and nuclear norm matrix completion), to benchmark the SDP
+ * solvers beyond the small graphs of the tests.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SDP_GENERATORS_HPP
+#define ENSMALLEN_PROBLEMS_SDP_GENERATORS_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * Generate an Erdos-Renyi random graph, where every edge exists with the given
+ * probability.  The edges are drawn by skipping over the absent ones with
+ * geometric jumps (Batagelj and Brandes, 2005), so the time is linear in the
+ * number of edges instead of quadratic in the number of vertices.
+ *
+ * @param vertices Number of vertices.
+ * @param edgeProbability Probability of every edge, in [0, 1].
+ * @return 2 x m matrix of the edges (i, j), with i < j.
+ */
+inline arma::umat RandomGraph(const size_t vertices,
+                              const double edgeProbability);
+
+/**
+ * Generate the MaxCut relaxation of the given graph:
+ *
+ *   min  dot(-L, X)  s.t.  X_ii = 1, i = 1, ..., n,  X >= 0,
+ *
+ * where L is the Laplacian of the graph.  There are n constraints, with one
+ * non-zero element each.
+ *
+ * @param edges 2 x m matrix of the edges.
+ * @param vertices Number of vertices.
+ * @param denseConstraints Whether to store the constraints as dense matrices
+ *     (to time the dense path of the solvers) instead of sparse ones.
+ */
+inline SDP<arma::sp_mat> GenerateMaxCutSDP(const arma::umat& edges,
+                                           const size_t vertices,
+                                           const bool denseConstraints = false);
+
+/**
+ * Generate the Lovasz-Theta SDP of the given graph:
+ *
+ *   min  dot(-J, X)  s.t.  Tr(X) = 1,  X_ij = 0 for every edge (i, j),  X >= 0,
+ *
+ * where J is the matrix of ones, so that the objective matrix is dense.  There
+ * are m + 1 constraints; the optimum is minus the Lovasz number of the graph.
+ *
+ * @param edges 2 x m matrix of the edges.
+ * @param vertices Number of vertices.
+ * @param denseConstraints Whether to store the constraints as dense matrices
+ *     instead of sparse ones.
+ */
+inline SDP<arma::mat> GenerateLovaszThetaSDP(
+    const arma::umat& edges,
+    const size_t vertices,
+    const bool denseConstraints = false);
+
+/**
+ * Generate a nuclear norm matrix completion SDP: a random rows x cols matrix M
+ * of the given rank is observed at the given number of distinct random
+ * entries, and the matrix Y of least nuclear norm that agrees with the
+ * observations is found as
+ *
+ *   min  dot(I / 2, X)  s.t.  X_{i, rows + j} = M_ij for every observed
+ *       (i, j),  X = [ W1 Y ; Y^T W2 ] >= 0.
+ *
+ * With enough observations (of the order of rank (rows + cols) log(rows +
+ * cols)), Y = M with high probability, and the optimum is the nuclear norm of
+ * M.
+ *
+ * @param rows Number of rows of M.
+ * @param cols Number of columns of M.
+ * @param rank Rank of M.
+ * @param observations Number of observed entries of M (at most rows * cols).
+ * @param m The generated matrix M is stored here.
+ * @param denseConstraints Whether to store the constraints as dense matrices
+ *     instead of sparse ones.
+ */
+inline SDP<arma::sp_mat> GenerateMatrixCompletionSDP(
+    const size_t rows,
+    const size_t cols,
+    const size_t rank,
+    const size_t observations,
+    arma::mat& m,
+    const bool denseConstraints = false);
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "sdp_generators_impl.hpp"
+
+#endif
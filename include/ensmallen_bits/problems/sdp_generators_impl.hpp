@@ -0,0 +1,226 @@
+/**
+ * @file sdp_generators_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the generators of random SDPs.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SDP_GENERATORS_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_SDP_GENERATORS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sdp_generators.hpp"
+
+#include <unordered_set>
+
+namespace ens {
+namespace test {
+
+/**
+ * Create an SDP with the given number of constraints, which are all sparse or
+ * all dense.
+ */
+template<typename ObjectiveMatrixType>
+inline SDP<ObjectiveMatrixType> EmptyGeneratedSDP(
+    const size_t n,
+    const size_t constraints,
+    const bool denseConstraints)
+{
+  return SDP<ObjectiveMatrixType>(n, denseConstraints ? 0 : constraints,
+      denseConstraints ? constraints : 0);
+}
+
+/**
+ * Set the i-th constraint of the SDP, as a sparse or a dense matrix.
+ */
+template<typename ObjectiveMatrixType>
+inline void SetGeneratedConstraint(SDP<ObjectiveMatrixType>& sdp,
+                                   const size_t i,
+                                   const arma::sp_mat& a,
+                                   const double b,
+                                   const bool denseConstraints)
+{
+  if (denseConstraints)
+  {
+    sdp.DenseA()[i] = arma::mat(a);
+    sdp.DenseB()[i] = b;
+  }
+  else
+  {
+    sdp.SparseA()[i] = a;
+    sdp.SparseB()[i] = b;
+  }
+}
+
+inline arma::umat RandomGraph(const size_t vertices,
+                              const double edgeProbability)
+{
+  if (edgeProbability < 0.0 || edgeProbability > 1.0)
+  {
+    std::ostringstream oss;
+    oss << "RandomGraph(): the edge probability must be in [0, 1], but is "
+        << edgeProbability << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  std::vector<size_t> first, second;
+  if (edgeProbability > 0.0)
+  {
+    // The pairs (w, v) with w < v are visited in order of v, then w; the
+    // number of absent pairs before the next edge is geometric.
+    const double logQ = std::log(1.0 - edgeProbability);
+    size_t v = 1;
+    size_t w = 0;
+    bool start = true;
+    while (v < vertices)
+    {
+      size_t skip = 0;
+      if (edgeProbability < 1.0)
+      {
+        const double r = arma::randu();
+        const double jump = std::floor(std::log(1.0 - r) / logQ);
+        // Any jump past the last pair ends the graph.
+        skip = (jump >= (double) vertices * vertices) ? vertices * vertices :
+            (size_t) jump;
+      }
+
+      w += skip + (start ? 0 : 1);
+      start = false;
+      while (w >= v && v < vertices)
+      {
+        w -= v;
+        ++v;
+      }
+
+      if (v < vertices)
+      {
+        first.push_back(w);
+        second.push_back(v);
+      }
+    }
+  }
+
+  arma::umat edges(2, first.size());
+  for (size_t i = 0; i < first.size(); ++i)
+  {
+    edges(0, i) = first[i];
+    edges(1, i) = second[i];
+  }
+
+  return edges;
+}
+
+inline SDP<arma::sp_mat> GenerateMaxCutSDP(const arma::umat& edges,
+                                           const size_t vertices,
+                                           const bool denseConstraints)
+{
+  SDP<arma::sp_mat> sdp = EmptyGeneratedSDP<arma::sp_mat>(vertices, vertices,
+      denseConstraints);
+
+  // C is minus the Laplacian; the duplicate locations of the batch
+  // constructor are added.
+  arma::umat locations(2, 4 * edges.n_cols);
+  arma::vec values(4 * edges.n_cols);
+  for (size_t i = 0; i < edges.n_cols; ++i)
+  {
+    const arma::uword u = edges(0, i);
+    const arma::uword v = edges(1, i);
+    locations.col(4 * i) = arma::uvec({ u, v });
+    locations.col(4 * i + 1) = arma::uvec({ v, u });
+    locations.col(4 * i + 2) = arma::uvec({ u, u });
+    locations.col(4 * i + 3) = arma::uvec({ v, v });
+    values.subvec(4 * i, 4 * i + 3) = arma::vec({ 1.0, 1.0, -1.0, -1.0 });
+  }
+  sdp.C() = arma::sp_mat(true, locations, values, vertices, vertices);
+
+  for (size_t i = 0; i < vertices; ++i)
+  {
+    arma::sp_mat a(vertices, vertices);
+    a(i, i) = 1.0;
+    SetGeneratedConstraint(sdp, i, a, 1.0, denseConstraints);
+  }
+
+  return sdp;
+}
+
+inline SDP<arma::mat> GenerateLovaszThetaSDP(const arma::umat& edges,
+                                             const size_t vertices,
+                                             const bool denseConstraints)
+{
+  SDP<arma::mat> sdp = EmptyGeneratedSDP<arma::mat>(vertices,
+      edges.n_cols + 1, denseConstraints);
+  sdp.C().ones(vertices, vertices);
+  sdp.C() *= -1.0;
+
+  SetGeneratedConstraint(sdp, 0, arma::speye<arma::sp_mat>(vertices, vertices),
+      1.0, denseConstraints);
+  for (size_t i = 0; i < edges.n_cols; ++i)
+  {
+    arma::sp_mat a(vertices, vertices);
+    a(edges(0, i), edges(1, i)) = 1.0;
+    a(edges(1, i), edges(0, i)) = 1.0;
+    SetGeneratedConstraint(sdp, i + 1, a, 0.0, denseConstraints);
+  }
+
+  return sdp;
+}
+
+inline SDP<arma::sp_mat> GenerateMatrixCompletionSDP(
+    const size_t rows,
+    const size_t cols,
+    const size_t rank,
+    const size_t observations,
+    arma::mat& m,
+    const bool denseConstraints)
+{
+  if (observations > rows * cols)
+  {
+    std::ostringstream oss;
+    oss << "GenerateMatrixCompletionSDP(): cannot observe " << observations
+        << " entries of a " << rows << " x " << cols << " matrix!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  m = arma::randn<arma::mat>(rows, rank) * arma::randn<arma::mat>(rank, cols);
+
+  const size_t n = rows + cols;
+  SDP<arma::sp_mat> sdp = EmptyGeneratedSDP<arma::sp_mat>(n, observations,
+      denseConstraints);
+  sdp.C() = 0.5 * arma::speye<arma::sp_mat>(n, n);
+
+  // Draw distinct entries by rejection; with many observations, draw the
+  // entries that are not observed instead.
+  const bool complement = (2 * observations > rows * cols);
+  const size_t draws = complement ? rows * cols - observations : observations;
+  std::unordered_set<size_t> drawn;
+  while (drawn.size() < draws)
+  {
+    drawn.insert(std::min((size_t) (arma::randu() * rows * cols),
+        rows * cols - 1));
+  }
+
+  size_t c = 0;
+  for (size_t k = 0; k < rows * cols && c < observations; ++k)
+  {
+    if ((drawn.count(k) == 1) == complement)
+      continue;
+
+    const size_t i = k % rows;
+    const size_t j = k / rows;
+    arma::sp_mat a(n, n);
+    a(i, rows + j) = 0.5;
+    a(rows + j, i) = 0.5;
+    SetGeneratedConstraint(sdp, c++, a, m(i, j), denseConstraints);
+  }
+
+  return sdp;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
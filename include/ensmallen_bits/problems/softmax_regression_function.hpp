@@ -13,10 +13,25 @@
 #ifndef ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 
+#include "data_access.hpp"
+
 namespace ens {
 namespace test {
 
-class SoftmaxRegressionFunction
+/**
+ * The objective function of softmax regression, the negative log-likelihood
+ * plus L2-regularization.  The data may be dense (arma::mat) or sparse
+ * (arma::sp_mat); sparse data is never converted to a dense matrix.
+ *
+ * The points are processed in blocks, so that the scores of a block stay in
+ * cache: the log-sum-exp and the probabilities of each point are computed in
+ * place, and the gradient is accumulated block by block.  Neither the
+ * probabilities of all the points nor the ground truth matrix are formed.
+ *
+ * @tparam MatType Type of the data matrix.
+ */
+template<typename MatType = arma::mat>
+class SoftmaxRegressionFunctionType
 {
  public:
   /**
@@ -29,12 +44,15 @@ class SoftmaxRegressionFunction
    * @param numClasses Number of classes for classification.
    * @param lambda L2-regularization constant.
    * @param fitIntercept Intercept term flag.
+   * @param blockSize Number of points processed at once; 0 chooses it so that
+   *     the scores of a block fit in 256 kB.
    */
-  SoftmaxRegressionFunction(const arma::mat& data,
-                            const arma::Row<size_t>& labels,
-                            const size_t numClasses,
-                            const double lambda = 0.0001,
-                            const bool fitIntercept = false);
+  SoftmaxRegressionFunctionType(const MatType& data,
+                                const arma::Row<size_t>& labels,
+                                const size_t numClasses,
+                                const double lambda = 0.0001,
+                                const bool fitIntercept = false,
+                                const size_t blockSize = 0);
 
   //! Initializes the parameters of the model to suitable values.
   const arma::mat InitializeWeights();
@@ -149,6 +167,32 @@ class SoftmaxRegressionFunction
                 arma::mat& gradient,
                 const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the objective function and its gradient given the current set of
+   * parameters, in a single pass over the data.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return The objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the objective function and its gradient given the current set of
+   * parameters, on a subset of the data, in a single pass.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param gradient Matrix to store gradient into.
+   * @param batchSize Number of data points to use.
+   * @return The objective function on the given data points.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t start,
+                              arma::mat& gradient,
+                              const size_t batchSize = 1) const;
+
   /**
    * Evaluates the gradient values of the objective function given the current
    * set of parameters for a single feature indexed by j.
@@ -162,6 +206,19 @@ class SoftmaxRegressionFunction
                        size_t j,
                        arma::sp_mat& gradient) const;
 
+  /**
+   * Evaluates the gradient values of the objective function for a single
+   * feature indexed by j, storing only the non-zero column.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param j The index of the feature with respect to which the partial
+   *    gradient is to be computed.
+   * @param gradient Out param for the gradient column.
+   */
+  void PartialGradient(const arma::mat& parameters,
+                       size_t j,
+                       arma::vec& gradient) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -182,11 +239,41 @@ class SoftmaxRegressionFunction
   //! Gets the intercept flag.
   bool FitIntercept() const { return fitIntercept; }
 
+  //! Get the number of points processed at once (0 means automatic).
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of points processed at once (0 means automatic).
+  size_t& BlockSize() { return blockSize; }
+
  private:
-  //! Training data matrix.  This is an alias until the data is shuffled.
-  arma::mat data;
-  //! Label matrix for the provided data.
-  arma::sp_mat groundTruth;
+  //! Get the number of points of a block.
+  size_t BlockPoints() const;
+
+  /**
+   * Overwrite scores with the probabilities of the points begin to end
+   * (inclusive) minus their class indicators, and add the negative log
+   * likelihood of the points to loss.
+   */
+  void BlockResiduals(const arma::mat& parameters,
+                      const size_t begin,
+                      const size_t end,
+                      arma::mat& scores,
+                      double& loss) const;
+
+  /**
+   * Return the mean negative log likelihood of the given points, and
+   * accumulate the unscaled gradient of the log likelihood into gradient if it
+   * is not NULL.
+   */
+  double BlockedObjective(const arma::mat& parameters,
+                          const size_t start,
+                          const size_t batchSize,
+                          arma::mat* gradient) const;
+
+  //! Training data matrix.  This is an alias until the data is shuffled (if
+  //! it is dense).
+  MatType data;
+  //! Labels of the data.  This is an alias until the data is shuffled.
+  arma::Row<size_t> labels;
   //! Initial parameter point.
   arma::mat initialPoint;
   //! Number of classes.
@@ -195,8 +282,13 @@ class SoftmaxRegressionFunction
   double lambda;
   //! Intercept term flag.
   bool fitIntercept;
+  //! Number of points processed at once (0 means automatic).
+  size_t blockSize;
 };
 
+//! The softmax regression function for dense data.
+using SoftmaxRegressionFunction = SoftmaxRegressionFunctionType<arma::mat>;
+
 } // namespace test
 } // namespace ens
 
@@ -18,61 +18,58 @@
 namespace ens {
 namespace test {
 
-inline SoftmaxRegressionFunction::SoftmaxRegressionFunction(
-    const arma::mat& data,
+template<typename MatType>
+SoftmaxRegressionFunctionType<MatType>::SoftmaxRegressionFunctionType(
+    const MatType& data,
     const arma::Row<size_t>& labels,
     const size_t numClasses,
     const double lambda,
-    const bool fitIntercept) :
-    data(arma::mat(const_cast<arma::mat&>(data).memptr(), data.n_rows,
-      data.n_cols, false, false)),
+    const bool fitIntercept,
+    const size_t blockSize) :
+    data(AliasData(data)),
+    // We promise to be well-behaved... the elements won't be modified.
+    labels(arma::Row<size_t>(const_cast<arma::Row<size_t>&>(labels).memptr(),
+        labels.n_elem, false, false)),
     numClasses(numClasses),
     lambda(lambda),
-    fitIntercept(fitIntercept)
+    fitIntercept(fitIntercept),
+    blockSize(blockSize)
 {
+  // Sanity check: the labels are used as indices of the classes.
+  if (labels.n_elem != data.n_cols ||
+      (labels.n_elem > 0 && labels.max() >= numClasses))
+  {
+    std::ostringstream oss;
+    oss << "SoftmaxRegressionFunction::SoftmaxRegressionFunction(): "
+        << "there must be one label in [0, " << numClasses << ") for each of "
+        << "the " << data.n_cols << " points!" << std::endl;
+    throw std::logic_error(oss.str());
+  }
+
   // Initialize the parameters to suitable values.
   initialPoint = InitializeWeights();
-
-  // Calculate the label matrix.
-  GetGroundTruthMatrix(labels, groundTruth);
 }
 
 /**
  * Shuffle the data.
  */
-inline void SoftmaxRegressionFunction::Shuffle()
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Shuffle()
 {
   // Determine new ordering.
   arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
       data.n_cols - 1, data.n_cols));
 
   // Re-sort data.
-  arma::mat newData = data.cols(ordering);
-  if (data.mem_state >= 1)
-    data.reset();
+  MatType newData = GatherColumns(data, ordering);
+  ReleaseData(data);
   data = std::move(newData);
 
-  // Assemble data for batch constructor.  We need reverse orderings though...
-  arma::uvec reverseOrdering(ordering.n_elem);
-  for (size_t i = 0; i < ordering.n_elem; ++i)
-    reverseOrdering[ordering[i]] = i;
-
-  arma::umat newLocations(2, groundTruth.n_nonzero);
-  arma::vec values(groundTruth.n_nonzero);
-  arma::sp_mat::const_iterator it = groundTruth.begin();
-  size_t loc = 0;
-  while (it != groundTruth.end())
-  {
-    newLocations(0, loc) = reverseOrdering(it.col());
-    newLocations(1, loc) = it.row();
-    values(loc) = (*it);
-
-    ++it;
-    ++loc;
-  }
-
-  groundTruth = arma::sp_mat(newLocations, values, groundTruth.n_rows,
-      groundTruth.n_cols);
+  // If the labels are an alias, make sure we don't write to the original data.
+  arma::Row<size_t> newLabels = labels.cols(ordering);
+  if (labels.mem_state >= 1)
+    labels.reset();
+  labels = std::move(newLabels);
 }
 
 /**
@@ -80,12 +77,14 @@ inline void SoftmaxRegressionFunction::Shuffle()
  * normal distribution. The weights cannot be initialized to zero, as that will
  * lead to each class output being the same.
  */
-inline const arma::mat SoftmaxRegressionFunction::InitializeWeights()
+template<typename MatType>
+const arma::mat SoftmaxRegressionFunctionType<MatType>::InitializeWeights()
 {
   return InitializeWeights(data.n_rows, numClasses, fitIntercept);
 }
 
-inline const arma::mat SoftmaxRegressionFunction::InitializeWeights(
+template<typename MatType>
+const arma::mat SoftmaxRegressionFunctionType<MatType>::InitializeWeights(
     const size_t featureSize,
     const size_t numClasses,
     const bool fitIntercept)
@@ -95,7 +94,8 @@ inline const arma::mat SoftmaxRegressionFunction::InitializeWeights(
     return parameters;
 }
 
-inline void SoftmaxRegressionFunction::InitializeWeights(
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::InitializeWeights(
     arma::mat &weights,
     const size_t featureSize,
     const size_t numClasses,
@@ -116,7 +116,8 @@ inline void SoftmaxRegressionFunction::InitializeWeights(
  * labels. The output is in the form of a matrix, which leads to simpler
  * calculations in the Evaluate() and Gradient() methods.
  */
-inline void SoftmaxRegressionFunction::GetGroundTruthMatrix(
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::GetGroundTruthMatrix(
     const arma::Row<size_t>& labels, arma::sp_mat& groundTruth)
 {
   // Calculate the ground truth matrix according to the labels passed. The
@@ -149,7 +150,8 @@ inline void SoftmaxRegressionFunction::GetGroundTruthMatrix(
  * Evaluate the probabilities matrix. If fitIntercept flag is true,
  * it should consider the parameters.cols(0) intercept term.
  */
-inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::GetProbabilitiesMatrix(
     const arma::mat& parameters,
     arma::mat& probabilities,
     const size_t start,
@@ -180,163 +182,214 @@ inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
                                             numClasses, 1);
 }
 
+template<typename MatType>
+size_t SoftmaxRegressionFunctionType<MatType>::BlockPoints() const
+{
+  // By default, make a block of scores fit in 256 kB, in the L2 cache.
+  if (blockSize > 0)
+    return blockSize;
+
+  return std::max<size_t>(1, 32768 / std::max<size_t>(1, numClasses));
+}
+
 /**
- * Evaluates the objective function given the parameters.
+ * Compute the scores of the given points, then overwrite each score with the
+ * difference between the probability of the class and its indicator, and add
+ * the negative log likelihood of the points to the loss.  The log-sum-exp is
+ * computed in place, after subtracting the largest score of each point.
  */
-inline double SoftmaxRegressionFunction::Evaluate(
-    const arma::mat& parameters) const
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::BlockResiduals(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t end,
+    arma::mat& scores,
+    double& loss) const
 {
-  // The objective function is the negative log likelihood of the model
-  // calculated over all the training examples. Mathematically it is as follows:
-  // log likelihood = sum(1{y_i = j} * log(probability(j))) / m
-  // The sum is over all 'i's and 'j's, where 'i' points to a training example
-  // and 'j' points to a particular class. 1{x} is an indicator function whose
-  // value is 1 only when 'x' is satisfied, otherwise it is 0.
-  // 'm' is the number of training examples.
-  // The cost also takes into account the regularization to control the
-  // parameter weights.
+  if (fitIntercept)
+  {
+    scores = parameters.cols(1, parameters.n_cols - 1) *
+        data.cols(begin, end);
+    scores.each_col() += parameters.col(0);
+  }
+  else
+  {
+    scores = parameters * data.cols(begin, end);
+  }
 
-  // Calculate the class probabilities for each training example. The
-  // probabilities for each of the classes are given by:
-  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
-  // The sum is calculated over all the classes.
-  // x_i is the input vector for a particular training example.
-  // theta_j is the parameter vector associated with a particular class.
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  for (size_t i = 0; i < scores.n_cols; ++i)
+  {
+    double* score = scores.colptr(i);
+    const size_t label = labels(begin + i);
 
-  // Calculate the log likelihood and regularization terms.
-  double logLikelihood, weightDecay, cost;
+    double maxScore = score[0];
+    for (size_t c = 1; c < numClasses; ++c)
+      maxScore = std::max(maxScore, score[c]);
 
-  logLikelihood = arma::accu(groundTruth % arma::log(probabilities)) /
-                  data.n_cols;
-  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
+    const double labelScore = score[label] - maxScore;
+    double sum = 0.0;
+    for (size_t c = 0; c < numClasses; ++c)
+    {
+      score[c] = std::exp(score[c] - maxScore);
+      sum += score[c];
+    }
 
-  // The cost is the sum of the negative log likelihood and the regularization
-  // terms.
-  cost = -logLikelihood + weightDecay;
+    loss += std::log(sum) - labelScore;
 
-  return cost;
+    const double scale = 1.0 / sum;
+    for (size_t c = 0; c < numClasses; ++c)
+      score[c] *= scale;
+    score[label] -= 1.0;
+  }
 }
 
 /**
- * Evaluate the objective function for the given points given the parameters.
+ * Process the given points block by block; the objective (without the
+ * regularization) is returned, and the gradient is accumulated if it is given.
  */
-inline double SoftmaxRegressionFunction::Evaluate(
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::BlockedObjective(
     const arma::mat& parameters,
     const size_t start,
-    const size_t batchSize) const
+    const size_t batchSize,
+    arma::mat* gradient) const
 {
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, start, batchSize);
+  const size_t block = BlockPoints();
 
-  // Calculate the log likelihood and regularization terms.
-  double logLikelihood, weightDecay;
+  if (gradient)
+    gradient->zeros(parameters.n_rows, parameters.n_cols);
 
-  logLikelihood = arma::accu(groundTruth.cols(start, start + batchSize - 1) %
-      arma::log(probabilities)) / batchSize;
-  weightDecay = 0.5 * lambda * arma::accu(parameters * parameters);
+  arma::mat scores;
+  double loss = 0.0;
+  for (size_t begin = start; begin < start + batchSize; begin += block)
+  {
+    const size_t end = std::min(begin + block, start + batchSize) - 1;
+    BlockResiduals(parameters, begin, end, scores, loss);
 
-  return -logLikelihood + weightDecay;
+    if (gradient && fitIntercept)
+    {
+      gradient->col(0) += arma::sum(scores, 1);
+      gradient->cols(1, parameters.n_cols - 1) +=
+          scores * data.cols(begin, end).t();
+    }
+    else if (gradient)
+    {
+      *gradient += scores * data.cols(begin, end).t();
+    }
+  }
+
+  return loss / batchSize;
+}
+
+/**
+ * Evaluates the objective function given the parameters.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::Evaluate(
+    const arma::mat& parameters) const
+{
+  return Evaluate(parameters, 0, data.n_cols);
+}
+
+/**
+ * Evaluate the objective function for the given points given the parameters.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t start,
+    const size_t batchSize) const
+{
+  // The objective function is the negative log likelihood of the model
+  // calculated over the training examples, plus the regularization of the
+  // parameter weights.
+  return BlockedObjective(parameters, start, batchSize, NULL) +
+      0.5 * lambda * arma::accu(parameters % parameters);
 }
 
 /**
  * Calculates and stores the gradient values given a set of parameters.
  */
-inline void SoftmaxRegressionFunction::Gradient(
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
     const arma::mat& parameters, arma::mat& gradient) const
 {
-  // Calculate the class probabilities for each training example. The
-  // probabilities for each of the classes are given by:
-  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
-  // The sum is calculated over all the classes.
-  // x_i is the input vector for a particular training example.
-  // theta_j is the parameter vector associated with a particular class.
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
-
-  // Calculate the parameter gradients.
-  gradient.set_size(parameters.n_rows, parameters.n_cols);
-  if (fitIntercept)
-  {
-    // Treating the intercept term parameters.col(0) seperately to avoid
-    // the cost of building matrix [1; data].
-    arma::mat inner = probabilities - groundTruth;
-    gradient.col(0) =
-      inner * arma::ones<arma::mat>(data.n_cols, 1) / data.n_cols +
-      lambda * parameters.col(0);
-    gradient.cols(1, parameters.n_cols - 1) =
-      inner * data.t() / data.n_cols +
-      lambda * parameters.cols(1, parameters.n_cols - 1);
-  }
-  else
-  {
-    gradient = (probabilities - groundTruth) * data.t() / data.n_cols +
-               lambda * parameters;
-  }
+  EvaluateWithGradient(parameters, 0, gradient, data.n_cols);
 }
 
-inline void SoftmaxRegressionFunction::Gradient(
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
     const arma::mat& parameters,
     const size_t start,
     arma::mat& gradient,
     const size_t batchSize) const
 {
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, start, batchSize);
+  EvaluateWithGradient(parameters, start, gradient, batchSize);
+}
 
-  // Calculate the parameter gradients.
-  gradient.set_size(parameters.n_rows, parameters.n_cols);
-  if (fitIntercept)
-  {
-    arma::mat inner = probabilities - groundTruth.cols(start, start +
-        batchSize - 1);
-    gradient.col(0) =
-        inner * arma::ones<arma::mat>(batchSize, 1) / batchSize +
-        lambda * parameters.col(0);
-    gradient.cols(1, parameters.n_cols - 1) =
-        inner * data.cols(start, start + batchSize - 1).t() / batchSize +
-        lambda * parameters.cols(1, parameters.n_cols - 1);
-  }
-  else
-  {
-    gradient = (probabilities - groundTruth.cols(start, start + batchSize - 1))
-        * data.cols(start, start + batchSize - 1).t() / batchSize
-        + lambda * parameters;
-  }
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters, arma::mat& gradient) const
+{
+  return EvaluateWithGradient(parameters, 0, gradient, data.n_cols);
 }
 
-inline void SoftmaxRegressionFunction::PartialGradient(
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t start,
+    arma::mat& gradient,
+    const size_t batchSize) const
+{
+  const double objective = BlockedObjective(parameters, start, batchSize,
+      &gradient);
+
+  gradient /= batchSize;
+  gradient += lambda * parameters;
+
+  return objective + 0.5 * lambda * arma::accu(parameters % parameters);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::PartialGradient(
     const arma::mat& parameters,
     const size_t j,
     arma::sp_mat& gradient) const
 {
+  arma::vec column;
+  PartialGradient(parameters, j, column);
+
   gradient.zeros(arma::size(parameters));
+  gradient.col(j) = column;
+}
 
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::PartialGradient(
+    const arma::mat& parameters,
+    const size_t j,
+    arma::vec& gradient) const
+{
+  const size_t block = BlockPoints();
 
-  // Calculate the required part of the gradient.
-  arma::mat inner = probabilities - groundTruth;
-  if (fitIntercept)
+  // Only the feature j of the data is needed for the gradient.
+  gradient.zeros(numClasses);
+  arma::mat scores;
+  double loss = 0.0;
+  for (size_t begin = 0; begin < data.n_cols; begin += block)
   {
-    if (j == 0)
-    {
-      gradient.col(j) =
-          inner * arma::ones<arma::mat>(data.n_cols, 1) / data.n_cols +
-          lambda * parameters.col(0);
-    }
+    const size_t end = std::min(begin + block, (size_t) data.n_cols) - 1;
+    BlockResiduals(parameters, begin, end, scores, loss);
+
+    if (fitIntercept && j == 0)
+      gradient += arma::sum(scores, 1);
+    else if (fitIntercept)
+      gradient += scores * data.submat(j - 1, begin, j - 1, end).t();
     else
-    {
-      gradient.col(j) = inner * data.row(j).t() / data.n_cols + lambda *
-          parameters.col(j);
-    }
-  }
-  else
-  {
-    gradient.col(j) = inner * data.row(j).t() / data.n_cols + lambda *
-        parameters.col(j);
+      gradient += scores * data.submat(j, begin, j, end).t();
   }
+
+  gradient /= data.n_cols;
+  gradient += lambda * parameters.col(j);
 }
 
 } // namespace test
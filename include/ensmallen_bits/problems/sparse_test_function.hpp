@@ -32,6 +32,10 @@ class SparseTestFunction
   //! Return 4 (the number of features).
   size_t NumFeatures() const { return 4; }
 
+  //! Shuffle the order of function visitation.  Every function touches its own
+  //! dimension only, so the order does not matter and nothing is done.
+  void Shuffle() { }
+
   //! Get the starting point.
   arma::mat GetInitialPoint() const { return arma::mat("0 0 0 0;"); }
 
@@ -54,6 +58,19 @@ class SparseTestFunction
                        const size_t j,
                        arma::sp_mat& gradient) const;
 
+  //! Evaluate the non-zero column of the gradient of a feature function.
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::vec& gradient) const;
+
+  //! Get the features whose partial gradient depends on feature j; every
+  //! feature is independent, so this is only j.
+  void AffectedFeatures(const size_t j, arma::uvec& affected) const
+  {
+    affected.set_size(1);
+    affected(0) = j;
+  }
+
  private:
   // Each quadratic polynomial is monic. The intercept and coefficient of the
   // first order term is stored.
@@ -73,6 +73,15 @@ inline void SparseTestFunction::PartialGradient(const arma::mat& coordinates,
   gradient[j] = 2 * coordinates[j] + bi[j];
 }
 
+//! Evaluate the non-zero column of the gradient of a feature function.
+inline void SparseTestFunction::PartialGradient(const arma::mat& coordinates,
+                                                const size_t j,
+                                                arma::vec& gradient) const
+{
+  gradient.set_size(1);
+  gradient[0] = 2 * coordinates[j] + bi[j];
+}
+
 } // namespace test
 } // namespace ens
 
@@ -0,0 +1,173 @@
+/**
+ * @file synthetic_data.hpp
+ * @author Marcus Edel
+ *
+ * Generators of synthetic datasets of any size for the regression test
+ * problems, drawn from planted models whose parameters are known.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SYNTHETIC_DATA_HPP
+#define ENSMALLEN_PROBLEMS_SYNTHETIC_DATA_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * The generators below write the datasets in place, in blocks of columns that
+ * are generated in parallel with OpenMPExecutor.  Every block draws from its
+ * own stream of RandomGenerator for the given seed, so a dataset only depends
+ * on its size and its seed, not on the number of threads; datasets of 10^7 or
+ * more points can be generated directly into a MappedMatrix without any copy.
+ *
+ * The predictors are drawn first with RandomPredictors(); then the responses
+ * are drawn from a planted model with known parameters:
+ *
+ *  - LogisticRegressionData(): the responses of LogisticRegressionFunction,
+ *    with P(y = 1 | x) = sigmoid(b + w^T x);
+ *  - SoftmaxRegressionData(): the labels of SoftmaxRegressionFunction (with an
+ *    intercept), with P(y = k | x) proportional to exp(b_k + w_k^T x);
+ *  - LinearRegressionData(): real responses y = b + w^T x + noise.
+ *
+ * MatrixFactorizationData() draws the observed entries of a planted low-rank
+ * ratings matrix for MatrixFactorizationFunction instead.
+ *
+ * The planted parameters are the minimizers of the expected unregularized
+ * loss of each model, so the minimizer of the loss on the dataset tends to
+ * them as the number of points grows (with an error of order
+ * 1 / sqrt(points)); for linear regression without noise they are the exact
+ * minimizer.  The softmax parameters are only defined up to a common shift of
+ * all the classes, so the planted ones sum to zero over the classes.  The
+ * parameters are scaled so that the margins (or the signal of the linear
+ * model) have the given standard deviation, which sets how separable the
+ * classes are.
+ */
+
+/**
+ * Fill the given dense matrix (whose size is already set, as that of a
+ * MappedMatrix) with standard normal predictors, one point per column.
+ *
+ * @param predictors Matrix to fill.
+ * @param seed Seed of the dataset.
+ */
+inline void RandomPredictors(arma::mat& predictors, const uint64_t seed = 0);
+
+/**
+ * Generate a sparse matrix of predictors with the given number of non-zero
+ * standard normal elements in every column, at distinct random rows.  The
+ * matrix is built directly in compressed sparse column form.
+ *
+ * @param predictors Matrix to store the predictors in.
+ * @param dimensions Number of rows (dimensions of the points).
+ * @param points Number of columns (points).
+ * @param nonZeros Number of non-zero elements per point (at most dimensions).
+ * @param seed Seed of the dataset.
+ */
+inline void RandomPredictors(arma::sp_mat& predictors,
+                             const size_t dimensions,
+                             const size_t points,
+                             const size_t nonZeros,
+                             const uint64_t seed = 0);
+
+/**
+ * Draw the responses of a logistic regression model with random planted
+ * parameters (in the layout of LogisticRegressionFunction: the intercept,
+ * then the weights).
+ *
+ * @param predictors Dense or sparse predictors, one point per column.
+ * @param responses The 0 / 1 responses are stored here.
+ * @param parameters The planted parameters are stored here.
+ * @param scale Standard deviation of the margins.
+ * @param seed Seed of the dataset.
+ */
+template<typename MatType>
+void LogisticRegressionData(const MatType& predictors,
+                            arma::Row<size_t>& responses,
+                            arma::rowvec& parameters,
+                            const double scale = 2.0,
+                            const uint64_t seed = 0);
+
+/**
+ * Draw the labels of a softmax regression model with random planted
+ * parameters (in the layout of SoftmaxRegressionFunction with an intercept:
+ * one row per class, whose first column is the intercept).
+ *
+ * @param predictors Dense or sparse predictors, one point per column.
+ * @param classes Number of classes.
+ * @param labels The labels in [0, classes) are stored here.
+ * @param parameters The planted parameters are stored here.
+ * @param scale Standard deviation of the scores of each class.
+ * @param seed Seed of the dataset.
+ */
+template<typename MatType>
+void SoftmaxRegressionData(const MatType& predictors,
+                           const size_t classes,
+                           arma::Row<size_t>& labels,
+                           arma::mat& parameters,
+                           const double scale = 2.0,
+                           const uint64_t seed = 0);
+
+/**
+ * Draw the responses of a linear model with random planted parameters (the
+ * intercept, then the weights) and Gaussian noise.
+ *
+ * @param predictors Dense or sparse predictors, one point per column.
+ * @param responses The real responses are stored here.
+ * @param parameters The planted parameters are stored here.
+ * @param noise Standard deviation of the noise.
+ * @param scale Standard deviation of the signal.
+ * @param seed Seed of the dataset.
+ */
+template<typename MatType>
+void LinearRegressionData(const MatType& predictors,
+                          arma::rowvec& responses,
+                          arma::rowvec& parameters,
+                          const double noise = 0.0,
+                          const double scale = 1.0,
+                          const uint64_t seed = 0);
+
+/**
+ * Draw the observed entries of a random users x items ratings matrix of rank r
+ * with Gaussian noise, for MatrixFactorizationFunction.  Every user rates the
+ * given number of items (drawn with replacement), with a popularity skew: the
+ * item of a rating is floor(items * u^skew) for u uniform in [0, 1), so a skew
+ * of 1 draws the items uniformly, and larger skews make the first items much
+ * more popular, so that concurrent updates collide more often.  The ratings are
+ * ordered by user.  The planted coordinates are in the layout of
+ * MatrixFactorizationFunction (the r x users factors of the users, then the
+ * r x items factors of the items), scaled so that the ratings without noise
+ * have unit variance.
+ *
+ * @param users Number of users (rows of the matrix).
+ * @param items Number of items (columns of the matrix).
+ * @param perUser Number of ratings of every user.
+ * @param rank Rank of the matrix.
+ * @param locations The 2 x (users * perUser) users and items of the ratings
+ *     are stored here.
+ * @param values The ratings are stored here.
+ * @param parameters The planted coordinates are stored here.
+ * @param skew Popularity skew of the items (at least 1).
+ * @param noise Standard deviation of the noise.
+ * @param seed Seed of the dataset.
+ */
+inline void MatrixFactorizationData(const size_t users,
+                                    const size_t items,
+                                    const size_t perUser,
+                                    const size_t rank,
+                                    arma::umat& locations,
+                                    arma::vec& values,
+                                    arma::mat& parameters,
+                                    const double skew = 1.0,
+                                    const double noise = 0.0,
+                                    const uint64_t seed = 0);
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "synthetic_data_impl.hpp"
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file synthetic_data_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the generators of synthetic datasets.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SYNTHETIC_DATA_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_SYNTHETIC_DATA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "synthetic_data.hpp"
+
+namespace ens {
+namespace test {
+
+//! Number of points generated by each task.
+static const size_t syntheticBlockSize = 16384;
+
+//! Streams of the random numbers of the responses and of the parameters;
+//! block b of the predictors uses stream b.
+static const uint64_t syntheticResponseStream = uint64_t(1) << 40;
+static const uint64_t syntheticParameterStream = uint64_t(1) << 48;
+
+/**
+ * Run the given function on every block of syntheticBlockSize points, in
+ * parallel.  The function takes the index of the block and its first and last
+ * points.
+ */
+template<typename BlockFunctionType>
+inline void ForEachSyntheticBlock(const size_t points, BlockFunctionType block)
+{
+  const size_t blocks = (points + syntheticBlockSize - 1) / syntheticBlockSize;
+  OpenMPExecutor().Run(blocks, [&](const size_t b)
+  {
+    block(b, b * syntheticBlockSize,
+        std::min((b + 1) * syntheticBlockSize, points) - 1);
+  });
+}
+
+//! Get the number of non-zero predictors per point.
+inline double SyntheticNonZeros(const arma::mat& predictors)
+{
+  return (double) predictors.n_rows;
+}
+
+//! Get the average number of non-zero predictors per point.
+inline double SyntheticNonZeros(const arma::sp_mat& predictors)
+{
+  return (predictors.n_cols == 0) ? 0.0 :
+      (double) predictors.n_nonzero / predictors.n_cols;
+}
+
+/**
+ * Draw planted parameters with an intercept in the first column, scaled so
+ * that the margins of standard normal predictors have the given standard
+ * deviation (split evenly between the intercept and the weights).
+ */
+template<typename MatType>
+inline arma::mat PlantedParameters(const MatType& predictors,
+                                   const size_t rows,
+                                   const double scale,
+                                   const uint64_t seed)
+{
+  arma::mat parameters(rows, predictors.n_rows + 1);
+  RandomGenerator generator(seed, syntheticParameterStream);
+  generator.Randn(parameters);
+
+  const double nonZeros = std::max(SyntheticNonZeros(predictors), 1.0);
+  parameters.col(0) *= scale / std::sqrt(2.0);
+  parameters.cols(1, parameters.n_cols - 1) *= scale / std::sqrt(2.0 *
+      nonZeros);
+  return parameters;
+}
+
+inline void RandomPredictors(arma::mat& predictors, const uint64_t seed)
+{
+  ForEachSyntheticBlock(predictors.n_cols, [&](const size_t b,
+      const size_t begin, const size_t end)
+  {
+    // The block is an alias of the columns of the predictors.
+    arma::mat block(predictors.colptr(begin), predictors.n_rows,
+        end - begin + 1, false, true);
+    RandomGenerator generator(seed, b);
+    generator.Randn(block);
+  });
+}
+
+inline void RandomPredictors(arma::sp_mat& predictors,
+                             const size_t dimensions,
+                             const size_t points,
+                             const size_t nonZeros,
+                             const uint64_t seed)
+{
+  if (nonZeros > dimensions)
+  {
+    std::ostringstream oss;
+    oss << "RandomPredictors(): cannot draw " << nonZeros << " non-zero "
+        << "elements per point in " << dimensions << " dimensions!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Every column has the same number of non-zero elements, so the layout of
+  // the compressed columns is known before they are drawn.
+  arma::uvec rowIndices(points * nonZeros);
+  arma::vec values(points * nonZeros);
+  arma::uvec columnPointers(points + 1);
+  for (size_t j = 0; j <= points; ++j)
+    columnPointers[j] = j * nonZeros;
+
+  ForEachSyntheticBlock(points, [&](const size_t b, const size_t begin,
+      const size_t end)
+  {
+    RandomGenerator generator(seed, b);
+    for (size_t j = begin; j <= end; ++j)
+    {
+      // Floyd's algorithm draws distinct rows.
+      arma::uword* rows = rowIndices.memptr() + j * nonZeros;
+      for (size_t k = 0; k < nonZeros; ++k)
+      {
+        const size_t limit = dimensions - nonZeros + k;
+        const arma::uword t = generator.Integer(limit + 1);
+        rows[k] = (std::find(rows, rows + k, t) == rows + k) ? t : limit;
+      }
+      std::sort(rows, rows + nonZeros);
+
+      for (size_t k = 0; k < nonZeros; ++k)
+        values[j * nonZeros + k] = generator.Normal();
+    }
+  });
+
+  predictors = arma::sp_mat(rowIndices, columnPointers, values, dimensions,
+      points);
+}
+
+template<typename MatType>
+void LogisticRegressionData(const MatType& predictors,
+                            arma::Row<size_t>& responses,
+                            arma::rowvec& parameters,
+                            const double scale,
+                            const uint64_t seed)
+{
+  parameters = PlantedParameters(predictors, 1, scale, seed);
+
+  responses.set_size(predictors.n_cols);
+  ForEachSyntheticBlock(predictors.n_cols, [&](const size_t b,
+      const size_t begin, const size_t end)
+  {
+    const arma::rowvec margins = parameters[0] +
+        parameters.tail_cols(predictors.n_rows) *
+        MatType(predictors.cols(begin, end));
+    RandomGenerator generator(seed, syntheticResponseStream + b);
+    for (size_t i = 0; i < margins.n_elem; ++i)
+    {
+      responses[begin + i] =
+          (generator.Uniform() < 1.0 / (1.0 + std::exp(-margins[i]))) ? 1 : 0;
+    }
+  });
+}
+
+template<typename MatType>
+void SoftmaxRegressionData(const MatType& predictors,
+                           const size_t classes,
+                           arma::Row<size_t>& labels,
+                           arma::mat& parameters,
+                           const double scale,
+                           const uint64_t seed)
+{
+  parameters = PlantedParameters(predictors, classes, scale, seed);
+  parameters.each_row() -= arma::mean(parameters, 0);
+
+  labels.set_size(predictors.n_cols);
+  ForEachSyntheticBlock(predictors.n_cols, [&](const size_t b,
+      const size_t begin, const size_t end)
+  {
+    arma::mat scores = parameters.cols(1, parameters.n_cols - 1) *
+        MatType(predictors.cols(begin, end));
+    scores.each_col() += parameters.col(0);
+    RandomGenerator generator(seed, syntheticResponseStream + b);
+    for (size_t i = 0; i < scores.n_cols; ++i)
+    {
+      // Sample the class by inversion of the distribution function.
+      const arma::vec probabilities = arma::exp(scores.col(i) -
+          scores.col(i).max());
+      double u = generator.Uniform() * arma::accu(probabilities);
+      size_t k = 0;
+      while (k + 1 < classes && u >= probabilities[k])
+        u -= probabilities[k++];
+      labels[begin + i] = k;
+    }
+  });
+}
+
+template<typename MatType>
+void LinearRegressionData(const MatType& predictors,
+                          arma::rowvec& responses,
+                          arma::rowvec& parameters,
+                          const double noise,
+                          const double scale,
+                          const uint64_t seed)
+{
+  parameters = PlantedParameters(predictors, 1, scale, seed);
+
+  responses.set_size(predictors.n_cols);
+  ForEachSyntheticBlock(predictors.n_cols, [&](const size_t b,
+      const size_t begin, const size_t end)
+  {
+    responses.cols(begin, end) = parameters[0] +
+        parameters.tail_cols(predictors.n_rows) *
+        MatType(predictors.cols(begin, end));
+    RandomGenerator generator(seed, syntheticResponseStream + b);
+    if (noise > 0.0)
+    {
+      for (size_t i = begin; i <= end; ++i)
+        responses[i] += noise * generator.Normal();
+    }
+  });
+}
+
+inline void MatrixFactorizationData(const size_t users,
+                                    const size_t items,
+                                    const size_t perUser,
+                                    const size_t rank,
+                                    arma::umat& locations,
+                                    arma::vec& values,
+                                    arma::mat& parameters,
+                                    const double skew,
+                                    const double noise,
+                                    const uint64_t seed)
+{
+  if (items == 0 || skew < 1.0)
+  {
+    std::ostringstream oss;
+    oss << "MatrixFactorizationData(): cannot draw ratings of " << items
+        << " items with skew " << skew << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  parameters.set_size(rank, users + items);
+  RandomGenerator generator(seed, syntheticParameterStream);
+  generator.Randn(parameters);
+  if (users > 0 && rank > 0)
+    parameters.head_cols(users) /= std::sqrt((double) rank);
+
+  const size_t ratings = users * perUser;
+  locations.set_size(2, ratings);
+  values.set_size(ratings);
+  ForEachSyntheticBlock(ratings, [&](const size_t b, const size_t begin,
+      const size_t end)
+  {
+    RandomGenerator generator(seed, b);
+    for (size_t i = begin; i <= end; ++i)
+    {
+      const size_t u = i / perUser;
+      const size_t v = std::min((size_t) (items * std::pow(
+          generator.Uniform(), skew)), items - 1);
+      locations(0, i) = u;
+      locations(1, i) = v;
+      values[i] = arma::dot(parameters.col(u), parameters.col(users + v));
+      if (noise > 0.0)
+        values[i] += noise * generator.Normal();
+    }
+  });
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file proximal_gradient.hpp
+ * @author Marcus Edel
+ *
+ * Proximal gradient descent (ISTA, and FISTA with acceleration) for composite
+ * objectives f(x) + g(x).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+
+#include "proximal_operators/no_penalty.hpp"
+#include "proximal_operators/l1_penalty.hpp"
+#include "proximal_operators/group_lasso_penalty.hpp"
+#include "proximal_operators/box_constraint.hpp"
+#include "proximal_operators/ball_constraints.hpp"
+
+namespace ens {
+
+/**
+ * Proximal gradient descent minimizes composite objectives f(x) + g(x), where
+ * f is differentiable and g is a convex function with a cheap proximal
+ * operator (a penalty such as the l1 norm, or the indicator of a constraint
+ * set).  Each iteration takes a gradient step on f, then the proximal step of
+ * g:
+ *
+ * \f[
+ * x_{k + 1} = prox_{\alpha g}(y_k - \alpha \nabla f(y_k))
+ * \f]
+ *
+ * where y_k = x_k for ISTA.  With acceleration (FISTA), y_k extrapolates the
+ * last two iterates, and the momentum is restarted whenever it points uphill.
+ * With backtracking, the step size alpha is halved until f(x_{k + 1}) is below
+ * its quadratic upper bound at y_k, so that no Lipschitz constant has to be
+ * known.  The optimization stops when the relative change of the iterate is
+ * below the tolerance.
+ *
+ * Unlike subgradient methods, the proximal steps of sparsity-inducing
+ * penalties set coordinates exactly to zero, and the convergence rate is that
+ * of smooth problems.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Beck2009,
+ *   title   = {A Fast Iterative Shrinkage-Thresholding Algorithm for Linear
+ *              Inverse Problems},
+ *   author  = {Beck, Amir and Teboulle, Marc},
+ *   journal = {SIAM Journal on Imaging Sciences},
+ *   volume  = {2},
+ *   number  = {1},
+ *   pages   = {183--202},
+ *   year    = {2009}
+ * }
+ * @endcode
+ *
+ * ProximalGradient can optimize differentiable functions, together with a
+ * proximal operator policy (see L1Penalty for the interface); the provided
+ * policies are L1Penalty, GroupLassoPenalty, BoxConstraint, L1BallConstraint
+ * and L0BallConstraint.
+ *
+ * @tparam ProximalType The proximal operator policy of g.
+ */
+template<typename ProximalType = L1Penalty>
+class ProximalGradient
+{
+ public:
+  /**
+   * Construct the proximal gradient optimizer with the given parameters.
+   *
+   * @param stepSize Step size of the first iteration (the step size of every
+   *     iteration without backtracking).
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum relative change of the iterate to terminate the
+   *     algorithm.
+   * @param accelerate If true, use FISTA with restarts; otherwise, ISTA.
+   * @param backtracking If true, reduce the step size until the quadratic
+   *     upper bound of f holds.
+   * @param backtrackingFactor Factor the step is reduced by on each failure.
+   * @param proximal The proximal operator policy.
+   */
+  ProximalGradient(const double stepSize = 1.0,
+                   const size_t maxIterations = 10000,
+                   const double tolerance = 1e-10,
+                   const bool accelerate = true,
+                   const bool backtracking = true,
+                   const double backtrackingFactor = 0.5,
+                   const ProximalType& proximal = ProximalType());
+
+  /**
+   * Minimize f + g, where f is the given function and g that of the proximal
+   * operator policy.  The given starting point will be modified to store the
+   * finishing point of the algorithm, and the final objective value f + g is
+   * returned.
+   *
+   * @tparam FunctionType Type of the differentiable function f.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Differentiable function f.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value f + g of the final point.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the step size of the first iteration.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size of the first iteration.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether FISTA is used.
+  bool Accelerate() const { return accelerate; }
+  //! Modify whether FISTA is used.
+  bool& Accelerate() { return accelerate; }
+
+  //! Get whether the step size is reduced by backtracking.
+  bool Backtracking() const { return backtracking; }
+  //! Modify whether the step size is reduced by backtracking.
+  bool& Backtracking() { return backtracking; }
+
+  //! Get the factor the step is reduced by when backtracking.
+  double BacktrackingFactor() const { return backtrackingFactor; }
+  //! Modify the factor the step is reduced by when backtracking.
+  double& BacktrackingFactor() { return backtrackingFactor; }
+
+  //! Get the proximal operator policy.
+  const ProximalType& Proximal() const { return proximal; }
+  //! Modify the proximal operator policy.
+  ProximalType& Proximal() { return proximal; }
+
+  //! Get the step size of the last iteration of the last call to Optimize().
+  double FinalStepSize() const { return finalStepSize; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size of the first iteration.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Whether FISTA is used.
+  bool accelerate;
+
+  //! Whether the step size is reduced by backtracking.
+  bool backtracking;
+
+  //! The factor the step is reduced by when backtracking.
+  double backtrackingFactor;
+
+  //! The proximal operator policy.
+  ProximalType proximal;
+
+  //! The step size of the last iteration of the last call to Optimize().
+  double finalStepSize;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "proximal_gradient_impl.hpp"
+
+#endif
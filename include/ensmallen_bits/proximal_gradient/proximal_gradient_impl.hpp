@@ -0,0 +1,195 @@
+/**
+ * @file proximal_gradient_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of proximal gradient descent (ISTA/FISTA).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "proximal_gradient.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename ProximalType>
+ProximalGradient<ProximalType>::ProximalGradient(
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool accelerate,
+    const bool backtracking,
+    const double backtrackingFactor,
+    const ProximalType& proximal) :
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    accelerate(accelerate),
+    backtracking(backtracking),
+    backtrackingFactor(backtrackingFactor),
+    proximal(proximal),
+    finalStepSize(stepSize)
+{ /* Nothing to do. */ }
+
+template<typename ProximalType>
+template<typename FunctionType, typename... CallbackTypes>
+double ProximalGradient<ProximalType>::Optimize(
+    FunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType>();
+
+  // The iterations start from a feasible point.
+  proximal.ProximalStep(iterate, stepSize);
+
+  // The gradient step is taken from point: the extrapolated point with
+  // acceleration, and the iterate otherwise.
+  arma::mat extrapolated;
+  if (accelerate)
+    extrapolated = iterate;
+  arma::mat& point = accelerate ? extrapolated : iterate;
+  double momentum = 1.0;
+
+  // Without acceleration the accepted candidate of the line search is the next
+  // point, so its gradient is computed with its objective.
+  const bool fusedSearch = backtracking && !accelerate;
+  arma::mat candidate, candidateGradient, difference;
+  double candidateObjective = 0.0;
+  bool evaluated = false;
+
+  double step = stepSize;
+  double objective = 0.0;
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+
+  size_t i = 1;
+  for (; (maxIterations == 0 || i <= maxIterations) && !terminate; ++i)
+  {
+    if (!evaluated)
+    {
+      objective = f.EvaluateWithGradient(point, gradient);
+      terminate |= Callback::Evaluate(*this, f, point, objective,
+          callbacks...);
+      terminate |= Callback::Gradient(*this, f, point, gradient,
+          callbacks...);
+    }
+    evaluated = false;
+
+    terminate |= Callback::BeginEpoch(*this, f, iterate, i, objective,
+        callbacks...);
+    if (terminate)
+      break;
+
+    if (std::isnan(objective) || std::isinf(objective))
+    {
+      ENS_WARN << "ProximalGradient: converged to " << objective << "; "
+          << "terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      break;
+    }
+
+    // The proximal step; with backtracking, the step size is reduced until f
+    // at the candidate is below its quadratic upper bound at the point, at
+    // most 50 times.
+    candidate = point - step * gradient;
+    proximal.ProximalStep(candidate, step);
+    if (backtracking)
+    {
+      for (size_t k = 0; k < 50; ++k)
+      {
+        candidateObjective = fusedSearch ?
+            f.EvaluateWithGradient(candidate, candidateGradient) :
+            f.Evaluate(candidate);
+        difference = candidate - point;
+        if (candidateObjective <= objective + arma::dot(gradient, difference) +
+            arma::dot(difference, difference) / (2.0 * step))
+        {
+          evaluated = fusedSearch;
+          break;
+        }
+
+        step *= backtrackingFactor;
+        candidate = point - step * gradient;
+        proximal.ProximalStep(candidate, step);
+      }
+    }
+
+    // The relative change of the iterate.
+    const double change = arma::norm(candidate - iterate, 2);
+    const double scale = std::max(1.0, arma::norm(iterate, 2));
+
+    if (accelerate)
+    {
+      // Restart the momentum if the step goes against the last one (the
+      // generalized gradient points along the momentum); otherwise,
+      // extrapolate along the last step.
+      if (arma::dot(point - candidate, candidate - iterate) > 0.0)
+      {
+        momentum = 1.0;
+        extrapolated = candidate;
+      }
+      else
+      {
+        const double nextMomentum = (1.0 + std::sqrt(1.0 + 4.0 * momentum *
+            momentum)) / 2.0;
+        extrapolated = candidate + ((momentum - 1.0) / nextMomentum) *
+            (candidate - iterate);
+        momentum = nextMomentum;
+      }
+    }
+
+    SwapInPlace(iterate, candidate);
+    if (evaluated)
+    {
+      objective = candidateObjective;
+      gradient.swap(candidateGradient);
+    }
+
+    ENS_INFO << "ProximalGradient: iteration " << i << ", step size " << step
+        << ", change " << change << "." << std::endl;
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    terminate |= Callback::EndEpoch(*this, f, iterate, i, objective,
+        callbacks...);
+
+    if (change <= tolerance * scale)
+    {
+      ENS_INFO << "ProximalGradient: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      break;
+    }
+  }
+
+  if (!terminate && maxIterations != 0 && i > maxIterations)
+  {
+    ENS_INFO << "ProximalGradient: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  finalStepSize = step;
+  objective = f.Evaluate(iterate) + proximal.Evaluate(iterate);
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file ball_constraints.hpp
+ * @author Marcus Edel
+ *
+ * The indicators of the l1 and l0 balls, whose proximal operators are the
+ * projections of Proximal.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_BALL_CONSTRAINTS_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_BALL_CONSTRAINTS_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The constraint ||x||_1 <= tau, on all the coordinates; the proximal operator
+ * is Proximal::ProjectToL1Ball().
+ */
+class L1BallConstraint
+{
+ public:
+  /**
+   * Create the constraint with the given radius.
+   *
+   * @param tau Radius of the l1 ball.
+   */
+  L1BallConstraint(const double tau = 1.0) : tau(tau) { }
+
+  //! The iterates are always inside the ball.
+  double Evaluate(const arma::mat& /* coordinates */) const { return 0.0; }
+
+  //! Project the coordinates onto the ball.
+  void ProximalStep(arma::mat& coordinates, const double /* step */) const
+  {
+    arma::vec v(coordinates.memptr(), coordinates.n_elem, false, true);
+    Proximal::ProjectToL1Ball(v, tau);
+  }
+
+  //! Get the radius of the ball.
+  double Tau() const { return tau; }
+  //! Modify the radius of the ball.
+  double& Tau() { return tau; }
+
+ private:
+  //! The radius of the ball.
+  double tau;
+};
+
+/**
+ * The constraint that at most tau coordinates are non-zero; the proximal
+ * operator is Proximal::ProjectToL0Ball(), which keeps the tau coordinates of
+ * largest magnitude.  The set is not convex, so ProximalGradient then finds a
+ * local minimum (as iterative hard thresholding); acceleration should be
+ * disabled.
+ */
+class L0BallConstraint
+{
+ public:
+  /**
+   * Create the constraint with the given number of non-zero coordinates.
+   *
+   * @param tau Maximum number of non-zero coordinates.
+   */
+  L0BallConstraint(const int tau = 1) : tau(tau) { }
+
+  //! The iterates are always inside the ball.
+  double Evaluate(const arma::mat& /* coordinates */) const { return 0.0; }
+
+  //! Keep the tau coordinates of largest magnitude.
+  void ProximalStep(arma::mat& coordinates, const double /* step */) const
+  {
+    arma::vec v(coordinates.memptr(), coordinates.n_elem, false, true);
+    Proximal::ProjectToL0Ball(v, tau);
+  }
+
+  //! Get the maximum number of non-zero coordinates.
+  int Tau() const { return tau; }
+  //! Modify the maximum number of non-zero coordinates.
+  int& Tau() { return tau; }
+
+ private:
+  //! The maximum number of non-zero coordinates.
+  int tau;
+};
+
+} // namespace ens
+
+#endif
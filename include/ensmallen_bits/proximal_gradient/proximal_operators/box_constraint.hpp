@@ -0,0 +1,65 @@
+/**
+ * @file box_constraint.hpp
+ * @author Marcus Edel
+ *
+ * The indicator of a box, whose proximal operator is the projection onto the
+ * box.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_BOX_CONSTRAINT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_BOX_CONSTRAINT_HPP
+
+namespace ens {
+
+/**
+ * The constraint lower <= x <= upper on every coordinate; the proximal
+ * operator clamps the coordinates, whatever the step.
+ */
+class BoxConstraint
+{
+ public:
+  /**
+   * Create the constraint with the given bounds.
+   *
+   * @param lower Lower bound of every coordinate.
+   * @param upper Upper bound of every coordinate.
+   */
+  BoxConstraint(const double lower = 0.0, const double upper = 1.0) :
+      lower(lower),
+      upper(upper)
+  { }
+
+  //! The iterates are always inside the box.
+  double Evaluate(const arma::mat& /* coordinates */) const { return 0.0; }
+
+  //! Clamp the coordinates to the box.
+  void ProximalStep(arma::mat& coordinates, const double /* step */) const
+  {
+    coordinates = arma::clamp(coordinates, lower, upper);
+  }
+
+  //! Get the lower bound.
+  double Lower() const { return lower; }
+  //! Modify the lower bound.
+  double& Lower() { return lower; }
+
+  //! Get the upper bound.
+  double Upper() const { return upper; }
+  //! Modify the upper bound.
+  double& Upper() { return upper; }
+
+ private:
+  //! The lower bound.
+  double lower;
+
+  //! The upper bound.
+  double upper;
+};
+
+} // namespace ens
+
+#endif
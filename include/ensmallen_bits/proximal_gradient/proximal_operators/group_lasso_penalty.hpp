@@ -0,0 +1,95 @@
+/**
+ * @file group_lasso_penalty.hpp
+ * @author Marcus Edel
+ *
+ * The group lasso penalty, and its proximal operator.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_GROUP_LASSO_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_GROUP_LASSO_PENALTY_HPP
+
+namespace ens {
+
+/**
+ * The group lasso penalty g(x) = lambda sum_k ||x_k||_2, where the groups x_k
+ * are the consecutive blocks of groupSize coordinates (in column-major order;
+ * the last group may be smaller).  Its proximal operator shrinks the norm of
+ * every group by step * lambda, so that whole groups become zero.  With
+ * groupSize equal to the number of rows, each column is a group.
+ */
+class GroupLassoPenalty
+{
+ public:
+  /**
+   * Create the penalty with the given strength and size of the groups.
+   *
+   * @param lambda Strength of the penalty.
+   * @param groupSize Number of coordinates in each group.
+   */
+  GroupLassoPenalty(const double lambda = 0.01, const size_t groupSize = 1) :
+      lambda(lambda),
+      groupSize(groupSize)
+  { }
+
+  //! Evaluate the penalty.
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    double penalty = 0.0;
+    for (size_t begin = 0; begin < coordinates.n_elem; begin += groupSize)
+    {
+      const size_t n = std::min(groupSize, coordinates.n_elem - begin);
+      penalty += GroupNorm(coordinates.memptr() + begin, n);
+    }
+    return lambda * penalty;
+  }
+
+  //! Shrink the norm of every group by step * lambda.
+  void ProximalStep(arma::mat& coordinates, const double step) const
+  {
+    const double threshold = step * lambda;
+    for (size_t begin = 0; begin < coordinates.n_elem; begin += groupSize)
+    {
+      const size_t n = std::min(groupSize, coordinates.n_elem - begin);
+      double* group = coordinates.memptr() + begin;
+
+      const double norm = GroupNorm(group, n);
+      const double scale = (norm > threshold) ? (1.0 - threshold / norm) : 0.0;
+      for (size_t i = 0; i < n; ++i)
+        group[i] *= scale;
+    }
+  }
+
+  //! Get the strength of the penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the strength of the penalty.
+  double& Lambda() { return lambda; }
+
+  //! Get the number of coordinates in each group.
+  size_t GroupSize() const { return groupSize; }
+  //! Modify the number of coordinates in each group.
+  size_t& GroupSize() { return groupSize; }
+
+ private:
+  //! The l2 norm of the n coordinates of a group.
+  static double GroupNorm(const double* group, const size_t n)
+  {
+    double norm = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      norm += group[i] * group[i];
+    return std::sqrt(norm);
+  }
+
+  //! The strength of the penalty.
+  double lambda;
+
+  //! The number of coordinates in each group.
+  size_t groupSize;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file l1_penalty.hpp
+ * @author Marcus Edel
+ *
+ * The l1 penalty of the lasso, and its proximal operator (soft thresholding).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_L1_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_L1_PENALTY_HPP
+
+namespace ens {
+
+/**
+ * The l1 penalty g(x) = lambda ||x||_1, whose proximal operator is the soft
+ * thresholding of every coordinate by step * lambda.  The coordinates that end
+ * up below the threshold are exactly zero, so that the iterates are sparse.
+ *
+ * A proximal operator policy for ProximalGradient must implement the
+ * following methods:
+ *
+ * @code
+ * // Return g(coordinates).
+ * double Evaluate(const arma::mat& coordinates) const;
+ *
+ * // Replace coordinates by argmin_x g(x) + ||x - coordinates||^2 / (2 step).
+ * void ProximalStep(arma::mat& coordinates, const double step) const;
+ * @endcode
+ *
+ * The indicator function of a convex set (0 inside, infinity outside), whose
+ * proximal operator is the projection onto the set, evaluates to 0, as the
+ * iterates are always inside.
+ */
+class L1Penalty
+{
+ public:
+  /**
+   * Create the penalty with the given strength.
+   *
+   * @param lambda Strength of the penalty.
+   */
+  L1Penalty(const double lambda = 0.01) : lambda(lambda) { }
+
+  //! Evaluate the penalty.
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return lambda * arma::accu(arma::abs(coordinates));
+  }
+
+  //! Soft threshold the coordinates by step * lambda.
+  void ProximalStep(arma::mat& coordinates, const double step) const
+  {
+    const double threshold = step * lambda;
+    coordinates.transform([threshold](double x)
+    {
+      return (x > threshold) ? (x - threshold) :
+          ((x < -threshold) ? (x + threshold) : 0.0);
+    });
+  }
+
+  //! Get the strength of the penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the strength of the penalty.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! The strength of the penalty.
+  double lambda;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file no_penalty.hpp
+ * @author Marcus Edel
+ *
+ * The zero penalty, whose proximal operator is the identity.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_NO_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_NO_PENALTY_HPP
+
+namespace ens {
+
+/**
+ * The penalty g(x) = 0, whose proximal operator leaves the coordinates alone.
+ * This is the default penalty of ConsensusADMM, for problems without a
+ * regularizer (or whose regularizer is part of the local functions).
+ */
+class NoPenalty
+{
+ public:
+  //! Evaluate the penalty.
+  double Evaluate(const arma::mat& /* coordinates */) const { return 0.0; }
+
+  //! Nothing to do.
+  void ProximalStep(arma::mat& /* coordinates */, const double /* step */)
+      const { }
+};
+
+} // namespace ens
+
+#endif
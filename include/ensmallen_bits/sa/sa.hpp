@@ -42,6 +42,37 @@ namespace ens {
  * on function types included with this distribution or on the ensmallen
  * website.
  *
+ * If the function has a method
+ *
+ *   double EvaluateDelta(const arma::mat& coordinates,
+ *                        const size_t index,
+ *                        const double value);
+ *
+ * returning the change of the objective when element index of coordinates is
+ * set to value, SA uses it to evaluate each move instead of Evaluate(); the
+ * objective is then evaluated in full only once every moveCtrlSweep sweeps.
+ *
+ * With blockSize > 1, SA moves blockSize parameters at a time instead of one,
+ * drawing the Laplace moves of the whole block at once; an iteration (and a
+ * step of the cooling schedule) is then a block move.  If the function has an
+ * EvaluateBatch() method (see traits::HasBatchEvaluation), the block gives
+ * blockSize independent proposals, one per parameter, which are evaluated in
+ * one call, and the first one accepted by the Metropolis criterion is taken
+ * (the later ones are dropped, since they were proposed from the old state);
+ * this is the same chain as with single moves, with its evaluations batched.
+ * Otherwise, the parameters of the block are moved together and the move is
+ * accepted or rejected as a whole, with one call to Evaluate() per block
+ * (EvaluateDelta() is not used); the move control then adapts the move sizes
+ * to the acceptance of the block moves.  Blocks never span two sweeps.
+ *
+ * With numChains > 1, SA runs in replica-exchange (parallel tempering) mode:
+ * numChains chains start at the temperatures initT, initT * temperatureRatio,
+ * initT * temperatureRatio^2, ... and are cooled with the cooling schedule,
+ * each on its own OpenMP thread.  Every swapInterval moves, neighbouring chains
+ * exchange their states according to the Metropolis criterion, so that the
+ * hot chains can carry the cold ones out of local minima.  The function (and
+ * the cooling schedule) must then be safe to call concurrently.
+ *
  * The CoolingScheduleType template parameter must implement the following
  * method:
  *
@@ -72,6 +103,13 @@ class SA
    * @param maxMoveCoef Maximum move size.
    * @param initMoveCoef Initial move size.
    * @param gain Proportional control in feedback move control.
+   * @param numChains Number of chains to run at different temperatures
+   *    (replica exchange); 1 runs a single chain.
+   * @param swapInterval Number of moves of each chain between two attempts to
+   *    swap the states of neighbouring chains.
+   * @param temperatureRatio Ratio between the temperatures of two neighbouring
+   *    chains.
+   * @param blockSize Number of parameters moved at a time.
    */
   SA(CoolingScheduleType& coolingSchedule,
      const size_t maxIterations = 1000000,
@@ -82,20 +120,32 @@ class SA
      const size_t maxToleranceSweep = 3,
      const double maxMoveCoef = 20,
      const double initMoveCoef = 0.3,
-     const double gain = 0.3);
+     const double gain = 0.3,
+     const size_t numChains = 1,
+     const size_t swapInterval = 100,
+     const double temperatureRatio = 2.0,
+     const size_t blockSize = 1);
 
   /**
    * Optimize the given function using simulated annealing. The given starting
    * point will be modified to store the finishing point of the algorithm, and
    * the final objective value is returned.
    *
+   * Any number of callbacks may be given after the iterate; SA reports the
+   * start and the end of the optimization and every move as a step (with
+   * several chains, every round of moves of the coldest chain).
+   *
    * @tparam FunctionType Type of function to optimize.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename FunctionType>
-  double Optimize(FunctionType& function, arma::mat& iterate);
+  template<typename FunctionType, typename... CallbackTypes>
+  double Optimize(FunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the temperature.
   double Temperature() const { return temperature; }
@@ -132,6 +182,29 @@ class SA
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of chains.
+  size_t NumChains() const { return numChains; }
+  //! Modify the number of chains.
+  size_t& NumChains() { return numChains; }
+
+  //! Get the number of moves between two swap attempts.
+  size_t SwapInterval() const { return swapInterval; }
+  //! Modify the number of moves between two swap attempts.
+  size_t& SwapInterval() { return swapInterval; }
+
+  //! Get the ratio between the temperatures of neighbouring chains.
+  double TemperatureRatio() const { return temperatureRatio; }
+  //! Modify the ratio between the temperatures of neighbouring chains.
+  double& TemperatureRatio() { return temperatureRatio; }
+
+  //! Get the number of parameters moved at a time.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of parameters moved at a time.
+  size_t& BlockSize() { return blockSize; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The cooling schedule being used.
   CoolingScheduleType& coolingSchedule;
@@ -154,13 +227,73 @@ class SA
   //! Proportional control in feedback move control.
   double gain;
 
+  //! Number of chains to run at different temperatures.
+  size_t numChains;
+
+  //! Number of moves of each chain between two swap attempts.
+  size_t swapInterval;
+
+  //! Ratio between the temperatures of neighbouring chains.
+  double temperatureRatio;
+
+  //! Number of parameters moved at a time.
+  size_t blockSize;
+
+  //! Draw uniform random numbers from [0, 1) from a stream of its own.
+  struct UniformStream
+  {
+    //! The random number generator of the stream.
+    RandomGenerator generator;
+
+    //! Draw a uniform random number from [0, 1).
+    double operator()() { return generator.Uniform(); }
+  };
+
+  //! The state of one chain of the replica-exchange mode.
+  struct Chain
+  {
+    //! Current coordinates of the chain.
+    arma::mat iterate;
+    //! Accepted moves of each parameter since the last MoveControl().
+    arma::mat accept;
+    //! Move size of each parameter.
+    arma::mat moveSize;
+    //! Current energy of the chain.
+    double energy;
+    //! Current temperature of the chain.
+    double temperature;
+    //! Next parameter to move.
+    size_t idx;
+    //! Sweeps since the last MoveControl().
+    size_t sweepCounter;
+    //! Consecutive moves that changed the energy by less than the tolerance.
+    size_t frozenCount;
+    //! The random number generator of the chain, so that the chains do not
+    //! share one.
+    RandomGenerator generator;
+
+    //! Draw a uniform random number from [0, 1).
+    double operator()() { return generator.Uniform(); }
+  };
+
+  /**
+   * Optimize the given function with numChains chains at different
+   * temperatures, which periodically swap their states (replica exchange).
+   * The chains run on separate OpenMP threads.
+   */
+  template<typename FunctionType, typename... CallbackTypes>
+  double OptimizeChains(FunctionType& function,
+                        arma::mat& iterate,
+                        CallbackTypes&... callbacks);
+
   /**
    * GenerateMove proposes a move on element iterate(idx), and determines if
    * that move is acceptable or not according to the Metropolis criterion.
    * After that it increments idx so the next call will make a move on next
    * parameters. When all elements of the state have been moved (a sweep), it
    * resets idx and increments sweepCounter. When sweepCounter reaches
-   * moveCtrlSweep, it performs MoveControl() and resets sweepCounter.
+   * moveCtrlSweep, it performs MoveControl() and resets sweepCounter.  With
+   * blockSize > 1, it calls GenerateBlockMove() instead.
    *
    * @param iterate Current optimization position.
    * @param accept Matrix representing which parameters have had accepted moves.
@@ -169,15 +302,53 @@ class SA
    * @param idx Current parameter to modify.
    * @param sweepCounter Current counter representing how many sweeps have been
    *      completed.
+   * @param currentTemperature Current temperature of the system.
+   * @param uniform Callable object returning uniform random numbers in [0, 1).
+   * @return The number of parameters moved.
    */
-  template<typename FunctionType>
-  void GenerateMove(FunctionType& function,
+  template<typename FunctionType, typename UniformType>
+  size_t GenerateMove(FunctionType& function,
                     arma::mat& iterate,
                     arma::mat& accept,
                     arma::mat& moveSize,
                     double& energy,
                     size_t& idx,
-                    size_t& sweepCounter);
+                    size_t& sweepCounter,
+                    const double currentTemperature,
+                    UniformType& uniform);
+
+  /**
+   * GenerateBlockMove proposes moves on the (at most) blockSize elements from
+   * iterate(idx) to the end of the sweep, and accepts them as described in the
+   * documentation of the class.  The parameters are the same as for
+   * GenerateMove().
+   *
+   * @return The number of parameters moved.
+   */
+  template<typename FunctionType, typename UniformType>
+  size_t GenerateBlockMove(FunctionType& function,
+                           arma::mat& iterate,
+                           arma::mat& accept,
+                           arma::mat& moveSize,
+                           double& energy,
+                           size_t& idx,
+                           size_t& sweepCounter,
+                           const double currentTemperature,
+                           UniformType& uniform);
+
+  /**
+   * Advance idx past the given number of moved parameters, and count the sweep
+   * and perform MoveControl() if needed.
+   */
+  template<typename FunctionType>
+  void FinishMove(FunctionType& function,
+                  const arma::mat& iterate,
+                  arma::mat& accept,
+                  arma::mat& moveSize,
+                  double& energy,
+                  size_t& idx,
+                  size_t& sweepCounter,
+                  const size_t moves);
 
   /**
    * MoveControl() uses a proportional feedback control to determine the size
@@ -197,7 +368,12 @@ class SA
    * @param nMoves Number of moves since last call.
    * @param accept Matrix representing which parameters have had accepted moves.
    */
-  void MoveControl(const size_t nMoves, arma::mat& accept, arma::mat& moveSize);
+  void MoveControl(const size_t nMoves,
+                   arma::mat& accept,
+                   arma::mat& moveSize) const;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
@@ -13,6 +13,7 @@
 #define ENSMALLEN_SA_SA_IMPL_HPP
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 
 namespace ens {
 
@@ -27,7 +28,11 @@ SA<CoolingScheduleType>::SA(
     const size_t maxToleranceSweep,
     const double maxMoveCoef,
     const double initMoveCoef,
-    const double gain) :
+    const double gain,
+    const size_t numChains,
+    const size_t swapInterval,
+    const double temperatureRatio,
+    const size_t blockSize) :
     coolingSchedule(coolingSchedule),
     maxIterations(maxIterations),
     temperature(initT),
@@ -37,20 +42,35 @@ SA<CoolingScheduleType>::SA(
     maxToleranceSweep(maxToleranceSweep),
     maxMoveCoef(maxMoveCoef),
     initMoveCoef(initMoveCoef),
-    gain(gain)
+    gain(gain),
+    numChains(numChains),
+    swapInterval(swapInterval),
+    temperatureRatio(temperatureRatio),
+    blockSize(blockSize)
 {
   // Nothing to do.
 }
 
 //! Optimize the function (minimize).
 template<typename CoolingScheduleType>
-template<typename FunctionType>
+template<typename FunctionType, typename... CallbackTypes>
 double SA<CoolingScheduleType>::Optimize(FunctionType& function,
-                                         arma::mat& iterate)
+                                         arma::mat& iterate,
+                                         CallbackTypes&&... callbacks)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   // Make sure we have the methods that we need.
   traits::CheckNonDifferentiableFunctionTypeAPI<FunctionType>();
 
+  if (blockSize == 0)
+  {
+    throw std::invalid_argument("SA::Optimize(): blockSize must be positive");
+  }
+
+  if (numChains > 1)
+    return OptimizeChains(function, iterate, callbacks...);
+
   const size_t rows = iterate.n_rows;
   const size_t cols = iterate.n_cols;
 
@@ -65,41 +85,202 @@ double SA<CoolingScheduleType>::Optimize(FunctionType& function,
   arma::mat moveSize(rows, cols);
   moveSize.fill(initMoveCoef);
 
+  UniformStream uniform = { NewRandomGenerator() };
+
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  terminate |= Callback::Evaluate(*this, function, iterate, energy,
+      callbacks...);
+
   // Initial moves to get rid of dependency of initial states.
-  for (size_t i = 0; i < initMoves; ++i)
+  for (size_t i = 0; i < initMoves && !terminate; ++i)
+  {
     GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter);
+        sweepCounter, temperature, uniform);
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+  }
 
   // Iterating and cooling.
-  for (size_t i = 0; i != maxIterations; ++i)
+  for (size_t i = 0; i != maxIterations && !terminate; ++i)
   {
     oldEnergy = energy;
-    GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter);
+    const size_t moves = GenerateMove(function, iterate, accept, moveSize,
+        energy, idx, sweepCounter, temperature, uniform);
     temperature = coolingSchedule.NextTemperature(temperature, energy);
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
 
     // Determine if the optimization has entered (or continues to be in) a
     // frozen state.
     if (std::abs(energy - oldEnergy) < tolerance)
-      ++frozenCount;
+      frozenCount += moves;
     else
       frozenCount = 0;
 
     // Terminate, if possible.
     if (frozenCount >= maxToleranceSweep * moveCtrlSweep * iterate.n_elem)
     {
-      Info << "SA: minimized within tolerance " << tolerance << " for "
+      ENS_INFO << "SA: minimized within tolerance " << tolerance << " for "
           << maxToleranceSweep << " sweeps after " << i << " iterations; "
           << "terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return energy;
     }
   }
 
-  Warn << "SA: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    ENS_WARN << "SA: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return energy;
 }
 
+template<typename CoolingScheduleType>
+template<typename FunctionType, typename... CallbackTypes>
+double SA<CoolingScheduleType>::OptimizeChains(FunctionType& function,
+                                               arma::mat& iterate,
+                                               CallbackTypes&... callbacks)
+{
+  if (swapInterval == 0)
+  {
+    throw std::invalid_argument("SA::Optimize(): swapInterval must be "
+        "positive");
+  }
+
+  const size_t frozenLimit = maxToleranceSweep * moveCtrlSweep *
+      iterate.n_elem;
+
+  // The chains are ordered from the coldest to the hottest.  Each chain draws
+  // its random numbers from its own stream of one seed, so the result does not
+  // depend on the number of threads; the swaps use the stream of the
+  // optimization.
+  RandomGenerator generator = NewRandomGenerator();
+  const uint64_t seed = generator.Next64();
+  std::vector<Chain> chains(numChains);
+  for (size_t k = 0; k < numChains; ++k)
+  {
+    Chain& chain = chains[k];
+    chain.iterate = iterate;
+    chain.accept.zeros(iterate.n_rows, iterate.n_cols);
+    chain.moveSize.set_size(iterate.n_rows, iterate.n_cols);
+    chain.moveSize.fill(initMoveCoef);
+    chain.temperature = temperature * std::pow(temperatureRatio, (double) k);
+    chain.idx = 0;
+    chain.sweepCounter = 0;
+    chain.frozenCount = 0;
+    chain.generator.Seed(seed, k);
+  }
+
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  // Initial moves to get rid of dependency of initial states, followed by the
+  // iterations.  The chains exchange their states after each round.  The
+  // callbacks are called between the rounds, with the coldest chain.
+  size_t i = 0;
+  for (size_t round = 0; !terminate; ++round)
+  {
+    const size_t moves = (round == 0) ? initMoves : ((maxIterations == 0) ?
+        swapInterval : std::min(swapInterval, maxIterations - i));
+
+    ENS_PRAGMA_OMP_PARALLEL
+    {
+      size_t threadId = 0;
+      size_t numThreads = 1;
+      #ifdef ENS_USE_OPENMP
+        threadId = omp_get_thread_num();
+        numThreads = omp_get_num_threads();
+      #endif
+
+      for (size_t k = threadId; k < numChains; k += numThreads)
+      {
+        Chain& chain = chains[k];
+        if (round == 0)
+          chain.energy = function.Evaluate(chain.iterate);
+
+        for (size_t m = 0; m < moves; ++m)
+        {
+          const double oldEnergy = chain.energy;
+          const size_t moved = GenerateMove(function, chain.iterate,
+              chain.accept, chain.moveSize, chain.energy, chain.idx,
+              chain.sweepCounter, chain.temperature, chain);
+
+          // The temperature is kept during the initial moves.
+          if (round == 0)
+            continue;
+
+          chain.temperature = coolingSchedule.NextTemperature(
+              chain.temperature, chain.energy);
+          if (std::abs(chain.energy - oldEnergy) < tolerance)
+            chain.frozenCount += moved;
+          else
+            chain.frozenCount = 0;
+        }
+      }
+    }
+
+    terminate |= Callback::StepTaken(*this, function, chains[0].iterate,
+        callbacks...);
+    if (round == 0)
+      continue;
+    i += moves;
+
+    // Try to swap the states of the neighbouring chains, alternating between
+    // the even and the odd pairs.  According to the Metropolis criterion, the
+    // swap is accepted with probability
+    // min{1, exp((E_cold - E_hot) (1 / T_cold - 1 / T_hot))}.
+    for (size_t k = round % 2; k + 1 < numChains; k += 2)
+    {
+      Chain& cold = chains[k];
+      Chain& hot = chains[k + 1];
+      const double criterion = std::exp((cold.energy - hot.energy) *
+          (1.0 / cold.temperature - 1.0 / hot.temperature));
+      if (criterion >= 1.0 || criterion > generator.Uniform())
+      {
+        if (std::abs(cold.energy - hot.energy) >= tolerance)
+        {
+          cold.frozenCount = 0;
+          hot.frozenCount = 0;
+        }
+
+        cold.iterate.swap(hot.iterate);
+        std::swap(cold.energy, hot.energy);
+      }
+    }
+
+    // Terminate, if the coldest chain is frozen.
+    if (chains[0].frozenCount >= frozenLimit)
+    {
+      ENS_INFO << "SA: minimized within tolerance " << tolerance << " for "
+          << maxToleranceSweep << " sweeps after " << i << " iterations; "
+          << "terminating optimization." << std::endl;
+      break;
+    }
+
+    if (maxIterations != 0 && i >= maxIterations)
+    {
+      ENS_WARN << "SA: maximum iterations (" << maxIterations << ") reached; "
+          << "terminating optimization." << std::endl;
+      break;
+    }
+  }
+
+  // Return the best state of all the chains.
+  size_t best = 0;
+  for (size_t k = 1; k < numChains; ++k)
+  {
+    if (chains[k].energy < chains[best].energy)
+      best = k;
+  }
+
+  temperature = chains[0].temperature;
+  iterate = chains[best].iterate;
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return chains[best].energy;
+}
+
 /**
  * GenerateMove proposes a move on element iterate(idx), and determines
  * it that move is acceptable or not according to the Metropolis criterion.
@@ -109,16 +290,24 @@ double SA<CoolingScheduleType>::Optimize(FunctionType& function,
  * moveCtrlSweep, it performs moveControl and resets sweepCounter.
  */
 template<typename CoolingScheduleType>
-template<typename FunctionType>
-void SA<CoolingScheduleType>::GenerateMove(
+template<typename FunctionType, typename UniformType>
+size_t SA<CoolingScheduleType>::GenerateMove(
     FunctionType& function,
     arma::mat& iterate,
     arma::mat& accept,
     arma::mat& moveSize,
     double& energy,
     size_t& idx,
-    size_t& sweepCounter)
+    size_t& sweepCounter,
+    const double currentTemperature,
+    UniformType& uniform)
 {
+  if (blockSize > 1)
+  {
+    return GenerateBlockMove(function, iterate, accept, moveSize, energy, idx,
+        sweepCounter, currentTemperature, uniform);
+  }
+
   const double prevEnergy = energy;
   const double prevValue = iterate(idx);
 
@@ -127,28 +316,139 @@ void SA<CoolingScheduleType>::GenerateMove(
   // MoveControl() is derived for the Laplace distribution.
 
   // Sample from a Laplace distribution with scale parameter moveSize(idx).
-  const double unif = 2.0 * arma::randu() - 1.0;
+  const double unif = 2.0 * uniform() - 1.0;
   const double move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
       (-moveSize(idx) * std::log(1 - unif));
 
-  iterate(idx) += move;
-  energy = function.Evaluate(iterate);
+  // Only the change of the objective is computed if the function has an
+  // EvaluateDelta() method.
+  const double newEnergy = EvaluateMove(function, iterate, idx,
+      prevValue + move, prevEnergy);
+
   // According to the Metropolis criterion, accept the move with probability
   // min{1, exp(-(E_new - E_old) / T)}.
-  const double xi = arma::randu();
-  const double delta = energy - prevEnergy;
-  const double criterion = std::exp(-delta / temperature);
+  const double xi = uniform();
+  const double delta = newEnergy - prevEnergy;
+  const double criterion = std::exp(-delta / currentTemperature);
   if (delta <= 0. || criterion > xi)
   {
+    iterate(idx) = prevValue + move;
+    energy = newEnergy;
     accept(idx) += 1.;
   }
-  else // Reject the move; restore previous state.
+
+  FinishMove(function, iterate, accept, moveSize, energy, idx, sweepCounter,
+      1);
+  return 1;
+}
+
+/**
+ * GenerateBlockMove proposes moves on a block of elements at once: either
+ * independent proposals, one per element, evaluated with one EvaluateBatch()
+ * call, or one joint move of the block, evaluated with one Evaluate() call.
+ */
+template<typename CoolingScheduleType>
+template<typename FunctionType, typename UniformType>
+size_t SA<CoolingScheduleType>::GenerateBlockMove(
+    FunctionType& function,
+    arma::mat& iterate,
+    arma::mat& accept,
+    arma::mat& moveSize,
+    double& energy,
+    size_t& idx,
+    size_t& sweepCounter,
+    const double currentTemperature,
+    UniformType& uniform)
+{
+  // The block stops at the end of the sweep.
+  const size_t length = std::min(blockSize, (size_t) iterate.n_elem - idx);
+  const double prevEnergy = energy;
+
+  // Sample the Laplace moves of the whole block at once:
+  // -moveSize * sign(u) * log(1 - |u|) for u uniform in (-1, 1).
+  arma::vec unif(length);
+  for (size_t j = 0; j < length; ++j)
+    unif[j] = 2.0 * uniform() - 1.0;
+  const arma::vec scales(moveSize.memptr() + idx, length, false, true);
+  const arma::vec moves = -scales % arma::sign(unif) %
+      arma::log(1.0 - arma::abs(unif));
+
+  if (traits::HasBatchEvaluation<FunctionType>::value)
   {
-    iterate(idx) = prevValue;
-    energy = prevEnergy;
+    // One candidate per element, each with only that element moved.
+    arma::cube candidates(iterate.n_rows, iterate.n_cols, length);
+    for (size_t j = 0; j < length; ++j)
+    {
+      candidates.slice(j) = iterate;
+      candidates.slice(j)[idx + j] += moves[j];
+    }
+
+    arma::vec objectives;
+    TryEvaluateBatch(function, candidates, objectives);
+
+    // Take the first candidate accepted by the Metropolis criterion; the
+    // elements before it count as rejected moves, and those after it are
+    // dropped and moved again in the next block.
+    size_t moved = length;
+    for (size_t j = 0; j < length; ++j)
+    {
+      const double xi = uniform();
+      const double delta = objectives[j] - prevEnergy;
+      const double criterion = std::exp(-delta / currentTemperature);
+      if (delta <= 0. || criterion > xi)
+      {
+        iterate[idx + j] += moves[j];
+        energy = objectives[j];
+        accept[idx + j] += 1.;
+        moved = j + 1;
+        break;
+      }
+    }
+
+    FinishMove(function, iterate, accept, moveSize, energy, idx, sweepCounter,
+        moved);
+    return moved;
   }
 
-  ++idx;
+  // Move the whole block and accept or reject it at once.
+  arma::vec block(iterate.memptr() + idx, length, false, true);
+  const arma::vec prevValues(block);
+  block += moves;
+
+  const double newEnergy = function.Evaluate(iterate);
+  const double xi = uniform();
+  const double delta = newEnergy - prevEnergy;
+  const double criterion = std::exp(-delta / currentTemperature);
+  if (delta <= 0. || criterion > xi)
+  {
+    energy = newEnergy;
+    arma::vec blockAccept(accept.memptr() + idx, length, false, true);
+    blockAccept += 1.;
+  }
+  else
+  {
+    block = prevValues;
+  }
+
+  FinishMove(function, iterate, accept, moveSize, energy, idx, sweepCounter,
+      length);
+  return length;
+}
+
+//! Advance to the next parameter to move, and control the move sizes after
+//! moveCtrlSweep sweeps.
+template<typename CoolingScheduleType>
+template<typename FunctionType>
+void SA<CoolingScheduleType>::FinishMove(FunctionType& function,
+                                         const arma::mat& iterate,
+                                         arma::mat& accept,
+                                         arma::mat& moveSize,
+                                         double& energy,
+                                         size_t& idx,
+                                         size_t& sweepCounter,
+                                         const size_t moves)
+{
+  idx += moves;
   if (idx == iterate.n_elem) // Finished with a sweep.
   {
     idx = 0;
@@ -159,6 +459,11 @@ void SA<CoolingScheduleType>::GenerateMove(
   {
     MoveControl(moveCtrlSweep, accept, moveSize);
     sweepCounter = 0;
+
+    // The changes given by EvaluateDelta() accumulate rounding errors, so the
+    // energy is recomputed once in a while.
+    if (traits::HasDeltaEvaluation<FunctionType>::value)
+      energy = function.Evaluate(iterate);
   }
 }
 
@@ -179,7 +484,7 @@ void SA<CoolingScheduleType>::GenerateMove(
 template<typename CoolingScheduleType>
 inline void SA<CoolingScheduleType>::MoveControl(const size_t nMoves,
                                                  arma::mat& accept,
-                                                 arma::mat& moveSize)
+                                                 arma::mat& moveSize) const
 {
   arma::mat target;
   target.copy_size(accept);
@@ -0,0 +1,221 @@
+/**
+ * @file gradient_table.hpp
+ * @author Marcus Edel
+ *
+ * Storage of the gradients of each batch of separable functions for the SAGA
+ * optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_GRADIENT_TABLE_HPP
+#define ENSMALLEN_SAGA_GRADIENT_TABLE_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+
+namespace ens {
+
+/**
+ * GradientTable stores the last gradient computed for every batch of separable
+ * functions, along with their average.  The batches are contiguous ranges of
+ * batchSize functions, so the table takes (n / batchSize) times the size of the
+ * coordinates.
+ *
+ * If the function is a linear model (see traits::HasLinearModelGradient), the
+ * specialization below only stores one coefficient per separable function.
+ *
+ * @tparam FunctionType Type of the function to optimize.
+ */
+template<typename FunctionType,
+         bool LinearModel = traits::HasLinearModelGradient<FunctionType>::value>
+class GradientTable
+{
+ public:
+  /**
+   * Fill the table with the gradients of every batch at the given coordinates.
+   *
+   * @param function Function to optimize, wrapped in Function<>.
+   * @param iterate Coordinates to compute the gradients at.
+   * @param batchSize Number of separable functions in each batch.
+   * @return Sum of the objectives of the separable functions.
+   */
+  template<typename FullFunctionType>
+  double Initialize(FullFunctionType& function,
+                    const arma::mat& iterate,
+                    const size_t batchSize)
+  {
+    const size_t numFunctions = function.NumFunctions();
+    size_t numBatches = numFunctions / batchSize;
+    if (numFunctions % batchSize != 0)
+      ++numBatches; // Capture last few.
+
+    gradients.set_size(iterate.n_elem, numBatches);
+    arma::mat gradient;
+    double objective = 0;
+    for (size_t b = 0; b < numBatches; ++b)
+    {
+      const size_t begin = b * batchSize;
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+      objective += function.EvaluateWithGradient(iterate, begin, gradient,
+          effectiveBatchSize);
+      gradients.col(b) = arma::vectorise(gradient);
+    }
+
+    average = arma::sum(gradients, 1) / (double) numFunctions;
+    average.reshape(iterate.n_rows, iterate.n_cols);
+    return objective;
+  }
+
+  /**
+   * Compute the gradient of the given batch at the given coordinates, store it
+   * in the table, and return the objective of the batch.
+   *
+   * @param function Function to optimize, wrapped in Function<>.
+   * @param iterate Coordinates to compute the gradient at.
+   * @param batch Index of the batch.
+   * @param begin Index of the first separable function of the batch.
+   * @param batchSize Number of separable functions in the batch.
+   * @param difference Matrix to store the difference between the new and the
+   *     stored gradient of the batch in.
+   * @param oldAverage Matrix to store the average of the stored gradients in,
+   *     before the gradient of the batch is replaced.
+   */
+  template<typename FullFunctionType>
+  double Step(FullFunctionType& function,
+              const arma::mat& iterate,
+              const size_t batch,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& difference,
+              arma::mat& oldAverage)
+  {
+    const double objective = function.EvaluateWithGradient(iterate, begin,
+        difference, batchSize);
+
+    // Replace the stored gradient by the new one, keeping the difference.
+    arma::mat stored(gradients.colptr(batch), iterate.n_rows, iterate.n_cols,
+        false, true);
+    difference -= stored;
+    stored += difference;
+
+    oldAverage = average;
+    average += difference / (double) function.NumFunctions();
+    return objective;
+  }
+
+ private:
+  //! The stored gradient of each batch, one per column.
+  arma::mat gradients;
+
+  //! The average of the stored gradients.
+  arma::mat average;
+};
+
+/**
+ * Specialization for linear models.  The gradient of each separable function is
+ * a coefficient times its feature vector, plus a term shared by all the
+ * separable functions that does not need to be stored; the table therefore only
+ * takes one scalar per separable function, plus the average of the stored
+ * feature terms.
+ */
+template<typename FunctionType>
+class GradientTable<FunctionType, true>
+{
+ public:
+  /**
+   * Fill the table with the coefficients of every separable function at the
+   * given coordinates.
+   *
+   * @param function Function to optimize.
+   * @param iterate Coordinates to compute the coefficients at.
+   * @param batchSize Number of separable functions per call to the function.
+   * @return Sum of the objectives of the separable functions.
+   */
+  template<typename FullFunctionType>
+  double Initialize(FullFunctionType& function,
+                    const arma::mat& iterate,
+                    const size_t batchSize)
+  {
+    const size_t numFunctions = function.NumFunctions();
+    coefficients.set_size(numFunctions);
+    average.zeros(iterate.n_rows, iterate.n_cols);
+
+    arma::rowvec batchCoefficients;
+    arma::mat gradient;
+    double objective = 0;
+    for (size_t begin = 0; begin < numFunctions; begin += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+      objective += function.EvaluateWithCoefficients(iterate, begin,
+          batchCoefficients, effectiveBatchSize);
+      function.LinearGradient(begin, batchCoefficients, gradient,
+          effectiveBatchSize);
+
+      coefficients.subvec(begin, begin + effectiveBatchSize - 1) =
+          batchCoefficients;
+      average += gradient;
+    }
+
+    average /= (double) numFunctions;
+    return objective;
+  }
+
+  /**
+   * Compute the coefficients of the given batch at the given coordinates, store
+   * them in the table, and return the objective of the batch.
+   *
+   * @param function Function to optimize.
+   * @param iterate Coordinates to compute the coefficients at.
+   * @param batch Index of the batch (unused).
+   * @param begin Index of the first separable function of the batch.
+   * @param batchSize Number of separable functions in the batch.
+   * @param difference Matrix to store the difference between the new and the
+   *     stored gradient of the batch in.
+   * @param oldAverage Matrix to store the average of the stored gradients in,
+   *     before the gradient of the batch is replaced.
+   */
+  template<typename FullFunctionType>
+  double Step(FullFunctionType& function,
+              const arma::mat& iterate,
+              const size_t /* batch */,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& difference,
+              arma::mat& oldAverage)
+  {
+    const double objective = function.EvaluateWithCoefficients(iterate, begin,
+        batchCoefficients, batchSize);
+
+    // The shared term is the same in the new and the stored gradients, so only
+    // the change of the coefficients contributes to the difference.
+    const size_t end = begin + batchSize - 1;
+    batchCoefficients -= coefficients.subvec(begin, end);
+    coefficients.subvec(begin, end) += batchCoefficients;
+    function.LinearGradient(begin, batchCoefficients, difference, batchSize);
+
+    // The stored gradients share the term at the current coordinates.
+    function.RegularizationGradient(iterate, oldAverage);
+    oldAverage += average;
+
+    average += difference / (double) function.NumFunctions();
+    return objective;
+  }
+
+ private:
+  //! The stored coefficient of each separable function.
+  arma::rowvec coefficients;
+
+  //! The average of the stored feature terms.
+  arma::mat average;
+
+  //! The coefficients of the current batch.
+  arma::rowvec batchCoefficients;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file sag_update.hpp
+ * @author Marcus Edel
+ *
+ * Biased update for the SAGA optimizer, which gives the stochastic average
+ * gradient (SAG) method.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAG_UPDATE_HPP
+#define ENSMALLEN_SAGA_SAG_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * SAG update policy.  The step is taken in the direction of the average of the
+ * stored gradients, once the gradients of the batch have been replaced:
+ *
+ * \f[
+ * g = \frac{1}{n} \sum_{j \in B} (\nabla f_j(x) - \nabla f_j(\phi_j)) +
+ *     \frac{1}{n} \sum_{i = 1}^{n} \nabla f_i(\phi_i).
+ * \f]
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Schmidt2017,
+ *   author  = {Schmidt, Mark and Le Roux, Nicolas and Bach, Francis},
+ *   title   = {Minimizing Finite Sums with the Stochastic Average Gradient},
+ *   journal = {Mathematical Programming},
+ *   volume  = {162},
+ *   number  = {1},
+ *   pages   = {83--112},
+ *   year    = {2017}
+ * }
+ * @endcode
+ */
+class SAGUpdate
+{
+ public:
+  /**
+   * Update step for SAG.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param difference Sum of the differences between the current and the
+   *     stored gradients of the functions of the batch.
+   * @param average Average of the stored gradients, before the gradients of
+   *     the batch are replaced.
+   * @param batchSize Batch size to be used for the given iteration.
+   * @param numFunctions Number of separable functions.
+   * @param stepSize Step size to be used for the given iteration.
+   */
+  void Update(arma::mat& iterate,
+              const arma::mat& difference,
+              const arma::mat& average,
+              const size_t /* batchSize */,
+              const size_t numFunctions,
+              const double stepSize)
+  {
+    iterate -= stepSize * (difference / (double) numFunctions + average);
+  }
+};
+
+} // namespace ens
+
+#endif
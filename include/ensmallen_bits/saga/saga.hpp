@@ -0,0 +1,190 @@
+/**
+ * @file saga.hpp
+ * @author Marcus Edel
+ *
+ * SAGA, an incremental gradient method with support for composite objectives,
+ * and the stochastic average gradient (SAG) method.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_HPP
+#define ENSMALLEN_SAGA_SAGA_HPP
+
+#include "saga_update.hpp"
+#include "sag_update.hpp"
+#include "gradient_table.hpp"
+
+namespace ens {
+
+/**
+ * SAGA is a variance reducing stochastic gradient method for minimizing a
+ * function which can be expressed as a sum of other functions.  Instead of
+ * computing a full gradient periodically like SVRG, it keeps the last gradient
+ * computed for every batch of functions, and corrects each stochastic gradient
+ * with the stored one; each step therefore only evaluates one batch.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Defazio2014,
+ *   author    = {Defazio, Aaron and Bach, Francis and Lacoste-Julien, Simon},
+ *   title     = {SAGA: A Fast Incremental Gradient Method With Support for
+ *                Non-Strongly Convex Composite Objectives},
+ *   booktitle = {Advances in Neural Information Processing Systems 27},
+ *   pages     = {1646--1654},
+ *   year      = {2014}
+ * }
+ * @endcode
+ *
+ * The gradients are stored for contiguous batches of batchSize functions, which
+ * takes (n / batchSize) times the size of the coordinates.  If the function is
+ * a linear model (see traits::HasLinearModelGradient), like
+ * LogisticRegressionFunction, only one scalar per separable function is stored
+ * instead.
+ *
+ * SAGA can optimize differentiable separable functions.  For more details, see
+ * the documentation on function types included with this distribution or on the
+ * ensmallen website.
+ *
+ * @tparam UpdatePolicyType update policy used by SAGAType during the iterative
+ *    update process (SAGAUpdate or SAGUpdate).
+ */
+template<typename UpdatePolicyType = SAGAUpdate>
+class SAGAType
+{
+ public:
+  /**
+   * Construct the SAGA optimizer with the given function and parameters. The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.  The
+   * maximum number of iterations refers to the maximum number of points that
+   * are processed (i.e., one iteration equals one point; one iteration does not
+   * equal one pass over the dataset).
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the batches are visited in a random order in each
+   *     pass; otherwise, each batch is visited in linear order.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   */
+  SAGAType(const double stepSize = 0.01,
+           const size_t batchSize = 32,
+           const size_t maxIterations = 100000,
+           const double tolerance = 1e-5,
+           const bool shuffle = true,
+           const UpdatePolicyType& updatePolicy = UpdatePolicyType());
+
+  /**
+   * Optimize the given function using SAGA. The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * The gradient of every batch is computed once at the starting point; the
+   * function is never shuffled, since the stored gradients refer to the
+   * functions by index.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType>
+  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for an iterate
+   * of the given size (see ens::MemoryEstimate()): the stored gradient of every
+   * batch (ceil(numFunctions / BatchSize()) buffers of the size of the
+   * iterate), and a few more buffers.  This bounds the memory of functions
+   * whose table only stores a coefficient per separable function (see
+   * GradientTable), which take numFunctions doubles instead.
+   *
+   * @param rows Number of rows of the iterate.
+   * @param cols Number of columns of the iterate.
+   * @param numFunctions Number of separable functions of the objective.
+   */
+  size_t MemoryEstimate(const size_t rows,
+                        const size_t cols,
+                        const size_t numFunctions) const;
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are visited in a random order.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are visited in a random order.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are visited in a random order.
+  bool shuffle;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+// Convenience typedefs.
+
+/**
+ * SAGA, with the unbiased update.
+ */
+using SAGA = SAGAType<SAGAUpdate>;
+
+/**
+ * Stochastic average gradient (SAG), with the biased update.
+ */
+using SAG = SAGAType<SAGUpdate>;
+
+} // namespace ens
+
+// Include implementation.
+#include "saga_impl.hpp"
+
+#endif
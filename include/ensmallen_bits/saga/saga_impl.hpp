@@ -0,0 +1,152 @@
+/**
+ * @file saga_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of SAGA and SAG.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_IMPL_HPP
+#define ENSMALLEN_SAGA_SAGA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "saga.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType>
+SAGAType<UpdatePolicyType>::SAGAType(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const UpdatePolicyType& updatePolicy) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicy(updatePolicy)
+{ /* Nothing to do. */ }
+
+template<typename UpdatePolicyType>
+size_t SAGAType<UpdatePolicyType>::MemoryEstimate(
+    const size_t rows,
+    const size_t cols,
+    const size_t numFunctions) const
+{
+  const size_t n = rows * cols;
+  const size_t numBatches = (numFunctions + std::max(batchSize, size_t(1)) -
+      1) / std::max(batchSize, size_t(1));
+
+  // The table, the difference, the average, the gradient of the batch and the
+  // order of the batches.
+  return (numBatches * n + 4 * n) * sizeof(double) +
+      numBatches * sizeof(arma::uword);
+}
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType>
+template<typename DecomposableFunctionType>
+double SAGAType<UpdatePolicyType>::Optimize(
+    DecomposableFunctionType& function, arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
+
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& fullFunction(static_cast<FullFunctionType&>(function));
+
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  // Find the number of batches.
+  size_t numBatches = numFunctions / batchSize;
+  if (numFunctions % batchSize != 0)
+    ++numBatches; // Capture last few.
+
+  // Store the gradients at the starting point; this pass also gives the
+  // objective of the first epoch.
+  GradientTable<DecomposableFunctionType> table;
+  double overallObjective = table.Initialize(fullFunction, iterate, batchSize);
+  double lastObjective = DBL_MAX;
+
+  // The order in which the batches are visited.
+  arma::uvec order = arma::linspace<arma::uvec>(0, numBatches - 1, numBatches);
+
+  // Now iterate!
+  arma::mat difference(iterate.n_rows, iterate.n_cols);
+  arma::mat average(iterate.n_rows, iterate.n_cols);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0, currentBatch = 0; i < actualMaxIterations;
+      /* incrementing done manually */)
+  {
+    // Is this iteration the start of a sequence?
+    if (currentBatch == 0)
+    {
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "SAGA: converged to " << overallObjective
+            << "; terminating  with failure.  Try a smaller step size?"
+            << std::endl;
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "SAGA: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+
+      // Determine order of visitation.
+      if (shuffle)
+        Random().Shuffle(order);
+    }
+
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t batch = order(currentBatch);
+    const size_t begin = batch * batchSize;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - begin);
+
+    // Replace the stored gradient of the batch and use the update policy to
+    // take a step.
+    overallObjective += table.Step(fullFunction, iterate, batch, begin,
+        effectiveBatchSize, difference, average);
+    updatePolicy.Update(iterate, difference, average, effectiveBatchSize,
+        numFunctions, stepSize);
+
+    i += effectiveBatchSize;
+    currentBatch = (currentBatch + 1) % numBatches;
+  }
+
+  ENS_INFO << "SAGA: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  // Calculate final objective.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += function.Evaluate(iterate, i, effectiveBatchSize);
+  }
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
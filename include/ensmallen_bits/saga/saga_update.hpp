@@ -0,0 +1,57 @@
+/**
+ * @file saga_update.hpp
+ * @author Marcus Edel
+ *
+ * Unbiased update for the SAGA optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_UPDATE_HPP
+#define ENSMALLEN_SAGA_SAGA_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * SAGA update policy.  The step is taken in the direction of the unbiased
+ * estimate of the gradient
+ *
+ * \f[
+ * g = \frac{1}{b} \sum_{j \in B} (\nabla f_j(x) - \nabla f_j(\phi_j)) +
+ *     \frac{1}{n} \sum_{i = 1}^{n} \nabla f_i(\phi_i)
+ * \f]
+ *
+ * where B is the batch, b its size, and \f$ \nabla f_i(\phi_i) \f$ the stored
+ * gradient of each separable function.
+ */
+class SAGAUpdate
+{
+ public:
+  /**
+   * Update step for SAGA.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param difference Sum of the differences between the current and the
+   *     stored gradients of the functions of the batch.
+   * @param average Average of the stored gradients, before the gradients of
+   *     the batch are replaced.
+   * @param batchSize Batch size to be used for the given iteration.
+   * @param numFunctions Number of separable functions.
+   * @param stepSize Step size to be used for the given iteration.
+   */
+  void Update(arma::mat& iterate,
+              const arma::mat& difference,
+              const arma::mat& average,
+              const size_t batchSize,
+              const size_t /* numFunctions */,
+              const double stepSize)
+  {
+    iterate -= stepSize * (difference / (double) batchSize + average);
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -67,6 +67,10 @@ class SARAHType
    *     function is visited in linear order.
    * @param updatePolicy Instantiated update policy used to adjust the given
    *     parameters.
+   * @param parallelFullGradient If true, compute the full gradient of each
+   *     outer iteration with several OpenMP threads.
+   * @param parallelBatchGradient If true, compute the gradients of each inner
+   *     step with several OpenMP threads (see BatchGradientPair()).
    */
   SARAHType(const double stepSize = 0.01,
             const size_t batchSize = 32,
@@ -74,7 +78,9 @@ class SARAHType
             const size_t innerIterations = 0,
             const double tolerance = 1e-5,
             const bool shuffle = true,
-            const UpdatePolicyType& updatePolicy = UpdatePolicyType());
+            const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+            const bool parallelFullGradient = false,
+            const bool parallelBatchGradient = false);
 
   /**
    * Optimize the given function using SARAH. The given starting point will be
@@ -124,6 +130,20 @@ class SARAHType
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
+  //! Get whether the full gradient is computed in parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether the full gradient is computed in parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get whether the gradients of the inner steps are computed in parallel.
+  bool ParallelBatchGradient() const { return parallelBatchGradient; }
+  //! Modify whether the gradients of the inner steps are computed in
+  //! parallel.
+  bool& ParallelBatchGradient() { return parallelBatchGradient; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -146,6 +166,15 @@ class SARAHType
 
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
+
+  //! Whether to compute the full gradient in parallel.
+  bool parallelFullGradient;
+
+  //! Whether to compute the gradients of the inner steps in parallel.
+  bool parallelBatchGradient;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 // Convenience typedefs.
@@ -27,14 +27,18 @@ SARAHType<UpdatePolicyType>::SARAHType(
     const size_t innerIterations,
     const double tolerance,
     const bool shuffle,
-    const UpdatePolicyType& updatePolicy) :
+    const UpdatePolicyType& updatePolicy,
+    const bool parallelFullGradient,
+    const bool parallelBatchGradient) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
     innerIterations(innerIterations),
     tolerance(tolerance),
     shuffle(shuffle),
-    updatePolicy(updatePolicy)
+    updatePolicy(updatePolicy),
+    parallelFullGradient(parallelFullGradient),
+    parallelBatchGradient(parallelBatchGradient)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -43,8 +47,13 @@ template<typename DecomposableFunctionType>
 double SARAHType<UpdatePolicyType>::Optimize(
     DecomposableFunctionType& function, arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   traits::CheckDecomposableFunctionTypeAPI<DecomposableFunctionType>();
 
+  typedef Function<DecomposableFunctionType> FullFunctionType;
+  FullFunctionType& fullFunction(static_cast<FullFunctionType&>(function));
+
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
 
@@ -60,7 +69,8 @@ double SARAHType<UpdatePolicyType>::Optimize(
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
   arma::mat v(iterate.n_rows, iterate.n_cols);
   arma::mat gradient0(iterate.n_rows, iterate.n_cols);
-  arma::mat iterate0;
+  arma::mat iterate0(iterate.n_rows, iterate.n_cols);
+  std::vector<arma::mat> chunkGradients;
 
   // Find the number of batches.
   size_t numBatches = numFunctions / batchSize;
@@ -71,17 +81,14 @@ double SARAHType<UpdatePolicyType>::Optimize(
       std::numeric_limits<size_t>::max() : maxIterations;
   for (size_t i = 0; i < actualMaxIterations; ++i)
   {
-    // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
-    {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate, f, effectiveBatchSize);
-    }
+    // Calculate the objective function and the full gradient (v) in one
+    // pass.
+    overallObjective = FullEvaluateWithGradient(fullFunction, iterate,
+        batchSize, v, gradient, parallelFullGradient);
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
-      Warn << "SARAH: converged to " << overallObjective
+      ENS_WARN << "SARAH: converged to " << overallObjective
           << "; terminating  with failure.  Try a smaller step size?"
           << std::endl;
       return overallObjective;
@@ -89,29 +96,13 @@ double SARAHType<UpdatePolicyType>::Optimize(
 
     if (std::abs(lastObjective - overallObjective) < tolerance)
     {
-      Info << "SARAH: minimized within tolerance " << tolerance
+      ENS_INFO << "SARAH: minimized within tolerance " << tolerance
           << "; terminating optimization." << std::endl;
       return overallObjective;
     }
 
     lastObjective = overallObjective;
 
-    // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, v, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
-    {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
-
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      v += gradient;
-
-      f += effectiveBatchSize;
-    }
-    v /= (double) numFunctions;
-
     // Update iterate with full gradient (v).
     iterate -= stepSize * v;
 
@@ -131,17 +122,16 @@ double SARAHType<UpdatePolicyType>::Optimize(
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
-
-      // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
 
       // Avoid an unnecessary copy on the first iteration.
       if (f > 0)
       {
-        function.Gradient(iterate0, currentFunction, gradient0,
-            effectiveBatchSize);
+        // Calculate variance reduced gradient.
+        BatchGradientPair(fullFunction, iterate, iterate0, currentFunction,
+            effectiveBatchSize, gradient, gradient0, chunkGradients,
+            parallelBatchGradient);
 
         // Store current parameter for the calculation of the variance reduced
         // gradient.
@@ -156,6 +146,9 @@ double SARAHType<UpdatePolicyType>::Optimize(
       }
       else
       {
+        function.Gradient(iterate, currentFunction, gradient,
+            effectiveBatchSize);
+
         // Store current parameter for the calculation of the variance reduced
         // gradient.
         iterate0 = iterate;
@@ -173,7 +166,7 @@ double SARAHType<UpdatePolicyType>::Optimize(
     }
   }
 
-  Info << "SARAH: maximum iterations (" << maxIterations << ") reached; "
+  ENS_INFO << "SARAH: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
 
   // Calculate final objective.
@@ -13,6 +13,8 @@
 #ifndef ENSMALLEN_SARAH_SARAH_PLUS_UPDATE_HPP
 #define ENSMALLEN_SARAH_SARAH_PLUS_UPDATE_HPP
 
+#include "sarah_update.hpp"
+
 namespace ens {
 
 /**
@@ -51,13 +53,12 @@ class SARAHPlusUpdate
               const double stepSize,
               const double vNorm)
   {
-    v += (gradient - gradient0) / (double) batchSize;
-    iterate -= stepSize * v;
-
-    if (arma::norm(v) <= gamma * vNorm)
-      return true;
-
-    return false;
+    // The squared norm of v comes with the step, so the test needs no extra
+    // pass over the parameters.
+    const double squaredNorm = SARAHStep(iterate, v, gradient, gradient0,
+        batchSize, stepSize);
+    const double threshold = gamma * vNorm;
+    return (threshold >= 0.0) && (squaredNorm <= threshold * threshold);
   }
 
  private:
@@ -1,5 +1,5 @@
 /**
- * @file svrg_update.hpp
+ * @file sarah_update.hpp
  * @author Marcus Edel
  *
  * Vanilla update for SARAH.
@@ -14,6 +14,45 @@
 
 namespace ens {
 
+/**
+ * Take a SARAH step in one pass over the parameters: update the recursive
+ * gradient v with the difference of the batch gradients, move the iterate in
+ * the negative direction of v, and return the squared norm of the new v, so
+ * that a termination test on it costs nothing more.
+ *
+ * @param iterate Parameters that minimize the function.
+ * @param v Recursive estimator of the gradient.
+ * @param gradient The current gradient matrix at time t.
+ * @param gradient0 The old gradient matrix at time t - 1.
+ * @param batchSize Batch size to be used for the given iteration.
+ * @param stepSize Step size to be used for the given iteration.
+ * @return Squared norm of the updated v.
+ */
+inline double SARAHStep(arma::mat& iterate,
+                        arma::mat& v,
+                        const arma::mat& gradient,
+                        const arma::mat& gradient0,
+                        const size_t batchSize,
+                        const double stepSize)
+{
+  const double scale = 1.0 / (double) batchSize;
+  double* x = iterate.memptr();
+  double* vMem = v.memptr();
+  const double* g = gradient.memptr();
+  const double* g0 = gradient0.memptr();
+
+  double squaredNorm = 0.0;
+  for (size_t i = 0; i < v.n_elem; ++i)
+  {
+    const double vi = vMem[i] + (g[i] - g0[i]) * scale;
+    vMem[i] = vi;
+    x[i] -= stepSize * vi;
+    squaredNorm += vi * vi;
+  }
+
+  return squaredNorm;
+}
+
 /**
  * Vanilla update policy for SARAH.
  */
@@ -40,8 +79,7 @@ class SARAHUpdate
               const double stepSize,
               const double /* vNorm */)
   {
-    v += (gradient - gradient0) / (double) batchSize;
-    iterate -= stepSize * v;
+    SARAHStep(iterate, v, gradient, gradient0, batchSize, stepSize);
     return false;
   }
 };
@@ -0,0 +1,195 @@
+/**
+ * @file accelerated_scd.hpp
+ * @author Marcus Edel
+ *
+ * Accelerated, parallel and importance sampled randomized coordinate descent
+ * (APPROX).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_ACCELERATED_SCD_HPP
+#define ENSMALLEN_SCD_ACCELERATED_SCD_HPP
+
+namespace ens {
+
+/**
+ * AcceleratedSCD is a randomized coordinate descent with Nesterov's
+ * acceleration for smooth convex partially differentiable functions.  Each
+ * coordinate j has its own step size 1 / v_j, given by the Lipschitz constant
+ * L_j of the partial gradient of the coordinate, and the coordinates are drawn
+ * with probabilities proportional to L_j^alpha, so that the coordinates with
+ * the largest curvature are visited the most.
+ *
+ * With theta_0 = min_j p_j, where p_j is the probability that coordinate j is
+ * updated in a step, the iteration is
+ *
+ *   y = (1 - theta) x + theta z,
+ *   z_j <- z_j - p_j / (theta v_j) f'_j(y)     for each drawn coordinate j,
+ *   x <- y + theta / p_j (z_j^new - z_j)       for each drawn coordinate j,
+ *   theta <- (sqrt(theta^4 + 4 theta^2) - theta^2) / 2,
+ *
+ * which converges as O(1 / k^2) instead of O(1 / k) for plain coordinate
+ * descent.  The iterates are kept as y = theta^2 u + z and x = theta_old^2 u +
+ * z, so that a step only changes u and z on the drawn coordinates.  For more
+ * information, see the following.
+ *
+ * @code
+ * @article{fercoq2015accelerated,
+ *   title   = {Accelerated, Parallel, and Proximal Coordinate Descent},
+ *   author  = {Fercoq, Olivier and Richt{\'a}rik, Peter},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {25},
+ *   number  = {4},
+ *   pages   = {1997--2023},
+ *   year    = {2015}
+ * }
+ *
+ * @inproceedings{allen2016even,
+ *   title     = {Even Faster Accelerated Coordinate Descent Using Non-Uniform
+ *                Sampling},
+ *   author    = {Allen-Zhu, Zeyuan and Qu, Zheng and Richt{\'a}rik, Peter and
+ *                Yuan, Yang},
+ *   booktitle = {Proceedings of the 33rd International Conference on Machine
+ *                Learning},
+ *   pages     = {1110--1119},
+ *   year      = {2016}
+ * }
+ * @endcode
+ *
+ * As in the parallel mode of SCD, several coordinates can be drawn at each
+ * step, and their partial gradients are then computed in parallel at y.  When
+ * up to tau coordinates are updated at once, v_j = tau L_j, which is safe for
+ * any convex function; a step then costs tau partial gradients.
+ *
+ * If no Lipschitz constants are given, they are estimated at the starting
+ * point, from the change of the partial gradient of each coordinate along a
+ * small step; this is exact for quadratic coordinates, and for functions
+ * whose curvature is largest at the starting point (e.g. logistic regression
+ * started at zero).
+ *
+ * AcceleratedSCD can optimize partially differentiable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class AcceleratedSCD
+{
+ public:
+  /**
+   * Construct the accelerated SCD optimizer with the given parameters.  The
+   * maximum number of iterations refers to the maximum number of coordinate
+   * updates.
+   *
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *    limit).
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   * @param updateInterval The interval at which the objective is to be
+   *    reported and checked for convergence.
+   * @param lipschitz Lipschitz constant of the partial gradient of each
+   *    feature; if empty, the constants are estimated at the starting point.
+   * @param samplingExponent The features are drawn with probabilities
+   *    proportional to their Lipschitz constants to this power (0 means
+   *    uniform sampling).
+   * @param parallelism Number of coordinates drawn at once, whose partial
+   *    gradients are computed in parallel with OpenMP (0 means one per
+   *    thread).
+   */
+  AcceleratedSCD(const size_t maxIterations = 100000,
+                 const double tolerance = 1e-5,
+                 const size_t updateInterval = 1e3,
+                 const arma::vec& lipschitz = arma::vec(),
+                 const double samplingExponent = 0.5,
+                 const size_t parallelism = 1);
+
+  /**
+   * Optimize the given function using accelerated coordinate descent.  The
+   * given starting point will be modified to store the finishing point of the
+   * optimization, and the final objective value is returned.
+   *
+   * @tparam ResolvableFunctionType Type of the function to be optimized.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @return Objective value at the final point.
+   */
+  template<typename ResolvableFunctionType>
+  double Optimize(ResolvableFunctionType& function, arma::mat& iterate);
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the update interval for reporting objective.
+  size_t UpdateInterval() const { return updateInterval; }
+  //! Modify the update interval for reporting objective.
+  size_t& UpdateInterval() { return updateInterval; }
+
+  //! Get the given Lipschitz constants (empty if they are estimated).
+  const arma::vec& Lipschitz() const { return lipschitz; }
+  //! Modify the given Lipschitz constants (empty if they are estimated).
+  arma::vec& Lipschitz() { return lipschitz; }
+
+  //! Get the exponent of the Lipschitz constants in the sampling weights.
+  double SamplingExponent() const { return samplingExponent; }
+  //! Modify the exponent of the Lipschitz constants in the sampling weights.
+  double& SamplingExponent() { return samplingExponent; }
+
+  //! Get the number of coordinates drawn at once (0 means one per thread).
+  size_t Parallelism() const { return parallelism; }
+  //! Modify the number of coordinates drawn at once (0 means one per
+  //! thread).
+  size_t& Parallelism() { return parallelism; }
+
+  //! Get the Lipschitz constants used by the last call to Optimize().
+  const arma::vec& CoordinateLipschitz() const { return coordinateLipschitz; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Estimate the Lipschitz constant of the partial gradient of each feature at
+   * the given coordinates.
+   */
+  template<typename ResolvableFunctionType>
+  void EstimateLipschitz(ResolvableFunctionType& function,
+                         const arma::mat& coordinates);
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The update interval for reporting objective and testing for convergence.
+  size_t updateInterval;
+
+  //! The given Lipschitz constants.
+  arma::vec lipschitz;
+
+  //! The exponent of the Lipschitz constants in the sampling weights.
+  double samplingExponent;
+
+  //! The number of coordinates drawn at once.
+  size_t parallelism;
+
+  //! The Lipschitz constants used by the last optimization.
+  arma::vec coordinateLipschitz;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "accelerated_scd_impl.hpp"
+
+#endif
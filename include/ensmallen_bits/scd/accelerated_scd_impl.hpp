@@ -0,0 +1,260 @@
+/**
+ * @file accelerated_scd_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of accelerated, parallel and importance sampled randomized
+ * coordinate descent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_ACCELERATED_SCD_IMPL_HPP
+#define ENSMALLEN_SCD_ACCELERATED_SCD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "accelerated_scd.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline AcceleratedSCD::AcceleratedSCD(const size_t maxIterations,
+                                      const double tolerance,
+                                      const size_t updateInterval,
+                                      const arma::vec& lipschitz,
+                                      const double samplingExponent,
+                                      const size_t parallelism) :
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    updateInterval(updateInterval),
+    lipschitz(lipschitz),
+    samplingExponent(samplingExponent),
+    parallelism(parallelism)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename ResolvableFunctionType>
+double AcceleratedSCD::Optimize(ResolvableFunctionType& function,
+                                arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Make sure we have the methods that we need.
+  traits::CheckResolvableFunctionTypeAPI<ResolvableFunctionType>();
+
+  const size_t numFeatures = function.NumFeatures();
+
+  if (lipschitz.is_empty())
+  {
+    EstimateLipschitz(function, iterate);
+  }
+  else if (lipschitz.n_elem != numFeatures)
+  {
+    std::ostringstream oss;
+    oss << "AcceleratedSCD::Optimize(): " << lipschitz.n_elem << " Lipschitz "
+        << "constants were given, but the function has " << numFeatures
+        << " features!";
+    throw std::invalid_argument(oss.str());
+  }
+  else
+  {
+    coordinateLipschitz = lipschitz;
+  }
+
+  // A feature whose partial gradient does not change would get an infinite
+  // step; it is given a tiny fraction of the largest constant instead.
+  const double maxLipschitz = coordinateLipschitz.max();
+  if (!(maxLipschitz > 0.0))
+    coordinateLipschitz.ones();
+  else
+    coordinateLipschitz.clamp(1e-8 * maxLipschitz, maxLipschitz);
+
+  // Find the number of coordinates to draw at once.
+  size_t numUpdates = parallelism;
+  if (numUpdates == 0)
+  {
+    numUpdates = 1;
+    #ifdef ENS_USE_OPENMP
+      numUpdates = omp_get_max_threads();
+    #endif
+  }
+
+  // Each of the numUpdates draws picks feature j with probability q_j, so that
+  // feature j is updated in a step with probability p_j = 1 - (1 - q_j)^tau.
+  // Whatever features are drawn, the steps of at most tau features are safe
+  // with v_j = tau L_j.
+  arma::vec weights = arma::pow(coordinateLipschitz, samplingExponent);
+  ImportanceSampler sampler(0, 0.0);
+  sampler.Reset(weights);
+
+  arma::vec probabilities(numFeatures);
+  arma::vec stepScales(numFeatures);
+  for (size_t j = 0; j < numFeatures; ++j)
+  {
+    probabilities[j] = 1.0 - std::pow(1.0 - sampler.Probability(j),
+        (double) numUpdates);
+    stepScales[j] = probabilities[j] / (numUpdates * coordinateLipschitz[j]);
+  }
+
+  double theta = probabilities.min();
+  double lastTheta = theta;
+
+  // The points are y = theta^2 u + z and x = lastTheta^2 u + z.
+  arma::mat u(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  arma::mat z(iterate);
+  arma::mat point(iterate);
+
+  // The coordinates of the current step, and the partial gradient column of
+  // each.  The sparse buffers are only used by functions without a dense
+  // PartialGradient() overload.
+  std::vector<size_t> features;
+  features.reserve(numUpdates);
+  std::vector<arma::vec> gradients(numUpdates);
+  std::vector<arma::sp_mat> buffers(numUpdates);
+
+  double overallObjective = DBL_MAX;
+  double lastObjective = DBL_MAX;
+
+  // Start iterating; every updated coordinate counts as an iteration.
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 1; i < actualMaxIterations; /* incrementing done manually */)
+  {
+    const size_t stepUpdates = std::min(numUpdates, actualMaxIterations - i);
+
+    // Draw the coordinates to descend on; a coordinate drawn twice is only
+    // updated once.
+    features.clear();
+    for (size_t k = 0; k < stepUpdates; ++k)
+    {
+      const size_t featureIdx = sampler.Sample();
+      if (std::find(features.begin(), features.end(), featureIdx) ==
+          features.end())
+        features.push_back(featureIdx);
+    }
+
+    // The partial gradients are taken at y, which changes everywhere when
+    // theta changes; forming it costs less than a partial gradient of a
+    // function that needs a pass over its data.
+    point = theta * theta * u + z;
+
+    if (features.size() == 1)
+    {
+      PartialGradientColumn(function, point, features[0], gradients[0],
+          buffers[0]);
+    }
+    else
+    {
+      // Compute all the partial gradients at y.
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        for (size_t k = threadId; k < features.size(); k += numThreads)
+        {
+          PartialGradientColumn(function, point, features[k], gradients[k],
+              buffers[k]);
+        }
+      }
+    }
+
+    // Each partial gradient is turned into the change t of z; the change of u
+    // keeps x = y + theta / p_j t on the feature.
+    for (size_t k = 0; k < features.size(); ++k)
+    {
+      const size_t j = features[k];
+      gradients[k] *= -stepScales[j] / theta;
+      z.col(j) += gradients[k];
+      u.col(j) -= ((1.0 - theta / probabilities[j]) / (theta * theta)) *
+          gradients[k];
+    }
+
+    lastTheta = theta;
+    const double theta2 = theta * theta;
+    theta = (std::sqrt(theta2 * theta2 + 4.0 * theta2) - theta2) / 2.0;
+
+    const size_t firstIteration = i;
+    const size_t lastIteration = i + stepUpdates - 1;
+    i += stepUpdates;
+
+    // Check for convergence whenever this step reached a multiple of the
+    // update interval.
+    if (lastIteration / updateInterval != (firstIteration - 1) / updateInterval)
+    {
+      point = lastTheta * lastTheta * u + z;
+      overallObjective = function.Evaluate(point);
+
+      // Output current objective function.
+      ENS_INFO << "AcceleratedSCD: iteration " << lastIteration
+          << ", objective " << overallObjective << "." << std::endl;
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "AcceleratedSCD: converged to " << overallObjective
+            << "; terminating with failure.  Try smaller steps (larger "
+            << "Lipschitz constants)?" << std::endl;
+        iterate = point;
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "AcceleratedSCD: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        iterate = point;
+        return overallObjective;
+      }
+
+      lastObjective = overallObjective;
+    }
+  }
+
+  ENS_INFO << "AcceleratedSCD: maximum iterations (" << maxIterations
+      << ") reached; terminating optimization." << std::endl;
+
+  // Calculate and return final objective.
+  iterate = lastTheta * lastTheta * u + z;
+  return function.Evaluate(iterate);
+}
+
+template<typename ResolvableFunctionType>
+void AcceleratedSCD::EstimateLipschitz(ResolvableFunctionType& function,
+                                       const arma::mat& coordinates)
+{
+  const size_t numFeatures = function.NumFeatures();
+  coordinateLipschitz.set_size(numFeatures);
+
+  // The partial gradient of each feature is computed at the coordinates and
+  // after a small step of every element of the feature.
+  arma::mat point(coordinates);
+  arma::vec gradient, stepGradient;
+  arma::sp_mat buffer;
+  for (size_t j = 0; j < numFeatures; ++j)
+  {
+    PartialGradientColumn(function, point, j, gradient, buffer);
+
+    const double step = 1e-4 * std::max(1.0,
+        arma::norm(coordinates.col(j), "inf"));
+    point.col(j) += step;
+    PartialGradientColumn(function, point, j, stepGradient, buffer);
+    point.col(j) = coordinates.col(j);
+
+    coordinateLipschitz[j] = arma::norm(stepGradient - gradient) /
+        (step * std::sqrt((double) coordinates.n_rows));
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_SCD_DESCENT_POLICIES_GREEDY_HPP
 #define ENSMALLEN_SCD_DESCENT_POLICIES_GREEDY_HPP
 
+#include <ensmallen_bits/function.hpp>
+
 namespace ens {
 
 /**
@@ -53,11 +55,13 @@ class GreedyDescent
   {
     size_t bestFeature = 0;
     double bestDescent = 0;
+
+    // The buffers are reused for every feature.
+    arma::vec fGrad;
+    arma::sp_mat buffer;
     for (size_t i = 0; i < function.NumFeatures(); ++i)
     {
-      arma::sp_mat fGrad;
-
-      function.PartialGradient(iterate, i, fGrad);
+      PartialGradientColumn(function, iterate, i, fGrad, buffer);
 
       double descent = arma::accu(fGrad);
       if (descent > bestDescent)
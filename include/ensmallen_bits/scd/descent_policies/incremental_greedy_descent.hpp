@@ -0,0 +1,204 @@
+/**
+ * @file incremental_greedy_descent.hpp
+ * @author Marcus Edel
+ *
+ * Greedy descent policy for Stochastic Coordinate Descent (SCD) that keeps the
+ * partial gradient magnitudes in a max-heap.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_DESCENT_POLICIES_INCREMENTAL_GREEDY_HPP
+#define ENSMALLEN_SCD_DESCENT_POLICIES_INCREMENTAL_GREEDY_HPP
+
+#include <vector>
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * Incremental greedy descent policy for Stochastic Co-ordinate Descent(SCD).
+ * Like GreedyDescent, this policy picks the co-ordinate with the largest
+ * partial gradient (the Gauss-Southwell rule), but instead of computing every
+ * partial gradient at each iteration, the squared norms of the partial
+ * gradients are kept in an indexed max-heap.  After each step only the partial
+ * gradients that depend on the updated co-ordinate are recomputed and moved in
+ * the heap, so that an iteration costs O(k log d) for k affected features out
+ * of d.
+ *
+ * The affected features are given by the AffectedFeatures() method of the
+ * function, if it has one (see the documentation on partially differentiable
+ * functions); otherwise every partial gradient is recomputed at each iteration.
+ *
+ * The heap is rebuilt from scratch when the iteration number does not increase
+ * (that is, at the start of a new optimization) or when the number of features
+ * changes.
+ */
+class IncrementalGreedyDescent
+{
+ public:
+  //! Construct the policy; the heap is built on the first call.
+  IncrementalGreedyDescent() : lastIteration(0), lastFeature(0) { }
+
+  /**
+   * The DescentFeature method is used to get the descent coordinate for the
+   * current iteration.  The coordinate returned by the previous call is
+   * assumed to have been updated since.
+   *
+   * @tparam ResolvableFunctionType The type of the function to be optimized.
+   * @param iteration The iteration number for which the feature is to be
+   *    obtained.
+   * @param iterate The current value of the decision variable.
+   * @param function The function to be optimized.
+   * @return The index of the coordinate to be descended.
+   */
+  template <typename ResolvableFunctionType>
+  size_t DescentFeature(const size_t iteration,
+                        const arma::mat& iterate,
+                        ResolvableFunctionType& function)
+  {
+    const size_t numFeatures = function.NumFeatures();
+    if (heap.size() != numFeatures || iteration <= lastIteration)
+    {
+      // Compute every partial gradient and build the heap in linear time.
+      magnitudes.set_size(numFeatures);
+      heap.resize(numFeatures);
+      position.resize(numFeatures);
+      for (size_t i = 0; i < numFeatures; ++i)
+      {
+        magnitudes(i) = Magnitude(iterate, function, i);
+        heap[i] = i;
+        position[i] = i;
+      }
+
+      for (size_t i = numFeatures / 2; i > 0; --i)
+        SiftDown(i - 1);
+    }
+    else if (TryAffectedFeatures(function, lastFeature, affected))
+    {
+      // The updated feature itself always has to be refreshed.
+      Update(lastFeature, Magnitude(iterate, function, lastFeature));
+      for (size_t i = 0; i < affected.n_elem; ++i)
+      {
+        if (affected(i) != lastFeature)
+          Update(affected(i), Magnitude(iterate, function, affected(i)));
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < numFeatures; ++i)
+        Update(i, Magnitude(iterate, function, i));
+    }
+
+    lastIteration = iteration;
+    lastFeature = heap[0];
+    return lastFeature;
+  }
+
+  //! Get the squared norms of the partial gradients of the last call.
+  const arma::vec& Magnitudes() const { return magnitudes; }
+
+ private:
+  //! Compute the squared norm of the partial gradient of the given feature.
+  template <typename ResolvableFunctionType>
+  double Magnitude(const arma::mat& iterate,
+                   ResolvableFunctionType& function,
+                   const size_t feature)
+  {
+    PartialGradientColumn(function, iterate, feature, partialGradient,
+        sparseGradient);
+    return arma::dot(partialGradient, partialGradient);
+  }
+
+  //! Set the magnitude of the given feature and restore the heap order.
+  void Update(const size_t feature, const double magnitude)
+  {
+    const double oldMagnitude = magnitudes(feature);
+    magnitudes(feature) = magnitude;
+    if (magnitude > oldMagnitude)
+      SiftUp(position[feature]);
+    else if (magnitude < oldMagnitude)
+      SiftDown(position[feature]);
+  }
+
+  //! Move the entry at the given heap index up to its place.
+  void SiftUp(size_t index)
+  {
+    while (index > 0)
+    {
+      const size_t parent = (index - 1) / 2;
+      if (!Before(heap[index], heap[parent]))
+        break;
+
+      Swap(index, parent);
+      index = parent;
+    }
+  }
+
+  //! Move the entry at the given heap index down to its place.
+  void SiftDown(size_t index)
+  {
+    const size_t size = heap.size();
+    while (true)
+    {
+      const size_t left = 2 * index + 1;
+      const size_t right = left + 1;
+      size_t largest = index;
+      if (left < size && Before(heap[left], heap[largest]))
+        largest = left;
+      if (right < size && Before(heap[right], heap[largest]))
+        largest = right;
+      if (largest == index)
+        break;
+
+      Swap(index, largest);
+      index = largest;
+    }
+  }
+
+  //! Whether feature a comes before feature b; ties go to the lower index.
+  bool Before(const size_t a, const size_t b) const
+  {
+    return magnitudes(a) > magnitudes(b) ||
+        (magnitudes(a) == magnitudes(b) && a < b);
+  }
+
+  //! Swap the entries at the given heap indices.
+  void Swap(const size_t i, const size_t j)
+  {
+    std::swap(heap[i], heap[j]);
+    position[heap[i]] = i;
+    position[heap[j]] = j;
+  }
+
+  //! The squared norms of the partial gradients.
+  arma::vec magnitudes;
+
+  //! The features ordered as a binary max-heap on their magnitude.
+  std::vector<size_t> heap;
+
+  //! The index of each feature in the heap.
+  std::vector<size_t> position;
+
+  //! The iteration number of the last call.
+  size_t lastIteration;
+
+  //! The feature returned by the last call.
+  size_t lastFeature;
+
+  //! Buffer for the features affected by the last update.
+  arma::uvec affected;
+
+  //! Buffer for the partial gradient column, reused to avoid reallocations.
+  arma::vec partialGradient;
+
+  //! Buffer for functions without a dense PartialGradient() overload.
+  arma::sp_mat sparseGradient;
+};
+
+} // namespace ens
+
+#endif
@@ -52,8 +52,7 @@ class RandomDescent
                         const arma::mat& /* iterate */,
                         const ResolvableFunctionType& function)
   {
-    return arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, function.NumFeatures() - 1)));
+    return Random().Integer(function.NumFeatures());
   }
 };
 
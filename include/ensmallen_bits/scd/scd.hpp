@@ -15,6 +15,7 @@
 #include "descent_policies/cyclic_descent.hpp"
 #include "descent_policies/random_descent.hpp"
 #include "descent_policies/greedy_descent.hpp"
+#include "descent_policies/incremental_greedy_descent.hpp"
 
 namespace ens {
 
@@ -42,6 +43,26 @@ namespace ens {
  * }
  * @endcode
  *
+ * When the parallelism is larger than one, several coordinates are picked by
+ * the descent policy at each step and their partial gradients are computed in
+ * parallel at the same point, as in the Shotgun algorithm; this gives nearly
+ * linear speedups when the features are sparse and weakly correlated, but may
+ * diverge when they are strongly correlated.  This is meant for the
+ * RandomDescent and CyclicDescent policies.  For more information, see the
+ * following.
+ * @code
+ * @inproceedings{Bradley2011,
+ *   author    = {Bradley, Joseph K. and Kyrola, Aapo and Bickson, Danny and
+ *                Guestrin, Carlos},
+ *   title     = {Parallel Coordinate Descent for L1-Regularized Loss
+ *                Minimization},
+ *   booktitle = {Proceedings of the 28th International Conference on
+ *                Machine Learning},
+ *   series    = {ICML '11},
+ *   year      = {2011}
+ * }
+ * @endcode
+ *
  * SCD can optimize partially differentiable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -69,12 +90,16 @@ class SCD
    *    reported and checked for convergence.
    * @param descentPolicy The policy to use for picking up the coordinate to
    *    descend on.
+   * @param parallelism Number of coordinates updated at once, in parallel with
+   *    OpenMP (1 means one coordinate at a time; 0 means one coordinate per
+   *    thread).
    */
   SCD(const double stepSize = 0.01,
       const size_t maxIterations = 100000,
       const double tolerance = 1e-5,
       const size_t updateInterval = 1e3,
-      const DescentPolicyType descentPolicy = DescentPolicyType());
+      const DescentPolicyType descentPolicy = DescentPolicyType(),
+      const size_t parallelism = 1);
 
   /**
    * Optimize the given function using stochastic coordinate descent. The
@@ -114,6 +139,15 @@ class SCD
   //! Modify the descent policy.
   DescentPolicyType& DescentPolicy() { return descentPolicy; }
 
+  //! Get the number of coordinates updated at once (0 means one per thread).
+  size_t Parallelism() const { return parallelism; }
+  //! Modify the number of coordinates updated at once (0 means one per
+  //! thread).
+  size_t& Parallelism() { return parallelism; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -129,6 +163,12 @@ class SCD
 
   //! The descent policy used to pick the coordinates for the update.
   DescentPolicyType descentPolicy;
+
+  //! The number of coordinates updated at once.
+  size_t parallelism;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
@@ -15,6 +15,10 @@
 // In case it hasn't been included yet.
 #include "scd.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include <ensmallen_bits/function.hpp>
 
 namespace ens {
@@ -25,12 +29,14 @@ SCD<DescentPolicyType>::SCD(
     const size_t maxIterations,
     const double tolerance,
     const size_t updateInterval,
-    const DescentPolicyType descentPolicy) :
+    const DescentPolicyType descentPolicy,
+    const size_t parallelism) :
     stepSize(stepSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
     updateInterval(updateInterval),
-    descentPolicy(descentPolicy)
+    descentPolicy(descentPolicy),
+    parallelism(parallelism)
 { /* Nothing to do */ }
 
 //! Optimize the function (minimize).
@@ -39,45 +45,120 @@ template <typename ResolvableFunctionType>
 double SCD<DescentPolicyType>::Optimize(ResolvableFunctionType& function,
                                         arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   // Make sure we have the methods that we need.
   traits::CheckResolvableFunctionTypeAPI<ResolvableFunctionType>();
 
-  double overallObjective = 0;
+  // If the function keeps track of its objective as features are updated, the
+  // objective is never evaluated in full during the optimization.
+  typedef IncrementalObjective<ResolvableFunctionType> TrackedObjective;
+
+  double overallObjective = TrackedObjective::Initialize(function, iterate);
   double lastObjective = DBL_MAX;
 
-  arma::sp_mat gradient;
+  // Find the number of coordinates to update at once.
+  size_t numUpdates = parallelism;
+  if (numUpdates == 0)
+  {
+    numUpdates = 1;
+    #ifdef ENS_USE_OPENMP
+      numUpdates = omp_get_max_threads();
+    #endif
+  }
 
-  // Start iterating.
-  for (size_t i = 1; i != maxIterations; ++i)
+  // The coordinates of the current step, and the partial gradient column of
+  // each.  The sparse buffers are only used by functions without a dense
+  // PartialGradient() overload.
+  std::vector<size_t> features;
+  features.reserve(numUpdates);
+  std::vector<arma::vec> gradients(numUpdates);
+  std::vector<arma::sp_mat> buffers(numUpdates);
+
+  // Start iterating; every updated coordinate counts as an iteration.
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 1; i < actualMaxIterations; /* incrementing done manually */)
   {
-    // Get the coordinate to descend on.
-    size_t featureIdx = descentPolicy.DescentFeature(i, iterate, function);
+    const size_t stepUpdates = std::min(numUpdates, actualMaxIterations - i);
+
+    // Get the coordinates to descend on; a coordinate picked twice is only
+    // updated once.
+    features.clear();
+    for (size_t k = 0; k < stepUpdates; ++k)
+    {
+      const size_t featureIdx = descentPolicy.DescentFeature(i + k, iterate,
+          function);
+      if (std::find(features.begin(), features.end(), featureIdx) ==
+          features.end())
+        features.push_back(featureIdx);
+    }
+
+    if (features.size() == 1)
+    {
+      // Get the partial gradient with respect to this feature.
+      PartialGradientColumn(function, iterate, features[0], gradients[0],
+          buffers[0]);
+    }
+    else
+    {
+      // Compute all the partial gradients at the current point.
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        for (size_t k = threadId; k < features.size(); k += numThreads)
+        {
+          PartialGradientColumn(function, iterate, features[k], gradients[k],
+              buffers[k]);
+        }
+      }
+    }
 
-    // Get the partial gradient with respect to this feature.
-    function.PartialGradient(iterate, featureIdx, gradient);
+    // Update the decision variable with the partial gradients; each gradient
+    // is turned into the change of its feature.
+    for (size_t k = 0; k < features.size(); ++k)
+    {
+      gradients[k] *= -stepSize;
+      iterate.col(features[k]) += gradients[k];
+
+      if (TrackedObjective::Tracked)
+      {
+        overallObjective = TrackedObjective::Update(function, iterate,
+            features[k], gradients[k]);
+      }
+    }
 
-    // Update the decision variable with the partial gradient.
-    iterate.col(featureIdx) -= stepSize * gradient.col(featureIdx);
+    const size_t firstIteration = i;
+    const size_t lastIteration = i + stepUpdates - 1;
+    i += stepUpdates;
 
-    // Check for convergence.
-    if (i % updateInterval == 0)
+    // Check for convergence whenever this step reached a multiple of the
+    // update interval.
+    if (lastIteration / updateInterval != (firstIteration - 1) / updateInterval)
     {
-      overallObjective = function.Evaluate(iterate);
+      if (!TrackedObjective::Tracked)
+        overallObjective = function.Evaluate(iterate);
 
       // Output current objective function.
-      Info << "SCD: iteration " << i << ", objective " << overallObjective
-          << "." << std::endl;
+      ENS_INFO << "SCD: iteration " << lastIteration << ", objective "
+          << overallObjective << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
-        Warn << "SCD: converged to " << overallObjective << "; terminating"
+        ENS_WARN << "SCD: converged to " << overallObjective << "; terminating"
             << " with failure.  Try a smaller step size?" << std::endl;
         return overallObjective;
       }
 
       if (std::abs(lastObjective - overallObjective) < tolerance)
       {
-        Info << "SCD: minimized within tolerance " << tolerance << "; "
+        ENS_INFO << "SCD: minimized within tolerance " << tolerance << "; "
             << "terminating optimization." << std::endl;
         return overallObjective;
       }
@@ -86,7 +167,7 @@ double SCD<DescentPolicyType>::Optimize(ResolvableFunctionType& function,
     }
   }
 
-  Info << "SCD: maximum iterations (" << maxIterations << ") reached; "
+  ENS_INFO << "SCD: maximum iterations (" << maxIterations << ") reached; "
       << "terminating optimization." << std::endl;
 
   // Calculate and return final objective.
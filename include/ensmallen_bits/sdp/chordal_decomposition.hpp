@@ -0,0 +1,211 @@
+/**
+ * @file chordal_decomposition.hpp
+ * @author Marcus Edel
+ *
+ * Conversion of an SDP with a sparse aggregate sparsity pattern into a
+ * block-diagonal SDP with one block per maximal clique of a chordal extension
+ * of the pattern.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_HPP
+#define ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_HPP
+
+#include <set>
+#include <vector>
+
+#include "sdp.hpp"
+
+namespace ens {
+
+/**
+ * ChordalDecomposition converts an SDP whose aggregate sparsity pattern (the
+ * union of the non-zero entries of C and of all the Ai, and the diagonal) is
+ * sparse into an equivalent block-diagonal SDP, in which X is replaced by one
+ * smaller PSD block per maximal clique of a chordal extension of the pattern.
+ * The objective and the constraints only involve the entries of X on the
+ * pattern, and a partial matrix on a chordal pattern has a PSD completion if
+ * and only if all its blocks on the maximal cliques are PSD, so the two SDPs
+ * have the same optimal value.  This is the conversion method of Fukuda et al.
+ *
+ * The chordal extension comes from a minimum degree elimination ordering of
+ * the pattern, and the cliques are linked by a clique tree.  Every entry of C
+ * and of the Ai is moved to one clique that contains it, and the overlap of
+ * each clique with its parent in the tree is tied by the equality constraints
+ * X_k(i, j) = X_parent(i, j), which are enough for all the cliques to agree.
+ * For a pattern of bounded treewidth (such as a graph problem on a sparse
+ * graph), the cliques stay small, so that the solvers, which factorize and
+ * multiply each diagonal block separately (see SDP::BlockSizes()), only do
+ * work proportional to n instead of n^3 per iteration.
+ *
+ * The constraints of the decomposed SDP are all sparse, in this order: the
+ * sparse constraints of the SDP, then its dense constraints, then the
+ * coupling constraints; the low-rank constraints stay low-rank (the rows of
+ * the support of a factor Vi always fall in one clique).  Any block sizes of
+ * the SDP are ignored, since its pattern already describes them.  After the
+ * decomposed SDP is solved, CompleteX() (or PartialX()) gives the solution of
+ * the SDP, and Multipliers() the multipliers of its constraints.
+ *
+ * @code
+ * ChordalDecomposition<SDP<arma::sp_mat>> decomposition(sdp);
+ * PrimalDualSolver<SDP<arma::sp_mat>> solver(decomposition.Decomposed());
+ *
+ * arma::mat decomposedX, decomposedZ, X;
+ * arma::vec decomposedYSparse, decomposedYDense, ySparse, yDense;
+ * solver.Optimize(decomposedX, decomposedYSparse, decomposedYDense,
+ *     decomposedZ);
+ * decomposition.CompleteX(decomposedX, X);
+ * decomposition.Multipliers(decomposedYSparse, decomposedYDense, ySparse,
+ *     yDense);
+ * @endcode
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Fukuda2001,
+ *   title   = {Exploiting Sparsity in Semidefinite Programming via Matrix
+ *              Completion I: General Framework},
+ *   author  = {Fukuda, Mituhiro and Kojima, Masakazu and Murota, Kazuo and
+ *              Nakata, Kazuhide},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {11},
+ *   number  = {3},
+ *   pages   = {647--674},
+ *   year    = {2001}
+ * }
+ * @endcode
+ *
+ * @tparam SDPType Type of the SDP to decompose.
+ */
+template<typename SDPType>
+class ChordalDecomposition
+{
+ public:
+  /**
+   * Compute the chordal extension of the aggregate sparsity pattern of the
+   * given SDP and build the decomposed SDP.
+   *
+   * @param sdp SDP to decompose.
+   */
+  ChordalDecomposition(const SDPType& sdp);
+
+  //! Get the decomposed SDP, with one diagonal block per clique.
+  const SDP<arma::sp_mat>& Decomposed() const { return decomposed; }
+
+  //! Get the number of maximal cliques (the blocks of the decomposed SDP).
+  size_t NumCliques() const { return cliques.size(); }
+
+  //! Get the rows of X in each clique (in increasing order).
+  const std::vector<arma::uvec>& Cliques() const { return cliques; }
+
+  //! Get the parent of the given clique in the clique tree (NumCliques() for a
+  //! root).
+  size_t Parent(const size_t clique) const { return parents[clique]; }
+
+  //! Get the number of coupling constraints.
+  size_t NumCouplingConstraints() const { return numCoupling; }
+
+  /**
+   * Get the entries of the solution of the SDP on the chordal extension of its
+   * pattern (which are all the entries that the objective and the constraints
+   * depend on) from the solution of the decomposed SDP.  The other entries
+   * are zero, so the result is in general not PSD itself; see CompleteX().
+   *
+   * @param decomposedX Solution of the decomposed SDP.
+   */
+  arma::sp_mat PartialX(const arma::mat& decomposedX) const;
+
+  /**
+   * Compute the maximum determinant PSD completion of the partial solution
+   * (see PartialX()), clique by clique along the clique tree.  This gives a
+   * dense n x n solution of the SDP, so it takes O(n^2) memory.
+   *
+   * @param decomposedX Solution of the decomposed SDP.
+   * @param X Matrix to store the solution of the SDP in.
+   */
+  void CompleteX(const arma::mat& decomposedX, arma::mat& X) const;
+
+  /**
+   * Get the multipliers of the constraints of the SDP from those of the
+   * decomposed SDP, in the layout of PrimalDualSolver::Optimize(): ySparse
+   * holds the multipliers of the sparse constraints, and yDense those of the
+   * dense constraints followed by those of the low-rank constraints.
+   *
+   * @param decomposedYSparse Multipliers of the sparse constraints of the
+   *     decomposed SDP.
+   * @param decomposedYDense Multipliers of the dense and low-rank constraints
+   *     of the decomposed SDP.
+   * @param ySparse Vector to store the multipliers of the sparse constraints
+   *     in.
+   * @param yDense Vector to store the multipliers of the dense and low-rank
+   *     constraints in.
+   */
+  void Multipliers(const arma::vec& decomposedYSparse,
+                   const arma::vec& decomposedYDense,
+                   arma::vec& ySparse,
+                   arma::vec& yDense) const;
+
+ private:
+  //! Add the off-diagonal non-zero entries of the given matrix to the pattern.
+  void AddPattern(const arma::sp_mat& matrix,
+                  std::vector<std::set<size_t>>& pattern) const;
+
+  //! Find a minimum degree elimination ordering of the pattern and the cliques
+  //! of the chordal extension it gives.
+  void Eliminate(std::vector<std::set<size_t>>& pattern);
+
+  //! Get the row of the decomposed SDP of the given row of X in the given
+  //! clique.
+  size_t Row(const size_t clique, const size_t row) const;
+
+  //! Move the entries of the given n x n matrix to the cliques that own them.
+  arma::sp_mat Convert(const arma::sp_mat& matrix) const;
+
+  //! Check the size of the given solution of the decomposed SDP.
+  void CheckDecomposedX(const arma::mat& decomposedX,
+                        const std::string& method) const;
+
+  //! The number of rows of X.
+  size_t n;
+  //! The number of sparse constraints of the SDP.
+  size_t numSparse;
+  //! The number of dense constraints of the SDP.
+  size_t numDense;
+  //! The number of low-rank constraints of the SDP.
+  size_t numLowRank;
+  //! The number of coupling constraints.
+  size_t numCoupling;
+
+  //! The position of every row in the elimination ordering.
+  std::vector<size_t> position;
+  //! The neighbours of every row in the chordal extension that are eliminated
+  //! after it.
+  std::vector<std::vector<size_t>> higher;
+  //! The clique that owns the entries between every row and the rows of
+  //! higher.
+  std::vector<size_t> owner;
+
+  //! The rows of X in each clique.
+  std::vector<arma::uvec> cliques;
+  //! The parent of each clique in the clique tree.
+  std::vector<size_t> parents;
+  //! The rows that each clique shares with its parent.
+  std::vector<arma::uvec> separators;
+  //! The cliques, with every parent before its children.
+  std::vector<size_t> treeOrder;
+  //! The first row of each block of the decomposed SDP.
+  arma::uvec offsets;
+
+  //! The decomposed SDP.
+  SDP<arma::sp_mat> decomposed;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "chordal_decomposition_impl.hpp"
+
+#endif
@@ -0,0 +1,462 @@
+/**
+ * @file chordal_decomposition_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the chordal decomposition of an SDP.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_IMPL_HPP
+#define ENSMALLEN_SDP_CHORDAL_DECOMPOSITION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chordal_decomposition.hpp"
+
+#include <algorithm>
+
+namespace ens {
+
+template<typename SDPType>
+ChordalDecomposition<SDPType>::ChordalDecomposition(const SDPType& sdp) :
+    n(sdp.N()),
+    numSparse(sdp.NumSparseConstraints()),
+    numDense(sdp.NumDenseConstraints()),
+    numLowRank(sdp.NumLowRankConstraints()),
+    numCoupling(0)
+{
+  // The aggregate sparsity pattern of the SDP.
+  std::vector<std::set<size_t>> pattern(n);
+  const arma::sp_mat c(sdp.C());
+  AddPattern(c, pattern);
+  for (size_t i = 0; i < numSparse; ++i)
+    AddPattern(sdp.SparseA()[i], pattern);
+  for (size_t i = 0; i < numDense; ++i)
+    AddPattern(arma::sp_mat(sdp.DenseA()[i]), pattern);
+  for (size_t i = 0; i < numLowRank; ++i)
+  {
+    // The rows of the support of Vi are all linked in Vi Vi^T.
+    const arma::uvec support = arma::find(
+        arma::any(sdp.LowRankA()[i] != 0.0, 1));
+    for (size_t j = 0; j < support.n_elem; ++j)
+    {
+      for (size_t k = j + 1; k < support.n_elem; ++k)
+      {
+        pattern[support(j)].insert(support(k));
+        pattern[support(k)].insert(support(j));
+      }
+    }
+  }
+
+  Eliminate(pattern);
+
+  // One diagonal block per clique.
+  arma::uvec blockSizes(cliques.size());
+  offsets.set_size(cliques.size() + 1);
+  offsets(0) = 0;
+  for (size_t k = 0; k < cliques.size(); ++k)
+  {
+    blockSizes(k) = cliques[k].n_elem;
+    offsets(k + 1) = offsets(k) + cliques[k].n_elem;
+    numCoupling += separators[k].n_elem * (separators[k].n_elem + 1) / 2;
+  }
+
+  decomposed = SDP<arma::sp_mat>(blockSizes, numSparse + numDense +
+      numCoupling, 0, numLowRank);
+  decomposed.C() = Convert(c);
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    decomposed.SparseA()[i] = Convert(sdp.SparseA()[i]);
+    decomposed.SparseB()[i] = sdp.SparseB()[i];
+  }
+  for (size_t i = 0; i < numDense; ++i)
+  {
+    decomposed.SparseA()[numSparse + i] =
+        Convert(arma::sp_mat(sdp.DenseA()[i]));
+    decomposed.SparseB()[numSparse + i] = sdp.DenseB()[i];
+  }
+
+  // The support of a low-rank factor is a clique of the pattern, so it lies in
+  // the clique that owns the entries of its first eliminated row.
+  const size_t decomposedN = decomposed.N();
+  for (size_t i = 0; i < numLowRank; ++i)
+  {
+    const arma::mat& v = sdp.LowRankA()[i];
+    const arma::uvec support = arma::find(arma::any(v != 0.0, 1));
+    arma::mat& decomposedV = decomposed.LowRankA()[i];
+    decomposedV.zeros(decomposedN, v.n_cols);
+    if (!support.is_empty())
+    {
+      size_t first = support(0);
+      for (size_t j = 1; j < support.n_elem; ++j)
+      {
+        if (position[support(j)] < position[first])
+          first = support(j);
+      }
+
+      for (size_t j = 0; j < support.n_elem; ++j)
+        decomposedV.row(Row(owner[first], support(j))) = v.row(support(j));
+    }
+    decomposed.LowRankB()[i] = sdp.LowRankB()[i];
+  }
+
+  // Tie the entries that each clique shares with its parent.
+  size_t constraint = numSparse + numDense;
+  for (size_t k = 0; k < cliques.size(); ++k)
+  {
+    const arma::uvec& separator = separators[k];
+    for (size_t a = 0; a < separator.n_elem; ++a)
+    {
+      for (size_t b = a; b < separator.n_elem; ++b)
+      {
+        const size_t i = Row(k, separator(a));
+        const size_t j = Row(k, separator(b));
+        const size_t pi = Row(parents[k], separator(a));
+        const size_t pj = Row(parents[k], separator(b));
+
+        arma::sp_mat& A = decomposed.SparseA()[constraint];
+        A(i, j) = 1.0;
+        A(j, i) = 1.0;
+        A(pi, pj) = -1.0;
+        A(pj, pi) = -1.0;
+        decomposed.SparseB()[constraint] = 0.0;
+        ++constraint;
+      }
+    }
+  }
+}
+
+template<typename SDPType>
+void ChordalDecomposition<SDPType>::AddPattern(
+    const arma::sp_mat& matrix,
+    std::vector<std::set<size_t>>& pattern) const
+{
+  for (arma::sp_mat::const_iterator it = matrix.begin(); it != matrix.end();
+      ++it)
+  {
+    if (it.row() != it.col() && (*it) != 0.0)
+    {
+      pattern[it.row()].insert(it.col());
+      pattern[it.col()].insert(it.row());
+    }
+  }
+}
+
+template<typename SDPType>
+void ChordalDecomposition<SDPType>::Eliminate(
+    std::vector<std::set<size_t>>& pattern)
+{
+  position.assign(n, 0);
+  higher.assign(n, std::vector<size_t>());
+
+  // Eliminate the row of smallest degree in the remaining graph, and link its
+  // neighbours (the fill of the chordal extension).
+  std::set<std::pair<size_t, size_t>> degrees;
+  for (size_t v = 0; v < n; ++v)
+    degrees.insert(std::make_pair(pattern[v].size(), v));
+
+  std::vector<size_t> order(n);
+  for (size_t step = 0; step < n; ++step)
+  {
+    const size_t v = degrees.begin()->second;
+    degrees.erase(degrees.begin());
+    position[v] = step;
+    order[step] = v;
+
+    std::vector<size_t>& neighbours = higher[v];
+    neighbours.assign(pattern[v].begin(), pattern[v].end());
+    for (size_t a = 0; a < neighbours.size(); ++a)
+    {
+      const size_t u = neighbours[a];
+      degrees.erase(std::make_pair(pattern[u].size(), u));
+      pattern[u].erase(v);
+      for (size_t b = 0; b < neighbours.size(); ++b)
+      {
+        if (b != a)
+          pattern[u].insert(neighbours[b]);
+      }
+    }
+    for (size_t a = 0; a < neighbours.size(); ++a)
+      degrees.insert(std::make_pair(pattern[neighbours[a]].size(),
+          neighbours[a]));
+    pattern[v].clear();
+  }
+
+  // The parent of a row in the elimination tree is its first eliminated
+  // higher neighbour.
+  std::vector<size_t> rowParents(n, n);
+  std::vector<std::vector<size_t>> children(n);
+  for (size_t v = 0; v < n; ++v)
+  {
+    for (size_t a = 0; a < higher[v].size(); ++a)
+    {
+      if (rowParents[v] == n ||
+          position[higher[v][a]] < position[rowParents[v]])
+        rowParents[v] = higher[v][a];
+    }
+    if (rowParents[v] != n)
+      children[rowParents[v]].push_back(v);
+  }
+
+  // The set {v} + higher(v) is a clique of the chordal extension.  It is not
+  // maximal if and only if it is contained in the clique of a child u of v,
+  // i.e. higher(u) = {v} + higher(v); v then joins the clique of u.  The rows
+  // of a clique therefore form a path of the elimination tree, and the parent
+  // of the clique is the clique of the parent of the last row of the path.
+  owner.assign(n, 0);
+  std::vector<size_t> last;
+  cliques.clear();
+  for (size_t step = 0; step < n; ++step)
+  {
+    const size_t v = order[step];
+    size_t joined = n;
+    for (size_t a = 0; a < children[v].size(); ++a)
+    {
+      const size_t u = children[v][a];
+      if (higher[u].size() == higher[v].size() + 1)
+      {
+        joined = u;
+        break;
+      }
+    }
+
+    if (joined != n)
+    {
+      owner[v] = owner[joined];
+      last[owner[v]] = v;
+    }
+    else
+    {
+      owner[v] = cliques.size();
+      last.push_back(v);
+      arma::uvec clique(higher[v].size() + 1);
+      clique(0) = v;
+      for (size_t a = 0; a < higher[v].size(); ++a)
+        clique(a + 1) = higher[v][a];
+      cliques.push_back(arma::sort(clique));
+    }
+  }
+
+  // The last row of a clique is eliminated before the last row of its parent,
+  // so sorting the cliques by the position of their last row, backwards, puts
+  // every parent before its children.
+  treeOrder.resize(cliques.size());
+  for (size_t k = 0; k < cliques.size(); ++k)
+    treeOrder[k] = k;
+  std::sort(treeOrder.begin(), treeOrder.end(),
+      [&](const size_t a, const size_t b)
+      {
+        return position[last[a]] > position[last[b]];
+      });
+
+  parents.assign(cliques.size(), cliques.size());
+  separators.assign(cliques.size(), arma::uvec());
+  for (size_t k = 0; k < cliques.size(); ++k)
+  {
+    const size_t parent = rowParents[last[k]];
+    if (parent == n)
+      continue;
+
+    parents[k] = owner[parent];
+    const std::vector<size_t>& separator = higher[last[k]];
+    separators[k].set_size(separator.size());
+    for (size_t a = 0; a < separator.size(); ++a)
+      separators[k](a) = separator[a];
+    separators[k] = arma::sort(separators[k]);
+  }
+}
+
+template<typename SDPType>
+size_t ChordalDecomposition<SDPType>::Row(const size_t clique,
+                                          const size_t row) const
+{
+  const arma::uvec& rows = cliques[clique];
+  return offsets(clique) + (std::lower_bound(rows.begin(), rows.end(), row) -
+      rows.begin());
+}
+
+template<typename SDPType>
+arma::sp_mat ChordalDecomposition<SDPType>::Convert(
+    const arma::sp_mat& matrix) const
+{
+  arma::umat locations(2, matrix.n_nonzero);
+  arma::vec values(matrix.n_nonzero);
+  size_t nonzeros = 0;
+  for (arma::sp_mat::const_iterator it = matrix.begin(); it != matrix.end();
+      ++it)
+  {
+    if ((*it) == 0.0)
+      continue;
+
+    // The entry belongs to the clique of its first eliminated row.
+    const size_t i = it.row();
+    const size_t j = it.col();
+    const size_t k = owner[(position[i] <= position[j]) ? i : j];
+    locations(0, nonzeros) = Row(k, i);
+    locations(1, nonzeros) = Row(k, j);
+    values(nonzeros) = (*it);
+    ++nonzeros;
+  }
+
+  const size_t decomposedN = offsets(offsets.n_elem - 1);
+  return arma::sp_mat(locations.head_cols(nonzeros), values.head(nonzeros),
+      decomposedN, decomposedN);
+}
+
+template<typename SDPType>
+void ChordalDecomposition<SDPType>::CheckDecomposedX(
+    const arma::mat& decomposedX,
+    const std::string& method) const
+{
+  const size_t decomposedN = offsets(offsets.n_elem - 1);
+  if (decomposedX.n_rows != decomposedN || decomposedX.n_cols != decomposedN)
+  {
+    std::ostringstream oss;
+    oss << "ChordalDecomposition::" << method << "(): the solution of the "
+        << "decomposed SDP should be " << decomposedN << " x " << decomposedN
+        << ", but is " << decomposedX.n_rows << " x " << decomposedX.n_cols
+        << "!";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename SDPType>
+arma::sp_mat ChordalDecomposition<SDPType>::PartialX(
+    const arma::mat& decomposedX) const
+{
+  CheckDecomposedX(decomposedX, "PartialX");
+
+  // Every entry of the chordal extension is owned by the clique of its first
+  // eliminated row.
+  size_t nonzeros = 0;
+  for (size_t v = 0; v < n; ++v)
+    nonzeros += 2 * higher[v].size() + 1;
+
+  arma::umat locations(2, nonzeros);
+  arma::vec values(nonzeros);
+  size_t e = 0;
+  for (size_t v = 0; v < n; ++v)
+  {
+    const size_t k = owner[v];
+    const size_t i = Row(k, v);
+    locations(0, e) = v;
+    locations(1, e) = v;
+    values(e++) = decomposedX(i, i);
+    for (size_t a = 0; a < higher[v].size(); ++a)
+    {
+      const size_t u = higher[v][a];
+      const double value = decomposedX(i, Row(k, u));
+      locations(0, e) = v;
+      locations(1, e) = u;
+      values(e++) = value;
+      locations(0, e) = u;
+      locations(1, e) = v;
+      values(e++) = value;
+    }
+  }
+
+  return arma::sp_mat(locations, values, n, n);
+}
+
+template<typename SDPType>
+void ChordalDecomposition<SDPType>::CompleteX(const arma::mat& decomposedX,
+                                              arma::mat& X) const
+{
+  CheckDecomposedX(decomposedX, "CompleteX");
+
+  X.zeros(n, n);
+
+  // Each clique is visited after its parent, and adds its rows outside of the
+  // separator, whose entries with the rows known so far are those of the
+  // maximum determinant completion: X(N, O) = X(N, S) X(S, S)^+ X(S, O).
+  std::vector<arma::uword> known;
+  std::vector<bool> inSeparator(n, false);
+  for (size_t k = 0; k < treeOrder.size(); ++k)
+  {
+    const size_t clique = treeOrder[k];
+    const arma::uvec& rows = cliques[clique];
+    const arma::uvec& separator = separators[clique];
+    const arma::mat block = decomposedX.submat(offsets(clique), offsets(clique),
+        offsets(clique + 1) - 1, offsets(clique + 1) - 1);
+
+    for (size_t a = 0; a < separator.n_elem; ++a)
+      inSeparator[separator(a)] = true;
+
+    std::vector<arma::uword> newRows, newLocal, separatorLocal;
+    for (size_t a = 0; a < rows.n_elem; ++a)
+    {
+      if (inSeparator[rows(a)])
+      {
+        separatorLocal.push_back(a);
+      }
+      else
+      {
+        newRows.push_back(rows(a));
+        newLocal.push_back(a);
+      }
+    }
+
+    if (!separator.is_empty())
+    {
+      std::vector<arma::uword> others;
+      for (size_t a = 0; a < known.size(); ++a)
+      {
+        if (!inSeparator[known[a]])
+          others.push_back(known[a]);
+      }
+
+      if (!others.empty() && !newRows.empty())
+      {
+        const arma::uvec s(separatorLocal);
+        const arma::uvec nl(newLocal);
+        const arma::uvec o(others);
+        const arma::uvec nr(newRows);
+        const arma::mat cross = block.submat(nl, s) *
+            arma::pinv(block.submat(s, s)) * X.submat(separator, o);
+        X.submat(nr, o) = cross;
+        X.submat(o, nr) = cross.t();
+      }
+    }
+
+    X.submat(rows, rows) = block;
+    known.insert(known.end(), newRows.begin(), newRows.end());
+
+    for (size_t a = 0; a < separator.n_elem; ++a)
+      inSeparator[separator(a)] = false;
+  }
+}
+
+template<typename SDPType>
+void ChordalDecomposition<SDPType>::Multipliers(
+    const arma::vec& decomposedYSparse,
+    const arma::vec& decomposedYDense,
+    arma::vec& ySparse,
+    arma::vec& yDense) const
+{
+  if (decomposedYSparse.n_elem != numSparse + numDense + numCoupling ||
+      decomposedYDense.n_elem != numLowRank)
+  {
+    std::ostringstream oss;
+    oss << "ChordalDecomposition::Multipliers(): expected "
+        << (numSparse + numDense + numCoupling) << " sparse and " << numLowRank
+        << " dense multipliers, but got " << decomposedYSparse.n_elem << " and "
+        << decomposedYDense.n_elem << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  ySparse.set_size(numSparse);
+  for (size_t i = 0; i < numSparse; ++i)
+    ySparse(i) = decomposedYSparse(i);
+
+  yDense.set_size(numDense + numLowRank);
+  for (size_t i = 0; i < numDense; ++i)
+    yDense(i) = decomposedYSparse(numSparse + i);
+  for (size_t i = 0; i < numLowRank; ++i)
+    yDense(numDense + i) = decomposedYDense(i);
+}
+
+} // namespace ens
+
+#endif
@@ -138,6 +138,254 @@ inline void SymKronId(const arma::mat& A, arma::mat& op)
   }
 }
 
+/**
+ * Compute Op * x for the operator Op = SymKronId(A) without forming it, that
+ * is,
+ *
+ *    output == svec(0.5 * (A smat(x) + smat(x) A))
+ *
+ * This takes O(n^3) time and O(n^2) memory, instead of the O(n^4) memory of
+ * the operator.
+ *
+ * @param A A symmetric matrix.
+ * @param x Svec representation of a symmetric matrix.
+ * @param output Svec representation of the product.
+ */
+inline void SymKronIdTimes(const arma::mat& A,
+                           const arma::vec& x,
+                           arma::vec& output)
+{
+  arma::mat xMat;
+  Smat(x, xMat);
+  const arma::mat product = A * xMat;
+  Svec(0.5 * (product + product.t()), output);
+}
+
+/**
+ * Approximate the extreme eigenpairs of a symmetric n x n matrix A with at most
+ * maxSteps steps of the Lanczos method (with full reorthogonalization).  A is
+ * only accessed through products multiply(x) = A * x, so it does not have to be
+ * formed.  The Ritz values are never below the smallest eigenvalue or above the
+ * largest one, and are exact (up to rounding) when maxSteps is at least n,
+ * unless the starting vector is orthogonal to an eigenvector.
+ *
+ * @param multiply Function returning the product of A with a vector.
+ * @param n Size of A.
+ * @param maxSteps Maximum number of Lanczos steps.
+ * @param values Vector to store the Ritz values in, in increasing order.
+ * @param vectors Matrix to store the corresponding Ritz vectors in.
+ */
+template<typename MultiplyType>
+inline void Lanczos(const MultiplyType& multiply,
+                    const size_t n,
+                    const size_t maxSteps,
+                    arma::vec& values,
+                    arma::mat& vectors)
+{
+  const size_t k = std::min(n, maxSteps);
+
+  arma::mat V(n, k);
+  arma::vec a(k), b(k);
+  V.col(0) = arma::normalise(arma::linspace<arma::vec>(1., 2., n));
+
+  size_t steps = k;
+  arma::vec w;
+  for (size_t j = 0; j < k; ++j)
+  {
+    w = multiply(arma::vec(V.col(j)));
+    a(j) = arma::dot(w, V.col(j));
+
+    // Reorthogonalize twice against all the previous Lanczos vectors.
+    for (size_t pass = 0; pass < 2; ++pass)
+      w -= V.cols(0, j) * (V.cols(0, j).t() * w);
+
+    b(j) = arma::norm(w, 2);
+    if (j + 1 == k || b(j) <= 1e-12 * std::max(1., std::abs(a(j))))
+    {
+      steps = j + 1;
+      break;
+    }
+
+    V.col(j + 1) = w / b(j);
+  }
+
+  // The eigenpairs of the tridiagonal matrix of the recurrence.
+  arma::mat T(steps, steps, arma::fill::zeros);
+  T.diag() = a.subvec(0, steps - 1);
+  if (steps > 1)
+  {
+    T.diag(1) = b.subvec(0, steps - 2);
+    T.diag(-1) = b.subvec(0, steps - 2);
+  }
+
+  arma::mat U;
+  arma::eig_sym(values, U, T);
+  vectors = V.cols(0, steps - 1) * U;
+}
+
+/**
+ * Solve the linear system A x = b with the preconditioned BiCGSTAB method, for
+ * a square matrix A which does not have to be symmetric.  A is only accessed
+ * through products multiply(v) = A * v, and the preconditioner through
+ * precondition(v), an approximation of A^(-1) v, so that neither has to be
+ * formed.  Each iteration costs two products with A and two applications of
+ * the preconditioner.
+ *
+ * @param multiply Function returning the product of A with a vector.
+ * @param precondition Function returning the preconditioned vector.
+ * @param b Right hand side.
+ * @param x Vector to store the solution in; it is also the starting point, if
+ *     it has the size of b (otherwise the start is zero).
+ * @param tolerance Relative tolerance on the norm of the residual.
+ * @param maxIterations Maximum number of iterations.
+ * @return false if the method broke down or did not converge.
+ */
+template<typename MultiplyType, typename PreconditionType>
+inline bool BiCGStab(const MultiplyType& multiply,
+                     const PreconditionType& precondition,
+                     const arma::vec& b,
+                     arma::vec& x,
+                     const double tolerance,
+                     const size_t maxIterations)
+{
+  if (x.n_elem != b.n_elem)
+    x.zeros(b.n_elem);
+
+  const double bNorm = arma::norm(b, 2);
+  if (bNorm == 0.0)
+  {
+    x.zeros();
+    return true;
+  }
+
+  arma::vec r = b - multiply(x);
+  if (arma::norm(r, 2) <= tolerance * bNorm)
+    return true;
+
+  const arma::vec rHat = r;
+  arma::vec p(b.n_elem, arma::fill::zeros), v(b.n_elem, arma::fill::zeros);
+  arma::vec pHat, s, sHat, t;
+  double rho = 1.0, alpha = 1.0, omega = 1.0;
+  for (size_t i = 0; i < maxIterations; ++i)
+  {
+    const double rhoNew = arma::dot(rHat, r);
+    if (rhoNew == 0.0 || omega == 0.0)
+      return false;
+
+    const double beta = (rhoNew / rho) * (alpha / omega);
+    p = r + beta * (p - omega * v);
+    pHat = precondition(p);
+    v = multiply(pHat);
+
+    const double rHatV = arma::dot(rHat, v);
+    if (rHatV == 0.0)
+      return false;
+    alpha = rhoNew / rHatV;
+
+    s = r - alpha * v;
+    if (arma::norm(s, 2) <= tolerance * bNorm)
+    {
+      x += alpha * pHat;
+      return true;
+    }
+
+    sHat = precondition(s);
+    t = multiply(sHat);
+    const double tt = arma::dot(t, t);
+    omega = (tt == 0.0) ? 0.0 : arma::dot(t, s) / tt;
+
+    x += alpha * pHat + omega * sHat;
+    r = s - omega * t;
+    if (arma::norm(r, 2) <= tolerance * bNorm)
+      return true;
+
+    rho = rhoNew;
+  }
+
+  return false;
+}
+
+/**
+ * Stack the Svec of each of the given symmetric sparse matrices as the rows of
+ * a sparse matrix.  The matrix is built in a single batch from the non-zero
+ * entries, instead of inserting each row (which costs as much as all the
+ * non-zero entries already stored).
+ *
+ * @param inputs Symmetric matrices.
+ * @param output Matrix whose row i is Svec(inputs[i]).
+ */
+inline void SvecRows(const std::vector<arma::sp_mat>& inputs,
+                     arma::sp_mat& output)
+{
+  const size_t n = inputs.empty() ? 0 : inputs[0].n_rows;
+  const size_t n2bar = n * (n + 1) / 2;
+
+  // Count the non-zero entries in the upper triangles.
+  size_t nonZeros = 0;
+  for (size_t k = 0; k < inputs.size(); ++k)
+  {
+    for (auto it = inputs[k].begin(); it != inputs[k].end(); ++it)
+    {
+      if (it.row() <= it.col())
+        ++nonZeros;
+    }
+  }
+
+  arma::umat locations(2, nonZeros);
+  arma::vec values(nonZeros);
+  size_t entry = 0;
+  for (size_t k = 0; k < inputs.size(); ++k)
+  {
+    for (auto it = inputs[k].begin(); it != inputs[k].end(); ++it)
+    {
+      const size_t i = it.row();
+      const size_t j = it.col();
+      if (i > j)
+        continue;
+
+      locations(0, entry) = k;
+      locations(1, entry) = SvecIndex(i, j, n);
+      values(entry++) = (i == j) ? (*it) : arma::datum::sqrt2 * (*it);
+    }
+  }
+
+  output = arma::sp_mat(locations, values, inputs.size(), n2bar);
+}
+
+/**
+ * Stack the Svec of each of the given symmetric dense matrices as the rows of
+ * a dense matrix.  The matrices are converted in parallel.
+ *
+ * @param inputs Symmetric matrices.
+ * @param output Matrix whose row i is Svec(inputs[i]).
+ */
+inline void SvecRows(const std::vector<arma::mat>& inputs, arma::mat& output)
+{
+  const size_t n = inputs.empty() ? 0 : inputs[0].n_rows;
+  const size_t n2bar = n * (n + 1) / 2;
+
+  // Each conversion is stored as a column, which is contiguous in memory.
+  arma::mat columns(n2bar, inputs.size());
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    arma::vec column;
+    for (size_t k = threadId; k < inputs.size(); k += numThreads)
+    {
+      Svec(inputs[k], column);
+      columns.col(k) = column;
+    }
+  }
+
+  output = columns.t();
+}
+
 } // namespace math
 } // namespace ens
 
@@ -27,6 +27,21 @@ namespace ens {
  * LRSDP can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * With a maximum rank larger than the number of columns of the initial point,
+ * the rank is adapted: after each solve, the smallest eigenvalues of the dual
+ * slack S = C - sum_i y_i A_i are estimated with the Lanczos method.  If S is
+ * positive semidefinite, R is optimal (Burer and Monteiro, 2005); otherwise R
+ * is extended with the eigenvectors of the negative eigenvalues, which are
+ * descent directions, and the solve continues from there.
+ *
+ * With SinglePrecision(), the products of R with the matrices of the SDP are
+ * computed in single precision, with the traces (and so the constraint
+ * residuals) still accumulated in double precision (see LRSDPFunction), and
+ * the inner L-BFGS optimizer stores its history in single precision for the
+ * duration of Optimize() (see L_BFGS::FloatHistory()).  This halves the memory
+ * of the history and of the products, and is meant for large problems whose
+ * constraints are only needed to a moderate accuracy.
  */
 template <typename SDPType>
 class LRSDP
@@ -42,11 +57,19 @@ class LRSDP
    * @param numDenseConstraints Number of dense constraints in the problem.
    * @param initialPoint Initial point of the optimization.
    * @param maxIterations Maximum number of iterations.
+   * @param maxRank Maximum rank the solution may grow to; 0 keeps the rank of
+   *     the initial point.
+   * @param rankIncrement Maximum number of columns added at a time.
+   * @param dualTolerance Relative tolerance on the negative eigenvalues of the
+   *     dual slack under which the solution is considered optimal.
    */
   LRSDP(const size_t numSparseConstraints,
         const size_t numDenseConstraints,
         const arma::mat& initialPoint,
-        const size_t maxIterations = 1000);
+        const size_t maxIterations = 1000,
+        const size_t maxRank = 0,
+        const size_t rankIncrement = 1,
+        const double dualTolerance = 1e-4);
 
   /**
    * Create an LRSDP object with the given SDP problem to be solved, and the
@@ -68,9 +91,30 @@ class LRSDP
    * Optimize the LRSDP and return the final objective value.  The given
    * coordinates will be modified to contain the final solution.
    *
+   * Any number of callbacks may be given after the coordinates; they are
+   * passed to the AugLagrangian optimizer, once for every rank that is tried.
+   * If a callback terminates the optimization, the rank is not increased
+   * further.
+   *
+   * @tparam CallbackTypes Types of callback functions.
    * @param coordinates Starting coordinates for the optimization.
+   * @param callbacks Callback functions.
    */
-  double Optimize(arma::mat& coordinates);
+  template<typename... CallbackTypes>
+  double Optimize(arma::mat& coordinates, CallbackTypes&&... callbacks);
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates, besides the
+   * coordinates and the SDP: the memory of the inner optimizer of AugLag() for
+   * an n x r iterate (see ens::MemoryEstimate()), where r is the larger of the
+   * rank of the initial point and MaxRank(), the temporaries of the
+   * evaluation of the constraints, and, if the rank is adapted, the dual slack
+   * and the Lanczos vectors of its eigenpairs.  Unlike PrimalDualSolver, no
+   * n x n matrix is formed unless the rank is adapted and the SDP has dense
+   * matrices.  With SinglePrecision(), this also counts the single-precision
+   * copies of the dense matrices and the low-rank factors of the SDP.
+   */
+  size_t MemoryEstimate() const;
 
   //! Return the SDP that will be solved.
   const SDPType& SDP() const { return function.SDP(); }
@@ -92,13 +136,59 @@ class LRSDP
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the maximum rank (0 if the rank is not adapted).
+  size_t MaxRank() const { return maxRank; }
+  //! Modify the maximum rank (0 if the rank is not adapted).
+  size_t& MaxRank() { return maxRank; }
+
+  //! Get the maximum number of columns added at a time.
+  size_t RankIncrement() const { return rankIncrement; }
+  //! Modify the maximum number of columns added at a time.
+  size_t& RankIncrement() { return rankIncrement; }
+
+  //! Get the relative tolerance on the eigenvalues of the dual slack.
+  double DualTolerance() const { return dualTolerance; }
+  //! Modify the relative tolerance on the eigenvalues of the dual slack.
+  double& DualTolerance() { return dualTolerance; }
+
+  //! Get whether the products with the solution are computed in single
+  //! precision.
+  bool SinglePrecision() const { return function.SinglePrecision(); }
+  //! Modify whether the products with the solution are computed in single
+  //! precision.
+  bool& SinglePrecision() { return function.SinglePrecision(); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  /**
+   * Estimate the smallest eigenpairs of the dual slack S = C - sum_i y_i A_i
+   * at the given coordinates, where y are the current multiplier estimates.
+   *
+   * @param coordinates Current solution.
+   * @param values Vector to store the Ritz values in, in increasing order.
+   * @param vectors Matrix to store the corresponding Ritz vectors in.
+   */
+  void DualSlackEigenpairs(const arma::mat& coordinates,
+                           arma::vec& values,
+                           arma::mat& vectors) const;
+
   //! Augmented lagrangian optimizer.
   AugLagrangian augLag;
   //! Function to optimize, which the AugLagrangian object holds.
   LRSDPFunction<SDPType> function;
   //! The maximum number of iterations for optimization.
   size_t maxIterations;
+  //! The maximum rank.
+  size_t maxRank;
+  //! The maximum number of columns added at a time.
+  size_t rankIncrement;
+  //! The relative tolerance on the eigenvalues of the dual slack.
+  double dualTolerance;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
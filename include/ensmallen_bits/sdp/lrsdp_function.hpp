@@ -21,14 +21,35 @@ namespace ens {
 /**
  * The objective function that LRSDP is trying to optimize.
  *
- * Note: LRSDPfunction is designed and implemented to specifically work
- * with a combination of AugLagrangian and L-BFGS optimizer. Implemenation
- * of LRSDPFunction includes caching R * R^T matrix in order to avoid redundant
- * computations(Specifically with above two optimizers) of R * R^T matrix
- * through AugLagrangian optimizer call, as only L-BFGS takes part in updating
- * R(coordinates) matrix. So, be careful while using LRSDP with some other
- * optimizer. You may need to modify caching process of R * R^T matrix.
- * See EvaluateImpl() in lrsdp_function_impl.hpp for more details.
+ * The n x n matrix R * R^T is never formed: Tr(A * R * R^T) is computed as a
+ * sum of dot products of rows of R over the non-zero entries of a sparse A,
+ * and as accu(R % (A * R)) for a dense A, and as ||V^T R||_F^2 for a low-rank
+ * A = V V^T, so that the memory used stays proportional to the size of R and
+ * of the constraints.
+ *
+ * For a block-diagonal SDP (see SDP::BlockSizes()), block b of X is
+ * R_b * R_b^T, where R_b holds the rows of R of the block; the products with
+ * a dense C or A_i are then computed one diagonal block at a time.
+ *
+ * When used through AugLagrangianFunction, the objective Tr(C * R * R^T) and
+ * the constraint residuals Tr(A_i * R * R^T) - b_i are computed once for each
+ * new R by UpdateCache(), and Evaluate() and EvaluateConstraint() reuse them
+ * when they are called with the same R (until the SDP is modified).
+ *
+ * With SinglePrecision(), UpdateCache() and the gradient of the augmented
+ * Lagrangian multiply R by the dense matrices and the low-rank factors of the
+ * SDP in single precision, from single-precision copies of them, which halves
+ * the memory traffic and doubles the throughput of the products.  The traces
+ * are still accumulated in double precision, so that the constraint residuals
+ * (and so the multipliers) are not spoiled by the rounding of long float sums.
+ * The evaluations at other points than the cached one are in double precision.
+ *
+ * From ENS_LRSDP_PARALLEL_THRESHOLD constraints on, the residuals and the
+ * terms y_i * A_i * R of the gradient are computed by OpenMP threads.  The
+ * constraints are dealt round-robin to one chunk per thread (or to
+ * ENS_DETERMINISTIC_CHUNKS chunks in the deterministic mode; see
+ * SetDeterministic()), each chunk sums its terms in its own n x r buffer, and
+ * the buffers are added pairwise.
  */
 template <typename SDPType>
 class LRSDPFunction
@@ -75,6 +96,13 @@ class LRSDPFunction
    */
   double EvaluateConstraint(const size_t index,
                             const arma::mat& coordinates) const;
+  /**
+   * Evaluate all the constraints of the LRSDP at the given coordinates.  The
+   * cached residuals are used if they are at the same coordinates.
+   */
+  void EvaluateConstraints(const arma::mat& coordinates,
+                           arma::vec& constraints) const;
+
   /**
    * Evaluate the gradient of a particular constraint of the LRSDP at the given
    * coordinates.
@@ -83,6 +111,37 @@ class LRSDPFunction
                           const arma::mat& coordinates,
                           arma::mat& gradient) const;
 
+  /**
+   * Compute the objective and the constraint residuals at the given
+   * coordinates, unless they are already cached for these coordinates.
+   */
+  void UpdateCache(const arma::mat& coordinates);
+
+  //! Return whether the cache holds the values at the given coordinates.
+  bool Cached(const arma::mat& coordinates) const;
+
+  //! Get the cached objective Tr(C * R * R^T).
+  double CachedObjective() const { return cacheObjective; }
+
+  //! Get the cached constraint residuals Tr(A_i * R * R^T) - b_i.
+  const arma::vec& CachedResiduals() const { return cacheResiduals; }
+
+  /**
+   * Compute the product S' * R of the given coordinates with the dual slack
+   * S' = C - sum_i y_i A_i, for the multipliers y_i = lambda_i - sigma *
+   * (Tr(A_i * R * R^T) - b_i) at the cached residuals (see UpdateCache()),
+   * in single precision with SinglePrecision().
+   *
+   * @param coordinates Coordinates the cache was computed at.
+   * @param lambda Lagrange multipliers.
+   * @param sigma Penalty parameter.
+   * @param product Matrix to store S' * R in.
+   */
+  void DualSlackTimes(const arma::mat& coordinates,
+                      const arma::vec& lambda,
+                      const double sigma,
+                      arma::mat& product);
+
   //! Get the total number of constraints in the LRSDP.
   size_t NumConstraints() const { return sdp.NumConstraints(); }
 
@@ -92,24 +151,73 @@ class LRSDPFunction
   //! Return the SDP object representing the problem.
   const SDPType& SDP() const { return sdp; }
 
-  //! Modify the SDP object representing the problem.
-  SDPType& SDP() { return sdp; }
+  //! Modify the SDP object representing the problem.  This clears the cache.
+  SDPType& SDP()
+  {
+    cacheCoordinates.reset();
+    floatCopies = false;
+    return sdp;
+  }
 
-  //! Get R*R^T matrix.
-  const arma::mat& RRT() const { return rrt; }
-
-  //! Modify R*R^T matrix.
-  arma::mat& RRT()  { return rrt; }
+  //! Get whether the products with R are computed in single precision.
+  bool SinglePrecision() const { return singlePrecision; }
+  //! Modify whether the products with R are computed in single precision.
+  //! This clears the cache.
+  bool& SinglePrecision() { cacheCoordinates.reset(); return singlePrecision; }
 
  private:
+  //! Make the single-precision copies of the dense matrices and the low-rank
+  //! factors of the SDP, unless they are up to date.
+  void UpdateFloatCopies();
+
+  /**
+   * Compute the constraint residuals at the given coordinates, whose element
+   * type is that of the given dense matrices and low-rank factors.
+   */
+  template<typename eT>
+  void ComputeConstraints(const arma::Mat<eT>& coordinates,
+                          const std::vector<arma::Mat<eT>>& denseA,
+                          const std::vector<arma::Mat<eT>>& lowRankA,
+                          arma::vec& constraints) const;
+
+  /**
+   * Compute S' * R (see DualSlackTimes()) in the element type of the given
+   * coordinates, objective, dense matrices and low-rank factors.
+   */
+  template<typename eT, typename CType>
+  void ComputeDualSlackTimes(const arma::Mat<eT>& coordinates,
+                             const CType& C,
+                             const std::vector<arma::Mat<eT>>& denseA,
+                             const std::vector<arma::Mat<eT>>& lowRankA,
+                             const arma::vec& lambda,
+                             const double sigma,
+                             arma::Mat<eT>& product) const;
+
   //! SDP object representing the problem
   SDPType sdp;
 
   //! Initial point.
   arma::mat initialPoint;
 
-  //! Cache R*R^T matrix.
-  arma::mat rrt;
+  //! The coordinates the cache was computed at.
+  arma::mat cacheCoordinates;
+
+  //! The cached objective.
+  double cacheObjective;
+
+  //! The cached constraint residuals.
+  arma::vec cacheResiduals;
+
+  //! Whether the products with R are computed in single precision.
+  bool singlePrecision;
+  //! Whether the single-precision copies match the SDP.
+  bool floatCopies;
+  //! The single-precision copy of a dense objective (empty for a sparse one).
+  arma::fmat floatC;
+  //! The single-precision copies of the dense constraint matrices.
+  std::vector<arma::fmat> floatDenseA;
+  //! The single-precision copies of the low-rank factors.
+  std::vector<arma::fmat> floatLowRankA;
 };
 
 // Declare specializations in lrsdp_function.cpp.
@@ -131,6 +239,14 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const;
 
+template <>
+inline double AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::
+EvaluateWithGradient(const arma::mat& coordinates, arma::mat& gradient) const;
+
+template <>
+inline double AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::
+EvaluateWithGradient(const arma::mat& coordinates, arma::mat& gradient) const;
+
 } // namespace ens
 
 // Include implementation
@@ -22,17 +22,17 @@ template <typename SDPType>
 LRSDPFunction<SDPType>::LRSDPFunction(const SDPType& sdp,
                                       const arma::mat& initialPoint):
     sdp(sdp),
-    initialPoint(initialPoint)
+    initialPoint(initialPoint),
+    cacheObjective(0.0),
+    singlePrecision(false),
+    floatCopies(false)
 {
   if (initialPoint.n_rows < initialPoint.n_cols)
   {
-    Warn << "LRSDPFunction::LRSDPFunction(): solution matrix will have "
+    ENS_WARN << "LRSDPFunction::LRSDPFunction(): solution matrix will have "
         << "more columns than rows.  It may be more efficient to find the "
         << "transposed solution." << std::endl;
   }
-
-  // Initialize R*R^T matrix.
-  rrt = initialPoint * trans(initialPoint);
 }
 
 template <typename SDPType>
@@ -40,27 +40,222 @@ LRSDPFunction<SDPType>::LRSDPFunction(const size_t numSparseConstraints,
                                       const size_t numDenseConstraints,
                                       const arma::mat& initialPoint):
     sdp(initialPoint.n_rows, numSparseConstraints, numDenseConstraints),
-    initialPoint(initialPoint)
+    initialPoint(initialPoint),
+    cacheObjective(0.0),
+    singlePrecision(false),
+    floatCopies(false)
 {
   if (initialPoint.n_rows < initialPoint.n_cols)
   {
-    Warn << "LRSDPFunction::LRSDPFunction(): solution matrix will have "
+    ENS_WARN << "LRSDPFunction::LRSDPFunction(): solution matrix will have "
         << "more columns than rows.  It may be more efficient to find the "
         << "transposed solution." << std::endl;
   }
+}
+
+//! Compute A * R for a sparse A; only the rows of R matching the non-zero
+//! entries of A are touched, so the blocks of the SDP need no special care.
+inline arma::mat LRSDPTimes(const arma::sp_mat& A,
+                            const arma::mat& coordinates,
+                            const arma::uvec& /* offsets */)
+{
+  return A * coordinates;
+}
+
+//! Compute A * R for a sparse A and a single-precision R, one scaled row of R
+//! per non-zero entry of A.
+inline arma::fmat LRSDPTimes(const arma::sp_mat& A,
+                             const arma::fmat& coordinates,
+                             const arma::uvec& /* offsets */)
+{
+  arma::fmat product(coordinates.n_rows, coordinates.n_cols, arma::fill::zeros);
+  for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+    product.row(it.row()) += float(*it) * coordinates.row(it.col());
+  return product;
+}
+
+//! Compute A * R for a dense A.  For a block-diagonal SDP (with the given block
+//! offsets), A is zero outside of the diagonal blocks, so each block of rows of
+//! R is only multiplied by its diagonal block of A.
+template<typename eT>
+inline arma::Mat<eT> LRSDPTimes(const arma::Mat<eT>& A,
+                                const arma::Mat<eT>& coordinates,
+                                const arma::uvec& offsets)
+{
+  if (offsets.n_elem <= 2)
+    return A * coordinates;
+
+  arma::Mat<eT> product(coordinates.n_rows, coordinates.n_cols);
+  for (size_t b = 0; b + 1 < offsets.n_elem; ++b)
+  {
+    if (offsets(b + 1) == offsets(b))
+      continue;
+
+    const arma::span s(offsets(b), offsets(b + 1) - 1);
+    product.rows(s) = A(s, s) * coordinates.rows(s);
+  }
+  return product;
+}
+
+//! Sum the elements of the given expression.
+template<typename T1>
+inline double LRSDPAccu(const arma::Base<double, T1>& x)
+{
+  return arma::accu(x.get_ref());
+}
+
+//! Sum the elements of the given single-precision expression in double
+//! precision, since a float sum over n r elements would lose most digits.
+template<typename T1>
+inline double LRSDPAccu(const arma::Base<float, T1>& x)
+{
+  const arma::fmat values(x.get_ref());
+  double sum = 0.0;
+  for (size_t i = 0; i < values.n_elem; ++i)
+    sum += values[i];
+  return sum;
+}
+
+//! Compute Tr(A * R * R^T) for a sparse A from the dot products of the rows of
+//! R (that is, the columns of Rt = R^T) over the non-zero entries of A.
+template<typename eT>
+inline double LRSDPTrace(const arma::sp_mat& A,
+                         const arma::Mat<eT>& /* coordinates */,
+                         const arma::Mat<eT>& Rt,
+                         const arma::uvec& /* offsets */)
+{
+  double trace = 0.0;
+  for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+    trace += (*it) * arma::dot(Rt.col(it.row()), Rt.col(it.col()));
+  return trace;
+}
+
+//! Compute Tr(A * R * R^T) = Tr(R^T * A * R) for a dense A.
+template<typename eT>
+inline double LRSDPTrace(const arma::Mat<eT>& A,
+                         const arma::Mat<eT>& coordinates,
+                         const arma::Mat<eT>& /* Rt */,
+                         const arma::uvec& offsets)
+{
+  return LRSDPAccu(coordinates % LRSDPTimes(A, coordinates, offsets));
+}
+
+//! Compute Tr(V * V^T * R * R^T) = ||V^T * R||_F^2 for a low-rank constraint,
+//! in O(n r k) time for an n x k factor V.
+template<typename eT>
+inline double LRSDPLowRankTrace(const arma::Mat<eT>& V,
+                                const arma::Mat<eT>& coordinates)
+{
+  return LRSDPAccu(arma::square(V.t() * coordinates));
+}
+
+//! Make the single-precision copy of a sparse objective: none is needed, since
+//! its entries are read one at a time (see LRSDPTimes()).
+inline void LRSDPFloatCopy(const arma::sp_mat& /* C */, arma::fmat& copy)
+{
+  copy.reset();
+}
+
+//! Make the single-precision copy of a dense objective.
+inline void LRSDPFloatCopy(const arma::mat& C, arma::fmat& copy)
+{
+  copy = arma::conv_to<arma::fmat>::from(C);
+}
+
+//! Get the objective to multiply a single-precision R by: a sparse objective
+//! itself.
+inline const arma::sp_mat& LRSDPFloatObjective(const arma::sp_mat& C,
+                                               const arma::fmat& /* copy */)
+{
+  return C;
+}
+
+//! Get the objective to multiply a single-precision R by: the single-precision
+//! copy of a dense objective.
+inline const arma::fmat& LRSDPFloatObjective(const arma::mat& /* C */,
+                                             const arma::fmat& copy)
+{
+  return copy;
+}
+
+/**
+ * Get the number of chunks to split the loops over the given number of
+ * constraints into: one per thread from ENS_LRSDP_PARALLEL_THRESHOLD
+ * constraints, or ENS_DETERMINISTIC_CHUNKS in the deterministic mode (see
+ * ParallelChunks()), and 1 below the threshold or inside a parallel region.
+ */
+inline size_t LRSDPChunks(const size_t numConstraints)
+{
+  if (numConstraints < ENS_LRSDP_PARALLEL_THRESHOLD)
+    return 1;
+
+  #ifdef ENS_USE_OPENMP
+    const size_t maxThreads = omp_in_parallel() ? 1 : omp_get_max_threads();
+  #else
+    const size_t maxThreads = 1;
+  #endif
+  return ParallelChunks(maxThreads, numConstraints);
+}
+
+template <typename SDPType>
+void LRSDPFunction<SDPType>::UpdateFloatCopies()
+{
+  if (floatCopies)
+    return;
+
+  LRSDPFloatCopy(sdp.C(), floatC);
+  floatDenseA.resize(sdp.NumDenseConstraints());
+  for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+    floatDenseA[i] = arma::conv_to<arma::fmat>::from(sdp.DenseA()[i]);
+  floatLowRankA.resize(sdp.NumLowRankConstraints());
+  for (size_t i = 0; i < sdp.NumLowRankConstraints(); ++i)
+    floatLowRankA[i] = arma::conv_to<arma::fmat>::from(sdp.LowRankA()[i]);
+  floatCopies = true;
+}
+
+template <typename SDPType>
+void LRSDPFunction<SDPType>::UpdateCache(const arma::mat& coordinates)
+{
+  if (Cached(coordinates))
+    return;
+
+  if (singlePrecision)
+  {
+    UpdateFloatCopies();
+    const arma::fmat R = arma::conv_to<arma::fmat>::from(coordinates);
+    cacheObjective = LRSDPTrace(LRSDPFloatObjective(sdp.C(), floatC), R,
+        arma::fmat(trans(R)), sdp.BlockOffsets());
+    ComputeConstraints(R, floatDenseA, floatLowRankA, cacheResiduals);
+  }
+  else
+  {
+    cacheObjective = LRSDPTrace(sdp.C(), coordinates,
+        arma::mat(trans(coordinates)), sdp.BlockOffsets());
+    ComputeConstraints(coordinates, sdp.DenseA(), sdp.LowRankA(),
+        cacheResiduals);
+  }
+  cacheCoordinates = coordinates;
+}
 
-  // Initialize R*R^T matrix.
-  rrt = initialPoint * trans(initialPoint);
+template <typename SDPType>
+bool LRSDPFunction<SDPType>::Cached(const arma::mat& coordinates) const
+{
+  return !cacheCoordinates.is_empty() &&
+      cacheCoordinates.n_rows == coordinates.n_rows &&
+      cacheCoordinates.n_cols == coordinates.n_cols &&
+      cacheResiduals.n_elem == SDP().NumConstraints() &&
+      std::equal(coordinates.begin(), coordinates.end(),
+          cacheCoordinates.begin());
 }
 
 template <typename SDPType>
-double LRSDPFunction<SDPType>::Evaluate(const arma::mat& /* coordinates */)
-                                        const
+double LRSDPFunction<SDPType>::Evaluate(const arma::mat& coordinates) const
 {
-  // Note: We don't require to update the R*R^T matrix here as the current
-  // function is only used by AugLagrangian, which do not update the coordinates
-  // matrix.
-  return accu(SDP().C() % rrt);
+  if (Cached(coordinates))
+    return cacheObjective;
+
+  return LRSDPTrace(SDP().C(), coordinates, arma::mat(trans(coordinates)),
+      SDP().BlockOffsets());
 }
 
 template <typename SDPType>
@@ -76,18 +271,97 @@ double LRSDPFunction<SDPType>::EvaluateConstraint(
     const size_t index,
     const arma::mat& coordinates) const
 {
-  // Note: We don't require to update the R*R^T matrix here as the current
-  // function is only used by AugLagrangian, which do not update the coordinates
-  // matrix.
+  if (Cached(coordinates))
+    return cacheResiduals[index];
 
-  // Using cached R*R^T gives better optimization for sparse matrices.
   if (index < SDP().NumSparseConstraints())
-    return accu(SDP().SparseA()[index] % rrt) - SDP().SparseB()[index];
+  {
+    return LRSDPTrace(SDP().SparseA()[index], coordinates,
+        arma::mat(trans(coordinates)), SDP().BlockOffsets()) -
+        SDP().SparseB()[index];
+  }
   const size_t index1 = index - SDP().NumSparseConstraints();
+  if (index1 < SDP().NumDenseConstraints())
+  {
+    return LRSDPTrace(SDP().DenseA()[index1], coordinates, arma::mat(),
+        SDP().BlockOffsets()) - SDP().DenseB()[index1];
+  }
+  const size_t index2 = index1 - SDP().NumDenseConstraints();
+
+  return LRSDPLowRankTrace(SDP().LowRankA()[index2], coordinates) -
+      SDP().LowRankB()[index2];
+}
+
+template <typename SDPType>
+void LRSDPFunction<SDPType>::EvaluateConstraints(
+    const arma::mat& coordinates,
+    arma::vec& constraints) const
+{
+  if (Cached(coordinates))
+  {
+    constraints = cacheResiduals;
+    return;
+  }
 
-  // For computation optimization we will be taking R^T * A first.
-  return trace((trans(coordinates) * SDP().DenseA()[index1]) * coordinates)
-                 - SDP().DenseB()[index1];
+  ComputeConstraints(coordinates, sdp.DenseA(), sdp.LowRankA(), constraints);
+}
+
+template <typename SDPType>
+template <typename eT>
+void LRSDPFunction<SDPType>::ComputeConstraints(
+    const arma::Mat<eT>& coordinates,
+    const std::vector<arma::Mat<eT>>& denseA,
+    const std::vector<arma::Mat<eT>>& lowRankA,
+    arma::vec& constraints) const
+{
+  const arma::Mat<eT> Rt = trans(coordinates);
+  const arma::uvec offsets = sdp.BlockOffsets();
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t lowRankOffset = numSparse + sdp.NumDenseConstraints();
+  const size_t numConstraints = sdp.NumConstraints();
+  constraints.set_size(numConstraints);
+
+  auto evaluate = [&](const size_t i)
+  {
+    if (i < numSparse)
+    {
+      constraints[i] = LRSDPTrace(sdp.SparseA()[i], coordinates, Rt,
+          offsets) - sdp.SparseB()[i];
+    }
+    else if (i < lowRankOffset)
+    {
+      constraints[i] = LRSDPTrace(denseA[i - numSparse], coordinates, Rt,
+          offsets) - sdp.DenseB()[i - numSparse];
+    }
+    else
+    {
+      constraints[i] = LRSDPLowRankTrace(lowRankA[i - lowRankOffset],
+          coordinates) - sdp.LowRankB()[i - lowRankOffset];
+    }
+  };
+
+  if (LRSDPChunks(numConstraints) <= 1)
+  {
+    for (size_t i = 0; i < numConstraints; ++i)
+      evaluate(i);
+    return;
+  }
+
+  // Each constraint only writes its own residual, so the threads can take
+  // every numThreads'th constraint, which spreads the dense and the low-rank
+  // constraints over the threads.
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    for (size_t i = threadId; i < numConstraints; i += numThreads)
+      evaluate(i);
+  }
 }
 
 template <typename SDPType>
@@ -100,61 +374,148 @@ void LRSDPFunction<SDPType>::GradientConstraint(
          "for arbitrary optimizers!");
 }
 
-//! Utility function for updating R*R^T matrix.
-//! Note: Caching R*R^T provide significant computation optimization
-//! by reducing redundant R*R^T calculations in case of functions are not used
-//! updating coordinates matrix, hence leaving R*R^T unchanged.
-template <typename SDPType>
-void UpdateRRT(LRSDPFunction<SDPType>& function,
-               const arma::mat& newrrt)
+//! Get the first of the given number of constraints, whose indices start at
+//! the given offset, that falls in the given chunk of numChunks (the chunk of
+//! constraint i is i % numChunks).
+inline size_t LRSDPFirstInChunk(const size_t offset,
+                                const size_t chunk,
+                                const size_t numChunks)
 {
-  function.RRT() = newrrt;
+  return (chunk + numChunks - offset % numChunks) % numChunks;
 }
 
-//! Utility function for calculating part of the objective when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
+//! Utility function for calculating part of the gradient when AugLagrangian is
+//! used with an LRSDPFunction, for the constraints of the given chunk.
+template <typename eT, typename MatrixType>
 static inline void
-UpdateObjective(double& objective,
-                const arma::mat& rrt,
-                const std::vector<MatrixType>& ais,
-                const arma::vec& bis,
-                const arma::vec& lambda,
-                const size_t lambdaOffset,
-                const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+UpdateGradient(arma::Mat<eT>& sr,
+               const arma::Mat<eT>& coordinates,
+               const std::vector<MatrixType>& ais,
+               const arma::vec& residuals,
+               const arma::vec& lambda,
+               const size_t lambdaOffset,
+               const double sigma,
+               const arma::uvec& offsets,
+               const size_t chunk,
+               const size_t numChunks)
+{
+  for (size_t i = LRSDPFirstInChunk(lambdaOffset, chunk, numChunks);
+      i < ais.size(); i += numChunks)
   {
-    // Take the trace subtracted by the b_i.
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    objective -= (lambda[lambdaOffset + i] * constraint);
-    objective += (sigma / 2.) * constraint * constraint;
+    // A sparse A_i * R only costs one scaled row of R per non-zero entry.
+    const double constraint = residuals[lambdaOffset + i];
+    const double y = lambda[lambdaOffset + i] - sigma * constraint;
+    sr -= eT(y) * LRSDPTimes(ais[i], coordinates, offsets);
   }
 }
 
-//! Utility function for calculating part of the gradient when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
+//! Utility function for calculating the part of the gradient of the low-rank
+//! constraints of the given chunk; A_i * R = V_i * (V_i^T * R) costs O(n r k).
+template <typename eT>
 static inline void
-UpdateGradient(arma::mat& s,
-               const arma::mat& rrt,
-               const std::vector<MatrixType>& ais,
-               const arma::vec& bis,
-               const arma::vec& lambda,
-               const size_t lambdaOffset,
-               const double sigma)
+UpdateLowRankGradient(arma::Mat<eT>& sr,
+                      const arma::Mat<eT>& coordinates,
+                      const std::vector<arma::Mat<eT>>& factors,
+                      const arma::vec& residuals,
+                      const arma::vec& lambda,
+                      const size_t lambdaOffset,
+                      const double sigma,
+                      const size_t chunk,
+                      const size_t numChunks)
 {
-  for (size_t i = 0; i < ais.size(); ++i)
+  for (size_t i = LRSDPFirstInChunk(lambdaOffset, chunk, numChunks);
+      i < factors.size(); i += numChunks)
   {
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
+    const double constraint = residuals[lambdaOffset + i];
     const double y = lambda[lambdaOffset + i] - sigma * constraint;
-    s -= y * ais[i];
+    sr -= eT(y) * (factors[i] * (factors[i].t() * coordinates));
+  }
+}
+
+template <typename SDPType>
+template <typename eT, typename CType>
+void LRSDPFunction<SDPType>::ComputeDualSlackTimes(
+    const arma::Mat<eT>& coordinates,
+    const CType& C,
+    const std::vector<arma::Mat<eT>>& denseA,
+    const std::vector<arma::Mat<eT>>& lowRankA,
+    const arma::vec& lambda,
+    const double sigma,
+    arma::Mat<eT>& product) const
+{
+  const arma::uvec offsets = sdp.BlockOffsets();
+  product = LRSDPTimes(C, coordinates, offsets);
+
+  // Subtract y_i A_i R from the given sum for the constraints i of the given
+  // chunk.
+  auto addChunk = [&](const size_t chunk, const size_t numChunks,
+                      arma::Mat<eT>& sum)
+  {
+    UpdateGradient(sum, coordinates, sdp.SparseA(), cacheResiduals, lambda, 0,
+        sigma, offsets, chunk, numChunks);
+    UpdateGradient(sum, coordinates, denseA, cacheResiduals, lambda,
+        sdp.NumSparseConstraints(), sigma, offsets, chunk, numChunks);
+    UpdateLowRankGradient(sum, coordinates, lowRankA, cacheResiduals, lambda,
+        sdp.NumSparseConstraints() + sdp.NumDenseConstraints(), sigma, chunk,
+        numChunks);
+  };
+
+  const size_t numChunks = LRSDPChunks(sdp.NumConstraints());
+  if (numChunks <= 1)
+  {
+    addChunk(0, 1, product);
+    return;
+  }
+
+  // Every chunk but the first sums its terms in its own n x r buffer (S' itself
+  // is never formed), and the buffers are added pairwise into the product.
+  std::vector<arma::Mat<eT>> partials(numChunks - 1);
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    // The team may be smaller than requested, so each thread takes every
+    // numThreads'th chunk.
+    for (size_t c = threadId; c < numChunks; c += numThreads)
+    {
+      if (c > 0)
+        partials[c - 1].zeros(coordinates.n_rows, coordinates.n_cols);
+      addChunk(c, numChunks, (c == 0) ? product : partials[c - 1]);
+    }
+  }
+
+  PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+  {
+    arma::Mat<eT>& sum = (target == 0) ? product : partials[target - 1];
+    sum += partials[source - 1];
+  });
+}
+
+template <typename SDPType>
+void LRSDPFunction<SDPType>::DualSlackTimes(const arma::mat& coordinates,
+                                            const arma::vec& lambda,
+                                            const double sigma,
+                                            arma::mat& product)
+{
+  UpdateCache(coordinates);
+  if (singlePrecision)
+  {
+    UpdateFloatCopies();
+    arma::fmat floatProduct;
+    ComputeDualSlackTimes(arma::fmat(arma::conv_to<arma::fmat>::from(
+        coordinates)), LRSDPFloatObjective(sdp.C(), floatC), floatDenseA,
+        floatLowRankA, lambda, sigma, floatProduct);
+    product = arma::conv_to<arma::mat>::from(floatProduct);
+  }
+  else
+  {
+    ComputeDualSlackTimes(coordinates, sdp.C(), sdp.DenseA(), sdp.LowRankA(),
+        lambda, sigma, product);
   }
 }
 
@@ -170,50 +531,20 @@ EvaluateImpl(LRSDPFunction<SDPType>& function,
   //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
   //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
 
-  // Let's start with the objective: Tr(C * (R R^T)).
-  // Simple, possibly slow solution-- see below for optimization opportunity
-  //
-  // Note that Tr(C^T * (R R^T)) = Tr( (CR)^T * R ), so
-  // multiplying C * R first, and then taking the trace dot should be more
-  // memory efficient.
-  //
-  // Similarly for the constraints, taking R^T * A first should be
-  // more efficient.
-  //
-  // For computation optimization we will be taking R^T * C first.
-  // Objective function = Tr((R^T * C) * R)
-
-  // Calculate R*R^T for updating cache.
-  const arma::mat rrt = coordinates * trans(coordinates);
-
-  // Update R*R^T matrix.
-  // Note that we can only use this optimization in case of L-BFGS optimizer
-  // or any other similar optimizer which calls Evaluate() before Gradient()
-  // with same coordinates matrix and uses only Evaluate() to update
-  // coordinates matrix.
-
-  // Note: In case optimizer also uses Gradient() for updating coordinates
-  // matrix than the same line of code can be used to update R*R^T through
-  // Gradient().
-  UpdateRRT(function, rrt);
-
-  // Optimized objective function.
-  double objective = trace((trans(coordinates) * function.SDP().C())
-                         * coordinates);
-
-  // Now each constraint.
-  UpdateObjective(objective, rrt, function.SDP().SparseA(),
-      function.SDP().SparseB(), lambda, 0, sigma);
-  UpdateObjective(objective, rrt, function.SDP().DenseA(),
-      function.SDP().DenseB(), lambda, function.SDP().NumSparseConstraints(),
-      sigma);
+  // R R^T is never formed: each trace is computed from R directly (see
+  // LRSDPTrace()), which only touches the rows of R matching the non-zero
+  // entries of a sparse matrix.  The traces are cached, so that the gradient
+  // and the constraints at the same R do not compute them again.
+  function.UpdateCache(coordinates);
+  const arma::vec& residuals = function.CachedResiduals();
 
-  return objective;
+  return function.CachedObjective() +
+      arma::dot((sigma / 2.) * residuals - lambda, residuals);
 }
 
 template <typename SDPType>
 static inline void
-GradientImpl(const LRSDPFunction<SDPType>& function,
+GradientImpl(LRSDPFunction<SDPType>& function,
              const arma::mat& coordinates,
              const arma::vec& lambda,
              const double sigma,
@@ -225,18 +556,12 @@ GradientImpl(const LRSDPFunction<SDPType>& function,
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
 
-  // Directly reterive R*R^T from cache.
-  const arma::mat rrt = function.RRT();
-  arma::mat s(function.SDP().C());
-
-  UpdateGradient(
-      s, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateGradient(
-      s, rrt, function.SDP().DenseA(), function.SDP().DenseB(),
-      lambda, function.SDP().NumSparseConstraints(), sigma);
+  // S' is never formed either: S' * R is accumulated one term at a time (see
+  // LRSDPFunction::DualSlackTimes()).
+  arma::mat sr;
+  function.DualSlackTimes(coordinates, lambda, sigma, sr);
 
-  gradient = 2 * s * coordinates;
+  gradient = 2 * sr;
 }
 
 // Template specializations for function and gradient evaluation.
@@ -272,6 +597,24 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
   GradientImpl(function, coordinates, lambda, sigma, gradient);
 }
 
+template <>
+inline double AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::
+EvaluateWithGradient(const arma::mat& coordinates, arma::mat& gradient) const
+{
+  const double objective = EvaluateImpl(function, coordinates, lambda, sigma);
+  GradientImpl(function, coordinates, lambda, sigma, gradient);
+  return objective;
+}
+
+template <>
+inline double AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::
+EvaluateWithGradient(const arma::mat& coordinates, arma::mat& gradient) const
+{
+  const double objective = EvaluateImpl(function, coordinates, lambda, sigma);
+  GradientImpl(function, coordinates, lambda, sigma, gradient);
+  return objective;
+}
+
 } // namespace ens
 
 #endif
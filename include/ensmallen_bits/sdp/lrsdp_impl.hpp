@@ -21,17 +21,213 @@ template <typename SDPType>
 LRSDP<SDPType>::LRSDP(const size_t numSparseConstraints,
                       const size_t numDenseConstraints,
                       const arma::mat& initialPoint,
-                      const size_t maxIterations) :
+                      const size_t maxIterations,
+                      const size_t maxRank,
+                      const size_t rankIncrement,
+                      const double dualTolerance) :
     function(numSparseConstraints, numDenseConstraints, initialPoint),
-    maxIterations(maxIterations)
+    maxIterations(maxIterations),
+    maxRank(maxRank),
+    rankIncrement(rankIncrement),
+    dualTolerance(dualTolerance)
 { }
 
 template <typename SDPType>
-double LRSDP<SDPType>::Optimize(arma::mat& coordinates)
+size_t LRSDP<SDPType>::MemoryEstimate() const
 {
+  const SDPType& sdp = function.SDP();
+  const size_t n = function.GetInitialPoint().n_rows;
+  const size_t r = std::max((size_t) function.GetInitialPoint().n_cols,
+      maxRank);
+
+  size_t bytes = ens::MemoryEstimate(augLag.InnerOptimizer(), n, r) +
+      (4 * n * r + 2 * sdp.NumConstraints()) * sizeof(double);
+
+  // The partial sums of the gradient of the chunks of constraints.
+  bytes += (LRSDPChunks(sdp.NumConstraints()) - 1) * n * r * sizeof(double);
+
+  if (function.SinglePrecision())
+  {
+    // Optimize() stores the history of L-BFGS in single precision.
+    if (!augLag.InnerOptimizer().FloatHistory())
+    {
+      bytes -= 2 * augLag.InnerOptimizer().NumBasis() * n * r *
+          (sizeof(double) - sizeof(float));
+    }
+
+    // The single-precision copies of R, R^T and the products, and those of
+    // the dense matrices and the low-rank factors.
+    size_t floatElements = 4 * n * r;
+    if (std::is_same<typename SDPType::objective_matrix_type,
+        arma::mat>::value)
+      floatElements += n * n;
+    floatElements += sdp.NumDenseConstraints() * n * n;
+    for (size_t i = 0; i < sdp.NumLowRankConstraints(); ++i)
+      floatElements += sdp.LowRankA()[i].n_elem;
+    bytes += floatElements * sizeof(float);
+  }
+
+  if (maxRank > function.GetInitialPoint().n_cols)
+  {
+    size_t nonZeros = 0;
+    for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+      nonZeros += sdp.SparseA()[i].n_nonzero;
+
+    // The entries of the sparse slack (twice, with their locations), the
+    // dense slack, and the Lanczos vectors.
+    const bool dense = (sdp.NumDenseConstraints() > 0) ||
+        std::is_same<typename SDPType::objective_matrix_type, arma::mat>::value;
+    bytes += (4 * nonZeros + (dense ? n * n : 0) + 52 * n) * sizeof(double);
+  }
+
+  return bytes;
+}
+
+//! Add a sparse objective matrix to the sparse part of the dual slack.
+inline void AddDualSlackObjective(const arma::sp_mat& C,
+                                  arma::sp_mat& sparseSlack,
+                                  arma::mat& /* denseSlack */)
+{
+  sparseSlack += C;
+}
+
+//! Add a dense objective matrix to the dense part of the dual slack.
+inline void AddDualSlackObjective(const arma::mat& C,
+                                  arma::sp_mat& /* sparseSlack */,
+                                  arma::mat& denseSlack)
+{
+  denseSlack += C;
+}
+
+template <typename SDPType>
+void LRSDP<SDPType>::DualSlackEigenpairs(const arma::mat& coordinates,
+                                         arma::vec& values,
+                                         arma::mat& vectors) const
+{
+  const SDPType& sdp = function.SDP();
+  const size_t n = coordinates.n_rows;
+
+  // The multipliers of the augmented Lagrangian at the solution.
+  arma::vec constraints;
+  function.EvaluateConstraints(coordinates, constraints);
+  const arma::vec y = augLag.Lambda() - augLag.Sigma() * constraints;
+
+  // The sparse constraints are summed in one batch from their entries.
+  size_t nonZeros = 0;
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    nonZeros += sdp.SparseA()[i].n_nonzero;
+
+  arma::umat locations(2, nonZeros);
+  arma::vec entries(nonZeros);
+  size_t entry = 0;
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+  {
+    const arma::sp_mat& A = sdp.SparseA()[i];
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+    {
+      locations(0, entry) = it.row();
+      locations(1, entry) = it.col();
+      entries(entry++) = -y[i] * (*it);
+    }
+  }
+
+  arma::sp_mat sparseSlack(true, locations, entries, n, n);
+  arma::mat denseSlack;
+  const bool dense = (sdp.NumDenseConstraints() > 0) ||
+      std::is_same<typename SDPType::objective_matrix_type, arma::mat>::value;
+  if (dense)
+    denseSlack.zeros(n, n);
+
+  AddDualSlackObjective(sdp.C(), sparseSlack, denseSlack);
+  for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+    denseSlack -= y[sdp.NumSparseConstraints() + i] * sdp.DenseA()[i];
+
+  // The low-rank constraints are applied through their factors.
+  const size_t lowRankOffset = sdp.NumSparseConstraints() +
+      sdp.NumDenseConstraints();
+  math::Lanczos([&](const arma::vec& x) -> arma::vec
+      {
+        arma::vec product = dense ? arma::vec(sparseSlack * x +
+            denseSlack * x) : arma::vec(sparseSlack * x);
+        for (size_t i = 0; i < sdp.NumLowRankConstraints(); ++i)
+        {
+          const arma::mat& V = sdp.LowRankA()[i];
+          product -= y[lowRankOffset + i] * (V * (V.t() * x));
+        }
+        return product;
+      },
+      n, 50, values, vectors);
+}
+
+template <typename SDPType>
+template <typename... CallbackTypes>
+double LRSDP<SDPType>::Optimize(arma::mat& coordinates,
+                                CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // In single precision, the history of L-BFGS is stored in single precision
+  // too.
+  const bool floatHistory = augLag.InnerOptimizer().FloatHistory();
+  if (function.SinglePrecision())
+    augLag.InnerOptimizer().FloatHistory() = true;
+
   augLag.Sigma() = 10;
-  augLag.Optimize(function, coordinates, maxIterations);
+  if (maxRank == 0 || coordinates.n_cols >= maxRank)
+  {
+    augLag.Optimize(function, coordinates, maxIterations, callbacks...);
+    augLag.InnerOptimizer().FloatHistory() = floatHistory;
+    return function.Evaluate(coordinates);
+  }
+
+  // The multipliers and the penalty are kept from one rank to the next, so
+  // that each solve continues from the last one.
+  const bool warmStart = augLag.WarmStart();
+  augLag.WarmStart() = true;
+
+  while (true)
+  {
+    // If a callback terminated the solve, the rank is not increased.
+    augLag.Optimize(function, coordinates, maxIterations, callbacks...);
+    if (augLag.Terminated() || coordinates.n_cols >= maxRank)
+      break;
+
+    arma::vec values;
+    arma::mat vectors;
+    DualSlackEigenpairs(coordinates, values, vectors);
+
+    // The Ritz values are in increasing order, so the directions of negative
+    // curvature come first.
+    const double threshold = -dualTolerance *
+        std::max(1.0, arma::max(arma::abs(values)));
+    size_t newColumns = 0;
+    while (newColumns < rankIncrement && newColumns < values.n_elem &&
+        coordinates.n_cols + newColumns < maxRank &&
+        values(newColumns) < threshold)
+    {
+      ++newColumns;
+    }
+
+    // The dual slack is positive semidefinite: the solution is optimal.
+    if (newColumns == 0)
+      break;
+
+    // Scale the new columns like a tenth of an average column, so that the
+    // step along them is noticeable but does not undo the last solve.
+    double scale = 0.1 * arma::norm(coordinates, "fro") /
+        std::sqrt((double) coordinates.n_cols);
+    if (scale == 0.0)
+      scale = 1.0;
+
+    coordinates = arma::join_rows(coordinates,
+        scale * vectors.cols(0, newColumns - 1));
+    ENS_INFO << "LRSDP: increased the rank to " << coordinates.n_cols
+        << " (smallest dual slack eigenvalue " << values(0) << ")."
+        << std::endl;
+  }
 
+  augLag.WarmStart() = warmStart;
+  augLag.InnerOptimizer().FloatHistory() = floatHistory;
   return function.Evaluate(coordinates);
 }
 
@@ -19,6 +19,12 @@ namespace ens {
  * PrimalDualSolver is a primal dual interior point solver for semidefinite
  * programs.
  *
+ * For a block-diagonal SDP (see SDP::BlockSizes()), the eigendecompositions,
+ * Cholesky factorizations, Lyapunov solves and products of X and Z run on each
+ * diagonal block separately (and in parallel), and each column of the Schur
+ * complement only involves the blocks of its constraint.  X and Z keep their
+ * n x n shape, with zeros outside of the blocks.
+ *
  * PrimalDualSolver can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -58,28 +64,77 @@ class PrimalDualSolver
    * Invoke the optimization procedure, returning the converged values for the
    * primal and dual variables.
    *
+   * Any number of callbacks may be given after Z; an epoch is one iteration
+   * of the interior point method, and a step is reported after the primal and
+   * dual variables have been updated.  The SDP is given to the callbacks as
+   * the function, and X as the coordinates.
+   *
+   * @tparam CallbackTypes Types of callback functions.
    * @param X
    * @param ySparse
    * @param yDense
    * @param Z
+   * @param callbacks Callback functions.
    */
+  template<typename... CallbackTypes>
   double Optimize(arma::mat& X,
                   arma::vec& ySparse,
                   arma::vec& yDense,
-                  arma::mat& Z);
+                  arma::mat& Z,
+                  CallbackTypes&&... callbacks);
 
   /**
    * Invoke the optimization procedure, and only return the primal variable.
    *
+   * @tparam CallbackTypes Types of callback functions.
    * @param X
+   * @param callbacks Callback functions.
    */
-  double Optimize(arma::mat& X)
+  template<typename... CallbackTypes>
+  double Optimize(arma::mat& X, CallbackTypes&&... callbacks)
   {
     arma::vec ysparse, ydense;
     arma::mat Z;
-    return Optimize(X, ysparse, ydense, Z);
+    return Optimize(X, ysparse, ydense, Z, callbacks...);
   }
 
+  /**
+   * Start the next calls to Optimize() from a solution of a related SDP (for
+   * instance, the solution for the previous window of a sequence of SDPs)
+   * instead of from the identity.  That solution is usually on the boundary
+   * of the cone (X and Z are singular at an optimum), so each diagonal block of
+   * X and Z is moved into the interior first: its eigenvalues below shift *
+   * max(1, largest eigenvalue) are raised to that value, and its eigenvectors
+   * are kept.  The duality measure <X, Z> / n at the start is then of the order
+   * of the shift instead of 1, and the centering of the predictor-corrector
+   * steps takes mu down from there, so a slightly changed SDP takes far fewer
+   * iterations.  A larger shift is more robust to larger changes of the SDP;
+   * the multipliers are used as they are.
+   *
+   * @param X Primal solution of the related SDP.
+   * @param ysparse Multipliers of the sparse constraints.
+   * @param ydense Multipliers of the dense and low-rank constraints.
+   * @param Z Dual slack of the related SDP.
+   * @param shift Relative distance to keep from the boundary of the cone.
+   */
+  void WarmStart(const arma::mat& X,
+                 const arma::vec& ysparse,
+                 const arma::vec& ydense,
+                 const arma::mat& Z,
+                 const double shift = 0.01);
+
+  /**
+   * Estimate the peak number of bytes that Optimize() allocates for the SDP,
+   * besides X, Z and the SDP itself: with n the size of X, n2bar = n (n + 1) / 2
+   * and m constraints, about twenty n x n work matrices, a few vectors of
+   * length n2bar, the svec() rows of the dense constraints (an n2bar row per
+   * constraint) and of the sparse ones, and the m x m Schur complement and its
+   * LU factors, which are only formed if m is at most
+   * IterativeSchurThreshold() (otherwise the system is solved iteratively in
+   * O(m) memory).
+   */
+  size_t MemoryEstimate() const;
+
   //! Return the underlying SDP instance.
   const SDPType& SDP() const { return sdp; }
 
@@ -98,6 +153,20 @@ class PrimalDualSolver
   //! Modify the maximum number of iterations to run before converging.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Modify the number of constraints above which the Schur complement system
+  //! is solved iteratively instead of being formed and factored.
+  size_t& IterativeSchurThreshold() { return iterativeSchurThreshold; }
+
+  //! Modify the relative tolerance of the iterative Schur complement solve.
+  double& SchurTolerance() { return schurTolerance; }
+
+  //! Modify the maximum number of iterations of the iterative Schur
+  //! complement solve.
+  size_t& MaxSchurIterations() { return maxSchurIterations; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The SDP problem instance to optimize.
   SDPType sdp;
@@ -130,6 +199,19 @@ class PrimalDualSolver
 
   //! Maximum number of iterations to run. Set to 0 for no limit.
   size_t maxIterations;
+
+  //! The number of constraints above which the Schur complement system is
+  //! solved iteratively.
+  size_t iterativeSchurThreshold;
+
+  //! The relative tolerance of the iterative Schur complement solve.
+  double schurTolerance;
+
+  //! The maximum number of iterations of the iterative Schur complement solve.
+  size_t maxSchurIterations;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
@@ -31,21 +31,48 @@
 
 #include "primal_dual.hpp"
 #include "lin_alg.hpp"
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 
 namespace ens {
 
+/**
+ * Return whether the given matrix is zero outside of the diagonal blocks with
+ * the given offsets (see SDP::BlockOffsets()).
+ */
+static inline bool
+IsBlockDiagonal(const arma::mat& A, const arma::uvec& offsets)
+{
+  for (size_t b = 0; b + 1 < offsets.n_elem; ++b)
+  {
+    for (size_t j = offsets(b); j < offsets(b + 1); ++j)
+    {
+      for (size_t i = 0; i < A.n_rows; ++i)
+      {
+        if ((i < offsets(b) || i >= offsets(b + 1)) && A(i, j) != 0.0)
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 template <typename SDPType>
 PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp)
   : sdp(sdp),
     initialX(arma::eye<arma::mat>(sdp.N(), sdp.N())),
     initialYsparse(arma::ones<arma::vec>(sdp.NumSparseConstraints())),
-    initialYdense(arma::ones<arma::vec>(sdp.NumDenseConstraints())),
+    initialYdense(arma::ones<arma::vec>(sdp.NumDenseConstraints() +
+        sdp.NumLowRankConstraints())),
     initialZ(arma::eye<arma::mat>(sdp.N(), sdp.N())),
     tau(0.99),
     normXzTol(1e-7),
     primalInfeasTol(1e-7),
     dualInfeasTol(1e-7),
-    maxIterations(1000)
+    maxIterations(1000),
+    iterativeSchurThreshold(20000),
+    schurTolerance(1e-10),
+    maxSchurIterations(1000)
 { /* Nothing to do. */ }
 
 template <typename SDPType>
@@ -63,7 +90,10 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
     normXzTol(1e-7),
     primalInfeasTol(1e-7),
     dualInfeasTol(1e-7),
-    maxIterations(1000)
+    maxIterations(1000),
+    iterativeSchurThreshold(20000),
+    schurTolerance(1e-10),
+    maxSchurIterations(1000)
 {
   arma::mat tmp;
 
@@ -89,11 +119,12 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
         "constraints.");
   }
 
-  if (initialYdense.n_elem != sdp.NumDenseConstraints())
+  if (initialYdense.n_elem !=
+      sdp.NumDenseConstraints() + sdp.NumLowRankConstraints())
   {
     throw std::logic_error("PrimalDualSolver::PrimalDualSolver(): "
         "initialYdense needs to have the same length as the number of dense "
-        "constraints.");
+        "and low-rank constraints.");
   }
 
   if (initialZ.n_rows != sdp.N() || initialZ.n_cols != sdp.N())
@@ -107,6 +138,63 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
     throw std::logic_error("PrimalDualSolver::PrimalDualSolver(): "
         "initialZ needs to be symmetric positive definite.");
   }
+
+  // The solver only works on the diagonal blocks of a block-diagonal SDP.
+  if (sdp.NumBlocks() > 1)
+  {
+    const arma::uvec offsets = sdp.BlockOffsets();
+    if (!IsBlockDiagonal(initialX, offsets) ||
+        !IsBlockDiagonal(initialZ, offsets))
+    {
+      throw std::logic_error("PrimalDualSolver::PrimalDualSolver(): "
+          "initialX and initialZ need to be block diagonal.");
+    }
+  }
+}
+
+template <typename SDPType>
+size_t PrimalDualSolver<SDPType>::MemoryEstimate() const
+{
+  const size_t n = sdp.N();
+  const size_t n2bar = sdp.N2bar();
+  const size_t m = sdp.NumConstraints();
+  const size_t numDense = sdp.NumDenseConstraints() +
+      sdp.NumLowRankConstraints();
+
+  size_t sparseNonZeros = 0;
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    sparseNonZeros += sdp.SparseA()[i].n_nonzero;
+
+  // The starting points and the work matrices of the iteration; the vectors of
+  // length n2bar; the dense rows (and the products of the low-rank
+  // constraints); the sparse rows, in Asparse and in the entry lists of the
+  // Schur complement; the Schur complement with its factors and permutation,
+  // or the vectors of BiCGStab.
+  size_t words = 20 * n * n + 10 * n2bar + numDense * n2bar +
+      sdp.NumLowRankConstraints() * n * n + 7 * sparseNonZeros + n2bar;
+  if (m <= iterativeSchurThreshold)
+    words += 4 * m * m + 8 * m;
+  else
+    words += 16 * m;
+
+  return words * sizeof(double);
+}
+
+/**
+ * Estimate the largest eigenvalue of the symmetric matrix B with at most
+ * maxSteps steps of the Lanczos method (see math::Lanczos()).  The estimate is
+ * never larger than the largest eigenvalue, and is exact (up to rounding) when
+ * maxSteps is at least the size of B, unless the starting vector is orthogonal
+ * to the corresponding eigenvector.
+ */
+static inline double
+LargestEigenvalue(const arma::mat& B, const size_t maxSteps = 30)
+{
+  arma::vec values;
+  arma::mat vectors;
+  math::Lanczos([&B](const arma::vec& x) -> arma::vec { return B * x; },
+      B.n_rows, maxSteps, values, vectors);
+  return values(values.n_elem - 1);
 }
 
 /**
@@ -118,27 +206,69 @@ PrimalDualSolver<SDPType>::PrimalDualSolver(const SDPType& sdp,
  *
  *     alphahat = sup{ alphahat : A + dA is psd }
  *
- * See (2.18) of [AHO98] for more details.
+ * See (2.18) of [AHO98] for more details.  With A = L L^T, 1 / alphahat is the
+ * largest eigenvalue of -L^(-1) dA L^(-T), which is formed with two triangular
+ * solves and estimated with LargestEigenvalue().  Since the estimate may be too
+ * small, the step is checked with a Cholesky decomposition of A + alpha dA,
+ * and all the eigenvalues are computed if it leaves the cone.
  */
 static inline bool
 Alpha(const arma::mat& A, const arma::mat& dA, double tau, double& alpha)
 {
+  ENS_TRACE_ZONE("Alpha");
+
   arma::mat L;
   if (!arma::chol(L, A, "lower"))
     return false;
 
-  arma::mat Linv;
-  if (!arma::inv(Linv, arma::trimatl(L)))
+  // B = -L^(-1) dA L^(-T); dA is symmetric, so (L^(-1) dA)^T = dA L^(-T).
+  arma::mat LinvdA, B;
+  if (!arma::solve(LinvdA, arma::trimatl(L), dA))
+    return false;
+  if (!arma::solve(B, arma::trimatl(L), arma::mat(LinvdA.t())))
     return false;
-  // TODO(stephentu): We only want the top eigenvalue, we should
-  // be able to do better than full eigen-decomposition.
-  const arma::vec evals = arma::eig_sym(-Linv * dA * Linv.t());
-  const double alphahatinv = evals(evals.n_elem - 1);
-  double alphahat = 1. / alphahatinv;
+  B = -0.5 * (B + B.t());
+
+  double alphahat = 1. / LargestEigenvalue(B);
   if (alphahat < 0.)
     // dA is PSD already
     alphahat = 1.;
   alpha = std::min(1., tau * alphahat);
+
+  arma::mat step;
+  if (!arma::chol(step, A + alpha * dA))
+  {
+    const arma::vec evals = arma::eig_sym(B);
+    alphahat = 1. / evals(evals.n_elem - 1);
+    if (alphahat < 0.)
+      alphahat = 1.;
+    alpha = std::min(1., tau * alphahat);
+  }
+
+  return true;
+}
+
+/**
+ * Compute the eigendecomposition A = Q diag(d) Q^T of the symmetric matrix A,
+ * and the matrix of the sums d_i + d_j, so that SolveLyapunov() can solve any
+ * number of Lyapunov equations with A.
+ *
+ * @param A A symmetric matrix.
+ * @param Q Matrix to store the eigenvectors of A in.
+ * @param D Matrix to store the sums of the eigenvalues of A in.
+ * @return false if the eigendecomposition failed.
+ */
+static inline bool
+LyapunovBasis(const arma::mat& A, arma::mat& Q, arma::mat& D)
+{
+  ENS_TRACE_ZONE("LyapunovBasis");
+
+  arma::vec d;
+  if (!arma::eig_sym(d, Q, A))
+    return false;
+
+  D = arma::repmat(d, 1, d.n_elem);
+  D += D.t();
   return true;
 }
 
@@ -147,17 +277,248 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau, double& alpha)
  *
  *   AX + XA = H
  *
- * where A, H are symmetric matrices.
+ * where A, H are symmetric matrices, given the eigenvectors Q of A and the
+ * sums D of its eigenvalues computed by LyapunovBasis().  In the eigenbasis of
+ * A the equation is diagonal, so (Lemma 7.2 of [AHO98])
  *
- * TODO(stephentu): Note this method current uses arma's builtin arma::syl
- * method, which is overkill for this situation. See Lemma 7.2 of [AHO98] for
- * how to solve this Lyapunov equation using an eigenvalue decomposition of A.
+ *   X = Q ((Q^T H Q) ./ D) Q^T,
  *
+ * which costs four matrix products instead of a Schur decomposition per
+ * equation.
+ */
+static inline void
+SolveLyapunov(arma::mat& X,
+              const arma::mat& Q,
+              const arma::mat& D,
+              const arma::mat& H)
+{
+  ENS_TRACE_ZONE("SolveLyapunov");
+  X = Q * ((Q.t() * H * Q) / D) * Q.t();
+}
+
+/**
+ * Call task(b, span) for each non-empty diagonal block b of a block-diagonal
+ * matrix with the given block offsets (see SDP::BlockOffsets()), where span is
+ * the range of rows and columns of the block.  The blocks are independent, so
+ * they are processed in parallel; a single block is processed directly, so
+ * that its linear algebra keeps all the threads.
+ */
+template<typename TaskType>
+static inline void
+ForEachBlock(const arma::uvec& offsets, const TaskType& task)
+{
+  const size_t numBlocks = offsets.n_elem - 1;
+  if (numBlocks == 1)
+  {
+    if (offsets(1) > 0)
+      task(0, arma::span(0, offsets(1) - 1));
+    return;
+  }
+
+  ENS_PRAGMA_OMP_PARALLEL
+  {
+    size_t threadId = 0;
+    size_t numThreads = 1;
+    #ifdef ENS_USE_OPENMP
+      threadId = omp_get_thread_num();
+      numThreads = omp_get_num_threads();
+    #endif
+
+    for (size_t b = threadId; b < numBlocks; b += numThreads)
+    {
+      if (offsets(b + 1) > offsets(b))
+        task(b, arma::span(offsets(b), offsets(b + 1) - 1));
+    }
+  }
+}
+
+/**
+ * Compute the product of two block-diagonal matrices one block at a time.  The
+ * entries of the product outside of the blocks are zero.
+ */
+static inline void
+BlockProduct(const arma::mat& A,
+             const arma::mat& B,
+             const arma::uvec& offsets,
+             arma::mat& product)
+{
+  if (offsets.n_elem <= 2)
+  {
+    product = A * B;
+    return;
+  }
+
+  product.zeros(A.n_rows, B.n_cols);
+  ForEachBlock(offsets, [&](const size_t /* b */, const arma::span& s)
+  {
+    product(s, s) = A(s, s) * B(s, s);
+  });
+}
+
+/**
+ * Alpha() for block-diagonal matrices: A + alpha dA is positive semidefinite
+ * if each of its blocks is, so the step is the smallest step of the blocks.
+ */
+static inline bool
+BlockAlpha(const arma::mat& A,
+           const arma::mat& dA,
+           const arma::uvec& offsets,
+           double tau,
+           double& alpha)
+{
+  if (offsets.n_elem <= 2)
+    return Alpha(A, dA, tau, alpha);
+
+  arma::vec alphas(offsets.n_elem - 1, arma::fill::ones);
+  std::vector<char> success(offsets.n_elem - 1, 1);
+  ForEachBlock(offsets, [&](const size_t b, const arma::span& s)
+  {
+    double blockAlpha;
+    success[b] = Alpha(arma::mat(A(s, s)), arma::mat(dA(s, s)), tau,
+        blockAlpha);
+    if (success[b])
+      alphas(b) = blockAlpha;
+  });
+
+  if (std::find(success.begin(), success.end(), 0) != success.end())
+    return false;
+
+  alpha = alphas.min();
+  return true;
+}
+
+/**
+ * LyapunovBasis() for a block-diagonal matrix: the eigendecomposition is
+ * computed one block at a time, so Q is block-diagonal too.  The entries of D
+ * outside of the blocks are set to one, so that the division in
+ * BlockSolveLyapunov() is always defined.
+ */
+static inline bool
+BlockLyapunovBasis(const arma::mat& A,
+                   const arma::uvec& offsets,
+                   arma::mat& Q,
+                   arma::mat& D)
+{
+  if (offsets.n_elem <= 2)
+    return LyapunovBasis(A, Q, D);
+
+  Q.zeros(A.n_rows, A.n_cols);
+  D.ones(A.n_rows, A.n_cols);
+  std::vector<char> success(offsets.n_elem - 1, 1);
+  ForEachBlock(offsets, [&](const size_t b, const arma::span& s)
+  {
+    arma::mat Qb, Db;
+    success[b] = LyapunovBasis(arma::mat(A(s, s)), Qb, Db);
+    if (!success[b])
+      return;
+
+    Q(s, s) = Qb;
+    D(s, s) = Db;
+  });
+
+  return std::find(success.begin(), success.end(), 0) == success.end();
+}
+
+/**
+ * SolveLyapunov() for a block-diagonal right hand side H and basis (Q, D)
+ * given by BlockLyapunovBasis(); each block is an independent equation.
  */
 static inline void
-SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
+BlockSolveLyapunov(arma::mat& X,
+                   const arma::mat& Q,
+                   const arma::mat& D,
+                   const arma::mat& H,
+                   const arma::uvec& offsets)
 {
-  arma::syl(X, A, A, -H);
+  if (offsets.n_elem <= 2)
+  {
+    SolveLyapunov(X, Q, D, H);
+    return;
+  }
+
+  X.zeros(H.n_rows, H.n_cols);
+  ForEachBlock(offsets, [&](const size_t /* b */, const arma::span& s)
+  {
+    const arma::mat Qb = Q(s, s);
+    X(s, s) = Qb * ((Qb.t() * H(s, s) * Qb) / D(s, s)) * Qb.t();
+  });
+}
+
+/**
+ * math::SymKronIdTimes() for a block-diagonal A and a block-diagonal smat(x).
+ */
+static inline void
+BlockSymKronIdTimes(const arma::mat& A,
+                    const arma::uvec& offsets,
+                    const arma::vec& x,
+                    arma::vec& output)
+{
+  if (offsets.n_elem <= 2)
+  {
+    math::SymKronIdTimes(A, x, output);
+    return;
+  }
+
+  arma::mat xMat, product;
+  math::Smat(x, xMat);
+  BlockProduct(A, xMat, offsets, product);
+  math::Svec(0.5 * (product + product.t()), output);
+}
+
+/**
+ * Compute M v for the Schur complement M = A E^(-1) F A^T without forming it:
+ * with V = smat(A^T v), M v = A svec(G), where G solves the Lyapunov equation
+ *
+ *   Z G + G Z = X V + V X
+ *
+ * (see (2.16) of [AHO98]), with the eigendecomposition (Zq, Zd) of Z given by
+ * BlockLyapunovBasis().  A product costs O(n^3) time (the sum over the blocks
+ * for a block-diagonal SDP) and no O(m^2) memory.
+ */
+static inline arma::vec
+SchurTimes(const arma::sp_mat& Asparse,
+           const arma::mat& Adense,
+           const arma::mat& Zq,
+           const arma::mat& Zd,
+           const arma::mat& X,
+           const arma::uvec& offsets,
+           const arma::vec& v)
+{
+  const size_t numSparse = Asparse.n_rows;
+  arma::vec atv(Asparse.n_cols, arma::fill::zeros);
+  if (numSparse)
+    atv += Asparse.t() * arma::vec(v.subvec(0, numSparse - 1));
+  if (Adense.n_rows)
+    atv += Adense.t() * v.subvec(numSparse, v.n_elem - 1);
+
+  arma::vec fv, g;
+  arma::mat F, G;
+  BlockSymKronIdTimes(X, offsets, atv, fv);
+  math::Smat(fv, F);
+  BlockSolveLyapunov(G, Zq, Zd, 2. * F, offsets);
+  math::Svec(G, g);
+
+  arma::vec product(v.n_elem);
+  if (numSparse)
+    product.subvec(0, numSparse - 1) = Asparse * g;
+  if (Adense.n_rows)
+    product.subvec(numSparse, v.n_elem - 1) = Adense * g;
+  return product;
+}
+
+/**
+ * Compute the inverse of the block-diagonal matrix Z = Q diag(d) Q^T from the
+ * basis (Q, D) given by BlockLyapunovBasis(), where d_i = D_ii / 2.
+ */
+static inline void
+BlockLyapunovInverse(const arma::mat& Q,
+                     const arma::mat& D,
+                     const arma::uvec& offsets,
+                     arma::mat& Zinv)
+{
+  arma::mat W = Q;
+  W.each_row() /= arma::rowvec(0.5 * D.diag().t());
+  BlockProduct(W, arma::mat(Q.t()), offsets, Zinv);
 }
 
 /**
@@ -176,13 +537,22 @@ SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
  *     E  = Z sym I
  *     F  = X sym I
  *
+ * Neither E nor F is formed: products with F are computed from X with
+ * math::SymKronIdTimes(), and E^(-1) is applied by solving Lyapunov equations
+ * with the eigendecomposition (Zq, Zd) of Z given by BlockLyapunovBasis().  The
+ * system with the Schur complement M = A E^(-1) F A^T is solved by
+ * schurSolve(rhs, dy), which returns false on failure.  X and Z are
+ * block-diagonal with the given block offsets.
  */
+template<typename SchurSolveType>
 static inline void
 SolveKKTSystem(const arma::sp_mat& Asparse,
                const arma::mat& Adense,
-               const arma::mat& Z,
-               const arma::mat& M,
-               const arma::mat& F,
+               const arma::mat& Zq,
+               const arma::mat& Zd,
+               const SchurSolveType& schurSolve,
+               const arma::mat& X,
+               const arma::uvec& offsets,
                const arma::vec& rp,
                const arma::vec& rd,
                const arma::vec& rc,
@@ -193,14 +563,15 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
 {
   arma::mat Frd_rc_Mat, Einv_Frd_rc_Mat,
             Einv_Frd_ATdy_rc_Mat, Frd_ATdy_rc_Mat;
-  arma::vec Einv_Frd_rc, Einv_Frd_ATdy_rc, dy;
+  arma::vec Frd, Frd_ATdy, Einv_Frd_rc, Einv_Frd_ATdy_rc, dy;
 
   // Note: Whenever a formula calls for E^(-1) v for some v, we solve Lyapunov
   // equations instead of forming an explicit inverse.
 
   // Compute the RHS of (2.12)
-  math::Smat(F * rd - rc, Frd_rc_Mat);
-  SolveLyapunov(Einv_Frd_rc_Mat, Z, 2. * Frd_rc_Mat);
+  BlockSymKronIdTimes(X, offsets, rd, Frd);
+  math::Smat(Frd - rc, Frd_rc_Mat);
+  BlockSolveLyapunov(Einv_Frd_rc_Mat, Zq, Zd, 2. * Frd_rc_Mat, offsets);
   math::Svec(Einv_Frd_rc_Mat, Einv_Frd_rc);
 
   arma::vec rhs = rp;
@@ -210,8 +581,7 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
   if (Adense.n_rows)
     rhs(arma::span(Asparse.n_rows, numConstraints - 1)) += Adense * Einv_Frd_rc;
 
-  // TODO(stephentu): use a more efficient method (e.g. LU decomposition)
-  if (!arma::solve(dy, M, rhs))
+  if (!schurSolve(rhs, dy))
   {
     throw std::logic_error("PrimalDualSolver::SolveKKTSystem(): Could not "
         "solve KKT system.");
@@ -223,9 +593,11 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
     dydense = dy(arma::span(Asparse.n_rows, numConstraints - 1));
 
   // Compute dx from (2.13)
-  math::Smat(F * (rd - Asparse.t() * dysparse - Adense.t() * dydense) - rc,
-      Frd_ATdy_rc_Mat);
-  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Z, 2. * Frd_ATdy_rc_Mat);
+  BlockSymKronIdTimes(X, offsets,
+      rd - Asparse.t() * dysparse - Adense.t() * dydense, Frd_ATdy);
+  math::Smat(Frd_ATdy - rc, Frd_ATdy_rc_Mat);
+  BlockSolveLyapunov(Einv_Frd_ATdy_rc_Mat, Zq, Zd, 2. * Frd_ATdy_rc_Mat,
+      offsets);
   math::Svec(Einv_Frd_ATdy_rc_Mat, Einv_Frd_ATdy_rc);
   dsx = -Einv_Frd_ATdy_rc;
 
@@ -242,15 +614,244 @@ template <typename eT> struct vectype<arma::Mat<eT>>
 template <typename eT> struct vectype<arma::SpMat<eT>>
 { typedef arma::SpCol<eT> type; };
 
+/**
+ * The non-zero entries of a sparse constraint matrix A_i, so that its column
+ * of the Schur complement can be assembled in time proportional to them.
+ */
+struct SparseConstraint
+{
+  //! The rows of A_i with a non-zero entry, in increasing order.
+  arma::uvec rows;
+  //! The index in rows of the row of each non-zero entry.
+  arma::uvec localRows;
+  //! The row of each non-zero entry.
+  arma::uvec entryRows;
+  //! The column of each non-zero entry.
+  arma::uvec entryCols;
+  //! The value of each non-zero entry.
+  arma::vec values;
+};
+
+//! Collect the non-zero entries of the given constraint matrix.
+inline void MakeSparseConstraint(const arma::sp_mat& A, SparseConstraint& c)
+{
+  c.entryRows.set_size(A.n_nonzero);
+  c.entryCols.set_size(A.n_nonzero);
+  c.values.set_size(A.n_nonzero);
+
+  size_t k = 0;
+  for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it, ++k)
+  {
+    c.entryRows(k) = it.row();
+    c.entryCols(k) = it.col();
+    c.values(k) = *it;
+  }
+
+  c.rows = (A.n_nonzero > 0) ? arma::uvec(arma::unique(c.entryRows)) :
+      arma::uvec();
+  c.localRows.set_size(A.n_nonzero);
+  for (k = 0; k < A.n_nonzero; ++k)
+  {
+    c.localRows(k) = std::lower_bound(c.rows.begin(), c.rows.end(),
+        c.entryRows(k)) - c.rows.begin();
+  }
+}
+
+/**
+ * The diagonal blocks of a constraint matrix A_i of a block-diagonal SDP, so
+ * that its column of the Schur complement can be assembled one block at a
+ * time.
+ */
+struct BlockConstraint
+{
+  //! The blocks where A_i has a non-zero entry, in increasing order.
+  std::vector<size_t> blocks;
+  //! The diagonal blocks of a sparse A_i, in the order of blocks.
+  std::vector<arma::sp_mat> sparse;
+  //! The diagonal blocks of a dense A_i, in the order of blocks.
+  std::vector<arma::mat> dense;
+};
+
+//! Split the given sparse constraint matrix into its diagonal blocks.
+inline void MakeBlockConstraint(const arma::sp_mat& A,
+                                const arma::uvec& offsets,
+                                BlockConstraint& c)
+{
+  for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+  {
+    const size_t b = std::upper_bound(offsets.begin(), offsets.end(),
+        (arma::uword) it.row()) - offsets.begin() - 1;
+    c.blocks.push_back(b);
+  }
+  std::sort(c.blocks.begin(), c.blocks.end());
+  c.blocks.erase(std::unique(c.blocks.begin(), c.blocks.end()),
+      c.blocks.end());
+
+  for (size_t k = 0; k < c.blocks.size(); ++k)
+  {
+    const size_t b = c.blocks[k];
+    c.sparse.push_back(arma::sp_mat(A.submat(offsets(b), offsets(b),
+        offsets(b + 1) - 1, offsets(b + 1) - 1)));
+  }
+}
+
+//! Split the given dense constraint matrix into its diagonal blocks.
+inline void MakeBlockConstraint(const arma::mat& A,
+                                const arma::uvec& offsets,
+                                BlockConstraint& c)
+{
+  for (size_t b = 0; b + 1 < offsets.n_elem; ++b)
+  {
+    if (offsets(b + 1) == offsets(b))
+      continue;
+
+    const arma::span s(offsets(b), offsets(b + 1) - 1);
+    if (arma::any(arma::vectorise(A(s, s)) != 0.0))
+    {
+      c.blocks.push_back(b);
+      c.dense.push_back(A(s, s));
+    }
+  }
+}
+
 } // namespace private_
 
+/**
+ * Approximate the diagonal of the Schur complement M = A E^(-1) F A^T by its
+ * value on the central path, where XZ = mu I and so E^(-1) F = X sym Z^(-1):
+ *
+ *   M_jj ~ <A_j, X A_j Z^(-1)>.
+ *
+ * This takes O(nnz(A_j)^2) time for a sparse A_j; for a dense A_j, X and
+ * Z^(-1) are replaced by their diagonals, which takes O(n^2) time.  For a
+ * low-rank A_j = V V^T, it is <V^T X V, V^T Z^(-1) V>, which takes O(n^2 k)
+ * time.  The estimates that are not positive are replaced by one.
+ */
+static inline void
+SchurDiagonal(const std::vector<private_::SparseConstraint>& sparse,
+              const std::vector<arma::mat>& dense,
+              const std::vector<arma::mat>& lowRank,
+              const arma::mat& X,
+              const arma::mat& Zinv,
+              arma::vec& diagonal)
+{
+  diagonal.set_size(sparse.size() + dense.size() + lowRank.size());
+  for (size_t j = 0; j < sparse.size(); ++j)
+  {
+    // tr(A X A Z^(-1)) = sum_{(p, q), (r, s)} A_pq X_qr A_rs Z^(-1)_sp.
+    const private_::SparseConstraint& c = sparse[j];
+    double mjj = 0.0;
+    for (size_t k = 0; k < c.values.n_elem; ++k)
+    {
+      for (size_t l = 0; l < c.values.n_elem; ++l)
+      {
+        mjj += c.values(k) * c.values(l) * X(c.entryCols(k), c.entryRows(l)) *
+            Zinv(c.entryCols(l), c.entryRows(k));
+      }
+    }
+    diagonal(j) = mjj;
+  }
+
+  const arma::vec xDiagonal = X.diag();
+  const arma::vec zinvDiagonal = Zinv.diag();
+  for (size_t j = 0; j < dense.size(); ++j)
+  {
+    diagonal(sparse.size() + j) = arma::dot(zinvDiagonal,
+        (dense[j] % dense[j]) * xDiagonal);
+  }
+
+  for (size_t j = 0; j < lowRank.size(); ++j)
+  {
+    const arma::mat& V = lowRank[j];
+    diagonal(sparse.size() + dense.size() + j) = arma::accu(
+        (V.t() * X * V) % (V.t() * Zinv * V));
+  }
+
+  diagonal.elem(arma::find(diagonal <= 0.0)).ones();
+}
+
+/**
+ * Move the symmetric part of the given matrix into the interior of the PSD
+ * cone, one diagonal block at a time: the eigenvalues of each block below
+ * shift * max(1, lambda_max) are raised to that value, and the eigenvectors are
+ * kept.  The entries outside of the blocks are dropped.
+ */
+static inline bool
+ShiftIntoInterior(const arma::mat& A,
+                  const arma::uvec& offsets,
+                  const double shift,
+                  arma::mat& shifted)
+{
+  shifted.zeros(A.n_rows, A.n_cols);
+  std::vector<char> success(offsets.n_elem - 1, 1);
+  ForEachBlock(offsets, [&](const size_t b, const arma::span& s)
+  {
+    arma::vec eigval;
+    arma::mat eigvec;
+    const arma::mat block = 0.5 * (A(s, s) + A(s, s).t());
+    success[b] = arma::eig_sym(eigval, eigvec, block);
+    if (!success[b])
+      return;
+
+    const double floor = shift * std::max(1.0, eigval.max());
+    eigval.elem(arma::find(eigval < floor)).fill(floor);
+    shifted(s, s) = eigvec * arma::diagmat(eigval) * eigvec.t();
+  });
+
+  return std::find(success.begin(), success.end(), 0) == success.end();
+}
+
 template <typename SDPType>
+void PrimalDualSolver<SDPType>::WarmStart(const arma::mat& X,
+                                          const arma::vec& ysparse,
+                                          const arma::vec& ydense,
+                                          const arma::mat& Z,
+                                          const double shift)
+{
+  if (X.n_rows != sdp.N() || X.n_cols != sdp.N() ||
+      Z.n_rows != sdp.N() || Z.n_cols != sdp.N())
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): X and Z need to be "
+        "square n x n matrices.");
+  }
+
+  if (ysparse.n_elem != sdp.NumSparseConstraints() ||
+      ydense.n_elem != sdp.NumDenseConstraints() + sdp.NumLowRankConstraints())
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): ysparse and ydense "
+        "need to have one element per sparse and per dense or low-rank "
+        "constraint.");
+  }
+
+  if (shift <= 0.0)
+  {
+    throw std::logic_error("PrimalDualSolver::WarmStart(): shift needs to be "
+        "positive.");
+  }
+
+  const arma::uvec offsets = sdp.BlockOffsets();
+  if (!ShiftIntoInterior(X, offsets, shift, initialX) ||
+      !ShiftIntoInterior(Z, offsets, shift, initialZ))
+  {
+    throw std::runtime_error("PrimalDualSolver::WarmStart(): "
+        "eigendecomposition of X or Z failed.");
+  }
+
+  initialYsparse = ysparse;
+  initialYdense = ydense;
+}
+
+template <typename SDPType>
+template <typename... CallbackTypes>
 double
 PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
                                     arma::vec& ysparse,
                                     arma::vec& ydense,
-                                    arma::mat& Z)
+                                    arma::mat& Z,
+                                    CallbackTypes&&... callbacks)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   // TODO(stephentu): We need a method which deals with the case when the Ais
   // are not linearly independent.
 
@@ -258,23 +859,90 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
   const size_t n2bar = sdp.N2bar();
 
   // Form the A matrix in (2.7). Note we explicitly handle
-  // sparse and dense constraints separately.
-
+  // sparse and dense constraints separately.  The sparse part is assembled in
+  // one batch from its non-zero entries.
   arma::sp_mat Asparse(sdp.NumSparseConstraints(), n2bar);
-  arma::sp_vec Aisparse;
+  if (sdp.NumSparseConstraints())
+    math::SvecRows(sdp.SparseA(), Asparse);
+
+  // The low-rank constraints are rows of the dense part, after the dense
+  // constraints.
+  const size_t numDense = sdp.NumDenseConstraints();
+  const size_t numLowRank = sdp.NumLowRankConstraints();
+  arma::mat Adense(numDense, n2bar);
+  if (numDense)
+    math::SvecRows(sdp.DenseA(), Adense);
+  if (numLowRank)
+  {
+    std::vector<arma::mat> lowRankA(numLowRank);
+    for (size_t i = 0; i < numLowRank; i++)
+      lowRankA[i] = sdp.LowRankA()[i] * sdp.LowRankA()[i].t();
 
-  for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
+    arma::mat lowRankRows;
+    math::SvecRows(lowRankA, lowRankRows);
+    Adense = arma::join_cols(Adense, lowRankRows);
+  }
+  const arma::vec denseB = arma::join_cols(sdp.DenseB(), sdp.LowRankB());
+
+  // Collect the non-zero entries of the sparse constraints, and the rows where
+  // any of them has a non-zero entry.
+  const size_t numSparse = sdp.NumSparseConstraints();
+  std::vector<private_::SparseConstraint> sparseConstraints(numSparse);
+  arma::uvec sparseRows;
+  size_t sparseNonZeros = 0;
+  for (size_t i = 0; i < numSparse; i++)
   {
-    math::Svec(sdp.SparseA()[i], Aisparse);
-    Asparse.row(i) = Aisparse.t();
+    private_::MakeSparseConstraint(sdp.SparseA()[i], sparseConstraints[i]);
+    sparseRows = arma::join_cols(sparseRows, sparseConstraints[i].rows);
+    sparseNonZeros += sdp.SparseA()[i].n_nonzero;
   }
-
-  arma::mat Adense(sdp.NumDenseConstraints(), n2bar);
-  arma::vec Aidense;
-  for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
+  if (sparseRows.n_elem > 0)
+    sparseRows = arma::unique(sparseRows);
+
+  arma::uvec sparseRowIndex(n, arma::fill::zeros);
+  for (size_t i = 0; i < sparseRows.n_elem; i++)
+    sparseRowIndex(sparseRows(i)) = i;
+
+  // Without dense constraints, only the entries of each G_j (see below) where
+  // some sparse constraint has a non-zero entry are needed.  Computing them
+  // takes O((|rows| n + nnz) n) time per constraint instead of the O(n^3) of
+  // the whole G_j.
+  const arma::uvec offsets = sdp.BlockOffsets();
+  const size_t numBlocks = offsets.n_elem - 1;
+  const bool entrywise = (numBlocks == 1) && (numDense == 0) &&
+      (sparseRows.n_elem * n + sparseNonZeros < 2 * n * n);
+
+  // For a block-diagonal SDP, split each constraint into its diagonal blocks,
+  // and collect the constraints (and their position in the list of blocks of
+  // the constraint) which have an entry in each block.
+  std::vector<private_::BlockConstraint> blockConstraints;
+  std::vector<std::vector<std::pair<size_t, size_t>>> blockMembers;
+  if (numBlocks > 1)
   {
-    math::Svec(sdp.DenseA()[i], Aidense);
-    Adense.row(i) = Aidense.t();
+    blockConstraints.resize(sdp.NumConstraints());
+    blockMembers.resize(numBlocks);
+    for (size_t i = 0; i < sdp.NumConstraints(); i++)
+    {
+      if (i < numSparse)
+      {
+        private_::MakeBlockConstraint(sdp.SparseA()[i], offsets,
+            blockConstraints[i]);
+      }
+      else if (i < numSparse + numDense)
+      {
+        private_::MakeBlockConstraint(sdp.DenseA()[i - numSparse], offsets,
+            blockConstraints[i]);
+      }
+      else
+      {
+        const arma::mat& V = sdp.LowRankA()[i - numSparse - numDense];
+        private_::MakeBlockConstraint(arma::mat(V * V.t()), offsets,
+            blockConstraints[i]);
+      }
+
+      for (size_t k = 0; k < blockConstraints[i].blocks.size(); k++)
+        blockMembers[blockConstraints[i].blocks[k]].emplace_back(i, k);
+    }
   }
 
   typename private_::vectype<typename SDPType::objective_matrix_type>::type sc;
@@ -291,20 +959,54 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
   math::Svec(X, sx);
   math::Svec(Z, sz);
 
-  arma::vec rp, rd, rc, gk;
+  arma::vec rp, rd, rc;
 
-  arma::mat Rc, F, Einv_F_AsparseT, Einv_F_AdenseT, Gk,
-            M, DualCheck;
+  arma::mat Rc, M, ML, MU, MP, Zq, Zd, Zinv, DualCheck, XZ, ZX, dXdZ, dZdX;
+  arma::vec schurDiagonal;
 
-  rp.set_size(sdp.NumConstraints());
+  // With many constraints, the m x m Schur complement M is not formed: the
+  // systems with M are solved with BiCGSTAB (M is not symmetric for the AHO
+  // direction), with products with M computed by SchurTimes() and a diagonal
+  // preconditioner.  Otherwise M is factored with LU once for both the
+  // predictor and the corrector steps.
+  const bool iterative = (sdp.NumConstraints() > iterativeSchurThreshold);
+  const auto schurSolve = [&](const arma::vec& rhs, arma::vec& dy) -> bool
+  {
+    if (!iterative)
+    {
+      arma::vec Ldy;
+      return arma::solve(Ldy, arma::trimatl(ML), MP * rhs) &&
+          arma::solve(dy, arma::trimatu(MU), Ldy);
+    }
+
+    if (!math::BiCGStab([&](const arma::vec& v) -> arma::vec
+        {
+          return SchurTimes(Asparse, Adense, Zq, Zd, X, offsets, v);
+        },
+        [&](const arma::vec& v) -> arma::vec { return v / schurDiagonal; },
+        rhs, dy, schurTolerance, maxSchurIterations))
+    {
+      ENS_WARN << "PrimalDualSolver::Optimize(): the iterative solve of the "
+          << "Schur complement system did not converge; using the last "
+          << "iterate." << std::endl;
+    }
+    return dy.is_finite();
+  };
 
-  Einv_F_AsparseT.set_size(n2bar, sdp.NumSparseConstraints());
-  Einv_F_AdenseT.set_size(n2bar, sdp.NumDenseConstraints());
-  M.set_size(sdp.NumConstraints(), sdp.NumConstraints());
+  rp.set_size(sdp.NumConstraints());
+  if (!iterative)
+    M.set_size(sdp.NumConstraints(), sdp.NumConstraints());
 
   double primalObj = 0., alpha, beta;
-  for (size_t iteration = 1; iteration != maxIterations; iteration++)
+  bool terminate = Callback::BeginOptimization(*this, sdp, X, callbacks...);
+  for (size_t iteration = 1; iteration != maxIterations && !terminate;
+       iteration++)
   {
+    terminate |= Callback::BeginEpoch(*this, sdp, X, iteration, primalObj,
+        callbacks...);
+    if (terminate)
+      break;
+
     // Note: The Mehrotra PC algorithm works like this at a high level.
     // We first solve a KKT system with mu=0. Then, we use the results
     // of this KKT system to get a better estimate of mu and solve
@@ -315,93 +1017,222 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     if (sdp.NumSparseConstraints())
       rp(arma::span(0, sdp.NumSparseConstraints() - 1)) =
         sdp.SparseB() - Asparse * sx;
-    if (sdp.NumDenseConstraints())
+    if (Adense.n_rows)
       rp(arma::span(sdp.NumSparseConstraints(), sdp.NumConstraints() - 1)) =
-          sdp.DenseB() - Adense * sx;
+          denseB - Adense * sx;
 
     // Rd = C - Z - smat A^T y
     rd = sc - sz - Asparse.t() * ysparse - Adense.t() * ydense;
 
-    math::SymKronId(X, F);
-
-    // We compute E^(-1) F A^T by solving Lyapunov equations.
-    // See (2.16).
-    for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
+    // All the Lyapunov equations of this iteration are solved with the same
+    // eigendecomposition of Z.
+    if (!BlockLyapunovBasis(Z, offsets, Zq, Zd))
     {
-      SolveLyapunov(Gk, Z, X * sdp.SparseA()[i] + sdp.SparseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AsparseT.col(i) = gk;
+      ENS_WARN << "PrimalDualSolver::Optimize(): eigendecomposition of Z "
+          << "failed!  Terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
+      return primalObj;
     }
 
-    for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
+    if (!iterative)
     {
-      SolveLyapunov(Gk, Z, X * sdp.DenseA()[i] + sdp.DenseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AdenseT.col(i) = gk;
-    }
+      // Form the M = A E^(-1) F A^T matrix (2.15) one column at a time.  By
+      // (2.16), column j is A svec(G_j), where G_j solves the Lyapunov
+      // equation
+      //
+      //   Z G_j + G_j Z = X A_j + A_j X,
+      //
+      // so neither F nor E^(-1) F A^T has to be formed.  With
+      // Z = Q diag(d) Q^T, G_j = Q Y_j Q^T where
+      // Y_j = (Q^T (X A_j + A_j X) Q) ./ (d_i + d_j).  For a sparse A_j,
+      // Q^T X A_j Q = (Q^T X)(:, rows) (A_j Q)(rows, :) only involves the rows
+      // of A_j with a non-zero entry.  For a block-diagonal SDP, G_j is
+      // computed one diagonal block of A_j at a time, and only meets the
+      // constraints with an entry in the same block.  The columns are
+      // independent, so they are computed in parallel.
+      const arma::mat Qt = Zq.t();
+      const arma::mat QtX = (numBlocks == 1) ? arma::mat(Qt * X) : arma::mat();
+      const arma::mat QtS = entrywise ? arma::mat(Qt.cols(sparseRows)) :
+          arma::mat();
+
+      // For a low-rank A_i = V_i V_i^T, <A_i, G_j> = <W_i, Y_j W_i> with
+      // W_i = Q^T V_i, so G_j is not needed for these rows.
+      std::vector<arma::mat> W((numBlocks == 1) ? numLowRank : 0);
+      for (size_t i = 0; i < W.size(); i++)
+        W[i] = Qt * sdp.LowRankA()[i];
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        arma::mat Yk, Lk, AQt, Pt, Gk;
+        arma::vec gk;
+        for (size_t j = threadId; j < sdp.NumConstraints(); j += numThreads)
+        {
+          if (numBlocks > 1)
+          {
+            M.col(j).zeros();
+            const private_::BlockConstraint& cj = blockConstraints[j];
+            for (size_t k = 0; k < cj.blocks.size(); k++)
+            {
+              const size_t b = cj.blocks[k];
+              const arma::span s(offsets(b), offsets(b + 1) - 1);
+              const arma::mat Qb = Zq(s, s);
+              const arma::mat Xb = X(s, s);
+
+              // X_b A_j + A_j X_b = L + L^T with L = X_b A_j.
+              if (j < numSparse)
+                Lk = Xb * cj.sparse[k];
+              else
+                Lk = Xb * cj.dense[k];
+              Yk = (Qb.t() * (Lk + Lk.t()) * Qb) / Zd(s, s);
+              Gk = Qb * Yk * Qb.t();
+
+              for (size_t l = 0; l < blockMembers[b].size(); l++)
+              {
+                const size_t i = blockMembers[b][l].first;
+                const private_::BlockConstraint& ci = blockConstraints[i];
+                if (i < numSparse)
+                {
+                  const arma::sp_mat& Ai = ci.sparse[blockMembers[b][l].second];
+                  double mij = 0.0;
+                  for (arma::sp_mat::const_iterator it = Ai.begin();
+                       it != Ai.end(); ++it)
+                  {
+                    mij += (*it) * Gk(it.row(), it.col());
+                  }
+                  M(i, j) += mij;
+                }
+                else
+                {
+                  M(i, j) += arma::accu(ci.dense[blockMembers[b][l].second] %
+                      Gk);
+                }
+              }
+            }
+            continue;
+          }
+
+          if (j < numSparse)
+          {
+            // AQt holds the transpose of the non-zero rows of A_j Q.
+            const private_::SparseConstraint& c = sparseConstraints[j];
+            AQt.zeros(n, c.rows.n_elem);
+            for (size_t k = 0; k < c.values.n_elem; k++)
+              AQt.col(c.localRows(k)) += c.values(k) * Qt.col(c.entryCols(k));
+
+            Lk = QtX.cols(c.rows) * AQt.t();
+            Yk = (Lk + Lk.t()) / Zd;
+          }
+          else if (j < numSparse + numDense)
+          {
+            const arma::mat& Aj = sdp.DenseA()[j - numSparse];
+            Yk = (Qt * (X * Aj + Aj * X) * Zq) / Zd;
+          }
+          else
+          {
+            // Q^T X A_j Q = (Q^T X V_j) W_j^T.
+            const size_t l = j - numSparse - numDense;
+            Lk = (QtX * sdp.LowRankA()[l]) * W[l].t();
+            Yk = (Lk + Lk.t()) / Zd;
+          }
+
+          for (size_t i = 0; i < numLowRank; i++)
+          {
+            M(numSparse + numDense + i, j) = arma::accu(W[i] % (Yk * W[i]));
+          }
+
+          if (entrywise)
+          {
+            // Pt(:, s) = (Q(sparseRows(s), :) Y_j)^T, so that
+            // G_j(p, q) = dot(Pt(:, index of p), Q(q, :)).
+            Pt = Yk * QtS;
+            for (size_t i = 0; i < numSparse; i++)
+            {
+              const private_::SparseConstraint& c = sparseConstraints[i];
+              double mij = 0.0;
+              for (size_t k = 0; k < c.values.n_elem; k++)
+              {
+                mij += c.values(k) * arma::dot(
+                    Pt.col(sparseRowIndex(c.entryRows(k))),
+                    Qt.col(c.entryCols(k)));
+              }
+              M(i, j) = mij;
+            }
+            continue;
+          }
+
+          if (numSparse + numDense == 0)
+            continue;
+
+          Gk = Zq * Yk * Qt;
+          math::Svec(Gk, gk);
+
+          if (numSparse)
+          {
+            M.submat(arma::span(0, numSparse - 1), arma::span(j, j)) =
+                Asparse * gk;
+          }
+          if (numDense)
+          {
+            M.submat(arma::span(numSparse, numSparse + numDense - 1),
+                     arma::span(j, j)) = Adense.rows(0, numDense - 1) * gk;
+          }
+        }
+      }
 
-    // Form the M = A E^(-1) F A^T matrix (2.15)
-    //
-    // Since we split A up into its sparse and dense components,
-    // we have to handle each block separately.
-    if (sdp.NumSparseConstraints())
-    {
-      M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-               arma::span(0, sdp.NumSparseConstraints() - 1)) =
-          Asparse * Einv_F_AsparseT;
-      if (sdp.NumDenseConstraints())
+      // M is not symmetric in general for the AHO direction, so it is factored
+      // with LU once for both the predictor and the corrector steps.
+      if (!arma::lu(ML, MU, MP, M))
       {
-        M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-                 arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1)) =
-            Asparse * Einv_F_AdenseT;
+        ENS_WARN << "PrimalDualSolver::Optimize(): LU decomposition of the "
+            << "Schur complement failed!  Terminating optimization."
+            << std::endl;
+        Callback::EndOptimization(*this, sdp, X, callbacks...);
+        return primalObj;
       }
     }
-    if (sdp.NumDenseConstraints())
+    else
     {
-      if (sdp.NumSparseConstraints())
-      {
-        M.submat(arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1),
-                 arma::span(0,
-                            sdp.NumSparseConstraints() - 1)) =
-            Adense * Einv_F_AsparseT;
-      }
-      M.submat(arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1),
-               arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1)) =
-          Adense * Einv_F_AdenseT;
+      // The diagonal of the Schur complement on the central path (XZ = mu I),
+      // where E^(-1) F = X sym Z^(-1), so that M_jj = <A_j, X A_j Z^(-1)>.
+      BlockLyapunovInverse(Zq, Zd, offsets, Zinv);
+      SchurDiagonal(sparseConstraints, sdp.DenseA(), sdp.LowRankA(), X, Zinv,
+          schurDiagonal);
     }
 
     const double sxdotsz = arma::dot(sx, sz);
 
-    // TODO(stephentu): computing these alphahats should take advantage of
-    // the cholesky decomposition of X and Z which we should have available
-    // when we use more efficient methods above.
-
     // This solves step (1) of Section 7, the "predictor" step.
-    Rc = -0.5*(X*Z + Z*X);
+    BlockProduct(X, Z, offsets, XZ);
+    BlockProduct(Z, X, offsets, ZX);
+    Rc = -0.5*(XZ + ZX);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, Zq, Zd, schurSolve, X, offsets, rp, rd, rc,
+        dsx, dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
 
     // Step (2), determine step size lengths (alpha, beta)
-    bool success = Alpha(X, dX, tau, alpha);
+    bool success = BlockAlpha(X, dX, offsets, tau, alpha);
     if (!success)
     {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
+      ENS_WARN << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
           << "failed!  Terminating optimization.";
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
       return primalObj;
     }
 
-    success = Alpha(Z, dZ, tau, beta);
+    success = BlockAlpha(Z, dZ, offsets, tau, beta);
     if (!success)
     {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
+      ENS_WARN << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
           << "failed!  Terminating optimization.";
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
       return primalObj;
     }
 
@@ -411,22 +1242,26 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     const double mu = sigma * sxdotsz / n;
 
     // Step (3), the "corrector" step.
-    Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(X*Z + Z*X + dX*dZ + dZ*dX);
+    BlockProduct(dX, dZ, offsets, dXdZ);
+    BlockProduct(dZ, dX, offsets, dZdX);
+    Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(XZ + ZX + dXdZ + dZdX);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, Zq, Zd, schurSolve, X, offsets, rp, rd, rc,
+        dsx, dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
-    if (!Alpha(X, dX, tau, alpha))
+    if (!BlockAlpha(X, dX, offsets, tau, alpha))
     {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
+      ENS_WARN << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
           << "failed!  Terminating optimization.";
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
       return primalObj;
     }
-    if (!Alpha(Z, dZ, tau, beta))
+    if (!BlockAlpha(Z, dZ, offsets, tau, beta))
     {
-      Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
+      ENS_WARN << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
           << "failed!  Terminating optimization.";
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
       return primalObj;
     }
 
@@ -448,11 +1283,12 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     // then we consider this a valid certificate of optimality and terminate.
     // Otherwise, we proceed onwards.
 
-    const double normXZ = arma::norm(X * Z, "fro");
+    BlockProduct(X, Z, offsets, XZ);
+    const double normXZ = arma::norm(XZ, "fro");
 
     const double sparsePrimalInfeas = arma::norm(sdp.SparseB() - Asparse * sx,
         2);
-    const double densePrimalInfeas = arma::norm(sdp.DenseB() - Adense * sx, 2);
+    const double densePrimalInfeas = arma::norm(denseB - Adense * sx, 2);
     const double primalInfeas = sqrt(sparsePrimalInfeas * sparsePrimalInfeas +
         densePrimalInfeas * densePrimalInfeas);
 
@@ -471,15 +1307,33 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
       DualCheck += ysparse(i) * sdp.SparseA()[i];
     for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
       DualCheck += ydense(i) * sdp.DenseA()[i];
+    for (size_t i = 0; i < sdp.NumLowRankConstraints(); i++)
+    {
+      const arma::mat& V = sdp.LowRankA()[i];
+      DualCheck += ydense(numDense + i) * (V * V.t());
+    }
     const double dualInfeas = arma::norm(DualCheck, "fro");
 
+    terminate |= Callback::StepTaken(*this, sdp, X, callbacks...);
+
     if (normXZ <= normXzTol && primalInfeas <= primalInfeasTol &&
         dualInfeas <= dualInfeasTol)
+    {
+      Callback::EndOptimization(*this, sdp, X, callbacks...);
       return primalObj;
+    }
+
+    terminate |= Callback::EndEpoch(*this, sdp, X, iteration, primalObj,
+        callbacks...);
+  }
+
+  if (!terminate)
+  {
+    ENS_WARN << "PrimalDualSolver::Optimizer(): Did not converge after "
+        << maxIterations << " iterations!" << std::endl;
   }
 
-  Warn << "PrimalDualSolver::Optimizer(): Did not converge after "
-      << maxIterations << " iterations!" << std::endl;
+  Callback::EndOptimization(*this, sdp, X, callbacks...);
   return primalObj;
 }
 
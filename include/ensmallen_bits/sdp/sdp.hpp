@@ -26,9 +26,26 @@ namespace ens {
  * that for each matrix you add to either SparseA() or DenseA(), you must add
  * the corresponding b value to the corresponding vector SparseB() or DenseB().
  *
+ * Constraints with a low-rank positive semidefinite Ai = Vi Vi^T (for
+ * instance the rank-one Ai = ai ai^T of phase retrieval) may instead be given
+ * by their n x k factor Vi, via LowRankA() and LowRankB().  Then Tr(Ai R R^T) =
+ * ||Vi^T R||_F^2 and Ai R = Vi (Vi^T R) take O(n r k) time instead of the O(n^2)
+ * entries of a dense Ai.  Solvers that return one vector of multipliers for
+ * the dense constraints (such as PrimalDualSolver) append the multipliers of
+ * the low-rank constraints to it.
+ *
  * The objective matrix (C) may be stored as either dense or sparse depending on
  * the ObjectiveMatrixType parameter.
  *
+ * The SDP may also be block-diagonal, i.e. X, C and every Ai are zero outside
+ * of the diagonal blocks given by BlockSizes() (such as the many small PSD
+ * blocks of MaxCut-style relaxations, or the slack variables of inequality
+ * constraints).  X is still n x n, but the solvers only factorize and multiply
+ * the diagonal blocks, so that an iteration costs the sum of the costs of the
+ * blocks instead of the cost of one n x n problem.  The entries of C and the
+ * Ai outside of the blocks must be zero; the sparse matrices only store the
+ * non-zero entries, so they take no memory there.
+ *
  * @tparam ObjectiveMatrixType Should be either arma::mat or arma::sp_mat.
  */
 template <typename ObjectiveMatrixType>
@@ -57,10 +74,27 @@ class SDP
    * @param n Number of rows (and columns) in the objective matrix C.
    * @param numSparseConstraints Number of sparse constraints.
    * @param numDenseConstraints Number of dense constraints.
+   * @param numLowRankConstraints Number of low-rank constraints.
    */
   SDP(const size_t n,
       const size_t numSparseConstraints,
-      const size_t numDenseConstraints);
+      const size_t numDenseConstraints,
+      const size_t numLowRankConstraints = 0);
+
+  /**
+   * Initialize this SDP to a block-diagonal one, whose blocks have the given
+   * sizes (n is the sum of the sizes).  Otherwise this is the same as the
+   * previous constructor.
+   *
+   * @param blockSizes Number of rows (and columns) of each diagonal block.
+   * @param numSparseConstraints Number of sparse constraints.
+   * @param numDenseConstraints Number of dense constraints.
+   * @param numLowRankConstraints Number of low-rank constraints.
+   */
+  SDP(const arma::uvec& blockSizes,
+      const size_t numSparseConstraints,
+      const size_t numDenseConstraints,
+      const size_t numLowRankConstraints = 0);
 
   //! Return number of rows and columns in the objective matrix C.
   size_t N() const { return c.n_rows; }
@@ -73,9 +107,13 @@ class SDP
   //! Return the number of dense constraints (constraints with dense Ai) in the
   //! SDP.
   size_t NumDenseConstraints() const { return denseB.n_elem; }
+  //! Return the number of low-rank constraints (constraints with Ai = Vi Vi^T)
+  //! in the SDP.
+  size_t NumLowRankConstraints() const { return lowRankB.n_elem; }
 
   //! Return the total number of constraints in the SDP.
-  size_t NumConstraints() const { return sparseB.n_elem + denseB.n_elem; }
+  size_t NumConstraints() const
+  { return sparseB.n_elem + denseB.n_elem + lowRankB.n_elem; }
 
   //! Modify the sparse objective function matrix (sparseC).
   ObjectiveMatrixType& C() { return c; }
@@ -98,6 +136,14 @@ class SDP
   //! constraints).
   std::vector<arma::mat>& DenseA() { return denseA; }
 
+  //! Return the vector of factors Vi of the low-rank constraints, where
+  //! Ai = Vi Vi^T.
+  const std::vector<arma::mat>& LowRankA() const { return lowRankA; }
+
+  //! Modify the vector of factors Vi of the low-rank constraints, where
+  //! Ai = Vi Vi^T.
+  std::vector<arma::mat>& LowRankA() { return lowRankA; }
+
   //! Return the vector of sparse B values.
   const arma::vec& SparseB() const { return sparseB; }
   //! Modify the vector of sparse B values.
@@ -108,6 +154,28 @@ class SDP
   //! Modify the vector of dense B values.
   arma::vec& DenseB() { return denseB; }
 
+  //! Return the vector of low-rank B values.
+  const arma::vec& LowRankB() const { return lowRankB; }
+  //! Modify the vector of low-rank B values.
+  arma::vec& LowRankB() { return lowRankB; }
+
+  //! Return the sizes of the diagonal blocks (empty means one block of size
+  //! N()).
+  const arma::uvec& BlockSizes() const { return blockSizes; }
+  //! Modify the sizes of the diagonal blocks (empty means one block of size
+  //! N()).
+  arma::uvec& BlockSizes() { return blockSizes; }
+
+  //! Return the number of diagonal blocks.
+  size_t NumBlocks() const
+  { return blockSizes.is_empty() ? 1 : blockSizes.n_elem; }
+
+  /**
+   * Return the offsets of the diagonal blocks: block b has the rows and
+   * columns offsets(b) to offsets(b + 1) - 1, and the last offset is N().
+   */
+  arma::uvec BlockOffsets() const;
+
   /**
    * Check whether or not the constraint matrices are linearly independent.
    *
@@ -128,6 +196,14 @@ class SDP
   std::vector<arma::mat> denseA;
   //! b_i for each dense constraint.
   arma::vec denseB;
+
+  //! V_i for each low-rank constraint.
+  std::vector<arma::mat> lowRankA;
+  //! b_i for each low-rank constraint.
+  arma::vec lowRankB;
+
+  //! The sizes of the diagonal blocks.
+  arma::uvec blockSizes;
 };
 
 } // namespace ens
@@ -22,23 +22,64 @@ SDP<ObjectiveMatrixType>::SDP() :
     sparseA(),
     sparseB(),
     denseA(),
-    denseB()
+    denseB(),
+    lowRankA(),
+    lowRankB(),
+    blockSizes()
 { /* Nothing to do. */ }
 
 template <typename ObjectiveMatrixType>
 SDP<ObjectiveMatrixType>::SDP(const size_t n,
                               const size_t numSparseConstraints,
-                              const size_t numDenseConstraints) :
+                              const size_t numDenseConstraints,
+                              const size_t numLowRankConstraints) :
     c(n, n),
     sparseA(numSparseConstraints),
     sparseB(numSparseConstraints),
     denseA(numDenseConstraints),
-    denseB(numDenseConstraints)
+    denseB(numDenseConstraints),
+    lowRankA(numLowRankConstraints),
+    lowRankB(numLowRankConstraints),
+    blockSizes()
 {
   for (size_t i = 0; i < numSparseConstraints; i++)
     sparseA[i].zeros(n, n);
   for (size_t i = 0; i < numDenseConstraints; i++)
     denseA[i].zeros(n, n);
+  for (size_t i = 0; i < numLowRankConstraints; i++)
+    lowRankA[i].zeros(n, 1);
+}
+
+template <typename ObjectiveMatrixType>
+SDP<ObjectiveMatrixType>::SDP(const arma::uvec& blockSizes,
+                              const size_t numSparseConstraints,
+                              const size_t numDenseConstraints,
+                              const size_t numLowRankConstraints) :
+    SDP(arma::accu(blockSizes), numSparseConstraints, numDenseConstraints,
+        numLowRankConstraints)
+{
+  this->blockSizes = blockSizes;
+}
+
+template <typename ObjectiveMatrixType>
+arma::uvec SDP<ObjectiveMatrixType>::BlockOffsets() const
+{
+  if (blockSizes.is_empty())
+    return arma::uvec({ 0, (arma::uword) N() });
+
+  if (arma::accu(blockSizes) != N())
+  {
+    std::ostringstream oss;
+    oss << "SDP::BlockOffsets(): the blocks have " << arma::accu(blockSizes)
+        << " rows in total, but C has " << N() << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::uvec offsets(blockSizes.n_elem + 1);
+  offsets(0) = 0;
+  for (size_t b = 0; b < blockSizes.n_elem; b++)
+    offsets(b + 1) = offsets(b) + blockSizes(b);
+  return offsets;
 }
 
 template <typename ObjectiveMatrixType>
@@ -63,6 +104,12 @@ bool SDP<ObjectiveMatrixType>::HasLinearlyIndependentConstraints() const
     math::Svec(DenseA()[i], sa);
     A.row(NumSparseConstraints() + i) = sa.t();
   }
+  for (size_t i = 0; i < NumLowRankConstraints(); i++)
+  {
+    arma::vec sa;
+    math::Svec(arma::mat(LowRankA()[i] * LowRankA()[i].t()), sa);
+    A.row(NumSparseConstraints() + NumDenseConstraints() + i) = sa.t();
+  }
 
   const arma::vec s = arma::svd(A);
   return s(s.n_elem - 1) > 1e-5;
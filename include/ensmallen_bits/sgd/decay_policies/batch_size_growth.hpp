@@ -0,0 +1,207 @@
+/**
+ * @file batch_size_growth.hpp
+ * @author Marcus Edel
+ *
+ * Decay policy that grows the batch size of SGD geometrically, and the
+ * detection of decay policies that change the batch size.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_BATCH_SIZE_GROWTH_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_BATCH_SIZE_GROWTH_HPP
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+#include "initialize_step_size.hpp"
+#include "no_decay.hpp"
+
+namespace ens {
+
+/**
+ * Detect whether a decay policy can change the batch size, that is, whether it
+ * has the method
+ *
+ *   void UpdateBatchSize(size_t& batchSize,
+ *                        const size_t epoch,
+ *                        const size_t numFunctions);
+ *
+ * which SGD calls at the start of every epoch but the first.
+ */
+template<typename PolicyType>
+struct HasBatchSizeMethod
+{
+  template<typename P>
+  static auto Check(int) -> decltype(
+      std::declval<P&>().UpdateBatchSize(std::declval<size_t&>(), size_t(0),
+          size_t(0)),
+      std::true_type());
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+//! Let a policy that has an UpdateBatchSize() method change the batch size.
+template<typename PolicyType>
+typename std::enable_if<HasBatchSizeMethod<PolicyType>::value>::type
+UpdatePolicyBatchSize(PolicyType& policy,
+                      size_t& batchSize,
+                      const size_t epoch,
+                      const size_t numFunctions)
+{
+  policy.UpdateBatchSize(batchSize, epoch, numFunctions);
+}
+
+//! A policy without an UpdateBatchSize() method keeps the batch size.
+template<typename PolicyType>
+typename std::enable_if<!HasBatchSizeMethod<PolicyType>::value>::type
+UpdatePolicyBatchSize(PolicyType& /* policy */,
+                      size_t& /* batchSize */,
+                      const size_t /* epoch */,
+                      const size_t /* numFunctions */)
+{ }
+
+/**
+ * BatchSizeGrowth multiplies the batch size of SGD by a factor every few
+ * epochs, up to a maximum, instead of (or as well as) decaying the step size:
+ * growing the batch reduces the noise of the steps as decaying the step size
+ * does, but with fewer, larger steps that are cheaper per sample and split
+ * better between threads (see the parallelBatch option of SGD).  The step size
+ * is changed by the wrapped decay policy.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Smith2018,
+ *   title     = {Don't Decay the Learning Rate, Increase the Batch Size},
+ *   author    = {Smith, Samuel L. and Kindermans, Pieter-Jan and Ying, Chris
+ *                and Le, Quoc V.},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2018}
+ * }
+ * @endcode
+ *
+ * As the step size, the batch size of the optimizer is modified in place, so
+ * that a later call to Optimize() continues with the grown batch; it is also
+ * part of the state stored by SGD::SaveState().
+ *
+ * @tparam DecayPolicyType Decay policy of the step size.
+ */
+template<typename DecayPolicyType = NoDecay>
+class BatchSizeGrowth
+{
+ public:
+  /**
+   * Create the policy with the given parameters.
+   *
+   * @param factor Factor the batch size is multiplied by.
+   * @param interval Number of epochs between two growths.
+   * @param maxBatchSize Largest batch size (0 means the number of functions).
+   * @param decayPolicy Decay policy of the step size.
+   */
+  BatchSizeGrowth(const double factor = 2.0,
+                  const size_t interval = 1,
+                  const size_t maxBatchSize = 0,
+                  const DecayPolicyType& decayPolicy = DecayPolicyType()) :
+      factor(factor),
+      interval(interval),
+      maxBatchSize(maxBatchSize),
+      decayPolicy(decayPolicy)
+  { /* Nothing to do. */ }
+
+  /**
+   * Let the wrapped decay policy set the step size of the first step.
+   *
+   * @param stepSize Step size of the optimizer.
+   */
+  void Initialize(double& stepSize)
+  {
+    InitializePolicyStepSize(decayPolicy, stepSize);
+  }
+
+  /**
+   * Update the step size with the wrapped decay policy; this is called in each
+   * iteration after the update policy.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param stepSize Step size to be used for the given iteration.
+   * @param gradient The gradient matrix.
+   */
+  template<typename MatType, typename GradType>
+  void Update(MatType& iterate, double& stepSize, const GradType& gradient)
+  {
+    decayPolicy.Update(iterate, stepSize, gradient);
+  }
+
+  /**
+   * Grow the batch size, if the given epoch starts a new interval.
+   *
+   * @param batchSize Batch size of the optimizer.
+   * @param epoch Index of the epoch that starts (1 for the first one).
+   * @param numFunctions Number of separable functions.
+   */
+  void UpdateBatchSize(size_t& batchSize,
+                       const size_t epoch,
+                       const size_t numFunctions)
+  {
+    if (interval == 0 || (epoch - 1) % interval != 0)
+      return;
+
+    const size_t limit = (maxBatchSize == 0) ? numFunctions :
+        std::min(maxBatchSize, numFunctions);
+    const double grown = std::ceil(batchSize * factor);
+    batchSize = (grown >= double(limit)) ? std::max(limit, batchSize) :
+        std::max((size_t) grown, batchSize);
+  }
+
+  //! Store the state of the wrapped decay policy.
+  void Save(OptimizerState& state) const
+  {
+    SavePolicyState(decayPolicy, state);
+  }
+
+  //! Restore the state of the wrapped decay policy.
+  void Load(const OptimizerState& state)
+  {
+    LoadPolicyState(decayPolicy, state);
+  }
+
+  //! Get the growth factor.
+  double Factor() const { return factor; }
+  //! Modify the growth factor.
+  double& Factor() { return factor; }
+
+  //! Get the number of epochs between two growths.
+  size_t Interval() const { return interval; }
+  //! Modify the number of epochs between two growths.
+  size_t& Interval() { return interval; }
+
+  //! Get the largest batch size (0 means the number of functions).
+  size_t MaxBatchSize() const { return maxBatchSize; }
+  //! Modify the largest batch size (0 means the number of functions).
+  size_t& MaxBatchSize() { return maxBatchSize; }
+
+  //! Get the decay policy of the step size.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the decay policy of the step size.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+ private:
+  //! The growth factor.
+  double factor;
+
+  //! The number of epochs between two growths.
+  size_t interval;
+
+  //! The largest batch size.
+  size_t maxBatchSize;
+
+  //! The decay policy of the step size.
+  DecayPolicyType decayPolicy;
+};
+
+} // namespace ens
+
+#endif
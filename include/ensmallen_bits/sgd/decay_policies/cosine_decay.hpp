@@ -0,0 +1,197 @@
+/**
+ * @file cosine_decay.hpp
+ * @author Marcus Edel
+ *
+ * Step size schedule that follows half a cosine from the base step size to a
+ * final step size.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_COSINE_DECAY_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_COSINE_DECAY_HPP
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+
+namespace ens {
+
+/**
+ * CosineDecay anneals the step size from the base step size to the final step
+ * size over totalSteps steps (one step is one batch), as SGDR does within a
+ * cycle but without restarts:
+ *
+ * \f[
+ * \alpha_t = \alpha_T + \frac{1}{2} (\alpha_0 - \alpha_T)
+ *     (1 + \cos(\pi \min(t, T) / T)).
+ * \f]
+ *
+ * The cosine is not computed at every step: cos((t + 1) theta) follows from
+ * the two previous values by the Chebyshev recurrence
+ * cos((t + 1) theta) = 2 cos(theta) cos(t theta) - cos((t - 1) theta), which
+ * costs one multiplication and one subtraction, and the recurrence is
+ * recomputed exactly every 4096 steps so that rounding errors do not build up.
+ *
+ * The base step size \f$ \alpha_0 \f$ is the step size of the optimizer at the
+ * start of the first call to Optimize(); the schedule continues over later
+ * calls (and is part of the state stored by SGD::SaveState()) until Reset() is
+ * called.
+ */
+class CosineDecay
+{
+ public:
+  /**
+   * Create the schedule.
+   *
+   * @param totalSteps Number of steps to reach the final step size.
+   * @param finalStepSize Step size after totalSteps steps.
+   */
+  CosineDecay(const size_t totalSteps = 10000,
+              const double finalStepSize = 0.0) :
+      totalSteps(totalSteps),
+      finalStepSize(finalStepSize),
+      baseStepSize(0.0),
+      steps(0),
+      initialized(false),
+      cosTheta(1.0),
+      cosCurrent(1.0),
+      cosPrevious(1.0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Take the base step size from the optimizer, the first time, and set the
+   * step size of the current step.
+   *
+   * @param stepSize Step size of the optimizer.
+   */
+  void Initialize(double& stepSize)
+  {
+    if (!initialized)
+    {
+      baseStepSize = stepSize;
+      initialized = true;
+    }
+
+    Synchronize();
+    stepSize = StepSize();
+  }
+
+  /**
+   * Count the step, and set the step size of the next one.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param stepSize Step size to be used for the next iteration.
+   * @param gradient The gradient matrix.
+   */
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
+              double& stepSize,
+              const GradType& /* gradient */)
+  {
+    ++steps;
+    if (steps < totalSteps)
+    {
+      if (steps % 4096 == 0)
+      {
+        Synchronize();
+      }
+      else
+      {
+        const double next = 2.0 * cosTheta * cosCurrent - cosPrevious;
+        cosPrevious = cosCurrent;
+        cosCurrent = next;
+      }
+    }
+
+    stepSize = StepSize();
+  }
+
+  //! Restart the schedule in the next call to Optimize().
+  void Reset() { steps = 0; initialized = false; }
+
+  //! Store the state of the schedule.
+  void Save(OptimizerState& state) const
+  {
+    state.Set("baseStepSize", baseStepSize);
+    state.Set("steps", double(steps));
+    state.Set("initialized", double(initialized));
+  }
+
+  //! Restore the state of the schedule.
+  void Load(const OptimizerState& state)
+  {
+    state.Get("baseStepSize", baseStepSize);
+    state.Get("steps", steps);
+    state.Get("initialized", initialized);
+    Synchronize();
+  }
+
+  //! Get the number of steps to reach the final step size.
+  size_t TotalSteps() const { return totalSteps; }
+  //! Modify the number of steps to reach the final step size.
+  size_t& TotalSteps() { return totalSteps; }
+
+  //! Get the final step size.
+  double FinalStepSize() const { return finalStepSize; }
+  //! Modify the final step size.
+  double& FinalStepSize() { return finalStepSize; }
+
+  //! Get the step size of the first step (set by the first Initialize()).
+  double BaseStepSize() const { return baseStepSize; }
+
+  //! Get the number of steps taken so far.
+  size_t Steps() const { return steps; }
+
+ private:
+  //! Compute the recurrence exactly for the current step.
+  void Synchronize()
+  {
+    if (totalSteps == 0)
+      return;
+
+    const double theta = arma::datum::pi / double(totalSteps);
+    const double t = double(std::min(steps, totalSteps));
+    cosTheta = std::cos(theta);
+    cosCurrent = std::cos(t * theta);
+    cosPrevious = std::cos((t - 1.0) * theta);
+  }
+
+  //! Compute the step size of the current step.
+  double StepSize() const
+  {
+    if (steps >= totalSteps)
+      return finalStepSize;
+
+    return finalStepSize + 0.5 * (baseStepSize - finalStepSize) *
+        (1.0 + cosCurrent);
+  }
+
+  //! The number of steps to reach the final step size.
+  size_t totalSteps;
+
+  //! The step size after totalSteps steps.
+  double finalStepSize;
+
+  //! The step size of the first step.
+  double baseStepSize;
+
+  //! The number of steps taken so far.
+  size_t steps;
+
+  //! Whether the base step size was taken from the optimizer.
+  bool initialized;
+
+  //! cos(theta), with theta = pi / totalSteps.
+  double cosTheta;
+
+  //! cos(steps theta).
+  double cosCurrent;
+
+  //! cos((steps - 1) theta).
+  double cosPrevious;
+};
+
+} // namespace ens
+
+#endif
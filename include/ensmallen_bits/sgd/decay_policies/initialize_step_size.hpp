@@ -0,0 +1,57 @@
+/**
+ * @file initialize_step_size.hpp
+ * @author Marcus Edel
+ *
+ * Detection of the decay policies that set the step size at the start of an
+ * optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_INITIALIZE_STEP_SIZE_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_INITIALIZE_STEP_SIZE_HPP
+
+namespace ens {
+
+/**
+ * Detect whether a decay policy sets the step size of the first iteration,
+ * that is, whether it has the method
+ *
+ *   void Initialize(double& stepSize);
+ *
+ * which SGD calls at the start of Optimize(), before the first step.  The
+ * schedules (e.g. StepDecay, CosineDecay) use it to take the step size of the
+ * optimizer as their base step size.
+ */
+template<typename PolicyType>
+struct HasInitializeStepSizeMethod
+{
+  template<typename P>
+  static auto Check(int) -> decltype(
+      std::declval<P&>().Initialize(std::declval<double&>()),
+      std::true_type());
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+//! Let a policy that has an Initialize() method set the first step size.
+template<typename PolicyType>
+typename std::enable_if<HasInitializeStepSizeMethod<PolicyType>::value>::type
+InitializePolicyStepSize(PolicyType& policy, double& stepSize)
+{
+  policy.Initialize(stepSize);
+}
+
+//! A policy without an Initialize() method keeps the step size.
+template<typename PolicyType>
+typename std::enable_if<!HasInitializeStepSizeMethod<PolicyType>::value>::type
+InitializePolicyStepSize(PolicyType& /* policy */, double& /* stepSize */)
+{ }
+
+} // namespace ens
+
+#endif
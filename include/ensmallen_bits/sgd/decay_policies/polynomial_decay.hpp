@@ -0,0 +1,191 @@
+/**
+ * @file polynomial_decay.hpp
+ * @author Marcus Edel
+ *
+ * Step size schedules that decay the step size polynomially (or linearly) to a
+ * final step size over a given number of steps.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_POLYNOMIAL_DECAY_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_POLYNOMIAL_DECAY_HPP
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+
+namespace ens {
+
+/**
+ * PolynomialDecay decays the step size from the base step size to the final
+ * step size over totalSteps steps (one step is one batch):
+ *
+ * \f[
+ * \alpha_t = (\alpha_0 - \alpha_T) (1 - \min(t, T) / T)^p + \alpha_T.
+ * \f]
+ *
+ * The base step size \f$ \alpha_0 \f$ is the step size of the optimizer at the
+ * start of the first call to Optimize(); the schedule continues over later
+ * calls (and is part of the state stored by SGD::SaveState()) until Reset() is
+ * called.  For an integer power the step costs p multiplications; only other
+ * powers call std::pow().
+ */
+class PolynomialDecay
+{
+ public:
+  /**
+   * Create the schedule.
+   *
+   * @param totalSteps Number of steps to reach the final step size.
+   * @param power Power p of the decay.
+   * @param finalStepSize Step size after totalSteps steps.
+   */
+  PolynomialDecay(const size_t totalSteps = 10000,
+                  const double power = 1.0,
+                  const double finalStepSize = 0.0) :
+      totalSteps(totalSteps),
+      power(power),
+      finalStepSize(finalStepSize),
+      baseStepSize(0.0),
+      steps(0),
+      initialized(false)
+  { /* Nothing to do. */ }
+
+  /**
+   * Take the base step size from the optimizer, the first time, and set the
+   * step size of the current step.
+   *
+   * @param stepSize Step size of the optimizer.
+   */
+  void Initialize(double& stepSize)
+  {
+    if (!initialized)
+    {
+      baseStepSize = stepSize;
+      initialized = true;
+    }
+
+    stepSize = StepSize();
+  }
+
+  /**
+   * Count the step, and set the step size of the next one.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param stepSize Step size to be used for the next iteration.
+   * @param gradient The gradient matrix.
+   */
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
+              double& stepSize,
+              const GradType& /* gradient */)
+  {
+    ++steps;
+    stepSize = StepSize();
+  }
+
+  //! Restart the schedule in the next call to Optimize().
+  void Reset() { steps = 0; initialized = false; }
+
+  //! Store the state of the schedule.
+  void Save(OptimizerState& state) const
+  {
+    state.Set("baseStepSize", baseStepSize);
+    state.Set("steps", double(steps));
+    state.Set("initialized", double(initialized));
+  }
+
+  //! Restore the state of the schedule.
+  void Load(const OptimizerState& state)
+  {
+    state.Get("baseStepSize", baseStepSize);
+    state.Get("steps", steps);
+    state.Get("initialized", initialized);
+  }
+
+  //! Get the number of steps to reach the final step size.
+  size_t TotalSteps() const { return totalSteps; }
+  //! Modify the number of steps to reach the final step size.
+  size_t& TotalSteps() { return totalSteps; }
+
+  //! Get the power of the decay.
+  double Power() const { return power; }
+  //! Modify the power of the decay.
+  double& Power() { return power; }
+
+  //! Get the final step size.
+  double FinalStepSize() const { return finalStepSize; }
+  //! Modify the final step size.
+  double& FinalStepSize() { return finalStepSize; }
+
+  //! Get the step size of the first step (set by the first Initialize()).
+  double BaseStepSize() const { return baseStepSize; }
+
+  //! Get the number of steps taken so far.
+  size_t Steps() const { return steps; }
+
+ private:
+  //! Compute the step size of the current step.
+  double StepSize() const
+  {
+    if (steps >= totalSteps)
+      return finalStepSize;
+
+    const double remaining = 1.0 - double(steps) / double(totalSteps);
+    // Small integer powers (including the linear decay) are multiplied out.
+    double factor = remaining;
+    if (power >= 1.0 && power <= 16.0 && power == std::floor(power))
+    {
+      for (size_t k = 1; k < size_t(power); ++k)
+        factor *= remaining;
+    }
+    else
+    {
+      factor = std::pow(remaining, power);
+    }
+
+    return (baseStepSize - finalStepSize) * factor + finalStepSize;
+  }
+
+  //! The number of steps to reach the final step size.
+  size_t totalSteps;
+
+  //! The power of the decay.
+  double power;
+
+  //! The step size after totalSteps steps.
+  double finalStepSize;
+
+  //! The step size of the first step.
+  double baseStepSize;
+
+  //! The number of steps taken so far.
+  size_t steps;
+
+  //! Whether the base step size was taken from the optimizer.
+  bool initialized;
+};
+
+/**
+ * LinearDecay decays the step size linearly from the base step size to the
+ * final step size over totalSteps steps; it is PolynomialDecay with power 1.
+ */
+class LinearDecay : public PolynomialDecay
+{
+ public:
+  /**
+   * Create the schedule.
+   *
+   * @param totalSteps Number of steps to reach the final step size.
+   * @param finalStepSize Step size after totalSteps steps.
+   */
+  LinearDecay(const size_t totalSteps = 10000,
+              const double finalStepSize = 0.0) :
+      PolynomialDecay(totalSteps, 1.0, finalStepSize)
+  { /* Nothing to do. */ }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * @file step_decay.hpp
+ * @author Marcus Edel
+ *
+ * Step size schedule that multiplies the step size by a factor every given
+ * number of steps.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_STEP_DECAY_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_STEP_DECAY_HPP
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+
+namespace ens {
+
+/**
+ * StepDecay multiplies the step size by gamma every stepInterval steps (one
+ * step is one batch):
+ *
+ * \f[
+ * \alpha_t = \alpha_0 \gamma^{\lfloor t / k \rfloor}.
+ * \f]
+ *
+ * The base step size \f$ \alpha_0 \f$ is the step size of the optimizer at the
+ * start of the first call to Optimize(); the schedule continues over later
+ * calls (and is part of the state stored by SGD::SaveState()) until Reset() is
+ * called.  Each step costs one comparison, and one multiplication at the end
+ * of an interval.
+ */
+class StepDecay
+{
+ public:
+  /**
+   * Create the schedule.
+   *
+   * @param gamma Factor the step size is multiplied by.
+   * @param stepInterval Number of steps between two decays.
+   */
+  StepDecay(const double gamma = 0.1, const size_t stepInterval = 1000) :
+      gamma(gamma),
+      stepInterval(stepInterval),
+      baseStepSize(0.0),
+      currentStepSize(0.0),
+      steps(0),
+      initialized(false)
+  { /* Nothing to do. */ }
+
+  /**
+   * Take the base step size from the optimizer, the first time, and set the
+   * step size of the current step.
+   *
+   * @param stepSize Step size of the optimizer.
+   */
+  void Initialize(double& stepSize)
+  {
+    if (!initialized)
+    {
+      baseStepSize = currentStepSize = stepSize;
+      initialized = true;
+    }
+
+    stepSize = currentStepSize;
+  }
+
+  /**
+   * Count the step, and decay the step size at the end of an interval.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param stepSize Step size to be used for the next iteration.
+   * @param gradient The gradient matrix.
+   */
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
+              double& stepSize,
+              const GradType& /* gradient */)
+  {
+    if (stepInterval > 0 && ++steps % stepInterval == 0)
+      currentStepSize *= gamma;
+    stepSize = currentStepSize;
+  }
+
+  //! Restart the schedule in the next call to Optimize().
+  void Reset() { steps = 0; initialized = false; }
+
+  //! Store the state of the schedule.
+  void Save(OptimizerState& state) const
+  {
+    state.Set("baseStepSize", baseStepSize);
+    state.Set("currentStepSize", currentStepSize);
+    state.Set("steps", double(steps));
+    state.Set("initialized", double(initialized));
+  }
+
+  //! Restore the state of the schedule.
+  void Load(const OptimizerState& state)
+  {
+    state.Get("baseStepSize", baseStepSize);
+    state.Get("currentStepSize", currentStepSize);
+    state.Get("steps", steps);
+    state.Get("initialized", initialized);
+  }
+
+  //! Get the decay factor.
+  double Gamma() const { return gamma; }
+  //! Modify the decay factor.
+  double& Gamma() { return gamma; }
+
+  //! Get the number of steps between two decays.
+  size_t StepInterval() const { return stepInterval; }
+  //! Modify the number of steps between two decays.
+  size_t& StepInterval() { return stepInterval; }
+
+  //! Get the step size of the first step (set by the first Initialize()).
+  double BaseStepSize() const { return baseStepSize; }
+
+  //! Get the number of steps taken so far.
+  size_t Steps() const { return steps; }
+
+ private:
+  //! The decay factor.
+  double gamma;
+
+  //! The number of steps between two decays.
+  size_t stepInterval;
+
+  //! The step size of the first step.
+  double baseStepSize;
+
+  //! The step size of the current step.
+  double currentStepSize;
+
+  //! The number of steps taken so far.
+  size_t steps;
+
+  //! Whether the base step size was taken from the optimizer.
+  bool initialized;
+};
+
+} // namespace ens
+
+#endif
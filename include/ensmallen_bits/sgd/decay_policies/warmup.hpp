@@ -0,0 +1,183 @@
+/**
+ * @file warmup.hpp
+ * @author Marcus Edel
+ *
+ * Linear warmup of the step size before another decay policy.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_DECAY_POLICIES_WARMUP_HPP
+#define ENSMALLEN_SGD_DECAY_POLICIES_WARMUP_HPP
+
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+#include "initialize_step_size.hpp"
+#include "cosine_decay.hpp"
+#include "no_decay.hpp"
+
+namespace ens {
+
+/**
+ * Warmup raises the step size linearly from base / warmupSteps to the base
+ * step size over the first warmupSteps steps (one step is one batch), and then
+ * hands the step size over to the wrapped decay policy, whose schedule starts
+ * at the end of the warmup with the base step size.  Starting with small steps
+ * keeps the first updates of a large step size (and of large batches) from
+ * diverging while the statistics of adaptive update policies build up.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Goyal2017,
+ *   title   = {Accurate, Large Minibatch {SGD}: Training {ImageNet} in 1
+ *              Hour},
+ *   author  = {Goyal, Priya and Doll{\'a}r, Piotr and Girshick, Ross and
+ *              Noordhuis, Pieter and Wesolowski, Lukasz and Kyrola, Aapo and
+ *              Tulloch, Andrew and Jia, Yangqing and He, Kaiming},
+ *   journal = {arXiv preprint arXiv:1706.02677},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * The base step size is the step size of the optimizer at the start of the
+ * first call to Optimize(); the schedule continues over later calls (and is
+ * part of the state stored by SGD::SaveState()) until Reset() is called.
+ *
+ * @tparam DecayPolicyType Decay policy after the warmup.
+ */
+template<typename DecayPolicyType = NoDecay>
+class Warmup
+{
+ public:
+  /**
+   * Create the schedule.
+   *
+   * @param warmupSteps Number of steps of the warmup.
+   * @param decayPolicy Decay policy after the warmup.
+   */
+  Warmup(const size_t warmupSteps = 1000,
+         const DecayPolicyType& decayPolicy = DecayPolicyType()) :
+      warmupSteps(warmupSteps),
+      decayPolicy(decayPolicy),
+      baseStepSize(0.0),
+      steps(0),
+      initialized(false)
+  { /* Nothing to do. */ }
+
+  /**
+   * Take the base step size from the optimizer, the first time, and set the
+   * step size of the current step.
+   *
+   * @param stepSize Step size of the optimizer.
+   */
+  void Initialize(double& stepSize)
+  {
+    if (!initialized)
+    {
+      baseStepSize = stepSize;
+      initialized = true;
+    }
+
+    if (steps < warmupSteps)
+      stepSize = baseStepSize * double(steps + 1) / double(warmupSteps);
+    else
+      InitializePolicyStepSize(decayPolicy, stepSize);
+  }
+
+  /**
+   * Count the step, and set the step size of the next one.
+   *
+   * @param iterate Parameters that minimize the function.
+   * @param stepSize Step size to be used for the next iteration.
+   * @param gradient The gradient matrix.
+   */
+  template<typename MatType, typename GradType>
+  void Update(MatType& iterate, double& stepSize, const GradType& gradient)
+  {
+    if (steps >= warmupSteps)
+    {
+      decayPolicy.Update(iterate, stepSize, gradient);
+      return;
+    }
+
+    if (++steps < warmupSteps)
+    {
+      stepSize = baseStepSize * double(steps + 1) / double(warmupSteps);
+    }
+    else
+    {
+      // The wrapped schedule starts here, from the base step size.
+      stepSize = baseStepSize;
+      InitializePolicyStepSize(decayPolicy, stepSize);
+    }
+  }
+
+  //! Restart the schedule in the next call to Optimize().
+  void Reset() { steps = 0; initialized = false; }
+
+  //! Store the state of the schedule and of the wrapped decay policy.
+  void Save(OptimizerState& state) const
+  {
+    state.Set("baseStepSize", baseStepSize);
+    state.Set("steps", double(steps));
+    state.Set("initialized", double(initialized));
+
+    OptimizerState policyState;
+    SavePolicyState(decayPolicy, policyState);
+    state.Set("decayPolicy.", policyState);
+  }
+
+  //! Restore the state of the schedule and of the wrapped decay policy.
+  void Load(const OptimizerState& state)
+  {
+    state.Get("baseStepSize", baseStepSize);
+    state.Get("steps", steps);
+    state.Get("initialized", initialized);
+
+    OptimizerState policyState;
+    state.Get("decayPolicy.", policyState);
+    LoadPolicyState(decayPolicy, policyState);
+  }
+
+  //! Get the number of steps of the warmup.
+  size_t WarmupSteps() const { return warmupSteps; }
+  //! Modify the number of steps of the warmup.
+  size_t& WarmupSteps() { return warmupSteps; }
+
+  //! Get the decay policy after the warmup.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the decay policy after the warmup.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the step size at the end of the warmup (set by the first
+  //! Initialize()).
+  double BaseStepSize() const { return baseStepSize; }
+
+  //! Get the number of warmup steps taken so far.
+  size_t Steps() const { return steps; }
+
+ private:
+  //! The number of steps of the warmup.
+  size_t warmupSteps;
+
+  //! The decay policy after the warmup.
+  DecayPolicyType decayPolicy;
+
+  //! The step size at the end of the warmup.
+  double baseStepSize;
+
+  //! The number of warmup steps taken so far.
+  size_t steps;
+
+  //! Whether the base step size was taken from the optimizer.
+  bool initialized;
+};
+
+//! Linear warmup followed by a cosine decay.
+using WarmupCosineDecay = Warmup<CosineDecay>;
+
+} // namespace ens
+
+#endif
@@ -15,13 +15,32 @@
 #ifndef ENSMALLEN_SGD_SGD_HPP
 #define ENSMALLEN_SGD_SGD_HPP
 
+#include <ensmallen_bits/utility/any.hpp>
+#include <ensmallen_bits/utility/optimizer_state.hpp>
+#include <ensmallen_bits/executors/executors.hpp>
+
 #include "update_policies/vanilla_update.hpp"
 #include "update_policies/momentum_update.hpp"
 #include "update_policies/nesterov_momentum_update.hpp"
+#include "update_policies/reset_update_policy.hpp"
+#include "update_policies/synchronize_update_policy.hpp"
 #include "decay_policies/no_decay.hpp"
+#include "decay_policies/batch_size_growth.hpp"
+#include "decay_policies/initialize_step_size.hpp"
+#include "decay_policies/step_decay.hpp"
+#include "decay_policies/polynomial_decay.hpp"
+#include "decay_policies/cosine_decay.hpp"
+#include "decay_policies/warmup.hpp"
 
 namespace ens {
 
+// Forward declaration; see sgd_stepper.hpp.
+template<typename SGDType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType>
+class SGDStepper;
+
 /**
  * Stochastic Gradient Descent is a technique for minimizing a function which
  * can be expressed as a sum of other functions.  That is, suppose we have
@@ -60,10 +79,17 @@ namespace ens {
  *     is used.
  * @tparam DecayPolicyType Decay policy used during the iterative update
  *     process to adjust the step size. By default the step size isn't going to
- *     be adjusted (i.e. NoDecay is used).
+ *     be adjusted (i.e. NoDecay is used).  A decay policy with an
+ *     Initialize(double&) method (see StepDecay, PolynomialDecay, CosineDecay
+ *     and Warmup) sets the step size of the first step, and one with an
+ *     UpdateBatchSize() method (see BatchSizeGrowth) also adjusts the batch
+ *     size at the start of every epoch.
+ * @tparam ExecutorType Executor that runs the sub-batches when parallelBatch
+ *     is set (see SerialExecutor, OpenMPExecutor, and ThreadPoolExecutor).
  */
 template<typename UpdatePolicyType = VanillaUpdate,
-         typename DecayPolicyType = NoDecay>
+         typename DecayPolicyType = NoDecay,
+         typename ExecutorType = OpenMPExecutor>
 class SGD
 {
  public:
@@ -87,6 +113,17 @@ class SGD
    * @param decayPolicy Instantiated decay policy used to adjust the step size.
    * @param resetPolicy Flag that determines whether update policy parameters
    *                    are reset before every Optimize call.
+   * @param parallelBatch If true, each batch is split into one sub-batch per
+   *                      thread of the executor (or a fixed number of
+   *                      sub-batches in the deterministic mode, see
+   *                      SetDeterministic()) and the sub-batch gradients
+   *                      are computed concurrently.  The function must then
+   *                      allow concurrent calls to EvaluateWithGradient().
+   * @param executor The executor that runs the sub-batches.
+   * @param microBatchSize If positive, the gradient of each batch is
+   *     accumulated from EvaluateWithGradient() calls on at most this many
+   *     functions, so that the memory used by the function does not grow with
+   *     the batch size; 0 means the whole batch (or sub-batch) in one call.
    */
   SGD(const double stepSize = 0.01,
       const size_t batchSize = 32,
@@ -95,21 +132,95 @@ class SGD
       const bool shuffle = true,
       const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
       const DecayPolicyType& decayPolicy = DecayPolicyType(),
-      const bool resetPolicy = true);
+      const bool resetPolicy = true,
+      const bool parallelBatch = false,
+      const ExecutorType& executor = ExecutorType(),
+      const size_t microBatchSize = 0);
 
   /**
    * Optimize the given function using stochastic gradient descent.  The given
    * starting point will be modified to store the finishing point of the
    * algorithm, and the final objective value is returned.
    *
+   * The update policy's internal state is held in the same matrix type as the
+   * given iterate, so optimizing an arma::fmat keeps all work in single
+   * precision.
+   *
+   * If GradType is a sparse matrix type (e.g. arma::sp_mat), the function's
+   * Gradient() is asked for a sparse gradient; VanillaUpdate, AdamUpdate and
+   * AdaGradUpdate then only touch the coordinates with a non-zero gradient in
+   * each step.  Since GradType cannot be deduced, call it as, e.g.,
+   * Optimize<FunctionType, arma::mat, arma::sp_mat>(function, iterate).
+   *
+   * If Pipelined() is set, the gradient of each batch after the first of an
+   * epoch is computed while the update of the batch before it is applied, at
+   * the iterate before that update; the gradients are then one step stale.
+   * The function must allow EvaluateWithGradient() to run concurrently with
+   * the update policy, and is evaluated at a copy of the iterate, which
+   * callbacks must not change in the middle of an epoch.  This pays off when
+   * the update is about as expensive as the gradient of a batch (e.g. with
+   * many parameters and small batches); SGDStepper ignores it.
+   *
+   * Any number of callbacks may be given after the iterate; SGD reports all
+   * events of the Callback class, where an epoch is one pass over the data
+   * and a step is one batch.  To run the optimization a few batches at a
+   * time, use an SGDStepper (see MakeStepper()).
+   *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function,
-                  arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  /**
+   * Store the state of the optimizer in the given state: the step size, the
+   * batch size, and the state of the update and decay policies after the last
+   * call to Optimize().  The state of the update policy is only stored if it
+   * was instantiated for the given matrix types, i.e., if the last call to
+   * Optimize() used them.
+   *
+   * @tparam MatType Type of matrix used in the last call to Optimize().
+   * @tparam GradType Type of gradient used in the last call to Optimize().
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const;
+
+  /**
+   * Resume from the given state (see SaveState()) in the next call to
+   * Optimize(): the step size, the batch size and the state of the update and
+   * decay policies are restored at its start, instead of starting from
+   * scratch, regardless of resetPolicy.  The coordinates are not part of the
+   * state, so the iterate given to Optimize() should be the one the state was
+   * saved with (the Checkpoint callback stores both).
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { resumeState = state; }
+
+  /**
+   * Get the update policy instantiated by the last call to Optimize(), for
+   * instance to read the averaged iterate of WeightAveraging or the slow
+   * weights of Lookahead.  A std::logic_error is thrown if the last call to
+   * Optimize() did not use the given matrix types.
+   *
+   * @tparam MatType Type of matrix used in the last call to Optimize().
+   * @tparam GradType Type of gradient used in the last call to Optimize().
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  const typename UpdatePolicyType::template Policy<MatType, GradType>&
+  InstUpdatePolicy() const;
 
   //! Get the step size.
   double StepSize() const { return stepSize; }
@@ -143,6 +254,37 @@ class SGD
   //! are reset before Optimize call.
   bool& ResetPolicy() { return resetPolicy; }
 
+  //! Get whether or not the gradient of each batch is computed in parallel.
+  bool ParallelBatch() const { return parallelBatch; }
+  //! Modify whether or not the gradient of each batch is computed in parallel.
+  bool& ParallelBatch() { return parallelBatch; }
+
+  //! Get the number of functions in each gradient evaluation (0 means the whole
+  //! batch).
+  size_t MicroBatchSize() const { return microBatchSize; }
+  //! Modify the number of functions in each gradient evaluation (0 means the
+  //! whole batch).
+  size_t& MicroBatchSize() { return microBatchSize; }
+
+  //! Get the number of consecutive functions shuffled as a block (0 means the
+  //! functions are shuffled individually).
+  size_t ShuffleBlockSize() const { return shuffleBlockSize; }
+  //! Modify the number of consecutive functions shuffled as a block (0 means
+  //! the functions are shuffled individually).
+  size_t& ShuffleBlockSize() { return shuffleBlockSize; }
+
+  //! Get whether the gradient of the next batch is computed while the update
+  //! of the current batch is applied.
+  bool Pipelined() const { return pipelined; }
+  //! Modify whether the gradient of the next batch is computed while the
+  //! update of the current batch is applied.
+  bool& Pipelined() { return pipelined; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
@@ -153,7 +295,15 @@ class SGD
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
+  //! SGDStepper runs the steps of Optimize() with the buffers and the batch
+  //! evaluation of its copy of the optimizer.
+  template<typename, typename, typename, typename>
+  friend class SGDStepper;
+
   //! The step size for each example.
   double stepSize;
 
@@ -179,6 +329,121 @@ class SGD
   //! Flag indicating whether update policy
   //! should be reset before running optimization.
   bool resetPolicy;
+
+  //! Flag indicating whether the gradient of each batch is computed by
+  //! several threads.
+  bool parallelBatch;
+
+  //! The executor that runs the sub-batches.
+  ExecutorType executor;
+
+  //! The largest number of functions in one gradient evaluation (0 means no
+  //! limit).
+  size_t microBatchSize;
+
+  //! The number of consecutive functions shuffled as a block.
+  size_t shuffleBlockSize;
+
+  //! Flag indicating whether the gradient of the next batch is computed
+  //! during the update of the current batch.
+  bool pipelined;
+
+  //! The initialized update policy; its type depends on the matrix type used
+  //! in the last call to Optimize().
+  Any instUpdatePolicy;
+
+  //! The state to resume from in the next call to Optimize(), if any.
+  OptimizerState resumeState;
+
+  /**
+   * The buffers of an optimization, which are kept between calls to
+   * Optimize() so that repeated optimizations of iterates of the same size do
+   * not allocate memory.
+   *
+   * @tparam MatType Type of the coordinates.
+   * @tparam GradType Type of the gradient.
+   */
+  template<typename MatType, typename GradType>
+  struct Workspace
+  {
+    //! The gradient of the current batch.
+    GradType gradient;
+    //! The gradients of the sub-batches, if parallelBatch is set.
+    std::vector<GradType> gradients;
+    //! The objectives of the sub-batches, if parallelBatch is set.
+    std::vector<typename MatType::elem_type> objectives;
+    //! The gradients of the micro-batches, before they are added to those of
+    //! the batch or sub-batches; one per sub-batch.
+    std::vector<GradType> microGradients;
+    //! The gradient of the next batch, if pipelined is set.
+    GradType nextGradient;
+    //! The iterate that the gradient of the next batch is computed at, if
+    //! pipelined is set.
+    MatType snapshot;
+    //! The iterate after the update, for the gradient of the batch after.
+    MatType nextSnapshot;
+  };
+
+  //! The buffers of the last call to Optimize(); their type depends on the
+  //! matrix types used in that call.
+  Any workspace;
+
+  /**
+   * Compute the objective and gradient of the given batch by splitting it into
+   * one sub-batch per thread and summing the results.  The sum is always taken
+   * in the same order, so the result does not depend on thread scheduling.
+   * With a single thread this just calls EvaluateWithGradient().  The
+   * sub-batch gradients are held in the workspace.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  typename MatType::elem_type ParallelEvaluateWithGradient(
+      FunctionType& function,
+      const MatType& iterate,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize);
+
+  /**
+   * Compute the objective and gradient of the given functions with
+   * EvaluateWithGradient() calls on at most microBatchSize functions, summing
+   * the gradients of the micro-batches into the given gradient.  The gradient
+   * of each micro-batch is held in the given buffer, so the memory used does
+   * not depend on the number of functions.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  typename MatType::elem_type AccumulateEvaluateWithGradient(
+      FunctionType& function,
+      const MatType& iterate,
+      const size_t begin,
+      GradType& gradient,
+      GradType& microGradient,
+      const size_t batchSize) const;
+
+  /**
+   * Apply the update of the current batch with the given gradient, and at the
+   * same time compute the objective and gradient of the given next batch at
+   * the iterate before the update, as separate tasks of the executor.  The
+   * gradient is computed at a snapshot of the iterate, which the update task
+   * refreshes after the update for the next call (so that only the first call
+   * of an epoch, where snapshotReady is false, copies the iterate before the
+   * tasks start).  The gradient of the next batch is left in the workspace.
+   * With parallelBatch, the next batch is split between the other threads of
+   * the executor.
+   */
+  template<typename FunctionType,
+           typename PolicyType,
+           typename MatType,
+           typename GradType>
+  typename MatType::elem_type PipelinedUpdate(FunctionType& function,
+                                              PolicyType& policy,
+                                              MatType& iterate,
+                                              const GradType& gradient,
+                                              const size_t nextBegin,
+                                              const size_t nextBatchSize,
+                                              const bool snapshotReady);
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 using StandardSGD = SGD<VanillaUpdate>;
@@ -191,5 +456,6 @@ using NesterovMomentumSGD = SGD<NesterovMomentumUpdate>;
 
 // Include implementation.
 #include "sgd_impl.hpp"
+#include "sgd_stepper.hpp"
 
 #endif
@@ -18,11 +18,14 @@
 #include "sgd.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
 
 namespace ens {
 
-template<typename UpdatePolicyType, typename DecayPolicyType>
-SGD<UpdatePolicyType, DecayPolicyType>::SGD(
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>::SGD(
     const double stepSize,
     const size_t batchSize,
     const size_t maxIterations,
@@ -30,7 +33,10 @@ SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     const bool shuffle,
     const UpdatePolicyType& updatePolicy,
     const DecayPolicyType& decayPolicy,
-    const bool resetPolicy) :
+    const bool resetPolicy,
+    const bool parallelBatch,
+    const ExecutorType& executor,
+    const size_t microBatchSize) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
@@ -38,68 +44,169 @@ SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     shuffle(shuffle),
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
-    resetPolicy(resetPolicy)
+    resetPolicy(resetPolicy),
+    parallelBatch(parallelBatch),
+    executor(executor),
+    microBatchSize(microBatchSize),
+    shuffleBlockSize(0),
+    pipelined(false)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
-template<typename UpdatePolicyType, typename DecayPolicyType>
-template<typename DecomposableFunctionType>
-double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
 {
-  typedef Function<DecomposableFunctionType> FullFunctionType;
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  typedef Function<DecomposableFunctionType, MatType, GradType>
+      FullFunctionType;
   FullFunctionType& f(static_cast<FullFunctionType&>(function));
 
+  // The update policy, instantiated for the matrix types we were given.
+  typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+      InstUpdatePolicyType;
+
   // Make sure we have all the methods that we need.
-  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType>();
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, MatType,
+      GradType>();
+
+  // If the function can be evaluated on any set of indices, we hold the order
+  // of visitation ourselves and the function never has to be shuffled.
+  typedef VisitationOrder<DecomposableFunctionType, MatType, GradType>
+      VisitationOrderType;
+  typedef Function<typename VisitationOrderType::VisitedType, MatType,
+      GradType> VisitedFunctionType;
+  VisitationOrderType order(function, shuffleBlockSize);
+  VisitedFunctionType& visited(
+      static_cast<VisitedFunctionType&>(order.Get()));
 
   // Find the number of functions to use.
-  const size_t numFunctions = f.NumFunctions();
+  const size_t numFunctions = visited.NumFunctions();
 
   // To keep track of where we are and how things are going.
   size_t currentFunction = 0;
-  double overallObjective = 0;
-  double lastObjective = DBL_MAX;
+  typename MatType::elem_type overallObjective = 0;
+  typename MatType::elem_type lastObjective =
+      std::numeric_limits<typename MatType::elem_type>::max();
+
+  // Initialize the update policy.  If it was built for a different matrix
+  // type, it has to be rebuilt regardless of resetPolicy; otherwise a policy
+  // that can be reset in place keeps its memory.
+  if (!instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    instUpdatePolicy.Clean();
+    instUpdatePolicy.Set<InstUpdatePolicyType>(new InstUpdatePolicyType(
+        updatePolicy, iterate.n_rows, iterate.n_cols));
+  }
+  else if (resetPolicy && !ResetUpdatePolicy(
+      instUpdatePolicy.As<InstUpdatePolicyType>(), iterate.n_rows,
+      iterate.n_cols))
+  {
+    instUpdatePolicy.Clean();
+    instUpdatePolicy.Set<InstUpdatePolicyType>(new InstUpdatePolicyType(
+        updatePolicy, iterate.n_rows, iterate.n_cols));
+  }
+
+  // Resume from a stored state, if we were given one.
+  if (!resumeState.Empty())
+  {
+    OptimizerState policyState;
+    resumeState.Get("stepSize", stepSize);
+    if (resumeState.Has("batchSize"))
+      resumeState.Get("batchSize", batchSize);
+    resumeState.Get("updatePolicy.", policyState);
+    LoadPolicyState(instUpdatePolicy.As<InstUpdatePolicyType>(), policyState);
+    resumeState.Get("decayPolicy.", policyState);
+    LoadPolicyState(decayPolicy, policyState);
+    resumeState.Clear();
+  }
+
+  // A step size schedule sets the step size of the first step.
+  InitializePolicyStepSize(decayPolicy, stepSize);
 
-  // Initialize the update policy.
-  if (resetPolicy)
-    updatePolicy.Initialize(iterate.n_rows, iterate.n_cols);
+  // The buffers are kept from the last call if it used the same matrix types;
+  // setting the size of a matrix that already has it does not allocate.
+  typedef Workspace<MatType, GradType> WorkspaceType;
+  if (!workspace.Has<WorkspaceType>())
+    workspace.Set(new WorkspaceType());
+  GradType& gradient = workspace.As<WorkspaceType>().gradient;
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+
+  // With pipelining, the objective of the next batch, if its gradient was
+  // computed during the last update.
+  typename MatType::elem_type nextObjective = 0;
+  bool prefetched = false;
 
   // Now iterate!
-  arma::mat gradient(iterate.n_rows, iterate.n_cols);
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
-  for (size_t i = 0; i < actualMaxIterations; /* incrementing done manually */)
+  size_t epoch = 1;
+  bool terminate = Callback::BeginOptimization(*this, f, iterate,
+      callbacks...);
+  terminate |= Callback::BeginEpoch(*this, f, iterate, epoch, lastObjective,
+      callbacks...);
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
   {
     // Is this iteration the start of a sequence?
     if ((currentFunction % numFunctions) == 0 && i > 0)
     {
+      // Apply the updates that the policy deferred, so that the iterate seen at
+      // the end of the epoch is up to date.
+      SynchronizeUpdatePolicy(instUpdatePolicy.As<InstUpdatePolicyType>(),
+          iterate);
+
       // Output current objective function.
-      Info << "SGD: iteration " << i << ", objective " << overallObjective
+      ENS_INFO << "SGD: iteration " << i << ", objective " << overallObjective
          << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
-        Warn << "SGD: converged to " << overallObjective << "; terminating"
+        ENS_WARN << "SGD: converged to " << overallObjective << "; terminating"
             << " with failure.  Try a smaller step size?" << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
         return overallObjective;
       }
 
       if (std::abs(lastObjective - overallObjective) < tolerance)
       {
-        Info << "SGD: minimized within tolerance " << tolerance << "; "
+        ENS_INFO << "SGD: minimized within tolerance " << tolerance << "; "
             << "terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
         return overallObjective;
       }
 
+      terminate |= Callback::EndEpoch(*this, f, iterate, epoch,
+          overallObjective, callbacks...);
+      if (terminate)
+        break;
+
       // Reset the counter variables.
       lastObjective = overallObjective;
       overallObjective = 0;
       currentFunction = 0;
 
       if (shuffle) // Determine order of visitation.
-        f.Shuffle();
+        visited.Shuffle();
+
+      // The decay policy may change the batch size for the new epoch.
+      ++epoch;
+      UpdatePolicyBatchSize(decayPolicy, batchSize, epoch, numFunctions);
+
+      terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+          lastObjective, callbacks...);
+      if (terminate)
+        break;
     }
 
     // Find the effective batch size; we have to take the minimum of three
@@ -114,11 +221,69 @@ double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
 
     // Technically we are computing the objective before we take the step, but
     // for many FunctionTypes it may be much quicker to do it like this.
-    overallObjective += f.EvaluateWithGradient(iterate, currentFunction,
-        gradient, effectiveBatchSize);
+    typename MatType::elem_type objective;
+    const bool snapshotReady = prefetched;
+    if (prefetched)
+    {
+      // The gradient of this batch was computed during the last update.
+      objective = nextObjective;
+      std::swap(gradient, workspace.As<WorkspaceType>().nextGradient);
+      prefetched = false;
+    }
+    else if (parallelBatch)
+    {
+      objective = ParallelEvaluateWithGradient(visited, iterate,
+          currentFunction, gradient, effectiveBatchSize);
+    }
+    else if (microBatchSize > 0 && microBatchSize < effectiveBatchSize)
+    {
+      typedef Workspace<MatType, GradType> WorkspaceType;
+      std::vector<GradType>& microGradients =
+          workspace.As<WorkspaceType>().microGradients;
+      if (microGradients.empty())
+        microGradients.resize(1);
+
+      objective = AccumulateEvaluateWithGradient(visited, iterate,
+          currentFunction, gradient, microGradients[0], effectiveBatchSize);
+    }
+    else
+    {
+      objective = visited.EvaluateWithGradient(iterate, currentFunction,
+          gradient, effectiveBatchSize);
+    }
+    overallObjective += objective;
+
+    terminate |= Callback::Evaluate(*this, f, iterate, objective,
+        callbacks...);
+    terminate |= Callback::Gradient(*this, f, iterate, gradient,
+        callbacks...);
+
+    // With pipelining, the gradient of the next batch of this epoch is
+    // computed while the step is taken.
+    const size_t nextBegin = currentFunction + effectiveBatchSize;
+    const size_t nextBatchSize = (!pipelined || terminate ||
+        nextBegin >= numFunctions ||
+        i + effectiveBatchSize >= actualMaxIterations) ? 0 :
+        std::min(std::min(batchSize,
+        actualMaxIterations - i - effectiveBatchSize),
+        numFunctions - nextBegin);
 
     // Use the update policy to take a step.
-    updatePolicy.Update(iterate, stepSize, gradient);
+    if (nextBatchSize > 0)
+    {
+      nextObjective = PipelinedUpdate(visited,
+          instUpdatePolicy.As<InstUpdatePolicyType>(), iterate, gradient,
+          nextBegin, nextBatchSize, snapshotReady);
+      prefetched = true;
+    }
+    else
+    {
+      ENS_TRACE_ZONE("Update");
+      instUpdatePolicy.As<InstUpdatePolicyType>().Update(iterate, stepSize,
+          gradient);
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
 
     // Now update the learning rate if requested by the user.
     decayPolicy.Update(iterate, stepSize, gradient);
@@ -127,19 +292,251 @@ double SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
     currentFunction += effectiveBatchSize;
   }
 
-  Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    ENS_INFO << "SGD: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  SynchronizeUpdatePolicy(instUpdatePolicy.As<InstUpdatePolicyType>(),
+      iterate);
 
   // Calculate final objective.
   overallObjective = 0;
   for (size_t i = 0; i < numFunctions; i += batchSize)
   {
     const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    overallObjective += visited.Evaluate(iterate, i, effectiveBatchSize);
   }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
   return overallObjective;
 }
 
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename MatType, typename GradType>
+void SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>::SaveState(
+    OptimizerState& state) const
+{
+  typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+      InstUpdatePolicyType;
+
+  state.Set("stepSize", stepSize);
+  state.Set("batchSize", double(batchSize));
+
+  OptimizerState policyState;
+  if (instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    SavePolicyState(instUpdatePolicy.As<InstUpdatePolicyType>(), policyState);
+    state.Set("updatePolicy.", policyState);
+  }
+
+  policyState.Clear();
+  SavePolicyState(decayPolicy, policyState);
+  state.Set("decayPolicy.", policyState);
+}
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename MatType, typename GradType>
+const typename UpdatePolicyType::template Policy<MatType, GradType>&
+SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>::InstUpdatePolicy() const
+{
+  typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+      InstUpdatePolicyType;
+
+  if (!instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    throw std::logic_error("SGD::InstUpdatePolicy(): the update policy was "
+        "not instantiated for the given matrix types by the last call to "
+        "Optimize()");
+  }
+
+  return instUpdatePolicy.As<InstUpdatePolicyType>();
+}
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename FunctionType, typename MatType, typename GradType>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType,
+    ExecutorType>::ParallelEvaluateWithGradient(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t numChunks = ParallelChunks(executor.Threads(), batchSize);
+
+  typedef Workspace<MatType, GradType> WorkspaceType;
+  std::vector<GradType>& microGradients =
+      workspace.As<WorkspaceType>().microGradients;
+  if (microGradients.size() < std::max(numChunks, (size_t) 1))
+    microGradients.resize(std::max(numChunks, (size_t) 1));
+
+  if (numChunks <= 1)
+  {
+    return AccumulateEvaluateWithGradient(function, iterate, begin, gradient,
+        microGradients[0], batchSize);
+  }
+
+  // Every chunk gets its own gradient buffer, which is kept for the next
+  // batch.
+  std::vector<GradType>& gradients =
+      workspace.As<WorkspaceType>().gradients;
+  std::vector<ElemType>& objectives =
+      workspace.As<WorkspaceType>().objectives;
+  if (gradients.size() < numChunks)
+  {
+    gradients.resize(numChunks);
+    objectives.resize(numChunks);
+  }
+
+  // Each chunk is one task of the executor; with micro-batches, the chunks
+  // accumulate their micro-batches concurrently.
+  const uint64_t seed = ChunkRandomSeed();
+  executor.Run(numChunks, [&](const size_t c)
+  {
+    ChunkRandomScope chunkScope(seed, c);
+    const size_t chunkBegin = c * batchSize / numChunks;
+    const size_t chunkEnd = (c + 1) * batchSize / numChunks;
+    gradients[c].zeros(iterate.n_rows, iterate.n_cols);
+    objectives[c] = AccumulateEvaluateWithGradient(function, iterate,
+        begin + chunkBegin, gradients[c], microGradients[c],
+        chunkEnd - chunkBegin);
+  });
+
+  // Add the per-chunk results pairwise, so that the result only depends on
+  // the number of chunks.
+  PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+  {
+    objectives[target] += objectives[source];
+    gradients[target] += gradients[source];
+  });
+  gradient = gradients[0];
+
+  return objectives[0];
+}
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename FunctionType, typename MatType, typename GradType>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType,
+    ExecutorType>::AccumulateEvaluateWithGradient(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    GradType& microGradient,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (microBatchSize == 0 || microBatchSize >= batchSize)
+    return function.EvaluateWithGradient(iterate, begin, gradient, batchSize);
+
+  // The first micro-batch writes the gradient directly; the others are added
+  // to it, so that the gradient is that of the whole batch.
+  ElemType objective = function.EvaluateWithGradient(iterate, begin, gradient,
+      microBatchSize);
+  for (size_t offset = microBatchSize; offset < batchSize;
+      offset += microBatchSize)
+  {
+    const size_t size = std::min(microBatchSize, batchSize - offset);
+    microGradient.zeros(iterate.n_rows, iterate.n_cols);
+    objective += function.EvaluateWithGradient(iterate, begin + offset,
+        microGradient, size);
+    gradient += microGradient;
+  }
+
+  return objective;
+}
+
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType>
+template<typename FunctionType,
+         typename PolicyType,
+         typename MatType,
+         typename GradType>
+typename MatType::elem_type
+SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>::PipelinedUpdate(
+    FunctionType& function,
+    PolicyType& policy,
+    MatType& iterate,
+    const GradType& gradient,
+    const size_t nextBegin,
+    const size_t nextBatchSize,
+    const bool snapshotReady)
+{
+  // One task takes the update, and the other threads share the next batch.
+  const size_t threads = executor.Threads();
+  const size_t numChunks = parallelBatch ? std::max(ParallelChunks(
+      (threads > 1) ? threads - 1 : 1, nextBatchSize), (size_t) 1) : 1;
+
+  typedef Workspace<MatType, GradType> WorkspaceType;
+  WorkspaceType& w = workspace.As<WorkspaceType>();
+  if (w.microGradients.size() < numChunks)
+    w.microGradients.resize(numChunks);
+  if (w.gradients.size() < numChunks)
+  {
+    w.gradients.resize(numChunks);
+    w.objectives.resize(numChunks);
+  }
+
+  // The last call left the iterate before this update in the snapshot, unless
+  // this is the first call of the epoch.
+  if (!snapshotReady)
+    w.snapshot = iterate;
+
+  // The update gets its own random stream too, since it may not run on the
+  // calling thread.
+  const uint64_t seed = ChunkRandomSeed();
+  executor.Run(numChunks + 1, [&](const size_t t)
+  {
+    ChunkRandomScope chunkScope(seed, t);
+    if (t == 0)
+    {
+      ENS_TRACE_ZONE("Update");
+      policy.Update(iterate, stepSize, gradient);
+      w.nextSnapshot = iterate;
+      return;
+    }
+
+    const size_t c = t - 1;
+    const size_t chunkBegin = c * nextBatchSize / numChunks;
+    const size_t chunkEnd = (c + 1) * nextBatchSize / numChunks;
+    GradType& chunkGradient = (numChunks == 1) ? w.nextGradient :
+        w.gradients[c];
+    chunkGradient.zeros(iterate.n_rows, iterate.n_cols);
+    w.objectives[c] = AccumulateEvaluateWithGradient(function, w.snapshot,
+        nextBegin + chunkBegin, chunkGradient, w.microGradients[c],
+        chunkEnd - chunkBegin);
+  });
+
+  if (numChunks > 1)
+  {
+    PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+    {
+      w.objectives[target] += w.objectives[source];
+      w.gradients[target] += w.gradients[source];
+    });
+    w.nextGradient = w.gradients[0];
+  }
+
+  std::swap(w.snapshot, w.nextSnapshot);
+  return w.objectives[0];
+}
+
 } // namespace ens
 
 #endif
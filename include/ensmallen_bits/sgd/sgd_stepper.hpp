@@ -0,0 +1,207 @@
+/**
+ * @file sgd_stepper.hpp
+ * @author Marcus Edel
+ *
+ * A stochastic gradient descent optimization that is run a few batches at a
+ * time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_SGD_STEPPER_HPP
+#define ENSMALLEN_SGD_SGD_STEPPER_HPP
+
+#include <memory>
+#include <type_traits>
+
+#include "sgd.hpp"
+
+namespace ens {
+
+/**
+ * An SGD optimization of the given separable function from the given iterate,
+ * which is advanced by calls to Step() instead of running to completion, so
+ * that a scheduler can interleave many optimizations on a few threads, and
+ * give more batches to the promising ones.  Each call to Step(n) takes at most
+ * n steps (batches), and the optimization goes through the same epochs,
+ * shuffles, policy updates and termination conditions as SGD::Optimize(); once
+ * the maximum number of iterations is reached, the objective on all the
+ * functions is computed, as Optimize() does.  Callbacks are not supported.
+ *
+ * The stepper works on its own copy of the optimizer (and holds its own
+ * instantiated update policy), so one configured optimizer can start many
+ * steppers; a state given to SGD::LoadState() is resumed from.  The stepper
+ * refers to the function and the iterate, which must outlive it; the iterate
+ * holds the current point between the calls to Step().  A stepper can be
+ * moved (e.g. into a std::vector), but not copied.
+ *
+ * @code
+ * StandardSGD optimizer(0.01, 32, 0, 1e-8);
+ * std::vector<SGDStepper<StandardSGD, LogisticRegressionFunction<>>> steppers;
+ * for (size_t i = 0; i < models; ++i)
+ *   steppers.push_back(MakeStepper(optimizer, functions[i], coordinates[i]));
+ *
+ * // Round-robin over the unfinished optimizations, 100 batches at a time.
+ * bool running = true;
+ * while (running)
+ * {
+ *   running = false;
+ *   for (size_t i = 0; i < models; ++i)
+ *     running |= steppers[i].Step(100);
+ * }
+ * @endcode
+ *
+ * @tparam SGDType Type of the optimizer (an SGD<>).
+ * @tparam FunctionType Type of the function to optimize.
+ * @tparam MatType Type of the iterate.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename SGDType,
+         typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class SGDStepper
+{
+ public:
+  //! The type of the elements of the iterate.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Start the optimization of the given function from the given iterate; no
+   * evaluation is done until the first call to Step().
+   *
+   * @param optimizer Optimizer with the parameters of the optimization.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified by Step()).
+   */
+  SGDStepper(const SGDType& optimizer,
+             FunctionType& function,
+             MatType& iterate);
+
+  /**
+   * Take at most the given number of steps (batches), and return whether the
+   * optimization can go on (i.e. !Done()).
+   *
+   * @param steps Maximum number of steps to take.
+   */
+  bool Step(const size_t steps = 1);
+
+  //! Get whether the optimization has terminated.
+  bool Done() const { return done; }
+
+  //! Get the number of steps (batches) taken so far.
+  size_t Steps() const { return stepsTaken; }
+
+  //! Get the number of iterations (functions visited) so far.
+  size_t Iterations() const { return iteration; }
+
+  //! Get the current epoch (from 1).
+  size_t Epoch() const { return epoch; }
+
+  //! Get the objective of the last batch.
+  ElemType Objective() const { return objective; }
+
+  //! Get the objective of the last full epoch (the largest value before the
+  //! end of the first epoch).
+  ElemType EpochObjective() const { return lastObjective; }
+
+  //! Get the objective returned by Optimize(); before Done(), it is the
+  //! objective of the last full epoch.
+  ElemType Result() const { return done ? result : lastObjective; }
+
+  //! Get the current point.
+  const MatType& Iterate() const { return iterate; }
+
+  //! Get the optimizer, whose step size and batch size are those of the
+  //! current step.
+  const SGDType& Optimizer() const { return optimizer; }
+
+ private:
+  //! The function wrapper with all the methods.
+  typedef Function<FunctionType, MatType, GradType> FullFunctionType;
+  //! The order of visitation of the functions.
+  typedef VisitationOrder<FunctionType, MatType, GradType>
+      VisitationOrderType;
+  //! The function wrapper of the visited functions.
+  typedef Function<typename VisitationOrderType::VisitedType, MatType,
+      GradType> VisitedFunctionType;
+  //! The update policy of the optimizer.
+  typedef typename std::decay<decltype(
+      std::declval<const SGDType&>().UpdatePolicy())>::type UpdatePolicyType;
+  //! The update policy, instantiated for the matrix types.
+  typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+      InstUpdatePolicyType;
+
+  //! Get the visited functions.
+  VisitedFunctionType& Visited()
+  {
+    return static_cast<VisitedFunctionType&>(order.Get());
+  }
+
+  //! Take one step, or terminate.
+  void TakeStep();
+
+  //! The optimizer with the parameters of the optimization.
+  SGDType optimizer;
+  //! The order of visitation of the functions.
+  VisitationOrderType order;
+  //! The current point.
+  MatType& iterate;
+  //! The instantiated update policy.
+  std::unique_ptr<InstUpdatePolicyType> updatePolicy;
+  //! The gradient of the current batch.
+  GradType gradient;
+
+  //! The number of functions.
+  size_t numFunctions;
+  //! The maximum number of iterations (functions visited).
+  size_t maxIterations;
+  //! The number of steps taken.
+  size_t stepsTaken;
+  //! The number of iterations (functions visited).
+  size_t iteration;
+  //! The first function of the next batch in the epoch.
+  size_t currentFunction;
+  //! The current epoch.
+  size_t epoch;
+  //! Whether the optimization has terminated.
+  bool done;
+
+  //! The objective of the last batch.
+  ElemType objective;
+  //! The sum of the objectives of the batches of the current epoch.
+  ElemType overallObjective;
+  //! The objective of the last full epoch.
+  ElemType lastObjective;
+  //! The objective returned by Optimize().
+  ElemType result;
+};
+
+/**
+ * Start a step-wise SGD optimization of the given function from the given
+ * iterate; see SGDStepper.
+ */
+template<typename UpdatePolicyType,
+         typename DecayPolicyType,
+         typename ExecutorType,
+         typename FunctionType,
+         typename MatType>
+SGDStepper<SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>, FunctionType,
+    MatType>
+MakeStepper(const SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>&
+                optimizer,
+            FunctionType& function,
+            MatType& iterate)
+{
+  return SGDStepper<SGD<UpdatePolicyType, DecayPolicyType, ExecutorType>,
+      FunctionType, MatType>(optimizer, function, iterate);
+}
+
+} // namespace ens
+
+// Include implementation.
+#include "sgd_stepper_impl.hpp"
+
+#endif
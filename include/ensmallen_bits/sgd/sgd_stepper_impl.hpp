@@ -0,0 +1,208 @@
+/**
+ * @file sgd_stepper_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of the step-wise SGD optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_SGD_STEPPER_IMPL_HPP
+#define ENSMALLEN_SGD_SGD_STEPPER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sgd_stepper.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename SGDType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType>
+SGDStepper<SGDType, FunctionType, MatType, GradType>::SGDStepper(
+    const SGDType& optimizer,
+    FunctionType& function,
+    MatType& iterate) :
+    optimizer(optimizer),
+    order(function, optimizer.ShuffleBlockSize()),
+    iterate(iterate),
+    updatePolicy(new InstUpdatePolicyType(optimizer.UpdatePolicy(),
+        iterate.n_rows, iterate.n_cols)),
+    numFunctions(0),
+    maxIterations((optimizer.MaxIterations() == 0) ?
+        std::numeric_limits<size_t>::max() : optimizer.MaxIterations()),
+    stepsTaken(0),
+    iteration(0),
+    currentFunction(0),
+    epoch(1),
+    done(false),
+    objective(0),
+    overallObjective(0),
+    lastObjective(std::numeric_limits<ElemType>::max()),
+    result(0)
+{
+  // Make sure we have all the methods that we need.
+  traits::CheckDecomposableFunctionTypeAPI<FullFunctionType, MatType,
+      GradType>();
+
+  numFunctions = Visited().NumFunctions();
+
+  // Resume from a stored state, if the optimizer was given one.
+  SGDType& o = this->optimizer;
+  if (!o.resumeState.Empty())
+  {
+    OptimizerState policyState;
+    o.resumeState.Get("stepSize", o.stepSize);
+    if (o.resumeState.Has("batchSize"))
+      o.resumeState.Get("batchSize", o.batchSize);
+    o.resumeState.Get("updatePolicy.", policyState);
+    LoadPolicyState(*updatePolicy, policyState);
+    o.resumeState.Get("decayPolicy.", policyState);
+    LoadPolicyState(o.decayPolicy, policyState);
+    o.resumeState.Clear();
+  }
+
+  // A step size schedule sets the step size of the first step.
+  InitializePolicyStepSize(o.decayPolicy, o.stepSize);
+
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+}
+
+template<typename SGDType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType>
+bool SGDStepper<SGDType, FunctionType, MatType, GradType>::Step(
+    const size_t steps)
+{
+  // The buffers of the batch evaluations are in the workspace of the
+  // optimizer, which is not kept when the stepper is moved.
+  typedef typename SGDType::template Workspace<MatType, GradType>
+      WorkspaceType;
+  if (!optimizer.workspace.template Has<WorkspaceType>())
+    optimizer.workspace.Set(new WorkspaceType());
+
+  for (size_t k = 0; k < steps && !done; ++k)
+    TakeStep();
+
+  return !done;
+}
+
+template<typename SGDType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType>
+void SGDStepper<SGDType, FunctionType, MatType, GradType>::TakeStep()
+{
+  VisitedFunctionType& visited = Visited();
+
+  if (iteration >= maxIterations)
+  {
+    ENS_INFO << "SGD: maximum iterations (" << optimizer.maxIterations
+        << ") reached; terminating optimization." << std::endl;
+
+    SynchronizeUpdatePolicy(*updatePolicy, iterate);
+
+    // Calculate final objective.
+    result = 0;
+    for (size_t i = 0; i < numFunctions; i += optimizer.batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(optimizer.batchSize,
+          numFunctions - i);
+      result += visited.Evaluate(iterate, i, effectiveBatchSize);
+    }
+
+    done = true;
+    return;
+  }
+
+  // Is this iteration the start of a sequence?
+  if ((currentFunction % numFunctions) == 0 && iteration > 0)
+  {
+    // Apply the updates that the policy deferred, so that the iterate seen at
+    // the end of the epoch is up to date.
+    SynchronizeUpdatePolicy(*updatePolicy, iterate);
+
+    // Output current objective function.
+    ENS_INFO << "SGD: iteration " << iteration << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      ENS_WARN << "SGD: converged to " << overallObjective << "; terminating"
+          << " with failure.  Try a smaller step size?" << std::endl;
+      result = overallObjective;
+      done = true;
+      return;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < optimizer.tolerance)
+    {
+      ENS_INFO << "SGD: minimized within tolerance " << optimizer.tolerance
+          << "; terminating optimization." << std::endl;
+      result = overallObjective;
+      done = true;
+      return;
+    }
+
+    // Reset the counter variables.
+    lastObjective = overallObjective;
+    overallObjective = 0;
+    currentFunction = 0;
+
+    if (optimizer.shuffle) // Determine order of visitation.
+      visited.Shuffle();
+
+    // The decay policy may change the batch size for the new epoch.
+    ++epoch;
+    UpdatePolicyBatchSize(optimizer.decayPolicy, optimizer.batchSize, epoch,
+        numFunctions);
+  }
+
+  // The batch size is bounded by the number of iterations and of functions
+  // left, as in SGD::Optimize().
+  const size_t effectiveBatchSize = std::min(
+      std::min(optimizer.batchSize, maxIterations - iteration),
+      numFunctions - currentFunction);
+
+  if (optimizer.parallelBatch)
+  {
+    objective = optimizer.ParallelEvaluateWithGradient(visited, iterate,
+        currentFunction, gradient, effectiveBatchSize);
+  }
+  else if (optimizer.microBatchSize > 0 &&
+      optimizer.microBatchSize < effectiveBatchSize)
+  {
+    typedef typename SGDType::template Workspace<MatType, GradType>
+        WorkspaceType;
+    std::vector<GradType>& microGradients =
+        optimizer.workspace.template As<WorkspaceType>().microGradients;
+    if (microGradients.empty())
+      microGradients.resize(1);
+
+    objective = optimizer.AccumulateEvaluateWithGradient(visited, iterate,
+        currentFunction, gradient, microGradients[0], effectiveBatchSize);
+  }
+  else
+  {
+    objective = visited.EvaluateWithGradient(iterate, currentFunction,
+        gradient, effectiveBatchSize);
+  }
+  overallObjective += objective;
+
+  // Use the update policy to take a step, then update the learning rate.
+  updatePolicy->Update(iterate, optimizer.stepSize, gradient);
+  optimizer.decayPolicy.Update(iterate, optimizer.stepSize, gradient);
+
+  iteration += effectiveBatchSize;
+  currentFunction += effectiveBatchSize;
+  ++stepsTaken;
+}
+
+} // namespace ens
+
+#endif
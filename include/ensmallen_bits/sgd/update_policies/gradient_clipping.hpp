@@ -20,6 +20,13 @@ namespace ens {
  * (Clipping here is implemented as
  * \f$ g_{\text{clipped}} = \max(g_{\text{min}}, \min(g_{\text{min}}, g))) \f$.)
  *
+ * If maxNorm is positive, the clipped gradient is then also rescaled to have a
+ * norm of at most maxNorm, \f$ g \leftarrow g \min(1, maxNorm / \|g\|) \f$,
+ * as is common for recurrent networks; set the element bounds to
+ * -DBL_MAX and DBL_MAX to only clip the norm.  The clipped gradient is stored
+ * in a buffer of the policy that is reused at each step, and the norm is
+ * computed in the same pass as the element-wise clipping.
+ *
  * @tparam UpdatePolicy A type of UpdatePolicy that sould be wrapped around.
  */
 template<typename UpdatePolicyType>
@@ -33,47 +40,144 @@ class GradientClipping
    * @param maxGradient Maximum possible value of gradient element.
    * @param updatePolicy An instance of the UpdatePolicyType
    *                     used for actual optimization.
+   * @param maxNorm Maximum norm of the gradient (0 means no limit).
    */
   GradientClipping(const double minGradient,
                    const double maxGradient,
-                   UpdatePolicyType& updatePolicy) :
+                   UpdatePolicyType& updatePolicy,
+                   const double maxNorm = 0.0) :
     minGradient(minGradient),
     maxGradient(maxGradient),
-    updatePolicy(updatePolicy)
+    updatePolicy(updatePolicy),
+    maxNorm(maxNorm)
   {
     // Nothing to do here
   }
 
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process. Here we just do whatever initialization
-   * is needed for the actual update policy.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    updatePolicy.Initialize(rows, cols);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  Here we just do whatever initialization is needed for
+     * the actual update policy.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(GradientClipping<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols)
+    {
+      // Nothing to do.
+    }
 
-  /**
-   * Update step. First, the gradient is clipped, and then the actual update
-   * policy does whatever update it needs to do.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // First, clip the gradient.
-    arma::mat clippedGradient = arma::clamp(gradient, minGradient, maxGradient);
-    // And only then do the update.
-    updatePolicy.Update(iterate, stepSize, clippedGradient);
-  }
+    /**
+     * Update step. First, the gradient is clipped, and then the actual update
+     * policy does whatever update it needs to do.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // First, clip the gradient.
+      Clip(gradient);
+      // And only then do the update.
+      instUpdatePolicy.Update(iterate, stepSize, clippedGradient);
+    }
+
+    /**
+     * Store the state of the actual update policy in the given state, so that
+     * the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+    }
+
+    /**
+     * Restore the state of the actual update policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+    }
+
+   private:
+    /**
+     * Clip the given dense gradient into clippedGradient, whose memory is
+     * reused, accumulating its squared norm on the way.
+     */
+    template<typename eT>
+    void Clip(const arma::Mat<eT>& gradient)
+    {
+      clippedGradient.set_size(gradient.n_rows, gradient.n_cols);
+
+      const eT minGradient = eT(parent.minGradient);
+      const eT maxGradient = eT(parent.maxGradient);
+      const eT* g = gradient.memptr();
+      eT* clipped = clippedGradient.memptr();
+
+      double sums[1];
+      ElementwiseSums(gradient.n_elem, [&](const size_t begin,
+          const size_t end, double* partial)
+      {
+        double squaredNorm = 0.0;
+        for (size_t i = begin; i < end; ++i)
+        {
+          clipped[i] = std::min(std::max(g[i], minGradient), maxGradient);
+          squaredNorm += double(clipped[i]) * double(clipped[i]);
+        }
+        partial[0] += squaredNorm;
+      }, sums);
+
+      ClipNorm(std::sqrt(sums[0]));
+    }
+
+    /**
+     * Clip the given sparse gradient into clippedGradient.
+     */
+    template<typename eT>
+    void Clip(const arma::SpMat<eT>& gradient)
+    {
+      clippedGradient = arma::clamp(gradient, eT(parent.minGradient),
+          eT(parent.maxGradient));
+      ClipNorm(arma::norm(clippedGradient, "fro"));
+    }
+
+    //! Rescale clippedGradient, whose norm is given, to at most maxNorm.
+    void ClipNorm(const double norm)
+    {
+      if (parent.maxNorm > 0.0 && norm > parent.maxNorm)
+        clippedGradient *= (parent.maxNorm / norm);
+    }
+
+    //! Instantiated parent object.
+    GradientClipping<UpdatePolicyType>& parent;
+    //! The buffer of the clipped gradient.
+    GradType clippedGradient;
+    //! The update policy instantiated for the given matrix types.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+  };
 
   //! Get the update policy.
   UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
@@ -90,6 +194,11 @@ class GradientClipping
   //! Modify the maximum gradient value.
   double& MaxGradient() { return maxGradient; }
 
+  //! Get the maximum gradient norm (0 means no limit).
+  double MaxNorm() const { return maxNorm; }
+  //! Modify the maximum gradient norm (0 means no limit).
+  double& MaxNorm() { return maxNorm; }
+
  private:
   //! Minimum possible value of gradient element.
   double minGradient;
@@ -99,6 +208,9 @@ class GradientClipping
 
   //! An instance of the UpdatePolicy used for actual optimization.
   UpdatePolicyType updatePolicy;
+
+  //! Maximum norm of the gradient.
+  double maxNorm;
 };
 
 } // namespace ens
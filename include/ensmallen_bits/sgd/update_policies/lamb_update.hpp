@@ -0,0 +1,255 @@
+/**
+ * @file lamb_update.hpp
+ * @author Marcus Edel
+ *
+ * Layer-wise adaptive moments (LAMB) update policy for SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LAMB_UPDATE_HPP
+#define ENSMALLEN_SGD_LAMB_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * Layer-wise adaptive moments (LAMB) is an Adam update whose step is scaled,
+ * for each block of parameters, by the trust ratio \f$ \| A \| / \| r \| \f$,
+ * where
+ *
+ * \f[
+ * r = \frac{\hat{m}}{\sqrt{\hat{v}} + \epsilon} + \beta A
+ * \f]
+ *
+ * is the Adam step with weight decay \f$ \beta \f$, and \f$ \hat{m} \f$ and
+ * \f$ \hat{v} \f$ are the bias-corrected moments.  The update is then
+ * \f$ A = A - \alpha \frac{\| A \|}{\| r \|} r \f$, and the trust ratio is 1
+ * if either norm is zero.  This allows very large batches without lowering
+ * the step size.
+ *
+ * The moments are updated in the same pass that accumulates the norms of A
+ * and r, and the iterate is updated in a second pass that recomputes r from
+ * the moments, so no parameter-sized buffer is needed besides the moments.
+ *
+ * The whole iterate is one block; to use one trust ratio per layer, wrap the
+ * policy in ParameterGroups with one group per layer, e.g.
+ * SGD<ParameterGroups<LAMBUpdate>>.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{You2020,
+ *   title     = {Large Batch Optimization for Deep Learning: Training BERT in
+ *                76 minutes},
+ *   author    = {You, Yang and Li, Jing and Reddi, Sashank and Hseu, Jonathan
+ *                and Kumar, Sanjiv and Bhojanapalli, Srinadh and Song, Xiaodan
+ *                and Demmel, James and Keutzer, Kurt and Hsieh, Cho-Jui},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2020}
+ * }
+ * @endcode
+ */
+class LAMBUpdate
+{
+ public:
+  /**
+   * Construct the LAMB update policy with the given parameters.
+   *
+   * @param epsilon The epsilon value used to initialise the squared gradient
+   *     parameter.
+   * @param beta1 The smoothing parameter.
+   * @param beta2 The second moment coefficient.
+   * @param weightDecay The weight decay.
+   */
+  LAMBUpdate(const double epsilon = 1e-6,
+             const double beta1 = 0.9,
+             const double beta2 = 0.999,
+             const double weightDecay = 0.0) :
+      epsilon(epsilon),
+      beta1(beta1),
+      beta2(beta2),
+      weightDecay(weightDecay)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the weight decay.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the weight decay.
+  double& WeightDecay() { return weightDecay; }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(LAMBUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0),
+        trustRatio(1.0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+    }
+
+    /**
+     * Update step for LAMB.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
+      const ElemType epsilon = parent.epsilon;
+      const ElemType weightDecay = parent.weightDecay;
+      const ElemType biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const ElemType biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      ElemType* x = iterate.memptr();
+      ElemType* mMem = m.memptr();
+      ElemType* vMem = v.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // Update the moments, and accumulate the squared norms of the iterate
+      // and of the Adam step r.
+      double norms[2];
+      ElementwiseSums(iterate.n_elem, [&](const size_t begin,
+          const size_t end, double* partial)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * g[i];
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+          const double r = (mMem[i] / biasCorrection1) /
+              (std::sqrt(vMem[i] / biasCorrection2) + epsilon) +
+              weightDecay * x[i];
+          partial[0] += double(x[i]) * x[i];
+          partial[1] += r * r;
+        }
+      }, norms);
+
+      const double iterateNorm = std::sqrt(norms[0]);
+      const double stepNorm = std::sqrt(norms[1]);
+      trustRatio = (iterateNorm > 0.0 && stepNorm > 0.0) ?
+          iterateNorm / stepNorm : 1.0;
+
+      const ElemType step = stepSize * trustRatio;
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          x[i] -= step * ((mMem[i] / biasCorrection1) /
+              (std::sqrt(vMem[i] / biasCorrection2) + epsilon) +
+              weightDecay * x[i]);
+        }
+      });
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("m", m);
+      state.Set("v", v);
+      state.Set("iteration", iteration);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("m", m);
+      state.Get("v", v);
+      state.Get("iteration", iteration);
+    }
+
+    //! Get the trust ratio of the last step.
+    double TrustRatio() const { return trustRatio; }
+
+   private:
+    //! Instantiated parent object.
+    LAMBUpdate& parent;
+
+    //! The exponential moving average of gradient values.
+    MatType m;
+
+    //! The exponential moving average of squared gradient values.
+    MatType v;
+
+    //! The number of iterations.
+    double iteration;
+
+    //! The trust ratio of the last step.
+    double trustRatio;
+  };
+
+ private:
+  //! The value used to initialise the squared gradient parameter.
+  double epsilon;
+
+  //! The smoothing parameter.
+  double beta1;
+
+  //! The second moment coefficient.
+  double beta2;
+
+  //! The weight decay.
+  double weightDecay;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file lars_update.hpp
+ * @author Marcus Edel
+ *
+ * Layer-wise adaptive rate scaling (LARS) update policy for SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LARS_UPDATE_HPP
+#define ENSMALLEN_SGD_LARS_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * Layer-wise adaptive rate scaling (LARS) is a momentum update whose step size
+ * is scaled, for each block of parameters, by the trust ratio
+ *
+ * \f[
+ * \lambda = \eta \frac{\| A \|}{\| \nabla f(A) \| + \beta \| A \|},
+ * \f]
+ *
+ * so that the size of the steps of a block is proportional to the size of its
+ * parameters; with it, very large batches can be used without lowering the
+ * step size.  The update is
+ *
+ * \f[
+ * v = \mu v + \alpha \lambda (\nabla f(A) + \beta A), \qquad A = A - v,
+ * \f]
+ *
+ * where \f$ \eta \f$ is the trust coefficient and \f$ \beta \f$ the weight
+ * decay.  The trust ratio is 1 if either norm is zero.  The norms take one pass
+ * over the iterate and the gradient, and the velocity and the iterate are
+ * updated in a second pass.
+ *
+ * The whole iterate is one block; to use one trust ratio per layer, wrap the
+ * policy in ParameterGroups with one group per layer, e.g.
+ * SGD<ParameterGroups<LARSUpdate>>.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{You2017,
+ *   title   = {Large Batch Training of Convolutional Networks},
+ *   author  = {You, Yang and Gitman, Igor and Ginsburg, Boris},
+ *   journal = {arXiv preprint arXiv:1708.03888},
+ *   year    = {2017}
+ * }
+ * @endcode
+ */
+class LARSUpdate
+{
+ public:
+  /**
+   * Construct the LARS update policy with the given parameters.
+   *
+   * @param momentum The momentum decay hyperparameter.
+   * @param trustCoefficient The trust coefficient of the trust ratio.
+   * @param weightDecay The weight decay.
+   * @param epsilon Value added to the denominator of the trust ratio for
+   *     numerical stability.
+   */
+  LARSUpdate(const double momentum = 0.9,
+             const double trustCoefficient = 0.001,
+             const double weightDecay = 0.0,
+             const double epsilon = 1e-9) :
+      momentum(momentum),
+      trustCoefficient(trustCoefficient),
+      weightDecay(weightDecay),
+      epsilon(epsilon)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the momentum decay hyperparameter.
+  double Momentum() const { return momentum; }
+  //! Modify the momentum decay hyperparameter.
+  double& Momentum() { return momentum; }
+
+  //! Get the trust coefficient.
+  double TrustCoefficient() const { return trustCoefficient; }
+  //! Modify the trust coefficient.
+  double& TrustCoefficient() { return trustCoefficient; }
+
+  //! Get the weight decay.
+  double WeightDecay() const { return weightDecay; }
+  //! Modify the weight decay.
+  double& WeightDecay() { return weightDecay; }
+
+  //! Get the value added to the denominator of the trust ratio.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value added to the denominator of the trust ratio.
+  double& Epsilon() { return epsilon; }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(LARSUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        trustRatio(1.0)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(velocity, rows, cols);
+    }
+
+    /**
+     * Update step for LARS.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+
+      ElemType* x = iterate.memptr();
+      ElemType* v = velocity.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+
+      // The squared norms of the iterate and of the gradient.
+      double norms[2];
+      ElementwiseSums(iterate.n_elem, [&](const size_t begin,
+          const size_t end, double* partial)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          partial[0] += double(x[i]) * x[i];
+          partial[1] += double(g[i]) * g[i];
+        }
+      }, norms);
+
+      const double iterateNorm = std::sqrt(norms[0]);
+      const double gradientNorm = std::sqrt(norms[1]);
+      trustRatio = (iterateNorm > 0.0 && gradientNorm > 0.0) ?
+          parent.trustCoefficient * iterateNorm / (gradientNorm +
+          parent.weightDecay * iterateNorm + parent.epsilon) : 1.0;
+
+      const ElemType momentum = parent.momentum;
+      const ElemType step = stepSize * trustRatio;
+      const ElemType weightDecay = parent.weightDecay;
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          v[i] = momentum * v[i] + step * (g[i] + weightDecay * x[i]);
+          x[i] -= v[i];
+        }
+      });
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("velocity", velocity);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("velocity", velocity);
+    }
+
+    //! Get the trust ratio of the last step.
+    double TrustRatio() const { return trustRatio; }
+
+   private:
+    //! Instantiated parent object.
+    LARSUpdate& parent;
+
+    //! The velocity matrix.
+    MatType velocity;
+
+    //! The trust ratio of the last step.
+    double trustRatio;
+  };
+
+ private:
+  //! The momentum decay hyperparameter.
+  double momentum;
+
+  //! The trust coefficient.
+  double trustCoefficient;
+
+  //! The weight decay.
+  double weightDecay;
+
+  //! The value added to the denominator of the trust ratio.
+  double epsilon;
+};
+
+} // namespace ens
+
+#endif
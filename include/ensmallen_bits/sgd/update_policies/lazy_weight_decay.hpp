@@ -0,0 +1,238 @@
+/**
+ * @file lazy_weight_decay.hpp
+ * @author Marcus Edel
+ *
+ * Weight decay update wrapper that applies the decay of each coordinate only
+ * when the coordinate has a non-zero gradient.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LAZY_WEIGHT_DECAY_HPP
+#define ENSMALLEN_SGD_LAZY_WEIGHT_DECAY_HPP
+
+#include "vanilla_update.hpp"
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., VanillaUpdate) to add
+ * the L2 penalty \f$ \frac{\lambda}{2} \|A\|^2 \f$ to every step, as the decay
+ *
+ * \f[
+ * A \leftarrow (1 - \alpha \lambda) A
+ * \f]
+ *
+ * before the step of the wrapped policy.  Applied to the whole iterate, the
+ * decay costs O(d) per step and destroys the benefit of sparse gradients.
+ * Instead, the decay of a coordinate is applied "just in time": each
+ * coordinate keeps the timestamp of its last update, measured on a clock that
+ * advances by \f$ \log(1 - \alpha \lambda) \f$ at each step, so that when the
+ * coordinate next has a non-zero gradient it is first multiplied by the exact
+ * product of all the decays it skipped.  A step with a sparse gradient then
+ * only touches the non-zero coordinates of the gradient, and the clock handles
+ * step sizes that change between steps.
+ *
+ * Coordinates that are not touched fall behind until Synchronize() is called,
+ * which SGD does at the end of every epoch and before computing the final
+ * objective.  The gradient of a batch is computed before the decay skipped by
+ * its coordinates is applied.  The function should not include the penalty in
+ * its gradient (e.g. LogisticRegressionFunction with lambda = 0).
+ *
+ * @code
+ * LazyWeightDecay<> update(1e-4);
+ * SGD<LazyWeightDecay<>> optimizer(0.01, 1, 100000, 1e-5, true, update);
+ * optimizer.Optimize<FunctionType, arma::mat, arma::sp_mat>(f, coordinates);
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ */
+template<typename UpdatePolicyType = VanillaUpdate>
+class LazyWeightDecay
+{
+ public:
+  /**
+   * Construct the LazyWeightDecay wrapper around the given update policy.
+   *
+   * @param lambda Strength of the L2 penalty.
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     actual optimization.
+   */
+  LazyWeightDecay(const double lambda = 1e-4,
+                  const UpdatePolicyType& updatePolicy = UpdatePolicyType()) :
+      lambda(lambda),
+      updatePolicy(updatePolicy)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(LazyWeightDecay<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        clock(0.0),
+        lastClock(rows, cols, arma::fill::zeros)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step: the coordinates with a non-zero gradient are brought up to
+     * date with the decay, and the wrapped policy takes its step.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      const double decay = 1.0 - stepSize * parent.lambda;
+      if (decay <= 0.0)
+      {
+        std::ostringstream oss;
+        oss << "LazyWeightDecay::Update(): the step size times lambda is "
+            << stepSize * parent.lambda << ", but must be less than 1!";
+        throw std::invalid_argument(oss.str());
+      }
+
+      clock += std::log(decay);
+      Decay(iterate, gradient);
+
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+    }
+
+    /**
+     * Apply the decay skipped by every coordinate, so that the whole iterate is
+     * up to date.
+     *
+     * @param iterate Parameters that minimize the function.
+     */
+    void Synchronize(MatType& iterate)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      for (size_t k = 0; k < iterate.n_elem; ++k)
+      {
+        iterate[k] *= ElemType(std::exp(clock - lastClock[k]));
+        lastClock[k] = clock;
+      }
+    }
+
+    /**
+     * Store the state of the actual update policy and the clocks in the given
+     * state, so that the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+      state.Set("clock", clock);
+      state.Set("lastClock", lastClock);
+    }
+
+    /**
+     * Restore the state of the actual update policy and the clocks from the
+     * given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+      state.Get("clock", clock);
+      state.Get("lastClock", lastClock);
+    }
+
+    //! Get the current value of the clock (the log of the total decay).
+    double Clock() const { return clock; }
+
+    //! Get the value of the clock at the last update of every coordinate.
+    const arma::mat& LastClock() const { return lastClock; }
+
+   private:
+    /**
+     * Bring the coordinates of the non-zero elements of the sparse gradient up
+     * to date.
+     */
+    template<typename eT>
+    void Decay(MatType& iterate, const arma::SpMat<eT>& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+      for (; cur != gradient.end(); ++cur)
+      {
+        const size_t k = cur.row() + cur.col() * iterate.n_rows;
+        iterate[k] *= ElemType(std::exp(clock - lastClock[k]));
+        lastClock[k] = clock;
+      }
+    }
+
+    //! A dense gradient touches every coordinate.
+    template<typename DenseGradType>
+    void Decay(MatType& iterate, const DenseGradType& /* gradient */)
+    {
+      Synchronize(iterate);
+    }
+
+    //! Instantiated parent object.
+    LazyWeightDecay<UpdatePolicyType>& parent;
+
+    //! The update policy used for the actual optimization.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The sum of the logs of the decays of all steps so far.
+    double clock;
+
+    //! The clock at the last update of every coordinate; the clocks are kept
+    //! in double precision since they only grow in magnitude.
+    arma::mat lastClock;
+  };
+
+  //! Get the strength of the L2 penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the strength of the L2 penalty.
+  double& Lambda() { return lambda; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+ private:
+  //! The strength of the L2 penalty.
+  double lambda;
+
+  //! An instance of the UpdatePolicy used for the actual optimization.
+  UpdatePolicyType updatePolicy;
+};
+
+} // namespace ens
+
+#endif
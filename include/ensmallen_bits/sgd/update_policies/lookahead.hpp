@@ -0,0 +1,213 @@
+/**
+ * @file lookahead.hpp
+ * @author Marcus Edel
+ *
+ * Lookahead update wrapper: the wrapped policy updates fast weights, which are
+ * pulled back towards a slow copy every few steps.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LOOKAHEAD_HPP
+#define ENSMALLEN_SGD_LOOKAHEAD_HPP
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate) with the
+ * Lookahead scheme: the iterate (the fast weights) is updated by the wrapped
+ * policy, and every k steps the slow weights are moved towards it and the
+ * iterate is reset to them,
+ *
+ * \f[
+ * \phi \leftarrow \phi + \alpha (\theta - \phi), \qquad \theta \leftarrow \phi.
+ * \f]
+ *
+ * Both assignments are done in a single pass, and the slow weights are kept
+ * by the policy, so no copy of the iterate is needed outside of the optimizer.
+ * The slow weights are taken from the iterate at the first step.  After the
+ * optimization, they can be read with SGD::InstUpdatePolicy().Slow().
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Zhang2019,
+ *   title     = {Lookahead Optimizer: k steps forward, 1 step back},
+ *   author    = {Zhang, Michael R. and Lucas, James and Hinton, Geoffrey and
+ *                Ba, Jimmy},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * @code
+ * Lookahead<AdamUpdate> update(AdamUpdate(), 5, 0.5);
+ * SGD<Lookahead<AdamUpdate>> optimizer(0.001, 32, 100000, 1e-5, true, update);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ */
+template<typename UpdatePolicyType>
+class Lookahead
+{
+ public:
+  /**
+   * Construct the Lookahead wrapper around the given update policy.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     updates of the fast weights.
+   * @param k Number of steps of the fast weights between two updates of the
+   *     slow weights.
+   * @param alpha Step size of the slow weights.
+   */
+  Lookahead(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+            const size_t k = 5,
+            const double alpha = 0.5) :
+      updatePolicy(updatePolicy),
+      k(k),
+      alpha(alpha)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(Lookahead<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        steps(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step: update the fast weights with the wrapped policy, and every
+     * k steps, update the slow weights and reset the fast weights to them.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      if (slow.n_rows != iterate.n_rows || slow.n_cols != iterate.n_cols)
+        slow = iterate;
+
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+
+      if (++steps < parent.k)
+        return;
+
+      steps = 0;
+      const ElemType alpha = parent.alpha;
+      ElemType* x = iterate.memptr();
+      ElemType* s = slow.memptr();
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          s[i] += alpha * (x[i] - s[i]);
+          x[i] = s[i];
+        }
+      });
+    }
+
+    /**
+     * Store the state of the actual update policy and the slow weights in the
+     * given state, so that the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+      state.Set("slow", slow);
+      state.Set("steps", steps);
+    }
+
+    /**
+     * Restore the state of the actual update policy and the slow weights from
+     * the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+      state.Get("slow", slow);
+      state.Get("steps", steps);
+    }
+
+    //! Get the slow weights.
+    const MatType& Slow() const { return slow; }
+
+   private:
+    //! Instantiated parent object.
+    Lookahead<UpdatePolicyType>& parent;
+
+    //! The update policy used for the fast weights.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The slow weights.
+    MatType slow;
+
+    //! The number of steps since the last update of the slow weights.
+    size_t steps;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the number of steps between two updates of the slow weights.
+  size_t K() const { return k; }
+  //! Modify the number of steps between two updates of the slow weights.
+  size_t& K() { return k; }
+
+  //! Get the step size of the slow weights.
+  double Alpha() const { return alpha; }
+  //! Modify the step size of the slow weights.
+  double& Alpha() { return alpha; }
+
+ private:
+  //! An instance of the UpdatePolicy used for the fast weights.
+  UpdatePolicyType updatePolicy;
+
+  //! The number of steps between two updates of the slow weights.
+  size_t k;
+
+  //! The step size of the slow weights.
+  double alpha;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file mixed_precision.hpp
+ * @author Marcus Edel
+ *
+ * Mixed-precision update wrapper: the iterate and the gradient are exchanged
+ * with the function in low precision, while the update policy works on a
+ * master copy of the parameters in higher precision.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_MIXED_PRECISION_HPP
+#define ENSMALLEN_SGD_MIXED_PRECISION_HPP
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate) so that the
+ * optimizer and the function can work in low precision (for instance with
+ * arma::fmat iterates and gradients, which halves the memory traffic of the
+ * function) while the update policy, its state and a master copy of the
+ * parameters are kept in the precision of MasterMatType.  Small updates that
+ * would be lost when added to a low precision iterate accumulate in the master
+ * copy instead.
+ *
+ * At each step, the gradient is converted to the master precision, the wrapped
+ * policy updates the master copy, and the iterate is set to the master copy
+ * converted to the low precision; each conversion is a single pass.  The master
+ * copy is taken from the iterate at the first step.
+ *
+ * @code
+ * MixedPrecision<AdamUpdate> update(AdamUpdate(1e-8, 0.9, 0.999));
+ * SGD<MixedPrecision<AdamUpdate>> optimizer(0.01, 32, 100000, 1e-5, true,
+ *     update);
+ *
+ * arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ * @tparam MasterMatType Type of the master copy of the parameters.
+ */
+template<typename UpdatePolicyType, typename MasterMatType = arma::mat>
+class MixedPrecision
+{
+ public:
+  /**
+   * Construct the MixedPrecision wrapper around the given update policy.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     actual optimization.
+   */
+  MixedPrecision(const UpdatePolicyType& updatePolicy = UpdatePolicyType()) :
+      updatePolicy(updatePolicy)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The wrapped policy is instantiated for the master type.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(MixedPrecision<UpdatePolicyType, MasterMatType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        masterGradient(rows, cols)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step: convert the gradient, update the master copy with the
+     * wrapped policy, and convert the master copy back into the iterate.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
+      typedef typename MasterMatType::elem_type MasterElemType;
+
+      if (master.n_rows != iterate.n_rows || master.n_cols != iterate.n_cols)
+        master = arma::conv_to<MasterMatType>::from(iterate);
+
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+      MasterElemType* masterG = masterGradient.memptr();
+      Elementwise(gradient.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+          masterG[i] = MasterElemType(g[i]);
+      });
+
+      instUpdatePolicy.Update(master, stepSize, masterGradient);
+
+      const MasterElemType* masterX = master.memptr();
+      ElemType* x = iterate.memptr();
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+          x[i] = ElemType(masterX[i]);
+      });
+    }
+
+    /**
+     * Store the state of the actual update policy and the master copy in the
+     * given state, so that the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+      state.Set("master", master);
+    }
+
+    /**
+     * Restore the state of the actual update policy and the master copy from
+     * the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+      state.Get("master", master);
+    }
+
+    //! Get the master copy of the parameters.
+    const MasterMatType& Master() const { return master; }
+
+   private:
+    //! The update policy instantiated for the master type.
+    typename UpdatePolicyType::template Policy<MasterMatType, MasterMatType>
+        instUpdatePolicy;
+    //! The master copy of the parameters.
+    MasterMatType master;
+    //! The buffer of the gradient in the master precision.
+    MasterMatType masterGradient;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+ private:
+  //! An instance of the UpdatePolicy used for actual optimization.
+  UpdatePolicyType updatePolicy;
+};
+
+} // namespace ens
+
+#endif
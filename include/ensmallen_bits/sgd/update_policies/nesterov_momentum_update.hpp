@@ -44,48 +44,158 @@ class NesterovMomentumUpdate
     // Nothing to do.
   }
 
+  //! Get the value used to initialize the momentum coefficient.
+  double Momentum() const { return momentum; }
+  //! Modify the value used to initialize the momentum coefficient.
+  double& Momentum() { return momentum; }
+
   /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.  In the momentum update policy the velocity
-   * matrix is initialized to the zeros matrix with the same size as the
-   * gradient matrix (see ens::SGD<>).
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Initialize(const size_t rows, const size_t cols)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Initialize an empty velocity matrix.
-    velocity = arma::zeros<arma::mat>(rows, cols);
-  }
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  In the momentum update policy the velocity matrix is
+     * initialized to the zeros matrix with the same size as the gradient
+     * matrix (see ens::SGD<>).
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(NesterovMomentumUpdate& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent)
+    {
+      // The state is first written by the threads that update it, for NUMA
+      // locality; GPU matrices are allocated on the device.
+      FirstTouchZeros(velocity, rows, cols);
+    }
 
-  /**
-   * Update step for SGD.  The momentum term makes the convergence faster on the
-   * way as momentum term increases for dimensions pointing in the same direction
-   * and reduces updates for dimensions whose gradients change directions.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
+    /**
+     * Update step for SGD.  The momentum term makes the convergence faster on
+     * the way as momentum term increases for dimensions pointing in the same
+     * direction and reduces updates for dimensions whose gradients change
+     * directions.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Step(iterate, stepSize, gradient);
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(velocity, rows, cols);
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("velocity", velocity);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("velocity", velocity);
+    }
+
+   private:
+    /**
+     * Take a step with a dense (or sparse, densified) gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    template<typename DenseGradType>
+    void Step(MatType& iterate,
               const double stepSize,
-              const arma::mat& gradient)
-  {
-    velocity = momentum * velocity - stepSize * gradient;
+              const DenseGradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+      typedef typename DenseGradType::elem_type GradElemType;
 
-    iterate += momentum * velocity - stepSize * gradient;
-  }
+      const ElemType momentum = parent.momentum;
+      const ElemType step = stepSize;
+      ElemType* x = iterate.memptr();
+      ElemType* v = velocity.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
 
-  //! Get the value used to initialize the momentum coefficient.
-  double Momentum() const { return momentum; }
-  //! Modify the value used to initialize the momentum coefficient.
-  double& Momentum() { return momentum; }
+      // Update the velocity and take the look-ahead step in place, in a single
+      // pass.
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType stepG = step * g[i];
+          v[i] = momentum * v[i] - stepG;
+          x[i] += momentum * v[i] - stepG;
+        }
+      });
+    }
 
- private:
-  // The velocity matrix.
-  arma::mat velocity;
+    #ifdef ENS_USE_COOT
+    /**
+     * Take a step on the GPU, with whole-matrix expressions that Bandicoot
+     * runs as kernels on the device.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    template<typename eT>
+    void Step(MatType& iterate,
+              const double stepSize,
+              const coot::Mat<eT>& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
 
+      velocity *= ElemType(parent.momentum);
+      velocity -= ElemType(stepSize) * gradient;
+      iterate += ElemType(parent.momentum) * velocity -
+          ElemType(stepSize) * gradient;
+    }
+    #endif
+
+    //! Instantiated parent object.
+    NesterovMomentumUpdate& parent;
+    //! The velocity matrix.
+    MatType velocity;
+  };
+
+ private:
   // The Momentum coefficient.
   double momentum;
 };
@@ -0,0 +1,320 @@
+/**
+ * @file parameter_groups.hpp
+ * @author Marcus Edel
+ *
+ * Parameter groups update wrapper: contiguous ranges of the iterate are
+ * updated by their own instance of an update policy, with their own
+ * hyperparameters, or are frozen.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_PARAMETER_GROUPS_HPP
+#define ENSMALLEN_SGD_PARAMETER_GROUPS_HPP
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate) so that
+ * different parts of the iterate use different hyperparameters.  A group is a
+ * contiguous range of elements of the iterate (in column-major order, so a
+ * range of columns of a matrix iterate is a group too), with its own instance
+ * of the update policy and a multiplier of the step size; a frozen group is
+ * not updated at all, and its elements cost nothing per step.  The elements
+ * that are not in any group are updated with the default policy given to the
+ * constructor.
+ *
+ * Each group is updated through a matrix that aliases the memory of the
+ * iterate and of the gradient, so no element is copied.  A group that covers
+ * whole columns is seen by its policy as a matrix with the rows of the
+ * iterate; any other group is seen as a column vector.  Sparse gradients are
+ * converted to dense ones.
+ *
+ * @code
+ * // Embeddings in columns 0 to 99 of a 64-row iterate with a smaller step
+ * // size, frozen columns 100 to 199, and the rest with the default policy.
+ * ParameterGroups<AdamUpdate> groups;
+ * groups.Add(0, 64 * 100, AdamUpdate(1e-8, 0.9, 0.99), 0.1);
+ * groups.Freeze(64 * 100, 64 * 100);
+ * SGD<ParameterGroups<AdamUpdate>> optimizer(0.001, 32, 100000, 1e-5, true,
+ *     groups);
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ */
+template<typename UpdatePolicyType>
+class ParameterGroups
+{
+ public:
+  //! A contiguous range of elements of the iterate and its hyperparameters.
+  struct Group
+  {
+    //! The first element of the group.
+    size_t begin;
+    //! The number of elements of the group.
+    size_t count;
+    //! The update policy of the group.
+    UpdatePolicyType updatePolicy;
+    //! The multiplier of the step size of the group.
+    double stepScale;
+    //! Whether the group is frozen.
+    bool frozen;
+  };
+
+  /**
+   * Construct the ParameterGroups wrapper with the given default policy and no
+   * groups.
+   *
+   * @param updatePolicy The update policy of the elements that are not in any
+   *     group.
+   */
+  ParameterGroups(const UpdatePolicyType& updatePolicy = UpdatePolicyType()) :
+      updatePolicy(updatePolicy)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Add a group of elements updated with the given policy.
+   *
+   * @param begin The first element of the group.
+   * @param count The number of elements of the group.
+   * @param groupPolicy The update policy of the group.
+   * @param stepScale The multiplier of the step size for the group.
+   */
+  void Add(const size_t begin,
+           const size_t count,
+           const UpdatePolicyType& groupPolicy,
+           const double stepScale = 1.0)
+  {
+    Group group = { begin, count, groupPolicy, stepScale, false };
+    groups.push_back(group);
+  }
+
+  /**
+   * Add a group of elements that are not updated.
+   *
+   * @param begin The first element of the group.
+   * @param count The number of elements of the group.
+   */
+  void Freeze(const size_t begin, const size_t count)
+  {
+    Group group = { begin, count, updatePolicy, 0.0, true };
+    groups.push_back(group);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    //! The dense gradient type seen by the policies of the groups.
+    typedef arma::Mat<typename GradType::elem_type> DenseGradType;
+
+    //! The policy of a group.
+    typedef typename UpdatePolicyType::template Policy<MatType, DenseGradType>
+        InstUpdatePolicyType;
+
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The groups are checked against the size of the iterate,
+     * and the policy of each group that is not frozen is instantiated.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(ParameterGroups<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        rows(rows)
+    {
+      // Visit the groups in the order of their elements, and give the gaps
+      // between them to the default policy.
+      std::vector<size_t> order(parent.groups.size());
+      for (size_t k = 0; k < order.size(); ++k)
+        order[k] = k;
+      std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
+          { return parent.groups[a].begin < parent.groups[b].begin; });
+
+      const size_t n = rows * cols;
+      size_t next = 0;
+      for (size_t k = 0; k < order.size(); ++k)
+      {
+        Group& group = parent.groups[order[k]];
+        if (group.begin < next || group.begin + group.count > n)
+        {
+          std::ostringstream oss;
+          oss << "ParameterGroups: the group of elements [" << group.begin
+              << ", " << group.begin + group.count << ") overlaps another "
+              << "group or is outside of the " << n << " elements of the "
+              << "iterate";
+          throw std::invalid_argument(oss.str());
+        }
+
+        if (group.begin > next)
+          AddSegment(parent.updatePolicy, next, group.begin - next, 1.0);
+        if (!group.frozen && group.count > 0)
+        {
+          AddSegment(group.updatePolicy, group.begin, group.count,
+              group.stepScale);
+        }
+        next = group.begin + group.count;
+      }
+
+      if (next < n)
+        AddSegment(parent.updatePolicy, next, n - next, 1.0);
+    }
+
+    /**
+     * Update step: the policy of each group that is not frozen updates its
+     * elements of the iterate.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename GradType::elem_type GradElemType;
+
+      DenseGradType buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
+      for (size_t k = 0; k < segments.size(); ++k)
+      {
+        const Segment& s = segments[k];
+        MatType x(iterate.memptr() + s.begin, s.rows, s.cols, false, true);
+        const DenseGradType groupGradient(const_cast<GradElemType*>(g +
+            s.begin), s.rows, s.cols, false, true);
+        policies[k]->Update(x, stepSize * s.stepScale, groupGradient);
+      }
+    }
+
+    /**
+     * Store the state of the policy of each group in the given state, so that
+     * the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      for (size_t k = 0; k < policies.size(); ++k)
+      {
+        OptimizerState groupState;
+        SavePolicyState(*policies[k], groupState);
+        state.Set(Prefix(k), groupState);
+      }
+    }
+
+    /**
+     * Restore the state of the policy of each group from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      for (size_t k = 0; k < policies.size(); ++k)
+      {
+        OptimizerState groupState;
+        state.Get(Prefix(k), groupState);
+        LoadPolicyState(*policies[k], groupState);
+      }
+    }
+
+    //! Get the number of groups that are updated (including the gaps between
+    //! the given groups).
+    size_t UpdatedGroups() const { return segments.size(); }
+
+    //! Get the number of elements that are updated at each step.
+    size_t UpdatedElements() const
+    {
+      size_t count = 0;
+      for (size_t k = 0; k < segments.size(); ++k)
+        count += segments[k].rows * segments[k].cols;
+      return count;
+    }
+
+    //! Get the policy of the k'th updated group, in the order of the elements.
+    const InstUpdatePolicyType& GroupPolicy(const size_t k) const
+    { return *policies[k]; }
+
+   private:
+    //! A range of elements updated by one policy.
+    struct Segment
+    {
+      size_t begin;
+      size_t rows;
+      size_t cols;
+      double stepScale;
+    };
+
+    //! Add a range of elements updated by the given policy.
+    void AddSegment(UpdatePolicyType& groupPolicy,
+                    const size_t begin,
+                    const size_t count,
+                    const double stepScale)
+    {
+      // Whole columns keep the shape of the iterate.
+      const bool columns = (rows > 0) && (begin % rows == 0) &&
+          (count % rows == 0);
+      Segment s = { begin, columns ? rows : count, columns ? count / rows : 1,
+          stepScale };
+      segments.push_back(s);
+      policies.push_back(std::unique_ptr<InstUpdatePolicyType>(
+          new InstUpdatePolicyType(groupPolicy, s.rows, s.cols)));
+    }
+
+    //! The prefix of the state of the k'th policy.
+    static std::string Prefix(const size_t k)
+    {
+      std::ostringstream oss;
+      oss << "group" << k << ".";
+      return oss.str();
+    }
+
+    //! The number of rows of the iterate.
+    size_t rows;
+
+    //! The ranges of elements that are updated.
+    std::vector<Segment> segments;
+
+    //! The policy of each range.
+    std::vector<std::unique_ptr<InstUpdatePolicyType>> policies;
+  };
+
+  //! Get the default update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the default update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the groups.
+  const std::vector<Group>& Groups() const { return groups; }
+  //! Modify the groups.
+  std::vector<Group>& Groups() { return groups; }
+
+ private:
+  //! The update policy of the elements that are not in any group.
+  UpdatePolicyType updatePolicy;
+
+  //! The groups.
+  std::vector<Group> groups;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file reset_update_policy.hpp
+ * @author Marcus Edel
+ *
+ * Reset an instantiated update policy in place, if it supports it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_UPDATE_POLICIES_RESET_UPDATE_POLICY_HPP
+#define ENSMALLEN_SGD_UPDATE_POLICIES_RESET_UPDATE_POLICY_HPP
+
+namespace ens {
+
+/**
+ * Detect whether an instantiated update policy has a method
+ * void Reset(const size_t rows, const size_t cols), which sets its state to
+ * that of a newly constructed policy for a gradient of the given size, reusing
+ * the memory it already has.
+ */
+template<typename PolicyType>
+struct HasResetMethod
+{
+  template<typename T>
+  static auto Check(int) -> decltype(
+      std::declval<T&>().Reset(size_t(0), size_t(0)), std::true_type());
+
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+/**
+ * Reset the given instantiated update policy in place for a gradient of the
+ * given size.
+ *
+ * @return true, since the policy could be reset.
+ */
+template<typename PolicyType>
+typename std::enable_if<HasResetMethod<PolicyType>::value, bool>::type
+ResetUpdatePolicy(PolicyType& policy, const size_t rows, const size_t cols)
+{
+  policy.Reset(rows, cols);
+  return true;
+}
+
+/**
+ * The given policy cannot be reset in place; the optimizer has to construct a
+ * new one.
+ *
+ * @return false.
+ */
+template<typename PolicyType>
+typename std::enable_if<!HasResetMethod<PolicyType>::value, bool>::type
+ResetUpdatePolicy(PolicyType& /* policy */,
+                  const size_t /* rows */,
+                  const size_t /* cols */)
+{
+  return false;
+}
+
+} // namespace ens
+
+#endif
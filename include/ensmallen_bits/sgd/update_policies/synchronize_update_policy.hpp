@@ -0,0 +1,54 @@
+/**
+ * @file synchronize_update_policy.hpp
+ * @author Marcus Edel
+ *
+ * Bring an iterate with lazily applied updates up to date.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_UPDATE_POLICIES_SYNCHRONIZE_UPDATE_POLICY_HPP
+#define ENSMALLEN_SGD_UPDATE_POLICIES_SYNCHRONIZE_UPDATE_POLICY_HPP
+
+namespace ens {
+
+/**
+ * Detect whether an instantiated update policy has a method
+ * void Synchronize(MatType& iterate), which applies to every coordinate of
+ * the iterate the updates that were deferred until the coordinate is next
+ * touched (see LazyWeightDecay).  SGD calls it at the end of every epoch and
+ * before the final objective is computed.
+ */
+template<typename PolicyType, typename MatType>
+struct HasSynchronizeMethod
+{
+  template<typename P>
+  static auto Check(int) -> decltype(
+      std::declval<P&>().Synchronize(std::declval<MatType&>()),
+      std::true_type());
+
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+//! Apply the deferred updates of the given policy to the whole iterate.
+template<typename PolicyType, typename MatType>
+typename std::enable_if<HasSynchronizeMethod<PolicyType, MatType>::value>::type
+SynchronizeUpdatePolicy(PolicyType& policy, MatType& iterate)
+{
+  policy.Synchronize(iterate);
+}
+
+//! A policy without a Synchronize() method always keeps the iterate current.
+template<typename PolicyType, typename MatType>
+typename std::enable_if<!HasSynchronizeMethod<PolicyType, MatType>::value>::type
+SynchronizeUpdatePolicy(PolicyType& /* policy */, MatType& /* iterate */)
+{ }
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file weight_averaging.hpp
+ * @author Marcus Edel
+ *
+ * Weight averaging update wrapper: a Polyak or exponential moving average of
+ * the iterates is kept alongside the optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_WEIGHT_AVERAGING_HPP
+#define ENSMALLEN_SGD_WEIGHT_AVERAGING_HPP
+
+namespace ens {
+
+/**
+ * Interface for wrapping around update policies (e.g., AdamUpdate) so that an
+ * average of the iterates is maintained after each step, without changing the
+ * optimization itself.  If decay is positive, the average is an exponential
+ * moving average,
+ *
+ * \f[
+ * \bar{\theta} \leftarrow \beta \bar{\theta} + (1 - \beta) \theta,
+ * \f]
+ *
+ * and otherwise it is the Polyak average of all the iterates since the first
+ * step, \f$ \bar{\theta} \leftarrow \bar{\theta} + (\theta - \bar{\theta}) / t
+ * \f$.  The average is updated in a single pass after each step of the wrapped
+ * policy, and starts at the first iterate.  After the optimization, it can be
+ * read with SGD::InstUpdatePolicy().Average().
+ *
+ * @code
+ * WeightAveraging<AdamUpdate> update(AdamUpdate(), 0.999);
+ * SGD<WeightAveraging<AdamUpdate>> optimizer(0.001, 32, 100000, 1e-5, true,
+ *     update);
+ * optimizer.Optimize(f, coordinates);
+ * arma::mat averaged = optimizer.InstUpdatePolicy().Average();
+ * @endcode
+ *
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ */
+template<typename UpdatePolicyType>
+class WeightAveraging
+{
+ public:
+  /**
+   * Construct the WeightAveraging wrapper around the given update policy.
+   *
+   * @param updatePolicy An instance of the UpdatePolicyType used for the
+   *     actual optimization.
+   * @param decay Decay of the exponential moving average (0 means the Polyak
+   *     average of all iterates).
+   */
+  WeightAveraging(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                  const double decay = 0.999) :
+      updatePolicy(updatePolicy),
+      decay(decay)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(WeightAveraging<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instUpdatePolicy(parent.updatePolicy, rows, cols),
+        count(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Update step: the wrapped policy updates the iterate, and the average is
+     * updated with the new iterate.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      instUpdatePolicy.Update(iterate, stepSize, gradient);
+
+      ++count;
+      if (average.n_rows != iterate.n_rows || average.n_cols != iterate.n_cols)
+      {
+        average = iterate;
+        count = 1;
+        return;
+      }
+
+      const ElemType weight = (parent.decay > 0.0) ? 1.0 - parent.decay :
+          1.0 / count;
+      const ElemType* x = iterate.memptr();
+      ElemType* a = average.memptr();
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+          a[i] += weight * (x[i] - a[i]);
+      });
+    }
+
+    /**
+     * Store the state of the actual update policy and the average in the given
+     * state, so that the optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      SavePolicyState(instUpdatePolicy, state);
+      state.Set("average", average);
+      state.Set("count", count);
+    }
+
+    /**
+     * Restore the state of the actual update policy and the average from the
+     * given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      LoadPolicyState(instUpdatePolicy, state);
+      state.Get("average", average);
+      state.Get("count", count);
+    }
+
+    //! Get the average of the iterates.
+    const MatType& Average() const { return average; }
+
+    //! Get the number of iterates in the average.
+    size_t Count() const { return count; }
+
+   private:
+    //! Instantiated parent object.
+    WeightAveraging<UpdatePolicyType>& parent;
+
+    //! The update policy used for the actual optimization.
+    typename UpdatePolicyType::template Policy<MatType, GradType>
+        instUpdatePolicy;
+
+    //! The average of the iterates.
+    MatType average;
+
+    //! The number of iterates in the average.
+    size_t count;
+  };
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the decay of the moving average (0 means the Polyak average).
+  double Decay() const { return decay; }
+  //! Modify the decay of the moving average (0 means the Polyak average).
+  double& Decay() { return decay; }
+
+ private:
+  //! An instance of the UpdatePolicy used for the actual optimization.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay of the moving average.
+  double decay;
+};
+
+} // namespace ens
+
+#endif
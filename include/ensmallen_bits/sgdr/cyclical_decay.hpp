@@ -47,13 +47,11 @@ class CyclicalDecay
    * @param epochRestart Initial epoch where decay is applied.
    * @param multFactor Factor to increase the number of epochs before a restart.
    * @param stepSize Initial step size for each restart.
-   * @param batchSize Size of each mini-batch.
-   * @param numFunctions The number of separable functions (the number of
-   *        predictor points).
    */
   CyclicalDecay(const size_t epochRestart,
                 const double multFactor,
                 const double stepSize) :
+      initialEpochRestart(epochRestart),
       epochRestart(epochRestart),
       multFactor(multFactor),
       constStepSize(stepSize),
@@ -63,6 +61,19 @@ class CyclicalDecay
       epoch(0)
   { /* Nothing to do here */ }
 
+  /**
+   * Go back to the start of the first cycle, as for a new optimization.  By
+   * default the position in the cycle is kept over calls to Optimize(), so
+   * that an optimization can be warm-started from the last one.
+   */
+  void Restart()
+  {
+    epochRestart = initialEpochRestart;
+    nextRestart = initialEpochRestart;
+    batchRestart = 0;
+    epoch = 0;
+  }
+
   /**
    * This function is called in each iteration after the policy update.
    *
@@ -70,9 +81,10 @@ class CyclicalDecay
    * @param stepSize Step size to be used for the given iteration.
    * @param gradient The gradient matrix.
    */
-  void Update(arma::mat& /* iterate */,
+  template<typename MatType, typename GradType>
+  void Update(MatType& /* iterate */,
               double& stepSize,
-              const arma::mat& /* gradient */)
+              const GradType& /* gradient */)
   {
     // Time to adjust the step size.
     if (epoch >= epochRestart)
@@ -100,6 +112,33 @@ class CyclicalDecay
     epoch++;
   }
 
+  /**
+   * Store the position in the restart cycle in the given state, so that the
+   * optimization can be resumed later.
+   *
+   * @param state The state to store to.
+   */
+  void Save(OptimizerState& state) const
+  {
+    state.Set("epochRestart", epochRestart);
+    state.Set("nextRestart", nextRestart);
+    state.Set("batchRestart", batchRestart);
+    state.Set("epoch", epoch);
+  }
+
+  /**
+   * Restore the position in the restart cycle from the given state.
+   *
+   * @param state The state to restore from.
+   */
+  void Load(const OptimizerState& state)
+  {
+    state.Get("epochRestart", epochRestart);
+    state.Get("nextRestart", nextRestart);
+    state.Get("batchRestart", batchRestart);
+    state.Get("epoch", epoch);
+  }
+
   //! Get the step size.
   double StepSize() const { return constStepSize; }
   //! Modify the step size.
@@ -110,7 +149,35 @@ class CyclicalDecay
   //! Modify the restart fraction.
   double& EpochBatches() { return epochBatches; }
 
+  //! Get the factor by which each cycle is longer than the last.
+  double MultFactor() const { return multFactor; }
+  //! Modify the factor by which each cycle is longer than the last.
+  double& MultFactor() { return multFactor; }
+
+  //! Get the length of the current cycle.
+  size_t EpochRestart() const { return epochRestart; }
+  //! Modify the length of the current cycle.
+  size_t& EpochRestart() { return epochRestart; }
+
+  //! Get the time of the next restart.
+  size_t NextRestart() const { return nextRestart; }
+  //! Modify the time of the next restart.
+  size_t& NextRestart() { return nextRestart; }
+
+  //! Get the number of batches since the last restart.
+  size_t BatchRestart() const { return batchRestart; }
+  //! Modify the number of batches since the last restart.
+  size_t& BatchRestart() { return batchRestart; }
+
+  //! Get the time since the start of the first cycle.
+  size_t Epoch() const { return epoch; }
+  //! Modify the time since the start of the first cycle.
+  size_t& Epoch() { return epoch; }
+
  private:
+  //! The length of the first cycle, for Restart().
+  size_t initialEpochRestart;
+
   //! Epoch where decay is applied.
   size_t epochRestart;
 
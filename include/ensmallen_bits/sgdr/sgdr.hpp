@@ -85,12 +85,31 @@ class SGDR
    * final objective value is returned.
    *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to be optimized.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the length of the current cycle.
+  size_t EpochRestart() const { return optimizer.DecayPolicy().EpochRestart(); }
+  //! Modify the length of the current cycle.
+  size_t& EpochRestart() { return optimizer.DecayPolicy().EpochRestart(); }
+
+  //! Get the factor by which each cycle is longer than the last.
+  double MultFactor() const { return optimizer.DecayPolicy().MultFactor(); }
+  //! Modify the factor by which each cycle is longer than the last.
+  double& MultFactor() { return optimizer.DecayPolicy().MultFactor(); }
 
   //! Get the batch size.
   size_t BatchSize() const { return optimizer.BatchSize(); }
@@ -117,6 +136,25 @@ class SGDR
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return optimizer.Shuffle(); }
 
+  //! Get whether or not the gradient of each batch is computed in parallel.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not the gradient of each batch is computed in parallel.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get the number of functions in each gradient evaluation (0 means the whole
+  //! batch).
+  size_t MicroBatchSize() const { return optimizer.MicroBatchSize(); }
+  //! Modify the number of functions in each gradient evaluation (0 means the
+  //! whole batch).
+  size_t& MicroBatchSize() { return optimizer.MicroBatchSize(); }
+
+  //! Get the number of consecutive functions shuffled as a block (0 means the
+  //! functions are shuffled individually).
+  size_t ShuffleBlockSize() const { return optimizer.ShuffleBlockSize(); }
+  //! Modify the number of consecutive functions shuffled as a block (0 means
+  //! the functions are shuffled individually).
+  size_t& ShuffleBlockSize() { return optimizer.ShuffleBlockSize(); }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const
   {
@@ -128,6 +166,41 @@ class SGDR
     return optimizer.UpdatePolicy();
   }
 
+  //! Get whether or not the update policy is reset before every call to
+  //! Optimize().  Policies that can be reset in place keep their memory.
+  bool ResetPolicy() const { return optimizer.ResetPolicy(); }
+  //! Modify whether or not the update policy is reset before every call to
+  //! Optimize().
+  bool& ResetPolicy() { return optimizer.ResetPolicy(); }
+
+  //! Get the decay policy, which holds the position in the restart cycle.
+  const CyclicalDecay& DecayPolicy() const { return optimizer.DecayPolicy(); }
+  //! Modify the decay policy, which holds the position in the restart cycle.
+  CyclicalDecay& DecayPolicy() { return optimizer.DecayPolicy(); }
+
+  /**
+   * Store the state of the optimizer, including the position in the restart
+   * cycle, in the given state; see SGD::SaveState().
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
  private:
   //! The size of each mini-batch.
   size_t batchSize;
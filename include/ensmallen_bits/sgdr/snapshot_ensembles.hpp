@@ -14,6 +14,8 @@
 #ifndef ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 #define ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 
+#include <functional>
+
 namespace ens {
 
 /**
@@ -35,6 +37,10 @@ namespace ens {
  *   url       = {https://arxiv.org/abs/1704.00109}
  * }
  * @endcode
+ *
+ * The running mean of the snapshots is always kept, and each snapshot can be
+ * handed to a user-provided sink (e.g. to write it to disk) as it is taken,
+ * so that the snapshots themselves do not have to be kept in memory.
  */
 class SnapshotEnsembles
 {
@@ -53,18 +59,24 @@ class SnapshotEnsembles
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *        limit).
    * @param snapshots Maximum number of snapshots.
+   * @param storeSnapshots If true, keep a copy of every snapshot; otherwise
+   *        only their running mean is kept.
    */
   SnapshotEnsembles(const size_t epochRestart,
                     const double multFactor,
                     const double stepSize,
                     const size_t maxIterations,
-                    const size_t snapshots) :
+                    const size_t snapshots,
+                    const bool storeSnapshots = true) :
+    initialEpochRestart(epochRestart),
     epochRestart(epochRestart),
     multFactor(multFactor),
     constStepSize(stepSize),
     nextRestart(epochRestart),
     batchRestart(0),
-    epoch(0)
+    epoch(0),
+    storeSnapshots(storeSnapshots),
+    numSnapshots(0)
   {
     snapshotEpochs = 0;
     for (size_t i = 0, er = epochRestart, nr = nextRestart;
@@ -82,16 +94,34 @@ class SnapshotEnsembles
         snapshotEpochs - snapshots + 1);
   }
 
+  /**
+   * Go back to the start of the first cycle, and forget the snapshots taken so
+   * far, as for a new optimization.  The memory of the snapshot mean is kept.
+   */
+  void Restart()
+  {
+    epochRestart = initialEpochRestart;
+    nextRestart = initialEpochRestart;
+    batchRestart = 0;
+    epoch = 0;
+    numSnapshots = 0;
+    snapshots.clear();
+  }
+
   /**
    * This function is called in each iteration after the policy update.
    *
+   * Snapshots are always stored as arma::mat, whatever the type of the
+   * iterate.
+   *
    * @param iterate Parameters that minimize the function.
    * @param stepSize Step size to be used for the given iteration.
    * @param gradient The gradient matrix.
    */
-  void Update(arma::mat& iterate,
+  template<typename MatType, typename GradType>
+  void Update(MatType& iterate,
               double& stepSize,
-              const arma::mat& /* gradient */)
+              const GradType& /* gradient */)
   {
     // Time to adjust the step size.
     if (epoch >= epochRestart)
@@ -114,9 +144,7 @@ class SnapshotEnsembles
 
       // Create a new snapshot.
       if (epochRestart >= snapshotEpochs)
-      {
-        snapshots.push_back(iterate);
-      }
+        TakeSnapshot(arma::conv_to<arma::mat>::from(iterate));
 
       // Update the time for the next restart.
       nextRestart += epochRestart;
@@ -125,6 +153,49 @@ class SnapshotEnsembles
     epoch++;
   }
 
+  /**
+   * Store the position in the restart cycle in the given state, so that the
+   * optimization can be resumed later.
+   *
+   * @param state The state to store to.
+   */
+  void Save(OptimizerState& state) const
+  {
+    state.Set("epochRestart", epochRestart);
+    state.Set("nextRestart", nextRestart);
+    state.Set("batchRestart", batchRestart);
+    state.Set("epoch", epoch);
+
+    // Store the snapshots taken so far and their mean.
+    state.Set("numSnapshots", numSnapshots);
+    state.Set("snapshotMean", snapshotMean);
+    state.Set("numStoredSnapshots", snapshots.size());
+    for (size_t i = 0; i < snapshots.size(); ++i)
+      state.Set("snapshot" + std::to_string(i), snapshots[i]);
+  }
+
+  /**
+   * Restore the position in the restart cycle from the given state.
+   *
+   * @param state The state to restore from.
+   */
+  void Load(const OptimizerState& state)
+  {
+    state.Get("epochRestart", epochRestart);
+    state.Get("nextRestart", nextRestart);
+    state.Get("batchRestart", batchRestart);
+    state.Get("epoch", epoch);
+
+    state.Get("numSnapshots", numSnapshots);
+    state.Get("snapshotMean", snapshotMean);
+
+    size_t numStoredSnapshots;
+    state.Get("numStoredSnapshots", numStoredSnapshots);
+    snapshots.resize(numStoredSnapshots);
+    for (size_t i = 0; i < numStoredSnapshots; ++i)
+      state.Get("snapshot" + std::to_string(i), snapshots[i]);
+  }
+
   //! Get the step size.
   double StepSize() const { return constStepSize; }
   //! Modify the step size.
@@ -135,12 +206,77 @@ class SnapshotEnsembles
   //! Modify the restart fraction.
   double& EpochBatches() { return epochBatches; }
 
+  //! Get the factor by which each cycle is longer than the last.  The epochs
+  //! of the snapshots are fixed by the constructor.
+  double MultFactor() const { return multFactor; }
+
+  //! Get the length of the current cycle.
+  size_t EpochRestart() const { return epochRestart; }
+  //! Modify the length of the current cycle.
+  size_t& EpochRestart() { return epochRestart; }
+
+  //! Get the time of the next restart.
+  size_t NextRestart() const { return nextRestart; }
+  //! Modify the time of the next restart.
+  size_t& NextRestart() { return nextRestart; }
+
+  //! Get the number of batches since the last restart.
+  size_t BatchRestart() const { return batchRestart; }
+  //! Modify the number of batches since the last restart.
+  size_t& BatchRestart() { return batchRestart; }
+
+  //! Get the time since the start of the first cycle.
+  size_t Epoch() const { return epoch; }
+  //! Modify the time since the start of the first cycle.
+  size_t& Epoch() { return epoch; }
+
   //! Get the snapshots.
   std::vector<arma::mat> Snapshots() const { return snapshots; }
   //! Modify the snapshots.
   std::vector<arma::mat>& Snapshots() { return snapshots; }
 
+  //! Get whether a copy of every snapshot is kept.
+  bool StoreSnapshots() const { return storeSnapshots; }
+  //! Modify whether a copy of every snapshot is kept.
+  bool& StoreSnapshots() { return storeSnapshots; }
+
+  //! Get the number of snapshots taken.
+  size_t NumSnapshots() const { return numSnapshots; }
+
+  //! Get the running mean of the snapshots taken.
+  const arma::mat& SnapshotMean() const { return snapshotMean; }
+
+  //! Get the function each snapshot is handed to as it is taken.
+  const std::function<void(const arma::mat&)>& SnapshotSink() const
+  {
+    return snapshotSink;
+  }
+  //! Modify the function each snapshot is handed to as it is taken.
+  std::function<void(const arma::mat&)>& SnapshotSink()
+  {
+    return snapshotSink;
+  }
+
  private:
+  //! Add the given snapshot to the mean, and hand it to the sink or keep it.
+  //! The snapshot is moved into the list, so it is only copied once.
+  void TakeSnapshot(arma::mat&& snapshot)
+  {
+    ++numSnapshots;
+    if (numSnapshots == 1)
+      snapshotMean = snapshot;
+    else
+      snapshotMean += (snapshot - snapshotMean) / (double) numSnapshots;
+
+    if (snapshotSink)
+      snapshotSink(snapshot);
+    if (storeSnapshots)
+      snapshots.push_back(std::move(snapshot));
+  }
+
+  //! The length of the first cycle, for Restart().
+  size_t initialEpochRestart;
+
   //! Epoch where decay is applied.
   size_t epochRestart;
 
@@ -167,6 +303,18 @@ class SnapshotEnsembles
 
   //! Locally-stored parameter snapshots.
   std::vector<arma::mat> snapshots;
+
+  //! Whether a copy of every snapshot is kept.
+  bool storeSnapshots;
+
+  //! The number of snapshots taken.
+  size_t numSnapshots;
+
+  //! The running mean of the snapshots taken.
+  arma::mat snapshotMean;
+
+  //! The function each snapshot is handed to as it is taken.
+  std::function<void(const arma::mat&)> snapshotSink;
 };
 
 } // namespace ens
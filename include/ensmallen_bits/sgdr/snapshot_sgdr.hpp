@@ -84,6 +84,9 @@ class SnapshotSGDR
    * @param accumulate Accumulate the snapshot parameter (default true).
    * @param updatePolicy Instantiated update policy used to adjust the given
    *        parameters.
+   * @param storeSnapshots If true, keep a copy of every snapshot; otherwise
+   *        only their running mean is kept, which is enough to accumulate
+   *        them.
    */
   SnapshotSGDR(const size_t epochRestart = 50,
                const double multFactor = 2.0,
@@ -94,19 +97,36 @@ class SnapshotSGDR
                const bool shuffle = true,
                const size_t snapshots = 5,
                const bool accumulate = true,
-               const UpdatePolicyType& updatePolicy = UpdatePolicyType());
+               const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+               const bool storeSnapshots = true);
 
   /**
    * Optimize the given function using SGDR.  The given starting point
    * will be modified to store the finishing point of the algorithm, and the
    * final objective value is returned.
    *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType,
+           typename MatType,
+           typename GradType = MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(DecomposableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the length of the current cycle.
+  size_t EpochRestart() const { return optimizer.DecayPolicy().EpochRestart(); }
+
+  //! Get the factor by which each cycle is longer than the last.
+  double MultFactor() const { return optimizer.DecayPolicy().MultFactor(); }
 
   //! Get the batch size.
   size_t BatchSize() const { return optimizer.BatchSize(); }
@@ -133,6 +153,32 @@ class SnapshotSGDR
   //! Modify whether or not the individual functions are shuffled.
   bool& Shuffle() { return optimizer.Shuffle(); }
 
+  //! Get whether or not the gradient of each batch is computed in parallel.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not the gradient of each batch is computed in parallel.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get the number of functions in each gradient evaluation (0 means the whole
+  //! batch).
+  size_t MicroBatchSize() const { return optimizer.MicroBatchSize(); }
+  //! Modify the number of functions in each gradient evaluation (0 means the
+  //! whole batch).
+  size_t& MicroBatchSize() { return optimizer.MicroBatchSize(); }
+
+  //! Get the number of consecutive functions shuffled as a block (0 means the
+  //! functions are shuffled individually).
+  size_t ShuffleBlockSize() const { return optimizer.ShuffleBlockSize(); }
+  //! Modify the number of consecutive functions shuffled as a block (0 means
+  //! the functions are shuffled individually).
+  size_t& ShuffleBlockSize() { return optimizer.ShuffleBlockSize(); }
+
+  //! Get whether the gradient of the next batch is computed while the update
+  //! of the current batch is applied.
+  bool Pipelined() const { return optimizer.Pipelined(); }
+  //! Modify whether the gradient of the next batch is computed while the
+  //! update of the current batch is applied.
+  bool& Pipelined() { return optimizer.Pipelined(); }
+
   //! Get the snapshots.
   std::vector<arma::mat> Snapshots() const
   {
@@ -144,6 +190,37 @@ class SnapshotSGDR
     return optimizer.DecayPolicy().Snapshots();
   }
 
+  //! Get whether a copy of every snapshot is kept.
+  bool StoreSnapshots() const
+  {
+    return optimizer.DecayPolicy().StoreSnapshots();
+  }
+  //! Modify whether a copy of every snapshot is kept.
+  bool& StoreSnapshots() { return optimizer.DecayPolicy().StoreSnapshots(); }
+
+  //! Get the number of snapshots taken.
+  size_t NumSnapshots() const
+  {
+    return optimizer.DecayPolicy().NumSnapshots();
+  }
+
+  //! Get the running mean of the snapshots taken.
+  const arma::mat& SnapshotMean() const
+  {
+    return optimizer.DecayPolicy().SnapshotMean();
+  }
+
+  //! Get the function each snapshot is handed to as it is taken.
+  const std::function<void(const arma::mat&)>& SnapshotSink() const
+  {
+    return optimizer.DecayPolicy().SnapshotSink();
+  }
+  //! Modify the function each snapshot is handed to as it is taken.
+  std::function<void(const arma::mat&)>& SnapshotSink()
+  {
+    return optimizer.DecayPolicy().SnapshotSink();
+  }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const
   {
@@ -155,6 +232,44 @@ class SnapshotSGDR
     return optimizer.UpdatePolicy();
   }
 
+  //! Get whether or not the update policy is reset before every call to
+  //! Optimize().  Policies that can be reset in place keep their memory.
+  bool ResetPolicy() const { return optimizer.ResetPolicy(); }
+  //! Modify whether or not the update policy is reset before every call to
+  //! Optimize().
+  bool& ResetPolicy() { return optimizer.ResetPolicy(); }
+
+  //! Get the decay policy, which holds the position in the restart cycle.
+  const SnapshotEnsembles& DecayPolicy() const
+  {
+    return optimizer.DecayPolicy();
+  }
+  //! Modify the decay policy, which holds the position in the restart cycle.
+  SnapshotEnsembles& DecayPolicy() { return optimizer.DecayPolicy(); }
+
+  /**
+   * Store the state of the optimizer, including the position in the restart
+   * cycle, in the given state; see SGD::SaveState().
+   *
+   * @param state The state to store to.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  void SaveState(OptimizerState& state) const
+  {
+    optimizer.template SaveState<MatType, GradType>(state);
+  }
+
+  /**
+   * Resume from the given state in the next call to Optimize(); see
+   * SGD::LoadState().
+   *
+   * @param state The state to restore from.
+   */
+  void LoadState(const OptimizerState& state) { optimizer.LoadState(state); }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return optimizer.Profile(); }
+
  private:
   //! The size of each mini-batch.
   size_t batchSize;
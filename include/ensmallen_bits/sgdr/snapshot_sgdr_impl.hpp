@@ -28,7 +28,8 @@ SnapshotSGDR<UpdatePolicyType>::SnapshotSGDR(
     const bool shuffle,
     const size_t snapshots,
     const bool accumulate,
-    const UpdatePolicyType& updatePolicy) :
+    const UpdatePolicyType& updatePolicy,
+    const bool storeSnapshots) :
     batchSize(batchSize),
     accumulate(accumulate),
     optimizer(OptimizerType(stepSize,
@@ -42,16 +43,21 @@ SnapshotSGDR<UpdatePolicyType>::SnapshotSGDR(
                                 multFactor,
                                 stepSize,
                                 maxIterations,
-                                snapshots)))
+                                snapshots,
+                                storeSnapshots)))
 {
   /* Nothing to do here */
 }
 
 template<typename UpdatePolicyType>
-template<typename DecomposableFunctionType>
-double SnapshotSGDR<UpdatePolicyType>::Optimize(
+template<typename DecomposableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type SnapshotSGDR<UpdatePolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
 {
   // If a user changed the step size he hasn't update the step size of the
   // cyclical decay instantiation, so we have to do here.
@@ -70,17 +76,31 @@ double SnapshotSGDR<UpdatePolicyType>::Optimize(
     batchSize = optimizer.BatchSize();
   }
 
-  double overallObjective = optimizer.Optimize(function, iterate);
+  typename MatType::elem_type overallObjective =
+      optimizer.template Optimize<DecomposableFunctionType, MatType,
+      GradType>(function, iterate, callbacks...);
 
   // Accumulate snapshots.
-  if (accumulate)
+  if (accumulate && optimizer.DecayPolicy().StoreSnapshots())
   {
     for (size_t i = 0; i < optimizer.DecayPolicy().Snapshots().size(); ++i)
     {
-      iterate += optimizer.DecayPolicy().Snapshots()[i];
+      iterate += arma::conv_to<MatType>::from(
+          optimizer.DecayPolicy().Snapshots()[i]);
     }
     iterate /= (optimizer.DecayPolicy().Snapshots().size() + 1);
+  }
+  else if (accumulate && optimizer.DecayPolicy().NumSnapshots() > 0)
+  {
+    // Only the mean of the snapshots is known, which gives the same average.
+    const size_t numSnapshots = optimizer.DecayPolicy().NumSnapshots();
+    iterate += arma::conv_to<MatType>::from((double) numSnapshots *
+        optimizer.DecayPolicy().SnapshotMean());
+    iterate /= (numSnapshots + 1);
+  }
 
+  if (accumulate)
+  {
     // Calculate final objective.
     overallObjective = 0;
     for (size_t i = 0; i < function.NumFunctions(); ++i)
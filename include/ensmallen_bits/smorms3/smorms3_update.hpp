@@ -43,62 +43,123 @@ class SMORMS3Update
   SMORMS3Update(const double epsilon = 1e-16) : epsilon(epsilon)
   { /* Do nothing. */ }
 
-  /**
-   * The Initialize method is called by SGD::Optimize method with UpdatePolicy
-   * SMORMS3Update before the start of the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    // Initialise the parameters mem, g and g2.
-    mem = arma::ones<arma::mat>(rows, cols);
-    g = arma::zeros<arma::mat>(rows, cols);
-    g2 = arma::zeros<arma::mat>(rows, cols);
-  }
-
-  /**
-   * Update step for SMORMS3.
-   *
-   * @param iterate Parameter that minimizes the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    // Update the iterate.
-    arma::mat r = 1 / (mem + 1);
-
-    g = (1 - r) % g;
-    g += r % gradient;
-
-    g2 = (1 - r) % g2;
-    g2 += r % (gradient % gradient);
-
-    arma::mat x = (g % g) / (g2 + epsilon);
-
-    x.transform( [stepSize](double &v) { return std::min(v, stepSize); } );
-
-    iterate -= gradient % x / (arma::sqrt(g2) + epsilon);
-
-    mem %= (1 - x);
-    mem += 1;
-  }
-
   //! Get the value used to initialise the mean squared gradient parameter.
   double Epsilon() const { return epsilon; }
   //! Modify the value used to initialise the mean squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.  It initialises the parameters mem, g
+     * and g2.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(SMORMS3Update& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        mem(arma::ones<MatType>(rows, cols)),
+        g(arma::zeros<MatType>(rows, cols)),
+        g2(arma::zeros<MatType>(rows, cols))
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      mem.ones(rows, cols);
+      g.zeros(rows, cols);
+      g2.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for SMORMS3.
+     *
+     * @param iterate Parameter that minimizes the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      // Update the iterate.
+      MatType r = 1 / (mem + 1);
+
+      g = (1 - r) % g;
+      g += r % gradient;
+
+      g2 = (1 - r) % g2;
+      g2 += r % (gradient % gradient);
+
+      MatType x = (g % g) / (g2 + parent.epsilon);
+
+      const ElemType maxStep = ElemType(stepSize);
+      x.transform( [maxStep](ElemType &v) { return std::min(v, maxStep); } );
+
+      iterate -= gradient % x / (arma::sqrt(g2) + parent.epsilon);
+
+      mem %= (1 - x);
+      mem += 1;
+    }
+
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("mem", mem);
+      state.Set("g", g);
+      state.Set("g2", g2);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("mem", mem);
+      state.Get("g", g);
+      state.Get("g2", g2);
+    }
+
+   private:
+    // Instantiated parent object.
+    SMORMS3Update& parent;
+
+    // The parameters mem, g and g2.
+    MatType mem, g, g2;
+  };
+
  private:
   //! The value used to initialise the mean squared gradient parameter.
   double epsilon;
-
-  // The parameters mem, g and g2.
-  arma::mat mem, g, g2;
 };
 
 } // namespace ens
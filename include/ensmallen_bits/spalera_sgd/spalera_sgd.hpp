@@ -96,6 +96,11 @@ class SPALeRASGD
    * @param decayPolicy Instantiated decay policy used to adjust the step size.
    * @param resetPolicy Flag that determines whether update policy parameters
    *    are reset before every Optimize call.
+   * @param exactObjective If true, the objective of the starting point and of
+   *    the final point are computed with extra passes over all functions;
+   *    otherwise, the starting objective is estimated on the first batch, and
+   *    the objective accumulated during the last epoch is returned (scaled to
+   *    all functions if the epoch is not complete).
    */
   SPALeRASGD(const double stepSize = 0.01,
              const size_t batchSize = 32,
@@ -107,7 +112,8 @@ class SPALeRASGD
              const double adaptRate = 3.10e-8,
              const bool shuffle = true,
              const DecayPolicyType& decayPolicy = DecayPolicyType(),
-             const bool resetPolicy = true);
+             const bool resetPolicy = true,
+             const bool exactObjective = true);
 
   /**
    * Optimize the given function using SPALeRA SGD.  The given starting point
@@ -174,6 +180,15 @@ class SPALeRASGD
   //! Modify the decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get whether or not the bookend objectives are computed with extra passes.
+  bool ExactObjective() const { return exactObjective; }
+  //! Modify whether or not the bookend objectives are computed with extra
+  //! passes.
+  bool& ExactObjective() { return exactObjective; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -203,6 +218,13 @@ class SPALeRASGD
   //! Flag that determines whether update policy parameters
   //! are reset before every Optimize call.
   bool resetPolicy;
+
+  //! Controls whether or not the objectives of the starting and final points
+  //! are computed with extra passes over all functions.
+  bool exactObjective;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 } // namespace ens
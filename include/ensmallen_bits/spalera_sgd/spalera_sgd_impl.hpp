@@ -30,7 +30,8 @@ SPALeRASGD<DecayPolicyType>::SPALeRASGD(const double stepSize,
                                         const double adaptRate,
                                         const bool shuffle,
                                         const DecayPolicyType& decayPolicy,
-                                        const bool resetPolicy) :
+                                        const bool resetPolicy,
+                                        const bool exactObjective) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
@@ -39,7 +40,8 @@ SPALeRASGD<DecayPolicyType>::SPALeRASGD(const double stepSize,
     shuffle(shuffle),
     updatePolicy(SPALeRAStepsize(alpha, epsilon, adaptRate)),
     decayPolicy(decayPolicy),
-    resetPolicy(resetPolicy)
+    resetPolicy(resetPolicy),
+    exactObjective(exactObjective)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -48,6 +50,8 @@ template<typename DecomposableFunctionType>
 double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
                                              arma::mat& iterate)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
   typedef Function<DecomposableFunctionType> FullFunctionType;
   FullFunctionType& f(static_cast<FullFunctionType&>(function));
 
@@ -61,11 +65,21 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
   double overallObjective = 0;
   double lastObjective = DBL_MAX;
 
-  // Calculate the first objective function.
-  for (size_t i = 0; i < numFunctions; i += batchSize)
+  // Calculate the first objective function, or estimate it on the first
+  // batch.
+  if (exactObjective)
   {
-    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    for (size_t i = 0; i < numFunctions; i += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+      overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    }
+  }
+  else
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions);
+    overallObjective = f.Evaluate(iterate, 0, effectiveBatchSize) *
+        numFunctions / effectiveBatchSize;
   }
 
   double currentObjective = overallObjective / numFunctions;
@@ -87,12 +101,12 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
     if ((currentFunction % numFunctions) == 0)
     {
       // Output current objective function.
-      Info << "SPALeRA SGD: iteration " << i << ", objective "
+      ENS_INFO << "SPALeRA SGD: iteration " << i << ", objective "
           << overallObjective << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
-        Warn << "SPALeRA SGD: converged to " << overallObjective
+        ENS_WARN << "SPALeRA SGD: converged to " << overallObjective
             << "; terminating with failure.  Try a smaller step size?"
             << std::endl;
         return overallObjective;
@@ -100,7 +114,7 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
 
       if (std::abs(lastObjective - overallObjective) < tolerance)
       {
-        Info << "SPALeRA SGD: minimized within tolerance " << tolerance
+        ENS_INFO << "SPALeRA SGD: minimized within tolerance " << tolerance
             << "; terminating optimization." << std::endl;
         return overallObjective;
       }
@@ -132,7 +146,7 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
     if (!updatePolicy.Update(stepSize, currentObjective, effectiveBatchSize,
         numFunctions, iterate, gradient))
     {
-      Warn << "SPALeRA SGD: converged to " << overallObjective << "; "
+      ENS_WARN << "SPALeRA SGD: converged to " << overallObjective << "; "
           << "terminating with failure.  Try a smaller step size?"
           << std::endl;
       return overallObjective;
@@ -147,9 +161,14 @@ double SPALeRASGD<DecayPolicyType>::Optimize(DecomposableFunctionType& function,
     currentObjective /= effectiveBatchSize;
   }
 
-  Info << "SPALeRA SGD: maximum iterations (" << maxIterations
+  ENS_INFO << "SPALeRA SGD: maximum iterations (" << maxIterations
       << ") reached; terminating optimization." << std::endl;
 
+  // The objective of the last epoch is a cheaper estimate of the final
+  // objective, if the user allows it.
+  if (!exactObjective && currentFunction > 0)
+    return overallObjective * numFunctions / currentFunction;
+
   // Calculate final objective.
   overallObjective = 0;
   for (size_t i = 0; i < numFunctions; i += batchSize)
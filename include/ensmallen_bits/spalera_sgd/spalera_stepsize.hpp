@@ -67,8 +67,12 @@ class SPALeRAStepsize
    */
   void Initialize(const size_t rows, const size_t cols, const double lambda)
   {
-    learningRates = arma::ones(rows, cols);
-    relaxedSums = arma::zeros(rows, cols);
+    // Place the state like the update policies do; the learning rates start
+    // at one.
+    FirstTouchZeros(learningRates, rows, cols);
+    learningRates.ones();
+    FirstTouchZeros(relaxedSums, rows, cols);
+    previousIterate.set_size(rows, cols);
 
     this->lambda = lambda;
 
@@ -129,9 +133,20 @@ class SPALeRAStepsize
 
       // Dividing learning rates by 2 as proposed in:
       // Stochastic Gradient Descent: Going As Fast As Possible But Not Faster.
-      learningRates /= 2;
-
-      if (arma::any(arma::vectorise(learningRates) <= 1e-15))
+      // The learning rates that are too low are counted in the same pass.
+      double* lr = learningRates.memptr();
+      double tooLow[1];
+      ElementwiseSums(learningRates.n_elem, [&](const size_t begin,
+          const size_t end, double* partial)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          lr[i] /= 2;
+          partial[0] += (lr[i] <= 1e-15) ? 1.0 : 0.0;
+        }
+      }, tooLow);
+
+      if (tooLow[0] > 0.0)
       {
         // Stop because learning rate too low.
         return false;
@@ -148,18 +163,36 @@ class SPALeRAStepsize
       const double paramStd = (alpha / std::sqrt(iterate.n_elem)) /
           std::sqrt(iterate.n_elem);
 
-      const double normGradient = std::sqrt(arma::accu(arma::pow(gradient, 2)));
-
-      relaxedSums *= (1 - alpha);
-      if (normGradient > epsilon)
-        relaxedSums += gradient * (alpha / normGradient);
-
-      learningRates %= arma::exp((arma::pow(relaxedSums, 2) - paramMean) *
-          (adaptRate / paramStd));
-
-      previousIterate = iterate;
-
-      iterate -= stepSize * (learningRates % gradient);
+      const double* g = gradient.memptr();
+      double sumSquares[1];
+      ElementwiseSums(gradient.n_elem, [&](const size_t begin,
+          const size_t end, double* partial)
+      {
+        for (size_t i = begin; i < end; ++i)
+          partial[0] += g[i] * g[i];
+      }, sumSquares);
+      const double normGradient = std::sqrt(sumSquares[0]);
+
+      // Update the relaxed sums and the learning rates, keep the previous
+      // iterate for backtracking, and take the step, in a single pass.
+      const double decay = 1 - alpha;
+      const double gradientScale = (normGradient > epsilon) ?
+          alpha / normGradient : 0.0;
+      const double rateScale = adaptRate / paramStd;
+      double* r = relaxedSums.memptr();
+      double* lr = learningRates.memptr();
+      double* x = iterate.memptr();
+      double* previous = previousIterate.memptr();
+      Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          r[i] = decay * r[i] + gradientScale * g[i];
+          lr[i] *= std::exp((r[i] * r[i] - paramMean) * rateScale);
+          previous[i] = x[i];
+          x[i] -= stepSize * (lr[i] * g[i]);
+        }
+      });
 
       // Keep track of the the number of evaluations and Page-Hinkley steps.
       eveCounter++;
@@ -0,0 +1,191 @@
+/**
+ * @file sqn.hpp
+ * @author Marcus Edel
+ *
+ * Stochastic quasi-Newton (SQN) optimizer with averaged curvature pairs.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SQN_SQN_HPP
+#define ENSMALLEN_SQN_SQN_HPP
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/lbfgs/history_kernels.hpp>
+
+namespace ens {
+
+/**
+ * SQN is a stochastic limited-memory BFGS method for functions which can be
+ * expressed as a sum of other functions,
+ *
+ * \f[
+ * f(A) = \sum_{i = 0}^{n} f_i(A).
+ * \f]
+ *
+ * Each step is \f$ A \leftarrow A - \alpha H g \f$, where g is the gradient of
+ * a batch and H the L-BFGS approximation of the inverse Hessian, applied with
+ * the same two-loop recursion as L_BFGS.  To keep the curvature information
+ * stable despite the noise of the batch gradients, the curvature pairs are
+ * only formed every updateInterval steps, from the averages of the iterates
+ * of the last two intervals: s is the difference of the averages, and y the
+ * difference of the gradients at the two averages on a separate (larger)
+ * batch of hessianBatchSize functions.  The cost per step is therefore that of
+ * SGD plus the two-loop recursion, O(numBasis) passes over the iterate.  For
+ * more information, see the following.
+ *
+ * @code
+ * @article{Byrd2016,
+ *   author  = {Byrd, Richard H. and Hansen, Samantha L. and Nocedal, Jorge and
+ *              Singer, Yoram},
+ *   title   = {A Stochastic Quasi-Newton Method for Large-Scale
+ *              Optimization},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {26},
+ *   number  = {2},
+ *   pages   = {1008--1031},
+ *   year    = {2016}
+ * }
+ * @endcode
+ *
+ * Until the first curvature pair is available, the steps are plain SGD steps.
+ *
+ * SQN can optimize differentiable separable functions.  For more details, see
+ * the documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class SQN
+{
+ public:
+  /**
+   * Construct the SQN optimizer with the given parameters.  The maximum number
+   * of iterations refers to the maximum number of points that are processed
+   * (i.e., one iteration equals one point; one iteration does not equal one
+   * pass over the dataset).
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Size of each batch.
+   * @param hessianBatchSize Size of the batch used to form the curvature
+   *     pairs.
+   * @param updateInterval Number of steps between two curvature pairs.
+   * @param numBasis Number of curvature pairs to keep.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled after each pass;
+   *     otherwise, the functions are visited in linear order.
+   */
+  SQN(const double stepSize = 0.1,
+      const size_t batchSize = 32,
+      const size_t hessianBatchSize = 256,
+      const size_t updateInterval = 10,
+      const size_t numBasis = 10,
+      const size_t maxIterations = 100000,
+      const double tolerance = 1e-5,
+      const bool shuffle = true);
+
+  /**
+   * Optimize the given function using SQN.  The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch of SQN is
+   * one pass over the functions.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the batch size of the curvature pairs.
+  size_t HessianBatchSize() const { return hessianBatchSize; }
+  //! Modify the batch size of the curvature pairs.
+  size_t& HessianBatchSize() { return hessianBatchSize; }
+
+  //! Get the number of steps between two curvature pairs.
+  size_t UpdateInterval() const { return updateInterval; }
+  //! Modify the number of steps between two curvature pairs.
+  size_t& UpdateInterval() { return updateInterval; }
+
+  //! Get the number of curvature pairs to keep.
+  size_t NumBasis() const { return numBasis; }
+  //! Modify the number of curvature pairs to keep.
+  size_t& NumBasis() { return numBasis; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the number of curvature pairs formed in the last call to Optimize().
+  size_t Pairs() const { return pairs; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The size of each batch.
+  size_t batchSize;
+
+  //! The size of the batch of the curvature pairs.
+  size_t hessianBatchSize;
+
+  //! The number of steps between two curvature pairs.
+  size_t updateInterval;
+
+  //! The number of curvature pairs to keep.
+  size_t numBasis;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+
+  //! The number of curvature pairs formed in the last call to Optimize().
+  size_t pairs;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+} // namespace ens
+
+#include "sqn_impl.hpp"
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file binary_file_data_source.hpp
+ * @author Ryan Curtin
+ *
+ * A data source for StreamingFunction that reads points from a raw binary file
+ * on disk.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_BINARY_FILE_DATA_SOURCE_HPP
+#define ENSMALLEN_STREAMING_BINARY_FILE_DATA_SOURCE_HPP
+
+#include <fstream>
+
+namespace ens {
+
+/**
+ * BinaryFileDataSource reads points from a file of raw elements in column-major
+ * order, one point per column, without any header; this is the format written
+ * by Armadillo's save() with arma::raw_binary, e.g.
+ *
+ * @code
+ * data.save("points.bin", arma::raw_binary);
+ * BinaryFileDataSource<> source("points.bin", data.n_rows);
+ * @endcode
+ *
+ * Only the requested points are read from the file, so the file may be much
+ * larger than the available memory.  The number of rows has to be given, since
+ * it is not stored in the file.
+ *
+ * @tparam ElemType Type of the elements stored in the file.
+ */
+template<typename ElemType = double>
+class BinaryFileDataSource
+{
+ public:
+  //! The type of the loaded blocks.
+  typedef arma::Mat<ElemType> BatchType;
+
+  /**
+   * Open the given file.  An exception is thrown if the file cannot be opened,
+   * or if its size is not a multiple of the size of one point.
+   *
+   * @param filename Name of the file to read.
+   * @param rows Number of elements of each point.
+   */
+  BinaryFileDataSource(const std::string& filename, const size_t rows) :
+      filename(filename),
+      rows(rows),
+      numPoints(0),
+      stream(filename.c_str(), std::ios::in | std::ios::binary)
+  {
+    if (!stream.is_open())
+    {
+      std::ostringstream oss;
+      oss << "BinaryFileDataSource::BinaryFileDataSource(): cannot open '"
+          << filename << "'!";
+      throw std::runtime_error(oss.str());
+    }
+
+    if (rows == 0)
+    {
+      throw std::invalid_argument("BinaryFileDataSource::"
+          "BinaryFileDataSource(): the number of rows must be positive!");
+    }
+
+    stream.seekg(0, std::ios::end);
+    const size_t bytes = (size_t) stream.tellg();
+    const size_t pointBytes = rows * sizeof(ElemType);
+    if (bytes % pointBytes != 0)
+    {
+      std::ostringstream oss;
+      oss << "BinaryFileDataSource::BinaryFileDataSource(): size of '"
+          << filename << "' (" << bytes << " bytes) is not a multiple of the "
+          << "size of a point with " << rows << " elements!";
+      throw std::invalid_argument(oss.str());
+    }
+    numPoints = bytes / pointBytes;
+  }
+
+  //! Return the number of points in the file.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Return the number of elements of each point.
+  size_t Rows() const { return rows; }
+
+  //! Return the name of the file.
+  const std::string& Filename() const { return filename; }
+
+  /**
+   * Read the given number of points, starting from the given point.  This is
+   * not thread-safe; StreamingFunction never loads two blocks at once.
+   *
+   * @param begin Index of the first point to read.
+   * @param count Number of points to read.
+   * @param batch Matrix to store the points into.
+   */
+  void Load(const size_t begin, const size_t count, BatchType& batch)
+  {
+    batch.set_size(rows, count);
+
+    stream.clear();
+    stream.seekg(begin * rows * sizeof(ElemType), std::ios::beg);
+    stream.read(reinterpret_cast<char*>(batch.memptr()),
+        count * rows * sizeof(ElemType));
+    if (!stream)
+    {
+      std::ostringstream oss;
+      oss << "BinaryFileDataSource::Load(): cannot read points " << begin
+          << " to " << (begin + count - 1) << " of '" << filename << "'!";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The number of elements of each point.
+  size_t rows;
+  //! The number of points in the file.
+  size_t numPoints;
+  //! The open file.
+  std::ifstream stream;
+};
+
+} // namespace ens
+
+#endif
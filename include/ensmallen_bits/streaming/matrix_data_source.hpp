@@ -0,0 +1,62 @@
+/**
+ * @file matrix_data_source.hpp
+ * @author Ryan Curtin
+ *
+ * A data source for StreamingFunction that serves the columns of a matrix held
+ * in memory.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_MATRIX_DATA_SOURCE_HPP
+#define ENSMALLEN_STREAMING_MATRIX_DATA_SOURCE_HPP
+
+namespace ens {
+
+/**
+ * MatrixDataSource serves the points of a matrix held in memory, one point per
+ * column.  The matrix is not copied, so it must outlive the data source.  This
+ * is mostly useful to test a StreamingFunction before pointing it at a file,
+ * or to reuse the same batch function for data in memory and on disk.
+ *
+ * @tparam MatType Type of the matrix (and of the loaded blocks).
+ */
+template<typename MatType = arma::mat>
+class MatrixDataSource
+{
+ public:
+  //! The type of the loaded blocks.
+  typedef MatType BatchType;
+
+  /**
+   * Serve the columns of the given matrix.
+   *
+   * @param data Matrix of points, one point per column.
+   */
+  MatrixDataSource(const MatType& data) : data(data) { }
+
+  //! Return the number of points.
+  size_t NumPoints() const { return data.n_cols; }
+
+  /**
+   * Load the given number of points, starting from the given point.
+   *
+   * @param begin Index of the first point to load.
+   * @param count Number of points to load.
+   * @param batch Matrix to store the points into.
+   */
+  void Load(const size_t begin, const size_t count, BatchType& batch) const
+  {
+    batch = data.cols(begin, begin + count - 1);
+  }
+
+ private:
+  //! The matrix of points.
+  const MatType& data;
+};
+
+} // namespace ens
+
+#endif
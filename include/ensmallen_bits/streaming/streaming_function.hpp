@@ -0,0 +1,215 @@
+/**
+ * @file streaming_function.hpp
+ * @author Ryan Curtin
+ *
+ * A decomposable function over a dataset that is not held in memory, but read
+ * block by block from a data source, with the next block read in the
+ * background while the current one is used.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_STREAMING_FUNCTION_HPP
+#define ENSMALLEN_STREAMING_STREAMING_FUNCTION_HPP
+
+#include <future>
+#include <memory>
+
+#include "matrix_data_source.hpp"
+#include "binary_file_data_source.hpp"
+
+namespace ens {
+
+/**
+ * StreamingFunction presents a dataset that may be much larger than the
+ * available memory as a decomposable function, so that it can be optimized
+ * with SGD and the optimizers built on it (SGDR, SnapshotSGDR, Adam, ...) as
+ * well as BigBatchSGD.  The points are read from a data source in blocks of
+ * blockSize points, and only two blocks are held in memory at once: while the
+ * optimizer uses the current block, the next one is read in the background.
+ *
+ * The data source must have the following API:
+ *
+ * @code
+ * // The type of a loaded block: a dense Armadillo matrix with one point per
+ * // column.
+ * typedef arma::mat BatchType;
+ *
+ * // Return the number of points.
+ * size_t NumPoints() const;
+ *
+ * // Store the points begin, ..., begin + count - 1 in batch.
+ * void Load(const size_t begin, const size_t count, BatchType& batch);
+ * @endcode
+ *
+ * MatrixDataSource and BinaryFileDataSource are provided.  The objective is
+ * given by a batch function that is evaluated on the points of a batch:
+ *
+ * @code
+ * // Return the objective of the points in batch.
+ * double Evaluate(const arma::mat& coordinates, const BatchType& batch);
+ *
+ * // Return the objective of the points in batch, and store its gradient.
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const BatchType& batch,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * Gradient() is computed with EvaluateWithGradient() of the batch function.
+ * A batch that lies inside one block is passed to the batch function without
+ * copying; a batch that spans two blocks is gathered first.  Shuffle()
+ * shuffles the order of the blocks, but the points inside a block are always
+ * visited in the order of the data source, so the data should not be sorted
+ * and blockSize should be small compared to the number of points.
+ *
+ * The function is not thread-safe, so it cannot be used with the
+ * ParallelBatch() option of SGD.
+ *
+ * @tparam DataSourceType Type of the data source.
+ * @tparam BatchFunctionType Type of the batch function.
+ */
+template<typename DataSourceType, typename BatchFunctionType>
+class StreamingFunction
+{
+ public:
+  //! The type of a loaded block.
+  typedef typename DataSourceType::BatchType BatchType;
+
+  /**
+   * Create the function over the given data source.  Neither the data source
+   * nor the batch function are copied, so they must outlive this object.
+   *
+   * @param source Data source to read the points from.
+   * @param batchFunction Function to evaluate on each batch.
+   * @param blockSize Number of points read from the data source at once.
+   * @param prefetch If true, the next block is read in the background.
+   */
+  StreamingFunction(DataSourceType& source,
+                    BatchFunctionType& batchFunction,
+                    const size_t blockSize = 65536,
+                    const bool prefetch = true);
+
+  //! Wait for the block being read in the background, if any.
+  ~StreamingFunction();
+
+  //! Return the number of separable functions (the number of points).
+  size_t NumFunctions() const { return source.NumPoints(); }
+
+  //! Shuffle the order in which the blocks are visited.
+  void Shuffle();
+
+  /**
+   * Evaluate the batch function on the given batch, starting from the given
+   * point.
+   *
+   * @param coordinates The point at which to evaluate the function.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize);
+
+  /**
+   * Evaluate the gradient of the batch function on the given batch, starting
+   * from the given point.
+   *
+   * @param coordinates The point at which to evaluate the gradient.
+   * @param begin Index of the first point of the batch.
+   * @param gradient Matrix to store the gradient into.
+   * @param batchSize Number of points in the batch.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize);
+
+  /**
+   * Evaluate the batch function and its gradient on the given batch, starting
+   * from the given point.
+   *
+   * @param coordinates The point at which to evaluate the function.
+   * @param begin Index of the first point of the batch.
+   * @param gradient Matrix to store the gradient into.
+   * @param batchSize Number of points in the batch.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   const size_t begin,
+                                                   GradType& gradient,
+                                                   const size_t batchSize);
+
+  //! Get the number of points read from the data source at once.
+  size_t BlockSize() const { return blockSize; }
+
+  //! Get whether the next block is read in the background.
+  bool Prefetch() const { return prefetch; }
+  //! Modify whether the next block is read in the background.
+  bool& Prefetch() { return prefetch; }
+
+ private:
+  /**
+   * Get the given batch; if it lies inside one block, the returned matrix is
+   * an alias of the block.  It is valid until the next call.
+   */
+  const BatchType& GetBatch(const size_t begin, const size_t batchSize);
+
+  //! Get the block at the given position of the visitation order.
+  const BatchType& GetBlock(const size_t position);
+
+  //! Start reading the block at the given position in the background.
+  void StartPrefetch(const size_t position);
+
+  //! Wait for the block being read in the background, if any.
+  void WaitPrefetch();
+
+  //! Read the given block from the data source.
+  void LoadBlock(const size_t block, BatchType& data);
+
+  //! Find the position of the block holding the given point.
+  size_t Position(const size_t point) const;
+
+  //! Compute the first point of each position of the visitation order.
+  void ComputeStarts();
+
+  //! The data source.
+  DataSourceType& source;
+  //! The batch function.
+  BatchFunctionType& batchFunction;
+  //! The number of points read at once.
+  size_t blockSize;
+  //! Whether the next block is read in the background.
+  bool prefetch;
+
+  //! The blocks in the order of visitation.
+  arma::uvec order;
+  //! The first point of each position of the visitation order.
+  arma::uvec starts;
+
+  //! The index of the current block, if there is one.
+  size_t currentBlock;
+  //! The current block.
+  BatchType current;
+  //! The index of the next block, if there is one.
+  size_t nextBlock;
+  //! The next block; only valid once the background read is done.
+  BatchType next;
+  //! The background read of the next block.
+  std::future<void> pending;
+
+  //! The alias of the last batch, if it lies inside one block.
+  std::unique_ptr<BatchType> view;
+  //! The last batch, if it spans several blocks.
+  BatchType gathered;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "streaming_function_impl.hpp"
+
+#endif
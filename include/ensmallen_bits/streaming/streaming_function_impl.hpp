@@ -0,0 +1,237 @@
+/**
+ * @file streaming_function_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of StreamingFunction.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_STREAMING_STREAMING_FUNCTION_IMPL_HPP
+#define ENSMALLEN_STREAMING_STREAMING_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "streaming_function.hpp"
+
+#include <algorithm>
+
+namespace ens {
+
+template<typename DataSourceType, typename BatchFunctionType>
+StreamingFunction<DataSourceType, BatchFunctionType>::StreamingFunction(
+    DataSourceType& source,
+    BatchFunctionType& batchFunction,
+    const size_t blockSize,
+    const bool prefetch) :
+    source(source),
+    batchFunction(batchFunction),
+    blockSize(blockSize),
+    prefetch(prefetch),
+    currentBlock(std::numeric_limits<size_t>::max()),
+    nextBlock(std::numeric_limits<size_t>::max())
+{
+  if (blockSize == 0)
+  {
+    throw std::invalid_argument("StreamingFunction::StreamingFunction(): "
+        "blockSize must be positive!");
+  }
+
+  const size_t numBlocks = (source.NumPoints() + blockSize - 1) / blockSize;
+  order = arma::linspace<arma::uvec>(0, numBlocks - 1, numBlocks);
+  ComputeStarts();
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+StreamingFunction<DataSourceType, BatchFunctionType>::~StreamingFunction()
+{
+  // Errors of a read nobody asked for are ignored.
+  if (pending.valid())
+    pending.wait();
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::Shuffle()
+{
+  Random().Shuffle(order);
+  ComputeStarts();
+
+  // The next epoch starts with the new first block.
+  if (prefetch && order.n_elem > 0)
+    StartPrefetch(0);
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+template<typename MatType>
+typename MatType::elem_type
+StreamingFunction<DataSourceType, BatchFunctionType>::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize)
+{
+  return batchFunction.Evaluate(coordinates, GetBatch(begin, batchSize));
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+template<typename MatType, typename GradType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  batchFunction.EvaluateWithGradient(coordinates, GetBatch(begin, batchSize),
+      gradient);
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+template<typename MatType, typename GradType>
+typename MatType::elem_type
+StreamingFunction<DataSourceType, BatchFunctionType>::EvaluateWithGradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize)
+{
+  return batchFunction.EvaluateWithGradient(coordinates,
+      GetBatch(begin, batchSize), gradient);
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+const typename StreamingFunction<DataSourceType, BatchFunctionType>::BatchType&
+StreamingFunction<DataSourceType, BatchFunctionType>::GetBatch(
+    const size_t begin,
+    const size_t batchSize)
+{
+  typedef typename BatchType::elem_type ElemType;
+
+  size_t position = Position(begin);
+  size_t offset = begin - starts[position];
+  const BatchType& block = GetBlock(position);
+
+  // The common case: the batch lies inside the block, so it is only aliased.
+  // We promise to be well-behaved... the elements won't be modified.
+  if (offset + batchSize <= block.n_cols)
+  {
+    view.reset(new BatchType(const_cast<ElemType*>(block.colptr(offset)),
+        block.n_rows, batchSize, false, true));
+    return *view;
+  }
+
+  // Otherwise gather the batch from consecutive blocks.
+  gathered.set_size(block.n_rows, batchSize);
+  size_t filled = 0;
+  while (filled < batchSize)
+  {
+    const BatchType& b = GetBlock(position);
+    const size_t count = std::min((size_t) b.n_cols - offset,
+        batchSize - filled);
+    gathered.cols(filled, filled + count - 1) =
+        b.cols(offset, offset + count - 1);
+
+    filled += count;
+    offset = 0;
+    ++position;
+  }
+
+  return gathered;
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+const typename StreamingFunction<DataSourceType, BatchFunctionType>::BatchType&
+StreamingFunction<DataSourceType, BatchFunctionType>::GetBlock(
+    const size_t position)
+{
+  const size_t block = order[position];
+  if (block != currentBlock)
+  {
+    WaitPrefetch();
+    if (block == nextBlock)
+    {
+      // The block was read in the background.
+      current.swap(next);
+      std::swap(currentBlock, nextBlock);
+    }
+    else
+    {
+      LoadBlock(block, current);
+      currentBlock = block;
+    }
+
+    // The optimizer usually needs the following block next.
+    if (prefetch)
+      StartPrefetch((position + 1) % order.n_elem);
+  }
+
+  return current;
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::StartPrefetch(
+    const size_t position)
+{
+  const size_t block = order[position];
+  if (block == currentBlock || block == nextBlock)
+    return;
+
+  // The data source is only used by one thread at a time.
+  WaitPrefetch();
+  nextBlock = block;
+  pending = std::async(std::launch::async, [this, block]()
+  {
+    LoadBlock(block, next);
+  });
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::WaitPrefetch()
+{
+  if (pending.valid())
+  {
+    try
+    {
+      pending.get();
+    }
+    catch (...)
+    {
+      // The block could not be read, so it will be read again when needed.
+      nextBlock = std::numeric_limits<size_t>::max();
+      throw;
+    }
+  }
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::LoadBlock(
+    const size_t block,
+    BatchType& data)
+{
+  const size_t begin = block * blockSize;
+  source.Load(begin, std::min(blockSize, source.NumPoints() - begin), data);
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+size_t StreamingFunction<DataSourceType, BatchFunctionType>::Position(
+    const size_t point) const
+{
+  return (std::upper_bound(starts.begin(), starts.end(), point) -
+      starts.begin()) - 1;
+}
+
+template<typename DataSourceType, typename BatchFunctionType>
+void StreamingFunction<DataSourceType, BatchFunctionType>::ComputeStarts()
+{
+  starts.set_size(order.n_elem);
+  size_t start = 0;
+  for (size_t i = 0; i < order.n_elem; ++i)
+  {
+    const size_t blockStart = order[i] * blockSize;
+    starts[i] = start;
+    start += std::min(blockSize, source.NumPoints() - blockStart);
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,246 @@
+/**
+ * @file async_svrg.hpp
+ * @author Marcus Edel
+ *
+ * Asynchronous parallel stochastic variance reduced gradient, with lock-free
+ * inner iterations.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_ASYNC_SVRG_HPP
+#define ENSMALLEN_SVRG_ASYNC_SVRG_HPP
+
+#include <ensmallen_bits/executors/executors.hpp>
+
+#include "svrg_update.hpp"
+
+namespace ens {
+
+/**
+ * Asynchronous parallel SVRG runs the inner iterations of SVRG on several
+ * threads at once.  Every outer iteration computes the full gradient at the
+ * current iterate in parallel and stores the iterate as the snapshot; then each
+ * thread takes its own contiguous part of the inner batches and applies the
+ * variance reduced steps
+ *
+ *   A <- A - stepSize (mu + (g_batch(A) - g_batch(A_snapshot)) / b)
+ *
+ * to the shared iterate without any lock, as in HOGWILD!.  The threads only
+ * wait for each other between two outer iterations.
+ *
+ * The full gradient mu is dense, so a plain step costs O(d) even when the
+ * gradients of the batches are sparse.  With a sparse gradient type, the mu
+ * term is therefore applied lazily: each coordinate holds the index of the
+ * last step it was brought up to date at, and the skipped mu terms are added
+ * the next time a batch touches the coordinate, and for all coordinates at the
+ * end of the outer iteration.  Each step then costs O(nnz), and the iterate at
+ * the end of every outer iteration is the same as with the dense steps (up to
+ * the gradients being computed before the skipped terms of their coordinates
+ * are applied).  For more information, see the following.
+ *
+ * @code
+ * @inproceedings{reddi2015variance,
+ *   title     = {On Variance Reduction in Stochastic Gradient Descent and its
+ *                Asynchronous Variants},
+ *   author    = {Reddi, Sashank J. and Hefny, Ahmed and Sra, Suvrit and
+ *                Poczos, Barnabas and Smola, Alexander J.},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {2647--2655},
+ *   year      = {2015}
+ * }
+ *
+ * @article{mania2017perturbed,
+ *   title   = {Perturbed Iterate Analysis for Asynchronous Stochastic
+ *              Optimization},
+ *   author  = {Mania, Horia and Pan, Xinghao and Papailiopoulos, Dimitris and
+ *              Recht, Benjamin and Ramchandran, Kannan and Jordan, Michael I.},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {27},
+ *   number  = {4},
+ *   pages   = {2202--2229},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * The dense steps are those of SVRGUpdate.  With a parallel executor, the
+ * function must be safe to evaluate from several threads at once.
+ *
+ * AsyncSVRG can optimize sparse differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam ExecutorType Executor that runs the threads (see SerialExecutor,
+ *     OpenMPExecutor, and ThreadPoolExecutor).
+ */
+template<typename ExecutorType = OpenMPExecutor>
+class AsyncSVRGType
+{
+ public:
+  /**
+   * Construct the asynchronous SVRG optimizer with the given parameters.  The
+   * defaults here are not necessarily good for the given problem, so it is
+   * suggested that the values used be tailored to the task at hand.
+   *
+   * @param stepSize Step size for each inner iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of outer iterations allowed (0 means
+   *     no limit).
+   * @param innerIterations Number of functions visited by all the threads
+   *     together in each outer iteration (0 means the number of functions).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the batches are visited in a new random order in
+   *     every outer iteration; otherwise, in linear order.
+   * @param executor The executor that runs the threads; each thread of an
+   *     outer iteration is one task of the executor.
+   */
+  AsyncSVRGType(const double stepSize = 0.01,
+                const size_t batchSize = 32,
+                const size_t maxIterations = 1000,
+                const size_t innerIterations = 0,
+                const double tolerance = 1e-5,
+                const bool shuffle = true,
+                const ExecutorType& executor = ExecutorType());
+
+  /**
+   * Optimize the given function using asynchronous SVRG.  The given starting
+   * point will be modified to store the finishing point of the algorithm, and
+   * the final objective value is returned.  By default the gradient is sparse
+   * and the full gradient term is applied lazily; a dense GradType can be
+   * specified explicitly for functions that only provide a dense Gradient().
+   *
+   * @tparam SparseFunctionType Type of function to be optimized.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param function Function to be optimized (minimized).
+   * @param iterate Starting point (will be modified).
+   * @return Objective value at the final point.
+   */
+  template<typename SparseFunctionType, typename GradType = arma::sp_mat>
+  double Optimize(SparseFunctionType& function, arma::mat& iterate);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of outer iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of outer iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of inner iterations (0 indicates the number of functions).
+  size_t InnerIterations() const { return innerIterations; }
+  //! Modify the number of inner iterations (0 indicates the number of
+  //! functions).
+  size_t& InnerIterations() { return innerIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the batches are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the batches are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the executor.
+  const ExecutorType& Executor() const { return executor; }
+  //! Modify the executor.
+  ExecutorType& Executor() { return executor; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  /**
+   * Compute the sum of the objectives and the mean of the gradients of all the
+   * functions at the given iterate.  Each thread sums a contiguous part of the
+   * batches into its own buffer, and the buffers are added in order, so the
+   * result only depends on the number of threads.
+   */
+  template<typename FunctionType, typename GradType>
+  double EvaluateFullGradient(FunctionType& function,
+                              const arma::mat& iterate,
+                              arma::mat& fullGradient,
+                              std::vector<arma::mat>& shareGradients,
+                              std::vector<GradType>& gradients);
+
+  /**
+   * Take the variance reduced step of a batch on the non-zero coordinates of
+   * its sparse gradients, after bringing the full gradient term of these
+   * coordinates up to the given step.
+   */
+  template<typename eT>
+  void Step(arma::mat& iterate,
+            const arma::mat& fullGradient,
+            arma::mat& lastStep,
+            const double step,
+            const arma::SpMat<eT>& gradient,
+            const arma::SpMat<eT>& gradient0,
+            const size_t effectiveBatchSize);
+
+  /**
+   * Take the dense variance reduced step of a batch with SVRGUpdate.
+   */
+  template<typename DenseGradType>
+  void Step(arma::mat& iterate,
+            const arma::mat& fullGradient,
+            arma::mat& lastStep,
+            const double step,
+            const DenseGradType& gradient,
+            const DenseGradType& gradient0,
+            const size_t effectiveBatchSize);
+
+  //! Bring the full gradient term of every coordinate up to the given step.
+  void SynchronizeIterate(arma::mat& iterate,
+                          const arma::mat& fullGradient,
+                          arma::mat& lastStep,
+                          const double step) const;
+
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed outer iterations.
+  size_t maxIterations;
+
+  //! The number of functions visited in each outer iteration.
+  size_t innerIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the batches are shuffled.
+  bool shuffle;
+
+  //! The executor that runs the threads.
+  ExecutorType executor;
+
+  //! The update policy of the dense steps.
+  SVRGUpdate updatePolicy;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+/**
+ * Asynchronous SVRG with OpenMP threads.
+ */
+using AsyncSVRG = AsyncSVRGType<OpenMPExecutor>;
+
+} // namespace ens
+
+// Include implementation.
+#include "async_svrg_impl.hpp"
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * @file async_svrg_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of asynchronous parallel SVRG.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_ASYNC_SVRG_IMPL_HPP
+#define ENSMALLEN_SVRG_ASYNC_SVRG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "async_svrg.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<typename ExecutorType>
+AsyncSVRGType<ExecutorType>::AsyncSVRGType(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const size_t innerIterations,
+    const double tolerance,
+    const bool shuffle,
+    const ExecutorType& executor) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    innerIterations(innerIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    executor(executor)
+{ /* Nothing to do. */ }
+
+template<typename ExecutorType>
+template<typename SparseFunctionType, typename GradType>
+double AsyncSVRGType<ExecutorType>::Optimize(SparseFunctionType& function,
+                                             arma::mat& iterate)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // Check that we have all the functions that we need.
+  traits::CheckSparseFunctionTypeAPI<SparseFunctionType, arma::mat,
+      GradType>();
+
+  typedef Function<SparseFunctionType, arma::mat, GradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // The functions are visited in batches of batchSize consecutive functions;
+  // the last batch may be smaller.
+  const size_t numFunctions = f.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+
+  // Number of steps taken by all the threads together in each outer iteration.
+  const size_t innerFunctions = (innerIterations == 0) ? numFunctions :
+      innerIterations;
+  const size_t numInnerBatches = (innerFunctions + batchSize - 1) / batchSize;
+
+  // The order in which the batches will be visited; the inner iterations cycle
+  // through it.
+  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
+      (numBatches - 1), numBatches);
+
+  // The batches are shuffled with a random stream of this optimization.
+  RandomGenerator generator = NewRandomGenerator();
+
+  // Each thread processes a contiguous part of the inner batches, and keeps
+  // its gradient buffers over the whole optimization.
+  const size_t maxThreads = std::max(executor.Threads(), (size_t) 1);
+  const size_t numShares = std::min(maxThreads, numInnerBatches);
+  std::vector<GradType> gradients(maxThreads);
+  std::vector<GradType> gradients0(maxThreads);
+  std::vector<arma::mat> shareGradients(maxThreads);
+
+  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat iterate0(iterate.n_rows, iterate.n_cols);
+
+  // With sparse gradients, each coordinate holds the index of the last step
+  // whose full gradient term it has received.
+  arma::mat lastStep;
+  if (arma::is_arma_sparse_type<GradType>::value)
+    lastStep.zeros(iterate.n_rows, iterate.n_cols);
+
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations; ++i)
+  {
+    // Calculate the objective function and the full gradient in one pass.
+    overallObjective = EvaluateFullGradient(f, iterate, fullGradient,
+        shareGradients, gradients);
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      ENS_WARN << "AsyncSVRG: converged to " << overallObjective
+          << "; terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      ENS_INFO << "AsyncSVRG: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    lastObjective = overallObjective;
+
+    // Output current objective function.
+    ENS_INFO << "AsyncSVRG: iteration " << i << ", objective "
+        << overallObjective << "." << std::endl;
+
+    // Store the snapshot for the variance reduced gradients; the storage is
+    // allocated once, so this is a copy without allocation.
+    iterate0 = iterate;
+
+    if (shuffle)
+      generator.Shuffle(visitationOrder);
+
+    executor.Run(numShares, [&](const size_t share)
+    {
+      GradType& gradient = gradients[share];
+      GradType& gradient0 = gradients0[share];
+
+      const size_t shareEnd = (share + 1) * numInnerBatches / numShares;
+      for (size_t j = share * numInnerBatches / numShares; j < shareEnd; ++j)
+      {
+        const size_t begin = visitationOrder[j % numBatches] * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
+
+        // Calculate the variance reduced gradient; the iterate may be changed
+        // by the other threads meanwhile.
+        f.Gradient(iterate, begin, gradient, effectiveBatchSize);
+        f.Gradient(iterate0, begin, gradient0, effectiveBatchSize);
+
+        Step(iterate, fullGradient, lastStep, (double) (j + 1), gradient,
+            gradient0, effectiveBatchSize);
+      }
+    });
+
+    if (arma::is_arma_sparse_type<GradType>::value)
+    {
+      SynchronizeIterate(iterate, fullGradient, lastStep,
+          (double) numInnerBatches);
+      lastStep.zeros();
+    }
+  }
+
+  ENS_INFO << "AsyncSVRG: maximum iterations (" << maxIterations << ") "
+      << "reached; terminating optimization." << std::endl;
+
+  return f.Evaluate(iterate);
+}
+
+template<typename ExecutorType>
+template<typename FunctionType, typename GradType>
+double AsyncSVRGType<ExecutorType>::EvaluateFullGradient(
+    FunctionType& function,
+    const arma::mat& iterate,
+    arma::mat& fullGradient,
+    std::vector<arma::mat>& shareGradients,
+    std::vector<GradType>& gradients)
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t numShares = std::min(shareGradients.size(), numBatches);
+
+  std::vector<double> shareObjectives(numShares, 0.0);
+  executor.Run(numShares, [&](const size_t share)
+  {
+    shareGradients[share].zeros(iterate.n_rows, iterate.n_cols);
+
+    const size_t shareEnd = (share + 1) * numBatches / numShares;
+    for (size_t j = share * numBatches / numShares; j < shareEnd; ++j)
+    {
+      const size_t begin = j * batchSize;
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+
+      shareObjectives[share] += function.EvaluateWithGradient(iterate, begin,
+          gradients[share], effectiveBatchSize);
+      shareGradients[share] += gradients[share];
+    }
+  });
+
+  // Add the shares in order.
+  double objective = shareObjectives[0];
+  fullGradient = shareGradients[0];
+  for (size_t share = 1; share < numShares; ++share)
+  {
+    objective += shareObjectives[share];
+    fullGradient += shareGradients[share];
+  }
+  fullGradient /= (double) numFunctions;
+
+  return objective;
+}
+
+template<typename ExecutorType>
+template<typename eT>
+void AsyncSVRGType<ExecutorType>::Step(arma::mat& iterate,
+                                       const arma::mat& fullGradient,
+                                       arma::mat& lastStep,
+                                       const double step,
+                                       const arma::SpMat<eT>& gradient,
+                                       const arma::SpMat<eT>& gradient0,
+                                       const size_t effectiveBatchSize)
+{
+  // The steps and the indices of the last steps are updated without
+  // synchronization, as the iterate is.  Since the skipped terms are counted
+  // from the index stored in the coordinate, every coordinate has received
+  // all of them once it is synchronized at the end of the outer iteration.
+  const double scale = stepSize / (double) effectiveBatchSize;
+
+  typename arma::SpMat<eT>::const_iterator cur = gradient.begin();
+  for (; cur != gradient.end(); ++cur)
+  {
+    const size_t k = cur.row() + cur.col() * iterate.n_rows;
+    iterate[k] -= stepSize * fullGradient[k] * (step - lastStep[k]);
+    lastStep[k] = step;
+    iterate[k] -= scale * (*cur);
+  }
+
+  cur = gradient0.begin();
+  for (; cur != gradient0.end(); ++cur)
+  {
+    const size_t k = cur.row() + cur.col() * iterate.n_rows;
+    iterate[k] -= stepSize * fullGradient[k] * (step - lastStep[k]);
+    lastStep[k] = step;
+    iterate[k] += scale * (*cur);
+  }
+}
+
+template<typename ExecutorType>
+template<typename DenseGradType>
+void AsyncSVRGType<ExecutorType>::Step(arma::mat& iterate,
+                                       const arma::mat& fullGradient,
+                                       arma::mat& /* lastStep */,
+                                       const double /* step */,
+                                       const DenseGradType& gradient,
+                                       const DenseGradType& gradient0,
+                                       const size_t effectiveBatchSize)
+{
+  updatePolicy.Update(iterate, fullGradient, gradient, gradient0,
+      effectiveBatchSize, stepSize);
+}
+
+template<typename ExecutorType>
+void AsyncSVRGType<ExecutorType>::SynchronizeIterate(
+    arma::mat& iterate,
+    const arma::mat& fullGradient,
+    arma::mat& lastStep,
+    const double step) const
+{
+  for (size_t k = 0; k < iterate.n_elem; ++k)
+  {
+    iterate[k] -= stepSize * fullGradient[k] * (step - lastStep[k]);
+    lastStep[k] = step;
+  }
+}
+
+} // namespace ens
+
+#endif
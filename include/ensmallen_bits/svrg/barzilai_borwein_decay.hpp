@@ -77,17 +77,33 @@ class BarzilaiBorweinDecay
               const size_t numBatches,
               double& stepSize)
   {
-    if (!fullGradient0.is_empty())
+    if (fullGradient0.n_elem != fullGradient.n_elem)
     {
-      // Step size selection based on Barzilai-Borwein (BB).
-      stepSize = std::pow(arma::norm(iterate - iterate0), 2.0) /
-          (arma::dot(iterate - iterate0, fullGradient - fullGradient0) + eps) /
-          (double) numBatches;
+      // The first epoch: there is no previous full gradient yet.  The storage
+      // is allocated once and overwritten in the later epochs.
+      fullGradient0 = fullGradient;
+      return;
+    }
 
-      stepSize = std::min(stepSize, maxStepSize);
+    // Step size selection based on Barzilai-Borwein (BB).  Both reductions
+    // and the update of the stored full gradient are done in one pass, without
+    // temporaries.
+    const double* x = iterate.memptr();
+    const double* x0 = iterate0.memptr();
+    const double* g = fullGradient.memptr();
+    double* g0 = fullGradient0.memptr();
+    double squaredNorm = 0.0;
+    double curvature = 0.0;
+    for (size_t i = 0; i < fullGradient.n_elem; ++i)
+    {
+      const double step = x[i] - x0[i];
+      squaredNorm += step * step;
+      curvature += step * (g[i] - g0[i]);
+      g0[i] = g[i];
     }
 
-    fullGradient0 = std::move(fullGradient);
+    stepSize = squaredNorm / (curvature + eps) / (double) numBatches;
+    stepSize = std::min(stepSize, maxStepSize);
   }
 
  private:
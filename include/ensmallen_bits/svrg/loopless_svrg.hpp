@@ -0,0 +1,209 @@
+/**
+ * @file loopless_svrg.hpp
+ * @author Marcus Edel
+ *
+ * Loopless stochastic variance reduced gradient (L-SVRG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_LOOPLESS_SVRG_HPP
+#define ENSMALLEN_SVRG_LOOPLESS_SVRG_HPP
+
+#include "svrg_update.hpp"
+
+namespace ens {
+
+/**
+ * Loopless SVRG is a variant of stochastic variance reduced gradient without
+ * the outer loop: instead of recomputing the full gradient every fixed number
+ * of steps, the snapshot is moved to the current iterate with probability p
+ * after every step, and the full gradient is computed at the new snapshot.
+ * With p = batchSize / n a full gradient is computed once per pass over the
+ * data on average, but the steps do not have to be tuned to an epoch length.
+ * The step itself is that of SVRG, given by the update policy.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Kovalev2020,
+ *   author    = {Kovalev, Dmitry and Horv{\'a}th, Samuel and
+ *                Richt{\'a}rik, Peter},
+ *   title     = {Don't Jump Through Hoops and Remove Those Loops: {SVRG} and
+ *                {Katyusha} are Better Without the Outer Loop},
+ *   booktitle = {Proceedings of the 31st International Conference on
+ *                Algorithmic Learning Theory},
+ *   pages     = {451--467},
+ *   year      = {2020}
+ * }
+ * @endcode
+ *
+ * LooplessSVRG can optimize differentiable separable functions.  For more
+ * details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam UpdatePolicyType Update policy used to take a step, with the same
+ *     interface as SVRGUpdate.
+ */
+template<typename UpdatePolicyType = SVRGUpdate>
+class LooplessSVRGType
+{
+ public:
+  /**
+   * Construct the loopless SVRG optimizer with the given parameters.  The
+   * maximum number of iterations is the maximum number of steps, one batch
+   * each.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of steps allowed (0 means no limit).
+   * @param snapshotProbability Probability of moving the snapshot after each
+   *     step (0 means batchSize / n).
+   * @param tolerance Maximum absolute difference of the objective at two
+   *     successive snapshots to terminate the algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   * @param parallelFullGradient If true, compute the full gradient at each
+   *     snapshot with several OpenMP threads.
+   */
+  LooplessSVRGType(const double stepSize = 0.01,
+                   const size_t batchSize = 32,
+                   const size_t maxIterations = 100000,
+                   const double snapshotProbability = 0.0,
+                   const double tolerance = 1e-5,
+                   const bool shuffle = true,
+                   const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                   const bool resetPolicy = true,
+                   const bool parallelFullGradient = false);
+
+  /**
+   * Optimize the given function using loopless SVRG.  The given starting point
+   * will be modified to store the finishing point of the algorithm, and the
+   * final objective value is returned.
+   *
+   * Any number of callbacks may be given after the iterate; an epoch is the
+   * sequence of steps between two snapshots, and the objective and the
+   * gradient given to the callbacks are those of the snapshot.
+   *
+   * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of steps (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of steps (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the snapshot probability (0 indicates batchSize / n).
+  double SnapshotProbability() const { return snapshotProbability; }
+  //! Modify the snapshot probability (0 indicates batchSize / n).
+  double& SnapshotProbability() { return snapshotProbability; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get whether the full gradient is computed in parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether the full gradient is computed in parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get the number of full gradients computed by the last call to
+  //! Optimize().
+  size_t Snapshots() const { return snapshots; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed steps.
+  size_t maxIterations;
+
+  //! The probability of moving the snapshot after a step.
+  double snapshotProbability;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! Flag indicating whether update policy
+  //! should be reset before running optimization.
+  bool resetPolicy;
+
+  //! Whether to compute the full gradient in parallel.
+  bool parallelFullGradient;
+
+  //! The number of full gradients computed by the last call to Optimize().
+  size_t snapshots;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
+};
+
+// Convenience typedefs.
+
+/**
+ * Loopless stochastic variance reduced gradient.
+ */
+using LooplessSVRG = LooplessSVRGType<SVRGUpdate>;
+
+} // namespace ens
+
+// Include implementation.
+#include "loopless_svrg_impl.hpp"
+
+#endif
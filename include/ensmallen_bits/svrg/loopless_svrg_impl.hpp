@@ -0,0 +1,194 @@
+/**
+ * @file loopless_svrg_impl.hpp
+ * @author Marcus Edel
+ *
+ * Implementation of loopless stochastic variance reduced gradient (L-SVRG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SVRG_LOOPLESS_SVRG_IMPL_HPP
+#define ENSMALLEN_SVRG_LOOPLESS_SVRG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "loopless_svrg.hpp"
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType>
+LooplessSVRGType<UpdatePolicyType>::LooplessSVRGType(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double snapshotProbability,
+    const double tolerance,
+    const bool shuffle,
+    const UpdatePolicyType& updatePolicy,
+    const bool resetPolicy,
+    const bool parallelFullGradient) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    snapshotProbability(snapshotProbability),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicy(updatePolicy),
+    resetPolicy(resetPolicy),
+    parallelFullGradient(parallelFullGradient),
+    snapshots(0)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
+double LooplessSVRGType<UpdatePolicyType>::Optimize(
+    DecomposableFunctionType& function,
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
+{
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // If the function can be evaluated on any set of indices, we hold the order
+  // of visitation ourselves and the function never has to be shuffled.
+  typedef VisitationOrder<DecomposableFunctionType> VisitationOrderType;
+  VisitationOrderType order(function);
+  typedef Function<typename VisitationOrderType::VisitedType>
+      VisitedFunctionType;
+  VisitedFunctionType& visited(
+      static_cast<VisitedFunctionType&>(order.Get()));
+
+  // Find the number of functions to use.
+  const size_t numFunctions = visited.NumFunctions();
+
+  // By default the snapshot moves once per pass over the data on average.
+  const double probability = (snapshotProbability == 0.0) ?
+      std::min(1.0, (double) batchSize / (double) numFunctions) :
+      snapshotProbability;
+
+  // To keep track of where we are and how things are going.
+  double overallObjective = 0;
+  double lastObjective = DBL_MAX;
+  snapshots = 0;
+
+  // Initialize the update policy.
+  if (resetPolicy)
+    updatePolicy.Initialize(iterate.n_rows, iterate.n_cols);
+
+  // The snapshot and all the gradients are allocated once.
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat gradient0(iterate.n_rows, iterate.n_cols);
+  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat iterate0(iterate.n_rows, iterate.n_cols);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  bool moveSnapshot = true;
+  size_t epoch = 0;
+  for (size_t i = 0, currentFunction = 0; i < actualMaxIterations &&
+      !terminate; ++i)
+  {
+    if (moveSnapshot)
+    {
+      if (i > 0)
+      {
+        terminate |= Callback::EndEpoch(*this, function, iterate, epoch++,
+            overallObjective, callbacks...);
+        if (terminate)
+          break;
+      }
+
+      // Move the snapshot to the current iterate, and calculate the objective
+      // function and the full gradient there in one pass.
+      iterate0 = iterate;
+      overallObjective = FullEvaluateWithGradient(visited, iterate0,
+          batchSize, fullGradient, gradient, parallelFullGradient);
+      ++snapshots;
+
+      terminate |= Callback::Evaluate(*this, function, iterate,
+          overallObjective, callbacks...);
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        ENS_WARN << "LooplessSVRG: converged to " << overallObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        ENS_INFO << "LooplessSVRG: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      lastObjective = overallObjective;
+
+      terminate |= Callback::BeginEpoch(*this, function, iterate, epoch,
+          overallObjective, callbacks...);
+      terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+          callbacks...);
+      if (terminate)
+        break;
+    }
+
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0)
+    {
+      currentFunction = 0;
+
+      // Determine order of visitation.
+      if (shuffle)
+        visited.Shuffle();
+    }
+
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+
+    // Calculate variance reduced gradient.
+    visited.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+    visited.Gradient(iterate0, currentFunction, gradient0,
+        effectiveBatchSize);
+
+    // Use the update policy to take a step.
+    updatePolicy.Update(iterate, fullGradient, gradient, gradient0,
+        effectiveBatchSize, stepSize);
+
+    terminate |= Callback::StepTaken(*this, function, iterate,
+        callbacks...);
+
+    currentFunction += effectiveBatchSize;
+    moveSnapshot = (Random().Uniform() < probability);
+  }
+
+  if (!terminate)
+  {
+    ENS_INFO << "LooplessSVRG: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+  }
+
+  // Calculate final objective.
+  overallObjective = 0;
+  for (size_t i = 0; i < numFunctions; i += batchSize)
+  {
+    const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+    overallObjective += visited.Evaluate(iterate, i, effectiveBatchSize);
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -106,6 +106,8 @@ class SVRGType
    * @param decayPolicy Instantiated decay policy used to adjust the step size.
    * @param resetPolicy Flag that determines whether update policy parameters
    *     are reset before every Optimize call.
+   * @param parallelFullGradient If true, compute the full gradient of each
+   *     outer iteration with several OpenMP threads.
    */
   SVRGType(const double stepSize = 0.01,
            const size_t batchSize = 32,
@@ -115,20 +117,28 @@ class SVRGType
            const bool shuffle = true,
            const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
            const DecayPolicyType& decayPolicy = DecayPolicyType(),
-           const bool resetPolicy = true);
+           const bool resetPolicy = true,
+           const bool parallelFullGradient = false);
 
   /**
    * Optimize the given function using SVRG. The given starting point will be
    * modified to store the finishing point of the algorithm, and the final
    * objective value is returned.
    *
+   * Any number of callbacks may be given after the iterate; an epoch of SVRG
+   * is one outer iteration and a step is one inner update.
+   *
    * @tparam DecomposableFunctionType Type of the function to be optimized.
+   * @tparam CallbackTypes Types of callback functions.
    * @param function Function to optimize.
    * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
    * @return Objective value of the final point.
    */
-  template<typename DecomposableFunctionType>
-  double Optimize(DecomposableFunctionType& function, arma::mat& iterate);
+  template<typename DecomposableFunctionType, typename... CallbackTypes>
+  double Optimize(DecomposableFunctionType& function,
+                  arma::mat& iterate,
+                  CallbackTypes&&... callbacks);
 
   //! Get the step size.
   double StepSize() const { return stepSize; }
@@ -177,6 +187,14 @@ class SVRGType
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get whether the full gradient is computed in parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether the full gradient is computed in parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get the profiling report of the last call to Optimize().
+  const ProfileReport& Profile() const { return profile; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -206,6 +224,12 @@ class SVRGType
   //! Flag indicating whether update policy
   //! should be reset before running optimization.
   bool resetPolicy;
+
+  //! Whether to compute the full gradient in parallel.
+  bool parallelFullGradient;
+
+  //! The profiling report of the last call to Optimize().
+  ProfileReport profile;
 };
 
 // Convenience typedefs.
@@ -15,6 +15,9 @@
 // In case it hasn't been included yet.
 #include "svrg.hpp"
 
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
 namespace ens {
 
 template<typename UpdatePolicyType, typename DecayPolicyType>
@@ -27,7 +30,8 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::SVRGType(
     const bool shuffle,
     const UpdatePolicyType& updatePolicy,
     const DecayPolicyType& decayPolicy,
-    const bool resetPolicy) :
+    const bool resetPolicy,
+    const bool parallelFullGradient) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
@@ -36,18 +40,31 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::SVRGType(
     shuffle(shuffle),
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
-    resetPolicy(resetPolicy)
+    resetPolicy(resetPolicy),
+    parallelFullGradient(parallelFullGradient)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
 template<typename UpdatePolicyType, typename DecayPolicyType>
-template<typename DecomposableFunctionType>
+template<typename DecomposableFunctionType, typename... CallbackTypes>
 double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
     DecomposableFunctionType& function,
-    arma::mat& iterate)
+    arma::mat& iterate,
+    CallbackTypes&&... callbacks)
 {
+  ENS_PROFILE_OPTIMIZER(profile);
+
+  // If the function can be evaluated on any set of indices, we hold the order
+  // of visitation ourselves and the function never has to be shuffled.
+  typedef VisitationOrder<DecomposableFunctionType> VisitationOrderType;
+  VisitationOrderType order(function);
+  typedef Function<typename VisitationOrderType::VisitedType>
+      VisitedFunctionType;
+  VisitedFunctionType& visited(
+      static_cast<VisitedFunctionType&>(order.Get()));
+
   // Find the number of functions to use.
-  const size_t numFunctions = function.NumFunctions();
+  const size_t numFunctions = visited.NumFunctions();
 
   // To keep track of where we are and how things are going.
   double overallObjective = 0;
@@ -64,7 +81,8 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   // Now iterate!
   arma::mat gradient(iterate.n_rows, iterate.n_cols);
   arma::mat gradient0(iterate.n_rows, iterate.n_cols);
-  arma::mat iterate0;
+  arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
+  arma::mat iterate0(iterate.n_rows, iterate.n_cols);
 
   // Find the number of batches.
   size_t numBatches = numFunctions / batchSize;
@@ -73,55 +91,53 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
 
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
-  for (size_t i = 0; i < actualMaxIterations; ++i)
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  for (size_t i = 0; i < actualMaxIterations && !terminate; ++i)
   {
-    // Calculate the objective function.
-    overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    // Calculate the objective function and the full gradient in one pass.
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      overallObjective += function.Evaluate(iterate, f, effectiveBatchSize);
+      ENS_TRACE_ZONE("Snapshot");
+      overallObjective = FullEvaluateWithGradient(visited, iterate, batchSize,
+          fullGradient, gradient, parallelFullGradient);
     }
 
+    terminate |= Callback::Evaluate(*this, function, iterate,
+        overallObjective, callbacks...);
+
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
     {
-      Warn << "SVRG: converged to " << overallObjective
+      ENS_WARN << "SVRG: converged to " << overallObjective
           << "; terminating  with failure.  Try a smaller step size?"
           << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
     if (std::abs(lastObjective - overallObjective) < tolerance)
     {
-      Info << "SVRG: minimized within tolerance " << tolerance
+      ENS_INFO << "SVRG: minimized within tolerance " << tolerance
           << "; terminating optimization." << std::endl;
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
       return overallObjective;
     }
 
     lastObjective = overallObjective;
 
-    // Compute the full gradient.
-    size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    arma::mat fullGradient(iterate.n_rows, iterate.n_cols);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
-    {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
+    terminate |= Callback::BeginEpoch(*this, function, iterate, i,
+        overallObjective, callbacks...);
+    if (terminate)
+      break;
 
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      fullGradient += gradient;
-
-      f += effectiveBatchSize;
-    }
-    fullGradient /= (double) numFunctions;
+    terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+        callbacks...);
 
     // Store current parameter for the calculation of the variance reduced
-    // gradient.
+    // gradient; the snapshot storage is allocated once, so this is a copy
+    // without allocation.
     iterate0 = iterate;
 
-    for (size_t f = 0, currentFunction = 0; f < innerIterations;
+    for (size_t f = 0, currentFunction = 0; f < innerIterations && !terminate;
         /* incrementing done manually */)
     {
       // Is this iteration the start of a sequence?
@@ -131,22 +147,26 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
 
         // Determine order of visitation.
         if (shuffle)
-          function.Shuffle();
+          visited.Shuffle();
       }
 
       // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - currentFunction);
 
       // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
+      visited.Gradient(iterate, currentFunction, gradient,
           effectiveBatchSize);
-      function.Gradient(iterate0, currentFunction, gradient0,
+      visited.Gradient(iterate0, currentFunction, gradient0,
           effectiveBatchSize);
 
       // Use the update policy to take a step.
       updatePolicy.Update(iterate, fullGradient, gradient, gradient0,
           effectiveBatchSize, stepSize);
 
+      terminate |= Callback::StepTaken(*this, function, iterate,
+          callbacks...);
+
       currentFunction += effectiveBatchSize;
       f += effectiveBatchSize;
     }
@@ -154,18 +174,26 @@ double SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
     // Update the learning rate if requested by the user.
     decayPolicy.Update(iterate, iterate0, gradient, fullGradient, numBatches,
         stepSize);
+
+    terminate |= Callback::EndEpoch(*this, function, iterate, i,
+        overallObjective, callbacks...);
   }
 
-  Info << "SVRG: maximum iterations (" << maxIterations << ") reached; "
-      << "terminating optimization." << std::endl;
+  if (!terminate)
+  {
+    ENS_INFO << "SVRG: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
 
   // Calculate final objective.
   overallObjective = 0;
   for (size_t i = 0; i < numFunctions; i += batchSize)
   {
     const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
-    overallObjective += function.Evaluate(iterate, i, effectiveBatchSize);
+    overallObjective += visited.Evaluate(iterate, i, effectiveBatchSize);
   }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
   return overallObjective;
 }
 
@@ -49,128 +49,236 @@ class SWATSUpdate
               const double beta2 = 0.999) :
     epsilon(epsilon),
     beta1(beta1),
-    beta2(beta2),
-    iteration(0),
-    phaseSGD(false),
-    sgdRate(0),
-    sgdLambda(0)
+    beta2(beta2)
   {
     // Nothing to do.
   }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t rows, const size_t cols)
-  {
-    m = arma::zeros<arma::mat>(rows, cols);
-    v = arma::zeros<arma::mat>(rows, cols);
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
 
-    sgdV = arma::zeros<arma::mat>(rows, cols);
-  }
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
 
   /**
-   * Update step for SWATS.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Increment the iteration counter variable.
-    ++iteration;
-
-    if (phaseSGD)
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(SWATSUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0),
+        phaseSGD(false),
+        sgdRate(0),
+        sgdLambda(0)
     {
-      // Note we reuse the exponential moving average parameter here instead of
-      // introducing a new parameter (sgdV) as done in the paper.
-      v *= beta1;
-      v += gradient;
+      // The state is first written by the threads that update it, for NUMA
+      // locality.
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(sgdV, rows, cols);
+    }
 
-      iterate -= (1 - beta1) * sgdRate * v;
-      return;
+    /**
+     * Reset the state of the policy to that of a new policy for a gradient of
+     * the given size, in place: the memory is only reallocated if the size
+     * changed.
+     *
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    void Reset(const size_t rows, const size_t cols)
+    {
+      FirstTouchZeros(m, rows, cols);
+      FirstTouchZeros(v, rows, cols);
+      FirstTouchZeros(sgdV, rows, cols);
+      phaseSGD = false;
+      sgdRate = 0;
+      sgdLambda = 0;
+      iteration = 0;
     }
 
-    m *= beta1;
-    m += (1 - beta1) * gradient;
+    /**
+     * Update step for SWATS.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
 
-    v *= beta2;
-    v += (1 - beta2) * (gradient % gradient);
+      typedef typename MatType::elem_type ElemType;
+      typedef typename GradType::elem_type GradElemType;
 
-    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
-    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
+      const ElemType beta1 = parent.beta1;
+      const ElemType beta2 = parent.beta2;
+      const ElemType oneMinusBeta1 = 1 - parent.beta1;
+      const ElemType oneMinusBeta2 = 1 - parent.beta2;
 
-    arma::mat delta = stepSize * m / biasCorrection1 /
-        (arma::sqrt(v / biasCorrection2) + epsilon);
-    iterate -= delta;
+      ElemType* x = iterate.memptr();
+      ElemType* mMem = m.memptr();
+      ElemType* vMem = v.memptr();
+      arma::Mat<GradElemType> buffer;
+      const GradElemType* g = DenseMemory(gradient, buffer);
 
-    const double deltaGradient = arma::dot(delta, gradient);
-    if (deltaGradient != 0)
-    {
-      const double rate = arma::dot(delta, delta) / deltaGradient;
-      sgdLambda = beta2 * sgdLambda + (1 - beta2) * rate;
-      sgdRate = sgdLambda / biasCorrection2;
+      if (phaseSGD)
+      {
+        // Note we reuse the exponential moving average parameter here instead
+        // of introducing a new parameter (sgdV) as done in the paper.
+        const ElemType sgdStep = (1 - parent.beta1) * sgdRate;
+        Elementwise(iterate.n_elem, [&](const size_t begin, const size_t end)
+        {
+          for (size_t i = begin; i < end; ++i)
+          {
+            vMem[i] = beta1 * vMem[i] + g[i];
+            x[i] -= sgdStep * vMem[i];
+          }
+        });
+        return;
+      }
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1, iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2, iteration);
+
+      const ElemType step = stepSize / biasCorrection1;
+      const ElemType correction2 = biasCorrection2;
+      const ElemType epsilon = parent.epsilon;
+
+      // Update the moments and the iterate in a single pass, and accumulate
+      // delta^T gradient and delta^T delta for the SGD rate, where delta is
+      // the step.
+      double sums[2];
+      ElementwiseSums(iterate.n_elem, [&](const size_t begin, const size_t end,
+          double* partial)
+      {
+        double deltaGradient = 0.0;
+        double deltaDelta = 0.0;
+        for (size_t i = begin; i < end; ++i)
+        {
+          mMem[i] = beta1 * mMem[i] + oneMinusBeta1 * g[i];
+          vMem[i] = beta2 * vMem[i] + oneMinusBeta2 * (g[i] * g[i]);
+
+          const ElemType delta = step * mMem[i] /
+              (std::sqrt(vMem[i] / correction2) + epsilon);
+          x[i] -= delta;
+
+          deltaGradient += double(delta) * double(g[i]);
+          deltaDelta += double(delta) * double(delta);
+        }
+        partial[0] += deltaGradient;
+        partial[1] += deltaDelta;
+      }, sums);
 
-      if (std::abs(sgdRate - rate) < epsilon && iteration > 1)
+      const double deltaGradient = sums[0];
+      if (deltaGradient != 0)
       {
-        phaseSGD = true;
-        v.zeros();
+        const double rate = sums[1] / deltaGradient;
+        sgdLambda = parent.beta2 * sgdLambda + (1 - parent.beta2) * rate;
+        sgdRate = sgdLambda / biasCorrection2;
+
+        if (std::abs(sgdRate - rate) < parent.epsilon && iteration > 1)
+        {
+          phaseSGD = true;
+          v.zeros();
+        }
       }
     }
-  }
 
-  //! Get the value used to initialise the squared gradient parameter.
-  double Epsilon() const { return epsilon; }
-  //! Modify the value used to initialise the squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("m", m);
+      state.Set("v", v);
+      state.Set("iteration", iteration);
+      state.Set("phaseSGD", phaseSGD);
+      state.Set("sgdV", sgdV);
+      state.Set("sgdRate", sgdRate);
+      state.Set("sgdLambda", sgdLambda);
+    }
 
-  //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
-  //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("m", m);
+      state.Get("v", v);
+      state.Get("iteration", iteration);
+      state.Get("phaseSGD", phaseSGD);
+      state.Get("sgdV", sgdV);
+      state.Get("sgdRate", sgdRate);
+      state.Get("sgdLambda", sgdLambda);
+    }
 
-  //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
-  //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+   private:
+    //! Instantiated parent object.
+    SWATSUpdate& parent;
 
- private:
-  //! The epsilon value used to initialise the squared gradient parameter.
-  double epsilon;
+    //! The exponential moving average of gradient values.
+    MatType m;
 
-  //! The smoothing parameter.
-  double beta1;
+    //! The exponential moving average of squared gradient values (Adam).
+    MatType v;
 
-  //! The second moment coefficient.
-  double beta2;
+    //! The number of iterations.
+    double iteration;
 
-  //! The exponential moving average of gradient values.
-  arma::mat m;
+    //! Wether to use the SGD or Adam update rule.
+    bool phaseSGD;
 
-  //! The exponential moving average of squared gradient values (Adam).
-  arma::mat v;
+    //! The exponential moving average of squared gradient values (SGD).
+    MatType sgdV;
 
-  //! The number of iterations.
-  double iteration;
+    //! SGD scaling parameter.
+    double sgdRate;
 
-  //! Wether to use the SGD or Adam update rule.
-  bool phaseSGD;
+    //! SGD learning rate.
+    double sgdLambda;
+  };
 
-  //! The exponential moving average of squared gradient values (SGD).
-  arma::mat sgdV;
+ private:
+  //! The epsilon value used to initialise the squared gradient parameter.
+  double epsilon;
 
-  //! SGD scaling parameter.
-  double sgdRate;
+  //! The smoothing parameter.
+  double beta1;
 
-  //! SGD learning rate.
-  double sgdLambda;
+  //! The second moment coefficient.
+  double beta2;
 };
 
 } // namespace ens
@@ -0,0 +1,104 @@
+/**
+ * @file any.hpp
+ * @author Ryan Curtin
+ *
+ * A simple type-erased holder for a single object of arbitrary type.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ANY_HPP
+#define ENSMALLEN_UTILITY_ANY_HPP
+
+#include <cstddef>
+#include <typeinfo>
+
+namespace ens {
+
+/**
+ * Any holds a single heap-allocated object whose type is only known when it is
+ * set.  Optimizers use this to keep instantiated policies (whose type depends
+ * on the matrix type given to Optimize()) alive between calls to Optimize(),
+ * without having to know that matrix type when the optimizer is constructed.
+ *
+ * Copying an Any gives an empty Any; the held object is never shared.
+ */
+class Any
+{
+ public:
+  //! Create an empty Any.
+  Any() : vptr(NULL), type(NULL), deleter(NULL) { }
+
+  //! Copying an Any gives an empty Any.
+  Any(const Any& /* other */) : vptr(NULL), type(NULL), deleter(NULL) { }
+
+  //! Assigning an Any empties it.
+  Any& operator=(const Any& other)
+  {
+    if (this != &other)
+      Clean();
+
+    return *this;
+  }
+
+  //! Destroy the held object, if any.
+  ~Any() { Clean(); }
+
+  /**
+   * Take ownership of the given heap-allocated object; any object that was
+   * held before is destroyed.
+   *
+   * @param ptr Object to hold; it must have been allocated with new.
+   */
+  template<typename T>
+  void Set(T* ptr)
+  {
+    Clean();
+    vptr = ptr;
+    type = &typeid(T);
+    deleter = &Delete<T>;
+  }
+
+  //! Return true if an object of type T is held.
+  template<typename T>
+  bool Has() const { return (vptr != NULL) && (*type == typeid(T)); }
+
+  //! Get the held object.  The held object must be of type T.
+  template<typename T>
+  const T& As() const { return *static_cast<const T*>(vptr); }
+  //! Modify the held object.  The held object must be of type T.
+  template<typename T>
+  T& As() { return *static_cast<T*>(vptr); }
+
+  //! Return true if nothing is held.
+  bool Empty() const { return vptr == NULL; }
+
+  //! Destroy the held object, if any.
+  void Clean()
+  {
+    if (vptr != NULL)
+      deleter(vptr);
+
+    vptr = NULL;
+    type = NULL;
+    deleter = NULL;
+  }
+
+ private:
+  //! Destroy an object of the given type.
+  template<typename T>
+  static void Delete(void* ptr) { delete static_cast<T*>(ptr); }
+
+  //! The held object.
+  void* vptr;
+  //! The type of the held object.
+  const std::type_info* type;
+  //! The function that destroys the held object.
+  void (*deleter)(void*);
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file cancellation_token.hpp
+ * @author Ryan Curtin
+ *
+ * A flag that another thread can set to ask an optimization to stop.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_CANCELLATION_TOKEN_HPP
+#define ENSMALLEN_UTILITY_CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace ens {
+
+/**
+ * A CancellationToken is a flag shared by all of its copies: a copy is given
+ * to the optimization (see the TimeBudget callback), and any thread may call
+ * Cancel() on another copy to ask the optimization to stop at its next check.
+ * Checking the flag is a single relaxed atomic load.
+ *
+ * @code
+ * CancellationToken token;
+ * std::thread watchdog([token]() mutable
+ * {
+ *   WaitForShutdown();
+ *   token.Cancel();
+ * });
+ *
+ * optimizer.Optimize(f, coordinates, TimeBudget(0.0, token));
+ * @endcode
+ */
+class CancellationToken
+{
+ public:
+  //! Create a new token that is not cancelled.
+  CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false))
+  { /* Nothing to do. */ }
+
+  //! Ask the optimizations that hold a copy of this token to stop.
+  void Cancel() { flag->store(true, std::memory_order_relaxed); }
+
+  //! Return whether Cancel() has been called since the last Reset().
+  bool Cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+  //! Clear the flag, so that the token can be used again.
+  void Reset() { flag->store(false, std::memory_order_relaxed); }
+
+ private:
+  //! The flag, shared by all copies of the token.
+  std::shared_ptr<std::atomic<bool>> flag;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file deterministic.hpp
+ * @author Marcus Edel
+ *
+ * The deterministic mode of the library, in which the parallel reductions give
+ * bitwise identical results for any number of threads.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_DETERMINISTIC_HPP
+#define ENSMALLEN_UTILITY_DETERMINISTIC_HPP
+
+#include <algorithm>
+#include <atomic>
+
+#include "random.hpp"
+
+namespace ens {
+
+namespace detail {
+
+//! Get the process-wide flag of the deterministic mode.
+inline std::atomic<bool>& DeterministicFlag()
+{
+  #ifdef ENS_DETERMINISTIC
+    static std::atomic<bool> deterministic(true);
+  #else
+    static std::atomic<bool> deterministic(false);
+  #endif
+  return deterministic;
+}
+
+} // namespace detail
+
+/**
+ * Enable or disable the deterministic mode (enabled by default if
+ * ENS_DETERMINISTIC is defined).  The random streams of the optimizers never
+ * depend on the threads (see RandomSeed()); by default, however, a parallel
+ * sum is split into one chunk per thread, so its rounding depends on the
+ * number of threads.  In the deterministic mode, such sums are split into
+ * ENS_DETERMINISTIC_CHUNKS chunks (or fewer, if there is less work) whatever
+ * the number of threads, the chunks are added pairwise in a fixed tree, and
+ * every chunk that evaluates the function installs its own random stream,
+ * keyed by the index of the chunk.  A program that sets the library seed and
+ * the deterministic mode then gets bitwise identical results with any number
+ * of threads, including without OpenMP, at the cost of the few more buffers of
+ * the extra chunks.
+ *
+ * The lock-free optimizers (ParallelSGD, AsyncParallelSGD, AsyncSVRG and FTRL
+ * with several threads) let the threads race on the iterate, and are not made
+ * deterministic.
+ *
+ * @param deterministic Whether to enable the deterministic mode.
+ */
+inline void SetDeterministic(const bool deterministic)
+{
+  detail::DeterministicFlag() = deterministic;
+}
+
+//! Get whether the deterministic mode is enabled.
+inline bool Deterministic()
+{
+  return detail::DeterministicFlag();
+}
+
+/**
+ * Get the number of chunks to split a parallel reduction over the given
+ * amount of work into: one per thread, or ENS_DETERMINISTIC_CHUNKS in the
+ * deterministic mode, and never more than the amount of work.
+ *
+ * @param threads Number of threads available.
+ * @param work Number of units of work (e.g. batches or functions).
+ */
+inline size_t ParallelChunks(const size_t threads, const size_t work)
+{
+  return std::min(Deterministic() ? (size_t) ENS_DETERMINISTIC_CHUNKS :
+      threads, work);
+}
+
+/**
+ * Add the results of the given number of chunks pairwise in a fixed tree:
+ * add(c, c + 1) for every even c, then add(c, c + 2) for every multiple c of
+ * 4, and so on, where add(target, source) adds the result of chunk source to
+ * that of chunk target.  The total ends up in chunk 0.  The order of the
+ * additions only depends on the number of chunks.
+ *
+ * @param chunks Number of chunks.
+ * @param add Function that adds the result of a chunk to another.
+ */
+template<typename AddType>
+inline void PairwiseReduce(const size_t chunks, AddType add)
+{
+  for (size_t stride = 1; stride < chunks; stride *= 2)
+    for (size_t c = 0; c + stride < chunks; c += 2 * stride)
+      add(c, c + stride);
+}
+
+/**
+ * Get the seed of the random streams of the chunks of a parallel loop, drawn
+ * from the generator of the calling thread in the deterministic mode (and 0,
+ * without drawing, otherwise).  Call it once before the loop, and create a
+ * ChunkRandomScope with it in every chunk.
+ */
+inline uint64_t ChunkRandomSeed()
+{
+  return Deterministic() ? Random().Next64() : 0;
+}
+
+/**
+ * In the deterministic mode, install the stream of the given chunk of a
+ * parallel loop (see ChunkRandomSeed()) as the generator of the calling thread
+ * for as long as this object lives, so that a function that draws random
+ * numbers while it is evaluated gets the same numbers whichever thread runs
+ * the chunk.  Otherwise, this does nothing.
+ */
+class ChunkRandomScope
+{
+ public:
+  /**
+   * Install the stream of the given chunk, in the deterministic mode.
+   *
+   * @param seed Seed returned by ChunkRandomSeed().
+   * @param chunk Index of the chunk.
+   */
+  ChunkRandomScope(const uint64_t seed, const size_t chunk) :
+      active(Deterministic()),
+      generator(seed, chunk),
+      previous(detail::CurrentRandom())
+  {
+    if (active)
+      detail::CurrentRandom() = &generator;
+  }
+
+  //! Restore the previous generator of this thread.
+  ~ChunkRandomScope()
+  {
+    if (active)
+      detail::CurrentRandom() = previous;
+  }
+
+ private:
+  ChunkRandomScope(const ChunkRandomScope&);
+  ChunkRandomScope& operator=(const ChunkRandomScope&);
+
+  //! Whether the stream of the chunk is installed.
+  bool active;
+  //! The stream of the chunk.
+  RandomGenerator generator;
+  //! The generator installed before.
+  RandomGenerator* previous;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * @file elementwise.hpp
+ * @author Marcus Edel
+ *
+ * Run a fused elementwise kernel over the elements of parameter-sized
+ * matrices, in one pass, split between OpenMP threads for large matrices.
+ * Used by the update policies, whose steps are bound by memory bandwidth, which
+ * also allocate their state with the same split for NUMA locality.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ELEMENTWISE_HPP
+#define ENSMALLEN_UTILITY_ELEMENTWISE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "huge_pages.hpp"
+
+namespace ens {
+
+/**
+ * Call kernel(begin, end) on ranges of elements that cover [0, n) once.  The
+ * kernel should be a single loop over its range that reads and writes every
+ * array once, so that the compiler can vectorize it; an update written as
+ * several Armadillo expressions instead makes one pass over memory (and often
+ * one temporary) per expression.
+ *
+ * If OpenMP is enabled, there are at least ENS_ELEMENTWISE_PARALLEL_THRESHOLD
+ * elements and we are not already in a parallel region, the range is split
+ * into one contiguous chunk per thread.  The elements are independent, so the
+ * result does not depend on the number of threads.
+ *
+ * @param n Number of elements.
+ * @param kernel Kernel to call on each range.
+ */
+template<typename KernelType>
+inline void Elementwise(const size_t n, KernelType kernel)
+{
+  #ifdef ENS_USE_OPENMP
+    if (n >= ENS_ELEMENTWISE_PARALLEL_THRESHOLD && !omp_in_parallel() &&
+        omp_get_max_threads() > 1)
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        const size_t threadId = omp_get_thread_num();
+        const size_t numThreads = omp_get_num_threads();
+        kernel(n * threadId / numThreads, n * (threadId + 1) / numThreads);
+      }
+      return;
+    }
+  #endif
+
+  kernel(0, n);
+}
+
+/**
+ * Like Elementwise(), but the kernel also accumulates N sums over its range:
+ * kernel(begin, end, partial) adds to partial[0], ..., partial[N - 1], which
+ * start at zero.  The sums of the chunks are added in order, so the result only
+ * depends on the number of threads and not on the scheduling.  In the
+ * deterministic mode (see SetDeterministic()), the range is split into
+ * ENS_DETERMINISTIC_CHUNKS chunks from ENS_ELEMENTWISE_PARALLEL_THRESHOLD
+ * elements, whatever the number of threads, and their sums are added pairwise,
+ * so the result does not depend on the number of threads at all.
+ *
+ * @param n Number of elements.
+ * @param kernel Kernel to call on each range.
+ * @param sums Array to store the sums in.
+ */
+template<size_t N, typename KernelType>
+inline void ElementwiseSums(const size_t n,
+                            KernelType kernel,
+                            double (&sums)[N])
+{
+  for (size_t k = 0; k < N; ++k)
+    sums[k] = 0.0;
+
+  if (n >= ENS_ELEMENTWISE_PARALLEL_THRESHOLD && Deterministic())
+  {
+    const size_t numChunks = ENS_DETERMINISTIC_CHUNKS;
+    std::vector<double> partials(N * numChunks, 0.0);
+
+    #ifdef ENS_USE_OPENMP
+      const bool parallel = !omp_in_parallel() && omp_get_max_threads() > 1;
+    #else
+      const bool parallel = false;
+    #endif
+
+    if (parallel)
+    {
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        size_t threadId = 0;
+        size_t numThreads = 1;
+        #ifdef ENS_USE_OPENMP
+          threadId = omp_get_thread_num();
+          numThreads = omp_get_num_threads();
+        #endif
+
+        for (size_t c = threadId; c < numChunks; c += numThreads)
+        {
+          kernel(n * c / numChunks, n * (c + 1) / numChunks,
+              &partials[N * c]);
+        }
+      }
+    }
+    else
+    {
+      for (size_t c = 0; c < numChunks; ++c)
+        kernel(n * c / numChunks, n * (c + 1) / numChunks, &partials[N * c]);
+    }
+
+    PairwiseReduce(numChunks, [&](const size_t target, const size_t source)
+    {
+      for (size_t k = 0; k < N; ++k)
+        partials[N * target + k] += partials[N * source + k];
+    });
+    for (size_t k = 0; k < N; ++k)
+      sums[k] = partials[k];
+    return;
+  }
+
+  #ifdef ENS_USE_OPENMP
+    if (n >= ENS_ELEMENTWISE_PARALLEL_THRESHOLD && !omp_in_parallel() &&
+        omp_get_max_threads() > 1)
+    {
+      std::vector<double> partials(N * omp_get_max_threads(), 0.0);
+      size_t usedThreads = 1;
+
+      ENS_PRAGMA_OMP_PARALLEL
+      {
+        const size_t threadId = omp_get_thread_num();
+        const size_t numThreads = omp_get_num_threads();
+        if (threadId == 0)
+          usedThreads = numThreads;
+        kernel(n * threadId / numThreads, n * (threadId + 1) / numThreads,
+            &partials[N * threadId]);
+      }
+
+      for (size_t c = 0; c < usedThreads; ++c)
+        for (size_t k = 0; k < N; ++k)
+          sums[k] += partials[N * c + k];
+      return;
+    }
+  #endif
+
+  kernel(0, n, sums);
+}
+
+/**
+ * Set the given matrix to zeros of the given size, with each element written
+ * first by the thread that Elementwise() gives it to.  With the first-touch
+ * page placement of Linux (and most other systems), the pages of each chunk are
+ * then allocated on the NUMA node of the thread that updates them in every
+ * step, as long as the threads stay on their cores (e.g. OMP_PROC_BIND=true).
+ * Below ENS_ELEMENTWISE_PARALLEL_THRESHOLD elements, this is just zeros().  If
+ * huge pages are enabled (see SetHugePages()), the new memory is advised to
+ * use them before it is written.
+ *
+ * @param matrix Matrix to set.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ */
+template<typename eT>
+inline void FirstTouchZeros(arma::Mat<eT>& matrix,
+                            const size_t rows,
+                            const size_t cols)
+{
+  // set_size() does not write the new memory.
+  matrix.set_size(rows, cols);
+  eT* mem = matrix.memptr();
+  AdviseHugePages(mem, matrix.n_elem * sizeof(eT));
+  Elementwise(matrix.n_elem, [&](const size_t begin, const size_t end)
+  {
+    std::fill(mem + begin, mem + end, eT(0));
+  });
+}
+
+/**
+ * Set the given cube to zeros of the given size, like the overload for
+ * matrices.
+ *
+ * @param cube Cube to set.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param slices Number of slices.
+ */
+template<typename eT>
+inline void FirstTouchZeros(arma::Cube<eT>& cube,
+                            const size_t rows,
+                            const size_t cols,
+                            const size_t slices)
+{
+  cube.set_size(rows, cols, slices);
+  eT* mem = cube.memptr();
+  AdviseHugePages(mem, cube.n_elem * sizeof(eT));
+  Elementwise(cube.n_elem, [&](const size_t begin, const size_t end)
+  {
+    std::fill(mem + begin, mem + end, eT(0));
+  });
+}
+
+/**
+ * Set the given matrix of another type (e.g. a sparse or a GPU matrix) to zeros
+ * of the given size.
+ */
+template<typename MatType>
+inline void FirstTouchZeros(MatType& matrix,
+                            const size_t rows,
+                            const size_t cols)
+{
+  matrix.zeros(rows, cols);
+}
+
+/**
+ * Move the elements of the given matrix to new memory, written first by the
+ * threads of Elementwise() like FirstTouchZeros(), so that its pages are
+ * spread over the NUMA nodes of the threads.  This can be used to place an
+ * iterate or a dataset that was filled by a single thread.  Matrices below
+ * ENS_ELEMENTWISE_PARALLEL_THRESHOLD elements, and matrices that use external
+ * memory, are left alone.
+ *
+ * @param matrix Matrix to place.
+ */
+template<typename eT>
+inline void FirstTouchPlace(arma::Mat<eT>& matrix)
+{
+  if (matrix.n_elem < ENS_ELEMENTWISE_PARALLEL_THRESHOLD ||
+      matrix.mem_state != 0)
+    return;
+
+  arma::Mat<eT> placed;
+  placed.set_size(matrix.n_rows, matrix.n_cols);
+  const eT* source = matrix.memptr();
+  eT* destination = placed.memptr();
+  AdviseHugePages(destination, placed.n_elem * sizeof(eT));
+  Elementwise(matrix.n_elem, [&](const size_t begin, const size_t end)
+  {
+    std::copy(source + begin, source + end, destination + begin);
+  });
+  matrix.steal_mem(placed);
+}
+
+//! Matrices of other types are left alone.
+template<typename MatType>
+inline void FirstTouchPlace(MatType& /* matrix */) { }
+
+/**
+ * Exchange the elements of the iterate and of a buffer of the same size.  If
+ * both own their memory, the memory is exchanged; otherwise (e.g. the iterate
+ * uses external memory), the elements are exchanged, so that the iterate keeps
+ * its memory.  Moving a matrix into an iterate with
+ * external memory would make it take the memory of the matrix instead.
+ *
+ * @param iterate Iterate of the optimizer.
+ * @param buffer Buffer of the same size.
+ */
+template<typename eT>
+inline void SwapInPlace(arma::Mat<eT>& iterate, arma::Mat<eT>& buffer)
+{
+  if (iterate.mem_state == 0 && buffer.mem_state == 0)
+    iterate.swap(buffer);
+  else
+    std::swap_ranges(iterate.begin(), iterate.end(), buffer.begin());
+}
+
+//! Sparse and fixed-size matrices keep their memory when swapped.
+template<typename MatType>
+inline void SwapInPlace(MatType& iterate, MatType& buffer)
+{
+  iterate.swap(buffer);
+}
+
+/**
+ * Return a pointer to the elements of the given dense matrix.  The buffer is
+ * not used.
+ */
+template<typename eT>
+inline const eT* DenseMemory(const arma::Mat<eT>& matrix,
+                             arma::Mat<eT>& /* buffer */)
+{
+  return matrix.memptr();
+}
+
+/**
+ * Return a pointer to the elements of the given sparse matrix, copied into the
+ * given dense buffer.
+ */
+template<typename eT>
+inline const eT* DenseMemory(const arma::SpMat<eT>& matrix,
+                             arma::Mat<eT>& buffer)
+{
+  buffer = arma::Mat<eT>(matrix);
+  return buffer.memptr();
+}
+
+} // namespace ens
+
+#endif
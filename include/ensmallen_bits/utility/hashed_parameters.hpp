@@ -0,0 +1,288 @@
+/**
+ * @file hashed_parameters.hpp
+ * @author Marcus Edel
+ *
+ * Storage for the few touched coordinates of a very high-dimensional sparse
+ * model, in an open-addressing hash table that threads can insert into
+ * concurrently.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_HASHED_PARAMETERS_HPP
+#define ENSMALLEN_UTILITY_HASHED_PARAMETERS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ens {
+
+/**
+ * HashedParameters holds the coordinates of a n_rows x n_cols iterate that have
+ * ever been written, and treats all the others as zero.  With feature hashing,
+ * a sparse model may have billions of coordinates of which only a small
+ * fraction is ever touched by a gradient; a dense arma::mat of that size does
+ * not fit in memory, while the table only takes memory for the coordinates in
+ * use.
+ *
+ * The coordinates are kept in an open-addressing table with linear probing,
+ * whose size is fixed at construction: it holds up to the given capacity of
+ * coordinates, and inserting more throws std::runtime_error.  Reading a
+ * coordinate (through a const object) never inserts it.  Writing a coordinate
+ * (through the non-const operator[]) inserts it if needed; the insertion is
+ * lock-free, so several threads can write to the table at once, as the
+ * HOGWILD! updates of ParallelSGD do.  As for a dense iterate, concurrent
+ * writes to the same coordinate are only safe if they are atomic.
+ *
+ * ParallelSGD can optimize a HashedParameters iterate directly, with sparse
+ * gradients and SparseVanillaUpdate; the function then takes the table as its
+ * coordinates.  The result can be converted to a sparse matrix with ToSparse().
+ *
+ * @code
+ * // A model over 2^34 hashed features, of which up to 10 million are used.
+ * HashedParameters<> iterate(size_t(1) << 34, 1, 10000000);
+ *
+ * ParallelSGD<> optimizer(100, 0);
+ * optimizer.Optimize(f, iterate);
+ * arma::sp_mat model = iterate.ToSparse();
+ * @endcode
+ *
+ * @tparam eT Type of the elements.
+ */
+template<typename eT = double>
+class HashedParameters
+{
+ public:
+  //! The type of the elements.
+  typedef eT elem_type;
+
+  /**
+   * Create an all-zero n_rows x n_cols iterate that can hold up to the given
+   * number of non-zero coordinates.
+   *
+   * @param n_rows Number of rows.
+   * @param n_cols Number of columns.
+   * @param capacity Maximum number of coordinates that can be written.
+   */
+  HashedParameters(const size_t n_rows,
+                   const size_t n_cols,
+                   const size_t capacity) :
+      n_rows(n_rows),
+      n_cols(n_cols),
+      n_elem(n_rows * n_cols),
+      capacity(capacity),
+      slots(1),
+      used(0)
+  {
+    if (n_cols != 0 && n_elem / n_cols != n_rows)
+    {
+      std::ostringstream oss;
+      oss << "HashedParameters::HashedParameters(): " << n_rows << " x "
+          << n_cols << " coordinates cannot be indexed!";
+      throw std::invalid_argument(oss.str());
+    }
+
+    // Keep the load of the table below one half, so that the probes stay
+    // short.
+    while (slots < 2 * capacity)
+      slots *= 2;
+
+    keys.reset(new std::atomic<uint64_t>[slots]);
+    values.reset(new eT[slots]());
+    for (size_t s = 0; s < slots; ++s)
+      keys[s].store(Empty(), std::memory_order_relaxed);
+  }
+
+  /**
+   * Get the value of the given coordinate (by linear index); coordinates that
+   * were never written are zero.
+   *
+   * @param k Linear index of the coordinate.
+   */
+  eT operator[](const size_t k) const
+  {
+    size_t s = Hash(k) & (slots - 1);
+    for (size_t probe = 0; probe < slots; ++probe, s = (s + 1) & (slots - 1))
+    {
+      const uint64_t key = keys[s].load(std::memory_order_acquire);
+      if (key == (uint64_t) k)
+        return values[s];
+      if (key == Empty())
+        break;
+    }
+
+    return eT(0);
+  }
+
+  /**
+   * Get a reference to the given coordinate (by linear index), and insert it
+   * with the value zero if it was never written.  This may be called from
+   * several threads at once.
+   *
+   * @param k Linear index of the coordinate.
+   */
+  eT& operator[](const size_t k)
+  {
+    size_t s = Hash(k) & (slots - 1);
+    for (size_t probe = 0; probe < slots; ++probe, s = (s + 1) & (slots - 1))
+    {
+      uint64_t key = keys[s].load(std::memory_order_acquire);
+      if (key == Empty())
+      {
+        // Claim the slot; if another thread claimed it first, its key is
+        // checked like any other.
+        if (keys[s].compare_exchange_strong(key, (uint64_t) k,
+            std::memory_order_acq_rel))
+        {
+          if (used.fetch_add(1, std::memory_order_relaxed) >= capacity)
+            break;
+          return values[s];
+        }
+      }
+
+      if (key == (uint64_t) k)
+        return values[s];
+    }
+
+    std::ostringstream oss;
+    oss << "HashedParameters::operator[](): more than " << capacity
+        << " coordinates were written!";
+    throw std::runtime_error(oss.str());
+  }
+
+  //! Get the value of the given coordinate.
+  eT operator()(const size_t row, const size_t col) const
+  { return (*this)[row + col * n_rows]; }
+  //! Get a reference to the given coordinate, inserting it if needed.
+  eT& operator()(const size_t row, const size_t col)
+  { return (*this)[row + col * n_rows]; }
+
+  //! Get the number of coordinates that were written.
+  size_t Size() const { return std::min(used.load(), capacity); }
+
+  //! Get the maximum number of coordinates that can be written.
+  size_t Capacity() const { return capacity; }
+
+  //! Reset all the coordinates to zero, and free the table for new ones (not
+  //! thread-safe).
+  void Clear()
+  {
+    for (size_t s = 0; s < slots; ++s)
+    {
+      keys[s].store(Empty(), std::memory_order_relaxed);
+      values[s] = eT(0);
+    }
+    used.store(0);
+  }
+
+  /**
+   * Call visit(k, value) for every coordinate that was written, with its
+   * linear index k, in no particular order.
+   *
+   * @param visit Function to call for every coordinate.
+   */
+  template<typename VisitType>
+  void ForEach(VisitType visit) const
+  {
+    for (size_t s = 0; s < slots; ++s)
+    {
+      const uint64_t key = keys[s].load(std::memory_order_acquire);
+      if (key != Empty())
+        visit((size_t) key, values[s]);
+    }
+  }
+
+  /**
+   * Convert the iterate to a sparse matrix.  The dimensions must fit in
+   * arma::uword (which is 64 bits unless Armadillo is configured otherwise).
+   */
+  arma::SpMat<eT> ToSparse() const
+  {
+    if (n_rows > (size_t) std::numeric_limits<arma::uword>::max() ||
+        n_cols > (size_t) std::numeric_limits<arma::uword>::max())
+    {
+      throw std::logic_error("HashedParameters::ToSparse(): the dimensions do "
+          "not fit in arma::uword; enable ARMA_64BIT_WORD!");
+    }
+
+    size_t nonZeroCount = 0;
+    ForEach([&](const size_t /* k */, const eT /* value */)
+    {
+      ++nonZeroCount;
+    });
+
+    arma::umat locations(2, nonZeroCount);
+    arma::Col<eT> nonZeros(nonZeroCount);
+    size_t i = 0;
+    ForEach([&](const size_t k, const eT value)
+    {
+      locations(0, i) = k % n_rows;
+      locations(1, i) = k / n_rows;
+      nonZeros[i++] = value;
+    });
+
+    return arma::SpMat<eT>(locations, nonZeros, n_rows, n_cols);
+  }
+
+  //! The number of rows.
+  const size_t n_rows;
+  //! The number of columns.
+  const size_t n_cols;
+  //! The number of coordinates (including those that are not stored).
+  const size_t n_elem;
+
+ private:
+  HashedParameters(const HashedParameters&);
+  HashedParameters& operator=(const HashedParameters&);
+
+  //! The key of an empty slot (no coordinate can have it, since n_elem is at
+  //! most the largest size_t).
+  static uint64_t Empty() { return std::numeric_limits<uint64_t>::max(); }
+
+  //! Mix the bits of the given index (the finalizer of SplitMix64), so that
+  //! regularly spaced indices do not collide.
+  static size_t Hash(const size_t k)
+  {
+    uint64_t z = (uint64_t) k + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (size_t) (z ^ (z >> 31));
+  }
+
+  //! The maximum number of coordinates that can be written.
+  size_t capacity;
+  //! The number of slots of the table (a power of two).
+  size_t slots;
+  //! The index of the coordinate in each slot, or Empty().
+  std::unique_ptr<std::atomic<uint64_t>[]> keys;
+  //! The value of the coordinate in each slot.
+  std::unique_ptr<eT[]> values;
+  //! The number of slots claimed.
+  std::atomic<size_t> used;
+};
+
+//! Whether the given iterate type is a HashedParameters.
+template<typename MatType>
+struct IsHashedParameters : std::false_type { };
+
+template<typename eT>
+struct IsHashedParameters<HashedParameters<eT>> : std::true_type { };
+
+/**
+ * A HashedParameters iterate is filled as it is written, so there is nothing
+ * to place; see the overload for matrices.
+ */
+template<typename eT>
+inline void FirstTouchPlace(HashedParameters<eT>& /* parameters */) { }
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,221 @@
+/**
+ * @file huge_pages.hpp
+ * @author Marcus Edel
+ *
+ * Huge page backing and cache line alignment for the large buffers of the
+ * optimizers, to cut the TLB misses of the steps that stream over them.
+ *
+ * This file does not depend on Armadillo, so that it can be included before
+ * it to provide its allocator (see ENS_ALIGNED_ALLOCATOR).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_HUGE_PAGES_HPP
+#define ENSMALLEN_UTILITY_HUGE_PAGES_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+#endif
+
+#if !defined(ENS_HUGE_PAGE_SIZE)
+  // Size of a huge page in bytes (2 MiB on x86-64 and most ARM64 systems).
+  // Buffers smaller than this are never backed by huge pages.
+  #define ENS_HUGE_PAGE_SIZE 2097152
+#endif
+
+#if !defined(ENS_MEMORY_ALIGNMENT)
+  // Alignment in bytes of the memory given by AlignedAllocate(): one cache
+  // line, so that the 64-byte vectors of AVX-512 never straddle two lines.
+  #define ENS_MEMORY_ALIGNMENT 64
+#endif
+
+namespace ens {
+
+//! The ways the large buffers can be backed by huge pages.
+enum HugePageMode
+{
+  //! Use the normal pages of the system.
+  NoHugePages,
+  //! Advise the kernel to back the buffers with transparent huge pages.
+  TransparentHugePages,
+  //! Map the buffers allocated by AlignedAllocate() from the reserved huge
+  //! pages (hugetlbfs), and fall back to transparent huge pages.
+  ExplicitHugePages
+};
+
+namespace detail {
+
+//! Get the process-wide huge page mode.
+inline std::atomic<int>& HugePageFlag()
+{
+  #ifdef ENS_HUGE_PAGES
+    static std::atomic<int> mode(TransparentHugePages);
+  #else
+    static std::atomic<int> mode(NoHugePages);
+  #endif
+  return mode;
+}
+
+//! The bookkeeping stored in front of the memory given by AlignedAllocate().
+struct AlignedHeader
+{
+  //! The start of the allocation.
+  void* base;
+  //! The size of the mapping, or 0 if the memory came from posix_memalign().
+  size_t mapped;
+};
+
+static_assert(sizeof(AlignedHeader) <= ENS_MEMORY_ALIGNMENT,
+    "ENS_MEMORY_ALIGNMENT must be large enough to hold the allocation header");
+
+} // namespace detail
+
+/**
+ * Set the huge page mode (TransparentHugePages by default if ENS_HUGE_PAGES is
+ * defined, NoHugePages otherwise).  The state of the update policies, the
+ * history of L_BFGS and the other buffers allocated with FirstTouchZeros() or
+ * placed with FirstTouchPlace() are then backed by huge pages if they are at
+ * least ENS_HUGE_PAGE_SIZE bytes.  A step streaming over gigabytes of state
+ * then needs one TLB entry per 2 MiB instead of one per 4 KiB, which removes
+ * most of its TLB misses.  The pages are still first written by the threads
+ * that update them, so they stay on their NUMA nodes.
+ *
+ * Transparent huge pages are only a hint: the kernel needs them to be enabled
+ * (in /sys/kernel/mm/transparent_hugepage/enabled, as "always" or
+ * "madvise"), and may fall back to normal pages if memory is fragmented.
+ * Explicit huge pages must be reserved beforehand (e.g. in
+ * /proc/sys/vm/nr_hugepages), and only apply to memory allocated with
+ * AlignedAllocate(), i.e. with ENS_ALIGNED_ALLOCATOR.  Huge pages are only
+ * supported on Linux; elsewhere the mode has no effect.
+ *
+ * @param mode The huge page mode.
+ */
+inline void SetHugePages(const HugePageMode mode)
+{
+  detail::HugePageFlag() = mode;
+}
+
+//! Get the huge page mode.
+inline HugePageMode HugePages()
+{
+  return (HugePageMode) detail::HugePageFlag().load();
+}
+
+/**
+ * Advise the kernel to back the whole huge pages in the given range of memory
+ * with transparent huge pages, if the huge page mode is not NoHugePages and
+ * the range is at least ENS_HUGE_PAGE_SIZE bytes.  This must be called before
+ * the memory is first written, since the pages are allocated then.
+ *
+ * @param memory Start of the range.
+ * @param bytes Size of the range in bytes.
+ */
+inline void AdviseHugePages(void* memory, const size_t bytes)
+{
+  #if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (HugePages() == NoHugePages || bytes < ENS_HUGE_PAGE_SIZE)
+      return;
+
+    // madvise() needs a page-aligned start; only the huge pages entirely in the
+    // range can be huge.
+    const uintptr_t begin = (uintptr_t) memory;
+    const uintptr_t first = (begin + ENS_HUGE_PAGE_SIZE - 1) /
+        ENS_HUGE_PAGE_SIZE * ENS_HUGE_PAGE_SIZE;
+    const uintptr_t last = (begin + bytes) / ENS_HUGE_PAGE_SIZE *
+        ENS_HUGE_PAGE_SIZE;
+    if (last > first)
+      madvise((void*) first, last - first, MADV_HUGEPAGE);
+  #else
+    (void) memory;
+    (void) bytes;
+  #endif
+}
+
+/**
+ * Allocate the given number of bytes aligned to ENS_MEMORY_ALIGNMENT.  Unless
+ * the huge page mode is NoHugePages, allocations of at least
+ * ENS_HUGE_PAGE_SIZE bytes are aligned to a huge page and advised to use
+ * transparent huge pages (or, with ExplicitHugePages, mapped from the
+ * reserved huge pages if there are enough).  The memory must be released with
+ * AlignedFree().  Returns a null pointer if the memory cannot be allocated.
+ *
+ * With ENS_ALIGNED_ALLOCATOR defined before ensmallen.hpp is included (and
+ * before Armadillo is included anywhere else), Armadillo allocates the memory
+ * of all its matrices with this function.
+ *
+ * @param bytes Number of bytes to allocate.
+ */
+inline void* AlignedAllocate(const size_t bytes)
+{
+  const size_t offset = ENS_MEMORY_ALIGNMENT;
+  const bool huge = (HugePages() != NoHugePages &&
+      bytes >= ENS_HUGE_PAGE_SIZE);
+
+  void* base = NULL;
+  size_t mapped = 0;
+
+  #if defined(__linux__) && defined(MAP_HUGETLB)
+    if (huge && HugePages() == ExplicitHugePages)
+    {
+      const size_t size = (bytes + offset + ENS_HUGE_PAGE_SIZE - 1) /
+          ENS_HUGE_PAGE_SIZE * ENS_HUGE_PAGE_SIZE;
+      void* map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (map != MAP_FAILED)
+      {
+        base = map;
+        mapped = size;
+      }
+    }
+  #endif
+
+  if (base == NULL)
+  {
+    if (posix_memalign(&base, huge ? ENS_HUGE_PAGE_SIZE : ENS_MEMORY_ALIGNMENT,
+        bytes + offset) != 0)
+      return NULL;
+
+    if (huge)
+      AdviseHugePages(base, bytes + offset);
+  }
+
+  detail::AlignedHeader* header = (detail::AlignedHeader*) base;
+  header->base = base;
+  header->mapped = mapped;
+  return (char*) base + offset;
+}
+
+/**
+ * Release memory allocated with AlignedAllocate().
+ *
+ * @param memory Memory to release (may be null).
+ */
+inline void AlignedFree(void* memory)
+{
+  if (memory == NULL)
+    return;
+
+  const detail::AlignedHeader* header = (const detail::AlignedHeader*)
+      ((char*) memory - ENS_MEMORY_ALIGNMENT);
+  #if defined(__linux__)
+    if (header->mapped != 0)
+    {
+      munmap(header->base, header->mapped);
+      return;
+    }
+  #endif
+
+  free(header->base);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file importance_sampler.hpp
+ * @author Marcus Edel
+ *
+ * Sampling of indices with probabilities proportional to weights that can be
+ * updated, for importance-sampled batches.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_IMPORTANCE_SAMPLER_HPP
+#define ENSMALLEN_UTILITY_IMPORTANCE_SAMPLER_HPP
+
+#include <vector>
+
+namespace ens {
+
+/**
+ * ImportanceSampler draws indices from [0, n) with probability
+ *
+ * \f[
+ * p_i = \frac{u}{n} + (1 - u) \frac{w_i}{\sum_j w_j}
+ * \f]
+ *
+ * where w_i are non-negative weights (for instance per-sample Lipschitz
+ * constants, or recent losses) and u is the uniformity.  The weights are held
+ * in a Fenwick tree, so that both drawing an index and changing a weight take
+ * O(log n) time.  The uniform part keeps every probability at least u / n, so
+ * that the importance weights 1 / (n p_i) of an unbiased estimate are at most
+ * 1 / u.
+ *
+ * The random numbers are taken from Random(), as in the rest of the library.
+ */
+class ImportanceSampler
+{
+ public:
+  /**
+   * Create a sampler of the given number of indices, with equal weights.
+   *
+   * @param n Number of indices.
+   * @param uniformity Fraction u of the probability spread uniformly.
+   */
+  ImportanceSampler(const size_t n = 0, const double uniformity = 0.1) :
+      uniformity(uniformity)
+  {
+    Reset(n);
+  }
+
+  //! Set the number of indices to n, with equal weights.
+  void Reset(const size_t n)
+  {
+    weights.assign(n, 1.0);
+    tree.assign(n + 1, 0.0);
+    // Build the tree in O(n): each node adds itself to its parent.
+    for (size_t i = 1; i <= n; ++i)
+    {
+      tree[i] += 1.0;
+      const size_t parent = i + (i & (~i + 1));
+      if (parent <= n)
+        tree[parent] += tree[i];
+    }
+    total = double(n);
+  }
+
+  //! Set the weights of all the indices.
+  void Reset(const arma::vec& newWeights)
+  {
+    Reset(newWeights.n_elem);
+    for (size_t i = 0; i < newWeights.n_elem; ++i)
+      Update(i, newWeights[i]);
+  }
+
+  //! Get the number of indices.
+  size_t Size() const { return weights.size(); }
+
+  //! Get the weight of the given index.
+  double Weight(const size_t i) const { return weights[i]; }
+
+  //! Get the sum of the weights.
+  double Total() const { return total; }
+
+  //! Set the weight of the given index (negative weights count as zero).
+  void Update(const size_t i, const double weight)
+  {
+    const double w = (weight > 0.0) ? weight : 0.0;
+    const double delta = w - weights[i];
+    weights[i] = w;
+    total += delta;
+    for (size_t k = i + 1; k < tree.size(); k += (k & (~k + 1)))
+      tree[k] += delta;
+  }
+
+  //! Get the probability of drawing the given index.
+  double Probability(const size_t i) const
+  {
+    const double n = double(weights.size());
+    if (!(total > 0.0))
+      return 1.0 / n;
+    return uniformity / n + (1.0 - uniformity) * weights[i] / total;
+  }
+
+  //! Draw an index.
+  size_t Sample() const
+  {
+    RandomGenerator& generator = Random();
+    const size_t n = weights.size();
+    if (!(total > 0.0) || generator.Uniform() < uniformity)
+      return generator.Integer(n);
+
+    // Descend the tree to the first index whose prefix sum exceeds the draw.
+    double target = generator.Uniform() * total;
+    size_t position = 0;
+    size_t step = 1;
+    while (2 * step <= n)
+      step *= 2;
+    for (; step > 0; step /= 2)
+    {
+      if (position + step <= n && tree[position + step] <= target)
+      {
+        position += step;
+        target -= tree[position];
+      }
+    }
+
+    // Rounding may leave the draw past the last index with a weight.
+    while (position > 0 && (position >= n || weights[position] == 0.0))
+      --position;
+    return position;
+  }
+
+  //! Get the fraction of the probability spread uniformly.
+  double Uniformity() const { return uniformity; }
+  //! Modify the fraction of the probability spread uniformly.
+  double& Uniformity() { return uniformity; }
+
+ private:
+  //! The fraction of the probability spread uniformly.
+  double uniformity;
+
+  //! The weight of each index.
+  std::vector<double> weights;
+
+  //! The Fenwick tree of the weights (1-based).
+  std::vector<double> tree;
+
+  //! The sum of the weights.
+  double total;
+};
+
+} // namespace ens
+
+#endif
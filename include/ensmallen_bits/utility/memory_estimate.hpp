@@ -0,0 +1,92 @@
+/**
+ * @file memory_estimate.hpp
+ * @author Marcus Edel
+ *
+ * Estimate the memory an optimizer takes before running it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_MEMORY_ESTIMATE_HPP
+#define ENSMALLEN_UTILITY_MEMORY_ESTIMATE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ens {
+
+/**
+ * Detect whether an optimizer can estimate its memory, that is, whether it has
+ * the method
+ *
+ *   size_t MemoryEstimate(const size_t rows,
+ *                         const size_t cols,
+ *                         const size_t numFunctions) const;
+ *
+ * which returns the number of bytes that Optimize() allocates at its peak for
+ * an iterate of the given size and a function with the given number of
+ * separable functions.  The iterate and the data of the function are not
+ * counted.
+ */
+template<typename OptimizerType>
+struct HasMemoryEstimate
+{
+  template<typename O>
+  static auto Check(int) -> decltype(
+      std::declval<const O&>().MemoryEstimate(size_t(0), size_t(0), size_t(0)),
+      std::true_type());
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<OptimizerType>(0))::value;
+};
+
+/**
+ * Estimate the peak number of bytes that the given optimizer allocates to
+ * optimize an iterate of the given size (the iterate itself and the data of
+ * the function are not counted), so that a job can be placed on a machine with
+ * enough memory, or a variant that needs less memory chosen, before it runs.
+ * Optimizers whose buffers grow faster than the iterate (IQN, CMAES, L_BFGS,
+ * SAGA, ...) give their own estimate; the others are assumed to take a few
+ * buffers of the size of the iterate (the gradient and the state of the
+ * update), as the first-order optimizers do.
+ *
+ * @code
+ * IQN iqn(0.01, 10);
+ * if (MemoryEstimate(iqn, f.NumFeatures(), 1, f.NumFunctions()) > budget)
+ *   return LIQN(0.01, 10).Optimize(f, coordinates);
+ * @endcode
+ *
+ * @param optimizer Optimizer to estimate the memory of.
+ * @param rows Number of rows of the iterate.
+ * @param cols Number of columns of the iterate.
+ * @param numFunctions Number of separable functions of the objective.
+ */
+template<typename OptimizerType>
+typename std::enable_if<HasMemoryEstimate<OptimizerType>::value, size_t>::type
+MemoryEstimate(const OptimizerType& optimizer,
+               const size_t rows,
+               const size_t cols,
+               const size_t numFunctions = 1)
+{
+  return optimizer.MemoryEstimate(rows, cols, numFunctions);
+}
+
+//! An optimizer without a MemoryEstimate() method is assumed to take four
+//! buffers of the size of the iterate.
+template<typename OptimizerType>
+typename std::enable_if<!HasMemoryEstimate<OptimizerType>::value, size_t>::type
+MemoryEstimate(const OptimizerType& /* optimizer */,
+               const size_t rows,
+               const size_t cols,
+               const size_t /* numFunctions */ = 1)
+{
+  return 4 * rows * cols * sizeof(double);
+}
+
+} // namespace ens
+
+#endif
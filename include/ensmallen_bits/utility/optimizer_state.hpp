@@ -0,0 +1,296 @@
+/**
+ * @file optimizer_state.hpp
+ * @author Marcus Edel
+ *
+ * A named collection of matrices holding the internal state of an optimizer,
+ * so that an optimization can be checkpointed and resumed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_OPTIMIZER_STATE_HPP
+#define ENSMALLEN_UTILITY_OPTIMIZER_STATE_HPP
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ens {
+
+/**
+ * OptimizerState holds the internal state of an optimizer and its policies
+ * (e.g. the moment estimates of Adam) as named matrices; scalars are stored as
+ * 1x1 matrices.  Entries are always stored in double precision, and converted
+ * back to the element type of the matrix they are read into.
+ *
+ * The state can be written to and read from a file with Save() and Load().
+ * The file holds the number of entries, followed by the name of each entry on
+ * its own line and the entry in Armadillo's binary format.
+ */
+class OptimizerState
+{
+ public:
+  //! Store the given matrix under the given name.
+  template<typename eT>
+  void Set(const std::string& name, const arma::Mat<eT>& value)
+  {
+    entries[name] = arma::conv_to<arma::mat>::from(value);
+  }
+
+  #ifdef ENS_USE_COOT
+  //! Store the given GPU matrix under the given name; it is copied to the host.
+  template<typename eT>
+  void Set(const std::string& name, const coot::Mat<eT>& value)
+  {
+    Set(name, coot::conv_to<arma::Mat<eT>>::from(value));
+  }
+  #endif
+
+  //! Store the given scalar under the given name.
+  void Set(const std::string& name, const double value)
+  {
+    entries[name] = arma::mat(1, 1);
+    entries[name](0) = value;
+  }
+
+  /**
+   * Store all the entries of the given state, with the given prefix prepended
+   * to their names.  This lets an optimizer store the state of each of its
+   * policies without name clashes.
+   */
+  void Set(const std::string& prefix, const OptimizerState& other)
+  {
+    std::map<std::string, arma::mat>::const_iterator it = other.entries.begin();
+    for ( ; it != other.entries.end(); ++it)
+      entries[prefix + it->first] = it->second;
+  }
+
+  //! Return whether there is an entry with the given name.
+  bool Has(const std::string& name) const
+  {
+    return entries.count(name) > 0;
+  }
+
+  //! Read the matrix stored under the given name.
+  template<typename eT>
+  void Get(const std::string& name, arma::Mat<eT>& value) const
+  {
+    value = arma::conv_to<arma::Mat<eT>>::from(Entry(name));
+  }
+
+  #ifdef ENS_USE_COOT
+  //! Read the matrix stored under the given name into a GPU matrix.
+  template<typename eT>
+  void Get(const std::string& name, coot::Mat<eT>& value) const
+  {
+    arma::Mat<eT> host;
+    Get(name, host);
+    value = coot::conv_to<coot::Mat<eT>>::from(host);
+  }
+  #endif
+
+  //! Read the scalar stored under the given name.
+  void Get(const std::string& name, double& value) const
+  {
+    value = Scalar(name);
+  }
+
+  //! Read the scalar stored under the given name.
+  void Get(const std::string& name, size_t& value) const
+  {
+    value = (size_t) Scalar(name);
+  }
+
+  //! Read the flag stored under the given name.
+  void Get(const std::string& name, bool& value) const
+  {
+    value = (Scalar(name) != 0.0);
+  }
+
+  /**
+   * Read all the entries whose name starts with the given prefix into the
+   * given state, with the prefix removed; this is the inverse of
+   * Set(prefix, other).
+   */
+  void Get(const std::string& prefix, OptimizerState& other) const
+  {
+    other.Clear();
+    std::map<std::string, arma::mat>::const_iterator it =
+        entries.lower_bound(prefix);
+    for ( ; it != entries.end() &&
+        it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+    {
+      other.entries[it->first.substr(prefix.size())] = it->second;
+    }
+  }
+
+  //! Remove all entries.
+  void Clear() { entries.clear(); }
+
+  //! Return whether there are no entries.
+  bool Empty() const { return entries.empty(); }
+
+  //! Return the number of entries.
+  size_t Size() const { return entries.size(); }
+
+  //! Return the names of the entries, in sorted order.
+  std::vector<std::string> Names() const
+  {
+    std::vector<std::string> names;
+    std::map<std::string, arma::mat>::const_iterator it = entries.begin();
+    for ( ; it != entries.end(); ++it)
+      names.push_back(it->first);
+    return names;
+  }
+
+  /**
+   * Write the state to the given file.
+   *
+   * @param filename Name of the file to write.
+   * @return false if the file could not be written.
+   */
+  bool Save(const std::string& filename) const
+  {
+    std::ofstream stream(filename.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      return false;
+
+    stream << "ENS_OPTIMIZER_STATE" << '\n' << entries.size() << '\n';
+    std::map<std::string, arma::mat>::const_iterator it = entries.begin();
+    for ( ; it != entries.end(); ++it)
+    {
+      stream << it->first << '\n';
+      if (!it->second.save(stream, arma::arma_binary))
+        return false;
+    }
+
+    stream.flush();
+    return stream.good();
+  }
+
+  /**
+   * Read the state from the given file, replacing all entries.
+   *
+   * @param filename Name of the file to read.
+   * @return false if the file could not be read; the state is then empty.
+   */
+  bool Load(const std::string& filename)
+  {
+    Clear();
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream.is_open())
+      return false;
+
+    std::string header;
+    size_t numEntries = 0;
+    if (!std::getline(stream, header) || header != "ENS_OPTIMIZER_STATE" ||
+        !(stream >> numEntries))
+    {
+      return false;
+    }
+    stream.ignore(1); // Skip the newline after the number of entries.
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+      std::string name;
+      arma::mat value;
+      if (!std::getline(stream, name) || !value.load(stream, arma::arma_binary))
+      {
+        Clear();
+        return false;
+      }
+
+      entries[name] = value;
+    }
+
+    return true;
+  }
+
+ private:
+  //! Return the entry with the given name, or throw if there is none.
+  const arma::mat& Entry(const std::string& name) const
+  {
+    std::map<std::string, arma::mat>::const_iterator it = entries.find(name);
+    if (it == entries.end())
+    {
+      throw std::runtime_error("OptimizerState: no entry named '" + name +
+          "'");
+    }
+
+    return it->second;
+  }
+
+  //! Return the scalar with the given name, or throw if there is none.
+  double Scalar(const std::string& name) const
+  {
+    const arma::mat& entry = Entry(name);
+    if (entry.n_elem != 1)
+    {
+      throw std::runtime_error("OptimizerState: entry '" + name +
+          "' is not a scalar");
+    }
+
+    return entry(0);
+  }
+
+  //! The stored entries.
+  std::map<std::string, arma::mat> entries;
+};
+
+/**
+ * Detect whether a policy can store its state in an OptimizerState, that is,
+ * whether it has the methods
+ *
+ *   void Save(OptimizerState& state) const;
+ *   void Load(const OptimizerState& state);
+ */
+template<typename PolicyType>
+struct HasStateMethods
+{
+  template<typename P>
+  static auto Check(int) -> decltype(
+      std::declval<const P&>().Save(std::declval<OptimizerState&>()),
+      std::declval<P&>().Load(std::declval<const OptimizerState&>()),
+      std::true_type());
+  template<typename>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+//! Store the state of a policy that has a Save() method.
+template<typename PolicyType>
+typename std::enable_if<HasStateMethods<PolicyType>::value>::type
+SavePolicyState(const PolicyType& policy, OptimizerState& state)
+{
+  policy.Save(state);
+}
+
+//! A policy without a Save() method has no state to store.
+template<typename PolicyType>
+typename std::enable_if<!HasStateMethods<PolicyType>::value>::type
+SavePolicyState(const PolicyType& /* policy */, OptimizerState& /* state */)
+{ }
+
+//! Restore the state of a policy that has a Load() method.
+template<typename PolicyType>
+typename std::enable_if<HasStateMethods<PolicyType>::value>::type
+LoadPolicyState(PolicyType& policy, const OptimizerState& state)
+{
+  policy.Load(state);
+}
+
+//! A policy without a Load() method has no state to restore.
+template<typename PolicyType>
+typename std::enable_if<!HasStateMethods<PolicyType>::value>::type
+LoadPolicyState(PolicyType& /* policy */, const OptimizerState& /* state */)
+{ }
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,242 @@
+/**
+ * @file profile.hpp
+ * @author Ryan Curtin
+ *
+ * Optional profiling of optimizers: the number of calls to the objective
+ * function and the time spent in the objective function versus the optimizer
+ * itself.  Profiling is only done if ENS_PROFILE is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PROFILE_HPP
+#define ENSMALLEN_UTILITY_PROFILE_HPP
+
+#include <cstddef>
+#include <ostream>
+
+#include "trace.hpp"
+
+#ifdef ENS_PROFILE
+  #include <atomic>
+  #include <chrono>
+#endif
+
+namespace ens {
+
+/**
+ * The profiling report of one call to Optimize().  Every optimizer holds the
+ * report of its last optimization, accessible with Profile().  The report is
+ * only filled if ensmallen is compiled with ENS_PROFILE defined; otherwise all
+ * of its values are zero and profiling costs nothing.
+ *
+ * Calls to the objective function are counted in the Function<> wrapper, so a
+ * call to a method the function does not implement itself is counted as the
+ * calls it is made of (for instance, an EvaluateWithGradient() provided by the
+ * wrapper counts as one Evaluate() and one Gradient()).  The counters are
+ * shared by the whole process, so optimizations that run concurrently in
+ * different threads are counted together.  The time spent in the objective
+ * function is summed over all threads, so it may exceed the total time for
+ * optimizers that evaluate the function in parallel.
+ */
+class ProfileReport
+{
+ public:
+  //! Create an empty report.
+  ProfileReport() :
+      evaluations(0),
+      gradients(0),
+      evaluationsWithGradient(0),
+      functionTime(0.0),
+      totalTime(0.0)
+  { /* Nothing to do. */ }
+
+  //! Get the number of calls to Evaluate().
+  size_t Evaluations() const { return evaluations; }
+  //! Modify the number of calls to Evaluate().
+  size_t& Evaluations() { return evaluations; }
+
+  //! Get the number of calls to Gradient().
+  size_t Gradients() const { return gradients; }
+  //! Modify the number of calls to Gradient().
+  size_t& Gradients() { return gradients; }
+
+  //! Get the number of calls to EvaluateWithGradient().
+  size_t EvaluationsWithGradient() const { return evaluationsWithGradient; }
+  //! Modify the number of calls to EvaluateWithGradient().
+  size_t& EvaluationsWithGradient() { return evaluationsWithGradient; }
+
+  //! Get the time (in seconds) spent in the objective function.
+  double FunctionTime() const { return functionTime; }
+  //! Modify the time (in seconds) spent in the objective function.
+  double& FunctionTime() { return functionTime; }
+
+  //! Get the total time (in seconds) of the optimization.
+  double TotalTime() const { return totalTime; }
+  //! Modify the total time (in seconds) of the optimization.
+  double& TotalTime() { return totalTime; }
+
+  //! Get the time (in seconds) spent in the optimizer itself.
+  double OptimizerTime() const
+  {
+    return (totalTime > functionTime) ? totalTime - functionTime : 0.0;
+  }
+
+  //! Print the report to the given stream.
+  void Print(std::ostream& output) const
+  {
+    output << "Evaluate() calls: " << evaluations << std::endl
+        << "Gradient() calls: " << gradients << std::endl
+        << "EvaluateWithGradient() calls: " << evaluationsWithGradient
+        << std::endl
+        << "Time in function: " << functionTime << "s" << std::endl
+        << "Time in optimizer: " << OptimizerTime() << "s" << std::endl
+        << "Total time: " << totalTime << "s" << std::endl;
+  }
+
+ private:
+  //! The number of calls to Evaluate().
+  size_t evaluations;
+  //! The number of calls to Gradient().
+  size_t gradients;
+  //! The number of calls to EvaluateWithGradient().
+  size_t evaluationsWithGradient;
+  //! The time spent in the objective function.
+  double functionTime;
+  //! The total time of the optimization.
+  double totalTime;
+};
+
+#ifdef ENS_PROFILE
+
+namespace profile {
+
+//! The kinds of objective function calls that are counted.
+enum CallType
+{
+  Evaluate,
+  Gradient,
+  EvaluateWithGradient
+};
+
+//! Process-wide counters of objective function calls.
+struct Counters
+{
+  std::atomic<size_t> calls[3];
+  std::atomic<long long> functionNanoseconds;
+};
+
+//! Get the process-wide counters.
+inline Counters& GlobalCounters()
+{
+  static Counters counters = { { { 0 }, { 0 }, { 0 } }, { 0 } };
+  return counters;
+}
+
+//! Get the number of function calls in progress on this thread.
+inline size_t& CallDepth()
+{
+  static thread_local size_t depth = 0;
+  return depth;
+}
+
+/**
+ * Count one call of the objective function, and time it for as long as this
+ * object lives.  Calls made while another call is being timed on the same
+ * thread are only counted, so that time is never counted twice.
+ */
+class FunctionCall
+{
+ public:
+  FunctionCall(const CallType type) :
+      start(std::chrono::steady_clock::now())
+  {
+    ++GlobalCounters().calls[type];
+    ++CallDepth();
+  }
+
+  ~FunctionCall()
+  {
+    if (--CallDepth() == 0)
+    {
+      GlobalCounters().functionNanoseconds +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count();
+    }
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Fill a ProfileReport with everything that happens while this object lives.
+ */
+class OptimizerScope
+{
+ public:
+  OptimizerScope(ProfileReport& report) :
+      report(report),
+      start(std::chrono::steady_clock::now())
+  {
+    Counters& c = GlobalCounters();
+    for (size_t i = 0; i < 3; ++i)
+      calls[i] = c.calls[i];
+    functionNanoseconds = c.functionNanoseconds;
+  }
+
+  ~OptimizerScope()
+  {
+    Counters& c = GlobalCounters();
+    report.Evaluations() = c.calls[Evaluate] - calls[Evaluate];
+    report.Gradients() = c.calls[Gradient] - calls[Gradient];
+    report.EvaluationsWithGradient() = c.calls[EvaluateWithGradient] -
+        calls[EvaluateWithGradient];
+    report.FunctionTime() = (c.functionNanoseconds - functionNanoseconds) /
+        1e9;
+    report.TotalTime() = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+ private:
+  ProfileReport& report;
+  std::chrono::steady_clock::time_point start;
+  size_t calls[3];
+  long long functionNanoseconds;
+};
+
+} // namespace profile
+
+#endif
+
+} // namespace ens
+
+/**
+ * Count (and time) a call to the objective function of the given type
+ * (Evaluate, Gradient or EvaluateWithGradient) until the end of the enclosing
+ * scope.  If ENS_TRACE is defined, the call is also a zone of the trace.
+ */
+#ifdef ENS_PROFILE
+  #define ENS_PROFILE_FUNCTION(TYPE) \
+      ens::profile::FunctionCall ensProfile##TYPE(ens::profile::TYPE); \
+      ENS_TRACE_ZONE(#TYPE)
+#else
+  #define ENS_PROFILE_FUNCTION(TYPE) ENS_TRACE_ZONE(#TYPE)
+#endif
+
+/**
+ * Fill the given ProfileReport with the calls and time until the end of the
+ * enclosing scope; use at the start of Optimize().  If ENS_TRACE is defined,
+ * the optimization is also a zone of the trace.
+ */
+#ifdef ENS_PROFILE
+  #define ENS_PROFILE_OPTIMIZER(REPORT) \
+      ens::profile::OptimizerScope ensProfileScope(REPORT); \
+      ENS_TRACE_ZONE("Optimize")
+#else
+  #define ENS_PROFILE_OPTIMIZER(REPORT) ENS_TRACE_ZONE("Optimize")
+#endif
+
+#endif
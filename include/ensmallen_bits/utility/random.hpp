@@ -0,0 +1,353 @@
+/**
+ * @file random.hpp
+ * @author Marcus Edel
+ *
+ * The random number generator used by the optimizers: counter-based Philox
+ * streams, with one stream per optimization and per parallel task, all derived
+ * from one library seed.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_RANDOM_HPP
+#define ENSMALLEN_UTILITY_RANDOM_HPP
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace ens {
+
+/**
+ * A stream of random numbers from the Philox4x32-10 counter-based generator.
+ * The n'th block of four 32-bit numbers of a stream is a bijective hash of
+ * (stream, n) keyed with the seed, so streams with the same seed and different
+ * stream ids never overlap, and a stream can be created anywhere (for
+ * instance, one per chain or per candidate of a parallel loop) without any
+ * shared state.  The numbers only depend on the seed and the stream id, not on
+ * the platform or the number of threads.
+ *
+ * The generator satisfies the UniformRandomBitGenerator requirements, so it
+ * can also be used with the distributions of <random>.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Salmon2011,
+ *   title     = {Parallel Random Numbers: As Easy as 1, 2, 3},
+ *   author    = {Salmon, John K. and Moraes, Mark A. and Dror, Ron O. and
+ *                Shaw, David E.},
+ *   booktitle = {Proceedings of the International Conference for High
+ *                Performance Computing, Networking, Storage and Analysis},
+ *   year      = {2011}
+ * }
+ * @endcode
+ */
+class RandomGenerator
+{
+ public:
+  typedef uint32_t result_type;
+
+  /**
+   * Create the stream with the given id of the given seed.
+   *
+   * @param seed The seed (the key of the generator).
+   * @param stream The id of the stream.
+   */
+  RandomGenerator(const uint64_t seed = 0, const uint64_t stream = 0)
+  {
+    Seed(seed, stream);
+  }
+
+  /**
+   * Restart the generator as the stream with the given id of the given seed.
+   *
+   * @param seed The seed (the key of the generator).
+   * @param stream The id of the stream.
+   */
+  void Seed(const uint64_t seed, const uint64_t stream = 0)
+  {
+    this->seed = seed;
+    this->stream = stream;
+    block = 0;
+    position = 4;
+    hasNormal = false;
+  }
+
+  //! Get the smallest value returned by operator().
+  static constexpr result_type min() { return 0; }
+  //! Get the largest value returned by operator().
+  static constexpr result_type max()
+  { return std::numeric_limits<result_type>::max(); }
+
+  //! Get the next 32 random bits.
+  result_type operator()()
+  {
+    if (position == 4)
+    {
+      Generate();
+      position = 0;
+    }
+
+    return output[position++];
+  }
+
+  //! Get the next 64 random bits.
+  uint64_t Next64()
+  {
+    const uint64_t high = (*this)();
+    return (high << 32) | (*this)();
+  }
+
+  //! Get a uniform random number from [0, 1), with 53 random bits.
+  double Uniform()
+  {
+    return (Next64() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  //! Get a standard normal random number (Box-Muller).
+  double Normal()
+  {
+    if (hasNormal)
+    {
+      hasNormal = false;
+      return normal;
+    }
+
+    const double radius = std::sqrt(-2.0 * std::log(1.0 - Uniform()));
+    const double angle = 6.283185307179586 * Uniform();
+    normal = radius * std::sin(angle);
+    hasNormal = true;
+    return radius * std::cos(angle);
+  }
+
+  //! Get a uniform random integer from [0, n), for n > 0.
+  size_t Integer(const size_t n)
+  {
+    // Reject the lowest 2^64 mod n values, so the result is not biased.
+    const uint64_t threshold = (uint64_t(0) - uint64_t(n)) % uint64_t(n);
+    uint64_t x;
+    do
+    {
+      x = Next64();
+    } while (x < threshold);
+
+    return x % n;
+  }
+
+  //! Fill the given matrix (or cube) with uniform random numbers from [0, 1).
+  template<typename MatType>
+  void Randu(MatType& m)
+  {
+    typedef typename MatType::elem_type ElemType;
+    ElemType* mem = m.memptr();
+    for (size_t i = 0; i < m.n_elem; ++i)
+      mem[i] = ElemType(Uniform());
+  }
+
+  //! Fill the given matrix (or cube) with standard normal random numbers.
+  template<typename MatType>
+  void Randn(MatType& m)
+  {
+    typedef typename MatType::elem_type ElemType;
+    ElemType* mem = m.memptr();
+    for (size_t i = 0; i < m.n_elem; ++i)
+      mem[i] = ElemType(Normal());
+  }
+
+  //! Shuffle the elements of the given vector in place (Fisher-Yates).
+  template<typename VecType>
+  void Shuffle(VecType& v)
+  {
+    for (size_t i = v.n_elem; i > 1; --i)
+      std::swap(v[i - 1], v[Integer(i)]);
+  }
+
+  //! Get the seed of the generator.
+  uint64_t GetSeed() const { return seed; }
+  //! Get the id of the stream.
+  uint64_t Stream() const { return stream; }
+
+ private:
+  //! Compute the next block of four numbers.
+  void Generate()
+  {
+    uint32_t ctr[4] = { uint32_t(block), uint32_t(block >> 32),
+        uint32_t(stream), uint32_t(stream >> 32) };
+    uint32_t key[2] = { uint32_t(seed), uint32_t(seed >> 32) };
+    for (size_t round = 0; round < 10; ++round)
+    {
+      if (round > 0)
+      {
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+      }
+
+      const uint64_t p0 = uint64_t(0xD2511F53u) * ctr[0];
+      const uint64_t p1 = uint64_t(0xCD9E8D57u) * ctr[2];
+      const uint32_t next[4] = { uint32_t(p1 >> 32) ^ ctr[1] ^ key[0],
+          uint32_t(p1), uint32_t(p0 >> 32) ^ ctr[3] ^ key[1], uint32_t(p0) };
+      for (size_t k = 0; k < 4; ++k)
+        ctr[k] = next[k];
+    }
+
+    for (size_t k = 0; k < 4; ++k)
+      output[k] = ctr[k];
+    ++block;
+  }
+
+  //! The seed (the key of the generator).
+  uint64_t seed;
+  //! The id of the stream.
+  uint64_t stream;
+  //! The index of the next block.
+  uint64_t block;
+  //! The current block.
+  uint32_t output[4];
+  //! The position of the next number in the current block.
+  size_t position;
+  //! Whether the second number of the last Box-Muller pair is unused.
+  bool hasNormal;
+  //! The second number of the last Box-Muller pair.
+  double normal;
+};
+
+namespace detail {
+
+//! The library seed, and the number of generators created from it.
+struct RandomState
+{
+  std::atomic<bool> seeded;
+  std::atomic<uint64_t> seed;
+  std::atomic<uint64_t> streams;
+  std::atomic<uint64_t> version;
+};
+
+//! Get the process-wide state of the library seed.
+inline RandomState& GlobalRandomState()
+{
+  static RandomState state = { { false }, { 0 }, { 0 }, { 0 } };
+  return state;
+}
+
+//! Get the generator installed on this thread by a RandomScope, if any.
+inline RandomGenerator*& CurrentRandom()
+{
+  static thread_local RandomGenerator* current = NULL;
+  return current;
+}
+
+} // namespace detail
+
+/**
+ * Set the library seed.  After this, the n'th generator returned by
+ * NewRandomGenerator() is the stream n of this seed, so that a program that
+ * runs the same optimizations in the same order gets the same results, no
+ * matter how many threads are used.
+ *
+ * @param seed The library seed.
+ */
+inline void RandomSeed(const uint64_t seed)
+{
+  detail::RandomState& state = detail::GlobalRandomState();
+  state.seed = seed;
+  state.streams = 0;
+  state.seeded = true;
+  ++state.version;
+}
+
+/**
+ * Forget the library seed set by RandomSeed(), so that the seeds of the new
+ * generators are drawn from Armadillo's generator again (the default).
+ */
+inline void ResetRandomSeed()
+{
+  detail::RandomState& state = detail::GlobalRandomState();
+  state.seeded = false;
+  ++state.version;
+}
+
+/**
+ * Get a new independent generator; each optimization that uses random numbers
+ * takes one at its start.  If RandomSeed() was called, this is the next stream
+ * of the library seed; otherwise its seed is drawn from Armadillo's generator,
+ * so that arma::arma_rng::set_seed() still makes the optimizations
+ * reproducible.  This can be called from any thread.
+ */
+inline RandomGenerator NewRandomGenerator()
+{
+  detail::RandomState& state = detail::GlobalRandomState();
+  if (state.seeded)
+    return RandomGenerator(state.seed, state.streams++);
+
+  const arma::uvec words = arma::randi<arma::uvec>(2,
+      arma::distr_param(0, std::numeric_limits<int>::max()));
+  return RandomGenerator((uint64_t(words[0]) << 31) ^ uint64_t(words[1]));
+}
+
+/**
+ * Get the generator of the calling thread: the one installed by the innermost
+ * RandomScope on this thread, or else a generator of the thread taken from
+ * NewRandomGenerator() (and taken again after each call to RandomSeed()).  All
+ * the randomness of the optimizers and their policies goes through this, so
+ * custom policies should use it too.
+ */
+inline RandomGenerator& Random()
+{
+  RandomGenerator* current = detail::CurrentRandom();
+  if (current != NULL)
+    return *current;
+
+  static thread_local RandomGenerator fallback;
+  static thread_local uint64_t version = 0;
+  static thread_local bool initialized = false;
+  const uint64_t globalVersion = detail::GlobalRandomState().version;
+  if (!initialized || version != globalVersion)
+  {
+    fallback = NewRandomGenerator();
+    version = globalVersion;
+    initialized = true;
+  }
+
+  return fallback;
+}
+
+/**
+ * Install the given generator as the generator of the calling thread (see
+ * Random()) for as long as this object lives.  Optimizers install a new
+ * generator for Optimize(), and one stream per task in their parallel loops,
+ * so that the results do not depend on the scheduling of the threads.
+ *
+ * @code
+ * RandomGenerator generator = NewRandomGenerator();
+ * RandomScope scope(generator);
+ * @endcode
+ */
+class RandomScope
+{
+ public:
+  //! Install the given generator on this thread.
+  explicit RandomScope(RandomGenerator& generator) :
+      previous(detail::CurrentRandom())
+  {
+    detail::CurrentRandom() = &generator;
+  }
+
+  //! Restore the previous generator of this thread.
+  ~RandomScope() { detail::CurrentRandom() = previous; }
+
+ private:
+  RandomScope(const RandomScope&);
+  RandomScope& operator=(const RandomScope&);
+
+  //! The generator installed before this one.
+  RandomGenerator* previous;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * @file trace.hpp
+ * @author Ryan Curtin
+ *
+ * Optional timeline tracing of optimizers: scoped zones around the phases of
+ * the optimizers (function evaluations, steps of the update policies, line
+ * searches, factorizations, ...), written in the Chrome trace event format.
+ * Tracing is only done if ENS_TRACE is defined.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_TRACE_HPP
+#define ENSMALLEN_UTILITY_TRACE_HPP
+
+#include <cstddef>
+#include <ostream>
+
+#ifdef ENS_TRACE
+  #include <chrono>
+  #include <iomanip>
+  #include <memory>
+  #include <mutex>
+  #include <vector>
+#endif
+
+namespace ens {
+
+#ifdef ENS_TRACE
+
+namespace trace {
+
+//! One zone of the timeline, in nanoseconds since the start of the trace.
+struct Event
+{
+  const char* name;
+  long long start;
+  long long duration;
+};
+
+//! The zones recorded by one thread.
+struct Track
+{
+  size_t id;
+  std::vector<Event> events;
+};
+
+//! The tracks of all the threads that recorded a zone.
+struct Registry
+{
+  Registry() : origin(std::chrono::steady_clock::now()) { }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Track>> tracks;
+  std::chrono::steady_clock::time_point origin;
+};
+
+//! Get the process-wide registry of tracks.
+inline Registry& GlobalRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+//! Get the time since the start of the trace, in nanoseconds.
+inline long long Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - GlobalRegistry().origin).count();
+}
+
+/**
+ * Get the track of this thread, which is registered the first time the thread
+ * records a zone.  The tracks are never freed, so that a thread (of a thread
+ * pool, say) keeps its track for the whole process.
+ */
+inline Track& CurrentTrack()
+{
+  static thread_local Track* track = nullptr;
+  if (track == nullptr)
+  {
+    Registry& registry = GlobalRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.tracks.emplace_back(new Track());
+    track = registry.tracks.back().get();
+    track->id = registry.tracks.size() - 1;
+    track->events.reserve(4096);
+  }
+
+  return *track;
+}
+
+/**
+ * Record a zone of the timeline for as long as this object lives.  The zone is
+ * only stored in the track of the thread when it ends, without any lock.  The
+ * name must be a string literal (or otherwise live until the trace is
+ * written).
+ */
+class Zone
+{
+ public:
+  Zone(const char* name) : name(name), start(Now()) { }
+
+  ~Zone()
+  {
+    const long long end = Now();
+    CurrentTrack().events.push_back(Event{ name, start, end - start });
+  }
+
+ private:
+  const char* name;
+  long long start;
+};
+
+} // namespace trace
+
+#endif
+
+/**
+ * Write the zones recorded so far in the Chrome trace event format, which can
+ * be opened with chrome://tracing or https://ui.perfetto.dev.  Every thread
+ * that recorded a zone has its own track.  This must not be called while
+ * zones are being recorded.  If ENS_TRACE is not defined, the trace is empty.
+ *
+ * @param output Stream to write to.
+ */
+inline void WriteTrace(std::ostream& output)
+{
+  output << "{\"traceEvents\": [";
+  #ifdef ENS_TRACE
+    trace::Registry& registry = trace::GlobalRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const std::ios_base::fmtflags flags = output.flags();
+    const std::streamsize precision = output.precision();
+    output << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    for (size_t t = 0; t < registry.tracks.size(); ++t)
+    {
+      const trace::Track& track = *registry.tracks[t];
+      output << (first ? "\n" : ",\n") << "  {\"name\": \"thread_name\", "
+          << "\"ph\": \"M\", \"pid\": 1, \"tid\": " << track.id
+          << ", \"args\": {\"name\": \"thread " << track.id << "\"}}";
+      first = false;
+
+      // The times are in microseconds.
+      for (size_t i = 0; i < track.events.size(); ++i)
+      {
+        const trace::Event& e = track.events[i];
+        output << ",\n  {\"name\": \"" << e.name << "\", \"cat\": "
+            << "\"ensmallen\", \"ph\": \"X\", \"ts\": " << (e.start / 1e3)
+            << ", \"dur\": " << (e.duration / 1e3) << ", \"pid\": 1, "
+            << "\"tid\": " << track.id << "}";
+      }
+    }
+
+    output.flags(flags);
+    output.precision(precision);
+    output << (first ? "" : "\n");
+  #endif
+  output << "]}" << std::endl;
+}
+
+/**
+ * Forget the zones recorded so far.  This must not be called while zones are
+ * being recorded.
+ */
+inline void ClearTrace()
+{
+  #ifdef ENS_TRACE
+    trace::Registry& registry = trace::GlobalRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t t = 0; t < registry.tracks.size(); ++t)
+      registry.tracks[t]->events.clear();
+  #endif
+}
+
+/**
+ * Get the number of zones recorded so far (0 if ENS_TRACE is not defined).
+ * This must not be called while zones are being recorded.
+ */
+inline size_t TraceSize()
+{
+  size_t size = 0;
+  #ifdef ENS_TRACE
+    trace::Registry& registry = trace::GlobalRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t t = 0; t < registry.tracks.size(); ++t)
+      size += registry.tracks[t]->events.size();
+  #endif
+  return size;
+}
+
+} // namespace ens
+
+#define ENS_TRACE_CONCAT_INNER(A, B) A##B
+#define ENS_TRACE_CONCAT(A, B) ENS_TRACE_CONCAT_INNER(A, B)
+
+/**
+ * Record a zone with the given name (a string literal) until the end of the
+ * enclosing scope.  If ENS_TRACE is not defined, this is removed at compile
+ * time.  Only one zone can be opened on each line.
+ */
+#ifdef ENS_TRACE
+  #define ENS_TRACE_ZONE(NAME) \
+      ens::trace::Zone ENS_TRACE_CONCAT(ensTraceZone, __LINE__)(NAME)
+#else
+  #define ENS_TRACE_ZONE(NAME)
+#endif
+
+#endif
@@ -35,43 +35,71 @@ class WNGradUpdate
 {
  public:
   /**
-   * Construct the WNGrad update policy.
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
    */
-  WNGradUpdate() : b(1.0)
+  template<typename MatType, typename GradType>
+  class Policy
   {
-    // Nothing to do here.
-  }
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(WNGradUpdate& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */) :
+        b(1.0)
+    {
+      // Nothing to do here.
+    }
 
-  /**
-   * The Initialize method is called by SGD Optimizer method before the start of
-   * the iteration update process.
-   *
-   * @param rows Number of rows in the gradient matrix.
-   * @param cols Number of columns in the gradient matrix.
-   */
-  void Initialize(const size_t /* rows */, const size_t /* cols */)
-  {
-    // Nothing to do here.
-  }
+    /**
+     * Update step for WNGrad.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      b += std::pow(stepSize, 2.0) / b * std::pow(arma::norm(gradient), 2);
+      iterate -= stepSize * gradient / b;
+    }
 
-  /**
-   * Update step for WNGrad.
-   *
-   * @param iterate Parameters that minimize the function.
-   * @param stepSize Step size to be used for the given iteration.
-   * @param gradient The gradient matrix.
-   */
-  void Update(arma::mat& iterate,
-              const double stepSize,
-              const arma::mat& gradient)
-  {
-    b += std::pow(stepSize, 2.0) / b * std::pow(arma::norm(gradient), 2);
-    iterate -= stepSize * gradient / b;
-  }
+    /**
+     * Store the state of the policy in the given state, so that the
+     * optimization can be resumed later.
+     *
+     * @param state The state to store to.
+     */
+    void Save(OptimizerState& state) const
+    {
+      state.Set("b", b);
+    }
+
+    /**
+     * Restore the state of the policy from the given state.
+     *
+     * @param state The state to restore from.
+     */
+    void Load(const OptimizerState& state)
+    {
+      state.Get("b", b);
+    }
 
- private:
-  //! Learning rate adjustment.
-  double b;
+   private:
+    //! Learning rate adjustment.
+    double b;
+  };
 };
 
 } // namespace ens
@@ -0,0 +1,43 @@
+/**
+ * @file ensmallen_instantiations.cpp
+ * @author Marcus Edel
+ *
+ * Explicit instantiations of the most used optimizers on the type-erased
+ * function wrappers.  This file is compiled into the ensmallen_instantiations
+ * library; the programs that link it define ENS_USE_EXTERN_TEMPLATES so that
+ * the instantiations are not compiled again.  The library must be compiled
+ * with the same configuration macros (ENS_PROFILE and so on) as the programs.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+
+namespace ens {
+
+template double L_BFGS::Optimize<AnyDifferentiableFunction>(
+    AnyDifferentiableFunction& function,
+    arma::mat& iterate);
+
+template double GradientDescent::Optimize<AnyDifferentiableFunction>(
+    AnyDifferentiableFunction& function,
+    arma::mat& iterate);
+
+template double
+SGD<VanillaUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+template double
+SGD<MomentumUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+template double
+SGD<AdamUpdate>::Optimize<AnySeparableFunction, arma::mat, arma::mat>(
+    AnySeparableFunction& function,
+    arma::mat& iterate);
+
+} // namespace ens
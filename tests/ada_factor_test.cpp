@@ -0,0 +1,105 @@
+/**
+ * @file ada_factor_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the AdaFactor optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run AdaFactor on the SGD test function, which has a vector iterate and so
+ * uses the full second moment estimate.
+ */
+TEST_CASE("AdaFactorSGDFunction", "[AdaFactorTest]")
+{
+  SGDTestFunction f;
+  AdaFactor optimizer(1e-3, 1, 1e-30, 1.0, 0.8, 0.0, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(std::abs(coordinates[0]) <= 0.1);
+  REQUIRE(std::abs(coordinates[1]) <= 0.1);
+  REQUIRE(std::abs(coordinates[2]) <= 0.1);
+}
+
+/**
+ * Run AdaFactor on logistic regression and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("AdaFactorLogisticRegressionTest", "[AdaFactorTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  AdaFactor optimizer(0.01, 32, 1e-30, 1.0, 0.8, 0.9);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that the state of a matrix iterate is factored, that the first step
+ * on a rank-1 squared gradient is exact, and that the policy minimizes a
+ * quadratic with a matrix iterate.
+ */
+TEST_CASE("AdaFactorFactoredUpdateTest", "[AdaFactorTest]")
+{
+  const size_t rows = 60;
+  const size_t cols = 40;
+
+  AdaFactorUpdate update;
+  AdaFactorUpdate::Policy<arma::mat, arma::mat> policy(update, rows, cols);
+  REQUIRE(policy.StateSize() == rows + cols);
+
+  // At the first step, the squared gradient of an outer product is estimated
+  // exactly, so every element moves by the step size.
+  const arma::vec a = arma::randu<arma::vec>(rows) + 0.5;
+  const arma::rowvec b = arma::randu<arma::rowvec>(cols) + 0.5;
+  arma::mat gradient = a * b;
+  gradient.col(1) *= -1.0;
+
+  arma::mat iterate(rows, cols, arma::fill::zeros);
+  policy.Update(iterate, 0.01, gradient);
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+    REQUIRE(std::abs(iterate[i]) == Approx(0.01).epsilon(1e-6));
+  REQUIRE(arma::all(arma::vectorise(iterate.col(1)) > 0.0));
+
+  // Minimize ||X - T||^2, with momentum.
+  AdaFactorUpdate momentumUpdate(1e-30, 1.0, 0.8, 0.9);
+  AdaFactorUpdate::Policy<arma::mat, arma::mat> momentumPolicy(momentumUpdate,
+      rows, cols);
+  REQUIRE(momentumPolicy.StateSize() == rows + cols + rows * cols);
+
+  const arma::mat target = arma::randu<arma::mat>(rows, cols);
+  iterate.zeros();
+  for (size_t i = 0; i < 3000; ++i)
+  {
+    gradient = 2 * (iterate - target);
+    momentumPolicy.Update(iterate, 0.01, gradient);
+  }
+
+  REQUIRE(arma::abs(iterate - target).max() <= 0.05);
+}
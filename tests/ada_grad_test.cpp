@@ -33,6 +33,24 @@ TEST_CASE("SimpleAdaGradTestFunction", "[AdaGradTest]")
   REQUIRE(coordinates[2] == Approx(0.0).margin(0.003));
 }
 
+/**
+ * Tests the sparse AdaGrad update on a function with sparse gradients.
+ */
+TEST_CASE("SparseAdaGradTestFunction", "[AdaGradTest]")
+{
+  SparseTestFunction f;
+  AdaGrad optimizer(0.5, 1, 1e-8, 200000, 1e-12, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.05));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.05));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.05));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.05));
+}
+
 /**
  * Run AdaGrad on logistic regression and make sure the results are acceptable.
  */
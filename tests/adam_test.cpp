@@ -128,6 +128,64 @@ TEST_CASE("SimpleAdamTestFunction", "[AdamTest]")
   REQUIRE(coordinates[2] == Approx(0.0).margin(0.3));
 }
 
+/**
+ * Tests the Adam optimizer with single-precision coordinates.
+ */
+TEST_CASE("SimpleAdamTestFunctionFloat", "[AdamTest]")
+{
+  SGDTestFunction f;
+  Adam optimizer(1e-3, 1, 0.9, 0.999, 1e-8, 500000, 1e-5, true);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.3));
+}
+
+/**
+ * Make sure the same Adam optimizer can be used with double-precision and
+ * single-precision coordinates one after another, even when the update policy
+ * is not reset between calls.
+ */
+TEST_CASE("AdamMixedPrecisionReuseTest", "[AdamTest]")
+{
+  SGDTestFunction f;
+  SGD<AdamUpdate> optimizer(1e-3, 1, 500000, 1e-5, true, AdamUpdate(),
+      NoDecay(), false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  arma::fmat fcoordinates = f.GetInitialPoint<arma::fmat>();
+  optimizer.Optimize(f, fcoordinates);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(coordinates[i] == Approx(0.0).margin(0.3));
+    REQUIRE(fcoordinates[i] == Approx(0.0).margin(0.3));
+  }
+}
+
+/**
+ * Tests the lazy sparse Adam update on a function with sparse gradients.
+ */
+TEST_CASE("SparseAdamTestFunction", "[AdamTest]")
+{
+  SparseTestFunction f;
+  Adam optimizer(0.01, 1, 0.9, 0.999, 1e-8, 200000, 1e-12, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates[0] == Approx(2.0).margin(0.1));
+  REQUIRE(coordinates[1] == Approx(1.0).margin(0.1));
+  REQUIRE(coordinates[2] == Approx(1.5).margin(0.1));
+  REQUIRE(coordinates[3] == Approx(4.0).margin(0.1));
+}
+
 /**
  * Tests the AdaMax optimizer using a simple test function.
  */
@@ -418,3 +476,81 @@ TEST_CASE("PadamLogisticRegressionTest", "[AdamTest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Make sure that the single-pass steps of AdamUpdate and AMSGradUpdate match
+ * the steps written as matrix expressions.
+ */
+TEST_CASE("AdamFusedUpdateTest", "[AdamTest]")
+{
+  const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8, stepSize = 0.01;
+
+  AdamUpdate adam(epsilon, beta1, beta2);
+  AdamUpdate::Policy<arma::mat, arma::mat> adamPolicy(adam, 7, 3);
+  AMSGradUpdate amsgrad(epsilon, beta1, beta2);
+  AMSGradUpdate::Policy<arma::mat, arma::mat> amsgradPolicy(amsgrad, 7, 3);
+
+  arma::mat adamIterate = arma::randn<arma::mat>(7, 3);
+  arma::mat amsgradIterate(adamIterate);
+  arma::mat adamExpected(adamIterate), amsgradExpected(adamIterate);
+  arma::mat m(7, 3, arma::fill::zeros), v(7, 3, arma::fill::zeros);
+  arma::mat vImproved(7, 3, arma::fill::zeros);
+
+  for (size_t t = 1; t <= 5; ++t)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(7, 3);
+    adamPolicy.Update(adamIterate, stepSize, gradient);
+    amsgradPolicy.Update(amsgradIterate, stepSize, gradient);
+
+    m = beta1 * m + (1 - beta1) * gradient;
+    v = beta2 * v + (1 - beta2) * (gradient % gradient);
+    vImproved = arma::max(vImproved, v);
+
+    const double step = stepSize * std::sqrt(1 - std::pow(beta2, t)) /
+        (1 - std::pow(beta1, t));
+    adamExpected -= step * m / (arma::sqrt(v) + epsilon);
+    amsgradExpected -= step * m / (arma::sqrt(vImproved) + epsilon);
+  }
+
+  CheckMatrices(adamIterate, adamExpected, 1e-10);
+  CheckMatrices(amsgradIterate, amsgradExpected, 1e-10);
+}
+
+/**
+ * Make sure the Adam step gives the same result with its state on huge pages,
+ * and that the aligned allocator aligns small and large blocks.
+ */
+TEST_CASE("AdamHugePagesTest", "[AdamTest]")
+{
+  // Large enough for the state to span several huge pages.
+  const size_t elements = (size_t(3) << 20) / sizeof(double) + 7;
+  arma::mat iterate = arma::randn<arma::mat>(elements, 1);
+  arma::mat hugeIterate(iterate);
+
+  AdamUpdate update;
+  AdamUpdate::Policy<arma::mat, arma::mat> policy(update, elements, 1);
+  SetHugePages(TransparentHugePages);
+  AdamUpdate::Policy<arma::mat, arma::mat> hugePolicy(update, elements, 1);
+  SetHugePages(NoHugePages);
+
+  for (size_t t = 0; t < 3; ++t)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(elements, 1);
+    policy.Update(iterate, 0.01, gradient);
+    hugePolicy.Update(hugeIterate, 0.01, gradient);
+  }
+
+  REQUIRE(arma::approx_equal(iterate, hugeIterate, "absdiff", 0.0));
+
+  SetHugePages(ExplicitHugePages);
+  const size_t sizes[] = { 1, 100, size_t(5) << 20 };
+  for (const size_t bytes : sizes)
+  {
+    char* memory = (char*) AlignedAllocate(bytes);
+    REQUIRE(memory != NULL);
+    REQUIRE((uintptr_t) memory % ENS_MEMORY_ALIGNMENT == 0);
+    memory[bytes - 1] = 1;
+    AlignedFree(memory);
+  }
+  SetHugePages(NoHugePages);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file admm_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the consensus ADMM optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The least squares objective 0.5 ||A x - b||^2 of one block of rows.
+ */
+class BlockLeastSquaresFunction
+{
+ public:
+  BlockLeastSquaresFunction(const arma::mat& a, const arma::vec& b) :
+      a(a), b(b) { }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& g)
+  {
+    const arma::vec r = a * x - b;
+    g = a.t() * r;
+    return 0.5 * arma::dot(r, r);
+  }
+
+ private:
+  arma::mat a;
+  arma::vec b;
+};
+
+/**
+ * Split the rows of a least squares problem into the given number of blocks.
+ */
+std::vector<BlockLeastSquaresFunction> SplitLeastSquares(const arma::mat& a,
+                                                         const arma::vec& b,
+                                                         const size_t blocks)
+{
+  std::vector<BlockLeastSquaresFunction> functions;
+  const size_t rows = a.n_rows / blocks;
+  for (size_t j = 0; j < blocks; ++j)
+  {
+    functions.push_back(BlockLeastSquaresFunction(
+        a.rows(j * rows, (j + 1) * rows - 1),
+        b.subvec(j * rows, (j + 1) * rows - 1)));
+  }
+  return functions;
+}
+
+/**
+ * Without a regularizer, consensus ADMM over blocks of rows must find the
+ * least squares solution of all the rows.
+ */
+TEST_CASE("ConsensusADMMLeastSquaresTest", "[ConsensusADMMTest]")
+{
+  arma::arma_rng::set_seed(42);
+  const arma::mat a = arma::randn<arma::mat>(100, 10);
+  const arma::vec b = a * arma::linspace<arma::vec>(-2, 2, 10) +
+      0.1 * arma::randn<arma::vec>(100);
+  std::vector<BlockLeastSquaresFunction> functions = SplitLeastSquares(a, b,
+      5);
+
+  ConsensusADMM<> admm(L_BFGS(), 1.0, 1000, 1e-8, 1e-8);
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+  admm.Optimize(functions, coordinates);
+
+  const arma::vec solution = arma::solve(a.t() * a, a.t() * b);
+  REQUIRE(admm.Iterations() < 1000);
+  for (size_t i = 0; i < 10; ++i)
+    REQUIRE(coordinates[i] == Approx(solution[i]).margin(1e-4));
+}
+
+/**
+ * Solve a lasso problem split over blocks of rows, with the l1 penalty applied
+ * by the consensus step, and check the optimality conditions.
+ */
+TEST_CASE("ConsensusADMMLassoTest", "[ConsensusADMMTest]")
+{
+  arma::arma_rng::set_seed(42);
+  const arma::mat a = arma::randn<arma::mat>(100, 20);
+  arma::vec truth(20, arma::fill::zeros);
+  truth.subvec(0, 4) = arma::linspace<arma::vec>(1, 5, 5);
+  const arma::vec b = a * truth + 0.1 * arma::randn<arma::vec>(100);
+  std::vector<BlockLeastSquaresFunction> functions = SplitLeastSquares(a, b,
+      4);
+
+  const double lambda = 5.0;
+  ConsensusADMM<L_BFGS, L1Penalty> admm(L_BFGS(), 1.0, 1000, 1e-8, 1e-8,
+      true, L1Penalty(lambda));
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  admm.Optimize(functions, coordinates);
+
+  // The consensus is the output of the proximal step, so it is exactly sparse.
+  REQUIRE(arma::accu(coordinates != 0.0) <= 10);
+
+  const arma::vec g = a.t() * (a * coordinates - b);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    if (coordinates[i] != 0.0)
+    {
+      REQUIRE(g[i] == Approx(coordinates[i] > 0.0 ? -lambda : lambda).margin(
+          1e-2));
+    }
+    else
+    {
+      REQUIRE(std::abs(g[i]) <= lambda + 1e-2);
+    }
+  }
+
+  // The same solution as proximal gradient on all the rows.
+  BlockLeastSquaresFunction f(a, b);
+  ProximalGradient<L1Penalty> fista(1.0, 10000, 1e-12, true, true, 0.5,
+      L1Penalty(lambda));
+  arma::mat fistaCoordinates(20, 1, arma::fill::zeros);
+  fista.Optimize(f, fistaCoordinates);
+  for (size_t i = 0; i < 20; ++i)
+    REQUIRE(coordinates[i] == Approx(fistaCoordinates[i]).margin(1e-3));
+}
@@ -0,0 +1,90 @@
+/**
+ * @file async_parallel_sgd_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the asynchronous parallel SGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Optimize the sparse test function with sparse pushes to the local parameter
+ * server.
+ */
+TEST_CASE("AsyncParallelSGDSparseTest", "[AsyncParallelSGDTest]")
+{
+  SparseTestFunction f;
+  AsyncParallelSGD<> optimizer(100000, 1e-5, true, ConstantStep(0.4));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  // The final value of the objective function should be close to the optimal
+  // value, that is the sum of values at the vertices of the parabolas.
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+
+  // The co-ordinates should be the vertices of the parabolas.
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * With a single worker and dense gradients, AsyncParallelSGD must take the
+ * same steps as SGD.
+ */
+TEST_CASE("AsyncParallelSGDSingleWorkerTest", "[AsyncParallelSGDTest]")
+{
+  SGDTestFunction f;
+
+  StandardSGD sgd(0.0003, 1, 300000, -1, false);
+  arma::mat coordinates1 = f.GetInitialPoint();
+  const double result1 = sgd.Optimize(f, coordinates1);
+
+  AsyncParallelSGD<> optimizer(300000, -1, false, ConstantStep(0.0003));
+  arma::mat coordinates2 = f.GetInitialPoint();
+  const double result2 = optimizer.Optimize<SGDTestFunction, arma::mat,
+      arma::mat>(f, coordinates2);
+
+  REQUIRE(result2 == Approx(result1).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+}
+
+#ifdef ENS_USE_MPI
+
+/**
+ * Every MPI process optimizes the sparse test function, and pushes its updates
+ * to the parameters sharded over all the processes.
+ */
+TEST_CASE("AsyncParallelSGDMPISparseTest", "[AsyncParallelSGDTest]")
+{
+  SparseTestFunction f;
+  MPIParameterServer server;
+
+  // All the workers push the same updates, so the step size is divided
+  // between them.
+  AsyncParallelSGD<ConstantStep, MPIParameterServer> optimizer(100000, 1e-9,
+      true, ConstantStep(0.4 / server.Workers()), 1, 2, 16, server);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.002));
+}
+
+#endif
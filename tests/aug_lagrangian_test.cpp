@@ -19,6 +19,91 @@
 using namespace ens;
 using namespace ens::test;
 
+// The Gockenbach function with batched constraint methods, counting how often
+// each kind of constraint method is called.
+class BatchedGockenbachFunction
+{
+ public:
+  BatchedGockenbachFunction() : singleCalls(0), batchCalls(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  { return f.Evaluate(coordinates); }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  { f.Gradient(coordinates, gradient); }
+
+  size_t NumConstraints() const { return f.NumConstraints(); }
+
+  double EvaluateConstraint(const size_t index, const arma::mat& coordinates)
+  {
+    ++singleCalls;
+    return f.EvaluateConstraint(index, coordinates);
+  }
+
+  void GradientConstraint(const size_t index,
+                          const arma::mat& coordinates,
+                          arma::mat& gradient)
+  {
+    ++singleCalls;
+    f.GradientConstraint(index, coordinates, gradient);
+  }
+
+  void EvaluateConstraints(const arma::mat& coordinates,
+                           arma::vec& constraints)
+  {
+    ++batchCalls;
+    constraints.set_size(f.NumConstraints());
+    for (size_t i = 0; i < f.NumConstraints(); ++i)
+      constraints[i] = f.EvaluateConstraint(i, coordinates);
+  }
+
+  void GradientConstraints(const arma::mat& coordinates,
+                           const arma::vec& weights,
+                           arma::mat& gradient)
+  {
+    ++batchCalls;
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    arma::mat constraintGradient;
+    for (size_t i = 0; i < f.NumConstraints(); ++i)
+    {
+      f.GradientConstraint(i, coordinates, constraintGradient);
+      gradient += weights[i] * constraintGradient;
+    }
+  }
+
+  const arma::mat& GetInitialPoint() const { return f.GetInitialPoint(); }
+
+  size_t singleCalls;
+  size_t batchCalls;
+
+ private:
+  GockenbachFunction f;
+};
+
+// An inner optimizer wrapping L-BFGS that records the tolerance it is called
+// with.
+class RecordingOptimizer
+{
+ public:
+  RecordingOptimizer() : tolerance(1e-6) { lbfgs.MaxIterations() = 1000; }
+
+  template<typename FunctionType>
+  double Optimize(FunctionType& function, arma::mat& coordinates)
+  {
+    tolerances.push_back(tolerance);
+    lbfgs.MinGradientNorm() = tolerance;
+    return lbfgs.Optimize(function, coordinates);
+  }
+
+  double& Tolerance() { return tolerance; }
+
+  std::vector<double> tolerances;
+
+ private:
+  double tolerance;
+  L_BFGS lbfgs;
+};
+
 /**
  * Tests the Augmented Lagrangian optimizer using the
  * AugmentedLagrangianTestFunction class.
@@ -62,3 +147,94 @@ TEST_CASE("GockenbachFunctionTest", "[AugLagrangianTest]")
   REQUIRE(coords[1] == Approx(-1.10778185).epsilon(1e-7));
   REQUIRE(coords[2] == Approx(0.015099932).epsilon(1e-5));
 }
+
+/**
+ * Make sure that the batched constraint methods are used instead of the
+ * per-constraint ones, and give the same result.
+ */
+TEST_CASE("AugLagrangianBatchedConstraintsTest", "[AugLagrangianTest]")
+{
+  REQUIRE(traits::HasBatchConstraintEvaluation<
+      BatchedGockenbachFunction>::value);
+  REQUIRE(traits::HasBatchConstraintGradient<
+      BatchedGockenbachFunction>::value);
+  REQUIRE(!traits::HasBatchConstraintEvaluation<GockenbachFunction>::value);
+
+  BatchedGockenbachFunction f;
+  AugLagrangian aug;
+
+  arma::vec coords = f.GetInitialPoint();
+
+  if (!aug.Optimize(f, coords, 0))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(f.singleCalls == 0);
+  REQUIRE(f.batchCalls > 0);
+
+  REQUIRE(f.Evaluate(coords) == Approx(29.633926).epsilon(1e-7));
+  REQUIRE(coords[0] == Approx(0.12288178).epsilon(1e-5));
+  REQUIRE(coords[1] == Approx(-1.10778185).epsilon(1e-7));
+  REQUIRE(coords[2] == Approx(0.015099932).epsilon(1e-5));
+}
+
+/**
+ * Make sure that the inner tolerance starts at the given value, is tightened
+ * at each iteration down to the tolerance of the inner optimizer, and that the
+ * optimization still converges.
+ */
+TEST_CASE("AugLagrangianInnerToleranceTest", "[AugLagrangianTest]")
+{
+  AugLagrangianTestFunction f;
+  AugLagrangianType<RecordingOptimizer> aug(RecordingOptimizer(), false, 1e-2,
+      0.1);
+
+  arma::vec coords = f.GetInitialPoint();
+  if (!aug.Optimize(f, coords, 0))
+    FAIL("Optimization reported failure.");
+
+  const std::vector<double>& tolerances = aug.InnerOptimizer().tolerances;
+  REQUIRE(tolerances.size() > 5);
+  REQUIRE(tolerances[0] == Approx(1e-2));
+  REQUIRE(tolerances[1] == Approx(1e-3));
+  for (size_t i = 1; i < tolerances.size(); ++i)
+  {
+    REQUIRE(tolerances[i] <= tolerances[i - 1]);
+    REQUIRE(tolerances[i] >= 1e-6);
+  }
+  REQUIRE(tolerances.back() == Approx(1e-6));
+
+  // The tolerance of the inner optimizer is restored at the end.
+  REQUIRE(aug.InnerOptimizer().Tolerance() == Approx(1e-6));
+
+  REQUIRE(f.Evaluate(coords) == Approx(70.0).epsilon(1e-7));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-7));
+  REQUIRE(coords[1] == Approx(4.0).epsilon(1e-7));
+}
+
+/**
+ * With warm starts, an optimization that is interrupted and continued should
+ * take the same path as an uninterrupted one.
+ */
+TEST_CASE("AugLagrangianWarmStartTest", "[AugLagrangianTest]")
+{
+  AugLagrangianTestFunction f;
+  AugLagrangian aug;
+
+  arma::vec coords = f.GetInitialPoint();
+  if (!aug.Optimize(f, coords, 0))
+    FAIL("Optimization reported failure.");
+
+  // Stop after two iterations, then continue until convergence.
+  AugLagrangian warm(true);
+  REQUIRE(warm.WarmStart());
+
+  arma::vec warmCoords = f.GetInitialPoint();
+  REQUIRE(!warm.Optimize(f, warmCoords, 3));
+  REQUIRE(warm.Lambda().n_elem == f.NumConstraints());
+  if (!warm.Optimize(f, warmCoords, 0))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(warmCoords[0] == Approx(coords[0]).epsilon(1e-10));
+  REQUIRE(warmCoords[1] == Approx(coords[1]).epsilon(1e-10));
+  REQUIRE(warm.Sigma() == Approx(aug.Sigma()));
+}
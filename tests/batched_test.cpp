@@ -0,0 +1,182 @@
+/**
+ * @file batched_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the optimizers of many small independent problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The Booth function of every problem, shifted so that the minimum of problem
+ * p is at (1 + shifts(p, 0), 3 + shifts(p, 1)).  The number of evaluations of
+ * each problem is counted.
+ */
+class BatchedShiftedBoothFunction
+{
+ public:
+  BatchedShiftedBoothFunction(const arma::mat& shifts) :
+      shift1(shifts.col(0)),
+      shift2(shifts.col(1)),
+      evaluations(shifts.n_rows, arma::fill::zeros)
+  { }
+
+  void EvaluateWithGradient(const arma::mat& coordinates,
+                            const arma::uvec& problems,
+                            arma::vec& objectives,
+                            arma::mat& gradients)
+  {
+    const arma::vec x1 = coordinates.col(0) - shift1.elem(problems);
+    const arma::vec x2 = coordinates.col(1) - shift2.elem(problems);
+    const arma::vec a = x1 + 2.0 * x2 - 7.0;
+    const arma::vec b = 2.0 * x1 + x2 - 5.0;
+
+    objectives = arma::square(a) + arma::square(b);
+    gradients.set_size(coordinates.n_rows, 2);
+    gradients.col(0) = 2.0 * a + 4.0 * b;
+    gradients.col(1) = 4.0 * a + 2.0 * b;
+
+    evaluations.elem(problems) += 1;
+  }
+
+  arma::vec shift1;
+  arma::vec shift2;
+  arma::uvec evaluations;
+};
+
+//! The two-dimensional Rosenbrock function, for every problem.
+class BatchedRosenbrockFunction
+{
+ public:
+  void EvaluateWithGradient(const arma::mat& coordinates,
+                            const arma::uvec& /* problems */,
+                            arma::vec& objectives,
+                            arma::mat& gradients)
+  {
+    const arma::vec x1 = coordinates.col(0);
+    const arma::vec r = coordinates.col(1) - arma::square(x1);
+
+    objectives = 100.0 * arma::square(r) + arma::square(1.0 - x1);
+    gradients.set_size(coordinates.n_rows, 2);
+    gradients.col(0) = -400.0 * x1 % r - 2.0 * (1.0 - x1);
+    gradients.col(1) = 200.0 * r;
+  }
+};
+
+/**
+ * Solve many shifted Booth functions with batched gradient descent.
+ */
+TEST_CASE("BatchedGradientDescentBoothTest", "[BatchedTest]")
+{
+  const arma::mat shifts = arma::randu<arma::mat>(1000, 2) - 0.5;
+  BatchedShiftedBoothFunction f(shifts);
+
+  arma::mat coordinates(1000, 2, arma::fill::zeros);
+  BatchedGradientDescent optimizer(0.01, 100000, 1e-12);
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(optimizer.Objectives().n_elem == 1000);
+  for (size_t p = 0; p < 1000; ++p)
+  {
+    REQUIRE(coordinates(p, 0) == Approx(1.0 + shifts(p, 0)).epsilon(1e-3));
+    REQUIRE(coordinates(p, 1) == Approx(3.0 + shifts(p, 1)).epsilon(1e-3));
+  }
+}
+
+/**
+ * Solve many shifted Booth functions with batched L-BFGS.
+ */
+TEST_CASE("BatchedL_BFGSBoothTest", "[BatchedTest]")
+{
+  const arma::mat shifts = 4.0 * (arma::randu<arma::mat>(10000, 2) - 0.5);
+  BatchedShiftedBoothFunction f(shifts);
+
+  arma::mat coordinates(10000, 2, arma::fill::zeros);
+  BatchedL_BFGS optimizer;
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-6));
+  for (size_t p = 0; p < 10000; ++p)
+  {
+    REQUIRE(coordinates(p, 0) == Approx(1.0 + shifts(p, 0)).margin(1e-4));
+    REQUIRE(coordinates(p, 1) == Approx(3.0 + shifts(p, 1)).margin(1e-4));
+  }
+
+  // A quadratic in two dimensions takes only a few iterations.
+  REQUIRE(optimizer.Iterations().max() < 20);
+}
+
+/**
+ * Solve the Rosenbrock function from many starting points with batched L-BFGS;
+ * the problems take different numbers of iterations.
+ */
+TEST_CASE("BatchedL_BFGSRosenbrockTest", "[BatchedTest]")
+{
+  BatchedRosenbrockFunction f;
+  arma::mat coordinates = 4.0 * (arma::randu<arma::mat>(500, 2) - 0.5);
+
+  BatchedL_BFGS optimizer;
+  optimizer.Optimize(f, coordinates);
+
+  for (size_t p = 0; p < 500; ++p)
+  {
+    REQUIRE(optimizer.Objectives()[p] == Approx(0.0).margin(1e-5));
+    REQUIRE(coordinates(p, 0) == Approx(1.0).epsilon(1e-2));
+    REQUIRE(coordinates(p, 1) == Approx(1.0).epsilon(1e-2));
+  }
+
+  REQUIRE(optimizer.Iterations().min() < optimizer.Iterations().max());
+}
+
+/**
+ * Make sure that the problems that have converged are not evaluated anymore:
+ * the problems that start at their minimum are evaluated once.
+ */
+TEST_CASE("BatchedConvergedProblemsTest", "[BatchedTest]")
+{
+  const arma::mat shifts(200, 2, arma::fill::zeros);
+  BatchedShiftedBoothFunction f(shifts);
+
+  arma::mat coordinates(200, 2, arma::fill::zeros);
+  coordinates.rows(0, 99).col(0).fill(1.0);
+  coordinates.rows(0, 99).col(1).fill(3.0);
+
+  BatchedL_BFGS optimizer;
+  optimizer.Optimize(f, coordinates);
+
+  for (size_t p = 0; p < 100; ++p)
+  {
+    REQUIRE(f.evaluations[p] == 1);
+    REQUIRE(optimizer.Iterations()[p] == 0);
+  }
+
+  for (size_t p = 100; p < 200; ++p)
+  {
+    REQUIRE(f.evaluations[p] > 1);
+    REQUIRE(coordinates(p, 0) == Approx(1.0).epsilon(1e-4));
+    REQUIRE(coordinates(p, 1) == Approx(3.0).epsilon(1e-4));
+  }
+
+  // Gradient descent stops a problem when its objective does not change, so
+  // the problems at their minimum are evaluated twice.
+  f.evaluations.zeros();
+  coordinates.rows(100, 199).zeros();
+  BatchedGradientDescent gd(0.01, 100000, 1e-12);
+  gd.Optimize(f, coordinates);
+
+  for (size_t p = 0; p < 100; ++p)
+    REQUIRE(f.evaluations[p] == 2);
+  for (size_t p = 100; p < 200; ++p)
+    REQUIRE(f.evaluations[p] > 2);
+}
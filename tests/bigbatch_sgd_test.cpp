@@ -77,3 +77,87 @@ TEST_CASE("BBSArmijoLogisticRegressionTest", "[BigBatchSGDTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
   }
 }
+
+/**
+ * Make sure that the sample variance computed by the batched
+ * GradientVariance() of logistic regression matches the variance of the
+ * gradients of each point.
+ */
+TEST_CASE("BigBatchSGDGradientVarianceTest", "[BigBatchSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  arma::mat coordinates = arma::randn<arma::mat>(1, 4) * 0.1;
+
+  // Compute the gradient of each point of the batch and their spread.
+  const size_t begin = 100;
+  const size_t batchSize = 50;
+  arma::mat gradients(coordinates.n_elem, batchSize);
+  arma::mat pointGradient;
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    lr.Gradient(coordinates, begin + i, pointGradient, 1);
+    gradients.col(i) = arma::vectorise(pointGradient);
+  }
+  const arma::vec mean = arma::mean(gradients, 1);
+  const double variance = arma::accu(arma::square(gradients.each_col() -
+      mean));
+
+  arma::mat gradient;
+  REQUIRE(lr.GradientVariance(coordinates, begin, gradient, batchSize) ==
+      Approx(variance).epsilon(1e-8));
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(gradient[i] == Approx(batchSize * mean[i]).epsilon(1e-8));
+
+  // The same batch, visited through its indices.
+  IndexedFunction<LogisticRegression<>> visited(lr);
+  double indexedVariance = 0;
+  REQUIRE(TryGradientVariance(visited, coordinates, begin, gradient,
+      batchSize, indexedVariance));
+  REQUIRE(indexedVariance == Approx(variance).epsilon(1e-8));
+}
+
+/**
+ * Make sure that both step size policies return the objective of the batch at
+ * the point the optimizer moves to, given the objective at the iterate.
+ */
+TEST_CASE("BigBatchSGDPolicyObjectiveTest", "[BigBatchSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  const size_t begin = 100;
+  const size_t batchSize = 50;
+
+  arma::mat coordinates = arma::randn<arma::mat>(1, 4);
+  arma::mat gradient;
+  lr.Gradient(coordinates, begin, gradient, batchSize);
+  const double objective = lr.Evaluate(coordinates, begin, batchSize);
+  const double gB = std::pow(arma::norm(gradient / batchSize, 2), 2.0);
+
+  BacktrackingLineSearch backtracking(0.1);
+  double stepSize = 1.0;
+  arma::mat iterate = coordinates;
+  double newObjective = backtracking.Update(lr, stepSize, iterate, gradient,
+      objective, gB, 0.0, begin, batchSize, batchSize, false);
+  REQUIRE(newObjective == Approx(lr.Evaluate(iterate - stepSize * gradient,
+      begin, batchSize)).epsilon(1e-10));
+
+  // The adaptive policy takes a first step itself.
+  AdaptiveStepsize adaptive(0.5, 0.1);
+  stepSize = 1.0;
+  iterate = coordinates;
+  newObjective = adaptive.Update(lr, stepSize, iterate, gradient, objective,
+      gB, 0.0, begin, batchSize, batchSize, false);
+  REQUIRE(newObjective == Approx(lr.Evaluate(iterate - stepSize * gradient,
+      begin, batchSize)).epsilon(1e-10));
+}
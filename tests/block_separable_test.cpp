@@ -0,0 +1,100 @@
+/**
+ * @file block_separable_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the BlockSeparable optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Optimize generalized Rosenbrock functions of different sizes as separate
+ * blocks, and make sure that every block converges on its own.
+ */
+TEST_CASE("BlockSeparableRosenbrockTest", "[BlockSeparableTest]")
+{
+  std::vector<GeneralizedRosenbrockFunction> functions;
+  std::vector<arma::mat> iterates;
+  for (size_t n = 4; n <= 64; n *= 2)
+  {
+    functions.push_back(GeneralizedRosenbrockFunction(n));
+    iterates.push_back(functions.back().GetInitialPoint());
+  }
+
+  BlockSeparable<L_BFGS> optimizer(L_BFGS(20));
+  const double objective = optimizer.Optimize(functions, iterates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(optimizer.Objectives().n_elem == functions.size());
+  REQUIRE(optimizer.Optimizers().size() == functions.size());
+  for (size_t j = 0; j < iterates.size(); ++j)
+  {
+    REQUIRE(optimizer.Objectives()[j] == Approx(0.0).margin(1e-5));
+    for (size_t i = 0; i < iterates[j].n_elem; ++i)
+      REQUIRE(iterates[j][i] == Approx(1.0).epsilon(1e-3));
+  }
+
+  // The blocks are independent, so optimizing them sequentially gives the
+  // same result.
+  std::vector<arma::mat> sequentialIterates;
+  for (size_t j = 0; j < functions.size(); ++j)
+    sequentialIterates.push_back(functions[j].GetInitialPoint());
+
+  BlockSeparable<L_BFGS> sequential(L_BFGS(20), false);
+  sequential.Optimize(functions, sequentialIterates);
+  for (size_t j = 0; j < iterates.size(); ++j)
+    CheckMatrices(iterates[j], sequentialIterates[j]);
+}
+
+/**
+ * Train one-vs-rest logistic regression classifiers, one row of the iterate
+ * per class.
+ */
+TEST_CASE("BlockSeparableOneVsRestTest", "[BlockSeparableTest]")
+{
+  // Three Gaussians in 5 dimensions.
+  const size_t numClasses = 3;
+  arma::mat data = arma::randn<arma::mat>(5, 600);
+  arma::Row<size_t> labels(600);
+  for (size_t i = 0; i < 600; ++i)
+  {
+    labels[i] = i % numClasses;
+    data.col(i) += 8.0 * labels[i];
+  }
+
+  // The functions keep references to the responses.
+  std::vector<arma::Row<size_t>> responses(numClasses);
+  std::vector<LogisticRegression<>> classifiers;
+  for (size_t c = 0; c < numClasses; ++c)
+  {
+    responses[c] = arma::conv_to<arma::Row<size_t>>::from(labels == c);
+    classifiers.push_back(LogisticRegression<>(data, responses[c], 0.1));
+  }
+
+  arma::mat coordinates(numClasses, data.n_rows + 1, arma::fill::zeros);
+  BlockSeparable<L_BFGS> optimizer;
+  optimizer.Optimize(classifiers, coordinates);
+
+  for (size_t c = 0; c < numClasses; ++c)
+  {
+    const double acc = classifiers[c].ComputeAccuracy(data, responses[c],
+        coordinates.row(c));
+    REQUIRE(acc == Approx(100.0).epsilon(0.01)); // 1% error tolerance.
+  }
+
+  // The number of functions has to match the number of blocks.
+  arma::mat wrongCoordinates(numClasses + 1, data.n_rows + 1,
+      arma::fill::zeros);
+  REQUIRE_THROWS_AS(optimizer.Optimize(classifiers, wrongCoordinates),
+      std::invalid_argument);
+}
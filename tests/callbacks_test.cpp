@@ -0,0 +1,598 @@
+/**
+ * @file callbacks_test.cpp
+ * @author Ryan Curtin
+ *
+ * Test the callback interface of the optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Count every event reported by an optimizer.  If maxSteps is non-zero, the
+ * optimization is terminated after that many steps.
+ */
+class CountingCallback
+{
+ public:
+  CountingCallback(const size_t maxSteps = 0) :
+      maxSteps(maxSteps),
+      beginOptimization(0),
+      endOptimization(0),
+      evaluate(0),
+      gradient(0),
+      beginEpoch(0),
+      endEpoch(0),
+      stepTaken(0)
+  { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType&, FunctionType&, MatType&)
+  {
+    ++beginOptimization;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType&, FunctionType&, MatType&)
+  {
+    ++endOptimization;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType&, FunctionType&, const MatType&, const double)
+  {
+    ++evaluate;
+  }
+
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType&, FunctionType&, const MatType&, const GradType&)
+  {
+    ++gradient;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginEpoch(OptimizerType&, FunctionType&, const MatType&, const size_t,
+                  const double)
+  {
+    ++beginEpoch;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType&, FunctionType&, const MatType&, const size_t,
+                const double)
+  {
+    ++endEpoch;
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType&, FunctionType&, const MatType&)
+  {
+    return (++stepTaken == maxSteps);
+  }
+
+  size_t maxSteps;
+  size_t beginOptimization;
+  size_t endOptimization;
+  size_t evaluate;
+  size_t gradient;
+  size_t beginEpoch;
+  size_t endEpoch;
+  size_t stepTaken;
+};
+
+/**
+ * Make sure that SGD reports every event.
+ */
+TEST_CASE("SGDCallbacksTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 3000, -1, false);
+
+  CountingCallback cb;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.beginOptimization == 1);
+  REQUIRE(cb.endOptimization == 1);
+  REQUIRE(cb.evaluate == 3000);
+  REQUIRE(cb.gradient == 3000);
+  REQUIRE(cb.stepTaken == 3000);
+  // Three functions, so 1000 epochs; the last one is not ended since the
+  // optimization stops when the maximum number of iterations is reached.
+  REQUIRE(cb.beginEpoch == 1000);
+  REQUIRE(cb.endEpoch == 999);
+}
+
+/**
+ * A callback returning true should terminate SGD, and several callbacks can be
+ * given at once.
+ */
+TEST_CASE("SGDCallbacksTerminateTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 100000, -1, false);
+
+  CountingCallback cb(10), cb2;
+  arma::mat coordinates = f.GetInitialPoint();
+  adam.Optimize(f, coordinates, cb, cb2, EarlyStopAtMinLoss());
+
+  REQUIRE(cb.stepTaken == 10);
+  REQUIRE(cb2.stepTaken == 10);
+  REQUIRE(cb.endOptimization == 1);
+  REQUIRE(cb2.endOptimization == 1);
+}
+
+/**
+ * EarlyStopAtMinLoss should terminate once the objective has not improved for
+ * the given number of epochs.
+ */
+TEST_CASE("EarlyStopAtMinLossTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s;
+  arma::mat coordinates = f.GetInitialPoint();
+
+  EarlyStopAtMinLoss cb(3);
+  cb.BeginOptimization(s, f, coordinates);
+
+  REQUIRE(!cb.EndEpoch(s, f, coordinates, 1, 5.0));
+  REQUIRE(!cb.EndEpoch(s, f, coordinates, 2, 4.0));
+  REQUIRE(!cb.EndEpoch(s, f, coordinates, 3, 4.5));
+  REQUIRE(!cb.EndEpoch(s, f, coordinates, 4, 4.0));
+  REQUIRE(cb.EndEpoch(s, f, coordinates, 5, 6.0));
+  REQUIRE(cb.BestObjective() == Approx(4.0));
+
+  // A new optimization starts over.
+  cb.BeginOptimization(s, f, coordinates);
+  REQUIRE(!cb.EndEpoch(s, f, coordinates, 1, 10.0));
+}
+
+// A validation function with its minimum at 2 in the first coordinate.
+class QuadraticValidationFunction
+{
+ public:
+  double Evaluate(const arma::mat& coordinates)
+  {
+    return std::pow(coordinates(0) - 2.0, 2.0);
+  }
+};
+
+/**
+ * EarlyStopAtMinValidationLoss should terminate once the validation objective
+ * has not improved for the given number of evaluations, and restore the best
+ * coordinates; the background evaluation terminates one period later.
+ */
+TEST_CASE("EarlyStopAtMinValidationLossTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s;
+  QuadraticValidationFunction validation;
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+
+  for (size_t async = 0; async < 2; ++async)
+  {
+    EarlyStopAtMinValidationLoss<QuadraticValidationFunction> cb(validation,
+        1, 2, true, async == 1);
+    cb.BeginOptimization(s, f, coordinates);
+
+    // The validation objectives are 4, 1, 1, 4 and 9.
+    const double points[] = { 0.0, 1.0, 3.0, 4.0, 5.0 };
+    bool terminate = false;
+    size_t epoch = 0;
+    for (; epoch < 5 && !terminate; ++epoch)
+    {
+      coordinates(0) = points[epoch];
+      terminate = cb.EndEpoch(s, f, coordinates, epoch, 0.0);
+    }
+
+    REQUIRE(terminate);
+    REQUIRE(epoch == ((async == 1) ? 5 : 4));
+    REQUIRE(cb.Evaluations() == 4);
+    REQUIRE(cb.BestObjective() == Approx(1.0));
+    REQUIRE(cb.BestEpoch() == 1);
+
+    cb.EndOptimization(s, f, coordinates);
+    REQUIRE(coordinates(0) == Approx(1.0));
+  }
+}
+
+/**
+ * Stopping SGD on a held-out validation set still gives a good model.
+ */
+TEST_CASE("EarlyStopAtMinValidationLossLogisticRegressionTest",
+          "[CallbacksTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  LogisticRegression<> validation(testData, testResponses, 0.5);
+
+  StandardSGD s(0.005, 1, 100 * shuffledData.n_cols, -1);
+  EarlyStopAtMinValidationLoss<LogisticRegression<>> cb(validation, 2, 3);
+  arma::mat coordinates = lr.GetInitialPoint();
+  s.Optimize(lr, coordinates, cb);
+
+  REQUIRE(cb.Evaluations() > 0);
+  REQUIRE(arma::approx_equal(coordinates, cb.Best(), "absdiff", 0.0));
+  REQUIRE(validation.Evaluate(coordinates) == Approx(cb.BestObjective()));
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that L-BFGS reports its events and can be terminated.
+ */
+TEST_CASE("LBFGSCallbacksTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10000;
+
+  CountingCallback cb;
+  arma::mat coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.beginOptimization == 1);
+  REQUIRE(cb.endOptimization == 1);
+  REQUIRE(cb.evaluate > 0);
+  REQUIRE(cb.evaluate == cb.gradient);
+  REQUIRE(cb.stepTaken > 0);
+  REQUIRE(cb.beginEpoch >= cb.endEpoch);
+
+  CountingCallback cb2(3);
+  coordinates = f.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates, cb2);
+
+  REQUIRE(cb2.stepTaken == 3);
+  REQUIRE(cb2.endOptimization == 1);
+}
+
+/**
+ * Callbacks with other optimizers.
+ */
+TEST_CASE("OtherOptimizersCallbacksTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+
+  CMAES<> cmaes(0, -1, 1, 32, 200, -1);
+  CountingCallback cmaesCallback(5);
+  arma::mat coordinates = f.GetInitialPoint();
+  cmaes.Optimize(f, coordinates, cmaesCallback);
+
+  REQUIRE(cmaesCallback.stepTaken == 5);
+  REQUIRE(cmaesCallback.evaluate > 5);
+  REQUIRE(cmaesCallback.endOptimization == 1);
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SVRG svrg(0.005, 1, 300, 0, 1e-5, true);
+  CountingCallback svrgCallback;
+  coordinates = lr.GetInitialPoint();
+  svrg.Optimize(lr, coordinates, svrgCallback);
+
+  REQUIRE(svrgCallback.beginOptimization == 1);
+  REQUIRE(svrgCallback.endOptimization == 1);
+  REQUIRE(svrgCallback.gradient == svrgCallback.beginEpoch);
+  REQUIRE(svrgCallback.stepTaken > 0);
+
+  AugLagrangianTestFunction augFunction;
+  AugLagrangian aug;
+  CountingCallback augCallback;
+  arma::mat augCoordinates = augFunction.GetInitialPoint();
+  aug.Optimize(augFunction, augCoordinates, 0, augCallback);
+
+  REQUIRE(augCallback.beginOptimization == 1);
+  REQUIRE(augCallback.endOptimization == 1);
+  REQUIRE(augCallback.stepTaken == augCallback.evaluate);
+}
+
+/**
+ * A cancelled token should stop SGD, L-BFGS, SA and the primal-dual SDP solver
+ * before they take a step; once the token is reset, they should run again.
+ */
+TEST_CASE("TimeBudgetCancelTest", "[CallbacksTest]")
+{
+  CancellationToken token;
+  token.Cancel();
+
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 3000, -1, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  TimeBudget budget(0.0, token);
+  s.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Stopped());
+  REQUIRE(arma::approx_equal(coordinates, f.GetInitialPoint(), "absdiff",
+      0.0));
+
+  RosenbrockFunction rf;
+  L_BFGS lbfgs;
+  coordinates = rf.GetInitialPoint();
+  lbfgs.Optimize(rf, coordinates, TimeBudget(0.0, token));
+  REQUIRE(arma::approx_equal(coordinates, rf.GetInitialPoint(), "absdiff",
+      0.0));
+
+  ExponentialSchedule schedule;
+  SA<> sa(schedule);
+  coordinates = rf.GetInitialPoint();
+  sa.Optimize(rf, coordinates, TimeBudget(0.0, token));
+  REQUIRE(arma::approx_equal(coordinates, rf.GetInitialPoint(), "absdiff",
+      0.0));
+
+  SDP<arma::sp_mat> sdp(2, 1, 0);
+  sdp.C().eye(2, 2);
+  sdp.SparseA()[0].eye(2, 2);
+  sdp.SparseB()[0] = 1;
+  PrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+  CountingCallback sdpCallback;
+  solver.Optimize(coordinates, TimeBudget(0.0, token), sdpCallback);
+  REQUIRE(sdpCallback.beginOptimization == 1);
+  REQUIRE(sdpCallback.stepTaken == 0);
+  REQUIRE(sdpCallback.endOptimization == 1);
+
+  // The token can be used again.
+  token.Reset();
+  budget.Restart();
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, budget);
+  REQUIRE(!budget.Stopped());
+  REQUIRE(!arma::approx_equal(coordinates, f.GetInitialPoint(), "absdiff",
+      0.0));
+}
+
+/**
+ * An optimization without any other limit should stop soon after its time
+ * budget is spent.
+ */
+TEST_CASE("TimeBudgetExpiryTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 0, -1, false);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  TimeBudget budget(0.05);
+  s.Optimize(f, coordinates, budget);
+
+  REQUIRE(budget.Stopped());
+  REQUIRE(budget.Elapsed() >= 0.05);
+  REQUIRE(budget.Elapsed() < 5.0);
+}
+
+/**
+ * TraceRecorder should record every period steps and every end of an epoch,
+ * and keep the latest records once its buffer is full.
+ */
+TEST_CASE("TraceRecorderTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 3000, -1, false);
+
+  // 300 steps and 999 ends of epochs are recorded.
+  TraceRecorder trace(2000, 10);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, trace);
+
+  REQUIRE(trace.Size() == 1299);
+  REQUIRE(trace.Dropped() == 0);
+  REQUIRE(trace[0].iteration == 3);
+  REQUIRE(trace[0].epoch);
+  REQUIRE(trace[2].iteration == 9);
+  REQUIRE(trace[3].iteration == 10);
+  REQUIRE(!trace[3].epoch);
+  REQUIRE(trace[3].evaluations == 10);
+  REQUIRE(trace[3].gradientNorm > 0.0);
+  REQUIRE(trace[3].stepSize == Approx(0.0003));
+  for (size_t i = 1; i < trace.Size(); ++i)
+  {
+    REQUIRE(trace[i].time >= trace[i - 1].time);
+    REQUIRE(trace[i].iteration >= trace[i - 1].iteration);
+  }
+
+  std::ostringstream csv;
+  trace.WriteCSV(csv);
+  const std::string csvString = csv.str();
+  REQUIRE(std::count(csvString.begin(), csvString.end(), '\n') == 1300);
+
+  // With a small buffer, only the latest records are kept.
+  TraceRecorder small(100, 10);
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, small);
+
+  REQUIRE(small.Size() == 100);
+  REQUIRE(small.Dropped() == 1199);
+  REQUIRE(small[99].iteration == trace[1298].iteration);
+  REQUIRE(small[99].objective == Approx(trace[1298].objective));
+
+  // L_BFGS has no step size.
+  RosenbrockFunction rf;
+  arma::mat rosenbrockCoordinates = rf.GetInitialPoint();
+  TraceRecorder lbfgsTrace;
+  L_BFGS lbfgs;
+  lbfgs.Optimize(rf, rosenbrockCoordinates, lbfgsTrace);
+
+  REQUIRE(lbfgsTrace.Size() > 0);
+  REQUIRE(std::isnan(lbfgsTrace[0].stepSize));
+
+  std::ostringstream json;
+  lbfgsTrace.WriteJSON(json);
+  REQUIRE(json.str().find("\"step_size\": null") != std::string::npos);
+}
+
+/**
+ * Take a snapshot of a MetricsExporter at the given step, as a scraping thread
+ * would.
+ */
+class SnapshotCallback
+{
+ public:
+  SnapshotCallback(const MetricsExporter& metrics, const size_t step) :
+      metrics(metrics), step(step), steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    if (++steps == step)
+      snapshot = metrics.Snapshot();
+  }
+
+  const MetricsExporter& metrics;
+  size_t step;
+  size_t steps;
+  MetricsSnapshot snapshot;
+};
+
+/**
+ * MetricsExporter should count the events of the optimizations it is passed
+ * to, be readable while they run, and write the Prometheus text format.
+ */
+TEST_CASE("MetricsExporterTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 3000, -1, false);
+
+  MetricsExporter metrics(10);
+  SnapshotCallback during(metrics, 1500);
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, metrics, during);
+
+  REQUIRE(during.snapshot.running);
+  // The exporter is called first, so it has counted the step.
+  REQUIRE(during.snapshot.steps == 1500);
+  REQUIRE(during.snapshot.optimizationTime > 0.0);
+
+  MetricsSnapshot snapshot = metrics.Snapshot();
+  REQUIRE(!snapshot.running);
+  REQUIRE(snapshot.optimizations == 1);
+  REQUIRE(snapshot.steps == 3000);
+  // SGD reports the batch size of its steps.
+  REQUIRE(snapshot.samples == 3000);
+  REQUIRE(snapshot.epochs == 999);
+  REQUIRE(snapshot.evaluations >= 3000);
+  REQUIRE(snapshot.gradients == 3000);
+  REQUIRE(snapshot.stepSize == Approx(0.0003));
+  REQUIRE(snapshot.gradientNorm > 0.0);
+  REQUIRE(snapshot.optimizationTime >= during.snapshot.optimizationTime);
+  REQUIRE(snapshot.lastEpochTime >= 0.0);
+  REQUIRE(snapshot.timeSinceLastStep >= 0.0);
+
+  // The counters keep growing over the next optimization.
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, metrics);
+  snapshot = metrics.Snapshot();
+  REQUIRE(snapshot.optimizations == 2);
+  REQUIRE(snapshot.steps == 6000);
+
+  std::ostringstream output;
+  PrometheusTextSink sink(output, "ens", "run=\"sgd\"");
+  metrics.Export(sink);
+  const std::string text = output.str();
+  REQUIRE(text.find("# TYPE ens_steps_total counter\n") != std::string::npos);
+  REQUIRE(text.find("ens_steps_total{run=\"sgd\"} 6000\n") !=
+      std::string::npos);
+  REQUIRE(text.find("ens_running{run=\"sgd\"} 0\n") != std::string::npos);
+  REQUIRE(text.find("# TYPE ens_objective gauge\n") != std::string::npos);
+}
+
+/**
+ * Make sure that an OptimizerState survives a round trip through a file.
+ */
+TEST_CASE("OptimizerStateSaveLoadTest", "[CallbacksTest]")
+{
+  OptimizerState state;
+  arma::mat m(3, 4, arma::fill::randu);
+  arma::fmat f(2, 2, arma::fill::randu);
+  state.Set("m", m);
+  state.Set("f", f);
+  state.Set("iteration", 17.0);
+
+  OptimizerState inner;
+  inner.Set("v", m);
+  state.Set("policy.", inner);
+
+  REQUIRE(state.Save("optimizer_state_test.bin"));
+
+  OptimizerState loaded;
+  REQUIRE(loaded.Load("optimizer_state_test.bin"));
+  std::remove("optimizer_state_test.bin");
+  REQUIRE(loaded.Size() == 4);
+
+  arma::mat m2;
+  arma::fmat f2;
+  size_t iteration;
+  loaded.Get("m", m2);
+  loaded.Get("f", f2);
+  loaded.Get("iteration", iteration);
+  REQUIRE(arma::approx_equal(m, m2, "absdiff", 1e-15));
+  REQUIRE(arma::approx_equal(f, f2, "absdiff", 1e-7));
+  REQUIRE(iteration == 17);
+
+  loaded.Get("policy.", inner);
+  REQUIRE(inner.Size() == 1);
+  inner.Get("v", m2);
+  REQUIRE(arma::approx_equal(m, m2, "absdiff", 1e-15));
+
+  REQUIRE_THROWS_AS(loaded.Get("u", m2), std::runtime_error);
+  REQUIRE(!loaded.Load("optimizer_state_test_missing.bin"));
+}
+
+/**
+ * Resuming Adam from a checkpoint should give the same result as an
+ * uninterrupted run.
+ */
+TEST_CASE("CheckpointResumeTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+
+  // The uninterrupted run: five epochs of three steps.
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 15, -1, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  adam.Optimize(f, coordinates);
+
+  // The interrupted run: the last checkpoint is written at the end of the
+  // second epoch, after six steps.
+  Adam interrupted(0.01, 1, 0.9, 0.999, 1e-8, 9, -1, false);
+  arma::mat interruptedCoordinates = f.GetInitialPoint();
+  interrupted.Optimize(f, interruptedCoordinates,
+      Checkpoint("checkpoint_test.bin"));
+
+  // Resume with a fresh optimizer for the remaining nine steps.
+  Adam resumed(0.01, 1, 0.9, 0.999, 1e-8, 9, -1, false);
+  arma::mat resumedCoordinates;
+  REQUIRE(Checkpoint::Resume("checkpoint_test.bin", resumed,
+      resumedCoordinates));
+  std::remove("checkpoint_test.bin");
+  resumed.Optimize(f, resumedCoordinates);
+
+  REQUIRE(arma::approx_equal(coordinates, resumedCoordinates, "absdiff",
+      1e-12));
+
+  // Without a checkpoint, nothing is restored.
+  REQUIRE(!Checkpoint::Resume("checkpoint_test.bin", resumed,
+      resumedCoordinates));
+}
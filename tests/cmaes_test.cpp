@@ -102,3 +102,240 @@ TEST_CASE("ApproxCMAESLogisticRegressionTest", "[CMAESTest]")
 
   REQUIRE(success == true);
 }
+
+/**
+ * Run CMA-ES with parallel evaluation of the candidates on logistic regression
+ * and make sure the results are acceptable.
+ */
+TEST_CASE("ParallelCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    ApproxCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3, RandomSelection(), true);
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Make sure that CMA-ES with parallel evaluation gives the same result for the
+ * same seed.
+ */
+TEST_CASE("ParallelCMAESReproducibilityTest", "[CMAESTest]")
+{
+  SGDTestFunction f;
+
+  arma::mat coordinates1 = f.GetInitialPoint();
+  arma::arma_rng::set_seed(42);
+  CMAES<> optimizer1(0, -1, 1, 32, 50, -1, FullSelection(), true);
+  optimizer1.Optimize(f, coordinates1);
+
+  arma::mat coordinates2 = f.GetInitialPoint();
+  arma::arma_rng::set_seed(42);
+  CMAES<> optimizer2(0, -1, 1, 32, 50, -1, FullSelection(), true);
+  optimizer2.Optimize(f, coordinates2);
+
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+}
+
+/**
+ * Tests the CMA-ES optimizer with a diagonal covariance matrix using a simple
+ * test function.
+ */
+TEST_CASE("SepCMAESSimpleTestFunction", "[CMAESTest]")
+{
+  SGDTestFunction f;
+  SepCMAES<> optimizer(0, -1, 1, 32, 200, -1);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.003));
+}
+
+/**
+ * Run CMA-ES with a diagonal covariance matrix on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("SepCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    SepCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * With warm starts, two short optimizations should get as close to the optimum
+ * as one long one.
+ */
+TEST_CASE("WarmStartCMAESTestFunction", "[CMAESTest]")
+{
+  SGDTestFunction f;
+  CMAES<> optimizer(0, -1, 1, 32, 100, -1, FullSelection(), false,
+      FullCovariance(), true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.003));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.003));
+}
+
+/**
+ * The ask/tell interface should follow the same search as Optimize() for the
+ * same seed, and reject objectives it did not ask for.
+ */
+TEST_CASE("CMAESAskTellTest", "[CMAESTest]")
+{
+  SGDTestFunction f;
+
+  // Optimize() runs maxIterations - 1 generations.
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::arma_rng::set_seed(42);
+  CMAES<> optimizer(0, -1, 1, 32, 101, -1);
+  optimizer.Optimize(f, coordinates);
+
+  arma::arma_rng::set_seed(42);
+  CMAES<> askTell(0, -1, 1);
+  askTell.Initialize(coordinates.n_rows, coordinates.n_cols);
+  REQUIRE_THROWS_AS(askTell.Tell(arma::vec()), std::logic_error);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const arma::cube& candidates = askTell.Ask();
+    arma::vec objectives(candidates.n_slices);
+    for (size_t j = 0; j < candidates.n_slices; ++j)
+      objectives[j] = f.Evaluate(candidates.slice(j), 0, f.NumFunctions());
+    askTell.Tell(objectives);
+  }
+
+  REQUIRE(askTell.Generation() == 100);
+  REQUIRE(arma::approx_equal(askTell.Mean(), optimizer.Mean(), "absdiff",
+      1e-10));
+  REQUIRE(askTell.Mean()[0] == Approx(0.0).margin(0.01));
+  REQUIRE(askTell.Mean()[1] == Approx(0.0).margin(0.01));
+  REQUIRE(askTell.Mean()[2] == Approx(0.0).margin(0.01));
+
+  askTell.Ask();
+  REQUIRE_THROWS_AS(askTell.Tell(arma::vec(1)), std::invalid_argument);
+}
+
+/**
+ * IPOP-CMA-ES and BIPOP-CMA-ES should find the global minimum of the Rastrigin
+ * function, and give the same result with parallel restarts for the same seed.
+ */
+TEST_CASE("IPOPCMAESRastriginFunctionTest", "[CMAESTest]")
+{
+  RastriginFunction f(2);
+
+  for (size_t bipop = 0; bipop < 2; ++bipop)
+  {
+    arma::mat coordinates1 = f.GetInitialPoint();
+    arma::arma_rng::set_seed(42);
+    IPOPCMAES<> optimizer1(CMAES<>(0, -5, 5, 2, 200, 1e-8), 2.0, 4, bipop);
+    const double objective1 = optimizer1.Optimize(f, coordinates1);
+
+    arma::mat coordinates2 = f.GetInitialPoint();
+    arma::arma_rng::set_seed(42);
+    IPOPCMAES<> optimizer2(CMAES<>(0, -5, 5, 2, 200, 1e-8), 2.0, 4, bipop,
+        true);
+    const double objective2 = optimizer2.Optimize(f, coordinates2);
+
+    REQUIRE(optimizer1.PopulationSizes().size() == 5);
+    REQUIRE(optimizer1.BestRestart() == optimizer2.BestRestart());
+    REQUIRE(objective1 == objective2);
+    REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+
+    REQUIRE(objective1 == Approx(0.0).margin(1e-3));
+    REQUIRE(coordinates1[0] == Approx(0.0).margin(1e-2));
+    REQUIRE(coordinates1[1] == Approx(0.0).margin(1e-2));
+  }
+}
+
+/**
+ * Make sure CMA-ES writes the best point into the memory of an iterate that
+ * uses external memory.
+ */
+TEST_CASE("CMAESExternalMemoryTest", "[CMAESTest]")
+{
+  SGDTestFunction f;
+  CMAES<> optimizer(0, -1, 1, 32, 200, -1);
+
+  std::vector<double> memory = { 6.0, -45.6, 6.2 };
+  arma::mat coordinates(memory.data(), 3, 1, false, false);
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == memory.data());
+  REQUIRE(memory[0] == Approx(0.0).margin(0.003));
+  REQUIRE(memory[1] == Approx(0.0).margin(0.003));
+  REQUIRE(memory[2] == Approx(0.0).margin(0.003));
+}
+
+/**
+ * The memory estimate of CMA-ES should grow with the square of the number of
+ * coordinates with a full covariance matrix, but not with a diagonal one.
+ */
+TEST_CASE("CMAESMemoryEstimateTest", "[CMAESTest]")
+{
+  CMAES<> cmaes;
+  SepCMAES<> sepCMAES;
+
+  const size_t n = 1000;
+  const size_t full = MemoryEstimate(cmaes, n, 1);
+  const size_t diagonal = MemoryEstimate(sepCMAES, n, 1);
+  REQUIRE(full >= 4 * n * n * sizeof(double));
+  REQUIRE(diagonal < 2 * n * n * sizeof(double));
+  REQUIRE(MemoryEstimate(sepCMAES, 2 * n, 1) < 3 * diagonal);
+
+  // The population is held three times.
+  sepCMAES.PopulationSize() = 2000;
+  REQUIRE(MemoryEstimate(sepCMAES, n, 1) >= 3 * n * 2000 * sizeof(double));
+}
@@ -41,3 +41,102 @@ TEST_CASE("CNELogisticRegressionTest", "[CNETest]")
       coordinates);
   REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
 }
+
+/**
+ * Train and test a logistic regression function using CNE, evaluating the
+ * candidates in parallel.
+ */
+TEST_CASE("CNEParallelLogisticRegressionTest", "[CNETest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  CNE opt(200, 10000, 0.2, 0.2, 0.3, 65, -1, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  opt.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+// A quadratic function that counts its evaluations.
+class CNECountingFunction
+{
+ public:
+  CNECountingFunction() : evaluations(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates - 0.5));
+  }
+
+  size_t evaluations;
+};
+
+/**
+ * Make sure that the candidates that survive a generation unchanged are not
+ * evaluated again.
+ */
+TEST_CASE("CNEUnchangedCandidatesTest", "[CNETest]")
+{
+  // Without mutation, only the 16 children of each of the 4 next generations
+  // are evaluated, and the starting point and the final point once each.
+  CNECountingFunction f;
+  CNE opt(20, 5, 0.0, 0.1, 0.2, -DBL_MAX, -DBL_MAX);
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+  const double objective = opt.Optimize(f, coordinates);
+
+  REQUIRE(opt.Evaluations() == 20 + 4 * 16);
+  REQUIRE(f.evaluations == opt.Evaluations() + 2);
+  REQUIRE(objective <= 2.5);
+
+  // With mutation, at least the best candidate is not evaluated again.
+  CNECountingFunction g;
+  CNE mutatingOpt(20, 5, 1.0, 0.1, 0.2, -DBL_MAX, -DBL_MAX);
+  coordinates.zeros();
+  mutatingOpt.Optimize(g, coordinates);
+
+  REQUIRE(mutatingOpt.Evaluations() == 20 + 4 * 19);
+}
+
+/**
+ * The ask/tell interface should follow the same search as Optimize() for the
+ * same seed, and only ask for the candidates that changed.
+ */
+TEST_CASE("CNEAskTellTest", "[CNETest]")
+{
+  CNECountingFunction f;
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+  arma::arma_rng::set_seed(42);
+  CNE optimizer(20, 30, 0.1, 0.1, 0.2, -DBL_MAX, -DBL_MAX);
+  optimizer.Optimize(f, coordinates);
+
+  arma::arma_rng::set_seed(42);
+  CNE askTell(20, 30, 0.1, 0.1, 0.2, -DBL_MAX, -DBL_MAX);
+  askTell.Initialize(10, 1);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    const arma::cube& candidates = askTell.Ask();
+    // The best candidate is never changed after the first generation.
+    REQUIRE(candidates.n_slices <= ((i == 0) ? 20 : 19));
+
+    arma::vec fitness(candidates.n_slices);
+    for (size_t j = 0; j < candidates.n_slices; ++j)
+      fitness[j] = f.Evaluate(candidates.slice(j));
+    askTell.Tell(fitness);
+  }
+
+  REQUIRE(askTell.Evaluations() == optimizer.Evaluations());
+  REQUIRE(arma::approx_equal(askTell.Best(), coordinates, "absdiff", 0.0));
+  REQUIRE(askTell.BestFitness() == Approx(f.Evaluate(coordinates)));
+}
@@ -0,0 +1,285 @@
+/**
+ * @file data_parallel_sgd_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the data-parallel SGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A communicator that plays two workers with the same data: every sum doubles
+ * the data.  The buckets of the sums are counted.
+ */
+class MirrorCommunicator
+{
+ public:
+  typedef int RequestType;
+
+  MirrorCommunicator() : reductions(0) { }
+
+  size_t Size() const { return 2; }
+  size_t Rank() const { return 0; }
+
+  template<typename ElemType>
+  void AllReduce(ElemType* data, const size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      data[i] *= 2;
+  }
+
+  template<typename ElemType>
+  RequestType StartAllReduce(ElemType* data, const size_t n)
+  {
+    ++reductions;
+    AllReduce(data, n);
+    return 0;
+  }
+
+  void Wait(RequestType& /* request */) { }
+
+  template<typename ElemType>
+  void Broadcast(ElemType* /* data */,
+                 const size_t /* n */,
+                 const size_t /* root */) { }
+
+  template<typename ElemType>
+  void AllGather(const ElemType* data, const size_t n, ElemType* result)
+  {
+    std::copy(data, data + n, result);
+    std::copy(data, data + n, result + n);
+  }
+
+  size_t reductions;
+};
+
+/**
+ * With a single worker, DataParallelSGD must take the same steps as SGD.
+ */
+TEST_CASE("DataParallelSGDSingleWorkerTest", "[DataParallelSGDTest]")
+{
+  SGDTestFunction f;
+
+  StandardSGD sgd(0.0003, 1, 100000, 1e-9, false);
+  arma::mat coordinates1 = f.GetInitialPoint();
+  const double result1 = sgd.Optimize(f, coordinates1);
+
+  DataParallelSGD<> optimizer(0.0003, 1, 100000, 1e-9, false);
+  arma::mat coordinates2 = f.GetInitialPoint();
+  const double result2 = optimizer.Optimize(f, coordinates2);
+
+  REQUIRE(result2 == Approx(result1).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+}
+
+/**
+ * Two workers with the same data average to the gradient of one, so the steps
+ * must be those of SGD with a stateful update policy, while the objective is
+ * summed over both.  Each step sums the objective and one bucket per element.
+ */
+TEST_CASE("DataParallelSGDMirroredWorkersTest", "[DataParallelSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<AdamUpdate> sgd(0.01, 32, 3200, -1, false);
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  const double result1 = sgd.Optimize(lr, coordinates1);
+
+  DataParallelSGD<AdamUpdate, NoDecay, MirrorCommunicator> optimizer(0.01, 32,
+      3200, -1, false, AdamUpdate(), NoDecay(), MirrorCommunicator(), 1);
+  arma::mat coordinates2 = lr.GetInitialPoint();
+  const double result2 = optimizer.Optimize(lr, coordinates2);
+
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+  REQUIRE(result2 == Approx(2 * result1).epsilon(1e-12));
+  const size_t reductions = optimizer.Communicator().reductions;
+  REQUIRE(reductions >= 100 * (coordinates2.n_elem + 1));
+  REQUIRE(reductions % (coordinates2.n_elem + 1) == 0);
+}
+
+/**
+ * Top-k sparsification must send the largest elements and keep the others in
+ * the residual, so that nothing is lost.
+ */
+TEST_CASE("TopKCompressionErrorFeedbackTest", "[DataParallelSGDTest]")
+{
+  TopKCompression compression(0.25);
+  NoCommunicator communicator;
+  TopKCompression::Policy<arma::mat, NoCommunicator> policy(compression,
+      communicator, 4, 5);
+
+  const arma::mat original = arma::randn(4, 5);
+  arma::mat gradient = original;
+  policy.Reduce(gradient, 1);
+
+  // 5 of the 20 elements are sent, and they are the largest ones.
+  const arma::uvec sent = arma::find(gradient != 0);
+  REQUIRE(sent.n_elem == 5);
+  const double smallest = arma::min(arma::abs(gradient.elem(sent)));
+  REQUIRE(arma::max(arma::vectorise(arma::abs(policy.Residual()))) <=
+      smallest);
+  REQUIRE(arma::approx_equal(gradient + policy.Residual(), original,
+      "absdiff", 0.0));
+
+  // Without a new gradient, the residual is sent in the next steps.
+  for (size_t i = 0; i < 3; ++i)
+  {
+    arma::mat zero(4, 5, arma::fill::zeros);
+    policy.Reduce(zero, 1);
+  }
+  REQUIRE(arma::accu(policy.Residual() != 0) == 0);
+}
+
+/**
+ * The quantized gradient must be within half a level of the gradient with 8
+ * bits, and the signs scaled by the mean magnitude with 1 bit; the
+ * quantization error is kept in the residual.
+ */
+TEST_CASE("QuantizedCompressionTest", "[DataParallelSGDTest]")
+{
+  NoCommunicator communicator;
+  const arma::mat original = arma::randn(7, 3);
+  const double maxValue = arma::abs(original).max();
+  const double meanValue = arma::mean(arma::vectorise(arma::abs(original)));
+
+  QuantizedCompression compression8(8);
+  QuantizedCompression::Policy<arma::mat, NoCommunicator> policy8(
+      compression8, communicator, 7, 3);
+  arma::mat gradient = original;
+  policy8.Reduce(gradient, 1);
+  REQUIRE(arma::abs(gradient - original).max() <= 0.5 * maxValue / 127 +
+      1e-12);
+  REQUIRE(arma::approx_equal(gradient + policy8.Residual(), original,
+      "absdiff", 1e-12));
+
+  QuantizedCompression compression1(1);
+  QuantizedCompression::Policy<arma::mat, NoCommunicator> policy1(
+      compression1, communicator, 7, 3);
+  gradient = original;
+  policy1.Reduce(gradient, 1);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    REQUIRE(std::abs(gradient[i]) == Approx(meanValue).epsilon(1e-12));
+    REQUIRE((gradient[i] > 0) == (original[i] >= 0));
+  }
+  REQUIRE(arma::approx_equal(gradient + policy1.Residual(), original,
+      "absdiff", 1e-12));
+
+  REQUIRE_THROWS_AS(QuantizedCompression(4), std::invalid_argument);
+  REQUIRE_THROWS_AS(TopKCompression(0.0), std::invalid_argument);
+}
+
+/**
+ * Top-k sparsification of all the elements sends the whole gradient, so two
+ * mirrored workers must take the same steps as SGD.
+ */
+TEST_CASE("DataParallelSGDTopKFullRatioTest", "[DataParallelSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<AdamUpdate> sgd(0.01, 32, 3200, -1, false);
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  sgd.Optimize(lr, coordinates1);
+
+  DataParallelSGD<AdamUpdate, NoDecay, MirrorCommunicator, TopKCompression>
+      optimizer(0.01, 32, 3200, -1, false, AdamUpdate(), NoDecay(),
+      MirrorCommunicator(), 1, true, TopKCompression(1.0));
+  arma::mat coordinates2 = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates2);
+
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+}
+
+/**
+ * Train a logistic regression with compressed gradients on two mirrored
+ * workers; the error feedback must make up for the compression.
+ */
+template<typename CompressionPolicyType>
+void CompressedLogisticRegressionTest(
+    const CompressionPolicyType& compression)
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  DataParallelSGD<VanillaUpdate, NoDecay, MirrorCommunicator,
+      CompressionPolicyType> optimizer(0.005, 32, 100000, 1e-9, true,
+      VanillaUpdate(), NoDecay(), MirrorCommunicator(), 1048576, true,
+      compression);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+TEST_CASE("DataParallelSGDTopKLogisticRegressionTest", "[DataParallelSGDTest]")
+{
+  // One of the four elements per step.
+  CompressedLogisticRegressionTest(TopKCompression(0.25));
+}
+
+TEST_CASE("DataParallelSGDOneBitLogisticRegressionTest",
+    "[DataParallelSGDTest]")
+{
+  CompressedLogisticRegressionTest(QuantizedCompression(1));
+}
+
+#ifdef ENS_USE_MPI
+
+/**
+ * Train a logistic regression on the MPI processes, each with its own part of
+ * the data.
+ */
+TEST_CASE("DataParallelSGDMPILogisticRegressionTest", "[DataParallelSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  MPICommunicator communicator;
+  const size_t size = communicator.Size();
+  const size_t rank = communicator.Rank();
+  const size_t points = shuffledData.n_cols / size;
+  LogisticRegression<> lr(shuffledData.cols(rank * points,
+      (rank + 1) * points - 1), shuffledResponses.cols(rank * points,
+      (rank + 1) * points - 1), 0.5);
+
+  DataParallelSGD<AdamUpdate, NoDecay, MPICommunicator> optimizer(0.01, 32,
+      100000, 1e-9, true, AdamUpdate(), NoDecay(), communicator);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
+
+#endif
@@ -87,3 +87,26 @@ TEST_CASE("EveStyblinskiTangFunctionTest","[EveTest]")
   REQUIRE(coordinates[0] == Approx(-2.9).epsilon(0.01));
   REQUIRE(coordinates[1] == Approx(-2.9).epsilon(0.01));
 }
+
+/**
+ * Make sure that Eve only makes the extra pass for the final objective if
+ * exactObjective is true.
+ */
+TEST_CASE("EveExactObjectiveTest","[EveTest]")
+{
+  // One epoch of the three functions, with one function per batch.
+  EvaluationCountingFunction f;
+  Eve optimizer(1e-3, 1, 0.9, 0.999, 0.999, 1e-8, 10, 3, 1e-9, false, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double runningObjective = optimizer.Optimize(f, coordinates);
+  REQUIRE(f.Evaluations() == 0);
+
+  optimizer.ExactObjective() = true;
+  coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+  REQUIRE(f.Evaluations() == 3);
+
+  // The running objective was taken before each step.
+  REQUIRE(runningObjective == Approx(objective).epsilon(0.01));
+}
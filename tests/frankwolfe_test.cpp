@@ -50,6 +50,44 @@ TEST_CASE("FWOMPTest", "[FrankWolfeTest]")
   }
 }
 
+/**
+ * Make sure Orthogonal Matching Pursuit and the full correction update give the
+ * same solution with a sparse dictionary as with a dense one.
+ */
+TEST_CASE("FWSparseDictionaryTest", "[FrankWolfeTest]")
+{
+  const int k = 5;
+  mat B1 = eye(3, 3);
+  mat B2 = 0.1 * randn(3, k);
+  mat A = join_horiz(B1, B2); // The dictionary is input as columns of A.
+  vec b;
+  b << 1 << 1 << 0; // Vector to be sparsely approximated.
+
+  FuncSq f(A, b);
+  FuncSqType<sp_mat> sparseF(sp_mat(A), b);
+  ConstrLpBallSolver linearConstrSolver(1);
+
+  OMP s(linearConstrSolver, UpdateSpan());
+  vec coordinates = zeros<vec>(k + 3);
+  s.Optimize(f, coordinates);
+
+  FrankWolfe<ConstrLpBallSolver, UpdateSpan> sparseS(linearConstrSolver,
+      UpdateSpan());
+  vec sparseCoordinates = zeros<vec>(k + 3);
+  double result = sparseS.Optimize(sparseF, sparseCoordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(sparseCoordinates[i] == Approx(coordinates[i]).margin(1e-10));
+
+  FrankWolfe<ConstrLpBallSolver, UpdateFullCorrection> fc(linearConstrSolver,
+      UpdateFullCorrection(2, 0.2));
+  coordinates = zeros<vec>(k + 3);
+  result = fc.Optimize(sparseF, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+}
+
 /**
  * Simple test of Orthogonal Matching Pursuit with regularization.
  */
@@ -178,3 +216,358 @@ TEST_CASE("FWLineSearch", "[FrankWolfeTest]")
   REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
   REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
 }
+
+/**
+ * Exactly the same problem with ClassicFW, over the unit l1 ball (a polytope),
+ * with the away-step update rule.  The starting point is a vertex of the ball.
+ */
+TEST_CASE("FWAwayStep", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  double p = 1;   // Constraint set is unit lp ball.
+  ConstrLpBallSolver linearConstrSolver(p);
+  UpdateAwayStep updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 10000);
+
+  vec coordinates("1 0 0");
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+
+  // The solution is a convex combination of the atoms of the active set.
+  const ActiveSet& activeSet = s.UpdateRule().CurrentActiveSet();
+  REQUIRE(accu(activeSet.Weights()) == Approx(1.0));
+  REQUIRE(all(activeSet.Weights() > 0.0));
+  REQUIRE(activeSet.Size() <= 6);
+}
+
+/**
+ * Exactly the same problem with FWAwayStep, with the pairwise update rule.
+ */
+TEST_CASE("FWPairwise", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  double p = 1;   // Constraint set is unit lp ball.
+  ConstrLpBallSolver linearConstrSolver(p);
+  UpdatePairwise updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdatePairwise>
+      s(linearConstrSolver, updateRule, 10000);
+
+  vec coordinates("1 0 0");
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+
+  const ActiveSet& activeSet = s.UpdateRule().CurrentActiveSet();
+  REQUIRE(accu(activeSet.Weights()) == Approx(1.0));
+  REQUIRE(all(activeSet.Weights() > 0.0));
+  REQUIRE(activeSet.Size() <= 6);
+}
+
+/**
+ * TestFuncFW without the UpdateGradient() method, so that the gradient is
+ * computed again at every iteration.
+ */
+class DenseTestFuncFW
+{
+ public:
+  double Evaluate(const arma::mat& coords) { return f.Evaluate(coords); }
+
+  void Gradient(const arma::mat& coords, arma::mat& gradient)
+  {
+    f.Gradient(coords, gradient);
+  }
+
+ private:
+  TestFuncFW f;
+};
+
+/**
+ * Classic Frank-Wolfe over the unit l1 ball, where each atom has a single
+ * non-zero element; the gradient is updated from the sparse step and should
+ * follow exactly the same path as when it is computed at every iteration.
+ */
+TEST_CASE("FWSparseAtom", "[FrankWolfeTest]")
+{
+  static_assert(traits::HasGradientUpdate<TestFuncFW>::value,
+      "TestFuncFW should have UpdateGradient()");
+  static_assert(!traits::HasGradientUpdate<DenseTestFuncFW>::value,
+      "DenseTestFuncFW should not have UpdateGradient()");
+
+  // The sparse atom is the dense solution of the linear constrained problem.
+  ConstrLpBallSolver linearConstrSolver(1);
+  vec gradient("0.3 -0.7 0.2");
+  mat s;
+  linearConstrSolver.Optimize(gradient, s);
+  arma::uword index = 0;
+  double value = 0.0;
+  REQUIRE(linearConstrSolver.Optimize(gradient, index, value));
+  REQUIRE(index == 1);
+  REQUIRE(value == Approx(s[1]));
+  REQUIRE(accu(abs(s)) == Approx(1.0));
+
+  // There is no sparse atom for other norms.
+  ConstrLpBallSolver l2Solver(2);
+  REQUIRE(!l2Solver.Optimize(gradient, index, value));
+
+  TestFuncFW f;
+  DenseTestFuncFW denseF;
+  FrankWolfe<ConstrLpBallSolver, UpdateClassic>
+      s1(linearConstrSolver, UpdateClassic(), 1000);
+  FrankWolfe<ConstrLpBallSolver, UpdateClassic>
+      s2(linearConstrSolver, UpdateClassic(), 1000);
+
+  vec coordinates1 = zeros<vec>(3);
+  vec coordinates2 = zeros<vec>(3);
+  const double result1 = s1.Optimize(f, coordinates1);
+  const double result2 = s2.Optimize(denseF, coordinates2);
+
+  REQUIRE(result1 == Approx(result2).margin(1e-8));
+  REQUIRE(result1 == Approx(0.0).margin(1e-2));
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(coordinates1[i] == Approx(coordinates2[i]).margin(1e-8));
+}
+
+/**
+ * Exactly the same problem with FWAwayStep, with a lazy linear constrained
+ * solver: the vertices of the l1 ball are found again and again, so most
+ * iterations should be answered from the cache.
+ */
+TEST_CASE("FWLazyAwayStep", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  LazyConstrSolver<ConstrLpBallSolver> linearConstrSolver(
+      ConstrLpBallSolver(1));
+  UpdateAwayStep updateRule;
+
+  FrankWolfe<LazyConstrSolver<ConstrLpBallSolver>, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 10000);
+
+  vec coordinates("1 0 0");
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-4));
+
+  const LazyConstrSolver<ConstrLpBallSolver>& lazy = s.LinearConstrSolver();
+  REQUIRE(lazy.OracleCalls() > 0);
+  REQUIRE(lazy.CachedCalls() > 0);
+  REQUIRE(lazy.CachedAtoms().n_cols <= 6);
+}
+
+/**
+ * Make sure Orthogonal Matching Pursuit writes the solution into the memory of
+ * an iterate that uses external memory.
+ */
+TEST_CASE("FWExternalMemoryTest", "[FrankWolfeTest]")
+{
+  const int k = 5;
+  mat B1 = eye(3, 3);
+  mat B2 = 0.1 * randn(3, k);
+  mat A = join_horiz(B1, B2); // The dictionary is input as columns of A.
+  vec b;
+  b << 1 << 1 << 0; // Vector to be sparsely approximated.
+
+  FuncSq f(A, b);
+  OMP s(ConstrLpBallSolver(1), UpdateSpan());
+
+  std::vector<double> memory(k + 3, 0.0);
+  mat coordinates(memory.data(), k + 3, 1, false, false);
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates.memptr() == memory.data());
+  REQUIRE(memory[0] == Approx(1.0).margin(1e-10));
+  REQUIRE(memory[1] == Approx(1.0).margin(1e-10));
+  REQUIRE(memory[2] == Approx(0.0).margin(1e-10));
+}
+
+/**
+ * GroupLpBall without its GroupDualNorm() method, so that the dual norm of
+ * each group is computed from its projection.
+ */
+class ProjectingGroupLpBall
+{
+ public:
+  ProjectingGroupLpBall(GroupLpBall& groups) : groups(groups) { }
+
+  size_t NumGroups() const { return groups.NumGroups(); }
+
+  void ProjectToGroup(const arma::mat& v, const size_t groupId, arma::vec& y)
+  {
+    groups.ProjectToGroup(v, groupId, y);
+  }
+
+  double DualNorm(const arma::vec& yk, const int groupId)
+  {
+    return groups.DualNorm(yk, groupId);
+  }
+
+  void OptimalFromGroup(const arma::mat& v, const size_t groupId, arma::mat& s)
+  {
+    groups.OptimalFromGroup(v, groupId, s);
+  }
+
+ private:
+  GroupLpBall& groups;
+};
+
+/**
+ * The direct dual norms of GroupLpBall and the parallel search for the optimal
+ * group must give the same atom as the search over the projections.
+ */
+TEST_CASE("FWStructGroupSolverTest", "[FrankWolfeTest]")
+{
+  const size_t dim = 50;
+  std::vector<arma::uvec> groupIndices(200);
+  for (size_t i = 0; i < groupIndices.size(); ++i)
+  {
+    arma::uvec permutation = arma::randperm(dim);
+    groupIndices[i] = permutation.head(1 + i % 7);
+  }
+
+  const double ps[] = { 1.0, 2.0, 3.0,
+      std::numeric_limits<double>::infinity() };
+  for (const double p : ps)
+  {
+    GroupLpBall groups(p, dim, groupIndices);
+    ProjectingGroupLpBall projectingGroups(groups);
+
+    ConstrStructGroupSolver<ProjectingGroupLpBall> projecting(
+        projectingGroups);
+    ConstrStructGroupSolver<GroupLpBall> direct(groups);
+    ConstrStructGroupSolver<GroupLpBall> parallel(groups, true);
+
+    for (size_t trial = 0; trial < 5; ++trial)
+    {
+      arma::mat v = arma::randn(dim, 1);
+
+      arma::vec y;
+      for (size_t i = 1; i <= groups.NumGroups(); ++i)
+      {
+        groups.ProjectToGroup(v, i, y);
+        REQUIRE(groups.GroupDualNorm(v, i) ==
+            Approx(groups.DualNorm(y, i)).epsilon(1e-10));
+      }
+
+      arma::mat s1, s2, s3;
+      projecting.Optimize(v, s1);
+      direct.Optimize(v, s2);
+      parallel.Optimize(v, s3);
+
+      REQUIRE(arma::approx_equal(s1, s2, "absdiff", 1e-12));
+      REQUIRE(arma::approx_equal(s1, s3, "absdiff", 1e-12));
+    }
+  }
+}
+
+/**
+ * Frank-Wolfe over the unit ball of the group norm of two overlapping l2
+ * groups, which contains the minimizer of the test function.
+ */
+TEST_CASE("FWStructGroupLineSearch", "[FrankWolfeTest]")
+{
+  TestFuncFW f;
+  std::vector<arma::uvec> groupIndices(2);
+  groupIndices[0] = arma::uvec("0 1");
+  groupIndices[1] = arma::uvec("1 2");
+  GroupLpBall groups(2, 3, groupIndices);
+
+  ConstrStructGroupSolver<GroupLpBall> linearConstrSolver(groups, true);
+  UpdateLineSearch updateRule;
+
+  FrankWolfe<ConstrStructGroupSolver<GroupLpBall>, UpdateLineSearch>
+      s(linearConstrSolver, updateRule);
+
+  vec coordinates = zeros<vec>(3);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates[0] - 0.1 == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] - 0.2 == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] - 0.3 == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * A separable quadratic f(x) = sum_i ||x - c_i||^2, with the points c_i
+ * scattered around (0.1, 0.2, 0.3), so that the minimizer is their mean, inside
+ * the unit l2 ball.
+ */
+class SeparableFuncFW
+{
+ public:
+  SeparableFuncFW(const size_t n) :
+      centers(arma::repmat(arma::vec("0.1 0.2 0.3"), 1, n) +
+          0.05 * arma::randn<arma::mat>(3, n)),
+      visitationOrder(arma::linspace<arma::uvec>(0, n - 1, n))
+  { }
+
+  size_t NumFunctions() const { return centers.n_cols; }
+
+  void Shuffle() { visitationOrder = arma::shuffle(visitationOrder); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    double objective = 0;
+    for (size_t j = begin; j < begin + batchSize; ++j)
+    {
+      objective += arma::accu(arma::square(coordinates -
+          centers.col(visitationOrder[j])));
+    }
+    return objective;
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    for (size_t j = begin; j < begin + batchSize; ++j)
+      gradient += 2 * (coordinates - centers.col(visitationOrder[j]));
+  }
+
+  //! Get the minimizer of the function.
+  arma::vec Minimizer() const { return arma::mean(centers, 1); }
+
+ private:
+  arma::mat centers;
+  arma::uvec visitationOrder;
+};
+
+/**
+ * Stochastic Frank-Wolfe with growing batches and with the SPIDER estimator
+ * should both find the minimizer of a separable function inside the unit l2
+ * ball.
+ */
+TEST_CASE("StochasticFWTest", "[FrankWolfeTest]")
+{
+  SeparableFuncFW f(1000);
+  const arma::vec minimizer = f.Minimizer();
+
+  for (size_t epochLength = 0; epochLength <= 20; epochLength += 20)
+  {
+    StochasticFrankWolfe<ConstrLpBallSolver> s(ConstrLpBallSolver(2),
+        UpdateClassic(), 10, 1.0, epochLength, 1000);
+
+    vec coordinates = zeros<vec>(3);
+    s.Optimize(f, coordinates);
+
+    REQUIRE(coordinates[0] == Approx(minimizer[0]).margin(1e-2));
+    REQUIRE(coordinates[1] == Approx(minimizer[1]).margin(1e-2));
+    REQUIRE(coordinates[2] == Approx(minimizer[2]).margin(1e-2));
+  }
+}
@@ -0,0 +1,103 @@
+/**
+ * @file ftrl_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the FTRL-Proximal optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+#include "test_function_tools.hpp"
+
+using namespace std;
+using namespace arma;
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Without regularization, FTRL-Proximal should find the vertices of the
+ * parabolas of the sparse test function.
+ */
+TEST_CASE("SimpleFTRLProximalTest", "[FTRLProximalTest]")
+{
+  SparseTestFunction f;
+
+  FTRLProximal optimizer(1.0, 1.0, 0.0, 0.0, 1, 1000, 1e-12);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * A strong L1 penalty should keep every weight at exactly zero.
+ */
+TEST_CASE("FTRLProximalL1SparsityTest", "[FTRLProximalTest]")
+{
+  SparseTestFunction f;
+
+  FTRLProximal optimizer(1.0, 1.0, 1e6, 0.0, 1, 100, 1e-12);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = optimizer.Optimize(f, coordinates);
+
+  // The objective at zero is the sum of the intercepts.
+  REQUIRE(result == Approx(147.0).epsilon(1e-10));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == 0.0);
+}
+
+/**
+ * Starting at the optimum, the starting point must be kept.
+ */
+TEST_CASE("FTRLProximalStartingPointTest", "[FTRLProximalTest]")
+{
+  SparseTestFunction f;
+
+  FTRLProximal optimizer(1.0, 1.0, 0.5, 0.1, 1, 10, 1e-12);
+
+  arma::mat coordinates("2 1 1.5 4");
+  double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(1e-10));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(1e-10));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-10));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(1e-10));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(1e-10));
+}
+
+#ifdef ENS_USE_OPENMP
+
+/**
+ * With HOGWILD! threads, the updates of the sparse test function are disjoint,
+ * so the result should be the same.
+ */
+TEST_CASE("ParallelFTRLProximalTest", "[FTRLProximalTest]")
+{
+  SparseTestFunction f;
+
+  FTRLProximalType<OpenMPExecutor> optimizer(1.0, 1.0, 0.0, 0.0, 1, 1000,
+      1e-12);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+#endif
@@ -11,6 +11,8 @@
  * http://www.opensource.org/licenses/BSD-3-Clause for more information.
  */
 
+#include <chrono>
+#include <thread>
 #include <ensmallen.hpp>
 #include "catch.hpp"
 
@@ -330,6 +332,289 @@ TEST_CASE("LogisticRegressionEvaluateWithGradientTest", "[FunctionTest]")
   REQUIRE(hasEvaluateWithGradient == true);
 }
 
+/**
+ * Make sure the single-pass EvaluateWithGradient() of the logistic regression
+ * function matches Evaluate() and Gradient(), and stays finite for points that
+ * are classified wrongly with very high confidence.
+ */
+TEST_CASE("LogisticRegressionStableLossTest", "[FunctionTest]")
+{
+  arma::mat predictors(4, 50, arma::fill::randn);
+  arma::Row<size_t> responses = arma::randi<arma::Row<size_t>>(50,
+      arma::distr_param(0, 1));
+  LogisticRegressionFunction<> f(predictors, responses, 0.5);
+
+  arma::mat parameters(1, 5, arma::fill::randn);
+  arma::mat gradient, expectedGradient;
+
+  double objective = f.EvaluateWithGradient(parameters, gradient);
+  f.Gradient(parameters, expectedGradient);
+  REQUIRE(objective == Approx(f.Evaluate(parameters)).epsilon(1e-10));
+  REQUIRE(arma::norm(gradient - expectedGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  objective = f.EvaluateWithGradient(parameters, 10, gradient, 20);
+  f.Gradient(parameters, 10, expectedGradient, 20);
+  REQUIRE(objective == Approx(f.Evaluate(parameters, 10, 20)).epsilon(1e-10));
+  REQUIRE(arma::norm(gradient - expectedGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  // With huge parameters, the probability of some points underflows.
+  parameters *= 1e4;
+  objective = f.EvaluateWithGradient(parameters, gradient);
+  REQUIRE(std::isfinite(objective));
+  REQUIRE(gradient.is_finite());
+}
+
+/**
+ * Make sure that the logistic regression function gives the same results with
+ * sparse predictors as with dense predictors.
+ */
+TEST_CASE("LogisticRegressionSparsePredictorsTest", "[FunctionTest]")
+{
+  arma::sp_mat sparsePredictors;
+  sparsePredictors.sprandn(20, 60, 0.1);
+  const arma::mat densePredictors(sparsePredictors);
+  arma::Row<size_t> responses = arma::randi<arma::Row<size_t>>(60,
+      arma::distr_param(0, 1));
+
+  LogisticRegressionFunction<> dense(densePredictors, responses, 0.5);
+  LogisticRegressionFunction<arma::sp_mat> sparse(sparsePredictors, responses,
+      0.5);
+
+  arma::mat parameters(1, 21, arma::fill::randn);
+  arma::mat denseGradient, sparseGradient;
+
+  REQUIRE(sparse.Evaluate(parameters) ==
+      Approx(dense.Evaluate(parameters)).epsilon(1e-10));
+  REQUIRE(sparse.Evaluate(parameters, 10, 20) ==
+      Approx(dense.Evaluate(parameters, 10, 20)).epsilon(1e-10));
+
+  dense.Gradient(parameters, denseGradient);
+  sparse.Gradient(parameters, sparseGradient);
+  REQUIRE(arma::norm(denseGradient - sparseGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  const double denseObjective = dense.EvaluateWithGradient(parameters, 10,
+      denseGradient, 20);
+  const double sparseObjective = sparse.EvaluateWithGradient(parameters, 10,
+      sparseGradient, 20);
+  REQUIRE(sparseObjective == Approx(denseObjective).epsilon(1e-10));
+  REQUIRE(arma::norm(denseGradient - sparseGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  arma::vec denseColumn, sparseColumn;
+  for (size_t j = 0; j < parameters.n_cols; ++j)
+  {
+    dense.PartialGradient(parameters, j, denseColumn);
+    sparse.PartialGradient(parameters, j, sparseColumn);
+    REQUIRE(arma::norm(denseColumn - sparseColumn, "inf") ==
+        Approx(0.0).margin(1e-10));
+  }
+
+  // The data is reordered the same way for both.
+  arma::arma_rng::set_seed(17);
+  dense.Shuffle();
+  arma::arma_rng::set_seed(17);
+  sparse.Shuffle();
+  REQUIRE(sparse.Evaluate(parameters, 5, 30) ==
+      Approx(dense.Evaluate(parameters, 5, 30)).epsilon(1e-10));
+}
+
+/**
+ * Check that the logistic regression function on quantized predictors matches
+ * LogisticRegressionFunction on the dequantized predictors, and that the
+ * quantization error is within its bound.
+ */
+template<typename ElemType>
+void QuantizedLogisticRegressionCheck(const double tolerance)
+{
+  arma::mat predictors(20, 60, arma::fill::randn);
+  predictors.row(3) *= 100.0;
+  predictors.row(7).zeros();
+  const arma::Row<size_t> responses = arma::randi<arma::Row<size_t>>(60,
+      arma::distr_param(0, 1));
+
+  QuantizedLogisticRegressionFunction<ElemType> quantized(predictors,
+      responses, 0.5);
+  const arma::mat dequantized = quantized.Predictors().Dequantize();
+  for (size_t j = 0; j < predictors.n_rows; ++j)
+  {
+    const double range = arma::abs(predictors.row(j)).max();
+    REQUIRE(arma::abs(dequantized.row(j) - predictors.row(j)).max() <=
+        tolerance * range);
+  }
+
+  LogisticRegressionFunction<> dense(dequantized, responses, 0.5);
+  arma::mat parameters(1, 21, arma::fill::randn);
+  parameters *= 0.1;
+  arma::mat denseGradient, quantizedGradient;
+
+  REQUIRE(quantized.Evaluate(parameters) ==
+      Approx(dense.Evaluate(parameters)).epsilon(1e-10));
+  REQUIRE(quantized.Evaluate(parameters, 10, 20) ==
+      Approx(dense.Evaluate(parameters, 10, 20)).epsilon(1e-10));
+
+  dense.Gradient(parameters, denseGradient);
+  quantized.Gradient(parameters, quantizedGradient);
+  REQUIRE(arma::norm(denseGradient - quantizedGradient, "inf") ==
+      Approx(0.0).margin(1e-9));
+
+  const double denseObjective = dense.EvaluateWithGradient(parameters, 10,
+      denseGradient, 20);
+  const double quantizedObjective = quantized.EvaluateWithGradient(parameters,
+      10, quantizedGradient, 20);
+  REQUIRE(quantizedObjective == Approx(denseObjective).epsilon(1e-10));
+  REQUIRE(arma::norm(denseGradient - quantizedGradient, "inf") ==
+      Approx(0.0).margin(1e-9));
+
+  // Shuffling moves the codes with their responses.
+  const double objective = quantized.Evaluate(parameters);
+  quantized.Shuffle();
+  REQUIRE(quantized.Evaluate(parameters) == Approx(objective).epsilon(1e-10));
+}
+
+TEST_CASE("QuantizedLogisticRegressionInt8Test", "[FunctionTest]")
+{
+  QuantizedLogisticRegressionCheck<int8_t>(0.5 / 127 + 1e-12);
+}
+
+TEST_CASE("QuantizedLogisticRegressionFloat16Test", "[FunctionTest]")
+{
+  QuantizedLogisticRegressionCheck<Float16>(std::pow(2.0, -11) + 1e-12);
+}
+
+/**
+ * Check the conversions of half precision floats, which round to the nearest
+ * value.
+ */
+TEST_CASE("Float16ConversionTest", "[FunctionTest]")
+{
+  REQUIRE(Float16::FromFloat(1.0f).bits == 0x3c00);
+  REQUIRE(Float16::FromFloat(-2.0f).bits == 0xc000);
+  REQUIRE(Float16::FromFloat(65504.0f).bits == 0x7bff);
+  REQUIRE(Float16::FromFloat(1e6f).bits == 0x7c00);
+  REQUIRE(Float16::FromFloat(std::ldexp(1.0f, -24)).bits == 0x0001);
+  // Ties round to even.
+  REQUIRE(Float16::FromFloat(1.0f + std::ldexp(1.0f, -11)).bits == 0x3c00);
+  REQUIRE(Float16::FromFloat(1.0f + 3 * std::ldexp(1.0f, -11)).bits ==
+      0x3c02);
+
+  // Every finite half converts to float and back exactly.
+  size_t mismatches = 0;
+  for (uint32_t bits = 0; bits < 0x7c00; ++bits)
+  {
+    Float16 h;
+    h.bits = (uint16_t) bits;
+    mismatches += (Float16::FromFloat(h.ToFloat()).bits != bits);
+    h.bits |= 0x8000;
+    mismatches += (Float16::FromFloat(h.ToFloat()).bits != (bits | 0x8000));
+  }
+  REQUIRE(mismatches == 0);
+}
+
+/**
+ * Make sure that the softmax regression function gives the same results with
+ * sparse data as with dense data.
+ */
+TEST_CASE("SoftmaxRegressionSparseDataTest", "[FunctionTest]")
+{
+  arma::sp_mat sparseData;
+  sparseData.sprandn(15, 40, 0.2);
+  const arma::mat denseData(sparseData);
+  arma::Row<size_t> labels = arma::randi<arma::Row<size_t>>(40,
+      arma::distr_param(0, 2));
+
+  SoftmaxRegressionFunction dense(denseData, labels, 3, 0.1, true);
+  SoftmaxRegressionFunctionType<arma::sp_mat> sparse(sparseData, labels, 3,
+      0.1, true);
+
+  arma::mat parameters(3, 16, arma::fill::randn);
+  arma::mat denseGradient, sparseGradient;
+
+  REQUIRE(sparse.Evaluate(parameters) ==
+      Approx(dense.Evaluate(parameters)).epsilon(1e-10));
+  REQUIRE(sparse.Evaluate(parameters, 10, 20) ==
+      Approx(dense.Evaluate(parameters, 10, 20)).epsilon(1e-10));
+
+  dense.Gradient(parameters, denseGradient);
+  sparse.Gradient(parameters, sparseGradient);
+  REQUIRE(arma::norm(denseGradient - sparseGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  dense.Gradient(parameters, 10, denseGradient, 20);
+  sparse.Gradient(parameters, 10, sparseGradient, 20);
+  REQUIRE(arma::norm(denseGradient - sparseGradient, "inf") ==
+      Approx(0.0).margin(1e-10));
+
+  // The partial gradient is the column of the full gradient.
+  dense.Gradient(parameters, denseGradient);
+  arma::vec denseColumn, sparseColumn;
+  for (size_t j = 0; j < parameters.n_cols; ++j)
+  {
+    dense.PartialGradient(parameters, j, denseColumn);
+    sparse.PartialGradient(parameters, j, sparseColumn);
+    REQUIRE(arma::norm(denseColumn - sparseColumn, "inf") ==
+        Approx(0.0).margin(1e-10));
+    REQUIRE(arma::norm(denseGradient.col(j) - denseColumn, "inf") ==
+        Approx(0.0).margin(1e-10));
+  }
+}
+
+/**
+ * Make sure that the blocked softmax regression function gives the same
+ * objective and gradient as the direct computation, for any block size.
+ */
+TEST_CASE("SoftmaxRegressionBlockedTest", "[FunctionTest]")
+{
+  arma::mat data(8, 45, arma::fill::randn);
+  arma::Row<size_t> labels = arma::randi<arma::Row<size_t>>(45,
+      arma::distr_param(0, 3));
+  arma::mat parameters(4, 9, arma::fill::randn);
+
+  // Reference objective and gradient, from the full probability matrix.
+  SoftmaxRegressionFunction reference(data, labels, 4, 0.2, true);
+  arma::sp_mat groundTruth;
+  reference.GetGroundTruthMatrix(labels, groundTruth);
+  arma::mat probabilities;
+  reference.GetProbabilitiesMatrix(parameters, probabilities, 0, 45);
+  const double expectedObjective = -arma::accu(groundTruth %
+      arma::log(probabilities)) / 45 + 0.1 * arma::accu(parameters %
+      parameters);
+  const arma::mat inner = probabilities - groundTruth;
+  arma::mat expectedGradient(4, 9);
+  expectedGradient.col(0) = arma::sum(inner, 1) / 45 + 0.2 * parameters.col(0);
+  expectedGradient.cols(1, 8) = inner * data.t() / 45 + 0.2 *
+      parameters.cols(1, 8);
+
+  const size_t blockSizes[] = { 0, 1, 7, 45, 100 };
+  for (size_t b = 0; b < 5; ++b)
+  {
+    SoftmaxRegressionFunction f(data, labels, 4, 0.2, true, blockSizes[b]);
+
+    arma::mat gradient;
+    const double objective = f.EvaluateWithGradient(parameters, gradient);
+    REQUIRE(objective == Approx(expectedObjective).epsilon(1e-10));
+    REQUIRE(f.Evaluate(parameters) == Approx(expectedObjective).epsilon(1e-10));
+    REQUIRE(arma::norm(gradient - expectedGradient, "inf") ==
+        Approx(0.0).margin(1e-10));
+
+    arma::vec column;
+    for (size_t j = 0; j < parameters.n_cols; ++j)
+    {
+      f.PartialGradient(parameters, j, column);
+      REQUIRE(arma::norm(column - expectedGradient.col(j), "inf") ==
+          Approx(0.0).margin(1e-10));
+    }
+  }
+
+  // Large scores must not overflow.
+  SoftmaxRegressionFunction f(data, labels, 4, 0.2, true, 7);
+  arma::mat gradient;
+  REQUIRE(std::isfinite(f.EvaluateWithGradient(1e4 * parameters, gradient)));
+  REQUIRE(gradient.is_finite());
+}
+
 TEST_CASE("SDPTest", "[FunctionTest]")
 {
   typedef AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>> FunctionType;
@@ -668,3 +953,530 @@ TEST_CASE("ResolvableFunctionTypeCheckTest", "[FunctionTest]")
   static_assert(!CheckPartialGradient<D>::value,
       "CheckPartialGradient static check failed.");
 }
+
+class E
+{
+ public:
+  double Evaluate(const arma::mat&);
+  void EvaluateBatch(const arma::cube&, arma::vec&);
+};
+
+class F
+{
+ public:
+  double Evaluate(const arma::mat&) const;
+  void EvaluateBatch(const arma::cube&, arma::vec&) const;
+};
+
+/**
+ * Test the correctness of the detection of the EvaluateBatch() method.
+ */
+TEST_CASE("BatchEvaluationCheckTest", "[FunctionTest]")
+{
+  static_assert(!HasBatchEvaluation<A>::value,
+      "HasBatchEvaluation check failed.");
+  static_assert(!HasBatchEvaluation<D>::value,
+      "HasBatchEvaluation check failed.");
+  static_assert(HasBatchEvaluation<E>::value,
+      "HasBatchEvaluation check failed.");
+  static_assert(HasBatchEvaluation<F>::value,
+      "HasBatchEvaluation check failed.");
+}
+
+/**
+ * Utility class that counts the calls to its Evaluate() and Gradient().
+ */
+class CountingTestFunction
+{
+ public:
+  CountingTestFunction() : evaluations(0), gradients(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::dot(coordinates, coordinates);
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    ++gradients;
+    gradient = 2 * coordinates;
+  }
+
+  size_t evaluations;
+  size_t gradients;
+};
+
+/**
+ * Make sure that CachedFunction only calls the wrapped function for values it
+ * has not computed at the current coordinates yet.
+ */
+TEST_CASE("CachedFunctionTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  CachedFunction<CountingTestFunction> cached(f);
+
+  arma::mat x("1 2 3");
+  arma::mat gradient;
+
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.evaluations == 1);
+
+  // Only the gradient is missing.
+  REQUIRE(cached.EvaluateWithGradient(x, gradient) == Approx(14.0));
+  REQUIRE(f.evaluations == 1);
+  REQUIRE(f.gradients == 1);
+  cached.Gradient(x, gradient);
+  REQUIRE(f.gradients == 1);
+  REQUIRE(arma::norm(gradient - 2 * x, "inf") == Approx(0.0).margin(1e-12));
+  REQUIRE(cached.Hits() == 2);
+  REQUIRE(cached.Misses() == 2);
+
+  // New coordinates invalidate both values.
+  x(1) = -2;
+  cached.Gradient(x, gradient);
+  REQUIRE(f.gradients == 2);
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.evaluations == 2);
+
+  cached.Reset();
+  cached.Evaluate(x);
+  REQUIRE(f.evaluations == 3);
+
+  // The cached function can be optimized like the original one.
+  x = "1 2 3";
+  L_BFGS lbfgs;
+  lbfgs.Optimize(cached, x);
+  REQUIRE(arma::norm(x, 2) == Approx(0.0).margin(1e-5));
+}
+
+/**
+ * Make sure that EvaluationCache serves the coordinates it has seen, drops the
+ * least recently used ones, and rounds the coordinates if asked to.
+ */
+TEST_CASE("EvaluationCacheTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  EvaluationCache<CountingTestFunction> cached(f, 2);
+
+  const arma::mat x("1 2 3"), y("0 1 0"), z("2 0 0");
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(cached.Evaluate(y) == Approx(1.0));
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.evaluations == 2);
+
+  // z pushes out y, the least recently used.
+  REQUIRE(cached.Evaluate(z) == Approx(4.0));
+  REQUIRE(cached.Size() == 2);
+  REQUIRE(cached.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.evaluations == 3);
+  REQUIRE(cached.Evaluate(y) == Approx(1.0));
+  REQUIRE(f.evaluations == 4);
+  REQUIRE(cached.Hits() == 2);
+  REQUIRE(cached.Misses() == 4);
+
+  // The shape is part of the key.
+  REQUIRE(cached.Evaluate(arma::mat("1; 2; 3")) == Approx(14.0));
+  REQUIRE(f.evaluations == 5);
+
+  cached.Clear();
+  REQUIRE(cached.Size() == 0);
+  cached.Evaluate(x);
+  REQUIRE(f.evaluations == 6);
+
+  // With a quantum, nearby coordinates share the objective of the first one.
+  EvaluationCache<CountingTestFunction> rounded(f, 0, 0.1);
+  REQUIRE(rounded.Evaluate(x) == Approx(14.0));
+  REQUIRE(rounded.Evaluate(x + 0.01) == Approx(14.0));
+  REQUIRE(rounded.Hits() == 1);
+  REQUIRE(rounded.Evaluate(x + 0.1) != Approx(14.0));
+
+  // A second grid search over the same grid is served from the cache.
+  CountingTestFunction g;
+  EvaluationCache<CountingTestFunction> gridCached(g, 0);
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("5 3 4");
+  arma::mat params("0 0 0");
+
+  GridSearch gs;
+  gs.Optimize(gridCached, params, categoricalDimensions, numCategories);
+  const size_t evaluations = g.evaluations;
+  REQUIRE(evaluations >= 60);
+
+  params.zeros();
+  gs.Optimize(gridCached, params, categoricalDimensions, numCategories);
+  REQUIRE(g.evaluations == evaluations);
+  REQUIRE(arma::norm(params, "inf") == 0.0);
+
+  // Separable functions are evaluated on all their functions.
+  SGDTestFunction sgdf;
+  EvaluationCache<SGDTestFunction> sgdCached(sgdf);
+  const arma::mat point = sgdf.GetInitialPoint();
+  REQUIRE(sgdCached.Evaluate(point) == Approx(sgdf.Evaluate(point, 0, 3)));
+}
+
+/**
+ * Make sure that FiniteDifferenceFunction estimates the gradient with the
+ * expected number of evaluations, and lets L-BFGS minimize a function given
+ * only by Evaluate().
+ */
+TEST_CASE("FiniteDifferenceFunctionTest", "[FunctionTest]")
+{
+  typedef FiniteDifferenceFunction<CountingTestFunction> DifferencesType;
+
+  CountingTestFunction f;
+  const arma::mat x("1 2 3");
+  arma::mat gradient;
+
+  DifferencesType central(f);
+  central.Gradient(x, gradient);
+  REQUIRE(f.evaluations == 6);
+  REQUIRE(f.gradients == 0);
+  REQUIRE(arma::norm(gradient - 2 * x, "inf") == Approx(0.0).margin(1e-6));
+
+  // Forward differences reuse the objective at x.
+  DifferencesType forward(f, DifferencesType::ForwardDifferences);
+  REQUIRE(forward.EvaluateWithGradient(x, gradient) == Approx(14.0));
+  REQUIRE(forward.Evaluations() == 4);
+  REQUIRE(arma::norm(gradient - 2 * x, "inf") == Approx(0.0).margin(1e-4));
+
+  // SPSA takes two evaluations per direction; its average is close to the
+  // gradient.
+  DifferencesType spsa(f, DifferencesType::SPSA, 0.0, false, 2000);
+  spsa.Gradient(x, gradient);
+  REQUIRE(spsa.Evaluations() == 4000);
+  REQUIRE(arma::norm(gradient - 2 * x, 2) <= 0.2 * arma::norm(2 * x, 2));
+
+  // Rosenbrock is safe to evaluate from several threads.
+  RosenbrockFunction rf;
+  FiniteDifferenceFunction<RosenbrockFunction> differentiable(rf,
+      FiniteDifferenceFunction<RosenbrockFunction>::CentralDifferences, 0.0,
+      true);
+  arma::mat coordinates = rf.GetInitialPoint();
+
+  L_BFGS lbfgs;
+  lbfgs.Optimize(differentiable, coordinates);
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Make sure that FunctionCapabilities tells apart the native and the
+ * synthesized methods.
+ */
+TEST_CASE("FunctionCapabilitiesTest", "[FunctionTest]")
+{
+  typedef FunctionCapabilities<EvaluateGradientTestFunction> Separate;
+  static_assert(Separate::NativeEvaluate && Separate::NativeGradient,
+      "FunctionCapabilities check failed.");
+  static_assert(!Separate::NativeEvaluateWithGradient &&
+      Separate::SynthesizedEvaluateWithGradient,
+      "FunctionCapabilities check failed.");
+  static_assert(Separate::SynthesizedDecomposableEvaluateWithGradient,
+      "FunctionCapabilities check failed.");
+
+  typedef FunctionCapabilities<EvaluateWithGradientTestFunction> Fused;
+  static_assert(Fused::NativeEvaluateWithGradient &&
+      !Fused::SynthesizedEvaluateWithGradient,
+      "FunctionCapabilities check failed.");
+  static_assert(Fused::SynthesizedEvaluate && Fused::SynthesizedGradient,
+      "FunctionCapabilities check failed.");
+
+  // The capabilities of a wrapped function are those of the function.
+  typedef FunctionCapabilities<Function<EvaluateGradientTestFunction>>
+      Wrapped;
+  static_assert(Wrapped::SynthesizedEvaluateWithGradient,
+      "FunctionCapabilities check failed.");
+
+  typedef FunctionCapabilities<EmptyTestFunction> Empty;
+  static_assert(!Empty::Evaluate && !Empty::SynthesizedEvaluateWithGradient,
+      "FunctionCapabilities check failed.");
+}
+
+/**
+ * Utility class whose gradient is off by a factor of two.
+ */
+class WrongGradientTestFunction
+{
+ public:
+  double Evaluate(const arma::mat& coordinates)
+  { return arma::accu(arma::square(coordinates)); }
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  { gradient = coordinates; }
+};
+
+/**
+ * Make sure that CheckGradient() accepts correct gradients and rejects wrong
+ * ones, and that the timings have the expected entries.
+ */
+TEST_CASE("CheckGradientTest", "[FunctionTest]")
+{
+  RosenbrockFunction rosenbrock;
+  arma::mat coordinates("0.5; -0.7");
+  arma::mat numericalGradient;
+  REQUIRE(CheckGradient(rosenbrock, coordinates, numericalGradient) < 1e-6);
+  REQUIRE(numericalGradient.n_elem == 2);
+
+  WrongGradientTestFunction wrong;
+  REQUIRE(CheckGradient(wrong, coordinates) > 0.1);
+  REQUIRE(CheckGradient(wrong, coordinates, 1e-6, true) > 0.1);
+
+  // The separable functions of the generalized Rosenbrock function.
+  GeneralizedRosenbrockFunction f(10);
+  arma::mat x = f.GetInitialPoint();
+  REQUIRE(CheckDecomposableGradient(f, x, 2, 5) < 1e-6);
+
+  typedef Function<GeneralizedRosenbrockFunction> FullFunctionType;
+  FullFunctionType& full(static_cast<FullFunctionType&>(f));
+  std::vector<size_t> batchSizes;
+  batchSizes.push_back(1);
+  batchSizes.push_back(4);
+  batchSizes.push_back(100); // More than the number of functions.
+  const std::vector<FunctionTiming> timings = TimeDecomposableFunction(full, x,
+      batchSizes, 0.001);
+
+  REQUIRE(timings.size() == 6);
+  REQUIRE(timings[0].Method() == "Evaluate");
+  REQUIRE(timings[5].Method() == "EvaluateWithGradient");
+  REQUIRE(timings[5].BatchSize() == 4);
+  for (size_t i = 0; i < timings.size(); ++i)
+  {
+    REQUIRE(timings[i].Calls() > 0);
+    REQUIRE(timings[i].SamplesPerSecond() > 0.0);
+  }
+
+  Function<RosenbrockFunction>& fullRosenbrock(
+      static_cast<Function<RosenbrockFunction>&>(rosenbrock));
+  REQUIRE(TimeFunction(fullRosenbrock, coordinates, 0.001).size() == 3);
+}
+
+/**
+ * Make sure that the throughput tuner tries the expected configurations and
+ * returns the fastest one within the maximum batch size.
+ */
+TEST_CASE("TuneThroughputTest", "[FunctionTest]")
+{
+  GeneralizedRosenbrockFunction f(50);
+  typedef Function<GeneralizedRosenbrockFunction> FullFunctionType;
+  FullFunctionType& full(static_cast<FullFunctionType&>(f));
+  arma::mat x = f.GetInitialPoint();
+
+  std::vector<size_t> batchSizes;
+  batchSizes.push_back(1);
+  batchSizes.push_back(8);
+  batchSizes.push_back(1000); // More than the number of functions.
+  std::vector<size_t> threadCounts;
+  threadCounts.push_back(1);
+  threadCounts.push_back(2);
+  const std::vector<FunctionTiming> timings = TimeThroughput(full, x,
+      batchSizes, threadCounts, 0.001);
+
+  REQUIRE(timings.size() == 4);
+  REQUIRE(timings[0].Method() == "EvaluateWithGradient");
+  REQUIRE(timings[0].Threads() == 1);
+  REQUIRE(timings[3].BatchSize() == 8);
+  for (size_t i = 0; i < timings.size(); ++i)
+  {
+    REQUIRE(timings[i].Threads() >= 1);
+    REQUIRE(timings[i].Threads() <= 2);
+    REQUIRE(timings[i].Calls() >= timings[i].Threads());
+  }
+
+  const FunctionTiming best = TuneThroughput(full, x, 20, 2, 0.001);
+  REQUIRE(best.BatchSize() <= 20);
+  REQUIRE(best.Threads() >= 1);
+  REQUIRE(best.Threads() <= 2);
+  REQUIRE(best.SamplesPerSecond() > 0.0);
+
+  REQUIRE_THROWS_AS(TuneThroughput(full, x, 0), std::invalid_argument);
+}
+
+/**
+ * Make sure that the type-erased wrappers forward to the wrapped function,
+ * and that the optimizers give the same results through them.
+ */
+TEST_CASE("AnyFunctionTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  AnyDifferentiableFunction any(f);
+
+  arma::mat x("1 2 3");
+  arma::mat gradient;
+  REQUIRE(any.Evaluate(x) == Approx(14.0));
+  REQUIRE(any.EvaluateWithGradient(x, gradient) == Approx(14.0));
+  REQUIRE(arma::norm(gradient - 2 * x, "inf") == Approx(0.0).margin(1e-12));
+  REQUIRE(f.evaluations == 2);
+  REQUIRE(f.gradients == 1);
+
+  RosenbrockFunction rosenbrock;
+  AnyDifferentiableFunction anyRosenbrock(rosenbrock);
+  L_BFGS lbfgs;
+  arma::mat coordinates1 = rosenbrock.GetInitialPoint();
+  arma::mat coordinates2 = rosenbrock.GetInitialPoint();
+  const double result1 = lbfgs.Optimize(rosenbrock, coordinates1);
+  const double result2 = lbfgs.Optimize(anyRosenbrock, coordinates2);
+  REQUIRE(result2 == Approx(result1).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 1e-12));
+
+  SGDTestFunction sgdf;
+  AnySeparableFunction anySeparable(sgdf);
+  REQUIRE(anySeparable.NumFunctions() == 3);
+
+  SGD<AdamUpdate> adam(0.01, 1, 500000, 1e-9, false);
+  coordinates1 = sgdf.GetInitialPoint();
+  coordinates2 = sgdf.GetInitialPoint();
+  const double result3 = adam.Optimize(sgdf, coordinates1);
+  const double result4 = adam.Optimize(anySeparable, coordinates2);
+  REQUIRE(result4 == Approx(result3).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 1e-12));
+}
+
+/**
+ * A quadratic function whose evaluations run on their own threads, and which
+ * records how many of them run at once.
+ */
+class AsyncQuadraticFunction
+{
+ public:
+  AsyncQuadraticFunction() : running(0), peak(0) { }
+
+  std::future<double> EvaluateAsync(const arma::mat& coordinates)
+  {
+    return std::async(std::launch::async, [this, &coordinates]()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        peak = std::max(peak, ++running);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      const double objective = arma::accu(arma::square(coordinates - 0.5));
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+      }
+      return objective;
+    });
+  }
+
+  size_t running;
+  size_t peak;
+  std::mutex mutex;
+};
+
+/**
+ * Make sure that AsyncFunction keeps at most the given number of evaluations
+ * in flight, and that population-based optimizers can use it.
+ */
+TEST_CASE("AsyncFunctionTest", "[FunctionTest]")
+{
+  AsyncQuadraticFunction f;
+  AsyncFunction<AsyncQuadraticFunction> async(f, 3);
+
+  arma::cube candidates(4, 1, 20, arma::fill::randu);
+  arma::vec objectives;
+  async.EvaluateBatch(candidates, objectives);
+  REQUIRE(objectives.n_elem == 20);
+  for (size_t i = 0; i < candidates.n_slices; ++i)
+  {
+    REQUIRE(objectives[i] == Approx(arma::accu(arma::square(
+        candidates.slice(i) - 0.5))));
+  }
+  REQUIRE(async.PeakInFlight() <= 3);
+  REQUIRE(f.peak <= 3);
+
+  // CNE evaluates each generation through EvaluateBatch().
+  CNE cne(40, 200, 0.1, 0.05, 0.2, 1e-4, -1);
+  arma::mat coordinates(4, 1, arma::fill::zeros);
+  cne.Optimize(async, coordinates);
+  REQUIRE(async.PeakInFlight() <= 3);
+  REQUIRE(arma::norm(coordinates - 0.5, "inf") <= 0.1);
+
+  // CMA-ES sees a separable function with a single separable function.
+  CMAES<> cmaes(0, -1, 1, 1, 100, -1);
+  coordinates.zeros();
+  cmaes.Optimize(async, coordinates);
+  REQUIRE(async.PeakInFlight() <= 3);
+  REQUIRE(arma::norm(coordinates - 0.5, "inf") <= 0.01);
+}
+
+/**
+ * Utility class that only implements EvaluateWithGradient(), with an
+ * objective-only form, and counts the gradients it computes.
+ */
+class ObjectiveOnlyTestFunction
+{
+ public:
+  ObjectiveOnlyTestFunction() : gradients(0) { }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient)
+  {
+    ++gradients;
+    gradient = 2 * coordinates;
+    return arma::dot(coordinates, coordinates);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates, ObjectiveOnly)
+  {
+    return arma::dot(coordinates, coordinates);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    ++gradients;
+    gradient = 2 * batchSize * coordinates;
+    return (begin + batchSize) * arma::dot(coordinates, coordinates);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              const size_t batchSize,
+                              ObjectiveOnly) const
+  {
+    return (begin + batchSize) * arma::dot(coordinates, coordinates);
+  }
+
+  size_t NumFunctions() const { return 1; }
+  void Shuffle() { }
+
+  size_t gradients;
+};
+
+/**
+ * Make sure that the Evaluate() methods built from EvaluateWithGradient() use
+ * the objective-only form when there is one, and that the optimizers still
+ * work with it.
+ */
+TEST_CASE("ObjectiveOnlyEvaluateTest", "[FunctionTest]")
+{
+  REQUIRE(traits::HasObjectiveOnly<ObjectiveOnlyTestFunction>::value);
+  REQUIRE(!traits::HasObjectiveOnly<ObjectiveOnlyTestFunction>::constValue);
+  REQUIRE(traits::HasDecomposableObjectiveOnly<
+      ObjectiveOnlyTestFunction>::constValue);
+  REQUIRE(!traits::HasObjectiveOnly<EvaluateWithGradientTestFunction>::value);
+
+  Function<ObjectiveOnlyTestFunction> f;
+  const arma::mat x("1 2 3");
+  REQUIRE(f.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.Evaluate(x, 1, 1) == Approx(28.0));
+  REQUIRE(f.gradients == 0);
+
+  // A function without the objective-only form gets the same results from
+  // the reused gradient buffer.
+  Function<EvaluateWithGradientTestFunction> g;
+  const double objective = g.Evaluate(x);
+  REQUIRE(g.Evaluate(x) == Approx(objective));
+
+  // The final objective of SGD needs no gradient.
+  ObjectiveOnlyTestFunction h;
+  arma::mat coordinates("1 2 3");
+  StandardSGD sgd(0.1, 1, 100, -1);
+  const double result = sgd.Optimize(h, coordinates);
+  REQUIRE(h.gradients == 100);
+  REQUIRE(result == Approx(arma::dot(coordinates, coordinates)));
+  REQUIRE(arma::norm(coordinates, 2) == Approx(0.0).margin(1e-5));
+}
@@ -44,3 +44,198 @@ TEST_CASE("GDRosenbrockTest", "[GradientDescentTest]")
   for (size_t j = 0; j < 2; ++j)
     REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
 }
+
+/**
+ * An ill-conditioned quadratic, 0.5 sum_i d_i x_i^2 with d_i between 1 and
+ * 1000, that counts its evaluations.
+ */
+class IllConditionedQuadratic
+{
+ public:
+  IllConditionedQuadratic() :
+      d(arma::linspace<arma::vec>(1, 1000, 100)),
+      evaluations(0)
+  { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluations;
+    return 0.5 * arma::dot(d, arma::square(x));
+  }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& gradient)
+  {
+    gradient = d % x;
+    return Evaluate(x);
+  }
+
+  arma::mat GetInitialPoint() const { return arma::ones(100, 1); }
+
+  arma::vec d;
+  size_t evaluations;
+};
+
+/**
+ * With the largest stable step, plain gradient descent is slow on the
+ * ill-conditioned quadratic; the accelerated and the Barzilai-Borwein steps
+ * must reach the minimum within the same number of evaluations.
+ */
+TEST_CASE("GDAcceleratedIllConditionedTest", "[GradientDescentTest]")
+{
+  IllConditionedQuadratic f;
+  arma::mat coordinates = f.GetInitialPoint();
+  GradientDescent plain(0.001, 500, -1);
+  plain.Optimize(f, coordinates);
+  REQUIRE(f.Evaluate(coordinates) > 0.1);
+
+  coordinates = f.GetInitialPoint();
+  GradientDescent accelerated(0.001, 500, -1, true);
+  accelerated.Optimize(f, coordinates);
+  REQUIRE(f.Evaluate(coordinates) < 1e-10);
+
+  coordinates = f.GetInitialPoint();
+  f.evaluations = 0;
+  GradientDescent bb(0.001, 500, -1, false, true);
+  bb.Optimize(f, coordinates);
+  REQUIRE(f.evaluations == 499);
+  REQUIRE(f.Evaluate(coordinates) < 1e-6);
+}
+
+/**
+ * Backtracking must recover from a step size that is far too large.
+ */
+TEST_CASE("GDBacktrackingTest", "[GradientDescentTest]")
+{
+  IllConditionedQuadratic f;
+  arma::mat coordinates = f.GetInitialPoint();
+  GradientDescent optimizer(1.0, 500, -1, true, false, true);
+  optimizer.Optimize(f, coordinates);
+  REQUIRE(f.Evaluate(coordinates) < 1e-10);
+  REQUIRE(optimizer.Backtracking());
+
+  GDTestFunction g;
+  arma::mat x = g.GetInitialPoint();
+  GradientDescent plain(10.0, 100000, 1e-12, false, false, true);
+  plain.Optimize(g, x);
+  REQUIRE(arma::norm(x, "inf") == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * Each step mode must find the minimum of the Rosenbrock function with far
+ * fewer iterations than plain gradient descent.
+ */
+TEST_CASE("GDStepModesRosenbrockTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+
+  GradientDescent accelerated(0.001, 2000, 1e-15, true);
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = accelerated.Optimize(f, coordinates);
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-4));
+
+  GradientDescent accelerated2(0.01, 2000, 1e-15, true, false, true);
+  coordinates = f.GetInitialPoint();
+  result = accelerated2.Optimize(f, coordinates);
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+
+  GradientDescent bb(0.01, 2000, 1e-15, false, true, true);
+  coordinates = f.GetInitialPoint();
+  result = bb.Optimize(f, coordinates);
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-4));
+}
+
+/**
+ * Optimize the Booth function from a fixed-size iterate, with and without
+ * backtracking, and make sure that the results are those with the usual
+ * iterate.
+ */
+TEST_CASE("GDFixedSizeBoothTest", "[GradientDescentTest]")
+{
+  BoothFunction f;
+  for (size_t backtracking = 0; backtracking < 2; ++backtracking)
+  {
+    GradientDescent s(0.01, 100000, 1e-12);
+    s.Backtracking() = (backtracking == 1);
+
+    arma::mat coordinates = f.GetInitialPoint();
+    s.Optimize(f, coordinates);
+
+    arma::mat::fixed<2, 1> fixedCoordinates(f.GetInitialPoint());
+    const double result = s.Optimize(f, fixedCoordinates);
+
+    REQUIRE(result == Approx(0.0).margin(1e-5));
+    REQUIRE(fixedCoordinates[0] == Approx(1.0).epsilon(1e-3));
+    REQUIRE(fixedCoordinates[1] == Approx(3.0).epsilon(1e-3));
+    REQUIRE(fixedCoordinates[0] == Approx(coordinates[0]).epsilon(1e-12));
+    REQUIRE(fixedCoordinates[1] == Approx(coordinates[1]).epsilon(1e-12));
+  }
+}
+
+/**
+ * Make sure that accelerated gradient descent with backtracking, which
+ * exchanges the iterate with its candidate, writes the solution into the
+ * memory of an iterate that uses external memory.
+ */
+TEST_CASE("GDExternalMemoryTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+  GradientDescent s(0.01, 2000, 1e-15, true, false, true);
+
+  std::vector<double> memory = { -1.2, 1.0 };
+  arma::mat coordinates(memory.data(), 2, 1, false, false);
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates.memptr() == memory.data());
+  REQUIRE(memory[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(memory[1] == Approx(1.0).epsilon(1e-4));
+}
+
+/**
+ * Two interleaved step-wise optimizations must end at the same points, after
+ * the same number of iterations, as the optimizations run to completion.
+ */
+TEST_CASE("GDStepperTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+  GDTestFunction g;
+  GradientDescent optimizer(0.001, 3000, 1e-15, true, false, true);
+
+  arma::mat x = f.GetInitialPoint();
+  const double fResult = optimizer.Optimize(f, x);
+  arma::mat y = g.GetInitialPoint();
+  const double gResult = optimizer.Optimize(g, y);
+
+  arma::mat xStep = f.GetInitialPoint();
+  arma::mat yStep = g.GetInitialPoint();
+  GradientDescentStepper<RosenbrockFunction> fStepper =
+      MakeStepper(optimizer, f, xStep);
+  GradientDescentStepper<GDTestFunction> gStepper(optimizer, g, yStep);
+  REQUIRE(fStepper.Steps() == 0);
+
+  bool running = true;
+  while (running)
+  {
+    running = fStepper.Step(7);
+    running |= gStepper.Step(3);
+  }
+
+  REQUIRE(fStepper.Done());
+  REQUIRE(gStepper.Done());
+  REQUIRE(fStepper.Steps() > 0);
+  REQUIRE(fStepper.Steps() < 3000);
+  REQUIRE(fStepper.Result() == fResult);
+  REQUIRE(gStepper.Result() == gResult);
+  REQUIRE(arma::approx_equal(x, xStep, "absdiff", 0.0));
+  REQUIRE(arma::approx_equal(y, yStep, "absdiff", 0.0));
+
+  // A finished optimization takes no more steps.
+  const size_t steps = fStepper.Steps();
+  REQUIRE(!fStepper.Step(10));
+  REQUIRE(fStepper.Steps() == steps);
+}
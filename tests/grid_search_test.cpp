@@ -68,3 +68,207 @@ TEST_CASE("GridSearchTest", "[GridSearchTest]")
   REQUIRE(params[1] == 2);
   REQUIRE(params[2] == 1);
 }
+
+// The same categorical function, which also evaluates a batch of candidates at
+// once and counts the calls to Evaluate() and EvaluateBatch().
+class BatchCategoricalFunction
+{
+ public:
+  BatchCategoricalFunction() : evaluations(0), batchEvaluations(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluations;
+    return function.Evaluate(x);
+  }
+
+  void EvaluateBatch(const arma::cube& candidates, arma::vec& objectives)
+  {
+    ++batchEvaluations;
+    for (size_t i = 0; i < candidates.n_slices; ++i)
+      objectives(i) = function.Evaluate(candidates.slice(i));
+  }
+
+  size_t evaluations;
+  size_t batchEvaluations;
+
+ private:
+  SimpleCategoricalFunction function;
+};
+
+TEST_CASE("GridSearchBatchTest", "[GridSearchTest]")
+{
+  BatchCategoricalFunction c;
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("5 3 12");
+  arma::mat params("0 0 0");
+
+  // The values of the last dimension are evaluated at once.
+  GridSearch gs;
+  gs.Optimize(c, params, categoricalDimensions, numCategories);
+
+  REQUIRE(params[0] == 0);
+  REQUIRE(params[1] == 2);
+  REQUIRE(params[2] == 1);
+  REQUIRE(c.evaluations == 0);
+  REQUIRE(c.batchEvaluations == 15);
+}
+
+// A categorical function with a distinct value at each point, so that the
+// order in which the points are visited is observable.  The minimum is at
+// [3, 1, 7], and Evaluate() can be called concurrently.
+class DistinctCategoricalFunction
+{
+ public:
+  double Evaluate(const arma::mat& x) const
+  {
+    return std::abs(x[0] - 3) + 2 * std::abs(x[1] - 1) +
+        0.1 * std::abs(x[2] - 7);
+  }
+};
+
+TEST_CASE("GridSearchParallelTest", "[GridSearchTest]")
+{
+  DistinctCategoricalFunction f;
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("5 3 12");
+  arma::mat params, parallelParams;
+
+  GridSearch gs;
+  const double objective = gs.Optimize(f, params, categoricalDimensions,
+      numCategories);
+
+  GridSearch parallelGs(true);
+  const double parallelObjective = parallelGs.Optimize(f, parallelParams,
+      categoricalDimensions, numCategories);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-10));
+  REQUIRE(parallelObjective == objective);
+  REQUIRE(params[0] == 3);
+  REQUIRE(params[1] == 1);
+  REQUIRE(params[2] == 7);
+  for (size_t i = 0; i < params.n_elem; ++i)
+    REQUIRE(parallelParams[i] == params[i]);
+}
+
+TEST_CASE("GridSearchEarlyTerminationTest", "[GridSearchTest]")
+{
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("5 3 12");
+  arma::mat params("0 0 0");
+
+  // The optimum is the 26th point of the grid: [0, 2, 1].
+  BatchCategoricalFunction c;
+  GridSearch gs(false, 0, 0.0);
+  REQUIRE(gs.Optimize(c, params, categoricalDimensions, numCategories) == 0.0);
+  REQUIRE(params[0] == 0);
+  REQUIRE(params[1] == 2);
+  REQUIRE(params[2] == 1);
+  REQUIRE(c.batchEvaluations == 3);
+
+  // With a budget of 20 points the optimum is not reached.
+  BatchCategoricalFunction budget;
+  GridSearch budgetGs(false, 20);
+  REQUIRE(budgetGs.Optimize(budget, params, categoricalDimensions,
+      numCategories) == 10.0);
+  REQUIRE(budget.batchEvaluations == 2);
+
+  // The parallel search stops at the same point.
+  DistinctCategoricalFunction f;
+  GridSearch parallelGs(true, 0, 1.0);
+  REQUIRE(parallelGs.Optimize(f, params, categoricalDimensions,
+      numCategories) <= 1.0);
+  REQUIRE(params[0] == 2);
+  REQUIRE(params[1] == 1);
+  REQUIRE(params[2] == 7);
+}
+
+// A categorical function of two parameters that can be evaluated at several
+// fidelities: its value is (x0 - 4)^2 + (x1 - 2)^2, plus a deterministic error
+// in [0, 1 / fidelity) that is different for every point.  Since the values
+// differ by at least 1 on the grid, the optimum [4, 2] always ranks first.
+class FidelityCategoricalFunction
+{
+ public:
+  double Evaluate(const arma::mat& x, const double fidelity) const
+  {
+    const double h = std::abs(std::sin(x[0] * 12.9898 + x[1] * 78.233) *
+        43758.5453);
+    return std::pow(x[0] - 4.0, 2.0) + std::pow(x[1] - 2.0, 2.0) +
+        (h - std::floor(h)) / fidelity;
+  }
+};
+
+// The same function, which records the fidelities of its evaluations.
+class CountingFidelityFunction : public FidelityCategoricalFunction
+{
+ public:
+  double Evaluate(const arma::mat& x, const double fidelity)
+  {
+    fidelities.push_back(fidelity);
+    return FidelityCategoricalFunction::Evaluate(x, fidelity);
+  }
+
+  std::vector<double> fidelities;
+};
+
+TEST_CASE("HyperbandSuccessiveHalvingTest", "[GridSearchTest]")
+{
+  std::vector<bool> categoricalDimensions(2, true);
+  arma::Row<size_t> numCategories("6 6");
+  arma::mat params;
+
+  // The only bracket starts with all 36 points at the smallest budget (1 of
+  // 81), and keeps 12, 4, 1 and 1 of them for the budgets 3, 9, 27 and 81.
+  CountingFidelityFunction f;
+  Hyperband successiveHalving(81, 3, 1);
+  const double objective = successiveHalving.Optimize(f, params,
+      categoricalDimensions, numCategories);
+
+  REQUIRE(params[0] == 4);
+  REQUIRE(params[1] == 2);
+  REQUIRE(objective < 1.0 / 81);
+  REQUIRE(successiveHalving.Evaluations() == 54);
+  REQUIRE(f.fidelities.size() == 54);
+  REQUIRE(std::count(f.fidelities.begin(), f.fidelities.end(), 1.0) == 36);
+  REQUIRE(std::count(f.fidelities.begin(), f.fidelities.end(), 3.0) == 12);
+  REQUIRE(std::count(f.fidelities.begin(), f.fidelities.end(), 81.0) == 1);
+
+  // A grid search at full fidelity would take a budget of 36.
+  REQUIRE(successiveHalving.TotalBudget() == Approx(216.0 / 81));
+}
+
+TEST_CASE("HyperbandTest", "[GridSearchTest]")
+{
+  std::vector<bool> categoricalDimensions(2, true);
+  arma::Row<size_t> numCategories("6 6");
+
+  // The brackets evaluate 36 + 12 + 4 + 1 + 1, 34 + 11 + 3 + 1, 15 + 5 + 1,
+  // 8 + 2, and 5 points.
+  RandomSeed(12);
+  FidelityCategoricalFunction f;
+  arma::mat params;
+  Hyperband hyperband;
+  const double objective = hyperband.Optimize(f, params,
+      categoricalDimensions, numCategories);
+  REQUIRE(params[0] == 4);
+  REQUIRE(params[1] == 2);
+  REQUIRE(hyperband.Evaluations() == 139);
+
+  // The rungs evaluated in parallel give the same result.
+  RandomSeed(12);
+  arma::mat parallelParams;
+  HyperbandType<OpenMPExecutor> parallelHyperband;
+  REQUIRE(parallelHyperband.Optimize(f, parallelParams, categoricalDimensions,
+      numCategories) == objective);
+  REQUIRE(parallelParams[0] == 4);
+  REQUIRE(parallelParams[1] == 2);
+  ResetRandomSeed();
+
+  // A non-categorical dimension is rejected.
+  std::vector<bool> mixedDimensions = { true, false };
+  REQUIRE_THROWS_AS(hyperband.Optimize(f, params, mixedDimensions,
+      numCategories), std::invalid_argument);
+}
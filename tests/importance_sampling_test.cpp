@@ -0,0 +1,179 @@
+/**
+ * @file importance_sampling_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the importance sampling of separable functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The separable function sum_i c_i x, whose gradient of function i is c_i.
+ */
+class LinearSeparableFunction
+{
+ public:
+  LinearSeparableFunction(const arma::vec& c) : c(c) { }
+
+  size_t NumFunctions() const { return c.n_elem; }
+
+  void Shuffle() { }
+
+  double EvaluateWithGradient(const arma::mat& x,
+                              const size_t begin,
+                              arma::mat& g,
+                              const size_t batchSize)
+  {
+    const double sum = arma::accu(c.subvec(begin, begin + batchSize - 1));
+    g.set_size(1, 1);
+    g[0] = sum;
+    return sum * x[0];
+  }
+
+ private:
+  arma::vec c;
+};
+
+/**
+ * The indices should be drawn with the probabilities of the sampler, also
+ * after the weights are changed.
+ */
+TEST_CASE("ImportanceSamplerTest", "[ImportanceSamplingTest]")
+{
+  RandomSeed(42);
+
+  ImportanceSampler sampler(13, 0.2);
+  for (size_t i = 0; i < 13; ++i)
+    sampler.Update(i, (i % 4 == 0) ? 0.0 : double(i));
+  sampler.Update(5, 20.0);
+
+  double sum = 0.0;
+  for (size_t i = 0; i < 13; ++i)
+    sum += sampler.Probability(i);
+  REQUIRE(sum == Approx(1.0));
+
+  const size_t draws = 200000;
+  arma::vec counts(13, arma::fill::zeros);
+  for (size_t k = 0; k < draws; ++k)
+    counts[sampler.Sample()] += 1.0;
+
+  for (size_t i = 0; i < 13; ++i)
+    REQUIRE(counts[i] / draws == Approx(sampler.Probability(i)).margin(0.005));
+
+  ResetRandomSeed();
+}
+
+/**
+ * The weighted gradient of a sampled batch should be an unbiased estimate of
+ * the gradient of a batch of the same size.
+ */
+TEST_CASE("ImportanceSampledGradientTest", "[ImportanceSamplingTest]")
+{
+  RandomSeed(42);
+
+  const arma::vec c = arma::linspace<arma::vec>(1, 20, 20);
+  LinearSeparableFunction f(c);
+  ImportanceSampledFunction<LinearSeparableFunction> sampled(f, c);
+
+  const arma::mat x(1, 1, arma::fill::ones);
+  arma::mat g;
+  const size_t draws = 20000;
+  double mean = 0.0;
+  for (size_t k = 0; k < draws; ++k)
+  {
+    sampled.EvaluateWithGradient(x, 0, g, 4);
+    mean += g[0] / draws;
+  }
+
+  // A uniform batch of 4 has the expected gradient 4 * mean(c).
+  REQUIRE(mean == Approx(4 * arma::mean(c)).epsilon(0.01));
+
+  // The objective of a batch is not sampled.
+  REQUIRE(sampled.Evaluate(x, 0, 20) == Approx(arma::accu(c)));
+
+  ResetRandomSeed();
+}
+
+/**
+ * Run SGD with loss-based importance sampling on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("ImportanceSampledSGDLogisticRegressionTest",
+          "[ImportanceSamplingTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+    ImportanceSampledFunction<LogisticRegression<>> sampled(lr);
+
+    StandardSGD s(0.01, 32, 100000, 1e-9, true);
+    arma::mat coordinates = lr.GetInitialPoint();
+    s.Optimize(sampled, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Run CMA-ES with the importance selection policy on logistic regression and
+ * make sure the results are acceptable.
+ */
+TEST_CASE("ImportanceSelectionCMAESLogisticRegressionTest",
+          "[ImportanceSamplingTest]")
+{
+  const size_t trials = 3;
+  bool success = false;
+  for (size_t trial = 0; trial < trials; ++trial)
+  {
+    arma::mat data, testData, shuffledData;
+    arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+    LogisticRegressionTestData(data, testData, shuffledData,
+        responses, testResponses, shuffledResponses);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    CMAES<ImportanceSelection> cmaes(0, -1, 1, 32, 200, 1e-3,
+        ImportanceSelection());
+    arma::mat coordinates = lr.GetInitialPoint();
+    cmaes.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    if (acc >= 99.7 && testAcc >= 99.4)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
@@ -47,3 +47,81 @@ TEST_CASE("IQNLogisticRegressionTest", "[IQNTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
   }
 }
+
+/**
+ * Run IQN on a logistic regression problem with more parameters, where the
+ * inverse of the aggregate Hessian approximation is updated incrementally.
+ */
+TEST_CASE("IQNHighDimensionalLogisticRegressionTest", "[IQNTest]")
+{
+  // Two Gaussians in 20 dimensions, centered at (1, ..., 1) and (9, ..., 9).
+  const size_t dimensions = 20;
+  arma::mat data = arma::randn<arma::mat>(dimensions, 400);
+  arma::Row<size_t> responses(400);
+  for (size_t i = 0; i < 400; ++i)
+  {
+    responses[i] = i % 2;
+    data.col(i) += (responses[i] == 0) ? 1.0 : 9.0;
+  }
+
+  LogisticRegression<> lr(data, responses, 0.5);
+
+  IQN iqn(0.01, 10, 500, 1e-3);
+  arma::mat coordinates = lr.GetInitialPoint();
+  iqn.Optimize(lr, coordinates);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.01)); // 1% error tolerance.
+}
+
+/**
+ * Run LIQN on logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("LIQNLogisticRegressionTest", "[IQNTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 1; batchSize < 9; batchSize += 4)
+  {
+    LIQN liqn(0.01, batchSize, 5000, 1e-3, 10);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    liqn.Optimize(lr, coordinates);
+
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.013)); // 1.3% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
+  }
+}
+
+/**
+ * Make sure that the memory estimate of IQN grows with the square of the number
+ * of coordinates and with the number of batches, and that LIQN needs much less.
+ */
+TEST_CASE("IQNMemoryEstimateTest", "[IQNTest]")
+{
+  IQN iqn(0.01, 10);
+  LIQN liqn(0.01, 10, 100000, 1e-5, 10);
+
+  // 100 batches of 10 functions, and the last, partial batch.
+  const size_t small = MemoryEstimate(iqn, 100, 1, 1001);
+  REQUIRE(small >= 101 * 100 * 100 * sizeof(double));
+  REQUIRE((double) MemoryEstimate(iqn, 200, 1, 1001) / small ==
+      Approx(4.0).epsilon(0.05));
+  REQUIRE(MemoryEstimate(iqn, 100, 1, 2001) > small);
+
+  // LIQN stores vectors instead of matrices.
+  REQUIRE(MemoryEstimate(liqn, 100, 1, 1001) < small / 10);
+
+  // An optimizer without an estimate takes a few buffers of the iterate.
+  StandardSGD sgd;
+  REQUIRE(MemoryEstimate(sgd, 100, 1, 1001) == 4 * 100 * sizeof(double));
+}
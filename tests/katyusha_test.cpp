@@ -76,3 +76,73 @@ TEST_CASE("KatyushaProximalLogisticRegressionTest", "[KatyushaTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
   }
 }
+
+/**
+ * Run loopless Katyusha on logistic regression and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("LooplessKatyushaLogisticRegressionTest", "[KatyushaTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 30; batchSize < 45; batchSize += 5)
+  {
+    LooplessKatyusha optimizer(1.0, 10.0, batchSize, 3000, 0.0, 1e-10, true);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    optimizer.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+  }
+}
+
+// The sparse test function, which can also give its gradients as dense
+// matrices.
+class KatyushaSparseTestFunction : public SparseTestFunction
+{
+ public:
+  using SparseTestFunction::Gradient;
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    arma::sp_mat sparseGradient;
+    SparseTestFunction::Gradient(coordinates, i, sparseGradient, batchSize);
+    gradient = arma::mat(sparseGradient);
+  }
+};
+
+/**
+ * Katyusha with lazy sparse steps should take the same steps as with dense
+ * steps, and minimize the sparse test function.
+ */
+TEST_CASE("KatyushaSparseTestFunctionTest", "[KatyushaTest]")
+{
+  KatyushaSparseTestFunction f;
+
+  Katyusha optimizer(1.0, 10.0, 1, 500, 0, 1e-12, false);
+  arma::mat sparseCoordinates = f.GetInitialPoint();
+  arma::mat denseCoordinates = f.GetInitialPoint();
+  const double sparseResult = optimizer.Optimize<KatyushaSparseTestFunction,
+      arma::sp_mat>(f, sparseCoordinates);
+  const double denseResult = optimizer.Optimize<KatyushaSparseTestFunction,
+      arma::mat>(f, denseCoordinates);
+
+  REQUIRE(arma::approx_equal(sparseCoordinates, denseCoordinates, "absdiff",
+      1e-8));
+  REQUIRE(sparseResult == Approx(denseResult).epsilon(1e-10));
+  REQUIRE(sparseResult == Approx(123.75).epsilon(0.0001));
+}
@@ -12,6 +12,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -127,3 +128,522 @@ TEST_CASE("RosenbrockWoodFunctionTest", "[LBFGSTest]")
     REQUIRE((coords(row, 1)) == Approx(1.0).epsilon(1e-7));
   }
 }
+
+/**
+ * Tests the L-BFGS optimizer with the compact representation using the
+ * generalized Rosenbrock function, and make sure the search directions are the
+ * same as with the two-loop recursion.
+ */
+TEST_CASE("CompactGeneralizedRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  for (int i = 2; i < 10; i++)
+  {
+    // Dimension: powers of 2
+    int dim = std::pow(2.0, i);
+
+    GeneralizedRosenbrockFunction f(dim);
+    L_BFGS lbfgs(20);
+    lbfgs.MaxIterations() = 10000;
+    lbfgs.Compact() = true;
+
+    arma::vec coords = f.GetInitialPoint();
+    if (!lbfgs.Optimize(f, coords))
+      FAIL("L-BFGS optimization reported failure.");
+
+    double finalValue = f.Evaluate(coords);
+
+    // Test the output to make sure it is correct.
+    REQUIRE(finalValue == Approx(0.0).margin(1e-5));
+    for (int j = 0; j < dim; j++)
+      REQUIRE(coords[j] == Approx(1.0).epsilon(1e-7));
+  }
+
+  // A few iterations take the same path with both representations.
+  GeneralizedRosenbrockFunction f(16);
+  L_BFGS lbfgs(5, 12);
+  arma::vec coords1 = f.GetInitialPoint();
+  arma::vec coords2 = coords1;
+  lbfgs.Optimize(f, coords1);
+  lbfgs.Compact() = true;
+  lbfgs.Optimize(f, coords2);
+
+  for (size_t j = 0; j < coords1.n_elem; j++)
+    REQUIRE(coords2[j] == Approx(coords1[j]).epsilon(1e-5));
+}
+
+/**
+ * Tests the L-BFGS optimizer with the history stored in single precision, with
+ * both the two-loop recursion and the compact representation.
+ */
+TEST_CASE("FloatHistoryGeneralizedRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  for (size_t compact = 0; compact < 2; ++compact)
+  {
+    for (int i = 2; i < 8; i++)
+    {
+      // Dimension: powers of 2
+      int dim = std::pow(2.0, i);
+
+      GeneralizedRosenbrockFunction f(dim);
+      L_BFGS lbfgs(20);
+      lbfgs.MaxIterations() = 10000;
+      lbfgs.Compact() = (compact == 1);
+      lbfgs.FloatHistory() = true;
+
+      arma::vec coords = f.GetInitialPoint();
+      if (!lbfgs.Optimize(f, coords))
+        FAIL("L-BFGS optimization reported failure.");
+
+      double finalValue = f.Evaluate(coords);
+
+      REQUIRE(finalValue == Approx(0.0).margin(1e-5));
+      for (int j = 0; j < dim; j++)
+        REQUIRE(coords[j] == Approx(1.0).epsilon(1e-5));
+    }
+  }
+}
+
+/**
+ * With warm starts, two optimizations of ten iterations should take the same
+ * path as one of twenty iterations, with both representations.
+ */
+TEST_CASE("WarmStartGeneralizedRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  for (size_t compact = 0; compact < 2; ++compact)
+  {
+    GeneralizedRosenbrockFunction f(16);
+    L_BFGS lbfgs(5, 20);
+    lbfgs.Compact() = (compact == 1);
+    arma::vec coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+
+    L_BFGS warm(5, 10);
+    warm.Compact() = (compact == 1);
+    warm.WarmStart() = true;
+    arma::vec warmCoords = f.GetInitialPoint();
+    warm.Optimize(f, warmCoords);
+    warm.Optimize(f, warmCoords);
+
+    for (size_t j = 0; j < coords.n_elem; j++)
+      REQUIRE(warmCoords[j] == Approx(coords[j]).epsilon(1e-10));
+  }
+}
+
+/**
+ * Without warm starts, an optimizer that is reused keeps its buffers and its
+ * history, but every call should take the same path as a new optimizer.
+ */
+TEST_CASE("RepeatedOptimizeGeneralizedRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  for (size_t compact = 0; compact < 2; ++compact)
+  {
+    GeneralizedRosenbrockFunction f(16);
+    L_BFGS lbfgs(5, 20);
+    lbfgs.Compact() = (compact == 1);
+
+    arma::vec coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+
+    for (size_t trial = 0; trial < 3; ++trial)
+    {
+      L_BFGS fresh(5, 20);
+      fresh.Compact() = (compact == 1);
+      arma::vec freshCoords = f.GetInitialPoint() + 0.1 * trial;
+      fresh.Optimize(f, freshCoords);
+
+      arma::vec reusedCoords = f.GetInitialPoint() + 0.1 * trial;
+      lbfgs.Optimize(f, reusedCoords);
+
+      for (size_t j = 0; j < coords.n_elem; j++)
+        REQUIRE(reusedCoords[j] == Approx(freshCoords[j]).epsilon(1e-12));
+    }
+  }
+}
+
+/**
+ * Tests the L-BFGS optimizer with the More-Thuente line search using the
+ * Rosenbrock, Wood and generalized Rosenbrock functions.
+ */
+TEST_CASE("MoreThuenteLineSearchTest", "[LBFGSTest]")
+{
+  L_BFGSType<MoreThuenteLineSearch> lbfgs(20);
+  lbfgs.MaxIterations() = 10000;
+
+  RosenbrockFunction f;
+  arma::vec coords = f.GetInitialPoint();
+  if (!lbfgs.Optimize(f, coords))
+    FAIL("L-BFGS optimization reported failure.");
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-7));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-7));
+
+  WoodFunction wf;
+  coords = wf.GetInitialPoint();
+  if (!lbfgs.Optimize(wf, coords))
+    FAIL("L-BFGS optimization reported failure.");
+
+  REQUIRE(wf.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 4; j++)
+    REQUIRE(coords[j] == Approx(1.0).epsilon(1e-7));
+
+  for (int i = 2; i < 10; i++)
+  {
+    // Dimension: powers of 2
+    int dim = std::pow(2.0, i);
+
+    GeneralizedRosenbrockFunction gf(dim);
+    coords = gf.GetInitialPoint();
+    if (!lbfgs.Optimize(gf, coords))
+      FAIL("L-BFGS optimization reported failure.");
+
+    REQUIRE(gf.Evaluate(coords) == Approx(0.0).margin(1e-5));
+    for (int j = 0; j < dim; j++)
+      REQUIRE(coords[j] == Approx(1.0).epsilon(1e-7));
+  }
+}
+
+/**
+ * Tests the L-BFGS optimizer with the speculative line search, evaluating four
+ * steps at once, using the Rosenbrock and generalized Rosenbrock functions.
+ * The result must not depend on the executor.
+ */
+TEST_CASE("SpeculativeLineSearchTest", "[LBFGSTest]")
+{
+  L_BFGSType<SpeculativeLineSearch> lbfgs(10, 10000);
+  lbfgs.LineSearch().Steps() = 4;
+
+  RosenbrockFunction f;
+  arma::vec coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-7));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-7));
+
+  GeneralizedRosenbrockFunction gf(50);
+  arma::mat parallelCoords = gf.GetInitialPoint();
+  lbfgs.Optimize(gf, parallelCoords);
+
+  L_BFGSType<SpeculativeLineSearchType<SerialExecutor>> serialLbfgs(10, 10000,
+      1e-4, 0.9, 1e-6, 1e-15, 50, 1e-20, 1e20, false, false, false,
+      SpeculativeLineSearchType<SerialExecutor>(4));
+  arma::mat serialCoords = gf.GetInitialPoint();
+  serialLbfgs.Optimize(gf, serialCoords);
+
+  REQUIRE(gf.Evaluate(parallelCoords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 50; j++)
+  {
+    REQUIRE(parallelCoords[j] == Approx(1.0).epsilon(1e-7));
+    REQUIRE(parallelCoords[j] == serialCoords[j]);
+  }
+}
+
+/**
+ * Optimize the Booth and McCormick functions from fixed-size iterates, and make
+ * sure that the results are those of the usual iterates.
+ */
+TEST_CASE("FixedSizeBoothMcCormickFunctionTest", "[LBFGSTest]")
+{
+  L_BFGS lbfgs;
+
+  BoothFunction f;
+  arma::mat coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  arma::mat::fixed<2, 1> fixedCoords(f.GetInitialPoint());
+  const double objective = lbfgs.Optimize(f, fixedCoords);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(fixedCoords[0] == Approx(1.0).epsilon(1e-5));
+  REQUIRE(fixedCoords[1] == Approx(3.0).epsilon(1e-5));
+  REQUIRE(fixedCoords[0] == Approx(coords[0]).epsilon(1e-12));
+  REQUIRE(fixedCoords[1] == Approx(coords[1]).epsilon(1e-12));
+
+  McCormickFunction g;
+  coords = g.GetInitialPoint();
+  lbfgs.Optimize(g, coords);
+
+  arma::vec::fixed<2> fixedVec(g.GetInitialPoint());
+  lbfgs.Optimize(g, fixedVec);
+
+  REQUIRE(fixedVec[0] == Approx(coords[0]).epsilon(1e-12));
+  REQUIRE(fixedVec[1] == Approx(coords[1]).epsilon(1e-12));
+}
+
+/**
+ * The function f(x) = 0.5 * ||x - a||^2; with an L1 penalty lambda, its
+ * minimum is a soft-thresholded by lambda.
+ */
+class ShiftedQuadraticFunction
+{
+ public:
+  ShiftedQuadraticFunction(const arma::mat& a) : a(a) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    return 0.5 * arma::accu(arma::square(x - a));
+  }
+
+  void Gradient(const arma::mat& x, arma::mat& gradient) { gradient = x - a; }
+
+ private:
+  arma::mat a;
+};
+
+/**
+ * Make sure that OWL-QN finds the soft-thresholded minimum of a shifted
+ * quadratic, with the thresholded coordinates exactly zero.
+ */
+TEST_CASE("OWLQNShiftedQuadraticFunctionTest", "[LBFGSTest]")
+{
+  arma::mat a("3.0; -0.5; 0.2; -2.0; 0.9; 1.5");
+  ShiftedQuadraticFunction f(a);
+  OWLQN owlqn(1.0);
+
+  arma::mat coords(6, 1, arma::fill::ones);
+  const double finalValue = owlqn.Optimize(f, coords);
+
+  REQUIRE(coords[0] == Approx(2.0).epsilon(1e-5));
+  REQUIRE(coords[1] == 0.0);
+  REQUIRE(coords[2] == 0.0);
+  REQUIRE(coords[3] == Approx(-1.0).epsilon(1e-5));
+  REQUIRE(coords[4] == 0.0);
+  REQUIRE(coords[5] == Approx(0.5).epsilon(1e-5));
+
+  // 0.5 * (1 + 0.25 + 0.04 + 1 + 0.81 + 1) + (2 + 1 + 0.5).
+  REQUIRE(finalValue == Approx(5.55).epsilon(1e-5));
+}
+
+/**
+ * Without a penalty, OWL-QN is L-BFGS; make sure it solves the Rosenbrock
+ * function.
+ */
+TEST_CASE("OWLQNRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  OWLQN owlqn(0.0);
+
+  arma::mat coords = f.GetInitialPoint();
+  owlqn.Optimize(f, coords);
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Make sure that L-BFGS-B finds the minimum of a shifted quadratic within the
+ * bounds, which is the shift clamped to the bounds.
+ */
+TEST_CASE("LBFGSBShiftedQuadraticFunctionTest", "[LBFGSTest]")
+{
+  arma::mat a("3.0; -0.5; 0.2; -2.0; 0.9; 1.5");
+  ShiftedQuadraticFunction f(a);
+  L_BFGS_B lbfgsb(0.0, 1.0);
+
+  arma::mat coords(6, 1, arma::fill::ones);
+  coords *= -4.0;
+  lbfgsb.Optimize(f, coords);
+
+  REQUIRE(coords[0] == 1.0);
+  REQUIRE(coords[1] == 0.0);
+  REQUIRE(coords[2] == Approx(0.2).epsilon(1e-5));
+  REQUIRE(coords[3] == 0.0);
+  REQUIRE(coords[4] == Approx(0.9).epsilon(1e-5));
+  REQUIRE(coords[5] == 1.0);
+}
+
+/**
+ * Tests L-BFGS-B on the Rosenbrock function with the first coordinate bounded
+ * by 0.5, where the minimum is (0.5, 0.25), and without bounds.
+ */
+TEST_CASE("LBFGSBRosenbrockFunctionTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS_B lbfgsb(arma::mat("-2.0; -2.0"), arma::mat("0.5; 2.0"));
+
+  arma::mat coords = f.GetInitialPoint();
+  const double finalValue = lbfgsb.Optimize(f, coords);
+
+  REQUIRE(finalValue == Approx(0.25).epsilon(1e-5));
+  REQUIRE(coords[0] == Approx(0.5).epsilon(1e-5));
+  REQUIRE(coords[1] == Approx(0.25).epsilon(1e-4));
+
+  L_BFGS_B unbounded;
+  coords = f.GetInitialPoint();
+  unbounded.Optimize(f, coords);
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  REQUIRE(coords[0] == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coords[1] == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * The badly scaled function f(x) = 0.5 * sum_i c_i x_i^2.
+ */
+class ScaledQuadraticFunction
+{
+ public:
+  ScaledQuadraticFunction(const arma::mat& c) : c(c) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    return 0.5 * arma::accu(c % arma::square(x));
+  }
+
+  void Gradient(const arma::mat& x, arma::mat& gradient) { gradient = c % x; }
+
+ private:
+  arma::mat c;
+};
+
+/**
+ * With the exact inverse Hessian diagonal as preconditioner, L-BFGS solves a
+ * badly scaled quadratic in one step; with an estimated diagonal it must still
+ * converge.
+ */
+TEST_CASE("DiagonalPreconditionerScaledQuadraticFunctionTest", "[LBFGSTest]")
+{
+  arma::mat c = arma::logspace<arma::vec>(0, 6, 20);
+  ScaledQuadraticFunction f(c);
+
+  L_BFGSType<BacktrackingWolfeLineSearch, DiagonalPreconditioner> lbfgs(10, 2,
+      1e-4, 0.9, 1e-6, 1e-15, 50, 1e-20, 1e20, false, false, false,
+      BacktrackingWolfeLineSearch(), DiagonalPreconditioner(1.0 / c));
+
+  arma::mat coords(20, 1, arma::fill::ones);
+  lbfgs.Optimize(f, coords);
+  for (size_t i = 0; i < 20; ++i)
+    REQUIRE(coords[i] == Approx(0.0).margin(1e-8));
+
+  L_BFGSType<BacktrackingWolfeLineSearch, DiagonalPreconditioner> estimated;
+  coords.ones();
+  estimated.Optimize(f, coords);
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-8));
+}
+
+/**
+ * Run online L-BFGS on logistic regression and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("OnlineLBFGSLogisticRegressionTest", "[LBFGSTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  OnlineL_BFGS olbfgs(0.05, 32, 10, 1e-4, 50000, 1e-5);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  olbfgs.Optimize(lr, coordinates);
+
+  // Curvature pairs must have been formed.
+  REQUIRE(olbfgs.Pairs() > 0);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.013)); // 1.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
+}
+
+/**
+ * Fit logistic regression to a synthetic dataset held in mapped memory; the
+ * fitted parameters should be close to the planted ones.
+ */
+TEST_CASE("LBFGSSyntheticLogisticRegressionTest", "[LBFGSTest]")
+{
+  MappedMatrix data(5, 20000);
+  RandomPredictors(data.Matrix(), 3);
+  arma::Row<size_t> responses;
+  arma::rowvec parameters;
+  LogisticRegressionData(data.Matrix(), responses, parameters, 2.0, 3);
+
+  // The dataset only depends on its seed.
+  arma::mat copy(5, 20000);
+  RandomPredictors(copy, 3);
+  REQUIRE(arma::approx_equal(copy, data.Matrix(), "absdiff", 0.0));
+
+  LogisticRegression<> lr(data.Matrix(), responses);
+  arma::mat coordinates = lr.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(lr, coordinates);
+
+  for (size_t i = 0; i < parameters.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx(parameters[i]).margin(0.15));
+}
+
+/**
+ * The sparse synthetic predictors should have the given number of distinct
+ * rows per point, and a linear model without noise should be recovered exactly
+ * by least squares.
+ */
+TEST_CASE("LBFGSSyntheticLinearRegressionTest", "[LBFGSTest]")
+{
+  arma::sp_mat data;
+  RandomPredictors(data, 20, 1000, 4, 5);
+  REQUIRE(data.n_rows == 20);
+  REQUIRE(data.n_cols == 1000);
+  REQUIRE(data.n_nonzero == 4000);
+  for (size_t j = 0; j < data.n_cols; ++j)
+    REQUIRE(data.col_ptrs[j + 1] - data.col_ptrs[j] == 4);
+
+  arma::rowvec responses, parameters;
+  LinearRegressionData(data, responses, parameters, 0.0, 1.0, 5);
+
+  // Solve the least squares problem with the intercept as the first row.
+  const arma::mat design = arma::join_cols(arma::mat(arma::ones<arma::rowvec>(
+      1000)), arma::mat(data));
+  const arma::vec solution = arma::solve(design.t(), responses.t());
+  for (size_t i = 0; i < parameters.n_elem; ++i)
+    REQUIRE(solution[i] == Approx(parameters[i]).margin(1e-8));
+}
+
+/**
+ * The memory estimate of L-BFGS should be dominated by the history, which takes
+ * half the memory in single precision.
+ */
+TEST_CASE("LBFGSMemoryEstimateTest", "[LBFGSTest]")
+{
+  L_BFGS lbfgs(20);
+  const size_t estimate = MemoryEstimate(lbfgs, 1000, 10);
+  REQUIRE(estimate >= 2 * 20 * 10000 * sizeof(double));
+  REQUIRE(estimate < 2 * 25 * 10000 * sizeof(double));
+
+  lbfgs.FloatHistory() = true;
+  REQUIRE(MemoryEstimate(lbfgs, 1000, 10) < estimate / 2 +
+      10 * 10000 * sizeof(double));
+  REQUIRE(MemoryEstimate(lbfgs, 1000, 10) >= 2 * 20 * 10000 * sizeof(float));
+}
+
+/**
+ * A step-wise L-BFGS optimization keeps its history between the calls to
+ * Step(), so it must take the same iterations as Optimize().
+ */
+TEST_CASE("LBFGSStepperTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(16);
+  L_BFGS lbfgs(20);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = lbfgs.Optimize(f, coordinates);
+
+  arma::mat stepCoordinates = f.GetInitialPoint();
+  L_BFGSStepper<L_BFGS, GeneralizedRosenbrockFunction> stepper =
+      MakeStepper(lbfgs, f, stepCoordinates);
+  size_t calls = 0;
+  while (stepper.Step(3))
+    ++calls;
+
+  REQUIRE(stepper.Done());
+  REQUIRE(calls > 1);
+  REQUIRE(stepper.Steps() <= 3 * (calls + 1));
+  REQUIRE(stepper.Result() == objective);
+  REQUIRE(arma::approx_equal(coordinates, stepCoordinates, "absdiff", 0.0));
+  REQUIRE(stepper.Objective() == Approx(0.0).margin(1e-5));
+}
@@ -36,3 +36,64 @@ TEST_CASE("FuncFWTest", "[LineSearchTest]")
   REQUIRE((x2[1] - 0.2) == Approx(0.0).margin(1e-10));
   REQUIRE((x2[2] - 0.3) == Approx(0.0).margin(1e-10));
 }
+
+/**
+ * FuncSq without its Residual() method, so that the line search has to use the
+ * secant method.
+ */
+class SecantFuncSq
+{
+ public:
+  SecantFuncSq(const mat& A, const vec& b) : f(A, b) { }
+
+  double Evaluate(const mat& coords) { return f.Evaluate(coords); }
+
+  void Gradient(const mat& coords, mat& gradient)
+  {
+    f.Gradient(coords, gradient);
+  }
+
+ private:
+  FuncSq f;
+};
+
+/**
+ * The exact step of the line search for a least squares objective, and the
+ * cached residual of UpdateLineSearch, should give the same results as the
+ * secant method.
+ */
+TEST_CASE("FuncSqClosedFormTest", "[LineSearchTest]")
+{
+  mat A = randn<mat>(20, 10);
+  vec b = randn<vec>(20);
+  FuncSq f(A, b);
+  SecantFuncSq secantF(A, b);
+
+  LineSearch solver(100000, 1e-10);
+  for (size_t trial = 0; trial < 5; ++trial)
+  {
+    const mat x1 = randn<mat>(10, 1);
+    mat exact = randn<mat>(10, 1);
+    mat secant = exact;
+
+    const double objective = solver.Optimize(f, x1, exact);
+    const double secantObjective = solver.Optimize(secantF, x1, secant);
+
+    REQUIRE(objective == Approx(secantObjective).epsilon(1e-6));
+    REQUIRE(objective == Approx(f.Evaluate(exact)).epsilon(1e-10));
+    for (size_t i = 0; i < exact.n_elem; ++i)
+      REQUIRE(exact[i] == Approx(secant[i]).margin(1e-5));
+  }
+
+  ConstrLpBallSolver linearConstrSolver(2);
+  FrankWolfe<ConstrLpBallSolver, UpdateLineSearch> s(linearConstrSolver,
+      UpdateLineSearch(), 500, 1e-10);
+
+  vec coordinates = zeros<vec>(10);
+  vec secantCoordinates = zeros<vec>(10);
+  const double result = s.Optimize(f, coordinates);
+  const double secantResult = s.Optimize(secantF, secantCoordinates);
+
+  REQUIRE(result == Approx(secantResult).epsilon(1e-4));
+  REQUIRE(norm(coordinates) <= 1.0 + 1e-10);
+}
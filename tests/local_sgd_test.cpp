@@ -0,0 +1,160 @@
+/**
+ * @file local_sgd_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the local SGD optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A communicator that plays two workers with the same data: every sum doubles
+ * the data.  The sums are counted.
+ */
+class TwinCommunicator
+{
+ public:
+  typedef int RequestType;
+
+  TwinCommunicator() : reductions(0) { }
+
+  size_t Size() const { return 2; }
+  size_t Rank() const { return 0; }
+
+  template<typename ElemType>
+  void AllReduce(ElemType* data, const size_t n)
+  {
+    ++reductions;
+    for (size_t i = 0; i < n; ++i)
+      data[i] *= 2;
+  }
+
+  template<typename ElemType>
+  RequestType StartAllReduce(ElemType* data, const size_t n)
+  {
+    AllReduce(data, n);
+    return 0;
+  }
+
+  void Wait(RequestType& /* request */) { }
+
+  template<typename ElemType>
+  void Broadcast(ElemType* /* data */,
+                 const size_t /* n */,
+                 const size_t /* root */) { }
+
+  size_t reductions;
+};
+
+/**
+ * With a single worker, LocalSGD must take the same steps as SGD.
+ */
+TEST_CASE("LocalSGDSingleWorkerTest", "[LocalSGDTest]")
+{
+  SGDTestFunction f;
+
+  StandardSGD sgd(0.0003, 1, 300000, -1, false);
+  arma::mat coordinates1 = f.GetInitialPoint();
+  const double result1 = sgd.Optimize(f, coordinates1);
+
+  LocalSGD<> optimizer(0.0003, 1, 4, 300000, -1, false);
+  arma::mat coordinates2 = f.GetInitialPoint();
+  const double result2 = optimizer.Optimize(f, coordinates2);
+
+  REQUIRE(result2 == Approx(result1).epsilon(1e-12));
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+}
+
+/**
+ * LocalSGD must converge on the SGD test function with its own tolerance.
+ */
+TEST_CASE("LocalSGDTest", "[LocalSGDTest]")
+{
+  SGDTestFunction f;
+  LocalSGD<MomentumUpdate> optimizer(0.0003, 1, 8, 2500000, 1e-9, true,
+      MomentumUpdate(0.7));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0015));
+  REQUIRE(coordinates(0) == Approx(0.0).margin(0.015));
+  REQUIRE(coordinates(1) == Approx(0.0).margin(1e-6));
+  REQUIRE(coordinates(2) == Approx(0.0).margin(1e-6));
+}
+
+/**
+ * Two workers with the same data average to the coordinates and the moments
+ * of one, so the steps must be those of SGD with the same stateful update
+ * policy, while the objective is summed over both.
+ */
+TEST_CASE("LocalSGDMirroredWorkersTest", "[LocalSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<AdamUpdate> sgd(0.01, 32, 3200, -1, false);
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  const double result1 = sgd.Optimize(lr, coordinates1);
+
+  LocalSGD<AdamUpdate, NoDecay, TwinCommunicator> optimizer(0.01, 32, 4, 3200,
+      -1, false, AdamUpdate(), NoDecay(), TwinCommunicator(), true);
+  arma::mat coordinates2 = lr.GetInitialPoint();
+  const double result2 = optimizer.Optimize(lr, coordinates2);
+
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+  REQUIRE(result2 == Approx(2 * result1).epsilon(1e-12));
+
+  // 3200 points in batches of 32 take at least 100 steps, averaged every 4.
+  const size_t averages = optimizer.InstUpdatePolicy().Averages();
+  REQUIRE(averages >= 25);
+  REQUIRE(optimizer.InstUpdatePolicy().Steps() < 4);
+  REQUIRE(optimizer.Communicator().reductions >= averages);
+}
+
+#ifdef ENS_USE_MPI
+
+/**
+ * Train a logistic regression on the MPI processes, each with its own part of
+ * the data.
+ */
+TEST_CASE("LocalSGDMPILogisticRegressionTest", "[LocalSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  MPICommunicator communicator;
+  const size_t size = communicator.Size();
+  const size_t rank = communicator.Rank();
+  const size_t points = shuffledData.n_cols / size;
+  LogisticRegression<> lr(shuffledData.cols(rank * points,
+      (rank + 1) * points - 1), shuffledResponses.cols(rank * points,
+      (rank + 1) * points - 1), 0.5);
+
+  LocalSGD<AdamUpdate, NoDecay, MPICommunicator> optimizer(0.01, 32, 8,
+      100000, 1e-9, true, AdamUpdate(), NoDecay(), communicator, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file log_test.cpp
+ * @author Marcus Edel
+ *
+ * Test the log statements and the asynchronous log streams.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+
+/**
+ * Count the calls, to check whether a log statement is evaluated.
+ */
+static double CountedValue(size_t& calls)
+{
+  ++calls;
+  return 1.0;
+}
+
+/**
+ * The arguments of a disabled log statement must not be evaluated, even in a
+ * branch without braces.
+ */
+TEST_CASE("DisabledLogStatementTest", "[LogTest]")
+{
+  size_t infoCalls = 0, warnCalls = 0;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    if (i != 1)
+      ENS_INFO << "value " << CountedValue(infoCalls) << std::endl;
+    else
+      ENS_WARN << "value " << CountedValue(warnCalls) << std::endl;
+  }
+
+  #ifdef ENS_PRINT_INFO
+  REQUIRE(infoCalls == 2);
+  #else
+  REQUIRE(infoCalls == 0);
+  #endif
+
+  #ifdef ENS_PRINT_WARN
+  REQUIRE(warnCalls == 1);
+  #else
+  REQUIRE(warnCalls == 0);
+  #endif
+}
+
+/**
+ * The lines of an asynchronous stream must all be written to the target once
+ * the sink is flushed.
+ */
+TEST_CASE("AsyncLogStreamTest", "[LogTest]")
+{
+  std::ostringstream target;
+  std::ostream& stream = AsyncLogStream<2>(target);
+
+  for (size_t i = 0; i < 100; ++i)
+    stream << "line " << i << std::endl;
+
+  // A line without end is written when the stream is flushed.
+  stream << "last" << std::flush;
+  AsyncLogSink::Global().Flush();
+
+  const std::string text = target.str();
+  REQUIRE(std::count(text.begin(), text.end(), '\n') == 100);
+  REQUIRE(text.find("line 99\n") != std::string::npos);
+  REQUIRE(text.substr(text.size() - 4) == "last");
+}
@@ -200,6 +200,58 @@ TEST_CASE("ErdosRenyiRandomGraphMaxCutSDP", "[LRSDPTest]")
   REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
 }
 
+/**
+ * Solve the same max-cut SDP starting from rank 2, letting the rank grow until
+ * the dual slack certifies the solution.
+ */
+TEST_CASE("ErdosRenyiRandomGraphMaxCutRankAdaptiveSDP", "[LRSDPTest]")
+{
+  arma::mat edges;
+  if (edges.load("data/erdosrenyi-n100.csv", arma::csv_ascii) == false)
+  {
+    FAIL("couldn't load data");
+    return;
+  }
+
+  edges = edges.t();
+
+  arma::sp_mat laplacian;
+  CreateSparseGraphLaplacian(edges, laplacian);
+
+  float r = 0.5 + sqrt(0.25 + 2 * edges.n_cols);
+  if (ceil(r) > laplacian.n_rows)
+    r = laplacian.n_rows;
+  const size_t maxRank = ceil(r);
+
+  // Initialize coordinates to a feasible point of rank 2.
+  arma::mat coordinates(laplacian.n_rows, 2);
+  coordinates.zeros();
+  for (size_t i = 0; i < coordinates.n_rows; ++i)
+    coordinates(i, i % coordinates.n_cols) = 1.;
+
+  LRSDP<SDP<arma::sp_mat>> maxcut(laplacian.n_rows, 0, coordinates, 1000,
+      maxRank, 2);
+  maxcut.SDP().C() = laplacian;
+  maxcut.SDP().C() *= -1.; // need to minimize the negative
+  maxcut.SDP().SparseB().ones(laplacian.n_rows);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    maxcut.SDP().SparseA()[i].zeros(laplacian.n_rows, laplacian.n_rows);
+    maxcut.SDP().SparseA()[i](i, i) = 1.;
+  }
+
+  const double finalValue = maxcut.Optimize(coordinates);
+  REQUIRE(coordinates.n_cols > 2);
+  REQUIRE(coordinates.n_cols <= maxRank);
+
+  const arma::mat rrt = coordinates * trans(coordinates);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+    REQUIRE(rrt(i, i) == Approx(1.0).epsilon(1e-7));
+
+  // Final value taken by solving with Mosek
+  REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
+}
+
 /*
  * Test a nuclear norm minimization SDP.
  *
@@ -294,3 +346,260 @@ TEST_CASE("GaussianMatrixSensingSDP", "[LRSDPTest]")
       arma::norm(Xorig, "fro");
   REQUIRE(err == Approx(0.0).margin(0.05));
 }
+
+/**
+ * Make sure the augmented Lagrangian of an LRSDP, which never forms R * R^T,
+ * matches the explicit formula with R * R^T for sparse and dense constraints.
+ */
+TEST_CASE("LRSDPAugLagrangianEvaluationTest", "[LRSDPTest]")
+{
+  const size_t n = 8;
+  SDP<arma::sp_mat> sdp(n, 3, 1);
+  sdp.C() = arma::sprandu<arma::sp_mat>(n, n, 0.3);
+  sdp.C() += sdp.C().t();
+  for (size_t i = 0; i < 3; ++i)
+  {
+    sdp.SparseA()[i] = arma::sprandu<arma::sp_mat>(n, n, 0.2);
+    sdp.SparseA()[i] += sdp.SparseA()[i].t();
+  }
+  sdp.DenseA()[0] = arma::randu<arma::mat>(n, n);
+  sdp.DenseA()[0] += sdp.DenseA()[0].t();
+  sdp.SparseB() = arma::randu<arma::vec>(3);
+  sdp.DenseB() = arma::randu<arma::vec>(1);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(n, 3);
+  LRSDPFunction<SDP<arma::sp_mat>> function(sdp, coordinates);
+  const arma::vec lambda = arma::randn<arma::vec>(4);
+  const double sigma = 2.5;
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augLag(function,
+      lambda, sigma);
+
+  const arma::mat rrt = coordinates * coordinates.t();
+  double expectedObjective = arma::accu(arma::mat(sdp.C()) % rrt);
+  arma::mat s(sdp.C());
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const arma::mat a = (i < 3) ? arma::mat(sdp.SparseA()[i]) : sdp.DenseA()[0];
+    const double b = (i < 3) ? sdp.SparseB()[i] : sdp.DenseB()[0];
+    const double constraint = arma::accu(a % rrt) - b;
+    REQUIRE(function.EvaluateConstraint(i, coordinates) ==
+        Approx(constraint).margin(1e-10));
+
+    expectedObjective += -lambda[i] * constraint +
+        (sigma / 2.) * constraint * constraint;
+    s -= (lambda[i] - sigma * constraint) * a;
+  }
+  const arma::mat expectedGradient = 2 * s * coordinates;
+
+  REQUIRE(augLag.Evaluate(coordinates) ==
+      Approx(expectedObjective).epsilon(1e-10));
+
+  arma::mat gradient;
+  augLag.Gradient(coordinates, gradient);
+  REQUIRE(gradient.n_rows == n);
+  REQUIRE(gradient.n_cols == 3);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(gradient[i] == Approx(expectedGradient[i]).margin(1e-10));
+
+  // The fused evaluation at new coordinates must refresh the cached residuals.
+  const arma::mat newCoordinates = coordinates + 0.1;
+  arma::mat fusedGradient, separateGradient;
+  const double fusedObjective = augLag.EvaluateWithGradient(newCoordinates,
+      fusedGradient);
+  REQUIRE(function.Cached(newCoordinates));
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const arma::mat a = (i < 3) ? arma::mat(sdp.SparseA()[i]) : sdp.DenseA()[0];
+    const double b = (i < 3) ? sdp.SparseB()[i] : sdp.DenseB()[0];
+    REQUIRE(function.CachedResiduals()[i] == Approx(arma::accu(a %
+        (newCoordinates * newCoordinates.t())) - b).margin(1e-10));
+  }
+
+  LRSDPFunction<SDP<arma::sp_mat>> otherFunction(sdp, coordinates);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> otherAugLag(
+      otherFunction, lambda, sigma);
+  otherAugLag.Gradient(newCoordinates, separateGradient);
+  REQUIRE(fusedObjective ==
+      Approx(otherAugLag.Evaluate(newCoordinates)).epsilon(1e-10));
+  for (size_t i = 0; i < fusedGradient.n_elem; ++i)
+    REQUIRE(fusedGradient[i] == Approx(separateGradient[i]).margin(1e-10));
+}
+
+/**
+ * Make sure that low-rank constraints, given by their factors, give the same
+ * augmented Lagrangian as the same constraints given as dense matrices.
+ */
+TEST_CASE("LRSDPLowRankConstraintTest", "[LRSDPTest]")
+{
+  const size_t n = 8;
+  SDP<arma::sp_mat> lowRankSdp(n, 0, 0, 2);
+  SDP<arma::sp_mat> denseSdp(n, 0, 2);
+  lowRankSdp.C() = arma::sprandu<arma::sp_mat>(n, n, 0.3);
+  lowRankSdp.C() += lowRankSdp.C().t();
+  denseSdp.C() = lowRankSdp.C();
+
+  // A rank-one and a rank-two constraint.
+  for (size_t i = 0; i < 2; ++i)
+  {
+    lowRankSdp.LowRankA()[i] = arma::randn<arma::mat>(n, i + 1);
+    denseSdp.DenseA()[i] = lowRankSdp.LowRankA()[i] *
+        lowRankSdp.LowRankA()[i].t();
+  }
+  lowRankSdp.LowRankB() = arma::randu<arma::vec>(2);
+  denseSdp.DenseB() = lowRankSdp.LowRankB();
+  REQUIRE(lowRankSdp.NumConstraints() == 2);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(n, 3);
+  LRSDPFunction<SDP<arma::sp_mat>> lowRankFunction(lowRankSdp, coordinates);
+  LRSDPFunction<SDP<arma::sp_mat>> denseFunction(denseSdp, coordinates);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    REQUIRE(lowRankFunction.EvaluateConstraint(i, coordinates) ==
+        Approx(denseFunction.EvaluateConstraint(i, coordinates)).margin(1e-10));
+  }
+
+  const arma::vec lambda = arma::randn<arma::vec>(2);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> lowRankAugLag(
+      lowRankFunction, lambda, 2.5);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> denseAugLag(
+      denseFunction, lambda, 2.5);
+
+  arma::mat lowRankGradient, denseGradient;
+  REQUIRE(lowRankAugLag.EvaluateWithGradient(coordinates, lowRankGradient) ==
+      Approx(denseAugLag.EvaluateWithGradient(coordinates,
+      denseGradient)).epsilon(1e-10));
+  for (size_t i = 0; i < denseGradient.n_elem; ++i)
+    REQUIRE(lowRankGradient[i] == Approx(denseGradient[i]).margin(1e-10));
+}
+
+/**
+ * Make sure that the augmented Lagrangian of an LRSDPFunction in single
+ * precision matches the one in double precision to the accuracy of floats,
+ * with sparse, dense and low-rank constraints and a dense objective.
+ */
+TEST_CASE("LRSDPSinglePrecisionTest", "[LRSDPTest]")
+{
+  const size_t n = 30;
+  SDP<arma::mat> sdp(n, 2, 1, 1);
+  sdp.C() = arma::randu<arma::mat>(n, n);
+  sdp.C() += sdp.C().t();
+  for (size_t i = 0; i < 2; ++i)
+  {
+    sdp.SparseA()[i] = arma::sprandu<arma::sp_mat>(n, n, 0.2);
+    sdp.SparseA()[i] += sdp.SparseA()[i].t();
+  }
+  sdp.DenseA()[0] = arma::randu<arma::mat>(n, n);
+  sdp.DenseA()[0] += sdp.DenseA()[0].t();
+  sdp.LowRankA()[0] = arma::randn<arma::mat>(n, 2);
+  sdp.SparseB() = arma::randu<arma::vec>(2);
+  sdp.DenseB() = arma::randu<arma::vec>(1);
+  sdp.LowRankB() = arma::randu<arma::vec>(1);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(n, 3);
+  LRSDPFunction<SDP<arma::mat>> function(sdp, coordinates);
+  LRSDPFunction<SDP<arma::mat>> floatFunction(sdp, coordinates);
+  floatFunction.SinglePrecision() = true;
+  REQUIRE(floatFunction.SinglePrecision());
+
+  const arma::vec lambda = arma::randn<arma::vec>(4);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>> augLag(function,
+      lambda, 2.5);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>> floatAugLag(
+      floatFunction, lambda, 2.5);
+
+  arma::mat gradient, floatGradient;
+  const double objective = augLag.EvaluateWithGradient(coordinates, gradient);
+  const double floatObjective = floatAugLag.EvaluateWithGradient(coordinates,
+      floatGradient);
+
+  REQUIRE(floatFunction.Cached(coordinates));
+  REQUIRE(floatObjective == Approx(objective).epsilon(1e-5));
+  for (size_t i = 0; i < 4; ++i)
+  {
+    REQUIRE(floatFunction.CachedResiduals()[i] ==
+        Approx(function.CachedResiduals()[i]).epsilon(1e-5).margin(1e-4));
+  }
+  const double scale = arma::abs(gradient).max();
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(floatGradient[i] == Approx(gradient[i]).margin(1e-5 * scale));
+
+  // Modifying the SDP refreshes the single-precision copies.
+  floatFunction.SDP().DenseA()[0] *= 2.0;
+  function.SDP().DenseA()[0] *= 2.0;
+  floatFunction.UpdateCache(coordinates);
+  function.UpdateCache(coordinates);
+  REQUIRE(floatFunction.CachedResiduals()[2] ==
+      Approx(function.CachedResiduals()[2]).epsilon(1e-5).margin(1e-4));
+}
+
+/**
+ * Make sure that the gradient of the augmented Lagrangian is right when the
+ * constraints are split into chunks, which the deterministic mode does for
+ * any number of threads.
+ */
+TEST_CASE("LRSDPChunkedConstraintsTest", "[LRSDPTest]")
+{
+  const size_t n = 20;
+  const size_t numSparse = ENS_LRSDP_PARALLEL_THRESHOLD + 5;
+  SDP<arma::sp_mat> sdp(n, numSparse, 2, 1);
+  sdp.C() = arma::sprandu<arma::sp_mat>(n, n, 0.3);
+  sdp.C() += sdp.C().t();
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    sdp.SparseA()[i] = arma::sprandu<arma::sp_mat>(n, n, 0.05);
+    sdp.SparseA()[i] += sdp.SparseA()[i].t();
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    sdp.DenseA()[i] = arma::randu<arma::mat>(n, n);
+    sdp.DenseA()[i] += sdp.DenseA()[i].t();
+  }
+  sdp.LowRankA()[0] = arma::randn<arma::mat>(n, 2);
+  sdp.SparseB() = arma::randu<arma::vec>(numSparse);
+  sdp.DenseB() = arma::randu<arma::vec>(2);
+  sdp.LowRankB() = arma::randu<arma::vec>(1);
+
+  const arma::mat coordinates = arma::randn<arma::mat>(n, 3);
+  const arma::vec lambda = arma::randn<arma::vec>(sdp.NumConstraints());
+  const double sigma = 2.5;
+
+  const arma::mat rrt = coordinates * coordinates.t();
+  arma::mat s(sdp.C());
+  for (size_t i = 0; i < sdp.NumConstraints(); ++i)
+  {
+    arma::mat a;
+    double b;
+    if (i < numSparse)
+    {
+      a = arma::mat(sdp.SparseA()[i]);
+      b = sdp.SparseB()[i];
+    }
+    else if (i < numSparse + 2)
+    {
+      a = sdp.DenseA()[i - numSparse];
+      b = sdp.DenseB()[i - numSparse];
+    }
+    else
+    {
+      a = sdp.LowRankA()[0] * sdp.LowRankA()[0].t();
+      b = sdp.LowRankB()[0];
+    }
+    s -= (lambda[i] - sigma * (arma::accu(a % rrt) - b)) * a;
+  }
+  const arma::mat expectedGradient = 2 * s * coordinates;
+
+  const bool deterministic = Deterministic();
+  SetDeterministic(true);
+
+  LRSDPFunction<SDP<arma::sp_mat>> function(sdp, coordinates);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augLag(function,
+      lambda, sigma);
+  arma::mat gradient;
+  augLag.EvaluateWithGradient(coordinates, gradient);
+
+  SetDeterministic(deterministic);
+
+  const double scale = arma::abs(expectedGradient).max();
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(gradient[i] == Approx(expectedGradient[i]).margin(1e-10 * scale));
+}
@@ -30,5 +30,12 @@ int main(int argc, char** argv)
 
   std::cout << "armadillo version: " << arma::arma_version::as_string() << std::endl;
 
-  return Catch::Session().run(argc, argv);
+  #ifdef ENS_USE_MPI
+    MPI_Init(&argc, &argv);
+    const int result = Catch::Session().run(argc, argv);
+    MPI_Finalize();
+    return result;
+  #else
+    return Catch::Session().run(argc, argv);
+  #endif
 }
@@ -64,3 +64,26 @@ TEST_CASE("MomentumSGDGeneralizedRosenbrockTest", "[MomentumSGDTest]")
       REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
   }
 }
+
+/**
+ * Make sure that the fused momentum step matches the step written with
+ * Armadillo expressions.
+ */
+TEST_CASE("MomentumFusedUpdateTest", "[MomentumSGDTest]")
+{
+  MomentumUpdate momentum(0.7);
+  MomentumUpdate::Policy<arma::mat, arma::mat> policy(momentum, 7, 3);
+
+  arma::mat iterate = arma::randu<arma::mat>(7, 3);
+  arma::mat expected(iterate);
+  arma::mat velocity(7, 3, arma::fill::zeros);
+  for (size_t t = 0; t < 3; ++t)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(7, 3);
+    policy.Update(iterate, 0.1, gradient);
+
+    velocity = 0.7 * velocity - 0.1 * gradient;
+    expected += velocity;
+    REQUIRE(arma::approx_equal(iterate, expected, "absdiff", 1e-12));
+  }
+}
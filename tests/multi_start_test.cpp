@@ -0,0 +1,94 @@
+/**
+ * @file multi_start_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the MultiStart optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * L-BFGS from the initial point of the Rastrigin function stops in a local
+ * minimum; some of the random starts find the global minimum.
+ */
+TEST_CASE("MultiStartLBFGSRastriginFunctionTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+
+  arma::mat single = f.GetInitialPoint();
+  L_BFGS lbfgs;
+  const double singleObjective = lbfgs.Optimize(f, single);
+  REQUIRE(singleObjective > 1.0);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat coordinates = f.GetInitialPoint();
+  MultiStart<L_BFGS> optimizer(lbfgs, 20, -1.0, 1.0);
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(optimizer.Objectives().n_elem == 20);
+  REQUIRE(optimizer.Objectives()[0] == Approx(singleObjective));
+  REQUIRE(optimizer.Objectives()[optimizer.BestStart()] == objective);
+  REQUIRE(optimizer.Terminated() == 0);
+}
+
+/**
+ * With sequential starts, the starts that stop in a local minimum after the
+ * global one was found lag behind it and are terminated, and the result does
+ * not change.
+ */
+TEST_CASE("MultiStartLaggardTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+
+  arma::arma_rng::set_seed(42);
+  arma::mat coordinates = f.GetInitialPoint();
+  MultiStart<L_BFGS> optimizer(L_BFGS(), 20, -1.0, 1.0, 1, 0.1, false);
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(optimizer.Terminated() > 0);
+  REQUIRE(optimizer.Terminated() < 20);
+
+  // The starting points do not depend on the termination of the starts.
+  arma::arma_rng::set_seed(42);
+  arma::mat full = f.GetInitialPoint();
+  MultiStart<L_BFGS> fullOptimizer(L_BFGS(), 20, -1.0, 1.0, 0, 0.0, false);
+  fullOptimizer.Optimize(f, full);
+  CheckMatrices(coordinates, full, 1e-3);
+}
+
+/**
+ * MultiStart also runs optimizers without callbacks, and SGD-based ones.
+ */
+TEST_CASE("MultiStartGradientDescentAdamTest", "[MultiStartTest]")
+{
+  GDTestFunction f;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  MultiStart<GradientDescent> gd(GradientDescent(0.01, 5000000, 1e-9), 4);
+  const double gdObjective = gd.Optimize(f, coordinates);
+  REQUIRE(gdObjective == Approx(0.0).margin(1e-4));
+  REQUIRE(coordinates.n_elem == 3);
+
+  SGDTestFunction g;
+  coordinates = g.GetInitialPoint();
+  MultiStart<Adam> adam(Adam(1e-3, 1, 0.9, 0.999, 1e-8, 500000, 1e-9, false),
+      4, -1.0, 1.0, 0, 0.0, false);
+  adam.Optimize(g, coordinates);
+  REQUIRE(coordinates[0] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(0.3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(0.3));
+}
@@ -55,3 +55,26 @@ TEST_CASE("NesterovMomentumSGDGeneralizedRosenbrockTest", "[NesterovMomentumSGDT
       REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
   }
 }
+
+/**
+ * Make sure that the fused Nesterov momentum step matches the step written with
+ * Armadillo expressions.
+ */
+TEST_CASE("NesterovMomentumFusedUpdateTest", "[NesterovMomentumSGDTest]")
+{
+  NesterovMomentumUpdate momentum(0.7);
+  NesterovMomentumUpdate::Policy<arma::mat, arma::mat> policy(momentum, 7, 3);
+
+  arma::mat iterate = arma::randu<arma::mat>(7, 3);
+  arma::mat expected(iterate);
+  arma::mat velocity(7, 3, arma::fill::zeros);
+  for (size_t t = 0; t < 3; ++t)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(7, 3);
+    policy.Update(iterate, 0.1, gradient);
+
+    velocity = 0.7 * velocity - 0.1 * gradient;
+    expected += 0.7 * velocity - 0.1 * gradient;
+    REQUIRE(arma::approx_equal(iterate, expected, "absdiff", 1e-12));
+  }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file newton_cg_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the Newton-CG optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Tests the Newton-CG optimizer using the Rosenbrock function, which has no
+ * HessianVectorProduct(), so the products are finite differences.
+ */
+TEST_CASE("NewtonCGRosenbrockTest", "[NewtonCGTest]")
+{
+  RosenbrockFunction f;
+  NewtonCG optimizer;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(optimizer.HessianProducts() > 0);
+}
+
+/**
+ * Make sure that the exact Hessian-vector product of the logistic regression
+ * function matches the finite difference of its gradient.
+ */
+TEST_CASE("LogisticRegressionHessianVectorProductTest", "[NewtonCGTest]")
+{
+  arma::mat data(4, 100, arma::fill::randn);
+  arma::Row<size_t> responses = arma::randi<arma::Row<size_t>>(100,
+      arma::distr_param(0, 1));
+  LogisticRegression<> f(data, responses, 0.5);
+
+  static_assert(traits::HasHessianVectorProduct<LogisticRegression<>>::value,
+      "HasHessianVectorProduct check failed.");
+  static_assert(!traits::HasHessianVectorProduct<RosenbrockFunction>::value,
+      "HasHessianVectorProduct check failed.");
+
+  arma::mat parameters(1, 5, arma::fill::randn);
+  arma::mat v(1, 5, arma::fill::randn);
+  arma::mat gradient, exact, approximate;
+  f.Gradient(parameters, gradient);
+
+  HessianVectorProduct(f, parameters, gradient, v, exact);
+  HessianProduct<LogisticRegression<>, false>::Product(f, parameters, gradient,
+      v, approximate);
+
+  REQUIRE(arma::norm(exact - approximate, 2) <=
+      1e-4 * std::max(1.0, arma::norm(exact, 2)));
+}
+
+/**
+ * Train logistic regression with Newton-CG, using the exact Hessian-vector
+ * products, and compare with L-BFGS.
+ */
+TEST_CASE("NewtonCGLogisticRegressionTest", "[NewtonCGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  NewtonCG optimizer;
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  L_BFGS lbfgs;
+  arma::mat lbfgsCoordinates = f.GetInitialPoint();
+  const double lbfgsResult = lbfgs.Optimize(f, lbfgsCoordinates);
+
+  REQUIRE(result == Approx(lbfgsResult).epsilon(1e-5));
+
+  // Ensure that the error is close to zero.
+  const double acc = f.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = f.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that Newton-CG writes the solution into the memory of an iterate
+ * that uses external memory.
+ */
+TEST_CASE("NewtonCGExternalMemoryTest", "[NewtonCGTest]")
+{
+  RosenbrockFunction f;
+  NewtonCG optimizer;
+
+  std::vector<double> memory = { -1.2, 1.0 };
+  arma::mat coordinates(memory.data(), 2, 1, false, false);
+  const double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates.memptr() == memory.data());
+  REQUIRE(memory[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(memory[1] == Approx(1.0).epsilon(1e-4));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file nonlinear_cg_test.cpp
+ * @author Marcus Edel
+ *
+ * Tests for the nonlinear conjugate gradient optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Tests nonlinear CG with both choices of beta using the Rosenbrock function.
+ */
+TEST_CASE("NonlinearCGRosenbrockTest", "[NonlinearCGTest]")
+{
+  RosenbrockFunction f;
+
+  NonlinearCG hz;
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = hz.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-4));
+
+  NonlinearCGType<PolakRibierePlus> pr;
+  coordinates = f.GetInitialPoint();
+  result = pr.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  REQUIRE(coordinates[0] == Approx(1.0).epsilon(1e-4));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(1e-4));
+}
+
+/**
+ * Tests nonlinear CG using the generalized Rosenbrock function, from 4 to 256
+ * dimensions, with periodic restarts and with the back-tracking line search
+ * of L-BFGS.
+ */
+TEST_CASE("NonlinearCGGeneralizedRosenbrockTest", "[NonlinearCGTest]")
+{
+  for (int i = 2; i < 9; i++)
+  {
+    const int dim = std::pow(2.0, i);
+    GeneralizedRosenbrockFunction f(dim);
+
+    NonlinearCG optimizer(0);
+    optimizer.RestartInterval() = dim;
+    arma::mat coordinates = f.GetInitialPoint();
+    double result = optimizer.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(0.0).margin(1e-5));
+    for (int j = 0; j < dim; j++)
+      REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-3));
+
+    // The back-tracking line search needs the usual Wolfe parameter.
+    NonlinearCGType<HagerZhang, BacktrackingWolfeLineSearch> backtracking(0,
+        1e-4, 0.9);
+    coordinates = f.GetInitialPoint();
+    result = backtracking.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(0.0).margin(1e-5));
+    for (int j = 0; j < dim; j++)
+      REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-3));
+  }
+}
+
+/**
+ * Train logistic regression with nonlinear CG and compare with L-BFGS.
+ */
+TEST_CASE("NonlinearCGLogisticRegressionTest", "[NonlinearCGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  NonlinearCG optimizer;
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = optimizer.Optimize(f, coordinates);
+
+  L_BFGS lbfgs;
+  arma::mat lbfgsCoordinates = f.GetInitialPoint();
+  const double lbfgsResult = lbfgs.Optimize(f, lbfgsCoordinates);
+
+  REQUIRE(result == Approx(lbfgsResult).epsilon(1e-5));
+
+  // Ensure that the error is close to zero.
+  const double acc = f.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
@@ -90,6 +90,99 @@ TEST_CASE("ParallelSGDGeneralizedRosenbrockTest", "[ParallelSGDTest]")
   }
 }
 
+/**
+ * A share size that is too small to cover the data in one iteration should
+ * still visit every function over successive iterations.
+ */
+TEST_CASE("ParallelSGDSmallThreadShareTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  ConstantStep decayPolicy(0.4);
+
+  omp_set_num_threads(1);
+
+  // Each iteration only processes one function, so the tolerance is set low
+  // enough that no iteration terminates the optimization early.
+  ParallelSGD<ConstantStep> s(10000, 1, 1e-15, true, decayPolicy);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Test parallel SGD with mini-batches, automatic partitioning and
+ * non-atomic updates.
+ */
+TEST_CASE("ParallelSGDBatchNonAtomicTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  ConstantStep decayPolicy(0.4);
+
+  ParallelSGD<ConstantStep> s(10000, 0, 1e-5, true, decayPolicy, 2, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Test parallel SGD when the objective is accumulated during each pass
+ * instead of being recomputed at every iteration.
+ */
+TEST_CASE("ParallelSGDAccumulateObjectiveTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  ConstantStep decayPolicy(0.4);
+
+  ParallelSGD<ConstantStep> s(10000, 0, 1e-10, true, decayPolicy, 1, true,
+      true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Parallel SGD should also work with dense gradients.
+ */
+TEST_CASE("ParallelSGDDenseGradientTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  ConstantStep decayPolicy(0.001);
+
+  ParallelSGD<ConstantStep> s(0, 0, 1e-12, true, decayPolicy);
+
+  arma::mat coordinates = f.GetInitialPoint();
+
+  omp_set_num_threads(1);
+  double result = s.Optimize<GeneralizedRosenbrockFunction, arma::mat,
+      arma::mat>(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  for (size_t j = 0; j < 10; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(0.0001));
+}
+
 #endif
 
 /**
@@ -110,3 +203,418 @@ TEST_CASE("ExponentialBackoffDecayTest", "[ParallelSGDTest]")
   // At the 211th iteration, stepsize should be changed
   REQUIRE(decayPolicy.StepSize(211) == 81);
 }
+
+/**
+ * Every executor must run every task exactly once, also when Run() is called
+ * from inside a task, and the ThreadPoolExecutor must rethrow the exception of
+ * a task.
+ */
+TEST_CASE("ExecutorTest", "[ParallelSGDTest]")
+{
+  ThreadPoolExecutor pool(4);
+  REQUIRE(pool.Threads() == 4);
+
+  std::vector<size_t> counts(50, 0);
+  pool.Run(10, [&](const size_t t)
+  {
+    // Each task owns five counters.
+    pool.Run(5, [&](const size_t u) { ++counts[5 * t + u]; });
+  });
+  for (size_t i = 0; i < counts.size(); ++i)
+    REQUIRE(counts[i] == 1);
+
+  REQUIRE_THROWS_AS(pool.Run(8, [](const size_t t)
+  {
+    if (t == 5)
+      throw std::runtime_error("task failed");
+  }), std::runtime_error);
+
+  OpenMPExecutor openmp;
+  std::vector<size_t> openmpCounts(10, 0);
+  openmp.Run(10, [&](const size_t t) { ++openmpCounts[t]; });
+  for (size_t i = 0; i < openmpCounts.size(); ++i)
+    REQUIRE(openmpCounts[i] == 1);
+
+  SerialExecutor serial;
+  REQUIRE(serial.Threads() == 1);
+}
+
+/**
+ * Parallel SGD on the threads of a ThreadPoolExecutor, which does not need
+ * OpenMP; each thread updates its own coordinates of the sparse test function.
+ */
+TEST_CASE("ThreadPoolParallelSGDTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  ParallelSGD<ConstantStep, ThreadPoolExecutor> s(10000, 0, 1e-5, true,
+      ConstantStep(0.4), 1, true, false, ThreadPoolExecutor(4));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * With a SerialExecutor, parallel SGD should be identical to normal SGD.
+ */
+TEST_CASE("SerialParallelSGDTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+
+  ParallelSGD<ConstantStep, SerialExecutor> s(0, f.NumFunctions(), 1e-12,
+      true, ConstantStep(0.001));
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  for (size_t j = 0; j < 10; ++j)
+    REQUIRE(coordinates[j] == Approx(1.0).epsilon(0.0001));
+}
+
+/**
+ * With a SerialExecutor, the adaptive update policies of parallel SGD should
+ * take the AdaGrad and lazy Adam steps of the coordinates of each batch, with
+ * the batches counted over the whole optimization.
+ */
+TEST_CASE("ParallelSGDAdaptiveUpdateTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+  const double stepSize = 0.1;
+  const size_t iterations = 20;
+  const arma::vec b("-4 -2 -3 -8");
+
+  ParallelSGD<ConstantStep, SerialExecutor, SparseAdaGradUpdate> adaGrad(
+      iterations + 1, 4, -1.0, false, ConstantStep(stepSize));
+  arma::mat adaGradCoordinates = f.GetInitialPoint();
+  adaGrad.Optimize(f, adaGradCoordinates);
+
+  ParallelSGD<ConstantStep, SerialExecutor, SparseAdamUpdate> adam(
+      iterations + 1, 4, -1.0, false, ConstantStep(stepSize));
+  arma::mat adamCoordinates = f.GetInitialPoint();
+  adam.Optimize(f, adamCoordinates);
+
+  // Each batch is one function, which only touches its own coordinate.
+  arma::vec x(4, arma::fill::zeros), sum(4, arma::fill::zeros);
+  arma::vec y(4, arma::fill::zeros), m(4, arma::fill::zeros),
+      v(4, arma::fill::zeros);
+  for (size_t t = 1; t <= 4 * iterations; ++t)
+  {
+    const size_t i = (t - 1) % 4;
+
+    const double g = 2 * x[i] + b[i];
+    sum[i] += g * g;
+    x[i] -= stepSize * g / (std::sqrt(sum[i]) + 1e-8);
+
+    const double h = 2 * y[i] + b[i];
+    m[i] = 0.9 * m[i] + 0.1 * h;
+    v[i] = 0.999 * v[i] + 0.001 * h * h;
+    y[i] -= stepSize * (m[i] / (1.0 - std::pow(0.9, (double) t))) /
+        (std::sqrt(v[i] / (1.0 - std::pow(0.999, (double) t))) + 1e-8);
+  }
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    REQUIRE(adaGradCoordinates[i] == Approx(x[i]).epsilon(1e-6));
+    REQUIRE(adamCoordinates[i] == Approx(y[i]).epsilon(1e-6));
+  }
+  REQUIRE(adaGrad.UpdatePolicy().SquaredGradients()[0] ==
+      Approx(sum[0]).epsilon(1e-10));
+}
+
+/**
+ * An executor that runs the tasks of four threads on the calling thread, and
+ * remembers the task that is running.
+ */
+class RecordingExecutor
+{
+ public:
+  RecordingExecutor() : task(0) { }
+
+  size_t Threads() const { return 4; }
+
+  template<typename TaskType>
+  void Run(const size_t tasks, TaskType taskFunction)
+  {
+    for (task = 0; task < tasks; ++task)
+      taskFunction(task);
+  }
+
+  size_t task;
+};
+
+/**
+ * A generalized Rosenbrock function that counts the functions whose gradient
+ * is computed by more than one task of the given executor.
+ */
+class TaskRecordingFunction
+{
+ public:
+  TaskRecordingFunction(const size_t n, const RecordingExecutor& executor) :
+      f(n),
+      executor(executor),
+      owners(f.NumFunctions(), -1),
+      violations(0)
+  { }
+
+  size_t NumFunctions() const { return f.NumFunctions(); }
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return f.Evaluate(coordinates);
+  }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return f.Evaluate(coordinates, begin, batchSize);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::sp_mat& gradient,
+                const size_t batchSize)
+  {
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      if (owners[i] == -1)
+        owners[i] = executor.task;
+      else if (owners[i] != (int) executor.task)
+        ++violations;
+    }
+
+    f.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+  GeneralizedRosenbrockFunction f;
+  const RecordingExecutor& executor;
+  std::vector<int> owners;
+  size_t violations;
+};
+
+/**
+ * With NUMA locality, each thread must keep to its own batches over all the
+ * passes, even though they are shuffled; otherwise the batches move between
+ * the threads.
+ */
+TEST_CASE("ParallelSGDNUMALocalityTest", "[ParallelSGDTest]")
+{
+  // 39 functions; one iteration is 4 shares of 2 batches.
+  ParallelSGD<ConstantStep, RecordingExecutor> s(200, 2, -1, true,
+      ConstantStep(0.0001), 1, true, false, RecordingExecutor(), true);
+  TaskRecordingFunction f(40, s.Executor());
+
+  arma::mat coordinates = f.f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+
+  REQUIRE(f.violations == 0);
+  for (size_t i = 0; i < f.owners.size(); ++i)
+    REQUIRE(f.owners[i] != -1);
+
+  s.NUMALocality() = false;
+  TaskRecordingFunction g(40, s.Executor());
+  coordinates = g.f.GetInitialPoint();
+  s.Optimize(g, coordinates);
+
+  REQUIRE(g.violations > 0);
+}
+
+/**
+ * The lazy weight decay of parallel SGD should give the same iterates as that
+ * of SGD; see LazyWeightDecaySparseSGDTest.
+ */
+TEST_CASE("ParallelSGDWeightDecayTest", "[ParallelSGDTest]")
+{
+  SparseTestFunction f;
+
+  const double stepSize = 0.1;
+  const double lambda = 0.1;
+  ParallelSGD<ConstantStep, SerialExecutor> s(1000, 4, 1e-15, false,
+      ConstantStep(stepSize), 1, true, false, SerialExecutor(), false, lambda);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+
+  const double d = 1.0 - stepSize * lambda;
+  const arma::vec b("-4 -2 -3 -8");
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const double fixedPoint = -stepSize * b[i] /
+        (1.0 - std::pow(d, 4.0) + 2.0 * stepSize);
+    REQUIRE(coordinates[i] ==
+        Approx(std::pow(d, 3.0 - i) * fixedPoint).epsilon(1e-6));
+  }
+}
+
+/**
+ * The sparse and dense gradients of the matrix factorization should agree with
+ * each other and with its objective, and parallel SGD should fit a low-rank
+ * matrix.
+ */
+TEST_CASE("ParallelSGDMatrixFactorizationTest", "[ParallelSGDTest]")
+{
+  arma::arma_rng::set_seed(7);
+  const arma::mat w = arma::randn<arma::mat>(2, 30) / std::sqrt(2.0);
+  const arma::mat h = arma::randn<arma::mat>(2, 20);
+  arma::sp_mat observations(w.t() * h);
+  MatrixFactorizationFunction f(observations, 2, 0.01);
+  REQUIRE(f.NumFunctions() == 600);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::sp_mat sparseGradient;
+  arma::mat denseGradient;
+  f.Gradient(coordinates, 10, sparseGradient, 5);
+  f.Gradient(coordinates, 10, denseGradient, 5);
+  REQUIRE(arma::norm(arma::mat(sparseGradient) - denseGradient, "inf") <
+      1e-12);
+
+  const double epsilon = 1e-6;
+  for (size_t k = 0; k < coordinates.n_elem; ++k)
+  {
+    arma::mat shifted = coordinates;
+    shifted[k] += epsilon;
+    const double plus = f.Evaluate(shifted, 10, 5);
+    shifted[k] -= 2 * epsilon;
+    const double minus = f.Evaluate(shifted, 10, 5);
+    REQUIRE((plus - minus) / (2 * epsilon) ==
+        Approx(denseGradient[k]).margin(1e-6));
+  }
+
+  const double initialObjective = f.Evaluate(coordinates);
+  ParallelSGD<ConstantStep> s(1000, 0, 1e-10, true, ConstantStep(0.02));
+  const double objective = s.Optimize(f, coordinates);
+  REQUIRE(objective < 0.01 * initialObjective);
+}
+
+/**
+ * Check the generated ratings and the gradients of single observations, which
+ * are built directly in compressed sparse column form.
+ */
+TEST_CASE("ParallelSGDMatrixFactorizationDataTest", "[ParallelSGDTest]")
+{
+  arma::umat locations, otherLocations;
+  arma::vec values, otherValues;
+  arma::mat parameters, otherParameters;
+  MatrixFactorizationData(40, 25, 10, 3, locations, values, parameters, 2.0,
+      0.0, 5);
+  MatrixFactorizationData(40, 25, 10, 3, otherLocations, otherValues,
+      otherParameters, 2.0, 0.0, 5);
+  REQUIRE(locations.n_cols == 400);
+  REQUIRE(arma::all(arma::vectorise(locations == otherLocations)));
+  REQUIRE(arma::approx_equal(values, otherValues, "absdiff", 0.0));
+  REQUIRE(locations.row(0).max() == 39);
+  REQUIRE(locations.row(1).max() < 25);
+
+  MatrixFactorizationFunction f(locations, values, 40, 25, 3, 0.1);
+  f.Lambda() = 0.0;
+  REQUIRE(f.Evaluate(parameters) == Approx(0.0).margin(1e-20));
+  f.Lambda() = 0.1;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  for (size_t i = 0; i < f.NumFunctions(); i += 37)
+  {
+    arma::sp_mat sparseGradient;
+    arma::mat denseGradient;
+    const double objective = f.EvaluateWithGradient(coordinates, i,
+        sparseGradient);
+    REQUIRE(f.EvaluateWithGradient(coordinates, i, denseGradient) ==
+        Approx(objective));
+    REQUIRE(f.Evaluate(coordinates, i) == Approx(objective));
+    REQUIRE(sparseGradient.n_nonzero == 6);
+    REQUIRE(arma::norm(arma::mat(sparseGradient) - denseGradient, "inf") <
+        1e-12);
+  }
+}
+
+/**
+ * A separable least squares function over 2^30 coordinates, of which each
+ * function only touches one: f_i(x) = (x_{k_i} - t_i)^2.
+ */
+class HashedLeastSquaresFunction
+{
+ public:
+  HashedLeastSquaresFunction() : targets("1 -2 3 -4 5 -6 7 -8 9 -10")
+  {
+    for (size_t i = 0; i < NumFunctions(); ++i)
+      indices.push_back((i * 1000000007ULL) % Dimensions());
+  }
+
+  size_t Dimensions() const { return size_t(1) << 30; }
+
+  size_t NumFunctions() const { return 10; }
+
+  double Evaluate(const HashedParameters<>& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    double objective = 0.0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += std::pow(coordinates[indices[i]] - targets[i], 2.0);
+    return objective;
+  }
+
+  double Evaluate(const HashedParameters<>& coordinates) const
+  {
+    return Evaluate(coordinates, 0, NumFunctions());
+  }
+
+  void Gradient(const HashedParameters<>& coordinates,
+                const size_t begin,
+                arma::sp_mat& gradient,
+                const size_t batchSize) const
+  {
+    gradient.zeros(Dimensions(), 1);
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      gradient(indices[i], 0) += 2.0 * (coordinates[indices[i]] - targets[i]);
+  }
+
+  const std::vector<size_t>& Indices() const { return indices; }
+  const arma::vec& Targets() const { return targets; }
+
+ private:
+  std::vector<size_t> indices;
+  arma::vec targets;
+};
+
+/**
+ * Parallel SGD should optimize a hashed iterate directly, only storing the
+ * coordinates that the gradients touch.
+ */
+TEST_CASE("ParallelSGDHashedParametersTest", "[ParallelSGDTest]")
+{
+  HashedLeastSquaresFunction f;
+  HashedParameters<> iterate(f.Dimensions(), 1, 100);
+
+  ParallelSGD<ConstantStep, SerialExecutor> s(1000, 0, 1e-15, true,
+      ConstantStep(0.2));
+  s.Optimize(f, iterate);
+
+  REQUIRE(iterate.Size() == 10);
+  for (size_t i = 0; i < f.NumFunctions(); ++i)
+    REQUIRE(iterate[f.Indices()[i]] == Approx(f.Targets()[i]).epsilon(1e-5));
+
+  const arma::sp_mat model = iterate.ToSparse();
+  REQUIRE(model.n_rows == f.Dimensions());
+  REQUIRE(model.n_nonzero == 10);
+  REQUIRE(model(f.Indices()[3], 0) == Approx(-4.0).epsilon(1e-5));
+
+  // Adaptive update policies keep dense state, so they are rejected.
+  ParallelSGD<ConstantStep, SerialExecutor, SparseAdaGradUpdate> adaGrad(10,
+      0);
+  REQUIRE_THROWS_AS(adaGrad.Optimize(f, iterate), std::invalid_argument);
+
+  // Writing more coordinates than the capacity fails.
+  HashedParameters<> small(10, 1, 2);
+  small[1] = 1.0;
+  small(2, 0) = 2.0;
+  REQUIRE_THROWS_AS(small[3] = 3.0, std::runtime_error);
+  REQUIRE(static_cast<const HashedParameters<>&>(small)[4] == 0.0);
+}
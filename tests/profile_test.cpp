@@ -0,0 +1,135 @@
+/**
+ * @file profile_test.cpp
+ * @author Ryan Curtin
+ *
+ * Test the profiling reports of the optimizers.  The reports are only filled
+ * if ENS_PROFILE is defined (configure with -DUSE_PROFILE=ON).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A function with only Evaluate() and Gradient() that counts its own calls.
+ */
+class CountingQuadraticFunction
+{
+ public:
+  CountingQuadraticFunction() : evaluations(0), gradients(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates - 1.0));
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    ++gradients;
+    gradient = 2 * (coordinates - 1.0);
+  }
+
+  size_t evaluations;
+  size_t gradients;
+};
+
+/**
+ * The report of L-BFGS should match the calls made to the function.  Since the
+ * function has no EvaluateWithGradient(), each call of the one provided by the
+ * Function<> wrapper is counted as one Evaluate() and one Gradient().
+ */
+TEST_CASE("LBFGSProfileTest", "[ProfileTest]")
+{
+  CountingQuadraticFunction f;
+  L_BFGS lbfgs;
+
+  arma::mat coordinates = arma::zeros<arma::mat>(5, 1);
+  lbfgs.Optimize(f, coordinates);
+
+  const ProfileReport& report = lbfgs.Profile();
+  #ifdef ENS_PROFILE
+    REQUIRE(report.Evaluations() == f.evaluations);
+    REQUIRE(report.Gradients() == f.gradients);
+    REQUIRE(report.EvaluationsWithGradient() == 0);
+    REQUIRE(report.TotalTime() >= report.FunctionTime());
+    REQUIRE(report.FunctionTime() >= 0.0);
+  #else
+    REQUIRE(report.Evaluations() == 0);
+    REQUIRE(report.Gradients() == 0);
+    REQUIRE(report.TotalTime() == 0.0);
+  #endif
+}
+
+/**
+ * The report of an SGD-based optimizer should count one call for each batch,
+ * and be reset by the next optimization.
+ */
+TEST_CASE("SGDProfileTest", "[ProfileTest]")
+{
+  SGDTestFunction f;
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 300, -1, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  adam.Optimize(f, coordinates);
+
+  #ifdef ENS_PROFILE
+    // SGDTestFunction has Evaluate() and Gradient(), so the wrapper counts
+    // both for each of the 300 batches, and the final objective takes another
+    // three calls to Evaluate().
+    REQUIRE(adam.Profile().Evaluations() == 303);
+    REQUIRE(adam.Profile().Gradients() == 300);
+
+    coordinates = f.GetInitialPoint();
+    adam.MaxIterations() = 30;
+    adam.Optimize(f, coordinates);
+
+    REQUIRE(adam.Profile().Evaluations() == 33);
+    REQUIRE(adam.Profile().Gradients() == 30);
+  #else
+    REQUIRE(adam.Profile().Evaluations() == 0);
+  #endif
+}
+
+/**
+ * The trace should hold the zones of the phases of L-BFGS, and be empty if
+ * tracing is not enabled.
+ */
+TEST_CASE("LBFGSTraceTest", "[ProfileTest]")
+{
+  CountingQuadraticFunction f;
+  L_BFGS lbfgs;
+
+  ClearTrace();
+  arma::mat coordinates = arma::zeros<arma::mat>(5, 1);
+  lbfgs.Optimize(f, coordinates);
+
+  std::ostringstream output;
+  WriteTrace(output);
+  const std::string trace = output.str();
+  REQUIRE(trace.find("{\"traceEvents\": [") == 0);
+
+  #ifdef ENS_TRACE
+    // One zone for the optimization, and one for each call to the function,
+    // search direction and line search.
+    REQUIRE(TraceSize() > f.evaluations + f.gradients + 1);
+    REQUIRE(trace.find("\"name\": \"Optimize\"") != std::string::npos);
+    REQUIRE(trace.find("\"name\": \"Evaluate\"") != std::string::npos);
+    REQUIRE(trace.find("\"name\": \"SearchDirection\"") != std::string::npos);
+    REQUIRE(trace.find("\"name\": \"LineSearch\"") != std::string::npos);
+    REQUIRE(trace.find("\"ph\": \"X\"") != std::string::npos);
+
+    ClearTrace();
+    REQUIRE(TraceSize() == 0);
+  #else
+    REQUIRE(TraceSize() == 0);
+    REQUIRE(trace == "{\"traceEvents\": []}\n");
+  #endif
+}
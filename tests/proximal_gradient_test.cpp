@@ -0,0 +1,199 @@
+/**
+ * @file proximal_gradient_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the proximal gradient optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The least squares objective 0.5 ||A x - b||^2.
+ */
+class LeastSquaresFunction
+{
+ public:
+  LeastSquaresFunction(const arma::mat& a, const arma::vec& b) : a(a), b(b) { }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& g)
+  {
+    const arma::vec r = a * x - b;
+    g = a.t() * r;
+    return 0.5 * arma::dot(r, r);
+  }
+
+ private:
+  arma::mat a;
+  arma::vec b;
+};
+
+/**
+ * The squared distance to a point, ||x - c||^2.
+ */
+class DistanceFunction
+{
+ public:
+  DistanceFunction(const arma::vec& c) : c(c) { }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& g)
+  {
+    g = 2 * (x - c);
+    return arma::accu(arma::square(x - c));
+  }
+
+ private:
+  arma::vec c;
+};
+
+/**
+ * Count the steps taken by an optimizer.
+ */
+class StepCounter
+{
+ public:
+  StepCounter() : steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType&, FunctionType&, const MatType&) { ++steps; }
+
+  size_t steps;
+};
+
+/**
+ * Solve a lasso problem, and check the optimality conditions: the gradient of
+ * the least squares term is -lambda sign(x_i) on the non-zero coordinates, and
+ * at most lambda in magnitude on the others.
+ */
+void CheckLasso(ProximalGradient<L1Penalty>& optimizer, size_t& iterations)
+{
+  arma::arma_rng::set_seed(42);
+  const arma::mat a = arma::randn<arma::mat>(50, 20);
+  arma::vec truth(20, arma::fill::zeros);
+  truth.subvec(0, 4) = arma::linspace<arma::vec>(1, 5, 5);
+  const arma::vec b = a * truth + 0.1 * arma::randn<arma::vec>(50);
+
+  LeastSquaresFunction f(a, b);
+  const double lambda = optimizer.Proximal().Lambda();
+
+  StepCounter counter;
+  arma::mat coordinates(20, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates, counter);
+  iterations = counter.steps;
+
+  const arma::vec g = a.t() * (a * coordinates - b);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    if (coordinates[i] != 0.0)
+    {
+      REQUIRE(g[i] == Approx(coordinates[i] > 0.0 ? -lambda : lambda).margin(
+          1e-5));
+    }
+    else
+    {
+      REQUIRE(std::abs(g[i]) <= lambda + 1e-5);
+    }
+  }
+
+  // The penalty sets the irrelevant coordinates exactly to zero.
+  REQUIRE(arma::accu(coordinates != 0.0) <= 10);
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(coordinates[i] == Approx(truth[i]).margin(0.5));
+}
+
+TEST_CASE("ProximalGradientLassoTest", "[ProximalGradientTest]")
+{
+  ProximalGradient<L1Penalty> fista(1.0, 10000, 1e-10, true, true, 0.5,
+      L1Penalty(5.0));
+  size_t fistaIterations = 0;
+  CheckLasso(fista, fistaIterations);
+
+  ProximalGradient<L1Penalty> ista(1.0, 10000, 1e-10, false, true, 0.5,
+      L1Penalty(5.0));
+  size_t istaIterations = 0;
+  CheckLasso(ista, istaIterations);
+
+  // The acceleration saves iterations.
+  REQUIRE(fistaIterations > 0);
+  REQUIRE(fistaIterations <= istaIterations);
+}
+
+TEST_CASE("ProximalGradientFixedStepLassoTest", "[ProximalGradientTest]")
+{
+  // Without backtracking, the step size must be below 1 / L (L being the
+  // largest eigenvalue of A^T A).
+  arma::arma_rng::set_seed(42);
+  const arma::mat a = arma::randn<arma::mat>(50, 20);
+  const double lipschitz = arma::max(arma::eig_sym(a.t() * a));
+
+  ProximalGradient<L1Penalty> optimizer(1.0 / lipschitz, 10000, 1e-10, true,
+      false, 0.5, L1Penalty(5.0));
+  size_t iterations = 0;
+  CheckLasso(optimizer, iterations);
+  REQUIRE(optimizer.FinalStepSize() == Approx(1.0 / lipschitz));
+}
+
+TEST_CASE("ProximalGradientBoxTest", "[ProximalGradientTest]")
+{
+  // The minimum of ||x - c||^2 in the box is the clamped c.
+  const arma::vec c("-2.0 0.5 3.0 0.25 -0.1 1.5");
+  DistanceFunction f(c);
+
+  ProximalGradient<BoxConstraint> optimizer(1.0, 1000, 1e-12, true, true, 0.5,
+      BoxConstraint(0.0, 1.0));
+  arma::mat coordinates(6, 1, arma::fill::zeros);
+  const double objective = optimizer.Optimize(f, coordinates);
+
+  const arma::vec expected = arma::clamp(c, 0.0, 1.0);
+  for (size_t i = 0; i < 6; ++i)
+    REQUIRE(coordinates[i] == Approx(expected[i]).margin(1e-8));
+  REQUIRE(objective == Approx(arma::accu(arma::square(expected - c))));
+}
+
+TEST_CASE("ProximalGradientL1BallTest", "[ProximalGradientTest]")
+{
+  // The minimum of ||x - c||^2 in the ball is the projection of c.
+  const arma::vec c("3.0 -1.0 0.5 2.0 -0.2");
+  DistanceFunction f(c);
+
+  ProximalGradient<L1BallConstraint> optimizer(1.0, 1000, 1e-12, true, true,
+      0.5, L1BallConstraint(2.0));
+  arma::mat coordinates(5, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  arma::vec expected = c;
+  Proximal::ProjectToL1Ball(expected, 2.0);
+  REQUIRE(arma::accu(arma::abs(coordinates)) <= 2.0 + 1e-8);
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(coordinates[i] == Approx(expected[i]).margin(1e-6));
+}
+
+TEST_CASE("ProximalGradientGroupLassoTest", "[ProximalGradientTest]")
+{
+  // With ||x - c||^2, the proximal step at the half step is the solution: each
+  // group of two shrinks by lambda / 2 in norm, and the small groups vanish.
+  const arma::vec c("3.0 4.0 0.1 -0.1 0.0 2.0");
+  DistanceFunction f(c);
+
+  ProximalGradient<GroupLassoPenalty> optimizer(0.5, 1000, 1e-12, true, true,
+      0.5, GroupLassoPenalty(2.0, 2));
+  arma::mat coordinates(6, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates);
+
+  // The first group has norm 5 and shrinks to norm 4; the second vanishes; the
+  // last has norm 2 and shrinks to norm 1.
+  REQUIRE(coordinates[0] == Approx(2.4).margin(1e-6));
+  REQUIRE(coordinates[1] == Approx(3.2).margin(1e-6));
+  REQUIRE(coordinates[2] == 0.0);
+  REQUIRE(coordinates[3] == 0.0);
+  REQUIRE(coordinates[4] == Approx(0.0).margin(1e-6));
+  REQUIRE(coordinates[5] == Approx(1.0).margin(1e-6));
+}
@@ -53,6 +53,42 @@ TEST_CASE("ProjectToL1","[ProximalTest]")
   }
 }
 
+/**
+ * Compare the projection onto the l1 ball with the sort-based solution, and
+ * project every column of a matrix at once.
+ */
+TEST_CASE("ProjectToL1Threshold","[ProximalTest]")
+{
+  const size_t D = 1000;
+  const double tau = 2.0;
+
+  mat m = randn<mat>(D, 8);
+  mat projected = m;
+  Proximal::ProjectColumnsToL1Ball(projected, tau);
+
+  for (size_t i = 0; i < m.n_cols; ++i)
+  {
+    // Sort-based threshold of the projection of |v| onto the simplex.
+    const vec u = sort(abs(m.col(i)), "descend");
+    const vec sums = cumsum(u);
+    double theta = 0.0;
+    for (size_t j = 0; j < D; ++j)
+    {
+      if (u(j) - (sums(j) - tau) / (j + 1) > 0.0)
+        theta = (sums(j) - tau) / (j + 1);
+    }
+    const vec expected = sign(m.col(i)) % clamp(abs(m.col(i)) - theta, 0.0,
+        datum::inf);
+
+    vec v = m.col(i);
+    Proximal::ProjectToL1Ball(v, tau);
+
+    REQUIRE(norm(v, 1) == Approx(tau).epsilon(1e-8));
+    REQUIRE(norm(v - expected, "inf") == Approx(0.0).margin(1e-10));
+    REQUIRE(norm(projected.col(i) - v, "inf") == Approx(0.0).margin(1e-12));
+  }
+}
+
 /**
  * Approximate a vector with a tau-sparse vector.
  */
@@ -82,3 +118,35 @@ TEST_CASE("ProjectToL0","[ProximalTest]")
     REQUIRE(distanceNew >= distance);
   }
 }
+
+/**
+ * The tau-sparse approximation keeps the tau entries of largest magnitude, and
+ * its support gives the same sparse vector.
+ */
+TEST_CASE("ProjectToL0Support","[ProximalTest]")
+{
+  const size_t D = 1000;
+  const int tau = 37;
+
+  const vec v = randn<vec>(D);
+  vec v0 = v;
+  uvec support;
+  Proximal::ProjectToL0Ball(v0, tau, support);
+
+  REQUIRE(support.n_elem == (size_t) tau);
+  REQUIRE(all(support == find(v0)));
+
+  // The same entries as with a full sort.
+  const uvec order = sort_index(abs(v), "descend");
+  const uvec expected = sort(order.head(tau));
+  REQUIRE(all(support == expected));
+
+  const umat locations = join_cols(support.t(), zeros<urowvec>(tau));
+  const sp_mat sparse(locations, v0.elem(support), D, 1);
+  REQUIRE(norm(vec(sparse) - v0, "inf") == Approx(0.0).margin(1e-15));
+
+  // Vectors that are already sparse enough are unchanged.
+  vec v1 = v0;
+  Proximal::ProjectToL0Ball(v1, 2 * tau);
+  REQUIRE(all(v1 == v0));
+}
@@ -0,0 +1,187 @@
+/**
+ * @file random_test.cpp
+ * @author Marcus Edel
+ *
+ * Test the random number generator of the optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Make sure that the generator gives the known answer of Philox4x32-10 for a
+ * zero counter and key.
+ */
+TEST_CASE("PhiloxKnownAnswerTest", "[RandomTest]")
+{
+  RandomGenerator generator(0, 0);
+  REQUIRE(generator() == 0x6627e8d5u);
+  REQUIRE(generator() == 0xe169c58du);
+  REQUIRE(generator() == 0xbc57ac4cu);
+  REQUIRE(generator() == 0x9b00dbd8u);
+}
+
+/**
+ * Make sure that a stream only depends on its seed and id.
+ */
+TEST_CASE("RandomStreamsTest", "[RandomTest]")
+{
+  RandomGenerator a(42, 3), b(42, 3), c(42, 4), d(43, 3);
+  arma::vec x(100), y(100), z(100), w(100);
+  a.Randu(x);
+  b.Randu(y);
+  c.Randu(z);
+  d.Randu(w);
+
+  REQUIRE(arma::approx_equal(x, y, "absdiff", 0.0));
+  REQUIRE(arma::accu(x == z) == 0);
+  REQUIRE(arma::accu(x == w) == 0);
+
+  // Restarting the stream gives the same numbers again.
+  a.Seed(42, 3);
+  a.Randu(y);
+  REQUIRE(arma::approx_equal(x, y, "absdiff", 0.0));
+}
+
+/**
+ * Check the distributions of the uniform, normal and integer numbers, and that
+ * a shuffle is a permutation.
+ */
+TEST_CASE("RandomDistributionsTest", "[RandomTest]")
+{
+  RandomGenerator generator(7);
+
+  arma::vec u(100000), n(100000);
+  generator.Randu(u);
+  generator.Randn(n);
+  REQUIRE(u.min() >= 0.0);
+  REQUIRE(u.max() < 1.0);
+  REQUIRE(arma::mean(u) == Approx(0.5).margin(0.01));
+  REQUIRE(arma::mean(n) == Approx(0.0).margin(0.02));
+  REQUIRE(arma::var(n) == Approx(1.0).margin(0.02));
+
+  arma::uvec counts(7, arma::fill::zeros);
+  for (size_t i = 0; i < 70000; ++i)
+    ++counts[generator.Integer(7)];
+  for (size_t k = 0; k < 7; ++k)
+    REQUIRE(counts[k] == Approx(10000).epsilon(0.05));
+
+  arma::uvec order = arma::linspace<arma::uvec>(0, 99, 100);
+  generator.Shuffle(order);
+  REQUIRE(arma::accu(order != arma::linspace<arma::uvec>(0, 99, 100)) > 0);
+  REQUIRE(arma::all(arma::sort(order) == arma::linspace<arma::uvec>(0, 99,
+      100)));
+}
+
+/**
+ * Make sure that RandomSeed() makes the parallel optimizers reproducible, and
+ * that RandomScope installs a generator on the calling thread.
+ */
+TEST_CASE("RandomSeedReproducibilityTest", "[RandomTest]")
+{
+  RastriginFunction f(2);
+  arma::mat coordinates1 = f.GetInitialPoint();
+  arma::mat coordinates2 = f.GetInitialPoint();
+
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 20000, 100, 50, 1000, 1e-12, 2, 2.0, 0.5, 0.1, 4, 100,
+      4.0);
+  RandomSeed(42);
+  sa.Optimize(f, coordinates1);
+  RandomSeed(42);
+  sa.Optimize(f, coordinates2);
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+
+  RosenbrockFunction g;
+  CNE cne(50, 50, 0.2, 0.2, 0.3, 1e-5, -1, true);
+  coordinates1 = g.GetInitialPoint();
+  coordinates2 = g.GetInitialPoint();
+  RandomSeed(7);
+  cne.Optimize(g, coordinates1);
+  RandomSeed(7);
+  cne.Optimize(g, coordinates2);
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+
+  // The other tests seed Armadillo's generator.
+  ResetRandomSeed();
+
+  RandomGenerator generator(1, 2);
+  {
+    RandomScope scope(generator);
+    REQUIRE(&Random() == &generator);
+  }
+  REQUIRE(&Random() != &generator);
+}
+
+/**
+ * Make sure that PairwiseReduce() adds the chunks in a fixed tree, and that in
+ * the deterministic mode the parallel sums do not depend on the number of
+ * threads.
+ */
+TEST_CASE("DeterministicModeTest", "[RandomTest]")
+{
+  std::vector<std::pair<size_t, size_t>> additions;
+  PairwiseReduce(5, [&](const size_t target, const size_t source)
+  {
+    additions.push_back(std::make_pair(target, source));
+  });
+  REQUIRE(additions.size() == 4);
+  REQUIRE(additions[0] == std::make_pair((size_t) 0, (size_t) 1));
+  REQUIRE(additions[1] == std::make_pair((size_t) 2, (size_t) 3));
+  REQUIRE(additions[2] == std::make_pair((size_t) 0, (size_t) 2));
+  REQUIRE(additions[3] == std::make_pair((size_t) 0, (size_t) 4));
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SetDeterministic(true);
+  REQUIRE(ParallelChunks(1, 1000) == ENS_DETERMINISTIC_CHUNKS);
+  REQUIRE(ParallelChunks(64, 3) == 3);
+
+  // The sub-batches of SGD on one and on four threads.
+  SGD<VanillaUpdate, NoDecay, ThreadPoolExecutor> s1(0.01, 256, 5000, 1e-15,
+      false, VanillaUpdate(), NoDecay(), true, true, ThreadPoolExecutor(1));
+  SGD<VanillaUpdate, NoDecay, ThreadPoolExecutor> s2(0.01, 256, 5000, 1e-15,
+      false, VanillaUpdate(), NoDecay(), true, true, ThreadPoolExecutor(4));
+
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  arma::mat coordinates2 = coordinates1;
+  const double result1 = s1.Optimize(lr, coordinates1);
+  const double result2 = s2.Optimize(lr, coordinates2);
+
+  REQUIRE(result1 == result2);
+  REQUIRE(arma::approx_equal(coordinates1, coordinates2, "absdiff", 0.0));
+
+  // The full gradient, with as many threads as OpenMP gives and with one.
+  Function<LogisticRegression<>>& f =
+      static_cast<Function<LogisticRegression<>>&>(lr);
+  arma::mat gradient, fullGradient1, fullGradient2;
+  const double objective1 = FullEvaluateWithGradient(f, coordinates1, 7,
+      fullGradient1, gradient, true);
+  #ifdef ENS_USE_OPENMP
+    const int maxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+  #endif
+  const double objective2 = FullEvaluateWithGradient(f, coordinates1, 7,
+      fullGradient2, gradient, true);
+  #ifdef ENS_USE_OPENMP
+    omp_set_num_threads(maxThreads);
+  #endif
+
+  REQUIRE(objective1 == objective2);
+  REQUIRE(arma::approx_equal(fullGradient1, fullGradient2, "absdiff", 0.0));
+
+  SetDeterministic(false);
+}
@@ -16,6 +16,67 @@
 using namespace ens;
 using namespace ens::test;
 
+// The function f(x) = sum_i (x_i - i)^2, which can also compute the change of
+// its objective when a single coordinate moves.  The calls to Evaluate() and
+// EvaluateDelta() are counted.
+class DeltaQuadraticFunction
+{
+ public:
+  DeltaQuadraticFunction() : evaluations(0), deltaEvaluations(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    double objective = 0.0;
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+      objective += std::pow(coordinates[i] - i, 2.0);
+    return objective;
+  }
+
+  double EvaluateDelta(const arma::mat& coordinates,
+                       const size_t index,
+                       const double value)
+  {
+    ++deltaEvaluations;
+    return std::pow(value - index, 2.0) -
+        std::pow(coordinates[index] - index, 2.0);
+  }
+
+  size_t evaluations;
+  size_t deltaEvaluations;
+};
+
+// The function f(x) = sum_i (x_i - i)^2, which can also evaluate several
+// candidates at once.  The calls to Evaluate() and EvaluateBatch() are counted.
+class BatchQuadraticFunction
+{
+ public:
+  BatchQuadraticFunction() : evaluations(0), batchEvaluations(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    double objective = 0.0;
+    for (size_t i = 0; i < coordinates.n_elem; ++i)
+      objective += std::pow(coordinates[i] - i, 2.0);
+    return objective;
+  }
+
+  void EvaluateBatch(const arma::cube& candidates, arma::vec& objectives)
+  {
+    ++batchEvaluations;
+    for (size_t c = 0; c < candidates.n_slices; ++c)
+    {
+      objectives[c] = 0.0;
+      for (size_t i = 0; i < candidates.n_rows * candidates.n_cols; ++i)
+        objectives[c] += std::pow(candidates.slice(c)[i] - i, 2.0);
+    }
+  }
+
+  size_t evaluations;
+  size_t batchEvaluations;
+};
+
 // The Generalized-Rosenbrock function is a simple function to optimize.
 TEST_CASE("SAGeneralizedRosenbrockTest","[SATest]")
 {
@@ -93,3 +154,96 @@ TEST_CASE("RastrigrinFunctionTest","[SATest]")
 
   REQUIRE(successes >= 1);
 }
+
+/**
+ * Make sure that SA evaluates single-coordinate moves with EvaluateDelta() when
+ * the function has it.
+ */
+TEST_CASE("SAEvaluateDeltaTest", "[SATest]")
+{
+  REQUIRE(traits::HasDeltaEvaluation<DeltaQuadraticFunction>::value);
+  REQUIRE(!traits::HasDeltaEvaluation<RosenbrockFunction>::value);
+
+  DeltaQuadraticFunction f;
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 1000000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5, 0.3);
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+
+  const double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx((double) i).margin(1e-2));
+
+  // The whole objective is only evaluated at the start and once every
+  // moveCtrlSweep sweeps.
+  REQUIRE(f.deltaEvaluations > 0);
+  REQUIRE(f.evaluations <= 1 + f.deltaEvaluations / (100 * 10));
+  REQUIRE(result == Approx(f.Evaluate(coordinates)).margin(1e-8));
+}
+
+/**
+ * Run SA with several chains at different temperatures on the Rastrigin
+ * function, and make sure that the chains escape from the local minima.
+ */
+TEST_CASE("SAParallelTemperingRastriginTest", "[SATest]")
+{
+  size_t successes = 0;
+
+  for (size_t trial = 0; trial < 4; ++trial)
+  {
+    RastriginFunction f(2);
+    ExponentialSchedule schedule;
+    SA<> sa(schedule, 2000000, 100, 50, 1000, 1e-12, 2, 2.0, 0.5, 0.1, 4, 100,
+        4.0);
+    arma::mat coordinates = f.GetInitialPoint();
+
+    const double result = sa.Optimize(f, coordinates);
+
+    if ((std::abs(result) < 1e-3) &&
+        (std::abs(coordinates[0]) < 1e-3) &&
+        (std::abs(coordinates[1]) < 1e-3))
+    {
+      ++successes;
+      break; // No need to continue.
+    }
+  }
+
+  REQUIRE(successes >= 1);
+}
+
+/**
+ * Run SA with block moves, both with joint moves of the blocks and with the
+ * proposals of each block evaluated in one batch.
+ */
+TEST_CASE("SABlockMoveTest", "[SATest]")
+{
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 1000000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5, 0.3, 1, 100,
+      2.0, 5);
+
+  // Joint moves of the blocks, with one Evaluate() call per block.
+  DeltaQuadraticFunction f;
+  arma::mat coordinates(10, 1, arma::fill::zeros);
+  double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx((double) i).margin(1e-2));
+  REQUIRE(f.deltaEvaluations == 0);
+
+  // Independent proposals, with one EvaluateBatch() call per block.
+  BatchQuadraticFunction g;
+  sa.Temperature() = 1000.;
+  coordinates.zeros();
+  result = sa.Optimize(g, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-5));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx((double) i).margin(1e-2));
+  REQUIRE(g.batchEvaluations > 0);
+  REQUIRE(g.evaluations == 1);
+
+  sa.BlockSize() = 0;
+  REQUIRE_THROWS_AS(sa.Optimize(g, coordinates), std::invalid_argument);
+}
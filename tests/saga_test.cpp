@@ -0,0 +1,136 @@
+/**
+ * @file saga_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for the SAGA and SAG optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+// Logistic regression without the linear model methods, so that SAGA stores a
+// whole gradient for each batch.
+class DenseLogisticRegression
+{
+ public:
+  DenseLogisticRegression(LogisticRegression<>& lr) : lr(lr) { }
+
+  void Shuffle() { lr.Shuffle(); }
+
+  size_t NumFunctions() const { return lr.NumFunctions(); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return lr.Evaluate(coordinates, begin, batchSize);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    lr.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+ private:
+  LogisticRegression<>& lr;
+};
+
+/**
+ * Run SAGA on logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("SAGALogisticRegressionTest", "[SAGATest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 1; batchSize <= 32; batchSize += 31)
+  {
+    SAGA optimizer(0.005, batchSize, 50000, 1e-5, true);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    optimizer.Optimize(lr, coordinates);
+
+    // Ensure that the error is close to zero.
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+  }
+}
+
+/**
+ * Run SAG on logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("SAGLogisticRegressionTest", "[SAGATest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SAG optimizer(0.005, 32, 50000, 1e-5, true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Make sure that storing one coefficient per point for a linear model gives
+ * the same steps as storing the whole gradients.
+ */
+TEST_CASE("SAGALinearModelTableTest", "[SAGATest]")
+{
+  REQUIRE(traits::HasLinearModelGradient<LogisticRegression<>>::value);
+  REQUIRE(!traits::HasLinearModelGradient<DenseLogisticRegression>::value);
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  // Without regularization the gradient of each point is only its linear
+  // term, which both tables store exactly.
+  LogisticRegression<> lr(shuffledData, shuffledResponses);
+  DenseLogisticRegression dense(lr);
+
+  // The batches are visited in linear order, so both runs take the same steps.
+  SAGA optimizer(0.005, 10, 3000, 1e-5, false);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  arma::mat denseCoordinates = lr.GetInitialPoint();
+  optimizer.Optimize(dense, denseCoordinates);
+
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx(denseCoordinates[i]).epsilon(1e-7));
+}
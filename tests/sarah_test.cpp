@@ -77,3 +77,62 @@ TEST_CASE("SAHRAPlusLogisticRegressionTest","[SARAHTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
   }
 }
+
+/**
+ * Make sure that the fused SARAH step matches its definition, and that the
+ * SARAH+ test uses the norm of the updated estimator.
+ */
+TEST_CASE("SARAHStepTest","[SARAHTest]")
+{
+  const arma::mat gradient = arma::randu<arma::mat>(5, 4);
+  const arma::mat gradient0 = arma::randu<arma::mat>(5, 4);
+  arma::mat v = arma::randu<arma::mat>(5, 4);
+  arma::mat iterate = arma::randu<arma::mat>(5, 4);
+
+  const arma::mat expectedV = v + (gradient - gradient0) / 3.0;
+  const arma::mat expectedIterate = iterate - 0.1 * expectedV;
+
+  const double squaredNorm = SARAHStep(iterate, v, gradient, gradient0, 3,
+      0.1);
+  REQUIRE(arma::approx_equal(v, expectedV, "absdiff", 1e-12));
+  REQUIRE(arma::approx_equal(iterate, expectedIterate, "absdiff", 1e-12));
+  REQUIRE(squaredNorm == Approx(arma::dot(expectedV, expectedV)));
+
+  // With gamma = 0.5, SARAH+ stops once the norm of v is at most half the
+  // given norm.
+  SARAHPlusUpdate update(0.5);
+  const double vNorm = arma::norm(v + (gradient - gradient0) / 3.0);
+  arma::mat v1 = v, v2 = v;
+  REQUIRE(update.Update(iterate, v1, gradient, gradient0, 3, 0.1,
+      2.0 * vNorm + 1e-6));
+  REQUIRE(!update.Update(iterate, v2, gradient, gradient0, 3, 0.1,
+      2.0 * vNorm - 1e-6));
+}
+
+/**
+ * Run SARAH+ with the gradients of the inner steps computed in parallel on
+ * logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("SAHRAPlusParallelBatchGradientTest","[SARAHTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SARAH_Plus optimizer(0.01, 40, 250, 0, 1e-5, true, SARAHPlusUpdate(), true,
+      true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
@@ -64,6 +64,214 @@ TEST_CASE("DisjointFeatureTest","[SCDTest]")
   REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
 }
 
+/**
+ * Update several coordinates at once on the sparse test function, whose
+ * features are independent, with the random and cyclic descent policies.
+ */
+TEST_CASE("ParallelSCDTest","[SCDTest]")
+{
+  SparseTestFunction f;
+
+  // Updating all four features at once with the cyclic policy is a full
+  // gradient descent step.
+  SCD<CyclicDescent> cyclic(0.4, 100000, 1e-5, 1e3, CyclicDescent(), 4);
+  arma::mat iterate = f.GetInitialPoint();
+  double result = cyclic.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+
+  // One coordinate per thread.
+  SCD<> random(0.4, 100000, 1e-5, 1e3, RandomDescent(), 0);
+  iterate = f.GetInitialPoint();
+  result = random.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Accelerated SCD should find the vertices of the parabolas of the sparse test
+ * function, with the Lipschitz constants of the features estimated exactly.
+ */
+TEST_CASE("AcceleratedSCDDisjointFeatureTest","[SCDTest]")
+{
+  SparseTestFunction f;
+  AcceleratedSCD s(100000, 1e-10);
+
+  arma::mat iterate = f.GetInitialPoint();
+  double result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+
+  // Every feature is a parabola with second derivative 2.
+  REQUIRE(s.CoordinateLipschitz().n_elem == 4);
+  for (size_t j = 0; j < 4; ++j)
+    REQUIRE(s.CoordinateLipschitz()[j] == Approx(2.0).epsilon(1e-6));
+}
+
+/**
+ * Draw several coordinates at once with accelerated SCD, with given Lipschitz
+ * constants.
+ */
+TEST_CASE("ParallelAcceleratedSCDTest","[SCDTest]")
+{
+  SparseTestFunction f;
+
+  AcceleratedSCD s(100000, 1e-10, 1e3, arma::vec("2 2 2 2"), 0.5, 4);
+  arma::mat iterate = f.GetInitialPoint();
+  double result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+
+  // One coordinate per thread.
+  s.Parallelism() = 0;
+  iterate = f.GetInitialPoint();
+  result = s.Optimize(f, iterate);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(iterate[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(iterate[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(iterate[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(iterate[3] == Approx(4.0).epsilon(0.0002));
+
+  // Lipschitz constants of the wrong size are rejected.
+  s.Lipschitz() = arma::vec("2 2 2");
+  REQUIRE_THROWS_AS(s.Optimize(f, iterate), std::invalid_argument);
+}
+
+/**
+ * With a third of the coordinate updates, accelerated SCD should get well below
+ * the objective that SCD reaches on the logistic regression problem of
+ * PreCalcSCDTest.
+ */
+TEST_CASE("AcceleratedSCDLogisticRegressionTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.0001);
+
+  AcceleratedSCD s(20000, 1e-7);
+  arma::mat iterate = f.InitialPoint();
+
+  double objective = s.Optimize(f, iterate);
+
+  REQUIRE(objective <= 0.03);
+}
+
+// Logistic regression which counts the calls to Evaluate().
+class CountingLogisticRegression
+{
+ public:
+  CountingLogisticRegression(LogisticRegressionFunction<arma::mat>& f) :
+      f(f), evaluations(0) { }
+
+  size_t NumFeatures() const { return f.NumFeatures(); }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return f.Evaluate(coordinates);
+  }
+
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::vec& gradient) const
+  {
+    f.PartialGradient(coordinates, j, gradient);
+  }
+
+  double InitializeObjective(const arma::mat& coordinates)
+  {
+    return f.InitializeObjective(coordinates);
+  }
+
+  double UpdateObjective(const arma::mat& coordinates,
+                         const size_t j,
+                         const arma::vec& delta)
+  {
+    return f.UpdateObjective(coordinates, j, delta);
+  }
+
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  LogisticRegressionFunction<arma::mat>& f;
+  size_t evaluations;
+};
+
+/**
+ * Make sure the objective tracked by LogisticRegressionFunction matches
+ * Evaluate(), and that SCD then only evaluates the objective at the end.
+ */
+TEST_CASE("SCDIncrementalObjectiveTest","[SCDTest]")
+{
+  arma::mat predictors("0 0 0.4; 0 0 0.6; 0 0.3 0; 0.2 0 0; 0.2 -0.5 0;");
+  arma::Row<size_t> responses("1  1  0;");
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses, 0.1);
+  REQUIRE(traits::HasIncrementalObjective<
+      LogisticRegressionFunction<arma::mat>>::value);
+
+  arma::mat coordinates(1, f.NumFeatures(), arma::fill::randu);
+  REQUIRE(f.InitializeObjective(coordinates) ==
+      Approx(f.Evaluate(coordinates)).epsilon(1e-10));
+
+  for (size_t i = 0; i < 20; ++i)
+  {
+    const size_t j = i % f.NumFeatures();
+    arma::vec delta(1, arma::fill::randn);
+    coordinates.col(j) += delta;
+
+    REQUIRE(f.UpdateObjective(coordinates, j, delta) ==
+        Approx(f.Evaluate(coordinates)).epsilon(1e-10));
+  }
+
+  // The partial gradients computed with the stored margins match those
+  // computed from scratch.
+  LogisticRegressionFunction<arma::mat> fresh(predictors, responses, 0.1);
+  for (size_t j = 0; j < f.NumFeatures(); ++j)
+  {
+    arma::vec cached, expected;
+    f.PartialGradient(coordinates, j, cached);
+    fresh.PartialGradient(coordinates, j, expected);
+    REQUIRE(cached[0] == Approx(expected[0]).epsilon(1e-10));
+  }
+
+  // Other parameters do not use the stored margins.
+  arma::mat other = coordinates + 1.0;
+  arma::vec cached, expected;
+  f.PartialGradient(other, 1, cached);
+  fresh.PartialGradient(other, 1, expected);
+  REQUIRE(cached[0] == Approx(expected[0]).epsilon(1e-10));
+
+  // SCD checks for convergence with the tracked objective.
+  LogisticRegressionFunction<arma::mat> g(predictors, responses, 0.0001);
+  CountingLogisticRegression counting(g);
+
+  SCD<> s(0.02, 60000, 1e-5);
+  arma::mat iterate = g.InitialPoint();
+  const double objective = s.Optimize(counting, iterate);
+
+  REQUIRE(objective <= 0.055);
+  REQUIRE(counting.Evaluations() <= 1);
+}
+
 /**
  * Test the greedy descent policy.
  */
@@ -86,6 +294,84 @@ TEST_CASE("GreedyDescentTest","[SCDTest]")
   REQUIRE(descentPolicy.DescentFeature(0, point, f) == 1);
 }
 
+// The sparse test function without the AffectedFeatures() method and the
+// dense PartialGradient() overload, so that the incremental greedy policy has
+// to refresh every sparse partial gradient.
+class DenseSparseTestFunction
+{
+ public:
+  size_t NumFeatures() const { return f.NumFeatures(); }
+
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return f.Evaluate(coordinates);
+  }
+
+  void PartialGradient(const arma::mat& coordinates,
+                       const size_t j,
+                       arma::sp_mat& gradient) const
+  {
+    f.PartialGradient(coordinates, j, gradient);
+  }
+
+ private:
+  SparseTestFunction f;
+};
+
+/**
+ * Make sure the incremental greedy descent policy picks the same coordinates
+ * as an exhaustive search of the largest partial gradient, with and without
+ * the AffectedFeatures() method.
+ */
+TEST_CASE("IncrementalGreedyDescentTest","[SCDTest]")
+{
+  REQUIRE(traits::HasFeatureDependencies<SparseTestFunction>::value);
+  REQUIRE(!traits::HasFeatureDependencies<DenseSparseTestFunction>::value);
+  REQUIRE(traits::HasDensePartialGradient<SparseTestFunction>::value);
+  REQUIRE(!traits::HasDensePartialGradient<DenseSparseTestFunction>::value);
+
+  SparseTestFunction f;
+  DenseSparseTestFunction dense;
+
+  IncrementalGreedyDescent policy, densePolicy;
+
+  arma::mat iterate("1 2 3 4;");
+  arma::sp_mat gradient;
+  for (size_t i = 1; i < 50; ++i)
+  {
+    size_t bestFeature = 0;
+    double bestMagnitude = -1.0;
+    for (size_t j = 0; j < f.NumFeatures(); ++j)
+    {
+      f.PartialGradient(iterate, j, gradient);
+      const double magnitude = arma::accu(gradient % gradient);
+      if (magnitude > bestMagnitude)
+      {
+        bestFeature = j;
+        bestMagnitude = magnitude;
+      }
+    }
+
+    const size_t feature = policy.DescentFeature(i, iterate, f);
+    REQUIRE(feature == bestFeature);
+    REQUIRE(densePolicy.DescentFeature(i, iterate, dense) == bestFeature);
+
+    f.PartialGradient(iterate, feature, gradient);
+    iterate.col(feature) -= 0.3 * gradient.col(feature);
+  }
+
+  // A new optimization with the same policy starts from scratch.
+  SCD<IncrementalGreedyDescent> s(0.4, 100000, 1e-5, 1e3, policy);
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
 /**
  * Test the cyclic descent policy.
  */
@@ -159,6 +445,12 @@ TEST_CASE("LogisticRegressionFunctionPartialGradientTest","[SCDTest]")
     f.PartialGradient(testPoint, i, fGrad);
 
     CheckMatrices(testGradient.col(i), arma::mat(fGrad.col(i)));
+
+    // The dense overload gives only the non-zero column.
+    arma::vec denseGrad;
+    f.PartialGradient(testPoint, i, denseGrad);
+
+    CheckMatrices(testGradient.col(i), arma::mat(denseGrad));
   }
 }
 
@@ -177,7 +469,7 @@ TEST_CASE("SoftmaxRegressionFunctionPartialGradientTest","[SCDTest]")
 
   // Create random class labels.
   arma::Row<size_t> labels = arma::randi<arma::Row<size_t> >(
-      points, arma::distr_param(0, numClasses));
+      points, arma::distr_param(0, numClasses - 1));
 
   // 2 objects for 2 terms in the cost function. Each term contributes towards
   // the gradient and thus need to be checked independently.
@@ -200,5 +492,11 @@ TEST_CASE("SoftmaxRegressionFunctionPartialGradientTest","[SCDTest]")
     srf.PartialGradient(parameters, j, fGrad);
 
     CheckMatrices(gradient.col(j), arma::mat(fGrad.col(j)));
+
+    // The dense overload gives only the non-zero column.
+    arma::vec denseGrad;
+    srf.PartialGradient(parameters, j, denseGrad);
+
+    CheckMatrices(gradient.col(j), arma::mat(denseGrad));
   }
 }
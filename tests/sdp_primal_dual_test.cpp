@@ -266,6 +266,85 @@ static void SolveMaxCutPositiveSDP(const SDP<arma::sp_mat>& sdp)
   CheckKKT(sdp, X, ysparse, ydense, Z);
 }
 
+/**
+ * Make sure that applying the operator X sym I without forming it gives the
+ * same result as the explicit operator.
+ */
+TEST_CASE("SymKronIdTimesTest","[SdpPrimalDualTest]")
+{
+  arma::mat A = arma::randu<arma::mat>(6, 6);
+  A = A + A.t();
+  arma::mat B = arma::randu<arma::mat>(6, 6);
+  B = B + B.t();
+
+  arma::mat op;
+  arma::vec b, expected, product;
+  math::SymKronId(A, op);
+  math::Svec(B, b);
+  expected = op * b;
+  math::SymKronIdTimes(A, b, product);
+
+  REQUIRE(product.n_elem == expected.n_elem);
+  for (size_t i = 0; i < product.n_elem; ++i)
+    REQUIRE(product(i) == Approx(expected(i)).margin(1e-10));
+}
+
+/**
+ * Make sure that the batch assembly of the constraint rows matches the Svec of
+ * each constraint.
+ */
+TEST_CASE("SvecRowsTest","[SdpPrimalDualTest]")
+{
+  std::vector<arma::sp_mat> sparse(4);
+  std::vector<arma::mat> dense(3);
+  for (size_t i = 0; i < sparse.size(); ++i)
+  {
+    sparse[i] = arma::sprandu<arma::sp_mat>(7, 7, 0.2);
+    sparse[i] += sparse[i].t();
+  }
+  for (size_t i = 0; i < dense.size(); ++i)
+  {
+    dense[i] = arma::randu<arma::mat>(7, 7);
+    dense[i] += dense[i].t();
+  }
+
+  arma::sp_mat sparseRows;
+  arma::mat denseRows;
+  math::SvecRows(sparse, sparseRows);
+  math::SvecRows(dense, denseRows);
+  REQUIRE(sparseRows.n_rows == sparse.size());
+  REQUIRE(denseRows.n_rows == dense.size());
+
+  arma::sp_vec sparseRow;
+  arma::vec denseRow;
+  for (size_t i = 0; i < sparse.size(); ++i)
+  {
+    math::Svec(sparse[i], sparseRow);
+    REQUIRE(arma::norm(arma::mat(sparseRows.row(i)) -
+        arma::mat(sparseRow.t()), "fro") == Approx(0.0).margin(1e-12));
+  }
+  for (size_t i = 0; i < dense.size(); ++i)
+  {
+    math::Svec(dense[i], denseRow);
+    REQUIRE(arma::norm(denseRows.row(i) - denseRow.t(), "fro") ==
+        Approx(0.0).margin(1e-12));
+  }
+}
+
+/**
+ * Make sure the Lanczos estimate of the largest eigenvalue used for the step
+ * lengths matches a full eigendecomposition.
+ */
+TEST_CASE("LargestEigenvalueTest","[SdpPrimalDualTest]")
+{
+  arma::mat B = arma::randn<arma::mat>(20, 20);
+  B = B + B.t();
+
+  const arma::vec evals = arma::eig_sym(B);
+  REQUIRE(LargestEigenvalue(B) ==
+      Approx(evals(evals.n_elem - 1)).margin(1e-8));
+}
+
 TEST_CASE("SmallMaxCutSdp","[SdpPrimalDualTest]")
 {
   auto sdp = ConstructMaxCutSDPFromLaplacian("data/r10.txt");
@@ -455,6 +534,136 @@ TEST_CASE("LogChebychevApproxSdp","[SdpPrimalDualTest]")
   REQUIRE(success == true);
 }
 
+/**
+ * Solve the logarithmic Chebychev approximation SDP above as a block-diagonal
+ * SDP with p blocks of size 3, and make sure that the solution satisfies the
+ * KKT conditions and has the objective of the solution of the full SDP.
+ */
+TEST_CASE("BlockDiagonalLogChebychevApproxSdp","[SdpPrimalDualTest]")
+{
+  // Sometimes, the optimization can fail randomly, so we will run the test
+  // three times and make sure it succeeds at least once.
+  bool success = false;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const size_t p = 8;
+    const size_t k = 4;
+    const arma::mat A = RandomFullRowRankMatrix(p, k);
+    const arma::vec b = arma::randu<arma::vec>(p);
+    SDP<arma::sp_mat> sdp = ConstructLogChebychevApproxSdp(A, b);
+
+    PrimalDualSolver<SDP<arma::sp_mat>> fullSolver(sdp);
+    arma::mat fullX, fullZ;
+    arma::vec fullYsparse, fullYdense;
+    const double fullObjective = fullSolver.Optimize(fullX, fullYsparse,
+        fullYdense, fullZ);
+
+    sdp.BlockSizes() = 3 * arma::ones<arma::uvec>(p);
+    REQUIRE(sdp.NumBlocks() == p);
+    PrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+    arma::mat X, Z;
+    arma::vec ysparse, ydense;
+    const double objective = solver.Optimize(X, ysparse, ydense, Z);
+
+    // The solution stays block-diagonal.
+    const arma::mat mask(RepeatBlockDiag(
+        arma::sp_mat(arma::ones<arma::mat>(3, 3)), p));
+    REQUIRE(arma::norm(X - X % mask, "fro") == Approx(0.0).margin(1e-12));
+
+    success = CheckKKT(sdp, X, ysparse, ydense, Z) &&
+        std::abs(objective - fullObjective) < 1e-5;
+    if (success)
+      break;
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Solve the logarithmic Chebychev approximation SDP with the iterative Schur
+ * complement solve, and make sure that the solution satisfies the KKT
+ * conditions and has the objective of the direct solve.
+ */
+TEST_CASE("IterativeSchurLogChebychevApproxSdp","[SdpPrimalDualTest]")
+{
+  // Sometimes, the optimization can fail randomly, so we will run the test
+  // three times and make sure it succeeds at least once.
+  bool success = false;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const arma::mat A = RandomFullRowRankMatrix(5, 10);
+    const arma::vec b = arma::randu<arma::vec>(5);
+    const SDP<arma::sp_mat> sdp = ConstructLogChebychevApproxSdp(A, b);
+
+    PrimalDualSolver<SDP<arma::sp_mat>> directSolver(sdp);
+    arma::mat directX, directZ;
+    arma::vec directYsparse, directYdense;
+    const double directObjective = directSolver.Optimize(directX,
+        directYsparse, directYdense, directZ);
+
+    PrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+    solver.IterativeSchurThreshold() = 0;
+    arma::mat X, Z;
+    arma::vec ysparse, ydense;
+    const double objective = solver.Optimize(X, ysparse, ydense, Z);
+
+    success = CheckKKT(sdp, X, ysparse, ydense, Z) &&
+        std::abs(objective - directObjective) < 1e-5;
+    if (success)
+      break;
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Solve an SDP with rank-one constraints a_i a_i^T (as in phase retrieval),
+ * given as low-rank factors, and make sure that it has the solution of the
+ * same SDP with the constraints given as dense matrices.
+ */
+TEST_CASE("LowRankConstraintSdp","[SdpPrimalDualTest]")
+{
+  const size_t n = 5;
+  const size_t m = 8;
+
+  // The constraints are satisfied by a positive definite X0, and C is positive
+  // definite, so that both problems are strictly feasible.
+  const arma::mat a = arma::randn<arma::mat>(n, m);
+  const arma::mat R0 = arma::randn<arma::mat>(n, n);
+  const arma::mat X0 = R0 * R0.t() + arma::eye<arma::mat>(n, n);
+  const arma::mat R = arma::randn<arma::mat>(n, n);
+
+  SDP<arma::mat> lowRankSdp(n, 0, 0, m);
+  SDP<arma::mat> denseSdp(n, 0, m);
+  lowRankSdp.C() = R * R.t() + arma::eye<arma::mat>(n, n);
+  denseSdp.C() = lowRankSdp.C();
+  for (size_t i = 0; i < m; ++i)
+  {
+    lowRankSdp.LowRankA()[i] = a.col(i);
+    denseSdp.DenseA()[i] = a.col(i) * a.col(i).t();
+    lowRankSdp.LowRankB()[i] = arma::as_scalar(a.col(i).t() * X0 * a.col(i));
+  }
+  denseSdp.DenseB() = lowRankSdp.LowRankB();
+
+  PrimalDualSolver<SDP<arma::mat>> denseSolver(denseSdp);
+  arma::mat denseX, denseZ;
+  arma::vec denseYsparse, denseYdense;
+  const double denseObjective = denseSolver.Optimize(denseX, denseYsparse,
+      denseYdense, denseZ);
+  REQUIRE(CheckKKT(denseSdp, denseX, denseYsparse, denseYdense, denseZ));
+
+  PrimalDualSolver<SDP<arma::mat>> solver(lowRankSdp);
+  arma::mat X, Z;
+  arma::vec ysparse, ydense;
+  const double objective = solver.Optimize(X, ysparse, ydense, Z);
+
+  // The multipliers of the low-rank constraints are in ydense.
+  REQUIRE(ydense.n_elem == m);
+  REQUIRE(objective == Approx(denseObjective).epsilon(1e-5));
+  REQUIRE(arma::norm(X - denseX, "fro") == Approx(0.0).margin(1e-4));
+  REQUIRE(arma::norm(ydense - denseYdense, 2) == Approx(0.0).margin(1e-4));
+}
+
 /**
  * Example 1 on the SDP wiki
  *
@@ -564,3 +773,179 @@ TEST_CASE("CorrelationCoeffToySdp","[SdpPrimalDualTest]")
   REQUIRE(success == true);
   REQUIRE(obj == Approx(2 * (-0.978)).epsilon(1e-5));
 }
+
+/**
+ * Make sure that the random graphs have distinct edges (i, j) with i < j, and
+ * that the generated MaxCut SDP has minus the Laplacian as objective.
+ */
+TEST_CASE("GeneratedMaxCutSdpTest","[SdpPrimalDualTest]")
+{
+  const arma::umat edges = RandomGraph(40, 0.3);
+  REQUIRE(edges.n_rows == 2);
+  // The expected number of edges is 234, with a standard deviation of 13.
+  REQUIRE(edges.n_cols > 180);
+  REQUIRE(edges.n_cols < 290);
+
+  arma::mat adjacency(40, 40, arma::fill::zeros);
+  for (size_t i = 0; i < edges.n_cols; ++i)
+  {
+    REQUIRE(edges(0, i) < edges(1, i));
+    REQUIRE(adjacency(edges(0, i), edges(1, i)) == 0.0);
+    adjacency(edges(0, i), edges(1, i)) = 1.0;
+    adjacency(edges(1, i), edges(0, i)) = 1.0;
+  }
+
+  const arma::mat laplacian = arma::diagmat(arma::sum(adjacency, 1)) -
+      adjacency;
+  const SDP<arma::sp_mat> sdp = GenerateMaxCutSDP(edges, 40);
+  REQUIRE(sdp.NumSparseConstraints() == 40);
+  REQUIRE(arma::norm(arma::mat(sdp.C()) + laplacian, "fro") ==
+      Approx(0.0).margin(1e-12));
+
+  const SDP<arma::sp_mat> denseSDP = GenerateMaxCutSDP(edges, 40, true);
+  REQUIRE(denseSDP.NumSparseConstraints() == 0);
+  REQUIRE(denseSDP.NumDenseConstraints() == 40);
+  REQUIRE(denseSDP.DenseA()[7](7, 7) == 1.0);
+}
+
+/**
+ * With every entry observed, the generated matrix completion SDP should have
+ * the nuclear norm of the matrix as optimum.
+ */
+TEST_CASE("GeneratedMatrixCompletionSdpTest","[SdpPrimalDualTest]")
+{
+  arma::mat m;
+  const SDP<arma::sp_mat> sdp = GenerateMatrixCompletionSDP(4, 5, 1, 20, m);
+  REQUIRE(sdp.N() == 9);
+  REQUIRE(sdp.NumSparseConstraints() == 20);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+  arma::mat X, Z;
+  arma::vec ysparse, ydense;
+  const double obj = solver.Optimize(X, ysparse, ydense, Z);
+  REQUIRE(obj == Approx(arma::norm(m, "nuc")).epsilon(1e-4));
+  REQUIRE(arma::norm(X.submat(0, 4, 3, 8) - m, "fro") ==
+      Approx(0.0).margin(1e-4));
+}
+
+/**
+ * Decompose the MaxCut SDP of a cycle, whose chordal extension has small
+ * cliques, and make sure that the decomposed SDP has the optimum of the full
+ * one and that the completed solution is feasible.
+ */
+TEST_CASE("ChordalDecompositionMaxCutSdp","[SdpPrimalDualTest]")
+{
+  const size_t n = 12;
+  arma::umat edges(2, n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    edges(0, i) = std::min(i, (i + 1) % n);
+    edges(1, i) = std::max(i, (i + 1) % n);
+  }
+  const SDP<arma::sp_mat> sdp = GenerateMaxCutSDP(edges, n);
+
+  ChordalDecomposition<SDP<arma::sp_mat>> decomposition(sdp);
+  REQUIRE(decomposition.NumCliques() == n - 2);
+  for (size_t k = 0; k < decomposition.NumCliques(); ++k)
+    REQUIRE(decomposition.Cliques()[k].n_elem == 3);
+  const SDP<arma::sp_mat>& decomposed = decomposition.Decomposed();
+  REQUIRE(decomposed.NumBlocks() == n - 2);
+  REQUIRE(decomposed.NumSparseConstraints() ==
+      n + decomposition.NumCouplingConstraints());
+
+  PrimalDualSolver<SDP<arma::sp_mat>> fullSolver(sdp);
+  arma::mat fullX, fullZ;
+  arma::vec fullYsparse, fullYdense;
+  const double fullObjective = fullSolver.Optimize(fullX, fullYsparse,
+      fullYdense, fullZ);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> solver(decomposed);
+  arma::mat decomposedX, decomposedZ, X;
+  arma::vec decomposedYsparse, decomposedYdense, ysparse, ydense;
+  const double objective = solver.Optimize(decomposedX, decomposedYsparse,
+      decomposedYdense, decomposedZ);
+  REQUIRE(objective == Approx(fullObjective).epsilon(1e-5));
+
+  // The completion is PSD, satisfies the constraints and has the objective;
+  // the partial solution agrees with it on the pattern.
+  decomposition.CompleteX(decomposedX, X);
+  REQUIRE(arma::eig_sym(X).min() > -1e-6);
+  REQUIRE(arma::norm(X.diag() - arma::ones<arma::vec>(n), "inf") ==
+      Approx(0.0).margin(1e-5));
+  REQUIRE(arma::accu(arma::mat(sdp.C()) % X) ==
+      Approx(fullObjective).epsilon(1e-5));
+  const arma::mat partialX(decomposition.PartialX(decomposedX));
+  const arma::mat mask(arma::spones(decomposition.PartialX(decomposedX)));
+  REQUIRE(arma::norm(X % mask - partialX, "fro") ==
+      Approx(0.0).margin(1e-8));
+
+  // The multipliers of the diagonal constraints give the dual objective (the
+  // coupling constraints have b = 0).
+  decomposition.Multipliers(decomposedYsparse, decomposedYdense, ysparse,
+      ydense);
+  REQUIRE(ysparse.n_elem == n);
+  REQUIRE(ydense.n_elem == 0);
+  REQUIRE(arma::accu(ysparse) == Approx(fullObjective).epsilon(1e-5));
+}
+
+//! Count the iterations of an optimization.
+class IterationCounter
+{
+ public:
+  IterationCounter() : iterations(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginEpoch(OptimizerType&, FunctionType&, const MatType&, const size_t,
+                  const double)
+  {
+    ++iterations;
+  }
+
+  size_t iterations;
+};
+
+/**
+ * Solve a MaxCut SDP, change the weight of an edge, and make sure that solving
+ * the new SDP from the solution of the first one gives the same solution as
+ * from the identity, in fewer iterations.
+ */
+TEST_CASE("WarmStartMaxCutSdp","[SdpPrimalDualTest]")
+{
+  const size_t n = 20;
+  const arma::umat edges = RandomGraph(n, 0.3);
+  const SDP<arma::sp_mat> sdp = GenerateMaxCutSDP(edges, n);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> solver(sdp);
+  arma::mat X, Z;
+  arma::vec ysparse, ydense;
+  solver.Optimize(X, ysparse, ydense, Z);
+
+  SDP<arma::sp_mat> nextSdp = sdp;
+  const size_t i = edges(0, 0);
+  const size_t j = edges(1, 0);
+  nextSdp.C()(i, j) -= 0.1;
+  nextSdp.C()(j, i) -= 0.1;
+
+  PrimalDualSolver<SDP<arma::sp_mat>> coldSolver(nextSdp);
+  arma::mat coldX, coldZ;
+  arma::vec coldYsparse, coldYdense;
+  IterationCounter coldCounter;
+  const double coldObjective = coldSolver.Optimize(coldX, coldYsparse,
+      coldYdense, coldZ, coldCounter);
+
+  PrimalDualSolver<SDP<arma::sp_mat>> warmSolver(nextSdp);
+  warmSolver.WarmStart(X, ysparse, ydense, Z);
+  arma::mat warmX, warmZ;
+  arma::vec warmYsparse, warmYdense;
+  IterationCounter warmCounter;
+  const double warmObjective = warmSolver.Optimize(warmX, warmYsparse,
+      warmYdense, warmZ, warmCounter);
+
+  REQUIRE(CheckKKT(nextSdp, warmX, warmYsparse, warmYdense, warmZ));
+  REQUIRE(warmObjective == Approx(coldObjective).epsilon(1e-5));
+  REQUIRE(warmCounter.iterations < coldCounter.iterations);
+
+  // The shift has to be positive.
+  REQUIRE_THROWS_AS(warmSolver.WarmStart(X, ysparse, ydense, Z, 0.0),
+      std::logic_error);
+}
@@ -12,6 +12,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace std;
 using namespace arma;
@@ -32,6 +33,189 @@ TEST_CASE("SimpleSGDTestFunction","[SGDTest]")
   REQUIRE(coordinates[2] == Approx(0.0).margin(1e-7));
 }
 
+/**
+ * Run SGD on the simple test function with single-precision coordinates.
+ */
+TEST_CASE("SimpleSGDTestFunctionFloat","[SGDTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 5000000, 1e-9, true);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  float result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * Run SGD with sparse gradients on a function whose gradients each touch a
+ * single coordinate.
+ */
+TEST_CASE("SparseSGDTestFunction","[SGDTest]")
+{
+  SparseTestFunction f;
+  StandardSGD s(0.1, 1, 100000, 1e-12, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * Computing the batch gradient in parallel should give the same result as
+ * computing it on one thread.
+ */
+TEST_CASE("ParallelBatchSGDTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD s1(0.01, 256, 5000, 1e-15, false);
+  StandardSGD s2(0.01, 256, 5000, 1e-15, false);
+  s2.ParallelBatch() = true;
+
+  arma::mat coordinates1 = f.GetInitialPoint();
+  arma::mat coordinates2 = coordinates1;
+  const double result1 = s1.Optimize(f, coordinates1);
+  const double result2 = s2.Optimize(f, coordinates2);
+
+  REQUIRE(result2 == Approx(result1).epsilon(1e-7));
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates2[i] == Approx(coordinates1[i]).epsilon(1e-7));
+}
+
+/**
+ * The batch gradient computed on the threads of a ThreadPoolExecutor should
+ * also be the same.
+ */
+TEST_CASE("ThreadPoolParallelBatchSGDTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD s1(0.01, 256, 5000, 1e-15, false);
+  SGD<VanillaUpdate, NoDecay, ThreadPoolExecutor> s2(0.01, 256, 5000, 1e-15,
+      false, VanillaUpdate(), NoDecay(), true, true, ThreadPoolExecutor(4));
+
+  arma::mat coordinates1 = f.GetInitialPoint();
+  arma::mat coordinates2 = coordinates1;
+  const double result1 = s1.Optimize(f, coordinates1);
+  const double result2 = s2.Optimize(f, coordinates2);
+
+  REQUIRE(result2 == Approx(result1).epsilon(1e-7));
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates2[i] == Approx(coordinates1[i]).epsilon(1e-7));
+}
+
+/**
+ * LogisticRegression can be evaluated on any set of indices, so SGD should
+ * visit it in a shuffled order without shuffling (or copying) its data.
+ */
+TEST_CASE("VisitationOrderSGDTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  const bool lrIndexed =
+      ens::traits::HasIndexedFunctions<LogisticRegression<>>::value;
+  const bool sgdTestIndexed =
+      ens::traits::HasIndexedFunctions<SGDTestFunction>::value;
+  REQUIRE(lrIndexed == true);
+  REQUIRE(sgdTestIndexed == false);
+
+  // A batch of the visited function is the same batch of the permuted data.
+  IndexedFunction<LogisticRegression<>> visited(f);
+  visited.Shuffle();
+  LogisticRegression<> g(shuffledData.cols(visited.Order()),
+      shuffledResponses.cols(visited.Order()), 0.5);
+
+  arma::mat coordinates = arma::randu<arma::mat>(1, f.NumFeatures());
+  arma::mat gradient1, gradient2;
+  const double objective1 = visited.EvaluateWithGradient(coordinates, 10,
+      gradient1, 50);
+  const double objective2 = g.EvaluateWithGradient(coordinates, 10, gradient2,
+      50);
+  REQUIRE(objective1 == Approx(objective2).epsilon(1e-7));
+  for (size_t i = 0; i < gradient1.n_elem; ++i)
+    REQUIRE(gradient1[i] == Approx(gradient2[i]).epsilon(1e-7));
+
+  // Adam is SGD with a different update policy.
+  Adam adam;
+  coordinates = f.GetInitialPoint();
+  adam.Optimize(f, coordinates);
+
+  // The function still aliases the original data.
+  REQUIRE(f.Predictors().memptr() == shuffledData.memptr());
+
+  // Ensure that the error is close to zero.
+  const double acc = f.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = f.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * With block shuffling, every block of the permutation should be one
+ * contiguous block of the data (in any order inside it), and SGD should still
+ * train the model.
+ */
+TEST_CASE("BlockShuffleSGDTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+
+  const size_t blockSize = 64;
+  IndexedFunction<LogisticRegression<>> visited(f, blockSize);
+  visited.Shuffle();
+
+  const arma::uvec& order = visited.Order();
+  REQUIRE(order.n_elem == f.NumFunctions());
+  REQUIRE(arma::all(arma::sort(order) ==
+      arma::linspace<arma::uvec>(0, order.n_elem - 1, order.n_elem)));
+  for (size_t begin = 0; begin < order.n_elem; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize, (size_t) order.n_elem);
+    const arma::uvec block = order.subvec(begin, end - 1);
+    REQUIRE(block.min() % blockSize == 0);
+    REQUIRE(block.max() - block.min() == end - begin - 1);
+  }
+
+  StandardSGD optimizer(0.01, 32, 100000, 1e-5, true);
+  optimizer.ShuffleBlockSize() = blockSize;
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, coordinates);
+
+  const double acc = f.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+}
+
 TEST_CASE("GeneralizedRosenbrockTest","[SGDTest]")
 {
   // Loop over several variants.
@@ -50,3 +234,891 @@ TEST_CASE("GeneralizedRosenbrockTest","[SGDTest]")
       REQUIRE(coordinates[j] == Approx(1.0).epsilon(1e-5));
   }
 }
+
+/**
+ * Make sure that GradientClipping clips the elements and the norm of the
+ * gradient it passes to the wrapped policy.
+ */
+TEST_CASE("GradientClippingTest","[SGDTest]")
+{
+  VanillaUpdate vanilla;
+  GradientClipping<VanillaUpdate> clipping(-5.0, 5.0, vanilla, 5.0);
+  GradientClipping<VanillaUpdate>::Policy<arma::mat, arma::mat> policy(
+      clipping, 3, 1);
+
+  // The elements are clipped to (3, 4, -5), with norm sqrt(50); the norm is
+  // then clipped to 5.
+  arma::mat iterate(3, 1, arma::fill::zeros);
+  policy.Update(iterate, 1.0, arma::mat("3; 4; -10"));
+  const double scale = 5.0 / std::sqrt(50.0);
+  REQUIRE(iterate(0) == Approx(-3.0 * scale));
+  REQUIRE(iterate(1) == Approx(-4.0 * scale));
+  REQUIRE(iterate(2) == Approx(5.0 * scale));
+
+  // A gradient within both limits is not modified.
+  iterate.zeros();
+  policy.Update(iterate, 1.0, arma::mat("0.5; -1; 2"));
+  REQUIRE(iterate(0) == Approx(-0.5));
+  REQUIRE(iterate(1) == Approx(1.0));
+  REQUIRE(iterate(2) == Approx(-2.0));
+
+  // Without a maximum norm, only the elements are clipped.
+  clipping.MaxNorm() = 0.0;
+  iterate.zeros();
+  policy.Update(iterate, 1.0, arma::mat("3; 4; -10"));
+  REQUIRE(iterate(2) == Approx(5.0));
+}
+
+/**
+ * Run SGD with single-precision coordinates and a double precision master copy
+ * of the parameters on the simple test function.
+ */
+TEST_CASE("MixedPrecisionSGDTestFunction","[SGDTest]")
+{
+  SGDTestFunction f;
+  SGD<MixedPrecision<VanillaUpdate>> s(0.0003, 1, 5000000, 1e-9, true);
+
+  arma::fmat coordinates = f.GetInitialPoint<arma::fmat>();
+  float result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * Make sure that updates too small to change a single-precision iterate are
+ * accumulated in the master copy.
+ */
+TEST_CASE("MixedPrecisionAccumulationTest","[SGDTest]")
+{
+  MixedPrecision<VanillaUpdate> mixed;
+  MixedPrecision<VanillaUpdate>::Policy<arma::fmat, arma::fmat> policy(mixed,
+      1, 1);
+  VanillaUpdate vanilla;
+  VanillaUpdate::Policy<arma::fmat, arma::fmat> plainPolicy(vanilla, 1, 1);
+
+  arma::fmat iterate(1, 1), plainIterate(1, 1);
+  iterate.fill(1.0f);
+  plainIterate.fill(1.0f);
+  const arma::fmat gradient(1, 1, arma::fill::ones);
+  for (size_t i = 0; i < 10000; ++i)
+  {
+    policy.Update(iterate, 1e-9, gradient);
+    plainPolicy.Update(plainIterate, 1e-9, gradient);
+  }
+
+  REQUIRE(plainIterate(0) == 1.0f);
+  REQUIRE(policy.Master()(0) == Approx(1.0 - 1e-5).epsilon(1e-10));
+  REQUIRE(iterate(0) == Approx(1.0 - 1e-5).epsilon(1e-6));
+}
+
+/**
+ * Make sure that Lookahead moves the slow weights towards the fast weights and
+ * resets the iterate every k steps.
+ */
+TEST_CASE("LookaheadTest","[SGDTest]")
+{
+  Lookahead<VanillaUpdate> lookahead(VanillaUpdate(), 2, 0.5);
+  Lookahead<VanillaUpdate>::Policy<arma::mat, arma::mat> policy(lookahead, 1,
+      1);
+
+  arma::mat iterate(1, 1, arma::fill::zeros);
+  const arma::mat gradient(1, 1, arma::fill::ones);
+  policy.Update(iterate, 1.0, gradient);
+  REQUIRE(iterate(0) == Approx(-1.0));
+  REQUIRE(policy.Slow()(0) == Approx(0.0).margin(1e-15));
+
+  // The fast weights are at -2, so the slow weights move to -1.
+  policy.Update(iterate, 1.0, gradient);
+  REQUIRE(policy.Slow()(0) == Approx(-1.0));
+  REQUIRE(iterate(0) == Approx(-1.0));
+
+  // Lookahead around SGD still minimizes the test function.
+  SGDTestFunction f;
+  SGD<Lookahead<VanillaUpdate>> s(0.0003, 1, 5000000, 1e-9, true,
+      Lookahead<VanillaUpdate>());
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(s.InstUpdatePolicy().Slow()(0) == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * Make sure that WeightAveraging keeps the Polyak average and the exponential
+ * moving average of the iterates, and that the average can be read after the
+ * optimization.
+ */
+TEST_CASE("WeightAveragingTest","[SGDTest]")
+{
+  // The iterates are 1, 2, 3, 4.
+  const arma::mat gradient(1, 1, arma::fill::ones);
+  WeightAveraging<VanillaUpdate> polyak(VanillaUpdate(), 0.0);
+  WeightAveraging<VanillaUpdate>::Policy<arma::mat, arma::mat> polyakPolicy(
+      polyak, 1, 1);
+  WeightAveraging<VanillaUpdate> ema(VanillaUpdate(), 0.5);
+  WeightAveraging<VanillaUpdate>::Policy<arma::mat, arma::mat> emaPolicy(ema,
+      1, 1);
+
+  arma::mat iterate(1, 1, arma::fill::zeros), emaIterate(1, 1,
+      arma::fill::zeros);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    polyakPolicy.Update(iterate, -1.0, gradient);
+    emaPolicy.Update(emaIterate, -1.0, gradient);
+  }
+
+  REQUIRE(iterate(0) == Approx(4.0));
+  REQUIRE(polyakPolicy.Count() == 4);
+  REQUIRE(polyakPolicy.Average()(0) == Approx(2.5));
+  REQUIRE(emaPolicy.Average()(0) == Approx(3.125));
+
+  SGDTestFunction f;
+  SGD<WeightAveraging<VanillaUpdate>> s(0.0003, 1, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+
+  const arma::mat& average = s.InstUpdatePolicy().Average();
+  REQUIRE(average.n_elem == coordinates.n_elem);
+  REQUIRE(average[0] == Approx(0.0).margin(1e-2));
+  REQUIRE(average[1] == Approx(0.0).margin(1e-2));
+  REQUIRE(average[2] == Approx(0.0).margin(1e-2));
+
+  // The policy was not instantiated for single-precision matrices.
+  REQUIRE_THROWS_AS(s.InstUpdatePolicy<arma::fmat>(), std::logic_error);
+}
+
+/**
+ * Make sure that ParameterGroups updates each group with its own policy and
+ * step size, skips frozen groups, and rejects overlapping groups.
+ */
+TEST_CASE("ParameterGroupsTest","[SGDTest]")
+{
+  // Column 0 has half the step size, column 1 is frozen, and column 2 uses the
+  // default policy.
+  ParameterGroups<VanillaUpdate> groups;
+  groups.Add(0, 4, VanillaUpdate(), 0.5);
+  groups.Freeze(4, 4);
+  ParameterGroups<VanillaUpdate>::Policy<arma::mat, arma::mat> policy(groups,
+      4, 3);
+  REQUIRE(policy.UpdatedGroups() == 2);
+  REQUIRE(policy.UpdatedElements() == 8);
+
+  arma::mat iterate(4, 3, arma::fill::zeros);
+  policy.Update(iterate, 1.0, arma::mat(4, 3, arma::fill::ones));
+  for (size_t i = 0; i < 4; ++i)
+  {
+    REQUIRE(iterate(i, 0) == Approx(-0.5));
+    REQUIRE(iterate(i, 1) == 0.0);
+    REQUIRE(iterate(i, 2) == Approx(-1.0));
+  }
+
+  ParameterGroups<VanillaUpdate> overlapping;
+  overlapping.Add(0, 5, VanillaUpdate());
+  overlapping.Freeze(4, 4);
+  typedef ParameterGroups<VanillaUpdate>::Policy<arma::mat, arma::mat>
+      PolicyType;
+  REQUIRE_THROWS_AS(PolicyType(overlapping, 4, 3), std::invalid_argument);
+
+  // Freeze the last coordinate of the test function; the others are still
+  // minimized.
+  ParameterGroups<VanillaUpdate> frozen;
+  frozen.Freeze(2, 1);
+  SGD<ParameterGroups<VanillaUpdate>> s(0.0003, 1, 5000000, 1e-9, true,
+      frozen);
+
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+
+  REQUIRE(coordinates[0] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[1] == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates[2] == 6.2);
+}
+
+/**
+ * Make sure that LARS and LAMB scale their steps by the trust ratio of each
+ * block.
+ */
+TEST_CASE("LARSLAMBTrustRatioTest","[SGDTest]")
+{
+  // ||x|| = 5 and ||g|| = 2, so the trust ratio is 0.1 * 5 / 2.
+  LARSUpdate lars(0.9, 0.1, 0.0, 0.0);
+  LARSUpdate::Policy<arma::mat, arma::mat> larsPolicy(lars, 2, 1);
+  arma::mat iterate("3; 4");
+  larsPolicy.Update(iterate, 1.0, arma::mat("0; 2"));
+  REQUIRE(larsPolicy.TrustRatio() == Approx(0.25));
+  REQUIRE(iterate(0) == Approx(3.0));
+  REQUIRE(iterate(1) == Approx(3.5));
+
+  // At the first step the Adam step is the sign of the gradient, with norm
+  // sqrt(2), so the trust ratio is 5 / sqrt(2).
+  LAMBUpdate lamb(1e-12);
+  LAMBUpdate::Policy<arma::mat, arma::mat> lambPolicy(lamb, 2, 1);
+  iterate = arma::mat("3; 4");
+  lambPolicy.Update(iterate, 0.1, arma::mat("1; -2"));
+  REQUIRE(lambPolicy.TrustRatio() == Approx(5.0 / std::sqrt(2.0)));
+  REQUIRE(iterate(0) == Approx(3.0 - 0.5 / std::sqrt(2.0)));
+  REQUIRE(iterate(1) == Approx(4.0 + 0.5 / std::sqrt(2.0)));
+
+  // With one group per column, each column has its own trust ratio.
+  ParameterGroups<LARSUpdate> groups(lars);
+  groups.Add(0, 2, lars);
+  ParameterGroups<LARSUpdate>::Policy<arma::mat, arma::mat> groupsPolicy(
+      groups, 2, 2);
+  iterate = arma::mat("3 6; 4 8");
+  groupsPolicy.Update(iterate, 1.0, arma::mat("0 0; 2 1"));
+  REQUIRE(groupsPolicy.UpdatedGroups() == 2);
+  REQUIRE(groupsPolicy.GroupPolicy(0).TrustRatio() == Approx(0.25));
+  REQUIRE(groupsPolicy.GroupPolicy(1).TrustRatio() == Approx(1.0));
+}
+
+/**
+ * Run SGD with the LAMB update policy on logistic regression with a large
+ * batch, with one trust ratio for the intercept and one for the weights.
+ */
+TEST_CASE("LAMBLogisticRegressionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  ParameterGroups<LAMBUpdate> groups;
+  groups.Add(0, 1, LAMBUpdate());
+  SGD<ParameterGroups<LAMBUpdate>> optimizer(0.01, 256, 500000, 1e-5, true,
+      groups);
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * BatchSizeGrowth should grow the batch once per interval, up to the limit.
+ */
+TEST_CASE("BatchSizeGrowthScheduleTest","[SGDTest]")
+{
+  BatchSizeGrowth<> policy(3.0, 2, 100);
+
+  size_t batchSize = 4;
+  policy.UpdateBatchSize(batchSize, 2, 1000);
+  REQUIRE(batchSize == 4);
+  policy.UpdateBatchSize(batchSize, 3, 1000);
+  REQUIRE(batchSize == 12);
+  policy.UpdateBatchSize(batchSize, 5, 1000);
+  REQUIRE(batchSize == 36);
+  policy.UpdateBatchSize(batchSize, 7, 1000);
+  REQUIRE(batchSize == 100);
+
+  // The batch is never larger than the number of functions.
+  policy.MaxBatchSize() = 0;
+  policy.UpdateBatchSize(batchSize, 9, 200);
+  REQUIRE(batchSize == 200);
+}
+
+/**
+ * Run SGD on logistic regression with a batch that grows from 8 to 256, and
+ * make sure the results are acceptable.
+ */
+TEST_CASE("BatchSizeGrowthLogisticRegressionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SGD<VanillaUpdate, BatchSizeGrowth<>> optimizer(0.01, 8, 100000, -1, true,
+      VanillaUpdate(), BatchSizeGrowth<>(2.0, 1, 256));
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  REQUIRE(optimizer.BatchSize() == 256);
+
+  // The grown batch is part of the state.
+  OptimizerState state;
+  optimizer.SaveState(state);
+  size_t storedBatchSize = 0;
+  state.Get("batchSize", storedBatchSize);
+  REQUIRE(storedBatchSize == 256);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Run the given step size schedule for the given number of steps from a step
+ * size of 1, and return the step size of each step.
+ */
+template<typename DecayPolicyType>
+std::vector<double> StepSizeSchedule(DecayPolicyType& policy,
+                                     const size_t steps)
+{
+  arma::mat iterate(2, 1, arma::fill::zeros), gradient(2, 1, arma::fill::zeros);
+  double stepSize = 1.0;
+  policy.Initialize(stepSize);
+
+  std::vector<double> schedule;
+  for (size_t i = 0; i < steps; ++i)
+  {
+    schedule.push_back(stepSize);
+    policy.Update(iterate, stepSize, gradient);
+  }
+  return schedule;
+}
+
+TEST_CASE("StepDecayScheduleTest","[SGDTest]")
+{
+  StepDecay policy(0.5, 10);
+  const std::vector<double> schedule = StepSizeSchedule(policy, 45);
+  for (size_t i = 0; i < schedule.size(); ++i)
+    REQUIRE(schedule[i] == Approx(std::pow(0.5, (double) (i / 10))));
+}
+
+TEST_CASE("PolynomialDecayScheduleTest","[SGDTest]")
+{
+  // Integer and fractional powers take different paths.
+  for (const double power : { 1.0, 3.0, 0.5 })
+  {
+    PolynomialDecay policy(50, power, 0.1);
+    const std::vector<double> schedule = StepSizeSchedule(policy, 80);
+    for (size_t i = 0; i < schedule.size(); ++i)
+    {
+      const double expected = (i >= 50) ? 0.1 :
+          0.1 + 0.9 * std::pow(1.0 - i / 50.0, power);
+      REQUIRE(schedule[i] == Approx(expected).margin(1e-12));
+    }
+  }
+
+  LinearDecay linear(20);
+  const std::vector<double> schedule = StepSizeSchedule(linear, 30);
+  for (size_t i = 0; i < schedule.size(); ++i)
+  {
+    const double expected = (i >= 20) ? 0.0 : 1.0 - i / 20.0;
+    REQUIRE(schedule[i] == Approx(expected).margin(1e-12));
+  }
+}
+
+TEST_CASE("CosineDecayScheduleTest","[SGDTest]")
+{
+  // The recurrence must stay accurate over many more steps than the
+  // resynchronization interval.
+  CosineDecay policy(20000, 0.01);
+  const std::vector<double> schedule = StepSizeSchedule(policy, 21000);
+  for (size_t i = 0; i < schedule.size(); ++i)
+  {
+    const double expected = (i >= 20000) ? 0.01 : 0.01 + 0.99 * 0.5 *
+        (1.0 + std::cos(arma::datum::pi * i / 20000.0));
+    REQUIRE(schedule[i] == Approx(expected).margin(1e-10));
+  }
+}
+
+TEST_CASE("WarmupCosineDecayScheduleTest","[SGDTest]")
+{
+  WarmupCosineDecay policy(10, CosineDecay(100));
+  const std::vector<double> schedule = StepSizeSchedule(policy, 120);
+  for (size_t i = 0; i < 10; ++i)
+    REQUIRE(schedule[i] == Approx((i + 1) / 10.0));
+  for (size_t i = 10; i < schedule.size(); ++i)
+  {
+    const double expected = (i >= 110) ? 0.0 : 0.5 *
+        (1.0 + std::cos(arma::datum::pi * (i - 10) / 100.0));
+    REQUIRE(schedule[i] == Approx(expected).margin(1e-12));
+  }
+}
+
+TEST_CASE("StepSizeScheduleStateTest","[SGDTest]")
+{
+  // A schedule restored in the middle of the cosine phase continues at the
+  // same step size, whatever step size the optimizer has.
+  WarmupCosineDecay policy(10, CosineDecay(100));
+  StepSizeSchedule(policy, 37);
+
+  OptimizerState state;
+  policy.Save(state);
+
+  WarmupCosineDecay restored(10, CosineDecay(100));
+  restored.Load(state);
+  double stepSize = 123.0;
+  restored.Initialize(stepSize);
+  const double expected = 0.5 * (1.0 + std::cos(arma::datum::pi * 27 / 100.0));
+  REQUIRE(stepSize == Approx(expected).margin(1e-12));
+  REQUIRE(restored.Steps() == policy.Steps());
+}
+
+TEST_CASE("WarmupCosineDecayLogisticRegressionTest","[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  // 100 passes over the 1000 points with batches of 32.
+  SGD<VanillaUpdate, WarmupCosineDecay> optimizer(0.01, 32, 100000, -1, true,
+      VanillaUpdate(), WarmupCosineDecay(100, CosineDecay(3200)));
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+}
+
+/**
+ * Make sure that an update policy that can be reset in place is reused by the
+ * next call to Optimize(), and that the reset policy behaves as a new one.
+ */
+TEST_CASE("ResetUpdatePolicyInPlaceTest","[SGDTest]")
+{
+  REQUIRE(HasResetMethod<AdamUpdate::Policy<arma::mat, arma::mat>>::value);
+  REQUIRE(HasResetMethod<MomentumUpdate::Policy<arma::mat, arma::mat>>::value);
+  REQUIRE(!HasResetMethod<VanillaUpdate::Policy<arma::mat, arma::mat>>::value);
+
+  SGDTestFunction f;
+  SGD<AdamUpdate> s(0.01, 1, 3000, -1, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+  const AdamUpdate::Policy<arma::mat, arma::mat>* policy =
+      &s.InstUpdatePolicy();
+
+  arma::mat restartCoordinates = f.GetInitialPoint();
+  s.Optimize(f, restartCoordinates);
+
+  REQUIRE(&s.InstUpdatePolicy() == policy);
+  REQUIRE(arma::approx_equal(coordinates, restartCoordinates, "absdiff",
+      1e-12));
+}
+
+/**
+ * A logistic regression function without the batched gradient over several
+ * models, so that MultiModelFunction evaluates each model on its own.
+ */
+class PlainLogisticRegression : public LogisticRegression<>
+{
+ public:
+  PlainLogisticRegression(const arma::mat& predictors,
+                          const arma::Row<size_t>& responses,
+                          const double lambda) :
+      LogisticRegression<>(predictors, responses, lambda) { }
+};
+
+/**
+ * Training several logistic regression models with different regularization
+ * and step sizes with one SGD optimization should give the same models as
+ * training each of them on its own.
+ */
+TEST_CASE("MultiModelSGDLogisticRegressionTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::vec lambdas("0.0 0.5 2.0");
+  const arma::vec stepScales("1.0 0.5 2.0");
+  std::vector<LogisticRegression<>> models;
+  std::vector<PlainLogisticRegression> plainModels;
+  for (size_t k = 0; k < lambdas.n_elem; ++k)
+  {
+    models.push_back(LogisticRegression<>(shuffledData, shuffledResponses,
+        lambdas[k]));
+    plainModels.push_back(PlainLogisticRegression(shuffledData,
+        shuffledResponses, lambdas[k]));
+  }
+
+  MultiModelFunction<LogisticRegression<>> f(models, true);
+  MultiModelFunction<PlainLogisticRegression> plain(plainModels, true);
+  REQUIRE(traits::HasMultiModelGradient<LogisticRegression<>>::value);
+  REQUIRE(!traits::HasMultiModelGradient<PlainLogisticRegression>::value);
+
+  // The batched gradient is the same as that of each model.
+  const size_t n = shuffledData.n_rows + 1;
+  arma::mat coordinates(n, lambdas.n_elem, arma::fill::randn);
+  arma::mat gradient, plainGradient;
+  const double objective = f.EvaluateWithGradient(coordinates, 100, gradient,
+      50);
+  const double plainObjective = plain.EvaluateWithGradient(coordinates, 100,
+      plainGradient, 50);
+  REQUIRE(objective == Approx(plainObjective).epsilon(1e-10));
+  CheckMatrices(gradient, plainGradient, 1e-8);
+
+  // Train all the models at once, each with its own step size.
+  ParameterGroups<VanillaUpdate> groups;
+  for (size_t k = 0; k < lambdas.n_elem; ++k)
+    groups.Add(k * n, n, VanillaUpdate(), stepScales[k]);
+  SGD<ParameterGroups<VanillaUpdate>> optimizer(0.001, 32, 5000, -1.0, false,
+      groups);
+  coordinates.zeros();
+  optimizer.Optimize(f, coordinates);
+
+  arma::vec objectives;
+  f.Objectives(coordinates, objectives);
+  for (size_t k = 0; k < lambdas.n_elem; ++k)
+  {
+    StandardSGD single(0.001 * stepScales[k], 32, 5000, -1.0, false);
+    arma::mat singleCoordinates = models[k].GetInitialPoint();
+    single.Optimize(models[k], singleCoordinates);
+
+    CheckMatrices(coordinates.col(k).t(), singleCoordinates, 1e-6);
+    REQUIRE(objectives[k] == Approx(models[k].Evaluate(singleCoordinates))
+        .epsilon(1e-6));
+  }
+}
+
+/**
+ * With lazy weight decay and a sparse gradient, each coordinate of the sparse
+ * test function receives the four decays of an epoch when it is touched, so
+ * the iterates converge to the fixed point of x <- d^4 x - step (2 x + b).
+ */
+TEST_CASE("LazyWeightDecaySparseSGDTest", "[SGDTest]")
+{
+  SparseTestFunction f;
+
+  const double stepSize = 0.1;
+  const double lambda = 0.1;
+  LazyWeightDecay<> update(lambda);
+  SGD<LazyWeightDecay<>> optimizer(stepSize, 1, 4000, 1e-15, false, update);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  // Coordinate i is touched in step i + 1 of every epoch, and is then brought
+  // up to date with the 3 - i remaining decays of the last epoch.
+  const double d = 1.0 - stepSize * lambda;
+  const arma::vec b("-4 -2 -3 -8");
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const double fixedPoint = -stepSize * b[i] /
+        (1.0 - std::pow(d, 4.0) + 2.0 * stepSize);
+    REQUIRE(coordinates[i] ==
+        Approx(std::pow(d, 3.0 - i) * fixedPoint).epsilon(1e-6));
+  }
+
+  // All the coordinates are up to date.
+  const arma::mat& lastClock = optimizer.InstUpdatePolicy<arma::mat,
+      arma::sp_mat>().LastClock();
+  for (size_t i = 0; i < 4; ++i)
+  {
+    REQUIRE(lastClock[i] == optimizer.InstUpdatePolicy<arma::mat,
+        arma::sp_mat>().Clock());
+  }
+}
+
+/**
+ * A logistic regression function that records the largest number of functions
+ * given to one call of EvaluateWithGradient().
+ */
+class MaxBatchLogisticRegression
+{
+ public:
+  MaxBatchLogisticRegression(const arma::mat& predictors,
+                             const arma::Row<size_t>& responses) :
+      function(predictors, responses), maxBatchSize(0) { }
+
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  void Shuffle() { function.Shuffle(); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return function.Evaluate(coordinates, begin, batchSize);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    maxBatchSize = std::max(maxBatchSize, batchSize);
+    return function.EvaluateWithGradient(coordinates, begin, gradient,
+        batchSize);
+  }
+
+  LogisticRegression<> function;
+  size_t maxBatchSize;
+};
+
+/**
+ * An executor that runs the tasks of four threads one after the other.
+ */
+class FourTaskExecutor
+{
+ public:
+  size_t Threads() const { return 4; }
+
+  template<typename TaskType>
+  void Run(const size_t tasks, TaskType task)
+  {
+    for (size_t t = 0; t < tasks; ++t)
+      task(t);
+  }
+};
+
+/**
+ * Accumulating the gradient of each batch from micro-batches should give the
+ * same steps as computing it in one call, without ever evaluating more than a
+ * micro-batch at once.
+ */
+TEST_CASE("MicroBatchSGDTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  MaxBatchLogisticRegression f(shuffledData, shuffledResponses);
+  StandardSGD optimizer(0.001, 64, 5000, -1.0, false);
+  arma::mat coordinates = f.function.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+  REQUIRE(f.maxBatchSize == 64);
+
+  MaxBatchLogisticRegression g(shuffledData, shuffledResponses);
+  optimizer.MicroBatchSize() = 10;
+  arma::mat microCoordinates = g.function.GetInitialPoint();
+  const double microObjective = optimizer.Optimize(g, microCoordinates);
+  REQUIRE(g.maxBatchSize == 10);
+
+  CheckMatrices(coordinates, microCoordinates, 1e-8);
+  REQUIRE(objective == Approx(microObjective).epsilon(1e-8));
+
+  // Each sub-batch of 16 functions accumulates its own micro-batches.
+  MaxBatchLogisticRegression h(shuffledData, shuffledResponses);
+  SGD<VanillaUpdate, NoDecay, FourTaskExecutor> parallelOptimizer(0.001, 64,
+      5000, -1.0, false, VanillaUpdate(), NoDecay(), true, true,
+      FourTaskExecutor(), 10);
+  arma::mat parallelCoordinates = h.function.GetInitialPoint();
+  parallelOptimizer.Optimize(h, parallelCoordinates);
+  REQUIRE(h.maxBatchSize == 10);
+
+  CheckMatrices(coordinates, parallelCoordinates, 1e-8);
+}
+
+/**
+ * With pipelining, the gradient of every batch but the first of an epoch is
+ * computed at the iterate before the last step, while that step is taken.
+ */
+TEST_CASE("PipelinedSGDTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> f(shuffledData, shuffledResponses, 0.5);
+  const size_t n = f.NumFunctions();
+
+  // Take the steps with one-step stale gradients by hand.
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::mat gradient, nextGradient;
+  for (size_t epoch = 0; epoch < 3; ++epoch)
+  {
+    f.EvaluateWithGradient(coordinates, 0, gradient, 64);
+    for (size_t begin = 0; begin < n; begin += 64)
+    {
+      const size_t nextBegin = begin + 64;
+      if (nextBegin < n)
+      {
+        f.EvaluateWithGradient(coordinates, nextBegin, nextGradient,
+            std::min((size_t) 64, n - nextBegin));
+      }
+      coordinates -= 0.01 * gradient;
+      gradient = nextGradient;
+    }
+  }
+
+  // The update and the gradient of the next batch are separate tasks.
+  SGD<VanillaUpdate, NoDecay, FourTaskExecutor> optimizer(0.01, 64, 3 * n,
+      -1.0, false, VanillaUpdate(), NoDecay(), true, false,
+      FourTaskExecutor());
+  optimizer.Pipelined() = true;
+  arma::mat pipelinedCoordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, pipelinedCoordinates);
+  CheckMatrices(coordinates, pipelinedCoordinates, 1e-8);
+
+  // The next batch may also be split between the other threads.
+  optimizer.ParallelBatch() = true;
+  pipelinedCoordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, pipelinedCoordinates);
+  CheckMatrices(coordinates, pipelinedCoordinates, 1e-8);
+}
+
+/**
+ * Step-wise SGD optimizations, advanced a few batches at a time in turn, must
+ * take the same steps as Optimize(), and end with the same objective.
+ */
+TEST_CASE("SGDStepperTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> f(shuffledData, shuffledResponses, 0.5);
+
+  SGD<MomentumUpdate, StepDecay> optimizer(0.001, 64, 5000, -1.0, false,
+      MomentumUpdate(0.5), StepDecay(0.5, 10));
+
+  typedef SGDStepper<SGD<MomentumUpdate, StepDecay>,
+      LogisticRegressionFunction<>> StepperType;
+  std::vector<arma::mat> stepCoordinates(3, f.GetInitialPoint());
+  std::vector<StepperType> steppers;
+  for (size_t i = 0; i < 3; ++i)
+    steppers.push_back(MakeStepper(optimizer, f, stepCoordinates[i]));
+
+  bool running = true;
+  while (running)
+  {
+    running = false;
+    for (size_t i = 0; i < 3; ++i)
+      running |= steppers[i].Step(i + 2);
+  }
+
+  // The steppers decayed the step size of their own copies of the optimizer.
+  REQUIRE(optimizer.StepSize() == 0.001);
+  REQUIRE(steppers[0].Optimizer().StepSize() < 0.001);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(steppers[i].Done());
+    REQUIRE(steppers[i].Iterations() == 5000);
+    REQUIRE(steppers[i].Steps() >= 5000 / 64);
+    REQUIRE(steppers[i].Result() == Approx(objective).epsilon(1e-10));
+    CheckMatrices(coordinates, stepCoordinates[i], 1e-10);
+  }
+}
+
+#ifdef ENS_USE_COOT
+
+/**
+ * The separable function f(x) = sum_i ||x - c_i||^2 / 2, with the centers c_i
+ * in the columns of a matrix; the matrix type can be a GPU matrix.
+ */
+template<typename MatType>
+class CentersFunction
+{
+ public:
+  CentersFunction(const MatType& centers) : centers(centers) { }
+
+  size_t NumFunctions() const { return centers.n_cols; }
+
+  void Shuffle() { }
+
+  typename MatType::elem_type Evaluate(const MatType& x,
+                                       const size_t begin,
+                                       const size_t batchSize)
+  {
+    typename MatType::elem_type objective = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      const MatType d = x - centers.col(i);
+      objective += accu(d % d) / 2;
+    }
+    return objective;
+  }
+
+  void Gradient(const MatType& x,
+                const size_t begin,
+                MatType& gradient,
+                const size_t batchSize)
+  {
+    gradient = batchSize * x - sum(centers.cols(begin,
+        begin + batchSize - 1), 1);
+  }
+
+ private:
+  MatType centers;
+};
+
+/**
+ * SGD with the given update policy must take the same steps on the GPU as on
+ * the host, and the iterate must stay a GPU matrix.
+ */
+template<typename UpdatePolicyType>
+void CootMatchesArmaTest(const UpdatePolicyType& updatePolicy)
+{
+  arma::fmat centers(10, 64, arma::fill::randu);
+  CentersFunction<arma::fmat> f(centers);
+  CentersFunction<coot::fmat> g(coot::conv_to<coot::fmat>::from(centers));
+
+  SGD<UpdatePolicyType> optimizer(0.01, 8, 6400, -1, false, updatePolicy);
+  arma::fmat coordinates1(10, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coordinates1);
+
+  coot::fmat coordinates2(10, 1);
+  coordinates2.zeros();
+  optimizer.Optimize(g, coordinates2);
+
+  const arma::fmat result = coot::conv_to<arma::fmat>::from(coordinates2);
+  REQUIRE(arma::approx_equal(coordinates1, result, "absdiff", 1e-4));
+  REQUIRE(arma::approx_equal(result, arma::mean(centers, 1), "absdiff",
+      0.05));
+}
+
+TEST_CASE("CootAdamTest", "[SGDTest]")
+{
+  CootMatchesArmaTest(AdamUpdate());
+}
+
+TEST_CASE("CootMomentumTest", "[SGDTest]")
+{
+  CootMatchesArmaTest(MomentumUpdate(0.5));
+}
+
+TEST_CASE("CootNesterovMomentumTest", "[SGDTest]")
+{
+  CootMatchesArmaTest(NesterovMomentumUpdate(0.5));
+}
+
+/**
+ * The state of a GPU optimization must be saved through the host and restored
+ * to the device.
+ */
+TEST_CASE("CootAdamStateTest", "[SGDTest]")
+{
+  coot::fmat m(3, 2), restored;
+  m.fill(0.25);
+
+  OptimizerState state;
+  state.Set("m", m);
+  state.Get("m", restored);
+
+  REQUIRE(restored.n_rows == 3);
+  REQUIRE(restored.n_cols == 2);
+  REQUIRE(coot::accu(restored) == Approx(1.5));
+}
+
+#endif
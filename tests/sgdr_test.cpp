@@ -53,6 +53,45 @@ TEST_CASE("SGDRCyclicalResetTest","[SGDRTest]")
   }
 }
 
+/**
+ * Make sure that the position in the restart cycle can be read, and that
+ * Restart() goes back to the start of the first cycle.
+ */
+TEST_CASE("SGDRCyclicalRestartTest","[SGDRTest]")
+{
+  const double stepSize = 0.5;
+  arma::mat iterate;
+
+  CyclicalDecay cyclicalDecay(5, 2.0, stepSize);
+  cyclicalDecay.EpochBatches() = 10;
+
+  arma::vec stepSizes(100);
+  for (size_t i = 0; i < stepSizes.n_elem; ++i)
+  {
+    double epochStepSize = stepSize;
+    cyclicalDecay.Update(iterate, epochStepSize, iterate);
+    stepSizes(i) = epochStepSize;
+  }
+
+  REQUIRE(cyclicalDecay.Epoch() == 100);
+  REQUIRE(cyclicalDecay.EpochRestart() > 5);
+  REQUIRE(cyclicalDecay.NextRestart() > 5);
+
+  cyclicalDecay.Restart();
+  REQUIRE(cyclicalDecay.Epoch() == 0);
+  REQUIRE(cyclicalDecay.EpochRestart() == 5);
+  REQUIRE(cyclicalDecay.NextRestart() == 5);
+  REQUIRE(cyclicalDecay.BatchRestart() == 0);
+
+  // The schedule is the same as the first time.
+  for (size_t i = 0; i < stepSizes.n_elem; ++i)
+  {
+    double epochStepSize = stepSize;
+    cyclicalDecay.Update(iterate, epochStepSize, iterate);
+    REQUIRE(epochStepSize == stepSizes(i));
+  }
+}
+
 /**
  * Run SGDR on logistic regression and make sure the results are acceptable.
  */
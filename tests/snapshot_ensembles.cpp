@@ -85,3 +85,44 @@ TEST_CASE("SnapshotEnsemblesLogisticRegressionTest","[SnapshotEnsemblesTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
   }
 }
+
+/**
+ * Make sure that without storing the snapshots, their running mean is kept and
+ * each snapshot is handed to the sink.
+ */
+TEST_CASE("SnapshotEnsemblesStreamingTest","[SnapshotEnsemblesTest]")
+{
+  SnapshotEnsembles stored(5, 2.0, 0.5, 1000, 3);
+  SnapshotEnsembles streamed(5, 2.0, 0.5, 1000, 3, false);
+  stored.EpochBatches() = streamed.EpochBatches() = 10 / (double) 1000;
+
+  std::vector<arma::mat> sunk;
+  streamed.SnapshotSink() = [&sunk](const arma::mat& snapshot)
+      { sunk.push_back(snapshot); };
+
+  arma::mat iterate(4, 2);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    iterate.fill((double) i);
+    double storedStepSize = 0.5, streamedStepSize = 0.5;
+    stored.Update(iterate, storedStepSize, iterate);
+    streamed.Update(iterate, streamedStepSize, iterate);
+    REQUIRE(streamedStepSize == storedStepSize);
+  }
+
+  REQUIRE(stored.Snapshots().size() == 3);
+  REQUIRE(streamed.Snapshots().size() == 0);
+  REQUIRE(streamed.NumSnapshots() == 3);
+  REQUIRE(sunk.size() == 3);
+
+  arma::mat mean(4, 2, arma::fill::zeros);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(arma::approx_equal(sunk[i], stored.Snapshots()[i], "absdiff",
+        1e-12));
+    mean += stored.Snapshots()[i] / 3.0;
+  }
+
+  REQUIRE(arma::approx_equal(streamed.SnapshotMean(), mean, "absdiff", 1e-10));
+  REQUIRE(arma::approx_equal(stored.SnapshotMean(), mean, "absdiff", 1e-10));
+}
@@ -58,3 +58,65 @@ TEST_CASE("LogisticRegressionTest","[SPALeRASGDTest]")
     REQUIRE(success == true); // At least one trial must succeed.
   }
 }
+
+/**
+ * Make sure that the fused SPALeRA step matches the step written with separate
+ * Armadillo expressions.
+ */
+TEST_CASE("SPALeRAStepsizeFusedUpdateTest","[SPALeRASGDTest]")
+{
+  const double alpha = 0.001, epsilon = 1e-6, adaptRate = 3.10e-8;
+  const double stepSize = 0.01;
+  SPALeRAStepsize stepsize(alpha, epsilon, adaptRate);
+  stepsize.Initialize(7, 3, 1e6);
+
+  arma::mat iterate = arma::randu<arma::mat>(7, 3);
+  arma::mat expected(iterate);
+  arma::mat learningRates = arma::ones(7, 3);
+  arma::mat relaxedSums = arma::zeros(7, 3);
+
+  for (size_t t = 0; t < 3; ++t)
+  {
+    const arma::mat gradient = arma::randn<arma::mat>(7, 3);
+    REQUIRE(stepsize.Update(stepSize, 1.0, 1, 100, iterate, gradient));
+
+    const double paramMean = (alpha / (2 - alpha) *
+        (1 - std::pow(1 - alpha, 2 * (t + 1)))) / expected.n_elem;
+    const double paramStd = (alpha / std::sqrt(expected.n_elem)) /
+        std::sqrt(expected.n_elem);
+    const double normGradient = std::sqrt(arma::accu(arma::pow(gradient, 2)));
+
+    relaxedSums *= (1 - alpha);
+    relaxedSums += gradient * (alpha / normGradient);
+    learningRates %= arma::exp((arma::pow(relaxedSums, 2) - paramMean) *
+        (adaptRate / paramStd));
+    expected -= stepSize * (learningRates % gradient);
+
+    REQUIRE(arma::approx_equal(iterate, expected, "absdiff", 1e-12));
+  }
+}
+
+/**
+ * Make sure that SPALeRA SGD only makes the extra passes for the starting and
+ * final objectives if exactObjective is true.
+ */
+TEST_CASE("SPALeRASGDExactObjectiveTest","[SPALeRASGDTest]")
+{
+  // One epoch of the three functions, with one function per batch.
+  EvaluationCountingFunction f;
+  SPALeRASGD<> optimizer(1e-4, 1, 3, 1e-9, 0.01, 0.001, 1e-6, 3.10e-8, false,
+      NoDecay(), true, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double runningObjective = optimizer.Optimize(f, coordinates);
+
+  // Only the first batch is evaluated for the starting objective.
+  REQUIRE(f.Evaluations() == 1);
+
+  optimizer.ExactObjective() = true;
+  coordinates = f.GetInitialPoint();
+  const double objective = optimizer.Optimize(f, coordinates);
+  REQUIRE(f.Evaluations() == 1 + 3 + 3);
+
+  REQUIRE(runningObjective == Approx(objective).epsilon(0.01));
+}
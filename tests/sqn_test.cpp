@@ -0,0 +1,79 @@
+/**
+ * @file sqn_test.cpp
+ * @author Marcus Edel
+ *
+ * Test file for SQN (stochastic quasi-Newton).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run SQN on logistic regression and make sure the results are acceptable.
+ */
+TEST_CASE("SQNLogisticRegressionTest", "[SQNTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  for (size_t batchSize = 8; batchSize < 40; batchSize += 24)
+  {
+    SQN sqn(0.05, batchSize, 256, 10, 10, 50000, 1e-5);
+    LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+    arma::mat coordinates = lr.GetInitialPoint();
+    sqn.Optimize(lr, coordinates);
+
+    // Curvature pairs must have been formed.
+    REQUIRE(sqn.Pairs() > 0);
+
+    const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+    REQUIRE(acc == Approx(100.0).epsilon(0.013)); // 1.3% error tolerance.
+
+    const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+        coordinates);
+    REQUIRE(testAcc == Approx(100.0).epsilon(0.016)); // 1.6% error tolerance.
+  }
+}
+
+/**
+ * Run SQN on a logistic regression problem with more parameters, where the
+ * features are badly scaled.
+ */
+TEST_CASE("SQNHighDimensionalLogisticRegressionTest", "[SQNTest]")
+{
+  // Two Gaussians in 20 dimensions, centered at (1, ..., 1) and (9, ..., 9),
+  // with the last dimensions shrunk.
+  const size_t dimensions = 20;
+  arma::mat data = arma::randn<arma::mat>(dimensions, 400);
+  arma::Row<size_t> responses(400);
+  for (size_t i = 0; i < 400; ++i)
+  {
+    responses[i] = i % 2;
+    data.col(i) += (responses[i] == 0) ? 1.0 : 9.0;
+  }
+  data.rows(10, dimensions - 1) *= 0.1;
+
+  LogisticRegression<> lr(data, responses, 0.5);
+
+  SQN sqn(0.05, 10, 200, 5, 10, 100000, 1e-5);
+  arma::mat coordinates = lr.GetInitialPoint();
+  sqn.Optimize(lr, coordinates);
+
+  REQUIRE(sqn.Pairs() > 0);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.01)); // 1% error tolerance.
+}
@@ -0,0 +1,189 @@
+/**
+ * @file streaming_function_test.cpp
+ * @author Ryan Curtin
+ *
+ * Test StreamingFunction and its data sources.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <cstdio>
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Logistic regression (without regularization) on a batch of points, where
+ * the last row of the batch holds the responses.
+ */
+class LogisticRegressionBatchFunction
+{
+ public:
+  double Evaluate(const arma::mat& coordinates, const arma::mat& batch)
+  {
+    arma::mat predictors = batch.head_rows(batch.n_rows - 1);
+    arma::Row<size_t> responses =
+        arma::conv_to<arma::Row<size_t>>::from(batch.row(batch.n_rows - 1));
+    LogisticRegression<> lr(predictors, responses);
+    return lr.Evaluate(coordinates, 0, batch.n_cols);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const arma::mat& batch,
+                              arma::mat& gradient)
+  {
+    arma::mat predictors = batch.head_rows(batch.n_rows - 1);
+    arma::Row<size_t> responses =
+        arma::conv_to<arma::Row<size_t>>::from(batch.row(batch.n_rows - 1));
+    LogisticRegression<> lr(predictors, responses);
+    return lr.EvaluateWithGradient(coordinates, 0, gradient, batch.n_cols);
+  }
+};
+
+/**
+ * A StreamingFunction over data in memory should give the same results as the
+ * function on the whole dataset, including for batches that span two blocks.
+ */
+TEST_CASE("StreamingFunctionMatrixTest", "[StreamingFunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses);
+
+  const arma::mat points = arma::join_cols(shuffledData,
+      arma::conv_to<arma::rowvec>::from(shuffledResponses));
+  MatrixDataSource<> source(points);
+  LogisticRegressionBatchFunction batchFunction;
+  StreamingFunction<MatrixDataSource<>, LogisticRegressionBatchFunction>
+      f(source, batchFunction, 64);
+
+  REQUIRE(f.NumFunctions() == lr.NumFunctions());
+
+  arma::mat coordinates = arma::randu<arma::mat>(1, lr.NumFeatures());
+  arma::mat gradient1, gradient2;
+  const size_t begins[] = { 0, 10, 60, 990, 0 };
+  for (size_t i = 0; i < 5; ++i)
+  {
+    const double objective1 = f.EvaluateWithGradient(coordinates, begins[i],
+        gradient1, 10);
+    const double objective2 = lr.EvaluateWithGradient(coordinates, begins[i],
+        gradient2, 10);
+
+    REQUIRE(objective1 == Approx(objective2).epsilon(1e-7));
+    for (size_t j = 0; j < gradient1.n_elem; ++j)
+      REQUIRE(gradient1[j] == Approx(gradient2[j]).epsilon(1e-7));
+  }
+
+  // Without shuffling, SGD takes the same steps on both functions.
+  StandardSGD s(0.01, 10, 5000, 1e-15, false);
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  arma::mat coordinates2 = coordinates1;
+  const double result1 = s.Optimize(f, coordinates1);
+  const double result2 = s.Optimize(lr, coordinates2);
+
+  REQUIRE(result1 == Approx(result2).epsilon(1e-7));
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == Approx(coordinates2[i]).epsilon(1e-7));
+}
+
+/**
+ * Train logistic regression on a dataset read from a file.
+ */
+TEST_CASE("StreamingFunctionBinaryFileTest", "[StreamingFunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  const arma::mat points = arma::join_cols(shuffledData,
+      arma::conv_to<arma::rowvec>::from(shuffledResponses));
+  points.save("streaming_function_test.bin", arma::raw_binary);
+
+  BinaryFileDataSource<> source("streaming_function_test.bin", points.n_rows);
+  REQUIRE(source.NumPoints() == points.n_cols);
+
+  arma::mat batch;
+  source.Load(5, 3, batch);
+  CheckMatrices(batch, points.cols(5, 7));
+
+  LogisticRegressionBatchFunction batchFunction;
+  StreamingFunction<BinaryFileDataSource<>, LogisticRegressionBatchFunction>
+      f(source, batchFunction, 100);
+
+  Adam adam;
+  arma::mat coordinates = arma::zeros<arma::mat>(1, data.n_rows + 1);
+  adam.Optimize(f, coordinates);
+
+  LogisticRegression<> lr(shuffledData, shuffledResponses);
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.003)); // 0.3% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.006)); // 0.6% error tolerance.
+
+  std::remove("streaming_function_test.bin");
+
+  REQUIRE_THROWS_AS(BinaryFileDataSource<>("streaming_function_test.bin", 4),
+      std::runtime_error);
+}
+
+/**
+ * Map a dataset saved by MappedDataset, and check that the logistic regression
+ * function uses its memory in place.
+ */
+TEST_CASE("MappedDatasetTest", "[StreamingFunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  MappedDataset::Save("mapped_dataset_test.bin", shuffledData,
+      shuffledResponses);
+  {
+    MappedDataset dataset("mapped_dataset_test.bin",
+        MappedDataset::RandomAccess);
+    CheckMatrices(dataset.Predictors(), shuffledData);
+    REQUIRE(arma::all(dataset.Responses() == shuffledResponses));
+    dataset.Advise(MappedDataset::SequentialAccess);
+
+    LogisticRegression<> lr(dataset.Predictors(), dataset.Responses(), 0.5);
+    REQUIRE(lr.Predictors().memptr() == dataset.Predictors().memptr());
+    REQUIRE(lr.Responses().memptr() == dataset.Responses().memptr());
+
+    LogisticRegression<> copied(shuffledData, shuffledResponses, 0.5);
+    const arma::mat coordinates = arma::randn<arma::mat>(1, data.n_rows + 1);
+    REQUIRE(lr.Evaluate(coordinates) ==
+        Approx(copied.Evaluate(coordinates)).epsilon(1e-10));
+  }
+
+  // A file without responses.
+  MappedDataset::Save("mapped_dataset_test.bin", testData);
+  {
+    MappedDataset dataset("mapped_dataset_test.bin");
+    CheckMatrices(dataset.Predictors(), testData);
+    REQUIRE(dataset.Responses().n_elem == 0);
+  }
+
+  // A truncated file is rejected.
+  arma::mat(4, 1).save("mapped_dataset_test.bin", arma::raw_binary);
+  REQUIRE_THROWS_AS(MappedDataset("mapped_dataset_test.bin"),
+      std::runtime_error);
+
+  std::remove("mapped_dataset_test.bin");
+  REQUIRE_THROWS_AS(MappedDataset("mapped_dataset_test.bin"),
+      std::runtime_error);
+}
@@ -78,3 +78,253 @@ TEST_CASE("SVRGBBLogisticRegressionTest", "[SVRGTest]")
     REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
   }
 }
+
+/**
+ * Run SVRG with a parallel full gradient on logistic regression and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("SVRGParallelFullGradientLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  SVRG optimizer(0.005, 40, 300, 0, 1e-5, true, SVRGUpdate(), NoDecay(), true,
+      true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * Make sure that the full gradient computed in parallel matches the serial one,
+ * and that it is the same every time.
+ */
+TEST_CASE("FullEvaluateWithGradientTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  Function<LogisticRegression<>>& f =
+      static_cast<Function<LogisticRegression<>>&>(lr);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(
+      lr.GetInitialPoint().n_rows, lr.GetInitialPoint().n_cols);
+
+  arma::mat gradient, serialGradient, parallelGradient1, parallelGradient2;
+  const double serialObjective = FullEvaluateWithGradient(f, coordinates, 7,
+      serialGradient, gradient);
+  const double parallelObjective1 = FullEvaluateWithGradient(f, coordinates, 7,
+      parallelGradient1, gradient, true);
+  const double parallelObjective2 = FullEvaluateWithGradient(f, coordinates, 7,
+      parallelGradient2, gradient, true);
+
+  REQUIRE(parallelObjective1 == Approx(serialObjective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(parallelGradient1, serialGradient, "reldiff",
+      1e-10));
+
+  REQUIRE(parallelObjective1 == parallelObjective2);
+  REQUIRE(arma::approx_equal(parallelGradient1, parallelGradient2, "absdiff",
+      0.0));
+}
+
+/**
+ * Make sure that the gradients of a batch at two points computed in parallel
+ * match the serial ones.
+ */
+TEST_CASE("BatchGradientPairTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  Function<LogisticRegression<>>& f =
+      static_cast<Function<LogisticRegression<>>&>(lr);
+
+  const arma::mat coordinates = arma::randu<arma::mat>(
+      lr.GetInitialPoint().n_rows, lr.GetInitialPoint().n_cols);
+  const arma::mat coordinates0 = arma::randu<arma::mat>(
+      lr.GetInitialPoint().n_rows, lr.GetInitialPoint().n_cols);
+
+  std::vector<arma::mat> buffers;
+  for (const size_t batchSize : { 1, 7, 40 })
+  {
+    arma::mat gradient, gradient0, parallelGradient, parallelGradient0;
+    f.Gradient(coordinates, 100, gradient, batchSize);
+    f.Gradient(coordinates0, 100, gradient0, batchSize);
+    BatchGradientPair(f, coordinates, coordinates0, 100, batchSize,
+        parallelGradient, parallelGradient0, buffers, true);
+
+    REQUIRE(arma::approx_equal(parallelGradient, gradient, "reldiff", 1e-10));
+    REQUIRE(arma::approx_equal(parallelGradient0, gradient0, "reldiff",
+        1e-10));
+  }
+}
+
+/**
+ * Make sure that the Barzilai-Borwein step size is the one of its definition,
+ * over several epochs.
+ */
+TEST_CASE("BarzilaiBorweinDecayStepSizeTest", "[SVRGTest]")
+{
+  BarzilaiBorweinDecay decay(10.0);
+  arma::mat gradient;
+  arma::mat iterate0 = arma::randu<arma::mat>(4, 3);
+  arma::mat fullGradient0 = arma::randu<arma::mat>(4, 3);
+
+  // The first epoch keeps the step size.
+  double stepSize = 0.01;
+  decay.Update(iterate0, iterate0, gradient, fullGradient0, 5, stepSize);
+  REQUIRE(stepSize == 0.01);
+
+  for (size_t epoch = 0; epoch < 3; ++epoch)
+  {
+    const arma::mat iterate = iterate0 + 0.1 * arma::randu<arma::mat>(4, 3);
+    const arma::mat fullGradient = fullGradient0 +
+        0.2 * (iterate - iterate0) + 0.01 * arma::randu<arma::mat>(4, 3);
+
+    const arma::mat step = iterate - iterate0;
+    const double expected = std::min(10.0, arma::dot(step, step) /
+        (arma::dot(step, fullGradient - fullGradient0) + 1e-7) / 5.0);
+
+    decay.Update(iterate, iterate0, gradient, fullGradient, 5, stepSize);
+    REQUIRE(stepSize == Approx(expected).epsilon(1e-10));
+
+    iterate0 = iterate;
+    fullGradient0 = fullGradient;
+  }
+}
+
+/**
+ * Run loopless SVRG on logistic regression and make sure the results are
+ * acceptable, and that the snapshot moves about once per pass over the data.
+ */
+TEST_CASE("LooplessSVRGLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  // 3000 steps of 40 points are 120 passes over the data.
+  LooplessSVRG optimizer(0.005, 40, 3000, 0.0, 1e-5, true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, coordinates);
+
+  REQUIRE(optimizer.Snapshots() > 60);
+  REQUIRE(optimizer.Snapshots() < 240);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
+
+/**
+ * The sparse test function, with a dense gradient.
+ */
+class DenseGradientSparseTestFunction : public SparseTestFunction
+{
+ public:
+  using SparseTestFunction::Gradient;
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    arma::sp_mat sparseGradient;
+    SparseTestFunction::Gradient(coordinates, i, sparseGradient, batchSize);
+    gradient = arma::mat(sparseGradient);
+  }
+};
+
+/**
+ * Asynchronous SVRG with lazy full gradient terms should find the vertices of
+ * the parabolas of the sparse test function.
+ */
+TEST_CASE("AsyncSVRGSparseTestFunctionTest", "[SVRGTest]")
+{
+  SparseTestFunction f;
+
+  AsyncSVRG optimizer(0.1, 1, 1000, 0, 1e-12, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = optimizer.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(123.75).epsilon(0.0001));
+  REQUIRE(coordinates[0] == Approx(2.0).epsilon(0.0002));
+  REQUIRE(coordinates[1] == Approx(1.0).epsilon(0.0002));
+  REQUIRE(coordinates[2] == Approx(1.5).epsilon(0.0002));
+  REQUIRE(coordinates[3] == Approx(4.0).epsilon(0.0002));
+}
+
+/**
+ * When every batch touches all the coordinates, the lazy steps of a sparse
+ * gradient must give the same iterate as the dense steps.
+ */
+TEST_CASE("AsyncSVRGLazyStepsTest", "[SVRGTest]")
+{
+  DenseGradientSparseTestFunction f;
+
+  AsyncSVRGType<SerialExecutor> optimizer(0.05, 4, 5, 12, 1e-12, false);
+
+  arma::mat sparseCoordinates = f.GetInitialPoint();
+  optimizer.Optimize(f, sparseCoordinates);
+
+  arma::mat denseCoordinates = f.GetInitialPoint();
+  optimizer.Optimize<DenseGradientSparseTestFunction, arma::mat>(f,
+      denseCoordinates);
+
+  for (size_t i = 0; i < denseCoordinates.n_elem; ++i)
+    REQUIRE(sparseCoordinates[i] == Approx(denseCoordinates[i]).epsilon(1e-12));
+}
+
+/**
+ * Run asynchronous SVRG with dense gradients on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("AsyncSVRGLogisticRegressionTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  AsyncSVRG optimizer(0.005, 40, 300, 0, 1e-5, true);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  arma::mat coordinates = lr.GetInitialPoint();
+  optimizer.Optimize<LogisticRegression<>, arma::mat>(lr, coordinates);
+
+  // Ensure that the error is close to zero.
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+
+  const double testAcc = lr.ComputeAccuracy(testData, testResponses,
+      coordinates);
+  REQUIRE(testAcc == Approx(100.0).epsilon(0.015)); // 1.5% error tolerance.
+}
@@ -91,4 +91,41 @@ inline void CheckMatrices(const arma::mat& a,
   }
 }
 
+// The SGD test function, which counts the calls to the separable Evaluate()
+// that are not part of EvaluateWithGradient().
+class EvaluationCountingFunction
+{
+ public:
+  EvaluationCountingFunction() : evaluations(0) { }
+
+  void Shuffle() { f.Shuffle(); }
+
+  size_t NumFunctions() const { return f.NumFunctions(); }
+
+  arma::mat GetInitialPoint() const { return f.GetInitialPoint(); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    ++evaluations;
+    return f.Evaluate(coordinates, begin, batchSize);
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    f.Gradient(coordinates, begin, gradient, batchSize);
+    return f.Evaluate(coordinates, begin, batchSize);
+  }
+
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  ens::test::SGDTestFunction f;
+  size_t evaluations;
+};
+
 #endif